@@ -0,0 +1,472 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+
+#include "sd-bus.h"
+#include "sd-journal.h"
+#include "sd-json.h"
+#include "sd-varlink.h"
+
+#include "alloc-util.h"
+#include "analyze.h"
+#include "analyze-benchmark.h"
+#include "bus-error.h"
+#include "bus-locator.h"
+#include "constants.h"
+#include "format-table.h"
+#include "hashmap.h"
+#include "iovec-util.h"
+#include "journal-file-util.h"
+#include "manager.h"
+#include "mkdir.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "sort-util.h"
+#include "special.h"
+#include "string-util.h"
+#include "strv.h"
+#include "time-util.h"
+#include "tmpfile-util.h"
+#include "varlink-util.h"
+
+typedef struct BenchmarkContext {
+        char *scratch_dir;
+        Manager *manager;
+        sd_bus *bus;
+        sd_varlink *varlink;
+} BenchmarkContext;
+
+typedef struct Benchmark {
+        const char *name;
+        unsigned iterations;  /* Default number of iterations, if not overridden with --iterations= */
+        /* Runs one iteration. Returns the number of operations done in it on success, which may vary
+         * between iterations. Only the time spent in this function is measured. */
+        int (*run)(BenchmarkContext *c, unsigned iteration, uint64_t *ret_operations);
+} Benchmark;
+
+#define HASHMAP_OPERATIONS 10000U
+#define JSON_OPERATIONS 1000U
+#define JOURNAL_OPERATIONS 10000U
+
+static void benchmark_context_done(BenchmarkContext *c) {
+        assert(c);
+
+        c->manager = manager_free(c->manager);
+        c->bus = sd_bus_flush_close_unref(c->bus);
+        c->varlink = sd_varlink_flush_close_unref(c->varlink);
+        c->scratch_dir = rm_rf_physical_and_free(c->scratch_dir);
+}
+
+static int benchmark_hashmap(BenchmarkContext *c, unsigned iteration, uint64_t *ret_operations) {
+        _cleanup_hashmap_free_ Hashmap *h = NULL;
+        int r;
+
+        h = hashmap_new(&trivial_hash_ops);
+        if (!h)
+                return log_oom();
+
+        for (unsigned i = 1; i <= HASHMAP_OPERATIONS; i++) {
+                r = hashmap_put(h, UINT_TO_PTR(i), UINT_TO_PTR(i));
+                if (r < 0)
+                        return log_error_errno(r, "Failed to add hashmap entry: %m");
+        }
+
+        for (unsigned i = 1; i <= HASHMAP_OPERATIONS; i++)
+                if (hashmap_get(h, UINT_TO_PTR(i)) != UINT_TO_PTR(i))
+                        return log_error_errno(SYNTHETIC_ERRNO(EIO), "Hashmap lookup returned wrong entry.");
+
+        for (unsigned i = 1; i <= HASHMAP_OPERATIONS; i++)
+                (void) hashmap_remove(h, UINT_TO_PTR(i));
+
+        *ret_operations = HASHMAP_OPERATIONS;
+        return 0;
+}
+
+static int benchmark_json(BenchmarkContext *c, unsigned iteration, uint64_t *ret_operations) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL, *w = NULL;
+        sd_json_variant **elements = NULL;
+        _cleanup_free_ char *s = NULL;
+        int r;
+
+        CLEANUP_ARRAY(elements, (size_t) { JSON_OPERATIONS }, sd_json_variant_unref_many);
+
+        elements = new0(sd_json_variant*, JSON_OPERATIONS);
+        if (!elements)
+                return log_oom();
+
+        for (unsigned i = 0; i < JSON_OPERATIONS; i++) {
+                r = sd_json_buildo(
+                                &elements[i],
+                                SD_JSON_BUILD_PAIR_UNSIGNED("index", i),
+                                SD_JSON_BUILD_PAIR_STRING("name", "systemd-benchmark.service"),
+                                SD_JSON_BUILD_PAIR_BOOLEAN("active", i % 2 == 0),
+                                SD_JSON_BUILD_PAIR_STRV("tags", STRV_MAKE("foo", "bar", "baz")));
+                if (r < 0)
+                        return log_error_errno(r, "Failed to build JSON object: %m");
+        }
+
+        r = sd_json_variant_new_array(&v, elements, JSON_OPERATIONS);
+        if (r < 0)
+                return log_error_errno(r, "Failed to build JSON array: %m");
+
+        r = sd_json_variant_format(v, /* flags= */ 0, &s);
+        if (r < 0)
+                return log_error_errno(r, "Failed to format JSON: %m");
+
+        r = sd_json_parse(s, /* flags= */ 0, &w, /* reterr_line= */ NULL, /* reterr_column= */ NULL);
+        if (r < 0)
+                return log_error_errno(r, "Failed to parse JSON: %m");
+
+        if (!sd_json_variant_equal(v, w))
+                return log_error_errno(SYNTHETIC_ERRNO(EIO), "Parsed JSON does not match formatted JSON.");
+
+        *ret_operations = JSON_OPERATIONS;
+        return 0;
+}
+
+static int manager_new_for_benchmark(Manager **ret) {
+        _cleanup_(manager_freep) Manager *m = NULL;
+        Unit *u;
+        int r;
+
+        assert(ret);
+
+        r = manager_new(arg_runtime_scope, MANAGER_TEST_RUN_MINIMAL|MANAGER_TEST_DONT_OPEN_EXECUTOR, &m);
+        if (r < 0)
+                return log_error_errno(r, "Failed to initialize manager: %m");
+
+        r = manager_startup(m, /* serialization= */ NULL, /* fds= */ NULL, /* root= */ NULL);
+        if (r < 0)
+                return log_error_errno(r, "Failed to start up manager: %m");
+
+        /* This loads the default target and, transitively, everything it pulls in */
+        r = manager_load_startable_unit_or_warn(m, SPECIAL_DEFAULT_TARGET, /* path= */ NULL, &u);
+        if (r < 0)
+                return r;
+
+        *ret = TAKE_PTR(m);
+        return 0;
+}
+
+static int benchmark_unit_load(BenchmarkContext *c, unsigned iteration, uint64_t *ret_operations) {
+        _cleanup_(manager_freep) Manager *m = NULL;
+        int r;
+
+        r = manager_new_for_benchmark(&m);
+        if (r < 0)
+                return r;
+
+        *ret_operations = hashmap_size(m->units);
+        return 0;
+}
+
+static int benchmark_transaction(BenchmarkContext *c, unsigned iteration, uint64_t *ret_operations) {
+        _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        Unit *u;
+        int r;
+
+        assert(c);
+
+        if (!c->manager) {
+                r = manager_new_for_benchmark(&c->manager);
+                if (r < 0)
+                        return r;
+        } else
+                manager_clear_jobs(c->manager);
+
+        u = manager_get_unit(c->manager, SPECIAL_DEFAULT_TARGET);
+        assert(u);
+
+        r = manager_add_job(c->manager, JOB_START, u, JOB_REPLACE, &error, /* ret= */ NULL);
+        if (r < 0)
+                return log_error_errno(r, "Failed to build transaction for %s: %s", u->id, bus_error_message(&error, r));
+
+        *ret_operations = hashmap_size(c->manager->jobs);
+        return 0;
+}
+
+static int benchmark_dbus(BenchmarkContext *c, unsigned iteration, uint64_t *ret_operations) {
+        _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        int r;
+
+        assert(c);
+
+        /* The connection is kept around for all iterations, as we want to measure the round trip time, not
+         * how long it takes to connect. */
+        if (!c->bus) {
+                r = acquire_bus(&c->bus, /* use_full_bus= */ NULL);
+                if (r < 0)
+                        return bus_log_connect_error(r, arg_transport, arg_runtime_scope);
+        }
+
+        r = sd_bus_call_method(
+                        c->bus,
+                        "org.freedesktop.systemd1",
+                        "/org/freedesktop/systemd1",
+                        "org.freedesktop.DBus.Peer",
+                        "Ping",
+                        &error,
+                        /* ret_reply= */ NULL,
+                        /* types= */ NULL);
+        if (r < 0)
+                return log_error_errno(r, "Failed to ping service manager: %s", bus_error_message(&error, r));
+
+        *ret_operations = 1;
+        return 0;
+}
+
+static int benchmark_varlink(BenchmarkContext *c, unsigned iteration, uint64_t *ret_operations) {
+        int r;
+
+        assert(c);
+
+        if (!c->varlink) {
+                /* Only the system manager listens on a Varlink socket */
+                if (arg_runtime_scope != RUNTIME_SCOPE_SYSTEM || arg_transport != BUS_TRANSPORT_LOCAL)
+                        return log_error_errno(SYNTHETIC_ERRNO(EOPNOTSUPP),
+                                               "Varlink benchmark is only supported for the local system manager.");
+
+                r = sd_varlink_connect_address(&c->varlink, VARLINK_ADDR_PATH_MANAGER);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to connect to %s: %m", VARLINK_ADDR_PATH_MANAGER);
+        }
+
+        r = varlink_call_and_log(c->varlink, "io.systemd.service.Ping", /* parameters= */ NULL, /* ret_parameters= */ NULL);
+        if (r < 0)
+                return r;
+
+        *ret_operations = 1;
+        return 0;
+}
+
+static int benchmark_scratch_dir(BenchmarkContext *c) {
+        int r;
+
+        assert(c);
+
+        if (c->scratch_dir)
+                return 0;
+
+        r = mkdtemp_malloc("/var/tmp/systemd-analyze-benchmark-XXXXXX", &c->scratch_dir);
+        if (r < 0)
+                return log_error_errno(r, "Failed to create scratch directory: %m");
+
+        return 0;
+}
+
+static int benchmark_journal_append(BenchmarkContext *c, unsigned iteration, uint64_t *ret_operations) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *mmap_cache = NULL;
+        _cleanup_(journal_file_offline_closep) JournalFile *f = NULL;
+        _cleanup_free_ char *fn = NULL;
+        int r;
+
+        assert(c);
+
+        r = benchmark_scratch_dir(c);
+        if (r < 0)
+                return r;
+
+        if (asprintf(&fn, "%s/benchmark-%u.journal", c->scratch_dir, iteration) < 0)
+                return log_oom();
+
+        mmap_cache = mmap_cache_new();
+        if (!mmap_cache)
+                return log_oom();
+
+        r = journal_file_open(
+                        /* fd= */ -EBADF,
+                        fn,
+                        O_RDWR|O_CREAT|O_EXCL,
+                        JOURNAL_COMPRESS,
+                        0644,
+                        /* compress_threshold_bytes= */ UINT64_MAX,
+                        /* metrics= */ NULL,
+                        mmap_cache,
+                        /* template= */ NULL,
+                        &f);
+        if (r < 0)
+                return log_error_errno(r, "Failed to create journal file '%s': %m", fn);
+
+        for (unsigned i = 0; i < JOURNAL_OPERATIONS; i++) {
+                char message[STRLEN("MESSAGE=Benchmark message ") + DECIMAL_STR_MAX(unsigned)],
+                        group[STRLEN("BENCHMARK_GROUP=") + DECIMAL_STR_MAX(unsigned)];
+                struct iovec iovec[] = {
+                        IOVEC_MAKE_STRING(message),
+                        IOVEC_MAKE_STRING(group),
+                        IOVEC_MAKE_STRING("PRIORITY=6"),
+                        IOVEC_MAKE_STRING("SYSLOG_IDENTIFIER=systemd-analyze"),
+                };
+                dual_timestamp ts;
+
+                xsprintf(message, "MESSAGE=Benchmark message %u", i);
+                xsprintf(group, "BENCHMARK_GROUP=%u", i % 10);
+
+                r = journal_file_append_entry(f, dual_timestamp_now(&ts), /* boot_id= */ NULL,
+                                              iovec, ELEMENTSOF(iovec),
+                                              /* seqnum= */ NULL, /* seqnum_id= */ NULL,
+                                              /* ret_object= */ NULL, /* ret_offset= */ NULL);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to append to journal file '%s': %m", fn);
+        }
+
+        *ret_operations = JOURNAL_OPERATIONS;
+        return 0;
+}
+
+static int benchmark_journal_query(BenchmarkContext *c, unsigned iteration, uint64_t *ret_operations) {
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        uint64_t n = 0;
+        int r;
+
+        assert(c);
+
+        /* Query the files written by the journal-append benchmark, or write one first if it wasn't run */
+        if (!c->scratch_dir) {
+                uint64_t ignored;
+
+                r = benchmark_journal_append(c, UINT_MAX, &ignored);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_journal_open_directory(&j, c->scratch_dir, /* flags= */ 0);
+        if (r < 0)
+                return log_error_errno(r, "Failed to open journal directory '%s': %m", c->scratch_dir);
+
+        r = sd_journal_add_match(j, "BENCHMARK_GROUP=7", SIZE_MAX);
+        if (r < 0)
+                return log_error_errno(r, "Failed to add journal match: %m");
+
+        for (;;) {
+                const void *d;
+                size_t l;
+
+                r = sd_journal_next(j);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to iterate through journal: %m");
+                if (r == 0)
+                        break;
+
+                r = sd_journal_get_data(j, "MESSAGE", &d, &l);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to read journal entry: %m");
+
+                n++;
+        }
+
+        *ret_operations = n;
+        return 0;
+}
+
+static const Benchmark benchmarks[] = {
+        { "hashmap",        1000, benchmark_hashmap        },
+        { "json",           100,  benchmark_json           },
+        { "unit-load",      10,   benchmark_unit_load      },
+        { "transaction",    100,  benchmark_transaction    },
+        { "dbus",           1000, benchmark_dbus           },
+        { "varlink",        1000, benchmark_varlink        },
+        { "journal-append", 10,   benchmark_journal_append },
+        { "journal-query",  100,  benchmark_journal_query  },
+};
+
+static usec_t percentile(const usec_t *sorted, size_t n, unsigned p) {
+        assert(sorted);
+        assert(n > 0);
+        assert(p <= 100);
+
+        /* Nearest-rank method */
+        return sorted[MAX(DIV_ROUND_UP((size_t) p * n, 100U), 1U) - 1];
+}
+
+static int run_benchmark(BenchmarkContext *c, const Benchmark *b, Table *table) {
+        _cleanup_free_ usec_t *samples = NULL;
+        uint64_t operations = 0;
+        usec_t total = 0;
+        unsigned n;
+        int r;
+
+        assert(c);
+        assert(b);
+        assert(table);
+
+        n = arg_iterations > 0 ? arg_iterations : b->iterations;
+
+        samples = new(usec_t, n);
+        if (!samples)
+                return log_oom();
+
+        log_debug("Running benchmark %s with %u iterations...", b->name, n);
+
+        for (unsigned i = 0; i < n; i++) {
+                uint64_t k = 0;
+                usec_t start;
+
+                start = now(CLOCK_MONOTONIC);
+                r = b->run(c, i, &k);
+                samples[i] = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+                if (r < 0)
+                        return r;
+
+                total = usec_add(total, samples[i]);
+                operations += k;
+        }
+
+        typesafe_qsort(samples, n, uint64_compare_func);
+
+        r = table_add_many(table,
+                           TABLE_STRING, b->name,
+                           TABLE_UINT, n,
+                           TABLE_UINT64, operations / n,
+                           TABLE_TIMESPAN, samples[0],
+                           TABLE_TIMESPAN, percentile(samples, n, 50),
+                           TABLE_TIMESPAN, percentile(samples, n, 90),
+                           TABLE_TIMESPAN, percentile(samples, n, 99),
+                           TABLE_TIMESPAN, samples[n - 1],
+                           TABLE_TIMESPAN, total / n);
+        if (r < 0)
+                return table_log_add_error(r);
+
+        return 0;
+}
+
+int verb_benchmark(int argc, char *argv[], void *userdata) {
+        _cleanup_(benchmark_context_done) BenchmarkContext c = {};
+        _cleanup_(table_unrefp) Table *table = NULL;
+        char **names = strv_skip(argv, 1);
+        int r;
+
+        STRV_FOREACH(name, names) {
+                bool found = false;
+
+                FOREACH_ELEMENT(b, benchmarks)
+                        if (streq(b->name, *name)) {
+                                found = true;
+                                break;
+                        }
+
+                if (!found)
+                        return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Unknown benchmark: %s", *name);
+        }
+
+        table = table_new("benchmark", "iterations", "operations", "min", "p50", "p90", "p99", "max", "mean");
+        if (!table)
+                return log_oom();
+
+        for (size_t i = 3; i < 9; i++)
+                (void) table_set_align_percent(table, table_get_cell(table, 0, i), 100);
+
+        FOREACH_ELEMENT(b, benchmarks) {
+                if (!strv_isempty(names) && !strv_contains(names, b->name))
+                        continue;
+
+                r = run_benchmark(&c, b, table);
+                if (r < 0)
+                        return r;
+        }
+
+        r = table_print_with_pager(table, arg_json_format_flags, arg_pager_flags, arg_legend);
+        if (r < 0)
+                return log_error_errno(r, "Failed to output table: %m");
+
+        return EXIT_SUCCESS;
+}
@@ -52,7 +52,7 @@ static int test_calendar_one(usec_t n, const char *p) {
         if (r < 0)
                 return table_log_add_error(r);
 
-        for (unsigned i = 0; i < arg_iterations; i++) {
+        for (unsigned i = 0; i < MAX(arg_iterations, 1U); i++) {
                 usec_t next;
 
                 r = calendar_spec_next_usec(spec, n, &next);
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "sd-varlink.h"
+
+#include "analyze.h"
+#include "analyze-event-loop.h"
+#include "constants.h"
+#include "format-table.h"
+#include "json-util.h"
+#include "parse-util.h"
+#include "varlink-util.h"
+
+int verb_event_loop(int argc, char *argv[], void *userdata) {
+        _cleanup_(sd_varlink_flush_close_unrefp) sd_varlink *vl = NULL;
+        _cleanup_(table_unrefp) Table *table = NULL;
+        sd_json_variant *reply = NULL, *statistics, *i;
+        const char *address = VARLINK_ADDR_PATH_MANAGER;
+        int r, enable = -1;
+
+        if (argc > 1)
+                address = argv[1];
+
+        if (argc > 2) {
+                r = parse_boolean(argv[2]);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to parse boolean '%s': %m", argv[2]);
+                enable = r;
+        }
+
+        r = sd_varlink_connect_address(&vl, address);
+        if (r < 0)
+                return log_error_errno(r, "Failed to connect to %s: %m", address);
+
+        r = varlink_callbo_and_log(
+                        vl,
+                        "io.systemd.service.GetEventLoopStatistics",
+                        &reply,
+                        SD_JSON_BUILD_PAIR_CONDITION(enable >= 0, "enable", SD_JSON_BUILD_BOOLEAN(enable)));
+        if (r < 0)
+                return r;
+
+        statistics = sd_json_variant_by_key(reply, "statistics");
+        if (!statistics)
+                return log_error_errno(SYNTHETIC_ERRNO(EOPNOTSUPP), "Service at %s does not run an event loop.", address);
+
+        if (sd_json_format_enabled(arg_json_format_flags)) {
+                sd_json_variant_dump(statistics, arg_json_format_flags, stdout, NULL);
+                return EXIT_SUCCESS;
+        }
+
+        if (!sd_json_variant_boolean(sd_json_variant_by_key(statistics, "enabled")))
+                log_notice("Collection of event loop statistics is disabled, enable it with 'systemd-analyze event-loop %s yes'.", address);
+
+        table = table_new("type", "description", "dispatched", "callback", "callback max", "queue delay", "queue delay max");
+        if (!table)
+                return log_oom();
+
+        JSON_VARIANT_ARRAY_FOREACH(i, sd_json_variant_by_key(statistics, "sources")) {
+                uint64_t n = sd_json_variant_unsigned(sd_json_variant_by_key(i, "dispatched"));
+
+                /* Show averages, the totals are available in the JSON output */
+                r = table_add_many(table,
+                                   TABLE_STRING, sd_json_variant_string(sd_json_variant_by_key(i, "type")),
+                                   TABLE_STRING, sd_json_variant_string(sd_json_variant_by_key(i, "description")),
+                                   TABLE_UINT64, n,
+                                   TABLE_TIMESPAN, n > 0 ? sd_json_variant_unsigned(sd_json_variant_by_key(i, "callbackUSec")) / n : 0,
+                                   TABLE_TIMESPAN, sd_json_variant_unsigned(sd_json_variant_by_key(i, "callbackMaxUSec")),
+                                   TABLE_TIMESPAN, n > 0 ? sd_json_variant_unsigned(sd_json_variant_by_key(i, "queueDelayUSec")) / n : 0,
+                                   TABLE_TIMESPAN, sd_json_variant_unsigned(sd_json_variant_by_key(i, "queueDelayMaxUSec")));
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
+
+        r = table_print_with_pager(table, SD_JSON_FORMAT_OFF, arg_pager_flags, arg_legend);
+        if (r < 0)
+                return log_error_errno(r, "Failed to output table: %m");
+
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,342 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "analyze.h"
+#include "analyze-simulate.h"
+#include "analyze-time-data.h"
+#include "bus-error.h"
+#include "format-table.h"
+#include "hashmap.h"
+#include "special.h"
+#include "string-util.h"
+#include "strv.h"
+#include "time-util.h"
+
+/* A very simple model of the boot: every unit starts once all units it is ordered after (and which
+ * actually finished before it started) are done, plus whatever additional time it was observed to wait
+ * for other reasons (socket activation, job queue, …), and then takes as long as it took last time. On
+ * top of this model the boot can be replayed with modified durations and ordering edges. */
+
+typedef enum SimulateState {
+        SIMULATE_UNVISITED,
+        SIMULATE_VISITING,
+        SIMULATE_DONE,
+} SimulateState;
+
+typedef struct SimulateUnit {
+        const UnitTimes *times;
+        usec_t duration;
+        usec_t slack;
+        size_t *after;
+        size_t n_after;
+        usec_t finish;
+        SimulateState state;
+} SimulateUnit;
+
+typedef struct Simulation {
+        SimulateUnit *units;
+        size_t n_units;
+        Hashmap *index; /* name → SimulateUnit */
+} Simulation;
+
+static void simulation_done(Simulation *s) {
+        assert(s);
+
+        FOREACH_ARRAY(u, s->units, s->n_units)
+                free(u->after);
+
+        s->units = mfree(s->units);
+        s->n_units = 0;
+        s->index = hashmap_free(s->index);
+}
+
+static usec_t simulate_finish(SimulateUnit *units, size_t i) {
+        SimulateUnit *u = units + i;
+        usec_t start = 0;
+
+        if (u->state == SIMULATE_DONE)
+                return u->finish;
+        if (u->state == SIMULATE_VISITING)
+                return 0; /* Ordering cycle, ignore this edge */
+
+        u->state = SIMULATE_VISITING;
+
+        FOREACH_ARRAY(a, u->after, u->n_after)
+                start = MAX(start, simulate_finish(units, *a));
+
+        u->finish = usec_add(usec_add(start, u->slack), u->duration);
+        u->state = SIMULATE_DONE;
+
+        return u->finish;
+}
+
+static usec_t simulate_boot(Simulation *s, SimulateUnit *target) {
+        assert(s);
+        assert(target);
+
+        FOREACH_ARRAY(u, s->units, s->n_units)
+                u->state = SIMULATE_UNVISITED;
+
+        return simulate_finish(s->units, target - s->units);
+}
+
+static usec_t unit_times_finish(const UnitTimes *t) {
+        assert(t);
+        return usec_add(t->activating, t->time);
+}
+
+static int simulation_build(Simulation *s, UnitTimes *times, size_t n) {
+        int r;
+
+        assert(s);
+        assert(times);
+
+        s->units = new0(SimulateUnit, n);
+        if (!s->units)
+                return log_oom();
+        s->n_units = n;
+
+        for (size_t i = 0; i < n; i++) {
+                s->units[i] = (SimulateUnit) {
+                        .times = times + i,
+                        .duration = times[i].time,
+                };
+
+                r = hashmap_ensure_put(&s->index, &string_hash_ops, times[i].name, s->units + i);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to add entry to hashmap: %m");
+        }
+
+        FOREACH_ARRAY(u, s->units, s->n_units) {
+                usec_t gate = 0;
+
+                STRV_FOREACH(d, u->times->deps[UNIT_AFTER]) {
+                        SimulateUnit *o;
+
+                        o = hashmap_get(s->index, *d);
+                        if (!o || o == u)
+                                continue;
+
+                        /* Only edges that actually held the unit back count. Units that finished later were
+                         * not part of the same transaction, or were not started at all back then. */
+                        if (unit_times_finish(o->times) > u->times->activating)
+                                continue;
+
+                        if (!GREEDY_REALLOC(u->after, u->n_after + 1))
+                                return log_oom();
+
+                        u->after[u->n_after++] = o - s->units;
+                        gate = MAX(gate, unit_times_finish(o->times));
+                }
+
+                u->slack = u->times->activating - gate;
+        }
+
+        return 0;
+}
+
+static int simulate_lookup(Simulation *s, const char *name, SimulateUnit **ret) {
+        SimulateUnit *u;
+
+        assert(s);
+        assert(name);
+        assert(ret);
+
+        u = hashmap_get(s->index, name);
+        if (!u)
+                return log_error_errno(SYNTHETIC_ERRNO(ENOENT),
+                                       "Unit %s was not activated during boot, refusing.", name);
+
+        *ret = u;
+        return 0;
+}
+
+static int simulate_apply_change(Simulation *s, const char *change) {
+        _cleanup_free_ char *name = NULL;
+        SimulateUnit *u, *o;
+        const char *e;
+        bool decrease;
+        usec_t t;
+        int r;
+
+        assert(s);
+        assert(change);
+
+        /* UNIT!OTHER drops the ordering of UNIT after OTHER */
+        e = strchr(change, '!');
+        if (e) {
+                name = strndup(change, e - change);
+                if (!name)
+                        return log_oom();
+
+                r = simulate_lookup(s, name, &u);
+                if (r < 0)
+                        return r;
+
+                r = simulate_lookup(s, e + 1, &o);
+                if (r < 0)
+                        return r;
+
+                for (size_t i = 0; i < u->n_after; i++)
+                        if (u->after[i] == (size_t) (o - s->units)) {
+                                u->after[i] = u->after[--u->n_after];
+                                return 0;
+                        }
+
+                return log_error_errno(SYNTHETIC_ERRNO(ENOENT),
+                                       "%s did not wait for %s during boot, refusing.", name, e + 1);
+        }
+
+        /* UNIT=SPAN sets the time the unit takes to start, UNIT-=SPAN makes it faster by SPAN */
+        e = strchr(change, '=');
+        if (!e)
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Invalid change, refusing: %s", change);
+
+        decrease = e > change && e[-1] == '-';
+        name = strndup(change, e - change - decrease);
+        if (!name)
+                return log_oom();
+
+        r = parse_sec(e + 1, &t);
+        if (r < 0)
+                return log_error_errno(r, "Failed to parse time span in '%s': %m", change);
+
+        r = simulate_lookup(s, name, &u);
+        if (r < 0)
+                return r;
+
+        u->duration = decrease ? usec_sub_unsigned(u->duration, t) : t;
+        return 0;
+}
+
+static int simulate_get_target(sd_bus *bus, char **ret) {
+        _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        _cleanup_free_ char *path = NULL, *id = NULL;
+        int r;
+
+        assert(bus);
+        assert(ret);
+
+        path = unit_dbus_path_from_name(SPECIAL_DEFAULT_TARGET);
+        if (!path)
+                return log_oom();
+
+        r = sd_bus_get_property_string(
+                        bus,
+                        "org.freedesktop.systemd1",
+                        path,
+                        "org.freedesktop.systemd1.Unit",
+                        "Id",
+                        &error,
+                        &id);
+        if (r < 0)
+                return log_error_errno(r, "Failed to get ID of %s: %s", SPECIAL_DEFAULT_TARGET, bus_error_message(&error, r));
+
+        *ret = TAKE_PTR(id);
+        return 0;
+}
+
+int verb_simulate(int argc, char *argv[], void *userdata) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *bus = NULL;
+        _cleanup_(unit_times_free_arrayp) UnitTimes *times = NULL;
+        _cleanup_(simulation_done) Simulation s = {};
+        _cleanup_(table_unrefp) Table *table = NULL;
+        _cleanup_free_ char *target_name = NULL;
+        usec_t base, modified;
+        SimulateUnit *target;
+        TableCell *cell;
+        int n, r;
+
+        r = acquire_bus(&bus, NULL);
+        if (r < 0)
+                return bus_log_connect_error(r, arg_transport, arg_runtime_scope);
+
+        n = acquire_time_data(bus, /* require_finished = */ true, &times);
+        if (n <= 0)
+                return n;
+
+        r = simulate_get_target(bus, &target_name);
+        if (r < 0)
+                return r;
+
+        r = simulation_build(&s, times, n);
+        if (r < 0)
+                return r;
+
+        r = simulate_lookup(&s, target_name, &target);
+        if (r < 0)
+                return r;
+
+        base = simulate_boot(&s, target);
+
+        STRV_FOREACH(c, strv_skip(argv, 1)) {
+                r = simulate_apply_change(&s, *c);
+                if (r < 0)
+                        return r;
+        }
+
+        modified = simulate_boot(&s, target);
+
+        table = table_new("saved", "time", "unit");
+        if (!table)
+                return log_oom();
+
+        for (size_t i = 0; i < 2; i++) {
+                assert_se(cell = table_get_cell(table, 0, i));
+                r = table_set_align_percent(table, cell, 100);
+                if (r < 0)
+                        return r;
+        }
+
+        r = table_set_sort(table, (size_t) 0);
+        if (r < 0)
+                return r;
+
+        r = table_set_reverse(table, 0, true);
+        if (r < 0)
+                return r;
+
+        /* Rank units by how much earlier the target would be reached if they started instantly */
+        FOREACH_ARRAY(u, s.units, s.n_units) {
+                usec_t saved, d = u->duration;
+
+                if (d <= 0)
+                        continue;
+
+                u->duration = 0;
+                saved = usec_sub_unsigned(modified, simulate_boot(&s, target));
+                u->duration = d;
+
+                if (saved <= 0)
+                        continue;
+
+                r = table_add_many(table,
+                                   TABLE_TIMESPAN_MSEC, saved,
+                                   TABLE_TIMESPAN_MSEC, d,
+                                   TABLE_STRING, u->times->name);
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
+
+        pager_open(arg_pager_flags);
+
+        printf("%s reached after %s, simulated %s.\n",
+               target_name,
+               FORMAT_TIMESPAN(unit_times_finish(target->times), USEC_PER_MSEC),
+               FORMAT_TIMESPAN(base, USEC_PER_MSEC));
+
+        if (argc > 1)
+                printf("With the specified changes: %s (%s%s).\n",
+                       FORMAT_TIMESPAN(modified, USEC_PER_MSEC),
+                       modified > base ? "+" : "-",
+                       FORMAT_TIMESPAN(modified > base ? modified - base : base - modified, USEC_PER_MSEC));
+
+        if (!table_isempty(table)) {
+                puts("\nTime saved if a unit started instantly:");
+
+                r = table_print(table, NULL);
+                if (r < 0)
+                        return r;
+        }
+
+        return EXIT_SUCCESS;
+}
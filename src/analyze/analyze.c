@@ -14,6 +14,7 @@
 #include "alloc-util.h"
 #include "analyze.h"
 #include "analyze-architectures.h"
+#include "analyze-benchmark.h"
 #include "analyze-blame.h"
 #include "analyze-calendar.h"
 #include "analyze-capability.h"
@@ -24,9 +25,11 @@
 #include "analyze-critical-chain.h"
 #include "analyze-dot.h"
 #include "analyze-dump.h"
+#include "analyze-event-loop.h"
 #include "analyze-exit-status.h"
 #include "analyze-fdstore.h"
 #include "analyze-filesystems.h"
+#include "analyze-generators.h"
 #include "analyze-has-tpm2.h"
 #include "analyze-image-policy.h"
 #include "analyze-inspect-elf.h"
@@ -36,6 +39,7 @@
 #include "analyze-plot.h"
 #include "analyze-security.h"
 #include "analyze-service-watchdogs.h"
+#include "analyze-simulate.h"
 #include "analyze-smbios11.h"
 #include "analyze-srk.h"
 #include "analyze-syscall-filter.h"
@@ -112,7 +116,7 @@ static char *arg_image = NULL;
 char *arg_security_policy = NULL;
 bool arg_offline = false;
 unsigned arg_threshold = 100;
-unsigned arg_iterations = 1;
+unsigned arg_iterations = 0;
 usec_t arg_base_time = USEC_INFINITY;
 char *arg_unit = NULL;
 sd_json_format_flags_t arg_json_format_flags = SD_JSON_FORMAT_OFF;
@@ -203,6 +207,10 @@ static int help(int argc, char *argv[], void *userdata) {
                "                             time to init\n"
                "  critical-chain [UNIT...]   Print a tree of the time critical chain\n"
                "                             of units\n"
+               "  simulate [CHANGE...]       Replay the boot with hypothetical changes\n"
+               "                             and rank units by time saved\n"
+               "  generators                 Print list of generators ordered by the\n"
+               "                             time they took on the last run\n"
                "\n%3$sDependency Analysis:%4$s\n"
                "  plot                       Output SVG graphic showing service\n"
                "                             initialization\n"
@@ -236,6 +244,10 @@ static int help(int argc, char *argv[], void *userdata) {
                "  security [UNIT...]         Analyze security of unit\n"
                "  fdstore SERVICE...         Show file descriptor store contents of service\n"
                "  malloc [D-BUS SERVICE...]  Dump malloc stats of a D-Bus service\n"
+               "  event-loop [ADDRESS [BOOL]]\n"
+               "                             Show event loop dispatch statistics of a\n"
+               "                             Varlink service, optionally toggling them\n"
+               "  benchmark [NAME...]        Run micro-benchmarks of systemd components\n"
                "\n%3$sExecutable Analysis:%4$s\n"
                "  inspect-elf FILE...        Parse and print ELF package metadata\n"
                "\n%3$sTPM Operations:%4$s\n"
@@ -269,7 +281,8 @@ static int help(int argc, char *argv[], void *userdata) {
                "     --generators[=BOOL]     Do [not] run unit generators\n"
                "                             (requires privileges)\n"
                "     --instance=NAME         Specify fallback instance name for template units\n"
-               "     --iterations=N          Show the specified number of iterations\n"
+               "     --iterations=N          Show the specified number of iterations,\n"
+               "                             or run benchmarks that many times\n"
                "     --base-time=TIMESTAMP   Calculate calendar times relative to\n"
                "                             specified time\n"
                "     --profile=name|PATH     Include the specified profile in the\n"
@@ -649,7 +662,9 @@ static int run(int argc, char *argv[]) {
                 { "help",              VERB_ANY, VERB_ANY, 0,            help                   },
                 { "time",              VERB_ANY, 1,        VERB_DEFAULT, verb_time              },
                 { "blame",             VERB_ANY, 1,        0,            verb_blame             },
+                { "generators",        VERB_ANY, 1,        0,            verb_generators        },
                 { "critical-chain",    VERB_ANY, VERB_ANY, 0,            verb_critical_chain    },
+                { "simulate",          VERB_ANY, VERB_ANY, 0,            verb_simulate          },
                 { "plot",              VERB_ANY, 1,        0,            verb_plot              },
                 { "dot",               VERB_ANY, VERB_ANY, 0,            verb_dot               },
                 /* ↓ The following seven verbs are deprecated, from here … ↓ */
@@ -678,6 +693,8 @@ static int run(int argc, char *argv[]) {
                 { "security",          VERB_ANY, VERB_ANY, 0,            verb_security          },
                 { "inspect-elf",       2,        VERB_ANY, 0,            verb_elf_inspection    },
                 { "malloc",            VERB_ANY, VERB_ANY, 0,            verb_malloc            },
+                { "event-loop",        VERB_ANY, 3,        0,            verb_event_loop        },
+                { "benchmark",         VERB_ANY, VERB_ANY, 0,            verb_benchmark         },
                 { "fdstore",           2,        VERB_ANY, 0,            verb_fdstore           },
                 { "image-policy",      2,        2,        0,            verb_image_policy      },
                 { "has-tpm2",          VERB_ANY, 1,        0,            verb_has_tpm2          },
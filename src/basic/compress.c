@@ -17,6 +17,7 @@
 #endif
 
 #if HAVE_ZSTD
+#include <zdict.h>
 #include <zstd.h>
 #include <zstd_errors.h>
 #endif
@@ -59,18 +60,28 @@ DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(LZ4F_decompressionContext_t, sym_LZ4F_freeDecom
 #if HAVE_ZSTD
 static void *zstd_dl = NULL;
 
+static DLSYM_PROTOTYPE(ZDICT_getErrorName) = NULL;
+static DLSYM_PROTOTYPE(ZDICT_isError) = NULL;
+static DLSYM_PROTOTYPE(ZDICT_trainFromBuffer) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_CCtx_setParameter) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_compress) = NULL;
+static DLSYM_PROTOTYPE(ZSTD_compress_usingCDict) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_compressStream2) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_createCCtx) = NULL;
+static DLSYM_PROTOTYPE(ZSTD_createCDict) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_createDCtx) = NULL;
+static DLSYM_PROTOTYPE(ZSTD_createDDict) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_CStreamInSize) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_CStreamOutSize) = NULL;
+static DLSYM_PROTOTYPE(ZSTD_DCtx_refDDict) = NULL;
+static DLSYM_PROTOTYPE(ZSTD_DCtx_reset) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_decompressStream) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_DStreamInSize) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_DStreamOutSize) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_freeCCtx) = NULL;
+static DLSYM_PROTOTYPE(ZSTD_freeCDict) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_freeDCtx) = NULL;
+static DLSYM_PROTOTYPE(ZSTD_freeDDict) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_getErrorCode) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_getErrorName) = NULL;
 static DLSYM_PROTOTYPE(ZSTD_getFrameContentSize) = NULL;
@@ -79,6 +90,15 @@ static DLSYM_PROTOTYPE(ZSTD_isError) = NULL;
 DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(ZSTD_CCtx*, sym_ZSTD_freeCCtx, NULL);
 DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(ZSTD_DCtx*, sym_ZSTD_freeDCtx, NULL);
 
+struct CompressDictionary {
+        ZSTD_CDict *cdict;
+        ZSTD_DDict *ddict;
+
+        /* Contexts are allocated lazily and reused, as dictionaries are meant for lots of small blobs */
+        ZSTD_CCtx *cctx;
+        ZSTD_DCtx *dctx;
+};
+
 static int zstd_ret_to_errno(size_t ret) {
         switch (sym_ZSTD_getErrorCode(ret)) {
         case ZSTD_error_dstSize_tooSmall:
@@ -291,6 +311,7 @@ int dlopen_zstd(void) {
                         "libzstd.so.1", LOG_DEBUG,
                         DLSYM_ARG(ZSTD_getErrorCode),
                         DLSYM_ARG(ZSTD_compress),
+                        DLSYM_ARG(ZSTD_compress_usingCDict),
                         DLSYM_ARG(ZSTD_getFrameContentSize),
                         DLSYM_ARG(ZSTD_decompressStream),
                         DLSYM_ARG(ZSTD_getErrorName),
@@ -300,11 +321,20 @@ int dlopen_zstd(void) {
                         DLSYM_ARG(ZSTD_CCtx_setParameter),
                         DLSYM_ARG(ZSTD_compressStream2),
                         DLSYM_ARG(ZSTD_DStreamInSize),
+                        DLSYM_ARG(ZSTD_DCtx_refDDict),
+                        DLSYM_ARG(ZSTD_DCtx_reset),
                         DLSYM_ARG(ZSTD_freeCCtx),
+                        DLSYM_ARG(ZSTD_freeCDict),
                         DLSYM_ARG(ZSTD_freeDCtx),
+                        DLSYM_ARG(ZSTD_freeDDict),
                         DLSYM_ARG(ZSTD_isError),
                         DLSYM_ARG(ZSTD_createDCtx),
-                        DLSYM_ARG(ZSTD_createCCtx));
+                        DLSYM_ARG(ZSTD_createDDict),
+                        DLSYM_ARG(ZSTD_createCCtx),
+                        DLSYM_ARG(ZSTD_createCDict),
+                        DLSYM_ARG(ZDICT_getErrorName),
+                        DLSYM_ARG(ZDICT_isError),
+                        DLSYM_ARG(ZDICT_trainFromBuffer));
 }
 #endif
 
@@ -445,25 +475,18 @@ int decompress_blob_lz4(
 #endif
 }
 
-int decompress_blob_zstd(
+#if HAVE_ZSTD
+static int decompress_blob_zstd_internal(
+                ZSTD_DCtx *dctx,
                 const void *src,
                 uint64_t src_size,
                 void **dst,
                 size_t *dst_size,
                 size_t dst_max) {
 
-        assert(src);
-        assert(src_size > 0);
-        assert(dst);
-        assert(dst_size);
-
-#if HAVE_ZSTD
         uint64_t size;
-        int r;
 
-        r = dlopen_zstd();
-        if (r < 0)
-                return r;
+        assert(dctx);
 
         size = sym_ZSTD_getFrameContentSize(src, src_size);
         if (IN_SET(size, ZSTD_CONTENTSIZE_ERROR, ZSTD_CONTENTSIZE_UNKNOWN))
@@ -477,10 +500,6 @@ int decompress_blob_zstd(
         if (!(greedy_realloc(dst, MAX(sym_ZSTD_DStreamOutSize(), size), 1)))
                 return -ENOMEM;
 
-        _cleanup_(sym_ZSTD_freeDCtxp) ZSTD_DCtx *dctx = sym_ZSTD_createDCtx();
-        if (!dctx)
-                return -ENOMEM;
-
         ZSTD_inBuffer input = {
                 .src = src,
                 .size = src_size,
@@ -499,6 +518,33 @@ int decompress_blob_zstd(
 
         *dst_size = size;
         return 0;
+}
+#endif
+
+int decompress_blob_zstd(
+                const void *src,
+                uint64_t src_size,
+                void **dst,
+                size_t *dst_size,
+                size_t dst_max) {
+
+        assert(src);
+        assert(src_size > 0);
+        assert(dst);
+        assert(dst_size);
+
+#if HAVE_ZSTD
+        int r;
+
+        r = dlopen_zstd();
+        if (r < 0)
+                return r;
+
+        _cleanup_(sym_ZSTD_freeDCtxp) ZSTD_DCtx *dctx = sym_ZSTD_createDCtx();
+        if (!dctx)
+                return -ENOMEM;
+
+        return decompress_blob_zstd_internal(dctx, src, src_size, dst, dst_size, dst_max);
 #else
         return -EPROTONOSUPPORT;
 #endif
@@ -669,7 +715,9 @@ int decompress_startswith_lz4(
 #endif
 }
 
-int decompress_startswith_zstd(
+#if HAVE_ZSTD
+static int decompress_startswith_zstd_internal(
+                ZSTD_DCtx *dctx,
                 const void *src,
                 uint64_t src_size,
                 void **buffer,
@@ -677,17 +725,7 @@ int decompress_startswith_zstd(
                 size_t prefix_len,
                 uint8_t extra) {
 
-        assert(src);
-        assert(src_size > 0);
-        assert(buffer);
-        assert(prefix);
-
-#if HAVE_ZSTD
-        int r;
-
-        r = dlopen_zstd();
-        if (r < 0)
-                return r;
+        assert(dctx);
 
         uint64_t size = sym_ZSTD_getFrameContentSize(src, src_size);
         if (IN_SET(size, ZSTD_CONTENTSIZE_ERROR, ZSTD_CONTENTSIZE_UNKNOWN))
@@ -696,10 +734,6 @@ int decompress_startswith_zstd(
         if (size < prefix_len + 1)
                 return 0; /* Decompressed text too short to match the prefix and extra */
 
-        _cleanup_(sym_ZSTD_freeDCtxp) ZSTD_DCtx *dctx = sym_ZSTD_createDCtx();
-        if (!dctx)
-                return -ENOMEM;
-
         if (!(greedy_realloc(buffer, MAX(sym_ZSTD_DStreamOutSize(), prefix_len + 1), 1)))
                 return -ENOMEM;
 
@@ -722,6 +756,34 @@ int decompress_startswith_zstd(
 
         return memcmp(*buffer, prefix, prefix_len) == 0 &&
                 ((const uint8_t*) *buffer)[prefix_len] == extra;
+}
+#endif
+
+int decompress_startswith_zstd(
+                const void *src,
+                uint64_t src_size,
+                void **buffer,
+                const void *prefix,
+                size_t prefix_len,
+                uint8_t extra) {
+
+        assert(src);
+        assert(src_size > 0);
+        assert(buffer);
+        assert(prefix);
+
+#if HAVE_ZSTD
+        int r;
+
+        r = dlopen_zstd();
+        if (r < 0)
+                return r;
+
+        _cleanup_(sym_ZSTD_freeDCtxp) ZSTD_DCtx *dctx = sym_ZSTD_createDCtx();
+        if (!dctx)
+                return -ENOMEM;
+
+        return decompress_startswith_zstd_internal(dctx, src, src_size, buffer, prefix, prefix_len, extra);
 #else
         return -EPROTONOSUPPORT;
 #endif
@@ -759,6 +821,210 @@ int decompress_startswith(
                 return -EBADMSG;
 }
 
+int compress_dictionary_train_zstd(
+                const void *samples,
+                const size_t *sample_sizes,
+                size_t n_samples,
+                size_t max_size,
+                void **ret,
+                size_t *ret_size) {
+
+        assert(samples);
+        assert(sample_sizes);
+        assert(max_size > 0);
+        assert(ret);
+        assert(ret_size);
+
+#if HAVE_ZSTD
+        _cleanup_free_ void *dict = NULL;
+        size_t k;
+        int r;
+
+        if (n_samples > UINT_MAX)
+                return -E2BIG;
+
+        r = dlopen_zstd();
+        if (r < 0)
+                return r;
+
+        dict = malloc(max_size);
+        if (!dict)
+                return -ENOMEM;
+
+        k = sym_ZDICT_trainFromBuffer(dict, max_size, samples, sample_sizes, n_samples);
+        if (sym_ZDICT_isError(k))
+                return log_debug_errno(SYNTHETIC_ERRNO(EINVAL),
+                                       "Failed to train ZSTD dictionary: %s", sym_ZDICT_getErrorName(k));
+
+        *ret = TAKE_PTR(dict);
+        *ret_size = k;
+        return 0;
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
+int compress_dictionary_new_zstd(const void *dict, size_t size, int level, CompressDictionary **ret) {
+        assert(dict);
+        assert(size > 0);
+        assert(ret);
+
+#if HAVE_ZSTD
+        _cleanup_(compress_dictionary_freep) CompressDictionary *d = NULL;
+        int r;
+
+        r = dlopen_zstd();
+        if (r < 0)
+                return r;
+
+        d = new0(CompressDictionary, 1);
+        if (!d)
+                return -ENOMEM;
+
+        /* Both copy the dictionary, hence the caller's buffer need not stay around */
+        d->cdict = sym_ZSTD_createCDict(dict, size, level < 0 ? 0 : level);
+        if (!d->cdict)
+                return -ENOMEM;
+
+        d->ddict = sym_ZSTD_createDDict(dict, size);
+        if (!d->ddict)
+                return -ENOMEM;
+
+        *ret = TAKE_PTR(d);
+        return 0;
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
+CompressDictionary* compress_dictionary_free(CompressDictionary *d) {
+        if (!d)
+                return NULL;
+
+#if HAVE_ZSTD
+        sym_ZSTD_freeCCtx(d->cctx);
+        sym_ZSTD_freeDCtx(d->dctx);
+        sym_ZSTD_freeCDict(d->cdict);
+        sym_ZSTD_freeDDict(d->ddict);
+#endif
+
+        return mfree(d);
+}
+
+#if HAVE_ZSTD
+static int compress_dictionary_acquire_dctx(CompressDictionary *d, ZSTD_DCtx **ret) {
+        size_t k;
+
+        assert(d);
+        assert(ret);
+
+        if (!d->dctx) {
+                _cleanup_(sym_ZSTD_freeDCtxp) ZSTD_DCtx *dctx = sym_ZSTD_createDCtx();
+                if (!dctx)
+                        return -ENOMEM;
+
+                k = sym_ZSTD_DCtx_refDDict(dctx, d->ddict);
+                if (sym_ZSTD_isError(k))
+                        return zstd_ret_to_errno(k);
+
+                d->dctx = TAKE_PTR(dctx);
+        } else {
+                /* A previous prefix match might have stopped in the middle of a frame. This keeps the
+                 * referenced dictionary. */
+                k = sym_ZSTD_DCtx_reset(d->dctx, ZSTD_reset_session_only);
+                if (sym_ZSTD_isError(k))
+                        return zstd_ret_to_errno(k);
+        }
+
+        *ret = d->dctx;
+        return 0;
+}
+#endif
+
+int compress_blob_zstd_dictionary(
+                CompressDictionary *d,
+                const void *src, uint64_t src_size,
+                void *dst, size_t dst_alloc_size, size_t *dst_size) {
+
+        assert(d);
+        assert(src);
+        assert(src_size > 0);
+        assert(dst);
+        assert(dst_alloc_size > 0);
+        assert(dst_size);
+
+#if HAVE_ZSTD
+        size_t k;
+
+        if (!d->cctx) {
+                d->cctx = sym_ZSTD_createCCtx();
+                if (!d->cctx)
+                        return -ENOMEM;
+        }
+
+        k = sym_ZSTD_compress_usingCDict(d->cctx, dst, dst_alloc_size, src, src_size, d->cdict);
+        if (sym_ZSTD_isError(k))
+                return zstd_ret_to_errno(k);
+
+        *dst_size = k;
+        return 0;
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
+int decompress_blob_zstd_dictionary(
+                CompressDictionary *d,
+                const void *src, uint64_t src_size,
+                void **dst, size_t *dst_size, size_t dst_max) {
+
+        assert(d);
+        assert(src);
+        assert(src_size > 0);
+        assert(dst);
+        assert(dst_size);
+
+#if HAVE_ZSTD
+        ZSTD_DCtx *dctx;
+        int r;
+
+        r = compress_dictionary_acquire_dctx(d, &dctx);
+        if (r < 0)
+                return r;
+
+        return decompress_blob_zstd_internal(dctx, src, src_size, dst, dst_size, dst_max);
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
+int decompress_startswith_zstd_dictionary(
+                CompressDictionary *d,
+                const void *src, uint64_t src_size,
+                void **buffer,
+                const void *prefix, size_t prefix_len,
+                uint8_t extra) {
+
+        assert(d);
+        assert(src);
+        assert(src_size > 0);
+        assert(buffer);
+        assert(prefix);
+
+#if HAVE_ZSTD
+        ZSTD_DCtx *dctx;
+        int r;
+
+        r = compress_dictionary_acquire_dctx(d, &dctx);
+        if (r < 0)
+                return r;
+
+        return decompress_startswith_zstd_internal(dctx, src, src_size, buffer, prefix, prefix_len, extra);
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
 int compress_stream_xz(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_uncompressed_size) {
         assert(fdf >= 0);
         assert(fdt >= 0);
@@ -1081,7 +1347,7 @@ int decompress_stream_lz4(int in, int out, uint64_t max_bytes) {
 #endif
 }
 
-int compress_stream_zstd(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_uncompressed_size) {
+int compress_stream_zstd_full(int fdf, int fdt, uint64_t max_bytes, unsigned n_threads, uint64_t *ret_uncompressed_size) {
         assert(fdf >= 0);
         assert(fdt >= 0);
 
@@ -1110,6 +1376,15 @@ int compress_stream_zstd(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_unc
         if (sym_ZSTD_isError(z))
                 log_debug("Failed to enable ZSTD checksum, ignoring: %s", sym_ZSTD_getErrorName(z));
 
+        if (n_threads > 0) {
+                /* With workers, compression happens in the background while we keep feeding input, and the
+                 * calls below only block once all workers are busy. */
+                z = sym_ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, (int) MIN(n_threads, (unsigned) INT_MAX));
+                if (sym_ZSTD_isError(z))
+                        log_debug("Failed to enable ZSTD multithreading, continuing single-threaded: %s",
+                                  sym_ZSTD_getErrorName(z));
+        }
+
         /* This loop read from the input file, compresses that entire chunk,
          * and writes all output produced to the output file.
          */
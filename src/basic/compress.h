@@ -64,9 +64,34 @@ int decompress_startswith(Compression compression,
                           const void *prefix, size_t prefix_len,
                           uint8_t extra);
 
+/* Trained dictionaries, which make compressing lots of small, similar blobs worthwhile. Only zstd is
+ * supported. */
+typedef struct CompressDictionary CompressDictionary;
+
+int compress_dictionary_train_zstd(const void *samples, const size_t *sample_sizes, size_t n_samples,
+                                   size_t max_size, void **ret, size_t *ret_size);
+int compress_dictionary_new_zstd(const void *dict, size_t size, int level, CompressDictionary **ret);
+CompressDictionary* compress_dictionary_free(CompressDictionary *d);
+DEFINE_TRIVIAL_CLEANUP_FUNC(CompressDictionary*, compress_dictionary_free);
+
+int compress_blob_zstd_dictionary(CompressDictionary *d,
+                                  const void *src, uint64_t src_size,
+                                  void *dst, size_t dst_alloc_size, size_t *dst_size);
+int decompress_blob_zstd_dictionary(CompressDictionary *d,
+                                    const void *src, uint64_t src_size,
+                                    void **dst, size_t *dst_size, size_t dst_max);
+int decompress_startswith_zstd_dictionary(CompressDictionary *d,
+                                          const void *src, uint64_t src_size,
+                                          void **buffer,
+                                          const void *prefix, size_t prefix_len,
+                                          uint8_t extra);
+
 int compress_stream_xz(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_uncompressed_size);
 int compress_stream_lz4(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_uncompressed_size);
-int compress_stream_zstd(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_uncompressed_size);
+int compress_stream_zstd_full(int fdf, int fdt, uint64_t max_bytes, unsigned n_threads, uint64_t *ret_uncompressed_size);
+static inline int compress_stream_zstd(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_uncompressed_size) {
+        return compress_stream_zstd_full(fdf, fdt, max_bytes, /* n_threads= */ 0, ret_uncompressed_size);
+}
 
 int decompress_stream_xz(int fdf, int fdt, uint64_t max_size);
 int decompress_stream_lz4(int fdf, int fdt, uint64_t max_size);
@@ -106,10 +131,11 @@ static inline int compress_blob(
         }
 }
 
-static inline int compress_stream(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_uncompressed_size) {
+/* n_threads is only honoured by zstd, and only if libzstd was built with multithreading support. */
+static inline int compress_stream_full(int fdf, int fdt, uint64_t max_bytes, unsigned n_threads, uint64_t *ret_uncompressed_size) {
         switch (DEFAULT_COMPRESSION) {
         case COMPRESSION_ZSTD:
-                return compress_stream_zstd(fdf, fdt, max_bytes, ret_uncompressed_size);
+                return compress_stream_zstd_full(fdf, fdt, max_bytes, n_threads, ret_uncompressed_size);
         case COMPRESSION_LZ4:
                 return compress_stream_lz4(fdf, fdt, max_bytes, ret_uncompressed_size);
         case COMPRESSION_XZ:
@@ -119,6 +145,10 @@ static inline int compress_stream(int fdf, int fdt, uint64_t max_bytes, uint64_t
         }
 }
 
+static inline int compress_stream(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_uncompressed_size) {
+        return compress_stream_full(fdf, fdt, max_bytes, /* n_threads= */ 0, ret_uncompressed_size);
+}
+
 static inline const char* default_compression_extension(void) {
         switch (DEFAULT_COMPRESSION) {
         case COMPRESSION_ZSTD:
@@ -641,6 +641,48 @@ int read_virtual_file_at(
         return !truncated;
 }
 
+int pread_virtual_file(int fd, char **ret_contents, size_t *ret_size) {
+        _cleanup_free_ char *buf = NULL;
+        size_t size;
+        ssize_t n;
+
+        assert(fd >= 0);
+        assert(ret_contents);
+
+        /* Like read_virtual_file_fd(), but reads the file from the start through the fd passed in, rather
+         * than through a reopened one. This is for callers that keep the fds of frequently polled procfs,
+         * sysfs or cgroupfs attributes open, where each read from offset 0 regenerates the contents. Like
+         * read_virtual_file_at(), each attempt is a single read, as some of these files require that. */
+
+        for (size = page_size() - 1;; size = MIN(size * 2 + 1, (size_t) READ_VIRTUAL_BYTES_MAX)) {
+                buf = mfree(buf);
+                buf = malloc(size + 1);
+                if (!buf)
+                        return -ENOMEM;
+
+                /* Read one more byte so we can detect whether the buffer was large enough */
+                n = pread(fd, buf, size + 1, 0);
+                if (n < 0)
+                        return -errno;
+                if ((size_t) n <= size)
+                        break;
+
+                if (size >= READ_VIRTUAL_BYTES_MAX)
+                        return -EFBIG;
+        }
+
+        if (!ret_size && memchr(buf, 0, n))
+                return -EBADMSG;
+
+        buf[n] = 0;
+        *ret_contents = TAKE_PTR(buf);
+
+        if (ret_size)
+                *ret_size = n;
+
+        return 0;
+}
+
 int read_full_stream_full(
                 FILE *f,
                 const char *filename,
@@ -1481,6 +1523,28 @@ static EndOfLineMarker categorize_eol(char c, ReadLineFlags flags) {
 
 DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(FILE*, funlockfile, NULL);
 
+static int safe_fgetc_unlocked(FILE *f, char *ret) {
+        int k;
+
+        assert(f);
+
+        /* Same as safe_fgetc(), but for use while the stream is locked via flockfile() already, which saves
+         * us from taking the lock again for every single character. */
+
+        errno = 0;
+        k = getc_unlocked(f);
+        if (k == EOF) {
+                if (ferror_unlocked(f))
+                        return errno_or_else(EIO);
+
+                *ret = 0;
+                return 0;
+        }
+
+        *ret = k;
+        return 1;
+}
+
 int read_line_full(FILE *f, size_t limit, ReadLineFlags flags, char **ret) {
         _cleanup_free_ char *buffer = NULL;
         size_t n = 0, count = 0;
@@ -1532,7 +1596,7 @@ int read_line_full(FILE *f, size_t limit, ReadLineFlags flags, char **ret) {
                         if (count >= INT_MAX) /* We couldn't return the counter anymore as "int", hence refuse this */
                                 return -ENOBUFS;
 
-                        r = safe_fgetc(f, &c);
+                        r = safe_fgetc_unlocked(f, &c);
                         if (r < 0)
                                 return r;
                         if (r == 0) /* EOF is definitely EOL */
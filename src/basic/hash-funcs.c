@@ -99,6 +99,13 @@ DEFINE_HASH_OPS_FULL(
                 void, trivial_hash_func, trivial_compare_func, free,
                 void, free);
 
+uint64_t trusted_trivial_hash_func(const void *p, uint64_t seed) {
+        return trusted_hash_mix64(PTR_TO_UINT64(p) ^ seed);
+}
+
+DEFINE_TRUSTED_HASH_OPS(trusted_trivial_hash_ops,
+                        void, trusted_trivial_hash_func, trivial_compare_func);
+
 void uint64_hash_func(const uint64_t *p, struct siphash *state) {
         siphash24_compress_typesafe(*p, state);
 }
@@ -114,6 +121,13 @@ DEFINE_HASH_OPS_WITH_VALUE_DESTRUCTOR(
                 uint64_t, uint64_hash_func, uint64_compare_func,
                 void, free);
 
+uint64_t trusted_uint64_hash_func(const uint64_t *p, uint64_t seed) {
+        return trusted_hash_mix64(*p ^ seed);
+}
+
+DEFINE_TRUSTED_HASH_OPS(trusted_uint64_hash_ops,
+                        uint64_t, trusted_uint64_hash_func, uint64_compare_func);
+
 #if SIZEOF_DEV_T != 8
 void devt_hash_func(const dev_t *p, struct siphash *state) {
         siphash24_compress_typesafe(*p, state);
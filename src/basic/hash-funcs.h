@@ -6,6 +6,7 @@
 #include "siphash24.h"
 
 typedef void (*hash_func_t)(const void *p, struct siphash *state);
+typedef uint64_t (*trusted_hash_func_t)(const void *p, uint64_t seed);
 typedef int (*compare_func_t)(const void *a, const void *b);
 
 struct hash_ops {
@@ -13,6 +14,8 @@ struct hash_ops {
         compare_func_t compare;
         free_func_t free_key;
         free_func_t free_value;
+        /* If set, used instead of siphash24 and 'hash'. See DEFINE_TRUSTED_HASH_OPS() below. */
+        trusted_hash_func_t trusted_hash;
 };
 
 #define _DEFINE_HASH_OPS(uq, name, type, hash_func, compare_func, free_key_func, free_value_func, scope) \
@@ -49,6 +52,20 @@ struct hash_ops {
                          UNIQ_T(static_free_key_wrapper, uq),           \
                          UNIQ_T(static_free_value_wrapper, uq), scope)
 
+/* The "trusted" hash ops skip siphash24 and use a plain keyed mixer, which is several times cheaper but gives
+ * no guarantee against collisions crafted by whoever picks the keys. Only use them for keys that cannot be
+ * controlled from the outside, e.g. pointers to our own objects or IDs we allocate ourselves. Keep the
+ * "trusted" in the name of every such hash_ops, so that all users can be found and audited with grep. */
+#define _DEFINE_TRUSTED_HASH_OPS(uq, name, type, hash_func, compare_func, free_key_func, free_value_func, scope) \
+        _unused_ static uint64_t (* UNIQ_T(static_hash_wrapper, uq))(const type *, uint64_t) = hash_func; \
+        _unused_ static int (* UNIQ_T(static_compare_wrapper, uq))(const type *, const type *) = compare_func; \
+        scope const struct hash_ops name = {                            \
+                .trusted_hash = (trusted_hash_func_t) hash_func,        \
+                .compare = (compare_func_t) compare_func,               \
+                .free_key = free_key_func,                              \
+                .free_value = free_value_func,                          \
+        }
+
 #define DEFINE_HASH_OPS(name, type, hash_func, compare_func)            \
         _DEFINE_HASH_OPS(UNIQ, name, type, hash_func, compare_func, NULL, NULL,)
 
@@ -73,6 +90,20 @@ struct hash_ops {
 #define DEFINE_PRIVATE_HASH_OPS_FULL(name, type, hash_func, compare_func, free_key_func, value_type, free_value_func) \
         _DEFINE_HASH_OPS_FULL(UNIQ, name, type, hash_func, compare_func, free_key_func, value_type, free_value_func, static)
 
+#define DEFINE_TRUSTED_HASH_OPS(name, type, hash_func, compare_func)    \
+        _DEFINE_TRUSTED_HASH_OPS(UNIQ, name, type, hash_func, compare_func, NULL, NULL,)
+
+#define DEFINE_PRIVATE_TRUSTED_HASH_OPS(name, type, hash_func, compare_func) \
+        _DEFINE_TRUSTED_HASH_OPS(UNIQ, name, type, hash_func, compare_func, NULL, NULL, static)
+
+/* The finalizer of splitmix64. Every output bit depends on every input bit, and it is a bijection, hence
+ * distinct keys never collide before being reduced to a bucket index. */
+static inline uint64_t trusted_hash_mix64(uint64_t x) {
+        x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+        x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+        return x ^ (x >> 31);
+}
+
 void string_hash_func(const char *p, struct siphash *state);
 #define string_compare_func strcmp
 extern const struct hash_ops string_hash_ops;
@@ -95,6 +126,11 @@ extern const struct hash_ops trivial_hash_ops_free;
 extern const struct hash_ops trivial_hash_ops_value_free;
 extern const struct hash_ops trivial_hash_ops_free_free;
 
+/* Like trivial_hash_ops, but with the cheaper trusted hash. Not for pointers that encode values which may
+ * come from the outside, like PIDs or UIDs. */
+uint64_t trusted_trivial_hash_func(const void *p, uint64_t seed) _const_;
+extern const struct hash_ops trusted_trivial_hash_ops;
+
 /* 32-bit values we can always just embed in the pointer itself, but in order to support 32-bit archs we need store 64-bit
  * values indirectly, since they don't fit in a pointer. */
 void uint64_hash_func(const uint64_t *p, struct siphash *state);
@@ -102,6 +138,9 @@ int uint64_compare_func(const uint64_t *a, const uint64_t *b) _pure_;
 extern const struct hash_ops uint64_hash_ops;
 extern const struct hash_ops uint64_hash_ops_value_free;
 
+uint64_t trusted_uint64_hash_func(const uint64_t *p, uint64_t seed) _pure_;
+extern const struct hash_ops trusted_uint64_hash_ops;
+
 /* On some archs dev_t is 32-bit, and on others 64-bit. And sometimes it's 64-bit on 32-bit archs, and sometimes 32-bit on
  * 64-bit archs. Yuck! */
 #if SIZEOF_DEV_T != 8
@@ -16,14 +16,13 @@
 #include "macro.h"
 #include "memory-util.h"
 #include "mempool.h"
-#include "missing_syscall.h"
-#include "process-util.h"
 #include "random-util.h"
 #include "set.h"
 #include "siphash24.h"
 #include "sort-util.h"
 #include "string-util.h"
 #include "strv.h"
+#include "unaligned.h"
 
 #if ENABLE_DEBUG_HASHMAP
 #include "list.h"
@@ -279,22 +278,6 @@ static _used_ const struct hashmap_type_info hashmap_type_info[_HASHMAP_TYPE_MAX
 };
 
 void hashmap_trim_pools(void) {
-        int r;
-
-        /* The pool is only allocated by the main thread, but the memory can be passed to other
-         * threads. Let's clean up if we are the main thread and no other threads are live. */
-
-        /* We build our own is_main_thread() here, which doesn't use C11 TLS based caching of the
-         * result. That's because valgrind apparently doesn't like TLS to be used from a GCC destructor. */
-        if (getpid() != gettid())
-                return (void) log_debug("Not cleaning up memory pools, not in main thread.");
-
-        r = get_process_threads(0);
-        if (r < 0)
-                return (void) log_debug_errno(r, "Failed to determine number of threads, not cleaning up memory pools: %m");
-        if (r != 1)
-                return (void) log_debug("Not cleaning up memory pools, running in multi-threaded process.");
-
         mempool_trim(&hashmap_pool);
         mempool_trim(&ordered_hashmap_pool);
 }
@@ -345,11 +328,15 @@ static unsigned base_bucket_hash(HashmapBase *h, const void *p) {
         struct siphash state;
         uint64_t hash;
 
-        siphash24_init(&state, hash_key(h));
+        if (h->hash_ops->trusted_hash)
+                hash = h->hash_ops->trusted_hash(p, unaligned_read_ne64(hash_key(h)));
+        else {
+                siphash24_init(&state, hash_key(h));
 
-        h->hash_ops->hash(p, &state);
+                h->hash_ops->hash(p, &state);
 
-        hash = siphash24_finalize(&state);
+                hash = siphash24_finalize(&state);
+        }
 
         return (unsigned) (hash % n_buckets(h));
 }
@@ -453,10 +440,22 @@ static void bucket_set_dib(HashmapBase *h, unsigned idx, unsigned dib) {
 
 static unsigned skip_free_buckets(HashmapBase *h, unsigned idx) {
         dib_raw_t *dibs;
+        unsigned n;
 
         dibs = dib_raw_ptr(h);
+        n = n_buckets(h);
+
+        /* Hashmaps never shrink, hence after removals most buckets may be free. Look at the DIBs of eight
+         * buckets at once: free buckets have all bits set, so the first occupied bucket is the lowest byte
+         * of the inverted word that is not zero. */
+        for ( ; idx + sizeof(uint64_t) <= n; idx += sizeof(uint64_t)) {
+                uint64_t w = ~unaligned_read_le64(dibs + idx);
+
+                if (w != 0)
+                        return idx + __builtin_ctzll(w) / 8;
+        }
 
-        for ( ; idx < n_buckets(h); idx++)
+        for ( ; idx < n; idx++)
                 if (dibs[idx] != DIB_RAW_FREE)
                         return idx;
 
@@ -904,11 +903,9 @@ static void hashmap_free_no_clear(HashmapBase *h) {
         assert_se(pthread_mutex_unlock(&hashmap_debug_list_mutex) == 0);
 #endif
 
-        if (h->from_pool) {
-                /* Ensure that the object didn't get migrated between threads. */
-                assert_se(is_main_thread());
+        if (h->from_pool)
                 mempool_free_tile(hashmap_type_info[h->type].mempool, h);
-        } else
+        else
                 free(h);
 }
 
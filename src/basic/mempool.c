@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -7,6 +8,7 @@
 #include "macro.h"
 #include "memory-util.h"
 #include "mempool.h"
+#include "missing_threads.h"
 
 struct pool {
         struct pool *next;
@@ -14,11 +16,153 @@ struct pool {
         size_t n_used;
 };
 
+/* Every thread keeps a small cache of free tiles for each pool it uses, so that allocating and freeing
+ * tiles usually does not need to take the pool lock. Tiles of a pool are interchangeable, hence a tile
+ * allocated in one thread may be freed into the cache of another: freeing never blocks on the thread
+ * that allocated the tile. Caches are handed back to the pool when they grow too large, when the thread
+ * exits, and when the pool is trimmed from the thread. */
+#define TILE_CACHES_MAX 8U
+#define TILE_CACHE_TILES_MAX 64U
+#define TILE_CACHE_REFILL 16U
+
+typedef struct TileCache {
+        struct mempool *mempool;
+        void *freelist;
+        size_t n_tiles;
+} TileCache;
+
+static thread_local TileCache tile_caches[TILE_CACHES_MAX];
+static pthread_key_t tile_cache_key;
+static bool tile_cache_key_valid = false;
+
+/* All pools that were ever locked, so that fork() can take all their locks, see pool_atfork_prepare() */
+static struct mempool *registered_pools = NULL;
+static pthread_mutex_t registered_pools_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void pool_atfork_prepare(void) {
+        /* Make sure no other thread is in the middle of modifying a pool while we fork, as the child would
+         * otherwise inherit a pool in an inconsistent state, with a lock that is never going to be
+         * released. */
+
+        assert_se(pthread_mutex_lock(&registered_pools_mutex) == 0);
+        for (struct mempool *mp = registered_pools; mp; mp = mp->next_registered)
+                assert_se(pthread_mutex_lock(&mp->mutex) == 0);
+}
+
+static void pool_atfork_release(void) {
+        /* Called in both parent and child, in the latter the forking thread owns the locks */
+
+        for (struct mempool *mp = registered_pools; mp; mp = mp->next_registered)
+                assert_se(pthread_mutex_unlock(&mp->mutex) == 0);
+        assert_se(pthread_mutex_unlock(&registered_pools_mutex) == 0);
+}
+
+static void pool_atfork_install(void) {
+        assert_se(pthread_atfork(pool_atfork_prepare, pool_atfork_release, pool_atfork_release) == 0);
+}
+
+static void pool_register(struct mempool *mp) {
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+        assert(mp);
+
+        assert_se(pthread_once(&once, pool_atfork_install) == 0);
+
+        assert_se(pthread_mutex_lock(&registered_pools_mutex) == 0);
+        if (!mp->registered) {
+                mp->next_registered = registered_pools;
+                registered_pools = mp;
+                __atomic_store_n(&mp->registered, true, __ATOMIC_RELEASE);
+        }
+        assert_se(pthread_mutex_unlock(&registered_pools_mutex) == 0);
+}
+
+static void pool_lock(struct mempool *mp) {
+        assert(mp);
+
+        if (!__atomic_load_n(&mp->registered, __ATOMIC_ACQUIRE))
+                pool_register(mp);
+
+        assert_se(pthread_mutex_lock(&mp->mutex) == 0);
+}
+
+static void pool_unlock(struct mempool *mp) {
+        assert(mp);
+
+        assert_se(pthread_mutex_unlock(&mp->mutex) == 0);
+}
+
 static void* pool_ptr(struct pool *p) {
         return ((uint8_t*) ASSERT_PTR(p)) + ALIGN(sizeof(struct pool));
 }
 
-void* mempool_alloc_tile(struct mempool *mp) {
+static void tile_cache_flush(TileCache *c) {
+        struct mempool *mp;
+        void **tail;
+
+        assert(c);
+
+        if (!c->freelist)
+                return;
+
+        mp = ASSERT_PTR(c->mempool);
+
+        for (tail = c->freelist; *tail; tail = *tail)
+                ;
+
+        pool_lock(mp);
+        *tail = mp->freelist;
+        mp->freelist = c->freelist;
+        pool_unlock(mp);
+
+        c->freelist = NULL;
+        c->n_tiles = 0;
+}
+
+static void tile_caches_flush(void *userdata) {
+        TileCache *caches = ASSERT_PTR(userdata);
+
+        /* Called when a thread exits. */
+
+        for (size_t i = 0; i < TILE_CACHES_MAX && caches[i].mempool; i++) {
+                tile_cache_flush(caches + i);
+                caches[i].mempool = NULL;
+        }
+}
+
+static void tile_cache_key_init(void) {
+        tile_cache_key_valid = pthread_key_create(&tile_cache_key, tile_caches_flush) == 0;
+}
+
+static TileCache* tile_cache_find(struct mempool *mp, bool create) {
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+        assert(mp);
+
+        FOREACH_ELEMENT(c, tile_caches) {
+                if (c->mempool == mp)
+                        return c;
+                if (c->mempool)
+                        continue;
+                if (!create)
+                        return NULL;
+
+                /* The first pool this thread uses, make sure the caches are handed back on exit. If that
+                 * does not work, operate on the pool directly. */
+                if (c == tile_caches) {
+                        assert_se(pthread_once(&once, tile_cache_key_init) == 0);
+                        if (!tile_cache_key_valid || pthread_setspecific(tile_cache_key, tile_caches) != 0)
+                                return NULL;
+                }
+
+                c->mempool = mp;
+                return c;
+        }
+
+        return NULL;
+}
+
+static void* pool_alloc_tile_unlocked(struct mempool *mp, bool may_grow) {
         size_t i;
 
         /* When a tile is released we add it to the list and simply
@@ -41,6 +185,9 @@ void* mempool_alloc_tile(struct mempool *mp) {
                 size_t size, n;
                 struct pool *p;
 
+                if (!may_grow)
+                        return NULL;
+
                 n = mp->first_pool ? mp->first_pool->n_tiles : 0;
                 n = MAX(mp->at_least, n * 2);
                 size = PAGE_ALIGN(ALIGN(sizeof(struct pool)) + n*mp->tile_size);
@@ -62,6 +209,44 @@ void* mempool_alloc_tile(struct mempool *mp) {
         return (uint8_t*) pool_ptr(mp->first_pool) + i*mp->tile_size;
 }
 
+void* mempool_alloc_tile(struct mempool *mp) {
+        TileCache *c;
+        void *t;
+
+        assert(mp);
+
+        c = tile_cache_find(mp, /* create = */ true);
+        if (c && c->freelist) {
+                t = c->freelist;
+                c->freelist = *(void**) t;
+                c->n_tiles--;
+                return t;
+        }
+
+        pool_lock(mp);
+
+        t = pool_alloc_tile_unlocked(mp, /* may_grow = */ true);
+
+        /* While we hold the lock anyway, take a few more tiles for later, but without allocating a new
+         * pool for them. */
+        if (t && c)
+                while (c->n_tiles < TILE_CACHE_REFILL) {
+                        void *u;
+
+                        u = pool_alloc_tile_unlocked(mp, /* may_grow = */ false);
+                        if (!u)
+                                break;
+
+                        *(void**) u = c->freelist;
+                        c->freelist = u;
+                        c->n_tiles++;
+                }
+
+        pool_unlock(mp);
+
+        return t;
+}
+
 void* mempool_alloc0_tile(struct mempool *mp) {
         void *p;
 
@@ -72,13 +257,28 @@ void* mempool_alloc0_tile(struct mempool *mp) {
 }
 
 void* mempool_free_tile(struct mempool *mp, void *p) {
+        TileCache *c;
+
         assert(mp);
 
         if (!p)
                 return NULL;
 
+        c = tile_cache_find(mp, /* create = */ true);
+        if (c) {
+                *(void**) p = c->freelist;
+                c->freelist = p;
+
+                if (++c->n_tiles > TILE_CACHE_TILES_MAX)
+                        tile_cache_flush(c);
+
+                return NULL;
+        }
+
+        pool_lock(mp);
         *(void**) p = mp->freelist;
         mp->freelist = p;
+        pool_unlock(mp);
 
         return NULL;
 }
@@ -153,9 +353,19 @@ static void pool_unlink(struct mempool *mp, struct pool *p) {
 
 void mempool_trim(struct mempool *mp) {
         size_t trimmed = 0, left = 0;
+        TileCache *c;
 
         assert(mp);
 
+        /* Tiles sitting in the caches of other threads keep their pools alive, but that is all: this is safe
+         * to call from any thread at any time. */
+
+        c = tile_cache_find(mp, /* create = */ false);
+        if (c)
+                tile_cache_flush(c);
+
+        pool_lock(mp);
+
         struct pool **p = &mp->first_pool;
         while (*p) {
                 struct pool *d = *p;
@@ -171,5 +381,7 @@ void mempool_trim(struct mempool *mp) {
                 }
         }
 
+        pool_unlock(mp);
+
         log_debug("Trimmed %s from memory pool %p. (%s left)", FORMAT_BYTES(trimmed), mp, FORMAT_BYTES(left));
 }
@@ -1,12 +1,16 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 #pragma once
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
 
 struct pool;
 
 struct mempool {
+        pthread_mutex_t mutex;     /* protects first_pool and freelist */
+        bool registered;           /* whether linked into the list of pools whose locks are taken on fork() */
+        struct mempool *next_registered;
         struct pool *first_pool;
         void *freelist;
         size_t tile_size;
@@ -19,6 +23,7 @@ void* mempool_free_tile(struct mempool *mp, void *p);
 
 #define DEFINE_MEMPOOL(pool_name, tile_type, alloc_at_least) \
 static struct mempool pool_name = { \
+        .mutex = PTHREAD_MUTEX_INITIALIZER, \
         .tile_size = sizeof(tile_type), \
         .at_least = alloc_at_least, \
 }
@@ -10,6 +10,7 @@
 #include "errno-util.h"
 #include "fd-util.h"
 #include "fileio.h"
+#include "hashmap.h"
 #include "missing_fs.h"
 #include "missing_magic.h"
 #include "missing_namespace.h"
@@ -557,6 +558,66 @@ int userns_acquire(const char *uid_map, const char *gid_map) {
         return pidref_namespace_open_by_type(&pid, NAMESPACE_USER);
 }
 
+#define USERNS_CACHE_MAX 16U
+
+/* Maps "<uid_map>\n<gid_map>" → user namespace fd */
+static Hashmap *userns_cache = NULL;
+
+int userns_acquire_cached(const char *uid_map, const char *gid_map) {
+        _cleanup_close_ int fd = -EBADF;
+        _cleanup_free_ char *key = NULL;
+        void *p;
+        int r;
+
+        assert(uid_map);
+        assert(gid_map);
+
+        /* Like userns_acquire(), but reuses a user namespace this process acquired earlier for the very same
+         * mappings. Mappings can't be changed once written, hence such a user namespace can be used for any
+         * number of ID mapped mounts. This saves a fork() for callers that set up the same ID mapping over
+         * and over again. Always returns a new fd owned by the caller. Not thread-safe. */
+
+        key = strjoin(uid_map, "\n", gid_map);
+        if (!key)
+                return -ENOMEM;
+
+        p = hashmap_get(userns_cache, key);
+        if (p)
+                return RET_NERRNO(fcntl(PTR_TO_FD(p), F_DUPFD_CLOEXEC, 3));
+
+        fd = userns_acquire(uid_map, gid_map);
+        if (fd < 0)
+                return fd;
+
+        if (hashmap_size(userns_cache) >= USERNS_CACHE_MAX)
+                userns_cache_flush();
+
+        _cleanup_close_ int copy = fcntl(fd, F_DUPFD_CLOEXEC, 3);
+        if (copy < 0) {
+                log_debug_errno(errno, "Failed to duplicate user namespace fd, not caching it: %m");
+                return TAKE_FD(fd);
+        }
+
+        r = hashmap_ensure_put(&userns_cache, &string_hash_ops_free, key, FD_TO_PTR(copy));
+        if (r < 0)
+                log_debug_errno(r, "Failed to cache user namespace fd, ignoring: %m");
+        else {
+                TAKE_PTR(key);
+                TAKE_FD(copy);
+        }
+
+        return TAKE_FD(fd);
+}
+
+void userns_cache_flush(void) {
+        void *p;
+
+        HASHMAP_FOREACH(p, userns_cache)
+                safe_close(PTR_TO_FD(p));
+
+        userns_cache = hashmap_free(userns_cache);
+}
+
 int userns_enter_and_pin(int userns_fd, pid_t *ret_pid) {
         _cleanup_close_pair_ int pfd[2] = EBADF_PAIR;
         _cleanup_(sigkill_waitp) pid_t pid = 0;
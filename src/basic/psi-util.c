@@ -15,16 +15,15 @@
 #include "stat-util.h"
 #include "strv.h"
 
-int read_resource_pressure(const char *path, PressureType type, ResourcePressure *ret) {
+int parse_resource_pressure(const char *contents, PressureType type, ResourcePressure *ret) {
         _cleanup_free_ char *line = NULL;
-        _cleanup_fclose_ FILE *f = NULL;
         unsigned field_filled = 0;
         ResourcePressure rp = {};
         const char *t, *cline;
         char *word;
         int r;
 
-        assert(path);
+        assert(contents);
         assert(IN_SET(type, PRESSURE_TYPE_SOME, PRESSURE_TYPE_FULL));
         assert(ret);
 
@@ -35,31 +34,24 @@ int read_resource_pressure(const char *path, PressureType type, ResourcePressure
         else
                 return -EINVAL;
 
-        r = fopen_unlocked(path, "re", &f);
-        if (r < 0)
-                return r;
-
-        for (;;) {
-                _cleanup_free_ char *l = NULL;
-                char *w;
+        for (const char *p = contents; *p; p += strspn(p, NEWLINE)) {
+                size_t l = strcspn(p, NEWLINE);
 
-                r = read_line(f, LONG_LINE_MAX, &l);
-                if (r < 0)
-                        return r;
-                if (r == 0)
-                        break;
-
-                w = first_word(l, t);
-                if (w) {
-                        line = TAKE_PTR(l);
-                        cline = w;
+                if (first_word(p, t)) {
+                        line = strndup(p, l);
+                        if (!line)
+                                return -ENOMEM;
                         break;
                 }
+
+                p += l;
         }
 
         if (!line)
                 return -ENODATA;
 
+        cline = first_word(line, t);
+
         /* extracts either avgX=Y.Z or total=X */
         while ((r = extract_first_word(&cline, &word, NULL, 0)) > 0) {
                 _cleanup_free_ char *w = word;
@@ -106,6 +98,20 @@ int read_resource_pressure(const char *path, PressureType type, ResourcePressure
         return 0;
 }
 
+int read_resource_pressure(const char *path, PressureType type, ResourcePressure *ret) {
+        _cleanup_free_ char *contents = NULL;
+        int r;
+
+        assert(path);
+        assert(ret);
+
+        r = read_full_virtual_file(path, &contents, NULL);
+        if (r < 0)
+                return r;
+
+        return parse_resource_pressure(contents, type, ret);
+}
+
 int is_pressure_supported(void) {
         static thread_local int cached = -1;
         int r;
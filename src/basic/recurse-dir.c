@@ -12,6 +12,9 @@
 
 #define DEFAULT_RECURSION_MAX 100
 
+/* Initial buffer size for reading directory entries, the same glibc's readdir() uses */
+#define READDIR_BUFFER_SIZE (32U * 1024U)
+
 static int sort_func(struct dirent * const *a, struct dirent * const *b) {
         return strcmp((*a)->d_name, (*b)->d_name);
 }
@@ -36,10 +39,11 @@ int readdir_all(int dir_fd, RecurseDirFlags flags, DirectoryEntries **ret) {
         /* Returns an array with pointers to "struct dirent" directory entries, optionally sorted. Free the
          * array with readdir_all_freep().
          *
-         * Start with space for up to 8 directory entries. We expect at least 2 ("." + ".."), hence hopefully
-         * 8 will cover most cases comprehensively. (Note that most likely a lot more entries will actually
-         * fit in the buffer, given we calculate maximum file name length here.) */
-        de = malloc(offsetof(DirectoryEntries, buffer) + DIRENT_SIZE_MAX * 8);
+         * Start with 32K of buffer space. With typical file name lengths that covers a few hundred entries
+         * in a single getdents64() call, and means that directories with many entries need only a few
+         * rounds of growing the buffer (and copying what we read so far). The buffer is shrunk to what is
+         * actually used below, hence this doesn't cost memory while we recurse. */
+        de = malloc(offsetof(DirectoryEntries, buffer) + MAX(READDIR_BUFFER_SIZE, DIRENT_SIZE_MAX * 8));
         if (!de)
                 return -ENOMEM;
 
@@ -124,12 +124,10 @@ bool unit_suffix_is_valid(const char *s) {
         return true;
 }
 
-int unit_name_to_prefix(const char *n, char **ret) {
+int unit_name_to_prefix_view(const char *n, const char **ret, size_t *ret_len) {
         const char *p;
-        char *s;
 
         assert(n);
-        assert(ret);
 
         if (!unit_name_is_valid(n, UNIT_NAME_ANY))
                 return -EINVAL;
@@ -140,7 +138,27 @@ int unit_name_to_prefix(const char *n, char **ret) {
 
         assert_se(p);
 
-        s = strndup(n, p - n);
+        if (ret)
+                *ret = n;
+        if (ret_len)
+                *ret_len = p - n;
+        return 0;
+}
+
+int unit_name_to_prefix(const char *n, char **ret) {
+        const char *p;
+        size_t l;
+        char *s;
+        int r;
+
+        assert(n);
+        assert(ret);
+
+        r = unit_name_to_prefix_view(n, &p, &l);
+        if (r < 0)
+                return r;
+
+        s = strndup(p, l);
         if (!s)
                 return -ENOMEM;
 
@@ -148,7 +166,7 @@ int unit_name_to_prefix(const char *n, char **ret) {
         return 0;
 }
 
-UnitNameFlags unit_name_to_instance(const char *n, char **ret) {
+UnitNameFlags unit_name_to_instance_view(const char *n, const char **ret, size_t *ret_len) {
         const char *p, *d;
 
         assert(n);
@@ -161,6 +179,8 @@ UnitNameFlags unit_name_to_instance(const char *n, char **ret) {
         if (!p) {
                 if (ret)
                         *ret = NULL;
+                if (ret_len)
+                        *ret_len = 0;
                 return UNIT_NAME_PLAIN;
         }
 
@@ -170,14 +190,36 @@ UnitNameFlags unit_name_to_instance(const char *n, char **ret) {
         if (!d)
                 return -EINVAL;
 
+        if (ret)
+                *ret = p;
+        if (ret_len)
+                *ret_len = d - p;
+        return d > p ? UNIT_NAME_INSTANCE : UNIT_NAME_TEMPLATE;
+}
+
+UnitNameFlags unit_name_to_instance(const char *n, char **ret) {
+        UnitNameFlags f;
+        const char *p;
+        size_t l;
+
+        assert(n);
+
+        f = unit_name_to_instance_view(n, &p, &l);
+        if (f < 0)
+                return f;
+
         if (ret) {
-                char *i = strndup(p, d-p);
-                if (!i)
-                        return -ENOMEM;
+                char *i = NULL;
+
+                if (p) {
+                        i = strndup(p, l);
+                        if (!i)
+                                return -ENOMEM;
+                }
 
                 *ret = i;
         }
-        return d > p ? UNIT_NAME_INSTANCE : UNIT_NAME_TEMPLATE;
+        return f;
 }
 
 int unit_name_to_prefix_and_instance(const char *n, char **ret) {
@@ -454,9 +496,21 @@ int unit_name_path_unescape(const char *f, char **ret) {
         return 0;
 }
 
-int unit_name_replace_instance_full(
+static bool in_charset_n(const char *s, size_t n, const char *charset) {
+        assert(s);
+        assert(charset);
+
+        FOREACH_ARRAY(c, s, n)
+                if (*c == 0 || !strchr(charset, *c))
+                        return false;
+
+        return true;
+}
+
+int unit_name_replace_instance_n(
                 const char *original,
                 const char *instance,
+                size_t instance_len,
                 bool accept_glob,
                 char **ret) {
 
@@ -468,9 +522,18 @@ int unit_name_replace_instance_full(
         assert(instance);
         assert(ret);
 
+        /* Like unit_name_replace_instance_full(), but the instance does not need to be NUL-terminated, so
+         * that it may point into another unit name. */
+
+        if (instance_len == SIZE_MAX)
+                instance_len = strlen(instance);
+
         if (!unit_name_is_valid(original, UNIT_NAME_INSTANCE|UNIT_NAME_TEMPLATE))
                 return -EINVAL;
-        if (!unit_instance_is_valid(instance) && !(accept_glob && in_charset(instance, VALID_CHARS_GLOB)))
+        if (instance_len == 0)
+                return -EINVAL;
+        if (!in_charset_n(instance, instance_len, "@" VALID_CHARS) &&
+            !(accept_glob && in_charset_n(instance, instance_len, VALID_CHARS_GLOB)))
                 return -EINVAL;
 
         prefix = ASSERT_PTR(strchr(original, '@'));
@@ -479,16 +542,11 @@ int unit_name_replace_instance_full(
 
         pl = prefix - original + 1; /* include '@' */
 
-        s = new(char, pl + strlen(instance) + strlen(suffix) + 1);
+        s = new(char, pl + instance_len + strlen(suffix) + 1);
         if (!s)
                 return -ENOMEM;
 
-#if HAS_FEATURE_MEMORY_SANITIZER
-        /* MSan doesn't like stpncpy... See also https://github.com/google/sanitizers/issues/926 */
-        memzero(s, pl + strlen(instance) + strlen(suffix) + 1);
-#endif
-
-        strcpy(stpcpy(stpncpy(s, original, pl), instance), suffix);
+        strcpy(mempcpy(mempcpy(s, original, pl), instance, instance_len), suffix);
 
         /* Make sure the resulting name still is valid, i.e. didn't grow too large. Globs will be expanded
          * by clients when used, so the check is pointless. */
@@ -894,23 +952,13 @@ bool slice_name_is_valid(const char *name) {
 
 bool unit_name_prefix_equal(const char *a, const char *b) {
         const char *p, *q;
+        size_t m, n;
 
         assert(a);
         assert(b);
 
-        if (!unit_name_is_valid(a, UNIT_NAME_ANY) || !unit_name_is_valid(b, UNIT_NAME_ANY))
+        if (unit_name_to_prefix_view(a, &p, &m) < 0 || unit_name_to_prefix_view(b, &q, &n) < 0)
                 return false;
 
-        p = strchr(a, '@');
-        if (!p)
-                p = strrchr(a, '.');
-
-        q = strchr(b, '@');
-        if (!q)
-                q = strrchr(b, '.');
-
-        assert(p);
-        assert(q);
-
-        return memcmp_nn(a, p - a, b, q - b) == 0;
+        return memcmp_nn(p, m, q, n) == 0;
 }
@@ -21,6 +21,11 @@ bool unit_prefix_is_valid(const char *p) _pure_;
 bool unit_instance_is_valid(const char *i) _pure_;
 bool unit_suffix_is_valid(const char *s) _pure_;
 
+/* These return the part of the name they are interested in as pointer into the name plus length, without
+ * allocating anything. */
+int unit_name_to_prefix_view(const char *n, const char **ret, size_t *ret_len);
+UnitNameFlags unit_name_to_instance_view(const char *n, const char **ret, size_t *ret_len);
+
 int unit_name_to_prefix(const char *n, char **ret);
 UnitNameFlags unit_name_to_instance(const char *n, char **ret);
 static inline UnitNameFlags unit_name_classify(const char *n) {
@@ -40,11 +45,19 @@ int unit_name_unescape(const char *f, char **ret);
 int unit_name_path_escape(const char *f, char **ret);
 int unit_name_path_unescape(const char *f, char **ret);
 
-int unit_name_replace_instance_full(
+int unit_name_replace_instance_n(
                 const char *original,
                 const char *instance,
+                size_t instance_len,
                 bool accept_glob,
                 char **ret);
+static inline int unit_name_replace_instance_full(
+                const char *original,
+                const char *instance,
+                bool accept_glob,
+                char **ret) {
+        return unit_name_replace_instance_n(original, instance, SIZE_MAX, accept_glob, ret);
+}
 static inline int unit_name_replace_instance(const char *original, const char *instance, char **ret) {
         return unit_name_replace_instance_full(original, instance, false, ret);
 }
@@ -16,6 +16,7 @@
 #include "hexdecoct.h"
 #include "macro.h"
 #include "string-util.h"
+#include "unaligned.h"
 #include "utf8.h"
 
 bool unichar_is_valid(char32_t ch) {
@@ -130,15 +131,32 @@ bool utf8_is_printable_newline(const char* str, size_t length, bool allow_newlin
         return true;
 }
 
+static bool word_is_ascii_nonzero(uint64_t w) {
+        /* Checks whether none of the 8 bytes of the word has the high bit set or is zero */
+        return ((w | ((w - UINT64_C(0x0101010101010101)) & ~w)) & UINT64_C(0x8080808080808080)) == 0;
+}
+
 char* utf8_is_valid_n(const char *str, size_t len_bytes) {
         /* Check if the string is composed of valid utf8 characters. If length len_bytes is given, stop after
          * len_bytes. Otherwise, stop at NUL. */
 
         assert(str);
 
-        for (size_t i = 0; len_bytes != SIZE_MAX ? i < len_bytes : str[i] != '\0'; ) {
+        for (size_t i = 0;; ) {
                 int len;
 
+                /* Most strings we validate are mostly or entirely ASCII, hence skip over runs of ASCII quickly,
+                 * eight bytes at a time if we know how much we may read, and byte-wise otherwise. */
+                if (len_bytes != SIZE_MAX)
+                        while (len_bytes - i >= sizeof(uint64_t) && word_is_ascii_nonzero(unaligned_read_ne64(str + i)))
+                                i += sizeof(uint64_t);
+
+                while ((len_bytes == SIZE_MAX || i < len_bytes) && (uint8_t) str[i] - 1U < 0x7FU)
+                        i++;
+
+                if (len_bytes != SIZE_MAX ? i >= len_bytes : str[i] == '\0')
+                        break;
+
                 if (_unlikely_(str[i] == '\0'))
                         return NULL; /* embedded NUL */
 
@@ -2028,6 +2028,137 @@ static void config_add_entry_windows(Config *config, EFI_HANDLE *device, EFI_FIL
 #endif
 }
 
+static BootEntry* boot_entry_add_type2_profile(
+                Config *config,
+                EFI_HANDLE *device,
+                const uint16_t *path,
+                const uint16_t *filename,
+                unsigned profile,
+                char *osrel,
+                char *profile_data) {
+
+        assert(config);
+        assert(device);
+        assert(path);
+        assert(filename);
+        assert(osrel);
+
+        /* Creates the menu entry for one profile of a UKI, from the contents of its .osrel and (optional)
+         * .profile sections. Note that both buffers are modified while parsing. */
+
+        _cleanup_free_ char16_t *os_pretty_name = NULL, *os_image_id = NULL, *os_name = NULL, *os_id = NULL,
+                *os_image_version = NULL, *os_version = NULL, *os_version_id = NULL, *os_build_id = NULL;
+        char *line, *key, *value;
+        size_t pos = 0;
+
+        /* read properties from the embedded os-release file */
+        while ((line = line_get_key_value(osrel, "=", &pos, &key, &value)))
+                if (streq8(key, "PRETTY_NAME")) {
+                        free(os_pretty_name);
+                        os_pretty_name = xstr8_to_16(value);
+
+                } else if (streq8(key, "IMAGE_ID")) {
+                        free(os_image_id);
+                        os_image_id = xstr8_to_16(value);
+
+                } else if (streq8(key, "NAME")) {
+                        free(os_name);
+                        os_name = xstr8_to_16(value);
+
+                } else if (streq8(key, "ID")) {
+                        free(os_id);
+                        os_id = xstr8_to_16(value);
+
+                } else if (streq8(key, "IMAGE_VERSION")) {
+                        free(os_image_version);
+                        os_image_version = xstr8_to_16(value);
+
+                } else if (streq8(key, "VERSION")) {
+                        free(os_version);
+                        os_version = xstr8_to_16(value);
+
+                } else if (streq8(key, "VERSION_ID")) {
+                        free(os_version_id);
+                        os_version_id = xstr8_to_16(value);
+
+                } else if (streq8(key, "BUILD_ID")) {
+                        free(os_build_id);
+                        os_build_id = xstr8_to_16(value);
+                }
+
+        const char16_t *good_name, *good_version, *good_sort_key;
+        if (!bootspec_pick_name_version_sort_key(
+                            os_pretty_name,
+                            os_image_id,
+                            os_name,
+                            os_id,
+                            os_image_version,
+                            os_version,
+                            os_version_id,
+                            os_build_id,
+                            &good_name,
+                            &good_version,
+                            &good_sort_key))
+                return NULL;
+
+        _cleanup_free_ char16_t *profile_id = NULL, *profile_title = NULL;
+
+        if (profile_data) {
+                /* read properties from the embedded .profile data */
+                pos = 0;
+                while ((line = line_get_key_value(profile_data, "=", &pos, &key, &value)))
+                        if (streq8(key, "ID")) {
+                                free(profile_id);
+                                profile_id = xstr8_to_16(value);
+                        } else if (streq8(key, "TITLE")) {
+                                free(profile_title);
+                                profile_title = xstr8_to_16(value);
+                        }
+        }
+
+        _cleanup_free_ char16_t *id = NULL;
+        if (profile > 0) {
+                if (profile_id)
+                        id = xasprintf("%ls@%ls", filename, profile_id);
+                else
+                        id = xasprintf("%ls@%u", filename, profile);
+        } else
+                id = xstrdup16(filename);
+
+        _cleanup_free_ char16_t *title = NULL;
+        if (profile_title)
+                title = xasprintf("%ls (%ls)", good_name, profile_title);
+        else if (profile > 0) {
+                if (profile_id)
+                        title = xasprintf("%ls (%ls)", good_name, profile_id);
+                else
+                        title = xasprintf("%ls (Profile #%u)", good_name, profile + 1);
+        } else
+                title = xstrdup16(good_name);
+
+        BootEntry *entry = xnew(BootEntry, 1);
+        *entry = (BootEntry) {
+                .id = strtolower16(TAKE_PTR(id)),
+                .id_without_profile = profile > 0 ? strtolower16(xstrdup16(filename)) : NULL,
+                .type = LOADER_TYPE2_UKI,
+                .title = TAKE_PTR(title),
+                .version = xstrdup16(good_version),
+                .device = device,
+                .loader = xasprintf("%ls\\%ls", path, filename),
+                .sort_key = xstrdup16(good_sort_key),
+                .key = 'l',
+                .tries_done = -1,
+                .tries_left = -1,
+                .profile = profile,
+                .call = call_image_start,
+        };
+
+        config_add_entry(config, entry);
+        boot_entry_parse_tries(entry, path, filename, u".efi");
+
+        return entry;
+}
+
 static void boot_entry_add_type2(
                 Config *config,
                 EFI_HANDLE *device,
@@ -2099,159 +2230,253 @@ static void boot_entry_add_type2(
                 if (!PE_SECTION_VECTOR_IS_SET(sections + SECTION_OSREL))
                         continue;
 
-                _cleanup_free_ char *content = NULL;
+                _cleanup_free_ char *osrel = NULL;
                 err = file_handle_read(
                                 handle,
                                 sections[SECTION_OSREL].file_offset,
                                 sections[SECTION_OSREL].file_size,
-                                &content,
+                                &osrel,
                                 /* ret_size= */ NULL);
                 if (err != EFI_SUCCESS)
                         continue;
 
-                _cleanup_free_ char16_t *os_pretty_name = NULL, *os_image_id = NULL, *os_name = NULL, *os_id = NULL,
-                        *os_image_version = NULL, *os_version = NULL, *os_version_id = NULL, *os_build_id = NULL;
-                char *line, *key, *value;
-                size_t pos = 0;
-
-                /* read properties from the embedded os-release file */
-                while ((line = line_get_key_value(content, "=", &pos, &key, &value)))
-                        if (streq8(key, "PRETTY_NAME")) {
-                                free(os_pretty_name);
-                                os_pretty_name = xstr8_to_16(value);
-
-                        } else if (streq8(key, "IMAGE_ID")) {
-                                free(os_image_id);
-                                os_image_id = xstr8_to_16(value);
-
-                        } else if (streq8(key, "NAME")) {
-                                free(os_name);
-                                os_name = xstr8_to_16(value);
-
-                        } else if (streq8(key, "ID")) {
-                                free(os_id);
-                                os_id = xstr8_to_16(value);
-
-                        } else if (streq8(key, "IMAGE_VERSION")) {
-                                free(os_image_version);
-                                os_image_version = xstr8_to_16(value);
-
-                        } else if (streq8(key, "VERSION")) {
-                                free(os_version);
-                                os_version = xstr8_to_16(value);
-
-                        } else if (streq8(key, "VERSION_ID")) {
-                                free(os_version_id);
-                                os_version_id = xstr8_to_16(value);
-
-                        } else if (streq8(key, "BUILD_ID")) {
-                                free(os_build_id);
-                                os_build_id = xstr8_to_16(value);
-                        }
-
-                const char16_t *good_name, *good_version, *good_sort_key;
-                if (!bootspec_pick_name_version_sort_key(
-                                    os_pretty_name,
-                                    os_image_id,
-                                    os_name,
-                                    os_id,
-                                    os_image_version,
-                                    os_version,
-                                    os_version_id,
-                                    os_build_id,
-                                    &good_name,
-                                    &good_version,
-                                    &good_sort_key))
-                        continue;
-
-                _cleanup_free_ char16_t *profile_id = NULL, *profile_title = NULL;
-
+                _cleanup_free_ char *profile_data = NULL;
                 if (PE_SECTION_VECTOR_IS_SET(sections + SECTION_PROFILE)) {
-                        content = mfree(content);
-
                         /* Read any .profile data from the file, if we have it */
-
                         err = file_handle_read(
                                         handle,
                                         sections[SECTION_PROFILE].file_offset,
                                         sections[SECTION_PROFILE].file_size,
-                                        &content,
+                                        &profile_data,
                                         /* ret_size= */ NULL);
                         if (err != EFI_SUCCESS)
                                 continue;
-
-                        /* read properties from the embedded os-release file */
-                        pos = 0;
-                        while ((line = line_get_key_value(content, "=", &pos, &key, &value)))
-                                if (streq8(key, "ID")) {
-                                        free(profile_id);
-                                        profile_id = xstr8_to_16(value);
-                                } else if (streq8(key, "TITLE")) {
-                                        free(profile_title);
-                                        profile_title = xstr8_to_16(value);
-                                }
                 }
 
-                _cleanup_free_ char16_t *id = NULL;
-                if (profile > 0) {
-                        if (profile_id)
-                                id = xasprintf("%ls@%ls", filename, profile_id);
-                        else
-                                id = xasprintf("%ls@%u", filename, profile);
-                } else
-                        id = xstrdup16(filename);
-
-                _cleanup_free_ char16_t *title = NULL;
-                if (profile_title)
-                        title = xasprintf("%ls (%ls)", good_name, profile_title);
-                else if (profile > 0) {
-                        if (profile_id)
-                                title = xasprintf("%ls (%ls)", good_name, profile_id);
-                        else
-                                title = xasprintf("%ls (Profile #%u)", good_name, profile + 1);
-                } else
-                        title = xstrdup16(good_name);
-
-                BootEntry *entry = xnew(BootEntry, 1);
-                *entry = (BootEntry) {
-                        .id = strtolower16(TAKE_PTR(id)),
-                        .id_without_profile = profile > 0 ? strtolower16(xstrdup16(filename)) : NULL,
-                        .type = LOADER_TYPE2_UKI,
-                        .title = TAKE_PTR(title),
-                        .version = xstrdup16(good_version),
-                        .device = device,
-                        .loader = xasprintf("%ls\\%ls", path, filename),
-                        .sort_key = xstrdup16(good_sort_key),
-                        .key = 'l',
-                        .tries_done = -1,
-                        .tries_left = -1,
-                        .profile = profile,
-                        .call = call_image_start,
-                };
-
-                config_add_entry(config, entry);
-                boot_entry_parse_tries(entry, path, filename, u".efi");
+                BootEntry *entry = boot_entry_add_type2_profile(config, device, path, filename, profile, osrel, profile_data);
+                if (!entry)
+                        continue;
 
                 if (!PE_SECTION_VECTOR_IS_SET(sections + SECTION_CMDLINE))
                         return;
 
-                content = mfree(content);
-
                 /* Read the embedded cmdline file for display purposes */
+                _cleanup_free_ char *cmdline = NULL;
                 size_t cmdline_len;
                 err = file_handle_read(
                                 handle,
                                 sections[SECTION_CMDLINE].file_offset,
                                 sections[SECTION_CMDLINE].file_size,
-                                &content,
+                                &cmdline,
                                 &cmdline_len);
                 if (err == EFI_SUCCESS) {
-                        entry->options = mangle_stub_cmdline(xstrn8_to_16(content, cmdline_len));
+                        entry->options = mangle_stub_cmdline(xstrn8_to_16(cmdline, cmdline_len));
                         entry->options_implied = true;
                 }
         }
 }
 
+typedef struct UkiIndexProfile {
+        unsigned profile;
+        char *osrel;
+        char *profile_data;
+        char *cmdline;
+} UkiIndexProfile;
+
+typedef struct UkiIndexEntry {
+        char16_t *filename;
+        uint64_t size;
+        uint64_t mtime;
+        UkiIndexProfile *profiles;
+        size_t n_profiles;
+} UkiIndexEntry;
+
+typedef struct UkiIndex {
+        UkiIndexEntry *entries;
+        size_t n_entries;
+} UkiIndex;
+
+static void uki_index_done(UkiIndex *index) {
+        assert(index);
+
+        for (size_t i = 0; i < index->n_entries; i++) {
+                UkiIndexEntry *e = index->entries + i;
+
+                for (size_t j = 0; j < e->n_profiles; j++) {
+                        free(e->profiles[j].osrel);
+                        free(e->profiles[j].profile_data);
+                        free(e->profiles[j].cmdline);
+                }
+
+                free(e->profiles);
+                free(e->filename);
+        }
+
+        free(index->entries);
+        *index = (UkiIndex) {};
+}
+
+static void strextend_line8(char **s, const char *line) {
+        size_t a, b;
+
+        assert(s);
+        assert(line);
+
+        a = *s ? strlen8(*s) : 0;
+        b = strlen8(line);
+
+        *s = xrealloc(*s, a > 0 ? a + 1 : 0, a + b + 2);
+        memcpy(*s + a, line, b);
+        (*s)[a + b] = '\n';
+        (*s)[a + b + 1] = '\0';
+}
+
+static uint64_t efi_time_to_index_mtime(const EFI_TIME *t) {
+        assert(t);
+
+        /* FAT only stores modification times with a granularity of 2s, hence round down, so that the value
+         * matches what userspace wrote into the index, regardless of how the firmware reports the odd
+         * seconds. */
+        return ((((t->Year * UINT64_C(100) + t->Month) * 100 + t->Day) * 100 + t->Hour) * 100 + t->Minute) * 100 +
+                (t->Second & ~1U);
+}
+
+static void uki_index_load(EFI_FILE *root_dir, UkiIndex *ret) {
+        _cleanup_free_ char *content = NULL;
+        UkiIndex index = {};
+        char *line, *key, *value;
+        size_t pos = 0;
+        EFI_STATUS err;
+
+        assert(root_dir);
+        assert(ret);
+
+        /* Loads the index of Type #2 entries, as written by "bootctl update-index". It carries the
+         * metadata we'd otherwise have to extract from the PE sections of each UKI, which on slow firmware
+         * file system drivers is expensive if there are many of them. The index is a list of records like
+         * this, where all values are quoted:
+         *
+         *     uki "foo.efi"
+         *     size "<file size>"
+         *     mtime "<modification time as YYYYMMDDhhmmss, UTC>"
+         *     profile "<profile number>"
+         *     osrel "<line of .osrel section>"
+         *     pdata "<line of .profile section>"
+         *     cmdline "<contents of .cmdline section>"
+         *
+         * Only fields this loader knows about are parsed, anything else is ignored. */
+
+        *ret = (UkiIndex) {};
+
+        err = file_read(root_dir, u"\\loader\\uki-index", /* offset= */ 0, /* size= */ 0, &content, /* ret_size= */ NULL);
+        if (err != EFI_SUCCESS)
+                return;
+
+        while ((line = line_get_key_value(content, " \t", &pos, &key, &value))) {
+                UkiIndexEntry *e = index.n_entries > 0 ? index.entries + index.n_entries - 1 : NULL;
+                UkiIndexProfile *p = e && e->n_profiles > 0 ? e->profiles + e->n_profiles - 1 : NULL;
+                uint64_t u;
+
+                if (streq8(key, "uki")) {
+                        index.entries = xrealloc(
+                                        index.entries,
+                                        index.n_entries * sizeof(UkiIndexEntry),
+                                        (index.n_entries + 1) * sizeof(UkiIndexEntry));
+                        index.entries[index.n_entries++] = (UkiIndexEntry) {
+                                .filename = xstr8_to_16(value),
+                                .size = UINT64_MAX,
+                                .mtime = UINT64_MAX,
+                        };
+
+                } else if (streq8(key, "size") && e) {
+                        if (parse_number8(value, &u, NULL))
+                                e->size = u;
+
+                } else if (streq8(key, "mtime") && e) {
+                        if (parse_number8(value, &u, NULL))
+                                e->mtime = u;
+
+                } else if (streq8(key, "profile") && e) {
+                        if (!parse_number8(value, &u, NULL) || u >= UNIFIED_PROFILES_MAX)
+                                continue;
+
+                        e->profiles = xrealloc(
+                                        e->profiles,
+                                        e->n_profiles * sizeof(UkiIndexProfile),
+                                        (e->n_profiles + 1) * sizeof(UkiIndexProfile));
+                        e->profiles[e->n_profiles++] = (UkiIndexProfile) {
+                                .profile = u,
+                        };
+
+                } else if (streq8(key, "osrel") && p)
+                        strextend_line8(&p->osrel, value);
+
+                else if (streq8(key, "pdata") && p)
+                        strextend_line8(&p->profile_data, value);
+
+                else if (streq8(key, "cmdline") && p) {
+                        free(p->cmdline);
+                        p->cmdline = xstrdup8(value);
+                }
+        }
+
+        *ret = index;
+}
+
+static bool boot_entry_add_type2_from_index(
+                Config *config,
+                EFI_HANDLE *device,
+                const UkiIndex *index,
+                const uint16_t *path,
+                const EFI_FILE_INFO *f) {
+
+        assert(config);
+        assert(device);
+        assert(index);
+        assert(path);
+        assert(f);
+
+        /* Returns true if the index has an up-to-date record for this file, and the menu entries have been
+         * created from it. Otherwise the caller has to look into the file itself. */
+
+        for (size_t i = 0; i < index->n_entries; i++) {
+                const UkiIndexEntry *e = index->entries + i;
+
+                if (!strcaseeq16(e->filename, f->FileName))
+                        continue;
+
+                if (e->size != f->FileSize || e->mtime != efi_time_to_index_mtime(&f->ModificationTime))
+                        return false;
+
+                for (size_t j = 0; j < e->n_profiles; j++) {
+                        const UkiIndexProfile *p = e->profiles + j;
+
+                        if (!p->osrel)
+                                continue;
+
+                        /* Parsing modifies the buffers, hence operate on copies */
+                        _cleanup_free_ char *osrel = xstrdup8(p->osrel),
+                                *profile_data = p->profile_data ? xstrdup8(p->profile_data) : NULL;
+
+                        BootEntry *entry = boot_entry_add_type2_profile(
+                                        config, device, path, f->FileName, p->profile, osrel, profile_data);
+                        if (!entry)
+                                continue;
+
+                        /* Same as boot_entry_add_type2(): stop at the first profile without a command line */
+                        if (!p->cmdline)
+                                break;
+
+                        entry->options = mangle_stub_cmdline(xstr8_to_16(p->cmdline));
+                        entry->options_implied = true;
+                }
+
+                return true;
+        }
+
+        return false;
+}
+
 static void config_load_type2_entries(
                 Config *config,
                 EFI_HANDLE *device,
@@ -2259,6 +2484,7 @@ static void config_load_type2_entries(
 
         _cleanup_file_close_ EFI_FILE *linux_dir = NULL;
         _cleanup_free_ EFI_FILE_INFO *f = NULL;
+        _cleanup_(uki_index_done) UkiIndex index = {};
         size_t f_size = 0;
         EFI_STATUS err;
 
@@ -2274,6 +2500,8 @@ static void config_load_type2_entries(
         if (err != EFI_SUCCESS)
                 return;
 
+        uki_index_load(root_dir, &index);
+
         for (;;) {
                 err = readdir(linux_dir, &f, &f_size);
                 if (err != EFI_SUCCESS || !f)
@@ -2288,6 +2516,9 @@ static void config_load_type2_entries(
                 if (startswith_no_case(f->FileName, u"auto-"))
                         continue;
 
+                if (boot_entry_add_type2_from_index(config, device, &index, dropin_path, f))
+                        continue;
+
                 boot_entry_add_type2(config, device, linux_dir, dropin_path, f->FileName);
         }
 }
@@ -301,36 +301,64 @@ static EFI_STATUS pack_cpio_trailer(
         return EFI_SUCCESS;
 }
 
-EFI_STATUS pack_cpio(
+typedef struct CpioItem {
+        char16_t *name;
+        uint64_t size;
+} CpioItem;
+
+struct CpioDirectory {
+        EFI_FILE *root;
+        EFI_FILE *dir;
+
+        CpioItem **items;
+        size_t n_items;
+};
+
+static int cpio_item_compare(const CpioItem *a, const CpioItem *b) {
+        return strcmp16(a->name, b->name);
+}
+
+CpioDirectory* cpio_directory_free(CpioDirectory *d) {
+        if (!d)
+                return NULL;
+
+        for (size_t i = 0; i < d->n_items; i++) {
+                free(d->items[i]->name);
+                free(d->items[i]);
+        }
+        free(d->items);
+
+        file_closep(&d->dir);
+        file_closep(&d->root);
+
+        return mfree(d);
+}
+
+EFI_STATUS cpio_directory_open(
                 EFI_LOADED_IMAGE_PROTOCOL *loaded_image,
                 const char16_t *dropin_dir,
-                const char16_t *match_suffix,
-                const char16_t *exclude_suffix,
-                const char *target_dir_prefix,
-                uint32_t dir_mode,
-                uint32_t access_mode,
-                uint32_t tpm_pcr,
-                const char16_t *tpm_description,
-                struct iovec *ret_buffer,
-                bool *ret_measured) {
+                CpioDirectory **ret) {
 
-        _cleanup_file_close_ EFI_FILE *root = NULL, *extra_dir = NULL;
-        size_t dirent_size = 0, buffer_size = 0, n_items = 0, n_allocated = 0;
+        _cleanup_(cpio_directory_freep) CpioDirectory *d = NULL;
         _cleanup_free_ char16_t *rel_dropin_dir = NULL;
         _cleanup_free_ EFI_FILE_INFO *dirent = NULL;
-        _cleanup_strv_free_ char16_t **items = NULL;
-        _cleanup_free_ void *buffer = NULL;
-        uint32_t inode = 1; /* inode counter, so that each item gets a new inode */
+        size_t dirent_size = 0, n_allocated = 0;
         EFI_STATUS err;
 
         assert(loaded_image);
-        assert(target_dir_prefix);
-        assert(ret_buffer);
+        assert(ret);
+
+        /* Enumerates the specified drop-in directory (or the loaded image's .extra.d/ directory if NULL) once,
+         * so that several cpio archives can be generated from its contents without going through the
+         * firmware's (possibly slow) file system protocol again for each of them. Returns NULL if there's
+         * no such directory, or nothing in it. */
 
         if (!loaded_image->DeviceHandle)
                 goto nothing;
 
-        err = open_volume(loaded_image->DeviceHandle, &root);
+        d = xnew0(CpioDirectory, 1);
+
+        err = open_volume(loaded_image->DeviceHandle, &d->root);
         if (err == EFI_UNSUPPORTED)
                 /* Error will be unsupported if the bootloader doesn't implement the file system protocol on
                  * its file handles. */
@@ -344,7 +372,7 @@ EFI_STATUS pack_cpio(
                         goto nothing;
         }
 
-        err = open_directory(root, dropin_dir, &extra_dir);
+        err = open_directory(d->root, dropin_dir, &d->dir);
         if (err == EFI_NOT_FOUND)
                 /* No extra subdir, that's totally OK */
                 goto nothing;
@@ -352,9 +380,7 @@ EFI_STATUS pack_cpio(
                 return log_error_status(err, "Failed to open extra directory of loaded image: %m");
 
         for (;;) {
-                _cleanup_free_ char16_t *d = NULL;
-
-                err = readdir(extra_dir, &dirent, &dirent_size);
+                err = readdir(d->dir, &dirent, &dirent_size);
                 if (err != EFI_SUCCESS)
                         return log_error_status(err, "Failed to read extra directory of loaded image: %m");
                 if (!dirent) /* End of directory */
@@ -364,66 +390,114 @@ EFI_STATUS pack_cpio(
                         continue;
                 if (FLAGS_SET(dirent->Attribute, EFI_FILE_DIRECTORY))
                         continue;
-                if (match_suffix && !endswith_no_case(dirent->FileName, match_suffix))
-                        continue;
-                if (exclude_suffix && endswith_no_case(dirent->FileName, exclude_suffix))
-                        continue;
                 if (!is_ascii(dirent->FileName))
                         continue;
                 if (strlen16(dirent->FileName) > 255) /* Max filename size on Linux */
                         continue;
 
-                d = xstrdup16(dirent->FileName);
-
-                if (n_items+2 > n_allocated) {
+                if (d->n_items+1 > n_allocated) {
                         /* We allocate 16 entries at a time, as a matter of optimization */
-                        if (n_items > (SIZE_MAX / sizeof(uint16_t)) - 16) /* Overflow check, just in case */
+                        if (d->n_items > (SIZE_MAX / sizeof(CpioItem *)) - 16) /* Overflow check, just in case */
                                 return log_oom();
 
-                        size_t m = n_items + 16;
-                        items = xrealloc(items, n_allocated * sizeof(uint16_t *), m * sizeof(uint16_t *));
+                        size_t m = d->n_items + 16;
+                        d->items = xrealloc(d->items, n_allocated * sizeof(CpioItem *), m * sizeof(CpioItem *));
                         n_allocated = m;
                 }
 
-                items[n_items++] = TAKE_PTR(d);
-                items[n_items] = NULL; /* Let's always NUL terminate, to make freeing via strv_free() easy */
+                /* Remember the size too, so that we don't have to query it again when reading the file */
+                d->items[d->n_items] = xnew(CpioItem, 1);
+                *d->items[d->n_items++] = (CpioItem) {
+                        .name = xstrdup16(dirent->FileName),
+                        .size = dirent->FileSize,
+                };
         }
 
-        if (n_items == 0)
+        if (d->n_items == 0)
                 /* Empty directory */
                 goto nothing;
 
         /* Now, sort the files we found, to make this uniform and stable (and to ensure the TPM measurements
          * are not dependent on read order) */
-        sort_pointer_array((void**) items, n_items, (compare_pointer_func_t) strcmp16);
+        sort_pointer_array((void**) d->items, d->n_items, (compare_pointer_func_t) cpio_item_compare);
 
-        /* Generate the leading directory inodes right before adding the first files, to the
-         * archive. Otherwise the cpio archive cannot be unpacked, since the leading dirs won't exist. */
-        err = pack_cpio_prefix(target_dir_prefix, dir_mode, &inode, &buffer, &buffer_size);
-        if (err != EFI_SUCCESS)
-                return log_error_status(err, "Failed to pack cpio prefix: %m");
+        *ret = TAKE_PTR(d);
+        return EFI_SUCCESS;
 
-        for (size_t i = 0; i < n_items; i++) {
+nothing:
+        *ret = NULL;
+        return EFI_SUCCESS;
+}
+
+EFI_STATUS pack_cpio_from_directory(
+                CpioDirectory *d,
+                const char16_t *match_suffix,
+                const char16_t *exclude_suffix,
+                const char *target_dir_prefix,
+                uint32_t dir_mode,
+                uint32_t access_mode,
+                uint32_t tpm_pcr,
+                const char16_t *tpm_description,
+                struct iovec *ret_buffer,
+                bool *ret_measured) {
+
+        _cleanup_free_ void *buffer = NULL;
+        uint32_t inode = 1; /* inode counter, so that each item gets a new inode */
+        size_t buffer_size = 0;
+        EFI_STATUS err;
+
+        assert(target_dir_prefix);
+        assert(ret_buffer);
+
+        if (!d)
+                goto nothing;
+
+        for (size_t i = 0; i < d->n_items; i++) {
+                const CpioItem *item = d->items[i];
                 _cleanup_free_ char *content = NULL;
                 size_t contentsize = 0;  /* avoid false maybe-uninitialized warning */
 
-                err = file_read(extra_dir, items[i], 0, 0, &content, &contentsize);
+                if (match_suffix && !endswith_no_case(item->name, match_suffix))
+                        continue;
+                if (exclude_suffix && endswith_no_case(item->name, exclude_suffix))
+                        continue;
+
+                if (buffer_size == 0) {
+                        /* Generate the leading directory inodes right before adding the first files, to the
+                         * archive. Otherwise the cpio archive cannot be unpacked, since the leading dirs won't
+                         * exist. */
+                        err = pack_cpio_prefix(target_dir_prefix, dir_mode, &inode, &buffer, &buffer_size);
+                        if (err != EFI_SUCCESS)
+                                return log_error_status(err, "Failed to pack cpio prefix: %m");
+                }
+
+                if (item->size > SIZE_MAX) {
+                        log_error_status(EFI_BAD_BUFFER_SIZE, "File %ls too large, ignoring.", item->name);
+                        continue;
+                }
+
+                /* A zero size means "read the whole file" to file_read(), which is fine for empty files, too */
+                err = file_read(d->dir, item->name, 0, item->size, &content, &contentsize);
                 if (err != EFI_SUCCESS) {
-                        log_error_status(err, "Failed to read %ls, ignoring: %m", items[i]);
+                        log_error_status(err, "Failed to read %ls, ignoring: %m", item->name);
                         continue;
                 }
 
                 err = pack_cpio_one(
-                                items[i],
+                                item->name,
                                 content, contentsize,
                                 target_dir_prefix,
                                 access_mode,
                                 &inode,
                                 &buffer, &buffer_size);
                 if (err != EFI_SUCCESS)
-                        return log_error_status(err, "Failed to pack cpio file %ls: %m", dirent->FileName);
+                        return log_error_status(err, "Failed to pack cpio file %ls: %m", item->name);
         }
 
+        if (buffer_size == 0)
+                /* Nothing matched */
+                goto nothing;
+
         err = pack_cpio_trailer(&buffer, &buffer_size);
         if (err != EFI_SUCCESS)
                 return log_error_status(err, "Failed to pack cpio trailer: %m");
@@ -449,6 +523,43 @@ nothing:
         return EFI_SUCCESS;
 }
 
+EFI_STATUS pack_cpio(
+                EFI_LOADED_IMAGE_PROTOCOL *loaded_image,
+                const char16_t *dropin_dir,
+                const char16_t *match_suffix,
+                const char16_t *exclude_suffix,
+                const char *target_dir_prefix,
+                uint32_t dir_mode,
+                uint32_t access_mode,
+                uint32_t tpm_pcr,
+                const char16_t *tpm_description,
+                struct iovec *ret_buffer,
+                bool *ret_measured) {
+
+        _cleanup_(cpio_directory_freep) CpioDirectory *d = NULL;
+        EFI_STATUS err;
+
+        assert(loaded_image);
+        assert(target_dir_prefix);
+        assert(ret_buffer);
+
+        err = cpio_directory_open(loaded_image, dropin_dir, &d);
+        if (err != EFI_SUCCESS)
+                return err;
+
+        return pack_cpio_from_directory(
+                        d,
+                        match_suffix,
+                        exclude_suffix,
+                        target_dir_prefix,
+                        dir_mode,
+                        access_mode,
+                        tpm_pcr,
+                        tpm_description,
+                        ret_buffer,
+                        ret_measured);
+}
+
 EFI_STATUS pack_cpio_literal(
                 const void *data,
                 size_t data_size,
@@ -5,6 +5,27 @@
 #include "iovec-util-fundamental.h"
 #include "proto/loaded-image.h"
 
+typedef struct CpioDirectory CpioDirectory;
+
+EFI_STATUS cpio_directory_open(
+                EFI_LOADED_IMAGE_PROTOCOL *loaded_image,
+                const char16_t *dropin_dir,
+                CpioDirectory **ret);
+CpioDirectory* cpio_directory_free(CpioDirectory *d);
+DEFINE_TRIVIAL_CLEANUP_FUNC(CpioDirectory*, cpio_directory_free);
+
+EFI_STATUS pack_cpio_from_directory(
+                CpioDirectory *d,
+                const char16_t *match_suffix,
+                const char16_t *exclude_suffix,
+                const char *target_dir_prefix,
+                uint32_t dir_mode,
+                uint32_t access_mode,
+                uint32_t tpm_pcr,
+                const char16_t *tpm_description,
+                struct iovec *ret_buffer,
+                bool *ret_measured);
+
 EFI_STATUS pack_cpio(
                 EFI_LOADED_IMAGE_PROTOCOL *loaded_image,
                 const char16_t *dropin_dir,
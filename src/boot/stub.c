@@ -821,6 +821,8 @@ static void generate_sidecar_initrds(
                 int *sysext_measured,
                 int *confext_measured) {
 
+        _cleanup_(cpio_directory_freep) CpioDirectory *extra = NULL;
+        EFI_STATUS extra_err;
         bool m;
 
         assert(loaded_image);
@@ -829,17 +831,21 @@ static void generate_sidecar_initrds(
         assert(sysext_measured);
         assert(confext_measured);
 
-        if (pack_cpio(loaded_image,
-                      /* dropin_dir= */ NULL,
-                      u".cred",
-                      /* exclude_suffix= */ NULL,
-                      ".extra/credentials",
-                      /* dir_mode= */ 0500,
-                      /* access_mode= */ 0400,
-                      /* tpm_pcr= */ TPM2_PCR_KERNEL_CONFIG,
-                      u"Credentials initrd",
-                      initrds + INITRD_CREDENTIAL,
-                      &m) == EFI_SUCCESS)
+        /* Credentials, system and configuration extensions all live in the same .extra.d/ directory next to
+         * our image, hence enumerate it only once. */
+        extra_err = cpio_directory_open(loaded_image, /* dropin_dir= */ NULL, &extra);
+
+        if (extra_err == EFI_SUCCESS &&
+            pack_cpio_from_directory(extra,
+                                     u".cred",
+                                     /* exclude_suffix= */ NULL,
+                                     ".extra/credentials",
+                                     /* dir_mode= */ 0500,
+                                     /* access_mode= */ 0400,
+                                     /* tpm_pcr= */ TPM2_PCR_KERNEL_CONFIG,
+                                     u"Credentials initrd",
+                                     initrds + INITRD_CREDENTIAL,
+                                     &m) == EFI_SUCCESS)
                 combine_measured_flag(parameters_measured, m);
 
         if (pack_cpio(loaded_image,
@@ -855,30 +861,30 @@ static void generate_sidecar_initrds(
                       &m) == EFI_SUCCESS)
                 combine_measured_flag(parameters_measured, m);
 
-        if (pack_cpio(loaded_image,
-                      /* dropin_dir= */ NULL,
-                      u".raw",         /* ideally we'd pick up only *.sysext.raw here, but for compat we pick up *.raw instead … */
-                      u".confext.raw", /* … but then exclude *.confext.raw again */
-                      ".extra/sysext",
-                      /* dir_mode= */ 0555,
-                      /* access_mode= */ 0444,
-                      /* tpm_pcr= */ TPM2_PCR_SYSEXTS,
-                      u"System extension initrd",
-                      initrds + INITRD_SYSEXT,
-                      &m) == EFI_SUCCESS)
+        if (extra_err == EFI_SUCCESS &&
+            pack_cpio_from_directory(extra,
+                                     u".raw",         /* ideally we'd pick up only *.sysext.raw here, but for compat we pick up *.raw instead … */
+                                     u".confext.raw", /* … but then exclude *.confext.raw again */
+                                     ".extra/sysext",
+                                     /* dir_mode= */ 0555,
+                                     /* access_mode= */ 0444,
+                                     /* tpm_pcr= */ TPM2_PCR_SYSEXTS,
+                                     u"System extension initrd",
+                                     initrds + INITRD_SYSEXT,
+                                     &m) == EFI_SUCCESS)
                 combine_measured_flag(sysext_measured, m);
 
-        if (pack_cpio(loaded_image,
-                      /* dropin_dir= */ NULL,
-                      u".confext.raw",
-                      /* exclude_suffix= */ NULL,
-                      ".extra/confext",
-                      /* dir_mode= */ 0555,
-                      /* access_mode= */ 0444,
-                      /* tpm_pcr= */ TPM2_PCR_KERNEL_CONFIG,
-                      u"Configuration extension initrd",
-                      initrds + INITRD_CONFEXT,
-                      &m) == EFI_SUCCESS)
+        if (extra_err == EFI_SUCCESS &&
+            pack_cpio_from_directory(extra,
+                                     u".confext.raw",
+                                     /* exclude_suffix= */ NULL,
+                                     ".extra/confext",
+                                     /* dir_mode= */ 0555,
+                                     /* access_mode= */ 0444,
+                                     /* tpm_pcr= */ TPM2_PCR_KERNEL_CONFIG,
+                                     u"Configuration extension initrd",
+                                     initrds + INITRD_CONFEXT,
+                                     &m) == EFI_SUCCESS)
                 combine_measured_flag(confext_measured, m);
 }
 
@@ -1283,6 +1283,10 @@ int verb_remove(int argc, char *argv[], void *userdata) {
         if (q < 0 && r >= 0)
                 r = q;
 
+        q = remove_file(arg_esp_path, "/loader/uki-index");
+        if (q < 0 && r >= 0)
+                r = q;
+
         FOREACH_STRING(db, "PK.auth", "KEK.auth", "db.auth") {
                 _cleanup_free_ char *p = path_join("/loader/keys/auto", db);
                 if (!p)
@@ -1316,6 +1320,10 @@ int verb_remove(int argc, char *argv[], void *userdata) {
                 if (q < 0 && r >= 0)
                         r = q;
 
+                q = remove_file(arg_xbootldr_path, "/loader/uki-index");
+                if (q < 0 && r >= 0)
+                        r = q;
+
                 q = remove_subdirs(arg_xbootldr_path, dollar_boot_subdirs);
                 if (q < 0 && r >= 0)
                         r = q;
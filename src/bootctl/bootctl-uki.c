@@ -1,10 +1,23 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include <fcntl.h>
+#include <sys/stat.h>
 
 #include "alloc-util.h"
+#include "bootctl.h"
 #include "bootctl-uki.h"
+#include "bootspec.h"
+#include "chase.h"
+#include "dirent-util.h"
+#include "fd-util.h"
+#include "fileio.h"
+#include "fs-util.h"
 #include "kernel-image.h"
+#include "memstream-util.h"
+#include "mkdir.h"
+#include "path-util.h"
+#include "tmpfile-util.h"
+#include "uki.h"
 
 int verb_kernel_identify(int argc, char *argv[], void *userdata) {
         KernelImageType t;
@@ -37,3 +50,180 @@ int verb_kernel_inspect(int argc, char *argv[], void *userdata) {
 
         return 0;
 }
+
+static void uki_index_write_quoted(FILE *f, const char *key, const char *text) {
+        assert(f);
+        assert(key);
+
+        /* The loader strips exactly one pair of enclosing quotes, hence no escaping is needed */
+        fprintf(f, "%s \"%s\"\n", key, strempty(text));
+}
+
+static void uki_index_write_lines(FILE *f, const char *key, const char *text) {
+        assert(f);
+        assert(key);
+
+        for (const char *p = text; p && *p;) {
+                size_t n = strcspn(p, "\n\r");
+
+                if (n > 0)
+                        fprintf(f, "%s \"%.*s\"\n", key, (int) n, p);
+
+                p += n;
+                p += strspn(p, "\n\r");
+        }
+}
+
+static int uki_index_write_one(FILE *f, int dir_fd, const char *dir, const char *fname) {
+        _cleanup_free_ char *path = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        struct stat st;
+        struct tm tm;
+        int r;
+
+        assert(f);
+        assert(dir_fd >= 0);
+        assert(dir);
+        assert(fname);
+
+        path = path_join(dir, fname);
+        if (!path)
+                return log_oom();
+
+        fd = openat(dir_fd, fname, O_RDONLY|O_CLOEXEC|O_NONBLOCK|O_NOFOLLOW|O_NOCTTY);
+        if (fd < 0)
+                return log_warning_errno(errno, "Failed to open %s, skipping: %m", path);
+
+        if (fstat(fd, &st) < 0)
+                return log_warning_errno(errno, "Failed to stat %s, skipping: %m", path);
+
+        /* The loader validates records by file size and modification time as reported by the firmware's
+         * FAT driver, which only has a granularity of 2s. If the timestamps don't match (for example because
+         * the file system is mounted with a time zone other than UTC) the loader simply ignores the record
+         * and looks into the UKI itself. */
+        if (!gmtime_r(&st.st_mtim.tv_sec, &tm))
+                return log_warning_errno(SYNTHETIC_ERRNO(EINVAL), "Modification time of %s out of range, skipping.", path);
+
+        _cleanup_(memstream_done) MemStream m = {};
+        FILE *g = memstream_init(&m);
+        if (!g)
+                return log_oom();
+
+        fprintf(g, "\nuki \"%s\"\n"
+                   "size \"%" PRIu64 "\"\n"
+                   "mtime \"%04i%02i%02i%02i%02i%02i\"\n",
+                fname,
+                (uint64_t) st.st_size,
+                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec & ~1);
+
+        for (unsigned p = 0; p < UNIFIED_PROFILES_MAX; p++) {
+                _cleanup_free_ char *osrelease = NULL, *profile = NULL, *cmdline = NULL;
+
+                r = pe_find_uki_sections(fd, path, p, &osrelease, &profile, &cmdline);
+                if (r < 0) /* Not a (valid) UKI? Leave it to the loader to decide what to do with it. */
+                        return 0;
+                if (r == 0) {
+                        if (p == 0) /* Not for us (e.g. non-native), don't generate a record */
+                                return 0;
+                        break;
+                }
+
+                fprintf(g, "profile \"%u\"\n", p);
+                uki_index_write_lines(g, "osrel", osrelease);
+                uki_index_write_lines(g, "pdata", profile);
+                if (cmdline) {
+                        /* The loader turns control characters into spaces anyway, hence fold it into one line */
+                        string_replace_char(cmdline, '\n', ' ');
+                        string_replace_char(cmdline, '\r', ' ');
+                        uki_index_write_quoted(g, "cmdline", cmdline);
+                }
+        }
+
+        _cleanup_free_ char *buf = NULL;
+        r = memstream_finalize(&m, &buf, /* ret_size= */ NULL);
+        if (r < 0)
+                return log_error_errno(r, "Failed to finalize index record: %m");
+
+        fputs(buf, f);
+        return 1;
+}
+
+static int uki_index_update(const char *root) {
+        _cleanup_(unlink_and_freep) char *t = NULL;
+        _cleanup_free_ char *full = NULL, *p = NULL;
+        _cleanup_closedir_ DIR *d = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        size_t n = 0;
+        int r;
+
+        assert(root);
+
+        p = path_join(root, "/loader/uki-index");
+        if (!p)
+                return log_oom();
+
+        r = chase_and_opendir("/EFI/Linux", root, CHASE_PREFIX_ROOT|CHASE_PROHIBIT_SYMLINKS, &full, &d);
+        if (r == -ENOENT) {
+                if (unlink(p) < 0 && errno != ENOENT)
+                        return log_error_errno(errno, "Failed to remove \"%s\": %m", p);
+                return 0;
+        }
+        if (r < 0)
+                return log_error_errno(r, "Failed to open '%s/EFI/Linux': %m", root);
+
+        r = mkdir_parents(p, 0755);
+        if (r < 0)
+                return log_error_errno(r, "Failed to create parent directories of \"%s\": %m", p);
+
+        r = fopen_tmpfile_linkable(p, O_WRONLY|O_CLOEXEC, &t, &f);
+        if (r < 0)
+                return log_error_errno(r, "Failed to open \"%s\" for writing: %m", p);
+
+        fputs("# Generated by \"bootctl update-index\", do not edit.\n", f);
+
+        FOREACH_DIRENT(de, d, return log_error_errno(errno, "Failed to read %s: %m", full)) {
+                if (!dirent_is_file(de))
+                        continue;
+
+                /* Same filtering as in the loader */
+                if (!endswith_no_case(de->d_name, ".efi") || startswith_no_case(de->d_name, "auto-"))
+                        continue;
+
+                r = uki_index_write_one(f, dirfd(d), full, de->d_name);
+                if (r < 0 && r != -ENOMEM)
+                        continue;
+                if (r < 0)
+                        return r;
+
+                n += r;
+        }
+
+        r = flink_tmpfile(f, t, p, LINK_TMPFILE_REPLACE|LINK_TMPFILE_SYNC);
+        if (r < 0)
+                return log_error_errno(r, "Failed to move \"%s\" into place: %m", p);
+
+        t = mfree(t);
+
+        log_info("Updated \"%s\" with %zu unified kernel images.", p, n);
+        return 0;
+}
+
+int verb_update_index(int argc, char *argv[], void *userdata) {
+        dev_t esp_devid = 0, xbootldr_devid = 0;
+        int r;
+
+        r = acquire_esp(/* unprivileged_mode= */ false, /* graceful= */ false, NULL, NULL, NULL, NULL, &esp_devid);
+        if (r < 0)
+                return r;
+
+        r = acquire_xbootldr(/* unprivileged_mode= */ false, NULL, &xbootldr_devid);
+        if (r < 0)
+                return r;
+
+        r = uki_index_update(arg_esp_path);
+
+        if (arg_xbootldr_path && xbootldr_devid != esp_devid)
+                RET_GATHER(r, uki_index_update(arg_xbootldr_path));
+
+        return r;
+}
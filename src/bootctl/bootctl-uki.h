@@ -2,3 +2,4 @@
 
 int verb_kernel_identify(int argc, char *argv[], void *userdata);
 int verb_kernel_inspect(int argc, char *argv[], void *userdata);
+int verb_update_index(int argc, char *argv[], void *userdata);
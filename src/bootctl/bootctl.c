@@ -246,6 +246,7 @@ static int help(int argc, char *argv[], void *userdata) {
                "  is-installed         Test whether systemd-boot is installed in the ESP\n"
                "  random-seed          Initialize or refresh random seed in ESP and EFI\n"
                "                       variables\n"
+               "  update-index         Update index of unified kernel images for the boot menu\n"
                "\n%3$sKernel Image Commands:%4$s\n"
                "  kernel-identify      Identify kernel image type\n"
                "  kernel-inspect       Prints details about the kernel image\n"
@@ -629,6 +630,7 @@ static int bootctl_main(int argc, char *argv[]) {
                 { "set-timeout",         2,        2,        0,            verb_set_efivar          },
                 { "set-timeout-oneshot", 2,        2,        0,            verb_set_efivar          },
                 { "random-seed",         VERB_ANY, 1,        0,            verb_random_seed         },
+                { "update-index",        VERB_ANY, 1,        0,            verb_update_index        },
                 { "reboot-to-firmware",  VERB_ANY, 2,        0,            verb_reboot_to_firmware  },
                 {}
         };
@@ -20,6 +20,7 @@
 #include "fdset.h"
 #include "fileio.h"
 #include "format-table.h"
+#include "format-util.h"
 #include "glyph-util.h"
 #include "json-util.h"
 #include "log.h"
@@ -67,6 +68,13 @@ static usec_t arg_timeout = 0;
 static const char *arg_destination = NULL;
 static uint64_t arg_limit_messages = UINT64_MAX;
 
+/* Capture output is written in large chunks rather than once per message, so that we keep up with busy buses */
+#define CAPTURE_BUFFER_SIZE (1U*1024U*1024U)
+
+static uint64_t capture_n_messages = 0;
+static uint64_t capture_n_truncated = 0;
+static uint64_t capture_n_bytes = 0;
+
 STATIC_DESTRUCTOR_REGISTER(arg_matches, strv_freep);
 
 #define NAME_IS_ACQUIRED INT_TO_PTR(1)
@@ -1210,6 +1218,13 @@ static int message_dump(sd_bus_message *m, FILE *f) {
 }
 
 static int message_pcap(sd_bus_message *m, FILE *f) {
+        size_t size = BUS_MESSAGE_SIZE(m);
+
+        capture_n_messages++;
+        capture_n_bytes += MIN(size, arg_snaplen);
+        if (size > arg_snaplen)
+                capture_n_truncated++;
+
         return bus_message_pcap_frame(m, arg_snaplen, f);
 }
 
@@ -1364,8 +1379,9 @@ static int monitor(int argc, char **argv, int (*dump)(sd_bus_message *m, FILE *f
                                 continue;
                         }
 
+                        /* Only flush once we ran out of messages to process (see below), so that
+                         * the output is written in batches while messages are coming in quickly. */
                         dump(m, stdout);
-                        fflush(stdout);
 
                         if (arg_limit_messages != UINT64_MAX) {
                                 arg_limit_messages--;
@@ -1389,6 +1405,8 @@ static int monitor(int argc, char **argv, int (*dump)(sd_bus_message *m, FILE *f
                 if (r > 0)
                         continue;
 
+                fflush(stdout);
+
                 r = sd_bus_wait(bus, arg_timeout > 0 ? usec_sub_unsigned(end, now(CLOCK_MONOTONIC)) : UINT64_MAX);
                 if (r == 0 && arg_timeout > 0 && now(CLOCK_MONOTONIC) >= end) {
                         if (!arg_quiet && !sd_json_format_enabled(arg_json_format_flags))
@@ -1414,6 +1432,9 @@ static int verb_capture(int argc, char **argv, void *userdata) {
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
                                        "Refusing to write message data to console, please redirect output to a file.");
 
+        if (setvbuf(stdout, NULL, _IOFBF, CAPTURE_BUFFER_SIZE) != 0)
+                log_debug("Failed to enlarge output buffer, ignoring.");
+
         r = parse_os_release(NULL, "PRETTY_NAME", &osname);
         if (r < 0)
                 log_full_errno(r == -ENOENT ? LOG_DEBUG : LOG_INFO, r,
@@ -1428,6 +1449,10 @@ static int verb_capture(int argc, char **argv, void *userdata) {
         if (r < 0)
                 return log_error_errno(r, "Couldn't write capture file: %m");
 
+        if (!arg_quiet)
+                log_info("Captured %" PRIu64 " messages (%s), %" PRIu64 " of them truncated to %zu bytes.",
+                         capture_n_messages, FORMAT_BYTES(capture_n_bytes), capture_n_truncated, arg_snaplen);
+
         return r;
 }
 
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <getopt.h>
 #include <signal.h>
 #include <stdint.h>
@@ -8,6 +9,7 @@
 #include <unistd.h>
 
 #include "sd-bus.h"
+#include "sd-json.h"
 
 #include "alloc-util.h"
 #include "build.h"
@@ -18,6 +20,7 @@
 #include "fd-util.h"
 #include "fileio.h"
 #include "hashmap.h"
+#include "json-util.h"
 #include "main-func.h"
 #include "missing_sched.h"
 #include "parse-argument.h"
@@ -26,6 +29,7 @@
 #include "pretty-print.h"
 #include "process-util.h"
 #include "procfs-util.h"
+#include "rlimit-util.h"
 #include "sort-util.h"
 #include "stdio-util.h"
 #include "strv.h"
@@ -33,9 +37,20 @@
 #include "unit-name.h"
 #include "virt.h"
 
+typedef enum GroupFile {
+        GROUP_FILE_TASKS,
+        GROUP_FILE_MEMORY,
+        GROUP_FILE_IO,
+        GROUP_FILE_CPU,
+        _GROUP_FILE_MAX,
+} GroupFile;
+
 typedef struct Group {
         char *path;
 
+        /* Attribute files kept open across refreshes, see group_read_attribute() */
+        int fds[_GROUP_FILE_MAX];
+
         bool n_tasks_valid;
         bool cpu_valid;
         bool memory_valid;
@@ -72,6 +87,7 @@ static char* arg_machine = NULL;
 static char* arg_root = NULL;
 static bool arg_recursive = true;
 static bool arg_recursive_unset = false;
+static sd_json_format_flags_t arg_json_format_flags = SD_JSON_FORMAT_OFF;
 
 static PidsCount arg_count = COUNT_PIDS;
 
@@ -92,6 +108,7 @@ static Group *group_free(Group *g) {
         if (!g)
                 return NULL;
 
+        close_many(g->fds, _GROUP_FILE_MAX);
         free(g->path);
         return mfree(g);
 }
@@ -148,6 +165,61 @@ static bool is_root_cgroup(const char *path) {
         return empty_or_root(path);
 }
 
+static int group_read_attribute(Group *g, GroupFile file, const char *controller, const char *attribute, char **ret) {
+        int r;
+
+        assert(g);
+        assert(file >= 0 && file < _GROUP_FILE_MAX);
+        assert(controller);
+        assert(attribute);
+        assert(ret);
+
+        /* Rather than looking up, opening and closing the attribute files of every cgroup on every refresh,
+         * keep them open and reread them from the start. */
+
+        for (bool retry = true;; retry = false) {
+                if (g->fds[file] < 0) {
+                        _cleanup_free_ char *p = NULL;
+
+                        r = cg_get_path(controller, g->path, attribute, &p);
+                        if (r < 0)
+                                return r;
+
+                        g->fds[file] = open(p, O_RDONLY|O_CLOEXEC|O_NOCTTY);
+                        if (g->fds[file] < 0) {
+                                /* Too many cgroups to keep all files open? Then read this one the old way. */
+                                if (IN_SET(errno, EMFILE, ENFILE))
+                                        return read_full_virtual_file(p, ret, NULL);
+
+                                return -errno;
+                        }
+                }
+
+                r = pread_virtual_file(g->fds[file], ret, NULL);
+                if (r >= 0 || r == -ENOMEM)
+                        return r;
+
+                /* The cgroup might have been removed (and maybe created again) since we opened the file, in
+                 * which case reading through the old fd fails. Try once more with a fresh fd. */
+                g->fds[file] = safe_close(g->fds[file]);
+                if (!retry)
+                        return r;
+        }
+}
+
+static int group_read_attribute_as_uint64(Group *g, GroupFile file, const char *controller, const char *attribute, uint64_t *ret) {
+        _cleanup_free_ char *v = NULL;
+        int r;
+
+        assert(ret);
+
+        r = group_read_attribute(g, file, controller, attribute, &v);
+        if (r < 0)
+                return r;
+
+        return safe_atou64(strstrip(v), ret);
+}
+
 static int process(
                 const char *controller,
                 const char *path,
@@ -175,6 +247,9 @@ static int process(
                         if (!g)
                                 return -ENOMEM;
 
+                        FOREACH_ELEMENT(fd, g->fds)
+                                *fd = -EBADF;
+
                         g->path = strdup(path);
                         if (!g->path) {
                                 group_free(g);
@@ -225,21 +300,11 @@ static int process(
                         if (r < 0)
                                 return r;
                 } else {
-                        _cleanup_free_ char *p = NULL, *v = NULL;
-
-                        r = cg_get_path(controller, path, "pids.current", &p);
-                        if (r < 0)
-                                return r;
-
-                        r = read_one_line_file(p, &v);
+                        r = group_read_attribute_as_uint64(g, GROUP_FILE_TASKS, controller, "pids.current", &g->n_tasks);
                         if (r == -ENOENT)
                                 return 0;
                         if (r < 0)
                                 return r;
-
-                        r = safe_atou64(v, &g->n_tasks);
-                        if (r < 0)
-                                return r;
                 }
 
                 if (g->n_tasks > 0)
@@ -252,24 +317,13 @@ static int process(
                         if (r < 0)
                                 return r;
                 } else {
-                        _cleanup_free_ char *p = NULL, *v = NULL;
-
-                        if (all_unified)
-                                r = cg_get_path(controller, path, "memory.current", &p);
-                        else
-                                r = cg_get_path(controller, path, "memory.usage_in_bytes", &p);
-                        if (r < 0)
-                                return r;
-
-                        r = read_one_line_file(p, &v);
+                        r = group_read_attribute_as_uint64(g, GROUP_FILE_MEMORY, controller,
+                                                           all_unified ? "memory.current" : "memory.usage_in_bytes",
+                                                           &g->memory);
                         if (r == -ENOENT)
                                 return 0;
                         if (r < 0)
                                 return r;
-
-                        r = safe_atou64(v, &g->memory);
-                        if (r < 0)
-                                return r;
                 }
 
                 if (g->memory > 0)
@@ -277,28 +331,24 @@ static int process(
 
         } else if ((streq(controller, "io") && all_unified) ||
                    (streq(controller, "blkio") && !all_unified)) {
-                _cleanup_fclose_ FILE *f = NULL;
-                _cleanup_free_ char *p = NULL;
+                _cleanup_free_ char *contents = NULL;
                 uint64_t wr = 0, rd = 0;
                 nsec_t timestamp;
 
-                r = cg_get_path(controller, path, all_unified ? "io.stat" : "blkio.io_service_bytes", &p);
+                r = group_read_attribute(g, GROUP_FILE_IO, controller,
+                                         all_unified ? "io.stat" : "blkio.io_service_bytes",
+                                         &contents);
+                if (r == -ENOENT)
+                        return 0;
                 if (r < 0)
                         return r;
 
-                f = fopen(p, "re");
-                if (!f) {
-                        if (errno == ENOENT)
-                                return 0;
-                        return -errno;
-                }
-
-                for (;;) {
+                for (const char *p = contents;;) {
                         _cleanup_free_ char *line = NULL;
                         uint64_t k, *q;
                         char *l;
 
-                        r = read_stripped_line(f, LONG_LINE_MAX, &line);
+                        r = extract_first_word(&p, &line, NEWLINE, 0);
                         if (r < 0)
                                 return r;
                         if (r == 0)
@@ -368,7 +418,6 @@ static int process(
                 g->io_timestamp = timestamp;
                 g->io_iteration = iteration;
         } else if (STR_IN_SET(controller, "cpu", "cpuacct") || cpu_accounting_is_cheap()) {
-                _cleanup_free_ char *p = NULL, *v = NULL;
                 uint64_t new_usage;
                 nsec_t timestamp;
 
@@ -377,18 +426,26 @@ static int process(
                         if (r < 0)
                                 return r;
                 } else if (all_unified) {
-                        _cleanup_free_ char *val = NULL;
+                        _cleanup_free_ char *contents = NULL;
+                        const char *w = NULL;
 
                         if (!streq(controller, "cpu"))
                                 return 0;
 
-                        r = cg_get_keyed_attribute("cpu", path, "cpu.stat", STRV_MAKE("usage_usec"), &val);
-                        if (IN_SET(r, -ENOENT, -ENXIO))
+                        r = group_read_attribute(g, GROUP_FILE_CPU, "cpu", "cpu.stat", &contents);
+                        if (r == -ENOENT)
                                 return 0;
                         if (r < 0)
                                 return r;
 
-                        r = safe_atou64(val, &new_usage);
+                        for (const char *p = contents; *p && !w; p += strspn(p, NEWLINE)) {
+                                w = first_word(p, "usage_usec");
+                                p += strcspn(p, NEWLINE);
+                        }
+                        if (!w)
+                                return 0;
+
+                        r = safe_atou64(strndupa_safe(w, strcspn(w, NEWLINE)), &new_usage);
                         if (r < 0)
                                 return r;
 
@@ -397,19 +454,11 @@ static int process(
                         if (!streq(controller, "cpuacct"))
                                 return 0;
 
-                        r = cg_get_path(controller, path, "cpuacct.usage", &p);
-                        if (r < 0)
-                                return r;
-
-                        r = read_one_line_file(p, &v);
+                        r = group_read_attribute_as_uint64(g, GROUP_FILE_CPU, controller, "cpuacct.usage", &new_usage);
                         if (r == -ENOENT)
                                 return 0;
                         if (r < 0)
                                 return r;
-
-                        r = safe_atou64(v, &new_usage);
-                        if (r < 0)
-                                return r;
                 }
 
                 timestamp = now_nsec(CLOCK_MONOTONIC);
@@ -602,7 +651,39 @@ static int group_compare(Group * const *a, Group * const *b) {
         return path_compare(x->path, y->path);
 }
 
-static void display(Hashmap *a) {
+static int display_json(Group **array, unsigned n) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r;
+
+        assert(array || n == 0);
+
+        FOREACH_ARRAY(i, array, n) {
+                Group *g = *i;
+
+                r = sd_json_variant_append_arraybo(
+                                &v,
+                                SD_JSON_BUILD_PAIR_STRING("path", empty_to_root(g->path)),
+                                SD_JSON_BUILD_PAIR_CONDITION(g->n_tasks_valid, arg_count == COUNT_PIDS ? "tasks" : "processes",
+                                                             SD_JSON_BUILD_UNSIGNED(g->n_tasks)),
+                                SD_JSON_BUILD_PAIR_CONDITION(g->cpu_valid, "cpuFraction", SD_JSON_BUILD_REAL(g->cpu_fraction)),
+                                JSON_BUILD_PAIR_UNSIGNED_NON_ZERO("cpuUsageUSec", g->cpu_usage / NSEC_PER_USEC),
+                                SD_JSON_BUILD_PAIR_CONDITION(g->memory_valid, "memoryBytes", SD_JSON_BUILD_UNSIGNED(g->memory)),
+                                SD_JSON_BUILD_PAIR_CONDITION(g->io_valid, "ioInputBytesPerSec", SD_JSON_BUILD_UNSIGNED(g->io_input_bps)),
+                                SD_JSON_BUILD_PAIR_CONDITION(g->io_valid, "ioOutputBytesPerSec", SD_JSON_BUILD_UNSIGNED(g->io_output_bps)));
+                if (r < 0)
+                        return log_error_errno(r, "Failed to build JSON object: %m");
+        }
+
+        if (!v) {
+                r = sd_json_variant_new_array(&v, NULL, 0);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to allocate JSON array: %m");
+        }
+
+        return sd_json_variant_dump(v, arg_json_format_flags, stdout, NULL);
+}
+
+static int display(Hashmap *a) {
         Group *g;
         Group **array;
         signed path_columns;
@@ -610,7 +691,7 @@ static void display(Hashmap *a) {
 
         assert(a);
 
-        if (!terminal_is_dumb())
+        if (!sd_json_format_enabled(arg_json_format_flags) && !terminal_is_dumb())
                 fputs(ANSI_HOME_CLEAR, stdout);
 
         array = newa(Group*, hashmap_size(a));
@@ -621,6 +702,9 @@ static void display(Hashmap *a) {
 
         typesafe_qsort(array, n, group_compare);
 
+        if (sd_json_format_enabled(arg_json_format_flags))
+                return display_json(array, n);
+
         /* Find the longest names in one run */
         for (unsigned j = 0; j < n; j++) {
                 maxtcpu = MAX(maxtcpu,
@@ -699,6 +783,8 @@ static void display(Hashmap *a) {
 
                 putchar('\n');
         }
+
+        return 0;
 }
 
 static int help(void) {
@@ -728,6 +814,8 @@ static int help(void) {
                "  -n --iterations=N   Run for N iterations before exiting\n"
                "  -1                  Shortcut for --iterations=1\n"
                "  -b --batch          Run in batch mode, accepting no input\n"
+               "     --json=pretty|short|off\n"
+               "                      Generate JSON output, implies --batch\n"
                "     --depth=DEPTH    Maximum traversal depth (default: %u)\n"
                "  -M --machine=       Show container\n"
                "\nSee the %s for details.\n",
@@ -745,6 +833,7 @@ static int parse_argv(int argc, char *argv[]) {
                 ARG_CPU_TYPE,
                 ARG_ORDER,
                 ARG_RECURSIVE,
+                ARG_JSON,
         };
 
         static const struct option options[] = {
@@ -759,6 +848,7 @@ static int parse_argv(int argc, char *argv[]) {
                 { "order",        required_argument, NULL, ARG_ORDER     },
                 { "recursive",    required_argument, NULL, ARG_RECURSIVE },
                 { "machine",      required_argument, NULL, 'M'           },
+                { "json",         required_argument, NULL, ARG_JSON      },
                 {}
         };
 
@@ -886,6 +976,13 @@ static int parse_argv(int argc, char *argv[]) {
                         arg_machine = optarg;
                         break;
 
+                case ARG_JSON:
+                        r = parse_json_argument(optarg, &arg_json_format_flags);
+                        if (r <= 0)
+                                return r;
+
+                        break;
+
                 case '?':
                         return -EINVAL;
 
@@ -893,6 +990,10 @@ static int parse_argv(int argc, char *argv[]) {
                         assert_not_reached();
                 }
 
+        /* Reading keys would only interfere with machine readable output */
+        if (sd_json_format_enabled(arg_json_format_flags))
+                arg_batch = true;
+
         if (optind == argc - 1)
                 arg_root = argv[optind];
         else if (optind < argc)
@@ -942,12 +1043,15 @@ static int loop(const char *root) {
                         immediate_refresh = false;
                 }
 
-                display(b);
+                r = display(b);
+                if (r < 0)
+                        return r;
 
                 if (arg_iterations && iteration >= arg_iterations)
                         return 0;
 
-                if (!on_tty()) /* non-TTY: Empty newline as delimiter between polls */
+                /* non-TTY: Empty newline as delimiter between polls. JSON output has one array per poll. */
+                if (!on_tty() && !sd_json_format_enabled(arg_json_format_flags))
                         fputs("\n", stdout);
                 fflush(stdout);
 
@@ -1101,6 +1205,9 @@ static int run(int argc, char *argv[]) {
 
         signal(SIGWINCH, columns_lines_cache_reset);
 
+        /* We keep a few attribute files open for every cgroup we show */
+        (void) rlimit_nofile_bump(HIGH_RLIMIT_NOFILE);
+
         if (arg_iterations == UINT_MAX)
                 arg_iterations = on_tty() ? 0 : 1;
 
@@ -8,15 +8,30 @@
 #include "devnum-util.h"
 #include "fd-util.h"
 #include "fileio.h"
+#include "hash-funcs.h"
+#include "hashmap.h"
+#include "hexdecoct.h"
+#include "memory-util.h"
 #include "missing_bpf.h"
 #include "nulstr-util.h"
 #include "parse-util.h"
 #include "path-util.h"
+#include "sha256.h"
 #include "stdio-util.h"
 #include "string-util.h"
 
 #define PASS_JUMP_OFF 4096
 
+/* Maximum number of distinct device policies we remember loaded programs for */
+#define DEVICE_PROGRAM_CACHE_MAX 1024U
+
+typedef struct DeviceProgram {
+        uint32_t id;
+        uint8_t tag[BPF_TAG_SIZE];
+} DeviceProgram;
+
+DEFINE_PRIVATE_HASH_OPS_FULL(device_program_hash_ops, char, string_hash_func, string_compare_func, free, DeviceProgram, free);
+
 /* Ensure the high level flags we use and the low-level BPF flags exposed on the kernel are defined the same way */
 assert_cc((unsigned) BPF_DEVCG_ACC_MKNOD == (unsigned) CGROUP_DEVICE_MKNOD);
 assert_cc((unsigned) BPF_DEVCG_ACC_READ  == (unsigned) CGROUP_DEVICE_READ);
@@ -185,11 +200,85 @@ int bpf_devices_cgroup_init(
         return 1;
 }
 
+static int bpf_devices_load_shared(BPFProgram *prog, Hashmap **cache, const char *cgroup_path) {
+        _cleanup_free_ DeviceProgram *n = NULL;
+        _cleanup_free_ char *key = NULL;
+        DeviceProgram *d;
+        int r;
+
+        assert(prog);
+        assert(cache);
+
+        /* Lots of units end up with the very same device policy (think PrivateDevices=yes or
+         * DevicePolicy=closed without further DeviceAllow=), hence instead of having the kernel verify an
+         * identical copy of the program for each cgroup, let's remember which programs we already loaded
+         * and attach those again. We only remember the kernel's ID of each program, not a reference to it:
+         * the kernel keeps a program around for as long as it is attached somewhere, and once it isn't
+         * anymore the ID simply stops resolving. */
+
+        if (prog->kernel_fd >= 0)
+                return 0;
+
+        key = hexmem(SHA256_DIRECT(prog->instructions, sizeof(struct bpf_insn) * prog->n_instructions), SHA256_DIGEST_SIZE);
+        if (!key)
+                return -ENOMEM;
+
+        d = hashmap_get(*cache, key);
+        if (d) {
+                _cleanup_close_ int fd = -EBADF;
+                uint8_t tag[BPF_TAG_SIZE];
+                uint32_t type;
+
+                /* The ID might have been recycled for an unrelated program in the meantime, hence check
+                 * that we got what we asked for. */
+                fd = bpf_program_get_fd_by_id(d->id);
+                if (fd >= 0 &&
+                    bpf_program_get_tag_by_fd(fd, /* ret_id= */ NULL, &type, tag) >= 0 &&
+                    type == prog->prog_type &&
+                    memcmp(tag, d->tag, sizeof(tag)) == 0) {
+                        log_debug("Reusing device control BPF program %" PRIu32 " for cgroup %s.",
+                                  d->id, empty_to_root(cgroup_path));
+                        prog->kernel_fd = TAKE_FD(fd);
+                        return 1;
+                }
+        }
+
+        r = bpf_program_load_kernel(prog, /* log_buf= */ NULL, /* log_size= */ 0);
+        if (r < 0)
+                return r;
+
+        if (!d) {
+                if (hashmap_size(*cache) >= DEVICE_PROGRAM_CACHE_MAX)
+                        hashmap_clear(*cache);
+
+                n = new0(DeviceProgram, 1);
+                if (!n)
+                        return -ENOMEM;
+
+                r = hashmap_ensure_put(cache, &device_program_hash_ops, key, n);
+                if (r < 0)
+                        return r;
+
+                TAKE_PTR(key);
+                d = TAKE_PTR(n);
+        }
+
+        r = bpf_program_get_tag_by_fd(prog->kernel_fd, &d->id, /* ret_type= */ NULL, d->tag);
+        if (r < 0) {
+                /* Make sure the entry never matches anything */
+                d->id = 0;
+                return r;
+        }
+
+        return 0;
+}
+
 int bpf_devices_apply_policy(
                 BPFProgram **prog,
                 CGroupDevicePolicy policy,
                 bool allow_list,
                 const char *cgroup_path,
+                Hashmap **cache,
                 BPFProgram **prog_installed) {
 
         _cleanup_free_ char *controller_path = NULL;
@@ -237,6 +326,25 @@ int bpf_devices_apply_policy(
         if (r < 0)
                 return log_error_errno(r, "Failed to determine cgroup path: %m");
 
+        /* If the very same program is already attached, there's nothing to do. Note that this is not just
+         * an optimization: with shared programs we'd otherwise try to attach the installed program a
+         * second time to the same cgroup, which the kernel refuses. */
+        if (prog_installed && *prog_installed &&
+            (*prog_installed)->attached_path &&
+            path_equal((*prog_installed)->attached_path, controller_path) &&
+            (*prog_installed)->n_instructions == (*prog)->n_instructions &&
+            memcmp_safe((*prog_installed)->instructions, (*prog)->instructions,
+                        sizeof(struct bpf_insn) * (*prog)->n_instructions) == 0) {
+                *prog = bpf_program_free(*prog);
+                return 0;
+        }
+
+        if (cache) {
+                r = bpf_devices_load_shared(*prog, cache, cgroup_path);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to share device control BPF program with other cgroups, ignoring: %m");
+        }
+
         r = bpf_program_cgroup_attach(*prog, BPF_CGROUP_DEVICE, controller_path, BPF_F_ALLOW_MULTI);
         if (r < 0)
                 return log_error_errno(r, "Attaching device control BPF program to cgroup %s failed: %m",
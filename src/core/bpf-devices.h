@@ -4,6 +4,7 @@
 #include <inttypes.h>
 
 #include "cgroup.h"
+#include "hashmap.h"
 
 typedef struct BPFProgram BPFProgram;
 
@@ -13,6 +14,7 @@ int bpf_devices_apply_policy(
                 CGroupDevicePolicy policy,
                 bool allow_list,
                 const char *cgroup_path,
+                Hashmap **cache,
                 BPFProgram **prog_installed);
 
 int bpf_devices_supported(void);
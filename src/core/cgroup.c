@@ -19,6 +19,7 @@
 #include "cgroup-util.h"
 #include "cgroup.h"
 #include "devnum-util.h"
+#include "escape.h"
 #include "fd-util.h"
 #include "fileio.h"
 #include "firewall-util.h"
@@ -115,23 +116,81 @@ bool unit_has_host_root_cgroup(const Unit *u) {
         return unit_has_name(u, SPECIAL_ROOT_SLICE);
 }
 
-static int set_attribute_and_warn(Unit *u, const char *controller, const char *attribute, const char *value) {
+static void cgroup_runtime_forget_attribute(CGroupRuntime *crt, const char *attribute) {
+        _cleanup_free_ char *k = NULL;
+
+        assert(crt);
+        assert(attribute);
+
+        free(hashmap_remove2(crt->cgroup_attributes_written, attribute, (void**) &k));
+}
+
+static void cgroup_runtime_remember_attribute(CGroupRuntime *crt, const char *attribute, const char *value) {
+        assert(crt);
+        assert(attribute);
+        assert(value);
+
+        cgroup_runtime_forget_attribute(crt, attribute);
+
+        /* This is just an optimization, hence on OOM we'll simply write the attribute again next time */
+        (void) hashmap_put_strdup(&crt->cgroup_attributes_written, attribute, value);
+}
+
+static int set_attribute_and_warn_full(
+                Unit *u,
+                const char *controller,
+                const char *attribute,
+                const char *value,
+                bool per_device) {
+
         int r;
 
         assert(u);
+        assert(attribute);
+        assert(value);
 
         CGroupRuntime *crt = unit_get_cgroup_runtime(u);
         if (!crt || !crt->cgroup_path)
                 return -EOWNERDEAD;
 
+        /* Realizing a cgroup applies all configured attributes, but usually only few of them actually
+         * changed since the last time, e.g. on daemon-reload. If the last value we wrote is identical,
+         * skip the write.
+         *
+         * Lines for a specific device (e.g. in io.max) are always written though: the kernel drops them
+         * when the device goes away, and a device that reappears under the same device number starts out
+         * without them again, which we wouldn't notice. Writing such a line does not change what a
+         * previous whole-file write to the same attribute left there, hence there is nothing to forget
+         * about then either. */
+        if (!per_device && streq_ptr(hashmap_get(crt->cgroup_attributes_written, attribute), value)) {
+                u->manager->cgroup_attribute_writes_skipped++;
+                return 0;
+        }
+
         r = cg_set_attribute(controller, crt->cgroup_path, attribute, value);
-        if (r < 0)
+        if (r < 0) {
                 log_unit_full_errno(u, LOG_LEVEL_CGROUP_WRITE(r), r, "Failed to set '%s' attribute on '%s' to '%.*s': %m",
                                     strna(attribute), empty_to_root(crt->cgroup_path), (int) strcspn(value, NEWLINE), value);
 
+                /* We don't know what the attribute is set to now */
+                cgroup_runtime_forget_attribute(crt, attribute);
+                return r;
+        }
+
+        u->manager->cgroup_attribute_writes++;
+        if (!per_device)
+                cgroup_runtime_remember_attribute(crt, attribute, value);
         return r;
 }
 
+static int set_attribute_and_warn(Unit *u, const char *controller, const char *attribute, const char *value) {
+        return set_attribute_and_warn_full(u, controller, attribute, value, /* per_device = */ false);
+}
+
+static int set_device_attribute_and_warn(Unit *u, const char *controller, const char *attribute, const char *value) {
+        return set_attribute_and_warn_full(u, controller, attribute, value, /* per_device = */ true);
+}
+
 static void cgroup_compat_warn(void) {
         static bool cgroup_compat_warned = false;
 
@@ -1752,7 +1811,7 @@ static void cgroup_apply_blkio_device_weight(Unit *u, const char *dev_path, uint
                 return;
 
         xsprintf(buf, DEVNUM_FORMAT_STR " %" PRIu64 "\n", DEVNUM_FORMAT_VAL(dev), blkio_weight);
-        (void) set_attribute_and_warn(u, "blkio", "blkio.weight_device", buf);
+        (void) set_device_attribute_and_warn(u, "blkio", "blkio.weight_device", buf);
 }
 
 static void cgroup_apply_io_device_latency(Unit *u, const char *dev_path, usec_t target) {
@@ -1769,7 +1828,7 @@ static void cgroup_apply_io_device_latency(Unit *u, const char *dev_path, usec_t
         else
                 xsprintf(buf, DEVNUM_FORMAT_STR " target=max\n", DEVNUM_FORMAT_VAL(dev));
 
-        (void) set_attribute_and_warn(u, "io", "io.latency", buf);
+        (void) set_device_attribute_and_warn(u, "io", "io.latency", buf);
 }
 
 static void cgroup_apply_io_device_limit(Unit *u, const char *dev_path, uint64_t *limits) {
@@ -1789,7 +1848,7 @@ static void cgroup_apply_io_device_limit(Unit *u, const char *dev_path, uint64_t
         xsprintf(buf, DEVNUM_FORMAT_STR " rbps=%s wbps=%s riops=%s wiops=%s\n", DEVNUM_FORMAT_VAL(dev),
                  limit_bufs[CGROUP_IO_RBPS_MAX], limit_bufs[CGROUP_IO_WBPS_MAX],
                  limit_bufs[CGROUP_IO_RIOPS_MAX], limit_bufs[CGROUP_IO_WIOPS_MAX]);
-        (void) set_attribute_and_warn(u, "io", "io.max", buf);
+        (void) set_device_attribute_and_warn(u, "io", "io.max", buf);
 }
 
 static void cgroup_apply_blkio_device_limit(Unit *u, const char *dev_path, uint64_t rbps, uint64_t wbps) {
@@ -1800,10 +1859,10 @@ static void cgroup_apply_blkio_device_limit(Unit *u, const char *dev_path, uint6
                 return;
 
         sprintf(buf, DEVNUM_FORMAT_STR " %" PRIu64 "\n", DEVNUM_FORMAT_VAL(dev), rbps);
-        (void) set_attribute_and_warn(u, "blkio", "blkio.throttle.read_bps_device", buf);
+        (void) set_device_attribute_and_warn(u, "blkio", "blkio.throttle.read_bps_device", buf);
 
         sprintf(buf, DEVNUM_FORMAT_STR " %" PRIu64 "\n", DEVNUM_FORMAT_VAL(dev), wbps);
-        (void) set_attribute_and_warn(u, "blkio", "blkio.throttle.write_bps_device", buf);
+        (void) set_device_attribute_and_warn(u, "blkio", "blkio.throttle.write_bps_device", buf);
 }
 
 static bool unit_has_unified_memory_config(Unit *u) {
@@ -1970,7 +2029,7 @@ static int cgroup_apply_devices(Unit *u) {
                 policy = CGROUP_DEVICE_POLICY_STRICT;
         }
 
-        r = bpf_devices_apply_policy(&prog, policy, any, crt->cgroup_path, &crt->bpf_device_control_installed);
+        r = bpf_devices_apply_policy(&prog, policy, any, crt->cgroup_path, &u->manager->bpf_device_programs, &crt->bpf_device_control_installed);
         if (r < 0) {
                 static bool warned = false;
 
@@ -2925,6 +2984,11 @@ static int unit_update_cgroup(
                 migrate_mask = crt->cgroup_realized_mask ^ target_mask;
         }
 
+        /* If the cgroup was just created or the set of controllers changed, the attribute files were
+         * (re)initialized by the kernel or went away, hence forget what we wrote to them earlier. */
+        if (created || crt->cgroup_realized_mask != target_mask)
+                crt->cgroup_attributes_written = hashmap_free(crt->cgroup_attributes_written);
+
         /* Keep track that this is now realized */
         crt->cgroup_realized = true;
         crt->cgroup_realized_mask = target_mask;
@@ -3714,6 +3778,7 @@ void unit_prune_cgroup(Unit *u) {
         crt->cgroup_realized = false;
         crt->cgroup_realized_mask = 0;
         crt->cgroup_enabled_mask = 0;
+        crt->cgroup_attributes_written = hashmap_free(crt->cgroup_attributes_written);
 
         crt->bpf_device_control_installed = bpf_program_free(crt->bpf_device_control_installed);
 }
@@ -3904,6 +3969,23 @@ static int on_cgroup_empty_event(sd_event_source *s, void *userdata) {
         return 0;
 }
 
+static void unit_enqueue_cgroup_empty(Unit *u) {
+        int r;
+
+        assert(u);
+
+        if (u->in_cgroup_empty_queue)
+                return;
+
+        LIST_PREPEND(cgroup_empty_queue, u->manager->cgroup_empty_queue, u);
+        u->in_cgroup_empty_queue = true;
+
+        /* Trigger the defer event */
+        r = sd_event_source_set_enabled(u->manager->cgroup_empty_event_source, SD_EVENT_ONESHOT);
+        if (r < 0)
+                log_debug_errno(r, "Failed to enable cgroup empty event source: %m");
+}
+
 void unit_add_to_cgroup_empty_queue(Unit *u) {
         int r;
 
@@ -3934,13 +4016,7 @@ void unit_add_to_cgroup_empty_queue(Unit *u) {
         if (r <= 0)
                 return;
 
-        LIST_PREPEND(cgroup_empty_queue, u->manager->cgroup_empty_queue, u);
-        u->in_cgroup_empty_queue = true;
-
-        /* Trigger the defer event */
-        r = sd_event_source_set_enabled(u->manager->cgroup_empty_event_source, SD_EVENT_ONESHOT);
-        if (r < 0)
-                log_debug_errno(r, "Failed to enable cgroup empty event source: %m");
+        unit_enqueue_cgroup_empty(u);
 }
 
 static void unit_remove_from_cgroup_empty_queue(Unit *u) {
@@ -4146,7 +4222,9 @@ static int unit_check_cgroup_events(Unit *u) {
                 if (streq(values[0], "1"))
                         unit_remove_from_cgroup_empty_queue(u);
                 else
-                        unit_add_to_cgroup_empty_queue(u);
+                        /* We just read that the cgroup is not populated, no need to verify that again by
+                         * reading the same attribute once more. */
+                        unit_enqueue_cgroup_empty(u);
         }
 
         /* Disregard freezer state changes due to operations not initiated by us.
@@ -4823,6 +4901,80 @@ int unit_get_ip_accounting(
         return r;
 }
 
+static void unit_refresh_accounting_snapshot(Unit *u, CGroupRuntime *crt) {
+        CGroupAccountingSnapshot *s;
+        int r;
+
+        assert(u);
+        assert(crt);
+
+        s = &crt->accounting_snapshot;
+
+        /* Reads all counters in one go. Errors are only logged at debug level here, as the snapshot is
+         * refreshed implicitly for whatever client asks, and unavailable counters are simply reported as
+         * such. */
+
+        s->memory_current = UINT64_MAX;
+        r = unit_get_memory_current(u, &s->memory_current);
+        if (r < 0 && r != -ENODATA)
+                log_unit_debug_errno(u, r, "Failed to get current memory usage from cgroup, ignoring: %m");
+
+        for (CGroupMemoryAccountingMetric metric = 0; metric < _CGROUP_MEMORY_ACCOUNTING_METRIC_MAX; metric++) {
+                s->memory[metric] = UINT64_MAX;
+                (void) unit_get_memory_accounting(u, metric, &s->memory[metric]);
+        }
+
+        s->tasks_current = UINT64_MAX;
+        r = unit_get_tasks_current(u, &s->tasks_current);
+        if (r < 0 && r != -ENODATA)
+                log_unit_debug_errno(u, r, "Failed to get pids.current attribute, ignoring: %m");
+
+        s->cpu_usage = NSEC_INFINITY;
+        r = unit_get_cpu_usage(u, &s->cpu_usage);
+        if (r < 0 && r != -ENODATA)
+                log_unit_debug_errno(u, r, "Failed to get cpuacct.usage attribute, ignoring: %m");
+
+        /* io.stat carries all IO counters at once, hence read it only once, and then take the values from
+         * the cache unit_get_io_accounting() maintains. If reading fails with -ENODATA, these are the values
+         * of the last time the counters could be read, as with the individual metric lookups. */
+        r = unit_get_io_accounting(u, _CGROUP_IO_ACCOUNTING_METRIC_INVALID, /* ret = */ NULL);
+        for (CGroupIOAccountingMetric metric = 0; metric < _CGROUP_IO_ACCOUNTING_METRIC_MAX; metric++)
+                s->io[metric] = r >= 0 || (r == -ENODATA && UNIT_CGROUP_BOOL(u, io_accounting)) ?
+                        crt->io_accounting_last[metric] : UINT64_MAX;
+
+        for (CGroupIPAccountingMetric metric = 0; metric < _CGROUP_IP_ACCOUNTING_METRIC_MAX; metric++) {
+                s->ip[metric] = UINT64_MAX;
+                (void) unit_get_ip_accounting(u, metric, &s->ip[metric]);
+        }
+
+        s->timestamp = now(CLOCK_MONOTONIC);
+}
+
+int unit_get_accounting_snapshot(Unit *u, const CGroupAccountingSnapshot **ret) {
+        usec_t max_age;
+
+        assert(u);
+        assert(ret);
+
+        /* Returns a snapshot of all accounting counters of the unit. If AccountingMaxAgeSec= is set, a
+         * previously taken snapshot is returned as long as it is not older than that, so that clients
+         * polling the counters of many units don't result in a flood of cgroupfs reads. Otherwise the
+         * snapshot is taken anew every time. */
+
+        CGroupRuntime *crt = unit_get_cgroup_runtime(u);
+        if (!crt)
+                return -ENODATA;
+
+        max_age = u->manager->accounting_max_age_usec;
+        if (max_age <= 0 ||
+            crt->accounting_snapshot.timestamp <= 0 ||
+            usec_add(crt->accounting_snapshot.timestamp, max_age) <= now(CLOCK_MONOTONIC))
+                unit_refresh_accounting_snapshot(u, crt);
+
+        *ret = &crt->accounting_snapshot;
+        return 0;
+}
+
 static uint64_t unit_get_effective_limit_one(Unit *u, CGroupLimitType type) {
         CGroupContext *cc;
 
@@ -5075,6 +5227,7 @@ int unit_reset_accounting(Unit *u) {
         if (!crt)
                 return 0;
 
+        crt->accounting_snapshot.timestamp = 0;
         cgroup_runtime_reset_memory_accounting_last(crt);
         RET_GATHER(r, unit_reset_cpu_accounting(u, crt));
         RET_GATHER(r, unit_reset_io_accounting(u, crt));
@@ -5344,6 +5497,7 @@ CGroupRuntime* cgroup_runtime_free(CGroupRuntime *crt) {
         bpf_link_free(crt->ipv6_socket_bind_link);
 #endif
         hashmap_free(crt->bpf_foreign_by_key);
+        hashmap_free(crt->cgroup_attributes_written);
 
         bpf_program_free(crt->bpf_device_control_installed);
 
@@ -5422,7 +5576,9 @@ int cgroup_runtime_serialize(Unit *u, FILE *f, FDSet *fds) {
         if (!crt)
                 return 0;
 
-        (void) serialize_item_format(f, "cpu-usage-base", "%" PRIu64, crt->cpu_usage_base);
+        /* The accounting bases default to zero, no need to serialize them in that case */
+        if (crt->cpu_usage_base > 0)
+                (void) serialize_item_format(f, "cpu-usage-base", "%" PRIu64, crt->cpu_usage_base);
         if (crt->cpu_usage_last != NSEC_INFINITY)
                 (void) serialize_item_format(f, "cpu-usage-last", "%" PRIu64, crt->cpu_usage_last);
 
@@ -5449,7 +5605,8 @@ int cgroup_runtime_serialize(Unit *u, FILE *f, FDSet *fds) {
         }
 
         for (CGroupIOAccountingMetric im = 0; im < _CGROUP_IO_ACCOUNTING_METRIC_MAX; im++) {
-                (void) serialize_item_format(f, io_accounting_metric_field_base_to_string(im), "%" PRIu64, crt->io_accounting_base[im]);
+                if (crt->io_accounting_base[im] > 0)
+                        (void) serialize_item_format(f, io_accounting_metric_field_base_to_string(im), "%" PRIu64, crt->io_accounting_base[im]);
 
                 if (crt->io_accounting_last[im] != UINT64_MAX)
                         (void) serialize_item_format(f, io_accounting_metric_field_last_to_string(im), "%" PRIu64, crt->io_accounting_last[im]);
@@ -5465,6 +5622,15 @@ int cgroup_runtime_serialize(Unit *u, FILE *f, FDSet *fds) {
         (void) serialize_cgroup_mask(f, "cgroup-enabled-mask", crt->cgroup_enabled_mask);
         (void) serialize_cgroup_mask(f, "cgroup-invalidated-mask", crt->cgroup_invalidated_mask);
 
+        const char *attribute, *value;
+        HASHMAP_FOREACH_KEY(value, attribute, crt->cgroup_attributes_written) {
+                _cleanup_free_ char *s = strjoin(attribute, "=", value);
+                if (!s)
+                        return log_oom();
+
+                (void) serialize_item_escaped(f, "cgroup-attribute-written", s);
+        }
+
         (void) bpf_socket_bind_serialize(u, f, fds);
 
         (void) bpf_program_serialize_attachment(f, fds, "ip-bpf-ingress-installed", crt->ip_bpf_ingress_installed);
@@ -5580,6 +5746,33 @@ int cgroup_runtime_deserialize_one(Unit *u, const char *key, const char *value,
         if (MATCH_DESERIALIZE_IMMEDIATE(u, "cgroup-invalidated-mask", key, value, cg_mask_from_string, cgroup_invalidated_mask))
                 return 1;
 
+        if (streq(key, "cgroup-attribute-written")) {
+                _cleanup_free_ char *unescaped = NULL;
+                ssize_t l;
+                char *eq;
+
+                l = cunescape(value, 0, &unescaped);
+                if (l < 0) {
+                        log_unit_debug_errno(u, l, "Failed to unescape cgroup attribute value '%s', ignoring: %m", value);
+                        return 1;
+                }
+
+                eq = strchr(unescaped, '=');
+                if (!eq) {
+                        log_unit_debug(u, "Failed to parse cgroup attribute value '%s', ignoring.", value);
+                        return 1;
+                }
+                *eq = 0;
+
+                CGroupRuntime *crt = unit_setup_cgroup_runtime(u);
+                if (!crt)
+                        log_oom_debug();
+                else
+                        cgroup_runtime_remember_attribute(crt, unescaped, eq + 1);
+
+                return 1;
+        }
+
         if (STR_IN_SET(key, "ipv4-socket-bind-bpf-link-fd", "ipv6-socket-bind-bpf-link-fd")) {
                 int fd;
 
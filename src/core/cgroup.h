@@ -296,6 +296,18 @@ typedef enum CGroupLimitType {
         _CGROUP_LIMIT_INVALID = -EINVAL,
 } CGroupLimitType;
 
+/* A snapshot of all accounting counters of a unit, taken at once. Counters that are not available are set
+ * to UINT64_MAX. */
+typedef struct CGroupAccountingSnapshot {
+        usec_t timestamp; /* CLOCK_MONOTONIC, 0 if never taken */
+        uint64_t memory_current;
+        uint64_t memory[_CGROUP_MEMORY_ACCOUNTING_METRIC_MAX];
+        uint64_t tasks_current;
+        nsec_t cpu_usage;
+        uint64_t io[_CGROUP_IO_ACCOUNTING_METRIC_MAX];
+        uint64_t ip[_CGROUP_IP_ACCOUNTING_METRIC_MAX];
+} CGroupAccountingSnapshot;
+
 /* The dynamic, regular updated information about a unit that as a realized cgroup. This is only allocated when a unit is first realized */
 typedef struct CGroupRuntime {
         /* Where the cpu.stat or cpuacct.usage was at the time the unit was started */
@@ -311,6 +323,9 @@ typedef struct CGroupRuntime {
         /* The current counter of the oom_kill field in the memory.events cgroup attribute */
         uint64_t oom_kill_last;
 
+        /* The accounting counters as served to D-Bus and Varlink clients, see AccountingMaxAgeSec= */
+        CGroupAccountingSnapshot accounting_snapshot;
+
         /* Where the io.stat data was at the time the unit was started */
         uint64_t io_accounting_base[_CGROUP_IO_ACCOUNTING_METRIC_MAX];
         uint64_t io_accounting_last[_CGROUP_IO_ACCOUNTING_METRIC_MAX]; /* the most recently read value */
@@ -327,6 +342,11 @@ typedef struct CGroupRuntime {
         int cgroup_control_inotify_wd;
         int cgroup_memory_inotify_wd;
 
+        /* Last value successfully written to each cgroup attribute, so that identical writes can be
+         * skipped when the cgroup is realized again. Attribute name → value, flushed whenever the cgroup is
+         * (re)created or removed. */
+        Hashmap *cgroup_attributes_written;
+
         /* Device Controller BPF program */
         BPFProgram *bpf_device_control_installed;
 
@@ -486,6 +506,7 @@ int unit_get_cpu_usage(Unit *u, nsec_t *ret);
 int unit_get_io_accounting(Unit *u, CGroupIOAccountingMetric metric, uint64_t *ret);
 int unit_get_ip_accounting(Unit *u, CGroupIPAccountingMetric metric, uint64_t *ret);
 int unit_get_effective_limit(Unit *u, CGroupLimitType type, uint64_t *ret);
+int unit_get_accounting_snapshot(Unit *u, const CGroupAccountingSnapshot **ret);
 
 int unit_reset_accounting(Unit *u);
 
@@ -4,12 +4,15 @@
 
 #include "core-varlink.h"
 #include "json-util.h"
+#include "metrics.h"
 #include "mkdir-label.h"
 #include "strv.h"
 #include "user-util.h"
 #include "varlink-internal.h"
 #include "varlink-io.systemd.UserDatabase.h"
 #include "varlink-io.systemd.ManagedOOM.h"
+#include "varlink-io.systemd.Manager.h"
+#include "varlink-io.systemd.Metrics.h"
 #include "varlink-io.systemd.service.h"
 #include "varlink-util.h"
 
@@ -562,6 +565,315 @@ static int vl_method_get_memberships(sd_varlink *link, sd_json_variant *paramete
         return sd_varlink_error(link, "io.systemd.UserDatabase.NoRecordFound", NULL);
 }
 
+typedef struct ListUnitsParameters {
+        char **states;
+        char **patterns;
+        char **properties;
+} ListUnitsParameters;
+
+static void list_units_parameters_done(ListUnitsParameters *p) {
+        assert(p);
+
+        p->states = strv_free(p->states);
+        p->patterns = strv_free(p->patterns);
+        p->properties = strv_free(p->properties);
+}
+
+static const char* const list_units_properties[] = {
+        "description",
+        "loadState",
+        "activeState",
+        "freezerState",
+        "subState",
+        "following",
+        "jobId",
+        "jobType",
+        "invocationId",
+        "activeEnterTimestamp",
+        "activeExitTimestamp",
+        "stateChangeTimestamp",
+};
+
+static bool list_units_want(char * const *properties, const char *name) {
+        return strv_isempty(properties) || strv_contains(properties, name);
+}
+
+static int build_unit_info_json(Unit *u, char * const *properties, sd_json_variant **ret) {
+        Unit *following;
+
+        assert(u);
+        assert(ret);
+
+        following = unit_following(u);
+
+        return sd_json_buildo(
+                        ret,
+                        SD_JSON_BUILD_PAIR_STRING("id", u->id),
+                        SD_JSON_BUILD_PAIR_CONDITION(list_units_want(properties, "description"),
+                                                     "description", SD_JSON_BUILD_STRING(unit_description(u))),
+                        SD_JSON_BUILD_PAIR_CONDITION(list_units_want(properties, "loadState"),
+                                                     "loadState", SD_JSON_BUILD_STRING(unit_load_state_to_string(u->load_state))),
+                        SD_JSON_BUILD_PAIR_CONDITION(list_units_want(properties, "activeState"),
+                                                     "activeState", SD_JSON_BUILD_STRING(unit_active_state_to_string(unit_active_state(u)))),
+                        SD_JSON_BUILD_PAIR_CONDITION(list_units_want(properties, "freezerState"),
+                                                     "freezerState", SD_JSON_BUILD_STRING(freezer_state_to_string(u->freezer_state))),
+                        SD_JSON_BUILD_PAIR_CONDITION(list_units_want(properties, "subState"),
+                                                     "subState", SD_JSON_BUILD_STRING(unit_sub_state_to_string(u))),
+                        SD_JSON_BUILD_PAIR_CONDITION(following && list_units_want(properties, "following"),
+                                                     "following", SD_JSON_BUILD_STRING(following ? following->id : NULL)),
+                        SD_JSON_BUILD_PAIR_CONDITION(u->job && list_units_want(properties, "jobId"),
+                                                     "jobId", SD_JSON_BUILD_UNSIGNED(u->job ? u->job->id : 0)),
+                        SD_JSON_BUILD_PAIR_CONDITION(u->job && list_units_want(properties, "jobType"),
+                                                     "jobType", SD_JSON_BUILD_STRING(u->job ? job_type_to_string(u->job->type) : NULL)),
+                        SD_JSON_BUILD_PAIR_CONDITION(!sd_id128_is_null(u->invocation_id) && list_units_want(properties, "invocationId"),
+                                                     "invocationId", SD_JSON_BUILD_ID128(u->invocation_id)),
+                        SD_JSON_BUILD_PAIR_CONDITION(dual_timestamp_is_set(&u->active_enter_timestamp) && list_units_want(properties, "activeEnterTimestamp"),
+                                                     "activeEnterTimestamp", JSON_BUILD_DUAL_TIMESTAMP(&u->active_enter_timestamp)),
+                        SD_JSON_BUILD_PAIR_CONDITION(dual_timestamp_is_set(&u->active_exit_timestamp) && list_units_want(properties, "activeExitTimestamp"),
+                                                     "activeExitTimestamp", JSON_BUILD_DUAL_TIMESTAMP(&u->active_exit_timestamp)),
+                        SD_JSON_BUILD_PAIR_CONDITION(dual_timestamp_is_set(&u->state_change_timestamp) && list_units_want(properties, "stateChangeTimestamp"),
+                                                     "stateChangeTimestamp", JSON_BUILD_DUAL_TIMESTAMP(&u->state_change_timestamp)));
+}
+
+static int vl_method_list_units(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+
+        static const sd_json_dispatch_field dispatch_table[] = {
+                { "states",     SD_JSON_VARIANT_ARRAY, sd_json_dispatch_strv, offsetof(ListUnitsParameters, states),     0 },
+                { "patterns",   SD_JSON_VARIANT_ARRAY, sd_json_dispatch_strv, offsetof(ListUnitsParameters, patterns),   0 },
+                { "properties", SD_JSON_VARIANT_ARRAY, sd_json_dispatch_strv, offsetof(ListUnitsParameters, properties), 0 },
+                {}
+        };
+
+        _cleanup_(list_units_parameters_done) ListUnitsParameters p = {};
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        Manager *m = ASSERT_PTR(userdata);
+        const char *k;
+        Unit *u;
+        int r;
+
+        assert(parameters);
+
+        /* The Varlink counterpart of ListUnitsWithProperties(): since we have no bus message to serialize
+         * the D-Bus vtables into, this returns a fixed set of fields of which the caller may pick a subset,
+         * one reply per unit. */
+
+        r = sd_varlink_dispatch(link, parameters, dispatch_table, &p);
+        if (r != 0)
+                return r;
+
+        STRV_FOREACH(i, p.properties)
+                if (!strv_contains((char**) list_units_properties, *i))
+                        return sd_varlink_error_invalid_parameter_name(link, "properties");
+
+        if (!FLAGS_SET(flags, SD_VARLINK_METHOD_MORE))
+                return sd_varlink_error(link, SD_VARLINK_ERROR_EXPECTED_MORE, NULL);
+
+        HASHMAP_FOREACH_KEY(u, k, m->units) {
+                if (k != u->id)
+                        continue;
+
+                if (!unit_passes_filter(u, p.states, p.patterns))
+                        continue;
+
+                if (v) {
+                        r = sd_varlink_notify(link, v);
+                        if (r < 0)
+                                return r;
+
+                        v = sd_json_variant_unref(v);
+                }
+
+                r = build_unit_info_json(u, p.properties, &v);
+                if (r < 0)
+                        return r;
+        }
+
+        if (!v)
+                return sd_varlink_error(link, "io.systemd.Manager.NoSuchUnit", NULL);
+
+        return sd_varlink_reply(link, v);
+}
+
+static int build_unit_accounting_json(Unit *u, sd_json_variant **ret) {
+        const CGroupAccountingSnapshot *s;
+        int r;
+
+        assert(u);
+        assert(ret);
+
+        r = unit_get_accounting_snapshot(u, &s);
+        if (r < 0)
+                return r;
+
+        return sd_json_buildo(
+                        ret,
+                        SD_JSON_BUILD_PAIR_STRING("id", u->id),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("memoryCurrent", s->memory_current, UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("memoryPeak", s->memory[CGROUP_MEMORY_PEAK], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("memorySwapCurrent", s->memory[CGROUP_MEMORY_SWAP_CURRENT], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("memorySwapPeak", s->memory[CGROUP_MEMORY_SWAP_PEAK], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("memoryZSwapCurrent", s->memory[CGROUP_MEMORY_ZSWAP_CURRENT], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("tasksCurrent", s->tasks_current, UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("cpuUsageNSec", s->cpu_usage, NSEC_INFINITY),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("ioReadBytes", s->io[CGROUP_IO_READ_BYTES], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("ioWriteBytes", s->io[CGROUP_IO_WRITE_BYTES], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("ioReadOperations", s->io[CGROUP_IO_READ_OPERATIONS], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("ioWriteOperations", s->io[CGROUP_IO_WRITE_OPERATIONS], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("ipIngressBytes", s->ip[CGROUP_IP_INGRESS_BYTES], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("ipIngressPackets", s->ip[CGROUP_IP_INGRESS_PACKETS], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("ipEgressBytes", s->ip[CGROUP_IP_EGRESS_BYTES], UINT64_MAX),
+                        JSON_BUILD_PAIR_UNSIGNED_NOT_EQUAL("ipEgressPackets", s->ip[CGROUP_IP_EGRESS_PACKETS], UINT64_MAX));
+}
+
+static int vl_method_list_unit_accounting(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+
+        static const sd_json_dispatch_field dispatch_table[] = {
+                { "patterns", SD_JSON_VARIANT_ARRAY, sd_json_dispatch_strv, 0, 0 },
+                {}
+        };
+
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        _cleanup_strv_free_ char **patterns = NULL;
+        Manager *m = ASSERT_PTR(userdata);
+        const char *k;
+        Unit *u;
+        int r;
+
+        assert(parameters);
+
+        /* Returns the accounting counters of all units in one call, so that exporters don't have to query
+         * the properties of each unit individually. The counters are taken from the per-unit snapshots, see
+         * AccountingMaxAgeSec=. */
+
+        r = sd_varlink_dispatch(link, parameters, dispatch_table, &patterns);
+        if (r != 0)
+                return r;
+
+        if (!FLAGS_SET(flags, SD_VARLINK_METHOD_MORE))
+                return sd_varlink_error(link, SD_VARLINK_ERROR_EXPECTED_MORE, NULL);
+
+        HASHMAP_FOREACH_KEY(u, k, m->units) {
+                _cleanup_(sd_json_variant_unrefp) sd_json_variant *w = NULL;
+
+                if (k != u->id)
+                        continue;
+
+                if (!UNIT_HAS_CGROUP_CONTEXT(u))
+                        continue;
+
+                if (!unit_passes_filter(u, /* states = */ NULL, patterns))
+                        continue;
+
+                r = build_unit_accounting_json(u, &w);
+                if (r == -ENODATA) /* No cgroup realized (yet) */
+                        continue;
+                if (r < 0)
+                        return r;
+
+                if (v) {
+                        r = sd_varlink_notify(link, v);
+                        if (r < 0)
+                                return r;
+
+                        sd_json_variant_unref(v);
+                }
+
+                v = TAKE_PTR(w);
+        }
+
+        if (!v)
+                return sd_varlink_error(link, "io.systemd.Manager.NoSuchUnit", NULL);
+
+        return sd_varlink_reply(link, v);
+}
+
+static int metric_units_by_type(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+        int r;
+
+        for (UnitType t = 0; t < _UNIT_TYPE_MAX; t++) {
+                uint64_t n = 0;
+
+                LIST_FOREACH(units_by_type, u, m->units_by_type[t])
+                        n++;
+
+                r = metric_append_value(array, f, "type", unit_type_to_string(t), n);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int metric_jobs(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, hashmap_size(m->jobs));
+}
+
+static int metric_jobs_running(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->n_running_jobs);
+}
+
+static int metric_jobs_installed(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->n_installed_jobs);
+}
+
+static int metric_jobs_failed(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->n_failed_jobs);
+}
+
+static int metric_job_run_time(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_histogram(array, f, NULL, NULL, &m->job_run_time_histogram);
+}
+
+static int metric_reloading(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, MAX(m->n_reloading, 0));
+}
+
+static int metric_run_queue_yields(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->n_run_queue_yields);
+}
+
+static int metric_change_signals_coalesced(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->n_change_signals_coalesced);
+}
+
+static const MetricFamily manager_metric_families[] = {
+        { "io.systemd.Manager.Units",                   "Units loaded, by unit type",                                       METRIC_GAUGE,     metric_units_by_type             },
+        { "io.systemd.Manager.Jobs",                    "Jobs currently installed",                                         METRIC_GAUGE,     metric_jobs                      },
+        { "io.systemd.Manager.JobsRunning",             "Jobs currently running",                                           METRIC_GAUGE,     metric_jobs_running              },
+        { "io.systemd.Manager.JobsInstalledTotal",      "Jobs installed since the manager started",                         METRIC_COUNTER,   metric_jobs_installed            },
+        { "io.systemd.Manager.JobsFailedTotal",         "Jobs failed since the manager started",                            METRIC_COUNTER,   metric_jobs_failed               },
+        { "io.systemd.Manager.JobRunTimeMSec",          "Time jobs were running until they finished, in ms",                METRIC_HISTOGRAM, metric_job_run_time              },
+        { "io.systemd.Manager.Reloading",               "Whether the manager is currently reloading or reexecuting",        METRIC_GAUGE,     metric_reloading                 },
+        { "io.systemd.Manager.RunQueueYieldsTotal",     "How often dispatching the job run queue yielded to other events",  METRIC_COUNTER,   metric_run_queue_yields          },
+        { "io.systemd.Manager.ChangeSignalsCoalesced",  "D-Bus change signals that were coalesced with later ones",         METRIC_COUNTER,   metric_change_signals_coalesced  },
+        {}
+};
+
+static int vl_method_list_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_list(link, parameters, manager_metric_families, userdata);
+}
+
+static int vl_method_describe_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_describe(link, parameters, manager_metric_families);
+}
+
 static void vl_disconnect(sd_varlink_server *s, sd_varlink *link, void *userdata) {
         Manager *m = ASSERT_PTR(userdata);
 
@@ -592,6 +904,8 @@ int manager_setup_varlink_server(Manager *m) {
                         s,
                         &vl_interface_io_systemd_UserDatabase,
                         &vl_interface_io_systemd_ManagedOOM,
+                        &vl_interface_io_systemd_Manager,
+                        &vl_interface_io_systemd_Metrics,
                         &vl_interface_io_systemd_service);
         if (r < 0)
                 return log_debug_errno(r, "Failed to add interfaces to varlink server: %m");
@@ -602,8 +916,13 @@ int manager_setup_varlink_server(Manager *m) {
                         "io.systemd.UserDatabase.GetGroupRecord", vl_method_get_group_record,
                         "io.systemd.UserDatabase.GetMemberships", vl_method_get_memberships,
                         "io.systemd.ManagedOOM.SubscribeManagedOOMCGroups", vl_method_subscribe_managed_oom_cgroups,
+                        "io.systemd.Manager.ListUnits", vl_method_list_units,
+                        "io.systemd.Manager.ListUnitAccounting", vl_method_list_unit_accounting,
+                        "io.systemd.Metrics.List", vl_method_list_metrics,
+                        "io.systemd.Metrics.Describe", vl_method_describe_metrics,
                         "io.systemd.service.Ping", varlink_method_ping,
-                        "io.systemd.service.GetEnvironment", varlink_method_get_environment);
+                        "io.systemd.service.GetEnvironment", varlink_method_get_environment,
+                        "io.systemd.service.GetEventLoopStatistics", varlink_method_get_event_loop_statistics);
         if (r < 0)
                 return log_debug_errno(r, "Failed to register varlink methods: %m");
 
@@ -635,7 +954,10 @@ static int manager_varlink_init_system(Manager *m) {
         if (!MANAGER_IS_TEST_RUN(m)) {
                 (void) mkdir_p_label("/run/systemd/userdb", 0755);
 
-                FOREACH_STRING(address, "/run/systemd/userdb/io.systemd.DynamicUser", VARLINK_ADDR_PATH_MANAGED_OOM_SYSTEM) {
+                FOREACH_STRING(address,
+                               "/run/systemd/userdb/io.systemd.DynamicUser",
+                               VARLINK_ADDR_PATH_MANAGED_OOM_SYSTEM,
+                               VARLINK_ADDR_PATH_MANAGER) {
                         if (!fresh) {
                                 /* We might have got sockets through deserialization. Do not bind to them twice. */
 
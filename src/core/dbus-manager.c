@@ -11,6 +11,7 @@
 #include "build.h"
 #include "bus-common-errors.h"
 #include "bus-get-properties.h"
+#include "bus-internal.h"
 #include "bus-log-control-api.h"
 #include "bus-message-util.h"
 #include "bus-util.h"
@@ -34,7 +35,6 @@
 #include "locale-util.h"
 #include "log.h"
 #include "manager-dump.h"
-#include "memfd-util.h"
 #include "os-util.h"
 #include "parse-util.h"
 #include "path-util.h"
@@ -207,6 +207,34 @@ static int property_set_log_level(
         return 0;
 }
 
+static int property_get_generator_timings(
+                sd_bus *bus,
+                const char *path,
+                const char *interface,
+                const char *property,
+                sd_bus_message *reply,
+                void *userdata,
+                sd_bus_error *error) {
+
+        Manager *m = ASSERT_PTR(userdata);
+        int r;
+
+        assert(bus);
+        assert(reply);
+
+        r = sd_bus_message_open_container(reply, 'a', "(st)");
+        if (r < 0)
+                return r;
+
+        FOREACH_ARRAY(t, m->generator_timings, m->n_generator_timings) {
+                r = sd_bus_message_append(reply, "(st)", t->path, t->duration);
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_bus_message_close_container(reply);
+}
+
 static int property_get_environment(
                 sd_bus *bus,
                 const char *path,
@@ -992,7 +1020,15 @@ static int transient_unit_from_message(
                                          "Unit type %s does not support transient units.",
                                          unit_type_to_string(t));
 
-        r = manager_load_unit(m, name, NULL, error, &u);
+        /* Transient units are typically created at a high rate under a fresh name. If there's nothing on
+         * disk for the name, there's no point in loading the unit first only to find that out, as it is
+         * loaded once more below after the transient settings are written. Hence in that case just
+         * allocate the unit. If in doubt, load it fully. */
+        r = manager_unit_file_exists(m, name);
+        if (r == 0)
+                r = manager_load_unit_prepare(m, name, NULL, error, &u);
+        else
+                r = manager_load_unit(m, name, NULL, error, &u);
         if (r < 0)
                 return r;
 
@@ -1276,6 +1312,80 @@ static int method_list_units_by_patterns(sd_bus_message *message, void *userdata
         return list_units_filtered(message, userdata, error, states, patterns);
 }
 
+static int method_list_units_with_properties(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        _cleanup_strv_free_ char **states = NULL, **patterns = NULL, **properties = NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        Manager *m = ASSERT_PTR(userdata);
+        const char *k;
+        Unit *u;
+        int r;
+
+        assert(message);
+
+        /* Like ListUnitsByPatterns(), but returns the requested properties of each unit instead of a fixed
+         * set of fields, so that clients don't have to issue a GetAll() call for each unit. */
+
+        r = sd_bus_message_read_strv(message, &states);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(message, &patterns);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(message, &properties);
+        if (r < 0)
+                return r;
+
+        STRV_FOREACH(p, properties)
+                if (!member_name_is_valid(*p))
+                        return sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Invalid property name: %s", *p);
+
+        /* Anyone can call this method */
+
+        r = mac_selinux_access_check(message, "status", error);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_new_method_return(message, &reply);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_open_container(reply, 'a', "(sa{sv})");
+        if (r < 0)
+                return r;
+
+        HASHMAP_FOREACH_KEY(u, k, m->units) {
+                if (k != u->id)
+                        continue;
+
+                if (!unit_passes_filter(u, states, patterns))
+                        continue;
+
+                r = sd_bus_message_open_container(reply, 'r', "sa{sv}");
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_append(reply, "s", u->id);
+                if (r < 0)
+                        return r;
+
+                r = bus_unit_append_properties(reply, u, properties, error);
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_close_container(reply);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_bus_message_close_container(reply);
+        if (r < 0)
+                return r;
+
+        return sd_bus_send(NULL, reply, NULL);
+}
+
 static int method_list_jobs(sd_bus_message *message, void *userdata, sd_bus_error *error) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
         Manager *m = ASSERT_PTR(userdata);
@@ -1389,9 +1499,8 @@ static int dump_impl(
                 void *userdata,
                 sd_bus_error *error,
                 char **patterns,
-                int (*reply)(sd_bus_message *, char *)) {
+                int (*reply)(sd_bus_message *, Manager *, char **)) {
 
-        _cleanup_free_ char *dump = NULL;
         Manager *m = ASSERT_PTR(userdata);
         int r;
 
@@ -1425,11 +1534,7 @@ static int dump_impl(
                         return 1;
         }
 
-        r = manager_get_dump_string(m, patterns, &dump);
-        if (r < 0)
-                return r;
-
-        return reply(message, dump);
+        return reply(message, m, patterns);
 
 ratelimited:
         log_warning("Dump request rejected due to rate limit on unprivileged callers, blocked for %s.",
@@ -1440,7 +1545,14 @@ ratelimited:
                                  FORMAT_TIMESPAN(ratelimit_left(&m->dump_ratelimit), USEC_PER_SEC));
 }
 
-static int reply_dump(sd_bus_message *message, char *dump) {
+static int reply_dump(sd_bus_message *message, Manager *m, char **patterns) {
+        _cleanup_free_ char *dump = NULL;
+        int r;
+
+        r = manager_get_dump_string(m, patterns, &dump);
+        if (r < 0)
+                return r;
+
         return sd_bus_reply_method_return(message, "s", dump);
 }
 
@@ -1448,10 +1560,10 @@ static int method_dump(sd_bus_message *message, void *userdata, sd_bus_error *er
         return dump_impl(message, userdata, error, NULL, reply_dump);
 }
 
-static int reply_dump_by_fd(sd_bus_message *message, char *dump) {
+static int reply_dump_by_fd(sd_bus_message *message, Manager *m, char **patterns) {
         _cleanup_close_ int fd = -EBADF;
 
-        fd = memfd_new_and_seal_string("dump", dump);
+        fd = manager_get_dump_fd(m, patterns);
         if (fd < 0)
                 return fd;
 
@@ -1466,7 +1578,7 @@ static int dump_units_matching_patterns(
                 sd_bus_message *message,
                 void *userdata,
                 sd_bus_error *error,
-                int (*reply)(sd_bus_message *, char *)) {
+                int (*reply)(sd_bus_message *, Manager *, char **)) {
         _cleanup_strv_free_ char **patterns = NULL;
         int r;
 
@@ -1558,6 +1670,56 @@ static int method_reload(sd_bus_message *message, void *userdata, sd_bus_error *
         return 1;
 }
 
+static int method_reload_changed_units(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        Manager *m = ASSERT_PTR(userdata);
+        int r;
+
+        assert(message);
+
+        r = mac_selinux_access_check(message, "reload", error);
+        if (r < 0)
+                return r;
+
+        r = bus_verify_reload_daemon_async(m, message, error);
+        if (r < 0)
+                return r;
+        if (r == 0)
+                return 1; /* No authorization for now, but the async polkit stuff will call us again when it has it */
+
+        log_caller(message, m, "ReloadChangedUnits");
+
+        if (!ratelimit_below(&m->reload_reexec_ratelimit)) {
+                log_warning("Reloading request rejected due to rate limit.");
+                return sd_bus_error_setf(error,
+                                         SD_BUS_ERROR_LIMITS_EXCEEDED,
+                                         "ReloadChangedUnits() request rejected due to rate limit.");
+        }
+
+        r = manager_reload_changed(m);
+        if (r >= 0)
+                return sd_bus_reply_method_return(message, "b", false);
+        if (r != -EBUSY)
+                return r;
+
+        /* Some changed unit cannot be replaced in place, fall back to a full reload, and reply once it is
+         * finished, like Reload() does. */
+
+        assert(!m->pending_reload_message);
+        r = sd_bus_message_new_method_return(message, &m->pending_reload_message);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_append(m->pending_reload_message, "b", true);
+        if (r < 0) {
+                m->pending_reload_message = sd_bus_message_unref(m->pending_reload_message);
+                return r;
+        }
+
+        m->objective = MANAGER_RELOAD;
+
+        return 1;
+}
+
 static int method_reexecute(sd_bus_message *message, void *userdata, sd_bus_error *error) {
         Manager *m = ASSERT_PTR(userdata);
         int r;
@@ -3102,6 +3264,11 @@ const sd_bus_vtable bus_manager_vtable[] = {
         SD_BUS_PROPERTY("DefaultOOMScoreAdjust", "i", property_get_oom_score_adjust, 0, SD_BUS_VTABLE_PROPERTY_CONST),
         SD_BUS_PROPERTY("CtrlAltDelBurstAction", "s", bus_property_get_emergency_action, offsetof(Manager, cad_burst_action), SD_BUS_VTABLE_PROPERTY_CONST),
         SD_BUS_PROPERTY("SoftRebootsCount", "u", bus_property_get_unsigned, offsetof(Manager, soft_reboots_count), SD_BUS_VTABLE_PROPERTY_CONST),
+        SD_BUS_PROPERTY("GeneratorParallelism", "u", bus_property_get_unsigned, offsetof(Manager, generator_parallelism), SD_BUS_VTABLE_PROPERTY_CONST),
+        SD_BUS_PROPERTY("GeneratorTimings", "a(st)", property_get_generator_timings, 0, 0),
+        SD_BUS_PROPERTY("ChangeSignalCoalesceUSec", "t", bus_property_get_usec, offsetof(Manager, change_signal_coalesce_usec), SD_BUS_VTABLE_PROPERTY_CONST),
+        SD_BUS_PROPERTY("ChangeSignalsCoalesced", "t", NULL, offsetof(Manager, n_change_signals_coalesced), 0),
+        SD_BUS_PROPERTY("AccountingMaxAgeUSec", "t", bus_property_get_usec, offsetof(Manager, accounting_max_age_usec), SD_BUS_VTABLE_PROPERTY_CONST),
 
         SD_BUS_METHOD_WITH_ARGS("GetUnit",
                                 SD_BUS_ARGS("s", name),
@@ -3318,6 +3485,11 @@ const sd_bus_vtable bus_manager_vtable[] = {
                                 SD_BUS_RESULT("a(ssssssouso)", units),
                                 method_list_units_by_names,
                                 SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD_WITH_ARGS("ListUnitsWithProperties",
+                                SD_BUS_ARGS("as", states, "as", patterns, "as", properties),
+                                SD_BUS_RESULT("a(sa{sv})", units),
+                                method_list_units_with_properties,
+                                SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD_WITH_ARGS("ListJobs",
                                 SD_BUS_NO_ARGS,
                                 SD_BUS_RESULT("a(usssoo)", jobs),
@@ -3368,6 +3540,11 @@ const sd_bus_vtable bus_manager_vtable[] = {
                       NULL,
                       method_reload,
                       SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD_WITH_ARGS("ReloadChangedUnits",
+                                SD_BUS_NO_ARGS,
+                                SD_BUS_RESULT("b", full_reload),
+                                method_reload_changed_units,
+                                SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD("Reexecute",
                       NULL,
                       NULL,
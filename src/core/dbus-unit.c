@@ -1052,6 +1052,24 @@ static int property_get_slice(
         return sd_bus_message_append(reply, "s", unit_slice_name(u));
 }
 
+static const CGroupAccountingSnapshot* unit_get_cached_accounting(Unit *u) {
+        const CGroupAccountingSnapshot *snapshot;
+
+        assert(u);
+
+        /* With AccountingMaxAgeSec= set, the counters are served from the unit's accounting snapshot, so
+         * that reading all of them (as "systemctl status" does) or polling them frequently only results in
+         * one round of cgroupfs reads per period. */
+
+        if (u->manager->accounting_max_age_usec <= 0)
+                return NULL;
+
+        if (unit_get_accounting_snapshot(u, &snapshot) < 0)
+                return NULL;
+
+        return snapshot;
+}
+
 static int property_get_current_memory(
                 sd_bus *bus,
                 const char *path,
@@ -1068,6 +1086,10 @@ static int property_get_current_memory(
         assert(bus);
         assert(reply);
 
+        const CGroupAccountingSnapshot *snapshot = unit_get_cached_accounting(u);
+        if (snapshot)
+                return sd_bus_message_append(reply, "t", snapshot->memory_current);
+
         r = unit_get_memory_current(u, &sz);
         if (r < 0 && r != -ENODATA)
                 log_unit_warning_errno(u, r, "Failed to get current memory usage from cgroup: %m");
@@ -1115,7 +1137,12 @@ static int property_get_memory_accounting(
         assert(reply);
 
         assert_se((metric = cgroup_memory_accounting_metric_from_string(property)) >= 0);
-        (void) unit_get_memory_accounting(u, metric, &sz);
+
+        const CGroupAccountingSnapshot *snapshot = unit_get_cached_accounting(u);
+        if (snapshot)
+                sz = snapshot->memory[metric];
+        else
+                (void) unit_get_memory_accounting(u, metric, &sz);
         return sd_bus_message_append(reply, "t", sz);
 }
 
@@ -1135,6 +1162,10 @@ static int property_get_current_tasks(
         assert(bus);
         assert(reply);
 
+        const CGroupAccountingSnapshot *snapshot = unit_get_cached_accounting(u);
+        if (snapshot)
+                return sd_bus_message_append(reply, "t", snapshot->tasks_current);
+
         r = unit_get_tasks_current(u, &cn);
         if (r < 0 && r != -ENODATA)
                 log_unit_warning_errno(u, r, "Failed to get pids.current attribute: %m");
@@ -1158,6 +1189,10 @@ static int property_get_cpu_usage(
         assert(bus);
         assert(reply);
 
+        const CGroupAccountingSnapshot *snapshot = unit_get_cached_accounting(u);
+        if (snapshot)
+                return sd_bus_message_append(reply, "t", snapshot->cpu_usage);
+
         r = unit_get_cpu_usage(u, &ns);
         if (r < 0 && r != -ENODATA)
                 log_unit_warning_errno(u, r, "Failed to get cpuacct.usage attribute: %m");
@@ -1431,7 +1466,12 @@ static int property_get_ip_counter(
         assert(property);
 
         assert_se((metric = cgroup_ip_accounting_metric_from_string(property)) >= 0);
-        (void) unit_get_ip_accounting(u, metric, &value);
+
+        const CGroupAccountingSnapshot *snapshot = unit_get_cached_accounting(u);
+        if (snapshot)
+                value = snapshot->ip[metric];
+        else
+                (void) unit_get_ip_accounting(u, metric, &value);
         return sd_bus_message_append(reply, "t", value);
 }
 
@@ -1453,7 +1493,12 @@ static int property_get_io_counter(
         assert(property);
 
         assert_se((metric = cgroup_io_accounting_metric_from_string(property)) >= 0);
-        (void) unit_get_io_accounting(u, metric, &value);
+
+        const CGroupAccountingSnapshot *snapshot = unit_get_cached_accounting(u);
+        if (snapshot)
+                value = snapshot->io[metric];
+        else
+                (void) unit_get_io_accounting(u, metric, &value);
         return sd_bus_message_append(reply, "t", value);
 }
 
@@ -11,6 +11,7 @@
 #include "bus-common-errors.h"
 #include "bus-error.h"
 #include "bus-internal.h"
+#include "bus-objects.h"
 #include "bus-polkit.h"
 #include "bus-util.h"
 #include "dbus-automount.h"
@@ -599,6 +600,94 @@ static const BusObjectImplementation manager_log_control_object = {
         .vtables = BUS_VTABLES(bus_manager_log_control_vtable),
 };
 
+static const BusObjectImplementation* const unit_type_objects[_UNIT_TYPE_MAX] = {
+        [UNIT_AUTOMOUNT] = &bus_automount_object,
+        [UNIT_DEVICE]    = &bus_device_object,
+        [UNIT_MOUNT]     = &bus_mount_object,
+        [UNIT_PATH]      = &bus_path_object,
+        [UNIT_SCOPE]     = &bus_scope_object,
+        [UNIT_SERVICE]   = &bus_service_object,
+        [UNIT_SLICE]     = &bus_slice_object,
+        [UNIT_SOCKET]    = &bus_socket_object,
+        [UNIT_SWAP]      = &bus_swap_object,
+        [UNIT_TARGET]    = &bus_target_object,
+        [UNIT_TIMER]     = &bus_timer_object,
+};
+
+static void* unit_vtable_userdata(Unit *u, sd_bus_object_find_t find) {
+        assert(u);
+
+        /* Returns what the find callback of the vtable would return for the unit's object path, without
+         * having to go through the object path */
+
+        if (find == bus_unit_find || find == bus_unit_interface_find)
+                return u;
+        if (find == bus_unit_cgroup_find)
+                return UNIT_HAS_CGROUP_CONTEXT(u) ? u : NULL;
+        if (find == bus_cgroup_context_find)
+                return unit_get_cgroup_context(u);
+        if (find == bus_exec_context_find)
+                return unit_get_exec_context(u);
+        if (find == bus_kill_context_find)
+                return unit_get_kill_context(u);
+
+        assert_not_reached();
+}
+
+int bus_unit_append_properties(sd_bus_message *reply, Unit *u, char * const *properties, sd_bus_error *error) {
+        const BusObjectImplementation *impls[] = {
+                &unit_object,
+                unit_type_objects[u->type],
+        };
+        _cleanup_free_ char *path = NULL;
+        sd_bus *bus;
+        int r;
+
+        assert(reply);
+        assert(u);
+
+        /* Appends the specified properties of the unit to the message as "a{sv}", looking them up in the
+         * generic unit interface first, and in the interfaces of the unit type second. Properties the unit
+         * doesn't have are silently skipped. */
+
+        bus = ASSERT_PTR(sd_bus_message_get_bus(reply));
+
+        path = unit_dbus_path(u);
+        if (!path)
+                return -ENOMEM;
+
+        r = sd_bus_message_open_container(reply, 'a', "{sv}");
+        if (r < 0)
+                return r;
+
+        STRV_FOREACH(property, properties) {
+                bool found = false;
+
+                FOREACH_ELEMENT(impl, impls) {
+                        for (const BusObjectVtablePair *p = (*impl)->fallback_vtables; p->vtable; p++) {
+                                void *userdata;
+
+                                userdata = unit_vtable_userdata(u, p->object_find);
+                                if (!userdata)
+                                        continue;
+
+                                r = bus_vtable_append_property(bus, reply, path, (*impl)->interface, p->vtable, *property, userdata, error);
+                                if (r < 0)
+                                        return r;
+                                if (r > 0) {
+                                        found = true;
+                                        break;
+                                }
+                        }
+
+                        if (found)
+                                break;
+                }
+        }
+
+        return sd_bus_message_close_container(reply);
+}
+
 int bus_manager_introspect_implementations(FILE *out, const char *pattern) {
         return bus_introspect_implementations(
                         out,
@@ -28,3 +28,5 @@ uint64_t manager_bus_n_queued_write(Manager *m);
 
 void dump_bus_properties(FILE *f);
 int bus_manager_introspect_implementations(FILE *out, const char *pattern);
+
+int bus_unit_append_properties(sd_bus_message *reply, Unit *u, char * const *properties, sd_bus_error *error);
@@ -140,6 +140,7 @@ static void device_done(Unit *u) {
         device_unset_sysfs(d);
         d->deserialized_sysfs = mfree(d->deserialized_sysfs);
         d->wants_property = strv_free(d->wants_property);
+        d->wants_property_raw = mfree(d->wants_property_raw);
         d->path = mfree(d->path);
 }
 
@@ -541,19 +542,69 @@ static int device_update_description(Unit *u, sd_device *dev, const char *path)
         return 0;
 }
 
+static void device_start_udev_wants(Device *d, char * const *added, const char *property) {
+        int r;
+
+        assert(d);
+        assert(property);
+
+        if (d->state != DEVICE_DEAD)
+                /* So here's a special hack, to compensate for the fact that the udev database's reload cycles are not
+                 * synchronized with our own reload cycles: when we detect that the SYSTEMD_WANTS property of a device
+                 * changes while the device unit is already up, let's skip to trigger units that were already listed
+                 * and are active, and start units otherwise. This typically happens during the boot-time switch root
+                 * transition, as udev devices will generally already be up in the initrd, but SYSTEMD_WANTS properties
+                 * get then added through udev rules only available on the host system, and thus only when the initial
+                 * udev coldplug trigger runs.
+                 *
+                 * We do this only if the device has been up already when we parse this, as otherwise the usual
+                 * dependency logic that is run from the dead → plugged transition will trigger these deps. */
+                STRV_FOREACH(i, added) {
+                        _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+
+                        if (strv_contains(d->wants_property, *i)) {
+                                Unit *v;
+
+                                v = manager_get_unit(UNIT(d)->manager, *i);
+                                if (v && UNIT_IS_ACTIVE_OR_RELOADING(unit_active_state(v)))
+                                        continue; /* The unit was already listed and is running. */
+                        }
+
+                        r = manager_add_job_by_name(UNIT(d)->manager, JOB_START, *i, JOB_FAIL, NULL, &error, NULL);
+                        if (r < 0)
+                                log_unit_full_errno(UNIT(d), sd_bus_error_has_name(&error, BUS_ERROR_NO_SUCH_UNIT) ? LOG_DEBUG : LOG_WARNING, r,
+                                                    "Failed to enqueue %s job, ignoring: %s", property, bus_error_message(&error, r));
+                }
+}
+
 static int device_add_udev_wants(Unit *u, sd_device *dev) {
         Device *d = ASSERT_PTR(DEVICE(u));
         _cleanup_strv_free_ char **added = NULL;
-        const char *wants, *property;
+        const char *wants = NULL, *raw, *property;
         int r;
 
         assert(dev);
 
         property = MANAGER_IS_USER(u->manager) ? "SYSTEMD_USER_WANTS" : "SYSTEMD_WANTS";
 
+        if (d->udev_dependencies_valid) {
+                /* Nothing changed since we set up the dependencies the last time (see
+                 * device_udev_dependencies_unchanged()), hence skip parsing the property and adding the
+                 * dependencies again. Only do what would be done for the units that are already listed. */
+                if (d->wants_property_raw)
+                        device_start_udev_wants(d, d->wants_property, property);
+                return 0;
+        }
+
         r = sd_device_get_property_value(dev, property, &wants);
-        if (r < 0)
+        if (r < 0) {
+                d->wants_property_raw = mfree(d->wants_property_raw);
+                d->udev_dependencies_valid = true;
                 return 0;
+        }
+
+        /* Remember the unparsed value, as wants is moved forward while parsing below */
+        raw = wants;
 
         for (;;) {
                 _cleanup_free_ char *word = NULL, *k = NULL;
@@ -596,33 +647,13 @@ static int device_add_udev_wants(Unit *u, sd_device *dev) {
                         return log_oom();
         }
 
-        if (d->state != DEVICE_DEAD)
-                /* So here's a special hack, to compensate for the fact that the udev database's reload cycles are not
-                 * synchronized with our own reload cycles: when we detect that the SYSTEMD_WANTS property of a device
-                 * changes while the device unit is already up, let's skip to trigger units that were already listed
-                 * and are active, and start units otherwise. This typically happens during the boot-time switch root
-                 * transition, as udev devices will generally already be up in the initrd, but SYSTEMD_WANTS properties
-                 * get then added through udev rules only available on the host system, and thus only when the initial
-                 * udev coldplug trigger runs.
-                 *
-                 * We do this only if the device has been up already when we parse this, as otherwise the usual
-                 * dependency logic that is run from the dead → plugged transition will trigger these deps. */
-                STRV_FOREACH(i, added) {
-                        _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        device_start_udev_wants(d, added, property);
 
-                        if (strv_contains(d->wants_property, *i)) {
-                                Unit *v;
-
-                                v = manager_get_unit(u->manager, *i);
-                                if (v && UNIT_IS_ACTIVE_OR_RELOADING(unit_active_state(v)))
-                                        continue; /* The unit was already listed and is running. */
-                        }
+        r = free_and_strdup(&d->wants_property_raw, raw);
+        if (r < 0)
+                return log_oom();
 
-                        r = manager_add_job_by_name(u->manager, JOB_START, *i, JOB_FAIL, NULL, &error, NULL);
-                        if (r < 0)
-                                log_unit_full_errno(u, sd_bus_error_has_name(&error, BUS_ERROR_NO_SUCH_UNIT) ? LOG_DEBUG : LOG_WARNING, r,
-                                                    "Failed to enqueue %s job, ignoring: %s", property, bus_error_message(&error, r));
-                }
+        d->udev_dependencies_valid = true;
 
         return strv_free_and_replace(d->wants_property, added);
 }
@@ -661,6 +692,29 @@ static void device_upgrade_mount_deps(Unit *u) {
         }
 }
 
+static bool device_udev_dependencies_unchanged(Device *d, sd_device *dev, const char *sysfs, bool main) {
+        const char *wants = NULL;
+
+        assert(d);
+
+        /* Checks whether the udev properties the dependencies of this device unit are generated from are the
+         * same as the last time. If so, the dependencies don't have to be removed and added again, which is
+         * costly when lots of devices are updated at once, e.g. on a "change" uevent storm. */
+
+        if (!main || !dev || !sysfs || !d->udev_dependencies_valid)
+                return false;
+
+        if (!d->sysfs || !path_equal(d->sysfs, sysfs))
+                return false;
+
+        if ((device_get_property_bool(dev, "SYSTEMD_MOUNT_DEVICE_BOUND") > 0) != d->bind_mounts)
+                return false;
+
+        (void) sd_device_get_property_value(dev, MANAGER_IS_USER(UNIT(d)->manager) ? "SYSTEMD_USER_WANTS" : "SYSTEMD_WANTS", &wants);
+
+        return streq_ptr(d->wants_property_raw, wants);
+}
+
 static int device_setup_unit(Manager *m, sd_device *dev, const char *path, bool main, Set **units) {
         _cleanup_(unit_freep) Unit *new_unit = NULL;
         _cleanup_free_ char *e = NULL;
@@ -698,8 +752,11 @@ static int device_setup_unit(Manager *m, sd_device *dev, const char *path, bool
                  * device causes syspath change. Hence, let's always update sysfs path. */
 
                 /* Let's remove all dependencies generated due to udev properties. We'll re-add whatever is configured
-                 * now below. */
-                unit_remove_dependencies(u, UNIT_DEPENDENCY_UDEV);
+                 * now below. Unless nothing changed, in which case we keep them as they are. */
+                if (!device_udev_dependencies_unchanged(DEVICE(u), dev, sysfs, main)) {
+                        unit_remove_dependencies(u, UNIT_DEPENDENCY_UDEV);
+                        DEVICE(u)->udev_dependencies_valid = false;
+                }
 
         } else {
                 r = unit_new_for_name(m, sizeof(Device), e, &new_unit);
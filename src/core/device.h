@@ -36,6 +36,11 @@ struct Device {
 
         /* The SYSTEMD_WANTS udev property for this device the last time we saw it */
         char **wants_property;
+
+        /* The unparsed SYSTEMD_WANTS udev property the udev dependencies were last set up from, and whether
+         * they are still in place. Used to skip recomputing them when a device is updated but unchanged. */
+        char *wants_property_raw;
+        bool udev_dependencies_valid;
 };
 
 extern const UnitVTable device_vtable;
@@ -1511,27 +1511,35 @@ static bool skip_seccomp_unavailable(const ExecContext *c, const ExecParameters
         return true;
 }
 
-static int apply_syscall_filter(const ExecContext *c, const ExecParameters *p) {
-        uint32_t negative_action, default_action, action;
+static const char* syscall_filter_cache_dir(const ExecParameters *p) {
+        assert(p);
+
+        /* Only the system service manager's executor may populate a cache in /run/systemd/ */
+        return p->runtime_scope == RUNTIME_SCOPE_SYSTEM ? "/run/systemd/seccomp" : NULL;
+}
+
+static int syscall_filter_actions(
+                const ExecContext *c,
+                const ExecParameters *p,
+                uint32_t *ret_default_action,
+                uint32_t *ret_action) {
+
+        uint32_t negative_action;
         int r;
 
         assert(c);
         assert(p);
-
-        if (!context_has_syscall_filters(c))
-                return 0;
-
-        if (skip_seccomp_unavailable(c, p, "SystemCallFilter="))
-                return 0;
+        assert(ret_default_action);
+        assert(ret_action);
 
         negative_action = c->syscall_errno == SECCOMP_ERROR_NUMBER_KILL ? scmp_act_kill_process() : SCMP_ACT_ERRNO(c->syscall_errno);
 
         if (c->syscall_allow_list) {
-                default_action = negative_action;
-                action = SCMP_ACT_ALLOW;
+                *ret_default_action = negative_action;
+                *ret_action = SCMP_ACT_ALLOW;
         } else {
-                default_action = SCMP_ACT_ALLOW;
-                action = negative_action;
+                *ret_default_action = SCMP_ACT_ALLOW;
+                *ret_action = negative_action;
         }
 
         /* Sending over exec_fd or handoff_timestamp_fd requires write() syscall. */
@@ -1541,7 +1549,54 @@ static int apply_syscall_filter(const ExecContext *c, const ExecParameters *p) {
                         return r;
         }
 
-        return seccomp_load_syscall_filter_set_raw(default_action, c->syscall_filter, action, false);
+        return 0;
+}
+
+static void prepare_syscall_filter(const ExecContext *c, const ExecParameters *p, SeccompProgramSet *ret) {
+        uint32_t default_action, action;
+        const char *cache_dir;
+        int r;
+
+        assert(c);
+        assert(p);
+        assert(ret);
+
+        /* Compiling large system call filters is slow. Take the compiled filter from the cache, or place it
+         * there, while we still see the host's file system and may write to it. The programs are kept in
+         * memory, apply_syscall_filter() then installs them without touching the cache again. */
+
+        if (!context_has_syscall_filters(c) || !is_seccomp_available())
+                return;
+
+        cache_dir = syscall_filter_cache_dir(p);
+        if (!cache_dir)
+                return;
+
+        r = syscall_filter_actions(c, p, &default_action, &action);
+        if (r >= 0)
+                r = seccomp_prepare_syscall_filter_set_raw(default_action, c->syscall_filter, action, cache_dir, ret);
+        if (r < 0)
+                log_exec_debug_errno(c, p, r, "Failed to precompile system call filter, ignoring: %m");
+}
+
+static int apply_syscall_filter(const ExecContext *c, const ExecParameters *p, const SeccompProgramSet *prepared) {
+        uint32_t default_action, action;
+        int r;
+
+        assert(c);
+        assert(p);
+
+        if (!context_has_syscall_filters(c))
+                return 0;
+
+        if (skip_seccomp_unavailable(c, p, "SystemCallFilter="))
+                return 0;
+
+        r = syscall_filter_actions(c, p, &default_action, &action);
+        if (r < 0)
+                return r;
+
+        return seccomp_load_syscall_filter_set_raw_full(default_action, c->syscall_filter, action, /* log_missing= */ false, prepared);
 }
 
 static int apply_syscall_log(const ExecContext *c, const ExecParameters *p) {
@@ -4426,6 +4481,7 @@ int exec_invoke(
         bool use_apparmor = false;
 #endif
 #if HAVE_SECCOMP
+        _cleanup_(seccomp_program_set_done) SeccompProgramSet syscall_filter_programs = {};
         uint64_t saved_bset = 0;
 #endif
         uid_t saved_uid = getuid();
@@ -4992,6 +5048,11 @@ int exec_invoke(
                 return log_exec_error_errno(context, params, r, "Failed to set up credentials: %m");
         }
 
+#if HAVE_SECCOMP
+        if (needs_sandboxing)
+                prepare_syscall_filter(context, params, &syscall_filter_programs);
+#endif
+
         r = build_environment(
                         context,
                         params,
@@ -5693,7 +5754,7 @@ int exec_invoke(
 #if HAVE_SECCOMP
                 /* This really should remain as close to the execve() as possible, to make sure our own code is affected
                  * by the filter as little as possible. */
-                r = apply_syscall_filter(context, params);
+                r = apply_syscall_filter(context, params, &syscall_filter_programs);
                 if (r < 0) {
                         *exit_status = EXIT_SECCOMP;
                         return log_exec_error_errno(context, params, r, "Failed to apply system call filters: %m");
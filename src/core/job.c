@@ -313,7 +313,7 @@ int job_install_deserialized(Job *j) {
         if (j->id <= 0)
                 j->id = manager_get_new_job_id(j->manager);
 
-        r = hashmap_ensure_put(&j->manager->jobs, NULL, UINT32_TO_PTR(j->id), j);
+        r = hashmap_ensure_put(&j->manager->jobs, &trusted_trivial_hash_ops, UINT32_TO_PTR(j->id), j);
         if (r == -EEXIST)
                 return log_unit_debug_errno(j->unit, r, "Job ID %" PRIu32 " already used, cannot deserialize job.", j->id);
         if (r < 0)
@@ -1038,6 +1038,10 @@ int job_finish_and_invalidate(Job *j, JobResult result, bool recursive, bool alr
         if (IN_SET(result, JOB_FAILED, JOB_INVALID, JOB_FROZEN))
                 j->manager->n_failed_jobs++;
 
+        if (timestamp_is_set(j->begin_running_usec))
+                metric_histogram_observe(&j->manager->job_run_time_histogram,
+                                         usec_sub_unsigned(now(CLOCK_MONOTONIC), j->begin_running_usec) / USEC_PER_MSEC);
+
         job_uninstall(j);
         job_free(j);
 
@@ -1201,8 +1205,10 @@ void job_add_to_dbus_queue(Job *j) {
         assert(j);
         assert(j->installed);
 
-        if (j->in_dbus_queue)
+        if (j->in_dbus_queue) {
+                j->manager->n_change_signals_coalesced++;
                 return;
+        }
 
         /* We don't check if anybody is subscribed here, since this
          * job might just have been created and not yet assigned to a
@@ -6182,14 +6182,19 @@ int unit_load_fragment(Unit *u) {
                 return 0;
         }
 
-        /* Possibly rebuild the fragment map to catch new units */
-        r = unit_file_build_name_map(&u->manager->lookup_paths,
-                                     &u->manager->unit_cache_timestamp_hash,
-                                     &u->manager->unit_id_map,
-                                     &u->manager->unit_name_map,
-                                     &u->manager->unit_path_cache);
-        if (r < 0)
-                return log_error_errno(r, "Failed to rebuild name map: %m");
+        /* Possibly rebuild the fragment map to catch new units. While dispatching the load queue, do this
+         * only for the first unit loaded, not for every single one of what might be thousands. */
+        if (!u->manager->unit_cache_validated) {
+                r = unit_file_build_name_map(&u->manager->lookup_paths,
+                                             &u->manager->unit_cache_timestamp_hash,
+                                             &u->manager->unit_id_map,
+                                             &u->manager->unit_name_map,
+                                             &u->manager->unit_path_cache);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to rebuild name map: %m");
+
+                u->manager->unit_cache_validated = u->manager->dispatching_load_queue;
+        }
 
         r = unit_file_find_fragment(u->manager->unit_id_map,
                                     u->manager->unit_name_map,
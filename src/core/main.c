@@ -164,6 +164,9 @@ static void *arg_random_seed;
 static size_t arg_random_seed_size;
 static usec_t arg_reload_limit_interval_sec;
 static unsigned arg_reload_limit_burst;
+static unsigned arg_generator_parallelism;
+static usec_t arg_change_signal_coalesce_usec;
+static usec_t arg_accounting_max_age_usec;
 
 /* A copy of the original environment block */
 static char **saved_env = NULL;
@@ -823,6 +826,9 @@ static int parse_config_file(void) {
                 { "Manager", "DefaultOOMScoreAdjust",        config_parse_oom_score_adjust,      0,                        NULL                              },
                 { "Manager", "ReloadLimitIntervalSec",       config_parse_sec,                   0,                        &arg_reload_limit_interval_sec    },
                 { "Manager", "ReloadLimitBurst",             config_parse_unsigned,              0,                        &arg_reload_limit_burst           },
+                { "Manager", "GeneratorParallelism",         config_parse_unsigned,              0,                        &arg_generator_parallelism        },
+                { "Manager", "ChangeSignalCoalesceSec",      config_parse_sec,                   0,                        &arg_change_signal_coalesce_usec  },
+                { "Manager", "AccountingMaxAgeSec",          config_parse_sec,                   0,                        &arg_accounting_max_age_usec      },
 #if ENABLE_SMACK
                 { "Manager", "DefaultSmackProcessLabel",     config_parse_string,                0,                        &arg_defaults.smack_process_label },
 #else
@@ -908,6 +914,9 @@ static void set_manager_settings(Manager *m) {
          * counter on every daemon-reload. */
         m->reload_reexec_ratelimit.interval = arg_reload_limit_interval_sec;
         m->reload_reexec_ratelimit.burst = arg_reload_limit_burst;
+        m->generator_parallelism = arg_generator_parallelism;
+        m->change_signal_coalesce_usec = arg_change_signal_coalesce_usec;
+        m->accounting_max_age_usec = arg_accounting_max_age_usec;
 
         manager_set_watchdog(m, WATCHDOG_RUNTIME, arg_runtime_watchdog);
         manager_set_watchdog(m, WATCHDOG_REBOOT, arg_reboot_watchdog);
@@ -1120,9 +1129,10 @@ static int parse_argv(int argc, char *argv[]) {
 
                         (void) fd_cloexec(fd, true);
 
-                        f = fdopen(fd, "r");
-                        if (!f)
-                                return log_error_errno(errno, "Failed to open serialization fd %d: %m", fd);
+                        /* Only we access this stream, hence skip stdio's locking for each character read */
+                        r = fdopen_unlocked(fd, "r", &f);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to open serialization fd %d: %m", fd);
 
                         safe_fclose(arg_serialization);
                         arg_serialization = f;
@@ -2801,6 +2811,9 @@ static void reset_arguments(void) {
 
         arg_reload_limit_interval_sec = 0;
         arg_reload_limit_burst = 0;
+        arg_generator_parallelism = 0;
+        arg_change_signal_coalesce_usec = 0;
+        arg_accounting_max_age_usec = 0;
 }
 
 static void determine_default_oom_score_adjust(void) {
@@ -1,11 +1,18 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "build.h"
 #include "fd-util.h"
 #include "fileio.h"
+#include "format-util.h"
 #include "hashmap.h"
+#include "mallinfo-util.h"
 #include "manager-dump.h"
+#include "memfd-util.h"
 #include "memstream-util.h"
+#include "missing_mman.h"
 #include "unit-serialize.h"
 #include "version.h"
 
@@ -58,6 +65,50 @@ void manager_dump_units(Manager *s, FILE *f, char **patterns, const char *prefix
         }
 }
 
+static void manager_dump_memory(Manager *m, FILE *f, const char *prefix) {
+        size_t n_dependencies = 0;
+
+        /* A rough breakdown of where our memory goes. The sizes of unit objects only cover the objects
+         * themselves, not anything they point to. */
+
+        for (UnitType t = 0; t < _UNIT_TYPE_MAX; t++) {
+                size_t n = 0;
+
+                LIST_FOREACH(units_by_type, u, m->units_by_type[t]) {
+                        Hashmap *deps;
+
+                        n++;
+
+                        HASHMAP_FOREACH(deps, u->dependencies)
+                                n_dependencies += hashmap_size(deps);
+                }
+
+                if (n == 0)
+                        continue;
+
+                fprintf(f, "%sUnits of type %s: %zu (%s)\n",
+                        strempty(prefix), unit_type_to_string(t), n,
+                        FORMAT_BYTES(n * unit_vtable[t]->object_size));
+        }
+
+        fprintf(f, "%sUnit names: %u\n", strempty(prefix), hashmap_size(m->units));
+        fprintf(f, "%sUnit dependencies: %zu\n", strempty(prefix), n_dependencies);
+        fprintf(f, "%sJobs: %u\n", strempty(prefix), hashmap_size(m->jobs));
+        fprintf(f, "%sWatched PIDs: %u\n", strempty(prefix), hashmap_size(m->watch_pids));
+        fprintf(f, "%sWatched bus names: %u\n", strempty(prefix), hashmap_size(m->watch_bus));
+        fprintf(f, "%sCGroups: %u\n", strempty(prefix), hashmap_size(m->cgroup_unit));
+
+#if HAVE_GENERIC_MALLINFO
+        generic_mallinfo mi = generic_mallinfo_get();
+
+        fprintf(f, "%sMemory allocated: %s (%s heap, %s mmap)\n", strempty(prefix),
+                FORMAT_BYTES((uint64_t) mi.uordblks + (uint64_t) mi.hblkhd),
+                FORMAT_BYTES((uint64_t) mi.uordblks),
+                FORMAT_BYTES((uint64_t) mi.hblkhd));
+        fprintf(f, "%sMemory free in heap: %s\n", strempty(prefix), FORMAT_BYTES((uint64_t) mi.fordblks));
+#endif
+}
+
 static void manager_dump_header(Manager *m, FILE *f, const char *prefix) {
 
         /* NB: this is a debug interface for developers. It's not supposed to be machine readable or be
@@ -80,6 +131,13 @@ static void manager_dump_header(Manager *m, FILE *f, const char *prefix) {
 
         for (const char *n = sd_bus_track_first(m->subscribed); n; n = sd_bus_track_next(m->subscribed))
                 fprintf(f, "%sSubscribed: %s\n", strempty(prefix), n);
+
+        manager_dump_memory(m, f, prefix);
+
+        fprintf(f, "%sJob run queue yields: %u\n", strempty(prefix), m->n_run_queue_yields);
+        fprintf(f, "%sUnit GC yields: %u\n", strempty(prefix), m->n_gc_unit_queue_yields);
+        fprintf(f, "%sCGroup attribute writes: %" PRIu64 " (%" PRIu64 " skipped as unchanged)\n",
+                strempty(prefix), m->cgroup_attribute_writes, m->cgroup_attribute_writes_skipped);
 }
 
 void manager_dump(Manager *m, FILE *f, char **patterns, const char *prefix) {
@@ -111,6 +169,45 @@ int manager_get_dump_string(Manager *m, char **patterns, char **ret) {
         return memstream_finalize(&ms, ret, NULL);
 }
 
+int manager_get_dump_fd(Manager *m, char **patterns) {
+        _cleanup_close_ int fd = -EBADF, copy = -EBADF;
+        _cleanup_fclose_ FILE *f = NULL;
+        int r;
+
+        assert(m);
+
+        /* Writes the dump directly into a sealed memfd, instead of formatting it into a string first and
+         * then copying that over. Dumps of systems with many units can be several megabytes in size. */
+
+        fd = memfd_new_full("dump", MFD_ALLOW_SEALING);
+        if (fd < 0)
+                return fd;
+
+        copy = fcntl(fd, F_DUPFD_CLOEXEC, 3);
+        if (copy < 0)
+                return -errno;
+
+        r = take_fdopen_unlocked(&copy, "w", &f);
+        if (r < 0)
+                return r;
+
+        manager_dump(m, f, patterns, NULL);
+
+        r = fflush_and_check(f);
+        if (r < 0)
+                return r;
+
+        /* The file offset is shared with the receiver, hence rewind before handing it out */
+        if (lseek(fd, 0, SEEK_SET) < 0)
+                return -errno;
+
+        r = memfd_set_sealed(fd);
+        if (r < 0)
+                return r;
+
+        return TAKE_FD(fd);
+}
+
 void manager_test_summary(Manager *m) {
         assert(m);
 
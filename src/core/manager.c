@@ -84,6 +84,7 @@
 #include "serialize.h"
 #include "signal-util.h"
 #include "socket-util.h"
+#include "sort-util.h"
 #include "special.h"
 #include "stat-util.h"
 #include "string-table.h"
@@ -119,6 +120,18 @@
 /* How many units and jobs to process of the bus queue before returning to the event loop. */
 #define MANAGER_BUS_MESSAGE_BUDGET 100U
 
+/* For how long to run jobs from the run queue before returning to the event loop. */
+#define MANAGER_RUN_QUEUE_TIME_SLICE_USEC (50*USEC_PER_MSEC)
+
+/* For how long to garbage collect units before returning to the event loop. */
+#define MANAGER_GC_UNIT_QUEUE_TIME_SLICE_USEC (20*USEC_PER_MSEC)
+
+/* How many notification messages to receive at once at most. */
+#define NOTIFY_MESSAGES_MAX 16U
+
+/* How many child processes to reap at most before returning to the event loop. */
+#define SIGCHLD_BATCH_MAX 64U
+
 #define DEFAULT_TASKS_MAX ((CGroupTasksMax) { 15U, 100U }) /* 15% */
 
 static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata);
@@ -760,6 +773,7 @@ static void manager_free_unit_name_maps(Manager *m) {
         m->unit_name_map = hashmap_free(m->unit_name_map);
         m->unit_path_cache = set_free(m->unit_path_cache);
         m->unit_cache_timestamp_hash = 0;
+        m->unit_cache_validated = false;
 }
 
 static int manager_setup_run_queue(Manager *m) {
@@ -1058,12 +1072,12 @@ int manager_new(RuntimeScope runtime_scope, ManagerTestRunFlags test_run_flags,
                 if (m->executor_fd < 0)
                         return log_debug_errno(m->executor_fd, "Failed to pin executor binary: %m");
 
-                if (DEBUG_LOGGING) {
-                        _cleanup_free_ char *executor_path = NULL;
+                /* Resolve the path once, it is passed as argv[0] to every executor we spawn */
+                r = fd_get_path(m->executor_fd, &m->executor_path);
+                if (r < 0)
+                        return log_debug_errno(r, "Failed to get path of pinned executor binary: %m");
 
-                        (void) fd_get_path(m->executor_fd, &executor_path);
-                        log_debug("Using systemd-executor binary from '%s'.", strna(executor_path));
-                }
+                log_debug("Using systemd-executor binary from '%s'.", m->executor_path);
         }
 
         /* Note that we do not set up the notify fd here. We do that after deserialization,
@@ -1415,6 +1429,15 @@ static void unit_gc_mark_good(Unit *u, unsigned gc_marker) {
                         unit_gc_mark_good(other, gc_marker);
 }
 
+static bool unit_gc_is_unreferenced(Unit *u) {
+        assert(u);
+
+        /* Returns true if nothing refers to this unit at all, in which case there's no point in walking the
+         * dependency graph to find out whether it can be collected. */
+
+        return !u->refs_by_target && !unit_has_dependency(u, UNIT_ATOM_REFERENCED_BY, NULL);
+}
+
 static void unit_gc_sweep(Unit *u, unsigned gc_marker) {
         Unit *other;
         bool is_bad;
@@ -1431,6 +1454,9 @@ static void unit_gc_sweep(Unit *u, unsigned gc_marker) {
         if (!unit_may_gc(u))
                 goto good;
 
+        if (unit_gc_is_unreferenced(u))
+                goto bad;
+
         u->gc_marker = gc_marker + GC_OFFSET_IN_PATH;
 
         is_bad = true;
@@ -1477,12 +1503,18 @@ good:
 
 static unsigned manager_dispatch_gc_unit_queue(Manager *m) {
         unsigned n = 0, gc_marker;
+        usec_t until;
         Unit *u;
 
         assert(m);
 
         /* log_debug("Running GC..."); */
 
+        /* Every unit taken off the queue is fully decided on within the current generation, hence we can
+         * stop at any point and continue with a new generation later. After mass exits of scopes in large
+         * slices sweeping may take a while, hence return to the event loop every now and then. */
+        until = usec_add(now(CLOCK_MONOTONIC), MANAGER_GC_UNIT_QUEUE_TIME_SLICE_USEC);
+
         m->gc_marker += _GC_OFFSET_MAX;
         if (m->gc_marker + _GC_OFFSET_MAX <= _GC_OFFSET_MAX)
                 m->gc_marker = 1;
@@ -1505,6 +1537,13 @@ static unsigned manager_dispatch_gc_unit_queue(Manager *m) {
                         u->gc_marker = gc_marker + GC_OFFSET_BAD;
                         unit_add_to_cleanup_queue(u);
                 }
+
+                if (m->gc_unit_queue && now(CLOCK_MONOTONIC) >= until) {
+                        log_debug("Unit GC time slice exhausted, continuing later.");
+                        m->gc_unit_queue_yielded = true;
+                        m->n_gc_unit_queue_yields++;
+                        break;
+                }
         }
 
         return n;
@@ -1775,6 +1814,7 @@ Manager* manager_free(Manager *m) {
         sd_event_source_unref(m->timezone_change_event_source);
         sd_event_source_unref(m->jobs_in_progress_event_source);
         sd_event_source_unref(m->run_queue_event_source);
+        sd_event_source_unref(m->dbus_queue_event_source);
         sd_event_source_unref(m->user_lookup_event_source);
         sd_event_source_unref(m->handoff_timestamp_event_source);
         sd_event_source_unref(m->pidref_event_source);
@@ -1782,6 +1822,7 @@ Manager* manager_free(Manager *m) {
 
         safe_close(m->signal_fd);
         safe_close(m->notify_fd);
+        notify_recv_buffer_free(m->notify_recv_buffer);
         safe_close(m->cgroups_agent_fd);
         safe_close_pair(m->user_lookup_fds);
         safe_close_pair(m->handoff_timestamp_fds);
@@ -1799,6 +1840,8 @@ Manager* manager_free(Manager *m) {
         strv_free(m->transient_environment);
         strv_free(m->client_environment);
 
+        exec_timing_free_many(m->generator_timings, m->n_generator_timings);
+
         hashmap_free(m->cgroup_unit);
         manager_free_unit_name_maps(m);
 
@@ -1832,8 +1875,10 @@ Manager* manager_free(Manager *m) {
 #if BPF_FRAMEWORK
         bpf_restrict_fs_destroy(m->restrict_fs);
 #endif
+        hashmap_free(m->bpf_device_programs);
 
         safe_close(m->executor_fd);
+        free(m->executor_path);
 
         return mfree(m);
 }
@@ -2178,6 +2223,8 @@ int manager_add_job_full(
                 Job **ret) {
 
         _cleanup_(transaction_abort_and_freep) Transaction *tr = NULL;
+        usec_t begin, built;
+        unsigned n_jobs;
         int r;
 
         assert(m);
@@ -2202,6 +2249,8 @@ int manager_add_job_full(
 
         type = job_type_collapse(type, unit);
 
+        begin = now(CLOCK_MONOTONIC);
+
         tr = transaction_new(mode == JOB_REPLACE_IRREVERSIBLY);
         if (!tr)
                 return -ENOMEM;
@@ -2232,13 +2281,19 @@ int manager_add_job_full(
                         return r;
         }
 
+        built = now(CLOCK_MONOTONIC);
+        n_jobs = hashmap_size(tr->jobs);
+
         r = transaction_activate(tr, m, mode, affected_jobs, error);
         if (r < 0)
                 return r;
 
         log_unit_debug(unit,
-                       "Enqueued job %s/%s as %u", unit->id,
-                       job_type_to_string(type), (unsigned) tr->anchor_job->id);
+                       "Enqueued job %s/%s as %u (transaction with %u units built in %s, activated in %s)",
+                       unit->id, job_type_to_string(type), (unsigned) tr->anchor_job->id,
+                       n_jobs,
+                       FORMAT_TIMESPAN(usec_sub_unsigned(built, begin), 1),
+                       FORMAT_TIMESPAN(usec_sub_unsigned(now(CLOCK_MONOTONIC), built), 1));
 
         if (ret)
                 *ret = tr->anchor_job;
@@ -2380,6 +2435,7 @@ unsigned manager_dispatch_load_queue(Manager *m) {
         }
 
         m->dispatching_load_queue = false;
+        m->unit_cache_validated = false;
 
         /* Dispatch the units waiting for their target dependencies to be added now, as all targets that we know about
          * should be loaded and have aliases resolved */
@@ -2406,6 +2462,37 @@ bool manager_unit_cache_should_retry_load(Unit *u) {
         return !lookup_paths_timestamp_hash_same(&u->manager->lookup_paths, u->manager->unit_cache_timestamp_hash, NULL);
 }
 
+int manager_unit_file_exists(Manager *m, const char *name) {
+        _cleanup_free_ char *template = NULL;
+        int r;
+
+        assert(m);
+        assert(name);
+
+        /* Returns whether there is anything on disk for the specified unit name, i.e. a fragment, an alias
+         * or a mask, either for the name itself or for its template. */
+
+        r = unit_file_build_name_map(&m->lookup_paths,
+                                     &m->unit_cache_timestamp_hash,
+                                     &m->unit_id_map,
+                                     &m->unit_name_map,
+                                     &m->unit_path_cache);
+        if (r < 0)
+                return r;
+
+        if (hashmap_contains(m->unit_id_map, name))
+                return true;
+
+        if (!unit_name_is_valid(name, UNIT_NAME_INSTANCE))
+                return false;
+
+        r = unit_name_template(name, &template);
+        if (r < 0)
+                return r;
+
+        return hashmap_contains(m->unit_id_map, template);
+}
+
 int manager_load_unit_prepare(
                 Manager *m,
                 const char *name,
@@ -2563,15 +2650,32 @@ void manager_unwatch_pidref(Manager *m, const PidRef *pid) {
 
 static int manager_dispatch_run_queue(sd_event_source *source, void *userdata) {
         Manager *m = ASSERT_PTR(userdata);
+        usec_t until;
         Job *j;
 
         assert(source);
 
+        /* The run queue is the least important of our event sources, hence it is only dispatched when
+         * nothing else is pending. But once it runs, events that come in meanwhile (e.g. SIGCHLD, D-Bus
+         * requests, or notification messages) are not looked at until it is done. Hence, if a burst of
+         * jobs takes long to run (e.g. thousands of device or mount jobs during a hotplug storm), return
+         * to the event loop every now and then and continue with the remaining jobs afterwards. Jobs are
+         * still run in the order of their priority. */
+        until = usec_add(now(CLOCK_MONOTONIC), MANAGER_RUN_QUEUE_TIME_SLICE_USEC);
+
         while ((j = prioq_peek(m->run_queue))) {
                 assert(j->installed);
                 assert(j->in_run_queue);
 
                 (void) job_run_and_invalidate(j);
+
+                if (!prioq_isempty(m->run_queue) && now(CLOCK_MONOTONIC) >= until) {
+                        log_debug("Job run queue time slice exhausted with %u jobs left, continuing later.",
+                                  prioq_size(m->run_queue));
+                        m->n_run_queue_yields++;
+                        manager_trigger_run_queue(m);
+                        break;
+                }
         }
 
         if (m->n_running_jobs > 0)
@@ -2595,6 +2699,45 @@ void manager_trigger_run_queue(Manager *m) {
                 log_warning_errno(r, "Failed to enable job run queue event source, ignoring: %m");
 }
 
+static int manager_dispatch_dbus_queue_timer(sd_event_source *source, usec_t usec, void *userdata) {
+        /* Nothing to do here, this only wakes up the event loop, which then dispatches the D-Bus queues. */
+        return 0;
+}
+
+static bool manager_hold_dbus_queue(Manager *m) {
+        usec_t n, until;
+        int r;
+
+        assert(m);
+
+        /* With ChangeSignalCoalesceSec= set, change signals are held back for a while once the D-Bus queues
+         * become non-empty, so that units and jobs that change multiple times in quick succession (e.g.
+         * during isolate, or when many scopes exit at once) result in one signal only. Both queues are held
+         * back together, so that the order of unit and job signals is the same as without coalescing. */
+
+        if (m->change_signal_coalesce_usec <= 0)
+                return false;
+
+        n = now(CLOCK_MONOTONIC);
+        if (m->dbus_queue_since <= 0)
+                m->dbus_queue_since = n;
+
+        until = usec_add(m->dbus_queue_since, m->change_signal_coalesce_usec);
+        if (n >= until)
+                return false;
+
+        r = event_reset_time(m->event, &m->dbus_queue_event_source,
+                             CLOCK_MONOTONIC, until, 0,
+                             manager_dispatch_dbus_queue_timer, m,
+                             0, "manager-dbus-queue", /* force_reset= */ false);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to arm D-Bus queue timer, not coalescing change signals: %m");
+                return false;
+        }
+
+        return true;
+}
+
 static unsigned manager_dispatch_dbus_queue(Manager *m) {
         unsigned n = 0, budget;
         Unit *u;
@@ -2608,14 +2751,19 @@ static unsigned manager_dispatch_dbus_queue(Manager *m) {
                 budget = UINT_MAX; /* infinite budget in this case */
         else {
                 /* Anything to do at all? */
-                if (!m->dbus_unit_queue && !m->dbus_job_queue)
+                if (!m->dbus_unit_queue && !m->dbus_job_queue) {
+                        m->dbus_queue_since = 0;
                         return 0;
+                }
 
                 /* Do we have overly many messages queued at the moment? If so, let's not enqueue more on top, let's
                  * sit this cycle out, and process things in a later cycle when the queues got a bit emptier. */
                 if (manager_bus_n_queued_write(m) > MANAGER_BUS_BUSY_THRESHOLD)
                         return 0;
 
+                if (manager_hold_dbus_queue(m))
+                        return 0;
+
                 /* Only process a certain number of units/jobs per event loop iteration. Even if the bus queue wasn't
                  * overly full before this call we shouldn't increase it in size too wildly in one step, and we
                  * shouldn't monopolize CPU time with generating these messages. Note the difference in counting of
@@ -2651,6 +2799,9 @@ static unsigned manager_dispatch_dbus_queue(Manager *m) {
                         budget--;
         }
 
+        if (!m->dbus_unit_queue && !m->dbus_job_queue)
+                m->dbus_queue_since = 0;
+
         if (m->send_reloading_done) {
                 m->send_reloading_done = false;
                 bus_manager_send_reloading(m, false);
@@ -2794,35 +2945,14 @@ static int manager_get_units_for_pidref(Manager *m, const PidRef *pidref, Unit *
         return (int) n;
 }
 
-static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata) {
-        Manager *m = ASSERT_PTR(userdata);
-        _cleanup_(pidref_done) PidRef pidref = PIDREF_NULL;
-        struct ucred ucred;
-        _cleanup_(fdset_free_asyncp) FDSet *fds = NULL;
-        int r;
-
-        assert(m->notify_fd == fd);
-
-        if (revents != EPOLLIN) {
-                log_warning("Got unexpected poll event for notify fd.");
-                return 0;
-        }
-
-        _cleanup_strv_free_ char **tags = NULL;
-        r = notify_recv_with_fds_strv(m->notify_fd, &tags, &ucred, &pidref, &fds);
-        if (r == -EAGAIN)
-                return 0;
-        if (r < 0)
-                /* If this is any other, real error, then stop processing this socket. This of course means
-                 * we won't take notification messages anymore, but that's still better than busy looping:
-                 * being woken up over and over again, but being unable to actually read the message from the
-                 * socket. */
-                return r;
+static void manager_process_notify_message(Manager *m, NotifyMessage *msg) {
+        assert(m);
+        assert(msg);
 
         /* Possibly a barrier fd, let's see. */
-        if (manager_process_barrier_fd(tags, fds)) {
-                log_debug("Received barrier notification message from PID " PID_FMT ".", pidref.pid);
-                return 0;
+        if (manager_process_barrier_fd(msg->tags, msg->fds)) {
+                log_debug("Received barrier notification message from PID " PID_FMT ".", msg->pidref.pid);
+                return;
         }
 
         /* Increase the generation counter used for filtering out duplicate unit invocations. */
@@ -2831,21 +2961,53 @@ static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t
         /* Notify every unit that might be interested, which might be multiple. */
         _cleanup_free_ Unit **array = NULL;
 
-        int n_array = manager_get_units_for_pidref(m, &pidref, &array);
+        int n_array = manager_get_units_for_pidref(m, &msg->pidref, &array);
         if (n_array < 0) {
-                log_warning_errno(n_array, "Failed to determine units for PID " PID_FMT ", ignoring: %m", pidref.pid);
-                return 0;
+                log_warning_errno(n_array, "Failed to determine units for PID " PID_FMT ", ignoring: %m", msg->pidref.pid);
+                return;
         }
         if (n_array == 0)
-                log_debug("Cannot find unit for notify message of PID "PID_FMT", ignoring.", pidref.pid);
+                log_debug("Cannot find unit for notify message of PID "PID_FMT", ignoring.", msg->pidref.pid);
         else
                 /* And now invoke the per-unit callbacks. Note that manager_invoke_notify_message() will handle
                  * duplicate units – making sure we only invoke each unit's handler once. */
                 FOREACH_ARRAY(u, array, n_array)
-                        manager_invoke_notify_message(m, *u, &pidref, &ucred, tags, fds);
+                        manager_invoke_notify_message(m, *u, &msg->pidref, &msg->ucred, msg->tags, msg->fds);
 
-        if (!fdset_isempty(fds))
+        if (!fdset_isempty(msg->fds))
                 log_warning("Got extra auxiliary fds with notification message, closing them.");
+}
+
+static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata) {
+        NotifyMessage messages[NOTIFY_MESSAGES_MAX];
+        Manager *m = ASSERT_PTR(userdata);
+        int n;
+
+        assert(m->notify_fd == fd);
+
+        if (revents != EPOLLIN) {
+                log_warning("Got unexpected poll event for notify fd.");
+                return 0;
+        }
+
+        /* Services with watchdogs or frequent status updates keep this socket busy, hence pick up whatever
+         * is queued in one go, instead of taking a trip through the event loop for each message. The
+         * messages are still processed in order. Any resulting D-Bus PropertiesChanged signals are
+         * deferred via the D-Bus queue anyway, and hence only sent once per unit. */
+        n = notify_recv_many_with_fds_strv(m->notify_fd, &m->notify_recv_buffer, messages, ELEMENTSOF(messages));
+        if (n == -EAGAIN)
+                return 0;
+        if (n < 0)
+                /* If this is any other, real error, then stop processing this socket. This of course means
+                 * we won't take notification messages anymore, but that's still better than busy looping:
+                 * being woken up over and over again, but being unable to actually read the message from the
+                 * socket. */
+                return n;
+
+        for (int i = 0; i < n; i++) {
+                manager_process_notify_message(m, messages + i);
+                notify_message_done(messages + i);
+        }
 
         return 0;
 }
@@ -2871,12 +3033,12 @@ static void manager_invoke_sigchld_event(
                 UNIT_VTABLE(u)->sigchld_event(u, si->si_pid, si->si_code, si->si_status);
 }
 
-static int manager_dispatch_sigchld(sd_event_source *source, void *userdata) {
-        Manager *m = ASSERT_PTR(userdata);
+static int manager_reap_child(Manager *m) {
         siginfo_t si = {};
-        int r;
 
-        assert(source);
+        assert(m);
+
+        /* Processes and reaps a single child. Returns > 0 if one was reaped, 0 if there are none left. */
 
         /* First we call waitid() for a PID and do not reap the zombie. That way we can still access
          * /proc/$PID for it while it is a zombie. */
@@ -2886,23 +3048,25 @@ static int manager_dispatch_sigchld(sd_event_source *source, void *userdata) {
                 if (errno != ECHILD)
                         log_error_errno(errno, "Failed to peek for child with waitid(), ignoring: %m");
 
-                goto turn_off;
+                return 0;
         }
 
         if (si.si_pid <= 0)
-                goto turn_off;
+                return 0;
 
         if (SIGINFO_CODE_IS_DEAD(si.si_code)) {
-                _cleanup_free_ char *name = NULL;
-                (void) pid_get_comm(si.si_pid, &name);
-
-                log_debug("Child "PID_FMT" (%s) died (code=%s, status=%i/%s)",
-                          si.si_pid, strna(name),
-                          sigchld_code_to_string(si.si_code),
-                          si.si_status,
-                          strna(si.si_code == CLD_EXITED
-                                ? exit_status_to_string(si.si_status, EXIT_STATUS_FULL)
-                                : signal_to_string(si.si_status)));
+                if (DEBUG_LOGGING) {
+                        _cleanup_free_ char *name = NULL;
+                        (void) pid_get_comm(si.si_pid, &name);
+
+                        log_debug("Child "PID_FMT" (%s) died (code=%s, status=%i/%s)",
+                                  si.si_pid, strna(name),
+                                  sigchld_code_to_string(si.si_code),
+                                  si.si_status,
+                                  strna(si.si_code == CLD_EXITED
+                                        ? exit_status_to_string(si.si_status, EXIT_STATUS_FULL)
+                                        : signal_to_string(si.si_status)));
+                }
 
                 /* Increase the generation counter used for filtering out duplicate unit invocations */
                 m->sigchldgen++;
@@ -2935,9 +3099,28 @@ static int manager_dispatch_sigchld(sd_event_source *source, void *userdata) {
         }
 
         /* And now, we actually reap the zombie. */
-        if (waitid(P_PID, si.si_pid, &si, WEXITED) < 0) {
+        if (waitid(P_PID, si.si_pid, &si, WEXITED) < 0)
                 log_error_errno(errno, "Failed to dequeue child, ignoring: %m");
-                return 0;
+
+        return 1;
+}
+
+static int manager_dispatch_sigchld(sd_event_source *source, void *userdata) {
+        Manager *m = ASSERT_PTR(userdata);
+        int r;
+
+        assert(source);
+
+        /* When many processes exit at once (e.g. when a slice with lots of workers is stopped), taking a
+         * trip through the event loop for each of them is slow. Hence process a bounded batch of children
+         * per iteration, and stay enabled if there are more, so that other event sources still get their
+         * turn in between. */
+
+        for (unsigned i = 0; i < SIGCHLD_BATCH_MAX; i++) {
+                if (manager_reap_child(m) <= 0)
+                        goto turn_off;
+
+                m->n_sigchld_reaped++;
         }
 
         return 0;
@@ -2945,6 +3128,14 @@ static int manager_dispatch_sigchld(sd_event_source *source, void *userdata) {
 turn_off:
         /* All children processed for now, turn off event source */
 
+        if (m->sigchld_timestamp > 0 && m->n_sigchld_reaped > 0)
+                log_debug("Reaped %u child processes, finished %s after SIGCHLD was received.",
+                          m->n_sigchld_reaped,
+                          FORMAT_TIMESPAN(usec_sub_unsigned(now(CLOCK_MONOTONIC), m->sigchld_timestamp), USEC_PER_MSEC));
+
+        m->sigchld_timestamp = 0;
+        m->n_sigchld_reaped = 0;
+
         r = sd_event_source_set_enabled(m->sigchld_event_source, SD_EVENT_OFF);
         if (r < 0)
                 return log_error_errno(r, "Failed to disable SIGCHLD event source: %m");
@@ -3015,6 +3206,10 @@ static int manager_dispatch_signal_fd(sd_event_source *source, int fd, uint32_t
         switch (sfsi.ssi_signo) {
 
         case SIGCHLD:
+                /* Remember when we learnt about the first exited child, to report how long reaping took */
+                if (m->sigchld_timestamp <= 0)
+                        m->sigchld_timestamp = now(CLOCK_MONOTONIC);
+
                 r = sd_event_source_set_enabled(m->sigchld_event_source, SD_EVENT_ON);
                 if (r < 0)
                         log_warning_errno(r, "Failed to enable SIGCHLD event source, ignoring: %m");
@@ -3339,7 +3534,7 @@ int manager_loop(Manager *m) {
                 if (manager_dispatch_gc_job_queue(m) > 0)
                         continue;
 
-                if (manager_dispatch_gc_unit_queue(m) > 0)
+                if (!m->gc_unit_queue_yielded && manager_dispatch_gc_unit_queue(m) > 0)
                         continue;
 
                 if (manager_dispatch_cleanup_queue(m) > 0)
@@ -3363,10 +3558,13 @@ int manager_loop(Manager *m) {
                 if (manager_dispatch_dbus_queue(m) > 0)
                         continue;
 
-                /* Sleep for watchdog runtime wait time */
-                r = sd_event_run(m->event, watchdog_runtime_wait());
+                /* Sleep for watchdog runtime wait time, unless the unit GC is still busy, in which case we
+                 * only process what is pending and continue with it right after. */
+                r = sd_event_run(m->event, m->gc_unit_queue_yielded ? 0 : watchdog_runtime_wait());
                 if (r < 0)
                         return log_error_errno(r, "Failed to run event loop: %m");
+
+                m->gc_unit_queue_yielded = false;
         }
 
         return m->objective;
@@ -3724,6 +3922,167 @@ int manager_reload(Manager *m) {
         return 0;
 }
 
+typedef struct UnitEdge {
+        Unit *other;
+        UnitDependency dependency;
+        UnitDependencyMask mask;
+} UnitEdge;
+
+static bool unit_can_replace(Unit *u) {
+        int r;
+
+        assert(u);
+
+        /* Only units that nothing but dependencies point to, and that have no runtime state worth keeping,
+         * can be dropped and loaded afresh. Everything else requires a full reload, which carries the
+         * runtime state over via serialization. */
+
+        if (u->transient || u->perpetual)
+                return false;
+
+        if (u->job || u->nop_job)
+                return false;
+
+        if (u->refs_by_target)
+                return false;
+
+        if (sd_bus_track_count(u->bus_track) > 0)
+                return false;
+
+        if (unit_active_state(u) != UNIT_INACTIVE)
+                return false;
+
+        r = unit_cgroup_is_empty(u);
+        if (r <= 0 && !IN_SET(r, -ENXIO, -EOWNERDEAD))
+                return false;
+
+        if (UNIT_VTABLE(u)->may_gc && !UNIT_VTABLE(u)->may_gc(u))
+                return false;
+
+        return true;
+}
+
+static int unit_collect_incoming_edges(Unit *u, UnitEdge **ret, size_t *ret_n) {
+        _cleanup_free_ UnitEdge *edges = NULL;
+        size_t n = 0;
+        Hashmap *deps;
+        void *dt;
+
+        assert(u);
+        assert(ret);
+        assert(ret_n);
+
+        /* Collects the dependencies other units have on this unit, i.e. everything that is not derived
+         * from the unit's own configuration and hence would be lost when the unit is freed. */
+
+        HASHMAP_FOREACH_KEY(deps, dt, u->dependencies) {
+                UnitDependencyInfo di;
+                Unit *other;
+
+                HASHMAP_FOREACH_KEY(di.data, other, deps) {
+                        Hashmap *other_deps;
+                        void *other_dt;
+
+                        if (di.destination_mask == 0)
+                                continue;
+
+                        HASHMAP_FOREACH_KEY(other_deps, other_dt, other->dependencies) {
+                                UnitDependencyInfo other_di;
+
+                                other_di.data = hashmap_get(other_deps, u);
+                                if (other_di.origin_mask == 0)
+                                        continue;
+
+                                if (!GREEDY_REALLOC(edges, n + 1))
+                                        return -ENOMEM;
+
+                                edges[n++] = (UnitEdge) {
+                                        .other = other,
+                                        .dependency = UNIT_DEPENDENCY_FROM_PTR(other_dt),
+                                        .mask = other_di.origin_mask,
+                                };
+                        }
+                }
+        }
+
+        *ret = TAKE_PTR(edges);
+        *ret_n = n;
+        return 0;
+}
+
+int manager_reload_changed(Manager *m) {
+        _cleanup_strv_free_ char **changed = NULL;
+        const char *k;
+        Unit *u;
+        int r, n = 0;
+
+        assert(m);
+
+        /* A lightweight alternative to manager_reload(): only units whose fragment, source file or drop-ins
+         * changed on disk are loaded again. Since such a unit is replaced by a new object, this is only
+         * possible for units that are inactive and not referenced by anything but other units'
+         * dependencies, which are restored afterwards. Generators are not rerun, and the unit file state
+         * (i.e. enablement symlinks) is not reconsidered. Returns -EBUSY if a full reload is required. */
+
+        if (m->unit_file_state_outdated)
+                return log_debug_errno(SYNTHETIC_ERRNO(EBUSY),
+                                       "Unit file state is outdated, full reload required.");
+
+        HASHMAP_FOREACH_KEY(u, k, m->units) {
+                /* Skip aliases */
+                if (!streq(k, u->id))
+                        continue;
+
+                /* Units that were not found are already retried on their own, see
+                 * manager_unit_cache_should_retry_load(). */
+                if (!IN_SET(u->load_state, UNIT_LOADED, UNIT_BAD_SETTING, UNIT_ERROR, UNIT_MASKED))
+                        continue;
+
+                if (!unit_files_changed(u))
+                        continue;
+
+                if (!unit_can_replace(u))
+                        return log_unit_debug_errno(u, SYNTHETIC_ERRNO(EBUSY),
+                                                    "Unit files changed but unit is in use, full reload required.");
+
+                r = strv_extend(&changed, u->id);
+                if (r < 0)
+                        return r;
+        }
+
+        STRV_FOREACH(id, changed) {
+                _cleanup_free_ UnitEdge *edges = NULL;
+                size_t n_edges = 0;
+
+                u = manager_get_unit(m, *id);
+                if (!u)
+                        continue;
+
+                r = unit_collect_incoming_edges(u, &edges, &n_edges);
+                if (r < 0)
+                        return r;
+
+                log_unit_debug(u, "Unit files changed, reloading unit.");
+                unit_free(u);
+
+                r = manager_load_unit(m, *id, /* path = */ NULL, /* e = */ NULL, &u);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to reload unit %s: %m", *id);
+
+                FOREACH_ARRAY(e, edges, n_edges) {
+                        r = unit_add_dependency(e->other, e->dependency, u, /* add_reference = */ false, e->mask);
+                        if (r < 0)
+                                log_unit_warning_errno(e->other, r, "Failed to restore dependency %s=%s, ignoring: %m",
+                                                       unit_dependency_to_string(e->dependency), u->id);
+                }
+
+                n++;
+        }
+
+        log_debug("Reloaded %i changed units.", n);
+        return n;
+}
+
 void manager_reset_failed(Manager *m) {
         Unit *u;
 
@@ -4094,7 +4453,7 @@ static int build_generator_environment(Manager *m, char ***ret) {
         return 0;
 }
 
-static int manager_execute_generators(Manager *m, char * const *paths, bool remount_ro) {
+static int manager_execute_generators(Manager *m, char * const *paths, bool remount_ro, int timing_fd) {
         _cleanup_strv_free_ char **ge = NULL;
         int r;
 
@@ -4125,18 +4484,57 @@ static int manager_execute_generators(Manager *m, char * const *paths, bool remo
         };
 
         BLOCK_WITH_UMASK(0022);
-        return execute_directories(
+        return execute_directories_full(
                         (const char* const*) paths,
                         DEFAULT_TIMEOUT_USEC,
                         /* callbacks= */ NULL, /* callback_args= */ NULL,
                         (char**) argv,
                         ge,
-                        EXEC_DIR_PARALLEL | EXEC_DIR_IGNORE_ERRORS | EXEC_DIR_SET_SYSTEMD_EXEC_PID | EXEC_DIR_WARN_WORLD_WRITABLE);
+                        EXEC_DIR_PARALLEL | EXEC_DIR_IGNORE_ERRORS | EXEC_DIR_SET_SYSTEMD_EXEC_PID | EXEC_DIR_WARN_WORLD_WRITABLE,
+                        m->generator_parallelism,
+                        timing_fd);
+}
+
+static int exec_timing_compare(const ExecTiming *a, const ExecTiming *b) {
+        return -CMP(a->duration, b->duration);
+}
+
+static void manager_update_generator_timings(Manager *m, int timing_fd) {
+        ExecTiming *t = NULL;
+        size_t n = 0;
+        int r;
+
+        assert(m);
+
+        /* Takes ownership of the fd */
+
+        if (timing_fd < 0)
+                return;
+
+        r = finish_serialization_fd(timing_fd);
+        if (r < 0) {
+                safe_close(timing_fd);
+                return (void) log_debug_errno(r, "Failed to rewind generator timing file, ignoring: %m");
+        }
+
+        r = exec_timing_read(timing_fd, &t, &n);
+        if (r < 0)
+                return (void) log_debug_errno(r, "Failed to read generator timings, ignoring: %m");
+
+        typesafe_qsort(t, n, exec_timing_compare);
+
+        if (n > 0)
+                log_debug("Slowest generator was %s, taking %s.", t[0].path, FORMAT_TIMESPAN(t[0].duration, USEC_PER_MSEC));
+
+        exec_timing_free_many(m->generator_timings, m->n_generator_timings);
+        m->generator_timings = t;
+        m->n_generator_timings = n;
 }
 
 static int manager_run_generators(Manager *m) {
         ForkFlags flags = FORK_RESET_SIGNALS | FORK_WAIT | FORK_NEW_MOUNTNS | FORK_MOUNTNS_SLAVE;
         _cleanup_strv_free_ char **paths = NULL;
+        _cleanup_close_ int timing_fd = -EBADF;
         int r;
 
         assert(m);
@@ -4157,12 +4555,18 @@ static int manager_run_generators(Manager *m) {
                 goto finish;
         }
 
+        /* The executor records how long each generator took in here, which is inherited through the
+         * sandboxing process below */
+        timing_fd = open_serialization_fd("generator-timings");
+        if (timing_fd < 0)
+                log_debug_errno(timing_fd, "Failed to open generator timing file, not recording generator timings: %m");
+
         /* If we are the system manager, we fork and invoke the generators in a sanitized mount namespace. If
          * we are the user manager, let's just execute the generators directly. We might not have the
          * necessary privileges, and the system manager has already mounted /tmp/ and everything else for us.
          */
         if (MANAGER_IS_USER(m)) {
-                r = manager_execute_generators(m, paths, /* remount_ro= */ false);
+                r = manager_execute_generators(m, paths, /* remount_ro= */ false, timing_fd);
                 goto finish;
         }
 
@@ -4173,7 +4577,7 @@ static int manager_run_generators(Manager *m) {
 
         r = safe_fork("(sd-gens)", flags, NULL);
         if (r == 0) {
-                r = manager_execute_generators(m, paths, /* remount_ro= */ true);
+                r = manager_execute_generators(m, paths, /* remount_ro= */ true, timing_fd);
                 _exit(r >= 0 ? EXIT_SUCCESS : EXIT_FAILURE);
         }
         if (r < 0) {
@@ -4194,10 +4598,11 @@ static int manager_run_generators(Manager *m) {
                 log_debug_errno(r,
                                 "Failed to fork off sandboxing environment for executing generators. "
                                 "Falling back to execute generators without sandboxing: %m");
-                r = manager_execute_generators(m, paths, /* remount_ro= */ false);
+                r = manager_execute_generators(m, paths, /* remount_ro= */ false, timing_fd);
         }
 
 finish:
+        manager_update_generator_timings(m, TAKE_FD(timing_fd));
         lookup_paths_trim_generator(&m->lookup_paths);
         return r;
 }
@@ -15,6 +15,8 @@
 #include "fdset.h"
 #include "hashmap.h"
 #include "list.h"
+#include "metrics.h"
+#include "notify-recv.h"
 #include "prioq.h"
 #include "ratelimit.h"
 
@@ -135,6 +137,7 @@ typedef enum WatchdogType {
         _WATCHDOG_TYPE_MAX,
 } WatchdogType;
 
+#include "exec-util.h"
 #include "execute.h"
 #include "job.h"
 #include "path-lookup.h"
@@ -206,6 +209,8 @@ struct Manager {
 
         /* Jobs that need to be run */
         struct Prioq *run_queue;
+        /* How often dispatching the job run queue was interrupted to let other events be processed */
+        unsigned n_run_queue_yields;
 
         /* Units and jobs that have not yet been announced via
          * D-Bus. When something about a job changes it is added here
@@ -214,12 +219,26 @@ struct Manager {
         LIST_HEAD(Unit, dbus_unit_queue);
         LIST_HEAD(Job, dbus_job_queue);
 
+        /* For how long to hold back change signals at most so that they can be coalesced, when the D-Bus
+         * queues became non-empty, and how many change signals were coalesced so far */
+        usec_t change_signal_coalesce_usec;
+        usec_t dbus_queue_since;
+        sd_event_source *dbus_queue_event_source;
+        uint64_t n_change_signals_coalesced;
+
+        /* For how long accounting counters served to clients may be reused before reading them again */
+        usec_t accounting_max_age_usec;
+
         /* Units to remove */
         LIST_HEAD(Unit, cleanup_queue);
 
         /* Units and jobs to check when doing GC */
         LIST_HEAD(Unit, gc_unit_queue);
         LIST_HEAD(Job, gc_job_queue);
+        /* Set when the unit GC ran out of its time slice, so that events are processed before it continues */
+        bool gc_unit_queue_yielded;
+        /* How often that happened */
+        unsigned n_gc_unit_queue_yields;
 
         /* Units that should be realized */
         LIST_HEAD(Unit, cgroup_realize_queue);
@@ -268,6 +287,7 @@ struct Manager {
         char *notify_socket;
         int notify_fd;
         sd_event_source *notify_event_source;
+        NotifyRecvBuffer *notify_recv_buffer;
 
         int cgroups_agent_fd;
         sd_event_source *cgroups_agent_event_source;
@@ -276,6 +296,9 @@ struct Manager {
         sd_event_source *signal_event_source;
 
         sd_event_source *sigchld_event_source;
+        /* When SIGCHLD was received for the children currently being reaped, and how many were reaped */
+        usec_t sigchld_timestamp;
+        unsigned n_sigchld_reaped;
 
         sd_event_source *time_change_event_source;
 
@@ -299,6 +322,9 @@ struct Manager {
         Hashmap *unit_name_map;
         Set *unit_path_cache;
         uint64_t unit_cache_timestamp_hash;
+        /* Set once the cache above has been validated while dispatching the load queue, so that this isn't
+         * redone (which means a stat() on each search path) for each unit loaded in the same go */
+        bool unit_cache_validated;
 
         /* We don't have support for atomically enabling/disabling units, and unit_file_state might become
          * outdated if such operations failed half-way. Therefore, we set this flag if changes to unit files
@@ -364,6 +390,10 @@ struct Manager {
         CGroupMask cgroup_supported;
         char *cgroup_root;
 
+        /* Number of cgroup attribute writes done, and skipped since the value was unchanged */
+        uint64_t cgroup_attribute_writes;
+        uint64_t cgroup_attribute_writes_skipped;
+
         /* Notifications from cgroups, when the unified hierarchy is used is done via inotify. */
         int cgroup_inotify_fd;
         sd_event_source *cgroup_inotify_event_source;
@@ -432,6 +462,8 @@ struct Manager {
 
         unsigned n_installed_jobs;
         unsigned n_failed_jobs;
+        /* How long jobs were running until they finished, in ms */
+        MetricHistogram job_run_time_histogram;
 
         /* Jobs in progress watching */
         unsigned n_running_jobs;
@@ -501,8 +533,18 @@ struct Manager {
         /* Reference to RestrictFileSystems= BPF program */
         struct restrict_fs_bpf *restrict_fs;
 
+        /* Device control BPF programs loaded so far, for sharing them between cgroups with identical
+         * policies: SHA256 of the program code (hex) → kernel program ID and tag */
+        Hashmap *bpf_device_programs;
+
         /* Allow users to configure a rate limit for Reload()/Reexecute() operations */
         RateLimit reload_reexec_ratelimit;
+
+        /* The maximum number of generators to run concurrently, 0 for no limit, and how long each of them
+         * took on the last run, sorted by duration (slowest first) */
+        unsigned generator_parallelism;
+        ExecTiming *generator_timings;
+        size_t n_generator_timings;
         /* Dump*() are slow, so always rate limit them to 10 per 10 minutes */
         RateLimit dump_ratelimit;
 
@@ -514,6 +556,7 @@ struct Manager {
         /* Pin the systemd-executor binary, so that it never changes until re-exec, ensuring we don't have
          * serialization/deserialization compatibility issues during upgrades. */
         int executor_fd;
+        char *executor_path;
 
         unsigned soft_reboots_count;
 
@@ -556,6 +599,7 @@ Unit *manager_get_unit(Manager *m, const char *name);
 int manager_get_job_from_dbus_path(Manager *m, const char *s, Job **_j);
 
 bool manager_unit_cache_should_retry_load(Unit *u);
+int manager_unit_file_exists(Manager *m, const char *name);
 int manager_load_unit_prepare(Manager *m, const char *name, const char *path, sd_bus_error *e, Unit **ret);
 int manager_load_unit(Manager *m, const char *name, const char *path, sd_bus_error *e, Unit **ret);
 int manager_load_startable_unit_or_warn(Manager *m, const char *name, const char *path, Unit **ret);
@@ -603,6 +647,7 @@ void manager_trigger_run_queue(Manager *m);
 int manager_loop(Manager *m);
 
 int manager_reload(Manager *m);
+int manager_reload_changed(Manager *m);
 Manager* manager_reloading_start(Manager *m);
 void manager_reloading_stopp(Manager **m);
 
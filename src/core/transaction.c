@@ -275,38 +275,40 @@ static int transaction_merge_jobs(Transaction *tr, sd_bus_error *e) {
 }
 
 static void transaction_drop_redundant(Transaction *tr) {
-        bool again;
+        Job *j;
 
         /* Goes through the transaction and removes all jobs of the units whose jobs are all noops. If not
-         * all of a unit's jobs are redundant, they are kept. */
+         * all of a unit's jobs are redundant, they are kept.
+         *
+         * Whether a job is redundant only depends on the job itself and the state of its unit, not on any
+         * other job in the transaction, hence a single pass is enough. Deleting a job without its
+         * dependencies only ever touches the hashmap entry of its own unit, so we can continue iterating
+         * afterwards, instead of starting from the beginning for each dropped job, which is quadratic for
+         * large transactions. */
 
         assert(tr);
 
-        do {
-                Job *j;
-
-                again = false;
-
-                HASHMAP_FOREACH(j, tr->jobs) {
-                        bool keep = false;
-
-                        LIST_FOREACH(transaction, k, j)
-                                if (tr->anchor_job == k ||
-                                    !job_type_is_redundant(k->type, unit_active_state(k->unit)) ||
-                                    (k->unit->job && job_type_is_conflicting(k->type, k->unit->job->type))) {
-                                        keep = true;
-                                        break;
-                                }
+        HASHMAP_FOREACH(j, tr->jobs) {
+                Unit *u = j->unit;
+                bool keep = false;
 
-                        if (!keep) {
-                                log_trace("Found redundant job %s/%s, dropping from transaction.",
-                                          j->unit->id, job_type_to_string(j->type));
-                                transaction_delete_job(tr, j, false);
-                                again = true;
+                LIST_FOREACH(transaction, k, j)
+                        if (tr->anchor_job == k ||
+                            !job_type_is_redundant(k->type, unit_active_state(k->unit)) ||
+                            (k->unit->job && job_type_is_conflicting(k->type, k->unit->job->type))) {
+                                keep = true;
                                 break;
                         }
+
+                if (keep)
+                        continue;
+
+                for (Job *k; (k = hashmap_get(tr->jobs, u));) {
+                        log_trace("Found redundant job %s/%s, dropping from transaction.",
+                                  k->unit->id, job_type_to_string(k->type));
+                        transaction_delete_job(tr, k, false);
                 }
-        } while (again);
+        }
 }
 
 static bool job_matters_to_anchor(Job *job) {
@@ -507,7 +509,9 @@ static void transaction_collect_garbage(Transaction *tr) {
 
         assert(tr);
 
-        /* Drop jobs that are not required by any other job */
+        /* Drop jobs that are not required by any other job. Deleting a job that nothing depends on only
+         * drops its own hashmap entry, hence we can continue iterating. But it might leave other jobs
+         * without anything requiring them, which we then pick up in the next pass. */
 
         do {
                 Job *j;
@@ -522,7 +526,7 @@ static void transaction_collect_garbage(Transaction *tr) {
                                 log_trace("Garbage collecting job %s/%s", j->unit->id, job_type_to_string(j->type));
                                 transaction_delete_job(tr, j, true);
                                 again = true;
-                                break;
+                                continue;
                         }
 
                         log_trace("Keeping job %s/%s because of %s/%s",
@@ -650,7 +654,7 @@ static int transaction_apply(
                 assert(!j->transaction_prev);
                 assert(!j->transaction_next);
 
-                r = hashmap_ensure_put(&m->jobs, NULL, UINT32_TO_PTR(j->id), j);
+                r = hashmap_ensure_put(&m->jobs, &trusted_trivial_hash_ops, UINT32_TO_PTR(j->id), j);
                 if (r < 0)
                         goto rollback;
         }
@@ -1230,7 +1234,7 @@ Transaction *transaction_new(bool irreversible) {
         if (!tr)
                 return NULL;
 
-        tr->jobs = hashmap_new(NULL);
+        tr->jobs = hashmap_new(&trusted_trivial_hash_ops);
         if (!tr->jobs)
                 return mfree(tr);
 
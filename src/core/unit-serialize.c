@@ -90,8 +90,11 @@ int unit_serialize_state(Unit *u, FILE *f, FDSet *fds, bool switching_root) {
         (void) serialize_dual_timestamp(f, "condition-timestamp", &u->condition_timestamp);
         (void) serialize_dual_timestamp(f, "assert-timestamp", &u->assert_timestamp);
 
-        (void) serialize_ratelimit(f, "start-ratelimit", &u->start_ratelimit);
-        (void) serialize_ratelimit(f, "auto-start-stop-ratelimit", &u->auto_start_stop_ratelimit);
+        /* Most units never hit these, skip them if they were never started so far */
+        if (u->start_ratelimit.begin > 0)
+                (void) serialize_ratelimit(f, "start-ratelimit", &u->start_ratelimit);
+        if (u->auto_start_stop_ratelimit.begin > 0)
+                (void) serialize_ratelimit(f, "auto-start-stop-ratelimit", &u->auto_start_stop_ratelimit);
 
         if (dual_timestamp_is_set(&u->condition_timestamp))
                 (void) serialize_bool(f, "condition-result", u->condition_result);
@@ -100,15 +103,19 @@ int unit_serialize_state(Unit *u, FILE *f, FDSet *fds, bool switching_root) {
                 (void) serialize_bool(f, "assert-result", u->assert_result);
 
         (void) serialize_bool(f, "transient", u->transient);
-        (void) serialize_bool(f, "in-audit", u->in_audit);
 
-        (void) serialize_bool(f, "debug-invocation", u->debug_invocation);
+        /* The following are all runtime state that starts out as false, hence only serialize them if set.
+         * With many (mostly inactive) units this keeps the serialization noticeably smaller, and hence
+         * quicker to parse again. */
+        (void) serialize_bool_elide(f, "in-audit", u->in_audit);
 
-        (void) serialize_bool(f, "exported-invocation-id", u->exported_invocation_id);
-        (void) serialize_bool(f, "exported-log-level-max", u->exported_log_level_max);
-        (void) serialize_bool(f, "exported-log-extra-fields", u->exported_log_extra_fields);
-        (void) serialize_bool(f, "exported-log-rate-limit-interval", u->exported_log_ratelimit_interval);
-        (void) serialize_bool(f, "exported-log-rate-limit-burst", u->exported_log_ratelimit_burst);
+        (void) serialize_bool_elide(f, "debug-invocation", u->debug_invocation);
+
+        (void) serialize_bool_elide(f, "exported-invocation-id", u->exported_invocation_id);
+        (void) serialize_bool_elide(f, "exported-log-level-max", u->exported_log_level_max);
+        (void) serialize_bool_elide(f, "exported-log-extra-fields", u->exported_log_extra_fields);
+        (void) serialize_bool_elide(f, "exported-log-rate-limit-interval", u->exported_log_ratelimit_interval);
+        (void) serialize_bool_elide(f, "exported-log-rate-limit-burst", u->exported_log_ratelimit_burst);
 
         (void) cgroup_runtime_serialize(u, f, fds);
 
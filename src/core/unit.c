@@ -228,7 +228,9 @@ static int unit_add_alias(Unit *u, char *donated_name) {
 }
 
 int unit_add_name(Unit *u, const char *text) {
-        _cleanup_free_ char *name = NULL, *instance = NULL;
+        _cleanup_free_ char *name = NULL;
+        const char *instance;
+        size_t instance_len;
         UnitType t;
         int r;
 
@@ -271,7 +273,7 @@ int unit_add_name(Unit *u, const char *text) {
                                             "Unit type is illegal: u->type(%d) and t(%d) for name '%s'.",
                                             u->type, t, name);
 
-        r = unit_name_to_instance(name, &instance);
+        r = unit_name_to_instance_view(name, &instance, &instance_len);
         if (r < 0)
                 return log_unit_debug_errno(u, r, "Failed to extract instance from name '%s': %m", name);
 
@@ -279,10 +281,11 @@ int unit_add_name(Unit *u, const char *text) {
                 return log_unit_debug_errno(u, SYNTHETIC_ERRNO(EINVAL), "Templates are not allowed for name '%s'.", name);
 
         /* Ensure that this unit either has no instance, or that the instance matches. */
-        if (u->type != _UNIT_TYPE_INVALID && !streq_ptr(u->instance, instance))
+        if (u->type != _UNIT_TYPE_INVALID &&
+            memcmp_nn(u->instance, strlen_ptr(u->instance), instance, instance_len) != 0)
                 return log_unit_debug_errno(u, SYNTHETIC_ERRNO(EINVAL),
-                                            "Cannot add name %s, the instances don't match (\"%s\" != \"%s\").",
-                                            name, instance, u->instance);
+                                            "Cannot add name %s, the instances don't match (\"%.*s\" != \"%s\").",
+                                            name, (int) instance_len, strempty(instance), strnull(u->instance));
 
         if (u->id && !unit_type_may_alias(t))
                 return log_unit_debug_errno(u, SYNTHETIC_ERRNO(EEXIST),
@@ -292,6 +295,14 @@ int unit_add_name(Unit *u, const char *text) {
         if (hashmap_size(u->manager->units) >= MANAGER_MAX_NAMES)
                 return log_unit_warning_errno(u, SYNTHETIC_ERRNO(E2BIG), "Cannot add name, manager has too many units.");
 
+        /* Only copy the instance if this is the unit's first name, aliases share the instance */
+        _cleanup_free_ char *instance_copy = NULL;
+        if (!u->id && instance) {
+                instance_copy = strndup(instance, instance_len);
+                if (!instance_copy)
+                        return -ENOMEM;
+        }
+
         /* Add name to the global hashmap first, because that's easier to undo */
         r = hashmap_put(u->manager->units, name, u);
         if (r < 0)
@@ -312,7 +323,7 @@ int unit_add_name(Unit *u, const char *text) {
 
                 u->type = t;
                 u->id = TAKE_PTR(name);
-                u->instance = TAKE_PTR(instance);
+                u->instance = TAKE_PTR(instance_copy);
 
                 LIST_PREPEND(units_by_type, u->manager->units_by_type[t], u);
                 unit_init(u);
@@ -525,8 +536,13 @@ void unit_add_to_dbus_queue(Unit *u) {
         assert(u);
         assert(u->type != _UNIT_TYPE_INVALID);
 
-        if (u->load_state == UNIT_STUB || u->in_dbus_queue)
+        if (u->load_state == UNIT_STUB)
+                return;
+
+        if (u->in_dbus_queue) {
+                u->manager->n_change_signals_coalesced++;
                 return;
+        }
 
         /* Shortcut things if nobody cares */
         if (sd_bus_track_count(u->manager->subscribed) <= 0 &&
@@ -622,6 +638,24 @@ void unit_submit_to_release_resources_queue(Unit *u) {
         u->in_release_resources_queue = true;
 }
 
+static void unit_trim_dependencies(Unit *u) {
+        Hashmap *deps;
+        void *dt;
+
+        assert(u);
+
+        /* Drops the per-type hashmaps that became empty. Our hashmaps never shrink, hence without this a
+         * unit that once had many dependencies of some type (think of a slice whose children went away)
+         * would keep the full allocation around forever. */
+
+        HASHMAP_FOREACH_KEY(deps, dt, u->dependencies)
+                if (hashmap_isempty(deps))
+                        hashmap_free(hashmap_remove(u->dependencies, dt));
+
+        if (hashmap_isempty(u->dependencies))
+                u->dependencies = hashmap_free(u->dependencies);
+}
+
 static void unit_clear_dependencies(Unit *u) {
         assert(u);
 
@@ -635,6 +669,7 @@ static void unit_clear_dependencies(Unit *u) {
                         HASHMAP_FOREACH(other_deps, other->dependencies)
                                 hashmap_remove(other_deps, u);
 
+                        unit_trim_dependencies(other);
                         unit_add_to_gc_queue(other);
                 }
 
@@ -933,7 +968,7 @@ static int unit_reserve_dependencies(Unit *u, Unit *other) {
 
         n_reserve = MIN(hashmap_size(other->dependencies), LESS_BY((size_t) _UNIT_DEPENDENCY_MAX, hashmap_size(u->dependencies)));
         if (n_reserve > 0) {
-                r = hashmap_ensure_allocated(&u->dependencies, NULL);
+                r = hashmap_ensure_allocated(&u->dependencies, &trusted_trivial_hash_ops);
                 if (r < 0)
                         return r;
 
@@ -3028,11 +3063,13 @@ static Hashmap *unit_get_dependency_hashmap_per_type(Unit *u, UnitDependency d)
         if (!deps) {
                 _cleanup_hashmap_free_ Hashmap *h = NULL;
 
-                h = hashmap_new(NULL);
+                /* Keyed by Unit objects, and the outer map by dependency type, neither is picked from the
+                 * outside, hence skip siphash on these very hot lookups. */
+                h = hashmap_new(&trusted_trivial_hash_ops);
                 if (!h)
                         return NULL;
 
-                if (hashmap_ensure_put(&u->dependencies, NULL, UNIT_DEPENDENCY_TO_PTR(d), h) < 0)
+                if (hashmap_ensure_put(&u->dependencies, &trusted_trivial_hash_ops, UNIT_DEPENDENCY_TO_PTR(d), h) < 0)
                         return NULL;
 
                 deps = TAKE_PTR(h);
@@ -3270,13 +3307,14 @@ static int resolve_template(Unit *u, const char *name, char **buf, const char **
         if (u->instance)
                 r = unit_name_replace_instance(name, u->instance, buf);
         else {
-                _cleanup_free_ char *i = NULL;
+                const char *i;
+                size_t n;
 
-                r = unit_name_to_prefix(u->id, &i);
+                r = unit_name_to_prefix_view(u->id, &i, &n);
                 if (r < 0)
                         return r;
 
-                r = unit_name_replace_instance(name, i, buf);
+                r = unit_name_replace_instance_n(name, i, n, /* accept_glob= */ false, buf);
         }
         if (r < 0)
                 return r;
@@ -3372,7 +3410,7 @@ int unit_set_invocation_id(Unit *u, sd_id128_t id) {
                 goto reset;
         }
 
-        r = hashmap_ensure_allocated(&u->manager->units_by_invocation_id, &id128_hash_ops);
+        r = hashmap_ensure_allocated(&u->manager->units_by_invocation_id, &trusted_id128_hash_ops);
         if (r < 0)
                 goto reset;
 
@@ -3826,12 +3864,8 @@ static bool fragment_mtime_newer(const char *path, usec_t mtime, bool path_maske
         return false;
 }
 
-bool unit_need_daemon_reload(Unit *u) {
+bool unit_files_changed(Unit *u) {
         assert(u);
-        assert(u->manager);
-
-        if (u->manager->unit_file_state_outdated)
-                return true;
 
         /* For unit files, we allow masking… */
         if (fragment_mtime_newer(u->fragment_path, u->fragment_mtime,
@@ -3859,6 +3893,16 @@ bool unit_need_daemon_reload(Unit *u) {
         return false;
 }
 
+bool unit_need_daemon_reload(Unit *u) {
+        assert(u);
+        assert(u->manager);
+
+        if (u->manager->unit_file_state_outdated)
+                return true;
+
+        return unit_files_changed(u);
+}
+
 void unit_reset_failed(Unit *u) {
         assert(u);
 
@@ -5169,9 +5213,12 @@ bool unit_is_pristine(Unit *u) {
          * Note that we don't check for drop-ins here, because we allow drop-ins for transient units
          * identically to non-transient units, both unit-specific and hierarchical. E.g. for a-b-c.service:
          * service.d/….conf, a-.service.d/….conf, a-b-.service.d/….conf, a-b-c.service.d/….conf.
+         *
+         * UNIT_STUB is accepted too, for units that were not loaded at all yet, because it is already known
+         * that there's nothing on disk for them (see transient_unit_from_message()).
          */
 
-        return IN_SET(u->load_state, UNIT_NOT_FOUND, UNIT_LOADED) &&
+        return IN_SET(u->load_state, UNIT_STUB, UNIT_NOT_FOUND, UNIT_LOADED) &&
                !u->fragment_path &&
                !u->source_path &&
                !u->job &&
@@ -5601,6 +5648,7 @@ void unit_remove_dependencies(Unit *u, UnitDependencyMask mask) {
                                         unit_update_dependency_mask(other_deps, u, dj);
                                 }
 
+                                unit_trim_dependencies(other);
                                 unit_add_to_gc_queue(other);
 
                                 /* The unit 'other' may not be wanted by the unit 'u'. */
@@ -5612,6 +5660,8 @@ void unit_remove_dependencies(Unit *u, UnitDependencyMask mask) {
 
                 } while (!done);
         }
+
+        unit_trim_dependencies(u);
 }
 
 static int unit_get_invocation_path(Unit *u, char **ret) {
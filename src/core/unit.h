@@ -906,6 +906,7 @@ void unit_catchup(Unit *u);
 
 void unit_status_printf(Unit *u, StatusType status_type, const char *status, const char *format, const char *ident) _printf_(4, 0);
 
+bool unit_files_changed(Unit *u);
 bool unit_need_daemon_reload(Unit *u);
 
 void unit_reset_failed(Unit *u);
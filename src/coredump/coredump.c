@@ -27,6 +27,7 @@
 #include "conf-parser.h"
 #include "copy.h"
 #include "coredump-util.h"
+#include "cpu-set-util.h"
 #include "coredump-vacuum.h"
 #include "dirent-util.h"
 #include "elf-util.h"
@@ -54,6 +55,7 @@
 #include "socket-util.h"
 #include "special.h"
 #include "stat-util.h"
+#include "stdio-util.h"
 #include "string-table.h"
 #include "string-util.h"
 #include "strv.h"
@@ -86,6 +88,9 @@
  * go below 4MB for writing core files to storage. */
 #define PROCESS_SIZE_MIN (4U*1024U*1024U)
 
+/* The chunk size in which we read the core from the kernel when compressing it on the fly */
+#define COPY_BUFFER_SIZE (128U*1024U)
+
 /* Make sure to not make this larger than the maximum journal entry
  * size. See DATA_SIZE_MAX in journal-importer.h. */
 assert_cc(JOURNAL_SIZE_MAX <= DATA_SIZE_MAX);
@@ -181,6 +186,7 @@ static DEFINE_CONFIG_PARSE_ENUM(config_parse_coredump_storage, coredump_storage,
 
 static CoredumpStorage arg_storage = COREDUMP_STORAGE_EXTERNAL;
 static bool arg_compress = true;
+static unsigned arg_compress_threads = 0;
 static uint64_t arg_process_size_max = PROCESS_SIZE_MAX;
 static uint64_t arg_external_size_max = EXTERNAL_SIZE_MAX;
 static uint64_t arg_journal_size_max = JOURNAL_SIZE_MAX;
@@ -201,6 +207,7 @@ static int parse_config(void) {
         static const ConfigTableItem items[] = {
                 { "Coredump", "Storage",         config_parse_coredump_storage,    0,                      &arg_storage           },
                 { "Coredump", "Compress",        config_parse_bool,                0,                      &arg_compress          },
+                { "Coredump", "CompressThreads", config_parse_unsigned,            0,                      &arg_compress_threads  },
                 { "Coredump", "ProcessSizeMax",  config_parse_iec_uint64,          0,                      &arg_process_size_max  },
                 { "Coredump", "ExternalSizeMax", config_parse_iec_uint64_infinity, 0,                      &arg_external_size_max },
                 { "Coredump", "JournalSizeMax",  config_parse_iec_size,            0,                      &arg_journal_size_max  },
@@ -443,6 +450,116 @@ static int grant_user_access(int core_fd, const Context *context) {
         return ret;
 }
 
+#if HAVE_COMPRESSION
+static int copy_and_compress(
+                int input_fd,
+                int fd,
+                int fd_compressed,
+                uint64_t max_size,
+                bool compress_beyond_max_size,
+                bool *ret_truncated,
+                uint64_t *ret_uncompressed_size) {
+
+        _cleanup_close_pair_ int pipefd[2] = EBADF_PAIR;
+        _cleanup_(sigkill_waitp) pid_t pid = 0;
+        _cleanup_free_ uint8_t *buf = NULL;
+        uint64_t copied = 0, fed = 0;
+        bool truncated = false;
+        int r;
+
+        assert(input_fd >= 0);
+        assert(fd >= 0);
+        assert(fd_compressed >= 0);
+        assert(ret_truncated);
+        assert(ret_uncompressed_size);
+
+        /* Reads the core only once: each chunk is written to the uncompressed file (up to max_size bytes)
+         * and handed to a child process that compresses it, so that both run concurrently and the crashed
+         * process is released as quickly as possible. If compress_beyond_max_size is set, compression
+         * continues after the uncompressed file is full. */
+
+        if (pipe2(pipefd, O_CLOEXEC) < 0)
+                return log_error_errno(errno, "Failed to create pipe: %m");
+
+        r = safe_fork("(sd-compress)", FORK_RESET_SIGNALS|FORK_DEATHSIG_SIGTERM|FORK_LOG, &pid);
+        if (r < 0)
+                return r;
+        if (r == 0) {
+                /* Child */
+                pipefd[1] = safe_close(pipefd[1]);
+
+                r = compress_stream_full(pipefd[0], fd_compressed, max_size, arg_compress_threads, /* ret_uncompressed_size= */ NULL);
+                if (r < 0) {
+                        log_error_errno(r, "Failed to compress coredump: %m");
+                        _exit(EXIT_FAILURE);
+                }
+
+                _exit(EXIT_SUCCESS);
+        }
+
+        pipefd[0] = safe_close(pipefd[0]);
+
+        /* If the compressor fails, we want to see EPIPE rather than being killed */
+        (void) ignore_signals(SIGPIPE);
+
+        buf = malloc(COPY_BUFFER_SIZE);
+        if (!buf)
+                return log_oom();
+
+        for (;;) {
+                size_t n, m;
+                ssize_t k;
+
+                k = loop_read(input_fd, buf, COPY_BUFFER_SIZE, /* do_poll= */ true);
+                if (k < 0)
+                        return log_error_errno(k, "Failed to read coredump: %m");
+                if (k == 0)
+                        break;
+                n = (size_t) k;
+
+                m = truncated ? 0 : (size_t) MIN((uint64_t) n, max_size - copied);
+                if (m > 0) {
+                        r = loop_write(fd, buf, m);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to write coredump: %m");
+
+                        copied += m;
+                }
+
+                if (m < n)
+                        truncated = true;
+
+                if (!compress_beyond_max_size)
+                        n = m;
+
+                if (n > 0) {
+                        r = loop_write(pipefd[1], buf, n);
+                        if (r == -EPIPE) /* The compressor gave up, it logged why */
+                                break;
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to write coredump to compressor: %m");
+
+                        fed += n;
+                }
+
+                if (truncated && !compress_beyond_max_size)
+                        break;
+        }
+
+        pipefd[1] = safe_close(pipefd[1]);
+
+        r = wait_for_terminate_and_check("(sd-compress)", TAKE_PID(pid), 0);
+        if (r < 0)
+                return r;
+        if (r != EXIT_SUCCESS)
+                return -EPROTO;
+
+        *ret_truncated = truncated;
+        *ret_uncompressed_size = fed;
+        return 0;
+}
+#endif
+
 static int save_external_coredump(
                 const Context *context,
                 int input_fd,
@@ -554,14 +671,6 @@ static int save_external_coredump(
                 log_debug("Limiting core file size to %" PRIu64 " bytes due to cgroup and/or filesystem limits.", max_size);
         }
 
-        r = copy_bytes(input_fd, fd, max_size, 0);
-        if (r < 0)
-                return log_error_errno(r, "Cannot store coredump of %s (%s): %m",
-                                context->meta[META_ARGV_PID], context->meta[META_COMM]);
-        truncated = r == 1;
-
-        bool allow_user = grant_user_access(fd, context) > 0;
-
 #if HAVE_COMPRESSION
         if (arg_compress) {
                 _cleanup_(unlink_and_freep) char *tmp_compressed = NULL;
@@ -569,9 +678,6 @@ static int save_external_coredump(
                 _cleanup_close_ int fd_compressed = -EBADF;
                 uint64_t uncompressed_size = 0;
 
-                if (lseek(fd, 0, SEEK_SET) < 0)
-                        return log_error_errno(errno, "Failed to seek on coredump %s: %m", fn);
-
                 fn_compressed = strjoin(fn, default_compression_extension());
                 if (!fn_compressed)
                         return log_oom();
@@ -580,24 +686,22 @@ static int save_external_coredump(
                 if (fd_compressed < 0)
                         return log_error_errno(fd_compressed, "Failed to create temporary file for coredump %s: %m", fn_compressed);
 
-                r = compress_stream(fd, fd_compressed, max_size, &uncompressed_size);
+                /* If the uncompressed write is truncated and we are writing to tmpfs, drop the uncompressed
+                 * core, but keep compressing the remaining part from STDIN. */
+                r = copy_and_compress(input_fd, fd, fd_compressed, max_size,
+                                      /* compress_beyond_max_size= */ storage_on_tmpfs,
+                                      &truncated, &uncompressed_size);
                 if (r < 0)
-                        return log_error_errno(r, "Failed to compress %s: %m", coredump_tmpfile_name(tmp_compressed));
+                        return log_error_errno(r, "Cannot store coredump of %s (%s): %m",
+                                               context->meta[META_ARGV_PID], context->meta[META_COMM]);
 
-                if (truncated && storage_on_tmpfs) {
-                        uint64_t partial_uncompressed_size = 0;
-
-                        /* Uncompressed write was truncated and we are writing to tmpfs: delete
-                         * the uncompressed core, and compress the remaining part from STDIN. */
+                bool allow_user = grant_user_access(fd, context) > 0;
 
+                if (truncated && storage_on_tmpfs) {
                         tmp = unlink_and_free(tmp);
                         fd = safe_close(fd);
-
-                        r = compress_stream(input_fd, fd_compressed, max_size, &partial_uncompressed_size);
-                        if (r < 0)
-                                return log_error_errno(r, "Failed to compress %s: %m", coredump_tmpfile_name(tmp_compressed));
-                        uncompressed_size += partial_uncompressed_size;
-                }
+                } else if (lseek(fd, 0, SEEK_SET) < 0)
+                        return log_error_errno(errno, "Failed to seek on coredump %s: %m", fn);
 
                 r = fix_permissions(fd_compressed, tmp_compressed, fn_compressed, context, allow_user);
                 if (r < 0)
@@ -620,6 +724,14 @@ static int save_external_coredump(
         }
 #endif
 
+        r = copy_bytes(input_fd, fd, max_size, 0);
+        if (r < 0)
+                return log_error_errno(r, "Cannot store coredump of %s (%s): %m",
+                                context->meta[META_ARGV_PID], context->meta[META_COMM]);
+        truncated = r == 1;
+
+        bool allow_user = grant_user_access(fd, context) > 0;
+
         if (truncated)
                 log_struct(LOG_INFO,
                            LOG_MESSAGE("Core file was truncated to %"PRIu64" bytes.", max_size),
@@ -805,6 +917,38 @@ static int change_uid_gid(const Context *context) {
         return drop_privileges(uid, gid, 0);
 }
 
+static int acquire_stacktrace_slot(void) {
+        int n;
+
+        /* Generating a stack trace means loading the debug information of all modules of the crashed
+         * process, which is expensive. When lots of processes crash at the same time, only do that for as
+         * many of them at once as we have CPUs. The others are still stored, and stack traces for them may
+         * be generated later on with coredumpctl. Returns the fd of the acquired slot, -EBUSY if all slots
+         * are taken, or another negative errno if we cannot tell. */
+
+        n = MAX(cpus_in_affinity_mask(), 1);
+
+        for (int i = 0; i < n; i++) {
+                char path[STRLEN("/var/lib/systemd/coredump/.stacktrace-slot.") + DECIMAL_STR_MAX(int)];
+                int fd;
+
+                xsprintf(path, "/var/lib/systemd/coredump/.stacktrace-slot.%i", i);
+
+                fd = xopenat_lock_full(
+                                AT_FDCWD,
+                                path,
+                                O_CREAT|O_RDWR|O_NOFOLLOW|O_CLOEXEC|O_NOCTTY,
+                                /* xopen_flags= */ 0,
+                                0600,
+                                LOCK_BSD,
+                                LOCK_EX|LOCK_NB);
+                if (fd != -EAGAIN)
+                        return fd;
+        }
+
+        return -EBUSY;
+}
+
 static int attach_mount_tree(int mount_tree_fd) {
         int r;
 
@@ -839,7 +983,7 @@ static int submit_coredump(
                 int input_fd) {
 
         _cleanup_(sd_json_variant_unrefp) sd_json_variant *json_metadata = NULL;
-        _cleanup_close_ int coredump_fd = -EBADF, coredump_node_fd = -EBADF;
+        _cleanup_close_ int coredump_fd = -EBADF, coredump_node_fd = -EBADF, stacktrace_slot_fd = -EBADF;
         _cleanup_free_ char *filename = NULL, *coredump_data = NULL, *stacktrace = NULL;
         const char *module_name, *root = NULL;
         uint64_t coredump_size = UINT64_MAX, coredump_compressed_size = UINT64_MAX;
@@ -880,6 +1024,13 @@ static int submit_coredump(
         if (context->mount_tree_fd >= 0 && attach_mount_tree(context->mount_tree_fd) >= 0)
                 root = MOUNT_TREE_ROOT;
 
+        /* Reserve the right to generate a stack trace while we still may create the lock file */
+        if (written) {
+                stacktrace_slot_fd = acquire_stacktrace_slot();
+                if (stacktrace_slot_fd < 0 && stacktrace_slot_fd != -EBUSY)
+                        log_debug_errno(stacktrace_slot_fd, "Failed to acquire stack trace slot, ignoring: %m");
+        }
+
         /* Now, let's drop privileges to become the user who owns the segfaulted process and allocate the
          * coredump memory under the user's uid. This also ensures that the credentials journald will see are
          * the ones of the coredumping user, thus making sure the user gets access to the core dump. Let's
@@ -894,6 +1045,8 @@ static int submit_coredump(
                         log_debug("Not generating stack trace: core size %"PRIu64" is greater "
                                   "than %"PRIu64" (the configured maximum)",
                                   coredump_size, arg_process_size_max);
+                else if (stacktrace_slot_fd == -EBUSY)
+                        log_info("Too many core dumps are being processed at the same time, not generating stack trace.");
                 else if (coredump_fd >= 0) {
                         bool skip = startswith(context->meta[META_COMM], "systemd-coredum"); /* COMM is 16 bytes usually */
 
@@ -15,6 +15,7 @@
 #include "alloc-util.h"
 #include "ask-password-api.h"
 #include "build.h"
+#include "cpu-set-util.h"
 #include "cryptsetup-fido2.h"
 #include "cryptsetup-keyfile.h"
 #include "cryptsetup-pkcs11.h"
@@ -25,15 +26,18 @@
 #include "efi-loader.h"
 #include "env-util.h"
 #include "escape.h"
+#include "fd-util.h"
 #include "fileio.h"
 #include "fs-util.h"
 #include "fstab-util.h"
 #include "hexdecoct.h"
 #include "json-util.h"
 #include "libfido2-util.h"
+#include "limits-util.h"
 #include "log.h"
 #include "main-func.h"
 #include "memory-util.h"
+#include "mkdir.h"
 #include "mount-util.h"
 #include "nulstr-util.h"
 #include "parse-util.h"
@@ -42,6 +46,7 @@
 #include "pretty-print.h"
 #include "process-util.h"
 #include "random-util.h"
+#include "stdio-util.h"
 #include "string-table.h"
 #include "strv.h"
 #include "tpm2-pcr.h"
@@ -1086,6 +1091,121 @@ static int measured_crypt_activate_by_volume_key(
         return r;
 }
 
+static unsigned kdf_concurrency_max(struct crypt_device *cd, int keyslot) {
+#if HAVE_CRYPT_KEYSLOT_GET_PBKDF
+        uint64_t memory_kb = 0;
+        unsigned threads = 1;
+        const char *e;
+        int r;
+
+        assert(cd);
+
+        /* Returns how many memory-hard key derivations for this device's keyslots we should permit to run
+         * at the same time system-wide, or 0 if there's no need to limit them. */
+
+        e = secure_getenv("SYSTEMD_CRYPTSETUP_KDF_CONCURRENCY");
+        if (e) {
+                unsigned n;
+
+                r = safe_atou(e, &n);
+                if (r >= 0)
+                        return n;
+
+                log_debug_errno(r, "Failed to parse $SYSTEMD_CRYPTSETUP_KDF_CONCURRENCY, ignoring: %m");
+        }
+
+        const char *type = crypt_get_type(cd);
+        if (!type || !STR_IN_SET(type, CRYPT_LUKS1, CRYPT_LUKS2))
+                return 0;
+
+        int first = keyslot >= 0 ? keyslot : 0,
+                last = keyslot >= 0 ? keyslot : crypt_keyslot_max(type) - 1;
+
+        for (int k = first; k <= last; k++) {
+                struct crypt_pbkdf_type pbkdf;
+
+                if (!IN_SET(crypt_keyslot_status(cd, k), CRYPT_SLOT_ACTIVE, CRYPT_SLOT_ACTIVE_LAST))
+                        continue;
+
+                if (crypt_keyslot_get_pbkdf(cd, k, &pbkdf) < 0)
+                        continue;
+
+                /* PBKDF2 needs neither much memory nor more than one CPU, leave it alone */
+                if (!STRPTR_IN_SET(pbkdf.type, CRYPT_KDF_ARGON2I, CRYPT_KDF_ARGON2ID))
+                        continue;
+
+                memory_kb = MAX(memory_kb, (uint64_t) pbkdf.max_memory_kb);
+                threads = MAX(threads, pbkdf.parallel_threads);
+        }
+
+        if (memory_kb == 0)
+                return 0;
+
+        /* Permit as many derivations at once as fit into half of the RAM, and as we have CPUs for the
+         * threads each of them uses, but always at least one. */
+        uint64_t n_memory = physical_memory() / 2 / (memory_kb * 1024);
+        r = cpus_in_affinity_mask();
+        unsigned n_cpus = (unsigned) MAX(r, 1) / threads;
+
+        return (unsigned) CLAMP(MIN(n_memory, (uint64_t) n_cpus), UINT64_C(1), UINT64_C(64));
+#else
+        return 0;
+#endif
+}
+
+static int kdf_slot_acquire(struct crypt_device *cd, int keyslot) {
+        unsigned n;
+        int r;
+
+        assert(cd);
+
+        /* When many volumes are unlocked at the same time during boot, running all their memory-hard key
+         * derivations in parallel makes them contend for memory and CPU, and might even push the system
+         * into OOM. Hence take one of a limited number of lock files before doing the derivation. Returns
+         * the fd of the taken lock, or -EBADF if no limiting is necessary or possible. */
+
+        n = kdf_concurrency_max(cd, keyslot);
+        if (n == 0)
+                return -EBADF;
+
+        r = mkdir_p("/run/systemd/cryptsetup", 0755);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to create /run/systemd/cryptsetup/, not limiting key derivation concurrency: %m");
+                return -EBADF;
+        }
+
+        /* First try to take any free slot, and if there is none, queue on one of them */
+        for (unsigned attempt = 0; attempt <= n; attempt++) {
+                bool block = attempt == n;
+                char path[STRLEN("/run/systemd/cryptsetup/kdf-slot.") + DECIMAL_STR_MAX(unsigned)];
+                int fd;
+
+                if (block)
+                        log_info("Waiting for other key derivations to finish before unlocking this volume.");
+
+                xsprintf(path, "/run/systemd/cryptsetup/kdf-slot.%u", block ? random_u64_range(n) : attempt);
+
+                fd = xopenat_lock_full(
+                                AT_FDCWD,
+                                path,
+                                O_CREAT|O_RDWR|O_NOFOLLOW|O_CLOEXEC|O_NOCTTY,
+                                /* xopen_flags= */ 0,
+                                0600,
+                                LOCK_BSD,
+                                LOCK_EX|(block ? 0 : LOCK_NB));
+                if (fd >= 0) {
+                        log_debug("Acquired key derivation slot %s (%u permitted concurrently).", path, n);
+                        return fd;
+                }
+                if (fd != -EAGAIN) {
+                        log_debug_errno(fd, "Failed to lock %s, not limiting key derivation concurrency: %m", path);
+                        return -EBADF;
+                }
+        }
+
+        assert_not_reached();
+}
+
 static int measured_crypt_activate_by_passphrase(
                 struct crypt_device *cd,
                 const char *name,
@@ -1105,6 +1225,8 @@ static int measured_crypt_activate_by_passphrase(
          * crypt_activate_by_passphrase() doesn't give us access to this. Hence, we operate indirectly, and
          * retrieve the volume key first, and then activate through that. */
 
+        _cleanup_close_ _unused_ int kdf_slot_fd = kdf_slot_acquire(cd, keyslot);
+
         if (arg_tpm2_measure_pcr == UINT_MAX) {
                 log_debug("Not measuring volume key, deactivated.");
                 goto shortcut;
@@ -50,11 +50,13 @@
 #include "process-util.h"
 #include "random-util.h"
 #include "resize-fs.h"
+#include "stdio-util.h"
 #include "strv.h"
 #include "sync-util.h"
 #include "tmpfile-util.h"
 #include "udev-util.h"
 #include "user-util.h"
+#include "xattr-util.h"
 
 /* Round down to the nearest 4K size. Given that newer hardware generally prefers 4K sectors, let's align our
  * partitions to that too. In the worst case we'll waste 3.5K per partition that way, but I think I can live
@@ -93,10 +95,24 @@ int run_mark_dirty(int fd, bool b) {
                         return log_debug_errno(errno, "Could not mark home directory as dirty: %m");
 
         } else {
+                char size[DECIMAL_STR_MAX(uint64_t)];
+                struct stat st;
+
                 r = fsync_full(fd);
                 if (r < 0)
                         return log_debug_errno(r, "Failed to synchronize image before marking it clean: %m");
 
+                /* Remember the size the image had when it was cleanly released. If it still has it the next
+                 * time it is activated, nothing touched it in between, and we can skip the file system
+                 * check. */
+                if (fstat(fd, &st) < 0)
+                        return log_debug_errno(errno, "Failed to stat image before marking it clean: %m");
+
+                xsprintf(size, "%" PRIu64, (uint64_t) st.st_size);
+                r = xsetxattr(fd, /* path= */ NULL, AT_EMPTY_PATH, "user.home-clean-size", size);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to record size of clean image, ignoring: %m");
+
                 ret = fremovexattr(fd, "user.home-dirty");
                 if (ret < 0 && !ERRNO_IS_XATTR_ABSENT(errno))
                         return log_debug_errno(errno, "Could not mark home directory as clean: %m");
@@ -109,6 +125,36 @@ int run_mark_dirty(int fd, bool b) {
         return ret >= 0;
 }
 
+static bool image_is_clean(int fd, const struct stat *st, bool was_clean) {
+        _cleanup_free_ char *v = NULL;
+        uint64_t size;
+        int r;
+
+        assert(fd >= 0);
+        assert(st);
+
+        /* Checks whether the image was cleanly released the last time it was used, and hasn't changed size
+         * since. 'was_clean' is what run_mark_dirty() reported when we marked the image dirty. */
+
+        if (!was_clean)
+                return false;
+
+        r = fgetxattr_malloc(fd, "user.home-clean-size", &v);
+        if (r < 0) {
+                if (!ERRNO_IS_XATTR_ABSENT(r))
+                        log_debug_errno(r, "Failed to read recorded size of clean image, ignoring: %m");
+                return false;
+        }
+
+        r = safe_atou64(v, &size);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to parse recorded size of clean image '%s', ignoring: %m", v);
+                return false;
+        }
+
+        return size == (uint64_t) st->st_size;
+}
+
 int run_mark_dirty_by_path(const char *path, bool b) {
         _cleanup_close_ int fd = -EBADF;
 
@@ -1363,6 +1409,7 @@ int home_setup_luks(
         } else {
                 _cleanup_free_ char *fstype = NULL, *subdir = NULL;
                 const char *ip;
+                bool skip_fsck;
 
                 /* When we aren't reopening the home directory we are allocating it fresh, hence the relevant
                  * objects can't be allocated yet. */
@@ -1382,9 +1429,12 @@ int home_setup_luks(
 
                 /* Everything before this point left the image untouched. We are now starting to make
                  * changes, hence mark the image dirty */
-                if (run_mark_dirty(setup->image_fd, true) > 0)
+                r = run_mark_dirty(setup->image_fd, true);
+                if (r > 0)
                         setup->do_mark_clean = true;
 
+                skip_fsck = image_is_clean(setup->image_fd, &st, /* was_clean= */ r > 0);
+
                 if (!user_record_luks_discard(h)) {
                         r = run_fallocate(setup->image_fd, &st);
                         if (r < 0)
@@ -1438,9 +1488,13 @@ int home_setup_luks(
                 if (r < 0)
                         return r;
 
-                r = run_fsck(setup->dm_node, fstype);
-                if (r < 0)
-                        return r;
+                if (skip_fsck)
+                        log_info("Image was released cleanly and has not changed since, skipping file system check.");
+                else {
+                        r = run_fsck(setup->dm_node, fstype);
+                        if (r < 0)
+                                return r;
+                }
 
                 r = home_unshare_and_mount(setup->dm_node, fstype, user_record_luks_discard(h), user_record_mount_flags(h), h->luks_extra_mount_options);
                 if (r < 0)
@@ -45,6 +45,7 @@ struct RawExport {
 
         unsigned last_percent;
         RateLimit progress_ratelimit;
+        usec_t start_usec;
 
         struct stat st;
 
@@ -109,6 +110,9 @@ int raw_export_new(
 
 static void raw_export_report_progress(RawExport *e) {
         unsigned percent;
+        uint64_t rate = 0;
+        usec_t n;
+
         assert(e);
 
         if (e->written_uncompressed >= (uint64_t) e->st.st_size)
@@ -122,17 +126,22 @@ static void raw_export_report_progress(RawExport *e) {
         if (!ratelimit_below(&e->progress_ratelimit))
                 return;
 
+        n = now(CLOCK_MONOTONIC);
+        if (n > e->start_usec)
+                rate = (uint64_t) ((double) e->written_uncompressed / ((double) (n - e->start_usec) / (double) USEC_PER_SEC));
+
         sd_notifyf(false, "X_IMPORT_PROGRESS=%u%%", percent);
 
         if (isatty_safe(STDERR_FILENO))
                 (void) draw_progress_barf(
                                 percent,
-                                "%s %s/%s",
+                                "%s %s/%s %s/s",
                                 special_glyph(SPECIAL_GLYPH_ARROW_RIGHT),
                                 FORMAT_BYTES(e->written_uncompressed),
-                                FORMAT_BYTES(e->st.st_size));
+                                FORMAT_BYTES(e->st.st_size),
+                                FORMAT_BYTES(rate));
         else
-                log_info("Exported %u%%.", percent);
+                log_info("Exported %u%% (%s/s).", percent, FORMAT_BYTES(rate));
 
         e->last_percent = percent;
 }
@@ -322,6 +331,8 @@ int raw_export_start(RawExport *e, const char *path, int fd, ImportCompressType
         if (r < 0)
                 return r;
 
+        e->start_usec = now(CLOCK_MONOTONIC);
+
         r = sd_event_add_io(e->event, &e->output_event_source, fd, EPOLLOUT, raw_export_on_output, e);
         if (r == -EPERM) {
                 r = sd_event_add_defer(e->event, &e->output_event_source, raw_export_on_defer, e);
@@ -45,6 +45,7 @@ struct TarExport {
 
         unsigned last_percent;
         RateLimit progress_ratelimit;
+        usec_t start_usec;
 
         bool eof;
         bool tried_splice;
@@ -115,6 +116,9 @@ int tar_export_new(
 
 static void tar_export_report_progress(TarExport *e) {
         unsigned percent;
+        uint64_t rate = 0;
+        usec_t n;
+
         assert(e);
 
         /* Do we have any quota info? If not, we don't know anything about the progress */
@@ -132,17 +136,22 @@ static void tar_export_report_progress(TarExport *e) {
         if (!ratelimit_below(&e->progress_ratelimit))
                 return;
 
+        n = now(CLOCK_MONOTONIC);
+        if (n > e->start_usec)
+                rate = (uint64_t) ((double) e->written_uncompressed / ((double) (n - e->start_usec) / (double) USEC_PER_SEC));
+
         sd_notifyf(false, "X_IMPORT_PROGRESS=%u%%", percent);
 
         if (isatty_safe(STDERR_FILENO))
                 (void) draw_progress_barf(
                                 percent,
-                                "%s %s/%s",
+                                "%s %s/%s %s/s",
                                 special_glyph(SPECIAL_GLYPH_ARROW_RIGHT),
                                 FORMAT_BYTES(e->written_uncompressed),
-                                FORMAT_BYTES(e->quota_referenced));
+                                FORMAT_BYTES(e->quota_referenced),
+                                FORMAT_BYTES(rate));
         else
-                log_info("Exported %u%%.", percent);
+                log_info("Exported %u%% (%s/s).", percent, FORMAT_BYTES(rate));
 
         e->last_percent = percent;
 }
@@ -317,6 +326,8 @@ int tar_export_start(TarExport *e, const char *path, int fd, ImportCompressType
         if (r < 0)
                 return r;
 
+        e->start_usec = now(CLOCK_MONOTONIC);
+
         r = sd_event_add_io(e->event, &e->output_event_source, fd, EPOLLOUT, tar_export_on_output, e);
         if (r == -EPERM) {
                 r = sd_event_add_defer(e->event, &e->output_event_source, tar_export_on_defer, e);
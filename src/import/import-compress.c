@@ -1,6 +1,9 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include "cpu-set-util.h"
 #include "import-compress.h"
+#include "limits-util.h"
+#include "log.h"
 #include "string-table.h"
 
 void import_compress_free(ImportCompress *c) {
@@ -25,6 +28,41 @@ void import_compress_free(ImportCompress *c) {
         c->type = IMPORT_COMPRESS_UNKNOWN;
 }
 
+static int import_uncompress_xz_init(lzma_stream *xz) {
+        const uint32_t flags = LZMA_TELL_UNSUPPORTED_CHECK | LZMA_CONCATENATED;
+
+        assert(xz);
+
+#if LZMA_VERSION >= 50040002U /* 5.4.0 */
+        /* Decoding xz is by far the most expensive part of pulling a compressed image, so decode in parallel
+         * if we can. This only helps for files compressed in multiple blocks (e.g. with "xz -T0"), single
+         * block files are transparently decoded in a single thread. */
+        int n = cpus_in_affinity_mask();
+        if (n > 1) {
+                lzma_mt mt = {
+                        .flags = flags,
+                        .threads = n,
+                        /* Fall back to single-threaded decoding rather than taking more than a quarter of
+                         * RAM for the per-thread buffers. */
+                        .memlimit_threading = physical_memory() / 4,
+                        .memlimit_stop = UINT64_MAX,
+                };
+
+                if (lzma_stream_decoder_mt(xz, &mt) == LZMA_OK) {
+                        log_debug("Decoding xz with up to %i threads.", n);
+                        return 0;
+                }
+
+                log_debug("Failed to initialize threaded xz decoder, falling back to single-threaded decoding.");
+        }
+#endif
+
+        if (lzma_stream_decoder(xz, UINT64_MAX, flags) != LZMA_OK)
+                return -EIO;
+
+        return 0;
+}
+
 int import_uncompress_detect(ImportCompress *c, const void *data, size_t size) {
         static const uint8_t xz_signature[] = {
                 0xfd, '7', 'z', 'X', 'Z', 0x00
@@ -51,11 +89,9 @@ int import_uncompress_detect(ImportCompress *c, const void *data, size_t size) {
         assert(data);
 
         if (memcmp(data, xz_signature, sizeof(xz_signature)) == 0) {
-                lzma_ret xzr;
-
-                xzr = lzma_stream_decoder(&c->xz, UINT64_MAX, LZMA_TELL_UNSUPPORTED_CHECK | LZMA_CONCATENATED);
-                if (xzr != LZMA_OK)
-                        return -EIO;
+                r = import_uncompress_xz_init(&c->xz);
+                if (r < 0)
+                        return r;
 
                 c->type = IMPORT_COMPRESS_XZ;
 
@@ -195,6 +231,41 @@ int import_uncompress(ImportCompress *c, const void *data, size_t size, ImportCo
         return 1;
 }
 
+static int import_compress_xz_init(lzma_stream *xz) {
+        assert(xz);
+
+        /* Compressing xz is by far the most expensive part of exporting an image, so encode in parallel if
+         * we can. The threaded encoder splits the input into independent blocks, which also allows the
+         * result to be decoded in parallel again. */
+        int n = cpus_in_affinity_mask();
+        if (n > 1) {
+                lzma_mt mt = {
+                        .threads = n,
+                        .preset = LZMA_PRESET_DEFAULT,
+                        .check = LZMA_CHECK_CRC64,
+                };
+                uint64_t limit = physical_memory() / 4;
+
+                /* Each thread needs its own buffers, don't take more than a quarter of RAM for them. */
+                while (mt.threads > 1 && lzma_stream_encoder_mt_memusage(&mt) > limit)
+                        mt.threads--;
+
+                if (mt.threads > 1) {
+                        if (lzma_stream_encoder_mt(xz, &mt) == LZMA_OK) {
+                                log_debug("Encoding xz with %" PRIu32 " threads.", mt.threads);
+                                return 0;
+                        }
+
+                        log_debug("Failed to initialize threaded xz encoder, falling back to single-threaded encoding.");
+                }
+        }
+
+        if (lzma_easy_encoder(xz, LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC64) != LZMA_OK)
+                return -EIO;
+
+        return 0;
+}
+
 int import_compress_init(ImportCompress *c, ImportCompressType t) {
         int r;
 
@@ -202,16 +273,13 @@ int import_compress_init(ImportCompress *c, ImportCompressType t) {
 
         switch (t) {
 
-        case IMPORT_COMPRESS_XZ: {
-                lzma_ret xzr;
-
-                xzr = lzma_easy_encoder(&c->xz, LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC64);
-                if (xzr != LZMA_OK)
-                        return -EIO;
+        case IMPORT_COMPRESS_XZ:
+                r = import_compress_xz_init(&c->xz);
+                if (r < 0)
+                        return r;
 
                 c->type = IMPORT_COMPRESS_XZ;
                 break;
-        }
 
         case IMPORT_COMPRESS_GZIP:
                 r = deflateInit2(&c->gzip, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
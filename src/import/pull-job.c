@@ -15,11 +15,15 @@
 #include "parse-util.h"
 #include "pull-common.h"
 #include "pull-job.h"
+#include "stdio-util.h"
 #include "string-util.h"
 #include "strv.h"
 #include "sync-util.h"
 #include "xattr-util.h"
 
+/* The chunk size in which we ask libcurl to hand us the payload */
+#define PULL_JOB_BUFFER_SIZE (512U*1024U)
+
 void pull_job_close_disk_fd(PullJob *j) {
         if (!j)
                 return;
@@ -490,6 +494,24 @@ static size_t pull_job_write_callback(void *contents, size_t size, size_t nmemb,
         switch (j->state) {
 
         case PULL_JOB_ANALYZING:
+                if (j->range_size > 0) {
+                        /* A byte range of a resource is not a stream of its own, hence don't look for
+                         * compression headers in it. */
+                        import_uncompress_force_off(&j->compress);
+
+                        r = pull_job_open_disk(j);
+                        if (r < 0)
+                                goto fail;
+
+                        j->state = PULL_JOB_RUNNING;
+
+                        r = pull_job_write_compressed(j, contents, sz);
+                        if (r < 0)
+                                goto fail;
+
+                        break;
+                }
+
                 /* Let's first check what it actually is */
 
                 if (!GREEDY_REALLOC(j->payload, j->payload_size + sz)) {
@@ -755,6 +777,23 @@ int pull_job_begin(PullJob *j) {
                         return -EIO;
         }
 
+        if (j->range_size > 0) {
+                char range[DECIMAL_STR_MAX(uint64_t) * 2 + 2];
+
+                assert(j->range_start <= UINT64_MAX - j->range_size);
+
+                xsprintf(range, "%" PRIu64 "-%" PRIu64, j->range_start, j->range_start + j->range_size - 1);
+                if (curl_easy_setopt(j->curl, CURLOPT_RANGE, range) != CURLE_OK)
+                        return -EIO;
+
+                /* If the server ignores the range and sends the whole resource, refuse it */
+                j->compressed_max = j->uncompressed_max = j->range_size;
+        }
+
+        /* Larger chunks mean fewer trips through the write callback, and give the decompressor more to work
+         * with at once. libcurl caps this at its own maximum, hence ignore failures. */
+        (void) curl_easy_setopt(j->curl, CURLOPT_BUFFERSIZE, (long) PULL_JOB_BUFFER_SIZE);
+
         if (curl_easy_setopt(j->curl, CURLOPT_WRITEFUNCTION, pull_job_write_callback) != CURLE_OK)
                 return -EIO;
 
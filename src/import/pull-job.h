@@ -55,6 +55,11 @@ struct PullJob {
         uint64_t written_uncompressed;
         uint64_t offset;
 
+        /* If range_size is non-zero only this byte range of the resource is requested. It is written as is,
+         * i.e. without attempting to detect compression. */
+        uint64_t range_start;
+        uint64_t range_size;
+
         uint64_t uncompressed_max;
         uint64_t compressed_max;
 
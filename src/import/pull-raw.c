@@ -10,26 +10,48 @@
 #include "btrfs-util.h"
 #include "copy.h"
 #include "curl-util.h"
+#include "extract-word.h"
 #include "fd-util.h"
+#include "format-util.h"
 #include "fs-util.h"
+#include "hexdecoct.h"
 #include "hostname-util.h"
 #include "import-common.h"
 #include "import-util.h"
 #include "install-file.h"
+#include "io-util.h"
 #include "macro.h"
 #include "mkdir-label.h"
+#include "parse-util.h"
 #include "path-util.h"
 #include "pull-common.h"
 #include "pull-job.h"
 #include "pull-raw.h"
 #include "qcow2-util.h"
 #include "rm-rf.h"
+#include "sha256.h"
+#include "stat-util.h"
 #include "string-util.h"
 #include "strv.h"
+#include "sync-util.h"
 #include "tmpfile-util.h"
 #include "utf8.h"
 #include "web-util.h"
 
+/* Limits for the chunk index, and for each chunk listed in it */
+#define DELTA_INDEX_SIZE_MAX (16U*1024U*1024U)
+#define DELTA_CHUNK_SIZE_MAX (64U*1024U*1024U)
+
+/* Missing chunks next to each other are requested together, up to this size */
+#define DELTA_RANGE_SIZE_MAX (256U*1024U*1024U)
+
+typedef struct DeltaChunk {
+        uint64_t offset;
+        uint64_t size;
+        uint8_t sha256[SHA256_DIGEST_SIZE];
+        bool have;
+} DeltaChunk;
+
 typedef enum RawProgress {
         RAW_DOWNLOADING,
         RAW_VERIFYING,
@@ -78,6 +100,21 @@ struct RawPull {
         char *verity_temp_path;
 
         char *checksum;
+
+        /* If a seed is set, we first try to acquire the chunk index of the image, take all chunks the seed
+         * already has from there, and only download the rest. */
+        char *delta_seed;
+        uint64_t delta_seed_offset;
+        PullJob *delta_index_job;
+        PullJob *delta_range_job;
+        sd_event_source *delta_event_source;
+        DeltaChunk *delta_chunks;
+        size_t n_delta_chunks;
+        size_t delta_next;
+        uint64_t delta_total;
+        uint64_t delta_acquired;
+        uint64_t delta_reused;
+        int delta_fd;
 };
 
 RawPull* raw_pull_unref(RawPull *i) {
@@ -91,6 +128,9 @@ RawPull* raw_pull_unref(RawPull *i) {
         pull_job_unref(i->roothash_job);
         pull_job_unref(i->roothash_signature_job);
         pull_job_unref(i->verity_job);
+        pull_job_unref(i->delta_index_job);
+        pull_job_unref(i->delta_range_job);
+        sd_event_source_disable_unref(i->delta_event_source);
 
         curl_glue_unref(i->glue);
         sd_event_unref(i->event);
@@ -109,6 +149,9 @@ RawPull* raw_pull_unref(RawPull *i) {
         free(i->image_root);
         free(i->local);
         free(i->checksum);
+        free(i->delta_seed);
+        free(i->delta_chunks);
+        safe_close(i->delta_fd);
 
         return mfree(i);
 }
@@ -156,6 +199,7 @@ int raw_pull_new(
                 .event = TAKE_PTR(e),
                 .glue = TAKE_PTR(g),
                 .offset = UINT64_MAX,
+                .delta_fd = -EBADF,
         };
 
         i->glue->on_finished = pull_job_curl_on_finished;
@@ -208,7 +252,9 @@ static void raw_pull_report_progress(RawPull *i, RawProgress p) {
                         remain -= 10;
                 }
 
-                if (i->raw_job)
+                if (i->delta_total > 0)
+                        percent += (unsigned) (i->delta_acquired * remain / i->delta_total);
+                else if (i->raw_job)
                         percent += i->raw_job->progress_percent * remain / 100;
                 break;
         }
@@ -828,6 +874,402 @@ static void raw_pull_job_on_progress(PullJob *j) {
         raw_pull_report_progress(i, RAW_DOWNLOADING);
 }
 
+static void raw_pull_finish(RawPull *i, int r) {
+        assert(i);
+
+        if (i->on_finished)
+                i->on_finished(i, r, i->userdata);
+        else
+                sd_event_exit(i->event, r);
+}
+
+static void raw_pull_delta_fallback(RawPull *i, int error) {
+        int r;
+
+        assert(i);
+
+        /* Something went wrong on the way, but we can always still download the whole image */
+        log_info_errno(error, "Cannot acquire '%s' in chunks, downloading the whole image: %m", i->raw_job->url);
+
+        i->delta_index_job = pull_job_unref(i->delta_index_job);
+        i->delta_range_job = pull_job_unref(i->delta_range_job);
+        i->delta_chunks = mfree(i->delta_chunks);
+        i->n_delta_chunks = i->delta_next = 0;
+        i->delta_total = i->delta_acquired = i->delta_reused = 0;
+        i->delta_fd = safe_close(i->delta_fd);
+
+        r = pull_job_begin(i->raw_job);
+        if (r < 0)
+                raw_pull_finish(i, log_error_errno(r, "Failed to start download of %s: %m", i->raw_job->url));
+}
+
+static int raw_pull_delta_parse_index(RawPull *i) {
+        _cleanup_strv_free_ char **lines = NULL;
+        _cleanup_free_ DeltaChunk *chunks = NULL;
+        _cleanup_free_ char *text = NULL;
+        size_t n_chunks = 0;
+        uint64_t total = 0;
+        int r;
+
+        assert(i);
+        assert(i->delta_index_job);
+
+        /* The chunk index lists the chunks the image is made of, in order, one per line, each as its SHA256
+         * sum in hex followed by its size in bytes. The index is not signed, it doesn't need to be: the
+         * image we put together from it is verified against the expected checksum as a whole. */
+
+        text = memdup_suffix0(i->delta_index_job->payload, i->delta_index_job->payload_size);
+        if (!text)
+                return log_oom();
+
+        lines = strv_split_newlines(text);
+        if (!lines)
+                return log_oom();
+
+        STRV_FOREACH(line, lines) {
+                _cleanup_free_ char *hash = NULL, *size = NULL;
+                const char *p = *line;
+                uint64_t sz;
+
+                r = extract_many_words(&p, NULL, 0, &hash, &size);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to parse chunk index line '%s': %m", *line);
+                if (r == 0)
+                        continue;
+                if (r != 2 || !isempty(p))
+                        return log_error_errno(SYNTHETIC_ERRNO(EBADMSG), "Invalid chunk index line: %s", *line);
+
+                r = safe_atou64(size, &sz);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to parse chunk size '%s': %m", size);
+                if (sz == 0 || sz > DELTA_CHUNK_SIZE_MAX)
+                        return log_error_errno(SYNTHETIC_ERRNO(EBADMSG), "Chunk size out of range: %s", size);
+                if (total > i->raw_job->uncompressed_max - MIN(sz, i->raw_job->uncompressed_max))
+                        return log_error_errno(SYNTHETIC_ERRNO(EFBIG), "Image described by chunk index too large, refusing.");
+
+                if (!GREEDY_REALLOC(chunks, n_chunks + 1))
+                        return log_oom();
+
+                DeltaChunk *c = chunks + n_chunks;
+                *c = (DeltaChunk) {
+                        .offset = total,
+                        .size = sz,
+                };
+
+                r = parse_sha256(hash, c->sha256);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to parse chunk checksum '%s': %m", hash);
+
+                total += sz;
+                n_chunks++;
+        }
+
+        if (n_chunks == 0)
+                return log_error_errno(SYNTHETIC_ERRNO(ENODATA), "Chunk index is empty.");
+
+        free_and_replace(i->delta_chunks, chunks);
+        i->n_delta_chunks = n_chunks;
+        i->delta_total = total;
+        return 0;
+}
+
+static int raw_pull_delta_prepare(RawPull *i) {
+        _cleanup_close_ int seed_fd = -EBADF;
+        _cleanup_free_ uint8_t *buf = NULL;
+        struct stat seed_st, st;
+        uint64_t base;
+        int r;
+
+        assert(i);
+        assert(i->local);
+        assert(i->delta_seed);
+        assert(i->delta_fd < 0);
+
+        /* Opens the destination, and copies every chunk over from the seed that the seed has at the same
+         * place already. */
+
+        seed_fd = open(i->delta_seed, O_RDONLY|O_NOCTTY|O_CLOEXEC);
+        if (seed_fd < 0)
+                return log_error_errno(errno, "Failed to open seed '%s': %m", i->delta_seed);
+
+        if (fstat(seed_fd, &seed_st) < 0)
+                return log_error_errno(errno, "Failed to stat seed '%s': %m", i->delta_seed);
+
+        (void) mkdir_parents_label(i->local, 0700);
+
+        i->delta_fd = open(i->local, O_RDWR|O_NOCTTY|O_CLOEXEC|(i->offset == UINT64_MAX ? O_CREAT : 0), 0664);
+        if (i->delta_fd < 0)
+                return log_error_errno(errno, "Failed to open destination '%s': %m", i->local);
+
+        if (fstat(i->delta_fd, &st) < 0)
+                return log_error_errno(errno, "Failed to stat destination '%s': %m", i->local);
+
+        /* Check this before truncating anything */
+        if (stat_inode_same(&seed_st, &st) && (i->offset == UINT64_MAX || i->offset == i->delta_seed_offset))
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Seed and destination are the same, refusing.");
+
+        if (i->offset == UINT64_MAX) {
+                if (ftruncate(i->delta_fd, 0) < 0)
+                        return log_error_errno(errno, "Failed to truncate '%s': %m", i->local);
+
+                (void) import_set_nocow_and_log(i->delta_fd, i->local);
+        }
+
+        base = i->offset == UINT64_MAX ? 0 : i->offset;
+
+        FOREACH_ARRAY(c, i->delta_chunks, i->n_delta_chunks) {
+                ssize_t n;
+
+                if (!GREEDY_REALLOC(buf, c->size))
+                        return log_oom();
+
+                n = pread(seed_fd, buf, c->size, i->delta_seed_offset + c->offset);
+                if (n < 0)
+                        return log_error_errno(errno, "Failed to read from seed '%s': %m", i->delta_seed);
+                if ((uint64_t) n < c->size) /* The seed ends here */
+                        break;
+
+                if (memcmp(SHA256_DIRECT(buf, c->size), c->sha256, SHA256_DIGEST_SIZE) != 0)
+                        continue;
+
+                /* Share the data with the seed if both are files on a file system that can do that,
+                 * otherwise write what we just read. */
+                if (!S_ISREG(seed_st.st_mode) || !S_ISREG(st.st_mode) ||
+                    reflink_range(seed_fd, i->delta_seed_offset + c->offset, i->delta_fd, base + c->offset, c->size) < 0) {
+
+                        if (lseek(i->delta_fd, base + c->offset, SEEK_SET) < 0)
+                                return log_error_errno(errno, "Failed to seek in destination '%s': %m", i->local);
+
+                        r = loop_write(i->delta_fd, buf, c->size);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to write to destination '%s': %m", i->local);
+                }
+
+                c->have = true;
+                i->delta_reused += c->size;
+        }
+
+        i->delta_acquired = i->delta_reused;
+
+        log_info("Reusing %s of %s from '%s'.",
+                 FORMAT_BYTES(i->delta_reused), FORMAT_BYTES(i->delta_total), i->delta_seed);
+
+        return 0;
+}
+
+static int raw_pull_delta_verify(RawPull *i) {
+        uint8_t expected[SHA256_DIGEST_SIZE], found[SHA256_DIGEST_SIZE];
+        _cleanup_free_ uint8_t *buf = NULL;
+        struct sha256_ctx ctx;
+        uint64_t base;
+        int r;
+
+        assert(i);
+        assert(i->checksum);
+        assert(i->delta_fd >= 0);
+
+        r = parse_sha256(i->checksum, expected);
+        if (r < 0)
+                return log_error_errno(r, "Failed to parse checksum '%s': %m", i->checksum);
+
+        buf = malloc(DELTA_CHUNK_SIZE_MAX);
+        if (!buf)
+                return log_oom();
+
+        base = i->offset == UINT64_MAX ? 0 : i->offset;
+
+        sha256_init_ctx(&ctx);
+
+        for (uint64_t done = 0; done < i->delta_total;) {
+                ssize_t n;
+
+                n = pread(i->delta_fd, buf, MIN(i->delta_total - done, (uint64_t) DELTA_CHUNK_SIZE_MAX), base + done);
+                if (n < 0)
+                        return log_error_errno(errno, "Failed to read back '%s': %m", i->local);
+                if (n == 0)
+                        return log_error_errno(SYNTHETIC_ERRNO(EIO), "Unexpected end of file while reading back '%s'.", i->local);
+
+                sha256_process_bytes(buf, n, &ctx);
+                done += n;
+        }
+
+        sha256_finish_ctx(&ctx, found);
+
+        if (memcmp(expected, found, SHA256_DIGEST_SIZE) != 0)
+                return log_error_errno(SYNTHETIC_ERRNO(EBADMSG), "Image put together from chunks does not match expected checksum.");
+
+        return 0;
+}
+
+static int raw_pull_delta_complete(RawPull *i) {
+        int r;
+
+        assert(i);
+        assert(i->delta_fd >= 0);
+
+        if (i->offset == UINT64_MAX && ftruncate(i->delta_fd, i->delta_total) < 0)
+                return log_error_errno(errno, "Failed to truncate '%s': %m", i->local);
+
+        raw_pull_report_progress(i, RAW_VERIFYING);
+
+        r = raw_pull_delta_verify(i);
+        if (r < 0)
+                return r;
+
+        if (FLAGS_SET(i->flags, IMPORT_SYNC)) {
+                r = fsync_full(i->delta_fd);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to synchronize '%s': %m", i->local);
+        }
+
+        log_info("Acquired %s, downloaded %s of it.",
+                 FORMAT_BYTES(i->delta_total), FORMAT_BYTES(i->delta_total - i->delta_reused));
+
+        i->delta_fd = safe_close(i->delta_fd);
+
+        raw_pull_report_progress(i, RAW_FINALIZING);
+
+        r = install_file(AT_FDCWD, i->local,
+                         AT_FDCWD, NULL,
+                         ((i->flags & IMPORT_READ_ONLY) && i->offset == UINT64_MAX ? INSTALL_READ_ONLY : 0) |
+                         (i->flags & IMPORT_SYNC ? INSTALL_FSYNC_FULL : 0));
+        if (r < 0)
+                return log_error_errno(r, "Failed to finalize raw file to '%s': %m", i->local);
+
+        return 0;
+}
+
+static void raw_pull_delta_on_finished(PullJob *j);
+
+static int raw_pull_delta_next(RawPull *i) {
+        _cleanup_(pull_job_unrefp) PullJob *j = NULL;
+        uint64_t size = 0;
+        size_t k;
+        int r;
+
+        assert(i);
+        assert(!i->delta_range_job);
+
+        /* Find the next missing chunk, and request it together with the missing chunks right after it */
+        while (i->delta_next < i->n_delta_chunks && i->delta_chunks[i->delta_next].have)
+                i->delta_next++;
+
+        if (i->delta_next >= i->n_delta_chunks)
+                return 0; /* Nothing left to download */
+
+        for (k = i->delta_next; k < i->n_delta_chunks; k++) {
+                if (i->delta_chunks[k].have)
+                        break;
+                if (size > 0 && size + i->delta_chunks[k].size > DELTA_RANGE_SIZE_MAX)
+                        break;
+
+                size += i->delta_chunks[k].size;
+        }
+
+        r = pull_job_new(&j, i->raw_job->url, i->glue, i);
+        if (r < 0)
+                return log_oom();
+
+        j->range_start = i->delta_chunks[i->delta_next].offset;
+        j->range_size = size;
+        j->offset = (i->offset == UINT64_MAX ? 0 : i->offset) + j->range_start;
+        j->disk_fd = i->delta_fd;
+        j->close_disk_fd = false;
+        j->sync = false; /* We sync once at the end */
+        j->on_finished = raw_pull_delta_on_finished;
+
+        r = pull_job_begin(j);
+        if (r < 0)
+                return log_error_errno(r, "Failed to start download of %s: %m", j->url);
+
+        log_debug("Downloading chunks %zu…%zu (%s) of %s.", i->delta_next, k - 1, FORMAT_BYTES(size), j->url);
+
+        i->delta_next = k;
+        i->delta_range_job = TAKE_PTR(j);
+        return 1;
+}
+
+static void raw_pull_delta_on_finished(PullJob *j) {
+        RawPull *i = ASSERT_PTR(ASSERT_PTR(j)->userdata);
+        int r;
+
+        /* We might be called from within a libcurl callback here, where the job must not be freed yet.
+         * Hence continue in a later event loop iteration. */
+        r = sd_event_source_set_enabled(i->delta_event_source, SD_EVENT_ONESHOT);
+        if (r < 0)
+                raw_pull_finish(i, log_error_errno(r, "Failed to enable event source: %m"));
+}
+
+static int raw_pull_delta_on_defer(sd_event_source *s, void *userdata) {
+        RawPull *i = ASSERT_PTR(userdata);
+        PullJob *j;
+        int r;
+
+        j = i->delta_index_job ?: i->delta_range_job;
+        assert(j);
+        assert(PULL_JOB_IS_COMPLETE(j));
+
+        if (j->error != 0) {
+                raw_pull_delta_fallback(i, j->error);
+                return 0;
+        }
+
+        if (j == i->delta_index_job) {
+                r = raw_pull_delta_parse_index(i);
+                if (r < 0) {
+                        raw_pull_delta_fallback(i, r);
+                        return 0;
+                }
+
+                i->delta_index_job = pull_job_unref(i->delta_index_job);
+
+                r = raw_pull_delta_prepare(i);
+                if (r < 0) {
+                        raw_pull_delta_fallback(i, r);
+                        return 0;
+                }
+        } else {
+                i->delta_acquired += j->written_uncompressed;
+                i->delta_range_job = pull_job_unref(i->delta_range_job);
+        }
+
+        raw_pull_report_progress(i, RAW_DOWNLOADING);
+
+        r = raw_pull_delta_next(i);
+        if (r < 0) {
+                raw_pull_delta_fallback(i, r);
+                return 0;
+        }
+        if (r > 0)
+                return 0;
+
+        /* Everything is in place now */
+        r = raw_pull_delta_complete(i);
+        if (r == -EBADMSG) {
+                raw_pull_delta_fallback(i, r);
+                return 0;
+        }
+
+        raw_pull_finish(i, r);
+        return 0;
+}
+
+int raw_pull_set_delta_seed(RawPull *i, const char *path, uint64_t offset) {
+        int r;
+
+        assert(i);
+
+        if (i->raw_job)
+                return -EBUSY;
+
+        r = free_and_strdup(&i->delta_seed, path);
+        if (r < 0)
+                return r;
+
+        i->delta_seed_offset = path && offset != UINT64_MAX ? offset : 0;
+        return 0;
+}
+
 int raw_pull_start(
                 RawPull *i,
                 const char *url,
@@ -856,6 +1298,10 @@ int raw_pull_start(
         if (local && !pull_validate_local(local, flags))
                 return -EINVAL;
 
+        /* Images put together from chunks are verified as a whole against an explicitly specified checksum */
+        if (i->delta_seed && (!FLAGS_SET(flags, IMPORT_DIRECT) || !local || !checksum))
+                return -EINVAL;
+
         if (i->raw_job)
                 return -EBUSY;
 
@@ -976,6 +1422,31 @@ int raw_pull_start(
                         return r;
         }
 
+        if (i->delta_seed) {
+                _cleanup_free_ char *index_url = NULL;
+
+                index_url = strjoin(url, ".chunks");
+                if (!index_url)
+                        return -ENOMEM;
+
+                r = pull_job_new(&i->delta_index_job, index_url, i->glue, i);
+                if (r < 0)
+                        return r;
+
+                i->delta_index_job->on_finished = raw_pull_delta_on_finished;
+                i->delta_index_job->compressed_max = i->delta_index_job->uncompressed_max = DELTA_INDEX_SIZE_MAX;
+
+                r = sd_event_add_defer(i->event, &i->delta_event_source, raw_pull_delta_on_defer, i);
+                if (r < 0)
+                        return r;
+
+                r = sd_event_source_set_enabled(i->delta_event_source, SD_EVENT_OFF);
+                if (r < 0)
+                        return r;
+
+                (void) sd_event_source_set_description(i->delta_event_source, "raw-pull-delta");
+        }
+
         PullJob *j;
         FOREACH_ARGUMENT(j,
                          i->raw_job,
@@ -984,7 +1455,8 @@ int raw_pull_start(
                          i->settings_job,
                          i->roothash_job,
                          i->roothash_signature_job,
-                         i->verity_job) {
+                         i->verity_job,
+                         i->delta_index_job) {
 
                 if (!j)
                         continue;
@@ -992,6 +1464,11 @@ int raw_pull_start(
                 j->on_progress = raw_pull_job_on_progress;
                 j->sync = FLAGS_SET(flags, IMPORT_SYNC);
 
+                /* If we try to get away with downloading just the changed chunks, the whole image is only
+                 * downloaded if that doesn't work out */
+                if (j == i->raw_job && i->delta_index_job)
+                        continue;
+
                 r = pull_job_begin(j);
                 if (r < 0)
                         return r;
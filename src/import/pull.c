@@ -34,8 +34,11 @@ static uint64_t arg_offset = UINT64_MAX, arg_size_max = UINT64_MAX;
 static char *arg_checksum = NULL;
 static ImageClass arg_class = IMAGE_MACHINE;
 static RuntimeScope arg_runtime_scope = _RUNTIME_SCOPE_INVALID;
+static char *arg_delta_seed = NULL;
+static uint64_t arg_delta_seed_offset = 0;
 
 STATIC_DESTRUCTOR_REGISTER(arg_checksum, freep);
+STATIC_DESTRUCTOR_REGISTER(arg_delta_seed, freep);
 
 static int normalize_local(const char *local, const char *url, char **ret) {
         _cleanup_free_ char *ll = NULL;
@@ -142,6 +145,9 @@ static int pull_tar(int argc, char *argv[], void *userdata) {
         if (!local && FLAGS_SET(arg_import_flags, IMPORT_DIRECT))
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Pulling tar images to STDOUT is not supported.");
 
+        if (arg_delta_seed)
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Delta downloads are only supported for raw images.");
+
         r = normalize_local(local, url, &normalized);
         if (r < 0)
                 return r;
@@ -221,6 +227,12 @@ static int pull_raw(int argc, char *argv[], void *userdata) {
         if (r < 0)
                 return log_error_errno(r, "Failed to allocate puller: %m");
 
+        if (arg_delta_seed) {
+                r = raw_pull_set_delta_seed(pull, arg_delta_seed, arg_delta_seed_offset);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to set delta seed: %m");
+        }
+
         r = raw_pull_start(
                         pull,
                         url,
@@ -274,7 +286,10 @@ static int help(int argc, char *argv[], void *userdata) {
                "     --class=CLASS            Select image class (machine, sysext, confext,\n"
                "                              portable)\n"
                "     --keep-download=BOOL     Keep a copy pristine copy of the downloaded file\n"
-               "                              around\n",
+               "                              around\n"
+               "     --delta-seed=PATH        Reuse unchanged chunks from this file or device\n"
+               "     --delta-seed-offset=BYTES\n"
+               "                              Offset of the seed image in the --delta-seed= file\n",
                program_invocation_short_name,
                ansi_underline(),
                ansi_normal(),
@@ -305,6 +320,8 @@ static int parse_argv(int argc, char *argv[]) {
                 ARG_SIZE_MAX,
                 ARG_CLASS,
                 ARG_KEEP_DOWNLOAD,
+                ARG_DELTA_SEED,
+                ARG_DELTA_SEED_OFFSET,
         };
 
         static const struct option options[] = {
@@ -327,6 +344,8 @@ static int parse_argv(int argc, char *argv[]) {
                 { "size-max",           required_argument, NULL, ARG_SIZE_MAX           },
                 { "class",              required_argument, NULL, ARG_CLASS              },
                 { "keep-download",      required_argument, NULL, ARG_KEEP_DOWNLOAD      },
+                { "delta-seed",         required_argument, NULL, ARG_DELTA_SEED         },
+                { "delta-seed-offset",  required_argument, NULL, ARG_DELTA_SEED_OFFSET  },
                 {}
         };
 
@@ -507,6 +526,20 @@ static int parse_argv(int argc, char *argv[]) {
                         auto_keep_download = false;
                         break;
 
+                case ARG_DELTA_SEED:
+                        r = parse_path_argument(optarg, /* suppress_root= */ false, &arg_delta_seed);
+                        if (r < 0)
+                                return r;
+                        break;
+
+                case ARG_DELTA_SEED_OFFSET:
+                        r = safe_atou64(optarg, &arg_delta_seed_offset);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse --delta-seed-offset= argument: %s", optarg);
+                        if (!FILE_SIZE_VALID(arg_delta_seed_offset))
+                                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Argument to --delta-seed-offset= switch too large: %s", optarg);
+                        break;
+
                 case '?':
                         return -EINVAL;
 
@@ -526,6 +559,10 @@ static int parse_argv(int argc, char *argv[]) {
         if (arg_checksum && (arg_import_flags & (IMPORT_PULL_SETTINGS|IMPORT_PULL_ROOTHASH|IMPORT_PULL_ROOTHASH_SIGNATURE|IMPORT_PULL_VERITY)) != 0)
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Literal checksum verification only supported if no associated files are downloaded.");
 
+        /* The reassembled image is only verified against the whole-file hash, hence insist on one */
+        if (arg_delta_seed && (!FLAGS_SET(arg_import_flags, IMPORT_DIRECT) || !arg_checksum))
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Delta downloads only supported in --direct mode with a literal checksum.");
+
         if (!arg_image_root)
                 arg_image_root = image_root_to_string(arg_class);
 
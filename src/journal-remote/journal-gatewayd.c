@@ -17,7 +17,9 @@
 #include "build.h"
 #include "bus-locator.h"
 #include "bus-util.h"
+#include "compress.h"
 #include "errno-util.h"
+#include "extract-word.h"
 #include "fd-util.h"
 #include "fileio.h"
 #include "glob-util.h"
@@ -33,11 +35,16 @@
 #include "parse-util.h"
 #include "pretty-print.h"
 #include "signal-util.h"
+#include "string-util.h"
 #include "time-util.h"
 #include "tmpfile-util.h"
 
 #define JOURNAL_WAIT_TIMEOUT (10*USEC_PER_SEC)
 
+/* Entries are serialized in batches of about this size, which is also the size of the chunks handed to
+ * microhttpd. With compression enabled each batch is compressed as a separate frame. */
+#define ENTRIES_BATCH_SIZE (64U*1024U)
+
 static char *arg_key_pem = NULL;
 static char *arg_cert_pem = NULL;
 static char *arg_trust_pem = NULL;
@@ -66,6 +73,12 @@ typedef struct RequestMeta {
         FILE *tmp;
         uint64_t delta, size;
 
+        /* The content encoding negotiated via Accept-Encoding for the entries, and the current batch
+         * compressed with it */
+        Compression compression;
+        void *compressed;
+        size_t compressed_allocated;
+
         int argument_parse_error;
 
         bool follow;
@@ -109,6 +122,7 @@ static void request_meta_free(
         sd_journal_close(m->journal);
 
         safe_fclose(m->tmp);
+        free(m->compressed);
 
         free(m->cursor);
         free(m);
@@ -148,6 +162,89 @@ static int request_meta_ensure_tmp(RequestMeta *m) {
         return 0;
 }
 
+static int request_reader_next_entry(RequestMeta *m) {
+        int r;
+
+        assert(m);
+
+        /* Moves to the next entry to serialize. Returns > 0 if there is one, 0 at the end of the stream, and
+         * -EAGAIN if we are following the journal and there is nothing new right now. */
+
+        if (m->n_entries_set &&
+            m->n_entries <= 0)
+                return 0;
+
+        if (m->n_skip < 0)
+                r = sd_journal_previous_skip(m->journal, (uint64_t) -m->n_skip + 1);
+        else if (m->n_skip > 0)
+                r = sd_journal_next_skip(m->journal, (uint64_t) m->n_skip + 1);
+        else
+                r = sd_journal_next(m->journal);
+        if (r < 0)
+                return log_error_errno(r, "Failed to advance journal pointer: %m");
+        if (r == 0)
+                return m->follow ? -EAGAIN : 0;
+
+        if (m->discrete) {
+                assert(m->cursor);
+
+                r = sd_journal_test_cursor(m->journal, m->cursor);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to test cursor: %m");
+                if (r == 0)
+                        return 0;
+        }
+
+        if (m->until_set) {
+                usec_t usec;
+
+                r = sd_journal_get_realtime_usec(m->journal, &usec);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to determine timestamp: %m");
+                if (usec > m->until)
+                        return 0;
+        }
+
+        if (m->n_entries_set)
+                m->n_entries -= 1;
+
+        m->n_skip = 0;
+
+        return 1;
+}
+
+static int request_meta_compress_tmp(RequestMeta *m, uint64_t size) {
+        _cleanup_free_ void *plain = NULL;
+        size_t k;
+        int r;
+
+        assert(m);
+        assert(m->tmp);
+        assert(size > 0);
+
+        plain = malloc(size);
+        if (!plain)
+                return -ENOMEM;
+
+        rewind(m->tmp);
+
+        errno = 0;
+        if (fread(plain, 1, size, m->tmp) != size)
+                return errno_or_else(EIO);
+
+        /* Enough for the compressed data even if the input is incompressible */
+        if (!GREEDY_REALLOC(m->compressed, size + size / 128 + 1024))
+                return -ENOMEM;
+        m->compressed_allocated = MALLOC_SIZEOF_SAFE(m->compressed);
+
+        r = compress_blob(m->compression, plain, size, m->compressed, m->compressed_allocated, &k, /* level = */ -1);
+        if (r < 0)
+                return r;
+
+        m->size = k;
+        return 0;
+}
+
 static ssize_t request_reader_entries(
                 void *cls,
                 uint64_t pos,
@@ -167,110 +264,89 @@ static ssize_t request_reader_entries(
         pos -= m->delta;
 
         while (pos >= m->size) {
-                off_t sz;
-
-                /* End of this entry, so let's serialize the next
-                 * one */
-
-                if (m->n_entries_set &&
-                    m->n_entries <= 0)
-                        return MHD_CONTENT_READER_END_OF_STREAM;
+                unsigned n_batch = 0;
+                off_t sz = 0;
 
-                if (m->n_skip < 0)
-                        r = sd_journal_previous_skip(m->journal, (uint64_t) -m->n_skip + 1);
-                else if (m->n_skip > 0)
-                        r = sd_journal_next_skip(m->journal, (uint64_t) m->n_skip + 1);
-                else
-                        r = sd_journal_next(m->journal);
+                /* End of this batch, so let's serialize the next one. We don't wait for more entries once
+                 * we have something to send, so that followers get to see new entries right away. */
 
+                r = request_meta_ensure_tmp(m);
                 if (r < 0) {
-                        log_error_errno(r, "Failed to advance journal pointer: %m");
+                        log_error_errno(r, "Failed to create temporary file: %m");
                         return MHD_CONTENT_READER_END_WITH_ERROR;
-                } else if (r == 0) {
+                }
 
-                        if (m->follow) {
+                for (;;) {
+                        r = request_reader_next_entry(m);
+                        if (r == -EAGAIN && n_batch == 0) {
                                 r = sd_journal_wait(m->journal, (uint64_t) JOURNAL_WAIT_TIMEOUT);
                                 if (r < 0) {
                                         log_error_errno(r, "Couldn't wait for journal event: %m");
                                         return MHD_CONTENT_READER_END_WITH_ERROR;
                                 }
                                 if (r == SD_JOURNAL_NOP)
-                                        break;
+                                        return 0;
 
                                 continue;
                         }
-
-                        return MHD_CONTENT_READER_END_OF_STREAM;
-                }
-
-                if (m->discrete) {
-                        assert(m->cursor);
-
-                        r = sd_journal_test_cursor(m->journal, m->cursor);
-                        if (r < 0) {
-                                log_error_errno(r, "Failed to test cursor: %m");
+                        if (r == -EAGAIN)
+                                break;
+                        if (r < 0)
                                 return MHD_CONTENT_READER_END_WITH_ERROR;
+                        if (r == 0) {
+                                if (n_batch == 0)
+                                        return MHD_CONTENT_READER_END_OF_STREAM;
+                                break;
                         }
 
-                        if (r == 0)
-                                return MHD_CONTENT_READER_END_OF_STREAM;
-                }
-
-                if (m->until_set) {
-                        usec_t usec;
-
-                        r = sd_journal_get_realtime_usec(m->journal, &usec);
+                        r = show_journal_entry(m->tmp, m->journal, m->mode, 0, OUTPUT_FULL_WIDTH,
+                                               NULL, NULL, NULL, &previous_ts, &previous_boot_id);
                         if (r < 0) {
-                                log_error_errno(r, "Failed to determine timestamp: %m");
+                                log_error_errno(r, "Failed to serialize item: %m");
                                 return MHD_CONTENT_READER_END_WITH_ERROR;
                         }
-                        if (usec > m->until)
-                                return MHD_CONTENT_READER_END_OF_STREAM;
-                }
-                pos -= m->size;
-                m->delta += m->size;
 
-                if (m->n_entries_set)
-                        m->n_entries -= 1;
+                        n_batch++;
 
-                m->n_skip = 0;
+                        sz = ftello(m->tmp);
+                        if (sz < 0) {
+                                log_error_errno(errno, "Failed to retrieve file position: %m");
+                                return MHD_CONTENT_READER_END_WITH_ERROR;
+                        }
 
-                r = request_meta_ensure_tmp(m);
-                if (r < 0) {
-                        log_error_errno(r, "Failed to create temporary file: %m");
-                        return MHD_CONTENT_READER_END_WITH_ERROR;
+                        if ((uint64_t) sz >= ENTRIES_BATCH_SIZE)
+                                break;
                 }
 
-                r = show_journal_entry(m->tmp, m->journal, m->mode, 0, OUTPUT_FULL_WIDTH,
-                                   NULL, NULL, NULL, &previous_ts, &previous_boot_id);
-                if (r < 0) {
-                        log_error_errno(r, "Failed to serialize item: %m");
-                        return MHD_CONTENT_READER_END_WITH_ERROR;
-                }
+                pos -= m->size;
+                m->delta += m->size;
+                m->size = (uint64_t) sz;
 
-                sz = ftello(m->tmp);
-                if (sz < 0) {
-                        log_error_errno(errno, "Failed to retrieve file position: %m");
-                        return MHD_CONTENT_READER_END_WITH_ERROR;
+                if (m->compression != COMPRESSION_NONE && sz > 0) {
+                        r = request_meta_compress_tmp(m, (uint64_t) sz);
+                        if (r < 0) {
+                                log_error_errno(r, "Failed to compress entries: %m");
+                                return MHD_CONTENT_READER_END_WITH_ERROR;
+                        }
                 }
-
-                m->size = (uint64_t) sz;
         }
 
-        if (m->tmp == NULL && m->follow)
+        n = m->size - pos;
+        if (n < 1)
                 return 0;
+        if (n > max)
+                n = max;
+
+        if (m->compression != COMPRESSION_NONE) {
+                memcpy(buf, (uint8_t*) m->compressed + pos, n);
+                return (ssize_t) n;
+        }
 
         if (fseeko(m->tmp, pos, SEEK_SET) < 0) {
                 log_error_errno(errno, "Failed to seek to position: %m");
                 return MHD_CONTENT_READER_END_WITH_ERROR;
         }
 
-        n = m->size - pos;
-        if (n < 1)
-                return 0;
-        if (n > max)
-                n = max;
-
         errno = 0;
         k = fread(buf, 1, n, m->tmp);
         if (k != n) {
@@ -308,6 +384,52 @@ static int request_parse_accept(
         return 0;
 }
 
+static int request_parse_accept_encoding(
+                RequestMeta *m,
+                struct MHD_Connection *connection) {
+
+        const char *header;
+        int r;
+
+        assert(m);
+        assert(connection);
+
+        /* Only zstd is offered, as the only one of our compression algorithms that is also a registered
+         * HTTP content coding. Each batch of entries is compressed as a separate frame, which is fine
+         * since a zstd stream may consist of multiple frames. */
+
+        m->compression = COMPRESSION_NONE;
+
+        header = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Accept-Encoding");
+        if (!header)
+                return 0;
+
+        for (const char *p = header;;) {
+                _cleanup_free_ char *word = NULL;
+                char *params;
+
+                r = extract_first_word(&p, &word, ",", 0);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        return 0;
+
+                params = strchr(word, ';');
+                if (params) {
+                        *params++ = 0;
+
+                        /* A quality of zero means the coding is not acceptable */
+                        if (STR_IN_SET(delete_chars(params, WHITESPACE), "q=0", "q=0.0", "q=0.00", "q=0.000"))
+                                continue;
+                }
+
+                if (streq(strstrip(word), "zstd") && compression_supported(COMPRESSION_ZSTD)) {
+                        m->compression = COMPRESSION_ZSTD;
+                        return 0;
+                }
+        }
+}
+
 static int request_parse_range_skip_and_n_entries(
                 RequestMeta *m,
                 const char *colon) {
@@ -593,11 +715,19 @@ static int request_handler_entries(
         if (r < 0)
                 return mhd_respond(connection, MHD_HTTP_BAD_REQUEST, "Failed to seek in journal.");
 
-        response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, 4*1024, request_reader_entries, m, NULL);
+        if (request_parse_accept_encoding(m, connection) < 0)
+                return mhd_respond(connection, MHD_HTTP_BAD_REQUEST, "Failed to parse Accept-Encoding header.");
+
+        response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, ENTRIES_BATCH_SIZE, request_reader_entries, m, NULL);
         if (!response)
                 return respond_oom(connection);
 
-        if (MHD_add_response_header(response, "Content-Type", mime_types[m->mode]) == MHD_NO)
+        if (MHD_add_response_header(response, "Content-Type", mime_types[m->mode]) == MHD_NO ||
+            MHD_add_response_header(response, "Vary", "Accept-Encoding") == MHD_NO)
+                return respond_oom(connection);
+
+        if (m->compression != COMPRESSION_NONE &&
+            MHD_add_response_header(response, "Content-Encoding", compression_lowercase_to_string(m->compression)) == MHD_NO)
                 return respond_oom(connection);
 
         return MHD_queue_response(connection, MHD_HTTP_OK, response);
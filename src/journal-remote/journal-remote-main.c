@@ -46,6 +46,7 @@ static char **arg_gnutls_log = NULL;
 
 static JournalWriteSplitMode arg_split_mode = _JOURNAL_WRITE_SPLIT_INVALID;
 static char *arg_output = NULL;
+static unsigned arg_workers = 0;
 
 static char *arg_key = NULL;
 static char *arg_cert = NULL;
@@ -772,6 +773,7 @@ static int parse_config(void) {
         const ConfigTableItem items[] = {
                 { "Remote",  "Seal",                   config_parse_bool,             0, &arg_seal        },
                 { "Remote",  "SplitMode",              config_parse_write_split_mode, 0, &arg_split_mode  },
+                { "Remote",  "Workers",                config_parse_unsigned,         0, &arg_workers     },
                 { "Remote",  "ServerKeyFile",          config_parse_path,             0, &arg_key         },
                 { "Remote",  "ServerCertificateFile",  config_parse_path,             0, &arg_cert        },
                 { "Remote",  "TrustedCertificateFile", config_parse_path_or_ignore,   0, &arg_trust       },
@@ -820,6 +822,7 @@ static int help(void) {
                "     --gnutls-log=CATEGORY...\n"
                "                            Specify a list of gnutls logging categories\n"
                "     --split-mode=none|host How many output files to create\n"
+               "     --workers=N            Write raw connections from N threads\n"
                "\nNote: file descriptors from sd_listen_fds() will be consumed, too.\n"
                "\nSee the %s for details.\n",
                program_invocation_short_name,
@@ -843,6 +846,7 @@ static int parse_argv(int argc, char *argv[]) {
                 ARG_CERT,
                 ARG_TRUST,
                 ARG_GNUTLS_LOG,
+                ARG_WORKERS,
         };
 
         static const struct option options[] = {
@@ -861,6 +865,7 @@ static int parse_argv(int argc, char *argv[]) {
                 { "cert",         required_argument, NULL, ARG_CERT         },
                 { "trust",        required_argument, NULL, ARG_TRUST        },
                 { "gnutls-log",   required_argument, NULL, ARG_GNUTLS_LOG   },
+                { "workers",      required_argument, NULL, ARG_WORKERS      },
                 {}
         };
 
@@ -961,6 +966,12 @@ static int parse_argv(int argc, char *argv[]) {
                                 return log_error_errno(arg_split_mode, "Invalid split mode: %s", optarg);
                         break;
 
+                case ARG_WORKERS:
+                        r = safe_atou(optarg, &arg_workers);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse --workers= argument: %s", optarg);
+                        break;
+
                 case ARG_COMPRESS:
                         r = parse_boolean_argument("--compress", optarg, &arg_compress);
                         if (r < 0)
@@ -1041,13 +1052,25 @@ static int parse_argv(int argc, char *argv[]) {
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
                                        "For SplitMode=host, output must be a directory.");
 
+        if (arg_workers > 0 && arg_split_mode != JOURNAL_WRITE_SPLIT_HOST)
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
+                                       "Worker threads can only be used with SplitMode=host.");
+
+        /* Entries received via HTTP(S) or pulled via --url= are written by the main thread, which would
+         * end up appending to the same per-host files as the workers, through a separate writer. */
+        if (arg_workers > 0 &&
+            (arg_listen_http || arg_listen_https || http_socket >= 0 || https_socket >= 0 || arg_url))
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
+                                       "Worker threads cannot be used together with --listen-http=, --listen-https= or --url=.");
+
         if (STRPTR_IN_SET(arg_trust, "-", "all")) {
                 arg_trust_all = true;
                 arg_trust = mfree(arg_trust);
         }
 
-        log_debug("Full config: SplitMode=%s Key=%s Cert=%s Trust=%s",
+        log_debug("Full config: SplitMode=%s Workers=%u Key=%s Cert=%s Trust=%s",
                   journal_write_split_mode_to_string(arg_split_mode),
+                  arg_workers,
                   strna(arg_key),
                   strna(arg_cert),
                   strna(arg_trust));
@@ -1143,6 +1166,11 @@ static int run(int argc, char **argv) {
         if (r < 0)
                 return r;
 
+        /* Start the workers only now, so that they inherit the complete configuration */
+        r = journal_remote_start_workers(&s, arg_workers);
+        if (r < 0)
+                return r;
+
         r = sd_event_set_watchdog(s.event, true);
         if (r < 0)
                 return log_error_errno(r, "Failed to enable watchdog: %m");
@@ -1166,6 +1194,9 @@ static int run(int argc, char **argv) {
                         return log_error_errno(r, "Failed to run event loop: %m");
         }
 
+        /* Wait for the workers to close their files, and collect their counters */
+        journal_remote_stop_workers(&s);
+
         notify_message = NULL;
         (void) sd_notifyf(false,
                           "STOPPING=1\n"
@@ -2,6 +2,7 @@
 
 #include "alloc-util.h"
 #include "fd-util.h"
+#include "format-util.h"
 #include "journal-remote-parse.h"
 #include "parse-util.h"
 #include "string-util.h"
@@ -10,6 +11,14 @@ RemoteSource* source_free(RemoteSource *source) {
         if (!source)
                 return NULL;
 
+        if (source->n_entries > 0)
+                log_debug("Source %s wrote %"PRIu64" entries (%s), backlogged %"PRIu64" times, largest backlog %s.",
+                          strna(source->importer.name),
+                          source->n_entries,
+                          FORMAT_BYTES(source->n_bytes),
+                          source->n_backlogged,
+                          FORMAT_BYTES(source->max_backlog));
+
         journal_importer_cleanup(&source->importer);
 
         log_trace("Writer ref count %u", source->writer->n_ref);
@@ -79,8 +88,11 @@ int process_source(RemoteSource *source, JournalFileFlags file_flags) {
         } else if (r < 0)
                 log_error_errno(r, "Failed to write entry of %zu bytes: %m",
                                 iovw_size(&source->importer.iovw));
-        else
+        else {
+                source->n_entries++;
+                source->n_bytes += iovw_size(&source->importer.iovw);
                 r = 1;
+        }
 
  freeing:
         journal_importer_drop_iovw(&source->importer);
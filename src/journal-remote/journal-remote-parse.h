@@ -16,6 +16,12 @@ typedef struct RemoteSource {
         sd_event_source *buffer_event;
         Compression compression;
         char *encoding;
+
+        /* Statistics, logged when the source goes away */
+        uint64_t n_entries;
+        uint64_t n_bytes;
+        uint64_t n_backlogged;   /* how often an entry was written with more data already queued behind it */
+        size_t max_backlog;      /* the largest amount of data we had received but not processed yet */
 } RemoteSource;
 
 RemoteSource* source_new(int fd, bool passive_fd, char *name, Writer *writer);
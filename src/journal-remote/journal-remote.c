@@ -2,9 +2,12 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <sys/prctl.h>
 #include <stdint.h>
+#include <unistd.h>
 
 #include "sd-daemon.h"
 
@@ -21,6 +24,7 @@
 #include "parse-util.h"
 #include "parse-helpers.h"
 #include "process-util.h"
+#include "siphash24.h"
 #include "socket-util.h"
 #include "stdio-util.h"
 #include "string-util.h"
@@ -364,6 +368,8 @@ void journal_remote_server_destroy(RemoteServer *s) {
         if (!s)
                 return;
 
+        journal_remote_stop_workers(s);
+
 #if HAVE_MICROHTTPD
         hashmap_free_with_destructor(s->daemons, MHDDaemonWrapper_free);
 #endif
@@ -431,8 +437,19 @@ int journal_remote_handle_raw_source(
                 log_debug_errno(r, "Closing connection: %m");
                 remove_source(s, fd);
                 return 0;
-        } else
+        } else {
+                size_t remaining;
+
+                /* If more data is queued up behind the entry we just wrote, the sender is faster than we
+                 * are. Keep track of that, so that overloaded collectors can be spotted. */
+                remaining = journal_importer_bytes_remaining(&source->importer);
+                if (r > 0 && remaining > 0) {
+                        source->n_backlogged++;
+                        source->max_backlog = MAX(source->max_backlog, remaining);
+                }
+
                 return 1;
+        }
 }
 
 static int dispatch_raw_source_until_block(sd_event_source *event,
@@ -445,7 +462,7 @@ static int dispatch_raw_source_until_block(sd_event_source *event,
         /* Make sure event stays around even if source is destroyed */
         sd_event_source_ref(event);
 
-        r = journal_remote_handle_raw_source(event, source->importer.fd, EPOLLIN, journal_remote_server_global);
+        r = journal_remote_handle_raw_source(event, source->importer.fd, EPOLLIN, source->writer->server);
         if (r != 1) {
                 int k;
 
@@ -470,7 +487,7 @@ static int dispatch_raw_source_event(sd_event_source *event,
         assert(source->event);
         assert(source->buffer_event);
 
-        r = journal_remote_handle_raw_source(event, fd, EPOLLIN, journal_remote_server_global);
+        r = journal_remote_handle_raw_source(event, fd, EPOLLIN, source->writer->server);
         if (r == 1) {
                 int k;
 
@@ -488,7 +505,283 @@ static int dispatch_blocking_source_event(sd_event_source *event,
                                           void *userdata) {
         RemoteSource *source = ASSERT_PTR(userdata);
 
-        return journal_remote_handle_raw_source(event, source->importer.fd, EPOLLIN, journal_remote_server_global);
+        return journal_remote_handle_raw_source(event, source->importer.fd, EPOLLIN, source->writer->server);
+}
+
+/**********************************************************************
+ **********************************************************************
+ **********************************************************************/
+
+struct RemoteWorker {
+        RemoteServer server;
+        pthread_t thread;
+        bool thread_started;
+        bool exited;            /* set by the worker thread once it stopped picking up connections */
+
+        /* Accepted connections are passed to the worker thread through this pipe */
+        int queue_fd[2];
+};
+
+typedef struct RemoteHandoff {
+        int fd;
+        char *name;
+} RemoteHandoff;
+
+/* The handoff messages are written in one go and must hence never be split up by the kernel */
+assert_cc(sizeof(RemoteHandoff) <= PIPE_BUF);
+
+static RemoteWorker* remote_worker_free(RemoteWorker *w) {
+        if (!w)
+                return NULL;
+
+        /* Closing the write end makes the worker thread exit its event loop */
+        w->queue_fd[1] = safe_close(w->queue_fd[1]);
+
+        if (w->thread_started)
+                (void) pthread_join(w->thread, NULL);
+
+        /* Connections that were handed off but never picked up */
+        if (w->queue_fd[0] >= 0)
+                for (;;) {
+                        RemoteHandoff h;
+
+                        if (read(w->queue_fd[0], &h, sizeof(h)) != sizeof(h))
+                                break;
+
+                        safe_close(h.fd);
+                        free(h.name);
+                }
+
+        safe_close(w->queue_fd[0]);
+
+        /* The worker thread already got rid of its sources and writers when it was done, this only releases
+         * whatever is left if the thread was never started. */
+        journal_remote_server_destroy(&w->server);
+
+        return mfree(w);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(RemoteWorker*, remote_worker_free);
+
+static int dispatch_worker_queue_event(sd_event_source *event, int fd, uint32_t revents, void *userdata) {
+        RemoteWorker *w = ASSERT_PTR(userdata);
+        RemoteServer *s = &w->server;
+
+        for (;;) {
+                RemoteHandoff h;
+                ssize_t n;
+                int r;
+
+                n = read(fd, &h, sizeof(h));
+                if (n < 0) {
+                        if (errno == EAGAIN)
+                                return 0;
+
+                        return sd_event_exit(s->event, log_error_errno(errno, "Failed to read from worker queue: %m"));
+                }
+                if (n == 0) {
+                        log_debug("Worker queue closed, exiting.");
+                        return sd_event_exit(s->event, 0);
+                }
+                if (n != sizeof(h))
+                        return sd_event_exit(s->event, log_error_errno(SYNTHETIC_ERRNO(EIO), "Short read from worker queue."));
+
+                r = journal_remote_add_source(s, h.fd, h.name, /* own_name = */ true);
+                if (r < 0 && (h.fd >= (ssize_t) MALLOC_ELEMENTSOF(s->sources) || !s->sources[h.fd]))
+                        /* If the source was never registered nobody closed the connection yet */
+                        safe_close(h.fd);
+        }
+}
+
+static void* remote_worker_thread(void *p) {
+        RemoteWorker *w = ASSERT_PTR(p);
+        RemoteServer *s = &w->server;
+        int r;
+
+        (void) prctl(PR_SET_NAME, (unsigned long) "remote-worker");
+
+        r = sd_event_new(&s->event);
+        if (r < 0) {
+                log_error_errno(r, "Failed to allocate worker event loop: %m");
+                goto finish;
+        }
+
+        r = sd_event_add_io(s->event, &s->listen_event, w->queue_fd[0], EPOLLIN, dispatch_worker_queue_event, w);
+        if (r < 0) {
+                log_error_errno(r, "Failed to watch worker queue: %m");
+                goto finish;
+        }
+
+        r = sd_event_loop(s->event);
+        if (r < 0)
+                log_error_errno(r, "Failed to run worker event loop: %m");
+
+finish:
+        __atomic_store_n(&w->exited, true, __ATOMIC_RELEASE);
+
+        /* Close all sources and output files from the thread owning them. The event counter stays
+         * around, it is summed up by journal_remote_stop_workers(). */
+        for (size_t i = 0; i < MALLOC_ELEMENTSOF(s->sources); i++)
+                remove_source(s, i);
+        s->sources = mfree(s->sources);
+
+        s->listen_event = sd_event_source_disable_unref(s->listen_event);
+        s->event = sd_event_unref(s->event);
+
+        return NULL;
+}
+
+static int remote_worker_new(RemoteServer *parent, RemoteWorker **ret) {
+        _cleanup_(remote_worker_freep) RemoteWorker *w = NULL;
+        int r;
+
+        assert(parent);
+        assert(ret);
+
+        w = new(RemoteWorker, 1);
+        if (!w)
+                return -ENOMEM;
+
+        *w = (RemoteWorker) {
+                .server = {
+                        .output = parent->output,
+                        .split_mode = parent->split_mode,
+                        .file_flags = parent->file_flags,
+                        .check_trust = parent->check_trust,
+                        .metrics = parent->metrics,
+                },
+                .queue_fd = EBADF_PAIR,
+        };
+
+        r = init_writer_hashmap(&w->server);
+        if (r < 0)
+                return r;
+
+        /* The worker reads without blocking from its event loop, while we block when writing, which
+         * throttles accepting new connections if a worker can't keep up. */
+        if (pipe2(w->queue_fd, O_CLOEXEC) < 0)
+                return -errno;
+
+        r = fd_nonblock(w->queue_fd[0], true);
+        if (r < 0)
+                return r;
+
+        *ret = TAKE_PTR(w);
+        return 0;
+}
+
+int journal_remote_start_workers(RemoteServer *s, size_t n) {
+        sigset_t ss, saved_ss;
+        int r, k;
+
+        assert(s);
+        assert(s->n_workers == 0);
+
+        if (n == 0)
+                return 0;
+
+        /* Each worker owns the writers for the hosts assigned to it, which only works if output files
+         * are per host. */
+        if (s->split_mode != JOURNAL_WRITE_SPLIT_HOST)
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Worker threads require SplitMode=host.");
+
+        s->workers = new0(RemoteWorker*, n);
+        if (!s->workers)
+                return log_oom();
+
+        for (size_t i = 0; i < n; i++) {
+                r = remote_worker_new(s, &s->workers[i]);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to allocate worker: %m");
+
+                s->n_workers++;
+        }
+
+        /* No signals in worker threads please, they are all handled by the main event loop */
+        assert_se(sigfillset(&ss) >= 0);
+        r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+        if (r > 0)
+                return log_error_errno(r, "Failed to block signals: %m");
+
+        FOREACH_ARRAY(i, s->workers, s->n_workers) {
+                r = pthread_create(&(*i)->thread, NULL, remote_worker_thread, *i);
+                if (r > 0) {
+                        r = log_error_errno(r, "Failed to start worker thread: %m");
+                        break;
+                }
+
+                (*i)->thread_started = true;
+                r = 0;
+        }
+
+        k = pthread_sigmask(SIG_SETMASK, &saved_ss, NULL);
+        if (k > 0 && r >= 0)
+                r = log_error_errno(k, "Failed to restore signal mask: %m");
+        if (r < 0)
+                return r;
+
+        log_debug("Started %zu worker threads.", s->n_workers);
+        return 0;
+}
+
+void journal_remote_stop_workers(RemoteServer *s) {
+        assert(s);
+
+        FOREACH_ARRAY(i, s->workers, s->n_workers) {
+                RemoteWorker *w = *i;
+
+                /* First tell everybody to stop, so that the workers wind down in parallel */
+                w->queue_fd[1] = safe_close(w->queue_fd[1]);
+        }
+
+        FOREACH_ARRAY(i, s->workers, s->n_workers) {
+                RemoteWorker *w = *i;
+
+                log_debug("Worker %zu wrote %" PRIu64 " entries.", (size_t) (i - s->workers), w->server.event_count);
+                s->event_count += w->server.event_count;
+
+                remote_worker_free(w);
+        }
+
+        s->workers = mfree(s->workers);
+        s->n_workers = 0;
+}
+
+static int remote_worker_handoff(RemoteServer *s, int fd, char *name) {
+        static const uint8_t hash_key[16] = {};
+        RemoteWorker *w;
+        size_t i;
+        int r;
+
+        /* This takes ownership of fd and name, even on failure. */
+
+        assert(s);
+        assert(s->n_workers > 0);
+        assert(fd >= 0);
+        assert(name);
+
+        /* All connections from the same host have to end up in the same worker, since the worker owns the
+         * output file for it. */
+        i = siphash24_string(name, hash_key) % s->n_workers;
+        w = s->workers[i];
+
+        if (__atomic_load_n(&w->exited, __ATOMIC_ACQUIRE)) {
+                log_warning("Worker %zu is gone, refusing connection from %s.", i, name);
+                safe_close(fd);
+                free(name);
+                return 0;
+        }
+
+        log_debug("Handing off connection fd:%d (%s) to worker %zu.", fd, name, i);
+
+        if (write(w->queue_fd[1], &(RemoteHandoff) { .fd = fd, .name = name }, sizeof(RemoteHandoff)) != sizeof(RemoteHandoff)) {
+                r = log_error_errno(errno, "Failed to hand off connection to worker %zu: %m", i);
+                safe_close(fd);
+                free(name);
+                return r;
+        }
+
+        return 0;
 }
 
 static int accept_connection(
@@ -564,5 +857,8 @@ static int dispatch_raw_connection_event(
         if (fd2 < 0)
                 return fd2;
 
+        if (s->n_workers > 0)
+                return remote_worker_handoff(s, fd2, hostname);
+
         return journal_remote_add_source(s, fd2, hostname, true);
 }
@@ -25,6 +25,8 @@ MHDDaemonWrapper* MHDDaemonWrapper_free(MHDDaemonWrapper *d);
 DEFINE_TRIVIAL_CLEANUP_FUNC(MHDDaemonWrapper*, MHDDaemonWrapper_free);
 #endif
 
+typedef struct RemoteWorker RemoteWorker;
+
 struct RemoteServer {
         RemoteSource **sources;
         size_t active;
@@ -45,6 +47,11 @@ struct RemoteServer {
         JournalFileFlags file_flags;
         bool check_trust;
         JournalMetrics metrics;
+
+        /* Raw connections are handed off to these, if any. Each worker runs its own event loop and
+         * writers in a separate thread. */
+        RemoteWorker **workers;
+        size_t n_workers;
 };
 extern RemoteServer *journal_remote_server_global;
 
@@ -57,6 +64,9 @@ int journal_remote_server_init(
                 JournalWriteSplitMode split_mode,
                 JournalFileFlags file_flags);
 
+int journal_remote_start_workers(RemoteServer *s, size_t n);
+void journal_remote_stop_workers(RemoteServer *s);
+
 int journal_remote_get_writer(RemoteServer *s, const char *host, Writer **writer);
 
 int journal_remote_add_source(RemoteServer *s, int fd, char *name, bool own_name);
@@ -6,6 +6,7 @@
 #include "sd-daemon.h"
 
 #include "alloc-util.h"
+#include "event-util.h"
 #include "journal-upload.h"
 #include "log.h"
 #include "string-util.h"
@@ -337,12 +338,170 @@ void close_journal_input(Uploader *u) {
         u->timeout = 0;
 }
 
+/* Leave some room for incompressible data, the compressors add a small header */
+#define BATCH_COMPRESSED_SIZE(n) ((n) + (n) / 8 + 1024)
+#define BATCH_GROW 65536U
+
+static int batch_append_entry(Uploader *u) {
+        assert(u);
+
+        u->entry_state = ENTRY_CURSOR;
+
+        while (u->entry_state != ENTRY_DONE) {
+                ssize_t w;
+
+                /* Make sure there's always enough space for the fixed size parts of an entry, so that
+                 * write_entry() keeps making progress. */
+                if (!GREEDY_REALLOC(u->batch, u->batch_size + BATCH_GROW))
+                        return log_oom();
+
+                w = write_entry(u->batch + u->batch_size, MALLOC_SIZEOF_SAFE(u->batch) - u->batch_size, u);
+                if (w < 0)
+                        return w;
+
+                u->batch_size += w;
+        }
+
+        u->batch_n_entries++;
+        return 0;
+}
+
+static int start_batch_upload(Uploader *u) {
+        const void *data;
+        size_t size;
+        CURLcode code;
+        int r;
+
+        assert(u);
+        assert(u->batch_n_entries > 0);
+
+        (void) event_source_disable(u->batch_timer);
+
+        /* Unlike streamed uploads, which compress every chunk curl asks for separately, the batch is
+         * compressed in one go, which is both cheaper and compresses better. */
+        if (u->compression) {
+                if (!GREEDY_REALLOC(u->batch_compressed, BATCH_COMPRESSED_SIZE(u->batch_size)))
+                        return log_oom();
+
+                r = compress_blob(u->compression->algorithm, u->batch, u->batch_size,
+                                  u->batch_compressed, MALLOC_SIZEOF_SAFE(u->batch_compressed),
+                                  &u->batch_compressed_size, u->compression->level);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to compress batch of %zu bytes by %s with level %i: %m",
+                                               u->batch_size,
+                                               compression_lowercase_to_string(u->compression->algorithm),
+                                               u->compression->level);
+
+                data = u->batch_compressed;
+                size = u->batch_compressed_size;
+        } else {
+                data = u->batch;
+                size = u->batch_size;
+        }
+
+        log_debug("Uploading batch of %zu entries (%zu bytes, %zu bytes on the wire).",
+                  u->batch_n_entries, u->batch_size, size);
+
+        r = start_upload(u, journal_input_callback, u);
+        if (r < 0)
+                return r;
+
+        /* With the body in memory curl doesn't call the read callback, and sends a Content-Length
+         * header instead of chunking the body. */
+        code = curl_easy_setopt(u->easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t) size);
+        if (code)
+                return log_error_errno(SYNTHETIC_ERRNO(EXFULL),
+                                       "curl_easy_setopt CURLOPT_POSTFIELDSIZE_LARGE failed: %s",
+                                       curl_easy_strerror(code));
+
+        code = curl_easy_setopt(u->easy, CURLOPT_POSTFIELDS, data);
+        if (code)
+                return log_error_errno(SYNTHETIC_ERRNO(EXFULL),
+                                       "curl_easy_setopt CURLOPT_POSTFIELDS failed: %s",
+                                       curl_easy_strerror(code));
+
+        return 0;
+}
+
+static int dispatch_batch_timer(sd_event_source *s, uint64_t usec, void *userdata) {
+        Uploader *u = ASSERT_PTR(userdata);
+
+        if (u->uploading || u->batch_n_entries == 0)
+                return 0;
+
+        log_debug("Batch timeout reached, uploading %zu entries.", u->batch_n_entries);
+        return start_batch_upload(u);
+}
+
+static int process_journal_batch(Uploader *u, int skip) {
+        int r;
+
+        assert(u);
+
+        check_update_watchdog(u);
+
+        u->batch_more = false;
+
+        while (u->batch_n_entries < u->batch_max_entries) {
+                r = sd_journal_next_skip(u->journal, skip);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to skip to next entry: %m");
+                if (r < skip)
+                        break;
+
+                skip = 1;
+
+                r = batch_append_entry(u);
+                if (r < 0)
+                        return r;
+
+                log_debug("Entry %zu (%s) has been added to the batch.",
+                          u->entries_sent, u->current_cursor);
+        }
+
+        if (u->batch_n_entries >= u->batch_max_entries) {
+                u->batch_more = true;
+                return start_batch_upload(u);
+        }
+
+        if (!u->input_event) {
+                /* We are not following the journal, hence there's nothing worth waiting for. The journal
+                 * is closed only once the last batch went out, since that ends the main loop. */
+                if (u->batch_n_entries > 0)
+                        return start_batch_upload(u);
+
+                log_info("No more entries, closing journal.");
+                close_journal_input(u);
+                return 0;
+        }
+
+        if (u->batch_n_entries == 0)
+                return 0;
+
+        /* Wait a bit for more entries, but only if we aren't waiting already, so that a steady trickle of
+         * entries doesn't delay the upload indefinitely. */
+        if (u->batch_timer && sd_event_source_get_enabled(u->batch_timer, NULL) > 0)
+                return 0;
+
+        r = event_reset_time_relative(u->event, &u->batch_timer, CLOCK_MONOTONIC,
+                                      u->batch_timeout_usec, 0,
+                                      dispatch_batch_timer, u,
+                                      SD_EVENT_PRIORITY_NORMAL, "batch-timer", /* force_reset = */ true);
+        if (r < 0)
+                return log_error_errno(r, "Failed to set up batch timer: %m");
+
+        return 0;
+}
+
 static int process_journal_input(Uploader *u, int skip) {
         int r;
 
         if (u->uploading)
                 return 0;
 
+        if (u->batch_max_entries > 0)
+                return process_journal_batch(u, skip);
+
         r = sd_journal_next_skip(u->journal, skip);
         if (r < 0)
                 return log_error_errno(r, "Failed to skip to next entry: %m");
@@ -365,7 +524,8 @@ int check_journal_input(Uploader *u) {
                         return r;
                 }
 
-                if (r == SD_JOURNAL_NOP)
+                /* A full batch might have left entries behind, which won't be announced again */
+                if (r == SD_JOURNAL_NOP && !u->batch_more)
                         return 0;
         }
 
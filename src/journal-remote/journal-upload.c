@@ -60,6 +60,8 @@ static char *arg_save_state = NULL;
 static usec_t arg_network_timeout_usec = USEC_INFINITY;
 static OrderedHashmap *arg_compression = NULL;
 static bool arg_force_compression = false;
+static unsigned arg_batch_entries = 0;
+static usec_t arg_batch_timeout_usec = JOURNAL_UPLOAD_BATCH_TIMEOUT_DEFAULT;
 
 STATIC_DESTRUCTOR_REGISTER(arg_url, freep);
 STATIC_DESTRUCTOR_REGISTER(arg_key, freep);
@@ -205,10 +207,13 @@ int start_upload(Uploader *u,
                 if (!h)
                         return log_oom();
 
-                l = curl_slist_append(h, "Transfer-Encoding: chunked");
-                if (!l)
-                        return log_oom();
-                h = l;
+                /* Batches are sent in one piece, with a Content-Length header */
+                if (u->batch_max_entries == 0) {
+                        l = curl_slist_append(h, "Transfer-Encoding: chunked");
+                        if (!l)
+                                return log_oom();
+                        h = l;
+                }
 
                 l = curl_slist_append(h, "Accept: text/plain");
                 if (!l)
@@ -276,6 +281,16 @@ int start_upload(Uploader *u,
                             "systemd-journal-upload " GIT_VERSION,
                             LOG_WARNING, );
 
+                if (u->batch_max_entries > 0) {
+                        /* Batches are lots of short requests, make sure they all travel over the same
+                         * connection, and prefer HTTP/2 where the server supports it. curl keeps the
+                         * connection of an easy handle open between requests by itself. */
+                        easy_setopt(curl, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2TLS,
+                                    LOG_DEBUG, );
+                        easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L,
+                                    LOG_DEBUG, );
+                }
+
                 if (!streq_ptr(arg_key, "-") && (arg_key || startswith(u->url, "https://"))) {
                         easy_setopt(curl, CURLOPT_SSLKEY, arg_key ?: PRIV_KEY_FILE,
                                     LOG_ERR, return -EXFULL);
@@ -486,6 +501,10 @@ static void destroy_uploader(Uploader *u) {
 
         free(u->url);
 
+        free(u->batch);
+        free(u->batch_compressed);
+        u->batch_timer = sd_event_source_disable_unref(u->batch_timer);
+
         u->input_event = sd_event_source_unref(u->input_event);
 
         close_fd_input(u);
@@ -647,6 +666,9 @@ static int perform_upload(Uploader *u) {
 
         free_and_replace(u->last_cursor, u->current_cursor);
 
+        /* The batch has been acknowledged, start over with the next one. The buffers are kept for reuse. */
+        u->batch_size = u->batch_n_entries = 0;
+
         return update_cursor_state(u);
 }
 
@@ -659,6 +681,8 @@ static int parse_config(void) {
                 { "Upload",  "NetworkTimeoutSec",      config_parse_sec,            0,                        &arg_network_timeout_usec },
                 { "Upload",  "Compression",            config_parse_compression,    /* with_level */ true,    &arg_compression          },
                 { "Upload",  "ForceCompression",       config_parse_bool,           0,                        &arg_force_compression    },
+                { "Upload",  "BatchEntries",           config_parse_unsigned,       0,                        &arg_batch_entries        },
+                { "Upload",  "BatchTimeoutSec",        config_parse_sec,            0,                        &arg_batch_timeout_usec   },
                 {}
         };
 
@@ -943,6 +967,10 @@ static int run(int argc, char **argv) {
         use_journal = optind >= argc;
         if (use_journal) {
                 sd_journal *j;
+
+                u.batch_max_entries = arg_batch_entries;
+                u.batch_timeout_usec = arg_batch_timeout_usec;
+
                 r = open_journal(&j);
                 if (r < 0)
                         return r;
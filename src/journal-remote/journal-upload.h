@@ -55,9 +55,20 @@ typedef struct Uploader {
         usec_t watchdog_timestamp;
         usec_t watchdog_usec;
         const CompressionConfig *compression;
+
+        /* batched uploads, only used for journal input */
+        size_t batch_max_entries;       /* 0 if entries are streamed in a single request instead */
+        usec_t batch_timeout_usec;
+        sd_event_source *batch_timer;
+        char *batch;
+        size_t batch_size, batch_n_entries;
+        void *batch_compressed;
+        size_t batch_compressed_size;
+        bool batch_more;                /* the last batch was full, and more entries might be pending */
 } Uploader;
 
 #define JOURNAL_UPLOAD_POLL_TIMEOUT (10 * USEC_PER_SEC)
+#define JOURNAL_UPLOAD_BATCH_TIMEOUT_DEFAULT (500 * USEC_PER_MSEC)
 
 int start_upload(Uploader *u,
                  size_t (*input_callback)(void *ptr,
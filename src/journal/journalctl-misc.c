@@ -1,15 +1,23 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <poll.h>
+
+#include "cpu-set-util.h"
 #include "dirent-util.h"
 #include "fd-util.h"
 #include "format-table.h"
 #include "format-util.h"
+#include "io-util.h"
+#include "journal-file-util.h"
 #include "journal-internal.h"
 #include "journal-verify.h"
 #include "journalctl.h"
+#include "journalctl-filter.h"
 #include "journalctl-misc.h"
 #include "journalctl-util.h"
 #include "logs-show.h"
+#include "mmap-cache.h"
+#include "process-util.h"
 #include "syslog-util.h"
 
 int action_print_header(void) {
@@ -26,9 +34,224 @@ int action_print_header(void) {
         return 0;
 }
 
+typedef struct VerifyResult {
+        int error;
+        usec_t first, validated, last;
+} VerifyResult;
+
+typedef struct VerifyJob {
+        JournalFile *file;
+        pid_t pid;
+        int fd;
+        bool done;
+        VerifyResult result;
+} VerifyJob;
+
+static void verify_job_array_free(VerifyJob *jobs, size_t n) {
+        FOREACH_ARRAY(job, jobs, n) {
+                if (job->pid > 0)
+                        sigkill_wait(job->pid);
+                safe_close(job->fd);
+        }
+
+        free(jobs);
+}
+
+static int verify_result_log(JournalFile *f, const VerifyResult *result) {
+        char a[FORMAT_TIMESTAMP_MAX], b[FORMAT_TIMESTAMP_MAX];
+
+        assert(f);
+        assert(result);
+
+        if (result->error < 0)
+                return log_warning_errno(result->error, "FAIL: %s (%m)", f->path);
+
+        log_full(arg_quiet ? LOG_DEBUG : LOG_INFO, "PASS: %s", f->path);
+
+        if (arg_verify_key && JOURNAL_HEADER_SEALED(f->header)) {
+                if (result->validated > 0) {
+                        log_full(arg_quiet ? LOG_DEBUG : LOG_INFO,
+                                 "=> Validated from %s to %s, final %s entries not sealed.",
+                                 format_timestamp_maybe_utc(a, sizeof(a), result->first),
+                                 format_timestamp_maybe_utc(b, sizeof(b), result->validated),
+                                 FORMAT_TIMESPAN(result->last > result->validated ? result->last - result->validated : 0, 0));
+                } else if (result->last > 0)
+                        log_full(arg_quiet ? LOG_DEBUG : LOG_INFO,
+                                 "=> No sealing yet, %s of entries not sealed.",
+                                 FORMAT_TIMESPAN(result->last - result->first, 0));
+                else
+                        log_full(arg_quiet ? LOG_DEBUG : LOG_INFO,
+                                 "=> No sealing yet, no entries in file.");
+        }
+
+        return 0;
+}
+
+static void verify_one(JournalFile *f, bool show_progress, VerifyResult *ret) {
+        assert(f);
+        assert(ret);
+
+#if HAVE_GCRYPT
+        if (!arg_verify_key && JOURNAL_HEADER_SEALED(f->header))
+                log_notice("Journal file %s has sealing enabled but verification key has not been passed using --verify-key=.", f->path);
+#endif
+
+        *ret = (VerifyResult) {};
+        ret->error = journal_file_verify(f, arg_verify_key, &ret->first, &ret->validated, &ret->last, show_progress);
+}
+
+static int verify_job_start(VerifyJob *job) {
+        _cleanup_close_pair_ int pfd[2] = EBADF_PAIR;
+        int r;
+
+        assert(job);
+
+        if (pipe2(pfd, O_CLOEXEC) < 0)
+                return log_error_errno(errno, "Failed to create pipe: %m");
+
+        r = safe_fork("(journal-verify)", FORK_RESET_SIGNALS|FORK_DEATHSIG_SIGTERM|FORK_LOG, &job->pid);
+        if (r < 0)
+                return r;
+        if (r == 0) {
+                VerifyResult result;
+
+                /* Child. The file was opened and mapped by the parent, we simply continue to use our copy of
+                 * it. No progress output though, it would get garbled with several workers. */
+
+                pfd[0] = safe_close(pfd[0]);
+
+                verify_one(job->file, /* show_progress = */ false, &result);
+
+                r = loop_write(pfd[1], &result, sizeof(result));
+                if (r < 0) {
+                        log_error_errno(r, "Failed to send verification result: %m");
+                        _exit(EXIT_FAILURE);
+                }
+
+                _exit(EXIT_SUCCESS);
+        }
+
+        job->fd = TAKE_FD(pfd[0]);
+        return 0;
+}
+
+static int verify_job_collect(VerifyJob *jobs, size_t n_jobs) {
+        _cleanup_free_ struct pollfd *pollfds = NULL;
+        _cleanup_free_ VerifyJob **running = NULL;
+        VerifyJob *job = NULL;
+        size_t n_running = 0;
+        int r;
+
+        /* Find out which worker finished first by waiting for its result pipe to become readable, which
+         * happens once it wrote the result or died. Only our own workers are waited for then, since
+         * waiting for any child could reap (and lose the exit status of) children that aren't ours. */
+
+        pollfds = new(struct pollfd, n_jobs);
+        running = new(VerifyJob*, n_jobs);
+        if (!pollfds || !running)
+                return log_oom();
+
+        FOREACH_ARRAY(i, jobs, n_jobs) {
+                if (i->done || i->pid <= 0)
+                        continue;
+
+                pollfds[n_running] = (struct pollfd) {
+                        .fd = i->fd,
+                        .events = POLLIN,
+                };
+                running[n_running++] = i;
+        }
+
+        if (n_running == 0)
+                return 0;
+
+        r = ppoll_usec(pollfds, n_running, USEC_INFINITY);
+        if (r == -EINTR)
+                return 0;
+        if (r < 0)
+                return log_error_errno(r, "Failed to wait for worker processes: %m");
+
+        for (size_t i = 0; i < n_running; i++)
+                if (pollfds[i].revents != 0) {
+                        job = running[i];
+                        break;
+                }
+        if (!job)
+                return 0;
+
+        r = wait_for_terminate_and_check("(journal-verify)", TAKE_PID(job->pid), WAIT_LOG);
+        if (r < 0)
+                return r;
+
+        if (r == EXIT_SUCCESS) {
+                r = loop_read_exact(job->fd, &job->result, sizeof(job->result), /* do_poll = */ false);
+                if (r < 0)
+                        job->result.error = log_error_errno(r, "Failed to read verification result for %s: %m", job->file->path);
+        } else
+                job->result.error = -EPROTO;
+
+        job->fd = safe_close(job->fd);
+        job->done = true;
+        return 1;
+}
+
+static int verify_parallel(sd_journal *j, unsigned n_workers) {
+        VerifyJob *jobs = NULL;
+        size_t n_jobs = 0, n_started = 0, n_running = 0, n_logged = 0;
+        JournalFile *f;
+        int r = 0, k;
+
+        CLEANUP_ARRAY(jobs, n_jobs, verify_job_array_free);
+
+        assert(j);
+        assert(n_workers > 1);
+
+        jobs = new(VerifyJob, ordered_hashmap_size(j->files));
+        if (!jobs)
+                return log_oom();
+
+        ORDERED_HASHMAP_FOREACH(f, j->files)
+                jobs[n_jobs++] = (VerifyJob) {
+                        .file = f,
+                        .fd = -EBADF,
+                };
+
+        while (n_logged < n_jobs) {
+                while (n_running < n_workers && n_started < n_jobs) {
+                        k = verify_job_start(jobs + n_started);
+                        if (k < 0)
+                                return k;
+
+                        n_started++;
+                        n_running++;
+                }
+
+                k = verify_job_collect(jobs, n_started);
+                if (k < 0)
+                        return k;
+                if (k > 0)
+                        n_running--;
+
+                /* Report results in the order of the files, not in the order the workers finished */
+                for (; n_logged < n_started && jobs[n_logged].done; n_logged++) {
+                        if (jobs[n_logged].result.error == -EINVAL)
+                                /* If the key was invalid give up right-away. */
+                                return jobs[n_logged].result.error;
+
+                        RET_GATHER(r, verify_result_log(jobs[n_logged].file, &jobs[n_logged].result));
+                }
+        }
+
+        return r;
+}
+
 int action_verify(void) {
         _cleanup_(sd_journal_closep) sd_journal *j = NULL;
-        int r;
+        uint64_t n_bytes = 0, n_objects = 0;
+        unsigned n_workers;
+        usec_t start, d;
+        JournalFile *f;
+        int r, k;
 
         assert(arg_action == ACTION_VERIFY);
 
@@ -38,43 +261,41 @@ int action_verify(void) {
 
         log_show_color(true);
 
-        JournalFile *f;
         ORDERED_HASHMAP_FOREACH(f, j->files) {
-                int k;
-                usec_t first = 0, validated = 0, last = 0;
+                n_bytes += (uint64_t) f->last_stat.st_size;
+                n_objects += le64toh(f->header->n_objects);
+        }
 
-#if HAVE_GCRYPT
-                if (!arg_verify_key && JOURNAL_HEADER_SEALED(f->header))
-                        log_notice("Journal file %s has sealing enabled but verification key has not been passed using --verify-key=.", f->path);
-#endif
+        start = now(CLOCK_MONOTONIC);
 
-                k = journal_file_verify(f, arg_verify_key, &first, &validated, &last, /* show_progress = */ !arg_quiet);
-                if (k == -EINVAL)
-                        /* If the key was invalid give up right-away. */
-                        return k;
-                if (k < 0)
-                        r = log_warning_errno(k, "FAIL: %s (%m)", f->path);
-                else {
-                        char a[FORMAT_TIMESTAMP_MAX], b[FORMAT_TIMESTAMP_MAX];
-                        log_full(arg_quiet ? LOG_DEBUG : LOG_INFO, "PASS: %s", f->path);
-
-                        if (arg_verify_key && JOURNAL_HEADER_SEALED(f->header)) {
-                                if (validated > 0) {
-                                        log_full(arg_quiet ? LOG_DEBUG : LOG_INFO,
-                                                 "=> Validated from %s to %s, final %s entries not sealed.",
-                                                 format_timestamp_maybe_utc(a, sizeof(a), first),
-                                                 format_timestamp_maybe_utc(b, sizeof(b), validated),
-                                                 FORMAT_TIMESPAN(last > validated ? last - validated : 0, 0));
-                                } else if (last > 0)
-                                        log_full(arg_quiet ? LOG_DEBUG : LOG_INFO,
-                                                 "=> No sealing yet, %s of entries not sealed.",
-                                                 FORMAT_TIMESPAN(last - first, 0));
-                                else
-                                        log_full(arg_quiet ? LOG_DEBUG : LOG_INFO,
-                                                 "=> No sealing yet, no entries in file.");
-                        }
+        /* Verification is CPU bound (hashing, decompression, HMAC), hence verify as many files at once as
+         * we have CPUs. */
+        k = cpus_in_affinity_mask();
+        n_workers = MIN((unsigned) MAX(k, 1), ordered_hashmap_size(j->files));
+
+        if (n_workers > 1)
+                r = verify_parallel(j, n_workers);
+        else
+                ORDERED_HASHMAP_FOREACH(f, j->files) {
+                        VerifyResult result;
+
+                        verify_one(f, /* show_progress = */ !arg_quiet, &result);
+                        if (result.error == -EINVAL)
+                                /* If the key was invalid give up right-away. */
+                                return result.error;
+
+                        RET_GATHER(r, verify_result_log(f, &result));
                 }
-        }
+        if (r == -EINVAL)
+                return r;
+
+        d = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+        log_full(arg_quiet ? LOG_DEBUG : LOG_INFO,
+                 "Verified %u journal files (%s, %" PRIu64 " objects) in %s using %u workers, %s/s, %" PRIu64 " objects/s.",
+                 ordered_hashmap_size(j->files), FORMAT_BYTES(n_bytes), n_objects,
+                 FORMAT_TIMESPAN(d, USEC_PER_MSEC), MAX(n_workers, 1u),
+                 FORMAT_BYTES(d > 0 ? n_bytes * USEC_PER_SEC / d : n_bytes),
+                 d > 0 ? n_objects * USEC_PER_SEC / d : n_objects);
 
         return r;
 }
@@ -98,6 +319,115 @@ int action_disk_usage(void) {
         return 0;
 }
 
+int action_merge_into(char **matches) {
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_(journal_file_offline_closep) JournalFile *to = NULL;
+        _cleanup_(journal_file_copy_cache_done) JournalFileCopyCache cache = {};
+        uint64_t n_entries = 0, n_bytes = 0;
+        JournalFile *f;
+        int r;
+
+        assert(arg_action == ACTION_MERGE_INTO);
+        assert(arg_merge_into);
+
+        /* Copies all matching entries of the selected journal files into a single new journal file. Data
+         * objects are stored only once per file, hence folding many archives that carry largely the same
+         * payloads (e.g. the per-host files journal-remote writes for a fleet of similar machines) into
+         * one file stores those payloads once instead of once per archive. Per-machine filtering keeps
+         * working, since the entries retain their _MACHINE_ID= and _HOSTNAME= fields. */
+
+        r = acquire_journal(&j);
+        if (r < 0)
+                return r;
+
+        r = add_filters(j, matches);
+        if (r < 0)
+                return r;
+
+        ORDERED_HASHMAP_FOREACH(f, j->files)
+                n_bytes += (uint64_t) f->last_stat.st_size;
+
+        m = mmap_cache_new();
+        if (!m)
+                return log_oom();
+
+        /* Entries from different sources are interleaved by time, which isn't necessarily strictly ordered
+         * across machines, hence don't use JOURNAL_STRICT_ORDER here. */
+        r = journal_file_open(
+                        /* fd= */ -EBADF,
+                        arg_merge_into,
+                        O_RDWR|O_CREAT|O_EXCL,
+                        JOURNAL_COMPRESS,
+                        0640,
+                        /* compress_threshold_bytes= */ UINT64_MAX,
+                        /* metrics= */ NULL,
+                        m,
+                        /* template= */ NULL,
+                        &to);
+        if (r < 0)
+                return log_error_errno(r, "Failed to create journal file %s: %m", arg_merge_into);
+
+        sd_journal_set_data_threshold(j, 0);
+
+        if (arg_since_set)
+                r = sd_journal_seek_realtime_usec(j, arg_since);
+        else
+                r = sd_journal_seek_head(j);
+        if (r < 0)
+                return log_error_errno(r, "Failed to seek in journal: %m");
+
+        for (;;) {
+                Object *o;
+                usec_t usec;
+
+                r = sd_journal_next(j);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to iterate through journal: %m");
+                if (r == 0)
+                        break;
+
+                if (arg_until_set) {
+                        r = sd_journal_get_realtime_usec(j, &usec);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to determine timestamp: %m");
+                        if (usec > arg_until)
+                                break;
+                }
+
+                f = j->current_file;
+                assert(f && f->current_offset > 0);
+
+                r = journal_file_move_to_object(f, OBJECT_ENTRY, f->current_offset, &o);
+                if (r < 0) {
+                        log_warning_errno(r, "Failed to read entry from %s, skipping: %m", f->path);
+                        continue;
+                }
+
+                r = journal_file_copy_entry(f, to, o, f->current_offset, /* seqnum= */ NULL, /* seqnum_id= */ NULL, &cache);
+                if (IN_SET(r, -EBADMSG, -EPROTONOSUPPORT)) {
+                        /* Corrupted entry or unsupported compression in the source file, skip it */
+                        log_warning_errno(r, "Failed to copy entry from %s, skipping: %m", f->path);
+                        continue;
+                }
+                if (r < 0)
+                        return log_error_errno(r, "Failed to write entry to %s: %m", arg_merge_into);
+
+                n_entries++;
+        }
+
+        r = journal_file_fstat(to);
+        if (r < 0)
+                return log_error_errno(r, "Failed to stat %s: %m", arg_merge_into);
+
+        if (!arg_quiet)
+                log_info("Merged %" PRIu64 " entries from %u journal files (%s) into %s (%s).",
+                         n_entries, ordered_hashmap_size(j->files), FORMAT_BYTES(n_bytes),
+                         arg_merge_into, FORMAT_BYTES((uint64_t) to->last_stat.st_size));
+
+        return 0;
+}
+
 static int show_log_ids(const LogId *ids, size_t n_ids, const char *name) {
         _cleanup_(table_unrefp) Table *table = NULL;
         int r;
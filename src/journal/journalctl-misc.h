@@ -6,6 +6,7 @@
 int action_print_header(void);
 int action_verify(void);
 int action_disk_usage(void);
+int action_merge_into(char **matches);
 int action_list_boots(void);
 int action_list_fields(void);
 int action_list_field_names(void);
@@ -25,11 +25,13 @@ typedef struct Context {
         sd_id128_t previous_boot_id;
         sd_id128_t previous_boot_id_output;
         dual_timestamp previous_ts_output;
+        JournalColumnarWriter *columnar_writer;
 } Context;
 
 static void context_done(Context *c) {
         assert(c);
 
+        journal_columnar_writer_free(c->columnar_writer);
         sd_journal_close(c->journal);
 }
 
@@ -241,9 +243,12 @@ static int show(Context *c) {
                         }
                 }
 
-                r = show_journal_entry(stdout, j, arg_output, 0, flags,
-                                       arg_output_fields, highlight, &c->ellipsized,
-                                       &c->previous_ts_output, &c->previous_boot_id_output);
+                if (c->columnar_writer)
+                        r = journal_columnar_writer_add(c->columnar_writer, j);
+                else
+                        r = show_journal_entry(stdout, j, arg_output, 0, flags,
+                                               arg_output_fields, highlight, &c->ellipsized,
+                                               &c->previous_ts_output, &c->previous_boot_id_output);
                 c->need_seek = true;
                 if (r == -EADDRNOTAVAIL)
                         break;
@@ -275,6 +280,8 @@ static int show_and_fflush(Context *c, sd_event_source *s) {
         assert(s);
 
         r = show(c);
+        if (r >= 0 && c->columnar_writer)
+                r = journal_columnar_writer_flush(c->columnar_writer);
         if (r < 0)
                 return sd_event_exit(sd_event_source_get_event(s), r);
 
@@ -399,6 +406,12 @@ int action_show(char **matches) {
         if (r < 0)
                 return r;
 
+        if (arg_output == OUTPUT_EXPORT_COLUMNAR) {
+                r = journal_columnar_writer_new(stdout, arg_output_fields, &c.columnar_writer);
+                if (r < 0)
+                        return log_oom();
+        }
+
         /* Opening the fd now means the first sd_journal_wait() will actually wait */
         if (arg_follow) {
                 poll_fd = sd_journal_get_fd(c.journal);
@@ -460,6 +473,12 @@ int action_show(char **matches) {
                 return r;
         n_shown = r;
 
+        if (c.columnar_writer) {
+                r = journal_columnar_writer_flush(c.columnar_writer);
+                if (r < 0)
+                        return r;
+        }
+
         if (n_shown == 0 && !arg_quiet)
                 printf("-- No entries --\n");
 
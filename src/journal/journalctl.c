@@ -5,6 +5,7 @@
 #include "sd-journal.h"
 
 #include "build.h"
+#include "env-util.h"
 #include "glob-util.h"
 #include "id128-print.h"
 #include "journalctl.h"
@@ -88,6 +89,7 @@ char *arg_namespace = NULL;
 uint64_t arg_vacuum_size = 0;
 uint64_t arg_vacuum_n_files = 0;
 usec_t arg_vacuum_time = 0;
+char *arg_merge_into = NULL;
 Set *arg_output_fields = NULL;
 char *arg_pattern = NULL;
 pcre2_code *arg_compiled_pattern = NULL;
@@ -108,6 +110,7 @@ STATIC_DESTRUCTOR_REGISTER(arg_user_units, strv_freep);
 STATIC_DESTRUCTOR_REGISTER(arg_field, freep);
 STATIC_DESTRUCTOR_REGISTER(arg_root, freep);
 STATIC_DESTRUCTOR_REGISTER(arg_image, freep);
+STATIC_DESTRUCTOR_REGISTER(arg_merge_into, freep);
 STATIC_DESTRUCTOR_REGISTER(arg_machine, freep);
 STATIC_DESTRUCTOR_REGISTER(arg_namespace, freep);
 STATIC_DESTRUCTOR_REGISTER(arg_output_fields, set_freep);
@@ -287,6 +290,7 @@ static int help(void) {
                "     --vacuum-files=INT      Leave only the specified number of journal files\n"
                "     --vacuum-time=TIME      Remove journal files older than specified time\n"
                "     --verify                Verify journal file consistency\n"
+               "     --merge-into=FILE       Copy matching entries into a single new journal file\n"
                "     --sync                  Synchronize unwritten journal messages to disk\n"
                "     --relinquish-var        Stop logging to disk, log to temporary file system\n"
                "     --smart-relinquish-var  Similar, but NOP if log directory is on root mount\n"
@@ -331,6 +335,7 @@ static int parse_argv(int argc, char *argv[]) {
                 ARG_VERIFY,
                 ARG_VERIFY_KEY,
                 ARG_DISK_USAGE,
+                ARG_MERGE_INTO,
                 ARG_AFTER_CURSOR,
                 ARG_CURSOR_FILE,
                 ARG_SHOW_CURSOR,
@@ -398,6 +403,7 @@ static int parse_argv(int argc, char *argv[]) {
                 { "verify",               no_argument,       NULL, ARG_VERIFY               },
                 { "verify-key",           required_argument, NULL, ARG_VERIFY_KEY           },
                 { "disk-usage",           no_argument,       NULL, ARG_DISK_USAGE           },
+                { "merge-into",           required_argument, NULL, ARG_MERGE_INTO           },
                 { "cursor",               required_argument, NULL, 'c'                      },
                 { "cursor-file",          required_argument, NULL, ARG_CURSOR_FILE          },
                 { "after-cursor",         required_argument, NULL, ARG_AFTER_CURSOR         },
@@ -468,7 +474,7 @@ static int parse_argv(int argc, char *argv[]) {
                         if (arg_output < 0)
                                 return log_error_errno(arg_output, "Unknown output format '%s'.", optarg);
 
-                        if (IN_SET(arg_output, OUTPUT_EXPORT, OUTPUT_JSON, OUTPUT_JSON_PRETTY, OUTPUT_JSON_SSE, OUTPUT_JSON_SEQ, OUTPUT_CAT))
+                        if (IN_SET(arg_output, OUTPUT_EXPORT, OUTPUT_EXPORT_COLUMNAR, OUTPUT_JSON, OUTPUT_JSON_PRETTY, OUTPUT_JSON_SSE, OUTPUT_JSON_SEQ, OUTPUT_CAT))
                                 arg_quiet = true;
 
                         if (OUTPUT_MODE_IS_JSON(arg_output))
@@ -670,6 +676,18 @@ static int parse_argv(int argc, char *argv[]) {
                         arg_action = ACTION_DISK_USAGE;
                         break;
 
+                case ARG_MERGE_INTO:
+                        if (!endswith(optarg, ".journal"))
+                                return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
+                                                       "Journal file name must end in .journal: %s", optarg);
+
+                        r = parse_path_argument(optarg, /* suppress_root= */ false, &arg_merge_into);
+                        if (r < 0)
+                                return r;
+
+                        arg_action = ACTION_MERGE_INTO;
+                        break;
+
                 case ARG_VACUUM_SIZE:
                         r = parse_size(optarg, 1024, &arg_vacuum_size);
                         if (r < 0)
@@ -1018,7 +1036,7 @@ static int parse_argv(int argc, char *argv[]) {
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
                                        "--lines=+N is unsupported when --reverse or --follow is specified.");
 
-        if (!IN_SET(arg_action, ACTION_SHOW, ACTION_DUMP_CATALOG, ACTION_LIST_CATALOG) && optind < argc)
+        if (!IN_SET(arg_action, ACTION_SHOW, ACTION_MERGE_INTO, ACTION_DUMP_CATALOG, ACTION_LIST_CATALOG) && optind < argc)
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
                                        "Extraneous arguments starting with '%s'",
                                        argv[optind]);
@@ -1053,7 +1071,13 @@ static int parse_argv(int argc, char *argv[]) {
         }
 
         if (!arg_follow)
-                arg_journal_additional_open_flags = SD_JOURNAL_ASSUME_IMMUTABLE;
+                arg_journal_additional_open_flags |= SD_JOURNAL_ASSUME_IMMUTABLE;
+
+        r = getenv_bool("SYSTEMD_JOURNAL_PARALLEL");
+        if (r < 0 && r != -ENXIO)
+                log_debug_errno(r, "Failed to parse $SYSTEMD_JOURNAL_PARALLEL, ignoring: %m");
+        if (r > 0)
+                arg_journal_additional_open_flags |= SD_JOURNAL_PARALLEL;
 
         return 1;
 }
@@ -1125,6 +1149,9 @@ static int run(int argc, char *argv[]) {
         case ACTION_DISK_USAGE:
                 return action_disk_usage();
 
+        case ACTION_MERGE_INTO:
+                return action_merge_into(args);
+
         case ACTION_LIST_BOOTS:
                 return action_list_boots();
 
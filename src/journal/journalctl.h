@@ -23,6 +23,7 @@ typedef enum JournalctlAction {
         ACTION_PRINT_HEADER,
         ACTION_VERIFY,
         ACTION_DISK_USAGE,
+        ACTION_MERGE_INTO,
         ACTION_LIST_BOOTS,
         ACTION_LIST_FIELDS,
         ACTION_LIST_FIELD_NAMES,
@@ -93,6 +94,7 @@ extern char *arg_namespace;
 extern uint64_t arg_vacuum_size;
 extern uint64_t arg_vacuum_n_files;
 extern usec_t arg_vacuum_time;
+extern char *arg_merge_into;
 extern Set *arg_output_fields;
 extern char *arg_pattern;
 extern pcre2_code *arg_compiled_pattern;
@@ -10,6 +10,7 @@
 #include "format-util.h"
 #include "iovec-util.h"
 #include "journald-console.h"
+#include "journald-forward.h"
 #include "journald-server.h"
 #include "parse-util.h"
 #include "process-util.h"
@@ -42,10 +43,10 @@ void server_forward_console(
         struct timespec ts;
         char tbuf[STRLEN("[] ") + DECIMAL_STR_MAX(ts.tv_sec) + DECIMAL_STR_MAX(ts.tv_nsec)-3 + 1];
         char header_pid[STRLEN("[]: ") + DECIMAL_STR_MAX(pid_t)];
+        ForwardQueue *q = &ASSERT_PTR(s)->forward_console_queue;
         _cleanup_free_ char *ident_buf = NULL;
-        _cleanup_close_ int fd = -EBADF;
         const char *tty, *color_on = "", *color_off = "";
-        int n = 0;
+        int n = 0, r;
 
         assert(s);
         assert(message);
@@ -94,14 +95,21 @@ void server_forward_console(
         /* Before you ask: yes, on purpose we open/close the console for each log line we write individually. This is a
          * good strategy to avoid journald getting killed by the kernel's SAK concept (it doesn't fix this entirely,
          * but minimizes the time window the kernel might end up killing journald due to SAK). It also makes things
-         * easier for us so that we don't have to recover from hangups and suchlike triggered on the console. */
-
-        fd = open_terminal(tty, O_WRONLY|O_NOCTTY|O_CLOEXEC);
-        if (fd < 0) {
-                log_debug_errno(fd, "Failed to open %s for logging: %m", tty);
-                return;
+         * easier for us so that we don't have to recover from hangups and suchlike triggered on the console. The
+         * exception is a console that is too slow to keep up (e.g. a serial console), which is kept open until
+         * everything queued up for it has been written out, as we never want to wait for it. */
+
+        if (q->fd < 0) {
+                q->fd = open_terminal(tty, O_WRONLY|O_NOCTTY|O_CLOEXEC|O_NONBLOCK);
+                if (q->fd < 0) {
+                        log_debug_errno(q->fd, "Failed to open %s for logging: %m", tty);
+                        return;
+                }
         }
 
-        if (writev(fd, iovec, n) < 0)
-                log_debug_errno(errno, "Failed to write to %s for logging: %m", tty);
+        r = forward_queue_write(s, q, iovec, n);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to write to %s for logging: %m", tty);
+                forward_queue_reset(q);
+        }
 }
@@ -50,6 +50,10 @@
  *    stream connection. This should improve cases where a service process logs immediately before exiting and we
  *    previously had trouble associating the log message with the service.
  *
+ * Metadata that is derived from the unit (invocation ID, log level, extra fields, …) is the same for all processes
+ * of a cgroup, and is kept in ClientCgroup objects shared between the contexts of one cgroup. These are also
+ * refreshed only every 1s, so that a refresh of a context of a busy service only needs to read /proc.
+ *
  * NB: With and without the metadata cache: the implicitly added entry metadata in the journal (with the exception of
  *     UID/PID/GID and SELinux label) must be understood as possibly slightly out of sync (i.e. sometimes slightly older
  *     and sometimes slightly newer than what was current at the log event).
@@ -92,6 +96,29 @@ static size_t cache_max(void) {
         return cached;
 }
 
+static ClientCgroup* client_cgroup_unref(Server *s, ClientCgroup *g) {
+        assert(s);
+
+        if (!g)
+                return NULL;
+
+        assert(g->n_ref > 0);
+        if (--g->n_ref > 0)
+                return NULL;
+
+        /* Only remove ourselves from the cache if we haven't been replaced by a newer object already */
+        if (g->path)
+                (void) hashmap_remove_value(s->client_cgroups, g->path, g);
+
+        free(g->path);
+        free(g->extra_fields_iovec);
+        free(g->extra_fields_data);
+        set_free(g->log_filter_allowed_patterns);
+        set_free(g->log_filter_denied_patterns);
+
+        return mfree(g);
+}
+
 static int client_context_compare(const void *a, const void *b) {
         const ClientContext *x = a, *y = b;
         int r;
@@ -128,7 +155,6 @@ static int client_context_new(Server *s, pid_t pid, ClientContext **ret) {
                 .owner_uid = UID_INVALID,
                 .lru_index = PRIOQ_IDX_NULL,
                 .timestamp = USEC_INFINITY,
-                .extra_fields_mtime = NSEC_INFINITY,
                 .log_level_max = -1,
                 .log_ratelimit_interval = s->ratelimit_interval,
                 .log_ratelimit_burst = s->ratelimit_burst,
@@ -172,18 +198,12 @@ static void client_context_reset(Server *s, ClientContext *c) {
         c->label = mfree(c->label);
         c->label_size = 0;
 
-        c->extra_fields_iovec = mfree(c->extra_fields_iovec);
-        c->extra_fields_n_iovec = 0;
-        c->extra_fields_data = mfree(c->extra_fields_data);
-        c->extra_fields_mtime = NSEC_INFINITY;
-
         c->log_level_max = -1;
 
         c->log_ratelimit_interval = s->ratelimit_interval;
         c->log_ratelimit_burst = s->ratelimit_burst;
 
-        c->log_filter_allowed_patterns = set_free_free(c->log_filter_allowed_patterns);
-        c->log_filter_denied_patterns = set_free_free(c->log_filter_denied_patterns);
+        c->cgroup_data = client_cgroup_unref(s, c->cgroup_data);
 
         c->capability_quintet = CAPABILITY_QUINTET_NULL;
 }
@@ -295,8 +315,6 @@ static int client_context_read_cgroup(Server *s, ClientContext *c, const char *u
                 return r;
         }
 
-        (void) client_context_read_log_filter_patterns(c, t);
-
         /* Let's shortcut this if the cgroup path didn't change */
         if (streq_ptr(c->cgroup, t))
                 return 0;
@@ -324,14 +342,11 @@ static int client_context_read_cgroup(Server *s, ClientContext *c, const char *u
         return 0;
 }
 
-static int client_context_read_invocation_id(
-                Server *s,
-                ClientContext *c) {
-
+static int client_cgroup_read_invocation_id(ClientCgroup *g, ClientContext *c) {
         _cleanup_free_ char *p = NULL, *value = NULL;
         int r;
 
-        assert(s);
+        assert(g);
         assert(c);
 
         /* Read the invocation ID of a unit off a unit.
@@ -355,17 +370,17 @@ static int client_context_read_invocation_id(
         if (r < 0)
                 return r;
 
-        return sd_id128_from_string(value, &c->invocation_id);
+        return sd_id128_from_string(value, &g->invocation_id);
 }
 
-static int client_context_read_log_level_max(
-                Server *s,
-                ClientContext *c) {
-
+static int client_cgroup_read_log_level_max(ClientCgroup *g, ClientContext *c) {
         _cleanup_free_ char *value = NULL;
         const char *p;
         int r, ll;
 
+        assert(g);
+        assert(c);
+
         if (!c->unit)
                 return 0;
 
@@ -378,53 +393,29 @@ static int client_context_read_log_level_max(
         if (ll < 0)
                 return ll;
 
-        c->log_level_max = ll;
+        g->log_level_max = ll;
         return 0;
 }
 
-static int client_context_read_extra_fields(
-                Server *s,
-                ClientContext *c) {
-
+static int client_cgroup_read_extra_fields(ClientCgroup *g, ClientContext *c) {
         _cleanup_free_ struct iovec *iovec = NULL;
         size_t size = 0, n_iovec = 0, left;
         _cleanup_free_ void *data = NULL;
-        _cleanup_fclose_ FILE *f = NULL;
-        struct stat st;
         const char *p;
         uint8_t *q;
         int r;
 
+        assert(g);
+        assert(c);
+
         if (!c->unit)
                 return 0;
 
         p = strjoina("/run/systemd/units/log-extra-fields:", c->unit);
 
-        if (c->extra_fields_mtime != NSEC_INFINITY) {
-                if (stat(p, &st) < 0) {
-                        if (errno == ENOENT)
-                                return 0;
-
-                        return -errno;
-                }
-
-                if (timespec_load_nsec(&st.st_mtim) == c->extra_fields_mtime)
-                        return 0;
-        }
-
-        f = fopen(p, "re");
-        if (!f) {
-                if (errno == ENOENT)
-                        return 0;
-
-                return -errno;
-        }
-
-        if (fstat(fileno(f), &st) < 0) /* The file might have been replaced since the stat() above, let's get a new
-                                        * one, that matches the stuff we are reading */
-                return -errno;
-
-        r = read_full_stream(f, (char**) &data, &size);
+        r = read_full_file(p, (char**) &data, &size);
+        if (r == -ENOENT)
+                return 0;
         if (r < 0)
                 return r;
 
@@ -461,22 +452,19 @@ static int client_context_read_extra_fields(
                 left -= n, q += n;
         }
 
-        free(c->extra_fields_iovec);
-        free(c->extra_fields_data);
-
-        c->extra_fields_iovec = TAKE_PTR(iovec);
-        c->extra_fields_n_iovec = n_iovec;
-        c->extra_fields_data = TAKE_PTR(data);
-        c->extra_fields_mtime = timespec_load_nsec(&st.st_mtim);
+        g->extra_fields_iovec = TAKE_PTR(iovec);
+        g->extra_fields_n_iovec = n_iovec;
+        g->extra_fields_data = TAKE_PTR(data);
 
         return 0;
 }
 
-static int client_context_read_log_ratelimit_interval(ClientContext *c) {
+static int client_cgroup_read_log_ratelimit_interval(ClientCgroup *g, ClientContext *c) {
         _cleanup_free_ char *value = NULL;
         const char *p;
         int r;
 
+        assert(g);
         assert(c);
 
         if (!c->unit)
@@ -487,14 +475,15 @@ static int client_context_read_log_ratelimit_interval(ClientContext *c) {
         if (r < 0)
                 return r;
 
-        return safe_atou64(value, &c->log_ratelimit_interval);
+        return safe_atou64(value, &g->log_ratelimit_interval);
 }
 
-static int client_context_read_log_ratelimit_burst(ClientContext *c) {
+static int client_cgroup_read_log_ratelimit_burst(ClientCgroup *g, ClientContext *c) {
         _cleanup_free_ char *value = NULL;
         const char *p;
         int r;
 
+        assert(g);
         assert(c);
 
         if (!c->unit)
@@ -505,7 +494,72 @@ static int client_context_read_log_ratelimit_burst(ClientContext *c) {
         if (r < 0)
                 return r;
 
-        return safe_atou(value, &c->log_ratelimit_burst);
+        return safe_atou(value, &g->log_ratelimit_burst);
+}
+
+static int client_context_read_cgroup_data(Server *s, ClientContext *c, usec_t timestamp) {
+        ClientCgroup *g;
+        int r;
+
+        assert(s);
+        assert(c);
+
+        /* All processes of a cgroup share the metadata of their unit, hence only read it once per refresh
+         * interval, regardless of how many processes of the cgroup are logging. */
+
+        if (c->cgroup) {
+                g = hashmap_get(s->client_cgroups, c->cgroup);
+                if (g && g->timestamp + REFRESH_USEC >= timestamp) {
+                        s->n_client_cgroup_hits++;
+                        g->n_ref++;
+                        goto finish;
+                }
+
+                s->n_client_cgroup_misses++;
+        }
+
+        g = new(ClientCgroup, 1);
+        if (!g)
+                return -ENOMEM;
+
+        /* Start out with what we know so far, so that we keep the old data for all we can't update */
+        *g = (ClientCgroup) {
+                .n_ref = 1,
+                .timestamp = timestamp,
+                .invocation_id = c->invocation_id,
+                .log_level_max = c->log_level_max,
+                .log_ratelimit_interval = c->log_ratelimit_interval,
+                .log_ratelimit_burst = c->log_ratelimit_burst,
+        };
+
+        (void) client_cgroup_read_invocation_id(g, c);
+        (void) client_cgroup_read_log_level_max(g, c);
+        (void) client_cgroup_read_extra_fields(g, c);
+        (void) client_cgroup_read_log_ratelimit_interval(g, c);
+        (void) client_cgroup_read_log_ratelimit_burst(g, c);
+
+        if (c->cgroup) {
+                (void) client_cgroup_read_log_filter_patterns(g, c->cgroup);
+
+                /* If this fails, the object is simply private to this context */
+                g->path = strdup(c->cgroup);
+                if (g->path) {
+                        r = hashmap_ensure_replace(&s->client_cgroups, &string_hash_ops, g->path, g);
+                        if (r < 0)
+                                g->path = mfree(g->path);
+                }
+        }
+
+finish:
+        client_cgroup_unref(s, c->cgroup_data);
+        c->cgroup_data = g;
+
+        c->invocation_id = g->invocation_id;
+        c->log_level_max = g->log_level_max;
+        c->log_ratelimit_interval = g->log_ratelimit_interval;
+        c->log_ratelimit_burst = g->log_ratelimit_burst;
+
+        return 0;
 }
 
 static void client_context_really_refresh(
@@ -531,11 +585,7 @@ static void client_context_really_refresh(
         (void) audit_loginuid_from_pid(&PIDREF_MAKE_FROM_PID(c->pid), &c->loginuid);
 
         (void) client_context_read_cgroup(s, c, unit_id);
-        (void) client_context_read_invocation_id(s, c);
-        (void) client_context_read_log_level_max(s, c);
-        (void) client_context_read_extra_fields(s, c);
-        (void) client_context_read_log_ratelimit_interval(c);
-        (void) client_context_read_log_ratelimit_burst(c);
+        (void) client_context_read_cgroup_data(s, c, timestamp);
 
         c->timestamp = timestamp;
 
@@ -653,9 +703,11 @@ void client_context_flush_all(Server *s) {
 
         assert(prioq_isempty(s->client_contexts_lru));
         assert(hashmap_isempty(s->client_contexts));
+        assert(hashmap_isempty(s->client_cgroups));
 
         s->client_contexts_lru = prioq_free(s->client_contexts_lru);
         s->client_contexts = hashmap_free(s->client_contexts);
+        s->client_cgroups = hashmap_free(s->client_cgroups);
 }
 
 static int client_context_get_internal(
@@ -678,6 +730,7 @@ static int client_context_get_internal(
 
         c = hashmap_get(s->client_contexts, PID_TO_PTR(pid));
         if (c) {
+                s->n_client_context_hits++;
 
                 if (add_ref) {
                         if (c->in_lru) {
@@ -696,6 +749,8 @@ static int client_context_get_internal(
                 return 0;
         }
 
+        s->n_client_context_misses++;
+
         client_context_try_shrink_to(s, cache_max()-1);
 
         r = client_context_new(s, pid, &c);
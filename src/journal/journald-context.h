@@ -12,9 +12,32 @@
 #include "time-util.h"
 
 typedef struct ClientContext ClientContext;
+typedef struct ClientCgroup ClientCgroup;
 
 #include "journald-server.h"
 
+/* Metadata that is derived from the unit a client belongs to, and hence is the same for all processes in a
+ * cgroup. Shared between all contexts of the cgroup, and never modified once created: a refresh creates a new
+ * object instead, so that the number of extra fields can't change under the feet of a context. */
+struct ClientCgroup {
+        unsigned n_ref;
+        char *path; /* NULL if the client's cgroup is unknown, in which case this is not in the cache */
+        usec_t timestamp;
+
+        sd_id128_t invocation_id;
+        int log_level_max;
+
+        struct iovec *extra_fields_iovec;
+        size_t extra_fields_n_iovec;
+        void *extra_fields_data;
+
+        usec_t log_ratelimit_interval;
+        unsigned log_ratelimit_burst;
+
+        Set *log_filter_allowed_patterns;
+        Set *log_filter_denied_patterns;
+};
+
 struct ClientContext {
         unsigned n_ref;
         unsigned lru_index;
@@ -50,16 +73,10 @@ struct ClientContext {
 
         int log_level_max;
 
-        struct iovec *extra_fields_iovec;
-        size_t extra_fields_n_iovec;
-        void *extra_fields_data;
-        nsec_t extra_fields_mtime;
-
         usec_t log_ratelimit_interval;
         unsigned log_ratelimit_burst;
 
-        Set *log_filter_allowed_patterns;
-        Set *log_filter_denied_patterns;
+        ClientCgroup *cgroup_data;
 };
 
 int client_context_get(
@@ -93,7 +110,7 @@ void client_context_flush_all(Server *s);
 void client_context_flush_regular(Server *s);
 
 static inline size_t client_context_extra_fields_n_iovec(const ClientContext *c) {
-        return c ? c->extra_fields_n_iovec : 0;
+        return c && c->cgroup_data ? c->cgroup_data->extra_fields_n_iovec : 0;
 }
 
 static inline bool client_context_test_priority(const ClientContext *c, int priority) {
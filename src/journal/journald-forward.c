@@ -0,0 +1,206 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "errno-util.h"
+#include "fd-util.h"
+#include "iovec-util.h"
+#include "journald-forward.h"
+#include "journald-server.h"
+#include "log.h"
+#include "memory-util.h"
+#include "socket-util.h"
+
+/* How much output to queue up per forwarding target at most, before dropping messages */
+#define FORWARD_QUEUE_SIZE_MAX (1U*1024U*1024U)
+
+/* How often to log about dropped messages per forwarding target at most */
+#define WARN_FORWARD_DROPPED_USEC (30 * USEC_PER_SEC)
+
+void forward_queue_reset(ForwardQueue *q) {
+        assert(q);
+
+        /* Drops everything queued, and closes the connection to the target */
+
+        q->event_source = sd_event_source_disable_unref(q->event_source);
+        q->fd = safe_close(q->fd);
+        q->connecting = false;
+        q->buffer = mfree(q->buffer);
+        q->size = 0;
+}
+
+static int forward_queue_dispatch(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
+        ForwardQueue *q = ASSERT_PTR(userdata);
+        ssize_t k;
+        int r;
+
+        assert(fd == q->fd);
+        assert(q->size > 0);
+
+        if (q->connecting) {
+                int error = 0;
+
+                /* The socket became writable, or failed. Find out whether the connection was established. */
+                r = getsockopt_int(q->fd, SOL_SOCKET, SO_ERROR, &error);
+                if (r < 0)
+                        error = -r;
+                else if (error == 0 && FLAGS_SET(revents, EPOLLERR))
+                        error = EIO;
+                if (error != 0) {
+                        log_debug_errno(error, "Failed to connect to %s for forwarding, dropping queued messages: %m", q->name);
+                        forward_queue_reset(q);
+                        return 0;
+                }
+
+                log_debug("Connected to %s for forwarding.", q->name);
+                q->connecting = false;
+        }
+
+        k = write(q->fd, q->buffer, q->size);
+        if (k < 0) {
+                if (ERRNO_IS_TRANSIENT(errno))
+                        return 0;
+
+                log_debug_errno(errno, "Failed to forward log messages to %s, dropping queued messages: %m", q->name);
+                forward_queue_reset(q);
+                return 0;
+        }
+
+        memmove(q->buffer, q->buffer + k, q->size - k);
+        q->size -= k;
+        if (q->size > 0)
+                return 0;
+
+        if (q->close_when_drained) {
+                forward_queue_reset(q);
+                return 0;
+        }
+
+        r = sd_event_source_set_enabled(q->event_source, SD_EVENT_OFF);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to disable %s forwarding event source, closing connection: %m", q->name);
+                forward_queue_reset(q);
+        }
+
+        return 0;
+}
+
+static int forward_queue_enable(Server *s, ForwardQueue *q) {
+        int r;
+
+        assert(s);
+        assert(q);
+
+        if (q->event_source)
+                return sd_event_source_set_enabled(q->event_source, SD_EVENT_ON);
+
+        if (!s->event || sd_event_get_state(s->event) == SD_EVENT_FINISHED)
+                return -ESTALE;
+
+        r = sd_event_add_io(s->event, &q->event_source, q->fd, EPOLLOUT, forward_queue_dispatch, q);
+        if (r < 0)
+                return r;
+
+        /* Forwarding is less important than reading and storing log messages */
+        r = sd_event_source_set_priority(q->event_source, SD_EVENT_PRIORITY_NORMAL+20);
+        if (r < 0)
+                return r;
+
+        (void) sd_event_source_set_description(q->event_source, q->name);
+        return 0;
+}
+
+int forward_queue_write(Server *s, ForwardQueue *q, const struct iovec *iovec, size_t n) {
+        size_t total, done = 0;
+        int r;
+
+        assert(s);
+        assert(q);
+        assert(q->fd >= 0);
+        assert(iovec || n == 0);
+
+        /* Writes the specified message to the target, or queues it up if that is not possible right away.
+         * The fd must be non-blocking. Returns 0 if the message was written, queued or dropped, and a
+         * negative errno on failure, in which case the caller should forward_queue_reset() the queue. While
+         * a non-blocking connect() is still in progress, everything is queued until forward_queue_dispatch()
+         * finds the connection established, since writing to the socket might fail with ENOTCONN until
+         * then. */
+
+        total = iovec_total_size(iovec, n);
+
+        if (q->size == 0 && !q->connecting) {
+                ssize_t k;
+
+                k = writev(q->fd, iovec, n);
+                if (k < 0) {
+                        if (!ERRNO_IS_TRANSIENT(errno))
+                                return -errno;
+                } else
+                        done = k;
+
+                if (done >= total) {
+                        if (q->close_when_drained)
+                                forward_queue_reset(q);
+                        return 0;
+                }
+
+        } else if (q->size + total > FORWARD_QUEUE_SIZE_MAX) {
+                /* Drop whole messages only, so that the output stays well-formed. */
+                q->n_dropped++;
+                return 0;
+        }
+
+        if (!GREEDY_REALLOC(q->buffer, q->size + total - done))
+                return -ENOMEM;
+
+        FOREACH_ARRAY(i, iovec, n) {
+                size_t skip = MIN(done, i->iov_len);
+
+                memcpy_safe(q->buffer + q->size, (uint8_t*) i->iov_base + skip, i->iov_len - skip);
+                q->size += i->iov_len - skip;
+                done -= skip;
+        }
+
+        r = forward_queue_enable(s, q);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to enable %s forwarding event source: %m", q->name);
+
+        return 0;
+}
+
+void forward_queue_done(ForwardQueue *q) {
+        assert(q);
+
+        /* Let's make one last attempt to get out what is still queued, without waiting for the target. */
+        if (q->fd >= 0 && q->size > 0)
+                (void) write(q->fd, q->buffer, q->size);
+
+        forward_queue_reset(q);
+}
+
+void server_maybe_warn_forward_dropped(Server *s, ForwardQueue *q) {
+        unsigned n_dropped;
+        usec_t n;
+
+        assert(s);
+        assert(q);
+
+        if (q->n_dropped <= 0)
+                return;
+
+        n = now(CLOCK_MONOTONIC);
+        if (q->last_warn_dropped + WARN_FORWARD_DROPPED_USEC > n)
+                return;
+
+        /* Reset the counter first, since the message below is forwarded too. */
+        n_dropped = TAKE_GENERIC(q->n_dropped, unsigned, 0);
+        q->last_warn_dropped = n;
+
+        server_driver_message(s, 0,
+                              NULL,
+                              LOG_MESSAGE("Forwarding to %s is too slow, dropped %u messages.",
+                                          q->name, n_dropped),
+                              NULL);
+}
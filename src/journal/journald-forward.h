@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <errno.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+
+#include "sd-event.h"
+
+#include "time-util.h"
+
+typedef struct ForwardQueue ForwardQueue;
+
+/* Output to a forwarding target (the console, or the ForwardToSocket= socket) that could not be written
+ * right away, because the target is slow or stuck. It is written out asynchronously from the event loop,
+ * so that log ingestion never blocks on a forwarding target. The amount of queued output is bounded, and
+ * messages that do not fit anymore are dropped and counted. */
+struct ForwardQueue {
+        const char *name;
+        int fd;
+        bool close_when_drained;
+        bool connecting; /* non-blocking connect() still in progress */
+        sd_event_source *event_source;
+        char *buffer;
+        size_t size;
+        unsigned n_dropped;
+        usec_t last_warn_dropped;
+};
+
+#define FORWARD_QUEUE_INIT(n, c)                \
+        (ForwardQueue) {                        \
+                .name = (n),                    \
+                .fd = -EBADF,                   \
+                .close_when_drained = (c),      \
+        }
+
+#include "journald-server.h"
+
+int forward_queue_write(Server *s, ForwardQueue *q, const struct iovec *iovec, size_t n);
+void forward_queue_reset(ForwardQueue *q);
+void forward_queue_done(ForwardQueue *q);
+
+void server_maybe_warn_forward_dropped(Server *s, ForwardQueue *q);
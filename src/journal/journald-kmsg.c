@@ -15,6 +15,7 @@
 #include "fd-util.h"
 #include "format-util.h"
 #include "fs-util.h"
+#include "hashmap.h"
 #include "iovec-util.h"
 #include "journal-internal.h"
 #include "journald-kmsg.h"
@@ -25,6 +26,35 @@
 #include "process-util.h"
 #include "stdio-util.h"
 #include "string-util.h"
+#include "strv.h"
+#include "time-util.h"
+
+/* How many records to read from /dev/kmsg in one event loop iteration at most */
+#define DEV_KMSG_RECORDS_MAX 64U
+
+/* How long to cache the udev metadata of a device referenced by kernel messages, and for how many devices */
+#define KMSG_DEVICE_CACHE_USEC (5U*USEC_PER_SEC)
+#define KMSG_DEVICE_CACHE_MAX 64U
+
+typedef struct KmsgDevice {
+        char *id;
+        char **fields;
+        usec_t timestamp;
+} KmsgDevice;
+
+static KmsgDevice* kmsg_device_free(KmsgDevice *d) {
+        if (!d)
+                return NULL;
+
+        free(d->id);
+        strv_free(d->fields);
+        return mfree(d);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(KmsgDevice*, kmsg_device_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(kmsg_device_hash_ops, char, string_hash_func, string_compare_func,
+                                              KmsgDevice, kmsg_device_free);
 
 void server_forward_kmsg(
                 Server *s,
@@ -96,6 +126,111 @@ static bool is_us(const char *identifier, const char *pid) {
                streq(identifier, program_invocation_short_name);
 }
 
+static int kmsg_device_fields_new(const char *id, char ***ret) {
+        _cleanup_(sd_device_unrefp) sd_device *d = NULL;
+        _cleanup_strv_free_ char **fields = NULL;
+        const char *g;
+        size_t n = 0;
+        int r;
+
+        assert(id);
+        assert(ret);
+
+        r = sd_device_new_from_device_id(&d, id);
+        if (r < 0) {
+                /* Remember that the device is not known, too */
+                *ret = NULL;
+                return 0;
+        }
+
+        if (sd_device_get_devname(d, &g) >= 0) {
+                r = strv_extendf(&fields, "_UDEV_DEVNODE=%s", g);
+                if (r < 0)
+                        return r;
+        }
+
+        if (sd_device_get_sysname(d, &g) >= 0) {
+                r = strv_extendf(&fields, "_UDEV_SYSNAME=%s", g);
+                if (r < 0)
+                        return r;
+        }
+
+        FOREACH_DEVICE_DEVLINK(d, link) {
+                if (n >= N_IOVEC_UDEV_FIELDS)
+                        break;
+
+                r = strv_extendf(&fields, "_UDEV_DEVLINK=%s", link);
+                if (r < 0)
+                        return r;
+
+                n++;
+        }
+
+        *ret = TAKE_PTR(fields);
+        return 0;
+}
+
+static char** kmsg_device_fields(Server *s, const char *id) {
+        _cleanup_(kmsg_device_freep) KmsgDevice *d = NULL;
+        _cleanup_strv_free_ char **fields = NULL;
+        KmsgDevice *k;
+        usec_t n;
+        int r;
+
+        assert(s);
+        assert(id);
+
+        /* Returns the _UDEV_xyz= fields for the specified kernel device ID. The result is owned by the
+         * cache. During kernel log storms the same few devices tend to be referenced over and over again,
+         * hence let's not query udev for every single message, but cache the result for a short while. */
+
+        n = now(CLOCK_MONOTONIC);
+
+        k = hashmap_get(s->kmsg_devices, id);
+        if (k && usec_add(k->timestamp, KMSG_DEVICE_CACHE_USEC) > n)
+                return k->fields;
+
+        r = kmsg_device_fields_new(id, &fields);
+        if (r < 0) {
+                log_oom_debug();
+                return NULL;
+        }
+
+        if (k) {
+                strv_free_and_replace(k->fields, fields);
+                k->timestamp = n;
+                return k->fields;
+        }
+
+        /* Keep things simple, and just start from scratch once the cache is full. */
+        if (hashmap_size(s->kmsg_devices) >= KMSG_DEVICE_CACHE_MAX)
+                hashmap_clear(s->kmsg_devices);
+
+        d = new(KmsgDevice, 1);
+        if (!d) {
+                log_oom_debug();
+                return NULL;
+        }
+
+        *d = (KmsgDevice) {
+                .id = strdup(id),
+                .fields = TAKE_PTR(fields),
+                .timestamp = n,
+        };
+        if (!d->id) {
+                log_oom_debug();
+                return NULL;
+        }
+
+        r = hashmap_ensure_put(&s->kmsg_devices, &kmsg_device_hash_ops, d->id, d);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to cache metadata of device %s, ignoring: %m", id);
+                return NULL;
+        }
+
+        return TAKE_PTR(d)->fields;
+}
+
 void dev_kmsg_record(Server *s, char *p, size_t l) {
 
         _cleanup_free_ char *message = NULL, *syslog_pid = NULL, *syslog_identifier = NULL, *identifier = NULL, *pid = NULL;
@@ -213,45 +348,10 @@ void dev_kmsg_record(Server *s, char *p, size_t l) {
                 k = e + 1;
         }
 
-        if (kernel_device) {
-                _cleanup_(sd_device_unrefp) sd_device *d = NULL;
-
-                if (sd_device_new_from_device_id(&d, kernel_device) >= 0) {
-                        const char *g;
-                        char *b;
-
-                        if (sd_device_get_devname(d, &g) >= 0) {
-                                b = strjoin("_UDEV_DEVNODE=", g);
-                                if (b) {
-                                        iovec[n++] = IOVEC_MAKE_STRING(b);
-                                        z++;
-                                }
-                        }
-
-                        if (sd_device_get_sysname(d, &g) >= 0) {
-                                b = strjoin("_UDEV_SYSNAME=", g);
-                                if (b) {
-                                        iovec[n++] = IOVEC_MAKE_STRING(b);
-                                        z++;
-                                }
-                        }
-
-                        j = 0;
-                        FOREACH_DEVICE_DEVLINK(d, link) {
-
-                                if (j >= N_IOVEC_UDEV_FIELDS)
-                                        break;
-
-                                b = strjoin("_UDEV_DEVLINK=", link);
-                                if (b) {
-                                        iovec[n++] = IOVEC_MAKE_STRING(b);
-                                        z++;
-                                }
-
-                                j++;
-                        }
-                }
-        }
+        if (kernel_device)
+                /* These are owned by the cache, hence not counted in 'z' */
+                STRV_FOREACH(field, kmsg_device_fields(s, kernel_device))
+                        iovec[n++] = IOVEC_MAKE_STRING(*field);
 
         char source_boot_time[STRLEN("_SOURCE_BOOTTIME_TIMESTAMP=") + DECIMAL_STR_MAX(unsigned long long)];
         xsprintf(source_boot_time, "_SOURCE_BOOTTIME_TIMESTAMP=%llu", usec);
@@ -371,6 +471,7 @@ int server_flush_dev_kmsg(Server *s) {
 
 static int dispatch_dev_kmsg(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
         Server *s = ASSERT_PTR(userdata);
+        int r;
 
         assert(es);
         assert(fd == s->dev_kmsg_fd);
@@ -382,7 +483,17 @@ static int dispatch_dev_kmsg(sd_event_source *es, int fd, uint32_t revents, void
         if (!(revents & EPOLLIN))
                 log_error("Got invalid event from epoll for /dev/kmsg: %"PRIx32, revents);
 
-        return server_read_dev_kmsg(s);
+        /* Each read() returns a single record only, hence process everything that is pending, up to a
+         * limit, in one go instead of returning to the event loop after each record. The resulting entries
+         * end up in the write queue, and are written out together. The limit makes sure we don't starve
+         * other event sources during kernel log storms. */
+        for (unsigned i = 0; i < DEV_KMSG_RECORDS_MAX; i++) {
+                r = server_read_dev_kmsg(s);
+                if (r <= 0)
+                        return r;
+        }
+
+        return 0;
 }
 
 int server_open_dev_kmsg(Server *s) {
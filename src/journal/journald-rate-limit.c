@@ -1,14 +1,16 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include "sd-json.h"
+
 #include "alloc-util.h"
 #include "hashmap.h"
 #include "journald-rate-limit.h"
+#include "list.h"
 #include "logarithm.h"
 #include "string-util.h"
 #include "time-util.h"
 
 #define POOLS_MAX 5
-#define GROUPS_MAX 2047
 
 static const int priority_map[] = {
         [LOG_EMERG]   = 0,
@@ -27,25 +29,45 @@ typedef struct JournalRateLimitPool {
         unsigned suppressed;
 } JournalRateLimitPool;
 
-typedef struct JournalRateLimitGroup {
-        OrderedHashmap *groups_by_id;
+typedef struct JournalRateLimitGroup JournalRateLimitGroup;
+
+struct JournalRateLimitGroup {
+        JournalRateLimit *parent;
 
         char *id;
 
         /* Interval is stored to keep track of when the group expires */
         usec_t interval;
 
+        /* Total number of messages suppressed over the lifetime of the group, unlike the per-pool counters
+         * this is not reset when a suppression message is generated */
+        uint64_t n_suppressed;
+
         JournalRateLimitPool pools[POOLS_MAX];
-} JournalRateLimitGroup;
+
+        LIST_FIELDS(JournalRateLimitGroup, lru);
+};
+
+struct JournalRateLimit {
+        Hashmap *groups_by_id;
+
+        /* Most recently used group first, so that we can evict from the tail in O(1) */
+        LIST_HEAD(JournalRateLimitGroup, lru);
+        JournalRateLimitGroup *lru_tail;
+};
 
 static JournalRateLimitGroup* journal_ratelimit_group_free(JournalRateLimitGroup *g) {
         if (!g)
                 return NULL;
 
-        if (g->groups_by_id && g->id)
-                /* The group is already removed from the hashmap when this is called from the
-                 * destructor of the hashmap. Hence, do not check the return value here. */
-                ordered_hashmap_remove_value(g->groups_by_id, g->id, g);
+        if (g->parent) {
+                assert_se(hashmap_remove(g->parent->groups_by_id, g->id) == g);
+
+                if (g->parent->lru_tail == g)
+                        g->parent->lru_tail = g->lru_prev;
+
+                LIST_REMOVE(lru, g->parent->lru, g);
+        }
 
         free(g->id);
         return mfree(g);
@@ -53,13 +75,16 @@ static JournalRateLimitGroup* journal_ratelimit_group_free(JournalRateLimitGroup
 
 DEFINE_TRIVIAL_CLEANUP_FUNC(JournalRateLimitGroup*, journal_ratelimit_group_free);
 
-DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(
-        journal_ratelimit_group_hash_ops,
-        char,
-        string_hash_func,
-        string_compare_func,
-        JournalRateLimitGroup,
-        journal_ratelimit_group_free);
+JournalRateLimit* journal_ratelimit_free(JournalRateLimit *rl) {
+        if (!rl)
+                return NULL;
+
+        while (rl->lru)
+                journal_ratelimit_group_free(rl->lru);
+
+        hashmap_free(rl->groups_by_id);
+        return mfree(rl);
+}
 
 static bool journal_ratelimit_group_expired(JournalRateLimitGroup *g, usec_t ts) {
         assert(g);
@@ -71,20 +96,23 @@ static bool journal_ratelimit_group_expired(JournalRateLimitGroup *g, usec_t ts)
         return true;
 }
 
-static void journal_ratelimit_vacuum(OrderedHashmap *groups_by_id, usec_t ts) {
+static void journal_ratelimit_vacuum(JournalRateLimit *rl, unsigned groups_max, usec_t ts) {
+        assert(rl);
 
-        /* Makes room for at least one new item, but drop all expired items too. */
+        /* Makes room for at least one new item, but drop all expired items too. Groups are ordered by their
+         * last use, hence the least recently used ones at the tail are also the ones most likely to have
+         * expired. */
 
-        while (ordered_hashmap_size(groups_by_id) >= GROUPS_MAX)
-                journal_ratelimit_group_free(ordered_hashmap_first(groups_by_id));
+        while (hashmap_size(rl->groups_by_id) >= MAX(groups_max, 1U))
+                journal_ratelimit_group_free(rl->lru_tail);
 
-        JournalRateLimitGroup *g;
-        while ((g = ordered_hashmap_first(groups_by_id)) && journal_ratelimit_group_expired(g, ts))
-                journal_ratelimit_group_free(g);
+        while (rl->lru_tail && journal_ratelimit_group_expired(rl->lru_tail, ts))
+                journal_ratelimit_group_free(rl->lru_tail);
 }
 
 static int journal_ratelimit_group_new(
-                OrderedHashmap **groups_by_id,
+                JournalRateLimit *rl,
+                unsigned groups_max,
                 const char *id,
                 usec_t interval,
                 usec_t ts,
@@ -93,7 +121,7 @@ static int journal_ratelimit_group_new(
         _cleanup_(journal_ratelimit_group_freep) JournalRateLimitGroup *g = NULL;
         int r;
 
-        assert(groups_by_id);
+        assert(rl);
         assert(id);
         assert(ret);
 
@@ -108,21 +136,25 @@ static int journal_ratelimit_group_new(
         if (!g->id)
                 return -ENOMEM;
 
-        journal_ratelimit_vacuum(*groups_by_id, ts);
+        journal_ratelimit_vacuum(rl, groups_max, ts);
 
-        r = ordered_hashmap_ensure_put(groups_by_id, &journal_ratelimit_group_hash_ops, g->id, g);
+        r = hashmap_ensure_put(&rl->groups_by_id, &string_hash_ops, g->id, g);
         if (r < 0)
                 return r;
         assert(r > 0);
 
-        g->groups_by_id = *groups_by_id;
+        g->parent = rl;
+        LIST_PREPEND(lru, rl->lru, g);
+        if (!rl->lru_tail)
+                rl->lru_tail = g;
 
         *ret = TAKE_PTR(g);
         return 0;
 }
 
 static int journal_ratelimit_group_acquire(
-                OrderedHashmap **groups_by_id,
+                JournalRateLimit *rl,
+                unsigned groups_max,
                 const char *id,
                 usec_t interval,
                 usec_t ts,
@@ -130,16 +162,25 @@ static int journal_ratelimit_group_acquire(
 
         JournalRateLimitGroup *g;
 
-        assert(groups_by_id);
+        assert(rl);
         assert(id);
         assert(ret);
 
-        g = ordered_hashmap_get(*groups_by_id, id);
+        g = hashmap_get(rl->groups_by_id, id);
         if (!g)
-                return journal_ratelimit_group_new(groups_by_id, id, interval, ts, ret);
+                return journal_ratelimit_group_new(rl, groups_max, id, interval, ts, ret);
 
         g->interval = interval;
 
+        /* Move to the front of the LRU list */
+        if (rl->lru != g) {
+                if (rl->lru_tail == g)
+                        rl->lru_tail = g->lru_prev;
+
+                LIST_REMOVE(lru, rl->lru, g);
+                LIST_PREPEND(lru, rl->lru, g);
+        }
+
         *ret = g;
         return 0;
 }
@@ -173,7 +214,8 @@ static unsigned burst_modulate(unsigned burst, uint64_t available) {
 }
 
 int journal_ratelimit_test(
-                OrderedHashmap **groups_by_id,
+                JournalRateLimit **rl,
+                unsigned groups_max,
                 const char *id,
                 usec_t rl_interval,
                 unsigned rl_burst,
@@ -186,7 +228,7 @@ int journal_ratelimit_test(
         usec_t ts;
         int r;
 
-        assert(groups_by_id);
+        assert(rl);
         assert(id);
 
         /* Returns:
@@ -196,9 +238,15 @@ int journal_ratelimit_test(
          * < 0   → error
          */
 
+        if (!*rl) {
+                *rl = new0(JournalRateLimit, 1);
+                if (!*rl)
+                        return -ENOMEM;
+        }
+
         ts = now(CLOCK_MONOTONIC);
 
-        r = journal_ratelimit_group_acquire(groups_by_id, id, rl_interval, ts, &g);
+        r = journal_ratelimit_group_acquire(*rl, groups_max, id, rl_interval, ts, &g);
         if (r < 0)
                 return r;
 
@@ -233,5 +281,33 @@ int journal_ratelimit_test(
         }
 
         p->suppressed++;
+        g->n_suppressed++;
+        return 0;
+}
+
+int journal_ratelimit_build_json(JournalRateLimit *rl, sd_json_variant **ret) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r;
+
+        assert(ret);
+
+        /* Reports the groups currently tracked that had messages suppressed, most recently used first */
+
+        LIST_FOREACH(lru, g, rl ? rl->lru : NULL) {
+                if (g->n_suppressed == 0)
+                        continue;
+
+                r = sd_json_variant_append_arraybo(
+                                &v,
+                                SD_JSON_BUILD_PAIR_STRING("Unit", g->id),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Suppressed", g->n_suppressed));
+                if (r < 0)
+                        return r;
+        }
+
+        if (!v)
+                return sd_json_variant_new_array(ret, NULL, 0);
+
+        *ret = TAKE_PTR(v);
         return 0;
 }
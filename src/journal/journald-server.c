@@ -46,6 +46,7 @@
 #include "journald-syslog.h"
 #include "log.h"
 #include "memory-util.h"
+#include "metrics.h"
 #include "missing_audit.h"
 #include "mkdir.h"
 #include "parse-util.h"
@@ -64,6 +65,7 @@
 #include "uid-classification.h"
 #include "user-util.h"
 #include "varlink-io.systemd.Journal.h"
+#include "varlink-io.systemd.Metrics.h"
 #include "varlink-io.systemd.service.h"
 #include "varlink-util.h"
 
@@ -92,9 +94,25 @@
 
 #define IDLE_TIMEOUT_USEC (30*USEC_PER_SEC)
 
+/* Journals written to more recently than this are only synced, not taken offline, see server_sync_journal() */
+#define SYNC_BUSY_USEC (1*USEC_PER_SEC)
+
+/* How many further datagrams to receive in one go, and how large each of them may be at most */
+#define DATAGRAM_BATCH_MAX 16U
+#define DATAGRAM_BATCH_SLOT_SIZE (64U*1024U)
+
+/* How many log messages to queue at most before writing them out in one batch */
+#define WRITE_QUEUE_ENTRIES_MAX 256U
+#define WRITE_QUEUE_SIZE_MAX (4U*1024U*1024U)
+
+/* Entries larger than this are written out right away, instead of copying them into the write queue. This
+ * allows large payloads (e.g. from sealed memfds) to be compressed straight from where we received them. */
+#define WRITE_QUEUE_ENTRY_SIZE_MAX (64U*1024U)
+
 #define FAILED_TO_WRITE_ENTRY_RATELIMIT ((const RateLimit) { .interval = 1 * USEC_PER_SEC, .burst = 1 })
 
 static int server_schedule_sync(Server *s, int priority);
+static void server_flush_write_queue(Server *s);
 static int server_refresh_idle_timer(Server *s);
 
 static int server_determine_path_usage(
@@ -719,6 +737,8 @@ void server_rotate(Server *s) {
 
         log_debug("Rotating...");
 
+        server_flush_write_queue(s);
+
         /* First, rotate the system journal (either in its runtime flavour or in its runtime flavour) */
         (void) server_do_rotate(s, &s->runtime_journal, "runtime", /* seal= */ false, /* uid= */ 0);
         (void) server_do_rotate(s, &s->system_journal, "system", s->seal, /* uid= */ 0);
@@ -768,19 +788,38 @@ static void server_rotate_journal(Server *s, JournalFile *f, uid_t uid) {
         server_process_deferred_closes(s);
 }
 
+static int server_sync_journal(JournalFile *f, bool wait, usec_t n, bool *busy) {
+        assert(f);
+        assert(busy);
+
+        /* Taking a journal that is being written to right now offline is pointless: the next message
+         * brings it online again right away, and that involves another fsync() on our main loop. Hence
+         * only sync busy journals in the background, and take them offline once they calmed down. */
+        if (!wait && usec_sub_unsigned(n, le64toh(f->header->tail_entry_realtime)) < SYNC_BUSY_USEC) {
+                *busy = true;
+                return journal_file_sync_async(f);
+        }
+
+        return journal_file_set_offline(f, wait);
+}
+
 static void server_sync(Server *s, bool wait) {
+        usec_t n = now(CLOCK_REALTIME);
+        bool busy = false;
         JournalFile *f;
         int r;
 
+        server_flush_write_queue(s);
+
         if (s->system_journal) {
-                r = journal_file_set_offline(s->system_journal, wait);
+                r = server_sync_journal(s->system_journal, wait, n, &busy);
                 if (r < 0)
                         log_ratelimit_warning_errno(r, JOURNAL_LOG_RATELIMIT,
                                                     "Failed to sync system journal, ignoring: %m");
         }
 
         ORDERED_HASHMAP_FOREACH(f, s->user_journals) {
-                r = journal_file_set_offline(f, wait);
+                r = server_sync_journal(f, wait, n, &busy);
                 if (r < 0)
                         log_ratelimit_warning_errno(r, JOURNAL_LOG_RATELIMIT,
                                                     "Failed to sync user journal, ignoring: %m");
@@ -792,6 +831,10 @@ static void server_sync(Server *s, bool wait) {
                                             "Failed to disable sync timer source, ignoring: %m");
 
         s->sync_scheduled = false;
+
+        /* Come back later to take the busy journals offline */
+        if (busy && s->event && sd_event_get_state(s->event) != SD_EVENT_FINISHED)
+                (void) server_schedule_sync(s, LOG_INFO);
 }
 
 static void server_do_vacuum(Server *s, JournalStorage *storage, bool verbose) {
@@ -806,9 +849,9 @@ static void server_do_vacuum(Server *s, JournalStorage *storage, bool verbose) {
         if (verbose)
                 server_space_usage_message(s, storage);
 
-        r = journal_directory_vacuum(storage->path, storage->space.limit,
-                                     storage->metrics.n_max_files, s->max_retention_usec,
-                                     &s->oldest_file_usec, verbose);
+        r = journal_directory_vacuum_full(storage->path, &storage->vacuum_cache, storage->space.limit,
+                                          storage->metrics.n_max_files, s->max_retention_usec,
+                                          &s->oldest_file_usec, verbose);
         if (r < 0 && r != -ENOENT)
                 log_ratelimit_warning_errno(r, JOURNAL_LOG_RATELIMIT,
                                             "Failed to vacuum %s, ignoring: %m", storage->path);
@@ -943,24 +986,82 @@ static bool shall_try_append_again(JournalFile *f, int r) {
         }
 }
 
-static void server_write_to_journal(
-                Server *s,
+struct PendingEntry {
+        uid_t uid;
+        int priority;
+        dual_timestamp ts;
+        struct iovec *iovec; /* allocated together with the payload it points to */
+        size_t n_iovec;
+};
+
+static void pending_entry_done(PendingEntry *e) {
+        assert(e);
+
+        e->iovec = mfree(e->iovec);
+        e->n_iovec = 0;
+}
+
+static int pending_entry_init(
+                PendingEntry *e,
                 uid_t uid,
                 const struct iovec *iovec,
                 size_t n,
                 const dual_timestamp *ts,
                 int priority) {
 
+        struct iovec *copy;
+        size_t sz;
+        uint8_t *p;
+
+        assert(e);
+        assert(iovec);
+        assert(n > 0);
+        assert(ts);
+
+        /* The iovecs passed to us typically point to stack memory of the caller, hence make a single
+         * allocation carrying both the iovec array and the payload. */
+        sz = size_add(n * sizeof(struct iovec), iovec_total_size(iovec, n));
+        if (sz == SIZE_MAX)
+                return -ENOMEM;
+
+        copy = malloc(sz);
+        if (!copy)
+                return -ENOMEM;
+
+        p = (uint8_t*) (copy + n);
+        for (size_t i = 0; i < n; i++) {
+                copy[i] = IOVEC_MAKE(p, iovec[i].iov_len);
+                p = mempcpy(p, iovec[i].iov_base, iovec[i].iov_len);
+        }
+
+        *e = (PendingEntry) {
+                .uid = uid,
+                .priority = priority,
+                .ts = *ts,
+                .iovec = copy,
+                .n_iovec = n,
+        };
+
+        return 0;
+}
+
+static size_t server_write_to_journal(Server *s, uid_t uid, const PendingEntry *entries, size_t n) {
+        JournalFileAppendEntry *a;
+        const PendingEntry *e;
         bool vacuumed = false;
+        size_t m, n_appended = 0;
+        int priority, r;
         JournalFile *f;
-        int r;
 
         assert(s);
-        assert(iovec);
+        assert(entries);
         assert(n > 0);
-        assert(ts);
+        assert(n <= WRITE_QUEUE_ENTRIES_MAX);
+
+        /* Writes out a series of entries destined for the same journal file, and returns how many of them
+         * were processed, i.e. either written or dropped. The caller should call us again for the rest. */
 
-        if (ts->realtime < s->last_realtime_clock) {
+        if (entries[0].ts.realtime < s->last_realtime_clock) {
                 /* When the time jumps backwards, let's immediately rotate. Of course, this should not happen during
                  * regular operation. However, when it does happen, then we should make sure that we start fresh files
                  * to ensure that the entries in the journal files are strictly ordered by time, in order to ensure
@@ -974,13 +1075,13 @@ static void server_write_to_journal(
 
         f = server_find_journal(s, uid);
         if (!f)
-                return;
+                return n;
 
         if (journal_file_rotate_suggested(f, s->max_file_usec, LOG_DEBUG)) {
                 if (vacuumed) {
                         log_ratelimit_warning(JOURNAL_LOG_RATELIMIT,
                                               "Suppressing rotation, as we already rotated immediately before write attempt. Giving up.");
-                        return;
+                        return 1;
                 }
 
                 log_debug("%s: Journal header limits reached or header out-of-date, rotating.", f->path);
@@ -991,33 +1092,49 @@ static void server_write_to_journal(
 
                 f = server_find_journal(s, uid);
                 if (!f)
-                        return;
+                        return n;
         }
 
-        s->last_realtime_clock = ts->realtime;
+        /* Only append entries in one go as long as time does not jump backwards, as that requires a
+         * rotation first, see above. */
+        for (m = 1; m < n; m++)
+                if (entries[m].ts.realtime < entries[m-1].ts.realtime)
+                        break;
+
+        a = newa(JournalFileAppendEntry, m);
+        for (size_t i = 0; i < m; i++)
+                a[i] = (JournalFileAppendEntry) {
+                        .ts = &entries[i].ts,
+                        .iovec = entries[i].iovec,
+                        .n_iovec = entries[i].n_iovec,
+                };
+
+        r = journal_file_append_entries(f, a, m, &s->seqnum->seqnum, &s->seqnum->id, &n_appended);
+
+        s->last_realtime_clock = entries[MIN(n_appended, m - 1)].ts.realtime;
+
+        if (n_appended > 0) {
+                /* Sync according to the most important entry we wrote */
+                priority = LOG_DEBUG;
+                for (size_t i = 0; i < n_appended; i++)
+                        priority = MIN(priority, entries[i].priority);
 
-        r = journal_file_append_entry(
-                        f,
-                        ts,
-                        /* boot_id= */ NULL,
-                        iovec, n,
-                        &s->seqnum->seqnum,
-                        &s->seqnum->id,
-                        /* ret_object= */ NULL,
-                        /* ret_offset= */ NULL);
-        if (r >= 0) {
                 server_schedule_sync(s, priority);
-                return;
         }
+        if (r >= 0)
+                return m;
+
+        e = entries + n_appended;
 
-        log_debug_errno(r, "Failed to write entry to %s (%zu items, %zu bytes): %m", f->path, n, iovec_total_size(iovec, n));
+        log_debug_errno(r, "Failed to write entry to %s (%zu items, %zu bytes): %m",
+                        f->path, e->n_iovec, iovec_total_size(e->iovec, e->n_iovec));
 
         if (!shall_try_append_again(f, r))
-                return;
+                return n_appended + 1;
         if (vacuumed) {
                 log_ratelimit_warning_errno(r, JOURNAL_LOG_RATELIMIT,
                                             "Suppressing rotation, as we already rotated immediately before write attempt. Giving up.");
-                return;
+                return n_appended + 1;
         }
 
         server_rotate_journal(s, TAKE_PTR(f), uid);
@@ -1025,14 +1142,14 @@ static void server_write_to_journal(
 
         f = server_find_journal(s, uid);
         if (!f)
-                return;
+                return n;
 
         log_debug_errno(r, "Retrying write.");
         r = journal_file_append_entry(
                         f,
-                        ts,
+                        &e->ts,
                         /* boot_id= */ NULL,
-                        iovec, n,
+                        e->iovec, e->n_iovec,
                         &s->seqnum->seqnum,
                         &s->seqnum->id,
                         /* ret_object= */ NULL,
@@ -1040,9 +1157,138 @@ static void server_write_to_journal(
         if (r < 0)
                 log_ratelimit_error_errno(r, FAILED_TO_WRITE_ENTRY_RATELIMIT,
                                           "Failed to write entry to %s (%zu items, %zu bytes) despite vacuuming, ignoring: %m",
-                                          f->path, n, iovec_total_size(iovec, n));
+                                          f->path, e->n_iovec, iovec_total_size(e->iovec, e->n_iovec));
         else
-                server_schedule_sync(s, priority);
+                server_schedule_sync(s, e->priority);
+
+        return n_appended + 1;
+}
+
+static void server_flush_write_queue(Server *s) {
+        _cleanup_free_ PendingEntry *q = NULL;
+        size_t n;
+
+        assert(s);
+
+        /* Writing out entries might result in driver messages being generated (for example when rotating),
+         * which are queued again. Hence let's not recurse, the event source will pick them up. */
+        if (s->write_queue_flushing)
+                return;
+
+        q = TAKE_PTR(s->write_queue);
+        n = TAKE_GENERIC(s->n_write_queue, size_t, 0);
+        s->write_queue_size = 0;
+
+        s->write_queue_flushing = true;
+
+        for (size_t i = 0; i < n; ) {
+                size_t k;
+
+                /* Coalesce runs of entries that go to the same journal file */
+                for (k = i + 1; k < n; k++)
+                        if (q[k].uid != q[i].uid)
+                                break;
+
+                i += server_write_to_journal(s, q[i].uid, q + i, k - i);
+        }
+
+        s->write_queue_flushing = false;
+
+        FOREACH_ARRAY(e, q, n)
+                pending_entry_done(e);
+}
+
+static int server_dispatch_write_queue(sd_event_source *es, void *userdata) {
+        Server *s = ASSERT_PTR(userdata);
+
+        server_flush_write_queue(s);
+        return 0;
+}
+
+static int server_schedule_write_queue(Server *s) {
+        int r;
+
+        assert(s);
+
+        if (!s->write_queue_event_source) {
+                r = sd_event_add_defer(s->event, &s->write_queue_event_source, server_dispatch_write_queue, s);
+                if (r < 0)
+                        return r;
+
+                /* Lower priority than the sources we read log messages from, so that we write out as many
+                 * of them as possible in one go when we are flooded. */
+                r = sd_event_source_set_priority(s->write_queue_event_source, SD_EVENT_PRIORITY_NORMAL+10);
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_event_source_set_enabled(s->write_queue_event_source, SD_EVENT_ONESHOT);
+}
+
+static void server_queue_write_to_journal(
+                Server *s,
+                uid_t uid,
+                const struct iovec *iovec,
+                size_t n,
+                const dual_timestamp *ts,
+                int priority) {
+
+        PendingEntry e;
+        int r;
+
+        assert(s);
+        assert(iovec);
+        assert(n > 0);
+        assert(ts);
+
+        /* Log messages are not written to the journal file right away, but queued up until we either have
+         * no further messages to process or the queue reaches its limits, so that they can be appended in
+         * one batch. If we are shutting down, the message is important enough to be synced right away, is
+         * large, or we cannot queue, let's write it out synchronously. */
+
+        if (!s->event || sd_event_get_state(s->event) == SD_EVENT_FINISHED || priority <= LOG_CRIT)
+                goto write_now;
+
+        if (iovec_total_size(iovec, n) > WRITE_QUEUE_ENTRY_SIZE_MAX)
+                goto write_now;
+
+        if (!GREEDY_REALLOC(s->write_queue, s->n_write_queue + 1))
+                goto write_now;
+
+        r = pending_entry_init(&e, uid, iovec, n, ts, priority);
+        if (r < 0)
+                goto write_now;
+
+        s->write_queue[s->n_write_queue++] = e;
+        s->write_queue_size += e.n_iovec * sizeof(struct iovec) + iovec_total_size(e.iovec, e.n_iovec);
+
+        if (s->n_write_queue >= WRITE_QUEUE_ENTRIES_MAX || s->write_queue_size >= WRITE_QUEUE_SIZE_MAX) {
+                server_flush_write_queue(s);
+                return;
+        }
+
+        r = server_schedule_write_queue(s);
+        if (r < 0) {
+                log_ratelimit_warning_errno(r, JOURNAL_LOG_RATELIMIT,
+                                            "Failed to schedule write queue, writing out synchronously: %m");
+                server_flush_write_queue(s);
+        }
+
+        return;
+
+write_now:
+        /* Keep the ordering intact */
+        server_flush_write_queue(s);
+
+        e = (PendingEntry) {
+                .uid = uid,
+                .priority = priority,
+                .ts = *ts,
+                .iovec = (struct iovec*) iovec,
+                .n_iovec = n,
+        };
+
+        (void) server_write_to_journal(s, uid, &e, 1);
 }
 
 #define IOVEC_ADD_NUMERIC_FIELD(iovec, n, value, type, isset, format, field)  \
@@ -1125,9 +1371,9 @@ static void server_dispatch_message_real(
 
                 IOVEC_ADD_ID128_FIELD(iovec, n, c->invocation_id, "_SYSTEMD_INVOCATION_ID");
 
-                if (c->extra_fields_n_iovec > 0) {
-                        memcpy(iovec + n, c->extra_fields_iovec, c->extra_fields_n_iovec * sizeof(struct iovec));
-                        n += c->extra_fields_n_iovec;
+                if (c->cgroup_data && c->cgroup_data->extra_fields_n_iovec > 0) {
+                        memcpy(iovec + n, c->cgroup_data->extra_fields_iovec, c->cgroup_data->extra_fields_n_iovec * sizeof(struct iovec));
+                        n += c->cgroup_data->extra_fields_n_iovec;
                 }
         }
 
@@ -1207,7 +1453,7 @@ static void server_dispatch_message_real(
 
         (void) server_forward_socket(s, iovec, n, &ts, priority);
 
-        server_write_to_journal(s, journal_uid, iovec, n, &ts, priority);
+        server_queue_write_to_journal(s, journal_uid, iovec, n, &ts, priority);
 }
 
 void server_driver_message(Server *s, pid_t object_pid, const char *message_id, const char *format, ...) {
@@ -1289,7 +1535,8 @@ void server_dispatch_message(
                 (void) server_determine_space(s, &available, /* limit= */ NULL);
 
                 rl = journal_ratelimit_test(
-                                &s->ratelimit_groups_by_id,
+                                &s->ratelimit,
+                                s->ratelimit_groups_max,
                                 c->unit,
                                 c->log_ratelimit_interval,
                                 c->log_ratelimit_burst,
@@ -1311,6 +1558,7 @@ void server_dispatch_message(
 }
 
 int server_flush_to_var(Server *s, bool require_flag_file) {
+        _cleanup_(journal_file_copy_cache_done) JournalFileCopyCache cache = {};
         sd_journal *j = NULL;
         const char *fn;
         unsigned n = 0;
@@ -1328,6 +1576,8 @@ int server_flush_to_var(Server *s, bool require_flag_file) {
         if (!s->runtime_journal) /* Nothing to flush? */
                 return 0;
 
+        server_flush_write_queue(s);
+
         if (require_flag_file && !server_flushed_flag_is_set(s))
                 return 0;
 
@@ -1377,7 +1627,8 @@ int server_flush_to_var(Server *s, bool require_flag_file) {
                                 o,
                                 f->current_offset,
                                 &s->seqnum->seqnum,
-                                &s->seqnum->id);
+                                &s->seqnum->id,
+                                &cache);
                 if (r >= 0)
                         continue;
 
@@ -1405,7 +1656,8 @@ int server_flush_to_var(Server *s, bool require_flag_file) {
                                 o,
                                 f->current_offset,
                                 &s->seqnum->seqnum,
-                                &s->seqnum->id);
+                                &s->seqnum->id,
+                                &cache);
                 if (r < 0) {
                         log_ratelimit_error_errno(r, JOURNAL_LOG_RATELIMIT, "Can't write entry: %m");
                         goto finish;
@@ -1479,6 +1731,8 @@ static int server_relinquish_var(Server *s) {
 
         log_debug("Relinquishing %s...", s->system_storage.path);
 
+        server_flush_write_queue(s);
+
         (void) server_system_journal_open(s, /* flush_requested */ false, /* relinquish_requested=*/ true);
 
         s->system_journal = journal_file_offline_close(s->system_journal);
@@ -1489,22 +1743,157 @@ static int server_relinquish_var(Server *s) {
         return 0;
 }
 
+static void server_process_datagram_one(
+                Server *s,
+                int fd,
+                char *buffer,
+                size_t n,
+                struct msghdr *msghdr) {
+
+        size_t label_len = 0, n_fds = 0;
+        struct ucred *ucred = NULL;
+        struct timeval tv_buf, *tv = NULL;
+        struct cmsghdr *cmsg;
+        char *label = NULL;
+        int *fds = NULL;
+
+        assert(s);
+        assert(buffer);
+        assert(msghdr);
+
+        CMSG_FOREACH(cmsg, msghdr) {
+                if (cmsg->cmsg_level != SOL_SOCKET)
+                        continue;
+
+                if (cmsg->cmsg_type == SCM_CREDENTIALS &&
+                    cmsg->cmsg_len == CMSG_LEN(sizeof(struct ucred))) {
+                        assert(!ucred);
+                        ucred = CMSG_TYPED_DATA(cmsg, struct ucred);
+                } else if (cmsg->cmsg_type == SCM_SECURITY) {
+                        assert(!label);
+                        label = CMSG_TYPED_DATA(cmsg, char);
+                        label_len = cmsg->cmsg_len - CMSG_LEN(0);
+                } else if (cmsg->cmsg_type == SCM_TIMESTAMP &&
+                           cmsg->cmsg_len == CMSG_LEN(sizeof(struct timeval))) {
+                        assert(!tv);
+                        tv = memcpy(&tv_buf, CMSG_DATA(cmsg), sizeof(struct timeval));
+                } else if (cmsg->cmsg_type == SCM_RIGHTS) {
+                        assert(!fds);
+                        fds = CMSG_TYPED_DATA(cmsg, int);
+                        n_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                }
+        }
+
+        /* And a trailing NUL, just in case */
+        buffer[n] = 0;
+
+        if (fd == s->syslog_fd) {
+                if (n > 0 && n_fds == 0)
+                        server_process_syslog_message(s, buffer, n, ucred, tv, label, label_len);
+                else if (n_fds > 0)
+                        log_ratelimit_warning(JOURNAL_LOG_RATELIMIT,
+                                              "Got file descriptors via syslog socket. Ignoring.");
+
+        } else if (fd == s->native_fd) {
+                if (n > 0 && n_fds == 0)
+                        server_process_native_message(s, buffer, n, ucred, tv, label, label_len);
+                else if (n == 0 && n_fds == 1)
+                        (void) server_process_native_file(s, fds[0], ucred, tv, label, label_len);
+                else if (n_fds > 0)
+                        log_ratelimit_warning(JOURNAL_LOG_RATELIMIT,
+                                              "Got too many file descriptors via native socket. Ignoring.");
+
+        } else {
+                assert(fd == s->audit_fd);
+
+                if (n > 0 && n_fds == 0)
+                        server_process_audit_message(s, buffer, n, ucred, msghdr->msg_name, msghdr->msg_namelen);
+                else if (n_fds > 0)
+                        log_ratelimit_warning(JOURNAL_LOG_RATELIMIT,
+                                              "Got file descriptors via audit socket. Ignoring.");
+        }
+
+        close_many(fds, n_fds);
+}
+
+static void server_process_datagram_batch(Server *s, int fd) {
+        struct mmsghdr msgs[DATAGRAM_BATCH_MAX] = {};
+        struct iovec iovecs[DATAGRAM_BATCH_MAX];
+        union sockaddr_union sas[DATAGRAM_BATCH_MAX] = {};
+        int n;
+
+        /* See server_process_datagram() for the size, and for why we need to initialize this. */
+        CMSG_BUFFER_TYPE(CMSG_SPACE(sizeof(struct ucred)) +
+                         CMSG_SPACE_TIMEVAL +
+                         CMSG_SPACE(sizeof(int)) + /* fd */
+                         CMSG_SPACE(NAME_MAX) /* selinux label */) controls[DATAGRAM_BATCH_MAX] = {};
+
+        assert(s);
+        assert(fd == s->syslog_fd || fd == s->audit_fd);
+
+        /* Pulls in whatever else is already queued on the socket with a single recvmmsg() call, so that
+         * bursts of small messages don't cost an event loop iteration and a recvmsg() each. The caller
+         * checked that the first queued datagram fits into a batch slot, but we can't know that for the
+         * ones behind it. Hence we only do this for the syslog and audit sockets, whose messages are
+         * reasonably bounded, and not for the native protocol. */
+
+        if (!s->datagram_batch) {
+                s->datagram_batch = new(char, DATAGRAM_BATCH_MAX * (DATAGRAM_BATCH_SLOT_SIZE + 1));
+                if (!s->datagram_batch)
+                        return (void) log_oom_debug();
+        }
+
+        for (size_t i = 0; i < DATAGRAM_BATCH_MAX; i++) {
+                /* Leave room for the trailing NUL we add later */
+                iovecs[i] = IOVEC_MAKE(s->datagram_batch + i * (DATAGRAM_BATCH_SLOT_SIZE + 1), DATAGRAM_BATCH_SLOT_SIZE);
+
+                msgs[i].msg_hdr = (struct msghdr) {
+                        .msg_iov = iovecs + i,
+                        .msg_iovlen = 1,
+                        .msg_control = controls + i,
+                        .msg_controllen = sizeof(controls[i]),
+                        .msg_name = sas + i,
+                        .msg_namelen = sizeof(sas[i]),
+                };
+        }
+
+        n = recvmmsg(fd, msgs, DATAGRAM_BATCH_MAX, MSG_DONTWAIT|MSG_CMSG_CLOEXEC, /* timeout= */ NULL);
+        if (n < 0) {
+                if (!ERRNO_IS_TRANSIENT(errno))
+                        log_ratelimit_error_errno(errno, JOURNAL_LOG_RATELIMIT, "Failed to receive messages: %m");
+                return;
+        }
+
+        for (int i = 0; i < n; i++) {
+                struct msghdr *mh = &msgs[i].msg_hdr;
+
+                if (FLAGS_SET(mh->msg_flags, MSG_CTRUNC)) {
+                        cmsg_close_all(mh);
+                        log_ratelimit_warning(JOURNAL_LOG_RATELIMIT,
+                                              "Got message with truncated control data (too many fds sent?), ignoring.");
+                        continue;
+                }
+                if (FLAGS_SET(mh->msg_flags, MSG_TRUNC)) {
+                        cmsg_close_all(mh);
+                        log_ratelimit_warning(JOURNAL_LOG_RATELIMIT, "Got message with truncated payload data, ignoring.");
+                        continue;
+                }
+
+                server_process_datagram_one(s, fd, iovecs[i].iov_base, msgs[i].msg_len, mh);
+        }
+}
+
 int server_process_datagram(
                 sd_event_source *es,
                 int fd,
                 uint32_t revents,
                 void *userdata) {
 
-        size_t label_len = 0, m;
         Server *s = ASSERT_PTR(userdata);
-        struct ucred *ucred = NULL;
-        struct timeval tv_buf, *tv = NULL;
-        struct cmsghdr *cmsg;
-        char *label = NULL;
         struct iovec iovec;
         ssize_t n;
-        int *fds = NULL, v = 0;
-        size_t n_fds = 0;
+        int v = 0;
+        size_t m;
 
         /* We use NAME_MAX space for the SELinux label here. The kernel currently enforces no limit, but
          * according to suggestions from the SELinux people this will change and it will probably be
@@ -1565,59 +1954,15 @@ int server_process_datagram(
         if (n < 0)
                 return log_ratelimit_error_errno(n, JOURNAL_LOG_RATELIMIT, "Failed to receive message: %m");
 
-        CMSG_FOREACH(cmsg, &msghdr) {
-                if (cmsg->cmsg_level != SOL_SOCKET)
-                        continue;
-
-                if (cmsg->cmsg_type == SCM_CREDENTIALS &&
-                    cmsg->cmsg_len == CMSG_LEN(sizeof(struct ucred))) {
-                        assert(!ucred);
-                        ucred = CMSG_TYPED_DATA(cmsg, struct ucred);
-                } else if (cmsg->cmsg_type == SCM_SECURITY) {
-                        assert(!label);
-                        label = CMSG_TYPED_DATA(cmsg, char);
-                        label_len = cmsg->cmsg_len - CMSG_LEN(0);
-                } else if (cmsg->cmsg_type == SCM_TIMESTAMP &&
-                           cmsg->cmsg_len == CMSG_LEN(sizeof(struct timeval))) {
-                        assert(!tv);
-                        tv = memcpy(&tv_buf, CMSG_DATA(cmsg), sizeof(struct timeval));
-                } else if (cmsg->cmsg_type == SCM_RIGHTS) {
-                        assert(!fds);
-                        fds = CMSG_TYPED_DATA(cmsg, int);
-                        n_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
-                }
-        }
-
-        /* And a trailing NUL, just in case */
-        s->buffer[n] = 0;
+        server_process_datagram_one(s, fd, s->buffer, n, &msghdr);
 
-        if (fd == s->syslog_fd) {
-                if (n > 0 && n_fds == 0)
-                        server_process_syslog_message(s, s->buffer, n, ucred, tv, label, label_len);
-                else if (n_fds > 0)
-                        log_ratelimit_warning(JOURNAL_LOG_RATELIMIT,
-                                              "Got file descriptors via syslog socket. Ignoring.");
-
-        } else if (fd == s->native_fd) {
-                if (n > 0 && n_fds == 0)
-                        server_process_native_message(s, s->buffer, n, ucred, tv, label, label_len);
-                else if (n == 0 && n_fds == 1)
-                        (void) server_process_native_file(s, fds[0], ucred, tv, label, label_len);
-                else if (n_fds > 0)
-                        log_ratelimit_warning(JOURNAL_LOG_RATELIMIT,
-                                              "Got too many file descriptors via native socket. Ignoring.");
-
-        } else {
-                assert(fd == s->audit_fd);
-
-                if (n > 0 && n_fds == 0)
-                        server_process_audit_message(s, s->buffer, n, ucred, &sa, msghdr.msg_namelen);
-                else if (n_fds > 0)
-                        log_ratelimit_warning(JOURNAL_LOG_RATELIMIT,
-                                              "Got file descriptors via audit socket. Ignoring.");
-        }
-
-        close_many(fds, n_fds);
+        /* If there's more queued up behind this one, pick it up right away. SIOCINQ tells us the size of the
+         * next datagram. If we can't tell, or if it wouldn't fit into a batch slot, leave it to the next
+         * iteration of the event loop, which receives it with a buffer of the right size. */
+        if (fd != s->native_fd &&
+            ioctl(fd, SIOCINQ, &v) >= 0 &&
+            v > 0 && (size_t) v <= DATAGRAM_BATCH_SLOT_SIZE)
+                server_process_datagram_batch(s, fd);
 
         server_refresh_idle_timer(s);
         return 0;
@@ -2312,6 +2657,173 @@ static int vl_method_relinquish_var(sd_varlink *link, sd_json_variant *parameter
         return sd_varlink_reply(link, NULL);
 }
 
+static void server_add_journal_statistics(JournalFile *f, uint64_t *hits, uint64_t *misses) {
+        assert(hits);
+        assert(misses);
+
+        if (!f)
+                return;
+
+        *hits += f->data_cache_hits;
+        *misses += f->data_cache_misses;
+}
+
+static int vl_method_get_statistics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *suppressed = NULL;
+        Server *s = ASSERT_PTR(userdata);
+        uint64_t hits = 0, misses = 0;
+        JournalFile *f;
+        int r;
+
+        assert(link);
+
+        r = sd_varlink_dispatch(link, parameters, /* dispatch_table = */ NULL, /* userdata = */ NULL);
+        if (r != 0)
+                return r;
+
+        server_add_journal_statistics(s->runtime_journal, &hits, &misses);
+        server_add_journal_statistics(s->system_journal, &hits, &misses);
+        ORDERED_HASHMAP_FOREACH(f, s->user_journals)
+                server_add_journal_statistics(f, &hits, &misses);
+
+        r = journal_ratelimit_build_json(s->ratelimit, &suppressed);
+        if (r < 0)
+                return r;
+
+        return sd_varlink_replybo(
+                        link,
+                        SD_JSON_BUILD_PAIR_UNSIGNED("DataCacheHits", hits),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("DataCacheMisses", misses),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("ContextCacheHits", s->n_client_context_hits),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("ContextCacheMisses", s->n_client_context_misses),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("CgroupCacheHits", s->n_client_cgroup_hits),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("CgroupCacheMisses", s->n_client_cgroup_misses),
+                        SD_JSON_BUILD_PAIR_VARIANT("RateLimitSuppressed", suppressed));
+}
+
+static int metric_cache_hits(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Server *s = ASSERT_PTR(userdata);
+        uint64_t hits = 0, misses = 0, mmap_hits;
+        JournalFile *j;
+        int r;
+
+        server_add_journal_statistics(s->runtime_journal, &hits, &misses);
+        server_add_journal_statistics(s->system_journal, &hits, &misses);
+        ORDERED_HASHMAP_FOREACH(j, s->user_journals)
+                server_add_journal_statistics(j, &hits, &misses);
+
+        mmap_cache_get_statistics(s->mmap, &mmap_hits, /* ret_misses= */ NULL);
+
+        r = metric_append_value(array, f, "cache", "data", hits);
+        if (r < 0)
+                return r;
+
+        r = metric_append_value(array, f, "cache", "context", s->n_client_context_hits);
+        if (r < 0)
+                return r;
+
+        r = metric_append_value(array, f, "cache", "cgroup", s->n_client_cgroup_hits);
+        if (r < 0)
+                return r;
+
+        return metric_append_value(array, f, "cache", "mmap", mmap_hits);
+}
+
+static int metric_cache_misses(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Server *s = ASSERT_PTR(userdata);
+        uint64_t hits = 0, misses = 0, mmap_misses;
+        JournalFile *j;
+        int r;
+
+        server_add_journal_statistics(s->runtime_journal, &hits, &misses);
+        server_add_journal_statistics(s->system_journal, &hits, &misses);
+        ORDERED_HASHMAP_FOREACH(j, s->user_journals)
+                server_add_journal_statistics(j, &hits, &misses);
+
+        mmap_cache_get_statistics(s->mmap, /* ret_hits= */ NULL, &mmap_misses);
+
+        r = metric_append_value(array, f, "cache", "data", misses);
+        if (r < 0)
+                return r;
+
+        r = metric_append_value(array, f, "cache", "context", s->n_client_context_misses);
+        if (r < 0)
+                return r;
+
+        r = metric_append_value(array, f, "cache", "cgroup", s->n_client_cgroup_misses);
+        if (r < 0)
+                return r;
+
+        return metric_append_value(array, f, "cache", "mmap", mmap_misses);
+}
+
+static int metric_disk_usage(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Server *s = ASSERT_PTR(userdata);
+        const JournalStorage *storages[] = { &s->runtime_storage, &s->system_storage };
+        int r;
+
+        /* Reports the values as of the last time the space was determined, we don't want to stat the file
+         * system each time metrics are collected */
+
+        FOREACH_ELEMENT(storage, storages) {
+                if (!timestamp_is_set((*storage)->space.timestamp))
+                        continue;
+
+                r = metric_append_value(array, f, "storage", (*storage)->name, (*storage)->space.vfs_used);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int metric_disk_limit(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Server *s = ASSERT_PTR(userdata);
+        const JournalStorage *storages[] = { &s->runtime_storage, &s->system_storage };
+        int r;
+
+        FOREACH_ELEMENT(storage, storages) {
+                if (!timestamp_is_set((*storage)->space.timestamp))
+                        continue;
+
+                r = metric_append_value(array, f, "storage", (*storage)->name, (*storage)->space.limit);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int metric_stdout_streams(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Server *s = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, s->n_stdout_streams);
+}
+
+static int metric_write_queue(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Server *s = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, s->n_write_queue);
+}
+
+static const MetricFamily server_metric_families[] = {
+        { "io.systemd.Journal.CacheHitsTotal",   "Cache hits, by cache",                                   METRIC_COUNTER, metric_cache_hits     },
+        { "io.systemd.Journal.CacheMissesTotal", "Cache misses, by cache",                                 METRIC_COUNTER, metric_cache_misses   },
+        { "io.systemd.Journal.DiskUsageBytes",   "Disk space used by journal files, as of the last check", METRIC_GAUGE,   metric_disk_usage     },
+        { "io.systemd.Journal.DiskLimitBytes",   "Disk space journal files may use, as of the last check", METRIC_GAUGE,   metric_disk_limit     },
+        { "io.systemd.Journal.StdoutStreams",    "Connected stdout streams",                               METRIC_GAUGE,   metric_stdout_streams },
+        { "io.systemd.Journal.WriteQueueLength", "Log messages not written to the journal files yet",      METRIC_GAUGE,   metric_write_queue    },
+        {}
+};
+
+static int vl_method_list_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_list(link, parameters, server_metric_families, userdata);
+}
+
+static int vl_method_describe_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_describe(link, parameters, server_metric_families);
+}
+
 static int vl_connect(sd_varlink_server *server, sd_varlink *link, void *userdata) {
         Server *s = ASSERT_PTR(userdata);
 
@@ -2347,6 +2859,7 @@ static int server_open_varlink(Server *s, const char *socket, int fd) {
         r = sd_varlink_server_add_interface_many(
                         s->varlink_server,
                         &vl_interface_io_systemd_Journal,
+                        &vl_interface_io_systemd_Metrics,
                         &vl_interface_io_systemd_service);
         if (r < 0)
                 return log_error_errno(r, "Failed to add Journal interface to varlink server: %m");
@@ -2357,6 +2870,9 @@ static int server_open_varlink(Server *s, const char *socket, int fd) {
                         "io.systemd.Journal.Rotate",         vl_method_rotate,
                         "io.systemd.Journal.FlushToVar",     vl_method_flush_to_var,
                         "io.systemd.Journal.RelinquishVar",  vl_method_relinquish_var,
+                        "io.systemd.Journal.GetStatistics",  vl_method_get_statistics,
+                        "io.systemd.Metrics.List",           vl_method_list_metrics,
+                        "io.systemd.Metrics.Describe",       vl_method_describe_metrics,
                         "io.systemd.service.Ping",           varlink_method_ping,
                         "io.systemd.service.SetLogLevel",    varlink_method_set_log_level,
                         "io.systemd.service.GetEnvironment", varlink_method_get_environment);
@@ -2608,7 +3124,6 @@ int server_new(Server **ret) {
                 .audit_fd = -EBADF,
                 .hostname_fd = -EBADF,
                 .notify_fd = -EBADF,
-                .forward_socket_fd = -EBADF,
 
                 .compress.enabled = true,
                 .compress.threshold_bytes = UINT64_MAX,
@@ -2623,9 +3138,12 @@ int server_new(Server **ret) {
 
                 .ratelimit_interval = DEFAULT_RATE_LIMIT_INTERVAL,
                 .ratelimit_burst = DEFAULT_RATE_LIMIT_BURST,
+                .ratelimit_groups_max = JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT,
 
                 .forward_to_wall = true,
                 .forward_to_socket = { .sockaddr.sa.sa_family = AF_UNSPEC },
+                .forward_socket_queue = FORWARD_QUEUE_INIT("socket", /* close_when_drained= */ false),
+                .forward_console_queue = FORWARD_QUEUE_INIT("console", /* close_when_drained= */ true),
 
                 .max_file_usec = DEFAULT_MAX_FILE_USEC,
 
@@ -2903,6 +3421,9 @@ Server* server_free(Server *s) {
         if (!s)
                 return NULL;
 
+        server_flush_write_queue(s);
+        free(s->write_queue);
+
         free(s->namespace);
         free(s->namespace_field);
 
@@ -2920,12 +3441,16 @@ Server* server_free(Server *s) {
 
         sd_varlink_server_unref(s->varlink_server);
 
+        forward_queue_done(&s->forward_socket_queue);
+        forward_queue_done(&s->forward_console_queue);
+
         sd_event_source_unref(s->syslog_event_source);
         sd_event_source_unref(s->native_event_source);
         sd_event_source_unref(s->stdout_event_source);
         sd_event_source_unref(s->dev_kmsg_event_source);
         sd_event_source_unref(s->audit_event_source);
         sd_event_source_unref(s->sync_event_source);
+        sd_event_source_unref(s->write_queue_event_source);
         sd_event_source_unref(s->sigusr1_event_source);
         sd_event_source_unref(s->sigusr2_event_source);
         sd_event_source_unref(s->sigterm_event_source);
@@ -2944,19 +3469,22 @@ Server* server_free(Server *s) {
         safe_close(s->audit_fd);
         safe_close(s->hostname_fd);
         safe_close(s->notify_fd);
-        safe_close(s->forward_socket_fd);
 
-        ordered_hashmap_free(s->ratelimit_groups_by_id);
+        journal_ratelimit_free(s->ratelimit);
 
         server_unmap_seqnum_file(s->seqnum, sizeof(*s->seqnum));
         server_unmap_seqnum_file(s->kernel_seqnum, sizeof(*s->kernel_seqnum));
 
         free(s->buffer);
+        free(s->datagram_batch);
+        hashmap_free(s->kmsg_devices);
         free(s->tty_path);
         free(s->cgroup_root);
         free(s->hostname_field);
         free(s->runtime_storage.path);
         free(s->system_storage.path);
+        journal_vacuum_cache_free(s->runtime_storage.vacuum_cache);
+        journal_vacuum_cache_free(s->system_storage.vacuum_cache);
         free(s->runtime_directory);
 
         mmap_cache_unref(s->mmap);
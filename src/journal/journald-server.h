@@ -8,12 +8,16 @@
 #include "sd-varlink.h"
 
 typedef struct Server Server;
+typedef struct PendingEntry PendingEntry;
 
 #include "common-signal.h"
 #include "conf-parser.h"
 #include "hashmap.h"
 #include "journal-file.h"
+#include "journal-vacuum.h"
 #include "journald-context.h"
+#include "journald-forward.h"
+#include "journald-rate-limit.h"
 #include "journald-stream.h"
 #include "list.h"
 #include "prioq.h"
@@ -59,6 +63,7 @@ typedef struct JournalStorage {
 
         JournalMetrics metrics;
         JournalStorageSpace space;
+        JournalVacuumCache *vacuum_cache;
 } JournalStorage;
 
 /* This structure will be kept in $RUNTIME_DIRECTORY/seqnum and is mapped by journald, and is used to
@@ -78,7 +83,6 @@ struct Server {
         int audit_fd;
         int hostname_fd;
         int notify_fd;
-        int forward_socket_fd;
 
         sd_event *event;
 
@@ -88,6 +92,7 @@ struct Server {
         sd_event_source *dev_kmsg_event_source;
         sd_event_source *audit_event_source;
         sd_event_source *sync_event_source;
+        sd_event_source *write_queue_event_source;
         sd_event_source *sigusr1_event_source;
         sd_event_source *sigusr2_event_source;
         sd_event_source *sigterm_event_source;
@@ -106,11 +111,13 @@ struct Server {
         SeqnumData *seqnum;
 
         char *buffer;
+        char *datagram_batch; /* DATAGRAM_BATCH_MAX slots, see server_process_datagram_batch() */
 
-        OrderedHashmap *ratelimit_groups_by_id;
+        JournalRateLimit *ratelimit;
         usec_t sync_interval_usec;
         usec_t ratelimit_interval;
         unsigned ratelimit_burst;
+        unsigned ratelimit_groups_max;
 
         JournalStorage runtime_storage;
         JournalStorage system_storage;
@@ -125,6 +132,8 @@ struct Server {
         bool forward_to_console;
         bool forward_to_wall;
         SocketAddress forward_to_socket;
+        ForwardQueue forward_socket_queue;
+        ForwardQueue forward_console_queue;
 
         unsigned n_forward_syslog_missed;
         usec_t last_warn_forward_syslog_missed;
@@ -156,10 +165,12 @@ struct Server {
         uint64_t *kernel_seqnum;
         bool dev_kmsg_readable:1;
         RateLimit kmsg_own_ratelimit;
+        Hashmap *kmsg_devices; /* udev metadata of devices referenced by kernel messages, see journald-kmsg.c */
 
         bool send_watchdog:1;
         bool sent_notify_ready:1;
         bool sync_scheduled:1;
+        bool write_queue_flushing:1;
 
         char machine_id_field[STRLEN("_MACHINE_ID=") + SD_ID128_STRING_MAX];
         char boot_id_field[STRLEN("_BOOT_ID=") + SD_ID128_STRING_MAX];
@@ -174,14 +185,23 @@ struct Server {
 
         usec_t last_realtime_clock;
 
+        /* Log messages not written to the journal files yet, see server_queue_write_to_journal() */
+        PendingEntry *write_queue;
+        size_t n_write_queue;
+        size_t write_queue_size;
+
         size_t line_max;
 
         /* Caching of client metadata */
         Hashmap *client_contexts;
         Prioq *client_contexts_lru;
+        Hashmap *client_cgroups; /* ClientCgroup objects by cgroup path, not referenced by the hashmap */
 
         usec_t last_cache_pid_flush;
 
+        uint64_t n_client_context_hits, n_client_context_misses;
+        uint64_t n_client_cgroup_hits, n_client_cgroup_misses;
+
         ClientContext *my_context; /* the context of journald itself */
         ClientContext *pid1_context; /* the context of PID 1 */
 
@@ -6,6 +6,7 @@
 
 #include "fd-util.h"
 #include "iovec-util.h"
+#include "journald-forward.h"
 #include "journald-socket.h"
 #include "log.h"
 #include "macro.h"
@@ -24,7 +25,7 @@ static int server_open_forward_socket(Server *s) {
         if (s->forward_to_socket.sockaddr.sa.sa_family == AF_UNSPEC || s->namespace)
                 return 0;
         /* All ready, nothing to do. */
-        if (s->forward_socket_fd >= 0)
+        if (s->forward_socket_queue.fd >= 0)
                 return 1;
 
         addr = &s->forward_to_socket;
@@ -35,15 +36,22 @@ static int server_open_forward_socket(Server *s) {
                 return log_debug_errno(SYNTHETIC_ERRNO(ESOCKTNOSUPPORT),
                                        "Unsupported socket type for forward socket: %d", family);
 
-        socket_fd = socket(family, SOCK_STREAM|SOCK_CLOEXEC, 0);
+        /* Never block on the remote side, see forward_queue_write(). Anything written before the connection
+         * is fully established is queued. */
+        socket_fd = socket(family, SOCK_STREAM|SOCK_CLOEXEC|SOCK_NONBLOCK, 0);
         if (socket_fd < 0)
                 return log_debug_errno(errno, "Failed to create forward socket, ignoring: %m");
 
-        if (connect(socket_fd, &addr->sockaddr.sa, addr->size) < 0)
+        if (connect(socket_fd, &addr->sockaddr.sa, addr->size) >= 0)
+                log_debug("Successfully connected to remote address for forwarding.");
+        else if (errno == EINPROGRESS) {
+                /* Completion is checked for once the socket becomes writable, see forward_queue_dispatch() */
+                s->forward_socket_queue.connecting = true;
+                log_debug("Connecting to remote address for forwarding.");
+        } else
                 return log_debug_errno(errno, "Failed to connect to remote address for forwarding, ignoring: %m");
 
-        s->forward_socket_fd = TAKE_FD(socket_fd);
-        log_debug("Successfully connected to remote address for forwarding.");
+        s->forward_socket_queue.fd = TAKE_FD(socket_fd);
         return 1;
 }
 
@@ -151,12 +159,13 @@ int server_forward_socket(
         xsprintf(monotonic_buf, "__MONOTONIC_TIMESTAMP="USEC_FMT"\n\n", ts->monotonic);
         iov[iov_idx++] = IOVEC_MAKE_STRING(monotonic_buf);
 
-        if (writev(s->forward_socket_fd, iov, iov_idx) < 0) {
-                log_debug_errno(errno, "Failed to forward log message over socket: %m");
+        r = forward_queue_write(s, &s->forward_socket_queue, iov, iov_idx);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to forward log message over socket: %m");
 
                 /* If we failed to send once we will probably fail again so wait for a new connection to
                  * establish before attempting to forward again. */
-                s->forward_socket_fd = safe_close(s->forward_socket_fd);
+                forward_queue_reset(&s->forward_socket_queue);
         }
 
         return 0;
@@ -48,6 +48,10 @@
  * let's enforce a line length matching the maximum unit name length (255) */
 #define STDOUT_STREAM_SETUP_PROTOCOL_LINE_MAX (UNIT_NAME_MAX-1U)
 
+/* Streams that keep filling up their read buffer get a larger one, up to this size (or a bit more than the line
+ * size, if that's larger), so that a client logging at a high rate is served with fewer, larger reads */
+#define STDOUT_STREAM_BUFFER_MAX (128U*1024U)
+
 typedef enum StdoutStreamState {
         STDOUT_STREAM_IDENTIFIER,
         STDOUT_STREAM_UNIT_ID,
@@ -90,10 +94,13 @@ struct StdoutStream {
 
         bool fdstore:1;
         bool in_notify_queue:1;
+        bool buffer_filled:1;
 
         char *buffer;
         size_t length;
 
+        char *identifier_field;
+
         sd_event_source *event_source;
 
         char *state_file;
@@ -128,6 +135,7 @@ StdoutStream* stdout_stream_free(StdoutStream *s) {
         safe_close(s->fd);
         free(s->label);
         free(s->identifier);
+        free(s->identifier_field);
         free(s->unit_id);
         free(s->state_file);
         free(s->buffer);
@@ -255,7 +263,7 @@ static int stdout_stream_log(
         int priority;
         char syslog_priority[] = "PRIORITY=\0";
         char syslog_facility[STRLEN("SYSLOG_FACILITY=") + DECIMAL_STR_MAX(int) + 1];
-        _cleanup_free_ char *message = NULL, *syslog_identifier = NULL;
+        _cleanup_free_ char *message = NULL;
         size_t n = 0, m;
         int r;
 
@@ -315,11 +323,11 @@ static int stdout_stream_log(
                 iovec[n++] = IOVEC_MAKE_STRING(syslog_facility);
         }
 
-        if (s->identifier) {
-                syslog_identifier = strjoin("SYSLOG_IDENTIFIER=", s->identifier);
-                if (syslog_identifier)
-                        iovec[n++] = IOVEC_MAKE_STRING(syslog_identifier);
-        }
+        /* The identifier doesn't change once the stream is set up, hence prepare the field only once */
+        if (s->identifier && !s->identifier_field)
+                s->identifier_field = strjoin("SYSLOG_IDENTIFIER=", s->identifier);
+        if (s->identifier_field)
+                iovec[n++] = IOVEC_MAKE_STRING(s->identifier_field);
 
         static const char * const line_break_field_table[_LINE_BREAK_MAX] = {
                 [LINE_BREAK_NEWLINE]    = NULL, /* Do not add field if traditional newline */
@@ -502,34 +510,36 @@ static int stdout_stream_scan(
                 LineBreak force_flush,
                 size_t *ret_consumed) {
 
+        char *end = NULL, *sentinel, saved;
         size_t consumed = 0;
-        int r;
+        int r = 0;
 
         assert(s);
         assert(p);
 
+        /* The buffer always has room for a terminating NUL, see stdout_stream_process(). Let's add one, so that we
+         * can look for both kinds of line terminators in a single pass with strchrnul(). The byte might be part
+         * of data read later on, hence restore it afterwards. */
+        sentinel = p + remaining;
+        saved = *sentinel;
+        *sentinel = 0;
+
         for (;;) {
                 LineBreak line_break;
-                size_t skip, found;
-                char *end1, *end2;
-                size_t tmp_remaining, line_max;
+                size_t skip, found, line_max;
 
                 line_max = stdout_stream_line_max(s);
-                tmp_remaining = MIN(remaining, line_max);
 
-                end1 = memchr(p, '\n', tmp_remaining);
-                end2 = memchr(p, 0, end1 ? (size_t) (end1 - p) : tmp_remaining);
+                /* If we forced a line break last time, the terminator we found is still ahead of us */
+                if (!end || end < p)
+                        end = strchrnul(p, '\n');
 
-                if (end2) {
-                        /* We found a NUL terminator */
-                        found = end2 - p;
-                        skip = found + 1;
-                        line_break = LINE_BREAK_NUL;
-                } else if (end1) {
-                        /* We found a \n terminator */
-                        found = end1 - p;
+                found = end - p;
+
+                if (found < MIN(remaining, line_max)) {
+                        /* We found a \n or NUL terminator */
                         skip = found + 1;
-                        line_break = LINE_BREAK_NEWLINE;
+                        line_break = *end == '\n' ? LINE_BREAK_NEWLINE : LINE_BREAK_NUL;
                 } else if (remaining >= line_max) {
                         /* Force a line break after the maximum line length */
                         found = skip = line_max;
@@ -539,7 +549,7 @@ static int stdout_stream_scan(
 
                 r = stdout_stream_found(s, p, found, line_break);
                 if (r < 0)
-                        return r;
+                        goto finish;
 
                 p += skip;
                 consumed += skip;
@@ -549,7 +559,7 @@ static int stdout_stream_scan(
         if (force_flush >= 0 && remaining > 0) {
                 r = stdout_stream_found(s, p, remaining, force_flush);
                 if (r < 0)
-                        return r;
+                        goto finish;
 
                 consumed += remaining;
         }
@@ -557,7 +567,9 @@ static int stdout_stream_scan(
         if (ret_consumed)
                 *ret_consumed = consumed;
 
-        return 0;
+finish:
+        *sentinel = saved;
+        return r < 0 ? r : 0;
 }
 
 static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
@@ -582,10 +594,16 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
                 goto terminate;
         }
 
-        /* If the buffer is almost full, add room for another 1K */
+        /* If the buffer is almost full, add room for another 1K. If the last read filled the buffer completely,
+         * the client is likely logging a lot, hence double the buffer then. */
         allocated = MALLOC_ELEMENTSOF(s->buffer);
-        if (s->length + 512 >= allocated) {
-                if (!GREEDY_REALLOC(s->buffer, s->length + 1 + 1024)) {
+        if (s->length + 512 >= allocated || (s->buffer_filled && allocated < STDOUT_STREAM_BUFFER_MAX)) {
+                size_t want = s->length + 1 + 1024;
+
+                if (s->buffer_filled)
+                        want = MAX(want, MIN(allocated * 2, STDOUT_STREAM_BUFFER_MAX));
+
+                if (!GREEDY_REALLOC(s->buffer, want)) {
                         log_oom();
                         goto terminate;
                 }
@@ -593,9 +611,9 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
                 allocated = MALLOC_ELEMENTSOF(s->buffer);
         }
 
-        /* Try to make use of the allocated buffer in full, but never read more than the configured line size. Also,
-         * always leave room for a terminating NUL we might need to add. */
-        limit = MIN(allocated - 1, MAX(s->server->line_max, STDOUT_STREAM_SETUP_PROTOCOL_LINE_MAX));
+        /* Try to make use of the allocated buffer in full, stdout_stream_scan() takes care of breaking up lines
+         * longer than the configured line size. Always leave room for a terminating NUL we need to add. */
+        limit = allocated - 1;
         assert(s->length <= limit);
         iovec = IOVEC_MAKE(s->buffer + s->length, limit - s->length);
 
@@ -609,6 +627,8 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
         }
         cmsg_close_all(&msghdr);
 
+        s->buffer_filled = (size_t) l == iovec.iov_len;
+
         if (l == 0) {
                 (void) stdout_stream_scan(s, s->buffer, s->length, /* force_flush = */ LINE_BREAK_EOF, NULL);
                 goto terminate;
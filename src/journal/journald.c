@@ -7,6 +7,7 @@
 
 #include "format-util.h"
 #include "journal-authenticate.h"
+#include "journald-forward.h"
 #include "journald-kmsg.h"
 #include "journald-server.h"
 #include "journald-syslog.h"
@@ -116,6 +117,8 @@ static int run(int argc, char *argv[]) {
 
                 server_maybe_append_tags(s);
                 server_maybe_warn_forward_syslog_missed(s);
+                server_maybe_warn_forward_dropped(s, &s->forward_console_queue);
+                server_maybe_warn_forward_dropped(s, &s->forward_socket_queue);
         }
 
         if (s->namespace)
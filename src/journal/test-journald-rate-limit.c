@@ -4,37 +4,69 @@
 #include "tests.h"
 
 TEST(journal_ratelimit_test) {
-        _cleanup_ordered_hashmap_free_ OrderedHashmap *rl = NULL;
+        _cleanup_(journal_ratelimit_freep) JournalRateLimit *rl = NULL;
         int r;
 
         for (unsigned i = 0; i < 20; i++) {
-                r = journal_ratelimit_test(&rl, "hoge", USEC_PER_SEC, 10, LOG_DEBUG, 0);
+                r = journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "hoge", USEC_PER_SEC, 10, LOG_DEBUG, 0);
                 assert_se(r == (i < 10 ? 1 : 0));
-                r = journal_ratelimit_test(&rl, "foo", 10 * USEC_PER_SEC, 10, LOG_DEBUG, 0);
+                r = journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "foo", 10 * USEC_PER_SEC, 10, LOG_DEBUG, 0);
                 assert_se(r == (i < 10 ? 1 : 0));
         }
 
         /* Different priority group with the same ID is not ratelimited. */
-        assert_se(journal_ratelimit_test(&rl, "hoge", USEC_PER_SEC, 10, LOG_INFO, 0) == 1);
-        assert_se(journal_ratelimit_test(&rl, "foo", 10 * USEC_PER_SEC, 10, LOG_INFO, 0) == 1);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "hoge", USEC_PER_SEC, 10, LOG_INFO, 0) == 1);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "foo", 10 * USEC_PER_SEC, 10, LOG_INFO, 0) == 1);
         /* Still LOG_DEBUG is ratelimited. */
-        assert_se(journal_ratelimit_test(&rl, "hoge", USEC_PER_SEC, 10, LOG_DEBUG, 0) == 0);
-        assert_se(journal_ratelimit_test(&rl, "foo", 10 * USEC_PER_SEC, 10, LOG_DEBUG, 0) == 0);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "hoge", USEC_PER_SEC, 10, LOG_DEBUG, 0) == 0);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "foo", 10 * USEC_PER_SEC, 10, LOG_DEBUG, 0) == 0);
         /* Different ID is not ratelimited. */
-        assert_se(journal_ratelimit_test(&rl, "quux", USEC_PER_SEC, 10, LOG_DEBUG, 0) == 1);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "quux", USEC_PER_SEC, 10, LOG_DEBUG, 0) == 1);
 
         usleep_safe(USEC_PER_SEC);
 
         /* The ratelimit is now expired (11 trials are suppressed, so the return value should be 12). */
-        assert_se(journal_ratelimit_test(&rl, "hoge", USEC_PER_SEC, 10, LOG_DEBUG, 0) == 1 + 11);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "hoge", USEC_PER_SEC, 10, LOG_DEBUG, 0) == 1 + 11);
 
         /* foo is still ratelimited. */
-        assert_se(journal_ratelimit_test(&rl, "foo", 10 * USEC_PER_SEC, 10, LOG_DEBUG, 0) == 0);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "foo", 10 * USEC_PER_SEC, 10, LOG_DEBUG, 0) == 0);
 
         /* Still other priority and/or other IDs are not ratelimited. */
-        assert_se(journal_ratelimit_test(&rl, "hoge", USEC_PER_SEC, 10, LOG_INFO, 0) == 1);
-        assert_se(journal_ratelimit_test(&rl, "foo", 10 * USEC_PER_SEC, 10, LOG_INFO, 0) == 1);
-        assert_se(journal_ratelimit_test(&rl, "quux", USEC_PER_SEC, 10, LOG_DEBUG, 0) == 1);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "hoge", USEC_PER_SEC, 10, LOG_INFO, 0) == 1);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "foo", 10 * USEC_PER_SEC, 10, LOG_INFO, 0) == 1);
+        assert_se(journal_ratelimit_test(&rl, JOURNAL_RATELIMIT_GROUPS_MAX_DEFAULT, "quux", USEC_PER_SEC, 10, LOG_DEBUG, 0) == 1);
+}
+
+TEST(journal_ratelimit_lru) {
+        _cleanup_(journal_ratelimit_freep) JournalRateLimit *rl = NULL;
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        sd_json_variant *e;
+
+        /* Exhaust the burst of both groups */
+        ASSERT_EQ(journal_ratelimit_test(&rl, 2, "a", USEC_PER_HOUR, 1, LOG_INFO, 0), 1);
+        ASSERT_EQ(journal_ratelimit_test(&rl, 2, "b", USEC_PER_HOUR, 1, LOG_INFO, 0), 1);
+        ASSERT_EQ(journal_ratelimit_test(&rl, 2, "b", USEC_PER_HOUR, 1, LOG_INFO, 0), 0);
+        ASSERT_EQ(journal_ratelimit_test(&rl, 2, "a", USEC_PER_HOUR, 1, LOG_INFO, 0), 0);
+        ASSERT_EQ(journal_ratelimit_test(&rl, 2, "a", USEC_PER_HOUR, 1, LOG_INFO, 0), 0);
+
+        ASSERT_OK(journal_ratelimit_build_json(rl, &v));
+        ASSERT_EQ(sd_json_variant_elements(v), 2U);
+        ASSERT_NOT_NULL(e = sd_json_variant_by_index(v, 0));
+        ASSERT_STREQ(sd_json_variant_string(sd_json_variant_by_key(e, "Unit")), "a");
+        ASSERT_EQ(sd_json_variant_unsigned(sd_json_variant_by_key(e, "Suppressed")), 2U);
+        v = sd_json_variant_unref(v);
+
+        /* "b" is the least recently used group now, and must make room for "c" */
+        ASSERT_EQ(journal_ratelimit_test(&rl, 2, "c", USEC_PER_HOUR, 1, LOG_INFO, 0), 1);
+        ASSERT_EQ(journal_ratelimit_test(&rl, 2, "a", USEC_PER_HOUR, 1, LOG_INFO, 0), 0);
+
+        ASSERT_OK(journal_ratelimit_build_json(rl, &v));
+        ASSERT_EQ(sd_json_variant_elements(v), 1U);
+        v = sd_json_variant_unref(v);
+
+        /* "c" got evicted to make room for "b" again, which hence starts out fresh */
+        ASSERT_EQ(journal_ratelimit_test(&rl, 2, "b", USEC_PER_HOUR, 1, LOG_INFO, 0), 1);
+        ASSERT_EQ(journal_ratelimit_test(&rl, 2, "a", USEC_PER_HOUR, 1, LOG_INFO, 0), 0);
 }
 
 DEFINE_TEST_MAIN(LOG_INFO);
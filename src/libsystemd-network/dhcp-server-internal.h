@@ -8,12 +8,20 @@
 #include "sd-dhcp-server.h"
 #include "sd-event.h"
 
+#include "bitmap.h"
 #include "dhcp-client-id-internal.h"
 #include "dhcp-option.h"
 #include "network-common.h"
 #include "ordered-set.h"
+#include "prioq.h"
 #include "time-util.h"
 
+/* Bitmap refuses to store numbers above 0xffff, the addresses of larger pools are probed one by one */
+#define DHCP_SERVER_POOL_INDEX_SIZE_MAX UINT32_C(0x10000)
+
+/* Saving leases is delayed a bit, so that a burst of lease changes results in a single write */
+#define DHCP_SERVER_SAVE_LEASES_DELAY_USEC (1 * USEC_PER_SEC)
+
 typedef enum DHCPRawOption {
         DHCP_RAW_OPTION_DATA_UINT8,
         DHCP_RAW_OPTION_DATA_UINT16,
@@ -62,6 +70,8 @@ struct sd_dhcp_server {
         Hashmap *bound_leases_by_address;
         Hashmap *static_leases_by_client_id;
         Hashmap *static_leases_by_address;
+        Prioq *bound_leases_by_expiration;
+        Bitmap *bound_leases_in_pool; /* offsets from pool_offset of the addresses of bound leases */
 
         usec_t max_lease_time;
         usec_t default_lease_time;
@@ -78,6 +88,7 @@ struct sd_dhcp_server {
 
         int lease_dir_fd;
         char *lease_file;
+        sd_event_source *save_leases_event_source;
 };
 
 typedef struct DHCPRequest {
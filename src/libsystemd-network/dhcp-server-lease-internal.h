@@ -21,6 +21,7 @@ typedef struct sd_dhcp_server_lease {
         be32_t gateway;
         uint8_t chaddr[16];
         usec_t expiration;
+        unsigned expiration_idx;
         char *hostname;
 } sd_dhcp_server_lease;
 
@@ -30,6 +31,7 @@ int dhcp_server_put_lease(sd_dhcp_server *server, sd_dhcp_server_lease *lease, b
 
 int dhcp_server_set_lease(sd_dhcp_server *server, be32_t address, DHCPRequest *req, usec_t expiration);
 int dhcp_server_cleanup_expired_leases(sd_dhcp_server *server);
+int dhcp_server_rebuild_pool_index(sd_dhcp_server *server);
 
 sd_dhcp_server_lease* dhcp_server_get_static_lease(sd_dhcp_server *server, const DHCPRequest *req);
 
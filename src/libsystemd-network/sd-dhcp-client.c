@@ -101,6 +101,7 @@ struct sd_dhcp_client {
         void *state_userdata;
         sd_dhcp_lease *lease;
         usec_t start_delay;
+        usec_t randomized_delay;
         int ip_service_type;
         int socket_priority;
         bool socket_priority_set;
@@ -579,6 +580,15 @@ int sd_dhcp_client_set_max_attempts(sd_dhcp_client *client, uint64_t max_attempt
         return 0;
 }
 
+int sd_dhcp_client_set_randomized_delay(sd_dhcp_client *client, usec_t usec) {
+        assert_return(client, -EINVAL);
+        assert_return(!sd_dhcp_client_is_running(client), -EBUSY);
+
+        client->randomized_delay = usec;
+
+        return 0;
+}
+
 int sd_dhcp_client_add_option(sd_dhcp_client *client, sd_dhcp_option *v) {
         int r;
 
@@ -2212,9 +2222,20 @@ int sd_dhcp_client_start(sd_dhcp_client *client) {
         if (client->last_addr && !client->anonymize)
                 client_set_state(client, DHCP_STATE_INIT_REBOOT);
 
-        r = client_start(client);
+        /* RFC2131 section 4.4.1:
+           The client SHOULD wait a random time between one and ten seconds to desynchronize the use of
+           DHCP at startup.
+           We do not do that by default, as it slows down boot. But when many interfaces come up at the
+           same time, spreading the initial messages avoids hitting the server with all of them at once. */
+        client->start_delay = client->randomized_delay > 0 ? random_u64_range(client->randomized_delay) : 0;
+
+        r = client_start_delayed(client);
         if (r >= 0)
-                log_dhcp_client(client, "STARTED on ifindex %i", client->ifindex);
+                log_dhcp_client(client, "STARTED on ifindex %i, first message in %s",
+                                client->ifindex, FORMAT_TIMESPAN(client->start_delay, USEC_PER_MSEC));
+
+        /* Only the initial message is delayed, restarts after NAK use their own backoff. */
+        client->start_delay = 0;
 
         return r;
 }
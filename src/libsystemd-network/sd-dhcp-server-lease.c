@@ -8,12 +8,80 @@
 #include "mkdir.h"
 #include "tmpfile-util.h"
 
+static bool dhcp_server_pool_index(sd_dhcp_server *server, be32_t address, unsigned *ret) {
+        uint32_t offset;
+
+        assert(server);
+        assert(ret);
+
+        if (server->pool_size == 0 || server->pool_size > DHCP_SERVER_POOL_INDEX_SIZE_MAX)
+                return false;
+
+        if ((address & server->netmask) != server->subnet)
+                return false;
+
+        offset = be32toh(address & ~server->netmask);
+        if (offset < server->pool_offset || offset - server->pool_offset >= server->pool_size)
+                return false;
+
+        *ret = offset - server->pool_offset;
+        return true;
+}
+
+static int dhcp_server_pool_index_set(sd_dhcp_server *server, be32_t address) {
+        unsigned i;
+        int r;
+
+        assert(server);
+
+        if (!dhcp_server_pool_index(server, address, &i))
+                return 0;
+
+        r = bitmap_ensure_allocated(&server->bound_leases_in_pool);
+        if (r < 0)
+                return r;
+
+        return bitmap_set(server->bound_leases_in_pool, i);
+}
+
+static void dhcp_server_pool_index_unset(sd_dhcp_server *server, be32_t address) {
+        unsigned i;
+
+        assert(server);
+
+        if (dhcp_server_pool_index(server, address, &i))
+                bitmap_unset(server->bound_leases_in_pool, i);
+}
+
+int dhcp_server_rebuild_pool_index(sd_dhcp_server *server) {
+        sd_dhcp_server_lease *lease;
+        int r;
+
+        assert(server);
+
+        bitmap_clear(server->bound_leases_in_pool);
+
+        HASHMAP_FOREACH(lease, server->bound_leases_by_address) {
+                r = dhcp_server_pool_index_set(server, lease->address);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int dhcp_server_lease_compare_expiration(const sd_dhcp_server_lease *a, const sd_dhcp_server_lease *b) {
+        return CMP(a->expiration, b->expiration);
+}
+
 static sd_dhcp_server_lease* dhcp_server_lease_free(sd_dhcp_server_lease *lease) {
         if (!lease)
                 return NULL;
 
         if (lease->server) {
-                hashmap_remove_value(lease->server->bound_leases_by_address, UINT32_TO_PTR(lease->address), lease);
+                if (hashmap_remove_value(lease->server->bound_leases_by_address, UINT32_TO_PTR(lease->address), lease))
+                        dhcp_server_pool_index_unset(lease->server, lease->address);
+                prioq_remove(lease->server->bound_leases_by_expiration, lease, &lease->expiration_idx);
                 hashmap_remove_value(lease->server->bound_leases_by_client_id, &lease->client_id, lease);
                 hashmap_remove_value(lease->server->static_leases_by_address, UINT32_TO_PTR(lease->address), lease);
                 hashmap_remove_value(lease->server->static_leases_by_client_id, &lease->client_id, lease);
@@ -51,7 +119,15 @@ int dhcp_server_put_lease(sd_dhcp_server *server, sd_dhcp_server_lease *lease, b
         if (r < 0)
                 return r;
 
-        return 0;
+        if (is_static)
+                return 0;
+
+        r = dhcp_server_pool_index_set(server, lease->address);
+        if (r < 0)
+                return r;
+
+        return prioq_ensure_put(&server->bound_leases_by_expiration, (compare_func_t) dhcp_server_lease_compare_expiration,
+                                lease, &lease->expiration_idx);
 }
 
 int dhcp_server_set_lease(sd_dhcp_server *server, be32_t address, DHCPRequest *req, usec_t expiration) {
@@ -67,15 +143,21 @@ int dhcp_server_set_lease(sd_dhcp_server *server, be32_t address, DHCPRequest *r
         lease = hashmap_get(server->bound_leases_by_client_id, &req->client_id);
         if (lease) {
                 if (lease->address != address) {
-                        hashmap_remove_value(server->bound_leases_by_address, UINT32_TO_PTR(lease->address), lease);
+                        if (hashmap_remove_value(server->bound_leases_by_address, UINT32_TO_PTR(lease->address), lease))
+                                dhcp_server_pool_index_unset(server, lease->address);
                         lease->address = address;
 
                         r = hashmap_ensure_put(&server->bound_leases_by_address, NULL, UINT32_TO_PTR(lease->address), lease);
                         if (r < 0)
                                 return r;
+
+                        r = dhcp_server_pool_index_set(server, lease->address);
+                        if (r < 0)
+                                return r;
                 }
 
                 lease->expiration = expiration;
+                prioq_reshuffle(server->bound_leases_by_expiration, lease, &lease->expiration_idx);
 
                 TAKE_PTR(lease);
                 return 0;
@@ -124,11 +206,12 @@ int dhcp_server_cleanup_expired_leases(sd_dhcp_server *server) {
         if (r < 0)
                 return r;
 
-        HASHMAP_FOREACH(lease, server->bound_leases_by_client_id)
-                if (lease->expiration < time_now) {
-                        log_dhcp_server(server, "CLEAN (0x%x)", be32toh(lease->address));
-                        sd_dhcp_server_lease_unref(lease);
-                }
+        /* The earliest expiring lease comes first, hence this does not need to go through all leases. */
+        while ((lease = prioq_peek(server->bound_leases_by_expiration)) && lease->expiration < time_now) {
+                log_dhcp_server(server, "CLEAN (0x%x)", be32toh(lease->address));
+                prioq_remove(server->bound_leases_by_expiration, lease, &lease->expiration_idx);
+                sd_dhcp_server_lease_unref(lease);
+        }
 
         return 0;
 }
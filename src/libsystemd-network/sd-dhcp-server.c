@@ -16,6 +16,7 @@
 #include "dhcp-server-internal.h"
 #include "dhcp-server-lease-internal.h"
 #include "dns-domain.h"
+#include "event-util.h"
 #include "fd-util.h"
 #include "in-addr-util.h"
 #include "iovec-util.h"
@@ -31,15 +32,39 @@
 #define DHCP_DEFAULT_LEASE_TIME_USEC USEC_PER_HOUR
 #define DHCP_MAX_LEASE_TIME_USEC (USEC_PER_HOUR*12)
 
-static void server_on_lease_change(sd_dhcp_server *server) {
+static int server_save_leases_handler(sd_event_source *s, uint64_t usec, void *userdata) {
+        sd_dhcp_server *server = ASSERT_PTR(userdata);
         int r;
 
-        assert(server);
-
         r = dhcp_server_save_leases(server);
         if (r < 0)
                 log_dhcp_server_errno(server, r, "Failed to save leases, ignoring: %m");
 
+        return 0;
+}
+
+static void server_on_lease_change(sd_dhcp_server *server) {
+        int r;
+
+        assert(server);
+
+        /* The lease file contains all bound leases, hence do not rewrite it for every single change. If the
+         * timer is already armed, the change will be saved with the pending write. */
+        if (server->lease_file) {
+                r = event_reset_time_relative(
+                                server->event, &server->save_leases_event_source,
+                                CLOCK_BOOTTIME, DHCP_SERVER_SAVE_LEASES_DELAY_USEC, /* accuracy = */ 0,
+                                server_save_leases_handler, server,
+                                server->event_priority, "dhcp-server-save-leases", /* force_reset = */ false);
+                if (r < 0) {
+                        log_dhcp_server_errno(server, r, "Failed to schedule saving leases, saving them now: %m");
+
+                        r = dhcp_server_save_leases(server);
+                        if (r < 0)
+                                log_dhcp_server_errno(server, r, "Failed to save leases, ignoring: %m");
+                }
+        }
+
         if (server->callback)
                 server->callback(server, SD_DHCP_SERVER_EVENT_LEASE_CHANGED, server->callback_userdata);
 }
@@ -101,6 +126,8 @@ int sd_dhcp_server_configure_pool(
                 server->address = address->s_addr;
                 server->netmask = netmask;
                 server->subnet = address->s_addr & netmask;
+
+                return dhcp_server_rebuild_pool_index(server);
         }
 
         return 0;
@@ -137,6 +164,8 @@ static sd_dhcp_server *dhcp_server_free(sd_dhcp_server *server) {
         server->bound_leases_by_client_id = hashmap_free(server->bound_leases_by_client_id);
         server->static_leases_by_address = hashmap_free(server->static_leases_by_address);
         server->static_leases_by_client_id = hashmap_free(server->static_leases_by_client_id);
+        prioq_free(server->bound_leases_by_expiration);
+        bitmap_free(server->bound_leases_in_pool);
 
         ordered_set_free(server->extra_options);
         ordered_set_free(server->vendor_options);
@@ -285,6 +314,11 @@ int sd_dhcp_server_stop(sd_dhcp_server *server) {
 
         running = sd_dhcp_server_is_running(server);
 
+        /* Write out the changes not saved yet. */
+        if (sd_event_source_get_enabled(server->save_leases_event_source, NULL) > 0)
+                (void) server_save_leases_handler(server->save_leases_event_source, 0, server);
+        server->save_leases_event_source = sd_event_source_disable_unref(server->save_leases_event_source);
+
         server->receive_message = sd_event_source_disable_unref(server->receive_message);
         server->receive_broadcast = sd_event_source_disable_unref(server->receive_broadcast);
 
@@ -1015,6 +1049,46 @@ static bool address_available(sd_dhcp_server *server, be32_t address) {
         return true;
 }
 
+static be32_t pool_find_free_address(sd_dhcp_server *server, uint64_t hash) {
+        bool indexed, wrapped = false;
+        uint32_t start, i;
+
+        assert(server);
+        assert(server->pool_size > 0);
+
+        /* Go through the pool starting at the given offset. For pools that are small enough, the offsets of
+         * bound leases are skipped quickly through the bitmap, hence usually only the static leases and the
+         * server address need to be looked up. */
+
+        indexed = server->pool_size <= DHCP_SERVER_POOL_INDEX_SIZE_MAX;
+        start = i = hash % server->pool_size;
+
+        for (;;) {
+                be32_t address;
+
+                if (indexed)
+                        i = bitmap_find_unset(server->bound_leases_in_pool, i);
+
+                if (wrapped && i >= start)
+                        return INADDR_ANY;
+
+                if (i >= server->pool_size) {
+                        if (wrapped)
+                                return INADDR_ANY;
+
+                        wrapped = true;
+                        i = 0;
+                        continue;
+                }
+
+                address = server->subnet | htobe32(server->pool_offset + i);
+                if (address_available(server, address))
+                        return address;
+
+                i++;
+        }
+}
+
 #define HASH_KEY SD_ID128_MAKE(0d,1d,fe,bd,f1,24,bd,b3,47,f1,dd,6e,73,21,93,30)
 
 int dhcp_server_handle_message(sd_dhcp_server *server, DHCPMessage *message, size_t length, const triple_timestamp *timestamp) {
@@ -1087,15 +1161,7 @@ int dhcp_server_handle_message(sd_dhcp_server *server, DHCPMessage *message, siz
                         client_id_hash_func(&req->client_id, &state);
                         hash = htole64(siphash24_finalize(&state));
 
-                        for (unsigned i = 0; i < server->pool_size; i++) {
-                                be32_t tmp_address;
-
-                                tmp_address = server->subnet | htobe32(server->pool_offset + (hash + i) % server->pool_size);
-                                if (address_available(server, tmp_address)) {
-                                        address = tmp_address;
-                                        break;
-                                }
-                        }
+                        address = pool_find_free_address(server, hash);
                 }
 
                 if (address == INADDR_ANY)
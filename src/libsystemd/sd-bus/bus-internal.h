@@ -103,6 +103,11 @@ struct node_vtable {
         const sd_bus_vtable *vtable;
         sd_bus_object_find_t find;
 
+        /* The introspection data of the vtable's members, generated on first use. It only depends on the
+         * vtable and whether the bus is trusted, hence is shared by all objects the vtable is found on. */
+        char *introspection;
+        bool introspection_trusted;
+
         LIST_FIELDS(struct node_vtable, vtables);
 };
 
@@ -228,6 +233,10 @@ struct sd_bus {
         size_t wqueue_size;
         size_t windex;
 
+        /* Number of messages written, and the number of write syscalls it took to write them */
+        uint64_t n_written_messages;
+        uint64_t n_write_calls;
+
         uint64_t cookie;
         uint64_t read_counter; /* A counter for each incoming msg */
 
@@ -322,6 +331,9 @@ struct sd_bus {
         LIST_HEAD(sd_bus_slot, slots);
         LIST_HEAD(sd_bus_track, tracks);
 
+        /* Names watched by any of the track objects on this connection, shared between them */
+        Hashmap *track_names;
+
         int *inotify_watches;
         size_t n_inotify_watches;
 
@@ -337,6 +349,9 @@ struct sd_bus {
 #define BUS_AUTH_TIMEOUT ((usec_t) DEFAULT_TIMEOUT_USEC)
 
 #define BUS_WQUEUE_MAX (384*1024)
+
+/* How many bytes of queued messages to coalesce into a single write at most */
+#define BUS_WRITE_BATCH_SIZE_MAX (128*1024)
 #define BUS_RQUEUE_MAX (384*1024)
 
 #define BUS_MESSAGE_SIZE_MAX (128*1024*1024)
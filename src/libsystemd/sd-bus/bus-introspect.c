@@ -201,22 +201,12 @@ static int introspect_write_arguments(struct introspect *i, const char *signatur
         }
 }
 
-int introspect_write_interface(
-                struct introspect *i,
-                const char *interface_name,
-                const sd_bus_vtable *v) {
-
+static void introspect_write_members(struct introspect *i, const sd_bus_vtable *v) {
         const sd_bus_vtable *vtable = ASSERT_PTR(v);
         const char *names = "";
-        int r;
 
         assert(i);
         assert(i->m.f);
-        assert(interface_name);
-
-        r = set_interface_name(i, interface_name);
-        if (r < 0)
-                return r;
 
         for (; v->type != _SD_BUS_VTABLE_END; v = bus_vtable_next(vtable, v)) {
 
@@ -265,7 +255,64 @@ int introspect_write_interface(
                 }
 
         }
+}
+
+int introspect_write_interface(
+                struct introspect *i,
+                const char *interface_name,
+                const sd_bus_vtable *v) {
+
+        int r;
+
+        assert(i);
+        assert(i->m.f);
+        assert(interface_name);
+        assert(v);
+
+        r = set_interface_name(i, interface_name);
+        if (r < 0)
+                return r;
+
+        introspect_write_members(i, v);
+        return 0;
+}
+
+int introspect_format_interface(const sd_bus_vtable *v, bool trusted, char **ret) {
+        _cleanup_(introspect_done) struct introspect i = {
+                .trusted = trusted,
+        };
+
+        assert(v);
+        assert(ret);
+
+        /* Formats just the members of the interface described by the vtable, i.e. what goes between the
+         * <interface> tags, so that it can be reused with introspect_write_interface_formatted(). */
+
+        if (!memstream_init(&i.m))
+                return -ENOMEM;
+
+        introspect_write_members(&i, v);
+
+        return memstream_finalize(&i.m, ret, NULL);
+}
+
+int introspect_write_interface_formatted(
+                struct introspect *i,
+                const char *interface_name,
+                const char *members) {
+
+        int r;
+
+        assert(i);
+        assert(i->m.f);
+        assert(interface_name);
+        assert(members);
+
+        r = set_interface_name(i, interface_name);
+        if (r < 0)
+                return r;
 
+        fputs(members, i->m.f);
         return 0;
 }
 
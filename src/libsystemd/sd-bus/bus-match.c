@@ -52,9 +52,22 @@ static bool BUS_MATCH_IS_COMPARE(enum bus_match_node_type t) {
         return t >= BUS_MATCH_SENDER && t <= BUS_MATCH_ARG_HAS_LAST;
 }
 
+static char BUS_MATCH_PREFIX_SEPARATOR(enum bus_match_node_type t) {
+        /* Namespace matches are hashed by their pattern too. When running them, we look up all prefixes of
+         * the tested value that end at a label boundary, see simple_pattern_check(). */
+
+        if (t == BUS_MATCH_PATH_NAMESPACE)
+                return '/';
+        if (t >= BUS_MATCH_ARG_NAMESPACE && t <= BUS_MATCH_ARG_NAMESPACE_LAST)
+                return '.';
+
+        return 0;
+}
+
 static bool BUS_MATCH_CAN_HASH(enum bus_match_node_type t) {
-        return (t >= BUS_MATCH_MESSAGE_TYPE && t <= BUS_MATCH_PATH) ||
+        return (t >= BUS_MATCH_MESSAGE_TYPE && t <= BUS_MATCH_PATH_NAMESPACE) ||
                 (t >= BUS_MATCH_ARG && t <= BUS_MATCH_ARG_LAST) ||
+                (t >= BUS_MATCH_ARG_NAMESPACE && t <= BUS_MATCH_ARG_NAMESPACE_LAST) ||
                 (t >= BUS_MATCH_ARG_HAS && t <= BUS_MATCH_ARG_HAS_LAST);
 }
 
@@ -95,6 +108,7 @@ static void bus_match_node_free(struct bus_match_node *node) {
         if (BUS_MATCH_IS_COMPARE(node->type)) {
                 assert(hashmap_isempty(node->compare.children));
                 hashmap_free(node->compare.children);
+                free(node->compare.prefix_buffer);
         }
 
         free(node);
@@ -200,6 +214,69 @@ static bool value_node_test(
         }
 }
 
+static int bus_match_run_prefixes(
+                sd_bus *bus,
+                struct bus_match_node *node,
+                const char *test_str,
+                char separator,
+                sd_bus_message *m) {
+
+        struct bus_match_node *found;
+        size_t l;
+        char *buf;
+        int r;
+
+        assert(node);
+        assert(test_str);
+        assert(separator != 0);
+
+        /* A namespace pattern matches if it equals the value, or is a prefix of it that is followed by the
+         * separator in the value, or that ends in the separator itself. Hence, instead of testing every
+         * pattern against the value, look up each such prefix of the value in the hash table. The number of
+         * lookups is bounded by the number of labels of the value, regardless of how many matches are
+         * installed.
+         *
+         * The prefixes are cut off in a copy of the value. This runs for every message, hence the copy is
+         * kept in a buffer of the compare node that is only ever grown. This node is never entered again
+         * while we are running the matches below it, since those only consist of later compare types. */
+
+        l = strlen(test_str);
+        if (!GREEDY_REALLOC(node->compare.prefix_buffer, l + 1))
+                return -ENOMEM;
+
+        buf = memcpy(node->compare.prefix_buffer, test_str, l + 1);
+
+        for (size_t i = 0; i < l; i++) {
+                if (buf[i] != separator)
+                        continue;
+
+                /* First without the separator, then with it, unless that's the whole value anyway */
+                for (size_t k = i; k <= i + 1 && k < l; k++) {
+                        char saved = buf[k];
+
+                        buf[k] = 0;
+                        found = hashmap_get(node->compare.children, buf);
+                        buf[k] = saved;
+
+                        if (!found)
+                                continue;
+
+                        r = bus_match_run(bus, found, m);
+                        if (r != 0)
+                                return r;
+
+                        if (bus && bus->match_callbacks_modified)
+                                return 0;
+                }
+        }
+
+        found = hashmap_get(node->compare.children, buf);
+        if (found)
+                return bus_match_run(bus, found, m);
+
+        return 0;
+}
+
 static bool value_node_same(
                 struct bus_match_node *node,
                 enum bus_match_node_type parent_type,
@@ -380,7 +457,13 @@ int bus_match_run(
 
                 /* Lookup via hash table, nice! So let's jump directly. */
 
-                if (test_str)
+                if (test_str && BUS_MATCH_PREFIX_SEPARATOR(node->type) != 0) {
+                        r = bus_match_run_prefixes(bus, node, test_str, BUS_MATCH_PREFIX_SEPARATOR(node->type), m);
+                        if (r != 0)
+                                return r;
+
+                        found = NULL;
+                } else if (test_str)
                         found = hashmap_get(node->compare.children, test_str);
                 else if (test_strv) {
                         STRV_FOREACH(i, test_strv) {
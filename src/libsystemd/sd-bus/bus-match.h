@@ -47,6 +47,10 @@ struct bus_match_node {
                 struct {
                         /* If this is set, then the child is NULL */
                         Hashmap *children;
+
+                        /* Scratch buffer for looking up prefixes of the tested value, reused across
+                         * messages, for namespace matches only */
+                        char *prefix_buffer;
                 } compare;
         };
 };
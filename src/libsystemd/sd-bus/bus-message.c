@@ -15,6 +15,7 @@
 #include "iovec-util.h"
 #include "memfd-util.h"
 #include "memory-util.h"
+#include "mempool.h"
 #include "string-util.h"
 #include "strv.h"
 #include "time-util.h"
@@ -40,6 +41,74 @@ static void *adjust_pointer(const void *p, void *old_base, size_t sz, void *new_
         return (uint8_t*) new_base + ((uint8_t*) p - (uint8_t*) old_base);
 }
 
+/* Like hashmaps, messages and additional body parts are taken from memory pools if that's enabled. The
+ * pools are global rather than per connection, since a message may outlive the connection it was created
+ * for. Messages that need more room than a header (i.e. received messages carrying a security label) are
+ * always allocated from the heap. */
+static struct mempool message_pool = {
+        .mutex = PTHREAD_MUTEX_INITIALIZER,
+        .tile_size = CONST_ALIGN_TO(sizeof(sd_bus_message), sizeof(void*)) + sizeof(struct bus_header),
+        .at_least = 64,
+};
+
+DEFINE_MEMPOOL(part_pool, struct bus_body_part, 64);
+
+static bool use_pool(void) {
+        return mempool_enabled && mempool_enabled();  /* mempool_enabled is a weak symbol */
+}
+
+static sd_bus_message* message_alloc0(size_t size) {
+        sd_bus_message *m;
+
+        if (size > message_pool.tile_size || !use_pool())
+                return malloc0(size);
+
+        m = mempool_alloc0_tile(&message_pool);
+        if (m)
+                m->from_pool = true;
+
+        return m;
+}
+
+static sd_bus_message* message_dealloc(sd_bus_message *m) {
+        if (!m)
+                return NULL;
+
+        if (!m->from_pool)
+                return mfree(m);
+
+        return mempool_free_tile(&message_pool, m);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(sd_bus_message*, message_dealloc);
+
+static struct bus_body_part* part_alloc0(void) {
+        struct bus_body_part *part;
+
+        if (!use_pool())
+                return new0(struct bus_body_part, 1);
+
+        part = mempool_alloc0_tile(&part_pool);
+        if (part)
+                part->from_pool = true;
+
+        return part;
+}
+
+static void part_dealloc(struct bus_body_part *part) {
+        assert(part);
+
+        if (!part->from_pool)
+                return (void) free(part);
+
+        mempool_free_tile(&part_pool, part);
+}
+
+void bus_message_trim_pools(void) {
+        mempool_trim(&message_pool);
+        mempool_trim(&part_pool);
+}
+
 static void message_free_part(sd_bus_message *m, struct bus_body_part *part) {
         assert(m);
         assert(part);
@@ -64,7 +133,7 @@ static void message_free_part(sd_bus_message *m, struct bus_body_part *part) {
         }
 
         if (part != &m->body)
-                free(part);
+                part_dealloc(part);
 }
 
 static void message_reset_parts(sd_bus_message *m) {
@@ -143,7 +212,7 @@ static sd_bus_message* message_free(sd_bus_message *m) {
         message_free_last_container(m);
 
         bus_creds_done(&m->creds);
-        return mfree(m);
+        return message_dealloc(m);
 }
 
 static void *message_extend_fields(sd_bus_message *m, size_t sz, bool add_offset) {
@@ -338,7 +407,7 @@ static int message_from_header(
                 const char *label,
                 sd_bus_message **ret) {
 
-        _cleanup_free_ sd_bus_message *m = NULL;
+        _cleanup_(message_deallocp) sd_bus_message *m = NULL;
         struct bus_header *h;
         size_t a, label_sz = 0; /* avoid false maybe-uninitialized warning */
 
@@ -369,7 +438,7 @@ static int message_from_header(
                 a += label_sz + 1;
         }
 
-        m = malloc0(a);
+        m = message_alloc0(a);
         if (!m)
                 return -ENOMEM;
 
@@ -465,7 +534,7 @@ _public_ int sd_bus_message_new(
         /* Creation of messages with _SD_BUS_MESSAGE_TYPE_INVALID is allowed. */
         assert_return(type < _SD_BUS_MESSAGE_TYPE_MAX, -EINVAL);
 
-        sd_bus_message *t = malloc0(ALIGN(sizeof(sd_bus_message)) + sizeof(struct bus_header));
+        sd_bus_message *t = message_alloc0(ALIGN(sizeof(sd_bus_message)) + sizeof(struct bus_header));
         if (!t)
                 return -ENOMEM;
 
@@ -1101,7 +1170,7 @@ static struct bus_body_part *message_append_part(sd_bus_message *m) {
         } else {
                 assert(m->body_end);
 
-                part = new0(struct bus_body_part, 1);
+                part = part_alloc0();
                 if (!part) {
                         m->poisoned = true;
                         return NULL;
@@ -40,6 +40,7 @@ struct bus_body_part {
         bool munmap_this:1;
         bool sealed:1;
         bool is_zero:1;
+        bool from_pool:1;
 };
 
 struct sd_bus_message {
@@ -80,6 +81,7 @@ struct sd_bus_message {
         bool free_fds:1;
         bool poisoned:1;
         bool sensitive:1;
+        bool from_pool:1;
 
         /* The first bytes of the message */
         struct bus_header *header;
@@ -178,6 +180,8 @@ int bus_message_get_arg_strv(sd_bus_message *m, unsigned i, char ***strv);
 int bus_body_part_map(struct bus_body_part *part);
 void bus_body_part_unmap(struct bus_body_part *part);
 
+void bus_message_trim_pools(void);
+
 int bus_message_new_synthetic_error(sd_bus *bus, uint64_t serial, const sd_bus_error *e, sd_bus_message **m);
 
 int bus_message_remarshal(sd_bus *bus, sd_bus_message **m);
@@ -421,6 +421,40 @@ static int method_callbacks_run(
         return 1;
 }
 
+static int property_append_automatic(sd_bus_message *reply, const sd_bus_vtable *v, void *userdata) {
+        const void *p;
+
+        assert(reply);
+        assert(v);
+
+        /* Automatic handling if no callback is defined. */
+
+        if (streq(v->x.property.signature, "as"))
+                return sd_bus_message_append_strv(reply, *(char***) userdata);
+
+        assert(signature_is_single(v->x.property.signature, false));
+        assert(bus_type_is_basic(v->x.property.signature[0]));
+
+        switch (v->x.property.signature[0]) {
+
+        case SD_BUS_TYPE_STRING:
+        case SD_BUS_TYPE_SIGNATURE:
+                p = strempty(*(char**) userdata);
+                break;
+
+        case SD_BUS_TYPE_OBJECT_PATH:
+                p = *(char**) userdata;
+                assert(p);
+                break;
+
+        default:
+                p = userdata;
+                break;
+        }
+
+        return sd_bus_message_append_basic(reply, v->x.property.signature[0], p);
+}
+
 static int invoke_property_get(
                 sd_bus *bus,
                 sd_bus_slot *slot,
@@ -432,7 +466,6 @@ static int invoke_property_get(
                 void *userdata,
                 sd_bus_error *error) {
 
-        const void *p;
         int r;
 
         assert(bus);
@@ -458,32 +491,7 @@ static int invoke_property_get(
                 return r;
         }
 
-        /* Automatic handling if no callback is defined. */
-
-        if (streq(v->x.property.signature, "as"))
-                return sd_bus_message_append_strv(reply, *(char***) userdata);
-
-        assert(signature_is_single(v->x.property.signature, false));
-        assert(bus_type_is_basic(v->x.property.signature[0]));
-
-        switch (v->x.property.signature[0]) {
-
-        case SD_BUS_TYPE_STRING:
-        case SD_BUS_TYPE_SIGNATURE:
-                p = strempty(*(char**) userdata);
-                break;
-
-        case SD_BUS_TYPE_OBJECT_PATH:
-                p = *(char**) userdata;
-                assert(p);
-                break;
-
-        default:
-                p = userdata;
-                break;
-        }
-
-        return sd_bus_message_append_basic(reply, v->x.property.signature[0], p);
+        return property_append_automatic(reply, v, userdata);
 }
 
 static int invoke_property_set(
@@ -746,6 +754,89 @@ static int vtable_append_one_property(
         return 0;
 }
 
+int bus_vtable_append_property(
+                sd_bus *bus,
+                sd_bus_message *reply,
+                const char *path,
+                const char *interface,
+                const sd_bus_vtable *vtable,
+                const char *property,
+                void *userdata,
+                sd_bus_error *error) {
+
+        int r;
+
+        assert(bus);
+        assert(reply);
+        assert(path);
+        assert(interface);
+        assert(vtable);
+        assert(property);
+
+        /* Looks for the specified property in the vtable, and if it's there appends it to the reply as a
+         * "{sv}" dictionary entry, just like GetAll() would. This is useful for services that want to return
+         * properties of many objects at once, without going through the object tree for each of them.
+         * Returns 0 if the vtable doesn't contain the property. */
+
+        if (FLAGS_SET(vtable[0].flags, SD_BUS_VTABLE_HIDDEN))
+                return 0;
+
+        for (const sd_bus_vtable *v = bus_vtable_next(vtable, vtable); v->type != _SD_BUS_VTABLE_END; v = bus_vtable_next(vtable, v)) {
+                if (!IN_SET(v->type, _SD_BUS_VTABLE_PROPERTY, _SD_BUS_VTABLE_WRITABLE_PROPERTY))
+                        continue;
+
+                if (v->flags & SD_BUS_VTABLE_HIDDEN)
+                        continue;
+
+                if (!streq(v->x.property.member, property))
+                        continue;
+
+                if (FLAGS_SET(vtable[0].flags, SD_BUS_VTABLE_SENSITIVE)) {
+                        r = sd_bus_message_sensitive(reply);
+                        if (r < 0)
+                                return r;
+                }
+
+                r = sd_bus_message_open_container(reply, 'e', "sv");
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_append(reply, "s", property);
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_open_container(reply, 'v', v->x.property.signature);
+                if (r < 0)
+                        return r;
+
+                userdata = vtable_property_convert_userdata(v, userdata);
+
+                if (v->x.property.get) {
+                        r = v->x.property.get(bus, path, interface, property, reply, userdata, error);
+                        if (r < 0)
+                                return r;
+                        if (sd_bus_error_is_set(error))
+                                return -sd_bus_error_get_errno(error);
+                } else {
+                        r = property_append_automatic(reply, v, userdata);
+                        if (r < 0)
+                                return r;
+                }
+
+                r = sd_bus_message_close_container(reply);
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_close_container(reply);
+                if (r < 0)
+                        return r;
+
+                return 1;
+        }
+
+        return 0;
+}
+
 static int vtable_append_all_properties(
                 sd_bus *bus,
                 sd_bus_message *reply,
@@ -972,7 +1063,19 @@ int introspect_path(
                 if (c->vtable[0].flags & SD_BUS_VTABLE_HIDDEN)
                         continue;
 
-                r = introspect_write_interface(&intro, c->interface, c->vtable);
+                /* Clients like "busctl tree" introspect every single object, and typically many objects
+                 * share the same vtables, hence don't generate the same XML over and over again. */
+                if (!c->introspection || c->introspection_trusted != bus->trusted) {
+                        c->introspection = mfree(c->introspection);
+
+                        r = introspect_format_interface(c->vtable, bus->trusted, &c->introspection);
+                        if (r < 0)
+                                return r;
+
+                        c->introspection_trusted = bus->trusted;
+                }
+
+                r = introspect_write_interface_formatted(&intro, c->interface, c->introspection);
                 if (r < 0)
                         return r;
         }
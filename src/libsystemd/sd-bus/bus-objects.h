@@ -7,6 +7,15 @@
 const sd_bus_vtable* bus_vtable_next(const sd_bus_vtable *vtable, const sd_bus_vtable *v);
 bool bus_vtable_has_names(const sd_bus_vtable *vtable);
 int bus_process_object(sd_bus *bus, sd_bus_message *m);
+int bus_vtable_append_property(
+                sd_bus *bus,
+                sd_bus_message *reply,
+                const char *path,
+                const char *interface,
+                const sd_bus_vtable *vtable,
+                const char *property,
+                void *userdata,
+                sd_bus_error *error);
 void bus_node_gc(sd_bus *b, struct node *n);
 
 int introspect_path(
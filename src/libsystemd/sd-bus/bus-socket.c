@@ -1214,66 +1214,98 @@ int bus_socket_take_fd(sd_bus *b) {
         return bus_socket_start_auth(b);
 }
 
-int bus_socket_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
+int bus_socket_write_messages(sd_bus *bus, sd_bus_message **messages, size_t n_messages, size_t *idx) {
+        size_t n = 0, n_iovec = 0, size = 0;
         struct iovec *iov;
         ssize_t k;
-        size_t n;
         unsigned j;
         int r;
 
         assert(bus);
-        assert(m);
+        assert(messages);
+        assert(n_messages > 0);
         assert(idx);
         assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
-        if (*idx >= BUS_MESSAGE_SIZE(m))
+        /* Writes as many of the specified messages as possible in a single syscall. *idx is the number of
+         * bytes already written of the first message on input, and is increased by the number of bytes
+         * written, which might hence extend into the following messages, on output. */
+
+        if (*idx >= BUS_MESSAGE_SIZE(messages[0]))
                 return 0;
 
-        r = bus_message_setup_iovec(m);
-        if (r < 0)
-                return r;
+        /* Figure out how many messages to write in one go. File descriptors are always attached to the
+         * beginning of a write, hence a message carrying some always has to start a new batch. */
+        FOREACH_ARRAY(i, messages, n_messages) {
+                sd_bus_message *m = *i;
+
+                if (n > 0 && m->n_fds > 0)
+                        break;
+
+                r = bus_message_setup_iovec(m);
+                if (r < 0)
+                        return r;
 
-        n = m->n_iovec * sizeof(struct iovec);
-        iov = newa(struct iovec, n);
-        memcpy_safe(iov, m->iovec, n);
+                if (n > 0 && (n_iovec + m->n_iovec > IOV_MAX || size + BUS_MESSAGE_SIZE(m) > BUS_WRITE_BATCH_SIZE_MAX))
+                        break;
+
+                n_iovec += m->n_iovec;
+                size += BUS_MESSAGE_SIZE(m);
+                n++;
+        }
+
+        iov = newa(struct iovec, n_iovec);
+        n_iovec = 0;
+        FOREACH_ARRAY(i, messages, n) {
+                memcpy_safe(iov + n_iovec, (*i)->iovec, (*i)->n_iovec * sizeof(struct iovec));
+                n_iovec += (*i)->n_iovec;
+        }
 
         j = 0;
         iovec_advance(iov, &j, *idx);
 
         if (bus->prefer_writev)
-                k = writev(bus->output_fd, iov, m->n_iovec);
+                k = writev(bus->output_fd, iov, n_iovec);
         else {
                 struct msghdr mh = {
                         .msg_iov = iov,
-                        .msg_iovlen = m->n_iovec,
+                        .msg_iovlen = n_iovec,
                 };
 
-                if (m->n_fds > 0 && *idx == 0) {
+                if (messages[0]->n_fds > 0 && *idx == 0) {
                         struct cmsghdr *control;
 
-                        mh.msg_controllen = CMSG_SPACE(sizeof(int) * m->n_fds);
+                        mh.msg_controllen = CMSG_SPACE(sizeof(int) * messages[0]->n_fds);
                         mh.msg_control = alloca0(mh.msg_controllen);
                         control = CMSG_FIRSTHDR(&mh);
-                        control->cmsg_len = CMSG_LEN(sizeof(int) * m->n_fds);
+                        control->cmsg_len = CMSG_LEN(sizeof(int) * messages[0]->n_fds);
                         control->cmsg_level = SOL_SOCKET;
                         control->cmsg_type = SCM_RIGHTS;
-                        memcpy(CMSG_DATA(control), m->fds, sizeof(int) * m->n_fds);
+                        memcpy(CMSG_DATA(control), messages[0]->fds, sizeof(int) * messages[0]->n_fds);
                 }
 
                 k = sendmsg(bus->output_fd, &mh, MSG_DONTWAIT|MSG_NOSIGNAL);
                 if (k < 0 && errno == ENOTSOCK) {
                         bus->prefer_writev = true;
-                        k = writev(bus->output_fd, iov, m->n_iovec);
+                        k = writev(bus->output_fd, iov, n_iovec);
                 }
         }
 
         if (k < 0)
                 return ERRNO_IS_TRANSIENT(errno) ? 0 : -errno;
 
+        bus->n_write_calls++;
+
         *idx += (size_t) k;
         return 1;
 }
 
+int bus_socket_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
+        assert(m);
+
+        return bus_socket_write_messages(bus, &m, 1, idx);
+}
+
 static int bus_socket_read_message_need(sd_bus *bus, size_t *need) {
         uint32_t a, b;
         uint8_t e;
@@ -5,12 +5,27 @@
 #include "alloc-util.h"
 #include "bus-internal.h"
 #include "bus-track.h"
+#include "list.h"
 #include "string-util.h"
 
-struct track_item {
-        unsigned n_ref;
+typedef struct track_item track_item;
+
+/* A name watched by one or more track objects of the same connection. All of them share a single
+ * NameOwnerChanged match, so that the number of matches (and of round trips to verify that the name exists)
+ * does not grow with the number of track objects a name is added to. */
+struct track_name {
+        sd_bus *bus;
         char *name;
         sd_bus_slot *slot;
+        LIST_HEAD(track_item, items);
+};
+
+struct track_item {
+        unsigned n_ref;
+        const char *name; /* Owned by the track_name object */
+        sd_bus_track *track;
+        struct track_name *watch;
+        LIST_FIELDS(track_item, items);
 };
 
 struct sd_bus_track {
@@ -39,12 +54,34 @@ struct sd_bus_track {
                  "member='NameOwnerChanged',"           \
                  "arg0='", name, "'")
 
+static struct track_name* track_name_free(struct track_name *w) {
+        if (!w)
+                return NULL;
+
+        assert(!w->items);
+
+        if (w->bus)
+                assert_se(hashmap_remove(w->bus->track_names, w->name) == w);
+
+        sd_bus_slot_unref(w->slot);
+        free(w->name);
+        return mfree(w);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(struct track_name*, track_name_free);
+
 static struct track_item* track_item_free(struct track_item *i) {
         if (!i)
                 return NULL;
 
-        sd_bus_slot_unref(i->slot);
-        free(i->name);
+        if (i->watch) {
+                LIST_REMOVE(items, i->watch->items, i);
+
+                /* Last track object interested in this name? Then drop the match too. */
+                if (!i->watch->items)
+                        track_name_free(i->watch);
+        }
+
         return mfree(i);
 }
 
@@ -164,24 +201,75 @@ static sd_bus_track *track_free(sd_bus_track *track) {
 DEFINE_PUBLIC_TRIVIAL_REF_UNREF_FUNC(sd_bus_track, sd_bus_track, track_free);
 
 static int on_name_owner_changed(sd_bus_message *message, void *userdata, sd_bus_error *error) {
-        sd_bus_track *track = ASSERT_PTR(userdata);
-        const char *name;
+        struct track_name *w = ASSERT_PTR(userdata);
         int r;
 
         assert(message);
 
-        r = sd_bus_message_read(message, "sss", &name, NULL, NULL);
+        r = sd_bus_message_read(message, "sss", NULL, NULL, NULL);
         if (r < 0)
                 return 0;
 
-        bus_track_remove_name_fully(track, name);
+        /* Drop the name from every track object watching it. Removing the last one frees the watch
+         * object itself, hence check for that before removing. */
+        for (;;) {
+                struct track_item *i = ASSERT_PTR(w->items);
+                bool last = !i->items_next;
+
+                bus_track_remove_name_fully(i->track, i->name);
+                if (last)
+                        break;
+        }
+
         return 0;
 }
 
+static int track_name_acquire(sd_bus *bus, const char *name, struct track_name **ret) {
+        _cleanup_(track_name_freep) struct track_name *w = NULL;
+        const char *match;
+        int r;
+
+        assert(bus);
+        assert(name);
+        assert(ret);
+
+        /* Returns 0 if the name is already watched on this connection, 1 if a new match was installed */
+
+        w = hashmap_get(bus->track_names, name);
+        if (w) {
+                *ret = TAKE_PTR(w);
+                return 0;
+        }
+
+        w = new(struct track_name, 1);
+        if (!w)
+                return -ENOMEM;
+
+        *w = (struct track_name) {
+                .name = strdup(name),
+        };
+        if (!w->name)
+                return -ENOMEM;
+
+        r = hashmap_ensure_put(&bus->track_names, &string_hash_ops, w->name, w);
+        if (r < 0)
+                return r;
+
+        w->bus = bus;
+
+        match = MATCH_FOR_NAME(name);
+        r = sd_bus_add_match_async(bus, &w->slot, match, on_name_owner_changed, NULL, w);
+        if (r < 0)
+                return r;
+
+        *ret = TAKE_PTR(w);
+        return 1;
+}
+
 _public_ int sd_bus_track_add_name(sd_bus_track *track, const char *name) {
         _cleanup_(track_item_unrefp) struct track_item *n = NULL;
+        struct track_name *w;
         struct track_item *i;
-        const char *match;
         int r;
 
         assert_return(track, -EINVAL);
@@ -216,22 +304,22 @@ _public_ int sd_bus_track_add_name(sd_bus_track *track, const char *name) {
 
         *n = (struct track_item) {
                 .n_ref = 1,
+                .track = track,
         };
 
-        n->name = strdup(name);
-        if (!n->name)
-                return -ENOMEM;
-
-        /* First, subscribe to this name */
-        match = MATCH_FOR_NAME(name);
-
         bus_track_remove_from_queue(track); /* don't dispatch this while we work in it */
 
-        r = sd_bus_add_match_async(track->bus, &n->slot, match, on_name_owner_changed, NULL, track);
+        /* First, subscribe to this name, unless some other track object on this connection already did */
+        r = track_name_acquire(track->bus, name, &w);
         if (r < 0) {
                 bus_track_add_to_queue(track);
                 return r;
         }
+        bool fresh = r > 0;
+
+        n->watch = w;
+        n->name = w->name;
+        LIST_PREPEND(items, w->items, n);
 
         r = hashmap_put(track->names, n->name, n);
         if (r < 0) {
@@ -239,14 +327,18 @@ _public_ int sd_bus_track_add_name(sd_bus_track *track, const char *name) {
                 return r;
         }
 
-        /* Second, check if it is currently existing, or maybe doesn't, or maybe disappeared already. */
-        track->n_adding++; /* again, make sure this isn't dispatch while we are working in it */
-        r = sd_bus_get_name_creds(track->bus, name, 0, NULL);
-        track->n_adding--;
-        if (r < 0) {
-                hashmap_remove(track->names, name);
-                bus_track_add_to_queue(track);
-                return r;
+        /* Second, check if it is currently existing, or maybe doesn't, or maybe disappeared already. If the
+         * name was watched already, this was checked when the match was installed, and if it disappeared
+         * since then the NameOwnerChanged signal is already on its way and will drop this entry too. */
+        if (fresh) {
+                track->n_adding++; /* again, make sure this isn't dispatch while we are working in it */
+                r = sd_bus_get_name_creds(track->bus, name, 0, NULL);
+                track->n_adding--;
+                if (r < 0) {
+                        hashmap_remove(track->names, name);
+                        bus_track_add_to_queue(track);
+                        return r;
+                }
         }
 
         TAKE_PTR(n);
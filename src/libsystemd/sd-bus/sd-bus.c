@@ -180,6 +180,7 @@ static sd_bus* bus_free(sd_bus *b) {
         assert(b);
         assert(!b->track_queue);
         assert(!b->tracks);
+        assert(hashmap_isempty(b->track_names));
 
         b->state = BUS_CLOSED;
 
@@ -231,6 +232,7 @@ static sd_bus* bus_free(sd_bus *b) {
 
         assert(hashmap_isempty(b->nodes));
         hashmap_free(b->nodes);
+        hashmap_free(b->track_names);
 
         bus_flush_memfd(b);
 
@@ -2042,6 +2044,28 @@ int bus_seal_synthetic_message(sd_bus *b, sd_bus_message *m) {
         return sd_bus_message_seal(m, UINT32_MAX, 0);
 }
 
+static void bus_message_sent(sd_bus *bus, sd_bus_message *m) {
+        assert(bus);
+        assert(m);
+
+        bus->n_written_messages++;
+
+        log_debug("Sent message type=%s sender=%s destination=%s path=%s interface=%s member=%s"
+                  " cookie=%" PRIu64 " reply_cookie=%" PRIu64
+                  " signature=%s error-name=%s error-message=%s",
+                  bus_message_type_to_string(m->header->type),
+                  strna(sd_bus_message_get_sender(m)),
+                  strna(sd_bus_message_get_destination(m)),
+                  strna(sd_bus_message_get_path(m)),
+                  strna(sd_bus_message_get_interface(m)),
+                  strna(sd_bus_message_get_member(m)),
+                  BUS_MESSAGE_COOKIE(m),
+                  m->reply_cookie,
+                  strna(m->root_container.signature),
+                  strna(m->error.name),
+                  strna(m->error.message));
+}
+
 static int bus_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
         int r;
 
@@ -2053,20 +2077,7 @@ static int bus_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
                 return r;
 
         if (*idx >= BUS_MESSAGE_SIZE(m))
-                log_debug("Sent message type=%s sender=%s destination=%s path=%s interface=%s member=%s"
-                          " cookie=%" PRIu64 " reply_cookie=%" PRIu64
-                          " signature=%s error-name=%s error-message=%s",
-                          bus_message_type_to_string(m->header->type),
-                          strna(sd_bus_message_get_sender(m)),
-                          strna(sd_bus_message_get_destination(m)),
-                          strna(sd_bus_message_get_path(m)),
-                          strna(sd_bus_message_get_interface(m)),
-                          strna(sd_bus_message_get_member(m)),
-                          BUS_MESSAGE_COOKIE(m),
-                          m->reply_cookie,
-                          strna(m->root_container.signature),
-                          strna(m->error.name),
-                          strna(m->error.message));
+                bus_message_sent(bus, m);
 
         return r;
 }
@@ -2078,28 +2089,34 @@ static int dispatch_wqueue(sd_bus *bus) {
         assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
         while (bus->wqueue_size > 0) {
+                size_t n = 0;
 
-                r = bus_write_message(bus, bus->wqueue[0], &bus->windex);
+                /* Write as many of the queued messages as we can in one go. windex may hence afterwards
+                 * point beyond the first message, into one of the following ones. */
+                r = bus_socket_write_messages(bus, bus->wqueue, bus->wqueue_size, &bus->windex);
                 if (r < 0)
                         return r;
-                else if (r == 0)
+                if (r == 0)
                         /* Didn't do anything this time */
                         return ret;
-                else if (bus->windex >= BUS_MESSAGE_SIZE(bus->wqueue[0])) {
-                        /* Fully written. Let's drop the entry from
-                         * the queue.
+
+                while (n < bus->wqueue_size && bus->windex >= BUS_MESSAGE_SIZE(bus->wqueue[n])) {
+                        bus->windex -= BUS_MESSAGE_SIZE(bus->wqueue[n]);
+                        bus_message_sent(bus, bus->wqueue[n]);
+                        bus_message_unref_queued(bus->wqueue[n], bus);
+                        n++;
+                }
+
+                if (n > 0) {
+                        /* Fully written. Let's drop the entries from the queue.
                          *
-                         * This isn't particularly optimized, but
-                         * well, this is supposed to be our worst-case
-                         * buffer only, and the socket buffer is
-                         * supposed to be our primary buffer, and if
-                         * it got full, then all bets are off
-                         * anyway. */
-
-                        bus->wqueue_size--;
-                        bus_message_unref_queued(bus->wqueue[0], bus);
-                        memmove(bus->wqueue, bus->wqueue + 1, sizeof(sd_bus_message*) * bus->wqueue_size);
-                        bus->windex = 0;
+                         * This isn't particularly optimized, but well, this is supposed to be our worst-case
+                         * buffer only, and the socket buffer is supposed to be our primary buffer, and if it
+                         * got full, then all bets are off anyway. At least we only move the remaining
+                         * entries once per write now. */
+
+                        bus->wqueue_size -= n;
+                        memmove(bus->wqueue, bus->wqueue + n, sizeof(sd_bus_message*) * bus->wqueue_size);
 
                         ret = 1;
                 }
@@ -4395,6 +4412,18 @@ _public_ int sd_bus_get_n_queued_write(sd_bus *bus, uint64_t *ret) {
         return 0;
 }
 
+_public_ int sd_bus_get_n_written(sd_bus *bus, uint64_t *ret_messages, uint64_t *ret_writes) {
+        assert_return(bus, -EINVAL);
+        assert_return(bus = bus_resolve(bus), -ENOPKG);
+        assert_return(!bus_origin_changed(bus), -ECHILD);
+
+        if (ret_messages)
+                *ret_messages = bus->n_written_messages;
+        if (ret_writes)
+                *ret_writes = bus->n_write_calls;
+        return 0;
+}
+
 _public_ int sd_bus_set_method_call_timeout(sd_bus *bus, uint64_t usec) {
         assert_return(bus, -EINVAL);
         assert_return(bus = bus_resolve(bus), -ENOPKG);
@@ -4,13 +4,17 @@
 #include <unistd.h>
 
 #include "sd-bus.h"
+#include "sd-json.h"
 
 #include "alloc-util.h"
 #include "bus-internal.h"
 #include "bus-kernel.h"
+#include "bus-message.h"
 #include "constants.h"
 #include "fd-util.h"
+#include "json-util.h"
 #include "missing_resource.h"
+#include "sort-util.h"
 #include "string-util.h"
 #include "tests.h"
 #include "time-util.h"
@@ -18,6 +22,8 @@
 #define MAX_SIZE (2*1024*1024)
 
 static usec_t arg_loop_usec = 100 * USEC_PER_MSEC;
+static bool arg_json = false;
+static sd_json_variant *arg_results = NULL;
 
 typedef enum Type {
         TYPE_LEGACY,
@@ -206,10 +212,392 @@ static void client_chart(Type type, const char *address, const char *server_name
         sd_bus_unref(b);
 }
 
+static void report(sd_json_variant *v) {
+        const char *k;
+        sd_json_variant *e;
+        bool first = true;
+
+        assert(v);
+
+        /* In JSON mode results are collected and written out as one array at the end, so that they can be
+         * compared between releases. */
+        if (arg_json) {
+                assert_se(sd_json_variant_append_array(&arg_results, v) >= 0);
+                return;
+        }
+
+        JSON_VARIANT_OBJECT_FOREACH(k, e, v) {
+                printf("%s%s=", first ? "" : " ", k);
+                first = false;
+
+                if (sd_json_variant_is_string(e))
+                        fputs(sd_json_variant_string(e), stdout);
+                else
+                        assert_se(sd_json_variant_dump(e, 0, stdout, NULL) >= 0);
+        }
+        putchar('\n');
+}
+
+static void bus_pair_new(sd_bus **ret_server, sd_bus **ret_client) {
+        _cleanup_(sd_bus_unrefp) sd_bus *a = NULL, *b = NULL;
+        int pair[2];
+        sd_id128_t id;
+
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, pair) >= 0);
+        assert_se(sd_id128_randomize(&id) >= 0);
+
+        assert_se(sd_bus_new(&a) >= 0);
+        assert_se(sd_bus_set_fd(a, pair[0], pair[0]) >= 0);
+        assert_se(sd_bus_set_server(a, true, id) >= 0);
+        assert_se(sd_bus_start(a) >= 0);
+
+        assert_se(sd_bus_new(&b) >= 0);
+        assert_se(sd_bus_set_fd(b, pair[1], pair[1]) >= 0);
+        assert_se(sd_bus_start(b) >= 0);
+
+        while (sd_bus_is_ready(a) <= 0 || sd_bus_is_ready(b) <= 0) {
+                assert_se(sd_bus_process(a, NULL) >= 0);
+                assert_se(sd_bus_process(b, NULL) >= 0);
+        }
+
+        *ret_server = TAKE_PTR(a);
+        *ret_client = TAKE_PTR(b);
+}
+
+static int usec_compare(const usec_t *a, const usec_t *b) {
+        return CMP(*a, *b);
+}
+
+static void benchmark_latency(void) {
+        _cleanup_(sd_bus_unrefp) sd_bus *b = NULL;
+        _cleanup_free_ usec_t *samples = NULL;
+        size_t n_samples = 0;
+        int pair[2];
+        usec_t t;
+        pid_t pid;
+
+        /* Round trip times of empty method calls on a direct connection to a forked off server */
+
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, pair) >= 0);
+
+        pid = fork();
+        assert_se(pid >= 0);
+
+        if (pid == 0) {
+                _cleanup_(sd_bus_unrefp) sd_bus *a = NULL;
+                size_t result;
+
+                safe_close(pair[1]);
+
+                assert_se(sd_bus_new(&a) >= 0);
+                assert_se(sd_bus_set_fd(a, pair[0], pair[0]) >= 0);
+                assert_se(sd_bus_set_server(a, true, SD_ID128_NULL) >= 0);
+                assert_se(sd_bus_start(a) >= 0);
+
+                server(a, &result);
+                _exit(EXIT_SUCCESS);
+        }
+
+        safe_close(pair[0]);
+
+        assert_se(sd_bus_new(&b) >= 0);
+        assert_se(sd_bus_set_fd(b, pair[1], pair[1]) >= 0);
+        assert_se(sd_bus_start(b) >= 0);
+
+        /* Warm up, and make sure authentication is complete */
+        assert_se(sd_bus_call_method(b, NULL, "/", "benchmark.server", "Ping", NULL, NULL, NULL) >= 0);
+
+        t = now(CLOCK_MONOTONIC);
+        for (;;) {
+                usec_t n, m;
+
+                n = now(CLOCK_MONOTONIC);
+                assert_se(sd_bus_call_method(b, NULL, "/", "benchmark.server", "Ping", NULL, NULL, NULL) >= 0);
+                m = now(CLOCK_MONOTONIC);
+
+                assert_se(GREEDY_REALLOC(samples, n_samples + 1));
+                samples[n_samples++] = m - n;
+
+                if (m >= t + arg_loop_usec)
+                        break;
+        }
+
+        typesafe_qsort(samples, n_samples, usec_compare);
+
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        assert_se(sd_json_buildo(
+                        &v,
+                        SD_JSON_BUILD_PAIR_STRING("benchmark", "latency"),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("calls", n_samples),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("p50Usec", samples[n_samples * 50 / 100]),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("p90Usec", samples[n_samples * 90 / 100]),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("p99Usec", samples[n_samples * 99 / 100]),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("maxUsec", samples[n_samples - 1])) >= 0);
+        report(v);
+
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *x = NULL;
+        assert_se(sd_bus_message_new_method_call(b, &x, NULL, "/", "benchmark.server", "Exit") >= 0);
+        assert_se(sd_bus_message_append(x, "t", UINT64_C(0)) >= 0);
+        assert_se(sd_bus_send(b, x, NULL) >= 0);
+        assert_se(sd_bus_flush(b) >= 0);
+
+        assert_se(waitpid(pid, NULL, 0) == pid);
+}
+
+static int on_signal(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        uint64_t *counter = ASSERT_PTR(userdata);
+
+        (*counter)++;
+        return 0;
+}
+
+static void benchmark_fanout_one(unsigned n_matches, bool all_match) {
+        _cleanup_(sd_bus_unrefp) sd_bus *a = NULL, *b = NULL;
+        uint64_t n_signals = 0, n_callbacks = 0;
+        usec_t t, elapsed;
+
+        /* Signal dispatch throughput with a number of match rules installed. Either all of them match each
+         * signal (i.e. every signal is fanned out to all callbacks), or exactly one matches. */
+
+        bus_pair_new(&a, &b);
+
+        for (unsigned i = 0; i < n_matches; i++) {
+                _cleanup_free_ char *path = NULL;
+
+                assert_se(asprintf(&path, "/bench/%u", all_match ? 0 : i) >= 0);
+                assert_se(sd_bus_match_signal(b, NULL, NULL, path, "benchmark.signal", "Ping", on_signal, &n_callbacks) >= 0);
+        }
+
+        t = now(CLOCK_MONOTONIC);
+        do {
+                for (unsigned i = 0; i < 64; i++) {
+                        _cleanup_free_ char *path = NULL;
+
+                        assert_se(asprintf(&path, "/bench/%" PRIu64, all_match ? 0 : n_signals % n_matches) >= 0);
+                        assert_se(sd_bus_emit_signal(a, path, "benchmark.signal", "Ping", NULL) >= 0);
+                        n_signals++;
+                }
+                assert_se(sd_bus_flush(a) >= 0);
+
+                while (n_callbacks < n_signals * (all_match ? n_matches : 1)) {
+                        int r;
+
+                        r = sd_bus_process(b, NULL);
+                        assert_se(r >= 0);
+                        if (r == 0)
+                                assert_se(sd_bus_wait(b, USEC_INFINITY) >= 0);
+                }
+
+                elapsed = now(CLOCK_MONOTONIC) - t;
+        } while (elapsed < arg_loop_usec);
+
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        assert_se(sd_json_buildo(
+                        &v,
+                        SD_JSON_BUILD_PAIR_STRING("benchmark", "fanout"),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("matches", n_matches),
+                        SD_JSON_BUILD_PAIR_BOOLEAN("allMatch", all_match),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("signalsPerSec", n_signals * USEC_PER_SEC / elapsed),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("callbacksPerSec", n_callbacks * USEC_PER_SEC / elapsed)) >= 0);
+        report(v);
+}
+
+static void benchmark_fanout(void) {
+        static const unsigned n_matches[] = { 1, 10, 100, 1000 };
+
+        FOREACH_ELEMENT(n, n_matches) {
+                benchmark_fanout_one(*n, /* all_match= */ false);
+                benchmark_fanout_one(*n, /* all_match= */ true);
+        }
+}
+
+static void append_properties(sd_bus_message *m) {
+        /* Roughly what a GetAll() on a unit returns, scaled down */
+        assert_se(sd_bus_message_append(
+                        m, "a{sv}", 8,
+                        "Id", "s", "foobar.service",
+                        "Names", "as", 2, "foobar.service", "foobar-alias.service",
+                        "Description", "s", "Foo Bar Service",
+                        "LoadState", "s", "loaded",
+                        "ActiveState", "s", "active",
+                        "SubState", "s", "running",
+                        "MainPID", "u", 4711,
+                        "ActiveEnterTimestamp", "t", UINT64_C(1700000000000000)) >= 0);
+}
+
+static void parse_properties(sd_bus_message *m) {
+        const char *name;
+        unsigned n = 0;
+        int r;
+
+        assert_se(sd_bus_message_enter_container(m, 'a', "{sv}") > 0);
+        while ((r = sd_bus_message_enter_container(m, 'e', "sv")) > 0) {
+                assert_se(sd_bus_message_read(m, "s", &name) > 0);
+                assert_se(sd_bus_message_skip(m, "v") > 0);
+                assert_se(sd_bus_message_exit_container(m) > 0);
+                n++;
+        }
+        assert_se(r == 0);
+        assert_se(sd_bus_message_exit_container(m) > 0);
+        assert_se(n == 8);
+}
+
+#define N_UNITS 100U
+
+static void append_units(sd_bus_message *m) {
+        /* Like the reply to ListUnits() */
+        assert_se(sd_bus_message_open_container(m, 'a', "(ssssssouso)") >= 0);
+        for (unsigned i = 0; i < N_UNITS; i++) {
+                char id[STRLEN("unit-.service") + DECIMAL_STR_MAX(unsigned)];
+
+                xsprintf(id, "unit-%u.service", i);
+                assert_se(sd_bus_message_append(
+                                m, "(ssssssouso)",
+                                id, "Some Unit", "loaded", "active", "running", "",
+                                "/org/freedesktop/systemd1/unit/some_2eservice",
+                                0, "", "/") >= 0);
+        }
+        assert_se(sd_bus_message_close_container(m) >= 0);
+}
+
+static void parse_units(sd_bus_message *m) {
+        const char *id, *description, *load_state, *active_state, *sub_state, *following, *unit_path, *job_type, *job_path;
+        uint32_t job_id;
+        unsigned n = 0;
+        int r;
+
+        assert_se(sd_bus_message_enter_container(m, 'a', "(ssssssouso)") > 0);
+        while ((r = sd_bus_message_read(m, "(ssssssouso)", &id, &description, &load_state, &active_state, &sub_state,
+                                        &following, &unit_path, &job_id, &job_type, &job_path)) > 0)
+                n++;
+        assert_se(r == 0);
+        assert_se(sd_bus_message_exit_container(m) > 0);
+        assert_se(n == N_UNITS);
+}
+
+static void benchmark_marshal_one(sd_bus *bus, const char *signature, void (*append)(sd_bus_message *m), void (*parse)(sd_bus_message *m)) {
+        usec_t t, marshal = 0, demarshal = 0;
+        uint64_t n = 0;
+        size_t size = 0;
+
+        t = now(CLOCK_MONOTONIC);
+        while (now(CLOCK_MONOTONIC) < t + arg_loop_usec) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL, *p = NULL;
+                void *blob;
+                usec_t a, b, c;
+
+                a = now(CLOCK_MONOTONIC);
+                assert_se(sd_bus_message_new_method_call(bus, &m, NULL, "/", "benchmark.server", "Work") >= 0);
+                append(m);
+                assert_se(sd_bus_message_seal(m, n + 1, 0) >= 0);
+                b = now(CLOCK_MONOTONIC);
+
+                assert_se(bus_message_get_blob(m, &blob, &size) >= 0);
+                assert_se(bus_message_from_malloc(bus, blob, size, NULL, 0, NULL, &p) >= 0);
+                c = now(CLOCK_MONOTONIC);
+                parse(p);
+
+                marshal += b - a;
+                demarshal += now(CLOCK_MONOTONIC) - c;
+                n++;
+        }
+
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        assert_se(sd_json_buildo(
+                        &v,
+                        SD_JSON_BUILD_PAIR_STRING("benchmark", "marshal"),
+                        SD_JSON_BUILD_PAIR_STRING("signature", signature),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("messageSize", size),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("messages", n),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("marshalNsec", marshal * NSEC_PER_USEC / n),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("demarshalNsec", demarshal * NSEC_PER_USEC / n)) >= 0);
+        report(v);
+}
+
+static void benchmark_marshal(void) {
+        _cleanup_(sd_bus_unrefp) sd_bus *a = NULL, *b = NULL;
+
+        bus_pair_new(&a, &b);
+
+        benchmark_marshal_one(b, "a{sv}", append_properties, parse_properties);
+        benchmark_marshal_one(b, "a(ssssssouso)", append_units, parse_units);
+}
+
+static int on_track(sd_bus_track *t, void *userdata) {
+        unsigned *n_left = ASSERT_PTR(userdata);
+
+        assert_se(*n_left > 0);
+        (*n_left)--;
+        return 1;
+}
+
+static void benchmark_track_one(unsigned n_tracks) {
+        _cleanup_(sd_bus_unrefp) sd_bus *a = NULL, *b = NULL;
+        _cleanup_free_ sd_bus_track **tracks = NULL;
+        unsigned n_left = n_tracks;
+        const char *unique;
+        usec_t t, add, notify;
+
+        /* A number of track objects watching the same peer, like PID 1 does for a client that owns a unit
+         * as well as a number of jobs. Track objects need a bus broker. */
+
+        assert_se(sd_bus_open_user(&a) >= 0);
+        assert_se(sd_bus_open_user(&b) >= 0);
+        assert_se(sd_bus_get_unique_name(b, &unique) >= 0);
+
+        assert_se(tracks = new0(sd_bus_track*, n_tracks));
+
+        t = now(CLOCK_MONOTONIC);
+        for (unsigned i = 0; i < n_tracks; i++) {
+                assert_se(sd_bus_track_new(a, tracks + i, on_track, &n_left) >= 0);
+                assert_se(sd_bus_track_add_name(tracks[i], unique) > 0);
+        }
+        add = now(CLOCK_MONOTONIC) - t;
+
+        t = now(CLOCK_MONOTONIC);
+        b = sd_bus_flush_close_unref(b);
+        while (n_left > 0) {
+                int r;
+
+                r = sd_bus_process(a, NULL);
+                assert_se(r >= 0);
+                if (r == 0)
+                        assert_se(sd_bus_wait(a, USEC_INFINITY) >= 0);
+        }
+        notify = now(CLOCK_MONOTONIC) - t;
+
+        for (unsigned i = 0; i < n_tracks; i++)
+                sd_bus_track_unref(tracks[i]);
+
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        assert_se(sd_json_buildo(
+                        &v,
+                        SD_JSON_BUILD_PAIR_STRING("benchmark", "track"),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("tracks", n_tracks),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("addNsec", add * NSEC_PER_USEC / n_tracks),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("notifyUsec", notify)) >= 0);
+        report(v);
+}
+
+static void benchmark_track(void) {
+        static const unsigned n_tracks[] = { 10, 100, 1000, 10000 };
+
+        if (!secure_getenv("DBUS_SESSION_BUS_ADDRESS"))
+                return (void) log_notice("$DBUS_SESSION_BUS_ADDRESS not set, skipping track benchmark.");
+
+        FOREACH_ELEMENT(n, n_tracks)
+                benchmark_track_one(*n);
+}
+
 int main(int argc, char *argv[]) {
         enum {
                 MODE_BISECT,
                 MODE_CHART,
+                MODE_LATENCY,
+                MODE_FANOUT,
+                MODE_MARSHAL,
+                MODE_TRACK,
+                MODE_SUITE,
         } mode = MODE_BISECT;
         Type type = TYPE_LEGACY;
         int i, pair[2] = EBADF_PAIR;
@@ -234,6 +622,24 @@ int main(int argc, char *argv[]) {
                 } else if (streq(argv[i], "direct")) {
                         type = TYPE_DIRECT;
                         continue;
+                } else if (streq(argv[i], "latency")) {
+                        mode = MODE_LATENCY;
+                        continue;
+                } else if (streq(argv[i], "fanout")) {
+                        mode = MODE_FANOUT;
+                        continue;
+                } else if (streq(argv[i], "marshal")) {
+                        mode = MODE_MARSHAL;
+                        continue;
+                } else if (streq(argv[i], "track")) {
+                        mode = MODE_TRACK;
+                        continue;
+                } else if (streq(argv[i], "suite")) {
+                        mode = MODE_SUITE;
+                        continue;
+                } else if (streq(argv[i], "json")) {
+                        arg_json = true;
+                        continue;
                 }
 
                 assert_se(parse_sec(argv[i], &arg_loop_usec) >= 0);
@@ -241,6 +647,24 @@ int main(int argc, char *argv[]) {
 
         assert_se(arg_loop_usec > 0);
 
+        /* These don't need a bus broker, and use direct connections only */
+        if (IN_SET(mode, MODE_LATENCY, MODE_FANOUT, MODE_MARSHAL, MODE_TRACK, MODE_SUITE)) {
+                if (IN_SET(mode, MODE_LATENCY, MODE_SUITE))
+                        benchmark_latency();
+                if (IN_SET(mode, MODE_FANOUT, MODE_SUITE))
+                        benchmark_fanout();
+                if (IN_SET(mode, MODE_MARSHAL, MODE_SUITE))
+                        benchmark_marshal();
+                if (IN_SET(mode, MODE_TRACK, MODE_SUITE))
+                        benchmark_track();
+
+                if (arg_json)
+                        assert_se(sd_json_variant_dump(arg_results, SD_JSON_FORMAT_NEWLINE, stdout, NULL) >= 0);
+
+                sd_json_variant_unref(arg_results);
+                return 0;
+        }
+
         if (type == TYPE_LEGACY) {
                 const char *e;
 
@@ -303,6 +727,9 @@ int main(int argc, char *argv[]) {
                 case MODE_CHART:
                         client_chart(type, address, server_name, pair[1]);
                         break;
+
+                default:
+                        assert_not_reached();
                 }
 
                 _exit(EXIT_SUCCESS);
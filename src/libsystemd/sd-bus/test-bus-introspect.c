@@ -2,6 +2,7 @@
 
 #include "bus-introspect.h"
 #include "log.h"
+#include "string-util.h"
 #include "tests.h"
 
 #include "test-vtable-data.h"
@@ -30,4 +31,34 @@ TEST(manual_introspection) {
         test_manual_introspection_one((const sd_bus_vtable *) vtable_format_221);
 }
 
+static void test_formatted_introspection_one(const sd_bus_vtable vtable[], bool trusted) {
+        struct introspect a = {}, b = {};
+        _cleanup_free_ char *x = NULL, *y = NULL, *members = NULL;
+
+        log_info("/* %s(trusted=%s) */", __func__, yes_no(trusted));
+
+        assert_se(introspect_format_interface(vtable, trusted, &members) >= 0);
+
+        assert_se(introspect_begin(&a, trusted) >= 0);
+        assert_se(introspect_write_interface(&a, "org.foo", vtable) >= 0);
+        assert_se(introspect_write_interface(&a, "org.foo.bar", vtable) >= 0);
+        assert_se(introspect_finish(&a, &x) == 0);
+
+        assert_se(introspect_begin(&b, trusted) >= 0);
+        assert_se(introspect_write_interface_formatted(&b, "org.foo", members) >= 0);
+        assert_se(introspect_write_interface_formatted(&b, "org.foo.bar", members) >= 0);
+        assert_se(introspect_finish(&b, &y) == 0);
+
+        assert_se(streq(x, y));
+}
+
+TEST(formatted_introspection) {
+        for (int trusted = 0; trusted <= 1; trusted++) {
+                test_formatted_introspection_one(test_vtable_1, trusted);
+                test_formatted_introspection_one(test_vtable_2, trusted);
+                test_formatted_introspection_one(test_vtable_deprecated, trusted);
+                test_formatted_introspection_one((const sd_bus_vtable *) vtable_format_221, trusted);
+        }
+}
+
 DEFINE_TEST_MAIN(LOG_DEBUG);
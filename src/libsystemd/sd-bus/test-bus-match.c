@@ -7,6 +7,7 @@
 #include "macro.h"
 #include "memory-util.h"
 #include "tests.h"
+#include "time-util.h"
 
 static bool mask[32];
 
@@ -56,6 +57,68 @@ static int match_add(sd_bus_slot *slots, struct bus_match_node *root, const char
         return bus_match_add(root, components, n_components, &s->match_callback);
 }
 
+static unsigned n_benchmark_hits = 0;
+
+static int benchmark_filter(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        n_benchmark_hits++;
+        return 0;
+}
+
+static void benchmark_one(sd_bus *bus, unsigned n_matches) {
+        struct bus_match_node root = {
+                .type = BUS_MATCH_ROOT,
+        };
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+        _cleanup_free_ sd_bus_slot *slots = NULL;
+        usec_t t;
+
+        /* One path_namespace= and one arg0namespace= match per unit, like a client tracking many units
+         * would install */
+
+        assert_se(slots = new0(sd_bus_slot, 2 * n_matches));
+
+        for (unsigned i = 0; i < 2 * n_matches; i++) {
+                struct bus_match_component *components = NULL;
+                _cleanup_free_ char *match = NULL;
+                size_t n_components = 0;
+
+                CLEANUP_ARRAY(components, n_components, bus_match_parse_free);
+
+                if (i % 2 == 0)
+                        assert_se(asprintf(&match, "type='signal',path_namespace='/org/example/unit/u%u'", i / 2) >= 0);
+                else
+                        assert_se(asprintf(&match, "type='signal',arg0namespace='org.example.u%u'", i / 2) >= 0);
+
+                assert_se(bus_match_parse(match, &components, &n_components) >= 0);
+
+                slots[i].match_callback.callback = benchmark_filter;
+                assert_se(bus_match_add(&root, components, n_components, &slots[i].match_callback) >= 0);
+        }
+
+        assert_se(sd_bus_message_new_signal(bus, &m, "/org/example/unit/u7/sub", "org.example.Unit", "Changed") >= 0);
+        assert_se(sd_bus_message_append(m, "s", "org.example.u7.sub") >= 0);
+        assert_se(sd_bus_message_seal(m, 1, 0) >= 0);
+
+        n_benchmark_hits = 0;
+        t = now(CLOCK_MONOTONIC);
+        for (unsigned i = 0; i < 1000; i++)
+                assert_se(bus_match_run(NULL, &root, m) == 0);
+        t = usec_sub_unsigned(now(CLOCK_MONOTONIC), t);
+
+        /* Exactly the two matches for u7 apply */
+        assert_se(n_benchmark_hits == 2 * 1000);
+
+        log_info("Dispatching a signal against %u namespace matches took %s on average.",
+                 2 * n_matches, FORMAT_TIMESPAN(t / 1000, 1));
+
+        bus_match_free(&root);
+}
+
+static void test_match_benchmark(sd_bus *bus) {
+        FOREACH_ELEMENT(n, ((unsigned[]) { 10, 1000, 25000 }))
+                benchmark_one(bus, *n);
+}
+
 static void test_match_scope(const char *match, enum bus_match_scope scope) {
         struct bus_match_component *components = NULL;
         size_t n_components = 0;
@@ -134,6 +197,8 @@ int main(int argc, char *argv[]) {
 
         bus_match_free(&root);
 
+        test_match_benchmark(bus);
+
         test_match_scope("interface='foobar'", BUS_MATCH_GENERIC);
         test_match_scope("", BUS_MATCH_GENERIC);
         test_match_scope("interface='org.freedesktop.DBus.Local'", BUS_MATCH_LOCAL);
@@ -94,6 +94,7 @@ static int client(struct context *c) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL, *reply = NULL;
         _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
+        uint64_t n_messages, n_writes;
         int r;
 
         assert_se(sd_bus_new(&bus) >= 0);
@@ -102,6 +103,16 @@ static int client(struct context *c) {
         assert_se(sd_bus_set_anonymous(bus, c->client_anonymous_auth) >= 0);
         assert_se(sd_bus_start(bus) >= 0);
 
+        /* The connection is still authenticating, hence these are all queued, and then written out in
+         * batches once we are done with that */
+        for (unsigned i = 0; i < 64; i++) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *s = NULL;
+
+                assert_se(sd_bus_message_new_signal(bus, &s, "/", "org.freedesktop.systemd.test", "Ping") >= 0);
+                assert_se(sd_bus_message_append(s, "u", i) >= 0);
+                assert_se(sd_bus_send(bus, s, NULL) >= 0);
+        }
+
         r = sd_bus_message_new_method_call(
                         bus,
                         &m,
@@ -116,6 +127,11 @@ static int client(struct context *c) {
         if (r < 0)
                 return log_error_errno(r, "Failed to issue method call: %s", bus_error_message(&error, r));
 
+        assert_se(sd_bus_get_n_written(bus, &n_messages, &n_writes) >= 0);
+        log_info("Wrote %" PRIu64 " messages in %" PRIu64 " writes.", n_messages, n_writes);
+        assert_se(n_messages == 65);
+        assert_se(n_writes > 0 && n_writes < n_messages);
+
         return 0;
 }
 
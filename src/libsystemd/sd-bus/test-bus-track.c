@@ -10,6 +10,7 @@
 
 static bool track_cb_called_x = false;
 static bool track_cb_called_y = false;
+static bool track_cb_called_w = false;
 static bool track_destroy_called_z = false;
 
 static int track_cb_x(sd_bus_track *t, void *userdata) {
@@ -40,6 +41,17 @@ static int track_cb_y(sd_bus_track *t, void *userdata) {
         return 0;
 }
 
+static int track_cb_w(sd_bus_track *t, void *userdata) {
+
+        log_error("TRACK CB W");
+
+        /* Watches the same name as x, hence shares the match with it, and must be notified too */
+        assert_se(!track_cb_called_w);
+        track_cb_called_w = true;
+
+        return 1;
+}
+
 static int track_cb_z(sd_bus_track *t, void *userdata) {
         assert_not_reached();
 }
@@ -50,7 +62,7 @@ static void track_destroy_z(void *userdata) {
 
 int main(int argc, char *argv[]) {
         _cleanup_(sd_event_unrefp) sd_event *event = NULL;
-        _cleanup_(sd_bus_track_unrefp) sd_bus_track *x = NULL, *y = NULL, *z = NULL;
+        _cleanup_(sd_bus_track_unrefp) sd_bus_track *x = NULL, *y = NULL, *z = NULL, *w = NULL;
         _cleanup_(sd_bus_unrefp) sd_bus *a = NULL, *b = NULL;
         bool use_system_bus = false;
         const char *unique;
@@ -85,6 +97,11 @@ int main(int argc, char *argv[]) {
 
         assert_se(sd_bus_track_add_name(x, unique) >= 0);
 
+        /* And once more from a second track object */
+        assert_se(sd_bus_track_new(a, &w, track_cb_w, NULL) >= 0);
+        assert_se(sd_bus_track_add_name(w, unique) >= 0);
+        assert_se(sd_bus_track_contains(w, unique));
+
         /* Watch's a's own name from a */
         assert_se(sd_bus_track_new(a, &y, track_cb_y, NULL) >= 0);
 
@@ -146,6 +163,7 @@ int main(int argc, char *argv[]) {
 
         assert_se(track_cb_called_x);
         assert_se(track_cb_called_y);
+        assert_se(track_cb_called_w);
 
         return 0;
 }
@@ -803,6 +803,42 @@ static int enumerator_scan_dir(
         return r;
 }
 
+static bool match_subsystem_by_device_id(sd_device_enumerator *enumerator, const char *id) {
+        _cleanup_free_ char *buf = NULL;
+        const char *subsystem, *e;
+
+        assert(enumerator);
+        assert(id);
+
+        /* Most device IDs encode the subsystem of the device, see sd_device_get_device_id(). Let's check it
+         * without creating the sd_device object, which requires accessing sysfs. If the subsystem cannot be
+         * determined from the ID, assume it matches, and leave it to test_matches(). */
+
+        switch (id[0]) {
+        case 'b':
+                subsystem = "block";
+                break;
+        case 'n':
+                subsystem = "net";
+                break;
+        case '+':
+                e = strchr(id + 1, ':');
+                if (!e)
+                        return true;
+
+                buf = strndup(id + 1, e - id - 1);
+                if (!buf)
+                        return true;
+
+                subsystem = buf;
+                break;
+        default:
+                return true;
+        }
+
+        return match_subsystem(enumerator, subsystem);
+}
+
 static int enumerator_scan_devices_tag(sd_device_enumerator *enumerator, const char *tag) {
         _cleanup_closedir_ DIR *dir = NULL;
         char *path;
@@ -821,8 +857,6 @@ static int enumerator_scan_devices_tag(sd_device_enumerator *enumerator, const c
                 return log_debug_errno(errno, "sd-device-enumerator: Failed to open directory '%s': %m", path);
         }
 
-        /* TODO: filter away subsystems? */
-
         FOREACH_DIRENT_ALL(de, dir, return -errno) {
                 _cleanup_(sd_device_unrefp) sd_device *device = NULL;
                 int k;
@@ -830,6 +864,9 @@ static int enumerator_scan_devices_tag(sd_device_enumerator *enumerator, const c
                 if (de->d_name[0] == '.')
                         continue;
 
+                if (!match_subsystem_by_device_id(enumerator, de->d_name))
+                        continue;
+
                 k = sd_device_new_from_device_id(&device, de->d_name);
                 if (k < 0) {
                         if (k != -ENODEV)
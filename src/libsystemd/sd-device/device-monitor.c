@@ -39,6 +39,11 @@
 #define log_device_monitor_errno(d, m, r, format, ...)                  \
         log_device_debug_errno(d, r, "sd-device-monitor(%s): " format, strna(m ? m->description : NULL), ##__VA_ARGS__)
 
+/* Maximum number of messages received and dispatched per wakeup of the event loop. During coldplug
+ * thousands of uevents may be queued, this way we don't go back to epoll_wait() for every single one of
+ * them, while other event sources still get their turn regularly. */
+#define DEVICE_MONITOR_DISPATCH_MAX 64U
+
 struct sd_device_monitor {
         unsigned n_ref;
 
@@ -320,18 +325,39 @@ _public_ int sd_device_monitor_stop(sd_device_monitor *m) {
 }
 
 static int device_monitor_event_handler(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
-        _cleanup_(sd_device_unrefp) sd_device *device = NULL;
-        _unused_ _cleanup_(log_context_unrefp) LogContext *c = NULL;
+        _unused_ _cleanup_(sd_device_monitor_unrefp) sd_device_monitor *ref = NULL;
         sd_device_monitor *m = ASSERT_PTR(userdata);
+        int r;
 
-        if (sd_device_monitor_receive(m, &device) <= 0)
-                return 0;
+        /* The callback might drop the last reference to us */
+        ref = sd_device_monitor_ref(m);
+
+        for (unsigned i = 0; i < DEVICE_MONITOR_DISPATCH_MAX; i++) {
+                _cleanup_(sd_device_unrefp) sd_device *device = NULL;
+                _unused_ _cleanup_(log_context_unrefp) LogContext *c = NULL;
+
+                /* Errors are logged already. Either nothing is queued anymore, or this was an invalid
+                 * message, in which case we simply continue with the next wakeup. */
+                r = sd_device_monitor_receive(m, &device);
+                if (r < 0)
+                        break;
+
+                if (r > 0 && m->callback) {
+                        if (log_context_enabled())
+                                c = log_context_new_strv_consume(device_make_log_fields(device));
 
-        if (log_context_enabled())
-                c = log_context_new_strv_consume(device_make_log_fields(device));
+                        r = m->callback(m, device, m->userdata);
+                        if (r < 0)
+                                return r;
+                }
 
-        if (m->callback)
-                return m->callback(m, device, m->userdata);
+                /* Stop if the callback stopped the monitor or the event loop, anything still queued is
+                 * picked up later. */
+                if (m->event_source != s ||
+                    sd_event_source_get_enabled(s, NULL) <= 0 ||
+                    sd_event_get_exit_code(m->event, NULL) != -ENODATA)
+                        break;
+        }
 
         return 0;
 }
@@ -525,6 +551,87 @@ static int passes_filter(sd_device_monitor *m, sd_device *device) {
         return device_match_parent(device, m->match_parent_filter, m->nomatch_parent_filter);
 }
 
+static bool tags_contain(const char *tags, const char *tag) {
+        assert(tags);
+        assert(tag);
+
+        for (const char *p = tags;;) {
+                size_t n = strcspn(p, ":");
+
+                if (n > 0 && strneq(p, tag, n) && tag[n] == '\0')
+                        return true;
+
+                if (p[n] == '\0')
+                        return false;
+
+                p += n + 1;
+        }
+}
+
+static bool properties_pass_filter(sd_device_monitor *m, const char *nulstr, size_t len) {
+        const char *subsystem = NULL, *devtype = NULL, *tags = NULL, *current_tags = NULL, *s, *d, *tag;
+        bool found = false;
+
+        assert(m);
+        assert(nulstr);
+
+        /* Checks the subsystem and tag filters against the raw properties of a received message, so that
+         * we can skip devices we are not interested in without parsing all their properties into a device
+         * object first. This needs to be conservative: if in doubt, let passes_filter() decide. */
+
+        if (hashmap_isempty(m->subsystem_filter) && set_isempty(m->tag_filter))
+                return true;
+
+        for (size_t i = 0; i < len;) {
+                const char *p = nulstr + i, *v;
+                size_t n = strnlen(p, len - i);
+
+                if ((v = startswith(p, "SUBSYSTEM=")))
+                        subsystem = v;
+                else if ((v = startswith(p, "DEVTYPE=")))
+                        devtype = v;
+                else if ((v = startswith(p, "TAGS=")))
+                        tags = v;
+                else if ((v = startswith(p, "CURRENT_TAGS=")))
+                        current_tags = v;
+
+                i += n + 1;
+        }
+
+        /* The subsystem is mandatory for a valid message, and tags are parsed with escape handling. */
+        if (!subsystem ||
+            (tags && strpbrk(tags, "\\\"'")) ||
+            (current_tags && strpbrk(current_tags, "\\\"'")))
+                return true;
+
+        if (!hashmap_isempty(m->subsystem_filter)) {
+                HASHMAP_FOREACH_KEY(d, s, m->subsystem_filter)
+                        if (streq(s, subsystem) && (!d || streq_ptr(d, devtype))) {
+                                found = true;
+                                break;
+                        }
+
+                if (!found)
+                        return false;
+        }
+
+        if (!set_isempty(m->tag_filter)) {
+                found = false;
+
+                SET_FOREACH(tag, m->tag_filter)
+                        if ((tags && tags_contain(tags, tag)) ||
+                            (current_tags && tags_contain(current_tags, tag))) {
+                                found = true;
+                                break;
+                        }
+
+                if (!found)
+                        return false;
+        }
+
+        return true;
+}
+
 static bool check_sender_uid(sd_device_monitor *m, uid_t uid) {
         int r;
 
@@ -665,6 +772,12 @@ _public_ int sd_device_monitor_receive(sd_device_monitor *m, sd_device **ret) {
                         return log_monitor_errno(m, SYNTHETIC_ERRNO(EAGAIN), "Invalid message length.");
         }
 
+        if (!properties_pass_filter(m, message.nulstr + offset, n - offset)) {
+                log_monitor(m, "Received device does not pass filter, ignoring.");
+                *ret = NULL;
+                return 0;
+        }
+
         r = device_new_from_nulstr(&device, message.nulstr + offset, n - offset);
         if (r < 0)
                 return log_monitor_errno(m, r, "Failed to create device from received message: %m");
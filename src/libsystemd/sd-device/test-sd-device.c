@@ -15,6 +15,7 @@
 #include "nulstr-util.h"
 #include "path-util.h"
 #include "rm-rf.h"
+#include "set.h"
 #include "stat-util.h"
 #include "string-util.h"
 #include "tests.h"
@@ -363,6 +364,53 @@ TEST(sd_device_enumerator_filter_subsystem) {
                 assert_se(test_sd_device_enumerator_filter_subsystem_trial_many());
 }
 
+static void test_sd_device_enumerator_tag_and_subsystem_one(bool match) {
+        _cleanup_(sd_device_enumerator_unrefp) sd_device_enumerator *e = NULL;
+        _cleanup_set_free_ Set *expected = NULL, *found = NULL;
+        const char *syspath, *s;
+
+        log_debug("/* %s(%s) */", __func__, yes_no(match));
+
+        /* Enumerate all tagged devices, and pick the ones that should be found with the subsystem filter. */
+        ASSERT_OK(sd_device_enumerator_new(&e));
+        ASSERT_OK(sd_device_enumerator_add_match_tag(e, "systemd"));
+
+        FOREACH_DEVICE(e, d) {
+                /* Devices without subsystem never pass a subsystem filter, not even an excluding one. */
+                if (sd_device_get_subsystem(d, &s) < 0)
+                        continue;
+
+                if (STR_IN_SET(s, "block", "net") != match)
+                        continue;
+
+                ASSERT_OK(sd_device_get_syspath(d, &syspath));
+                ASSERT_OK(set_put_strdup(&expected, syspath));
+        }
+
+        e = sd_device_enumerator_unref(e);
+
+        /* Subsystems are filtered by the device ID found in the tag directory before the device is read from
+         * sysfs, make sure that gives the same result as filtering by the subsystem of the device itself. */
+        ASSERT_OK(sd_device_enumerator_new(&e));
+        ASSERT_OK(sd_device_enumerator_add_match_tag(e, "systemd"));
+        ASSERT_OK(sd_device_enumerator_add_match_subsystem(e, "block", match));
+        ASSERT_OK(sd_device_enumerator_add_match_subsystem(e, "net", match));
+
+        FOREACH_DEVICE(e, d) {
+                ASSERT_OK_POSITIVE(sd_device_has_tag(d, "systemd"));
+                ASSERT_OK(sd_device_get_syspath(d, &syspath));
+                ASSERT_OK(set_put_strdup(&found, syspath));
+        }
+
+        log_debug("Found %u tagged devices, expected %u.", set_size(found), set_size(expected));
+        ASSERT_TRUE(set_equal(found, expected));
+}
+
+TEST(sd_device_enumerator_add_match_tag_and_subsystem) {
+        test_sd_device_enumerator_tag_and_subsystem_one(/* match = */ true);
+        test_sd_device_enumerator_tag_and_subsystem_one(/* match = */ false);
+}
+
 TEST(sd_device_enumerator_add_match_sysattr) {
         _cleanup_(sd_device_enumerator_unrefp) sd_device_enumerator *e = NULL;
         sd_device *dev;
@@ -7,11 +7,14 @@
 
 #include "sd-event.h"
 
+#include "event-uring.h"
+#include "event-work.h"
 #include "hashmap.h"
 #include "inotify-util.h"
 #include "list.h"
 #include "prioq.h"
 #include "ratelimit.h"
+#include "timer-wheel.h"
 
 typedef enum EventSourceType {
         SOURCE_IO,
@@ -28,6 +31,8 @@ typedef enum EventSourceType {
         SOURCE_WATCHDOG,
         SOURCE_INOTIFY,
         SOURCE_MEMORY_PRESSURE,
+        SOURCE_IO_URING,
+        SOURCE_WORK,
         _SOURCE_EVENT_SOURCE_TYPE_MAX,
         _SOURCE_EVENT_SOURCE_TYPE_INVALID = -EINVAL,
 } EventSourceType;
@@ -40,6 +45,8 @@ typedef enum WakeupType {
         WAKEUP_CLOCK_DATA,
         WAKEUP_SIGNAL_DATA,
         WAKEUP_INOTIFY_DATA,
+        WAKEUP_IO_URING_DATA,
+        WAKEUP_WORK_DATA,
         _WAKEUP_TYPE_MAX,
         _WAKEUP_TYPE_INVALID = -EINVAL,
 } WakeupType;
@@ -70,6 +77,9 @@ struct sd_event_source {
         unsigned prepare_index;
         uint64_t pending_iteration;
         uint64_t prepare_iteration;
+        usec_t pending_usec; /* When the event source was marked pending, if statistics are collected */
+
+        struct EventSourceStatistics *statistics;
 
         sd_event_destroy_t destroy_callback;
         sd_event_handler_t ratelimit_expire_callback;
@@ -95,6 +105,8 @@ struct sd_event_source {
                 struct {
                         sd_event_time_handler_t callback;
                         usec_t next, accuracy;
+                        TimerWheelNode wheel_node;
+                        bool use_wheel:1; /* scheduled via the clock's timer wheel rather than its prioqs */
                 } time;
                 struct {
                         sd_event_signal_handler_t callback;
@@ -141,6 +153,19 @@ struct sd_event_source {
                         bool locked:1;
                         bool in_write_list:1;
                 } memory_pressure;
+                struct {
+                        sd_event_io_uring_handler_t callback;
+                        void *sqe;          /* The operation to submit, a struct io_uring_sqe */
+                        uint64_t user_data; /* The user_data field of the operation as passed in by the caller */
+                        uint64_t token;     /* Identifies the submission currently in flight, 0 if none */
+                        int32_t res;
+                        uint32_t flags;
+                } io_uring;
+                struct {
+                        sd_event_work_handler_t callback;
+                        WorkItem item; /* item.func is the work function, executed on a worker thread */
+                        bool in_flight:1; /* queued or running, or finished but not collected yet */
+                } work;
         };
 };
 
@@ -159,6 +184,10 @@ struct clock_data {
         Prioq *latest;
         usec_t next;
 
+        /* Coarse timers on clocks that never jump backwards are kept in a timer wheel instead, which has
+         * O(1) insertion and removal. Allocated on first use. */
+        TimerWheel *wheel;
+
         bool needs_rearm:1;
 };
 
@@ -240,3 +269,21 @@ struct inotify_data {
          * to make it efficient to figure out what inotify objects to process data on next. */
         LIST_FIELDS(struct inotify_data, buffered);
 };
+
+/* The io_uring instance shared by all io_uring event sources of an event loop */
+struct io_uring_data {
+        WakeupType wakeup;
+
+        URing *ring;
+
+        /* Event sources with a submission in flight, keyed by their token */
+        Hashmap *sources;
+        uint64_t last_token;
+};
+
+/* The worker threads shared by all work event sources of an event loop */
+struct work_data {
+        WakeupType wakeup;
+
+        WorkPool *pool;
+};
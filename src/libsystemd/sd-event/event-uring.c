@@ -0,0 +1,207 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "env-util.h"
+#include "errno-util.h"
+#include "event-uring.h"
+#include "fd-util.h"
+#include "log.h"
+#include "missing_threads.h"
+
+#if ENABLE_URING
+
+struct URing {
+        int fd;
+
+        void *sq_ring;
+        size_t sq_ring_size;
+        void *cq_ring;
+        size_t cq_ring_size;
+        struct io_uring_sqe *sqes;
+        size_t sqes_size;
+
+        unsigned *sq_head;
+        unsigned *sq_tail;
+        unsigned *sq_mask;
+        unsigned *sq_array;
+        unsigned sq_entries;
+
+        /* Our private tail, i.e. SQEs handed out by uring_get_sqe() but not submitted yet */
+        unsigned sqe_tail;
+
+        unsigned *cq_head;
+        unsigned *cq_tail;
+        unsigned *cq_mask;
+        struct io_uring_cqe *cqes;
+};
+
+bool uring_supported(void) {
+        static thread_local int cached = -1;
+        int r;
+
+        if (cached >= 0)
+                return cached;
+
+        r = getenv_bool("SYSTEMD_EVENT_IO_URING");
+        if (r < 0 && r != -ENXIO)
+                log_debug_errno(r, "Failed to parse $SYSTEMD_EVENT_IO_URING, ignoring: %m");
+
+        return (cached = r != 0);
+}
+
+int uring_new(unsigned entries, URing **ret) {
+        _cleanup_(uring_freep) URing *u = NULL;
+        struct io_uring_params p = {};
+
+        assert(entries > 0);
+        assert(ret);
+
+        u = new(URing, 1);
+        if (!u)
+                return -ENOMEM;
+
+        *u = (URing) {
+                .fd = -EBADF,
+                .sq_ring = MAP_FAILED,
+                .cq_ring = MAP_FAILED,
+                .sqes = MAP_FAILED,
+        };
+
+        /* The io_uring fd is always created with O_CLOEXEC set */
+        u->fd = RET_NERRNO(syscall(__NR_io_uring_setup, entries, &p));
+        if (u->fd < 0)
+                return u->fd;
+
+        u->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        u->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+        if (FLAGS_SET(p.features, IORING_FEAT_SINGLE_MMAP))
+                u->sq_ring_size = u->cq_ring_size = MAX(u->sq_ring_size, u->cq_ring_size);
+
+        u->sq_ring = mmap(NULL, u->sq_ring_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+        if (u->sq_ring == MAP_FAILED)
+                return -errno;
+
+        if (FLAGS_SET(p.features, IORING_FEAT_SINGLE_MMAP))
+                u->cq_ring = u->sq_ring;
+        else {
+                u->cq_ring = mmap(NULL, u->cq_ring_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+                if (u->cq_ring == MAP_FAILED)
+                        return -errno;
+        }
+
+        u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+        u->sqes = mmap(NULL, u->sqes_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQES);
+        if (u->sqes == MAP_FAILED)
+                return -errno;
+
+        u->sq_head = (unsigned*) ((uint8_t*) u->sq_ring + p.sq_off.head);
+        u->sq_tail = (unsigned*) ((uint8_t*) u->sq_ring + p.sq_off.tail);
+        u->sq_mask = (unsigned*) ((uint8_t*) u->sq_ring + p.sq_off.ring_mask);
+        u->sq_array = (unsigned*) ((uint8_t*) u->sq_ring + p.sq_off.array);
+        u->sq_entries = p.sq_entries;
+        u->sqe_tail = *u->sq_tail;
+
+        u->cq_head = (unsigned*) ((uint8_t*) u->cq_ring + p.cq_off.head);
+        u->cq_tail = (unsigned*) ((uint8_t*) u->cq_ring + p.cq_off.tail);
+        u->cq_mask = (unsigned*) ((uint8_t*) u->cq_ring + p.cq_off.ring_mask);
+        u->cqes = (struct io_uring_cqe*) ((uint8_t*) u->cq_ring + p.cq_off.cqes);
+
+        *ret = TAKE_PTR(u);
+        return 0;
+}
+
+URing* uring_free(URing *u) {
+        if (!u)
+                return NULL;
+
+        if (u->sqes != MAP_FAILED)
+                (void) munmap(u->sqes, u->sqes_size);
+        if (u->cq_ring != MAP_FAILED && u->cq_ring != u->sq_ring)
+                (void) munmap(u->cq_ring, u->cq_ring_size);
+        if (u->sq_ring != MAP_FAILED)
+                (void) munmap(u->sq_ring, u->sq_ring_size);
+
+        safe_close(u->fd);
+        return mfree(u);
+}
+
+int uring_get_fd(URing *u) {
+        assert(u);
+        return u->fd;
+}
+
+struct io_uring_sqe* uring_get_sqe(URing *u) {
+        struct io_uring_sqe *sqe;
+        unsigned head;
+
+        assert(u);
+
+        head = __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+        if (u->sqe_tail - head >= u->sq_entries)
+                return NULL; /* Full, the caller should submit first */
+
+        sqe = u->sqes + (u->sqe_tail & *u->sq_mask);
+        u->sqe_tail++;
+
+        return memzero(sqe, sizeof(*sqe));
+}
+
+int uring_submit(URing *u) {
+        unsigned tail, n;
+
+        assert(u);
+
+        /* SQEs are handed out in order, hence the index array is simply the identity */
+        for (tail = *u->sq_tail; tail != u->sqe_tail; tail++)
+                u->sq_array[tail & *u->sq_mask] = tail & *u->sq_mask;
+
+        __atomic_store_n(u->sq_tail, tail, __ATOMIC_RELEASE);
+
+        /* Also covers SQEs the kernel didn't consume on a previous, failed or partial, submission */
+        n = tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+        if (n == 0)
+                return 0;
+
+        return RET_NERRNO(syscall(__NR_io_uring_enter, u->fd, n, 0, 0, NULL, 0));
+}
+
+bool uring_pop_cqe(URing *u, struct io_uring_cqe *ret) {
+        unsigned head;
+
+        assert(u);
+        assert(ret);
+
+        head = *u->cq_head;
+        if (head == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE))
+                return false;
+
+        *ret = u->cqes[head & *u->cq_mask];
+        __atomic_store_n(u->cq_head, head + 1, __ATOMIC_RELEASE);
+
+        return true;
+}
+
+#else
+
+bool uring_supported(void) {
+        return false;
+}
+
+int uring_new(unsigned entries, URing **ret) {
+        return -EOPNOTSUPP;
+}
+
+URing* uring_free(URing *u) {
+        assert(!u);
+        return NULL;
+}
+
+int uring_get_fd(URing *u) {
+        return -EOPNOTSUPP;
+}
+
+#endif
@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <stdbool.h>
+#include <sys/syscall.h>
+
+#include "macro.h"
+
+#if HAVE_LINUX_IO_URING_H && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#  include <linux/io_uring.h>
+#  define ENABLE_URING 1
+#else
+#  define ENABLE_URING 0
+#endif
+
+/* A minimal io_uring wrapper, just enough for sd-event: SQEs are queued in the mmap()ed submission ring
+ * and only handed to the kernel in one go by uring_submit(). Completions are read off the mmap()ed
+ * completion queue without any system call. */
+
+typedef struct URing URing;
+
+bool uring_supported(void);
+
+int uring_new(unsigned entries, URing **ret);
+URing* uring_free(URing *u);
+DEFINE_TRIVIAL_CLEANUP_FUNC(URing*, uring_free);
+
+int uring_get_fd(URing *u);
+
+#if ENABLE_URING
+struct io_uring_sqe* uring_get_sqe(URing *u);
+int uring_submit(URing *u);
+bool uring_pop_cqe(URing *u, struct io_uring_cqe *ret);
+#endif
@@ -0,0 +1,255 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+
+#include "alloc-util.h"
+#include "errno-util.h"
+#include "event-work.h"
+#include "fd-util.h"
+#include "io-util.h"
+#include "log.h"
+#include "process-util.h"
+
+struct WorkPool {
+        pthread_mutex_t mutex;
+        pthread_cond_t queued_cond;   /* Signalled when an item is queued, or when the threads shall exit */
+        pthread_cond_t finished_cond; /* Signalled when an item finished running */
+
+        LIST_HEAD(WorkItem, queue);
+        WorkItem *queue_tail;
+        size_t n_queued;
+
+        LIST_HEAD(WorkItem, finished);
+
+        pthread_t *threads;
+        size_t n_threads;
+        size_t n_threads_max;
+        size_t n_idle;
+
+        int fd;    /* eventfd, signalled whenever an item finished */
+        pid_t pid; /* the threads only exist in the process that created them */
+
+        bool shutdown;
+};
+
+int work_pool_new(size_t n_threads_max, WorkPool **ret) {
+        _cleanup_(work_pool_freep) WorkPool *p = NULL;
+
+        assert(n_threads_max > 0);
+        assert(ret);
+
+        p = new(WorkPool, 1);
+        if (!p)
+                return -ENOMEM;
+
+        *p = (WorkPool) {
+                .mutex = PTHREAD_MUTEX_INITIALIZER,
+                .queued_cond = PTHREAD_COND_INITIALIZER,
+                .finished_cond = PTHREAD_COND_INITIALIZER,
+                .n_threads_max = n_threads_max,
+                .fd = -EBADF,
+                .pid = getpid_cached(),
+        };
+
+        p->threads = new(pthread_t, n_threads_max);
+        if (!p->threads)
+                return -ENOMEM;
+
+        p->fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+        if (p->fd < 0)
+                return -errno;
+
+        *ret = TAKE_PTR(p);
+        return 0;
+}
+
+WorkPool* work_pool_free(WorkPool *p) {
+        if (!p)
+                return NULL;
+
+        /* After fork() the threads are gone, and so is whatever they were doing. Don't try to join them. */
+        if (p->pid == getpid_cached()) {
+                assert_se(pthread_mutex_lock(&p->mutex) == 0);
+                assert(!p->queue);
+                p->shutdown = true;
+                assert_se(pthread_cond_broadcast(&p->queued_cond) == 0);
+                assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+                FOREACH_ARRAY(t, p->threads, p->n_threads)
+                        assert_se(pthread_join(*t, NULL) == 0);
+        }
+
+        safe_close(p->fd);
+        free(p->threads);
+        return mfree(p);
+}
+
+int work_pool_get_fd(WorkPool *p) {
+        assert(p);
+
+        return p->fd;
+}
+
+void work_pool_flush_fd(WorkPool *p) {
+        assert(p);
+
+        (void) flush_fd(p->fd);
+}
+
+static void* work_pool_thread(void *userdata) {
+        WorkPool *p = ASSERT_PTR(userdata);
+
+        (void) pthread_setname_np(pthread_self(), "sd-event-work");
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+        for (;;) {
+                WorkItem *i;
+                int r;
+
+                while (!p->queue && !p->shutdown) {
+                        p->n_idle++;
+                        assert_se(pthread_cond_wait(&p->queued_cond, &p->mutex) == 0);
+                        p->n_idle--;
+                }
+
+                if (p->shutdown)
+                        break;
+
+                i = LIST_POP(items, p->queue);
+                if (p->queue_tail == i)
+                        p->queue_tail = NULL;
+                p->n_queued--;
+
+                assert(i->state == WORK_ITEM_QUEUED);
+                i->state = WORK_ITEM_RUNNING;
+
+                assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+                r = i->func(i->userdata);
+
+                assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+                i->result = r;
+                i->state = WORK_ITEM_FINISHED;
+                LIST_PREPEND(items, p->finished, i);
+
+                assert_se(pthread_cond_broadcast(&p->finished_cond) == 0);
+
+                if (eventfd_write(p->fd, 1) < 0)
+                        log_debug_errno(errno, "Failed to signal finished work item, ignoring: %m");
+        }
+
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+        return NULL;
+}
+
+static int work_pool_spawn_thread_unlocked(WorkPool *p) {
+        sigset_t ss, saved_ss;
+        int r, k;
+
+        assert(p);
+        assert(p->n_threads < p->n_threads_max);
+
+        /* Block all signals in the threads, so that they are delivered to the event loop thread, which
+         * might want to handle them. */
+        assert_se(sigfillset(&ss) >= 0);
+
+        r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+        if (r > 0)
+                return -r;
+
+        r = pthread_create(p->threads + p->n_threads, NULL, work_pool_thread, p);
+
+        k = pthread_sigmask(SIG_SETMASK, &saved_ss, NULL);
+        if (r > 0)
+                return -r;
+
+        p->n_threads++;
+
+        if (k > 0)
+                return -k;
+
+        return 0;
+}
+
+int work_pool_queue(WorkPool *p, WorkItem *i) {
+        int r = 0;
+
+        assert(p);
+        assert(i);
+        assert(i->func);
+        assert(i->state == WORK_ITEM_IDLE);
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+        /* Start another thread if everything queued already exceeds the threads waiting for work */
+        if (p->n_queued >= p->n_idle && p->n_threads < p->n_threads_max) {
+                r = work_pool_spawn_thread_unlocked(p);
+                if (r < 0) {
+                        if (p->n_threads == 0)
+                                goto finish;
+
+                        log_debug_errno(r, "Failed to start work thread, continuing with %zu: %m", p->n_threads);
+                        p->n_threads_max = p->n_threads;
+                        r = 0;
+                }
+        }
+
+        LIST_INSERT_AFTER(items, p->queue, p->queue_tail, i);
+        p->queue_tail = i;
+        p->n_queued++;
+
+        i->state = WORK_ITEM_QUEUED;
+
+        assert_se(pthread_cond_signal(&p->queued_cond) == 0);
+
+finish:
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+        return r;
+}
+
+void work_pool_cancel(WorkPool *p, WorkItem *i) {
+        assert(p);
+        assert(i);
+
+        /* Makes sure the item is neither queued nor running anymore, and drops its result if it finished
+         * already. There's no way to interrupt an item that is already running, hence wait for it. */
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+        while (i->state == WORK_ITEM_RUNNING)
+                assert_se(pthread_cond_wait(&p->finished_cond, &p->mutex) == 0);
+
+        if (i->state == WORK_ITEM_QUEUED) {
+                if (p->queue_tail == i)
+                        p->queue_tail = i->items_prev;
+                LIST_REMOVE(items, p->queue, i);
+                p->n_queued--;
+        } else if (i->state == WORK_ITEM_FINISHED)
+                LIST_REMOVE(items, p->finished, i);
+
+        i->state = WORK_ITEM_IDLE;
+
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+}
+
+WorkItem* work_pool_pop_finished(WorkPool *p) {
+        WorkItem *i;
+
+        assert(p);
+
+        assert_se(pthread_mutex_lock(&p->mutex) == 0);
+
+        i = LIST_POP(items, p->finished);
+        if (i) {
+                assert(i->state == WORK_ITEM_FINISHED);
+                i->state = WORK_ITEM_IDLE;
+        }
+
+        assert_se(pthread_mutex_unlock(&p->mutex) == 0);
+
+        return i;
+}
@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "list.h"
+#include "macro.h"
+
+/* A small pool of worker threads executing blocking work on behalf of an event loop. Work items are
+ * executed in the order they were queued. Once an item finished it is put on the list of finished items
+ * and the pool's eventfd is signalled, so that the event loop can pick up the result from its own
+ * thread. Threads are started lazily, up to the configured maximum, and are only joined when the pool is
+ * freed. */
+
+typedef int (*work_func_t)(void *userdata);
+
+typedef enum WorkItemState {
+        WORK_ITEM_IDLE,
+        WORK_ITEM_QUEUED,
+        WORK_ITEM_RUNNING,
+        WORK_ITEM_FINISHED,
+} WorkItemState;
+
+typedef struct WorkItem WorkItem;
+
+struct WorkItem {
+        work_func_t func;
+        void *userdata;
+        int result;
+        WorkItemState state; /* protected by the pool's mutex while not idle */
+        LIST_FIELDS(WorkItem, items);
+};
+
+typedef struct WorkPool WorkPool;
+
+int work_pool_new(size_t n_threads_max, WorkPool **ret);
+WorkPool* work_pool_free(WorkPool *p);
+DEFINE_TRIVIAL_CLEANUP_FUNC(WorkPool*, work_pool_free);
+
+int work_pool_get_fd(WorkPool *p);
+void work_pool_flush_fd(WorkPool *p);
+
+int work_pool_queue(WorkPool *p, WorkItem *i);
+void work_pool_cancel(WorkPool *p, WorkItem *i);
+WorkItem* work_pool_pop_finished(WorkPool *p);
@@ -7,9 +7,11 @@
 #include "sd-daemon.h"
 #include "sd-event.h"
 #include "sd-id128.h"
+#include "sd-json.h"
 #include "sd-messages.h"
 
 #include "alloc-util.h"
+#include "bus-message.h"
 #include "env-util.h"
 #include "event-source.h"
 #include "fd-util.h"
@@ -43,6 +45,16 @@
 
 #define DEFAULT_ACCURACY_USEC (250 * USEC_PER_MSEC)
 
+/* The granularity of the timer wheel. Timers with at least this accuracy are scheduled via the wheel. */
+#define TIMER_WHEEL_TICK_USEC DEFAULT_ACCURACY_USEC
+
+/* Size of the io_uring submission queue. If it fills up before the next event loop iteration we'll submit
+ * early. */
+#define IO_URING_ENTRIES 256U
+
+/* Maximum number of threads executing the work of work event sources, per event loop */
+#define WORK_THREADS_MAX 8U
+
 static bool EVENT_SOURCE_WATCH_PIDFD(const sd_event_source *s) {
         /* Returns true if this is a PID event source and can be implemented by watching EPOLLIN */
         return s &&
@@ -75,6 +87,8 @@ static const char* const event_source_type_table[_SOURCE_EVENT_SOURCE_TYPE_MAX]
         [SOURCE_WATCHDOG]            = "watchdog",
         [SOURCE_INOTIFY]             = "inotify",
         [SOURCE_MEMORY_PRESSURE]     = "memory-pressure",
+        [SOURCE_IO_URING]            = "io-uring",
+        [SOURCE_WORK]                = "work",
 };
 
 DEFINE_PRIVATE_STRING_TABLE_LOOKUP_TO_STRING(event_source_type, int);
@@ -137,6 +151,10 @@ struct sd_event {
 
         Hashmap *inotify_data; /* indexed by priority */
 
+        struct io_uring_data *io_uring; /* allocated when the first io_uring event source is added */
+
+        struct work_data *work; /* allocated when the first work event source is added */
+
         /* A list of inode structures that still have an fd open, that we need to close before the next loop iteration */
         LIST_HEAD(struct inode_data, inode_data_to_close_list);
 
@@ -156,6 +174,7 @@ struct sd_event {
         bool need_process_child:1;
         bool watchdog:1;
         bool profile_delays:1;
+        bool collect_statistics:1;
 
         int exit_code;
 
@@ -174,6 +193,9 @@ struct sd_event {
 
         usec_t last_run_usec, last_log_usec;
         unsigned delays[sizeof(usec_t) * 8];
+
+        Hashmap *statistics; /* EventSourceStatistics objects, keyed by type and description */
+        uint64_t statistics_generation; /* increased whenever the above is flushed */
 };
 
 DEFINE_PRIVATE_ORIGIN_ID_HELPERS(sd_event, event);
@@ -337,6 +359,29 @@ static void free_clock_data(struct clock_data *d) {
         safe_close(d->fd);
         prioq_free(d->earliest);
         prioq_free(d->latest);
+        free(d->wheel);
+}
+
+static void free_io_uring_data(struct io_uring_data *d) {
+        if (!d)
+                return;
+
+        assert(d->wakeup == WAKEUP_IO_URING_DATA);
+        assert(hashmap_isempty(d->sources));
+
+        hashmap_free(d->sources);
+        uring_free(d->ring);
+        free(d);
+}
+
+static void free_work_data(struct work_data *d) {
+        if (!d)
+                return;
+
+        assert(d->wakeup == WAKEUP_WORK_DATA);
+
+        work_pool_free(d->pool);
+        free(d);
 }
 
 static sd_event* event_free(sd_event *e) {
@@ -376,6 +421,11 @@ static sd_event* event_free(sd_event *e) {
 
         hashmap_free(e->inotify_data);
 
+        free_io_uring_data(e->io_uring);
+        free_work_data(e->work);
+
+        hashmap_free(e->statistics);
+
         hashmap_free(e->child_sources);
         set_free(e->post_sources);
 
@@ -435,6 +485,9 @@ _public_ int sd_event_new(sd_event** ret) {
                 e->profile_delays = true;
         }
 
+        if (secure_getenv_bool("SD_EVENT_STATISTICS") > 0)
+                e->collect_statistics = true;
+
         *ret = e;
         return 0;
 
@@ -621,6 +674,256 @@ static void source_memory_pressure_remove_from_write_list(sd_event_source *s) {
         s->memory_pressure.in_write_list = false;
 }
 
+#if ENABLE_URING
+static int event_make_io_uring_data(sd_event *e, struct io_uring_data **ret) {
+        _cleanup_(uring_freep) URing *ring = NULL;
+        struct io_uring_data *d;
+        int r;
+
+        assert(e);
+
+        if (e->io_uring) {
+                if (ret)
+                        *ret = e->io_uring;
+                return 0;
+        }
+
+        if (!uring_supported())
+                return log_debug_errno(SYNTHETIC_ERRNO(EOPNOTSUPP),
+                                       "io_uring support is explicitly disabled via $SYSTEMD_EVENT_IO_URING.");
+
+        r = uring_new(IO_URING_ENTRIES, &ring);
+        if (ERRNO_IS_NEG_NOT_SUPPORTED(r) || ERRNO_IS_NEG_PRIVILEGE(r)) {
+                /* io_uring might not be built into the kernel, or might be prohibited by a seccomp filter
+                 * or the kernel.io_uring_disabled sysctl. */
+                log_debug_errno(r, "io_uring is not available: %m");
+                return -EOPNOTSUPP;
+        }
+        if (r < 0)
+                return r;
+
+        d = new(struct io_uring_data, 1);
+        if (!d)
+                return -ENOMEM;
+
+        *d = (struct io_uring_data) {
+                .wakeup = WAKEUP_IO_URING_DATA,
+                .ring = TAKE_PTR(ring),
+        };
+
+        struct epoll_event ev = {
+                .events = EPOLLIN,
+                .data.ptr = d,
+        };
+
+        if (epoll_ctl(e->epoll_fd, EPOLL_CTL_ADD, uring_get_fd(d->ring), &ev) < 0) {
+                r = -errno;
+                free_io_uring_data(d);
+                return r;
+        }
+
+        e->io_uring = d;
+
+        if (ret)
+                *ret = d;
+
+        return 1;
+}
+
+static struct io_uring_sqe* event_io_uring_get_sqe(sd_event *e) {
+        struct io_uring_sqe *sqe;
+        int r;
+
+        assert(e);
+        assert(e->io_uring);
+
+        sqe = uring_get_sqe(e->io_uring->ring);
+        if (sqe)
+                return sqe;
+
+        /* The submission queue is full, flush it out to the kernel before the next event loop iteration */
+        r = uring_submit(e->io_uring->ring);
+        if (r < 0)
+                log_debug_errno(r, "Failed to submit io_uring operations: %m");
+
+        return uring_get_sqe(e->io_uring->ring);
+}
+#endif
+
+static int source_io_uring_submit(sd_event_source *s) {
+#if ENABLE_URING
+        struct io_uring_data *d;
+        struct io_uring_sqe *sqe;
+        int r;
+
+        assert(s);
+        assert(s->type == SOURCE_IO_URING);
+        assert(s->io_uring.token == 0);
+
+        d = ASSERT_PTR(s->event->io_uring);
+
+        s->io_uring.token = ++d->last_token;
+
+        r = hashmap_ensure_put(&d->sources, &uint64_hash_ops, &s->io_uring.token, s);
+        if (r < 0) {
+                s->io_uring.token = 0;
+                return r;
+        }
+
+        sqe = event_io_uring_get_sqe(s->event);
+        if (!sqe) {
+                assert_se(hashmap_remove(d->sources, &s->io_uring.token) == s);
+                s->io_uring.token = 0;
+                return -EBUSY;
+        }
+
+        memcpy(sqe, s->io_uring.sqe, sizeof(struct io_uring_sqe));
+        sqe->user_data = s->io_uring.token;
+
+        return 0;
+#else
+        return -EOPNOTSUPP;
+#endif
+}
+
+static void source_io_uring_cancel(sd_event_source *s) {
+#if ENABLE_URING
+        struct io_uring_data *d;
+        struct io_uring_sqe *sqe;
+
+        assert(s);
+        assert(s->type == SOURCE_IO_URING);
+
+        if (s->io_uring.token == 0)
+                return;
+
+        d = ASSERT_PTR(s->event->io_uring);
+        assert_se(hashmap_remove(d->sources, &s->io_uring.token) == s);
+
+        /* Cancellation is asynchronous, and possibly too late anyway. The completion of the original
+         * operation is simply dropped once it arrives, since its token is not known anymore. The user_data
+         * of 0 is never handed out as token, hence the completion of the cancellation itself is dropped
+         * too. */
+        if (!event_origin_changed(s->event)) {
+                sqe = event_io_uring_get_sqe(s->event);
+                if (sqe) {
+                        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                        sqe->fd = -1;
+                        sqe->addr = s->io_uring.token;
+                        sqe->user_data = 0;
+                } else
+                        log_debug("io_uring submission queue full, not cancelling operation of event source %s.",
+                                  strna(s->description));
+        }
+
+        s->io_uring.token = 0;
+#endif
+}
+
+static int event_submit_io_uring(sd_event *e) {
+#if ENABLE_URING
+        int r;
+
+        assert(e);
+
+        if (!e->io_uring)
+                return 0;
+
+        /* Hand all operations queued during this event loop iteration to the kernel in one go */
+        r = uring_submit(e->io_uring->ring);
+        if (IN_SET(r, -EINTR, -EAGAIN, -EBUSY)) {
+                /* The kernel is short on resources or the completion queue is overflowing, we'll try
+                 * again on the next iteration. */
+                log_debug_errno(r, "Failed to submit io_uring operations, will retry: %m");
+                return 0;
+        }
+        if (r < 0)
+                return r;
+#endif
+
+        return 0;
+}
+
+static int event_make_work_data(sd_event *e, struct work_data **ret) {
+        _cleanup_(work_pool_freep) WorkPool *pool = NULL;
+        struct work_data *d;
+        long n;
+        int r;
+
+        assert(e);
+
+        if (e->work) {
+                if (ret)
+                        *ret = e->work;
+                return 0;
+        }
+
+        /* Work is typically blocking on I/O, hence allow a couple of threads even on a single CPU */
+        n = sysconf(_SC_NPROCESSORS_ONLN);
+        r = work_pool_new(CLAMP(n > 0 ? (size_t) n : 1U, 2U, WORK_THREADS_MAX), &pool);
+        if (r < 0)
+                return r;
+
+        d = new(struct work_data, 1);
+        if (!d)
+                return -ENOMEM;
+
+        *d = (struct work_data) {
+                .wakeup = WAKEUP_WORK_DATA,
+                .pool = TAKE_PTR(pool),
+        };
+
+        struct epoll_event ev = {
+                .events = EPOLLIN,
+                .data.ptr = d,
+        };
+
+        if (epoll_ctl(e->epoll_fd, EPOLL_CTL_ADD, work_pool_get_fd(d->pool), &ev) < 0) {
+                r = -errno;
+                free_work_data(d);
+                return r;
+        }
+
+        e->work = d;
+
+        if (ret)
+                *ret = d;
+
+        return 1;
+}
+
+static int source_work_queue(sd_event_source *s) {
+        int r;
+
+        assert(s);
+        assert(s->type == SOURCE_WORK);
+        assert(!s->work.in_flight);
+
+        /* The work function sees the userdata as of the time the work is queued */
+        s->work.item.userdata = s->userdata;
+
+        r = work_pool_queue(ASSERT_PTR(s->event->work)->pool, &s->work.item);
+        if (r < 0)
+                return r;
+
+        s->work.in_flight = true;
+        return 0;
+}
+
+static void source_work_cancel(sd_event_source *s) {
+        assert(s);
+        assert(s->type == SOURCE_WORK);
+
+        if (!s->work.in_flight)
+                return;
+
+        /* The worker threads don't exist anymore after fork(), hence there's nothing to wait for */
+        if (!event_origin_changed(s->event))
+                work_pool_cancel(ASSERT_PTR(s->event->work)->pool, &s->work.item);
+
+        s->work.in_flight = false;
+}
+
 static clockid_t event_source_type_to_clock(EventSourceType t) {
 
         switch (t) {
@@ -869,6 +1172,74 @@ static void event_gc_signal_data(sd_event *e, const int64_t *priority, int sig)
                 event_unmask_signal_data(e, d, sig);
 }
 
+static bool timer_wheel_enabled(void) {
+        static thread_local int cached = -1;
+        int r;
+
+        if (cached >= 0)
+                return cached;
+
+        r = getenv_bool("SYSTEMD_EVENT_TIMER_WHEEL");
+        if (r < 0 && r != -ENXIO)
+                log_debug_errno(r, "Failed to parse $SYSTEMD_EVENT_TIMER_WHEEL, ignoring: %m");
+
+        return (cached = r != 0);
+}
+
+static bool event_source_timer_wheel_candidate(const sd_event_source *s) {
+        assert(s);
+
+        /* The timer wheel fires timers at the first tick at or after their time, hence it can only be used
+         * for timers whose accuracy is at least one tick. Realtime clocks may jump backwards, which the
+         * wheel cannot deal with, hence leave them to the prioqs. */
+        return IN_SET(s->type, SOURCE_TIME_MONOTONIC, SOURCE_TIME_BOOTTIME) &&
+                s->time.accuracy >= TIMER_WHEEL_TICK_USEC &&
+                timer_wheel_enabled();
+}
+
+/* Ticks are aligned to the perturbation value, so that wakeups are coalesced across the system the same
+ * way sleep_between() does it for the prioq-based timers. */
+static usec_t timer_wheel_offset(const sd_event *e) {
+        assert(e->perturb != USEC_INFINITY);
+        return e->perturb % TIMER_WHEEL_TICK_USEC;
+}
+
+static uint64_t usec_to_timer_wheel_tick(const sd_event *e, usec_t u) {
+        usec_t o = timer_wheel_offset(e);
+
+        /* Rounds up, i.e. returns the first tick at which the timer may elapse */
+        return u <= o ? 0 : DIV_ROUND_UP(u - o, TIMER_WHEEL_TICK_USEC);
+}
+
+static uint64_t usec_to_timer_wheel_tick_floor(const sd_event *e, usec_t u) {
+        usec_t o = timer_wheel_offset(e);
+
+        return u <= o ? 0 : (u - o) / TIMER_WHEEL_TICK_USEC;
+}
+
+static usec_t timer_wheel_tick_to_usec(const sd_event *e, uint64_t tick) {
+        if (tick >= (USEC_INFINITY - timer_wheel_offset(e)) / TIMER_WHEEL_TICK_USEC)
+                return USEC_INFINITY;
+
+        return tick * TIMER_WHEEL_TICK_USEC + timer_wheel_offset(e);
+}
+
+static void event_source_time_wheel_update(sd_event_source *s, struct clock_data *d) {
+        assert(s);
+        assert(s->time.use_wheel);
+        assert(d);
+        assert(d->wheel);
+
+        timer_wheel_remove(d->wheel, &s->time.wheel_node);
+
+        /* Disabled and pending timers need no wakeup, hence are not queued at all, and neither are those
+         * which never elapse. They are queued again once that changes. */
+        if (s->enabled != SD_EVENT_OFF && !s->pending && s->time.next != USEC_INFINITY)
+                timer_wheel_add(d->wheel, &s->time.wheel_node, usec_to_timer_wheel_tick(s->event, s->time.next));
+
+        d->needs_rearm = true;
+}
+
 static void event_source_pp_prioq_reshuffle(sd_event_source *s) {
         assert(s);
 
@@ -893,9 +1264,14 @@ static void event_source_time_prioq_reshuffle(sd_event_source *s) {
 
         if (s->ratelimited)
                 d = &s->event->monotonic;
-        else if (EVENT_SOURCE_IS_TIME(s->type))
+        else if (EVENT_SOURCE_IS_TIME(s->type)) {
                 assert_se(d = event_get_clock_data(s->event, s->type));
-        else
+
+                if (s->time.use_wheel) {
+                        event_source_time_wheel_update(s, d);
+                        return;
+                }
+        } else
                 return; /* no-op for an event source which is neither a timer nor ratelimited. */
 
         prioq_reshuffle(d->earliest, s, &s->earliest_index);
@@ -916,6 +1292,18 @@ static void event_source_time_prioq_remove(
         d->needs_rearm = true;
 }
 
+static void event_source_time_remove(sd_event_source *s, struct clock_data *d) {
+        assert(s);
+        assert(EVENT_SOURCE_IS_TIME(s->type));
+        assert(d);
+
+        if (s->time.use_wheel) {
+                timer_wheel_remove(d->wheel, &s->time.wheel_node);
+                d->needs_rearm = true;
+        } else
+                event_source_time_prioq_remove(s, d);
+}
+
 static void source_disconnect(sd_event_source *s) {
         sd_event *event;
         int r;
@@ -947,7 +1335,7 @@ static void source_disconnect(sd_event_source *s) {
                 if (!s->ratelimited) {
                         struct clock_data *d;
                         assert_se(d = event_get_clock_data(s->event, s->type));
-                        event_source_time_prioq_remove(s, d);
+                        event_source_time_remove(s, d);
                 }
 
                 break;
@@ -1049,6 +1437,14 @@ static void source_disconnect(sd_event_source *s) {
                 source_memory_pressure_unregister(s);
                 break;
 
+        case SOURCE_IO_URING:
+                source_io_uring_cancel(s);
+                break;
+
+        case SOURCE_WORK:
+                source_work_cancel(s);
+                break;
+
         default:
                 assert_not_reached();
         }
@@ -1062,6 +1458,9 @@ static void source_disconnect(sd_event_source *s) {
         if (s->ratelimited)
                 event_source_time_prioq_remove(s, &s->event->monotonic);
 
+        /* Not reachable via the event loop anymore, hence wouldn't be reset when statistics are flushed */
+        s->statistics = NULL;
+
         event = TAKE_PTR(s->event);
         LIST_REMOVE(sources, event->sources, s);
         event->n_sources--;
@@ -1114,6 +1513,9 @@ static sd_event_source* source_free(sd_event_source *s) {
                 s->memory_pressure.write_buffer = mfree(s->memory_pressure.write_buffer);
         }
 
+        if (s->type == SOURCE_IO_URING)
+                s->io_uring.sqe = mfree(s->io_uring.sqe);
+
         if (s->destroy_callback)
                 s->destroy_callback(s->userdata);
 
@@ -1136,6 +1538,8 @@ static int source_set_pending(sd_event_source *s, bool b) {
         if (b) {
                 s->pending_iteration = s->event->iteration;
 
+                s->pending_usec = s->event->collect_statistics ? now(CLOCK_MONOTONIC) : USEC_INFINITY;
+
                 r = prioq_put(s->event->pending, s, &s->pending_index);
                 if (r < 0) {
                         s->pending = false;
@@ -1190,6 +1594,8 @@ static sd_event_source* source_new(sd_event *e, bool floating, EventSourceType t
                 [SOURCE_EXIT]                = endoffsetof_field(sd_event_source, exit),
                 [SOURCE_INOTIFY]             = endoffsetof_field(sd_event_source, inotify),
                 [SOURCE_MEMORY_PRESSURE]     = endoffsetof_field(sd_event_source, memory_pressure),
+                [SOURCE_IO_URING]            = endoffsetof_field(sd_event_source, io_uring),
+                [SOURCE_WORK]                = endoffsetof_field(sd_event_source, work),
         };
 
         sd_event_source *s;
@@ -1214,6 +1620,7 @@ static sd_event_source* source_new(sd_event *e, bool floating, EventSourceType t
         s->type = type;
         s->pending_index = PRIOQ_IDX_NULL;
         s->prepare_index = PRIOQ_IDX_NULL;
+        s->pending_usec = USEC_INFINITY;
 
         if (!floating)
                 sd_event_ref(e);
@@ -1375,6 +1782,35 @@ static int event_source_time_prioq_put(
         return 0;
 }
 
+static int clock_data_ensure_timer_wheel(sd_event *e, struct clock_data *d, clockid_t clock) {
+        assert(e);
+        assert(d);
+
+        if (d->wheel)
+                return 0;
+
+        d->wheel = new(TimerWheel, 1);
+        if (!d->wheel)
+                return -ENOMEM;
+
+        initialize_perturb(e);
+        timer_wheel_init(d->wheel, usec_to_timer_wheel_tick_floor(e, now(clock)));
+
+        return 0;
+}
+
+static int event_source_time_put(sd_event_source *s, struct clock_data *d) {
+        assert(s);
+        assert(EVENT_SOURCE_IS_TIME(s->type));
+
+        if (s->time.use_wheel) {
+                event_source_time_wheel_update(s, d);
+                return 0;
+        }
+
+        return event_source_time_prioq_put(s, d);
+}
+
 _public_ int sd_event_add_time(
                 sd_event *e,
                 sd_event_source **ret,
@@ -1418,11 +1854,20 @@ _public_ int sd_event_add_time(
         s->time.next = usec;
         s->time.accuracy = accuracy == 0 ? DEFAULT_ACCURACY_USEC : accuracy;
         s->time.callback = callback;
+        s->time.wheel_node = TIMER_WHEEL_NODE_NULL;
         s->earliest_index = s->latest_index = PRIOQ_IDX_NULL;
         s->userdata = userdata;
         s->enabled = SD_EVENT_ONESHOT;
 
-        r = event_source_time_prioq_put(s, d);
+        if (event_source_timer_wheel_candidate(s)) {
+                r = clock_data_ensure_timer_wheel(e, d, clock);
+                if (r < 0)
+                        return r;
+
+                s->time.use_wheel = true;
+        }
+
+        r = event_source_time_put(s, d);
         if (r < 0)
                 return r;
 
@@ -1863,7 +2308,8 @@ _public_ int sd_event_trim_memory(void) {
 
         /* A default implementation of a memory pressure callback. Simply releases our own allocation caches
          * and glibc's. This is automatically used when people call sd_event_add_memory_pressure() with a
-         * NULL callback parameter. */
+         * NULL callback parameter. The memory pools may be trimmed from any thread, but tiles cached by other
+         * threads stay where they are until those threads exit. */
 
         log_debug("Memory pressure event, trimming malloc() memory.");
 
@@ -1873,6 +2319,7 @@ _public_ int sd_event_trim_memory(void) {
 
         usec_t before_timestamp = now(CLOCK_MONOTONIC);
         hashmap_trim_pools();
+        bus_message_trim_pools();
         r = malloc_trim(0);
         usec_t after_timestamp = now(CLOCK_MONOTONIC);
 
@@ -2083,27 +2530,119 @@ _public_ int sd_event_add_memory_pressure(
         else
                 return -EBADF;
 
-        s->memory_pressure.fd = TAKE_FD(fd);
-        s->memory_pressure.write_buffer = TAKE_PTR(write_buffer);
-        s->memory_pressure.write_buffer_size = write_buffer_size;
-        s->memory_pressure.events = events;
-        s->memory_pressure.locked = locked;
+        s->memory_pressure.fd = TAKE_FD(fd);
+        s->memory_pressure.write_buffer = TAKE_PTR(write_buffer);
+        s->memory_pressure.write_buffer_size = write_buffer_size;
+        s->memory_pressure.events = events;
+        s->memory_pressure.locked = locked;
+
+        /* So here's the thing: if we are talking to PSI we need to write the watch string before adding the
+         * fd to epoll (if we ignore this, then the watch won't work). Hence we'll not actually register the
+         * fd with the epoll right-away. Instead, we just add the event source to a list of memory pressure
+         * event sources on which writes must be executed before the first event loop iteration is
+         * executed. (We could also write the data here, right away, but we want to give the caller the
+         * freedom to call sd_event_source_set_memory_pressure_type() and
+         * sd_event_source_set_memory_pressure_rate() before we write it. */
+
+        if (s->memory_pressure.write_buffer_size > 0)
+                source_memory_pressure_add_to_write_list(s);
+        else {
+                r = source_memory_pressure_register(s, s->enabled);
+                if (r < 0)
+                        return r;
+        }
+
+        if (ret)
+                *ret = s;
+        TAKE_PTR(s);
+
+        return 0;
+}
+
+_public_ int sd_event_add_io_uring(
+                sd_event *e,
+                sd_event_source **ret,
+                const struct io_uring_sqe *sqe,
+                sd_event_io_uring_handler_t callback,
+                void *userdata) {
+
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(sqe, -EINVAL);
+        assert_return(callback, -EINVAL);
+        assert_return(e->state != SD_EVENT_FINISHED, -ESTALE);
+        assert_return(!event_origin_changed(e), -ECHILD);
+
+#if ENABLE_URING
+        _cleanup_(source_freep) sd_event_source *s = NULL;
+        int r;
+
+        r = event_make_io_uring_data(e, NULL);
+        if (r < 0)
+                return r;
+
+        s = source_new(e, !ret, SOURCE_IO_URING);
+        if (!s)
+                return -ENOMEM;
+
+        s->io_uring.sqe = memdup(sqe, sizeof(struct io_uring_sqe));
+        if (!s->io_uring.sqe)
+                return -ENOMEM;
+
+        s->io_uring.user_data = sqe->user_data;
+        s->io_uring.callback = callback;
+        s->userdata = userdata;
+        s->enabled = SD_EVENT_ONESHOT;
+
+        /* The operation is only queued here, it is handed to the kernel when the next event loop iteration
+         * is prepared, together with everything else queued in the meantime. */
+        r = source_io_uring_submit(s);
+        if (r < 0)
+                return r;
+
+        if (ret)
+                *ret = s;
+        TAKE_PTR(s);
+
+        return 0;
+#else
+        return -EOPNOTSUPP;
+#endif
+}
+
+_public_ int sd_event_add_work(
+                sd_event *e,
+                sd_event_source **ret,
+                sd_event_work_func_t work,
+                sd_event_work_handler_t callback,
+                void *userdata) {
+
+        _cleanup_(source_freep) sd_event_source *s = NULL;
+        int r;
+
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(work, -EINVAL);
+        assert_return(callback, -EINVAL);
+        assert_return(e->state != SD_EVENT_FINISHED, -ESTALE);
+        assert_return(!event_origin_changed(e), -ECHILD);
+
+        r = event_make_work_data(e, NULL);
+        if (r < 0)
+                return r;
+
+        s = source_new(e, !ret, SOURCE_WORK);
+        if (!s)
+                return -ENOMEM;
 
-        /* So here's the thing: if we are talking to PSI we need to write the watch string before adding the
-         * fd to epoll (if we ignore this, then the watch won't work). Hence we'll not actually register the
-         * fd with the epoll right-away. Instead, we just add the event source to a list of memory pressure
-         * event sources on which writes must be executed before the first event loop iteration is
-         * executed. (We could also write the data here, right away, but we want to give the caller the
-         * freedom to call sd_event_source_set_memory_pressure_type() and
-         * sd_event_source_set_memory_pressure_rate() before we write it. */
+        s->work.item.func = work;
+        s->work.callback = callback;
+        s->userdata = userdata;
+        s->enabled = SD_EVENT_ONESHOT;
 
-        if (s->memory_pressure.write_buffer_size > 0)
-                source_memory_pressure_add_to_write_list(s);
-        else {
-                r = source_memory_pressure_register(s, s->enabled);
-                if (r < 0)
-                        return r;
-        }
+        r = source_work_queue(s);
+        if (r < 0)
+                return r;
 
         if (ret)
                 *ret = s;
@@ -2593,6 +3132,9 @@ _public_ int sd_event_source_set_description(sd_event_source *s, const char *des
         assert_return(s, -EINVAL);
         assert_return(!event_origin_changed(s->event), -ECHILD);
 
+        /* Account the event source under its new name from now on */
+        s->statistics = NULL;
+
         return free_and_strdup(&s->description, description);
 }
 
@@ -2926,6 +3468,14 @@ static int event_source_offline(
                 source_memory_pressure_unregister(s);
                 break;
 
+        case SOURCE_IO_URING:
+                source_io_uring_cancel(s);
+                break;
+
+        case SOURCE_WORK:
+                source_work_cancel(s);
+                break;
+
         case SOURCE_TIME_REALTIME:
         case SOURCE_TIME_BOOTTIME:
         case SOURCE_TIME_MONOTONIC:
@@ -3020,6 +3570,24 @@ static int event_source_online(
 
                 break;
 
+        case SOURCE_IO_URING:
+                if (s->io_uring.token == 0) {
+                        r = source_io_uring_submit(s);
+                        if (r < 0)
+                                return r;
+                }
+
+                break;
+
+        case SOURCE_WORK:
+                if (!s->work.in_flight) {
+                        r = source_work_queue(s);
+                        if (r < 0)
+                                return r;
+                }
+
+                break;
+
         case SOURCE_TIME_REALTIME:
         case SOURCE_TIME_BOOTTIME:
         case SOURCE_TIME_MONOTONIC:
@@ -3147,6 +3715,8 @@ _public_ int sd_event_source_get_time_accuracy(sd_event_source *s, uint64_t *ret
 }
 
 _public_ int sd_event_source_set_time_accuracy(sd_event_source *s, uint64_t usec) {
+        usec_t old_accuracy;
+        bool use_wheel;
         int r;
 
         assert_return(s, -EINVAL);
@@ -3162,8 +3732,45 @@ _public_ int sd_event_source_set_time_accuracy(sd_event_source *s, uint64_t usec
         if (usec == 0)
                 usec = DEFAULT_ACCURACY_USEC;
 
+        old_accuracy = s->time.accuracy;
         s->time.accuracy = usec;
 
+        use_wheel = event_source_timer_wheel_candidate(s);
+        if (use_wheel != s->time.use_wheel) {
+                struct clock_data *d;
+
+                /* The accuracy changed enough to move the event source from the timer wheel to the prioqs
+                 * or vice versa. While ratelimited the event source is in neither, and will be put into the
+                 * right one when leaving the ratelimit state. */
+                assert_se(d = event_get_clock_data(s->event, s->type));
+
+                if (use_wheel) {
+                        r = clock_data_ensure_timer_wheel(s->event, d, event_source_type_to_clock(s->type));
+                        if (r < 0) {
+                                s->time.accuracy = old_accuracy;
+                                return r;
+                        }
+                }
+
+                if (!s->ratelimited)
+                        event_source_time_remove(s, d);
+
+                s->time.use_wheel = use_wheel;
+
+                if (!s->ratelimited) {
+                        r = event_source_time_put(s, d);
+                        if (r < 0) {
+                                /* Putting the event source back into the timer wheel cannot fail */
+                                s->time.accuracy = old_accuracy;
+                                s->time.use_wheel = true;
+                                assert_se(event_source_time_put(s, d) >= 0);
+                                return r;
+                        }
+                }
+
+                return 0;
+        }
+
         event_source_time_prioq_reshuffle(s);
         return 0;
 }
@@ -3349,7 +3956,7 @@ static int event_source_enter_ratelimited(sd_event_source *s) {
          * first remove them from the prioq appropriate for their own clock, so that we can use the prioq
          * fields of the event source then for adding it to the CLOCK_MONOTONIC prioq instead. */
         if (EVENT_SOURCE_IS_TIME(s->type))
-                event_source_time_prioq_remove(s, event_get_clock_data(s->event, s->type));
+                event_source_time_remove(s, event_get_clock_data(s->event, s->type));
 
         /* Now, let's add the event source to the monotonic clock instead */
         r = event_source_time_prioq_put(s, &s->event->monotonic);
@@ -3372,7 +3979,7 @@ fail:
         /* Reinstall time event sources in the priority queue as before. This shouldn't fail, since the queue
          * space for it should already be allocated. */
         if (EVENT_SOURCE_IS_TIME(s->type))
-                assert_se(event_source_time_prioq_put(s, event_get_clock_data(s->event, s->type)) >= 0);
+                assert_se(event_source_time_put(s, event_get_clock_data(s->event, s->type)) >= 0);
 
         return r;
 }
@@ -3390,7 +3997,7 @@ static int event_source_leave_ratelimit(sd_event_source *s, bool run_callback) {
 
         /* Let's then add the event source to its native clock prioq again — if this is a timer event source */
         if (EVENT_SOURCE_IS_TIME(s->type)) {
-                r = event_source_time_prioq_put(s, event_get_clock_data(s->event, s->type));
+                r = event_source_time_put(s, event_get_clock_data(s->event, s->type));
                 if (r < 0)
                         goto fail;
         }
@@ -3400,7 +4007,7 @@ static int event_source_leave_ratelimit(sd_event_source *s, bool run_callback) {
         if (r < 0) {
                 /* Do something roughly sensible when this failed: undo the two prioq ops above */
                 if (EVENT_SOURCE_IS_TIME(s->type))
-                        event_source_time_prioq_remove(s, event_get_clock_data(s->event, s->type));
+                        event_source_time_remove(s, event_get_clock_data(s->event, s->type));
 
                 goto fail;
         }
@@ -3529,7 +4136,7 @@ static int event_arm_timer(
 
         struct itimerspec its = {};
         sd_event_source *a, *b;
-        usec_t t;
+        usec_t t, w = USEC_INFINITY;
 
         assert(e);
         assert(d);
@@ -3539,9 +4146,29 @@ static int event_arm_timer(
 
         d->needs_rearm = false;
 
+        /* The timer wheel wants to be woken up exactly at the next tick anything elapses */
+        if (d->wheel) {
+                uint64_t tick = timer_wheel_next(d->wheel);
+
+                if (tick != UINT64_MAX)
+                        w = timer_wheel_tick_to_usec(e, tick);
+        }
+
         a = prioq_peek(d->earliest);
         assert(!a || EVENT_SOURCE_USES_TIME_PRIOQ(a->type));
-        if (!a || a->enabled == SD_EVENT_OFF || time_event_source_next(a) == USEC_INFINITY) {
+        if (!a || a->enabled == SD_EVENT_OFF || time_event_source_next(a) == USEC_INFINITY)
+                a = NULL;
+
+        if (a) {
+                b = prioq_peek(d->latest);
+                assert(!b || EVENT_SOURCE_USES_TIME_PRIOQ(b->type));
+                assert(b && b->enabled != SD_EVENT_OFF);
+
+                t = sleep_between(e, MIN(time_event_source_next(a), w), MIN(time_event_source_latest(b), w));
+        } else
+                t = w;
+
+        if (t == USEC_INFINITY) {
 
                 if (d->fd < 0)
                         return 0;
@@ -3557,11 +4184,6 @@ static int event_arm_timer(
                 return 0;
         }
 
-        b = prioq_peek(d->latest);
-        assert(!b || EVENT_SOURCE_USES_TIME_PRIOQ(b->type));
-        assert(b && b->enabled != SD_EVENT_OFF);
-
-        t = sleep_between(e, time_event_source_next(a), time_event_source_latest(b));
         if (d->next == t)
                 return 0;
 
@@ -3669,6 +4291,24 @@ static int process_timer(
                 event_source_time_prioq_reshuffle(s);
         }
 
+        if (d->wheel) {
+                uint64_t tick = usec_to_timer_wheel_tick_floor(e, n);
+                TimerWheelNode *node;
+
+                while ((node = timer_wheel_pop(d->wheel, tick))) {
+                        s = container_of(node, sd_event_source, time.wheel_node);
+                        assert(s->time.use_wheel);
+                        assert(s->enabled != SD_EVENT_OFF && !s->pending);
+
+                        r = source_set_pending(s, true);
+                        if (r < 0) {
+                                /* Requeue it so that we try again on the next iteration */
+                                event_source_time_wheel_update(s, d);
+                                return r;
+                        }
+                }
+        }
+
         return callback_invoked;
 }
 
@@ -4107,7 +4747,120 @@ static int source_memory_pressure_initiate_dispatch(sd_event_source *s) {
         return 0; /* go on, dispatch to user callback */
 }
 
+typedef struct EventSourceStatistics {
+        char *key; /* "<type>:<description>" */
+        EventSourceType type;
+        char *description;
+
+        uint64_t n_dispatched;
+        usec_t callback_usec, callback_max_usec;
+        usec_t queue_usec, queue_max_usec;
+
+        /* Logarithmic histograms, i.e. entry n counts durations in the range [2^n, 2^(n+1)) µs */
+        uint64_t callback_histogram[sizeof(usec_t) * 8];
+        uint64_t queue_histogram[sizeof(usec_t) * 8];
+} EventSourceStatistics;
+
+static EventSourceStatistics* event_source_statistics_free(EventSourceStatistics *st) {
+        if (!st)
+                return NULL;
+
+        free(st->key);
+        free(st->description);
+        return mfree(st);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(EventSourceStatistics*, event_source_statistics_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(
+                event_source_statistics_hash_ops,
+                char, string_hash_func, string_compare_func,
+                EventSourceStatistics, event_source_statistics_free);
+
+static EventSourceStatistics* event_source_get_statistics(sd_event_source *s) {
+        _cleanup_(event_source_statistics_freep) EventSourceStatistics *st = NULL;
+        _cleanup_free_ char *key = NULL;
+        int r;
+
+        assert(s);
+        assert(s->event);
+
+        /* Statistics are kept per description (and type), so that they survive event sources that come and
+         * go, and so that event sources doing the same thing are accounted together. */
+
+        if (s->statistics)
+                return s->statistics;
+
+        key = strjoin(event_source_type_to_string(s->type), ":", strempty(s->description));
+        if (!key)
+                return NULL;
+
+        s->statistics = hashmap_get(s->event->statistics, key);
+        if (s->statistics)
+                return s->statistics;
+
+        st = new(EventSourceStatistics, 1);
+        if (!st)
+                return NULL;
+
+        *st = (EventSourceStatistics) {
+                .key = TAKE_PTR(key),
+                .type = s->type,
+        };
+
+        if (s->description) {
+                st->description = strdup(s->description);
+                if (!st->description)
+                        return NULL;
+        }
+
+        r = hashmap_ensure_put(&s->event->statistics, &event_source_statistics_hash_ops, st->key, st);
+        if (r < 0)
+                return NULL;
+
+        return (s->statistics = TAKE_PTR(st));
+}
+
+static void event_source_statistics_account(
+                EventSourceStatistics *st,
+                usec_t queued,
+                usec_t begin,
+                usec_t end) {
+
+        usec_t d;
+
+        assert(st);
+
+        st->n_dispatched++;
+
+        d = usec_sub_unsigned(end, begin);
+        st->callback_usec = usec_add(st->callback_usec, d);
+        st->callback_max_usec = MAX(st->callback_max_usec, d);
+        st->callback_histogram[log2u64(d)]++;
+
+        if (queued == USEC_INFINITY)
+                return;
+
+        d = usec_sub_unsigned(begin, queued);
+        st->queue_usec = usec_add(st->queue_usec, d);
+        st->queue_max_usec = MAX(st->queue_max_usec, d);
+        st->queue_histogram[log2u64(d)]++;
+}
+
+static void event_flush_statistics(sd_event *e) {
+        assert(e);
+
+        LIST_FOREACH(sources, s, e->sources)
+                s->statistics = NULL;
+
+        e->statistics = hashmap_free(e->statistics);
+        e->statistics_generation++;
+}
+
 static int source_dispatch(sd_event_source *s) {
+        EventSourceStatistics *st = NULL;
+        uint64_t statistics_generation = 0;
+        usec_t begin = USEC_INFINITY;
         EventSourceType saved_type;
         sd_event *saved_event;
         int r = 0;
@@ -4171,6 +4924,14 @@ static int source_dispatch(sd_event_source *s) {
                         return r;
         }
 
+        if (saved_event->collect_statistics) {
+                st = event_source_get_statistics(s);
+                if (st) {
+                        statistics_generation = saved_event->statistics_generation;
+                        begin = now(CLOCK_MONOTONIC);
+                }
+        }
+
         s->dispatching = true;
 
         switch (s->type) {
@@ -4253,6 +5014,36 @@ static int source_dispatch(sd_event_source *s) {
                 r = s->memory_pressure.callback(s, s->userdata);
                 break;
 
+        case SOURCE_IO_URING: {
+#if ENABLE_URING
+                struct io_uring_cqe cqe = {
+                        .user_data = s->io_uring.user_data,
+                        .res = s->io_uring.res,
+                        .flags = s->io_uring.flags,
+                };
+
+                r = s->io_uring.callback(s, &cqe, s->userdata);
+
+                /* Resubmit the operation if the event source is enabled continuously, unless the callback
+                 * did something about it already. */
+                if (r >= 0 && s->n_ref > 0 && s->event && s->enabled == SD_EVENT_ON &&
+                    !s->ratelimited && s->io_uring.token == 0)
+                        r = source_io_uring_submit(s);
+#else
+                assert_not_reached();
+#endif
+                break;
+        }
+
+        case SOURCE_WORK:
+                r = s->work.callback(s, s->work.item.result, s->userdata);
+
+                /* Queue the work again if the event source is enabled continuously, unless the callback
+                 * did something about it already. */
+                if (r >= 0 && s->n_ref > 0 && s->event && s->enabled == SD_EVENT_ON && !s->work.in_flight)
+                        r = source_work_queue(s);
+                break;
+
         case SOURCE_WATCHDOG:
         case _SOURCE_EVENT_SOURCE_TYPE_MAX:
         case _SOURCE_EVENT_SOURCE_TYPE_INVALID:
@@ -4261,6 +5052,21 @@ static int source_dispatch(sd_event_source *s) {
 
         s->dispatching = false;
 
+        /* The callback might have turned statistics off (and maybe on again), which frees all collected
+         * statistics, including the object we looked up above. Don't touch it in that case. */
+        if (st && saved_event->statistics_generation != statistics_generation)
+                st = NULL;
+
+        if (st) {
+                usec_t end = now(CLOCK_MONOTONIC);
+
+                event_source_statistics_account(st, s->pending_usec, begin, end);
+
+                /* Defer sources remain pending, measure their next queueing delay from here */
+                if (s->pending)
+                        s->pending_usec = end;
+        }
+
 finish:
         if (r < 0) {
                 log_debug_errno(r, "Event source %s (type %s) returned error, %s: %m",
@@ -4468,6 +5274,10 @@ _public_ int sd_event_prepare(sd_event *e) {
         if (r < 0)
                 return r;
 
+        r = event_submit_io_uring(e);
+        if (r < 0)
+                return r;
+
         r = event_arm_timer(e, &e->realtime);
         if (r < 0)
                 return r;
@@ -4557,6 +5367,80 @@ static int epoll_wait_usec(
         return RET_NERRNO(epoll_wait(fd, events, maxevents, msec));
 }
 
+static int process_io_uring(sd_event *e, struct io_uring_data *d, int64_t *min_priority) {
+        bool something_new = false;
+
+        assert(e);
+        assert(d);
+        assert(min_priority);
+
+#if ENABLE_URING
+        struct io_uring_cqe cqe;
+        int r;
+
+        while (uring_pop_cqe(d->ring, &cqe)) {
+                sd_event_source *s;
+
+                s = hashmap_get(d->sources, &(uint64_t) { cqe.user_data });
+                if (!s)
+                        continue; /* A cancelled operation, or a cancellation request */
+
+                if (!FLAGS_SET(cqe.flags, IORING_CQE_F_MORE)) {
+                        assert_se(hashmap_remove(d->sources, &s->io_uring.token) == s);
+                        s->io_uring.token = 0;
+                }
+
+                s->io_uring.res = cqe.res;
+                s->io_uring.flags = cqe.flags;
+
+                r = source_set_pending(s, true);
+                if (r < 0)
+                        return r;
+
+                if (s->priority < *min_priority)
+                        *min_priority = s->priority;
+
+                something_new = true;
+        }
+#endif
+
+        return something_new;
+}
+
+static int process_work(sd_event *e, struct work_data *d, int64_t *min_priority) {
+        bool something_new = false;
+        WorkItem *i;
+        int r;
+
+        assert(e);
+        assert(d);
+        assert(min_priority);
+
+        work_pool_flush_fd(d->pool);
+
+        while ((i = work_pool_pop_finished(d->pool))) {
+                sd_event_source *s = container_of(i, sd_event_source, work.item);
+
+                assert(s->type == SOURCE_WORK);
+                assert(s->work.in_flight);
+
+                /* Disabling the event source cancels the work, hence anything that finished is for an
+                 * enabled event source */
+                s->work.in_flight = false;
+
+                r = source_set_pending(s, true);
+                if (r < 0)
+                        return r;
+
+                if (s->priority < *min_priority)
+                        *min_priority = s->priority;
+
+                something_new = true;
+        }
+
+        return something_new;
+}
+
 static int process_epoll(sd_event *e, usec_t timeout, int64_t threshold, int64_t *ret_min_priority) {
         size_t n_event_queue, m, n_event_max;
         int64_t min_priority = threshold;
@@ -4661,6 +5545,14 @@ static int process_epoll(sd_event *e, usec_t timeout, int64_t threshold, int64_t
                                 r = event_inotify_data_read(e, e->event_queue[i].data.ptr, e->event_queue[i].events, threshold);
                                 break;
 
+                        case WAKEUP_IO_URING_DATA:
+                                r = process_io_uring(e, e->event_queue[i].data.ptr, &min_priority);
+                                break;
+
+                        case WAKEUP_WORK_DATA:
+                                r = process_work(e, e->event_queue[i].data.ptr, &min_priority);
+                                break;
+
                         default:
                                 assert_not_reached();
                         }
@@ -5051,6 +5943,96 @@ _public_ int sd_event_get_iteration(sd_event *e, uint64_t *ret) {
         return 0;
 }
 
+_public_ int sd_event_set_statistics(sd_event *e, int b) {
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(!event_origin_changed(e), -ECHILD);
+
+        if (!!b == e->collect_statistics)
+                return 0;
+
+        /* Disabling resets the counters, so that they can be collected afresh later on */
+        if (!b)
+                event_flush_statistics(e);
+
+        e->collect_statistics = b;
+        return 1;
+}
+
+static int histogram_build_json(const uint64_t histogram[static sizeof(usec_t) * 8], sd_json_variant **ret) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        size_t n = sizeof(usec_t) * 8;
+        int r;
+
+        assert(ret);
+
+        /* Drop trailing empty buckets, they are implied */
+        while (n > 0 && histogram[n-1] == 0)
+                n--;
+
+        for (size_t i = 0; i < n; i++) {
+                r = sd_json_variant_append_arrayb(&v, SD_JSON_BUILD_UNSIGNED(histogram[i]));
+                if (r < 0)
+                        return r;
+        }
+
+        if (!v)
+                return sd_json_variant_new_array(ret, NULL, 0);
+
+        *ret = TAKE_PTR(v);
+        return 0;
+}
+
+_public_ int sd_event_get_statistics(sd_event *e, sd_json_variant **ret) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *array = NULL;
+        _cleanup_free_ EventSourceStatistics **sorted = NULL;
+        size_t n = 0;
+        int r;
+
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(!event_origin_changed(e), -ECHILD);
+        assert_return(ret, -EINVAL);
+
+        r = hashmap_dump_sorted(e->statistics, (void***) &sorted, &n);
+        if (r < 0)
+                return r;
+
+        FOREACH_ARRAY(i, sorted, n) {
+                _cleanup_(sd_json_variant_unrefp) sd_json_variant *ch = NULL, *qh = NULL;
+                EventSourceStatistics *st = *i;
+
+                r = histogram_build_json(st->callback_histogram, &ch);
+                if (r < 0)
+                        return r;
+
+                r = histogram_build_json(st->queue_histogram, &qh);
+                if (r < 0)
+                        return r;
+
+                r = sd_json_variant_append_arraybo(
+                                &array,
+                                SD_JSON_BUILD_PAIR_STRING("type", event_source_type_to_string(st->type)),
+                                SD_JSON_BUILD_PAIR_CONDITION(!!st->description, "description", SD_JSON_BUILD_STRING(st->description)),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("dispatched", st->n_dispatched),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("callbackUSec", st->callback_usec),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("callbackMaxUSec", st->callback_max_usec),
+                                SD_JSON_BUILD_PAIR_VARIANT("callbackHistogram", ch),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("queueDelayUSec", st->queue_usec),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("queueDelayMaxUSec", st->queue_max_usec),
+                                SD_JSON_BUILD_PAIR_VARIANT("queueDelayHistogram", qh));
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_json_buildo(
+                        ret,
+                        SD_JSON_BUILD_PAIR_BOOLEAN("enabled", e->collect_statistics),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("iteration", e->iteration),
+                        SD_JSON_BUILD_PAIR_CONDITION(!!array, "sources", SD_JSON_BUILD_VARIANT(array)),
+                        SD_JSON_BUILD_PAIR_CONDITION(!array, "sources", SD_JSON_BUILD_EMPTY_ARRAY));
+}
+
 _public_ int sd_event_source_set_destroy_callback(sd_event_source *s, sd_event_destroy_t callback) {
         assert_return(s, -EINVAL);
         assert_return(s->event, -EINVAL);
@@ -5346,3 +6328,20 @@ _public_ int sd_event_source_set_memory_pressure_period(sd_event_source *s, uint
 
         return 1;
 }
+
+_public_ int sd_event_source_set_io_uring_sqe(sd_event_source *s, const struct io_uring_sqe *sqe) {
+        assert_return(s, -EINVAL);
+        assert_return(sqe, -EINVAL);
+        assert_return(s->type == SOURCE_IO_URING, -EDOM);
+        assert_return(!event_origin_changed(s->event), -ECHILD);
+
+#if ENABLE_URING
+        /* This only affects the next submission, an operation that is already in flight is left alone. */
+        memcpy(s->io_uring.sqe, sqe, sizeof(struct io_uring_sqe));
+        s->io_uring.user_data = sqe->user_data;
+
+        return 0;
+#else
+        assert_not_reached();
+#endif
+}
@@ -7,8 +7,10 @@
 #include <unistd.h>
 
 #include "sd-event.h"
+#include "sd-json.h"
 
 #include "alloc-util.h"
+#include "event-uring.h"
 #include "exec-util.h"
 #include "fd-util.h"
 #include "fs-util.h"
@@ -918,4 +920,270 @@ TEST(leave_ratelimit) {
         assert_se(manually_left_ratelimit);
 }
 
+#if ENABLE_URING
+static int io_uring_read_handler(sd_event_source *s, const struct io_uring_cqe *cqe, void *userdata) {
+        unsigned *c = ASSERT_PTR(userdata);
+
+        ASSERT_EQ(cqe->user_data, UINT64_C(4711));
+        ASSERT_EQ(cqe->res, 1);
+
+        if (++(*c) >= 3)
+                return sd_event_exit(sd_event_source_get_event(s), 0);
+
+        return 0;
+}
+
+static int io_uring_nop_handler(sd_event_source *s, const struct io_uring_cqe *cqe, void *userdata) {
+        ASSERT_EQ(cqe->res, 0);
+
+        (*(unsigned*) userdata)++;
+        return 0;
+}
+#endif
+
+static int timer_wheel_handler(sd_event_source *s, uint64_t usec, void *userdata) {
+        unsigned *c = ASSERT_PTR(userdata);
+        uint64_t accuracy, n;
+
+        ASSERT_OK(sd_event_now(sd_event_source_get_event(s), CLOCK_MONOTONIC, &n));
+        ASSERT_OK(sd_event_source_get_time_accuracy(s, &accuracy));
+
+        /* Never early, and never later than the accuracy permits (modulo scheduling latencies) */
+        ASSERT_GE(n, usec);
+        ASSERT_LE(n, usec + accuracy + USEC_PER_SEC);
+
+        if (--(*c) == 0)
+                return sd_event_exit(sd_event_source_get_event(s), 0);
+
+        return 0;
+}
+
+TEST(timer_wheel) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        sd_event_source *s[20], *disabled;
+        unsigned c = ELEMENTSOF(s);
+        usec_t n;
+
+        ASSERT_OK(sd_event_new(&e));
+        ASSERT_OK(sd_event_now(e, CLOCK_MONOTONIC, &n));
+
+        /* Coarse timers, of which some are moved to the prioq and back by changing their accuracy */
+        for (unsigned i = 0; i < ELEMENTSOF(s); i++) {
+                ASSERT_OK(sd_event_add_time(e, s + i, CLOCK_MONOTONIC, n + random_u64_range(USEC_PER_SEC), 0, timer_wheel_handler, &c));
+                ASSERT_OK(sd_event_source_set_floating(s[i], true));
+
+                if (i % 3 == 0)
+                        ASSERT_OK(sd_event_source_set_time_accuracy(s[i], 1));
+                if (i % 6 == 0)
+                        ASSERT_OK(sd_event_source_set_time_accuracy(s[i], USEC_PER_SEC));
+        }
+
+        /* Rescheduling a timer moves it within the wheel, disabling one removes it */
+        ASSERT_OK(sd_event_source_set_time(s[1], n + 2 * USEC_PER_SEC));
+        ASSERT_OK(sd_event_add_time(e, &disabled, CLOCK_MONOTONIC, n, 0, timer_wheel_handler, &c));
+        ASSERT_OK(sd_event_source_set_enabled(disabled, SD_EVENT_OFF));
+
+        ASSERT_OK(sd_event_loop(e));
+        ASSERT_EQ(c, 0U);
+
+        ASSERT_NULL(sd_event_source_unref(disabled));
+}
+
+TEST(io_uring) {
+#if ENABLE_URING
+        _cleanup_(sd_event_source_unrefp) sd_event_source *r = NULL, *n = NULL;
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        _cleanup_close_pair_ int pfd[2] = EBADF_PAIR;
+        unsigned c = 0, d = 0;
+        char buf;
+        int k;
+
+        ASSERT_OK(sd_event_new(&e));
+        ASSERT_OK_ERRNO(pipe2(pfd, O_CLOEXEC));
+
+        k = sd_event_add_io_uring(e, &n, &(struct io_uring_sqe) { .opcode = IORING_OP_NOP }, io_uring_nop_handler, &d);
+        if (k == -EOPNOTSUPP)
+                return (void) log_tests_skipped("io_uring not available");
+        ASSERT_OK(k);
+
+        /* The NOP is one-shot, and hence only dispatched once */
+        ASSERT_OK_POSITIVE(sd_event_run(e, UINT64_MAX));
+        ASSERT_EQ(d, 1U);
+        ASSERT_OK_EQ(sd_event_source_get_enabled(n, NULL), SD_EVENT_OFF);
+
+        ASSERT_OK(sd_event_add_io_uring(e, &r,
+                                        &(struct io_uring_sqe) {
+                                                .opcode = IORING_OP_READ,
+                                                .fd = pfd[0],
+                                                .addr = PTR_TO_UINT64(&buf),
+                                                .len = 1,
+                                                .off = UINT64_MAX,
+                                                .user_data = 4711,
+                                        },
+                                        io_uring_read_handler, &c));
+        ASSERT_OK(sd_event_source_set_enabled(r, SD_EVENT_ON));
+
+        /* Enabled continuously, the read is resubmitted after each completion is dispatched */
+        ASSERT_OK_EQ_ERRNO(write(pfd[1], "abc", 3), (ssize_t) 3);
+        ASSERT_OK(sd_event_loop(e));
+        ASSERT_EQ(c, 3U);
+
+        /* Disabling cancels the operation in flight, its completion must never be dispatched */
+        ASSERT_OK(sd_event_source_set_enabled(r, SD_EVENT_OFF));
+        ASSERT_OK_EQ_ERRNO(write(pfd[1], "d", 1), (ssize_t) 1);
+        ASSERT_OK(sd_event_run(e, 100 * USEC_PER_MSEC));
+        ASSERT_EQ(c, 3U);
+#else
+        log_tests_skipped("io_uring support not compiled in");
+#endif
+}
+
+static int statistics_handler(sd_event_source *s, void *userdata) {
+        unsigned *c = ASSERT_PTR(userdata);
+
+        if (++(*c) >= 3)
+                return sd_event_source_set_enabled(s, SD_EVENT_OFF);
+
+        return 0;
+}
+
+TEST(statistics) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL;
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        sd_json_variant *sources, *i;
+        unsigned c = 0;
+
+        ASSERT_OK(sd_event_new(&e));
+
+        ASSERT_OK(sd_event_add_defer(e, &s, statistics_handler, &c));
+        ASSERT_OK(sd_event_source_set_description(s, "counted"));
+        ASSERT_OK(sd_event_source_set_enabled(s, SD_EVENT_ON));
+
+        /* Nothing is collected unless asked for */
+        ASSERT_OK_POSITIVE(sd_event_run(e, 0));
+        ASSERT_OK(sd_event_get_statistics(e, &v));
+        ASSERT_FALSE(sd_json_variant_boolean(sd_json_variant_by_key(v, "enabled")));
+        ASSERT_EQ(sd_json_variant_elements(sd_json_variant_by_key(v, "sources")), 0U);
+        v = sd_json_variant_unref(v);
+
+        ASSERT_OK_POSITIVE(sd_event_set_statistics(e, true));
+        ASSERT_OK_ZERO(sd_event_set_statistics(e, true));
+        ASSERT_OK_POSITIVE(sd_event_run(e, 0));
+        ASSERT_OK_POSITIVE(sd_event_run(e, 0));
+        ASSERT_EQ(c, 3U);
+
+        ASSERT_OK(sd_event_get_statistics(e, &v));
+        sd_json_variant_dump(v, SD_JSON_FORMAT_PRETTY_AUTO|SD_JSON_FORMAT_COLOR_AUTO, NULL, NULL);
+
+        ASSERT_TRUE(sd_json_variant_boolean(sd_json_variant_by_key(v, "enabled")));
+        ASSERT_NOT_NULL(sources = sd_json_variant_by_key(v, "sources"));
+        ASSERT_EQ(sd_json_variant_elements(sources), 1U);
+        ASSERT_NOT_NULL(i = sd_json_variant_by_index(sources, 0));
+        ASSERT_STREQ(sd_json_variant_string(sd_json_variant_by_key(i, "type")), "defer");
+        ASSERT_STREQ(sd_json_variant_string(sd_json_variant_by_key(i, "description")), "counted");
+        ASSERT_EQ(sd_json_variant_unsigned(sd_json_variant_by_key(i, "dispatched")), 2U);
+        ASSERT_GE(sd_json_variant_unsigned(sd_json_variant_by_key(i, "callbackUSec")),
+                  sd_json_variant_unsigned(sd_json_variant_by_key(i, "callbackMaxUSec")));
+        ASSERT_GT(sd_json_variant_elements(sd_json_variant_by_key(i, "callbackHistogram")), 0U);
+        v = sd_json_variant_unref(v);
+
+        /* Turning collection off again resets the counters */
+        ASSERT_OK_POSITIVE(sd_event_set_statistics(e, false));
+        ASSERT_OK(sd_event_get_statistics(e, &v));
+        ASSERT_EQ(sd_json_variant_elements(sd_json_variant_by_key(v, "sources")), 0U);
+}
+
+static int statistics_toggle_handler(sd_event_source *s, void *userdata) {
+        sd_event *e = sd_event_source_get_event(s);
+
+        /* Flushes the statistics of the source being dispatched, and starts collecting afresh */
+        ASSERT_OK_POSITIVE(sd_event_set_statistics(e, false));
+        ASSERT_OK_POSITIVE(sd_event_set_statistics(e, true));
+
+        return sd_event_source_set_enabled(s, SD_EVENT_OFF);
+}
+
+TEST(statistics_toggle_in_callback) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL;
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+
+        ASSERT_OK(sd_event_new(&e));
+        ASSERT_OK_POSITIVE(sd_event_set_statistics(e, true));
+
+        ASSERT_OK(sd_event_add_defer(e, &s, statistics_toggle_handler, NULL));
+        ASSERT_OK_POSITIVE(sd_event_run(e, 0));
+
+        /* The dispatch that flushed the statistics is not accounted anywhere */
+        ASSERT_OK(sd_event_get_statistics(e, &v));
+        ASSERT_EQ(sd_json_variant_elements(sd_json_variant_by_key(v, "sources")), 0U);
+}
+
+static int work_func(void *userdata) {
+        unsigned *n = ASSERT_PTR(userdata);
+
+        /* The event loop thread doesn't touch the counter while the work is in flight */
+        return (int) ++(*n);
+}
+
+static int work_handler(sd_event_source *s, int result, void *userdata) {
+        unsigned *n = ASSERT_PTR(userdata);
+
+        ASSERT_EQ(result, (int) *n);
+
+        if (*n >= 3) {
+                ASSERT_OK(sd_event_source_set_enabled(s, SD_EVENT_OFF));
+                return sd_event_exit(sd_event_source_get_event(s), 0);
+        }
+
+        return 0;
+}
+
+static int work_sleep_func(void *userdata) {
+        bool *running = ASSERT_PTR(userdata);
+
+        *running = true;
+        usleep_safe(50 * USEC_PER_MSEC);
+        *running = false;
+
+        return -EIO;
+}
+
+static int work_error_handler(sd_event_source *s, int result, void *userdata) {
+        ASSERT_ERROR(result, EIO);
+        ASSERT_FALSE(*(bool*) userdata);
+
+        return 0;
+}
+
+TEST(work) {
+        _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL, *t = NULL;
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        bool running = false;
+        unsigned n = 0;
+
+        ASSERT_OK(sd_event_new(&e));
+
+        /* Unreferencing the event source either drops queued work, or waits for running work */
+        ASSERT_OK(sd_event_add_work(e, &t, work_sleep_func, work_error_handler, &running));
+        t = sd_event_source_unref(t);
+        ASSERT_FALSE(running);
+
+        ASSERT_OK(sd_event_add_work(e, &t, work_sleep_func, work_error_handler, &running));
+        ASSERT_OK_POSITIVE(sd_event_run(e, UINT64_MAX));
+        ASSERT_OK_EQ(sd_event_source_get_enabled(t, NULL), SD_EVENT_OFF);
+
+        /* The work is one-shot by default, and hence only executed once */
+        ASSERT_OK(sd_event_add_work(e, &s, work_func, work_handler, &n));
+        ASSERT_OK_POSITIVE(sd_event_run(e, UINT64_MAX));
+        ASSERT_EQ(n, 1U);
+        ASSERT_OK_EQ(sd_event_source_get_enabled(s, NULL), SD_EVENT_OFF);
+
+        /* Enabled continuously, the work is queued again after each dispatch */
+        ASSERT_OK(sd_event_source_set_enabled(s, SD_EVENT_ON));
+        ASSERT_OK(sd_event_loop(e));
+        ASSERT_EQ(n, 3U);
+}
+
 DEFINE_TEST_MAIN(LOG_DEBUG);
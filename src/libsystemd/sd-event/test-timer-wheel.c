@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "alloc-util.h"
+#include "random-util.h"
+#include "tests.h"
+#include "timer-wheel.h"
+
+#define N_NODES 20000U
+
+TEST(timer_wheel_basic) {
+        TimerWheelNode a = TIMER_WHEEL_NODE_NULL, b = TIMER_WHEEL_NODE_NULL, c = TIMER_WHEEL_NODE_NULL;
+        TimerWheel w;
+
+        timer_wheel_init(&w, 100);
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_MAX);
+        ASSERT_NULL(timer_wheel_pop(&w, UINT64_MAX - 1));
+
+        timer_wheel_init(&w, 100);
+        timer_wheel_add(&w, &a, 110);
+        timer_wheel_add(&w, &b, 5000);
+        timer_wheel_add(&w, &c, 5000);
+        ASSERT_TRUE(timer_wheel_node_is_queued(&a));
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_C(110));
+
+        /* Nothing is returned early */
+        ASSERT_NULL(timer_wheel_pop(&w, 109));
+        ASSERT_TRUE(timer_wheel_pop(&w, 110) == &a);
+        ASSERT_FALSE(timer_wheel_node_is_queued(&a));
+        ASSERT_NULL(timer_wheel_pop(&w, 110));
+
+        /* The higher level slot is cascaded only when needed, without a wakeup of its own */
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_C(5000));
+        timer_wheel_remove(&w, &b);
+        ASSERT_FALSE(timer_wheel_node_is_queued(&b));
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_C(5000));
+        ASSERT_NULL(timer_wheel_pop(&w, 4999));
+        ASSERT_TRUE(timer_wheel_pop(&w, 6000) == &c);
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_MAX);
+
+        /* Nodes in the past are returned right away */
+        timer_wheel_add(&w, &a, 10);
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_C(0));
+        ASSERT_TRUE(timer_wheel_pop(&w, 0) == &a);
+
+        /* Removing the earliest node of a slot moves the next wakeup */
+        timer_wheel_add(&w, &a, 100000);
+        timer_wheel_add(&w, &b, 100500);
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_C(100000));
+        timer_wheel_remove(&w, &a);
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_C(100500));
+        timer_wheel_remove(&w, &b);
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_MAX);
+}
+
+TEST(timer_wheel_random) {
+        _cleanup_free_ TimerWheelNode *nodes = NULL;
+        _cleanup_free_ bool *done = NULL;
+        unsigned n_done = 0, n_removed = 0;
+        uint64_t now = 4711;
+        TimerWheel w;
+
+        ASSERT_NOT_NULL(nodes = new(TimerWheelNode, N_NODES));
+        ASSERT_NOT_NULL(done = new0(bool, N_NODES));
+
+        timer_wheel_init(&w, now);
+
+        for (unsigned i = 0; i < N_NODES; i++) {
+                /* Cover all levels, as well as nodes beyond the range of the wheel */
+                static const uint64_t range[] = { 64, 4096, UINT64_C(1) << 18, UINT64_C(1) << 26 };
+
+                nodes[i] = TIMER_WHEEL_NODE_NULL;
+                timer_wheel_add(&w, nodes + i, now + random_u64_range(range[i % ELEMENTSOF(range)]));
+        }
+
+        for (unsigned i = 0; i < N_NODES; i += 7) {
+                timer_wheel_remove(&w, nodes + i);
+                done[i] = true;
+                n_removed++;
+        }
+
+        while (n_done + n_removed < N_NODES) {
+                TimerWheelNode *n;
+                uint64_t next;
+
+                next = timer_wheel_next(&w);
+                ASSERT_LT(next, UINT64_MAX);
+                ASSERT_GE(next, now);
+
+                /* Sometimes wake up late */
+                now = next + (random_u64_range(4) == 0 ? random_u64_range(1000) : 0);
+
+                while ((n = timer_wheel_pop(&w, now))) {
+                        ASSERT_FALSE(done[n - nodes]);
+                        ASSERT_LE(n->tick, now);
+
+                        /* If we woke up on time, every node returned must be exactly on time */
+                        if (now == next)
+                                ASSERT_EQ(n->tick, now);
+
+                        done[n - nodes] = true;
+                        n_done++;
+                }
+        }
+
+        ASSERT_EQ(timer_wheel_next(&w), UINT64_MAX);
+}
+
+DEFINE_TEST_MAIN(LOG_DEBUG);
@@ -0,0 +1,235 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "macro.h"
+#include "memory-util.h"
+#include "timer-wheel.h"
+
+#define LEVEL_SHIFT(l) ((l) * TIMER_WHEEL_BITS)
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define SLOT_BIT(idx) (UINT64_C(1) << (idx))
+/* Nodes further out than this are parked in the top level slot covering this distance, and re-evaluated
+ * when it is cascaded */
+#define RANGE_MAX ((UINT64_C(1) << LEVEL_SHIFT(TIMER_WHEEL_LEVELS)) - 1)
+
+void timer_wheel_init(TimerWheel *w, uint64_t clk) {
+        assert(w);
+
+        *w = (TimerWheel) {
+                .clk = clk,
+        };
+}
+
+void timer_wheel_add(TimerWheel *w, TimerWheelNode *n, uint64_t tick) {
+        unsigned level, idx, slot;
+        uint64_t delta, t;
+
+        assert(w);
+        assert(n);
+        assert(!timer_wheel_node_is_queued(n));
+
+        n->tick = tick;
+
+        if (tick < w->clk) {
+                /* Already elapsed, return it on the next timer_wheel_pop() */
+                LIST_PREPEND(node, w->expired, n);
+                n->slot = TIMER_WHEEL_SLOT_EXPIRED;
+                return;
+        }
+
+        delta = MIN(tick - w->clk, RANGE_MAX);
+        t = w->clk + delta;
+
+        for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++)
+                if (delta < (UINT64_C(1) << LEVEL_SHIFT(level + 1)))
+                        break;
+
+        idx = (t >> LEVEL_SHIFT(level)) & SLOT_MASK;
+        slot = level * TIMER_WHEEL_SLOTS + idx;
+
+        if (!FLAGS_SET(w->bitmap[level], SLOT_BIT(idx))) {
+                w->bitmap[level] |= SLOT_BIT(idx);
+                w->dirty[level] &= ~SLOT_BIT(idx);
+                w->slot_min[slot] = tick;
+        } else
+                w->slot_min[slot] = MIN(w->slot_min[slot], tick);
+
+        LIST_PREPEND(node, w->slots[slot], n);
+        n->slot = slot;
+}
+
+void timer_wheel_remove(TimerWheel *w, TimerWheelNode *n) {
+        unsigned level, idx;
+
+        assert(w);
+        assert(n);
+
+        if (!timer_wheel_node_is_queued(n))
+                return;
+
+        if (n->slot == TIMER_WHEEL_SLOT_EXPIRED)
+                LIST_REMOVE(node, w->expired, n);
+        else {
+                assert(n->slot < TIMER_WHEEL_SLOT_EXPIRED);
+
+                level = n->slot / TIMER_WHEEL_SLOTS;
+                idx = n->slot % TIMER_WHEEL_SLOTS;
+
+                LIST_REMOVE(node, w->slots[n->slot], n);
+
+                if (!w->slots[n->slot])
+                        w->bitmap[level] &= ~SLOT_BIT(idx);
+                else if (n->tick == w->slot_min[n->slot])
+                        /* Recalculated lazily, only if it's needed at all */
+                        w->dirty[level] |= SLOT_BIT(idx);
+        }
+
+        n->slot = TIMER_WHEEL_SLOT_NONE;
+}
+
+static int first_slot(const TimerWheel *w, unsigned level, uint64_t *ret_q) {
+        uint64_t q, bits;
+        unsigned idx;
+
+        /* Returns the first non-empty slot of the specified level in the order the wheel will pass them,
+         * and the index of the slot boundary (in units of the level's slot width) the wheel will pass it
+         * at. */
+
+        if (w->bitmap[level] == 0)
+                return -ENOENT;
+
+        /* The first slot boundary of this level that hasn't been passed yet */
+        q = DIV_ROUND_UP(w->clk, UINT64_C(1) << LEVEL_SHIFT(level));
+        idx = q & SLOT_MASK;
+
+        bits = idx == 0 ? w->bitmap[level] : (w->bitmap[level] >> idx) | (w->bitmap[level] << (TIMER_WHEEL_SLOTS - idx));
+        assert(bits != 0);
+
+        q += __builtin_ctzll(bits);
+        if (ret_q)
+                *ret_q = q;
+
+        return q & SLOT_MASK;
+}
+
+static uint64_t next_step(const TimerWheel *w) {
+        uint64_t next = UINT64_MAX;
+
+        /* Returns the next tick at which either nodes elapse, or a higher level slot needs to be cascaded */
+
+        for (unsigned level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+                uint64_t q;
+
+                if (first_slot(w, level, &q) >= 0)
+                        next = MIN(next, q << LEVEL_SHIFT(level));
+        }
+
+        return next;
+}
+
+uint64_t timer_wheel_next(TimerWheel *w) {
+        uint64_t next = UINT64_MAX, q;
+        int idx;
+
+        assert(w);
+
+        /* Returns the earliest tick at which a node elapses, i.e. when timer_wheel_pop() should be called
+         * next. Returns 0 if there are elapsed nodes already, and UINT64_MAX if the wheel is empty. */
+
+        if (w->expired)
+                return 0;
+
+        idx = first_slot(w, 0, &q);
+        if (idx >= 0)
+                next = q;
+
+        /* The slots of each level cover consecutive tick ranges, hence the first non-empty slot of each
+         * level also contains the earliest node of that level. */
+        for (unsigned level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+                unsigned slot;
+
+                idx = first_slot(w, level, NULL);
+                if (idx < 0)
+                        continue;
+
+                slot = level * TIMER_WHEEL_SLOTS + idx;
+
+                if (FLAGS_SET(w->dirty[level], SLOT_BIT(idx))) {
+                        w->slot_min[slot] = UINT64_MAX;
+                        LIST_FOREACH(node, n, w->slots[slot])
+                                w->slot_min[slot] = MIN(w->slot_min[slot], n->tick);
+
+                        w->dirty[level] &= ~SLOT_BIT(idx);
+                }
+
+                next = MIN(next, w->slot_min[slot]);
+        }
+
+        return next;
+}
+
+static void cascade(TimerWheel *w) {
+        /* Redistributes the higher level slots that begin at the current tick onto the lower levels. */
+
+        for (unsigned level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+                unsigned idx;
+                TimerWheelNode *l;
+
+                if ((w->clk & ((UINT64_C(1) << LEVEL_SHIFT(level)) - 1)) != 0)
+                        break;
+
+                idx = (w->clk >> LEVEL_SHIFT(level)) & SLOT_MASK;
+
+                l = TAKE_PTR(w->slots[level * TIMER_WHEEL_SLOTS + idx]);
+                w->bitmap[level] &= ~SLOT_BIT(idx);
+
+                while (l) {
+                        TimerWheelNode *n = l;
+
+                        LIST_REMOVE(node, l, n);
+                        n->slot = TIMER_WHEEL_SLOT_NONE;
+                        timer_wheel_add(w, n, n->tick);
+                }
+        }
+}
+
+TimerWheelNode* timer_wheel_pop(TimerWheel *w, uint64_t now) {
+        assert(w);
+
+        /* Returns the next node whose tick is at or before 'now', removing it from the wheel, or NULL if
+         * there is none. */
+
+        for (;;) {
+                TimerWheelNode *n;
+                uint64_t next;
+                unsigned idx;
+
+                n = w->expired;
+                if (n) {
+                        LIST_REMOVE(node, w->expired, n);
+                        n->slot = TIMER_WHEEL_SLOT_NONE;
+                        return n;
+                }
+
+                next = next_step(w);
+                if (next > now) {
+                        /* Nothing to do until 'now', hence we can skip right to it */
+                        if (now >= w->clk)
+                                w->clk = now + 1;
+                        return NULL;
+                }
+
+                /* There's nothing queued before 'next', hence jump there directly */
+                assert(next >= w->clk);
+                w->clk = next;
+
+                cascade(w);
+
+                idx = w->clk & SLOT_MASK;
+                w->expired = TAKE_PTR(w->slots[idx]);
+                w->bitmap[0] &= ~SLOT_BIT(idx);
+                LIST_FOREACH(node, i, w->expired)
+                        i->slot = TIMER_WHEEL_SLOT_EXPIRED;
+
+                w->clk++;
+        }
+}
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "list.h"
+
+/* A hierarchical timer wheel with O(1) insertion and removal, counting in abstract ticks. Level 0 has one
+ * slot per tick, each further level has slots TIMER_WHEEL_SLOTS times as wide as the level below. Nodes
+ * are placed on the lowest level that covers their expiry tick, and are cascaded down one level at a time
+ * when the wheel passes the beginning of their slot. Cascading happens lazily in timer_wheel_pop(), hence
+ * the caller only needs to wake up for the ticks timer_wheel_next() returns, at which point the nodes due
+ * are returned exactly, neither earlier nor later. */
+
+#define TIMER_WHEEL_BITS 6U
+#define TIMER_WHEEL_SLOTS (UINT64_C(1) << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4U
+
+typedef struct TimerWheelNode TimerWheelNode;
+
+struct TimerWheelNode {
+        uint64_t tick;
+        unsigned slot; /* Index into TimerWheel.slots[], or one of the special values below */
+        LIST_FIELDS(TimerWheelNode, node);
+};
+
+#define TIMER_WHEEL_SLOT_NONE UINT_MAX
+#define TIMER_WHEEL_SLOT_EXPIRED (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+
+#define TIMER_WHEEL_NODE_NULL (TimerWheelNode) { .slot = TIMER_WHEEL_SLOT_NONE }
+
+typedef struct TimerWheel {
+        uint64_t clk;                      /* The first tick not processed yet */
+        uint64_t bitmap[TIMER_WHEEL_LEVELS]; /* Non-empty slots */
+        uint64_t dirty[TIMER_WHEEL_LEVELS];  /* Slots whose slot_min[] entry might be lower than necessary */
+        uint64_t slot_min[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+        LIST_HEAD(TimerWheelNode, expired); /* Nodes whose tick has been reached, not popped yet */
+        LIST_HEAD(TimerWheelNode, slots[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS]);
+} TimerWheel;
+
+void timer_wheel_init(TimerWheel *w, uint64_t clk);
+
+void timer_wheel_add(TimerWheel *w, TimerWheelNode *n, uint64_t tick);
+void timer_wheel_remove(TimerWheel *w, TimerWheelNode *n);
+
+static inline bool timer_wheel_node_is_queued(const TimerWheelNode *n) {
+        return n->slot != TIMER_WHEEL_SLOT_NONE;
+}
+
+uint64_t timer_wheel_next(TimerWheel *w);
+TimerWheelNode* timer_wheel_pop(TimerWheel *w, uint64_t now);
@@ -23,6 +23,10 @@ struct sd_hwdb {
         OrderedHashmap *properties;
         Iterator properties_iterator;
         bool properties_modified;
+
+        /* The modalias the properties above were looked up for, so that they can be reused when the same
+         * modalias is queried again, e.g. by multiple sd_hwdb_get() calls for different keys. */
+        char *properties_modalias;
 };
 
 /* on-disk trie objects */
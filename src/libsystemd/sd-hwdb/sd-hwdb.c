@@ -357,19 +357,34 @@ static sd_hwdb *hwdb_free(sd_hwdb *hwdb) {
                 munmap((void *)hwdb->map, hwdb->st.st_size);
         safe_fclose(hwdb->f);
         ordered_hashmap_free(hwdb->properties);
+        free(hwdb->properties_modalias);
         return mfree(hwdb);
 }
 
 DEFINE_PUBLIC_TRIVIAL_REF_UNREF_FUNC(sd_hwdb, sd_hwdb, hwdb_free)
 
 static int properties_prepare(sd_hwdb *hwdb, const char *modalias) {
+        int r;
+
         assert(hwdb);
         assert(modalias);
 
+        /* The trie is mapped read-only and never changes while we have it open, hence the result of the
+         * previous lookup is still valid if it was for the same modalias. */
+        if (streq_ptr(hwdb->properties_modalias, modalias))
+                return 0;
+
+        hwdb->properties_modalias = mfree(hwdb->properties_modalias);
         ordered_hashmap_clear(hwdb->properties);
         hwdb->properties_modified = true;
 
-        return trie_search_f(hwdb, modalias);
+        r = trie_search_f(hwdb, modalias);
+        if (r < 0)
+                return r;
+
+        /* Failing to remember the modalias only means the next lookup cannot be skipped. */
+        hwdb->properties_modalias = strdup(modalias);
+        return 0;
 }
 
 _public_ int sd_hwdb_get(sd_hwdb *hwdb, const char *modalias, const char *key, const char **_value) {
@@ -218,6 +218,12 @@ sd_id128_t id128_make_v4_uuid(sd_id128_t id) {
 DEFINE_HASH_OPS(id128_hash_ops, sd_id128_t, id128_hash_func, id128_compare_func);
 DEFINE_HASH_OPS_WITH_KEY_DESTRUCTOR(id128_hash_ops_free, sd_id128_t, id128_hash_func, id128_compare_func, free);
 
+uint64_t trusted_id128_hash_func(const sd_id128_t *p, uint64_t seed) {
+        return trusted_hash_mix64(trusted_hash_mix64(p->qwords[0] ^ seed) ^ p->qwords[1]);
+}
+
+DEFINE_TRUSTED_HASH_OPS(trusted_id128_hash_ops, sd_id128_t, trusted_id128_hash_func, id128_compare_func);
+
 int id128_get_product(sd_id128_t *ret) {
         sd_id128_t uuid;
         int r;
@@ -43,6 +43,10 @@ int id128_compare_func(const sd_id128_t *a, const sd_id128_t *b) _pure_;
 extern const struct hash_ops id128_hash_ops;
 extern const struct hash_ops id128_hash_ops_free;
 
+/* Only for IDs we generate ourselves, see DEFINE_TRUSTED_HASH_OPS() */
+uint64_t trusted_id128_hash_func(const sd_id128_t *p, uint64_t seed) _pure_;
+extern const struct hash_ops trusted_id128_hash_ops;
+
 sd_id128_t id128_make_v4_uuid(sd_id128_t id);
 
 int id128_get_product(sd_id128_t *ret);
@@ -301,6 +301,11 @@ int journal_file_hmac_put_object(JournalFile *f, ObjectType type, Object *o, uin
                 sym_gcry_md_write(f->hmac, &o->tag.seqnum, sizeof(o->tag.seqnum));
                 sym_gcry_md_write(f->hmac, &o->tag.epoch, sizeof(o->tag.epoch));
                 break;
+
+        case OBJECT_DICTIONARY:
+                /* All */
+                sym_gcry_md_write(f->hmac, o->dictionary.payload, le64toh(o->object.size) - offsetof(Object, dictionary.payload));
+                break;
         default:
                 return -EINVAL;
         }
@@ -0,0 +1,539 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "fd-util.h"
+#include "io-util.h"
+#include "journal-boot-index.h"
+#include "log.h"
+#include "path-util.h"
+#include "sort-util.h"
+#include "stat-util.h"
+#include "string-util.h"
+#include "tmpfile-util.h"
+
+/* Refuse to load indexes larger than this, even with thousands of archived files they stay much smaller. */
+#define JOURNAL_BOOT_INDEX_SIZE_MAX (UINT64_C(64) * U64_MB)
+
+struct JournalBootIndex {
+        uint8_t *data;
+        size_t size;
+
+        const JournalBootIndexItem *items;
+        uint64_t n_items;
+        const char *names;
+        uint64_t names_size;
+};
+
+/* Note that the boots of a file are determined from the offline thread when it gets archived, concurrently
+ * to other users of the (not thread safe) mmap cache. Hence everything here only uses pread(). */
+
+static int boot_find_field(JournalFile *f, uint64_t *ret_head_data_offset) {
+        uint64_t hash, m;
+        HashItem h;
+        ssize_t l;
+        Object o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(ret_head_data_offset);
+
+        m = le64toh(f->header->field_hash_table_size) / sizeof(HashItem);
+        if (m == 0)
+                return -EBADMSG;
+
+        hash = journal_file_hash_data(f, "_BOOT_ID", STRLEN("_BOOT_ID"));
+
+        l = pread(f->fd, &h, sizeof(h), le64toh(f->header->field_hash_table_offset) + (hash % m) * sizeof(HashItem));
+        if (l < 0)
+                return -errno;
+        if (l != sizeof(h))
+                return -EIO;
+
+        for (uint64_t q = le64toh(h.head_hash_offset), next; q != 0; q = next) {
+                char payload[STRLEN("_BOOT_ID")];
+
+                r = journal_file_read_object_header(f, OBJECT_FIELD, q, &o);
+                if (r < 0)
+                        return r;
+
+                /* Objects are only ever appended, hence the chain must move forward. Refuse loops. */
+                next = le64toh(o.field.next_hash_offset);
+                if (next != 0 && next <= q)
+                        return -EBADMSG;
+
+                if (le64toh(o.field.hash) != hash ||
+                    le64toh(o.object.size) != offsetof(Object, field.payload) + STRLEN("_BOOT_ID"))
+                        continue;
+
+                l = pread(f->fd, payload, sizeof(payload), q + offsetof(Object, field.payload));
+                if (l < 0)
+                        return -errno;
+                if (l != sizeof(payload))
+                        return -EIO;
+
+                if (memcmp(payload, "_BOOT_ID", sizeof(payload)) != 0)
+                        continue;
+
+                *ret_head_data_offset = le64toh(o.field.head_data_offset);
+                return 1;
+        }
+
+        return 0;
+}
+
+static int boot_data_last_entry(JournalFile *f, const Object *d, uint64_t *ret) {
+        uint64_t n, a;
+        int r;
+
+        assert(f);
+        assert(d);
+        assert(ret);
+
+        /* The first entry is stored inline in the data object, all further ones in the entry array chain. */
+        n = le64toh(d->data.n_entries) - 1;
+        if (n == 0) {
+                *ret = le64toh(d->data.entry_offset);
+                return 0;
+        }
+
+        a = le64toh(d->data.entry_array_offset);
+        for (;;) {
+                uint64_t m;
+                Object o;
+
+                if (a == 0)
+                        return -EBADMSG;
+
+                r = journal_file_read_object_header(f, OBJECT_ENTRY_ARRAY, a, &o);
+                if (r < 0)
+                        return r;
+
+                m = journal_file_entry_array_n_items(f, &o);
+                if (n <= m) {
+                        size_t sz = journal_file_entry_array_item_size(f);
+                        uint64_t item = 0;
+                        ssize_t l;
+
+                        l = pread(f->fd, &item, sz, a + offsetof(Object, entry_array.items) + (n - 1) * sz);
+                        if (l < 0)
+                                return -errno;
+                        if ((size_t) l != sz)
+                                return -EIO;
+
+                        /* Both the compact and the regular format store little endian integers, reading a
+                         * 32bit one into a zeroed 64bit variable hence works for either. */
+                        *ret = le64toh(item);
+                        return *ret == 0 ? -EBADMSG : 0;
+                }
+
+                n -= m;
+                a = le64toh(o.entry_array.next_entry_array_offset);
+        }
+}
+
+int journal_file_get_boots(JournalFile *f, JournalBoot **ret, size_t *ret_n) {
+        _cleanup_free_ JournalBoot *boots = NULL;
+        size_t n_boots = 0;
+        uint64_t q;
+        Object d;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(ret);
+        assert(ret_n);
+
+        /* Determines the boots recorded in the specified journal file, by looking at the first and the last
+         * entry of every _BOOT_ID= data object. The seqnums are those of the file's seqnum ID, which
+         * journald carries over from file to file. */
+
+        r = boot_find_field(f, &q);
+        if (r < 0)
+                return r;
+        if (r == 0)
+                q = 0;
+
+        for (uint64_t next; q != 0; q = next) {
+                uint64_t last;
+                Object e;
+
+                r = journal_file_read_object_header(f, OBJECT_DATA, q, &d);
+                if (r < 0)
+                        return r;
+
+                next = le64toh(d.data.next_field_offset);
+                if (next != 0 && next <= q)
+                        return -EBADMSG;
+
+                /* Data objects might be left unreferenced if writing the entry failed */
+                if (le64toh(d.data.n_entries) == 0)
+                        continue;
+
+                r = boot_data_last_entry(f, &d, &last);
+                if (r < 0)
+                        return r;
+
+                r = journal_file_read_object_header(f, OBJECT_ENTRY, le64toh(d.data.entry_offset), &e);
+                if (r < 0)
+                        return r;
+
+                if (!GREEDY_REALLOC(boots, n_boots + 1))
+                        return -ENOMEM;
+
+                boots[n_boots] = (JournalBoot) {
+                        .boot_id = e.entry.boot_id,
+                        .seqnum_id = f->header->seqnum_id,
+                        .first_seqnum = le64toh(e.entry.seqnum),
+                        .first_realtime = le64toh(e.entry.realtime),
+                };
+
+                r = journal_file_read_object_header(f, OBJECT_ENTRY, last, &e);
+                if (r < 0)
+                        return r;
+
+                if (!sd_id128_equal(e.entry.boot_id, boots[n_boots].boot_id))
+                        return -EBADMSG;
+
+                boots[n_boots].last_seqnum = le64toh(e.entry.seqnum);
+                boots[n_boots++].last_realtime = le64toh(e.entry.realtime);
+        }
+
+        *ret = TAKE_PTR(boots);
+        *ret_n = n_boots;
+        return 0;
+}
+
+static int boot_index_item_compare_file_id(const JournalBootIndexItem *a, const JournalBootIndexItem *b) {
+        return memcmp(&a->file_id, &b->file_id, sizeof(sd_id128_t));
+}
+
+static int boot_index_item_compare(const JournalBootIndexItem *a, const JournalBootIndexItem *b) {
+        int r;
+
+        r = boot_index_item_compare_file_id(a, b);
+        if (r != 0)
+                return r;
+
+        return CMP(le64toh(a->first_seqnum), le64toh(b->first_seqnum));
+}
+
+static const char* boot_index_item_name(JournalBootIndex *x, const JournalBootIndexItem *i) {
+        uint64_t o;
+
+        assert(x);
+        assert(i);
+
+        /* The names blob is NUL terminated, as verified when loading the index */
+        o = le64toh(i->name_offset);
+        if (o >= x->names_size)
+                return NULL;
+
+        return x->names + o;
+}
+
+static int boot_index_add_name(char **names, size_t *names_size, const char *name, uint64_t *ret_offset) {
+        size_t l;
+
+        assert(names);
+        assert(names_size);
+        assert(name);
+        assert(ret_offset);
+
+        l = strlen(name) + 1;
+        if (!GREEDY_REALLOC(*names, *names_size + l))
+                return -ENOMEM;
+
+        memcpy(*names + *names_size, name, l);
+        *ret_offset = *names_size;
+        *names_size += l;
+        return 0;
+}
+
+int journal_boot_index_update(JournalFile *f) {
+        _cleanup_(journal_boot_index_freep) JournalBootIndex *old = NULL;
+        _cleanup_free_ JournalBootIndexItem *items = NULL;
+        _cleanup_free_ char *dir = NULL, *fname = NULL, *path = NULL, *names = NULL;
+        _cleanup_(unlink_and_freep) char *tmp = NULL;
+        _cleanup_free_ JournalBoot *boots = NULL;
+        _cleanup_close_ int dir_fd = -EBADF, fd = -EBADF;
+        size_t n_boots = 0, n_items = 0, names_size = 0;
+        uint64_t name_offset = 0;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(f->path);
+
+        r = journal_file_get_boots(f, &boots, &n_boots);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to determine boots in %s, not updating boot index: %m", f->path);
+
+        r = path_extract_filename(f->path, &fname);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to extract file name from %s: %m", f->path);
+
+        r = path_extract_directory(f->path, &dir);
+        if (r < 0 && r != -EDESTADDRREQ)
+                return log_debug_errno(r, "Failed to extract directory from %s: %m", f->path);
+
+        path = path_join(dir, JOURNAL_BOOT_INDEX_FILENAME);
+        if (!path)
+                return -ENOMEM;
+
+        dir_fd = open(dir ?: ".", O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+        if (dir_fd < 0)
+                return log_debug_errno(errno, "Failed to open directory of %s: %m", f->path);
+
+        /* The offline threads of multiple journal files in the same directory might get here at the same
+         * time, let's make sure they don't lose each other's updates. */
+        if (flock(dir_fd, LOCK_EX) < 0)
+                return log_debug_errno(errno, "Failed to lock directory of %s: %m", f->path);
+
+        r = journal_boot_index_open(dir_fd, &old);
+        if (r < 0)
+                log_debug_errno(r, "Failed to load boot index %s, regenerating: %m", path);
+
+        /* Carry over the items of all other files that still exist. Files removed by vacuuming are dropped
+         * from the index that way, without having to touch it whenever a file is removed. */
+        if (old) {
+                const char *checked = NULL;
+                bool exists = false;
+
+                for (uint64_t i = 0; i < old->n_items; i++) {
+                        const JournalBootIndexItem *item = old->items + i;
+                        const char *name;
+
+                        if (sd_id128_equal(item->file_id, f->header->file_id))
+                                continue;
+
+                        name = boot_index_item_name(old, item);
+                        if (!name)
+                                continue;
+
+                        /* The items of a file are stored next to each other, only check once per file */
+                        if (name != checked) {
+                                checked = name;
+                                exists = faccessat(dir_fd, name, F_OK, AT_SYMLINK_NOFOLLOW) >= 0 || errno != ENOENT;
+                                if (exists) {
+                                        r = boot_index_add_name(&names, &names_size, name, &name_offset);
+                                        if (r < 0)
+                                                return r;
+                                }
+                        }
+                        if (!exists)
+                                continue;
+
+                        if (!GREEDY_REALLOC(items, n_items + 1))
+                                return -ENOMEM;
+
+                        items[n_items] = *item;
+                        items[n_items++].name_offset = htole64(name_offset);
+                }
+        }
+
+        if (n_boots > 0) {
+                r = boot_index_add_name(&names, &names_size, fname, &name_offset);
+                if (r < 0)
+                        return r;
+
+                if (!GREEDY_REALLOC(items, n_items + n_boots))
+                        return -ENOMEM;
+
+                FOREACH_ARRAY(b, boots, n_boots)
+                        items[n_items++] = (JournalBootIndexItem) {
+                                .file_id = f->header->file_id,
+                                .n_entries = f->header->n_entries,
+                                .tail_entry_seqnum = f->header->tail_entry_seqnum,
+                                .name_offset = htole64(name_offset),
+                                .boot_id = b->boot_id,
+                                .seqnum_id = b->seqnum_id,
+                                .first_seqnum = htole64(b->first_seqnum),
+                                .last_seqnum = htole64(b->last_seqnum),
+                                .first_realtime = htole64(b->first_realtime),
+                                .last_realtime = htole64(b->last_realtime),
+                        };
+        }
+
+        typesafe_qsort(items, n_items, boot_index_item_compare);
+
+        JournalBootIndexHeader header = {
+                .header_size = htole64(sizeof(JournalBootIndexHeader)),
+                .n_items = htole64(n_items),
+                .items_offset = htole64(sizeof(JournalBootIndexHeader)),
+                .names_offset = htole64(sizeof(JournalBootIndexHeader) + n_items * sizeof(JournalBootIndexItem)),
+                .names_size = htole64(names_size),
+        };
+        memcpy(header.signature, JOURNAL_BOOT_INDEX_SIGNATURE, sizeof(header.signature));
+
+        fd = open_tmpfile_linkable(path, O_WRONLY|O_CLOEXEC, &tmp);
+        if (fd < 0)
+                return log_debug_errno(fd, "Failed to create temporary file for %s: %m", path);
+
+        if (fchmod(fd, f->mode & 0666) < 0)
+                return log_debug_errno(errno, "Failed to adjust access mode of %s: %m", path);
+
+        r = loop_write(fd, &header, sizeof(header));
+        if (r >= 0)
+                r = loop_write(fd, items, n_items * sizeof(JournalBootIndexItem));
+        if (r >= 0)
+                r = loop_write(fd, names, names_size);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to write %s: %m", path);
+
+        r = link_tmpfile(fd, tmp, path, LINK_TMPFILE_REPLACE|LINK_TMPFILE_SYNC);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to move %s into place: %m", path);
+
+        tmp = mfree(tmp);
+
+        log_debug("Updated boot index %s with %zu boots of %s, %zu items in total.", path, n_boots, fname, n_items);
+        return 1;
+}
+
+JournalBootIndex* journal_boot_index_free(JournalBootIndex *x) {
+        if (!x)
+                return NULL;
+
+        free(x->data);
+        return mfree(x);
+}
+
+int journal_boot_index_open(int dir_fd, JournalBootIndex **ret) {
+        _cleanup_(journal_boot_index_freep) JournalBootIndex *x = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        const JournalBootIndexHeader *h;
+        uint64_t items_offset, names_offset, names_size, n_items;
+        struct stat st;
+        int r;
+
+        assert(dir_fd >= 0 || dir_fd == AT_FDCWD);
+        assert(ret);
+
+        /* Returns 0 if there's no usable index in this directory, 1 if it was loaded successfully. */
+
+        *ret = NULL;
+
+        fd = openat(dir_fd, JOURNAL_BOOT_INDEX_FILENAME, O_RDONLY|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0) {
+                if (errno == ENOENT)
+                        return 0;
+
+                return log_debug_errno(errno, "Failed to open " JOURNAL_BOOT_INDEX_FILENAME ": %m");
+        }
+
+        if (fstat(fd, &st) < 0)
+                return log_debug_errno(errno, "Failed to stat " JOURNAL_BOOT_INDEX_FILENAME ": %m");
+
+        r = stat_verify_regular(&st);
+        if (r < 0)
+                return log_debug_errno(r, "Refusing to use " JOURNAL_BOOT_INDEX_FILENAME " as boot index: %m");
+
+        if ((uint64_t) st.st_size < sizeof(JournalBootIndexHeader) || (uint64_t) st.st_size > JOURNAL_BOOT_INDEX_SIZE_MAX)
+                goto invalid;
+
+        x = new(JournalBootIndex, 1);
+        if (!x)
+                return -ENOMEM;
+
+        *x = (JournalBootIndex) {
+                .data = malloc(st.st_size),
+                .size = st.st_size,
+        };
+        if (!x->data)
+                return -ENOMEM;
+
+        r = loop_read_exact(fd, x->data, x->size, /* do_poll= */ false);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to read " JOURNAL_BOOT_INDEX_FILENAME ": %m");
+
+        h = (const JournalBootIndexHeader*) x->data;
+
+        if (memcmp(h->signature, JOURNAL_BOOT_INDEX_SIGNATURE, sizeof(h->signature)) != 0 ||
+            le64toh(h->header_size) < sizeof(JournalBootIndexHeader))
+                goto invalid;
+
+        n_items = le64toh(h->n_items);
+        items_offset = le64toh(h->items_offset);
+        names_offset = le64toh(h->names_offset);
+        names_size = le64toh(h->names_size);
+
+        if (items_offset < le64toh(h->header_size) ||
+            items_offset > x->size ||
+            n_items > (x->size - items_offset) / sizeof(JournalBootIndexItem) ||
+            names_offset < items_offset + n_items * sizeof(JournalBootIndexItem) ||
+            names_offset > x->size ||
+            names_size > x->size - names_offset)
+                goto invalid;
+
+        x->items = (const JournalBootIndexItem*) (x->data + items_offset);
+        x->n_items = n_items;
+        x->names = (const char*) x->data + names_offset;
+        x->names_size = names_size;
+
+        if (names_size > 0 && x->names[names_size - 1] != 0)
+                goto invalid;
+
+        *ret = TAKE_PTR(x);
+        return 1;
+
+invalid:
+        log_debug("Boot index " JOURNAL_BOOT_INDEX_FILENAME " is invalid, ignoring.");
+        return 0;
+}
+
+int journal_boot_index_get(JournalBootIndex *x, JournalFile *f, JournalBoot **ret, size_t *ret_n) {
+        _cleanup_free_ JournalBoot *boots = NULL;
+        const JournalBootIndexItem *found, *end;
+        size_t n_boots = 0;
+
+        assert(x);
+        assert(f);
+        assert(f->header);
+        assert(ret);
+        assert(ret_n);
+
+        /* Returns 0 if the index has no (or only stale) information about the file, 1 otherwise. */
+
+        /* Only archived files are immutable, anything else would make the index stale right-away. */
+        if (f->header->state != STATE_ARCHIVED)
+                return 0;
+
+        found = typesafe_bsearch(&(const JournalBootIndexItem) { .file_id = f->header->file_id },
+                                 x->items, x->n_items, boot_index_item_compare_file_id);
+        if (!found)
+                return 0;
+
+        while (found > x->items && sd_id128_equal(found[-1].file_id, f->header->file_id))
+                found--;
+
+        end = x->items + x->n_items;
+        for (const JournalBootIndexItem *i = found; i < end && sd_id128_equal(i->file_id, f->header->file_id); i++) {
+                if (i->n_entries != f->header->n_entries ||
+                    i->tail_entry_seqnum != f->header->tail_entry_seqnum) {
+                        log_debug("Boot index does not match %s, ignoring.", f->path);
+                        return 0;
+                }
+
+                if (!GREEDY_REALLOC(boots, n_boots + 1))
+                        return -ENOMEM;
+
+                boots[n_boots++] = (JournalBoot) {
+                        .boot_id = i->boot_id,
+                        .seqnum_id = i->seqnum_id,
+                        .first_seqnum = le64toh(i->first_seqnum),
+                        .last_seqnum = le64toh(i->last_seqnum),
+                        .first_realtime = le64toh(i->first_realtime),
+                        .last_realtime = le64toh(i->last_realtime),
+                };
+        }
+
+        *ret = TAKE_PTR(boots);
+        *ret_n = n_boots;
+        return 1;
+}
@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "sd-id128.h"
+
+#include "journal-file.h"
+#include "sparse-endian.h"
+#include "time-util.h"
+
+/* A per-directory index of the boots recorded in the archived journal files of that directory. For each
+ * archived file it lists the boot IDs with entries in the file, together with the seqnum and realtime
+ * ranges these entries cover. It is updated whenever a journal file is archived, and allows enumerating boots (as
+ * journalctl --list-boots and -b do) without walking the _BOOT_ID= data objects and entry arrays of every
+ * single file. Items are bound to a journal file via the file ID, the number of entries and the tail entry
+ * seqnum, and are silently ignored if any of these do not match. The index can always be regenerated from
+ * the journal files themselves. */
+
+#define JOURNAL_BOOT_INDEX_SIGNATURE ((const char[]) { 'L', 'P', 'K', 'S', 'B', 'I', 'D', '1' })
+#define JOURNAL_BOOT_INDEX_FILENAME "boots.idx"
+
+typedef struct JournalBootIndexHeader {
+        uint8_t signature[8];
+        le64_t header_size;
+        le64_t n_items;
+        le64_t items_offset;
+        le64_t names_offset;
+        le64_t names_size;
+} _packed_ JournalBootIndexHeader;
+
+typedef struct JournalBootIndexItem {
+        sd_id128_t file_id;
+        le64_t n_entries;
+        le64_t tail_entry_seqnum;
+        le64_t name_offset; /* relative to JournalBootIndexHeader.names_offset */
+        sd_id128_t boot_id;
+        sd_id128_t seqnum_id;
+        le64_t first_seqnum;
+        le64_t last_seqnum;
+        le64_t first_realtime;
+        le64_t last_realtime;
+} _packed_ JournalBootIndexItem;
+
+typedef struct JournalBoot {
+        sd_id128_t boot_id;
+        sd_id128_t seqnum_id;
+        uint64_t first_seqnum;
+        uint64_t last_seqnum;
+        usec_t first_realtime;
+        usec_t last_realtime;
+} JournalBoot;
+
+typedef struct JournalBootIndex JournalBootIndex;
+
+int journal_file_get_boots(JournalFile *f, JournalBoot **ret, size_t *ret_n);
+
+int journal_boot_index_update(JournalFile *f);
+
+int journal_boot_index_open(int dir_fd, JournalBootIndex **ret);
+JournalBootIndex* journal_boot_index_free(JournalBootIndex *x);
+DEFINE_TRIVIAL_CLEANUP_FUNC(JournalBootIndex*, journal_boot_index_free);
+
+int journal_boot_index_get(JournalBootIndex *x, JournalFile *f, JournalBoot **ret, size_t *ret_n);
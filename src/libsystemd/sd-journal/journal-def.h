@@ -23,6 +23,10 @@ typedef struct EntryObject EntryObject;
 typedef struct HashTableObject HashTableObject;
 typedef struct EntryArrayObject EntryArrayObject;
 typedef struct TagObject TagObject;
+typedef struct DictionaryObject DictionaryObject;
+typedef struct EntryArrayFanoutObject EntryArrayFanoutObject;
+
+typedef struct EntryArrayFanoutItem EntryArrayFanoutItem;
 
 typedef struct HashItem HashItem;
 
@@ -38,6 +42,8 @@ typedef enum ObjectType {
         OBJECT_FIELD_HASH_TABLE,
         OBJECT_ENTRY_ARRAY,
         OBJECT_TAG,
+        OBJECT_DICTIONARY,
+        OBJECT_ENTRY_ARRAY_FANOUT,
         _OBJECT_TYPE_MAX,
         _OBJECT_TYPE_INVALID = -EINVAL,
 } ObjectType;
@@ -48,6 +54,9 @@ enum {
         OBJECT_COMPRESSED_LZ4   = 1 << 1,
         OBJECT_COMPRESSED_ZSTD  = 1 << 2,
         _OBJECT_COMPRESSED_MASK = OBJECT_COMPRESSED_XZ | OBJECT_COMPRESSED_LZ4 | OBJECT_COMPRESSED_ZSTD,
+
+        /* Only valid together with OBJECT_COMPRESSED_ZSTD: compressed with the file's dictionary */
+        OBJECT_COMPRESSED_DICTIONARY = 1 << 3,
 };
 
 struct ObjectHeader {
@@ -150,6 +159,24 @@ struct TagObject {
         uint8_t tag[TAG_LENGTH]; /* SHA-256 HMAC */
 } _packed_;
 
+struct DictionaryObject {
+        ObjectHeader object;
+        uint8_t payload[]; /* zstd dictionary */
+} _packed_;
+
+struct EntryArrayFanoutItem {
+        le64_t entry_array_offset;
+        le64_t begin; /* the first entry of the entry array */
+        le64_t total; /* the number of entries in all entry arrays before this one */
+} _packed_;
+
+struct EntryArrayFanoutObject {
+        ObjectHeader object;
+        le64_t first_entry_array_offset; /* the first entry array of the chain described by this object */
+        le64_t next_fanout_offset;
+        EntryArrayFanoutItem items[];
+} _packed_;
+
 union Object {
         ObjectHeader object;
         DataObject data;
@@ -158,6 +185,8 @@ union Object {
         HashTableObject hash_table;
         EntryArrayObject entry_array;
         TagObject tag;
+        DictionaryObject dictionary;
+        EntryArrayFanoutObject entry_array_fanout;
 };
 
 enum {
@@ -174,16 +203,19 @@ enum {
         HEADER_INCOMPATIBLE_KEYED_HASH      = 1 << 2,
         HEADER_INCOMPATIBLE_COMPRESSED_ZSTD = 1 << 3,
         HEADER_INCOMPATIBLE_COMPACT         = 1 << 4,
+        HEADER_INCOMPATIBLE_DICTIONARY      = 1 << 5,
 
         HEADER_INCOMPATIBLE_ANY             = HEADER_INCOMPATIBLE_COMPRESSED_XZ |
                                               HEADER_INCOMPATIBLE_COMPRESSED_LZ4 |
                                               HEADER_INCOMPATIBLE_KEYED_HASH |
                                               HEADER_INCOMPATIBLE_COMPRESSED_ZSTD |
-                                              HEADER_INCOMPATIBLE_COMPACT,
+                                              HEADER_INCOMPATIBLE_COMPACT |
+                                              HEADER_INCOMPATIBLE_DICTIONARY,
 
         HEADER_INCOMPATIBLE_SUPPORTED       = (HAVE_XZ ? HEADER_INCOMPATIBLE_COMPRESSED_XZ : 0) |
                                               (HAVE_LZ4 ? HEADER_INCOMPATIBLE_COMPRESSED_LZ4 : 0) |
-                                              (HAVE_ZSTD ? HEADER_INCOMPATIBLE_COMPRESSED_ZSTD : 0) |
+                                              (HAVE_ZSTD ? HEADER_INCOMPATIBLE_COMPRESSED_ZSTD |
+                                                           HEADER_INCOMPATIBLE_DICTIONARY : 0) |
                                               HEADER_INCOMPATIBLE_KEYED_HASH |
                                               HEADER_INCOMPATIBLE_COMPACT,
 };
@@ -192,12 +224,15 @@ enum {
         HEADER_COMPATIBLE_SEALED             = 1 << 0,
         HEADER_COMPATIBLE_TAIL_ENTRY_BOOT_ID = 1 << 1, /* if set, the last_entry_boot_id field in the header is exclusively refreshed when an entry is appended */
         HEADER_COMPATIBLE_SEALED_CONTINUOUS  = 1 << 2,
+        HEADER_COMPATIBLE_ENTRY_ARRAY_FANOUT = 1 << 3,
         HEADER_COMPATIBLE_ANY                = HEADER_COMPATIBLE_SEALED |
                                                HEADER_COMPATIBLE_TAIL_ENTRY_BOOT_ID |
-                                               HEADER_COMPATIBLE_SEALED_CONTINUOUS,
+                                               HEADER_COMPATIBLE_SEALED_CONTINUOUS |
+                                               HEADER_COMPATIBLE_ENTRY_ARRAY_FANOUT,
 
         HEADER_COMPATIBLE_SUPPORTED          = (HAVE_GCRYPT ? HEADER_COMPATIBLE_SEALED | HEADER_COMPATIBLE_SEALED_CONTINUOUS : 0) |
-                                               HEADER_COMPATIBLE_TAIL_ENTRY_BOOT_ID,
+                                               HEADER_COMPATIBLE_TAIL_ENTRY_BOOT_ID |
+                                               HEADER_COMPATIBLE_ENTRY_ARRAY_FANOUT,
 };
 
 #define HEADER_SIGNATURE                                                \
@@ -242,12 +277,15 @@ enum {
         le32_t tail_entry_array_n_entries;              \
         /* Added in 254 */                              \
         le64_t tail_entry_offset;                       \
+        /* Added in 258 */                              \
+        le64_t dictionary_offset;                       \
+        le64_t entry_array_fanout_offset;               \
         }
 
 struct Header struct_Header__contents;
 struct Header__packed struct_Header__contents _packed_;
 assert_cc(sizeof(struct Header) == sizeof(struct Header__packed));
-assert_cc(sizeof(struct Header) == 272);
+assert_cc(sizeof(struct Header) == 288);
 
 #define FSS_HEADER_SIGNATURE                                            \
         ((const char[]) { 'K', 'S', 'H', 'H', 'R', 'H', 'L', 'P' })
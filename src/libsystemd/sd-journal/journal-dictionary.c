@@ -0,0 +1,223 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "alloc-util.h"
+#include "env-util.h"
+#include "journal-authenticate.h"
+#include "journal-dictionary.h"
+#include "log.h"
+#include "missing_threads.h"
+
+/* Train once this many bytes of samples have been collected, and don't let the dictionary grow larger than
+ * this. zstd recommends roughly 100 times the dictionary size in samples, but small dictionaries are what
+ * matters for small payloads. */
+#define JOURNAL_DICTIONARY_TRAINING_SIZE (512U * 1024U)
+#define JOURNAL_DICTIONARY_SIZE_MAX (16U * 1024U)
+
+struct JournalDictionary {
+        CompressDictionary *dictionary;
+
+        /* Set if the dictionary could not be loaded or trained, so that we don't try again and again */
+        bool failed;
+
+        /* Concatenated samples collected for training, only used when writing */
+        uint8_t *samples;
+        size_t samples_size;
+        size_t *sample_sizes;
+        size_t n_samples;
+};
+
+bool journal_dictionary_enabled(void) {
+        static thread_local int cached = -1;
+        int r;
+
+        if (cached < 0) {
+                r = getenv_bool("SYSTEMD_JOURNAL_COMPRESS_DICTIONARY");
+                if (r < 0) {
+                        if (r != -ENXIO)
+                                log_debug_errno(r, "Failed to parse $SYSTEMD_JOURNAL_COMPRESS_DICTIONARY environment variable, ignoring: %m");
+                        cached = false;
+                } else
+                        cached = r;
+        }
+
+        return cached;
+}
+
+static void journal_dictionary_free_samples(JournalDictionary *d) {
+        assert(d);
+
+        d->samples = mfree(d->samples);
+        d->sample_sizes = mfree(d->sample_sizes);
+        d->samples_size = d->n_samples = 0;
+}
+
+JournalDictionary* journal_dictionary_free(JournalDictionary *d) {
+        if (!d)
+                return NULL;
+
+        compress_dictionary_free(d->dictionary);
+        journal_dictionary_free_samples(d);
+
+        return mfree(d);
+}
+
+static JournalDictionary* journal_file_acquire_dictionary(JournalFile *f) {
+        assert(f);
+
+        if (!f->dictionary)
+                f->dictionary = new0(JournalDictionary, 1);
+
+        return f->dictionary;
+}
+
+int journal_dictionary_get(JournalFile *f, CompressDictionary **ret) {
+        JournalDictionary *d;
+        uint64_t p, size;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(ret);
+
+        /* Returns 1 and the dictionary if the file has one, 0 if it has none. */
+
+        if (f->dictionary && f->dictionary->dictionary) {
+                *ret = f->dictionary->dictionary;
+                return 1;
+        }
+
+        if (!JOURNAL_HEADER_CONTAINS(f->header, dictionary_offset))
+                return 0;
+
+        p = le64toh(READ_NOW(f->header->dictionary_offset));
+        if (p == 0)
+                return 0;
+
+        d = journal_file_acquire_dictionary(f);
+        if (!d)
+                return -ENOMEM;
+        if (d->failed)
+                return -EBADMSG;
+
+        r = journal_file_move_to_object(f, OBJECT_DICTIONARY, p, &o);
+        if (r < 0) {
+                d->failed = true;
+                return log_debug_errno(r, "Failed to move to dictionary object of %s: %m", f->path);
+        }
+
+        size = le64toh(READ_NOW(o->object.size)) - offsetof(Object, dictionary.payload);
+        if ((uint64_t) (size_t) size != size)
+                return -E2BIG;
+
+        r = compress_dictionary_new_zstd(o->dictionary.payload, size, /* level = */ -1, &d->dictionary);
+        if (r < 0) {
+                d->failed = true;
+                return log_debug_errno(r, "Failed to load compression dictionary of %s: %m", f->path);
+        }
+
+        *ret = d->dictionary;
+        return 1;
+}
+
+static bool journal_dictionary_wanted(JournalFile *f) {
+        assert(f);
+        assert(f->header);
+
+        if (!journal_file_writable(f))
+                return false;
+
+        if (!JOURNAL_HEADER_COMPRESSED_ZSTD(f->header))
+                return false;
+
+        /* Only files created with the incompatible flag set may get a dictionary, so that readers never
+         * see the flag appear on a file they already opened. And files shouldn't get a second one. */
+        if (!JOURNAL_HEADER_DICTIONARY(f->header) ||
+            !JOURNAL_HEADER_CONTAINS(f->header, dictionary_offset) ||
+            f->header->dictionary_offset != 0)
+                return false;
+
+        return true;
+}
+
+int journal_dictionary_add_sample(JournalFile *f, const void *data, size_t size) {
+        JournalDictionary *d;
+
+        assert(f);
+        assert(data);
+
+        if (size < JOURNAL_DICTIONARY_PAYLOAD_MIN || size >= f->compress_threshold_bytes)
+                return 0;
+
+        if (!journal_dictionary_wanted(f))
+                return 0;
+
+        d = journal_file_acquire_dictionary(f);
+        if (!d)
+                return -ENOMEM;
+        if (d->failed || d->samples_size >= JOURNAL_DICTIONARY_TRAINING_SIZE)
+                return 0;
+
+        if (!GREEDY_REALLOC(d->samples, d->samples_size + size) ||
+            !GREEDY_REALLOC(d->sample_sizes, d->n_samples + 1))
+                return -ENOMEM;
+
+        memcpy(d->samples + d->samples_size, data, size);
+        d->samples_size += size;
+        d->sample_sizes[d->n_samples++] = size;
+
+        return 1;
+}
+
+int journal_dictionary_maybe_train(JournalFile *f) {
+        _cleanup_(compress_dictionary_freep) CompressDictionary *c = NULL;
+        _cleanup_free_ void *dict = NULL;
+        JournalDictionary *d;
+        size_t dict_size, n_samples;
+        uint64_t p;
+        Object *o;
+        int r;
+
+        assert(f);
+
+        /* This appends an object, hence must not be called while the caller holds on to object pointers. */
+
+        d = f->dictionary;
+        if (!d || d->failed || d->samples_size < JOURNAL_DICTIONARY_TRAINING_SIZE)
+                return 0;
+
+        if (!journal_dictionary_wanted(f)) {
+                journal_dictionary_free_samples(d);
+                return 0;
+        }
+
+        n_samples = d->n_samples;
+        r = compress_dictionary_train_zstd(d->samples, d->sample_sizes, d->n_samples,
+                                           JOURNAL_DICTIONARY_SIZE_MAX, &dict, &dict_size);
+        journal_dictionary_free_samples(d);
+        if (r >= 0)
+                r = compress_dictionary_new_zstd(dict, dict_size, /* level = */ -1, &c);
+        if (r < 0) {
+                d->failed = true;
+                return log_debug_errno(r, "Failed to train compression dictionary for %s, not using one: %m", f->path);
+        }
+
+        r = journal_file_append_object(f, OBJECT_DICTIONARY, offsetof(Object, dictionary.payload) + dict_size, &o, &p);
+        if (r < 0)
+                return r;
+
+        memcpy(o->dictionary.payload, dict, dict_size);
+
+#if HAVE_GCRYPT
+        r = journal_file_hmac_put_object(f, OBJECT_DICTIONARY, o, p);
+        if (r < 0)
+                return r;
+#endif
+
+        /* Only reference the dictionary once it is fully written */
+        f->header->dictionary_offset = htole64(p);
+        d->dictionary = TAKE_PTR(c);
+
+        log_debug("Trained %zu byte compression dictionary from %zu samples for %s.", dict_size, n_samples, f->path);
+        return 1;
+}
@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "compress.h"
+#include "journal-file.h"
+
+/* An optional trained zstd dictionary, used for compressing DATA objects below the compression threshold,
+ * which would not shrink noticeably when compressed on their own. The dictionary is trained from the first
+ * such DATA objects appended to a file, stored in a DICTIONARY object referenced from the file header, and
+ * used for all small DATA objects appended afterwards. */
+
+/* Payloads this short never get smaller, not even with a dictionary */
+#define JOURNAL_DICTIONARY_PAYLOAD_MIN 16U
+
+typedef struct JournalDictionary JournalDictionary;
+
+bool journal_dictionary_enabled(void);
+
+JournalDictionary* journal_dictionary_free(JournalDictionary *d);
+DEFINE_TRIVIAL_CLEANUP_FUNC(JournalDictionary*, journal_dictionary_free);
+
+int journal_dictionary_get(JournalFile *f, CompressDictionary **ret);
+
+int journal_dictionary_add_sample(JournalFile *f, const void *data, size_t size);
+int journal_dictionary_maybe_train(JournalFile *f);
@@ -0,0 +1,263 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "env-util.h"
+#include "journal-fanout.h"
+#include "log.h"
+#include "missing_threads.h"
+#include "sort-util.h"
+
+typedef struct FanoutLocation {
+        uint64_t first;  /* Offset of the first entry array of the chain */
+        uint64_t offset; /* Offset of the ENTRY_ARRAY_FANOUT object describing it */
+} FanoutLocation;
+
+struct JournalFanout {
+        FanoutLocation *locations; /* Ordered by the first entry array */
+        size_t n_locations;
+};
+
+bool journal_fanout_enabled(void) {
+        static thread_local int cached = -1;
+        int r;
+
+        if (cached < 0) {
+                r = getenv_bool("SYSTEMD_JOURNAL_ENTRY_ARRAY_FANOUT");
+                if (r < 0) {
+                        if (r != -ENXIO)
+                                log_debug_errno(r, "Failed to parse $SYSTEMD_JOURNAL_ENTRY_ARRAY_FANOUT environment variable, ignoring: %m");
+                        cached = false;
+                } else
+                        cached = r;
+        }
+
+        return cached;
+}
+
+JournalFanout* journal_fanout_free(JournalFanout *x) {
+        if (!x)
+                return NULL;
+
+        free(x->locations);
+        return mfree(x);
+}
+
+static int fanout_location_compare(const FanoutLocation *a, const FanoutLocation *b) {
+        return CMP(a->first, b->first);
+}
+
+static int journal_fanout_load(JournalFile *f, JournalFanout *x) {
+        uint64_t p;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(x);
+
+        /* New objects are always prepended to the list, hence the offsets along it are strictly decreasing,
+         * which check_object() enforces, and which protects us from loops. */
+        p = le64toh(READ_NOW(f->header->entry_array_fanout_offset));
+        while (p != 0) {
+                Object o;
+
+                r = journal_file_read_object_header(f, OBJECT_ENTRY_ARRAY_FANOUT, p, &o);
+                if (r < 0)
+                        return r;
+
+                if (!GREEDY_REALLOC(x->locations, x->n_locations + 1))
+                        return -ENOMEM;
+
+                x->locations[x->n_locations++] = (FanoutLocation) {
+                        .first = le64toh(o.entry_array_fanout.first_entry_array_offset),
+                        .offset = p,
+                };
+
+                p = le64toh(o.entry_array_fanout.next_fanout_offset);
+        }
+
+        typesafe_qsort(x->locations, x->n_locations, fanout_location_compare);
+        return 0;
+}
+
+int journal_fanout_get(JournalFile *f, uint64_t first, Object **ret_object, uint64_t *ret_n_items) {
+        FanoutLocation *l;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(ret_object);
+        assert(ret_n_items);
+
+        if (!JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(f->header))
+                return 0;
+
+        if (!f->fanout) {
+                _cleanup_(journal_fanout_freep) JournalFanout *x = NULL;
+
+                x = new0(JournalFanout, 1);
+                if (!x)
+                        return -ENOMEM;
+
+                /* If the list is broken, remember that by keeping the empty lookup table, and walk the
+                 * chains the slow way from now on. */
+                r = journal_fanout_load(f, x);
+                if (r < 0) {
+                        log_debug_errno(r, "Failed to load entry array fan-out objects of %s, ignoring: %m", f->path);
+                        x->locations = mfree(x->locations);
+                        x->n_locations = 0;
+                }
+
+                f->fanout = TAKE_PTR(x);
+        }
+
+        l = typesafe_bsearch(&(FanoutLocation) { .first = first }, f->fanout->locations, f->fanout->n_locations, fanout_location_compare);
+        if (!l)
+                return 0;
+
+        r = journal_file_move_to_object(f, OBJECT_ENTRY_ARRAY_FANOUT, l->offset, &o);
+        if (r < 0)
+                return r;
+
+        if (le64toh(o->entry_array_fanout.first_entry_array_offset) != first)
+                return -EBADMSG;
+
+        *ret_object = o;
+        *ret_n_items = (le64toh(o->object.size) - offsetof(Object, entry_array_fanout.items)) / sizeof(EntryArrayFanoutItem);
+        return 1;
+}
+
+static bool journal_fanout_wanted(JournalFile *f) {
+        assert(f);
+        assert(f->header);
+
+        if (!journal_file_writable(f))
+                return false;
+
+        /* Files in older formats have no place to link the objects from */
+        if (!JOURNAL_HEADER_CONTAINS(f->header, entry_array_fanout_offset))
+                return false;
+
+        /* Already done? */
+        if (JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(f->header))
+                return false;
+
+        /* Objects appended after the last tag would not be covered by the seal, and would make the file
+         * fail verification. */
+        if (JOURNAL_HEADER_SEALED(f->header))
+                return false;
+
+        return journal_fanout_enabled();
+}
+
+static int journal_fanout_append(JournalFile *f, uint64_t first) {
+        _cleanup_free_ EntryArrayFanoutItem *items = NULL;
+        size_t n_items = 0;
+        uint64_t total = 0, p;
+        Object *o;
+        int r;
+
+        assert(f);
+
+        for (uint64_t a = first; a != 0; a = le64toh(o->entry_array.next_entry_array_offset)) {
+                uint64_t k, begin;
+
+                r = journal_file_move_to_object(f, OBJECT_ENTRY_ARRAY, a, &o);
+                if (r < 0)
+                        return r;
+
+                /* Only the last array of a chain may be partially filled, hence the item count of all
+                 * arrays but the last one is the number of entries in them. */
+                k = journal_file_entry_array_n_items(f, o);
+                begin = k > 0 ? journal_file_entry_array_item(f, o, 0) : 0;
+                if (begin == 0)
+                        break;
+
+                if (!GREEDY_REALLOC(items, n_items + 1))
+                        return -ENOMEM;
+
+                items[n_items++] = (EntryArrayFanoutItem) {
+                        .entry_array_offset = htole64(a),
+                        .begin = htole64(begin),
+                        .total = htole64(total),
+                };
+
+                total += k;
+        }
+
+        if (n_items < 2)
+                return 0;
+
+        r = journal_file_append_object(
+                        f,
+                        OBJECT_ENTRY_ARRAY_FANOUT,
+                        offsetof(Object, entry_array_fanout.items) + n_items * sizeof(EntryArrayFanoutItem),
+                        &o, &p);
+        if (r < 0)
+                return r;
+
+        o->entry_array_fanout.first_entry_array_offset = htole64(first);
+        o->entry_array_fanout.next_fanout_offset = f->header->entry_array_fanout_offset;
+        memcpy(o->entry_array_fanout.items, items, n_items * sizeof(EntryArrayFanoutItem));
+
+        f->header->entry_array_fanout_offset = htole64(p);
+        f->header->compatible_flags |= htole32(HEADER_COMPATIBLE_ENTRY_ARRAY_FANOUT);
+
+        return 1;
+}
+
+int journal_fanout_write(JournalFile *f) {
+        uint64_t p, sz;
+        unsigned n = 0;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        if (!journal_fanout_wanted(f))
+                return 0;
+
+        /* This appends objects, hence must not be called while the caller holds on to object pointers. */
+
+        if (le64toh(f->header->n_entries) >= JOURNAL_FANOUT_ENTRIES_MIN) {
+                r = journal_fanout_append(f, le64toh(f->header->entry_array_offset));
+                if (r < 0)
+                        return log_debug_errno(r, "Failed to write entry array fan-out of %s: %m", f->path);
+                n += r;
+        }
+
+        p = le64toh(f->header->data_hash_table_offset);
+        sz = le64toh(f->header->data_hash_table_size);
+
+        for (uint64_t i = 0; i < sz / sizeof(HashItem); i++) {
+                HashItem h;
+                ssize_t l;
+                Object o;
+
+                l = pread(f->fd, &h, sizeof(h), p + i * sizeof(HashItem));
+                if (l < 0)
+                        return log_debug_errno(errno, "Failed to read hash table item of %s: %m", f->path);
+                if (l != sizeof(h))
+                        return log_debug_errno(SYNTHETIC_ERRNO(EIO), "Short read of hash table item of %s.", f->path);
+
+                for (uint64_t q = le64toh(h.head_hash_offset); q != 0; q = le64toh(o.data.next_hash_offset)) {
+                        r = journal_file_read_object_header(f, OBJECT_DATA, q, &o);
+                        if (r < 0)
+                                return log_debug_errno(r, "Invalid data object in %s, not writing further entry array fan-outs: %m", f->path);
+
+                        /* The first entry of a data object is stored inline, not in its chain */
+                        if (le64toh(o.data.n_entries) <= JOURNAL_FANOUT_ENTRIES_MIN)
+                                continue;
+
+                        r = journal_fanout_append(f, le64toh(o.data.entry_array_offset));
+                        if (r < 0)
+                                return log_debug_errno(r, "Failed to write entry array fan-out of %s: %m", f->path);
+                        n += r;
+                }
+        }
+
+        log_debug("Wrote %u entry array fan-out objects to %s.", n, f->path);
+        return n > 0;
+}
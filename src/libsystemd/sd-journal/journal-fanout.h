@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "journal-file.h"
+
+/* Optional ENTRY_ARRAY_FANOUT objects, written when a file is archived. Each one describes a long entry
+ * array chain, and lists the offset, the first entry and the number of preceding entries of every entry
+ * array in it, so that lookups can bisect the arrays of the chain instead of walking it from its start.
+ * The objects are linked from the file header, and are flagged as a compatible feature, hence readers not
+ * knowing about them simply walk the chain as before. */
+
+/* Only chains with at least this many entries get a fan-out object. Entry arrays double in size along a
+ * chain, hence this corresponds to chains of roughly eight arrays. */
+#define JOURNAL_FANOUT_ENTRIES_MIN 1024U
+
+typedef struct JournalFanout JournalFanout;
+
+bool journal_fanout_enabled(void);
+
+JournalFanout* journal_fanout_free(JournalFanout *x);
+DEFINE_TRIVIAL_CLEANUP_FUNC(JournalFanout*, journal_fanout_free);
+
+int journal_fanout_get(JournalFile *f, uint64_t first, Object **ret_object, uint64_t *ret_n_items);
+
+int journal_fanout_write(JournalFile *f);
@@ -25,6 +25,10 @@
 #include "journal-authenticate.h"
 #include "journal-def.h"
 #include "journal-file.h"
+#include "journal-dictionary.h"
+#include "journal-fanout.h"
+#include "journal-index.h"
+#include "journal-unique-index.h"
 #include "journal-internal.h"
 #include "lookup3.h"
 #include "memory-util.h"
@@ -82,12 +86,33 @@
 /* How much to increase the journal file size at once each time we allocate something new. */
 #define FILE_SIZE_INCREASE (8 * U64_MB)                  /* 8MB */
 
+/* If a file needs to grow again within this time, double the increase, up to the maximum below, so that
+ * busy journals are not extended (and the header updated, and the mmap windows remapped) all the time.
+ * See journal_file_allocate(). */
+#define FILE_SIZE_INCREASE_FAST_USEC (30*USEC_PER_SEC)
+#define FILE_SIZE_INCREASE_MAX (128 * U64_MB)            /* 128MB */
+
 /* Reread fstat() of the file for detecting deletions at least this often */
 #define LAST_STAT_REFRESH_USEC (5*USEC_PER_SEC)
 
 /* Longest hash chain to rotate after */
 #define HASH_CHAIN_DEPTH_MAX 100
 
+/* Number of sets (of DATA_CACHE_WAYS entries each) in the cache of recently written DATA objects */
+#define DATA_CACHE_SETS 512U
+#define DATA_CACHE_WAYS 2U
+
+typedef struct DataCacheItem {
+        uint64_t hash;
+        uint64_t size;
+        uint64_t offset; /* 0 if unused */
+} DataCacheItem;
+
+typedef struct DataCacheSet {
+        DataCacheItem items[DATA_CACHE_WAYS];
+        unsigned lru; /* the least recently used item, i.e. the one to replace next */
+} DataCacheSet;
+
 #ifdef __clang__
 #  pragma GCC diagnostic ignored "-Waddress-of-packed-member"
 #endif
@@ -292,6 +317,11 @@ JournalFile* journal_file_close(JournalFile *f) {
         free(f->path);
 
         ordered_hashmap_free(f->chain_cache);
+        journal_index_free(f->index);
+        journal_unique_index_free(f->unique_index);
+        journal_dictionary_free(f->dictionary);
+        journal_fanout_free(f->fanout);
+        free(f->data_cache);
 
 #if HAVE_COMPRESSION
         free(f->compress_buffer);
@@ -411,7 +441,10 @@ static int journal_file_init_header(
                 .incompatible_flags = htole32(
                                 FLAGS_SET(file_flags, JOURNAL_COMPRESS) * COMPRESSION_TO_HEADER_INCOMPATIBLE_FLAG(compression_requested()) |
                                 keyed_hash_requested() * HEADER_INCOMPATIBLE_KEYED_HASH |
-                                compact_mode_requested() * HEADER_INCOMPATIBLE_COMPACT),
+                                compact_mode_requested() * HEADER_INCOMPATIBLE_COMPACT |
+                                (FLAGS_SET(file_flags, JOURNAL_COMPRESS) &&
+                                 compression_requested() == COMPRESSION_ZSTD &&
+                                 journal_dictionary_enabled()) * HEADER_INCOMPATIBLE_DICTIONARY),
                 .compatible_flags = htole32(
                                 (seal * (HEADER_COMPATIBLE_SEALED | HEADER_COMPATIBLE_SEALED_CONTINUOUS) ) |
                                 HEADER_COMPATIBLE_TAIL_ENTRY_BOOT_ID),
@@ -479,7 +512,7 @@ static bool warn_wrong_flags(const JournalFile *f, bool compatible) {
                                   f->path, type, flags & ~any);
                 flags = (flags & any) & ~supported;
                 if (flags) {
-                        const char* strv[6];
+                        const char* strv[7];
                         size_t n = 0;
                         _cleanup_free_ char *t = NULL;
 
@@ -488,6 +521,8 @@ static bool warn_wrong_flags(const JournalFile *f, bool compatible) {
                                         strv[n++] = "sealed";
                                 if (flags & HEADER_COMPATIBLE_SEALED_CONTINUOUS)
                                         strv[n++] = "sealed-continuous";
+                                if (flags & HEADER_COMPATIBLE_ENTRY_ARRAY_FANOUT)
+                                        strv[n++] = "entry-array-fanout";
                         } else {
                                 if (flags & HEADER_INCOMPATIBLE_COMPRESSED_XZ)
                                         strv[n++] = "xz-compressed";
@@ -499,6 +534,8 @@ static bool warn_wrong_flags(const JournalFile *f, bool compatible) {
                                         strv[n++] = "keyed-hash";
                                 if (flags & HEADER_INCOMPATIBLE_COMPACT)
                                         strv[n++] = "compact";
+                                if (flags & HEADER_INCOMPATIBLE_DICTIONARY)
+                                        strv[n++] = "dictionary";
                         }
                         strv[n] = NULL;
                         assert(n < ELEMENTSOF(strv));
@@ -654,6 +691,31 @@ static int journal_file_verify_header(JournalFile *f) {
                 }
         }
 
+        if (JOURNAL_HEADER_CONTAINS(f->header, dictionary_offset)) {
+                uint64_t offset = le64toh(f->header->dictionary_offset);
+
+                if (!offset_is_valid(offset, header_size, tail_object_offset))
+                        return -ENODATA;
+                /* The flag is set when the file is created, the dictionary is only added later on */
+                if (offset != 0 && !JOURNAL_HEADER_DICTIONARY(f->header))
+                        return -ENODATA;
+        } else if (JOURNAL_HEADER_DICTIONARY(f->header))
+                return -EBADMSG;
+
+        if (JOURNAL_HEADER_CONTAINS(f->header, entry_array_fanout_offset)) {
+                uint64_t offset = le64toh(f->header->entry_array_fanout_offset);
+
+                if (!offset_is_valid(offset, header_size, tail_object_offset))
+                        return -ENODATA;
+                if ((offset != 0) != JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(f->header))
+                        return -ENODATA;
+        } else if (JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(f->header))
+                return -EBADMSG;
+
+        /* Dictionaries are only defined for zstd */
+        if (JOURNAL_HEADER_DICTIONARY(f->header) && !JOURNAL_HEADER_COMPRESSED_ZSTD(f->header))
+                return -EBADMSG;
+
         /* Verify number of objects */
         uint64_t n_objects = le64toh(f->header->n_objects);
         if (n_objects > arena_size / sizeof(ObjectHeader))
@@ -786,16 +848,16 @@ static int journal_file_allocate(JournalFile *f, uint64_t offset, uint64_t size)
         if (f->metrics.max_size > 0 && new_size > f->metrics.max_size)
                 return -E2BIG;
 
-        /* Refuse to go over 4G in compact mode so offsets can be stored in 32-bit. */
-        if (JOURNAL_HEADER_COMPACT(f->header) && new_size > UINT32_MAX)
+        /* Refuse to go over 4G in compact mode so offsets can be stored in 32-bit. Use the same limit as for
+         * capping the rounded up size below, so that this can never end up below what is required. */
+        if (JOURNAL_HEADER_COMPACT(f->header) && new_size > PAGE_ALIGN_DOWN_U64(UINT32_MAX))
                 return -E2BIG;
 
+        uint64_t available = UINT64_MAX;
         if (new_size > f->metrics.min_size && f->metrics.keep_free > 0) {
                 struct statvfs svfs;
 
                 if (fstatvfs(f->fd, &svfs) >= 0) {
-                        uint64_t available;
-
                         available = LESS_BY(u64_multiply_safe(svfs.f_bfree, svfs.f_bsize), f->metrics.keep_free);
 
                         if (new_size - old_size > available)
@@ -803,10 +865,29 @@ static int journal_file_allocate(JournalFile *f, uint64_t offset, uint64_t size)
                 }
         }
 
-        /* Increase by larger blocks at once */
-        new_size = ROUND_UP(new_size, FILE_SIZE_INCREASE);
+        /* Scale the increase with how quickly the file grows: double it if the last increase didn't last
+         * long, go back to the default if the file hasn't grown for a while, and otherwise stick to it. */
+        usec_t n = now(CLOCK_MONOTONIC);
+        if (f->last_allocate_usec > 0 && n < usec_add(f->last_allocate_usec, FILE_SIZE_INCREASE_FAST_USEC))
+                f->size_increase = MIN(MAX(f->size_increase, FILE_SIZE_INCREASE) * 2, FILE_SIZE_INCREASE_MAX);
+        else if (f->last_allocate_usec == 0 || n >= usec_add(f->last_allocate_usec, 4 * FILE_SIZE_INCREASE_FAST_USEC))
+                f->size_increase = FILE_SIZE_INCREASE;
+        f->last_allocate_usec = n;
+
+        /* Increase by larger blocks at once, but only as far as the free space allows */
+        uint64_t rounded_size = ROUND_UP(new_size, FILE_SIZE_INCREASE);
+        if (f->size_increase > FILE_SIZE_INCREASE && old_size <= UINT64_MAX - f->size_increase) {
+                uint64_t grown_size = ROUND_UP(old_size + f->size_increase, FILE_SIZE_INCREASE);
+
+                if (grown_size > rounded_size && grown_size - old_size <= available)
+                        rounded_size = grown_size;
+        }
+
+        new_size = rounded_size;
         if (f->metrics.max_size > 0 && new_size > f->metrics.max_size)
                 new_size = f->metrics.max_size;
+        if (JOURNAL_HEADER_COMPACT(f->header) && new_size > PAGE_ALIGN_DOWN_U64(UINT32_MAX))
+                new_size = PAGE_ALIGN_DOWN_U64(UINT32_MAX);
 
         /* Note that the glibc fallocate() fallback is very
            inefficient, hence we try to minimize the allocation area
@@ -869,6 +950,8 @@ static uint64_t minimum_header_size(JournalFile *f, Object *o) {
                 [OBJECT_FIELD_HASH_TABLE] = sizeof(HashTableObject),
                 [OBJECT_ENTRY_ARRAY]      = sizeof(EntryArrayObject),
                 [OBJECT_TAG]              = sizeof(TagObject),
+                [OBJECT_DICTIONARY]       = sizeof(DictionaryObject),
+                [OBJECT_ENTRY_ARRAY_FANOUT] = sizeof(EntryArrayFanoutObject),
         };
 
         assert(f);
@@ -1072,6 +1155,45 @@ static int check_object(JournalFile *f, Object *o, uint64_t offset) {
                                                le64toh(o->tag.epoch), offset);
 
                 break;
+
+        case OBJECT_DICTIONARY:
+                if (le64toh(o->object.size) <= offsetof(Object, dictionary.payload))
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Bad dictionary size (<= %zu): %" PRIu64 ": %" PRIu64,
+                                               offsetof(Object, dictionary.payload),
+                                               le64toh(o->object.size),
+                                               offset);
+                break;
+
+        case OBJECT_ENTRY_ARRAY_FANOUT: {
+                uint64_t sz, first, next;
+
+                sz = le64toh(READ_NOW(o->object.size));
+                if (sz < offsetof(Object, entry_array_fanout.items) ||
+                    (sz - offsetof(Object, entry_array_fanout.items)) % sizeof(EntryArrayFanoutItem) != 0 ||
+                    (sz - offsetof(Object, entry_array_fanout.items)) / sizeof(EntryArrayFanoutItem) <= 0)
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Invalid object entry array fan-out size: %" PRIu64 ": %" PRIu64,
+                                               sz,
+                                               offset);
+
+                first = le64toh(o->entry_array_fanout.first_entry_array_offset);
+                if (!VALID64(first) || first == 0 || first >= offset)
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Invalid object entry array fan-out first_entry_array_offset: %" PRIu64 ": %" PRIu64,
+                                               first,
+                                               offset);
+
+                /* Fan-out objects are prepended to their list, hence the offsets are strictly decreasing. */
+                next = le64toh(o->entry_array_fanout.next_fanout_offset);
+                if (!VALID64(next) || next >= offset)
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Invalid object entry array fan-out next_fanout_offset: %" PRIu64 ": %" PRIu64,
+                                               next,
+                                               offset);
+
+                break;
+        }
         }
 
         return 0;
@@ -1798,30 +1920,147 @@ static int journal_file_append_field(
         return 0;
 }
 
-static int maybe_compress_payload(JournalFile *f, uint8_t *dst, const uint8_t *src, uint64_t size, size_t *rsize) {
+static int maybe_compress_payload(
+                JournalFile *f,
+                uint8_t *dst,
+                const uint8_t *src,
+                uint64_t size,
+                size_t *rsize,
+                uint8_t *ret_flags) {
+
         assert(f);
         assert(f->header);
+        assert(ret_flags);
 
 #if HAVE_COMPRESSION
         Compression c;
         int r;
 
         c = JOURNAL_FILE_COMPRESSION(f);
-        if (c == COMPRESSION_NONE || size < f->compress_threshold_bytes)
+        if (c == COMPRESSION_NONE)
                 return 0;
 
+        if (size < f->compress_threshold_bytes) {
+                CompressDictionary *d;
+
+                /* Small payloads are only worth compressing with a trained dictionary */
+                if (size < JOURNAL_DICTIONARY_PAYLOAD_MIN)
+                        return 0;
+
+                r = journal_dictionary_get(f, &d);
+                if (r < 0)
+                        return log_debug_errno(r, "Failed to acquire compression dictionary, ignoring: %m");
+                if (r == 0)
+                        return 0;
+
+                r = compress_blob_zstd_dictionary(d, src, size, dst, size - 1, rsize);
+                if (r == -ENOBUFS) /* Didn't get any smaller, not worth logging about */
+                        return 0;
+                if (r < 0)
+                        return log_debug_errno(r, "Failed to compress data object using dictionary, ignoring: %m");
+
+                *ret_flags = OBJECT_COMPRESSED_ZSTD | OBJECT_COMPRESSED_DICTIONARY;
+                return 1; /* compressed */
+        }
+
         r = compress_blob(c, src, size, dst, size - 1, rsize, /* level = */ -1);
         if (r < 0)
                 return log_debug_errno(r, "Failed to compress data object using %s, ignoring: %m", compression_to_string(c));
 
         log_debug("Compressed data object %"PRIu64" -> %zu using %s", size, *rsize, compression_to_string(c));
 
+        *ret_flags = COMPRESSION_TO_OBJECT_FLAG(c);
         return 1; /* compressed */
 #else
         return 0;
 #endif
 }
 
+static int data_cache_lookup(
+                JournalFile *f,
+                const void *data,
+                uint64_t size,
+                uint64_t hash,
+                Object **ret_object,
+                uint64_t *ret_offset) {
+
+        DataCacheSet *set;
+        int r;
+
+        assert(f);
+        assert(data);
+
+        /* Most fields (_HOSTNAME=, _BOOT_ID=, _SYSTEMD_UNIT=, …) are identical across a huge number of
+         * entries. Remember the DATA objects we recently wrote, so that we don't have to walk the hash
+         * chains for them again and again. */
+
+        if (!f->data_cache) {
+                f->data_cache = new0(DataCacheSet, DATA_CACHE_SETS);
+                if (!f->data_cache)
+                        return 0; /* Not fatal, we'll just walk the hash chains. */
+        }
+
+        set = f->data_cache + hash % DATA_CACHE_SETS;
+
+        for (unsigned i = 0; i < DATA_CACHE_WAYS; i++) {
+                DataCacheItem *c = set->items + i;
+                size_t rsize;
+                Object *o;
+                void *d;
+
+                if (c->offset == 0 || c->hash != hash || c->size != size)
+                        continue;
+
+                r = journal_file_move_to_object(f, OBJECT_DATA, c->offset, &o);
+                if (r < 0)
+                        return r;
+
+                /* Only uncompressed or dictionary compressed (i.e. small) objects are cached, hence this
+                 * is cheap. But don't trust the hash alone, in case of a collision we'll find the right
+                 * object on the hash chain. */
+                r = journal_file_data_payload(f, o, c->offset, NULL, 0, 0, &d, &rsize);
+                if (r < 0)
+                        return r;
+                if (memcmp_nn(data, size, d, rsize) != 0)
+                        break;
+
+                set->lru = (i + 1) % DATA_CACHE_WAYS;
+                f->data_cache_hits++;
+
+                if (ret_object)
+                        *ret_object = o;
+                if (ret_offset)
+                        *ret_offset = c->offset;
+                return 1;
+        }
+
+        f->data_cache_misses++;
+        return 0;
+}
+
+static void data_cache_put(JournalFile *f, Object *o, uint64_t size, uint64_t hash, uint64_t offset) {
+        DataCacheSet *set;
+
+        assert(f);
+        assert(o);
+
+        if (!f->data_cache)
+                return;
+
+        /* Comparing compressed objects would require decompressing them, so don't bother, except for the
+         * small ones compressed with the dictionary. */
+        if ((o->object.flags & _OBJECT_COMPRESSED_MASK) && !(o->object.flags & OBJECT_COMPRESSED_DICTIONARY))
+                return;
+
+        set = f->data_cache + hash % DATA_CACHE_SETS;
+        set->items[set->lru] = (DataCacheItem) {
+                .hash = hash,
+                .size = size,
+                .offset = offset,
+        };
+        set->lru = (set->lru + 1) % DATA_CACHE_WAYS;
+}
+
 static int journal_file_append_data(
                 JournalFile *f,
                 const void *data,
@@ -1832,6 +2071,7 @@ static int journal_file_append_data(
         uint64_t hash, p, osize;
         Object *o, *fo;
         size_t rsize = 0;
+        uint8_t flags = 0;
         const void *eq;
         int r;
 
@@ -1842,12 +2082,25 @@ static int journal_file_append_data(
 
         hash = journal_file_hash_data(f, data, size);
 
-        r = journal_file_find_data_object_with_hash(f, data, size, hash, ret_object, ret_offset);
+        r = data_cache_lookup(f, data, size, hash, ret_object, ret_offset);
         if (r < 0)
                 return r;
         if (r > 0)
                 return 0;
 
+        r = journal_file_find_data_object_with_hash(f, data, size, hash, &o, &p);
+        if (r < 0)
+                return r;
+        if (r > 0) {
+                data_cache_put(f, o, size, hash, p);
+
+                if (ret_object)
+                        *ret_object = o;
+                if (ret_offset)
+                        *ret_offset = p;
+                return 0;
+        }
+
         eq = memchr(data, '=', size);
         if (!eq)
                 return -EINVAL;
@@ -1859,17 +2112,20 @@ static int journal_file_append_data(
 
         o->data.hash = htole64(hash);
 
-        r = maybe_compress_payload(f, journal_file_data_payload_field(f, o), data, size, &rsize);
-        if (r <= 0)
+        r = maybe_compress_payload(f, journal_file_data_payload_field(f, o), data, size, &rsize, &flags);
+        if (r <= 0) {
                 /* We don't really care failures, let's continue without compression */
                 memcpy_safe(journal_file_data_payload_field(f, o), data, size);
-        else {
-                Compression c = JOURNAL_FILE_COMPRESSION(f);
 
-                assert(c >= 0 && c < _COMPRESSION_MAX && c != COMPRESSION_NONE);
+                /* Until the file has a dictionary, small payloads end up here. Use them for training it. */
+                r = journal_dictionary_add_sample(f, data, size);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to add data object as dictionary sample, ignoring: %m");
+        } else {
+                assert(flags != 0);
 
                 o->object.size = htole64(journal_file_data_payload_offset(f) + rsize);
-                o->object.flags |= COMPRESSION_TO_OBJECT_FLAG(c);
+                o->object.flags |= flags;
         }
 
         r = journal_file_link_data(f, o, p, hash);
@@ -1896,6 +2152,8 @@ static int journal_file_append_data(
         o->data.next_field_offset = fo->field.head_data_offset;
         fo->field.head_data_offset = le64toh(p);
 
+        data_cache_put(f, o, size, hash, p);
+
         if (ret_object)
                 *ret_object = o;
 
@@ -1910,6 +2168,7 @@ static int maybe_decompress_payload(
                 uint8_t *payload,
                 uint64_t size,
                 Compression compression,
+                CompressDictionary *dictionary,
                 const char *field,
                 size_t field_length,
                 size_t data_threshold,
@@ -1928,8 +2187,13 @@ static int maybe_decompress_payload(
                 int r;
 
                 if (field) {
-                        r = decompress_startswith(compression, payload, size, &f->compress_buffer, field,
-                                                  field_length, '=');
+                        if (dictionary)
+                                r = decompress_startswith_zstd_dictionary(dictionary, payload, size,
+                                                                          &f->compress_buffer, field,
+                                                                          field_length, '=');
+                        else
+                                r = decompress_startswith(compression, payload, size, &f->compress_buffer, field,
+                                                          field_length, '=');
                         if (r < 0)
                                 return log_debug_errno(r,
                                                        "Cannot decompress %s object of length %" PRIu64 ": %m",
@@ -1944,7 +2208,10 @@ static int maybe_decompress_payload(
                         }
                 }
 
-                r = decompress_blob(compression, payload, size, &f->compress_buffer, &rsize, 0);
+                if (dictionary)
+                        r = decompress_blob_zstd_dictionary(dictionary, payload, size, &f->compress_buffer, &rsize, 0);
+                else
+                        r = decompress_blob(compression, payload, size, &f->compress_buffer, &rsize, 0);
                 if (r < 0)
                         return r;
 
@@ -1973,43 +2240,178 @@ static int maybe_decompress_payload(
         return 1;
 }
 
-int journal_file_data_payload(
+static int journal_file_data_payload_prepare(
                 JournalFile *f,
-                Object *o,
+                Object **o,
                 uint64_t offset,
-                const char *field,
-                size_t field_length,
-                size_t data_threshold,
-                void **ret_data,
-                size_t *ret_size) {
+                uint64_t *ret_size,
+                Compression *ret_compression,
+                CompressDictionary **ret_dictionary) {
 
+        CompressDictionary *d = NULL;
         uint64_t size;
         Compression c;
         int r;
 
         assert(f);
-        assert(!field == (field_length == 0)); /* These must be specified together. */
+        assert(o);
+        assert(ret_size);
+        assert(ret_compression);
+        assert(ret_dictionary);
 
-        if (!o) {
-                r = journal_file_move_to_object(f, OBJECT_DATA, offset, &o);
+        if (!*o) {
+                r = journal_file_move_to_object(f, OBJECT_DATA, offset, o);
                 if (r < 0)
                         return r;
         }
 
-        size = le64toh(READ_NOW(o->object.size));
+        size = le64toh(READ_NOW((*o)->object.size));
         if (size < journal_file_data_payload_offset(f))
                 return -EBADMSG;
 
         size -= journal_file_data_payload_offset(f);
 
-        c = COMPRESSION_FROM_OBJECT(o);
+        c = COMPRESSION_FROM_OBJECT(*o);
         if (c < 0)
                 return -EPROTONOSUPPORT;
 
-        return maybe_decompress_payload(f, journal_file_data_payload_field(f, o), size, c, field,
+        if (FLAGS_SET((*o)->object.flags, OBJECT_COMPRESSED_DICTIONARY)) {
+                if (c != COMPRESSION_ZSTD)
+                        return -EBADMSG;
+
+                /* The dictionary lives in its own mmap cache category, hence this doesn't invalidate 'o' */
+                r = journal_dictionary_get(f, &d);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        return -EBADMSG;
+        }
+
+        *ret_size = size;
+        *ret_compression = c;
+        *ret_dictionary = d;
+        return 0;
+}
+
+int journal_file_data_payload(
+                JournalFile *f,
+                Object *o,
+                uint64_t offset,
+                const char *field,
+                size_t field_length,
+                size_t data_threshold,
+                void **ret_data,
+                size_t *ret_size) {
+
+        CompressDictionary *d;
+        uint64_t size;
+        Compression c;
+        int r;
+
+        assert(f);
+        assert(!field == (field_length == 0)); /* These must be specified together. */
+
+        r = journal_file_data_payload_prepare(f, &o, offset, &size, &c, &d);
+        if (r < 0)
+                return r;
+
+        return maybe_decompress_payload(f, journal_file_data_payload_field(f, o), size, c, d, field,
                                         field_length, data_threshold, ret_data, ret_size);
 }
 
+static bool payload_matches_fields(const uint8_t *p, size_t size, char * const *fields) {
+        STRV_FOREACH(field, fields) {
+                size_t l = strlen(*field);
+
+                if (size >= l + 1 && memcmp(p, *field, l) == 0 && p[l] == '=')
+                        return true;
+        }
+
+        return false;
+}
+
+int journal_file_data_payload_filtered(
+                JournalFile *f,
+                Object *o,
+                uint64_t offset,
+                char * const *fields,
+                size_t data_threshold,
+                void **ret_data,
+                size_t *ret_size) {
+
+        CompressDictionary *d;
+        uint8_t *payload;
+        uint64_t size;
+        Compression c;
+        int r;
+
+        assert(f);
+
+        /* Like journal_file_data_payload(), but checks the payload against a whole list of field names at
+         * once. For compressed objects only a prefix long enough to cover the longest field name is
+         * decompressed first, so that objects not matching any of the fields are never decompressed in
+         * full, and we don't have to decompress the prefix once for each field either. Returns 0 if the
+         * object matches none of the fields. */
+
+        if (strv_isempty(fields))
+                return journal_file_data_payload(f, o, offset, NULL, 0, data_threshold, ret_data, ret_size);
+
+        r = journal_file_data_payload_prepare(f, &o, offset, &size, &c, &d);
+        if (r < 0)
+                return r;
+
+        payload = journal_file_data_payload_field(f, o);
+
+        if (c == COMPRESSION_NONE) {
+                if (!payload_matches_fields(payload, size, fields)) {
+                        if (ret_data)
+                                *ret_data = NULL;
+                        if (ret_size)
+                                *ret_size = 0;
+                        return 0;
+                }
+
+                return maybe_decompress_payload(f, payload, size, c, d, NULL, 0, data_threshold, ret_data, ret_size);
+        }
+
+#if HAVE_COMPRESSION
+        size_t rsize, prefix_max = 0;
+
+        STRV_FOREACH(field, fields)
+                prefix_max = MAX(prefix_max, strlen(*field) + 1);
+
+        if (d)
+                r = decompress_blob_zstd_dictionary(d, payload, size, &f->compress_buffer, &rsize, prefix_max);
+        else
+                r = decompress_blob(c, payload, size, &f->compress_buffer, &rsize, prefix_max);
+        if (r < 0)
+                return log_debug_errno(r, "Cannot decompress %s object of length %" PRIu64 ": %m",
+                                       compression_to_string(c), size);
+
+        if (!payload_matches_fields(f->compress_buffer, rsize, fields)) {
+                if (ret_data)
+                        *ret_data = NULL;
+                if (ret_size)
+                        *ret_size = 0;
+                return 0;
+        }
+
+        /* The decoders return at most prefix_max bytes, except for lz4 which always decompresses
+         * everything. Either way, if we got something other than exactly the prefix, we got all of it. */
+        if (rsize != prefix_max) {
+                if (ret_data)
+                        *ret_data = f->compress_buffer;
+                if (ret_size)
+                        *ret_size = rsize;
+                return 1;
+        }
+
+        return maybe_decompress_payload(f, payload, size, c, d, NULL, 0, data_threshold, ret_data, ret_size);
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
 uint64_t journal_file_entry_n_items(JournalFile *f, Object *o) {
         uint64_t sz;
 
@@ -2501,10 +2903,11 @@ static size_t remove_duplicate_entry_items(EntryItem items[], size_t n) {
         return j;
 }
 
-int journal_file_append_entry(
+static int journal_file_append_entry_one(
                 JournalFile *f,
                 const dual_timestamp *ts,
                 const sd_id128_t *boot_id,
+                const sd_id128_t *machine_id,
                 const struct iovec iovec[],
                 size_t n_iovec,
                 uint64_t *seqnum,
@@ -2516,7 +2919,6 @@ int journal_file_append_entry(
         EntryItem *items;
         uint64_t xor_hash = 0;
         struct dual_timestamp _ts;
-        sd_id128_t _boot_id, _machine_id, *machine_id;
         int r;
 
         assert(f);
@@ -2538,25 +2940,10 @@ int journal_file_append_entry(
                 ts = &_ts;
         }
 
-        if (boot_id) {
-                if (sd_id128_is_null(*boot_id))
-                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG), "Empty boot ID, refusing entry.");
-        } else {
-                r = sd_id128_get_boot(&_boot_id);
-                if (r < 0)
-                        return r;
-
-                boot_id = &_boot_id;
-        }
+        assert(boot_id);
 
-        r = sd_id128_get_machine(&_machine_id);
-        if (ERRNO_IS_NEG_MACHINE_ID_UNSET(r))
-                /* Gracefully handle the machine ID not being initialized yet */
-                machine_id = NULL;
-        else if (r < 0)
-                return r;
-        else
-                machine_id = &_machine_id;
+        if (sd_id128_is_null(*boot_id))
+                return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG), "Empty boot ID, refusing entry.");
 
 #if HAVE_GCRYPT
         r = journal_file_maybe_append_tag(f, ts->realtime);
@@ -2564,6 +2951,10 @@ int journal_file_append_entry(
                 return r;
 #endif
 
+        r = journal_dictionary_maybe_train(f);
+        if (r < 0)
+                log_debug_errno(r, "Failed to add compression dictionary to %s, ignoring: %m", f->path);
+
         if (n_iovec < ALLOCA_MAX / sizeof(EntryItem) / 2)
                 items = newa(EntryItem, n_iovec);
         else {
@@ -2607,7 +2998,7 @@ int journal_file_append_entry(
         typesafe_qsort(items, n_iovec, entry_item_cmp);
         n_iovec = remove_duplicate_entry_items(items, n_iovec);
 
-        r = journal_file_append_entry_internal(
+        return journal_file_append_entry_internal(
                         f,
                         ts,
                         boot_id,
@@ -2619,6 +3010,75 @@ int journal_file_append_entry(
                         seqnum_id,
                         ret_object,
                         ret_offset);
+}
+
+static int get_boot_and_machine_id(sd_id128_t *ret_boot_id, sd_id128_t *ret_machine_id, bool *ret_have_machine_id) {
+        int r;
+
+        assert(ret_machine_id);
+        assert(ret_have_machine_id);
+
+        if (ret_boot_id) {
+                r = sd_id128_get_boot(ret_boot_id);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_id128_get_machine(ret_machine_id);
+        if (ERRNO_IS_NEG_MACHINE_ID_UNSET(r)) {
+                /* Gracefully handle the machine ID not being initialized yet */
+                *ret_have_machine_id = false;
+                return 0;
+        }
+        if (r < 0)
+                return r;
+
+        *ret_have_machine_id = true;
+        return 0;
+}
+
+static void journal_file_append_finish(JournalFile *f) {
+        assert(f);
+
+        if (f->post_change_timer)
+                schedule_post_change(f);
+        else
+                journal_file_post_change(f);
+}
+
+int journal_file_append_entry(
+                JournalFile *f,
+                const dual_timestamp *ts,
+                const sd_id128_t *boot_id,
+                const struct iovec iovec[],
+                size_t n_iovec,
+                uint64_t *seqnum,
+                sd_id128_t *seqnum_id,
+                Object **ret_object,
+                uint64_t *ret_offset) {
+
+        sd_id128_t _boot_id, machine_id;
+        bool have_machine_id;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        r = get_boot_and_machine_id(boot_id ? NULL : &_boot_id, &machine_id, &have_machine_id);
+        if (r < 0)
+                return r;
+
+        r = journal_file_append_entry_one(
+                        f,
+                        ts,
+                        boot_id ?: &_boot_id,
+                        have_machine_id ? &machine_id : NULL,
+                        iovec,
+                        n_iovec,
+                        seqnum,
+                        seqnum_id,
+                        ret_object,
+                        ret_offset);
 
         /* If the memory mapping triggered a SIGBUS then we return an
          * IO error and ignore the error code passed down to us, since
@@ -2628,14 +3088,76 @@ int journal_file_append_entry(
         if (mmap_cache_fd_got_sigbus(f->cache_fd))
                 r = -EIO;
 
-        if (f->post_change_timer)
-                schedule_post_change(f);
-        else
-                journal_file_post_change(f);
+        journal_file_append_finish(f);
 
         return r;
 }
 
+int journal_file_append_entries(
+                JournalFile *f,
+                const JournalFileAppendEntry entries[],
+                size_t n_entries,
+                uint64_t *seqnum,
+                sd_id128_t *seqnum_id,
+                size_t *ret_n_appended) {
+
+        sd_id128_t _boot_id, machine_id;
+        bool have_machine_id;
+        size_t n = 0;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(entries || n_entries == 0);
+
+        /* Appends a series of entries in one go. This is equivalent to calling journal_file_append_entry()
+         * for each of them, except that the boot and machine IDs are only acquired once, and that the
+         * inotify notification (or scheduling of it) is only done once for the whole batch. Stops at the
+         * first entry that cannot be appended, and returns the number of entries that were successfully
+         * appended before it in 'ret_n_appended', so that the caller may retry the rest, for example after
+         * rotating the file. */
+
+        if (n_entries == 0) {
+                if (ret_n_appended)
+                        *ret_n_appended = 0;
+                return 0;
+        }
+
+        r = get_boot_and_machine_id(&_boot_id, &machine_id, &have_machine_id);
+        if (r < 0)
+                goto finish;
+
+        FOREACH_ARRAY(e, entries, n_entries) {
+                r = journal_file_append_entry_one(
+                                f,
+                                e->ts,
+                                e->boot_id ?: &_boot_id,
+                                have_machine_id ? &machine_id : NULL,
+                                e->iovec,
+                                e->n_iovec,
+                                seqnum,
+                                seqnum_id,
+                                /* ret_object= */ NULL,
+                                /* ret_offset= */ NULL);
+
+                /* See above, a SIGBUS trumps any other error. */
+                if (mmap_cache_fd_got_sigbus(f->cache_fd))
+                        r = -EIO;
+                if (r < 0)
+                        break;
+
+                n++;
+        }
+
+finish:
+        journal_file_append_finish(f);
+
+        if (ret_n_appended)
+                *ret_n_appended = n;
+
+        return r < 0 ? r : 0;
+}
+
 typedef struct ChainCacheItem {
         uint64_t first; /* The offset of the entry array object at the beginning of the chain,
                          * i.e., le64toh(f->header->entry_array_offset), or le64toh(o->data.entry_offset). */
@@ -2752,6 +3274,54 @@ static int bump_entry_array(
         return *ret > 0;
 }
 
+static int generic_array_fanout_get(
+                JournalFile *f,
+                uint64_t first,
+                uint64_t i,          /* The index of the target object counted from the beginning of the chain. */
+                uint64_t *ret_array,
+                uint64_t *ret_total) {
+
+        const EntryArrayFanoutItem *items;
+        uint64_t n, left, right;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(ret_array);
+        assert(ret_total);
+
+        /* Looks up the entry array containing the i-th object of the chain in its fan-out object, if it has
+         * one. Returns 0 if not, or if it would not allow skipping anything. */
+
+        if (i == 0)
+                return 0;
+
+        r = journal_fanout_get(f, first, &o, &n);
+        if (r <= 0)
+                return r;
+
+        items = o->entry_array_fanout.items;
+
+        /* Find the last array with fewer entries before it than the index, like for the chain cache. */
+        left = 0;
+        right = n - 1;
+        while (left < right) {
+                uint64_t m = right - (right - left) / 2;
+
+                if (le64toh(items[m].total) < i)
+                        left = m;
+                else
+                        right = m - 1;
+        }
+
+        if (left == 0)
+                return 0;
+
+        *ret_array = le64toh(items[left].entry_array_offset);
+        *ret_total = le64toh(items[left].total);
+        return 1;
+}
+
 static int generic_array_get(
                 JournalFile *f,
                 uint64_t first,         /* The offset of the first entry array object in the chain. */
@@ -2760,7 +3330,7 @@ static int generic_array_get(
                 Object **ret_object,    /* The found object. */
                 uint64_t *ret_offset) { /* The offset of the found object. */
 
-        uint64_t a, t = 0, k = 0; /* Explicit initialization of k to appease gcc */
+        uint64_t a, t = 0, k = 0, fa, ft; /* Explicit initialization of k to appease gcc */
         ChainCacheItem *ci;
         Object *o = NULL;
         int r;
@@ -2779,6 +3349,16 @@ static int generic_array_get(
                 t = ci->total;
         }
 
+        /* If the chain has a fan-out object, maybe it allows us to skip even further ahead */
+        r = generic_array_fanout_get(f, first, i + t, &fa, &ft);
+        if (r < 0)
+                log_debug_errno(r, "Failed to look up entry array fan-out, ignoring: %m");
+        else if (r > 0 && ft > t) {
+                a = fa;
+                i -= ft - t;
+                t = ft;
+        }
+
         while (a > 0) {
                 r = journal_file_move_to_object(f, OBJECT_ENTRY_ARRAY, a, &o);
                 if (IN_SET(r, -EBADMSG, -EADDRNOTAVAIL)) {
@@ -2972,6 +3552,74 @@ static int generic_array_bisect_step(
         return r;
 }
 
+static int generic_array_fanout_bisect(
+                JournalFile *f,
+                uint64_t first,
+                uint64_t n,          /* The total number of elements in the chain. */
+                uint64_t needle,
+                int (*test_object)(JournalFile *f, uint64_t p, uint64_t needle),
+                uint64_t *ret_array,
+                uint64_t *ret_total) {
+
+        const EntryArrayFanoutItem *items;
+        uint64_t n_items, left, right, found = 0;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(test_object);
+        assert(ret_array);
+        assert(ret_total);
+
+        /* Looks up the last entry array whose first object is left of the needle in the fan-out object of
+         * the chain, if it has one. The needle can't be in any array before that one, hence bisecting the
+         * arrays here replaces walking the chain from its start. Returns 0 if there is no fan-out object,
+         * or if it would not allow skipping anything. */
+
+        r = journal_fanout_get(f, first, &o, &n_items);
+        if (r <= 0)
+                return r;
+
+        items = o->entry_array_fanout.items;
+
+        /* Only consider the arrays within the first n objects of the chain */
+        left = 1;
+        right = n_items;
+        while (left < right) {
+                uint64_t m = left + (right - left) / 2;
+
+                if (le64toh(items[m].total) < n)
+                        left = m + 1;
+                else
+                        right = m;
+        }
+
+        /* Now bisect the arrays [1, left) on their first object. The fan-out object lives in its own mmap
+         * cache category, hence testing entries doesn't invalidate 'o'. */
+        right = left;
+        left = 1;
+        while (left < right) {
+                uint64_t m = left + (right - left) / 2;
+
+                r = test_object(f, le64toh(items[m].begin), needle);
+                if (r < 0)
+                        return r;
+
+                if (r == TEST_LEFT) {
+                        found = m;
+                        left = m + 1;
+                } else
+                        right = m;
+        }
+
+        if (found == 0)
+                return 0;
+
+        *ret_array = le64toh(items[found].entry_array_offset);
+        *ret_total = le64toh(items[found].total);
+        return 1;
+}
+
 static int generic_array_bisect(
                 JournalFile *f,
                 uint64_t first,  /* The offset of the first entry array object in the chain. */
@@ -2999,7 +3647,7 @@ static int generic_array_bisect(
          * If there are multiple objects that test_object() return TEST_FOUND for, then the first matching
          * object returned when direction is DIRECTION_DOWN. Otherwise the last object is returned. */
 
-        uint64_t a, p, t = 0, i, last_index = UINT64_MAX;
+        uint64_t a, p, t = 0, i, fa, ft, last_index = UINT64_MAX;
         ChainCacheItem *ci;
         Object *array;
         int r;
@@ -3035,6 +3683,19 @@ static int generic_array_bisect(
                 }
         }
 
+        /* If the chain has a fan-out object, bisect its arrays rather than walking them one by one */
+        r = generic_array_fanout_bisect(f, first, n + t, needle, test_object, &fa, &ft);
+        if (IN_SET(r, -EBADMSG, -EADDRNOTAVAIL))
+                log_debug_errno(r, "Entry array fan-out is corrupted, ignoring: %m");
+        else if (r < 0)
+                return r;
+        else if (r > 0 && ft > t) {
+                a = fa;
+                n -= ft - t;
+                t = ft;
+                last_index = UINT64_MAX;
+        }
+
         while (a > 0) {
                 uint64_t left, right, k, m, m_original;
 
@@ -3828,8 +4489,9 @@ void journal_file_dump(JournalFile *f) {
 
                 c = COMPRESSION_FROM_OBJECT(o);
                 if (c > COMPRESSION_NONE)
-                        log_info("Flags: %s\n",
-                                 compression_to_string(c));
+                        log_info("Flags: %s%s\n",
+                                 compression_to_string(c),
+                                 FLAGS_SET(o->object.flags, OBJECT_COMPRESSED_DICTIONARY) ? " DICTIONARY" : "");
 
                 if (p == le64toh(f->header->tail_object_offset))
                         p = 0;
@@ -3857,8 +4519,8 @@ void journal_file_print_header(JournalFile *f) {
                "Boot ID: %s\n"
                "Sequential number ID: %s\n"
                "State: %s\n"
-               "Compatible flags:%s%s%s%s\n"
-               "Incompatible flags:%s%s%s%s%s%s\n"
+               "Compatible flags:%s%s%s%s%s\n"
+               "Incompatible flags:%s%s%s%s%s%s%s\n"
                "Header size: %"PRIu64"\n"
                "Arena size: %"PRIu64"\n"
                "Data hash table size: %"PRIu64"\n"
@@ -3882,12 +4544,14 @@ void journal_file_print_header(JournalFile *f) {
                JOURNAL_HEADER_SEALED(f->header) ? " SEALED" : "",
                JOURNAL_HEADER_SEALED_CONTINUOUS(f->header) ? " SEALED_CONTINUOUS" : "",
                JOURNAL_HEADER_TAIL_ENTRY_BOOT_ID(f->header) ? " TAIL_ENTRY_BOOT_ID" : "",
+               JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(f->header) ? " ENTRY_ARRAY_FANOUT" : "",
                (le32toh(f->header->compatible_flags) & ~HEADER_COMPATIBLE_ANY) ? " ???" : "",
                JOURNAL_HEADER_COMPRESSED_XZ(f->header) ? " COMPRESSED-XZ" : "",
                JOURNAL_HEADER_COMPRESSED_LZ4(f->header) ? " COMPRESSED-LZ4" : "",
                JOURNAL_HEADER_COMPRESSED_ZSTD(f->header) ? " COMPRESSED-ZSTD" : "",
                JOURNAL_HEADER_KEYED_HASH(f->header) ? " KEYED-HASH" : "",
                JOURNAL_HEADER_COMPACT(f->header) ? " COMPACT" : "",
+               JOURNAL_HEADER_DICTIONARY(f->header) ? " DICTIONARY" : "",
                (le32toh(f->header->incompatible_flags) & ~HEADER_INCOMPATIBLE_ANY) ? " ???" : "",
                le64toh(f->header->header_size),
                le64toh(f->header->arena_size),
@@ -4209,6 +4873,12 @@ int journal_file_open(
                 } else if (template)
                         f->metrics = template->metrics;
 
+                /* Keep the statistics across rotation */
+                if (template) {
+                        f->data_cache_hits = template->data_cache_hits;
+                        f->data_cache_misses = template->data_cache_misses;
+                }
+
                 r = journal_file_refresh_header(f);
                 if (r < 0)
                         goto fail;
@@ -4255,9 +4925,9 @@ int journal_file_open(
         f->close_fd = true;
 
         if (DEBUG_LOGGING) {
-                static int last_seal = -1, last_keyed_hash = -1;
-                static Compression last_compression = _COMPRESSION_INVALID;
-                static uint64_t last_bytes = UINT64_MAX;
+                static thread_local int last_seal = -1, last_keyed_hash = -1;
+                static thread_local Compression last_compression = _COMPRESSION_INVALID;
+                static thread_local uint64_t last_bytes = UINT64_MAX;
 
                 if (last_seal != JOURNAL_HEADER_SEALED(f->header) ||
                     last_keyed_hash != JOURNAL_HEADER_KEYED_HASH(f->header) ||
@@ -4326,6 +4996,7 @@ int journal_file_parse_uid_from_filename(const char *path, uid_t *ret_uid) {
 
 int journal_file_archive(JournalFile *f, char **ret_previous_path) {
         _cleanup_free_ char *p = NULL;
+        int r;
 
         assert(f);
 
@@ -4367,6 +5038,11 @@ int journal_file_archive(JournalFile *f, char **ret_previous_path) {
          * occurs. */
         f->archive = true;
 
+        /* The file won't change anymore, hence now is the time to index its long entry array chains */
+        r = journal_fanout_write(f);
+        if (r < 0)
+                log_debug_errno(r, "Failed to write entry array fan-out objects to %s, ignoring: %m", f->path);
+
         return 0;
 }
 
@@ -4395,13 +5071,83 @@ int journal_file_dispose(int dir_fd, const char *fname) {
         return 0;
 }
 
+/* Don't let the cache grow without bounds when copying huge files with many distinct but repeated values */
+#define JOURNAL_FILE_COPY_CACHE_MAX (256U*1024U)
+
+typedef struct CopiedData {
+        uint64_t from_offset;  /* must be first, it's the hashmap key */
+        uint64_t to_offset;
+        uint64_t to_hash;
+        uint64_t xor_hash;
+} CopiedData;
+
+void journal_file_copy_cache_done(JournalFileCopyCache *c) {
+        assert(c);
+
+        c->data_objects = hashmap_free(c->data_objects);
+        c->from_file_id = c->to_file_id = SD_ID128_NULL;
+}
+
+static void journal_file_copy_cache_prepare(JournalFileCopyCache *c, JournalFile *from, JournalFile *to) {
+        assert(c);
+        assert(from);
+        assert(to);
+
+        if (sd_id128_equal(c->from_file_id, from->header->file_id) &&
+            sd_id128_equal(c->to_file_id, to->header->file_id))
+                return;
+
+        hashmap_clear(c->data_objects);
+        c->from_file_id = from->header->file_id;
+        c->to_file_id = to->header->file_id;
+}
+
+static void journal_file_copy_cache_put(
+                JournalFileCopyCache *c,
+                JournalFile *from,
+                uint64_t from_offset,
+                uint64_t to_offset,
+                uint64_t to_hash,
+                uint64_t xor_hash) {
+
+        _cleanup_free_ CopiedData *d = NULL;
+        Object *o;
+
+        assert(c);
+        assert(from);
+
+        if (hashmap_size(c->data_objects) >= JOURNAL_FILE_COPY_CACHE_MAX)
+                return;
+
+        /* Values that only show up in a single entry won't be needed again */
+        if (journal_file_move_to_object(from, OBJECT_DATA, from_offset, &o) < 0 ||
+            le64toh(o->data.n_entries) <= 1)
+                return;
+
+        d = new(CopiedData, 1);
+        if (!d)
+                return;
+
+        *d = (CopiedData) {
+                .from_offset = from_offset,
+                .to_offset = to_offset,
+                .to_hash = to_hash,
+                .xor_hash = xor_hash,
+        };
+
+        /* The cache is purely an optimization, hence ignore allocation failures */
+        if (hashmap_ensure_put(&c->data_objects, &uint64_hash_ops_value_free, &d->from_offset, d) >= 0)
+                TAKE_PTR(d);
+}
+
 int journal_file_copy_entry(
                 JournalFile *from,
                 JournalFile *to,
                 Object *o,
                 uint64_t p,
                 uint64_t *seqnum,
-                sd_id128_t *seqnum_id) {
+                sd_id128_t *seqnum_id,
+                JournalFileCopyCache *cache) {
 
         _cleanup_free_ EntryItem *items_alloc = NULL;
         EntryItem *items;
@@ -4438,13 +5184,28 @@ int journal_file_copy_entry(
                 items = items_alloc;
         }
 
+        if (cache)
+                journal_file_copy_cache_prepare(cache, from, to);
+
         for (uint64_t i = 0; i < n; i++) {
-                uint64_t h, q;
+                uint64_t h, q, x;
+                CopiedData *c;
                 void *data;
                 size_t l;
                 Object *u;
 
                 q = journal_file_entry_item_object_offset(from, o, i);
+
+                c = cache ? hashmap_get(cache->data_objects, &q) : NULL;
+                if (c) {
+                        xor_hash ^= c->xor_hash;
+                        items[m++] = (EntryItem) {
+                                .object_offset = c->to_offset,
+                                .hash = c->to_hash,
+                        };
+                        continue;
+                }
+
                 r = journal_file_data_payload(from, NULL, q, NULL, 0, 0, &data, &l);
                 if (IN_SET(r, -EADDRNOTAVAIL, -EBADMSG)) {
                         log_debug_errno(r, "Entry item %"PRIu64" data object is bad, skipping over it: %m", i);
@@ -4462,14 +5223,19 @@ int journal_file_copy_entry(
                         return r;
 
                 if (JOURNAL_HEADER_KEYED_HASH(to->header))
-                        xor_hash ^= jenkins_hash64(data, l);
+                        x = jenkins_hash64(data, l);
                 else
-                        xor_hash ^= le64toh(u->data.hash);
+                        x = le64toh(u->data.hash);
+
+                xor_hash ^= x;
 
                 items[m++] = (EntryItem) {
                         .object_offset = h,
                         .hash = le64toh(u->data.hash),
                 };
+
+                if (cache)
+                        journal_file_copy_cache_put(cache, from, q, h, le64toh(u->data.hash), x);
         }
 
         if (m == 0)
@@ -4672,6 +5438,8 @@ static const char * const journal_object_type_table[] = {
         [OBJECT_FIELD_HASH_TABLE] = "field hash table",
         [OBJECT_ENTRY_ARRAY]      = "entry array",
         [OBJECT_TAG]              = "tag",
+        [OBJECT_DICTIONARY]       = "dictionary",
+        [OBJECT_ENTRY_ARRAY_FANOUT] = "entry array fan-out",
 };
 
 DEFINE_STRING_TABLE_LOOKUP_TO_STRING(journal_object_type, ObjectType);
@@ -73,11 +73,16 @@ typedef struct JournalFile {
         direction_t last_direction;
         LocationType location_type;
         uint64_t last_n_entries;
+        uint64_t notified_n_entries;   /* number of entries when sd_journal_process() last looked at us */
 
         char *path;
         struct stat last_stat;
         usec_t last_stat_usec;
 
+        /* By how much the file was grown last time, and when, see journal_file_allocate() */
+        uint64_t size_increase;
+        usec_t last_allocate_usec;
+
         Header *header;
         HashItem *data_hash_table;
         HashItem *field_hash_table;
@@ -96,8 +101,26 @@ typedef struct JournalFile {
 
         OrderedHashmap *chain_cache;
 
+        /* Recently written DATA objects, to avoid walking the hash chains when appending */
+        struct DataCacheSet *data_cache;
+        uint64_t data_cache_hits;
+        uint64_t data_cache_misses;
+
+        /* Optional sidecar index, only loaded for archived files opened for reading */
+        struct JournalIndex *index;
+
+        /* Optional sidecar summary of distinct field values, likewise only for archived files */
+        struct JournalUniqueIndex *unique_index;
+
+        /* Trained compression dictionary for small DATA objects, and while writing the samples to train it */
+        struct JournalDictionary *dictionary;
+
+        /* Lookup table for the ENTRY_ARRAY_FANOUT objects of the file, loaded on first use */
+        struct JournalFanout *fanout;
+
         pthread_t offline_thread;
         volatile OfflineState offline_state;
+        bool offline_sync_only; /* The offline thread only syncs, and leaves the file online */
 
         unsigned last_seen_generation;
 
@@ -131,6 +154,11 @@ typedef struct JournalFile {
         unsigned newest_boot_id_prioq_idx;
         uint64_t newest_entry_offset;
         uint8_t newest_state;
+
+        /* Location looked up by a worker thread when sd_journal is opened with SD_JOURNAL_PARALLEL */
+        bool prefetched;
+        int prefetch_result;
+        uint64_t prefetch_offset;
 } JournalFile;
 
 typedef enum JournalFileFlags {
@@ -196,6 +224,9 @@ static inline bool VALID_EPOCH(uint64_t u) {
 #define JOURNAL_HEADER_TAIL_ENTRY_BOOT_ID(h) \
         FLAGS_SET(le32toh((h)->compatible_flags), HEADER_COMPATIBLE_TAIL_ENTRY_BOOT_ID)
 
+#define JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(h) \
+        FLAGS_SET(le32toh((h)->compatible_flags), HEADER_COMPATIBLE_ENTRY_ARRAY_FANOUT)
+
 #define JOURNAL_HEADER_COMPRESSED_XZ(h) \
         FLAGS_SET(le32toh((h)->incompatible_flags), HEADER_INCOMPATIBLE_COMPRESSED_XZ)
 
@@ -211,6 +242,9 @@ static inline bool VALID_EPOCH(uint64_t u) {
 #define JOURNAL_HEADER_COMPACT(h) \
         FLAGS_SET(le32toh((h)->incompatible_flags), HEADER_INCOMPATIBLE_COMPACT)
 
+#define JOURNAL_HEADER_DICTIONARY(h) \
+        FLAGS_SET(le32toh((h)->incompatible_flags), HEADER_INCOMPATIBLE_DICTIONARY)
+
 int journal_file_move_to_object(JournalFile *f, ObjectType type, uint64_t offset, Object **ret);
 int journal_file_pin_object(JournalFile *f, Object *o);
 int journal_file_read_object_header(JournalFile *f, ObjectType type, uint64_t offset, Object *ret);
@@ -242,6 +276,14 @@ int journal_file_data_payload(
                 size_t data_threshold,
                 void **ret_data,
                 size_t *ret_size);
+int journal_file_data_payload_filtered(
+                JournalFile *f,
+                Object *o,
+                uint64_t offset,
+                char * const *fields,
+                size_t data_threshold,
+                void **ret_data,
+                size_t *ret_size);
 
 static inline size_t journal_file_data_payload_offset(JournalFile *f) {
         return JOURNAL_HEADER_COMPACT(f->header)
@@ -281,6 +323,21 @@ int journal_file_append_entry(
                 Object **ret_object,
                 uint64_t *ret_offset);
 
+typedef struct JournalFileAppendEntry {
+        const dual_timestamp *ts;       /* NULL → current time */
+        const sd_id128_t *boot_id;      /* NULL → current boot ID */
+        const struct iovec *iovec;
+        size_t n_iovec;
+} JournalFileAppendEntry;
+
+int journal_file_append_entries(
+                JournalFile *f,
+                const JournalFileAppendEntry entries[],
+                size_t n_entries,
+                uint64_t *seqnum,
+                sd_id128_t *seqnum_id,
+                size_t *ret_n_appended);
+
 int journal_file_find_data_object(JournalFile *f, const void *data, uint64_t size, Object **ret_object, uint64_t *ret_offset);
 int journal_file_find_data_object_with_hash(JournalFile *f, const void *data, uint64_t size, uint64_t hash, Object **ret_object, uint64_t *ret_offset);
 
@@ -303,7 +360,26 @@ int journal_file_move_to_entry_by_seqnum_for_data(JournalFile *f, Object *d, uin
 int journal_file_move_to_entry_by_realtime_for_data(JournalFile *f, Object *d, uint64_t realtime, direction_t direction, Object **ret_object, uint64_t *ret_offset);
 int journal_file_move_to_entry_by_monotonic_for_data(JournalFile *f, Object *d, sd_id128_t boot_id, uint64_t monotonic, direction_t direction, Object **ret_object, uint64_t *ret_offset);
 
-int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint64_t p, uint64_t *seqnum, sd_id128_t *seqnum_id);
+/* Remembers where DATA objects of one journal file were copied to in another one, so that copying many entries
+ * between the same pair of files doesn't need to read, hash and look up shared DATA objects again and again.
+ * Only DATA objects referenced by more than one entry are remembered. The cache is reset automatically if
+ * either file changes, e.g. because the destination file was rotated. */
+typedef struct JournalFileCopyCache {
+        sd_id128_t from_file_id;
+        sd_id128_t to_file_id;
+        Hashmap *data_objects;
+} JournalFileCopyCache;
+
+void journal_file_copy_cache_done(JournalFileCopyCache *c);
+
+int journal_file_copy_entry(
+                JournalFile *from,
+                JournalFile *to,
+                Object *o,
+                uint64_t p,
+                uint64_t *seqnum,
+                sd_id128_t *seqnum_id,
+                JournalFileCopyCache *cache);
 
 void journal_file_dump(JournalFile *f);
 void journal_file_print_header(JournalFile *f);
@@ -0,0 +1,643 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "env-util.h"
+#include "fd-util.h"
+#include "fs-util.h"
+#include "hashmap.h"
+#include "io-util.h"
+#include "journal-index.h"
+#include "log.h"
+#include "missing_threads.h"
+#include "path-util.h"
+#include "sort-util.h"
+#include "stat-util.h"
+#include "string-util.h"
+#include "tmpfile-util.h"
+
+/* Refuse to load sidecars larger than this, they are supposed to be much smaller than the journal file. */
+#define JOURNAL_INDEX_SIZE_MAX (UINT64_C(4) * U64_GB)
+
+typedef struct IndexPostings {
+        uint64_t data_offset;
+        uint64_t n_offsets;
+        uint64_t offsets[];
+} IndexPostings;
+
+struct JournalIndex {
+        void *map;
+        size_t size;
+
+        const JournalIndexHeader *header;
+        const JournalIndexItem *items;
+        uint64_t n_items;
+        const uint8_t *postings;
+        uint64_t postings_size;
+
+        /* Decoded posting lists, keyed by data object offset */
+        Hashmap *decoded;
+};
+
+typedef struct IndexEntry {
+        uint64_t offset;
+        uint64_t realtime;
+} IndexEntry;
+
+bool journal_index_enabled(void) {
+        static thread_local int cached = -1;
+        int r;
+
+        if (cached < 0) {
+                r = getenv_bool("SYSTEMD_JOURNAL_INDEX");
+                if (r < 0) {
+                        if (r != -ENXIO)
+                                log_debug_errno(r, "Failed to parse $SYSTEMD_JOURNAL_INDEX environment variable, ignoring: %m");
+                        cached = false;
+                } else
+                        cached = r;
+        }
+
+        return cached;
+}
+
+bool journal_index_use(void) {
+        /* Reading indexes is enabled unless explicitly turned off. */
+        return getenv_bool("SYSTEMD_JOURNAL_INDEX") != 0;
+}
+
+int journal_index_path(const char *journal_path, char **ret) {
+        char *p;
+
+        assert(journal_path);
+        assert(ret);
+
+        p = strjoin(journal_path, JOURNAL_INDEX_SUFFIX);
+        if (!p)
+                return -ENOMEM;
+
+        *ret = p;
+        return 0;
+}
+
+int journal_index_remove_at(int dir_fd, const char *journal_fname) {
+        _cleanup_free_ char *p = NULL;
+        int r;
+
+        assert(dir_fd >= 0 || dir_fd == AT_FDCWD);
+        assert(journal_fname);
+
+        r = journal_index_path(journal_fname, &p);
+        if (r < 0)
+                return r;
+
+        if (unlinkat(dir_fd, p, 0) < 0)
+                return errno == ENOENT ? 0 : -errno;
+
+        return 1;
+}
+
+static void varint_put(uint8_t *buf, size_t *pos, uint64_t v) {
+        do {
+                uint8_t b = v & 0x7f;
+
+                v >>= 7;
+                buf[(*pos)++] = b | (v > 0 ? 0x80 : 0);
+        } while (v > 0);
+}
+
+static int varint_get(const uint8_t *buf, size_t size, size_t *pos, uint64_t *ret) {
+        uint64_t v = 0;
+
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+                uint8_t b;
+
+                if (*pos >= size)
+                        return -EBADMSG;
+
+                b = buf[(*pos)++];
+                v |= (uint64_t) (b & 0x7f) << shift;
+                if (!(b & 0x80)) {
+                        *ret = v;
+                        return 0;
+                }
+        }
+
+        return -EBADMSG;
+}
+
+/* Note that the index is generated from the offline thread, concurrently to other users of the (not thread
+ * safe) mmap cache. Hence everything on the writing side only uses pread(). */
+static int index_read_entry_array_chain(
+                JournalFile *f,
+                uint64_t offset,
+                uint64_t n,
+                uint64_t **array,
+                size_t *n_array) {
+
+        _cleanup_free_ Object *buf = NULL;
+        size_t buf_size = 0;
+        int r;
+
+        assert(f);
+        assert(array);
+        assert(n_array);
+
+        while (offset != 0 && n > 0) {
+                uint64_t sz, m;
+                Object o;
+                ssize_t l;
+
+                r = journal_file_read_object_header(f, OBJECT_ENTRY_ARRAY, offset, &o);
+                if (r < 0)
+                        return r;
+
+                sz = le64toh(o.object.size);
+                if (sz > buf_size) {
+                        free(buf);
+                        buf = malloc(sz);
+                        if (!buf)
+                                return -ENOMEM;
+                        buf_size = sz;
+                }
+
+                l = pread(f->fd, buf, sz, offset);
+                if (l < 0)
+                        return -errno;
+                if ((uint64_t) l != sz)
+                        return -EIO;
+
+                m = journal_file_entry_array_n_items(f, buf);
+                if (!GREEDY_REALLOC(*array, *n_array + MIN(m, n)))
+                        return -ENOMEM;
+
+                for (uint64_t i = 0; i < m && n > 0; i++, n--) {
+                        uint64_t q = journal_file_entry_array_item(f, buf, i);
+                        if (q == 0)
+                                return 0;
+
+                        (*array)[(*n_array)++] = q;
+                }
+
+                offset = le64toh(o.entry_array.next_entry_array_offset);
+        }
+
+        return 0;
+}
+
+static int index_entry_compare(const IndexEntry *a, const IndexEntry *b) {
+        return CMP(a->offset, b->offset);
+}
+
+static int index_collect_entries(JournalFile *f, IndexEntry **ret, size_t *ret_n) {
+        _cleanup_free_ uint64_t *offsets = NULL;
+        _cleanup_free_ IndexEntry *entries = NULL;
+        size_t n = 0;
+        int r;
+
+        assert(f);
+        assert(ret);
+        assert(ret_n);
+
+        r = index_read_entry_array_chain(
+                        f,
+                        le64toh(f->header->entry_array_offset),
+                        le64toh(f->header->n_entries),
+                        &offsets, &n);
+        if (r < 0)
+                return r;
+
+        entries = new(IndexEntry, n);
+        if (!entries && n > 0)
+                return -ENOMEM;
+
+        for (size_t i = 0; i < n; i++) {
+                Object o;
+
+                if (i > 0 && offsets[i] <= offsets[i-1])
+                        return -EBADMSG;
+
+                r = journal_file_read_object_header(f, OBJECT_ENTRY, offsets[i], &o);
+                if (r < 0)
+                        return r;
+
+                entries[i] = (IndexEntry) {
+                        .offset = offsets[i],
+                        .realtime = le64toh(o.entry.realtime),
+                };
+        }
+
+        *ret = TAKE_PTR(entries);
+        *ret_n = n;
+        return 0;
+}
+
+static int index_add_data(
+                JournalFile *f,
+                const Object *d,
+                uint64_t data_offset,
+                const IndexEntry *entries,
+                size_t n_entries,
+                JournalIndexItem **items,
+                size_t *n_items,
+                uint8_t **postings,
+                size_t *postings_size) {
+
+        _cleanup_free_ uint64_t *offsets = NULL;
+        uint64_t rmin = UINT64_MAX, rmax = 0, prev = 0;
+        size_t n = 0, start;
+        int r;
+
+        assert(f);
+        assert(d);
+
+        if (le64toh(d->data.n_entries) == 0)
+                return 0;
+
+        if (!GREEDY_REALLOC(offsets, 1))
+                return -ENOMEM;
+        offsets[n++] = le64toh(d->data.entry_offset);
+
+        r = index_read_entry_array_chain(
+                        f,
+                        le64toh(d->data.entry_array_offset),
+                        le64toh(d->data.n_entries) - 1,
+                        &offsets, &n);
+        if (r < 0)
+                return r;
+
+        /* Worst case each offset takes 10 bytes when varint encoded. */
+        if (!GREEDY_REALLOC(*postings, *postings_size + n * 10))
+                return -ENOMEM;
+
+        start = *postings_size;
+        for (size_t i = 0; i < n; i++) {
+                const IndexEntry *e;
+
+                if (offsets[i] <= prev)
+                        return -EBADMSG;
+
+                e = typesafe_bsearch(&(const IndexEntry) { .offset = offsets[i] }, entries, n_entries, index_entry_compare);
+                if (!e) /* Entry not linked into the global entry array? Then the file is inconsistent. */
+                        return -EBADMSG;
+
+                rmin = MIN(rmin, e->realtime);
+                rmax = MAX(rmax, e->realtime);
+
+                varint_put(*postings, postings_size, offsets[i] - prev);
+                prev = offsets[i];
+        }
+
+        if (!GREEDY_REALLOC(*items, *n_items + 1))
+                return -ENOMEM;
+
+        (*items)[(*n_items)++] = (JournalIndexItem) {
+                .data_offset = htole64(data_offset),
+                .hash = d->data.hash,
+                .n_entries = htole64(n),
+                .realtime_min = htole64(rmin),
+                .realtime_max = htole64(rmax),
+                .postings_offset = htole64(start),
+                .postings_size = htole64(*postings_size - start),
+        };
+
+        return 0;
+}
+
+static int index_item_compare(const JournalIndexItem *a, const JournalIndexItem *b) {
+        return CMP(le64toh(a->data_offset), le64toh(b->data_offset));
+}
+
+int journal_index_write(JournalFile *f) {
+        _cleanup_(unlink_and_freep) char *tmp = NULL;
+        _cleanup_free_ JournalIndexItem *items = NULL;
+        _cleanup_free_ IndexEntry *entries = NULL;
+        _cleanup_free_ uint8_t *postings = NULL;
+        _cleanup_free_ char *path = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        size_t n_items = 0, postings_size = 0, n_entries = 0;
+        uint64_t p, sz;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        if (le64toh(f->header->n_entries) == 0)
+                return 0;
+
+        r = journal_index_path(f->path, &path);
+        if (r < 0)
+                return r;
+
+        r = index_collect_entries(f, &entries, &n_entries);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to read entry array of %s, not writing index: %m", f->path);
+
+        p = le64toh(f->header->data_hash_table_offset);
+        sz = le64toh(f->header->data_hash_table_size);
+
+        for (uint64_t i = 0; i < sz / sizeof(HashItem); i++) {
+                HashItem h;
+                ssize_t l;
+                Object o;
+
+                l = pread(f->fd, &h, sizeof(h), p + i * sizeof(HashItem));
+                if (l < 0)
+                        return log_debug_errno(errno, "Failed to read hash table item of %s: %m", f->path);
+                if (l != sizeof(h))
+                        return log_debug_errno(SYNTHETIC_ERRNO(EIO), "Short read of hash table item of %s.", f->path);
+
+                for (uint64_t q = le64toh(h.head_hash_offset); q != 0; q = le64toh(o.data.next_hash_offset)) {
+                        r = journal_file_read_object_header(f, OBJECT_DATA, q, &o);
+                        if (r < 0)
+                                return log_debug_errno(r, "Invalid data object in %s, not writing index: %m", f->path);
+
+                        r = index_add_data(f, &o, q, entries, n_entries, &items, &n_items, &postings, &postings_size);
+                        if (r < 0)
+                                return log_debug_errno(r, "Failed to index data object in %s: %m", f->path);
+                }
+        }
+
+        typesafe_qsort(items, n_items, index_item_compare);
+
+        JournalIndexHeader header = {
+                .header_size = htole64(sizeof(JournalIndexHeader)),
+                .file_id = f->header->file_id,
+                .n_entries = f->header->n_entries,
+                .tail_entry_seqnum = f->header->tail_entry_seqnum,
+                .n_items = htole64(n_items),
+                .items_offset = htole64(sizeof(JournalIndexHeader)),
+                .postings_offset = htole64(sizeof(JournalIndexHeader) + n_items * sizeof(JournalIndexItem)),
+                .postings_size = htole64(postings_size),
+        };
+        memcpy(header.signature, JOURNAL_INDEX_SIGNATURE, sizeof(header.signature));
+
+        fd = open_tmpfile_linkable(path, O_WRONLY|O_CLOEXEC, &tmp);
+        if (fd < 0)
+                return log_debug_errno(fd, "Failed to create temporary file for %s: %m", path);
+
+        if (fchmod(fd, f->mode & 0666) < 0)
+                return log_debug_errno(errno, "Failed to adjust access mode of %s: %m", path);
+
+        r = loop_write(fd, &header, sizeof(header));
+        if (r >= 0)
+                r = loop_write(fd, items, n_items * sizeof(JournalIndexItem));
+        if (r >= 0)
+                r = loop_write(fd, postings, postings_size);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to write %s: %m", path);
+
+        r = link_tmpfile(fd, tmp, path, LINK_TMPFILE_REPLACE|LINK_TMPFILE_SYNC);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to move %s into place: %m", path);
+
+        tmp = mfree(tmp);
+
+        log_debug("Wrote index %s for %zu data objects (%zu bytes of postings).", path, n_items, postings_size);
+        return 1;
+}
+
+JournalIndex* journal_index_free(JournalIndex *x) {
+        if (!x)
+                return NULL;
+
+        hashmap_free(x->decoded);
+
+        if (x->map)
+                (void) munmap(x->map, x->size);
+
+        return mfree(x);
+}
+
+int journal_index_open(int dir_fd, JournalFile *f, JournalIndex **ret) {
+        _cleanup_(journal_index_freep) JournalIndex *x = NULL;
+        _cleanup_free_ char *path = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        const JournalIndexHeader *h;
+        uint64_t items_offset, postings_offset, postings_size, n_items;
+        struct stat st;
+        void *m;
+        int r;
+
+        assert(dir_fd >= 0 || dir_fd == AT_FDCWD);
+        assert(f);
+        assert(f->header);
+        assert(ret);
+
+        /* Returns 0 if there's no usable index for this file, 1 if it was loaded successfully. */
+
+        if (!journal_index_use())
+                return 0;
+
+        /* Only archived files are immutable, anything else would make the index stale right-away. */
+        if (f->header->state != STATE_ARCHIVED)
+                return 0;
+
+        r = journal_index_path(f->path, &path);
+        if (r < 0)
+                return r;
+
+        fd = openat(dir_fd, dir_fd == AT_FDCWD ? path : skip_leading_slash(path), O_RDONLY|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0) {
+                if (errno == ENOENT)
+                        return 0;
+
+                return log_debug_errno(errno, "Failed to open %s: %m", path);
+        }
+
+        if (fstat(fd, &st) < 0)
+                return log_debug_errno(errno, "Failed to stat %s: %m", path);
+
+        r = stat_verify_regular(&st);
+        if (r < 0)
+                return log_debug_errno(r, "Refusing to use %s as journal index: %m", path);
+
+        if ((uint64_t) st.st_size < sizeof(JournalIndexHeader) || (uint64_t) st.st_size > JOURNAL_INDEX_SIZE_MAX)
+                goto stale;
+
+        m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED)
+                return log_debug_errno(errno, "Failed to map %s: %m", path);
+
+        x = new(JournalIndex, 1);
+        if (!x) {
+                (void) munmap(m, st.st_size);
+                return -ENOMEM;
+        }
+
+        *x = (JournalIndex) {
+                .map = m,
+                .size = st.st_size,
+                .header = m,
+        };
+
+        h = x->header;
+
+        if (memcmp(h->signature, JOURNAL_INDEX_SIGNATURE, sizeof(h->signature)) != 0 ||
+            le64toh(h->header_size) < sizeof(JournalIndexHeader) ||
+            !sd_id128_equal(h->file_id, f->header->file_id) ||
+            h->n_entries != f->header->n_entries ||
+            h->tail_entry_seqnum != f->header->tail_entry_seqnum)
+                goto stale;
+
+        n_items = le64toh(h->n_items);
+        items_offset = le64toh(h->items_offset);
+        postings_offset = le64toh(h->postings_offset);
+        postings_size = le64toh(h->postings_size);
+
+        if (items_offset < le64toh(h->header_size) ||
+            n_items > (x->size - items_offset) / sizeof(JournalIndexItem) ||
+            postings_offset < items_offset + n_items * sizeof(JournalIndexItem) ||
+            postings_offset > x->size ||
+            postings_size > x->size - postings_offset)
+                goto stale;
+
+        x->items = (const JournalIndexItem*) ((const uint8_t*) m + items_offset);
+        x->n_items = n_items;
+        x->postings = (const uint8_t*) m + postings_offset;
+        x->postings_size = postings_size;
+
+        log_debug("Using journal index %s with %" PRIu64 " data objects.", path, n_items);
+
+        *ret = TAKE_PTR(x);
+        return 1;
+
+stale:
+        log_debug("Journal index %s does not match %s, ignoring.", path, f->path);
+        return 0;
+}
+
+static const JournalIndexItem* index_find_item(JournalIndex *x, uint64_t data_offset) {
+        assert(x);
+
+        return typesafe_bsearch(&(const JournalIndexItem) { .data_offset = htole64(data_offset) },
+                                x->items, x->n_items, index_item_compare);
+}
+
+static int index_decode(JournalIndex *x, uint64_t data_offset, IndexPostings **ret) {
+        _cleanup_free_ IndexPostings *d = NULL;
+        const JournalIndexItem *item;
+        uint64_t n, start, size, prev = 0;
+        IndexPostings *cached;
+        size_t pos;
+        int r;
+
+        assert(x);
+        assert(ret);
+
+        cached = hashmap_get(x->decoded, &data_offset);
+        if (cached) {
+                *ret = cached;
+                return 0;
+        }
+
+        item = index_find_item(x, data_offset);
+        if (!item)
+                return -ENOENT;
+
+        n = le64toh(item->n_entries);
+        start = le64toh(item->postings_offset);
+        size = le64toh(item->postings_size);
+        if (n == 0 || start > x->postings_size || size > x->postings_size - start || n > size)
+                return -EBADMSG;
+
+        d = malloc(offsetof(IndexPostings, offsets) + n * sizeof(uint64_t));
+        if (!d)
+                return -ENOMEM;
+
+        d->data_offset = data_offset;
+        d->n_offsets = n;
+
+        pos = 0;
+        for (uint64_t i = 0; i < n; i++) {
+                uint64_t delta;
+
+                r = varint_get(x->postings + start, size, &pos, &delta);
+                if (r < 0)
+                        return r;
+                if (delta == 0 || delta > UINT64_MAX - prev)
+                        return -EBADMSG;
+
+                d->offsets[i] = prev += delta;
+        }
+
+        r = hashmap_ensure_put(&x->decoded, &uint64_hash_ops_value_free, &d->data_offset, d);
+        if (r < 0)
+                return r;
+
+        *ret = TAKE_PTR(d);
+        return 0;
+}
+
+int journal_index_move_to_entry_by_offset(
+                JournalIndex *x,
+                uint64_t data_offset,
+                uint64_t p,
+                direction_t direction,
+                uint64_t *ret_offset) {
+
+        IndexPostings *d;
+        size_t lo, hi;
+        int r;
+
+        assert(x);
+        assert(IN_SET(direction, DIRECTION_DOWN, DIRECTION_UP));
+
+        /* Same semantics as journal_file_move_to_entry_by_offset_for_data(): when going down, returns the
+         * first entry at or after 'p', when going up the last entry at or before 'p'. Returns -ENOENT if the
+         * data object is not covered by the index, in which case the caller should fall back to bisecting
+         * the on-disk entry arrays. */
+
+        r = index_decode(x, data_offset, &d);
+        if (r < 0)
+                return r;
+
+        /* Find the first offset >= p */
+        lo = 0;
+        hi = d->n_offsets;
+        while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+
+                if (d->offsets[mid] < p)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+
+        if (direction == DIRECTION_DOWN) {
+                if (lo >= d->n_offsets)
+                        return 0;
+        } else {
+                if (lo >= d->n_offsets || d->offsets[lo] != p) {
+                        if (lo == 0)
+                                return 0;
+                        lo--;
+                }
+        }
+
+        if (ret_offset)
+                *ret_offset = d->offsets[lo];
+
+        return 1;
+}
+
+int journal_index_get_realtime_range(JournalIndex *x, uint64_t data_offset, usec_t *ret_from, usec_t *ret_to) {
+        const JournalIndexItem *item;
+
+        assert(x);
+
+        item = index_find_item(x, data_offset);
+        if (!item)
+                return -ENOENT;
+
+        if (ret_from)
+                *ret_from = le64toh(item->realtime_min);
+        if (ret_to)
+                *ret_to = le64toh(item->realtime_max);
+
+        return 0;
+}
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "journal-file.h"
+#include "sparse-endian.h"
+#include "time-util.h"
+
+/* An optional sidecar index for archived journal files. For each DATA object in the journal file it carries
+ * the sorted list of entry offsets referencing it (delta and varint encoded) together with the realtime
+ * range these entries cover. This allows resolving matches without bisecting the on-disk entry array
+ * chains. The sidecar is bound to a specific journal file via the file ID, the number of entries and the
+ * tail entry seqnum, and is silently ignored if any of these do not match. It can always be regenerated
+ * from the journal file itself. */
+
+#define JOURNAL_INDEX_SIGNATURE ((const char[]) { 'L', 'P', 'K', 'S', 'I', 'D', 'X', '1' })
+#define JOURNAL_INDEX_SUFFIX ".idx"
+
+typedef struct JournalIndexHeader {
+        uint8_t signature[8];
+        le64_t header_size;
+        sd_id128_t file_id;
+        le64_t n_entries;
+        le64_t tail_entry_seqnum;
+        le64_t n_items;
+        le64_t items_offset;
+        le64_t postings_offset;
+        le64_t postings_size;
+} _packed_ JournalIndexHeader;
+
+typedef struct JournalIndexItem {
+        le64_t data_offset;
+        le64_t hash;
+        le64_t n_entries;
+        le64_t realtime_min;
+        le64_t realtime_max;
+        le64_t postings_offset; /* relative to JournalIndexHeader.postings_offset */
+        le64_t postings_size;
+} _packed_ JournalIndexItem;
+
+typedef struct JournalIndex JournalIndex;
+
+bool journal_index_enabled(void);
+bool journal_index_use(void);
+
+int journal_index_path(const char *journal_path, char **ret);
+int journal_index_write(JournalFile *f);
+int journal_index_remove_at(int dir_fd, const char *journal_fname);
+
+int journal_index_open(int dir_fd, JournalFile *f, JournalIndex **ret);
+JournalIndex* journal_index_free(JournalIndex *x);
+DEFINE_TRIVIAL_CLEANUP_FUNC(JournalIndex*, journal_index_free);
+
+int journal_index_move_to_entry_by_offset(
+                JournalIndex *x,
+                uint64_t data_offset,
+                uint64_t p,
+                direction_t direction,
+                uint64_t *ret_offset);
+int journal_index_get_realtime_range(JournalIndex *x, uint64_t data_offset, usec_t *ret_from, usec_t *ret_to);
@@ -9,8 +9,10 @@
 #include "sd-journal.h"
 
 #include "hashmap.h"
+#include "journal-boot-index.h"
 #include "journal-def.h"
 #include "journal-file.h"
+#include "journal-unique-index.h"
 #include "list.h"
 #include "prioq.h"
 
@@ -107,7 +109,9 @@ struct sd_journal {
         /* Iterating through unique fields and their data values */
         char *unique_field;
         JournalFile *unique_file;
-        uint64_t unique_offset;
+        uint64_t unique_offset;   /* UINT64_MAX while iterating through the file's field value summary */
+        JournalUniqueValues unique_values;
+        uint64_t unique_values_index;
 
         /* Iterating through known fields */
         JournalFile *fields_file;
@@ -129,6 +133,7 @@ struct sd_journal {
         bool has_persistent_files:1;
 
         size_t data_threshold;
+        char **data_filter;
 
         Hashmap *directories_by_path;
         Hashmap *directories_by_wd;
@@ -139,6 +144,7 @@ struct sd_journal {
 char* journal_make_match_string(sd_journal *j);
 void journal_print_header(sd_journal *j);
 int journal_get_directories(sd_journal *j, char ***ret);
+int journal_enumerate_boots(sd_journal *j, JournalBoot **ret, size_t *ret_n);
 
 int journal_add_match_pair(sd_journal *j, const char *field, const char *value);
 int journal_add_matchf(sd_journal *j, const char *format, ...) _printf_(2, 3);
@@ -0,0 +1,536 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "compress.h"
+#include "fd-util.h"
+#include "fs-util.h"
+#include "io-util.h"
+#include "iovec-util.h"
+#include "journal-index.h"
+#include "journal-unique-index.h"
+#include "log.h"
+#include "lookup3.h"
+#include "memory-util.h"
+#include "path-util.h"
+#include "sort-util.h"
+#include "stat-util.h"
+#include "string-util.h"
+#include "tmpfile-util.h"
+
+/* Refuse to load summaries larger than this, they are supposed to be much smaller than the journal file. */
+#define JOURNAL_UNIQUE_INDEX_SIZE_MAX (UINT64_C(256) * U64_MB)
+
+struct JournalUniqueIndex {
+        void *map;
+        size_t size;
+
+        const JournalUniqueIndexItem *items;
+        uint64_t n_items;
+        const le64_t *positions;
+        uint64_t n_positions;
+        const uint8_t *values;
+        uint64_t values_size;
+};
+
+int journal_unique_index_path(const char *journal_path, char **ret) {
+        char *p;
+
+        assert(journal_path);
+        assert(ret);
+
+        p = strjoin(journal_path, JOURNAL_UNIQUE_INDEX_SUFFIX);
+        if (!p)
+                return -ENOMEM;
+
+        *ret = p;
+        return 0;
+}
+
+int journal_unique_index_remove_at(int dir_fd, const char *journal_fname) {
+        _cleanup_free_ char *p = NULL;
+        int r;
+
+        assert(dir_fd >= 0 || dir_fd == AT_FDCWD);
+        assert(journal_fname);
+
+        r = journal_unique_index_path(journal_fname, &p);
+        if (r < 0)
+                return r;
+
+        if (unlinkat(dir_fd, p, 0) < 0)
+                return errno == ENOENT ? 0 : -errno;
+
+        return 1;
+}
+
+/* Note that the summary is generated from the offline thread, concurrently to other users of the (not thread
+ * safe) mmap cache. Hence everything on the writing side only uses pread(). Returns 0 if the payload is too
+ * large or compressed with the file's dictionary, in which case the field is not summarized. */
+static int unique_read_payload(JournalFile *f, const Object *d, uint64_t offset, struct iovec *ret) {
+        _cleanup_free_ void *buf = NULL;
+        uint64_t sz, po;
+        Compression c;
+        ssize_t l;
+
+        assert(f);
+        assert(d);
+        assert(ret);
+
+        if (FLAGS_SET(d->object.flags, OBJECT_COMPRESSED_DICTIONARY))
+                return 0;
+
+        sz = le64toh(d->object.size);
+        po = journal_file_data_payload_offset(f);
+        if (sz <= po)
+                return -EBADMSG;
+        sz -= po;
+        if (sz > JOURNAL_UNIQUE_INDEX_FIELD_SIZE_MAX)
+                return 0;
+
+        buf = malloc(sz);
+        if (!buf)
+                return -ENOMEM;
+
+        l = pread(f->fd, buf, sz, offset + po);
+        if (l < 0)
+                return -errno;
+        if ((uint64_t) l != sz)
+                return -EIO;
+
+        c = COMPRESSION_FROM_OBJECT(d);
+        if (c < 0)
+                return -EPROTONOSUPPORT;
+        if (c != COMPRESSION_NONE) {
+                _cleanup_free_ void *out = NULL;
+                size_t out_size = 0;
+                int r;
+
+                /* Output beyond the limit is truncated, ask for one byte more to notice that */
+                r = decompress_blob(c, buf, sz, &out, &out_size, JOURNAL_UNIQUE_INDEX_FIELD_SIZE_MAX + 1);
+                if (r < 0)
+                        return r;
+                if (out_size > JOURNAL_UNIQUE_INDEX_FIELD_SIZE_MAX)
+                        return 0;
+
+                free_and_replace(buf, out);
+                sz = out_size;
+        }
+
+        *ret = IOVEC_MAKE(TAKE_PTR(buf), sz);
+        return 1;
+}
+
+static int unique_add_field(
+                JournalFile *f,
+                const Object *field,
+                uint64_t field_offset,
+                JournalUniqueIndexItem **items,
+                size_t *n_items,
+                le64_t **positions,
+                size_t *n_positions,
+                uint8_t **values,
+                size_t *values_size) {
+
+        _cleanup_free_ char *name = NULL;
+        struct iovec *v = NULL;
+        size_t n_v = 0, total = 0, name_size;
+        Object d;
+        ssize_t l;
+        int r;
+
+        CLEANUP_ARRAY(v, n_v, iovec_array_free);
+
+        assert(f);
+        assert(field);
+
+        if (le64toh(field->object.size) <= offsetof(Object, field.payload))
+                return -EBADMSG;
+
+        name_size = le64toh(field->object.size) - offsetof(Object, field.payload);
+        name = malloc(name_size);
+        if (!name)
+                return -ENOMEM;
+
+        l = pread(f->fd, name, name_size, field_offset + offsetof(Object, field.payload));
+        if (l < 0)
+                return -errno;
+        if ((size_t) l != name_size)
+                return -EIO;
+
+        for (uint64_t q = le64toh(field->field.head_data_offset); q != 0; q = le64toh(d.data.next_field_offset)) {
+                struct iovec u;
+
+                r = journal_file_read_object_header(f, OBJECT_DATA, q, &d);
+                if (r < 0)
+                        return r;
+
+                /* Data objects might be left unreferenced if writing the entry failed */
+                if (le64toh(d.data.n_entries) == 0)
+                        continue;
+
+                /* Too many distinct values to be worth it */
+                if (n_v >= JOURNAL_UNIQUE_INDEX_VALUES_MAX)
+                        return 0;
+
+                r = unique_read_payload(f, &d, q, &u);
+                if (r <= 0)
+                        return r;
+
+                if (!GREEDY_REALLOC(v, n_v + 1)) {
+                        free(u.iov_base);
+                        return -ENOMEM;
+                }
+
+                v[n_v++] = u;
+
+                if (u.iov_len <= name_size || memcmp(u.iov_base, name, name_size) != 0 || ((const char*) u.iov_base)[name_size] != '=')
+                        return -EBADMSG;
+
+                total += u.iov_len;
+                if (total > JOURNAL_UNIQUE_INDEX_FIELD_SIZE_MAX)
+                        return 0;
+        }
+
+        if (n_v == 0)
+                return 0;
+
+        typesafe_qsort(v, n_v, iovec_memcmp);
+
+        if (!GREEDY_REALLOC(*items, *n_items + 1) ||
+            !GREEDY_REALLOC(*positions, *n_positions + n_v + 1) ||
+            !GREEDY_REALLOC(*values, *values_size + total))
+                return -ENOMEM;
+
+        (*items)[(*n_items)++] = (JournalUniqueIndexItem) {
+                .hash = htole64(jenkins_hash64(name, name_size)),
+                .n_values = htole64(n_v),
+                .position_index = htole64(*n_positions),
+        };
+
+        FOREACH_ARRAY(i, v, n_v) {
+                (*positions)[(*n_positions)++] = htole64(*values_size);
+                memcpy(*values + *values_size, i->iov_base, i->iov_len);
+                *values_size += i->iov_len;
+        }
+
+        /* And where the last value ends */
+        (*positions)[(*n_positions)++] = htole64(*values_size);
+
+        return 1;
+}
+
+static int unique_index_item_compare(const JournalUniqueIndexItem *a, const JournalUniqueIndexItem *b) {
+        return CMP(le64toh(a->hash), le64toh(b->hash));
+}
+
+int journal_unique_index_write(JournalFile *f) {
+        _cleanup_(unlink_and_freep) char *tmp = NULL;
+        _cleanup_free_ JournalUniqueIndexItem *items = NULL;
+        _cleanup_free_ le64_t *positions = NULL;
+        _cleanup_free_ uint8_t *values = NULL;
+        _cleanup_free_ char *path = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        size_t n_items = 0, n_positions = 0, values_size = 0;
+        uint64_t p, sz;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        if (le64toh(f->header->n_entries) == 0)
+                return 0;
+
+        r = journal_unique_index_path(f->path, &path);
+        if (r < 0)
+                return r;
+
+        p = le64toh(f->header->field_hash_table_offset);
+        sz = le64toh(f->header->field_hash_table_size);
+
+        for (uint64_t i = 0; i < sz / sizeof(HashItem); i++) {
+                HashItem h;
+                ssize_t l;
+                Object o;
+
+                l = pread(f->fd, &h, sizeof(h), p + i * sizeof(HashItem));
+                if (l < 0)
+                        return log_debug_errno(errno, "Failed to read hash table item of %s: %m", f->path);
+                if (l != sizeof(h))
+                        return log_debug_errno(SYNTHETIC_ERRNO(EIO), "Short read of hash table item of %s.", f->path);
+
+                for (uint64_t q = le64toh(h.head_hash_offset); q != 0; q = le64toh(o.field.next_hash_offset)) {
+                        r = journal_file_read_object_header(f, OBJECT_FIELD, q, &o);
+                        if (r < 0)
+                                return log_debug_errno(r, "Invalid field object in %s, not writing summary: %m", f->path);
+
+                        r = unique_add_field(f, &o, q, &items, &n_items, &positions, &n_positions, &values, &values_size);
+                        if (r < 0)
+                                return log_debug_errno(r, "Failed to summarize field values of %s: %m", f->path);
+                }
+        }
+
+        typesafe_qsort(items, n_items, unique_index_item_compare);
+
+        JournalUniqueIndexHeader header = {
+                .header_size = htole64(sizeof(JournalUniqueIndexHeader)),
+                .file_id = f->header->file_id,
+                .n_entries = f->header->n_entries,
+                .tail_entry_seqnum = f->header->tail_entry_seqnum,
+                .n_items = htole64(n_items),
+                .items_offset = htole64(sizeof(JournalUniqueIndexHeader)),
+                .n_positions = htole64(n_positions),
+                .positions_offset = htole64(sizeof(JournalUniqueIndexHeader) + n_items * sizeof(JournalUniqueIndexItem)),
+                .values_offset = htole64(sizeof(JournalUniqueIndexHeader) + n_items * sizeof(JournalUniqueIndexItem) + n_positions * sizeof(le64_t)),
+                .values_size = htole64(values_size),
+        };
+        memcpy(header.signature, JOURNAL_UNIQUE_INDEX_SIGNATURE, sizeof(header.signature));
+
+        fd = open_tmpfile_linkable(path, O_WRONLY|O_CLOEXEC, &tmp);
+        if (fd < 0)
+                return log_debug_errno(fd, "Failed to create temporary file for %s: %m", path);
+
+        if (fchmod(fd, f->mode & 0666) < 0)
+                return log_debug_errno(errno, "Failed to adjust access mode of %s: %m", path);
+
+        r = loop_write(fd, &header, sizeof(header));
+        if (r >= 0)
+                r = loop_write(fd, items, n_items * sizeof(JournalUniqueIndexItem));
+        if (r >= 0)
+                r = loop_write(fd, positions, n_positions * sizeof(le64_t));
+        if (r >= 0)
+                r = loop_write(fd, values, values_size);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to write %s: %m", path);
+
+        r = link_tmpfile(fd, tmp, path, LINK_TMPFILE_REPLACE|LINK_TMPFILE_SYNC);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to move %s into place: %m", path);
+
+        tmp = mfree(tmp);
+
+        log_debug("Wrote summary %s of the values of %zu fields (%zu bytes).", path, n_items, values_size);
+        return 1;
+}
+
+JournalUniqueIndex* journal_unique_index_free(JournalUniqueIndex *x) {
+        if (!x)
+                return NULL;
+
+        if (x->map)
+                (void) munmap(x->map, x->size);
+
+        return mfree(x);
+}
+
+int journal_unique_index_open(int dir_fd, JournalFile *f, JournalUniqueIndex **ret) {
+        _cleanup_(journal_unique_index_freep) JournalUniqueIndex *x = NULL;
+        _cleanup_free_ char *path = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        const JournalUniqueIndexHeader *h;
+        uint64_t items_offset, n_items, positions_offset, n_positions, values_offset, values_size;
+        struct stat st;
+        void *m;
+        int r;
+
+        assert(dir_fd >= 0 || dir_fd == AT_FDCWD);
+        assert(f);
+        assert(f->header);
+        assert(ret);
+
+        /* Returns 0 if there's no usable summary for this file, 1 if it was loaded successfully. */
+
+        if (!journal_index_use())
+                return 0;
+
+        /* Only archived files are immutable, anything else would make the summary stale right-away. */
+        if (f->header->state != STATE_ARCHIVED)
+                return 0;
+
+        r = journal_unique_index_path(f->path, &path);
+        if (r < 0)
+                return r;
+
+        fd = openat(dir_fd, dir_fd == AT_FDCWD ? path : skip_leading_slash(path), O_RDONLY|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0) {
+                if (errno == ENOENT)
+                        return 0;
+
+                return log_debug_errno(errno, "Failed to open %s: %m", path);
+        }
+
+        if (fstat(fd, &st) < 0)
+                return log_debug_errno(errno, "Failed to stat %s: %m", path);
+
+        r = stat_verify_regular(&st);
+        if (r < 0)
+                return log_debug_errno(r, "Refusing to use %s as journal field value summary: %m", path);
+
+        if ((uint64_t) st.st_size < sizeof(JournalUniqueIndexHeader) || (uint64_t) st.st_size > JOURNAL_UNIQUE_INDEX_SIZE_MAX)
+                goto stale;
+
+        m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED)
+                return log_debug_errno(errno, "Failed to map %s: %m", path);
+
+        x = new(JournalUniqueIndex, 1);
+        if (!x) {
+                (void) munmap(m, st.st_size);
+                return -ENOMEM;
+        }
+
+        *x = (JournalUniqueIndex) {
+                .map = m,
+                .size = st.st_size,
+        };
+
+        h = m;
+
+        if (memcmp(h->signature, JOURNAL_UNIQUE_INDEX_SIGNATURE, sizeof(h->signature)) != 0 ||
+            le64toh(h->header_size) < sizeof(JournalUniqueIndexHeader) ||
+            !sd_id128_equal(h->file_id, f->header->file_id) ||
+            h->n_entries != f->header->n_entries ||
+            h->tail_entry_seqnum != f->header->tail_entry_seqnum)
+                goto stale;
+
+        n_items = le64toh(h->n_items);
+        items_offset = le64toh(h->items_offset);
+        n_positions = le64toh(h->n_positions);
+        positions_offset = le64toh(h->positions_offset);
+        values_offset = le64toh(h->values_offset);
+        values_size = le64toh(h->values_size);
+
+        if (items_offset < le64toh(h->header_size) ||
+            n_items > (x->size - items_offset) / sizeof(JournalUniqueIndexItem) ||
+            positions_offset < items_offset + n_items * sizeof(JournalUniqueIndexItem) ||
+            positions_offset % sizeof(le64_t) != 0 ||
+            positions_offset > x->size ||
+            n_positions > (x->size - positions_offset) / sizeof(le64_t) ||
+            values_offset < positions_offset + n_positions * sizeof(le64_t) ||
+            values_offset > x->size ||
+            values_size > x->size - values_offset)
+                goto stale;
+
+        x->items = (const JournalUniqueIndexItem*) ((const uint8_t*) m + items_offset);
+        x->n_items = n_items;
+        x->positions = (const le64_t*) ((const uint8_t*) m + positions_offset);
+        x->n_positions = n_positions;
+        x->values = (const uint8_t*) m + values_offset;
+        x->values_size = values_size;
+
+        /* Validate everything once here, so that lookups can trust the positions. Positions are
+         * non-decreasing through the whole file, since fields are laid out one after the other. */
+        for (uint64_t i = 0; i < n_positions; i++)
+                if (le64toh(x->positions[i]) > values_size ||
+                    (i > 0 && le64toh(x->positions[i]) < le64toh(x->positions[i - 1])))
+                        goto stale;
+
+        for (uint64_t i = 0; i < n_items; i++) {
+                uint64_t n = le64toh(x->items[i].n_values), p = le64toh(x->items[i].position_index);
+
+                if (n == 0 || p >= n_positions || n >= n_positions - p ||
+                    (i > 0 && le64toh(x->items[i].hash) < le64toh(x->items[i - 1].hash)))
+                        goto stale;
+        }
+
+        log_debug("Using journal field value summary %s with %" PRIu64 " fields.", path, n_items);
+
+        *ret = TAKE_PTR(x);
+        return 1;
+
+stale:
+        log_debug("Journal field value summary %s does not match %s, ignoring.", path, f->path);
+        return 0;
+}
+
+int journal_unique_index_get(JournalUniqueIndex *x, const char *field, size_t field_length, JournalUniqueValues *ret) {
+        uint64_t hash, left, right;
+
+        assert(x);
+        assert(field);
+        assert(ret);
+
+        /* Returns 0 if the values of the field are not in the summary, in which case they have to be
+         * enumerated from the journal file itself. */
+
+        hash = jenkins_hash64(field, field_length);
+
+        /* Find the first item with the hash, then go through all items with the same hash */
+        left = 0;
+        right = x->n_items;
+        while (left < right) {
+                uint64_t m = left + (right - left) / 2;
+
+                if (le64toh(x->items[m].hash) < hash)
+                        left = m + 1;
+                else
+                        right = m;
+        }
+
+        for (; left < x->n_items && le64toh(x->items[left].hash) == hash; left++) {
+                const JournalUniqueIndexItem *i = x->items + left;
+                JournalUniqueValues v = {
+                        .positions = x->positions + le64toh(i->position_index),
+                        .n_values = le64toh(i->n_values),
+                        .values = x->values,
+                };
+                const void *data;
+                size_t size;
+
+                /* All values of an item belong to the same field, hence the first one tells which */
+                journal_unique_values_get(&v, 0, &data, &size);
+                if (size <= field_length || memcmp(data, field, field_length) != 0 || ((const char*) data)[field_length] != '=')
+                        continue;
+
+                *ret = v;
+                return 1;
+        }
+
+        return 0;
+}
+
+void journal_unique_values_get(const JournalUniqueValues *v, uint64_t i, const void **ret_data, size_t *ret_size) {
+        uint64_t start;
+
+        assert(v);
+        assert(i < v->n_values);
+        assert(ret_data);
+        assert(ret_size);
+
+        start = le64toh(v->positions[i]);
+
+        *ret_data = v->values + start;
+        *ret_size = le64toh(v->positions[i + 1]) - start;
+}
+
+bool journal_unique_values_contain(const JournalUniqueValues *v, const void *data, size_t size) {
+        uint64_t left, right;
+
+        assert(v);
+        assert(data || size == 0);
+
+        left = 0;
+        right = v->n_values;
+        while (left < right) {
+                uint64_t m = left + (right - left) / 2;
+                const void *d;
+                size_t s;
+                int c;
+
+                journal_unique_values_get(v, m, &d, &s);
+
+                c = memcmp_nn(d, s, data, size);
+                if (c == 0)
+                        return true;
+                if (c < 0)
+                        left = m + 1;
+                else
+                        right = m;
+        }
+
+        return false;
+}
@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "journal-file.h"
+#include "sparse-endian.h"
+
+/* An optional sidecar summary of the distinct values of the fields of an archived journal file. For each
+ * field with not too many distinct values it carries the sorted list of its "FIELD=value" payloads,
+ * decompressed, so that sd_journal_enumerate_unique() (and hence journalctl -F and shell completion) can
+ * list and deduplicate them without walking and decompressing the DATA objects of the journal file. Fields
+ * with many distinct values (such as MESSAGE=) are left out, and are enumerated from the journal file as
+ * before. Like the journal index, the summary is bound to a specific journal file via the file ID, the
+ * number of entries and the tail entry seqnum, is silently ignored if any of these do not match, and can
+ * always be regenerated from the journal file itself. */
+
+#define JOURNAL_UNIQUE_INDEX_SIGNATURE ((const char[]) { 'L', 'P', 'K', 'S', 'U', 'N', 'Q', '1' })
+#define JOURNAL_UNIQUE_INDEX_SUFFIX ".uniq"
+
+/* Fields with more distinct values, or more bytes of them, are not summarized */
+#define JOURNAL_UNIQUE_INDEX_VALUES_MAX 1024U
+#define JOURNAL_UNIQUE_INDEX_FIELD_SIZE_MAX (256U * 1024U)
+
+typedef struct JournalUniqueIndexHeader {
+        uint8_t signature[8];
+        le64_t header_size;
+        sd_id128_t file_id;
+        le64_t n_entries;
+        le64_t tail_entry_seqnum;
+        le64_t n_items;
+        le64_t items_offset;
+        le64_t n_positions;
+        le64_t positions_offset;
+        le64_t values_offset;
+        le64_t values_size;
+} _packed_ JournalUniqueIndexHeader;
+
+typedef struct JournalUniqueIndexItem {
+        le64_t hash;           /* jenkins_hash64() of the field name, items are ordered by it */
+        le64_t n_values;
+        le64_t position_index; /* n_values + 1 positions, value i spans [positions[i], positions[i+1]) */
+} _packed_ JournalUniqueIndexItem;
+
+typedef struct JournalUniqueValues {
+        const le64_t *positions;
+        uint64_t n_values;
+        const uint8_t *values;
+} JournalUniqueValues;
+
+typedef struct JournalUniqueIndex JournalUniqueIndex;
+
+int journal_unique_index_path(const char *journal_path, char **ret);
+int journal_unique_index_write(JournalFile *f);
+int journal_unique_index_remove_at(int dir_fd, const char *journal_fname);
+
+int journal_unique_index_open(int dir_fd, JournalFile *f, JournalUniqueIndex **ret);
+JournalUniqueIndex* journal_unique_index_free(JournalUniqueIndex *x);
+DEFINE_TRIVIAL_CLEANUP_FUNC(JournalUniqueIndex*, journal_unique_index_free);
+
+int journal_unique_index_get(JournalUniqueIndex *x, const char *field, size_t field_length, JournalUniqueValues *ret);
+
+void journal_unique_values_get(const JournalUniqueValues *v, uint64_t i, const void **ret_data, size_t *ret_size);
+bool journal_unique_values_contain(const JournalUniqueValues *v, const void *data, size_t size);
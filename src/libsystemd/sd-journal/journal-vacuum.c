@@ -11,9 +11,12 @@
 #include "fd-util.h"
 #include "format-util.h"
 #include "fs-util.h"
+#include "hashmap.h"
 #include "journal-def.h"
 #include "journal-file.h"
+#include "journal-index.h"
 #include "journal-internal.h"
+#include "journal-unique-index.h"
 #include "journal-vacuum.h"
 #include "sort-util.h"
 #include "string-util.h"
@@ -31,6 +34,158 @@ typedef struct vacuum_info {
         bool have_seqnum;
 } vacuum_info;
 
+typedef struct VacuumCacheEntry {
+        vacuum_info info; /* info.filename is the key in JournalVacuumCache.entries, info.usage is unused */
+        ino_t inode;      /* To notice files replaced under the same name */
+        uint64_t generation;
+} VacuumCacheEntry;
+
+struct JournalVacuumCache {
+        char *directory;
+        Hashmap *entries;
+        uint64_t generation;
+};
+
+static VacuumCacheEntry* vacuum_cache_entry_free(VacuumCacheEntry *e) {
+        if (!e)
+                return NULL;
+
+        free(e->info.filename);
+        return mfree(e);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(VacuumCacheEntry*, vacuum_cache_entry_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(
+                vacuum_cache_hash_ops,
+                char, string_hash_func, string_compare_func,
+                VacuumCacheEntry, vacuum_cache_entry_free);
+
+JournalVacuumCache* journal_vacuum_cache_free(JournalVacuumCache *c) {
+        if (!c)
+                return NULL;
+
+        free(c->directory);
+        hashmap_free(c->entries);
+        return mfree(c);
+}
+
+static int vacuum_cache_acquire(JournalVacuumCache **cache, const char *directory, JournalVacuumCache **ret) {
+        _cleanup_(journal_vacuum_cache_freep) JournalVacuumCache *c = NULL;
+
+        assert(directory);
+        assert(ret);
+
+        if (!cache) {
+                *ret = NULL;
+                return 0;
+        }
+
+        if (*cache && streq((*cache)->directory, directory)) {
+                (*cache)->generation++;
+                *ret = *cache;
+                return 0;
+        }
+
+        c = new0(JournalVacuumCache, 1);
+        if (!c)
+                return -ENOMEM;
+
+        c->directory = strdup(directory);
+        if (!c->directory)
+                return -ENOMEM;
+
+        journal_vacuum_cache_free(*cache);
+        *ret = *cache = TAKE_PTR(c);
+        return 0;
+}
+
+static int vacuum_cache_lookup(JournalVacuumCache *c, const char *filename, const struct stat *st, vacuum_info *ret) {
+        VacuumCacheEntry *e;
+        char *fn;
+
+        assert(filename);
+        assert(st);
+        assert(ret);
+
+        if (!c)
+                return 0;
+
+        e = hashmap_get(c->entries, filename);
+        if (!e)
+                return 0;
+
+        if (e->inode != st->st_ino) {
+                vacuum_cache_entry_free(hashmap_remove(c->entries, filename));
+                return 0;
+        }
+
+        fn = strdup(e->info.filename);
+        if (!fn)
+                return -ENOMEM;
+
+        e->generation = c->generation;
+
+        /* Disk usage changes even for archived files, e.g. when holes are punched into them after
+         * archiving, hence always take it from the stat() data of this run. */
+        *ret = e->info;
+        ret->filename = fn;
+        ret->usage = 512UL * (uint64_t) st->st_blocks;
+        return 1;
+}
+
+static int vacuum_cache_put(JournalVacuumCache *c, const vacuum_info *info, ino_t inode) {
+        _cleanup_(vacuum_cache_entry_freep) VacuumCacheEntry *e = NULL;
+        int r;
+
+        assert(info);
+
+        if (!c)
+                return 0;
+
+        e = new(VacuumCacheEntry, 1);
+        if (!e)
+                return -ENOMEM;
+
+        *e = (VacuumCacheEntry) {
+                .info = *info,
+                .inode = inode,
+                .generation = c->generation,
+        };
+
+        e->info.filename = strdup(info->filename);
+        if (!e->info.filename)
+                return -ENOMEM;
+
+        vacuum_cache_entry_free(hashmap_remove(c->entries, e->info.filename));
+
+        r = hashmap_ensure_put(&c->entries, &vacuum_cache_hash_ops, e->info.filename, e);
+        if (r < 0)
+                return r;
+
+        TAKE_PTR(e);
+        return 0;
+}
+
+static void vacuum_cache_forget(JournalVacuumCache *c, const char *filename) {
+        assert(filename);
+
+        if (c)
+                vacuum_cache_entry_free(hashmap_remove(c->entries, filename));
+}
+
+static void vacuum_cache_trim(JournalVacuumCache *c) {
+        VacuumCacheEntry *e;
+
+        if (!c)
+                return;
+
+        /* Forget about files that weren't found in the directory anymore */
+        HASHMAP_FOREACH(e, c->entries)
+                if (e->generation != c->generation)
+                        vacuum_cache_entry_free(hashmap_remove(c->entries, e->info.filename));
+}
+
 static int vacuum_info_compare(const vacuum_info *a, const vacuum_info *b) {
         int r;
 
@@ -125,8 +280,9 @@ static int journal_file_empty(int dir_fd, const char *name) {
         return le64toh(n_entries) <= 0;
 }
 
-int journal_directory_vacuum(
+int journal_directory_vacuum_full(
                 const char *directory,
+                JournalVacuumCache **cache,
                 uint64_t max_use,
                 uint64_t n_max_files,
                 usec_t max_retention_usec,
@@ -134,10 +290,11 @@ int journal_directory_vacuum(
                 bool verbose) {
 
         uint64_t sum = 0, freed = 0, n_active_files = 0;
-        size_t n_list = 0, i;
+        size_t n_list = 0, n_cached = 0, i;
         _cleanup_closedir_ DIR *d = NULL;
         vacuum_info *list = NULL;
         usec_t retention_limit = 0;
+        JournalVacuumCache *c;
         int r;
 
         CLEANUP_ARRAY(list, n_list, vacuum_info_array_free);
@@ -154,6 +311,13 @@ int journal_directory_vacuum(
         if (!d)
                 return -errno;
 
+        /* The names, headers and creation times of archived and corrupted files never change, hence if a
+         * cache is passed we remember what we found out about them, and on subsequent invocations only
+         * need to stat() them, rather than open them and read their headers and xattrs again. */
+        r = vacuum_cache_acquire(cache, directory, &c);
+        if (r < 0)
+                return r;
+
         FOREACH_DIRENT_ALL(de, d, return -errno) {
                 unsigned long long seqnum = 0, realtime;
                 _cleanup_free_ char *p = NULL;
@@ -173,6 +337,18 @@ int journal_directory_vacuum(
 
                 size = 512UL * (uint64_t) st.st_blocks;
 
+                if (!GREEDY_REALLOC(list, n_list + 1))
+                        return -ENOMEM;
+
+                r = vacuum_cache_lookup(c, de->d_name, &st, list + n_list);
+                if (r < 0)
+                        return r;
+                if (r > 0) {
+                        sum += list[n_list++].usage;
+                        n_cached++;
+                        continue;
+                }
+
                 q = strlen(de->d_name);
 
                 if (endswith(de->d_name, ".journal")) {
@@ -261,6 +437,8 @@ int journal_directory_vacuum(
 
                         r = unlinkat_deallocate(dirfd(d), p, 0);
                         if (r >= 0) {
+                                (void) journal_index_remove_at(dirfd(d), p);
+                                (void) journal_unique_index_remove_at(dirfd(d), p);
 
                                 log_full(verbose ? LOG_INFO : LOG_DEBUG,
                                          "Deleted empty archived journal %s/%s (%s).", directory, p, FORMAT_BYTES(size));
@@ -276,10 +454,7 @@ int journal_directory_vacuum(
 
                 patch_realtime(dirfd(d), p, &st, &realtime);
 
-                if (!GREEDY_REALLOC(list, n_list + 1))
-                        return -ENOMEM;
-
-                list[n_list++] = (vacuum_info) {
+                list[n_list] = (vacuum_info) {
                         .filename = TAKE_PTR(p),
                         .usage = size,
                         .seqnum = seqnum,
@@ -288,9 +463,20 @@ int journal_directory_vacuum(
                         .have_seqnum = have_seqnum,
                 };
 
+                r = vacuum_cache_put(c, list + n_list, st.st_ino);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to cache vacuum information about %s, ignoring: %m", list[n_list].filename);
+
+                n_list++;
                 sum += size;
         }
 
+        vacuum_cache_trim(c);
+
+        if (c)
+                log_debug("Reused cached information about %zu of %zu archived journal files in %s.",
+                          n_cached, n_list, directory);
+
         typesafe_qsort(list, n_list, vacuum_info_compare);
 
         for (i = 0; i < n_list; i++) {
@@ -303,8 +489,13 @@ int journal_directory_vacuum(
                     (n_max_files <= 0 || left <= n_max_files))
                         break;
 
+                vacuum_cache_forget(c, list[i].filename);
+
                 r = unlinkat_deallocate(dirfd(d), list[i].filename, 0);
                 if (r >= 0) {
+                        (void) journal_index_remove_at(dirfd(d), list[i].filename);
+                        (void) journal_unique_index_remove_at(dirfd(d), list[i].filename);
+
                         log_full(verbose ? LOG_INFO : LOG_DEBUG, "Deleted archived journal %s/%s (%s).",
                                  directory, list[i].filename, FORMAT_BYTES(list[i].usage));
                         freed += list[i].usage;
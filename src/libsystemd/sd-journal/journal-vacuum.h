@@ -4,6 +4,31 @@
 #include <inttypes.h>
 #include <stdbool.h>
 
+#include "macro.h"
 #include "time-util.h"
 
-int journal_directory_vacuum(const char *directory, uint64_t max_use, uint64_t n_max_files, usec_t max_retention_usec, usec_t *oldest_usec, bool verbose);
+/* Remembers what vacuuming found out about archived journal files, so that they don't need to be opened and
+ * inspected again on every invocation. */
+typedef struct JournalVacuumCache JournalVacuumCache;
+
+JournalVacuumCache* journal_vacuum_cache_free(JournalVacuumCache *c);
+DEFINE_TRIVIAL_CLEANUP_FUNC(JournalVacuumCache*, journal_vacuum_cache_free);
+
+int journal_directory_vacuum_full(
+                const char *directory,
+                JournalVacuumCache **cache,
+                uint64_t max_use,
+                uint64_t n_max_files,
+                usec_t max_retention_usec,
+                usec_t *oldest_usec,
+                bool verbose);
+
+static inline int journal_directory_vacuum(
+                const char *directory,
+                uint64_t max_use,
+                uint64_t n_max_files,
+                usec_t max_retention_usec,
+                usec_t *oldest_usec,
+                bool verbose) {
+        return journal_directory_vacuum_full(directory, NULL, max_use, n_max_files, max_retention_usec, oldest_usec, verbose);
+}
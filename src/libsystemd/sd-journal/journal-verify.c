@@ -14,6 +14,7 @@
 #include "gcrypt-util.h"
 #include "journal-authenticate.h"
 #include "journal-def.h"
+#include "journal-dictionary.h"
 #include "journal-file.h"
 #include "journal-verify.h"
 #include "lookup3.h"
@@ -126,7 +127,19 @@ static int hash_payload(JournalFile *f, Object *o, uint64_t offset, const uint8_
                 _cleanup_free_ void *b = NULL;
                 size_t b_size;
 
-                r = decompress_blob(c, src, size, &b, &b_size, 0);
+                if (FLAGS_SET(o->object.flags, OBJECT_COMPRESSED_DICTIONARY)) {
+                        CompressDictionary *d;
+
+                        r = journal_dictionary_get(f, &d);
+                        if (r <= 0) {
+                                error_errno(offset, r < 0 ? r : SYNTHETIC_ERRNO(EBADMSG),
+                                            "Object compressed with dictionary, but file has no usable dictionary.");
+                                return r < 0 ? r : -EBADMSG;
+                        }
+
+                        r = decompress_blob_zstd_dictionary(d, src, size, &b, &b_size, 0);
+                } else
+                        r = decompress_blob(c, src, size, &b, &b_size, 0);
                 if (r < 0) {
                         error_errno(offset, r, "%s decompression failed: %m",
                                     compression_to_string(c));
@@ -149,7 +162,7 @@ static int journal_file_object_verify(JournalFile *f, uint64_t offset, Object *o
          * possible field values. It does not follow any references to
          * other objects. */
 
-        if ((o->object.flags & _OBJECT_COMPRESSED_MASK) != 0 &&
+        if ((o->object.flags & (_OBJECT_COMPRESSED_MASK|OBJECT_COMPRESSED_DICTIONARY)) != 0 &&
             o->object.type != OBJECT_DATA) {
                 error(offset,
                       "Found compressed object of type %s that isn't of type data, which is not allowed.",
@@ -157,6 +170,14 @@ static int journal_file_object_verify(JournalFile *f, uint64_t offset, Object *o
                 return -EBADMSG;
         }
 
+        if (FLAGS_SET(o->object.flags, OBJECT_COMPRESSED_DICTIONARY) &&
+            ((o->object.flags & _OBJECT_COMPRESSED_MASK) != OBJECT_COMPRESSED_ZSTD ||
+             !JOURNAL_HEADER_DICTIONARY(f->header))) {
+                error(offset,
+                      "Found object compressed with dictionary, but it isn't zstd compressed or the file has no dictionary.");
+                return -EBADMSG;
+        }
+
         switch (o->object.type) {
 
         case OBJECT_DATA: {
@@ -379,6 +400,64 @@ static int journal_file_object_verify(JournalFile *f, uint64_t offset, Object *o
                 }
 
                 break;
+
+        case OBJECT_DICTIONARY:
+                if (le64toh(o->object.size) <= offsetof(Object, dictionary.payload)) {
+                        error(offset,
+                              "Bad dictionary size (<= %zu): %"PRIu64,
+                              offsetof(Object, dictionary.payload),
+                              le64toh(o->object.size));
+                        return -EBADMSG;
+                }
+
+                if (!JOURNAL_HEADER_DICTIONARY(f->header) ||
+                    le64toh(f->header->dictionary_offset) != offset) {
+                        error(offset, "Found dictionary object not referenced from the header.");
+                        return -EBADMSG;
+                }
+
+                break;
+
+        case OBJECT_ENTRY_ARRAY_FANOUT: {
+                uint64_t sz, n, total = 0;
+
+                sz = le64toh(o->object.size);
+                if (sz < offsetof(Object, entry_array_fanout.items) ||
+                    (sz - offsetof(Object, entry_array_fanout.items)) % sizeof(EntryArrayFanoutItem) != 0 ||
+                    (sz - offsetof(Object, entry_array_fanout.items)) / sizeof(EntryArrayFanoutItem) <= 0) {
+                        error(offset, "Invalid object entry array fan-out size: %"PRIu64, sz);
+                        return -EBADMSG;
+                }
+
+                if (!JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(f->header)) {
+                        error(offset, "Found entry array fan-out object without the header flag.");
+                        return -EBADMSG;
+                }
+
+                n = (sz - offsetof(Object, entry_array_fanout.items)) / sizeof(EntryArrayFanoutItem);
+                for (uint64_t i = 0; i < n; i++) {
+                        const EntryArrayFanoutItem *item = o->entry_array_fanout.items + i;
+
+                        if (!VALID64(le64toh(item->entry_array_offset)) ||
+                            (i == 0 && le64toh(item->entry_array_offset) != le64toh(o->entry_array_fanout.first_entry_array_offset)) ||
+                            !VALID64(le64toh(item->begin)) || le64toh(item->begin) == 0) {
+                                error(offset, "Invalid entry array fan-out item %"PRIu64".", i);
+                                return -EBADMSG;
+                        }
+
+                        /* The first array starts the chain, and all others follow at least one entry later */
+                        if (i == 0 ? le64toh(item->total) != 0 : le64toh(item->total) <= total) {
+                                error(offset,
+                                      "Entry array fan-out item %"PRIu64" has invalid total: %"PRIu64,
+                                      i, le64toh(item->total));
+                                return -EBADMSG;
+                        }
+
+                        total = le64toh(item->total);
+                }
+
+                break;
+        }
         }
 
         return 0;
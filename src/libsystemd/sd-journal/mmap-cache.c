@@ -43,6 +43,20 @@ struct Window {
         LIST_FIELDS(Window, unused);
 };
 
+typedef struct AccessPattern {
+        uint64_t last_offset;
+        unsigned n_sequential; /* Number of consecutive accesses in the same direction */
+        bool backwards;
+
+        /* Number of windows mapped during the current sequential run, each one twice as large as the
+         * previous one */
+        unsigned n_grown;
+
+        /* The range we already issued read-ahead for */
+        uint64_t readahead_start;
+        uint64_t readahead_end;
+} AccessPattern;
+
 struct MMapFileDescriptor {
         MMapCache *cache;
 
@@ -51,6 +65,8 @@ struct MMapFileDescriptor {
         bool sigbus;
 
         LIST_HEAD(Window, windows);
+
+        AccessPattern access[_MMAP_CACHE_CATEGORY_MAX];
 };
 
 struct MMapCache {
@@ -60,6 +76,10 @@ struct MMapCache {
         unsigned n_category_cache_hit;
         unsigned n_window_list_hit;
         unsigned n_missed;
+        unsigned n_grown;
+
+        uint64_t n_readahead_pages;
+        uint64_t n_dropped_pages;
 
         Hashmap *fds;
 
@@ -80,6 +100,22 @@ struct MMapCache {
 # define WINDOW_SIZE ((size_t) (UINT64_C(8) * UINT64_C(1024) * UINT64_C(1024)))
 #endif
 
+/* Windows mapped during sequential scans grow up to this size. Don't do that where address space is
+ * scarce, or when debugging. */
+#if ENABLE_DEBUG_MMAP_CACHE
+# define WINDOW_SIZE_MAX WINDOW_SIZE
+#else
+# define WINDOW_SIZE_MAX (sizeof(void*) >= 8 ? (size_t) (UINT64_C(64) * UINT64_C(1024) * UINT64_C(1024)) : WINDOW_SIZE)
+#endif
+
+/* An access is considered sequential if it is at most this far from the previous one of the same category
+ * in the same direction, and a run of this many such accesses makes a sequential scan. */
+#define SEQUENTIAL_DISTANCE_MAX (UINT64_C(64) * UINT64_C(1024))
+#define SEQUENTIAL_MIN 16U
+
+/* How far to read ahead of the cursor during sequential scans */
+#define READAHEAD_SIZE ((size_t) (UINT64_C(2) * UINT64_C(1024) * UINT64_C(1024)))
+
 MMapCache* mmap_cache_new(void) {
         MMapCache *m;
 
@@ -278,19 +314,50 @@ static int mmap_try_harder(MMapFileDescriptor *f, void *addr, int flags, uint64_
         }
 }
 
+static bool access_pattern_sequential(const AccessPattern *a) {
+        assert(a);
+        return a->n_sequential >= SEQUENTIAL_MIN;
+}
+
+static void access_pattern_update(AccessPattern *a, uint64_t offset) {
+        bool backwards;
+
+        assert(a);
+
+        if (offset == a->last_offset)
+                return; /* Same object again, tells us nothing */
+
+        backwards = offset < a->last_offset;
+
+        if (backwards == a->backwards &&
+            (backwards ? a->last_offset - offset : offset - a->last_offset) <= SEQUENTIAL_DISTANCE_MAX) {
+                if (a->n_sequential < UINT_MAX)
+                        a->n_sequential++;
+        } else
+                *a = (AccessPattern) {
+                        .backwards = backwards,
+                };
+
+        a->last_offset = offset;
+}
+
 static int add_mmap(
                 MMapFileDescriptor *f,
                 uint64_t offset,
                 size_t size,
                 struct stat *st,
+                AccessPattern *a,
                 Window **ret) {
 
+        size_t window_size = WINDOW_SIZE;
+        bool sequential;
         Window *w;
         void *d;
         int r;
 
         assert(f);
         assert(size > 0);
+        assert(a);
         assert(ret);
 
         /* overflow check */
@@ -300,12 +367,27 @@ static int add_mmap(
         size = PAGE_ALIGN(size + PAGE_OFFSET_U64(offset));
         offset = PAGE_ALIGN_DOWN_U64(offset);
 
-        if (size < WINDOW_SIZE) {
+        sequential = access_pattern_sequential(a) && WINDOW_SIZE_MAX > WINDOW_SIZE;
+        if (sequential) {
+                /* During sequential scans there's no point in mapping what's behind the cursor, and the
+                 * larger the window, the fewer mmap() calls, page table setups and window replacements. */
+                for (unsigned i = 0; i < a->n_grown && window_size < WINDOW_SIZE_MAX; i++)
+                        window_size *= 2;
+                window_size = MIN(window_size, WINDOW_SIZE_MAX);
+        }
+
+        if (size < window_size) {
                 uint64_t delta;
 
-                delta = PAGE_ALIGN((WINDOW_SIZE - size) / 2);
+                if (!sequential)
+                        delta = PAGE_ALIGN((window_size - size) / 2);
+                else if (a->backwards)
+                        delta = window_size - size;
+                else
+                        delta = 0;
+
                 offset = LESS_BY(offset, delta);
-                size = WINDOW_SIZE;
+                size = window_size;
         }
 
         if (st) {
@@ -332,10 +414,94 @@ static int add_mmap(
                 return -ENOMEM;
         }
 
+        if (sequential) {
+                /* Let the kernel read ahead more aggressively and drop pages behind us sooner */
+                (void) madvise(d, size, MADV_SEQUENTIAL);
+
+                a->n_grown++;
+                f->cache->n_grown++;
+        }
+
         *ret = w;
         return 0;
 }
 
+static void window_readahead(Window *w, AccessPattern *a, uint64_t offset, size_t size) {
+        uint64_t start, end;
+        bool covered;
+
+        assert(w);
+        assert(a);
+
+        if (!access_pattern_sequential(a))
+                return;
+
+        /* Make sure the next READAHEAD_SIZE bytes in the direction of the scan are in the page cache by the
+         * time we get there, so that we don't take a major page fault for every page. Only do this once the
+         * cursor got within half of that of the end of what we read ahead last time. */
+
+        covered = offset >= a->readahead_start && offset + size <= a->readahead_end;
+
+        if (a->backwards) {
+                if (covered && offset >= a->readahead_start + READAHEAD_SIZE / 2)
+                        return;
+
+                start = LESS_BY(offset, READAHEAD_SIZE);
+                end = covered ? a->readahead_start : offset + size;
+        } else {
+                if (covered && offset + size + READAHEAD_SIZE / 2 <= a->readahead_end)
+                        return;
+
+                start = covered ? a->readahead_end : offset;
+                end = offset + size + READAHEAD_SIZE;
+        }
+
+        /* Clamp to the window, the next one is taken care of once we get there */
+        start = PAGE_ALIGN_DOWN_U64(MAX(start, w->offset));
+        end = MIN(PAGE_ALIGN_U64(end), w->offset + w->size);
+        if (start >= end)
+                return;
+
+        if (madvise((uint8_t*) w->ptr + (start - w->offset), end - start, MADV_WILLNEED) < 0)
+                return;
+
+        w->fd->cache->n_readahead_pages += (end - start) / page_size();
+
+        /* Remember the range between the cursor and the end of what we read ahead */
+        if (a->backwards) {
+                a->readahead_start = start;
+                a->readahead_end = offset + size;
+        } else {
+                a->readahead_start = offset;
+                a->readahead_end = end;
+        }
+}
+
+static void window_drop_consumed(MMapFileDescriptor *f, MMapCacheCategory c, uint64_t offset) {
+        MMapCache *m = mmap_cache_fd_cache(f);
+        AccessPattern *a = f->access + c;
+        Window *w;
+
+        /* During a sequential scan, the window of the category that is about to be replaced is not going to
+         * be needed again. If nothing else uses it, drop its pages from our page tables already. They stay
+         * in the page cache, hence if we are wrong this only costs a minor fault. */
+
+        if (!access_pattern_sequential(a))
+                return;
+
+        w = m->windows_by_category[c];
+        if (!w || w->fd != f || (w->flags & _WINDOW_USED_MASK) != (1u << c) || FLAGS_SET(w->flags, WINDOW_INVALIDATED))
+                return;
+
+        if (a->backwards ? offset >= w->offset : offset < w->offset + w->size)
+                return; /* Not fully behind the cursor */
+
+        if (madvise(w->ptr, w->size, MADV_DONTNEED) < 0)
+                return;
+
+        m->n_dropped_pages += w->size / page_size();
+}
+
 int mmap_cache_fd_get(
                 MMapFileDescriptor *f,
                 MMapCacheCategory c,
@@ -346,6 +512,7 @@ int mmap_cache_fd_get(
                 void **ret) {
 
         MMapCache *m = mmap_cache_fd_cache(f);
+        AccessPattern *a;
         Window *w;
         int r;
 
@@ -356,6 +523,9 @@ int mmap_cache_fd_get(
         if (f->sigbus)
                 return -EIO;
 
+        a = f->access + c;
+        access_pattern_update(a, offset);
+
         /* Check whether the current category is the right one already */
         if (window_matches(m->windows_by_category[c], f, offset, size)) {
                 m->n_category_cache_hit++;
@@ -364,6 +534,7 @@ int mmap_cache_fd_get(
         }
 
         /* Drop the reference to the window, since it's unnecessary now */
+        window_drop_consumed(f, c, offset);
         category_detach_window(m, c);
 
         /* Search for a matching mmap */
@@ -377,7 +548,7 @@ int mmap_cache_fd_get(
         m->n_missed++;
 
         /* Create a new mmap */
-        r = add_mmap(f, offset, size, st, &w);
+        r = add_mmap(f, offset, size, st, a, &w);
         if (r < 0)
                 return r;
 
@@ -386,6 +557,7 @@ found:
                 w->flags |= WINDOW_KEEP_ALWAYS;
 
         category_attach_window(m, c, w);
+        window_readahead(w, a, offset, size);
         *ret = (uint8_t*) w->ptr + (offset - w->offset);
         return 0;
 }
@@ -436,8 +608,19 @@ found:
 void mmap_cache_stats_log_debug(MMapCache *m) {
         assert(m);
 
-        log_debug("mmap cache statistics: %u category cache hit, %u window list hit, %u miss, %u files, %u windows, %u unused",
-                  m->n_category_cache_hit, m->n_window_list_hit, m->n_missed, hashmap_size(m->fds), m->n_windows, m->n_unused);
+        log_debug("mmap cache statistics: %u category cache hit, %u window list hit, %u miss, %u files, %u windows, %u unused, "
+                  "%u grown windows, %"PRIu64" pages read ahead (page faults avoided), %"PRIu64" consumed pages dropped",
+                  m->n_category_cache_hit, m->n_window_list_hit, m->n_missed, hashmap_size(m->fds), m->n_windows, m->n_unused,
+                  m->n_grown, m->n_readahead_pages, m->n_dropped_pages);
+}
+
+void mmap_cache_get_statistics(MMapCache *m, uint64_t *ret_hits, uint64_t *ret_misses) {
+        assert(m);
+
+        if (ret_hits)
+                *ret_hits = (uint64_t) m->n_category_cache_hit + m->n_window_list_hit;
+        if (ret_misses)
+                *ret_misses = m->n_missed;
 }
 
 static void mmap_cache_process_sigbus(MMapCache *m) {
@@ -11,18 +11,20 @@ typedef struct MMapCache MMapCache;
 typedef struct MMapFileDescriptor MMapFileDescriptor;
 
 typedef enum MMapCacheCategory {
-        MMAP_CACHE_CATEGORY_ANY              = OBJECT_UNUSED,
-        MMAP_CACHE_CATEGORY_DATA             = OBJECT_DATA,
-        MMAP_CACHE_CATEGORY_FIELD            = OBJECT_FIELD,
-        MMAP_CACHE_CATEGORY_ENTRY            = OBJECT_ENTRY,
-        MMAP_CACHE_CATEGORY_DATA_HASH_TABLE  = OBJECT_DATA_HASH_TABLE,
-        MMAP_CACHE_CATEGORY_FIELD_HASH_TABLE = OBJECT_FIELD_HASH_TABLE,
-        MMAP_CACHE_CATEGORY_ENTRY_ARRAY      = OBJECT_ENTRY_ARRAY,
-        MMAP_CACHE_CATEGORY_TAG              = OBJECT_TAG,
+        MMAP_CACHE_CATEGORY_ANY                = OBJECT_UNUSED,
+        MMAP_CACHE_CATEGORY_DATA               = OBJECT_DATA,
+        MMAP_CACHE_CATEGORY_FIELD              = OBJECT_FIELD,
+        MMAP_CACHE_CATEGORY_ENTRY              = OBJECT_ENTRY,
+        MMAP_CACHE_CATEGORY_DATA_HASH_TABLE    = OBJECT_DATA_HASH_TABLE,
+        MMAP_CACHE_CATEGORY_FIELD_HASH_TABLE   = OBJECT_FIELD_HASH_TABLE,
+        MMAP_CACHE_CATEGORY_ENTRY_ARRAY        = OBJECT_ENTRY_ARRAY,
+        MMAP_CACHE_CATEGORY_TAG                = OBJECT_TAG,
+        MMAP_CACHE_CATEGORY_DICTIONARY         = OBJECT_DICTIONARY,
+        MMAP_CACHE_CATEGORY_ENTRY_ARRAY_FANOUT = OBJECT_ENTRY_ARRAY_FANOUT,
         MMAP_CACHE_CATEGORY_HEADER, /* for reading file header */
         MMAP_CACHE_CATEGORY_PIN,    /* for temporary pinning a object */
         _MMAP_CACHE_CATEGORY_MAX,
-        _MMAP_CACHE_CATEGORY_INVALID         = -EINVAL,
+        _MMAP_CACHE_CATEGORY_INVALID           = -EINVAL,
 } MMapCacheCategory;
 
 assert_cc((int) _OBJECT_TYPE_MAX < (int) _MMAP_CACHE_CATEGORY_MAX);
@@ -56,5 +58,6 @@ MMapCache* mmap_cache_fd_cache(MMapFileDescriptor *f);
 MMapFileDescriptor* mmap_cache_fd_free(MMapFileDescriptor *f);
 
 void mmap_cache_stats_log_debug(MMapCache *m);
+void mmap_cache_get_statistics(MMapCache *m, uint64_t *ret_hits, uint64_t *ret_misses);
 
 bool mmap_cache_fd_got_sigbus(MMapFileDescriptor *f);
@@ -5,6 +5,8 @@
 #include <inttypes.h>
 #include <linux/magic.h>
 #include <poll.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stddef.h>
 #include <sys/inotify.h>
 #include <sys/vfs.h>
@@ -29,6 +31,8 @@
 #include "io-util.h"
 #include "journal-def.h"
 #include "journal-file.h"
+#include "journal-index.h"
+#include "journal-unique-index.h"
 #include "journal-internal.h"
 #include "list.h"
 #include "lookup3.h"
@@ -54,6 +58,9 @@
 
 #define DEFAULT_DATA_THRESHOLD (64*1024)
 
+/* Maximum number of threads to use for opening files and looking up locations in SD_JOURNAL_PARALLEL mode */
+#define PARALLEL_THREADS_MAX 16
+
 DEFINE_PRIVATE_ORIGIN_ID_HELPERS(sd_journal, journal);
 
 static void remove_file_real(sd_journal *j, JournalFile *f);
@@ -683,7 +690,7 @@ static int next_for_match(
 
         if (m->type == MATCH_DISCRETE) {
                 Object *d;
-                uint64_t hash;
+                uint64_t hash, dp;
 
                 /* If the keyed hash logic is used, we need to calculate the hash fresh per file. Otherwise
                  * we can use what we pre-calculated. */
@@ -692,10 +699,22 @@ static int next_for_match(
                 else
                         hash = m->hash;
 
-                r = journal_file_find_data_object_with_hash(f, m->data, m->size, hash, &d, NULL);
+                r = journal_file_find_data_object_with_hash(f, m->data, m->size, hash, &d, &dp);
                 if (r <= 0)
                         return r;
 
+                if (f->index) {
+                        /* If we have an index for this file, look up the entry in the decoded offset list
+                         * rather than bisecting the entry array chain. */
+                        r = journal_index_move_to_entry_by_offset(f->index, dp, after_offset, direction, &np);
+                        if (r == 0)
+                                return 0;
+                        if (r > 0)
+                                goto found;
+                        if (r != -ENOENT)
+                                log_debug_errno(r, "Failed to look up data object in index of %s, ignoring: %m", f->path);
+                }
+
                 return journal_file_move_to_entry_by_offset_for_data(f, d, after_offset, direction, ret, ret_offset);
 
         } else if (m->type == MATCH_OR_TERM) {
@@ -749,6 +768,7 @@ static int next_for_match(
                 }
         }
 
+found:
         assert(np > 0);
 
         if (ret) {
@@ -858,8 +878,18 @@ static int find_location_for_match(
                         /* If not found, fall back to realtime if set, or go to the first entry of the next boot
                          * (or the last entry of the previous boot when DIRECTION_UP). */
                 }
-                if (j->current_location.realtime_set)
+                if (j->current_location.realtime_set) {
+                        usec_t from, to;
+
+                        /* The index knows the realtime range covered by this data object, use that to skip
+                         * the bisection if there can't be any matching entry in the requested direction. */
+                        if (f->index &&
+                            journal_index_get_realtime_range(f->index, dp, &from, &to) >= 0 &&
+                            (direction == DIRECTION_DOWN ? to < j->current_location.realtime : from > j->current_location.realtime))
+                                return 0;
+
                         return journal_file_move_to_entry_by_realtime_for_data(f, d, j->current_location.realtime, direction, ret, ret_offset);
+                }
 
                 if (j->current_location.monotonic_set)
                         return move_by_boot_for_data(j, f, direction, j->current_location.boot_id, dp, ret, ret_offset);
@@ -998,6 +1028,20 @@ static int next_with_matches(
                               direction, ret, ret_offset);
 }
 
+static bool file_needs_find_location(JournalFile *f, direction_t direction) {
+        assert(f);
+
+        /* Mirrors the logic in next_beyond_location(): returns true if the next call for this file will have
+         * to look up the location from scratch, rather than continuing from the current candidate entry. */
+
+        if (f->last_direction == direction &&
+            f->location_type == (direction == DIRECTION_DOWN ? LOCATION_TAIL : LOCATION_HEAD) &&
+            le64toh(f->header->n_entries) == f->last_n_entries)
+                return false;
+
+        return !(f->last_direction == direction && f->current_offset > 0);
+}
+
 static int next_beyond_location(sd_journal *j, JournalFile *f, direction_t direction) {
         Object *c;
         uint64_t cp, n_entries;
@@ -1006,17 +1050,19 @@ static int next_beyond_location(sd_journal *j, JournalFile *f, direction_t direc
         assert(j);
         assert(f);
 
-        (void) journal_file_read_tail_timestamp(j, f);
-
         n_entries = le64toh(f->header->n_entries);
 
         /* If we hit EOF before, we don't need to look into this file again
-         * unless direction changed or new entries appeared. */
+         * unless direction changed or new entries appeared. This is checked before anything else, since
+         * when following, all files but the active ones take this path on every wakeup. Without new
+         * entries the tail timestamp can't have changed either. */
         if (f->last_direction == direction &&
             f->location_type == (direction == DIRECTION_DOWN ? LOCATION_TAIL : LOCATION_HEAD) &&
             n_entries == f->last_n_entries)
                 return 0;
 
+        (void) journal_file_read_tail_timestamp(j, f);
+
         f->last_n_entries = n_entries;
 
         if (f->last_direction == direction && f->current_offset > 0) {
@@ -1031,7 +1077,19 @@ static int next_beyond_location(sd_journal *j, JournalFile *f, direction_t direc
                         journal_file_save_location(f, c, cp);
                 }
         } else {
-                r = find_location_with_matches(j, f, direction, &c, &cp);
+                if (f->prefetched) {
+                        /* The location was already looked up by a worker thread of prefetch_locations(). */
+                        f->prefetched = false;
+
+                        r = f->prefetch_result;
+                        if (r > 0) {
+                                cp = f->prefetch_offset;
+                                r = journal_file_move_to_object(f, OBJECT_ENTRY, cp, &c);
+                                if (r >= 0)
+                                        r = 1;
+                        }
+                } else
+                        r = find_location_with_matches(j, f, direction, &c, &cp);
                 /* LOCATION_SEEK specified to j->current_location.type here means that this is called first
                  * after sd_journal_seek_monotonic_usec() or friends was called. In that case, this file may
                  * not contain any matching entries with the user-specified location, but another file may
@@ -1123,6 +1181,178 @@ static int compare_locations(sd_journal *j, JournalFile *af, JournalFile *bf) {
         return CMP(af->current_xor_hash, bf->current_xor_hash);
 }
 
+typedef struct PrefetchJob {
+        JournalFile *file;
+        int result;
+        uint64_t offset;
+} PrefetchJob;
+
+typedef struct PrefetchContext {
+        sd_journal *journal;
+        direction_t direction;
+        PrefetchJob *jobs;
+        size_t n_jobs;
+        size_t next_job;
+} PrefetchContext;
+
+static void prefetch_job_run(PrefetchContext *c, MMapCache *m, PrefetchJob *job) {
+        _cleanup_(journal_file_closep) JournalFile *f = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        int r;
+
+        assert(c);
+        assert(m);
+        assert(job);
+
+        /* Neither JournalFile nor MMapCache objects are thread-safe, hence open a private instance of the
+         * file with a private mmap cache, and only report the offset of the entry found back. The Match
+         * objects and the current location of the sd_journal object are only read. */
+
+        fd = fcntl(job->file->fd, F_DUPFD_CLOEXEC, 3);
+        if (fd < 0) {
+                job->result = -errno;
+                return;
+        }
+
+        r = journal_file_open(fd, job->file->path, O_RDONLY, 0, 0, 0, NULL, m, NULL, &f);
+        if (r < 0) {
+                job->result = r;
+                return;
+        }
+        TAKE_FD(fd);
+
+        job->result = find_location_with_matches(c->journal, f, c->direction, NULL, &job->offset);
+}
+
+static void* prefetch_thread(void *userdata) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        PrefetchContext *c = ASSERT_PTR(userdata);
+
+        m = mmap_cache_new();
+
+        for (;;) {
+                size_t i;
+
+                i = __atomic_fetch_add(&c->next_job, 1, __ATOMIC_SEQ_CST);
+                if (i >= c->n_jobs)
+                        break;
+
+                if (!m)
+                        c->jobs[i].result = -ENOMEM;
+                else
+                        prefetch_job_run(c, m, c->jobs + i);
+        }
+
+        return NULL;
+}
+
+static void run_parallel(void* (*thread)(void *userdata), void *userdata, size_t n_jobs) {
+        _cleanup_free_ pthread_t *threads = NULL;
+        size_t n_threads = 0, n_threads_max;
+        sigset_t ss, saved_ss;
+        long ncpus;
+        int r;
+
+        assert(thread);
+
+        /* Runs the specified worker function in up to PARALLEL_THREADS_MAX threads, including the calling
+         * one, and returns once all of them are done. The worker function is expected to claim jobs from
+         * the context passed in until none are left. If no threads can be started, the calling thread ends
+         * up doing all the work on its own. */
+
+        ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads_max = CLAMP(ncpus, 1, PARALLEL_THREADS_MAX);
+        n_threads_max = MIN(n_threads_max, n_jobs);
+
+        if (n_threads_max > 1)
+                threads = new(pthread_t, n_threads_max - 1);
+        if (threads) {
+                assert_se(sigfillset(&ss) >= 0);
+                /* Don't block SIGBUS since the worker threads access memory mapped files. */
+                assert_se(sigdelset(&ss, SIGBUS) >= 0);
+
+                r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+                if (r > 0)
+                        log_debug_errno(r, "Failed to block signals, not starting any threads: %m");
+                else {
+                        /* The calling thread does its share of the work too, hence start one thread less. */
+                        for (; n_threads + 1 < n_threads_max; n_threads++) {
+                                r = pthread_create(threads + n_threads, NULL, thread, userdata);
+                                if (r > 0) {
+                                        log_debug_errno(r, "Failed to start journal worker thread, continuing with %zu threads: %m", n_threads);
+                                        break;
+                                }
+                        }
+
+                        assert_se(pthread_sigmask(SIG_SETMASK, &saved_ss, NULL) == 0);
+                }
+        }
+
+        (void) thread(userdata);
+
+        for (size_t i = 0; i < n_threads; i++)
+                assert_se(pthread_join(threads[i], NULL) == 0);
+}
+
+static int prefetch_locations(sd_journal *j, const void **files, unsigned n_files, direction_t direction) {
+        _cleanup_free_ PrefetchJob *jobs = NULL;
+        size_t n_jobs = 0;
+
+        assert(j);
+
+        /* In parallel mode, look up the initial location in all files that need it concurrently, since that
+         * involves bisecting the entry arrays of every file (and per matching data object), which is what
+         * dominates the runtime when many files are opened. The results are picked up by
+         * next_beyond_location() afterwards, where everything else happens as usual. */
+
+        FOREACH_ARRAY(_f, files, n_files) {
+                JournalFile *f = (JournalFile*) *_f;
+
+                f->prefetched = false;
+
+                if (!file_needs_find_location(f, direction))
+                        continue;
+
+                /* Files with a sidecar index are looked up via the index by next_beyond_location(), which is
+                 * cheaper than bisecting in a worker that does not have the index loaded. */
+                if (f->index)
+                        continue;
+
+                if (!GREEDY_REALLOC(jobs, n_jobs + 1))
+                        return -ENOMEM;
+
+                jobs[n_jobs++] = (PrefetchJob) {
+                        .file = f,
+                };
+        }
+
+        if (n_jobs < 2)
+                return 0;
+
+        PrefetchContext c = {
+                .journal = j,
+                .direction = direction,
+                .jobs = jobs,
+                .n_jobs = n_jobs,
+        };
+
+        run_parallel(prefetch_thread, &c, n_jobs);
+
+        FOREACH_ARRAY(job, jobs, n_jobs) {
+                if (job->result < 0) {
+                        /* Let next_beyond_location() retry, and deal with the error. */
+                        log_debug_errno(job->result, "Failed to prefetch location in %s, ignoring: %m", job->file->path);
+                        continue;
+                }
+
+                job->file->prefetched = true;
+                job->file->prefetch_result = job->result;
+                job->file->prefetch_offset = job->offset;
+        }
+
+        return 0;
+}
+
 static int real_journal_next(sd_journal *j, direction_t direction) {
         JournalFile *new_file = NULL;
         unsigned n_files;
@@ -1137,6 +1367,12 @@ static int real_journal_next(sd_journal *j, direction_t direction) {
         if (r < 0)
                 return r;
 
+        if (FLAGS_SET(j->flags, SD_JOURNAL_PARALLEL)) {
+                r = prefetch_locations(j, files, n_files, direction);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to prefetch locations, ignoring: %m");
+        }
+
         FOREACH_ARRAY(_f, files, n_files) {
                 JournalFile *f = (JournalFile*) *_f;
                 bool found;
@@ -1654,6 +1890,16 @@ static int add_any_file(
                 goto error;
         }
 
+        if (path) {
+                r = journal_index_open(j->toplevel_fd >= 0 ? j->toplevel_fd : AT_FDCWD, f, &f->index);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to load index of journal file %s, ignoring: %m", path);
+
+                r = journal_unique_index_open(j->toplevel_fd >= 0 ? j->toplevel_fd : AT_FDCWD, f, &f->unique_index);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to load field value summary of journal file %s, ignoring: %m", path);
+        }
+
         /* journal_file_dump(f); */
 
         /* journal_file_open() generates an replacement fname if necessary, so we can use f->path. */
@@ -1668,6 +1914,7 @@ static int add_any_file(
         TAKE_FD(our_fd); /* the fd is now owned by the JournalFile object */
 
         f->last_seen_generation = j->generation;
+        f->notified_n_entries = le64toh(f->header->n_entries);
 
         track_file_disposition(j, f);
         check_network(j, f->fd);
@@ -1719,6 +1966,149 @@ int journal_get_directories(sd_journal *j, char ***ret) {
         return 0;
 }
 
+DEFINE_PRIVATE_HASH_OPS_FULL(
+                boot_index_hash_ops,
+                char, string_hash_func, string_compare_func, free,
+                JournalBootIndex, journal_boot_index_free);
+
+static int journal_file_boot_index(sd_journal *j, Hashmap **indexes, JournalFile *f, JournalBootIndex **ret) {
+        _cleanup_(journal_boot_index_freep) JournalBootIndex *x = NULL;
+        _cleanup_free_ char *dir = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        const char *p;
+        int dir_fd, r;
+
+        assert(j);
+        assert(indexes);
+        assert(f);
+        assert(ret);
+
+        /* Only archived files are listed in the boot index, don't bother loading it for anything else */
+        if (f->header->state != STATE_ARCHIVED || path_startswith(f->path, "/proc/")) {
+                *ret = NULL;
+                return 0;
+        }
+
+        r = path_extract_directory(f->path, &dir);
+        if (r == -EDESTADDRREQ) {
+                dir = strdup(".");
+                if (!dir)
+                        return -ENOMEM;
+        } else if (r < 0)
+                return r;
+
+        /* Load the index of each directory only once, and remember if there is none */
+        if (hashmap_contains(*indexes, dir)) {
+                *ret = hashmap_get(*indexes, dir);
+                return 0;
+        }
+
+        /* Like journal file paths, the directory is relative to the toplevel fd if there is one */
+        dir_fd = j->toplevel_fd >= 0 ? j->toplevel_fd : AT_FDCWD;
+        p = dir_fd == AT_FDCWD ? dir : skip_leading_slash(dir);
+        fd = openat(dir_fd, isempty(p) ? "." : p, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+        if (fd < 0)
+                log_debug_errno(errno, "Failed to open directory %s, not using boot index: %m", dir);
+        else {
+                r = journal_boot_index_open(fd, &x);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to load boot index of %s, ignoring: %m", dir);
+        }
+
+        r = hashmap_ensure_put(indexes, &boot_index_hash_ops, dir, x);
+        if (r < 0)
+                return r;
+        TAKE_PTR(dir);
+
+        *ret = TAKE_PTR(x);
+        return 0;
+}
+
+static int journal_boot_compare_id(const JournalBoot *a, const JournalBoot *b) {
+        return id128_compare_func(&a->boot_id, &b->boot_id);
+}
+
+static int journal_boot_compare_seqnum(const JournalBoot *a, const JournalBoot *b) {
+        return CMP(a->first_seqnum, b->first_seqnum);
+}
+
+int journal_enumerate_boots(sd_journal *j, JournalBoot **ret, size_t *ret_n) {
+        _cleanup_hashmap_free_ Hashmap *indexes = NULL;
+        _cleanup_free_ JournalBoot *boots = NULL;
+        size_t n_boots = 0, n_indexed = 0, k = 0;
+        JournalFile *f;
+        int r;
+
+        assert(j);
+        assert(ret);
+        assert(ret_n);
+
+        /* Returns all boots recorded in the opened journal files together with the realtime range they
+         * cover, ordered from the oldest to the newest. For archived files this uses the per-directory boot
+         * index where available, so that the files themselves don't have to be looked at. Boots are ordered
+         * by the seqnum of their first entry, not by wallclock time, since the clock might have been off
+         * during early boot or might have been changed later. Fails with -ENOTUNIQ if the files don't share
+         * a seqnum ID (e.g. if the journals of multiple machines are merged), or if the seqnum ranges of the
+         * boots overlap, as they cannot be ordered that way then. */
+
+        ORDERED_HASHMAP_FOREACH(f, j->files) {
+                _cleanup_free_ JournalBoot *b = NULL;
+                JournalBootIndex *x;
+                size_t n = 0;
+
+                r = journal_file_boot_index(j, &indexes, f, &x);
+                if (r < 0)
+                        return r;
+
+                r = x ? journal_boot_index_get(x, f, &b, &n) : 0;
+                if (r < 0)
+                        return r;
+                if (r > 0)
+                        n_indexed++;
+                else {
+                        r = journal_file_get_boots(f, &b, &n);
+                        if (r < 0)
+                                return log_debug_errno(r, "Failed to determine boots in %s: %m", f->path);
+                }
+
+                if (n > 0 && !GREEDY_REALLOC_APPEND(boots, n_boots, b, n))
+                        return -ENOMEM;
+        }
+
+        /* Seqnums are only comparable within the same seqnum ID */
+        for (size_t i = 1; i < n_boots; i++)
+                if (!sd_id128_equal(boots[i].seqnum_id, boots[0].seqnum_id))
+                        return log_debug_errno(SYNTHETIC_ERRNO(ENOTUNIQ),
+                                               "Journal files have different seqnum IDs, cannot order boots by their seqnums.");
+
+        /* Merge the ranges of boots that are spread over multiple files */
+        typesafe_qsort(boots, n_boots, journal_boot_compare_id);
+        FOREACH_ARRAY(b, boots, n_boots) {
+                if (k > 0 && sd_id128_equal(boots[k-1].boot_id, b->boot_id)) {
+                        boots[k-1].first_seqnum = MIN(boots[k-1].first_seqnum, b->first_seqnum);
+                        boots[k-1].last_seqnum = MAX(boots[k-1].last_seqnum, b->last_seqnum);
+                        boots[k-1].first_realtime = MIN(boots[k-1].first_realtime, b->first_realtime);
+                        boots[k-1].last_realtime = MAX(boots[k-1].last_realtime, b->last_realtime);
+                } else
+                        boots[k++] = *b;
+        }
+        n_boots = k;
+
+        typesafe_qsort(boots, n_boots, journal_boot_compare_seqnum);
+        for (size_t i = 1; i < n_boots; i++)
+                if (boots[i].first_seqnum <= boots[i-1].last_seqnum)
+                        return log_debug_errno(SYNTHETIC_ERRNO(ENOTUNIQ),
+                                               "Boots %s and %s overlap, cannot order them by their seqnums.",
+                                               SD_ID128_TO_STRING(boots[i-1].boot_id), SD_ID128_TO_STRING(boots[i].boot_id));
+
+        log_debug("Found %zu boots in %u journal files, %zu of which were covered by the boot index.",
+                  n_boots, ordered_hashmap_size(j->files), n_indexed);
+
+        *ret = TAKE_PTR(boots);
+        *ret_n = n_boots;
+        return 0;
+}
+
 static int add_file_by_name(
                 sd_journal *j,
                 const char *prefix,
@@ -1743,6 +2133,185 @@ static int add_file_by_name(
         return add_any_file(j, -1, path);
 }
 
+typedef struct OpenJob {
+        char *path;
+        int fd;
+        int result;
+} OpenJob;
+
+typedef struct OpenContext {
+        int toplevel_fd;
+        OpenJob *jobs;
+        size_t n_jobs;
+        size_t next_job;
+} OpenContext;
+
+static void open_jobs_free(OpenJob *jobs, size_t n_jobs) {
+        FOREACH_ARRAY(job, jobs, n_jobs) {
+                free(job->path);
+                safe_close(job->fd);
+        }
+
+        free(jobs);
+}
+
+static int open_job_run(OpenContext *c, OpenJob *job) {
+        _cleanup_close_ int fd = -EBADF;
+        struct stat st;
+        Header h;
+        ssize_t n;
+        int r;
+
+        assert(c);
+        assert(job);
+
+        /* Opens the file and reads its header, and the most recent entry, which are the first things
+         * journal_file_open() and journal_file_read_tail_timestamp() look at. This only serves to get the
+         * I/O done in parallel, everything else is left to add_any_file(), which will validate the header
+         * properly once more. Files that are obviously not journal files are weeded out early though. */
+
+        if (c->toplevel_fd >= 0)
+                fd = openat(c->toplevel_fd, skip_leading_slash(job->path), O_RDONLY|O_CLOEXEC|O_NONBLOCK);
+        else
+                fd = open(job->path, O_RDONLY|O_CLOEXEC|O_NONBLOCK);
+        if (fd < 0)
+                return -errno;
+
+        r = fd_nonblock(fd, false);
+        if (r < 0)
+                return r;
+
+        if (fstat(fd, &st) < 0)
+                return -errno;
+
+        r = stat_verify_regular(&st);
+        if (r < 0)
+                return r;
+
+        n = pread(fd, &h, sizeof(h), 0);
+        if (n < 0)
+                return -errno;
+        if ((size_t) n < offsetof(Header, n_data) ||
+            memcmp(h.signature, HEADER_SIGNATURE, sizeof(h.signature)) != 0)
+                return -EBADMSG;
+
+        if ((size_t) n >= offsetof(Header, tail_entry_offset) + sizeof(h.tail_entry_offset) &&
+            JOURNAL_HEADER_CONTAINS(&h, tail_entry_offset)) {
+                uint64_t p = le64toh(h.tail_entry_offset);
+                uint8_t buf[offsetof(Object, entry.items)];
+
+                /* Failures are not fatal here, we only warm up the page cache. */
+                if (p > 0)
+                        (void) pread(fd, buf, sizeof(buf), p);
+        }
+
+        job->fd = TAKE_FD(fd);
+        return 0;
+}
+
+static void* open_thread(void *userdata) {
+        OpenContext *c = ASSERT_PTR(userdata);
+
+        for (;;) {
+                size_t i;
+
+                i = __atomic_fetch_add(&c->next_job, 1, __ATOMIC_SEQ_CST);
+                if (i >= c->n_jobs)
+                        break;
+
+                c->jobs[i].result = open_job_run(c, c->jobs + i);
+        }
+
+        return NULL;
+}
+
+static int add_files_by_name(
+                sd_journal *j,
+                const char *prefix,
+                char **filenames) {
+
+        OpenJob *jobs = NULL;
+        size_t n_jobs = 0;
+        int r = 0;
+
+        assert(j);
+        assert(prefix);
+
+        CLEANUP_ARRAY(jobs, n_jobs, open_jobs_free);
+
+        /* Like add_file_by_name(), but for a whole set of files of a directory. In parallel mode, the files
+         * are opened and their headers read concurrently first, since with many files, cold caches, or
+         * slow storage, waiting for that I/O file by file dominates the time it takes to open the journal.
+         * Mapping the files and setting up the JournalFile objects happens sequentially afterwards, since
+         * neither JournalFile nor MMapCache objects are thread-safe. */
+
+        if (j->no_new_files)
+                return 0;
+
+        STRV_FOREACH(fn, filenames) {
+                _cleanup_free_ char *path = NULL;
+
+                if (!file_type_wanted(j->flags, *fn))
+                        continue;
+
+                path = path_join(prefix, *fn);
+                if (!path)
+                        return -ENOMEM;
+
+                /* Files we already track only need to be checked for replacement, which is cheap. */
+                if (!FLAGS_SET(j->flags, SD_JOURNAL_PARALLEL) || ordered_hashmap_contains(j->files, path)) {
+                        RET_GATHER(r, add_any_file(j, -EBADF, path));
+                        continue;
+                }
+
+                if (!GREEDY_REALLOC(jobs, n_jobs + 1))
+                        return -ENOMEM;
+
+                jobs[n_jobs++] = (OpenJob) {
+                        .path = TAKE_PTR(path),
+                        .fd = -EBADF,
+                };
+        }
+
+        if (n_jobs > 1) {
+                OpenContext c = {
+                        .toplevel_fd = j->toplevel_fd,
+                        .jobs = jobs,
+                        .n_jobs = n_jobs,
+                };
+
+                run_parallel(open_thread, &c, n_jobs);
+        }
+
+        FOREACH_ARRAY(job, jobs, n_jobs) {
+                int k;
+
+                if (job->fd < 0) {
+                        if (job->result < 0) {
+                                log_debug_errno(job->result, "Failed to open journal file %s: %m", job->path);
+                                (void) journal_put_error(j, job->result, job->path);
+                                RET_GATHER(r, job->result);
+                                continue;
+                        }
+
+                        /* Not opened yet, because there was only a single job. */
+                        RET_GATHER(r, add_any_file(j, -EBADF, job->path));
+                        continue;
+                }
+
+                k = add_any_file(j, job->fd, job->path);
+                if (k < 0) {
+                        RET_GATHER(r, k);
+                        continue; /* The fd is closed when the jobs are freed. */
+                }
+
+                /* The fd is now owned by the JournalFile object */
+                job->fd = -EBADF;
+        }
+
+        return r;
+}
+
 static int remove_file_by_name(
                 sd_journal *j,
                 const char *prefix,
@@ -2006,21 +2575,33 @@ static int add_directory_impl(sd_journal *j, const char *path, bool is_root, Dir
 static int add_directory(sd_journal *j, const char *prefix, const char *dirname);
 
 static void directory_enumerate(sd_journal *j, Directory *m, DIR *d) {
+        _cleanup_strv_free_ char **files = NULL, **subdirs = NULL;
+        int r;
+
         assert(j);
         assert(m);
         assert(d);
 
-        FOREACH_DIRENT_ALL(de, d, goto fail) {
-                if (dirent_is_journal_file(de))
-                        (void) add_file_by_name(j, m->path, de->d_name);
+        /* Collect the entries first, so that the files can be opened in one go, see add_files_by_name(). */
 
-                if (m->is_root && dirent_is_journal_subdir(de))
-                        (void) add_directory(j, m->path, de->d_name);
+        FOREACH_DIRENT_ALL(de, d, log_debug_errno(errno, "Failed to enumerate directory %s, ignoring: %m", m->path)) {
+                if (dirent_is_journal_file(de)) {
+                        r = strv_extend(&files, de->d_name);
+                        if (r < 0)
+                                return (void) log_oom_debug();
+                }
+
+                if (m->is_root && dirent_is_journal_subdir(de)) {
+                        r = strv_extend(&subdirs, de->d_name);
+                        if (r < 0)
+                                return (void) log_oom_debug();
+                }
         }
 
-        return;
-fail:
-        log_debug_errno(errno, "Failed to enumerate directory %s, ignoring: %m", m->path);
+        (void) add_files_by_name(j, m->path, files);
+
+        STRV_FOREACH(sd, subdirs)
+                (void) add_directory(j, m->path, *sd);
 }
 
 static void directory_watch(sd_journal *j, Directory *m, int fd, uint32_t mask) {
@@ -2313,7 +2894,8 @@ static sd_journal *journal_new(int flags, const char *path, const char *namespac
          SD_JOURNAL_CURRENT_USER |                      \
          SD_JOURNAL_ALL_NAMESPACES |                    \
          SD_JOURNAL_INCLUDE_DEFAULT_NAMESPACE |         \
-         SD_JOURNAL_ASSUME_IMMUTABLE)
+         SD_JOURNAL_ASSUME_IMMUTABLE |                  \
+         SD_JOURNAL_PARALLEL)
 
 _public_ int sd_journal_open_namespace(sd_journal **ret, const char *namespace, int flags) {
         _cleanup_(sd_journal_closep) sd_journal *j = NULL;
@@ -2341,7 +2923,8 @@ _public_ int sd_journal_open(sd_journal **ret, int flags) {
 #define OPEN_CONTAINER_ALLOWED_FLAGS                    \
         (SD_JOURNAL_LOCAL_ONLY |                        \
          SD_JOURNAL_SYSTEM |                            \
-         SD_JOURNAL_ASSUME_IMMUTABLE)
+         SD_JOURNAL_ASSUME_IMMUTABLE |                  \
+         SD_JOURNAL_PARALLEL)
 
 _public_ int sd_journal_open_container(sd_journal **ret, const char *machine, int flags) {
         _cleanup_free_ char *root = NULL, *class = NULL;
@@ -2387,7 +2970,8 @@ _public_ int sd_journal_open_container(sd_journal **ret, const char *machine, in
         (SD_JOURNAL_OS_ROOT |                           \
          SD_JOURNAL_SYSTEM |                            \
          SD_JOURNAL_CURRENT_USER |                      \
-         SD_JOURNAL_ASSUME_IMMUTABLE)
+         SD_JOURNAL_ASSUME_IMMUTABLE |                  \
+         SD_JOURNAL_PARALLEL)
 
 _public_ int sd_journal_open_directory(sd_journal **ret, const char *path, int flags) {
         _cleanup_(sd_journal_closep) sd_journal *j = NULL;
@@ -2413,7 +2997,8 @@ _public_ int sd_journal_open_directory(sd_journal **ret, const char *path, int f
 }
 
 #define OPEN_FILES_ALLOWED_FLAGS                        \
-        (SD_JOURNAL_ASSUME_IMMUTABLE)
+        (SD_JOURNAL_ASSUME_IMMUTABLE |                  \
+         SD_JOURNAL_PARALLEL)
 
 _public_ int sd_journal_open_files(sd_journal **ret, const char **paths, int flags) {
         _cleanup_(sd_journal_closep) sd_journal *j = NULL;
@@ -2443,7 +3028,8 @@ _public_ int sd_journal_open_files(sd_journal **ret, const char **paths, int fla
          SD_JOURNAL_SYSTEM |                            \
          SD_JOURNAL_CURRENT_USER |                      \
          SD_JOURNAL_TAKE_DIRECTORY_FD |                 \
-         SD_JOURNAL_ASSUME_IMMUTABLE)
+         SD_JOURNAL_ASSUME_IMMUTABLE |                  \
+         SD_JOURNAL_PARALLEL)
 
 _public_ int sd_journal_open_directory_fd(sd_journal **ret, int fd, int flags) {
         _cleanup_(sd_journal_closep) sd_journal *j = NULL;
@@ -2482,7 +3068,8 @@ _public_ int sd_journal_open_directory_fd(sd_journal **ret, int fd, int flags) {
 }
 
 #define OPEN_FILES_FD_ALLOWED_FLAGS                        \
-        (SD_JOURNAL_ASSUME_IMMUTABLE)
+        (SD_JOURNAL_ASSUME_IMMUTABLE |                     \
+         SD_JOURNAL_PARALLEL)
 
 _public_ int sd_journal_open_files_fd(sd_journal **ret, int fds[], unsigned n_fds, int flags) {
         JournalFile *f;
@@ -2569,6 +3156,7 @@ _public_ void sd_journal_close(sd_journal *j) {
         free(j->namespace);
         free(j->unique_field);
         free(j->fields_buffer);
+        strv_free(j->data_filter);
         free(j);
 }
 
@@ -2883,14 +3471,15 @@ _public_ int sd_journal_enumerate_data(sd_journal *j, const void **data, size_t
                 size_t l;
 
                 p = journal_file_entry_item_object_offset(f, o, j->current_field);
-                r = journal_file_data_payload(f, NULL, p, NULL, 0, j->data_threshold, &d, &l);
+                r = journal_file_data_payload_filtered(f, NULL, p, j->data_filter, j->data_threshold, &d, &l);
                 if (IN_SET(r, -EADDRNOTAVAIL, -EBADMSG)) {
                         log_debug_errno(r, "Entry item %"PRIu64" data object is bad, skipping over it: %m", j->current_field);
                         continue;
                 }
                 if (r < 0)
                         return r;
-                assert(r > 0);
+                if (r == 0)
+                        continue; /* Not one of the fields we are asked for */
 
                 *data = d;
                 *size = l;
@@ -3046,15 +3635,52 @@ static void process_q_overflow(sd_journal *j) {
         log_debug("Reiteration complete.");
 }
 
-static void process_inotify_event(sd_journal *j, const struct inotify_event *e) {
+static int process_modified_file(sd_journal *j, Directory *d, const char *filename) {
+        _cleanup_free_ char *path = NULL;
+        JournalFile *f;
+        uint64_t n;
+
+        assert(j);
+        assert(d);
+        assert(filename);
+
+        /* A file we already track was written to. It must still be the same inode, since replacing it
+         * would have generated IN_CREATE or IN_MOVED_TO, hence don't bother with reopening it like
+         * add_file_by_name() does. Returns > 0 if the file might have new entries, 0 if not, i.e. the
+         * writer only grew the file ahead of writing or changed its state, and -ENOENT if we don't know
+         * the file. */
+
+        path = path_join(d->path, filename);
+        if (!path)
+                return -ENOMEM;
+
+        f = ordered_hashmap_get(j->files, path);
+        if (!f)
+                return -ENOENT;
+
+        /* The header is mapped shared with the writer, hence this sees entries as soon as they are
+         * linked in. */
+        n = le64toh(READ_NOW(f->header->n_entries));
+        if (n == f->notified_n_entries)
+                return 0;
+
+        f->notified_n_entries = n;
+        (void) journal_file_read_tail_timestamp(j, f);
+
+        return 1;
+}
+
+static bool process_inotify_event(sd_journal *j, const struct inotify_event *e) {
         Directory *d;
 
         assert(j);
         assert(e);
 
+        /* Returns false if the event is known to not change anything for the caller. */
+
         if (e->mask & IN_Q_OVERFLOW) {
                 process_q_overflow(j);
-                return;
+                return true;
         }
 
         /* Is this a subdirectory we watch? */
@@ -3066,7 +3692,15 @@ static void process_inotify_event(sd_journal *j, const struct inotify_event *e)
 
                         /* Event for a journal file */
 
-                        if (e->mask & (IN_CREATE|IN_MOVED_TO|IN_MODIFY|IN_ATTRIB))
+                        if ((e->mask & (IN_CREATE|IN_MOVED_TO|IN_MODIFY|IN_ATTRIB)) == IN_MODIFY) {
+                                int r;
+
+                                r = process_modified_file(j, d, e->name);
+                                if (r >= 0)
+                                        return r > 0;
+
+                                (void) add_file_by_name(j, d->path, e->name);
+                        } else if (e->mask & (IN_CREATE|IN_MOVED_TO|IN_MODIFY|IN_ATTRIB))
                                 (void) add_file_by_name(j, d->path, e->name);
                         else if (e->mask & (IN_DELETE|IN_MOVED_FROM|IN_UNMOUNT))
                                 (void) remove_file_by_name(j, d->path, e->name);
@@ -3086,13 +3720,14 @@ static void process_inotify_event(sd_journal *j, const struct inotify_event *e)
                                 (void) add_directory(j, d->path, e->name);
                 }
 
-                return;
+                return true;
         }
 
         if (e->mask & IN_IGNORED)
-                return;
+                return true;
 
         log_debug("Unexpected inotify event.");
+        return true;
 }
 
 static int determine_change(sd_journal *j) {
@@ -3132,10 +3767,11 @@ _public_ int sd_journal_process(sd_journal *j) {
                         return -errno;
                 }
 
-                got_something = true;
-
+                /* Wakeups that only carried writes to files without new entries are not reported, so that
+                 * followers don't iterate through all files for nothing. */
                 FOREACH_INOTIFY_EVENT(e, buffer, l)
-                        process_inotify_event(j, e);
+                        if (process_inotify_event(j, e))
+                                got_something = true;
         }
 }
 
@@ -3366,12 +4002,39 @@ _public_ int sd_journal_enumerate_unique(
 
         for (;;) {
                 JournalFile *of;
-                Object *o;
-                void *odata;
+                Object *o = NULL;
+                const void *odata;
+                void *payload;
                 size_t ol;
                 bool found;
                 int r;
 
+                /* If the file comes with a summary of the field's values, return them from there, rather
+                 * than reading and decompressing all the data objects of the field. */
+                if (j->unique_offset == 0 && j->unique_file->unique_index) {
+                        r = journal_unique_index_get(j->unique_file->unique_index, j->unique_field, k, &j->unique_values);
+                        if (r < 0)
+                                return r;
+                        if (r > 0) {
+                                j->unique_offset = UINT64_MAX;
+                                j->unique_values_index = 0;
+                        }
+                }
+
+                if (j->unique_offset == UINT64_MAX) {
+                        if (j->unique_values_index < j->unique_values.n_values) {
+                                journal_unique_values_get(&j->unique_values, j->unique_values_index++, &odata, &ol);
+                                goto check;
+                        }
+
+                        j->unique_offset = 0;
+                        j->unique_file = ordered_hashmap_next(j->files, j->unique_file->path);
+                        if (!j->unique_file)
+                                return 0;
+
+                        continue;
+                }
+
                 /* Proceed to next data object in the field's linked list */
                 if (j->unique_offset == 0) {
                         r = journal_file_find_field_object(j->unique_file, j->unique_field, k, &o, NULL);
@@ -3406,22 +4069,25 @@ _public_ int sd_journal_enumerate_unique(
                         return r;
 
                 r = journal_file_data_payload(j->unique_file, o, j->unique_offset, NULL, 0,
-                                              j->data_threshold, &odata, &ol);
+                                              j->data_threshold, &payload, &ol);
                 if (r < 0)
                         return r;
 
+                odata = payload;
+
+        check:
                 /* Check if we have at least the field name and "=". */
                 if (ol <= k)
                         return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
                                                "%s:offset " OFSfmt ": object has size %zu, expected at least %zu",
                                                j->unique_file->path,
-                                               j->unique_offset, ol, k + 1);
+                                               o ? j->unique_offset : 0, ol, k + 1);
 
                 if (memcmp(odata, j->unique_field, k) != 0 || ((const char*) odata)[k] != '=')
                         return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
                                                "%s:offset " OFSfmt ": object does not start with \"%s=\"",
                                                j->unique_file->path,
-                                               j->unique_offset,
+                                               o ? j->unique_offset : 0,
                                                j->unique_field);
 
                 /* OK, now let's see if we already returned this data object by checking if it exists in the
@@ -3435,10 +4101,28 @@ _public_ int sd_journal_enumerate_unique(
                         if (JOURNAL_HEADER_CONTAINS(of->header, n_fields) && le64toh(of->header->n_fields) <= 0)
                                 continue;
 
+                        /* If the file has a summary of the field's values, look there, which is a bisection
+                         * in a few kilobytes, rather than a lookup in the file's hash table. */
+                        if (of->unique_index) {
+                                JournalUniqueValues v;
+
+                                r = journal_unique_index_get(of->unique_index, j->unique_field, k, &v);
+                                if (r < 0)
+                                        return r;
+                                if (r > 0) {
+                                        if (journal_unique_values_contain(&v, odata, ol)) {
+                                                found = true;
+                                                break;
+                                        }
+
+                                        continue;
+                                }
+                        }
+
                         /* We can reuse the hash from our current file only on old-style journal files
                          * without keyed hashes. On new-style files we have to calculate the hash anew, to
                          * take the per-file hash seed into consideration. */
-                        if (!JOURNAL_HEADER_KEYED_HASH(j->unique_file->header) && !JOURNAL_HEADER_KEYED_HASH(of->header))
+                        if (o && !JOURNAL_HEADER_KEYED_HASH(j->unique_file->header) && !JOURNAL_HEADER_KEYED_HASH(of->header))
                                 r = journal_file_find_data_object_with_hash(of, odata, ol, le64toh(o->data.hash), NULL, NULL);
                         else
                                 r = journal_file_find_data_object(of, odata, ol, NULL, NULL);
@@ -3719,6 +4403,29 @@ _public_ int sd_journal_get_data_threshold(sd_journal *j, size_t *sz) {
         return 0;
 }
 
+_public_ int sd_journal_set_data_filter(sd_journal *j, char **fields) {
+        _cleanup_strv_free_ char **copy = NULL;
+
+        assert_return(j, -EINVAL);
+        assert_return(!journal_origin_changed(j), -ECHILD);
+
+        STRV_FOREACH(field, fields)
+                if (!field_is_valid(*field))
+                        return -EINVAL;
+
+        if (strv_equal(j->data_filter, fields))
+                return 0;
+
+        if (!strv_isempty(fields)) {
+                copy = strv_copy(fields);
+                if (!copy)
+                        return -ENOMEM;
+        }
+
+        strv_free_and_replace(j->data_filter, copy);
+        return 0;
+}
+
 _public_ int sd_journal_has_runtime_files(sd_journal *j) {
         assert_return(j, -EINVAL);
 
@@ -0,0 +1,209 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sd-journal.h"
+
+#include "alloc-util.h"
+#include "fd-util.h"
+#include "iovec-util.h"
+#include "journal-boot-index.h"
+#include "journal-file-util.h"
+#include "journal-internal.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "string-util.h"
+#include "tests.h"
+#include "tmpfile-util.h"
+
+static dual_timestamp ts = {};
+
+/* Like journald, carry the seqnum over from file to file */
+static uint64_t seqnum = 0;
+static sd_id128_t seqnum_id = {};
+
+static JournalFile* open_journal(const char *dir, const char *name) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_free_ char *path = NULL;
+        JournalFile *f;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(path = path_join(dir, name));
+        ASSERT_OK(journal_file_open(-EBADF, path, O_RDWR|O_CREAT, JOURNAL_COMPRESS, 0644, UINT64_MAX, NULL, m, NULL, &f));
+
+        return f;
+}
+
+static void append(JournalFile *f, sd_id128_t boot_id, unsigned n) {
+        _cleanup_free_ char *b = NULL;
+
+        ASSERT_NOT_NULL(b = strjoin("_BOOT_ID=", SD_ID128_TO_STRING(boot_id)));
+
+        for (unsigned i = 0; i < n; i++) {
+                _cleanup_free_ char *number = NULL;
+                struct iovec iovec[2];
+
+                ASSERT_OK(asprintf(&number, "NUMBER=%u", i));
+                iovec[0] = IOVEC_MAKE_STRING(number);
+                iovec[1] = IOVEC_MAKE_STRING(b);
+
+                ts.realtime++;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(f, &ts, &boot_id, iovec, ELEMENTSOF(iovec), &seqnum, &seqnum_id, NULL, NULL));
+        }
+}
+
+static void archive(JournalFile *f) {
+        ASSERT_OK(journal_file_archive(f, NULL));
+
+        /* Offlining an archived file updates the boot index */
+        journal_file_offline_close(f);
+}
+
+TEST(journal_file_get_boots) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_(journal_file_offline_closep) JournalFile *f = NULL;
+        _cleanup_free_ JournalBoot *boots = NULL;
+        sd_id128_t ids[3];
+        uint64_t start_seqnum;
+        usec_t start;
+        size_t n;
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-boot-index-XXXXXX", &t));
+        ASSERT_NOT_NULL(f = open_journal(t, "test.journal"));
+
+        ASSERT_OK(journal_file_get_boots(f, &boots, &n));
+        ASSERT_EQ(n, 0U);
+
+        dual_timestamp_now(&ts);
+        start = ts.realtime;
+        start_seqnum = seqnum;
+
+        /* Make the second boot large enough to span multiple entry arrays */
+        FOREACH_ELEMENT(id, ids)
+                ASSERT_OK(sd_id128_randomize(id));
+        append(f, ids[0], 1);
+        append(f, ids[1], 500);
+        append(f, ids[2], 3);
+
+        ASSERT_OK(journal_file_get_boots(f, &boots, &n));
+        ASSERT_EQ(n, 3U);
+
+        FOREACH_ARRAY(b, boots, n) {
+                ASSERT_EQ_ID128(b->seqnum_id, f->header->seqnum_id);
+
+                if (sd_id128_equal(b->boot_id, ids[0])) {
+                        ASSERT_EQ(b->first_realtime, start + 1);
+                        ASSERT_EQ(b->last_realtime, start + 1);
+                        ASSERT_EQ(b->first_seqnum, start_seqnum + 1);
+                        ASSERT_EQ(b->last_seqnum, start_seqnum + 1);
+                } else if (sd_id128_equal(b->boot_id, ids[1])) {
+                        ASSERT_EQ(b->first_realtime, start + 2);
+                        ASSERT_EQ(b->last_realtime, start + 501);
+                        ASSERT_EQ(b->first_seqnum, start_seqnum + 2);
+                        ASSERT_EQ(b->last_seqnum, start_seqnum + 501);
+                } else {
+                        ASSERT_EQ_ID128(b->boot_id, ids[2]);
+                        ASSERT_EQ(b->first_realtime, start + 502);
+                        ASSERT_EQ(b->last_realtime, start + 504);
+                        ASSERT_EQ(b->first_seqnum, start_seqnum + 502);
+                        ASSERT_EQ(b->last_seqnum, start_seqnum + 504);
+                }
+        }
+}
+
+static uint64_t boot_index_n_items(const char *dir) {
+        _cleanup_free_ char *p = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        JournalBootIndexHeader h;
+
+        ASSERT_NOT_NULL(p = path_join(dir, JOURNAL_BOOT_INDEX_FILENAME));
+        ASSERT_OK_ERRNO(fd = open(p, O_RDONLY|O_CLOEXEC));
+        ASSERT_OK_EQ_ERRNO(pread(fd, &h, sizeof(h), 0), (ssize_t) sizeof(h));
+
+        return le64toh(h.n_items);
+}
+
+TEST(journal_boot_index) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_(journal_file_offline_closep) JournalFile *online = NULL;
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_free_ JournalBoot *boots = NULL;
+        _cleanup_free_ char *two = NULL;
+        JournalFile *f, *x;
+        sd_id128_t ids[5];
+        unsigned n_indexed = 0;
+        size_t n;
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-boot-index-XXXXXX", &t));
+
+        FOREACH_ELEMENT(id, ids)
+                ASSERT_OK(sd_id128_randomize(id));
+
+        dual_timestamp_now(&ts);
+
+        /* Two archived files, with a boot spanning both of them */
+        ASSERT_NOT_NULL(x = open_journal(t, "one.journal"));
+        append(x, ids[0], 3);
+        append(x, ids[1], 2);
+        archive(x);
+
+        ASSERT_NOT_NULL(x = open_journal(t, "two.journal"));
+        append(x, ids[1], 2);
+        append(x, ids[2], 2);
+        ASSERT_OK(journal_file_archive(x, NULL));
+        ASSERT_NOT_NULL(two = strdup(x->path));
+        journal_file_offline_close(x);
+
+        ASSERT_EQ(boot_index_n_items(t), 4U);
+
+        /* And an active one, which is not covered by the index */
+        ASSERT_NOT_NULL(online = open_journal(t, "system.journal"));
+        append(online, ids[2], 1);
+
+        /* The clock went backwards during the last boot, it still needs to be ordered last */
+        ts.realtime -= 1000;
+        append(online, ids[3], 2);
+
+        ASSERT_OK(sd_journal_open_directory(&j, t, 0));
+
+        ORDERED_HASHMAP_FOREACH(f, j->files) {
+                _cleanup_(journal_boot_index_freep) JournalBootIndex *i = NULL;
+                _cleanup_free_ JournalBoot *b = NULL;
+                _cleanup_close_ int fd = -EBADF;
+                int r;
+
+                ASSERT_OK_ERRNO(fd = open(t, O_RDONLY|O_DIRECTORY|O_CLOEXEC));
+                ASSERT_OK_POSITIVE(journal_boot_index_open(fd, &i));
+
+                ASSERT_OK(r = journal_boot_index_get(i, f, &b, &n));
+                if (r > 0) {
+                        ASSERT_EQ(n, 2U);
+                        n_indexed++;
+                } else
+                        ASSERT_TRUE(streq(f->path, online->path));
+        }
+        ASSERT_EQ(n_indexed, 2U);
+
+        ASSERT_OK(journal_enumerate_boots(j, &boots, &n));
+        ASSERT_EQ(n, 4U);
+        for (size_t i = 0; i < n; i++)
+                ASSERT_EQ_ID128(boots[i].boot_id, ids[i]);
+
+        /* ids[1] spans the two archived files, ids[2] an archived and the active file */
+        ASSERT_EQ(boots[1].last_realtime - boots[1].first_realtime, 3U);
+        ASSERT_EQ(boots[2].last_realtime - boots[2].first_realtime, 2U);
+        ASSERT_TRUE(boots[2].first_realtime > boots[1].last_realtime);
+
+        /* Items of removed files are dropped with the next update */
+        ASSERT_OK_ERRNO(unlink(two));
+
+        ASSERT_NOT_NULL(x = open_journal(t, "three.journal"));
+        append(x, ids[4], 1);
+        archive(x);
+
+        ASSERT_EQ(boot_index_n_items(t), 3U);
+}
+
+DEFINE_TEST_MAIN(LOG_DEBUG);
@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sd-journal.h"
+
+#include "alloc-util.h"
+#include "iovec-util.h"
+#include "journal-file-util.h"
+#include "logs-show.h"
+#include "memstream-util.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "set.h"
+#include "string-util.h"
+#include "strv.h"
+#include "tests.h"
+#include "tmpfile-util.h"
+#include "unaligned.h"
+
+#define N_ENTRIES 3000U
+
+static char* create_journal(const char *dir) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_free_ char *path = NULL;
+        JournalFile *f;
+        dual_timestamp ts;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(path = path_join(dir, "test.journal"));
+        ASSERT_OK(journal_file_open(-EBADF, path, O_RDWR|O_CREAT, JOURNAL_COMPRESS, 0644, UINT64_MAX, NULL, m, NULL, &f));
+
+        dual_timestamp_now(&ts);
+
+        for (unsigned i = 0; i < N_ENTRIES; i++) {
+                _cleanup_free_ char *number = NULL;
+                struct iovec iovec[4];
+                size_t n = 0;
+
+                ASSERT_OK(asprintf(&number, "NUMBER=%u", i));
+                iovec[n++] = IOVEC_MAKE_STRING(number);
+                iovec[n++] = IOVEC_MAKE_STRING("MESSAGE=hello");
+
+                /* Every third entry carries TAG twice, every other entry not at all */
+                if (i % 2 == 0)
+                        iovec[n++] = IOVEC_MAKE_STRING("TAG=a");
+                if (i % 6 == 0)
+                        iovec[n++] = IOVEC_MAKE_STRING("TAG=b");
+
+                ts.realtime++;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(f, &ts, NULL, iovec, n, NULL, NULL, NULL, NULL));
+        }
+
+        journal_file_offline_close(f);
+
+        return TAKE_PTR(path);
+}
+
+static void parse_batches(const uint8_t *p, size_t size, unsigned *ret_entries, Set **ret_names, unsigned *ret_tags) {
+        unsigned n_entries = 0, n_tags = 0;
+
+        while (size > 0) {
+                const uint8_t *end;
+                uint64_t batch_size;
+                uint32_t n, k;
+
+                ASSERT_GE(size, sizeof(le64_t) + 2 * sizeof(le32_t));
+                batch_size = unaligned_read_le64(p);
+                ASSERT_LE(batch_size, size - sizeof(le64_t));
+                end = p + sizeof(le64_t) + batch_size;
+
+                n = unaligned_read_le32(p + sizeof(le64_t));
+                k = unaligned_read_le32(p + sizeof(le64_t) + sizeof(le32_t));
+                p += sizeof(le64_t) + 2 * sizeof(le32_t);
+
+                for (uint32_t c = 0; c < k; c++) {
+                        _cleanup_free_ char *name = NULL;
+                        uint64_t values_size = 0;
+                        uint32_t l;
+
+                        l = unaligned_read_le32(p);
+                        p += sizeof(le32_t);
+                        ASSERT_NOT_NULL(name = strndup((const char*) p, l));
+                        p += l;
+
+                        for (uint32_t e = 0; e < n; e++) {
+                                uint64_t v = unaligned_read_le64(p + e * sizeof(le64_t));
+
+                                if (v == UINT64_MAX)
+                                        continue;
+
+                                values_size += v;
+                                if (streq(name, "TAG"))
+                                        n_tags++;
+                        }
+                        p += n * sizeof(le64_t);
+                        p += values_size;
+
+                        ASSERT_OK(set_put_strdup(ret_names, name));
+                }
+
+                ASSERT_TRUE(p == end);
+
+                size -= sizeof(le64_t) + batch_size;
+                n_entries += n;
+        }
+
+        *ret_entries = n_entries;
+        *ret_tags = n_tags;
+}
+
+static void test_columnar_one(const char *path, Set *output_fields, unsigned expected_tags) {
+        _cleanup_(journal_columnar_writer_freep) JournalColumnarWriter *w = NULL;
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_(memstream_done) MemStream m = {};
+        _cleanup_set_free_ Set *names = NULL;
+        _cleanup_free_ char *buf = NULL;
+        unsigned n_entries, n_tags;
+        size_t size;
+        FILE *f;
+
+        ASSERT_OK(sd_journal_open_files(&j, (const char**) STRV_MAKE(path), 0));
+        ASSERT_NOT_NULL(f = memstream_init(&m));
+        ASSERT_OK(journal_columnar_writer_new(f, output_fields, &w));
+
+        SD_JOURNAL_FOREACH(j)
+                ASSERT_OK(journal_columnar_writer_add(w, j));
+        ASSERT_OK(journal_columnar_writer_flush(w));
+
+        ASSERT_OK(memstream_finalize(&m, &buf, &size));
+        parse_batches((const uint8_t*) buf, size, &n_entries, &names, &n_tags);
+
+        ASSERT_EQ(n_entries, N_ENTRIES);
+        ASSERT_EQ(n_tags, expected_tags);
+
+        ASSERT_TRUE(set_contains(names, "__CURSOR"));
+        ASSERT_TRUE(set_contains(names, "_BOOT_ID"));
+        ASSERT_TRUE(set_contains(names, "NUMBER"));
+        ASSERT_EQ(set_contains(names, "MESSAGE"), !output_fields);
+}
+
+TEST(journal_columnar) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_set_free_ Set *output_fields = NULL;
+        _cleanup_free_ char *path = NULL;
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-columnar-XXXXXX", &t));
+        ASSERT_NOT_NULL(path = create_journal(t));
+
+        /* All values, including the repeated ones */
+        test_columnar_one(path, NULL, DIV_ROUND_UP(N_ENTRIES, 2) + DIV_ROUND_UP(N_ENTRIES, 6));
+
+        /* With a projection only the first value of a field is looked up */
+        ASSERT_OK(set_put_strdupv(&output_fields, STRV_MAKE("NUMBER", "TAG")));
+        test_columnar_one(path, output_fields, DIV_ROUND_UP(N_ENTRIES, 2));
+}
+
+DEFINE_TEST_MAIN(LOG_INFO);
@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sd-journal.h"
+
+#include "alloc-util.h"
+#include "iovec-util.h"
+#include "journal-file-util.h"
+#include "journal-internal.h"
+#include "journal-verify.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "strv.h"
+#include "tests.h"
+#include "tmpfile-util.h"
+
+/* Enough unique small payloads to collect the training samples, and then some more */
+#define N_ENTRIES 20000U
+
+static const char *const users[] = { "root", "alice", "bob", "carol" };
+
+static char* message(unsigned i) {
+        char *s;
+
+        ASSERT_OK(asprintf(&s, "MESSAGE=Started session %u of user %s.", i, users[i % ELEMENTSOF(users)]));
+        return s;
+}
+
+TEST(journal_dictionary) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_free_ char *path = NULL;
+        uint64_t n_compressed = 0;
+        JournalFile *f;
+        dual_timestamp ts;
+        unsigned n = 0;
+        Object *o;
+        uint64_t p;
+
+        if (!compression_supported(COMPRESSION_ZSTD))
+                return (void) log_tests_skipped("zstd not supported");
+
+        ASSERT_OK_ERRNO(setenv("SYSTEMD_JOURNAL_COMPRESS", "zstd", /* overwrite = */ true));
+        ASSERT_OK_ERRNO(setenv("SYSTEMD_JOURNAL_COMPRESS_DICTIONARY", "1", /* overwrite = */ true));
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-dictionary-XXXXXX", &t));
+        ASSERT_NOT_NULL(path = path_join(t, "test.journal"));
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_OK(journal_file_open(-EBADF, path, O_RDWR|O_CREAT, JOURNAL_COMPRESS, 0644, UINT64_MAX, NULL, m, NULL, &f));
+
+        /* The flag is set right away, the dictionary is only referenced once trained */
+        ASSERT_TRUE(JOURNAL_HEADER_DICTIONARY(f->header));
+        ASSERT_EQ(le64toh(f->header->dictionary_offset), 0U);
+
+        dual_timestamp_now(&ts);
+
+        for (unsigned i = 0; i < N_ENTRIES; i++) {
+                _cleanup_free_ char *msg = NULL;
+                struct iovec iovec[1];
+
+                ASSERT_NOT_NULL(msg = message(i));
+                iovec[0] = IOVEC_MAKE_STRING(msg);
+
+                ts.realtime++;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(f, &ts, NULL, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL, NULL));
+        }
+
+        ASSERT_NE(le64toh(f->header->dictionary_offset), 0U);
+        ASSERT_OK(journal_file_move_to_object(f, OBJECT_DICTIONARY, le64toh(f->header->dictionary_offset), &o));
+
+        /* Walk all objects and make sure small DATA objects after the dictionary actually use it */
+        p = le64toh(f->header->header_size);
+        for (;;) {
+                ASSERT_OK(journal_file_move_to_object(f, OBJECT_UNUSED, p, &o));
+
+                if (o->object.type == OBJECT_DATA && FLAGS_SET(o->object.flags, OBJECT_COMPRESSED_DICTIONARY)) {
+                        ASSERT_GT(p, le64toh(f->header->dictionary_offset));
+                        n_compressed++;
+                }
+
+                if (p == le64toh(f->header->tail_object_offset))
+                        break;
+
+                p += ALIGN64(le64toh(o->object.size));
+        }
+        ASSERT_GT(n_compressed, 0U);
+
+        ASSERT_OK(journal_file_verify(f, NULL, NULL, NULL, NULL, false));
+        journal_file_offline_close(f);
+
+        /* And read everything back from a fresh file object */
+        ASSERT_OK(sd_journal_open_files(&j, (const char**) STRV_MAKE(path), 0));
+
+        SD_JOURNAL_FOREACH(j) {
+                _cleanup_free_ char *msg = NULL;
+                const void *d;
+                size_t l;
+
+                ASSERT_NOT_NULL(msg = message(n));
+
+                ASSERT_OK(sd_journal_get_data(j, "MESSAGE", &d, &l));
+                ASSERT_EQ(memcmp_nn(d, l, msg, strlen(msg)), 0);
+                n++;
+        }
+        ASSERT_EQ(n, N_ENTRIES);
+
+        ASSERT_OK(sd_journal_add_match(j, "MESSAGE=Started session 4711 of user carol.", SIZE_MAX));
+        n = 0;
+        SD_JOURNAL_FOREACH(j)
+                n++;
+        ASSERT_EQ(n, 1U);
+}
+
+DEFINE_TEST_MAIN(LOG_INFO);
@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "copy.h"
+#include "fd-util.h"
+#include "iovec-util.h"
+#include "journal-fanout.h"
+#include "journal-file-util.h"
+#include "journal-verify.h"
+#include "path-util.h"
+#include "random-util.h"
+#include "rm-rf.h"
+#include "tests.h"
+#include "time-util.h"
+#include "tmpfile-util.h"
+
+/* Enough entries for the global chain and the chains of the PARITY= data objects to get fan-out objects */
+#define N_ENTRIES 50000U
+#define N_LOOKUPS 20000U
+
+static JournalFile* open_journal(const char *path, int flags, MMapCache *m) {
+        JournalFile *f;
+
+        ASSERT_OK(journal_file_open(-EBADF, path, flags, JOURNAL_COMPRESS, 0644, UINT64_MAX, NULL, m, NULL, &f));
+        return f;
+}
+
+static void strip_fanout(const char *path) {
+        _cleanup_close_ int fd = -EBADF;
+        le32_t flags;
+        le64_t offset = 0;
+
+        /* Turns the copy into a file without fan-out objects, as far as readers are concerned */
+        ASSERT_OK_ERRNO(fd = open(path, O_RDWR|O_CLOEXEC));
+        ASSERT_OK_EQ_ERRNO(pread(fd, &flags, sizeof(flags), offsetof(Header, compatible_flags)), (ssize_t) sizeof(flags));
+        flags = htole32(le32toh(flags) & ~HEADER_COMPATIBLE_ENTRY_ARRAY_FANOUT);
+        ASSERT_OK_EQ_ERRNO(pwrite(fd, &flags, sizeof(flags), offsetof(Header, compatible_flags)), (ssize_t) sizeof(flags));
+        ASSERT_OK_EQ_ERRNO(pwrite(fd, &offset, sizeof(offset), offsetof(Header, entry_array_fanout_offset)), (ssize_t) sizeof(offset));
+}
+
+static usec_t seek_by_seqnum(JournalFile *f, const uint64_t *seqnums, uint64_t *offsets) {
+        usec_t start = now(CLOCK_MONOTONIC);
+
+        for (unsigned i = 0; i < N_LOOKUPS; i++) {
+                Object *o;
+
+                ASSERT_OK_POSITIVE(journal_file_move_to_entry_by_seqnum(f, seqnums[i], DIRECTION_DOWN, &o, offsets + i));
+                ASSERT_EQ(le64toh(o->entry.seqnum), seqnums[i]);
+        }
+
+        return usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+}
+
+static usec_t seek_by_seqnum_for_data(JournalFile *f, const uint64_t *seqnums, uint64_t *offsets) {
+        usec_t start = now(CLOCK_MONOTONIC);
+        uint64_t p;
+        Object *d;
+
+        for (unsigned i = 0; i < N_LOOKUPS; i++) {
+                Object *o;
+
+                /* Entries with an odd index, i.e. even seqnum, carry PARITY=odd */
+                ASSERT_OK_POSITIVE(journal_file_find_data_object(f, "PARITY=odd", STRLEN("PARITY=odd"), &d, &p));
+                ASSERT_OK_POSITIVE(journal_file_move_to_entry_by_seqnum_for_data(f, d, seqnums[i], DIRECTION_DOWN, &o, offsets + i));
+                ASSERT_EQ(le64toh(o->entry.seqnum), seqnums[i] + (seqnums[i] % 2));
+        }
+
+        return usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+}
+
+TEST(journal_fanout) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_free_ uint64_t *seqnums = NULL, *offsets_fanout = NULL, *offsets_plain = NULL;
+        _cleanup_free_ char *path = NULL, *archived = NULL, *plain = NULL;
+        JournalFile *f, *g;
+        dual_timestamp ts;
+        usec_t u, v;
+        uint64_t p, q;
+        Object *o;
+
+        ASSERT_OK_ERRNO(setenv("SYSTEMD_JOURNAL_ENTRY_ARRAY_FANOUT", "1", /* overwrite = */ true));
+        ASSERT_TRUE(journal_fanout_enabled());
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-fanout-XXXXXX", &t));
+        ASSERT_NOT_NULL(path = path_join(t, "test.journal"));
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+
+        f = open_journal(path, O_RDWR|O_CREAT, m);
+
+        dual_timestamp_now(&ts);
+
+        for (unsigned i = 0; i < N_ENTRIES; i++) {
+                _cleanup_free_ char *number = NULL;
+                struct iovec iovec[2];
+
+                ASSERT_OK(asprintf(&number, "NUMBER=%u", i));
+                iovec[0] = IOVEC_MAKE_STRING(number);
+                iovec[1] = IOVEC_MAKE_STRING(i % 2 == 0 ? "PARITY=even" : "PARITY=odd");
+
+                ts.realtime++;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(f, &ts, NULL, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL, NULL));
+        }
+
+        ASSERT_FALSE(JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(f->header));
+        ASSERT_OK(journal_file_archive(f, NULL));
+
+        /* One fan-out object for the global chain, and one for each of the two PARITY= chains */
+        ASSERT_TRUE(JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(f->header));
+        q = 0;
+        for (p = le64toh(f->header->entry_array_fanout_offset); p != 0; p = le64toh(o->entry_array_fanout.next_fanout_offset)) {
+                ASSERT_OK(journal_file_move_to_object(f, OBJECT_ENTRY_ARRAY_FANOUT, p, &o));
+                q++;
+        }
+        ASSERT_EQ(q, 3U);
+
+        ASSERT_OK(journal_file_verify(f, NULL, NULL, NULL, NULL, false));
+
+        /* Writing again is a NOP */
+        ASSERT_OK_ZERO(journal_fanout_write(f));
+
+        ASSERT_NOT_NULL(archived = strdup(f->path));
+        journal_file_offline_close(f);
+
+        ASSERT_NOT_NULL(plain = path_join(t, "plain.journal"));
+        ASSERT_OK(copy_file(archived, plain, O_EXCL, 0644, 0));
+        strip_fanout(plain);
+
+        f = open_journal(archived, O_RDONLY, m);
+        g = open_journal(plain, O_RDONLY, m);
+        ASSERT_TRUE(JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(f->header));
+        ASSERT_FALSE(JOURNAL_HEADER_ENTRY_ARRAY_FANOUT(g->header));
+
+        ASSERT_NOT_NULL(seqnums = new(uint64_t, N_LOOKUPS));
+        ASSERT_NOT_NULL(offsets_fanout = new(uint64_t, N_LOOKUPS));
+        ASSERT_NOT_NULL(offsets_plain = new(uint64_t, N_LOOKUPS));
+
+        /* Random seeks, so that the chain cache can't help much */
+        for (unsigned i = 0; i < N_LOOKUPS; i++)
+                seqnums[i] = 1 + random_u64_range(N_ENTRIES - 1);
+
+        u = seek_by_seqnum(f, seqnums, offsets_fanout);
+        v = seek_by_seqnum(g, seqnums, offsets_plain);
+        ASSERT_EQ(memcmp(offsets_fanout, offsets_plain, N_LOOKUPS * sizeof(uint64_t)), 0);
+        log_info("Seeking by seqnum: %s with fan-out, %s without.", FORMAT_TIMESPAN(u, 0), FORMAT_TIMESPAN(v, 0));
+
+        u = seek_by_seqnum_for_data(f, seqnums, offsets_fanout);
+        v = seek_by_seqnum_for_data(g, seqnums, offsets_plain);
+        ASSERT_EQ(memcmp(offsets_fanout, offsets_plain, N_LOOKUPS * sizeof(uint64_t)), 0);
+        log_info("Seeking by seqnum for data: %s with fan-out, %s without.", FORMAT_TIMESPAN(u, 0), FORMAT_TIMESPAN(v, 0));
+
+        /* Iterating through all entries must yield the same as well */
+        p = q = 0;
+        for (unsigned i = 0; i < N_ENTRIES; i++) {
+                ASSERT_OK_POSITIVE(journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p));
+                ASSERT_OK_POSITIVE(journal_file_next_entry(g, q, DIRECTION_DOWN, &o, &q));
+                ASSERT_EQ(p, q);
+        }
+        ASSERT_OK_ZERO(journal_file_next_entry(f, p, DIRECTION_DOWN, NULL, NULL));
+
+        journal_file_close(f);
+        journal_file_close(g);
+}
+
+DEFINE_TEST_MAIN(LOG_INFO);
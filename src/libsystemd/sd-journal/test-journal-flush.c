@@ -9,6 +9,7 @@
 #include "chattr-util.h"
 #include "dirent-util.h"
 #include "fd-util.h"
+#include "iovec-util.h"
 #include "journal-file-util.h"
 #include "journal-internal.h"
 #include "logs-show.h"
@@ -139,7 +140,7 @@ static void test_journal_flush_one(int argc, char *argv[]) {
                         log_error_errno(r, "journal_file_move_to_object failed: %m");
                 assert_se(r >= 0);
 
-                r = journal_file_copy_entry(f, new_journal, o, f->current_offset, NULL, NULL);
+                r = journal_file_copy_entry(f, new_journal, o, f->current_offset, NULL, NULL, NULL);
                 if (r < 0)
                         log_warning_errno(r, "journal_file_copy_entry failed: %m");
                 assert_se(r >= 0 ||
@@ -197,4 +198,62 @@ TEST(journal_flush_compact) {
         test_journal_flush_one(saved_argc, saved_argv);
 }
 
+TEST(journal_copy_cache) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_(rm_rf_physical_and_freep) char *dn = NULL;
+        _cleanup_(journal_file_offline_closep) JournalFile *from = NULL, *to = NULL;
+        _cleanup_(journal_file_copy_cache_done) JournalFileCopyCache cache = {};
+        _cleanup_free_ char *a = NULL, *b = NULL;
+        dual_timestamp ts;
+        sd_id128_t boot_id;
+        uint64_t p;
+        Object *o;
+        unsigned n = 0;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_OK(mkdtemp_malloc("/var/tmp/test-journal-copy-cache.XXXXXX", &dn));
+        ASSERT_NOT_NULL(a = path_join(dn, "from.journal"));
+        ASSERT_NOT_NULL(b = path_join(dn, "to.journal"));
+
+        ASSERT_OK(journal_file_open(-EBADF, a, O_CREAT|O_RDWR, JOURNAL_COMPRESS, 0644, UINT64_MAX, NULL, m, NULL, &from));
+        ASSERT_OK(journal_file_open(-EBADF, b, O_CREAT|O_RDWR, JOURNAL_COMPRESS, 0644, UINT64_MAX, NULL, m, NULL, &to));
+
+        ASSERT_OK(sd_id128_randomize(&boot_id));
+        dual_timestamp_now(&ts);
+
+        /* A field shared by all entries, one with a few values, and one unique per entry */
+        for (unsigned i = 0; i < 100; i++) {
+                _cleanup_free_ char *x = NULL, *y = NULL;
+                struct iovec iovec[3];
+
+                ASSERT_OK(asprintf(&x, "SOME=%u", i % 3));
+                ASSERT_OK(asprintf(&y, "UNIQUE=%u", i));
+                iovec[0] = IOVEC_MAKE_STRING("SHARED=yes");
+                iovec[1] = IOVEC_MAKE_STRING(x);
+                iovec[2] = IOVEC_MAKE_STRING(y);
+
+                ts.realtime++;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(from, &ts, &boot_id, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL, NULL));
+        }
+
+        for (p = 0; journal_file_next_entry(from, p, DIRECTION_DOWN, &o, &p) > 0; n++)
+                ASSERT_OK(journal_file_copy_entry(from, to, o, p, NULL, NULL, &cache));
+
+        ASSERT_EQ(n, 100U);
+        ASSERT_EQ(le64toh(to->header->n_entries), 100U);
+
+        /* Only the shared values are remembered, and every value exists exactly once in the destination */
+        ASSERT_EQ(hashmap_size(cache.data_objects), 4U);
+        ASSERT_EQ(le64toh(to->header->n_data), le64toh(from->header->n_data));
+
+        /* The copied entries reference the same values as the originals */
+        ASSERT_OK_POSITIVE(journal_file_find_data_object(to, "SHARED=yes", STRLEN("SHARED=yes"), &o, NULL));
+        ASSERT_EQ(le64toh(o->data.n_entries), 100U);
+        ASSERT_OK_POSITIVE(journal_file_find_data_object(to, "SOME=1", STRLEN("SOME=1"), &o, NULL));
+        ASSERT_EQ(le64toh(o->data.n_entries), 33U);
+        ASSERT_OK_POSITIVE(journal_file_find_data_object(to, "UNIQUE=42", STRLEN("UNIQUE=42"), &o, NULL));
+        ASSERT_EQ(le64toh(o->data.n_entries), 1U);
+}
+
 DEFINE_TEST_MAIN(LOG_INFO);
@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sd-journal.h"
+
+#include "alloc-util.h"
+#include "fd-util.h"
+#include "iovec-util.h"
+#include "journal-file-util.h"
+#include "journal-index.h"
+#include "journal-internal.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "string-util.h"
+#include "strv.h"
+#include "tests.h"
+#include "tmpfile-util.h"
+
+#define N_ENTRIES 200U
+
+static char* create_archived_journal(const char *dir) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_free_ char *path = NULL, *archived = NULL;
+        JournalFile *f;
+        dual_timestamp ts;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(path = path_join(dir, "test.journal"));
+        ASSERT_OK(journal_file_open(-EBADF, path, O_RDWR|O_CREAT, JOURNAL_COMPRESS, 0644, UINT64_MAX, NULL, m, NULL, &f));
+
+        dual_timestamp_now(&ts);
+
+        for (unsigned i = 0; i < N_ENTRIES; i++) {
+                _cleanup_free_ char *number = NULL;
+                struct iovec iovec[3];
+
+                ASSERT_OK(asprintf(&number, "NUMBER=%u", i));
+                iovec[0] = IOVEC_MAKE_STRING(number);
+                iovec[1] = IOVEC_MAKE_STRING(i % 2 == 0 ? "PARITY=even" : "PARITY=odd");
+                iovec[2] = IOVEC_MAKE_STRING(i % 3 == 0 ? "THIRD=yes" : "THIRD=no");
+
+                ts.realtime++;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(f, &ts, NULL, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL, NULL));
+        }
+
+        ASSERT_OK(journal_file_archive(f, NULL));
+        ASSERT_NOT_NULL(archived = strdup(f->path));
+
+        /* Offlining an archived file writes the index if $SYSTEMD_JOURNAL_INDEX is set */
+        journal_file_offline_close(f);
+
+        return TAKE_PTR(archived);
+}
+
+static unsigned count_matches(const char *path, bool *ret_indexed) {
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        unsigned n = 0;
+        JournalFile *f;
+
+        ASSERT_OK(sd_journal_open_files(&j, (const char**) STRV_MAKE(path), 0));
+
+        ASSERT_NOT_NULL(f = ordered_hashmap_first(j->files));
+        *ret_indexed = f->index;
+
+        ASSERT_OK(sd_journal_add_match(j, "PARITY=even", SIZE_MAX));
+        ASSERT_OK(sd_journal_add_match(j, "THIRD=yes", SIZE_MAX));
+
+        SD_JOURNAL_FOREACH(j)
+                n++;
+
+        /* And backwards again */
+        SD_JOURNAL_FOREACH_BACKWARDS(j)
+                n++;
+
+        return n;
+}
+
+TEST(journal_index) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_free_ char *path = NULL, *idx = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        bool indexed;
+
+        ASSERT_OK_ERRNO(setenv("SYSTEMD_JOURNAL_INDEX", "1", /* overwrite = */ true));
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-index-XXXXXX", &t));
+        ASSERT_NOT_NULL(path = create_archived_journal(t));
+
+        ASSERT_OK(journal_index_path(path, &idx));
+        ASSERT_OK_ERRNO(access(idx, F_OK));
+
+        /* Entries divisible by 6, counted twice since we iterate in both directions */
+        ASSERT_EQ(count_matches(path, &indexed), 2 * DIV_ROUND_UP(N_ENTRIES, 6));
+        ASSERT_TRUE(indexed);
+
+        /* A stale index must be ignored */
+        ASSERT_OK_ERRNO(fd = open(idx, O_WRONLY|O_CLOEXEC));
+        ASSERT_OK_EQ_ERRNO(pwrite(fd, &(le64_t) { htole64(4711) }, sizeof(le64_t), offsetof(JournalIndexHeader, n_entries)),
+                           (ssize_t) sizeof(le64_t));
+
+        ASSERT_EQ(count_matches(path, &indexed), 2 * DIV_ROUND_UP(N_ENTRIES, 6));
+        ASSERT_FALSE(indexed);
+
+        /* And so must a missing one */
+        ASSERT_OK(journal_index_remove_at(AT_FDCWD, path));
+        ASSERT_ERROR_ERRNO(access(idx, F_OK), ENOENT);
+
+        ASSERT_EQ(count_matches(path, &indexed), 2 * DIV_ROUND_UP(N_ENTRIES, 6));
+        ASSERT_FALSE(indexed);
+}
+
+TEST(journal_index_lookup) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_(journal_index_freep) JournalIndex *x = NULL;
+        _cleanup_(journal_file_closep) JournalFile *f = NULL;
+        _cleanup_free_ char *path = NULL;
+        uint64_t dp, head, tail;
+        Object *d;
+
+        ASSERT_OK_ERRNO(setenv("SYSTEMD_JOURNAL_INDEX", "1", /* overwrite = */ true));
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-index-XXXXXX", &t));
+        ASSERT_NOT_NULL(path = create_archived_journal(t));
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_OK(journal_file_open(-EBADF, path, O_RDONLY, 0, 0, UINT64_MAX, NULL, m, NULL, &f));
+        ASSERT_OK_POSITIVE(journal_index_open(AT_FDCWD, f, &x));
+
+        ASSERT_OK_POSITIVE(journal_file_find_data_object(f, "THIRD=yes", STRLEN("THIRD=yes"), &d, &dp));
+        ASSERT_OK_POSITIVE(journal_file_move_to_entry_for_data(f, d, DIRECTION_DOWN, NULL, &head));
+        ASSERT_OK_POSITIVE(journal_file_move_to_entry_for_data(f, d, DIRECTION_UP, NULL, &tail));
+
+        /* Compare the index against bisecting the entry arrays for every offset in the file */
+        for (uint64_t p = head - 1; p <= tail + 1; p++)
+                FOREACH_ELEMENT(direction, ((const direction_t[]) { DIRECTION_DOWN, DIRECTION_UP })) {
+                        uint64_t a = 0, b = 0;
+                        int r;
+
+                        ASSERT_OK(journal_file_move_to_object(f, OBJECT_DATA, dp, &d));
+                        ASSERT_OK(r = journal_file_move_to_entry_by_offset_for_data(f, d, p, *direction, NULL, &a));
+                        ASSERT_OK_EQ(journal_index_move_to_entry_by_offset(x, dp, p, *direction, &b), r);
+                        if (r > 0)
+                                ASSERT_EQ(a, b);
+                }
+
+        /* Data objects that are not part of the index are reported as such */
+        ASSERT_ERROR(journal_index_move_to_entry_by_offset(x, 8, 0, DIRECTION_DOWN, NULL), ENOENT);
+}
+
+DEFINE_TEST_MAIN(LOG_DEBUG);
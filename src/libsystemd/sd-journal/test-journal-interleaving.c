@@ -259,7 +259,7 @@ static void test_cursor(sd_journal *j) {
         }
 }
 
-static void test_skip_one(void (*setup)(void)) {
+static void test_skip_one(void (*setup)(void), int flags) {
         _cleanup_(test_donep) char *t = NULL;
         sd_journal *j;
 
@@ -268,14 +268,14 @@ static void test_skip_one(void (*setup)(void)) {
         setup();
 
         /* Seek to head, iterate down. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_head(j));
         ASSERT_OK_POSITIVE(sd_journal_next(j));       /* pointing to the first entry */
         test_check_numbers_down(j, 9);
         sd_journal_close(j);
 
         /* Seek to head, iterate down. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_head(j));
         ASSERT_OK_POSITIVE(sd_journal_next(j));       /* pointing to the first entry */
         ASSERT_OK_ZERO(sd_journal_previous(j));       /* no-op */
@@ -283,7 +283,7 @@ static void test_skip_one(void (*setup)(void)) {
         sd_journal_close(j);
 
         /* Seek to head twice, iterate down. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_head(j));
         ASSERT_OK_POSITIVE(sd_journal_next(j));       /* pointing to the first entry */
         ASSERT_OK(sd_journal_seek_head(j));
@@ -292,7 +292,7 @@ static void test_skip_one(void (*setup)(void)) {
         sd_journal_close(j);
 
         /* Seek to head, move to previous, then iterate down. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_head(j));
         ASSERT_OK_ZERO(sd_journal_previous(j));       /* no-op */
         ASSERT_OK_POSITIVE(sd_journal_next(j));       /* pointing to the first entry */
@@ -300,7 +300,7 @@ static void test_skip_one(void (*setup)(void)) {
         sd_journal_close(j);
 
         /* Seek to head, walk several steps, then iterate down. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_head(j));
         ASSERT_OK_ZERO(sd_journal_previous(j));       /* no-op */
         ASSERT_OK_ZERO(sd_journal_previous(j));       /* no-op */
@@ -312,14 +312,14 @@ static void test_skip_one(void (*setup)(void)) {
         sd_journal_close(j);
 
         /* Seek to tail, iterate up. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_tail(j));
         ASSERT_OK_POSITIVE(sd_journal_previous(j));   /* pointing to the last entry */
         test_check_numbers_up(j, 9);
         sd_journal_close(j);
 
         /* Seek to tail twice, iterate up. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_tail(j));
         ASSERT_OK_POSITIVE(sd_journal_previous(j));   /* pointing to the last entry */
         ASSERT_OK(sd_journal_seek_tail(j));
@@ -328,7 +328,7 @@ static void test_skip_one(void (*setup)(void)) {
         sd_journal_close(j);
 
         /* Seek to tail, move to next, then iterate up. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_tail(j));
         ASSERT_OK_ZERO(sd_journal_next(j));           /* no-op */
         ASSERT_OK_POSITIVE(sd_journal_previous(j));   /* pointing to the last entry */
@@ -336,7 +336,7 @@ static void test_skip_one(void (*setup)(void)) {
         sd_journal_close(j);
 
         /* Seek to tail, walk several steps, then iterate up. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_tail(j));
         ASSERT_OK_ZERO(sd_journal_next(j));           /* no-op */
         ASSERT_OK_ZERO(sd_journal_next(j));           /* no-op */
@@ -348,14 +348,14 @@ static void test_skip_one(void (*setup)(void)) {
         sd_journal_close(j);
 
         /* Seek to tail, skip to head, iterate down. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_tail(j));
         ASSERT_EQ(sd_journal_previous_skip(j, 9), 9); /* pointing to the first entry. */
         test_check_numbers_down(j, 9);
         sd_journal_close(j);
 
         /* Seek to tail, skip to head in a more complex way, then iterate down. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_tail(j));
         ASSERT_OK_ZERO(sd_journal_next(j));
         ASSERT_EQ(sd_journal_previous_skip(j, 4), 4);
@@ -374,14 +374,14 @@ static void test_skip_one(void (*setup)(void)) {
         sd_journal_close(j);
 
         /* Seek to head, skip to tail, iterate up. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_head(j));
         ASSERT_EQ(sd_journal_next_skip(j, 9), 9);
         test_check_numbers_up(j, 9);
         sd_journal_close(j);
 
         /* Seek to head, skip to tail in a more complex way, then iterate up. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         ASSERT_OK(sd_journal_seek_head(j));
         ASSERT_OK_ZERO(sd_journal_previous(j));
         ASSERT_EQ(sd_journal_next_skip(j, 4), 4);
@@ -400,7 +400,7 @@ static void test_skip_one(void (*setup)(void)) {
         sd_journal_close(j);
 
         /* For issue #31516. */
-        ASSERT_OK(sd_journal_open_directory(&j, t, SD_JOURNAL_ASSUME_IMMUTABLE));
+        ASSERT_OK(sd_journal_open_directory(&j, t, flags));
         test_cursor(j);
         sd_journal_flush_matches(j);
         ASSERT_OK(sd_journal_add_match(j, "LESS_THAN_FIVE=yes", SIZE_MAX));
@@ -426,8 +426,13 @@ static void test_skip_one(void (*setup)(void)) {
 }
 
 TEST(skip) {
-        test_skip_one(setup_sequential);
-        test_skip_one(setup_interleaved);
+        test_skip_one(setup_sequential, SD_JOURNAL_ASSUME_IMMUTABLE);
+        test_skip_one(setup_interleaved, SD_JOURNAL_ASSUME_IMMUTABLE);
+}
+
+TEST(skip_parallel) {
+        test_skip_one(setup_sequential, SD_JOURNAL_ASSUME_IMMUTABLE|SD_JOURNAL_PARALLEL);
+        test_skip_one(setup_interleaved, SD_JOURNAL_ASSUME_IMMUTABLE|SD_JOURNAL_PARALLEL);
 }
 
 static void test_boot_id_one(void (*setup)(void), size_t n_ids_expected) {
@@ -0,0 +1,163 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sd-journal.h"
+
+#include "alloc-util.h"
+#include "env-util.h"
+#include "fd-util.h"
+#include "fileio.h"
+#include "iovec-util.h"
+#include "journal-file-util.h"
+#include "logs-show.h"
+#include "memstream-util.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "strv.h"
+#include "tests.h"
+#include "time-util.h"
+#include "tmpfile-util.h"
+
+/* Tue 2023-11-14 22:13:20 UTC */
+#define BASE_REALTIME (UINT64_C(1700000000) * USEC_PER_SEC)
+
+static char* create_journal(const char *dir, unsigned n_entries) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_free_ char *path = NULL;
+        JournalFile *f;
+        dual_timestamp ts;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(path = path_join(dir, "test.journal"));
+        ASSERT_OK(journal_file_open(-EBADF, path, O_RDWR|O_CREAT, JOURNAL_COMPRESS, 0644, UINT64_MAX, NULL, m, NULL, &f));
+
+        dual_timestamp_now(&ts);
+
+        for (unsigned i = 0; i < n_entries; i++) {
+                _cleanup_free_ char *message = NULL;
+                struct iovec iovec[4];
+
+                ASSERT_OK(asprintf(&message, "MESSAGE=hello %u", i));
+                iovec[0] = IOVEC_MAKE_STRING(message);
+                iovec[1] = IOVEC_MAKE_STRING("SYSLOG_IDENTIFIER=test");
+                iovec[2] = IOVEC_MAKE_STRING("_PID=4711");
+                iovec[3] = IOVEC_MAKE_STRING("PRIORITY=6");
+
+                /* Four entries per second */
+                ts.realtime = BASE_REALTIME + i * 250 * USEC_PER_MSEC;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(f, &ts, NULL, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL, NULL));
+        }
+
+        journal_file_offline_close(f);
+
+        return TAKE_PTR(path);
+}
+
+TEST(output_short) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_(memstream_done) MemStream m = {};
+        _cleanup_free_ char *path = NULL, *buf = NULL;
+        dual_timestamp previous_ts = {};
+        sd_id128_t previous_boot_id = {};
+        FILE *f;
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-show-XXXXXX", &t));
+        ASSERT_NOT_NULL(path = create_journal(t, 6));
+        ASSERT_OK(sd_journal_open_files(&j, (const char**) STRV_MAKE(path), 0));
+        ASSERT_NOT_NULL(f = memstream_init(&m));
+
+        /* Timestamps within the same second share their formatted prefix, make sure the fractional part
+         * and the next second are still right */
+        SD_JOURNAL_FOREACH(j)
+                ASSERT_OK(show_journal_entry(f, j, OUTPUT_SHORT_ISO_PRECISE, 0, OUTPUT_UTC, NULL, NULL, NULL,
+                                             &previous_ts, &previous_boot_id));
+
+        ASSERT_OK(memstream_finalize(&m, &buf, NULL));
+        ASSERT_STREQ(buf,
+                     "2023-11-14T22:13:20.000000+00:00 test[4711]: hello 0\n"
+                     "2023-11-14T22:13:20.250000+00:00 test[4711]: hello 1\n"
+                     "2023-11-14T22:13:20.500000+00:00 test[4711]: hello 2\n"
+                     "2023-11-14T22:13:20.750000+00:00 test[4711]: hello 3\n"
+                     "2023-11-14T22:13:21.000000+00:00 test[4711]: hello 4\n"
+                     "2023-11-14T22:13:21.250000+00:00 test[4711]: hello 5\n");
+}
+
+TEST(output_short_tz) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_free_ char *path = NULL;
+        const char *tz = getenv("TZ");
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-show-XXXXXX", &t));
+        ASSERT_NOT_NULL(path = create_journal(t, 1));
+        ASSERT_OK(sd_journal_open_files(&j, (const char**) STRV_MAKE(path), 0));
+
+        /* The same entry shown twice in a row, in different time zones, must not reuse the cached prefix */
+        FOREACH_STRING(s, "UTC0", "JST-9") {
+                _cleanup_(memstream_done) MemStream m = {};
+                _cleanup_free_ char *buf = NULL;
+                dual_timestamp previous_ts = {};
+                sd_id128_t previous_boot_id = {};
+                FILE *f;
+
+                ASSERT_OK_ERRNO(setenv("TZ", s, 1));
+                tzset();
+
+                ASSERT_NOT_NULL(f = memstream_init(&m));
+                ASSERT_OK(sd_journal_seek_head(j));
+                ASSERT_OK_POSITIVE(sd_journal_next(j));
+                ASSERT_OK(show_journal_entry(f, j, OUTPUT_SHORT_ISO_PRECISE, 0, 0, NULL, NULL, NULL,
+                                             &previous_ts, &previous_boot_id));
+                ASSERT_OK(memstream_finalize(&m, &buf, NULL));
+
+                ASSERT_STREQ(buf,
+                             streq(s, "UTC0") ?
+                             "2023-11-14T22:13:20.000000+00:00 test[4711]: hello 0\n" :
+                             "2023-11-15T07:13:20.000000+09:00 test[4711]: hello 0\n");
+        }
+
+        ASSERT_OK(set_unset_env("TZ", tz, true));
+        tzset();
+}
+
+TEST(output_short_benchmark) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        _cleanup_free_ char *path = NULL;
+        unsigned n_entries = slow_tests_enabled() ? 500000 : 20000;
+        OutputMode mode;
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-show-XXXXXX", &t));
+        ASSERT_NOT_NULL(path = create_journal(t, n_entries));
+        ASSERT_NOT_NULL(f = fopen("/dev/null", "we"));
+
+        FOREACH_ARGUMENT(mode, OUTPUT_SHORT, OUTPUT_SHORT_ISO_PRECISE, OUTPUT_SHORT_MONOTONIC) {
+                _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+                dual_timestamp previous_ts = {};
+                sd_id128_t previous_boot_id = {};
+                unsigned n = 0;
+                usec_t start, elapsed;
+
+                ASSERT_OK(sd_journal_open_files(&j, (const char**) STRV_MAKE(path), 0));
+
+                start = now(CLOCK_MONOTONIC);
+                SD_JOURNAL_FOREACH(j) {
+                        ASSERT_OK(show_journal_entry(f, j, mode, 0, 0, NULL, NULL, NULL,
+                                                     &previous_ts, &previous_boot_id));
+                        n++;
+                }
+                ASSERT_OK(fflush_and_check(f));
+                elapsed = now(CLOCK_MONOTONIC) - start;
+
+                ASSERT_EQ(n, n_entries);
+                log_info("%s: %u lines in %s, %.0f lines/s",
+                         output_mode_to_string(mode), n, FORMAT_TIMESPAN(elapsed, USEC_PER_MSEC),
+                         (double) n * USEC_PER_SEC / MAX(elapsed, (usec_t) 1));
+        }
+}
+
+DEFINE_TEST_MAIN(LOG_INFO);
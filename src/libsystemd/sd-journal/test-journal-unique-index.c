@@ -0,0 +1,159 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sd-journal.h"
+
+#include "alloc-util.h"
+#include "iovec-util.h"
+#include "journal-file-util.h"
+#include "journal-internal.h"
+#include "journal-unique-index.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "set.h"
+#include "string-util.h"
+#include "strv.h"
+#include "tests.h"
+#include "tmpfile-util.h"
+
+/* More distinct NUMBER= values than are summarized */
+#define N_ENTRIES (JOURNAL_UNIQUE_INDEX_VALUES_MAX + 100U)
+
+static dual_timestamp ts = {};
+
+static char* create_archived_journal(const char *dir, const char *name, char **units) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_free_ char *path = NULL, *archived = NULL;
+        JournalFile *f;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(path = path_join(dir, name));
+        ASSERT_OK(journal_file_open(-EBADF, path, O_RDWR|O_CREAT, JOURNAL_COMPRESS, 0644, UINT64_MAX, NULL, m, NULL, &f));
+
+        for (unsigned i = 0; i < N_ENTRIES; i++) {
+                _cleanup_free_ char *number = NULL, *unit = NULL;
+                struct iovec iovec[2];
+
+                ASSERT_OK(asprintf(&number, "NUMBER=%u", i));
+                ASSERT_NOT_NULL(unit = strjoin("UNIT=", units[i % strv_length(units)]));
+                iovec[0] = IOVEC_MAKE_STRING(number);
+                iovec[1] = IOVEC_MAKE_STRING(unit);
+
+                ts.realtime++;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(f, &ts, NULL, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL, NULL));
+        }
+
+        ASSERT_OK(journal_file_archive(f, NULL));
+        ASSERT_NOT_NULL(archived = strdup(f->path));
+
+        /* Offlining an archived file writes the summary if $SYSTEMD_JOURNAL_INDEX is set */
+        journal_file_offline_close(f);
+
+        return TAKE_PTR(archived);
+}
+
+static unsigned enumerate_unique(const char *dir, const char *field, bool *ret_summarized) {
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_set_free_ Set *seen = NULL;
+        const void *data;
+        JournalFile *f;
+        unsigned n = 0;
+        size_t size;
+        int r;
+
+        ASSERT_OK(sd_journal_open_directory(&j, dir, 0));
+
+        *ret_summarized = true;
+        ORDERED_HASHMAP_FOREACH(f, j->files)
+                if (!f->unique_index)
+                        *ret_summarized = false;
+
+        ASSERT_OK(sd_journal_query_unique(j, field));
+
+        while ((r = sd_journal_enumerate_unique(j, &data, &size)) > 0) {
+                _cleanup_free_ char *s = NULL;
+
+                ASSERT_NOT_NULL(s = strndup(data, size));
+                ASSERT_TRUE(startswith(s, field));
+
+                /* Every value must only be returned once */
+                ASSERT_OK_POSITIVE(set_ensure_consume(&seen, &string_hash_ops_free, TAKE_PTR(s)));
+                n++;
+        }
+        ASSERT_OK(r);
+
+        return n;
+}
+
+TEST(journal_unique_index) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_free_ char *one = NULL, *two = NULL;
+        bool summarized;
+
+        ASSERT_OK_ERRNO(setenv("SYSTEMD_JOURNAL_INDEX", "1", /* overwrite = */ true));
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-unique-index-XXXXXX", &t));
+        dual_timestamp_now(&ts);
+
+        ASSERT_NOT_NULL(one = create_archived_journal(t, "one.journal", STRV_MAKE("a.service", "b.service", "c.service")));
+        ASSERT_NOT_NULL(two = create_archived_journal(t, "two.journal", STRV_MAKE("b.service", "c.service", "d.service")));
+
+        ASSERT_EQ(enumerate_unique(t, "UNIT", &summarized), 4U);
+        ASSERT_TRUE(summarized);
+
+        /* Fields with too many values are enumerated from the journal files, also when mixed with fields
+         * that are in the summary */
+        ASSERT_EQ(enumerate_unique(t, "NUMBER", &summarized), N_ENTRIES);
+        ASSERT_EQ(enumerate_unique(t, "NONEXISTENT", &summarized), 0U);
+
+        /* Without the summary of one of the files, the results must be the same */
+        ASSERT_OK_POSITIVE(journal_unique_index_remove_at(AT_FDCWD, one));
+
+        ASSERT_EQ(enumerate_unique(t, "UNIT", &summarized), 4U);
+        ASSERT_FALSE(summarized);
+        ASSERT_EQ(enumerate_unique(t, "NUMBER", &summarized), N_ENTRIES);
+
+        ASSERT_OK_POSITIVE(journal_unique_index_remove_at(AT_FDCWD, two));
+        ASSERT_EQ(enumerate_unique(t, "UNIT", &summarized), 4U);
+}
+
+TEST(journal_unique_index_lookup) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_(journal_unique_index_freep) JournalUniqueIndex *x = NULL;
+        _cleanup_(journal_file_closep) JournalFile *f = NULL;
+        _cleanup_free_ char *path = NULL;
+        JournalUniqueValues v;
+        const void *data;
+        size_t size;
+
+        ASSERT_OK_ERRNO(setenv("SYSTEMD_JOURNAL_INDEX", "1", /* overwrite = */ true));
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/journal-unique-index-XXXXXX", &t));
+        ASSERT_NOT_NULL(path = create_archived_journal(t, "test.journal", STRV_MAKE("foo.service", "bar.service")));
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_OK(journal_file_open(-EBADF, path, O_RDONLY, 0, 0, UINT64_MAX, NULL, m, NULL, &f));
+        ASSERT_OK_POSITIVE(journal_unique_index_open(AT_FDCWD, f, &x));
+
+        /* Values are sorted */
+        ASSERT_OK_POSITIVE(journal_unique_index_get(x, "UNIT", STRLEN("UNIT"), &v));
+        ASSERT_EQ(v.n_values, 2U);
+        journal_unique_values_get(&v, 0, &data, &size);
+        ASSERT_EQ(memcmp_nn(data, size, "UNIT=bar.service", STRLEN("UNIT=bar.service")), 0);
+        journal_unique_values_get(&v, 1, &data, &size);
+        ASSERT_EQ(memcmp_nn(data, size, "UNIT=foo.service", STRLEN("UNIT=foo.service")), 0);
+
+        ASSERT_TRUE(journal_unique_values_contain(&v, "UNIT=foo.service", STRLEN("UNIT=foo.service")));
+        ASSERT_FALSE(journal_unique_values_contain(&v, "UNIT=foo", STRLEN("UNIT=foo")));
+        ASSERT_FALSE(journal_unique_values_contain(&v, "UNIT=zzz.service", STRLEN("UNIT=zzz.service")));
+
+        /* Prefixes of field names must not match */
+        ASSERT_OK_ZERO(journal_unique_index_get(x, "UNI", STRLEN("UNI"), &v));
+        ASSERT_OK_ZERO(journal_unique_index_get(x, "NUMBER", STRLEN("NUMBER"), &v));
+}
+
+DEFINE_TEST_MAIN(LOG_DEBUG);
@@ -3,13 +3,20 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include "sd-journal.h"
+
 #include "chattr-util.h"
+#include "dirent-util.h"
+#include "fd-util.h"
 #include "iovec-util.h"
 #include "journal-authenticate.h"
 #include "journal-file-util.h"
 #include "journal-vacuum.h"
 #include "log.h"
+#include "path-util.h"
 #include "rm-rf.h"
+#include "string-util.h"
+#include "strv.h"
 #include "tests.h"
 
 static bool arg_keep = false;
@@ -174,6 +181,78 @@ TEST(empty) {
         test_empty_one();
 }
 
+static void test_append_entries_one(void) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_(journal_file_offline_closep) JournalFile *f = NULL;
+        dual_timestamp ts[4];
+        struct iovec iovec[4];
+        JournalFileAppendEntry entries[4];
+        uint64_t seqnum = 0, p;
+        size_t n;
+        Object *o;
+        char t[] = "/var/tmp/journal-XXXXXX";
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+
+        mkdtemp_chdir_chattr(t);
+
+        ASSERT_OK(journal_file_open(-EBADF, "test.journal", O_RDWR|O_CREAT, JOURNAL_STRICT_ORDER, 0666, UINT64_MAX, NULL, m, NULL, &f));
+
+        dual_timestamp_now(&ts[0]);
+        for (size_t i = 0; i < ELEMENTSOF(entries); i++) {
+                if (i > 0)
+                        ts[i] = (dual_timestamp) {
+                                .realtime = ts[i-1].realtime + 1,
+                                .monotonic = ts[i-1].monotonic + 1,
+                        };
+
+                iovec[i] = IOVEC_MAKE_STRING(i % 2 == 0 ? "TEST=even" : "TEST=odd");
+                entries[i] = (JournalFileAppendEntry) {
+                        .ts = &ts[i],
+                        .iovec = &iovec[i],
+                        .n_iovec = 1,
+                };
+        }
+
+        ASSERT_OK(journal_file_append_entries(f, entries, 2, &seqnum, NULL, &n));
+        ASSERT_EQ(n, 2U);
+        ASSERT_EQ(seqnum, 2U);
+        ASSERT_EQ(f->data_cache_hits, 0U);
+        ASSERT_EQ(f->data_cache_misses, 2U);
+
+        /* Time going backwards makes us stop at the offending entry in strict order mode */
+        ts[3].realtime = ts[1].realtime - 1;
+        ASSERT_ERROR(journal_file_append_entries(f, entries + 2, 2, &seqnum, NULL, &n), EREMCHG);
+        ASSERT_EQ(n, 1U);
+        ASSERT_EQ(seqnum, 3U);
+        ASSERT_EQ(le64toh(f->header->n_entries), 3U);
+
+        /* Both payloads are written already, hence the data objects are found in the cache */
+        ASSERT_EQ(f->data_cache_hits, 2U);
+        ASSERT_EQ(f->data_cache_misses, 2U);
+
+        n = 0;
+        for (int r = journal_file_next_entry(f, 0, DIRECTION_DOWN, &o, &p); r > 0; r = journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p)) {
+                ASSERT_EQ(le64toh(o->entry.seqnum), n + 1);
+                ASSERT_EQ(le64toh(o->entry.realtime), ts[n].realtime);
+                n++;
+        }
+        ASSERT_EQ(n, 3U);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                ASSERT_OK(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL));
+}
+
+TEST(append_entries) {
+        ASSERT_OK_ERRNO(setenv("SYSTEMD_JOURNAL_COMPACT", "0", 1));
+        test_append_entries_one();
+
+        ASSERT_OK_ERRNO(setenv("SYSTEMD_JOURNAL_COMPACT", "1", 1));
+        test_append_entries_one();
+}
+
 #if HAVE_COMPRESSION
 static bool check_compressed(uint64_t compress_threshold, uint64_t data_size) {
         _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
@@ -267,6 +346,262 @@ TEST(min_compress_size) {
 }
 #endif
 
+static unsigned count_journal_files(const char *path) {
+        _cleanup_closedir_ DIR *d = NULL;
+        unsigned n = 0;
+
+        ASSERT_NOT_NULL(d = opendir(path));
+
+        FOREACH_DIRENT(de, d, assert_not_reached())
+                if (endswith(de->d_name, ".journal"))
+                        n++;
+
+        return n;
+}
+
+static void create_archived_journals(const char *path, MMapCache *m, unsigned n) {
+        _cleanup_free_ char *fn = NULL;
+        dual_timestamp ts;
+
+        ASSERT_NOT_NULL(fn = path_join(path, "test.journal"));
+        dual_timestamp_now(&ts);
+
+        for (unsigned i = 0; i < n; i++) {
+                struct iovec iovec = IOVEC_MAKE_STRING("TEST=vacuum");
+                JournalFile *f;
+
+                ASSERT_OK(journal_file_open(-EBADF, fn, O_RDWR|O_CREAT, 0, 0644, UINT64_MAX, NULL, m, NULL, &f));
+
+                ts.realtime++;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL, NULL));
+                ASSERT_OK(journal_file_archive(f, NULL));
+                (void) journal_file_offline_close(f);
+        }
+}
+
+TEST(vacuum_cache) {
+        _cleanup_(journal_vacuum_cache_freep) JournalVacuumCache *cache = NULL;
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        char t[] = "/var/tmp/journal-vacuum-XXXXXX";
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(mkdtemp(t));
+
+        create_archived_journals(t, m, 5);
+        ASSERT_EQ(count_journal_files(t), 5U);
+
+        /* Populates the cache, but doesn't delete anything */
+        ASSERT_OK(journal_directory_vacuum_full(t, &cache, UINT64_MAX, 0, 0, NULL, true));
+        ASSERT_NOT_NULL(cache);
+        ASSERT_EQ(count_journal_files(t), 5U);
+
+        /* Served from the cache */
+        ASSERT_OK(journal_directory_vacuum_full(t, &cache, 0, 3, 0, NULL, true));
+        ASSERT_EQ(count_journal_files(t), 3U);
+
+        /* Files removed and added behind our back must not confuse the cache */
+        ASSERT_OK(rm_rf(t, REMOVE_PHYSICAL));
+        create_archived_journals(t, m, 2);
+        ASSERT_OK(journal_directory_vacuum_full(t, &cache, 0, 1, 0, NULL, true));
+        ASSERT_EQ(count_journal_files(t), 1U);
+
+        ASSERT_OK(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL));
+}
+
+TEST(process_spurious_modify) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_free_ char *fn = NULL;
+        char t[] = "/var/tmp/journal-process-XXXXXX";
+        struct iovec iovec = IOVEC_MAKE_STRING("TEST=1");
+        dual_timestamp ts;
+        JournalFile *f;
+        unsigned n = 0;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(mkdtemp(t));
+        ASSERT_NOT_NULL(fn = path_join(t, "test.journal"));
+
+        dual_timestamp_now(&ts);
+
+        ASSERT_OK(journal_file_open(-EBADF, fn, O_RDWR|O_CREAT, 0, 0644, UINT64_MAX, NULL, m, NULL, &f));
+        ASSERT_OK(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL, NULL));
+
+        ASSERT_OK(sd_journal_open_directory(&j, t, 0));
+        ASSERT_OK(sd_journal_get_fd(j));
+        ASSERT_OK(sd_journal_process(j));
+
+        /* A write that adds an entry is reported... */
+        ts.realtime++;
+        ts.monotonic++;
+        ASSERT_OK(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL, NULL));
+        journal_file_post_change(f);
+        ASSERT_OK_EQ(sd_journal_process(j), SD_JOURNAL_APPEND);
+
+        /* ... while one that doesn't is not */
+        journal_file_post_change(f);
+        ASSERT_OK_EQ(sd_journal_process(j), SD_JOURNAL_NOP);
+
+        SD_JOURNAL_FOREACH(j)
+                n++;
+        ASSERT_EQ(n, 2U);
+
+        (void) journal_file_offline_close(f);
+        ASSERT_OK(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL));
+}
+
+TEST(sync_async) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_free_ char *fn = NULL;
+        char t[] = "/var/tmp/journal-sync-XXXXXX";
+        struct iovec iovec = IOVEC_MAKE_STRING("TEST=1");
+        dual_timestamp ts;
+        JournalFile *f;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(mkdtemp(t));
+        ASSERT_NOT_NULL(fn = path_join(t, "test.journal"));
+
+        dual_timestamp_now(&ts);
+
+        ASSERT_OK(journal_file_open(-EBADF, fn, O_RDWR|O_CREAT, 0, 0644, UINT64_MAX, NULL, m, NULL, &f));
+        ASSERT_OK(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL, NULL));
+
+        /* A sync leaves the file online */
+        ASSERT_OK(journal_file_sync_async(f));
+        ASSERT_OK(journal_file_set_offline_thread_join(f));
+        ASSERT_EQ(f->header->state, STATE_ONLINE);
+
+        /* Writing while a sync is in flight is fine, and so is requesting another sync */
+        ASSERT_OK(journal_file_sync_async(f));
+        ts.realtime++;
+        ts.monotonic++;
+        ASSERT_OK(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL, NULL));
+        ASSERT_OK(journal_file_sync_async(f));
+
+        /* An offline requested while a sync is in flight still takes the file offline */
+        ASSERT_OK(journal_file_set_offline(f, /* wait= */ true));
+        ASSERT_EQ(f->header->state, STATE_OFFLINE);
+        ASSERT_FALSE(journal_file_is_offlining(f));
+
+        /* And there's nothing to sync for an offline file */
+        ASSERT_OK(journal_file_sync_async(f));
+        ASSERT_FALSE(journal_file_is_offlining(f));
+        ASSERT_EQ(le64toh(f->header->n_entries), 2U);
+
+        (void) journal_file_offline_close(f);
+        ASSERT_OK(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL));
+}
+
+TEST(allocate_adaptive) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_free_ char *fn = NULL, *payload = NULL;
+        char t[] = "/var/tmp/journal-allocate-XXXXXX";
+        uint64_t size = 0, max_increase = 0;
+        dual_timestamp ts;
+        JournalFile *f;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(mkdtemp(t));
+        ASSERT_NOT_NULL(fn = path_join(t, "test.journal"));
+        ASSERT_NOT_NULL(payload = malloc(64 * 1024));
+
+        dual_timestamp_now(&ts);
+
+        ASSERT_OK(journal_file_open(-EBADF, fn, O_RDWR|O_CREAT, 0, 0644, UINT64_MAX, NULL, m, NULL, &f));
+
+        /* A file that grows quickly is grown by more than the default 8M at a time */
+        for (unsigned i = 0; i < 1024 && size < 64 * U64_MB; i++) {
+                uint64_t new_size;
+                struct iovec iovec;
+                int l;
+
+                l = snprintf(payload, 64 * 1024, "TEST=%u ", i);
+                memset(payload + l, 'x', 64 * 1024 - l);
+                iovec = IOVEC_MAKE(payload, 64 * 1024);
+
+                ts.realtime++;
+                ts.monotonic++;
+                ASSERT_OK(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL, NULL));
+
+                new_size = le64toh(f->header->header_size) + le64toh(f->header->arena_size);
+                if (size > 0 && new_size > size)
+                        max_increase = MAX(max_increase, new_size - size);
+                size = new_size;
+        }
+
+        ASSERT_GT(max_increase, 8 * U64_MB);
+
+        (void) journal_file_offline_close(f);
+        ASSERT_OK(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL));
+}
+
+TEST(data_filter) {
+        _cleanup_(mmap_cache_unrefp) MMapCache *m = NULL;
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        _cleanup_free_ char *fn = NULL;
+        char t[] = "/var/tmp/journal-filter-XXXXXX";
+        struct iovec iovec[] = {
+                IOVEC_MAKE_STRING("MESSAGE=hello"),
+                IOVEC_MAKE_STRING("MESSAGE_ID=f00"),
+                IOVEC_MAKE_STRING("TEST=aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"),
+                IOVEC_MAKE_STRING("TESTING=bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb"),
+        };
+        dual_timestamp ts;
+        const void *d;
+        size_t l;
+        JournalFile *f;
+        unsigned n = 0;
+
+        ASSERT_NOT_NULL(m = mmap_cache_new());
+        ASSERT_NOT_NULL(mkdtemp(t));
+        ASSERT_NOT_NULL(fn = path_join(t, "test.journal"));
+
+        dual_timestamp_now(&ts);
+
+        /* Only the long fields get compressed, so that both the plain and the compressed code paths are
+         * covered */
+        ASSERT_OK(journal_file_open(-EBADF, fn, O_RDWR|O_CREAT, JOURNAL_COMPRESS, 0644, 64, NULL, m, NULL, &f));
+        ASSERT_OK(journal_file_append_entry(f, &ts, NULL, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL, NULL));
+        ts.realtime++;
+        ts.monotonic++;
+        ASSERT_OK(journal_file_append_entry(f, &ts, NULL, iovec + 2, 2, NULL, NULL, NULL, NULL));
+        (void) journal_file_offline_close(f);
+
+        ASSERT_OK(sd_journal_open_files(&j, (const char**) STRV_MAKE(fn), 0));
+
+        ASSERT_ERROR(sd_journal_set_data_filter(j, STRV_MAKE("TEST=")), EINVAL);
+        ASSERT_OK(sd_journal_set_data_filter(j, STRV_MAKE("TEST", "MESSAGE")));
+
+        SD_JOURNAL_FOREACH(j) {
+                unsigned k = 0;
+
+                SD_JOURNAL_FOREACH_DATA(j, d, l) {
+                        ASSERT_TRUE(memory_startswith(d, l, "TEST=a") || memory_startswith(d, l, "MESSAGE=hello"));
+                        k++;
+                }
+
+                /* The filter doesn't apply to explicit lookups */
+                ASSERT_OK(sd_journal_get_data(j, "TESTING", &d, &l));
+
+                ASSERT_EQ(k, n == 0 ? 2U : 1U);
+                n++;
+        }
+        ASSERT_EQ(n, 2U);
+
+        /* And turned off again */
+        ASSERT_OK(sd_journal_set_data_filter(j, NULL));
+        ASSERT_OK(sd_journal_seek_head(j));
+        ASSERT_OK_POSITIVE(sd_journal_next(j));
+        n = 0;
+        SD_JOURNAL_FOREACH_DATA(j, d, l)
+                n++;
+        ASSERT_EQ(n, ELEMENTSOF(iovec));
+
+        ASSERT_OK(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL));
+}
+
 static int intro(void) {
         arg_keep = saved_argc > 1;
 
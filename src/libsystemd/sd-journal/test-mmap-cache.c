@@ -3,6 +3,7 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "fd-util.h"
@@ -10,6 +11,60 @@
 #include "mmap-cache.h"
 #include "tests.h"
 #include "tmpfile-util.h"
+#include "unaligned.h"
+
+#define SCAN_FILE_SIZE (UINT64_C(48) * UINT64_C(1024) * UINT64_C(1024))
+#define SCAN_STEP (UINT64_C(4) * UINT64_C(1024))
+
+static void test_sequential_scan(MMapCache *m) {
+        char path[] = "/tmp/testmmapSXXXXXX";
+        MMapFileDescriptor *fs;
+        struct stat st;
+        int fd;
+
+        log_info("/* %s */", __func__);
+
+        fd = mkostemp_safe(path);
+        assert_se(fd >= 0);
+        (void) unlink(path);
+
+        /* A sparse file much larger than a single window, with the offset stored at every step */
+        assert_se(ftruncate(fd, SCAN_FILE_SIZE) >= 0);
+        for (uint64_t o = 0; o < SCAN_FILE_SIZE; o += SCAN_STEP)
+                assert_se(pwrite(fd, &o, sizeof(o), o) == sizeof(o));
+        assert_se(fstat(fd, &st) >= 0);
+
+        assert_se(mmap_cache_add_fd(m, fd, PROT_READ, &fs) > 0);
+
+        /* Forwards, which grows the windows along the way, and then backwards again */
+        for (uint64_t o = 0; o < SCAN_FILE_SIZE; o += SCAN_STEP) {
+                void *p;
+
+                assert_se(mmap_cache_fd_get(fs, 0, false, o, sizeof(uint64_t), &st, &p) >= 0);
+                assert_se(unaligned_read_ne64(p) == o);
+        }
+
+        for (uint64_t o = SCAN_FILE_SIZE; o > 0; o -= SCAN_STEP) {
+                void *p;
+
+                assert_se(mmap_cache_fd_get(fs, 0, false, o - SCAN_STEP, sizeof(uint64_t), &st, &p) >= 0);
+                assert_se(unaligned_read_ne64(p) == o - SCAN_STEP);
+        }
+
+        /* And make sure random access still works afterwards, also for the windows we dropped */
+        for (uint64_t i = 0; i < 64; i++) {
+                uint64_t o = (i * 7919 * SCAN_STEP) % SCAN_FILE_SIZE;
+                void *p;
+
+                assert_se(mmap_cache_fd_get(fs, 1, false, o, sizeof(uint64_t), &st, &p) >= 0);
+                assert_se(unaligned_read_ne64(p) == o);
+        }
+
+        mmap_cache_stats_log_debug(m);
+
+        mmap_cache_fd_free(fs);
+        safe_close(fd);
+}
 
 int main(int argc, char *argv[]) {
         MMapFileDescriptor *fx;
@@ -57,6 +112,8 @@ int main(int argc, char *argv[]) {
 
         assert_se((uint8_t*) p + 1 == (uint8_t*) q);
 
+        test_sequential_scan(m);
+
         mmap_cache_fd_free(fx);
         mmap_cache_unref(m);
 
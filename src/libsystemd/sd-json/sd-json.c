@@ -132,7 +132,9 @@ struct sd_json_variant {
 
 /* Inside string arrays we have a series of sd_json_variant structures one after the other. In this case, strings longer
  * than INLINE_STRING_MAX are stored as references, and all shorter ones inline. (This means — on x86-64 — strings up
- * to 7 chars are stored within the array elements, and all others in separate allocations) */
+ * to 7 chars are stored within the array elements, and all others in separate allocations). Arrays and objects
+ * created by the parser are an exception: there the longer strings are copied into the space following the
+ * elements, in the same allocation, and referenced from there. */
 #define INLINE_STRING_MAX (sizeof(sd_json_variant) - offsetof(sd_json_variant, string) - 1U)
 
 /* Let's make sure this structure isn't increased in size accidentally. This check is only for our most relevant arch
@@ -561,6 +563,86 @@ static void json_variant_set(sd_json_variant *a, sd_json_variant *b) {
         }
 }
 
+static size_t json_variant_tail_size(sd_json_variant *v) {
+        const char *s;
+        size_t l;
+
+        /* Returns how much space a string needs when it is copied into the tail of the allocation of an
+         * array/object, see json_variant_set_flat() below. Returns 0 for everything that is stored inline or
+         * by reference anyway. Sensitive strings are never copied, so that they are only ever stored in a
+         * single place in memory. */
+
+        if (!sd_json_variant_is_string(v) || sd_json_variant_is_sensitive(v))
+                return 0;
+
+        assert_se(s = sd_json_variant_string(v));
+
+        l = strlen(s);
+        if (l <= INLINE_STRING_MAX)
+                return 0;
+
+        return ALIGN_TO(offsetof(sd_json_variant, string) + l + 1, alignof(sd_json_variant));
+}
+
+static void json_variant_set_flat(sd_json_variant *a, sd_json_variant *b, uint8_t **tail) {
+        sd_json_variant *t;
+        size_t sz;
+
+        assert(a);
+        assert(a->is_embedded);
+
+        /* Like json_variant_set(), but if 'tail' is specified, copies long strings into the space it points
+         * to and references them from there, instead of referencing the separately allocated original. The
+         * copy is embedded into the same parent as 'a', so that the string lives and dies with the array or
+         * object it is part of, and no separate allocation has to be kept around for it. */
+
+        sz = tail ? json_variant_tail_size(b) : 0;
+        if (sz == 0) {
+                json_variant_set(a, b);
+                return;
+        }
+
+        assert(sz >= sizeof(sd_json_variant));
+
+        t = (sd_json_variant*) *tail;
+        *t = (sd_json_variant) {
+                .is_embedded = true,
+                .parent = a->parent,
+                .type = SD_JSON_VARIANT_STRING,
+        };
+        strcpy(t->string, sd_json_variant_string(b));
+
+        a->type = SD_JSON_VARIANT_STRING;
+        a->is_reference = true;
+        a->reference = t;
+
+        *tail += sz;
+}
+
+static bool json_variant_is_flat_reference(sd_json_variant *v) {
+        assert(v);
+
+        /* Checks whether 'v' is an element of an array/object that references a string stored in the tail of
+         * the very same allocation */
+
+        return v->is_embedded &&
+                v->is_reference &&
+                json_variant_is_regular(v->reference) &&
+                v->reference->is_embedded &&
+                v->reference->parent == v->parent;
+}
+
+static bool json_variant_has_tail(sd_json_variant *v) {
+        assert(v);
+        assert(IN_SET(v->type, SD_JSON_VARIANT_ARRAY, SD_JSON_VARIANT_OBJECT));
+
+        for (size_t i = 0; i < v->n_elements; i++)
+                if (json_variant_is_flat_reference(v + 1 + i))
+                        return true;
+
+        return false;
+}
+
 static void json_variant_copy_source(sd_json_variant *v, sd_json_variant *from) {
         assert(v);
 
@@ -572,7 +654,7 @@ static void json_variant_copy_source(sd_json_variant *v, sd_json_variant *from)
         v->source = json_source_ref(from->source);
 }
 
-static int json_variant_array_put_element(sd_json_variant *array, sd_json_variant *element) {
+static int json_variant_array_put_element(sd_json_variant *array, sd_json_variant *element, uint8_t **tail) {
         assert(array);
         sd_json_variant *w = array + 1 + array->n_elements;
 
@@ -588,7 +670,7 @@ static int json_variant_array_put_element(sd_json_variant *array, sd_json_varian
                 .parent = array,
         };
 
-        json_variant_set(w, element);
+        json_variant_set_flat(w, element, tail);
         json_variant_copy_source(w, element);
 
         if (!sd_json_variant_is_normalized(element))
@@ -597,8 +679,39 @@ static int json_variant_array_put_element(sd_json_variant *array, sd_json_varian
         return 0;
 }
 
-_public_ int sd_json_variant_new_array(sd_json_variant **ret, sd_json_variant **array, size_t n) {
+static sd_json_variant* json_variant_alloc_flat(sd_json_variant **array, size_t n, bool flat, uint8_t **ret_tail) {
+        size_t sz, extra = 0;
+        sd_json_variant *v;
+
+        assert(array || n == 0);
+        assert(ret_tail);
+
+        /* Allocates space for an array/object with n elements. If 'flat' is true, also reserves space for
+         * copies of all long strings among the elements after the elements themselves, so that a parsed
+         * document needs one allocation per array/object rather than one per array/object and long
+         * string. */
+
+        if (flat)
+                for (size_t i = 0; i < n; i++)
+                        extra = size_add(extra, json_variant_tail_size(array[i]));
+
+        if (size_multiply_overflow(n + 1, sizeof(sd_json_variant)))
+                return NULL;
+        sz = size_add((n + 1) * sizeof(sd_json_variant), extra);
+        if (sz == SIZE_MAX)
+                return NULL;
+
+        v = malloc(sz);
+        if (!v)
+                return NULL;
+
+        *ret_tail = extra > 0 ? (uint8_t*) (v + n + 1) : NULL;
+        return v;
+}
+
+static int json_variant_new_array_internal(sd_json_variant **ret, sd_json_variant **array, size_t n, bool flat) {
         _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        uint8_t *tail;
         int r;
 
         assert_return(ret, -EINVAL);
@@ -608,7 +721,7 @@ _public_ int sd_json_variant_new_array(sd_json_variant **ret, sd_json_variant **
         }
         assert_return(array, -EINVAL);
 
-        v = new(sd_json_variant, n + 1);
+        v = json_variant_alloc_flat(array, n, flat, &tail);
         if (!v)
                 return -ENOMEM;
 
@@ -619,7 +732,7 @@ _public_ int sd_json_variant_new_array(sd_json_variant **ret, sd_json_variant **
         };
 
         while (v->n_elements < n) {
-                r = json_variant_array_put_element(v, array[v->n_elements]);
+                r = json_variant_array_put_element(v, array[v->n_elements], tail ? &tail : NULL);
                 if (r < 0)
                         return r;
         }
@@ -628,6 +741,10 @@ _public_ int sd_json_variant_new_array(sd_json_variant **ret, sd_json_variant **
         return 0;
 }
 
+_public_ int sd_json_variant_new_array(sd_json_variant **ret, sd_json_variant **array, size_t n) {
+        return json_variant_new_array_internal(ret, array, n, /* flat= */ false);
+}
+
 _public_ int sd_json_variant_new_array_bytes(sd_json_variant **ret, const void *p, size_t n) {
         assert_return(ret, -EINVAL);
         if (n == 0) {
@@ -721,10 +838,11 @@ _public_ int sd_json_variant_new_array_strv(sd_json_variant **ret, char **l) {
         return 0;
 }
 
-_public_ int sd_json_variant_new_object(sd_json_variant **ret, sd_json_variant **array, size_t n) {
+static int json_variant_new_object_internal(sd_json_variant **ret, sd_json_variant **array, size_t n, bool flat) {
         _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
         const char *prev = NULL;
         bool sorted = true, normalized = true;
+        uint8_t *tail;
 
         assert_return(ret, -EINVAL);
         if (n == 0) {
@@ -734,7 +852,7 @@ _public_ int sd_json_variant_new_object(sd_json_variant **ret, sd_json_variant *
         assert_return(array, -EINVAL);
         assert_return(n % 2 == 0, -EINVAL);
 
-        v = new(sd_json_variant, n + 1);
+        v = json_variant_alloc_flat(array, n, flat, &tail);
         if (!v)
                 return -ENOMEM;
 
@@ -774,7 +892,7 @@ _public_ int sd_json_variant_new_object(sd_json_variant **ret, sd_json_variant *
                         .parent = v,
                 };
 
-                json_variant_set(w, c);
+                json_variant_set_flat(w, c, tail ? &tail : NULL);
                 json_variant_copy_source(w, c);
         }
 
@@ -785,6 +903,10 @@ _public_ int sd_json_variant_new_object(sd_json_variant **ret, sd_json_variant *
         return 0;
 }
 
+_public_ int sd_json_variant_new_object(sd_json_variant **ret, sd_json_variant **array, size_t n) {
+        return json_variant_new_object_internal(ret, array, n, /* flat= */ false);
+}
+
 static size_t json_variant_size(sd_json_variant* v) {
         if (!json_variant_is_regular(v))
                 return 0;
@@ -834,6 +956,14 @@ static void json_variant_free_inner(sd_json_variant *v, bool force_sensitive) {
         sensitive = v->sensitive || force_sensitive;
 
         if (v->is_reference) {
+                if (json_variant_is_flat_reference(v)) {
+                        /* The string is stored in the same allocation as we are, hence is released together
+                         * with us, and must not be unreferenced. */
+                        if (sensitive || v->reference->sensitive)
+                                explicit_bzero_safe(v->reference, json_variant_size(v->reference));
+                        return;
+                }
+
                 if (sensitive)
                         sd_json_variant_sensitive(v->reference);
 
@@ -1894,6 +2024,114 @@ _public_ int sd_json_variant_format(sd_json_variant *v, sd_json_format_flags_t f
         return sz;
 }
 
+typedef struct JsonAppendBuffer {
+        char **buffer;
+        size_t *size;
+        bool erase;
+        int error;
+} JsonAppendBuffer;
+
+static ssize_t json_append_buffer_write(void *userdata, const char *data, size_t n) {
+        JsonAppendBuffer *b = ASSERT_PTR(userdata);
+        size_t need;
+
+        if (n == 0)
+                return 0;
+
+        need = size_add(size_add(*b->size, n), 1);
+        if (need == SIZE_MAX) {
+                b->error = -ENOBUFS;
+                return 0;
+        }
+
+        if (MALLOC_SIZEOF_SAFE(*b->buffer) < need) {
+                if (b->erase) {
+                        char *p;
+
+                        /* Don't leave fragments of sensitive data behind in memory we return to the
+                         * allocator, hence don't use realloc() but copy and erase explicitly. */
+                        p = malloc(size_multiply_overflow(need, 2) ? need : need * 2);
+                        if (!p) {
+                                b->error = -ENOMEM;
+                                return 0;
+                        }
+
+                        memcpy_safe(p, *b->buffer, *b->size);
+                        erase_and_free(*b->buffer);
+                        *b->buffer = p;
+                } else if (!greedy_realloc((void**) b->buffer, need, 1)) {
+                        b->error = -ENOMEM;
+                        return 0;
+                }
+        }
+
+        memcpy(*b->buffer + *b->size, data, n);
+        *b->size += n;
+        (*b->buffer)[*b->size] = 0;
+
+        return n;
+}
+
+_public_ int sd_json_variant_format_append(sd_json_variant *v, sd_json_format_flags_t flags, char **buffer, size_t *size) {
+        _cleanup_fclose_ FILE *f = NULL;
+        JsonAppendBuffer b;
+        size_t start;
+        int r;
+
+        /* Like sd_json_variant_format(), but appends the formatted text to an existing buffer, without
+         * generating it in a separate one first. The buffer is grown as needed, and is always NUL
+         * terminated after its first *size bytes. */
+
+        assert_return(v, -EINVAL);
+        assert_return(buffer, -EINVAL);
+        assert_return(size, -EINVAL);
+        assert_return(*buffer || *size == 0, -EINVAL);
+
+        if (!sd_json_format_enabled(flags))
+                return -ENOEXEC;
+
+        start = *size;
+        b = (JsonAppendBuffer) {
+                .buffer = buffer,
+                .size = size,
+                .erase = sd_json_variant_is_sensitive_recursive(v),
+        };
+
+        f = fopencookie(&b, "w", (cookie_io_functions_t) {
+                        .write = json_append_buffer_write,
+                });
+        if (!f)
+                return -errno;
+
+        r = sd_json_variant_dump(v, flags, f, NULL);
+        if (r >= 0)
+                r = fflush_and_check(f);
+
+        /* Close the stream right-away, so that nothing is flushed into the buffer anymore after this */
+        f = safe_fclose(f);
+
+        if (r >= 0 && b.error < 0)
+                r = b.error;
+        if (r >= 0 && !*buffer) {
+                /* Nothing was written at all, but we promise a NUL terminated buffer */
+                *buffer = new0(char, 1);
+                if (!*buffer)
+                        r = -ENOMEM;
+        }
+        if (r < 0) {
+                /* Drop whatever we got so far */
+                if (*buffer) {
+                        if (b.erase)
+                                explicit_bzero_safe(*buffer + start, *size - start);
+                        (*buffer)[start] = 0;
+                }
+                *size = start;
+                return r;
+        }
+
+        return 0;
+}
+
 _public_ int sd_json_variant_dump(sd_json_variant *v, sd_json_format_flags_t flags, FILE *f, const char *prefix) {
         if (!v) {
                 if (flags & SD_JSON_FORMAT_EMPTY_ARRAY)
@@ -2281,7 +2519,7 @@ _public_ int sd_json_variant_append_array(sd_json_variant **v, sd_json_variant *
                  * need to fall back to the other method below. */
 
                 _unused_ _cleanup_(sd_json_variant_unrefp) sd_json_variant *dummy = sd_json_variant_ref(element);
-                if (json_variant_n_ref(*v) == 1) {
+                if (json_variant_n_ref(*v) == 1 && !json_variant_has_tail(*v)) {
                         /* We hold the only reference. Let's mutate the object. */
                         size_t size = sd_json_variant_elements(*v);
                         void *old = *v;
@@ -2294,7 +2532,7 @@ _public_ int sd_json_variant_append_array(sd_json_variant **v, sd_json_variant *
                                 for (size_t i = 1; i < size; i++)
                                         (*v)[1 + i].parent = *v;
 
-                        return json_variant_array_put_element(*v, element);
+                        return json_variant_array_put_element(*v, element, /* tail= */ NULL);
                 }
         }
 
@@ -2655,8 +2893,22 @@ static int json_parse_string(const char **p, char **ret) {
         c++;
 
         for (;;) {
+                const char *e;
                 int len;
 
+                /* Copy runs of plain printable ASCII characters in one go, rather than decoding and
+                 * appending them one by one. */
+                for (e = c; *e >= ' ' && *e < 0x7f && !IN_SET(*e, '"', '\\'); e++)
+                        ;
+                if (e > c) {
+                        if (!GREEDY_REALLOC(s, n + (e - c) + 1))
+                                return -ENOMEM;
+
+                        memcpy(s + n, c, e - c);
+                        n += e - c;
+                        c = e;
+                }
+
                 /* Check for EOF */
                 if (*c == 0)
                         return -EINVAL;
@@ -3206,7 +3458,7 @@ static int json_parse_internal(
 
                         assert(n_stack > 1);
 
-                        r = sd_json_variant_new_object(&add, current->elements, current->n_elements);
+                        r = json_variant_new_object_internal(&add, current->elements, current->n_elements, /* flat= */ true);
                         if (r < 0)
                                 goto finish;
 
@@ -3256,7 +3508,7 @@ static int json_parse_internal(
 
                         assert(n_stack > 1);
 
-                        r = sd_json_variant_new_array(&add, current->elements, current->n_elements);
+                        r = json_variant_new_array_internal(&add, current->elements, current->n_elements, /* flat= */ true);
                         if (r < 0)
                                 goto finish;
 
@@ -5137,7 +5389,7 @@ _public_ int sd_json_dispatch_full(
                 sd_json_dispatch_flags_t flags,
                 void *userdata,
                 const char **reterr_bad_field) {
-        size_t m;
+        size_t m, wildcard = SIZE_MAX, hint = 0;
         int r, done = 0;
         bool *found;
 
@@ -5154,8 +5406,13 @@ _public_ int sd_json_dispatch_full(
         }
 
         m = 0;
-        for (const sd_json_dispatch_field *p = table; p && p->name; p++)
+        for (const sd_json_dispatch_field *p = table; p && p->name; p++) {
+                if (p->name == POINTER_MAX && wildcard == SIZE_MAX)
+                        wildcard = m;
                 m++;
+        }
+        if (wildcard == SIZE_MAX)
+                wildcard = m;
 
         found = newa0(bool, m);
 
@@ -5167,10 +5424,23 @@ _public_ int sd_json_dispatch_full(
                 assert_se(key = sd_json_variant_by_index(v, i));
                 assert_se(value = sd_json_variant_by_index(v, i+1));
 
-                for (p = table; p && p->name; p++)
-                        if (p->name == POINTER_MAX ||
-                            streq_ptr(sd_json_variant_string(key), p->name))
+                /* Objects are usually generated with the same field order as the dispatch table, hence
+                 * start looking right after the previous match, so that we typically only need a single
+                 * comparison per field. Only the entries before the first catch-all entry are searched
+                 * that way, since that one takes precedence over any later ones. Field names in a
+                 * dispatch table are unique, hence the order of the search does not matter otherwise. */
+                p = NULL;
+                for (size_t j = 0; j < wildcard; j++) {
+                        size_t k = (hint + j) % wildcard;
+
+                        if (streq_ptr(sd_json_variant_string(key), table[k].name)) {
+                                p = table + k;
+                                hint = k + 1;
                                 break;
+                        }
+                }
+                if (!p && table)
+                        p = table + wildcard; /* Either the catch-all entry, or the end marker */
 
                 if (p && p->name) { /* Found a matching entry! 🙂 */
                         sd_json_dispatch_flags_t merged_flags;
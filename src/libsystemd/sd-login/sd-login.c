@@ -2,6 +2,7 @@
 
 #include <errno.h>
 #include <poll.h>
+#include <pthread.h>
 #include <sys/inotify.h>
 #include <unistd.h>
 
@@ -11,6 +12,7 @@
 #include "cgroup-util.h"
 #include "dirent-util.h"
 #include "env-file.h"
+#include "env-util.h"
 #include "escape.h"
 #include "extract-word.h"
 #include "fd-util.h"
@@ -20,11 +22,13 @@
 #include "io-util.h"
 #include "login-util.h"
 #include "macro.h"
+#include "missing_threads.h"
 #include "parse-util.h"
 #include "path-util.h"
 #include "pidfd-util.h"
 #include "process-util.h"
 #include "socket-util.h"
+#include "stat-util.h"
 #include "stdio-util.h"
 #include "string-util.h"
 #include "strv.h"
@@ -447,6 +451,137 @@ _public_ int sd_peer_get_cgroup(int fd, char **cgroup) {
         return sd_pid_get_cgroup(ucred.pid, cgroup);
 }
 
+/* logind replaces its state files atomically, hence as long as a file still refers to the same, unmodified
+ * inode, it has the same contents as when we last read it. Keep the most recently parsed files of each
+ * thread around, so that the common pattern of querying several properties of the same session, user or
+ * seat one after the other costs a stat() each, instead of parsing the file again every time. */
+#define STATE_FILE_CACHE_MAX 4U
+
+typedef struct StateFile {
+        char *path;
+        struct stat st;
+        char **pairs;
+} StateFile;
+
+static thread_local StateFile state_file_cache[STATE_FILE_CACHE_MAX];
+static thread_local unsigned state_file_cache_next;
+static pthread_key_t state_file_cache_key;
+static bool state_file_cache_key_valid = false;
+
+static void state_file_done(StateFile *f) {
+        assert(f);
+
+        f->path = mfree(f->path);
+        f->pairs = strv_free(f->pairs);
+}
+
+static void state_file_cache_flush(void *p) {
+        StateFile *cache = ASSERT_PTR(p);
+
+        /* Called on thread exit */
+        for (size_t i = 0; i < STATE_FILE_CACHE_MAX; i++)
+                state_file_done(cache + i);
+}
+
+static void state_file_cache_key_init(void) {
+        state_file_cache_key_valid = pthread_key_create(&state_file_cache_key, state_file_cache_flush) == 0;
+}
+
+static int state_file_load(const char *path, char ***ret_pairs) {
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+        _cleanup_strv_free_ char **pairs = NULL;
+        _cleanup_free_ char *copy = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        struct stat st;
+        int r;
+
+        assert(path);
+        assert(ret_pairs);
+
+        /* Returns the parsed key/value pairs of the specified state file. The returned strv is owned by the
+         * cache, and only valid until the next call. */
+
+        if (stat(path, &st) < 0)
+                return -errno;
+
+        FOREACH_ELEMENT(f, state_file_cache)
+                if (f->path && path_equal(f->path, path) && stat_inode_unmodified(&f->st, &st)) {
+                        *ret_pairs = f->pairs;
+                        return 0;
+                }
+
+        fd = open(path, O_RDONLY|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0)
+                return -errno;
+
+        /* The file might have been replaced since the stat() above, hence use the identity of what we
+         * actually read for the cache. */
+        if (fstat(fd, &st) < 0)
+                return -errno;
+
+        r = load_env_file_pairs_fd(fd, path, &pairs);
+        if (r < 0)
+                return r;
+
+        copy = strdup(path);
+        if (!copy)
+                return -ENOMEM;
+
+        /* Make sure the cache is released when the thread exits */
+        assert_se(pthread_once(&once, state_file_cache_key_init) == 0);
+        if (state_file_cache_key_valid)
+                (void) pthread_setspecific(state_file_cache_key, state_file_cache);
+
+        StateFile *f = state_file_cache + state_file_cache_next;
+        state_file_cache_next = (state_file_cache_next + 1) % STATE_FILE_CACHE_MAX;
+
+        state_file_done(f);
+        *f = (StateFile) {
+                .path = TAKE_PTR(copy),
+                .st = st,
+                .pairs = TAKE_PTR(pairs),
+        };
+
+        *ret_pairs = f->pairs;
+        return 0;
+}
+
+static int parse_state_file_sentinel(const char *path, ...) _sentinel_;
+static int parse_state_file_sentinel(const char *path, ...) {
+        const char *k;
+        char **pairs;
+        va_list ap;
+        int r;
+
+        assert(path);
+
+        /* Like parse_env_file(), but goes through the cache above */
+
+        r = state_file_load(path, &pairs);
+        if (r < 0)
+                return r;
+
+        va_start(ap, path);
+        while ((k = va_arg(ap, const char*))) {
+                char **v = va_arg(ap, char**);
+                const char *value;
+
+                value = strv_env_pairs_get(pairs, k);
+                if (!value)
+                        continue;
+
+                r = free_and_strdup(v, value);
+                if (r < 0) {
+                        va_end(ap);
+                        return r;
+                }
+        }
+        va_end(ap);
+
+        return 0;
+}
+#define parse_state_file(path, ...) parse_state_file_sentinel(path, __VA_ARGS__, NULL)
+
 static int file_of_uid(uid_t uid, char **p) {
 
         assert_return(uid_is_valid(uid), -EINVAL);
@@ -468,7 +603,7 @@ _public_ int sd_uid_get_state(uid_t uid, char**state) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, "STATE", &s);
+        r = parse_state_file(p, "STATE", &s);
         if (r == -ENOENT)
                 r = free_and_strdup(&s, "offline");
         if (r < 0)
@@ -490,7 +625,7 @@ _public_ int sd_uid_get_display(uid_t uid, char **session) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, "DISPLAY", &s);
+        r = parse_state_file(p, "DISPLAY", &s);
         if (r == -ENOENT)
                 return -ENODATA;
         if (r < 0)
@@ -514,7 +649,7 @@ _public_ int sd_uid_get_login_time(uid_t uid, uint64_t *usec) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, "STATE", &s, "REALTIME", &rt);
+        r = parse_state_file(p, "STATE", &s, "REALTIME", &rt);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
@@ -570,9 +705,9 @@ _public_ int sd_uid_is_on_seat(uid_t uid, int require_active, const char *seat)
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, filename,
-                           require_active ? "ACTIVE_UID" : "UIDS",
-                           &content);
+        r = parse_state_file(filename,
+                             require_active ? "ACTIVE_UID" : "UIDS",
+                             &content);
         if (r == -ENOENT)
                 return 0;
         if (r < 0)
@@ -594,7 +729,7 @@ static int uid_get_array(uid_t uid, const char *variable, char ***array) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, variable, &s);
+        r = parse_state_file(p, variable, &s);
         if (r == -ENOENT || (r >= 0 && isempty(s))) {
                 if (array)
                         *array = NULL;
@@ -672,7 +807,7 @@ _public_ int sd_session_is_active(const char *session) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, "ACTIVE", &s);
+        r = parse_state_file(p, "ACTIVE", &s);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
@@ -691,7 +826,7 @@ _public_ int sd_session_is_remote(const char *session) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, "REMOTE", &s);
+        r = parse_state_file(p, "REMOTE", &s);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
@@ -712,7 +847,7 @@ _public_ int sd_session_get_state(const char *session, char **state) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, "STATE", &s);
+        r = parse_state_file(p, "STATE", &s);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
@@ -735,7 +870,7 @@ _public_ int sd_session_get_uid(const char *session, uid_t *uid) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, "UID", &s);
+        r = parse_state_file(p, "UID", &s);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
@@ -757,7 +892,7 @@ static int session_get_string(const char *session, const char *field, char **val
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, field, &s);
+        r = parse_state_file(p, field, &s);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
@@ -788,7 +923,7 @@ _public_ int sd_session_get_start_time(const char *session, uint64_t *usec) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p, "REALTIME", &s);
+        r = parse_state_file(p, "REALTIME", &s);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
@@ -897,9 +1032,9 @@ _public_ int sd_seat_get_active(const char *seat, char **session, uid_t *uid) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p,
-                           "ACTIVE", &s,
-                           "ACTIVE_UID", &t);
+        r = parse_state_file(p,
+                             "ACTIVE", &s,
+                             "ACTIVE_UID", &t);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
@@ -939,9 +1074,9 @@ _public_ int sd_seat_get_sessions(
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, fname,
-                           "SESSIONS", &session_line,
-                           "UIDS", &uid_line);
+        r = parse_state_file(fname,
+                             "SESSIONS", &session_line,
+                             "UIDS", &uid_line);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
@@ -999,8 +1134,8 @@ static int seat_get_can(const char *seat, const char *variable) {
         if (r < 0)
                 return r;
 
-        r = parse_env_file(NULL, p,
-                           variable, &s);
+        r = parse_state_file(p,
+                             variable, &s);
         if (r == -ENOENT)
                 return -ENXIO;
         if (r < 0)
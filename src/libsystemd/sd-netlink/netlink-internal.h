@@ -15,6 +15,14 @@
 
 #define NETLINK_RQUEUE_MAX 64*1024
 
+/* Maximum number of datagrams read in one go, while waiting for a multi-part message to complete */
+#define NETLINK_READ_DATAGRAMS_MAX 32U
+
+/* While corked, asynchronous calls are collected and sent as one datagram, once this many are queued or
+ * the datagram would grow beyond the size limit */
+#define NETLINK_WQUEUE_MAX 64U
+#define NETLINK_WQUEUE_BYTES_MAX (32U * 1024U)
+
 #define NETLINK_CONTAINER_DEPTH 32
 
 struct reply_callback {
@@ -79,7 +87,12 @@ struct sd_netlink {
 
         struct nlmsghdr *rbuffer;
 
+        sd_netlink_message **wqueue;
+        size_t wqueue_size;
+        size_t wqueue_bytes;
+
         bool processing:1;
+        bool corked:1;
 
         uint32_t serial;
 
@@ -126,6 +139,7 @@ struct sd_netlink_message {
         bool sealed:1;
 
         sd_netlink_message *next; /* next in a chain of multi-part messages */
+        sd_netlink_message *last; /* last in the chain, only maintained on the head while it is partially received */
 };
 
 int message_new_empty(sd_netlink *nl, sd_netlink_message **ret);
@@ -152,6 +166,7 @@ int socket_bind(sd_netlink *nl);
 int socket_broadcast_group_ref(sd_netlink *nl, unsigned group);
 int socket_broadcast_group_unref(sd_netlink *nl, unsigned group);
 int socket_write_message(sd_netlink *nl, sd_netlink_message *m);
+int socket_writev_message(sd_netlink *nl, sd_netlink_message **m, size_t msgcount);
 int socket_read_message(sd_netlink *nl);
 
 int netlink_add_match_internal(
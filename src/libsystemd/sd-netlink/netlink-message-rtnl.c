@@ -60,6 +60,10 @@ static bool rtnl_message_type_is_nsid(uint16_t type) {
         return IN_SET(type, RTM_NEWNSID, RTM_DELNSID, RTM_GETNSID);
 }
 
+static bool rtnl_message_type_is_stats(uint16_t type) {
+        return IN_SET(type, RTM_NEWSTATS, RTM_GETSTATS);
+}
+
 #define DEFINE_RTNL_MESSAGE_SETTER(class, header_type, element, name, value_type) \
         int sd_rtnl_message_##class##_set_##name(sd_netlink_message *m, value_type value) { \
                 assert_return(m, -EINVAL);                              \
@@ -131,6 +135,8 @@ static bool rtnl_message_type_is_nsid(uint16_t type) {
         DEFINE_RTNL_MESSAGE_GETTER(routing_policy_rule, struct fib_rule_hdr, element, name, value_type)
 #define DEFINE_RTNL_MESSAGE_TRAFFIC_CONTROL_GETTER(element, name, value_type) \
         DEFINE_RTNL_MESSAGE_GETTER(traffic_control, struct tcmsg, element, name, value_type)
+#define DEFINE_RTNL_MESSAGE_STATS_GETTER(element, name, value_type) \
+        DEFINE_RTNL_MESSAGE_GETTER(stats, struct if_stats_msg, element, name, value_type)
 
 DEFINE_RTNL_MESSAGE_ADDR_GETTER(ifa_index, ifindex, int);
 DEFINE_RTNL_MESSAGE_ADDR_GETTER(ifa_family, family, int);
@@ -230,6 +236,8 @@ DEFINE_RTNL_MESSAGE_TRAFFIC_CONTROL_GETTER(tcm_ifindex, ifindex, int);
 DEFINE_RTNL_MESSAGE_TRAFFIC_CONTROL_GETTER(tcm_handle, handle, uint32_t);
 DEFINE_RTNL_MESSAGE_TRAFFIC_CONTROL_GETTER(tcm_parent, parent, uint32_t);
 
+DEFINE_RTNL_MESSAGE_STATS_GETTER(ifindex, ifindex, int);
+
 int sd_rtnl_message_new_route(
                 sd_netlink *rtnl,
                 sd_netlink_message **ret,
@@ -555,3 +563,29 @@ int sd_rtnl_message_new_nsid(
 
         return 0;
 }
+
+int sd_rtnl_message_new_stats(
+                sd_netlink *rtnl,
+                sd_netlink_message **ret,
+                uint16_t nlmsg_type,
+                int ifindex,
+                uint32_t filter_mask) {
+
+        struct if_stats_msg *ifsm;
+        int r;
+
+        assert_return(rtnl_message_type_is_stats(nlmsg_type), -EINVAL);
+        assert_return(ifindex >= 0, -EINVAL);
+        assert_return(ret, -EINVAL);
+
+        r = message_new(rtnl, ret, nlmsg_type);
+        if (r < 0)
+                return r;
+
+        ifsm = NLMSG_DATA((*ret)->hdr);
+        ifsm->family = AF_UNSPEC;
+        ifsm->ifindex = ifindex;
+        ifsm->filter_mask = filter_mask;
+
+        return 0;
+}
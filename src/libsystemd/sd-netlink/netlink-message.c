@@ -116,7 +116,8 @@ int sd_netlink_message_set_request_dump(sd_netlink_message *m, int dump) {
         assert_return(m->protocol != NETLINK_ROUTE ||
                       IN_SET(m->hdr->nlmsg_type,
                              RTM_GETLINK, RTM_GETLINKPROP, RTM_GETADDR, RTM_GETROUTE, RTM_GETNEIGH,
-                             RTM_GETRULE, RTM_GETADDRLABEL, RTM_GETNEXTHOP, RTM_GETQDISC, RTM_GETTCLASS),
+                             RTM_GETRULE, RTM_GETADDRLABEL, RTM_GETNEXTHOP, RTM_GETQDISC, RTM_GETTCLASS,
+                             RTM_GETSTATS),
                       -EINVAL);
 
         SET_FLAG(m->hdr->nlmsg_flags, NLM_F_DUMP, dump);
@@ -989,6 +990,13 @@ int netlink_message_read_in_addr_union(sd_netlink_message *m, uint16_t attr_type
         return r;
 }
 
+uint16_t netlink_message_get_flags(sd_netlink_message *m) {
+        assert(m);
+        assert(m->hdr);
+
+        return m->hdr->nlmsg_flags;
+}
+
 int sd_netlink_message_read_in_addr(sd_netlink_message *m, uint16_t attr_type, struct in_addr *ret) {
         assert_return(m, -EINVAL);
 
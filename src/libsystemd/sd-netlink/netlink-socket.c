@@ -159,6 +159,33 @@ int socket_write_message(sd_netlink *nl, sd_netlink_message *m) {
         return k;
 }
 
+/* returns the number of bytes sent, or a negative error code */
+int socket_writev_message(sd_netlink *nl, sd_netlink_message **m, size_t msgcount) {
+        _cleanup_free_ struct iovec *iovs = NULL;
+        ssize_t k;
+
+        assert(nl);
+        assert(m);
+        assert(msgcount > 0);
+
+        iovs = new(struct iovec, msgcount);
+        if (!iovs)
+                return -ENOMEM;
+
+        for (size_t i = 0; i < msgcount; i++) {
+                assert(m[i]->hdr);
+                assert(m[i]->hdr->nlmsg_len > 0);
+
+                iovs[i] = IOVEC_MAKE(m[i]->hdr, m[i]->hdr->nlmsg_len);
+        }
+
+        k = writev(nl->fd, iovs, msgcount);
+        if (k < 0)
+                return -errno;
+
+        return k;
+}
+
 static int socket_recv_message(int fd, void *buf, size_t buf_size, uint32_t *ret_mcast_group, bool peek) {
         struct iovec iov = IOVEC_MAKE(buf, buf_size);
         union sockaddr_union sender;
@@ -349,18 +376,17 @@ finalize:
         return 0;
 }
 
-/* On success, the number of bytes received is returned and *ret points to the received message
- * which has a valid header and the correct size.
- * If nothing useful was received 0 is returned.
- * On failure, a negative error code is returned.
- */
-int socket_read_message(sd_netlink *nl) {
+/* Reads one datagram. Returns 0 if nothing useful was received, and 1 if the datagram was consumed, in
+ * which case *ret_done tells whether a complete message was put into the read queue. On failure, a
+ * negative error code is returned. */
+static int socket_read_datagram(sd_netlink *nl, bool *ret_done) {
         bool done = false;
         uint32_t group;
         size_t len;
         int r;
 
         assert(nl);
+        assert(ret_done);
 
         /* read nothing, just get the pending message size */
         r = socket_recv_message(nl->fd, NULL, 0, NULL, true);
@@ -411,10 +437,10 @@ int socket_read_message(sd_netlink *nl) {
                                 existing = hashmap_get(nl->rqueue_partial_by_serial, UINT32_TO_PTR(hdr->nlmsg_seq));
                                 if (existing) {
                                         /* This is the continuation of the previously read messages.
-                                         * Let's append this message at the end. */
-                                        while (existing->next)
-                                                existing = existing->next;
-                                        existing->next = TAKE_PTR(m);
+                                         * Let's append this message at the end. The head keeps track of
+                                         * the end, as dumps may consist of millions of messages. */
+                                        (existing->last ?: existing)->next = m;
+                                        existing->last = TAKE_PTR(m);
                                 } else {
                                         /* This is the first message. Put it into the queue for partially
                                          * received messages. */
@@ -436,5 +462,27 @@ int socket_read_message(sd_netlink *nl) {
         if (len > 0)
                 log_debug("sd-netlink: discarding trailing %zu bytes of incoming message", len);
 
-        return done;
+        *ret_done = done;
+        return 1;
+}
+
+/* Returns 1 if at least one complete message was put into the read queue, 0 if not, and a negative error
+ * code on failure. The parts of a large dump are usually already queued on the socket, hence keep reading
+ * them without going back to poll() for each datagram, up to a limit. */
+int socket_read_message(sd_netlink *nl) {
+        int r;
+
+        assert(nl);
+
+        for (unsigned i = 0; i < NETLINK_READ_DATAGRAMS_MAX; i++) {
+                bool done;
+
+                r = socket_read_datagram(nl, &done);
+                if (r <= 0)
+                        return r;
+                if (done)
+                        return 1;
+        }
+
+        return 0;
 }
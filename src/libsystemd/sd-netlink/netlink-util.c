@@ -3,7 +3,6 @@
 #include "sd-netlink.h"
 
 #include "fd-util.h"
-#include "iovec-util.h"
 #include "memory-util.h"
 #include "netlink-internal.h"
 #include "netlink-util.h"
@@ -706,32 +705,6 @@ void netlink_seal_message(sd_netlink *nl, sd_netlink_message *m) {
         message_seal(m);
 }
 
-static int socket_writev_message(sd_netlink *nl, sd_netlink_message **m, size_t msgcount) {
-        _cleanup_free_ struct iovec *iovs = NULL;
-        ssize_t k;
-
-        assert(nl);
-        assert(m);
-        assert(msgcount > 0);
-
-        iovs = new(struct iovec, msgcount);
-        if (!iovs)
-                return -ENOMEM;
-
-        for (size_t i = 0; i < msgcount; i++) {
-                assert(m[i]->hdr);
-                assert(m[i]->hdr->nlmsg_len > 0);
-
-                iovs[i] = IOVEC_MAKE(m[i]->hdr, m[i]->hdr->nlmsg_len);
-        }
-
-        k = writev(nl->fd, iovs, msgcount);
-        if (k < 0)
-                return -errno;
-
-        return k;
-}
-
 int sd_netlink_sendv(
                 sd_netlink *nl,
                 sd_netlink_message **messages,
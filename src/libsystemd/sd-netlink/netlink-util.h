@@ -125,6 +125,7 @@ int netlink_message_append_sockaddr_union(sd_netlink_message *m, unsigned short
 
 int netlink_message_read_hw_addr(sd_netlink_message *m, unsigned short type, struct hw_addr_data *data);
 int netlink_message_read_in_addr_union(sd_netlink_message *m, unsigned short type, int family, union in_addr_union *data);
+uint16_t netlink_message_get_flags(sd_netlink_message *m);
 
 void rtattr_append_attribute_internal(struct rtattr *rta, unsigned short type, const void *data, size_t data_length);
 int rtattr_append_attribute(struct rtattr **rta, unsigned short type, const void *data, size_t data_length);
@@ -133,5 +134,9 @@ void netlink_seal_message(sd_netlink *nl, sd_netlink_message *m);
 
 size_t netlink_get_reply_callback_count(sd_netlink *nl);
 
+/* Collects asynchronous calls made in between and sends them in batches, see NETLINK_WQUEUE_MAX */
+void netlink_cork(sd_netlink *nl);
+int netlink_uncork(sd_netlink *nl);
+
 /* TODO: to be exported later */
 int sd_netlink_sendv(sd_netlink *nl, sd_netlink_message **messages, size_t msgcnt, uint32_t **ret_serial);
@@ -124,6 +124,10 @@ static sd_netlink *netlink_free(sd_netlink *nl) {
         hashmap_free(nl->rqueue_partial_by_serial);
         free(nl->rbuffer);
 
+        FOREACH_ARRAY(m, nl->wqueue, nl->wqueue_size)
+                sd_netlink_message_unref(*m);
+        free(nl->wqueue);
+
         while ((s = nl->slots)) {
                 assert(s->floating);
                 netlink_slot_disconnect(s, true);
@@ -145,6 +149,88 @@ static sd_netlink *netlink_free(sd_netlink *nl) {
 
 DEFINE_TRIVIAL_REF_UNREF_FUNC(sd_netlink, sd_netlink, netlink_free);
 
+static int netlink_flush_wqueue(sd_netlink *nl) {
+        int r;
+
+        assert(nl);
+
+        if (nl->wqueue_size == 0)
+                return 0;
+
+        r = socket_writev_message(nl, nl->wqueue, nl->wqueue_size);
+        if (r < 0) {
+                log_debug_errno(r, "sd-netlink: Failed to send %zu queued messages at once, sending them one by one: %m",
+                                nl->wqueue_size);
+
+                r = 0;
+                FOREACH_ARRAY(m, nl->wqueue, nl->wqueue_size) {
+                        int k;
+
+                        k = socket_write_message(nl, *m);
+                        if (k < 0)
+                                RET_GATHER(r, k);
+                }
+        }
+
+        FOREACH_ARRAY(m, nl->wqueue, nl->wqueue_size)
+                sd_netlink_message_unref(*m);
+        nl->wqueue_size = 0;
+        nl->wqueue_bytes = 0;
+
+        return r;
+}
+
+static int netlink_enqueue_message(sd_netlink *nl, sd_netlink_message *m, uint32_t *ret_serial) {
+        int r;
+
+        assert(nl);
+        assert(nl->corked);
+        assert(m);
+        assert(!m->sealed);
+
+        /* Failures to send earlier messages are not the fault of this one, and their reply callbacks will
+         * time out eventually. Hence only log them. */
+
+        /* Make sure the queued datagram stays small enough for the socket's send buffer */
+        if (nl->wqueue_bytes + m->hdr->nlmsg_len > NETLINK_WQUEUE_BYTES_MAX) {
+                r = netlink_flush_wqueue(nl);
+                if (r < 0)
+                        log_debug_errno(r, "sd-netlink: Failed to send queued messages, ignoring: %m");
+        }
+
+        if (!GREEDY_REALLOC(nl->wqueue, nl->wqueue_size + 1))
+                return -ENOMEM;
+
+        netlink_seal_message(nl, m);
+
+        nl->wqueue[nl->wqueue_size++] = sd_netlink_message_ref(m);
+        nl->wqueue_bytes += m->hdr->nlmsg_len;
+
+        if (ret_serial)
+                *ret_serial = message_get_serial(m);
+
+        if (nl->wqueue_size >= NETLINK_WQUEUE_MAX) {
+                r = netlink_flush_wqueue(nl);
+                if (r < 0)
+                        log_debug_errno(r, "sd-netlink: Failed to send queued messages, ignoring: %m");
+        }
+
+        return 1;
+}
+
+void netlink_cork(sd_netlink *nl) {
+        assert(nl);
+
+        nl->corked = true;
+}
+
+int netlink_uncork(sd_netlink *nl) {
+        assert(nl);
+
+        nl->corked = false;
+        return netlink_flush_wqueue(nl);
+}
+
 int sd_netlink_send(
                 sd_netlink *nl,
                 sd_netlink_message *message,
@@ -157,6 +243,11 @@ int sd_netlink_send(
         assert_return(message, -EINVAL);
         assert_return(!message->sealed, -EPERM);
 
+        /* Keep the order of messages: send out whatever was queued while corked first */
+        r = netlink_flush_wqueue(nl);
+        if (r < 0)
+                log_debug_errno(r, "sd-netlink: Failed to send queued messages, ignoring: %m");
+
         netlink_seal_message(nl, message);
 
         r = socket_write_message(nl, message);
@@ -502,7 +593,10 @@ int sd_netlink_call_async(
         slot->reply_callback.callback = callback;
         slot->reply_callback.timeout = timespan_to_timestamp(usec);
 
-        k = sd_netlink_send(nl, m, &slot->reply_callback.serial);
+        if (nl->corked)
+                k = netlink_enqueue_message(nl, m, &slot->reply_callback.serial);
+        else
+                k = sd_netlink_send(nl, m, &slot->reply_callback.serial);
         if (k < 0)
                 return k;
 
@@ -365,6 +365,35 @@ TEST(pipe) {
         assert_se((rtnl = sd_netlink_unref(rtnl)) == NULL);
 }
 
+TEST(cork) {
+        _cleanup_(sd_netlink_unrefp) sd_netlink *rtnl = NULL;
+        int ifindex, counter = 0;
+
+        assert_se(sd_netlink_open(&rtnl) >= 0);
+        ifindex = (int) if_nametoindex("lo");
+
+        /* More calls than fit into one batch, so that the queue is flushed while still corked, too */
+        netlink_cork(rtnl);
+
+        for (unsigned i = 0; i < NETLINK_WQUEUE_MAX + 5; i++) {
+                _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
+
+                assert_se(sd_rtnl_message_new_link(rtnl, &m, RTM_GETLINK, ifindex) >= 0);
+
+                counter++;
+                assert_se(sd_netlink_call_async(rtnl, NULL, m, pipe_handler, NULL, &counter, 0, NULL) >= 0);
+        }
+
+        assert_se(rtnl->wqueue_size == 5);
+        assert_se(netlink_uncork(rtnl) >= 0);
+        assert_se(rtnl->wqueue_size == 0);
+
+        while (counter > 0) {
+                assert_se(sd_netlink_wait(rtnl, 0) >= 0);
+                assert_se(sd_netlink_process(rtnl, NULL) >= 0);
+        }
+}
+
 TEST(message_container) {
         _cleanup_(sd_netlink_unrefp) sd_netlink *rtnl = NULL;
         _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
@@ -445,6 +474,37 @@ TEST(dump_addresses) {
         }
 }
 
+TEST(dump_stats) {
+        _cleanup_(sd_netlink_unrefp) sd_netlink *rtnl = NULL;
+        _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *req = NULL, *reply = NULL;
+        int r;
+
+        assert_se(sd_netlink_open(&rtnl) >= 0);
+
+        assert_se(sd_rtnl_message_new_stats(rtnl, &req, RTM_GETSTATS, 0, IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64)) >= 0);
+        assert_se(sd_netlink_message_set_request_dump(req, true) >= 0);
+        r = sd_netlink_call(rtnl, req, 0, &reply);
+        if (ERRNO_IS_NEG_NOT_SUPPORTED(r))
+                return (void) log_tests_skipped_errno(r, "RTM_GETSTATS is not supported");
+        assert_se(r >= 0);
+
+        for (sd_netlink_message *m = reply; m; m = sd_netlink_message_next(m)) {
+                struct rtnl_link_stats64 stats;
+                uint16_t type;
+                int ifindex;
+
+                assert_se(sd_netlink_message_get_type(m, &type) >= 0);
+                assert_se(type == RTM_NEWSTATS);
+
+                assert_se(sd_rtnl_message_stats_get_ifindex(m, &ifindex) >= 0);
+                assert_se(ifindex > 0);
+
+                assert_se(sd_netlink_message_read(m, IFLA_STATS_LINK_64, sizeof(stats), &stats) >= 0);
+
+                log_info("ifindex %i: rx %" PRIu64 " bytes, tx %" PRIu64 " bytes", ifindex, (uint64_t) stats.rx_bytes, (uint64_t) stats.tx_bytes);
+        }
+}
+
 TEST(sd_netlink_message_get_errno) {
         _cleanup_(sd_netlink_unrefp) sd_netlink *rtnl = NULL;
         _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
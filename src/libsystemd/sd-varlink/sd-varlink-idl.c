@@ -1784,6 +1784,31 @@ static int varlink_idl_validate_field(const sd_varlink_field *field, sd_json_var
         return 0;
 }
 
+static sd_json_variant* json_variant_by_key_hinted(sd_json_variant *v, const char *key, size_t *hint) {
+        size_t n;
+
+        assert(v);
+        assert(key);
+        assert(hint);
+
+        /* Like sd_json_variant_by_key(), but starts looking at the element index *hint, and updates it to
+         * point past the field found. Objects are typically generated by code following the IDL, hence
+         * usually list their fields in the same order as the IDL, and this way each lookup only needs to
+         * look at a single key instead of searching the whole object. */
+
+        n = sd_json_variant_elements(v);
+        for (size_t j = 0; j < n; j += 2) {
+                size_t i = (*hint + j) % n;
+
+                if (streq_ptr(sd_json_variant_string(sd_json_variant_by_index(v, i)), key)) {
+                        *hint = (i + 2) % n;
+                        return sd_json_variant_by_index(v, i + 1);
+                }
+        }
+
+        return NULL;
+}
+
 static int varlink_idl_validate_symbol(const sd_varlink_symbol *symbol, sd_json_variant *v, sd_varlink_field_direction_t direction, const char **reterr_bad_field) {
         int r;
 
@@ -1841,7 +1866,10 @@ static int varlink_idl_validate_symbol(const sd_varlink_symbol *symbol, sd_json_
                         return varlink_idl_log(SYNTHETIC_ERRNO(EMEDIUMTYPE), "Passed non-object to field '%s', refusing.", strna(symbol->name));
                 }
 
+                size_t hint = 0, n_found = 0;
+
                 for (const sd_varlink_field *field = symbol->fields; field->field_type != _SD_VARLINK_FIELD_TYPE_END_MARKER; field++) {
+                        sd_json_variant *e;
 
                         if (field->field_type == _SD_VARLINK_FIELD_COMMENT)
                                 continue;
@@ -1849,7 +1877,11 @@ static int varlink_idl_validate_symbol(const sd_varlink_symbol *symbol, sd_json_
                         if (field->field_direction != direction)
                                 continue;
 
-                        r = varlink_idl_validate_field(field, sd_json_variant_by_key(v, field->name));
+                        e = json_variant_by_key_hinted(v, field->name, &hint);
+                        if (e)
+                                n_found++;
+
+                        r = varlink_idl_validate_field(field, e);
                         if (r < 0) {
                                 if (reterr_bad_field)
                                         *reterr_bad_field = field->name;
@@ -1857,13 +1889,17 @@ static int varlink_idl_validate_symbol(const sd_varlink_symbol *symbol, sd_json_
                         }
                 }
 
-                _unused_ sd_json_variant *e;
-                const char *name;
-                JSON_VARIANT_OBJECT_FOREACH(name, e, v) {
-                        if (!varlink_idl_find_field(symbol, name)) {
-                                if (reterr_bad_field)
-                                        *reterr_bad_field = name;
-                                return varlink_idl_log(SYNTHETIC_ERRNO(EBUSY), "Field '%s' not defined for object, refusing.", name);
+                /* If each key of the object matched one of the fields above, they are all defined, and
+                 * there's no need to look them up again. */
+                if (n_found < sd_json_variant_elements(v) / 2) {
+                        _unused_ sd_json_variant *e;
+                        const char *name;
+                        JSON_VARIANT_OBJECT_FOREACH(name, e, v) {
+                                if (!varlink_idl_find_field(symbol, name)) {
+                                        if (reterr_bad_field)
+                                                *reterr_bad_field = name;
+                                        return varlink_idl_log(SYNTHETIC_ERRNO(EBUSY), "Field '%s' not defined for object, refusing.", name);
+                                }
                         }
                 }
 
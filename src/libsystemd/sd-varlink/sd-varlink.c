@@ -38,6 +38,7 @@
 #define VARLINK_DEFAULT_TIMEOUT_USEC (45U*USEC_PER_SEC)
 #define VARLINK_BUFFER_MAX (16U*1024U*1024U)
 #define VARLINK_READ_SIZE (64U*1024U)
+#define VARLINK_WRITE_COALESCE_MAX (64U*1024U)
 #define VARLINK_COLLECT_MAX 1024U
 
 static const char* const varlink_state_table[_VARLINK_STATE_MAX] = {
@@ -702,6 +703,22 @@ disconnect:
         return 1;
 }
 
+static bool varlink_may_delay_write(sd_varlink *v) {
+        assert(v);
+
+        /* If we are a server and the client pipelined further method calls that are already sitting in our
+         * input buffer, then let's process those first, so that the replies to all of them are written in
+         * one go, rather than with one write() each. We only do this as long as the replies are not
+         * accumulating too much, and not when file descriptors are to be sent, to keep things simple. If the
+         * buffered input turns out to be an incomplete message, varlink_parse_message() will reset
+         * 'input_buffer_unscanned' and we'll write things out on the next iteration. */
+
+        return v->state == VARLINK_IDLE_SERVER &&
+                (v->current || v->input_buffer_unscanned > 0) &&
+                v->output_buffer_size < VARLINK_WRITE_COALESCE_MAX &&
+                v->n_output_fds == 0;
+}
+
 static int varlink_write(sd_varlink *v) {
         ssize_t n;
         int r;
@@ -1446,7 +1463,7 @@ _public_ int sd_varlink_process(sd_varlink *v) {
 
         sd_varlink_ref(v);
 
-        r = varlink_write(v);
+        r = varlink_may_delay_write(v) ? 0 : varlink_write(v);
         if (r < 0)
                 varlink_log_errno(v, r, "Write failed: %m");
         if (r != 0)
@@ -1871,19 +1888,35 @@ _public_ sd_varlink* sd_varlink_flush_close_unref(sd_varlink *v) {
 }
 
 static int varlink_format_json(sd_varlink *v, sd_json_variant *m) {
-        _cleanup_(erase_and_freep) char *text = NULL;
-        int sz, r;
+        size_t size;
+        int r;
 
         assert(v);
         assert(m);
 
-        sz = sd_json_variant_format(m, /* flags= */ 0, &text);
-        if (sz < 0)
-                return sz;
-        assert(text[sz] == '\0');
+        /* Move what's still pending to the front first, so that the message can be formatted right after
+         * it, directly into the output buffer. */
+        if (v->output_buffer_index > 0) {
+                memmove(v->output_buffer, v->output_buffer + v->output_buffer_index, v->output_buffer_size);
+
+                if (v->output_buffer_sensitive)
+                        explicit_bzero_safe(v->output_buffer + v->output_buffer_size, v->output_buffer_index);
+
+                v->output_buffer_index = 0;
+        }
+
+        size = v->output_buffer_size;
+        r = sd_json_variant_format_append(m, /* flags= */ 0, &v->output_buffer, &size);
+        if (r < 0)
+                return r;
+
+        /* The trailing NUL byte sd_json_variant_format_append() leaves behind is our message delimiter */
+        if (size + 1 > VARLINK_BUFFER_MAX) {
+                if (sd_json_variant_is_sensitive_recursive(m))
+                        explicit_bzero_safe(v->output_buffer + v->output_buffer_size, size - v->output_buffer_size);
 
-        if (v->output_buffer_size + sz + 1 > VARLINK_BUFFER_MAX)
                 return -ENOBUFS;
+        }
 
         if (DEBUG_LOGGING) {
                 _cleanup_(erase_and_freep) char *censored_text = NULL;
@@ -1896,39 +1929,11 @@ static int varlink_format_json(sd_varlink *v, sd_json_variant *m) {
                 varlink_log(v, "Sending message: %s", censored_text);
         }
 
-        if (v->output_buffer_size == 0) {
-
-                free_and_replace(v->output_buffer, text);
-
-                v->output_buffer_size = sz + 1;
-                v->output_buffer_index = 0;
-
-        } else if (v->output_buffer_index == 0) {
-
-                if (!GREEDY_REALLOC(v->output_buffer, v->output_buffer_size + sz + 1))
-                        return -ENOMEM;
-
-                memcpy(v->output_buffer + v->output_buffer_size, text, sz + 1);
-                v->output_buffer_size += sz + 1;
-        } else {
-                char *n;
-                const size_t new_size = v->output_buffer_size + sz + 1;
-
-                n = new(char, new_size);
-                if (!n)
-                        return -ENOMEM;
-
-                memcpy(mempcpy(n, v->output_buffer + v->output_buffer_index, v->output_buffer_size), text, sz + 1);
-
-                free_and_replace(v->output_buffer, n);
-                v->output_buffer_size = new_size;
-                v->output_buffer_index = 0;
-        }
+        assert(v->output_buffer[size] == '\0');
+        v->output_buffer_size = size + 1;
 
         if (sd_json_variant_is_sensitive_recursive(m))
                 v->output_buffer_sensitive = true; /* Propagate sensitive flag */
-        else
-                text = mfree(text); /* No point in the erase_and_free() destructor declared above */
 
         return 0;
 }
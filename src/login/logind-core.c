@@ -20,6 +20,7 @@
 #include "fd-util.h"
 #include "limits-util.h"
 #include "logind.h"
+#include "logind-varlink.h"
 #include "parse-util.h"
 #include "path-util.h"
 #include "process-util.h"
@@ -255,6 +256,36 @@ int manager_add_button(Manager *m, const char *name, Button **ret_button) {
         return 0;
 }
 
+void manager_dispatch_save_queue(Manager *m) {
+        Session *session;
+        User *user;
+
+        assert(m);
+
+        /* State files are rewritten in full on every change. With many sessions a single event (e.g. a
+         * session being created or a seat switching sessions) tends to change the same objects multiple
+         * times, hence we only queue them up and write each of them out once here. */
+
+        while ((session = LIST_POP(save_queue, m->session_save_queue))) {
+                session->in_save_queue = false;
+                (void) session_save(session);
+
+                if (session->started)
+                        manager_varlink_session_changed(session, /* removed= */ false);
+        }
+
+        while ((user = LIST_POP(save_queue, m->user_save_queue))) {
+                user->in_save_queue = false;
+                (void) user_save(user);
+
+                if (user->started)
+                        manager_varlink_user_changed(user, /* removed= */ false);
+        }
+
+        /* Varlink subscribers get the same batch of changes in one go */
+        (void) manager_varlink_flush_changes(m);
+}
+
 int manager_process_seat_device(Manager *m, sd_device *d) {
         Device *device;
         int r;
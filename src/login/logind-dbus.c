@@ -4369,8 +4369,8 @@ int match_job_removed(sd_bus_message *message, void *userdata, sd_bus_error *err
                         session->scope_job = mfree(session->scope_job);
                         session_jobs_reply(session, id, unit, result);
 
-                        session_save(session);
-                        user_save(session->user);
+                        session_add_to_save_queue(session);
+                        user_add_to_save_queue(session->user);
                 }
 
                 session_add_to_gc_queue(session);
@@ -4389,7 +4389,7 @@ int match_job_removed(sd_bus_message *message, void *userdata, sd_bus_error *err
                                                 /* Don't propagate user service failures to the client */
                                                 session_jobs_reply(s, id, unit, /* error = */ NULL);
 
-                                        user_save(user);
+                                        user_add_to_save_queue(user);
                                         break;
                                 }
                 }
@@ -597,7 +597,7 @@ static int method_take_device(sd_bus_message *message, void *userdata, sd_bus_er
         if (r < 0)
                 return r;
 
-        session_save(s);
+        session_add_to_save_queue(s);
         TAKE_PTR(sd);
 
         return 1;
@@ -628,7 +628,7 @@ static int method_release_device(sd_bus_message *message, void *userdata, sd_bus
                 return sd_bus_error_set(error, BUS_ERROR_DEVICE_NOT_TAKEN, "Device not taken");
 
         session_device_free(sd);
-        session_save(s);
+        session_add_to_save_queue(s);
 
         return sd_bus_reply_method_return(message, NULL);
 }
@@ -916,8 +916,10 @@ int session_send_create_reply_bus(Session *s, const sd_bus_error *error) {
         if (fifo_fd < 0)
                 return fifo_fd;
 
-        /* Update the session state file before we notify the client about the result. */
-        session_save(s);
+        /* Write out the session state file, and any other pending ones (i.e. the user's), before we
+         * notify the client about the result. */
+        session_add_to_save_queue(s);
+        manager_dispatch_save_queue(s->manager);
 
         _cleanup_free_ char *p = session_bus_path(s);
         if (!p)
@@ -961,7 +963,8 @@ int session_send_upgrade_reply(Session *s, const sd_bus_error *error) {
         if (error)
                 return sd_bus_reply_method_error(c, error);
 
-        session_save(s);
+        session_add_to_save_queue(s);
+        manager_dispatch_save_queue(s->manager);
 
         return sd_bus_reply_method_return(c, NULL);
 }
@@ -158,6 +158,11 @@ Session* session_free(Session *s) {
                 LIST_REMOVE(gc_queue, s->manager->session_gc_queue, s);
         }
 
+        if (s->in_save_queue) {
+                assert(s->manager);
+                LIST_REMOVE(save_queue, s->manager->session_save_queue, s);
+        }
+
         sd_event_source_unref(s->timer_event_source);
 
         session_drop_controller(s);
@@ -883,8 +888,8 @@ int session_start(Session *s, sd_bus_message *properties, sd_bus_error *error) {
         user_elect_display(s->user);
 
         /* Save data */
-        (void) session_save(s);
-        (void) user_save(s->user);
+        session_add_to_save_queue(s);
+        user_add_to_save_queue(s->user);
         if (s->seat)
                 (void) seat_save(s->seat);
 
@@ -978,8 +983,8 @@ int session_stop(Session *s, bool force) {
 
         user_elect_display(s->user);
 
-        (void) session_save(s);
-        (void) user_save(s->user);
+        session_add_to_save_queue(s);
+        user_add_to_save_queue(s->user);
 
         return r;
 }
@@ -1015,6 +1020,7 @@ int session_finalize(Session *s) {
 
         if (s->started) {
                 session_send_signal(s, false);
+                manager_varlink_session_changed(s, /* removed= */ true);
                 s->started = false;
         }
 
@@ -1027,7 +1033,7 @@ int session_finalize(Session *s) {
 
         session_reset_leader(s, /* keep_fdstore = */ false);
 
-        (void) user_save(s->user);
+        user_add_to_save_queue(s->user);
         (void) user_send_changed(s->user, "Display", NULL);
 
         return 0;
@@ -1201,7 +1207,7 @@ int session_set_locked_hint(Session *s, bool b) {
                 return 0;
 
         s->locked_hint = b;
-        (void) session_save(s);
+        session_add_to_save_queue(s);
         (void) session_send_changed(s, "LockedHint", NULL);
 
         return 1;
@@ -1214,7 +1220,7 @@ void session_set_type(Session *s, SessionType t) {
                 return;
 
         s->type = t;
-        (void) session_save(s);
+        session_add_to_save_queue(s);
         (void) session_send_changed(s, "Type", NULL);
 }
 
@@ -1225,7 +1231,7 @@ void session_set_class(Session *s, SessionClass c) {
                 return;
 
         s->class = c;
-        (void) session_save(s);
+        session_add_to_save_queue(s);
         (void) session_send_changed(s, "Class", NULL);
 
         /* This class change might mean we need the per-user session manager now. Try to start it. */
@@ -1242,7 +1248,7 @@ int session_set_display(Session *s, const char *display) {
         if (r <= 0)  /* 0 means the strings were equal */
                 return r;
 
-        (void) session_save(s);
+        session_add_to_save_queue(s);
         (void) session_send_changed(s, "Display", NULL);
 
         return 1;
@@ -1258,7 +1264,7 @@ int session_set_tty(Session *s, const char *tty) {
         if (r <= 0)  /* 0 means the strings were equal */
                 return r;
 
-        (void) session_save(s);
+        session_add_to_save_queue(s);
         (void) session_send_changed(s, "TTY", NULL);
 
         return 1;
@@ -1386,6 +1392,19 @@ void session_add_to_gc_queue(Session *s) {
         s->in_gc_queue = true;
 }
 
+void session_add_to_save_queue(Session *s) {
+        assert(s);
+
+        /* The state file is written out from the main loop, after the current event has been dispatched,
+         * so that multiple changes to the session are coalesced into a single write. */
+
+        if (s->in_save_queue)
+                return;
+
+        LIST_PREPEND(save_queue, s->manager->session_save_queue, s);
+        s->in_save_queue = true;
+}
+
 SessionState session_get_state(Session *s) {
         assert(s);
 
@@ -1645,7 +1664,7 @@ int session_set_controller(Session *s, const char *sender, bool force, bool prep
 
         session_release_controller(s, true);
         s->controller = TAKE_PTR(name);
-        (void) session_save(s);
+        session_add_to_save_queue(s);
 
         return 0;
 }
@@ -1659,7 +1678,7 @@ void session_drop_controller(Session *s) {
         s->track = sd_bus_track_unref(s->track);
         session_set_type(s, s->original_type);
         session_release_controller(s, false);
-        (void) session_save(s);
+        session_add_to_save_queue(s);
         session_restore_vt(s);
 }
 
@@ -145,6 +145,7 @@ struct Session {
         sd_event_source *leader_pidfd_event_source;
 
         bool in_gc_queue;
+        bool in_save_queue;
         bool started;
         bool stopping;
 
@@ -173,6 +174,7 @@ struct Session {
         LIST_FIELDS(Session, sessions_by_seat);
 
         LIST_FIELDS(Session, gc_queue);
+        LIST_FIELDS(Session, save_queue);
 };
 
 int session_new(Manager *m, const char *id, Session **ret);
@@ -184,6 +186,7 @@ void session_set_user(Session *s, User *u);
 int session_set_leader_consume(Session *s, PidRef _leader);
 bool session_may_gc(Session *s, bool drop_not_started);
 void session_add_to_gc_queue(Session *s);
+void session_add_to_save_queue(Session *s);
 int session_activate(Session *s);
 bool session_is_active(Session *s);
 int session_get_idle_hint(Session *s, dual_timestamp *t);
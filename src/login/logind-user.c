@@ -22,6 +22,7 @@
 #include "logind-dbus.h"
 #include "logind-user-dbus.h"
 #include "logind-user.h"
+#include "logind-varlink.h"
 #include "mkdir-label.h"
 #include "parse-util.h"
 #include "path-util.h"
@@ -109,6 +110,9 @@ User *user_free(User *u) {
         if (u->in_gc_queue)
                 LIST_REMOVE(gc_queue, u->manager->user_gc_queue, u);
 
+        if (u->in_save_queue)
+                LIST_REMOVE(save_queue, u->manager->user_save_queue, u);
+
         while (u->sessions)
                 session_free(u->sessions);
 
@@ -542,7 +546,7 @@ int user_start(User *u) {
         }
 
         /* Save new user data */
-        user_save(u);
+        user_add_to_save_queue(u);
 
         return 0;
 }
@@ -584,7 +588,7 @@ int user_stop(User *u, bool force) {
                 return 0;
 
         if (u->stopping) { /* Stop jobs have already been queued */
-                user_save(u);
+                user_add_to_save_queue(u);
                 return 0;
         }
 
@@ -595,7 +599,7 @@ int user_stop(User *u, bool force) {
 
         u->stopping = true;
 
-        user_save(u);
+        user_add_to_save_queue(u);
 
         return r;
 }
@@ -628,6 +632,7 @@ int user_finalize(User *u) {
 
         if (u->started) {
                 user_send_signal(u, false);
+                manager_varlink_user_changed(u, /* removed= */ true);
                 u->started = false;
         }
 
@@ -812,6 +817,16 @@ void user_add_to_gc_queue(User *u) {
         u->in_gc_queue = true;
 }
 
+void user_add_to_save_queue(User *u) {
+        assert(u);
+
+        if (u->in_save_queue)
+                return;
+
+        LIST_PREPEND(save_queue, u->manager->user_save_queue, u);
+        u->in_save_queue = true;
+}
+
 UserState user_get_state(User *u) {
         assert(u);
 
@@ -56,6 +56,7 @@ struct User {
 
         UserGCMode gc_mode;
         bool in_gc_queue:1;
+        bool in_save_queue:1;
 
         bool started:1;       /* Whenever the user being started, has been started or is being stopped again
                                  (tracked through user-runtime-dir@.service) */
@@ -63,6 +64,7 @@ struct User {
 
         LIST_HEAD(Session, sessions);
         LIST_FIELDS(User, gc_queue);
+        LIST_FIELDS(User, save_queue);
 };
 
 int user_new(Manager *m, UserRecord *ur, User **ret);
@@ -75,6 +77,7 @@ int user_start(User *u);
 
 bool user_may_gc(User *u, bool drop_not_started);
 void user_add_to_gc_queue(User *u);
+void user_add_to_save_queue(User *u);
 int user_stop(User *u, bool force);
 int user_finalize(User *u);
 UserState user_get_state(User *u);
@@ -104,8 +104,10 @@ int session_send_create_reply_varlink(Session *s, const sd_bus_error *error) {
         if (fifo_fd < 0)
                 return fifo_fd;
 
-        /* Update the session state file before we notify the client about the result. */
-        session_save(s);
+        /* Write out the session state file, and any other pending ones (i.e. the user's), before we
+         * notify the client about the result. */
+        session_add_to_save_queue(s);
+        manager_dispatch_save_queue(s->manager);
 
         log_debug("Sending Varlink reply about created session: "
                   "id=%s uid=" UID_FMT " runtime_path=%s "
@@ -337,6 +339,183 @@ static int vl_method_release_session(sd_varlink *link, sd_json_variant *paramete
         return sd_varlink_reply(link, NULL);
 }
 
+static int session_append_json(Session *s, sd_json_variant **array) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r;
+
+        assert(s);
+        assert(s->user);
+        assert(array);
+
+        r = sd_json_buildo(
+                        &v,
+                        SD_JSON_BUILD_PAIR_STRING("Id", s->id),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("UID", s->user->user_record->uid),
+                        SD_JSON_BUILD_PAIR_STRING("State", session_state_to_string(session_get_state(s))),
+                        SD_JSON_BUILD_PAIR_BOOLEAN("Active", session_is_active(s)),
+                        SD_JSON_BUILD_PAIR_BOOLEAN("Remote", s->remote),
+                        SD_JSON_BUILD_PAIR_CONDITION(s->class >= 0, "Class", JSON_BUILD_STRING_UNDERSCORIFY(session_class_to_string(s->class))),
+                        SD_JSON_BUILD_PAIR_CONDITION(s->type >= 0, "Type", JSON_BUILD_STRING_UNDERSCORIFY(session_type_to_string(s->type))),
+                        SD_JSON_BUILD_PAIR_CONDITION(!!s->seat, "Seat", SD_JSON_BUILD_STRING(s->seat ? s->seat->id : NULL)),
+                        SD_JSON_BUILD_PAIR_CONDITION(s->vtnr > 0, "VTNr", SD_JSON_BUILD_UNSIGNED(s->vtnr)),
+                        JSON_BUILD_PAIR_STRING_NON_EMPTY("TTY", s->tty),
+                        JSON_BUILD_PAIR_STRING_NON_EMPTY("Display", s->display),
+                        JSON_BUILD_PAIR_STRING_NON_EMPTY("Service", s->service),
+                        JSON_BUILD_PAIR_STRING_NON_EMPTY("Desktop", s->desktop),
+                        JSON_BUILD_PAIR_STRING_NON_EMPTY("RemoteUser", s->remote_user),
+                        JSON_BUILD_PAIR_STRING_NON_EMPTY("RemoteHost", s->remote_host));
+        if (r < 0)
+                return r;
+
+        return sd_json_variant_append_array(array, v);
+}
+
+static int user_append_json(User *u, sd_json_variant **array) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r;
+
+        assert(u);
+        assert(array);
+
+        r = sd_json_buildo(
+                        &v,
+                        SD_JSON_BUILD_PAIR_UNSIGNED("UID", u->user_record->uid),
+                        SD_JSON_BUILD_PAIR_STRING("Name", u->user_record->user_name),
+                        SD_JSON_BUILD_PAIR_STRING("State", user_state_to_string(user_get_state(u))),
+                        SD_JSON_BUILD_PAIR_CONDITION(!!u->display, "Display", SD_JSON_BUILD_STRING(u->display ? u->display->id : NULL)));
+        if (r < 0)
+                return r;
+
+        return sd_json_variant_append_array(array, v);
+}
+
+void manager_varlink_session_changed(Session *s, bool removed) {
+        Manager *m = ASSERT_PTR(ASSERT_PTR(s)->manager);
+        int r;
+
+        /* Collects the change, manager_varlink_flush_changes() sends out everything collected in one go */
+
+        if (set_isempty(m->varlink_subscriptions))
+                return;
+
+        if (removed)
+                r = sd_json_variant_append_arrayb(&m->varlink_removed_sessions, SD_JSON_BUILD_STRING(s->id));
+        else
+                r = session_append_json(s, &m->varlink_changed_sessions);
+        if (r < 0)
+                log_warning_errno(r, "Failed to collect change of session %s for subscribers, ignoring: %m", s->id);
+}
+
+void manager_varlink_user_changed(User *u, bool removed) {
+        Manager *m = ASSERT_PTR(ASSERT_PTR(u)->manager);
+        int r;
+
+        if (set_isempty(m->varlink_subscriptions))
+                return;
+
+        if (removed)
+                r = sd_json_variant_append_arrayb(&m->varlink_removed_users, SD_JSON_BUILD_UNSIGNED(u->user_record->uid));
+        else
+                r = user_append_json(u, &m->varlink_changed_users);
+        if (r < 0)
+                log_warning_errno(r, "Failed to collect change of user %s for subscribers, ignoring: %m", u->user_record->user_name);
+}
+
+int manager_varlink_flush_changes(Manager *m) {
+        assert(m);
+
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant
+                *sessions = TAKE_PTR(m->varlink_changed_sessions),
+                *users = TAKE_PTR(m->varlink_changed_users),
+                *removed_sessions = TAKE_PTR(m->varlink_removed_sessions),
+                *removed_users = TAKE_PTR(m->varlink_removed_users);
+
+        if (!sessions && !users && !removed_sessions && !removed_users)
+                return 0;
+
+        return varlink_many_notifybo(
+                        m->varlink_subscriptions,
+                        SD_JSON_BUILD_PAIR_CONDITION(!!sessions, "Sessions", SD_JSON_BUILD_VARIANT(sessions)),
+                        SD_JSON_BUILD_PAIR_CONDITION(!!users, "Users", SD_JSON_BUILD_VARIANT(users)),
+                        SD_JSON_BUILD_PAIR_CONDITION(!!removed_sessions, "RemovedSessions", SD_JSON_BUILD_VARIANT(removed_sessions)),
+                        SD_JSON_BUILD_PAIR_CONDITION(!!removed_users, "RemovedUsers", SD_JSON_BUILD_VARIANT(removed_users)));
+}
+
+static int vl_method_subscribe(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *sessions = NULL, *users = NULL;
+        Manager *m = ASSERT_PTR(userdata);
+        Session *session;
+        User *user;
+        int r;
+
+        assert(link);
+
+        /* if the client didn't set the more flag, it is using us incorrectly */
+        if (!FLAGS_SET(flags, SD_VARLINK_METHOD_MORE))
+                return sd_varlink_error(link, SD_VARLINK_ERROR_EXPECTED_MORE, NULL);
+
+        r = sd_varlink_dispatch(link, parameters, /* dispatch_table= */ NULL, /* userdata= */ NULL);
+        if (r != 0)
+                return r;
+
+        /* Start out with the full current state, everything after that is sent as changes only. Objects
+         * that haven't been announced on the bus yet are skipped, they show up as changes later. */
+
+        r = sd_json_variant_new_array(&sessions, /* array= */ NULL, /* n= */ 0);
+        if (r < 0)
+                return r;
+
+        r = sd_json_variant_new_array(&users, /* array= */ NULL, /* n= */ 0);
+        if (r < 0)
+                return r;
+
+        HASHMAP_FOREACH(session, m->sessions) {
+                if (!session->started)
+                        continue;
+
+                r = session_append_json(session, &sessions);
+                if (r < 0)
+                        return r;
+        }
+
+        HASHMAP_FOREACH(user, m->users) {
+                if (!user->started)
+                        continue;
+
+                r = user_append_json(user, &users);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_varlink_notifybo(
+                        link,
+                        SD_JSON_BUILD_PAIR_VARIANT("Sessions", sessions),
+                        SD_JSON_BUILD_PAIR_VARIANT("Users", users));
+        if (r < 0)
+                return r;
+
+        r = set_ensure_put(&m->varlink_subscriptions, NULL, link);
+        if (r < 0)
+                return log_error_errno(r, "Failed to add subscription to set: %m");
+        sd_varlink_ref(link);
+
+        log_debug("%u clients now subscribed to session and user changes.", set_size(m->varlink_subscriptions));
+
+        return 1;
+}
+
+static void vl_on_disconnect(sd_varlink_server *s, sd_varlink *link, void *userdata) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        assert(s);
+        assert(link);
+
+        if (set_remove(m->varlink_subscriptions, link)) {
+                sd_varlink_unref(link);
+                log_debug("%u clients remain subscribed to session and user changes.", set_size(m->varlink_subscriptions));
+        }
+}
+
 int manager_varlink_init(Manager *m) {
         _cleanup_(sd_varlink_server_unrefp) sd_varlink_server *s = NULL;
         int r;
@@ -367,12 +546,17 @@ int manager_varlink_init(Manager *m) {
                         s,
                         "io.systemd.Login.CreateSession",    vl_method_create_session,
                         "io.systemd.Login.ReleaseSession",   vl_method_release_session,
+                        "io.systemd.Login.Subscribe",        vl_method_subscribe,
                         "io.systemd.service.Ping",           varlink_method_ping,
                         "io.systemd.service.SetLogLevel",    varlink_method_set_log_level,
                         "io.systemd.service.GetEnvironment", varlink_method_get_environment);
         if (r < 0)
                 return log_error_errno(r, "Failed to register varlink methods: %m");
 
+        r = sd_varlink_server_bind_disconnect(s, vl_on_disconnect);
+        if (r < 0)
+                return log_error_errno(r, "Failed to register varlink disconnect handler: %m");
+
         r = sd_varlink_server_listen_address(s, "/run/systemd/io.systemd.Login", 0666);
         if (r < 0)
                 return log_error_errno(r, "Failed to bind to varlink socket: %m");
@@ -388,5 +572,11 @@ int manager_varlink_init(Manager *m) {
 void manager_varlink_done(Manager *m) {
         assert(m);
 
+        m->varlink_subscriptions = set_free_with_destructor(m->varlink_subscriptions, sd_varlink_unref);
         m->varlink_server = sd_varlink_server_unref(m->varlink_server);
+
+        m->varlink_changed_sessions = sd_json_variant_unref(m->varlink_changed_sessions);
+        m->varlink_changed_users = sd_json_variant_unref(m->varlink_changed_users);
+        m->varlink_removed_sessions = sd_json_variant_unref(m->varlink_removed_sessions);
+        m->varlink_removed_users = sd_json_variant_unref(m->varlink_removed_users);
 }
@@ -5,8 +5,13 @@
 
 #include "logind.h"
 #include "logind-session.h"
+#include "logind-user.h"
 
 int manager_varlink_init(Manager *m);
 void manager_varlink_done(Manager *m);
 
+void manager_varlink_session_changed(Session *s, bool removed);
+void manager_varlink_user_changed(User *u, bool removed);
+int manager_varlink_flush_changes(Manager *m);
+
 int session_send_create_reply_varlink(Session *s, const sd_bus_error *error);
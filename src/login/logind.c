@@ -112,6 +112,8 @@ static Manager* manager_free(Manager *m) {
         if (!m)
                 return NULL;
 
+        manager_dispatch_save_queue(m);
+
         hashmap_free(m->devices);
         hashmap_free(m->seats);
         hashmap_free(m->sessions);
@@ -1208,6 +1210,7 @@ static int manager_run(Manager *m) {
                         return 0;
 
                 manager_gc(m, true);
+                manager_dispatch_save_queue(m);
 
                 r = manager_dispatch_delayed(m, false);
                 if (r < 0)
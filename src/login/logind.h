@@ -41,6 +41,9 @@ struct Manager {
         LIST_HEAD(Session, session_gc_queue);
         LIST_HEAD(User, user_gc_queue);
 
+        LIST_HEAD(Session, session_save_queue);
+        LIST_HEAD(User, user_save_queue);
+
         sd_device_monitor *device_seat_monitor, *device_monitor, *device_vcsa_monitor, *device_button_monitor;
 
         sd_event_source *console_active_event_source;
@@ -150,6 +153,10 @@ struct Manager {
         dual_timestamp init_ts;
 
         sd_varlink_server *varlink_server;
+        /* Clients subscribed via io.systemd.Login.Subscribe(), and the changes to send to them next */
+        Set *varlink_subscriptions;
+        sd_json_variant *varlink_changed_sessions, *varlink_changed_users;
+        sd_json_variant *varlink_removed_sessions, *varlink_removed_users;
 };
 
 void manager_reset_config(Manager *m);
@@ -164,6 +171,8 @@ int manager_add_user_by_name(Manager *m, const char *name, User **ret_user);
 int manager_add_user_by_uid(Manager *m, uid_t uid, User **ret_user);
 int manager_add_inhibitor(Manager *m, const char* id, Inhibitor **ret_inhibitor);
 
+void manager_dispatch_save_queue(Manager *m);
+
 int manager_process_seat_device(Manager *m, sd_device *d);
 int manager_process_button_device(Manager *m, sd_device *d);
 
@@ -855,7 +855,9 @@ static int vl_method_mount_directory(
                 if (r < 0)
                         return r;
 
-                _cleanup_close_ int idmap_userns_fd = userns_acquire(new_uid_map, new_uid_map);
+                /* Workers serve many requests, and typically the same image directory is mounted for the
+                 * same user namespace range over and over again, hence reuse the ID mapping user namespace */
+                _cleanup_close_ int idmap_userns_fd = userns_acquire_cached(new_uid_map, new_uid_map);
                 if (idmap_userns_fd < 0)
                         return log_debug_errno(idmap_userns_fd, "Failed to acquire user namespace for id mapping: %m");
 
@@ -0,0 +1,268 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "format-table.h"
+#include "json-util.h"
+#include "networkctl.h"
+#include "networkctl-statistics.h"
+#include "networkctl-util.h"
+#include "time-util.h"
+#include "varlink-util.h"
+
+typedef struct LinkObjectCounts {
+        int ifindex;
+        const char *ifname;
+        uint64_t n_addresses;
+        uint64_t n_neighbors;
+        uint64_t n_routes;
+        uint64_t n_requests;
+} LinkObjectCounts;
+
+static const sd_json_dispatch_field link_object_counts_dispatch_table[] = {
+        { "InterfaceIndex", _SD_JSON_VARIANT_TYPE_INVALID, json_dispatch_ifindex,         offsetof(LinkObjectCounts, ifindex),     SD_JSON_MANDATORY|SD_JSON_RELAX },
+        { "InterfaceName",  SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(LinkObjectCounts, ifname),      SD_JSON_MANDATORY               },
+        { "Addresses",      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(LinkObjectCounts, n_addresses), 0                               },
+        { "Neighbors",      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(LinkObjectCounts, n_neighbors), 0                               },
+        { "Routes",         _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(LinkObjectCounts, n_routes),    0                               },
+        { "Requests",       _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(LinkObjectCounts, n_requests),  0                               },
+        {},
+};
+
+typedef struct RequestTypeStatistics {
+        const char *type;
+        uint64_t queued;
+        uint64_t processed;
+} RequestTypeStatistics;
+
+static const sd_json_dispatch_field request_type_statistics_dispatch_table[] = {
+        { "Type",      SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(RequestTypeStatistics, type),      SD_JSON_MANDATORY },
+        { "Queued",    _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(RequestTypeStatistics, queued),    0                 },
+        { "Processed", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(RequestTypeStatistics, processed), 0                 },
+        {},
+};
+
+typedef struct NetlinkMessageStatistics {
+        unsigned type;
+        const char *name;
+        uint64_t received;
+        uint64_t sent;
+} NetlinkMessageStatistics;
+
+static const sd_json_dispatch_field netlink_message_statistics_dispatch_table[] = {
+        { "Type",     _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint,         offsetof(NetlinkMessageStatistics, type),     SD_JSON_MANDATORY },
+        { "Name",     SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(NetlinkMessageStatistics, name),     0                 },
+        { "Received", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(NetlinkMessageStatistics, received), 0                 },
+        { "Sent",     _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(NetlinkMessageStatistics, sent),     0                 },
+        {},
+};
+
+static void statistics_table_setup(Table *table) {
+        assert(table);
+
+        if (arg_full)
+                table_set_width(table, 0);
+
+        table_set_header(table, arg_legend);
+        table_set_ersatz_string(table, TABLE_ERSATZ_DASH);
+}
+
+static int statistics_table_print(Table *table) {
+        int r;
+
+        r = table_print(table, NULL);
+        if (r < 0)
+                return table_log_print_error(r);
+
+        return 0;
+}
+
+static int dump_links(sd_json_variant *reply) {
+        _cleanup_(table_unrefp) Table *table = NULL;
+        sd_json_variant *i;
+        int r;
+
+        table = table_new("idx", "link", "addresses", "neighbors", "routes", "requests");
+        if (!table)
+                return log_oom();
+
+        statistics_table_setup(table);
+
+        table_set_sort(table, (size_t) 0);
+        (void) table_set_align_percent(table, table_get_cell(table, 0, 0), 100);
+
+        JSON_VARIANT_ARRAY_FOREACH(i, sd_json_variant_by_key(reply, "Links")) {
+                LinkObjectCounts c = {};
+
+                r = sd_json_dispatch(i, link_object_counts_dispatch_table, SD_JSON_LOG|SD_JSON_ALLOW_EXTENSIONS, &c);
+                if (r < 0)
+                        return r;
+
+                r = table_add_many(table,
+                                   TABLE_INT,    c.ifindex,
+                                   TABLE_STRING, c.ifname,
+                                   TABLE_UINT64, c.n_addresses,
+                                   TABLE_UINT64, c.n_neighbors,
+                                   TABLE_UINT64, c.n_routes,
+                                   TABLE_UINT64, c.n_requests);
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
+
+        return statistics_table_print(table);
+}
+
+static int dump_requests(sd_json_variant *reply) {
+        _cleanup_(table_unrefp) Table *table = NULL;
+        sd_json_variant *i;
+        int r;
+
+        table = table_new("request", "queued", "processed");
+        if (!table)
+                return log_oom();
+
+        statistics_table_setup(table);
+
+        JSON_VARIANT_ARRAY_FOREACH(i, sd_json_variant_by_key(reply, "Requests")) {
+                RequestTypeStatistics s = {};
+
+                r = sd_json_dispatch(i, request_type_statistics_dispatch_table, SD_JSON_LOG|SD_JSON_ALLOW_EXTENSIONS, &s);
+                if (r < 0)
+                        return r;
+
+                r = table_add_many(table,
+                                   TABLE_STRING, s.type,
+                                   TABLE_UINT64, s.queued,
+                                   TABLE_UINT64, s.processed);
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
+
+        return statistics_table_print(table);
+}
+
+static int dump_request_wait_histogram(sd_json_variant *reply) {
+        _cleanup_(table_unrefp) Table *table = NULL;
+        sd_json_variant *histogram, *i;
+        unsigned k = 0;
+        size_t n_buckets;
+        int r;
+
+        table = table_new("wait", "requests");
+        if (!table)
+                return log_oom();
+
+        statistics_table_setup(table);
+
+        (void) table_set_align_percent(table, table_get_cell(table, 0, 0), 100);
+
+        /* Bucket k holds requests that waited for [2^(k-1), 2^k) milliseconds, bucket 0 those that were
+         * processed within a millisecond, and the last bucket everything beyond. */
+        histogram = sd_json_variant_by_key(reply, "RequestWaitHistogram");
+        n_buckets = sd_json_variant_elements(histogram);
+
+        JSON_VARIANT_ARRAY_FOREACH(i, histogram) {
+                uint64_t n = sd_json_variant_unsigned(i);
+                bool last = k + 1 >= n_buckets;
+
+                if (n > 0) {
+                        r = table_add_many(table,
+                                           TABLE_STRING, strjoina(last && k > 0 ? ">= " : "< ",
+                                                                  FORMAT_TIMESPAN((UINT64_C(1) << (last && k > 0 ? k - 1 : k)) * USEC_PER_MSEC, USEC_PER_MSEC)),
+                                           TABLE_UINT64, n);
+                        if (r < 0)
+                                return table_log_add_error(r);
+                }
+
+                k++;
+        }
+
+        return statistics_table_print(table);
+}
+
+static int dump_netlink_messages(sd_json_variant *reply) {
+        _cleanup_(table_unrefp) Table *table = NULL;
+        sd_json_variant *i;
+        int r;
+
+        table = table_new("type", "message", "received", "sent");
+        if (!table)
+                return log_oom();
+
+        statistics_table_setup(table);
+
+        table_set_sort(table, (size_t) 0);
+        table_hide_column_from_display(table, (size_t) 0);
+
+        JSON_VARIANT_ARRAY_FOREACH(i, sd_json_variant_by_key(reply, "NetlinkMessages")) {
+                NetlinkMessageStatistics s = {};
+
+                r = sd_json_dispatch(i, netlink_message_statistics_dispatch_table, SD_JSON_LOG|SD_JSON_ALLOW_EXTENSIONS, &s);
+                if (r < 0)
+                        return r;
+
+                r = table_add_many(table,
+                                   TABLE_UINT,   s.type,
+                                   TABLE_STRING, s.name,
+                                   TABLE_UINT64, s.received,
+                                   TABLE_UINT64, s.sent);
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
+
+        return statistics_table_print(table);
+}
+
+int verb_statistics(int argc, char *argv[], void *userdata) {
+        _cleanup_(sd_varlink_flush_close_unrefp) sd_varlink *vl = NULL;
+        sd_json_variant *reply, *v;
+        int r;
+
+        r = varlink_connect_networkd(&vl);
+        if (r < 0)
+                return r;
+
+        r = varlink_call_and_log(vl, "io.systemd.Network.GetDaemonStatistics", /* parameters= */ NULL, &reply);
+        if (r < 0)
+                return r;
+
+        if (sd_json_format_enabled(arg_json_format_flags))
+                return sd_json_variant_dump(reply, arg_json_format_flags, NULL, NULL);
+
+        pager_open(arg_pager_flags);
+
+        r = dump_links(reply);
+        if (r < 0)
+                return r;
+        putchar('\n');
+
+        r = dump_requests(reply);
+        if (r < 0)
+                return r;
+        putchar('\n');
+
+        r = dump_request_wait_histogram(reply);
+        if (r < 0)
+                return r;
+        putchar('\n');
+
+        r = dump_netlink_messages(reply);
+        if (r < 0)
+                return r;
+
+        if (!arg_legend)
+                return 0;
+
+        printf("\nPending requests: %" PRIu64 "\n",
+               sd_json_variant_unsigned(sd_json_variant_by_key(reply, "PendingRequests")));
+        printf("Reloads: %" PRIu64 "\n",
+               sd_json_variant_unsigned(sd_json_variant_by_key(reply, "Reloads")));
+
+        v = sd_json_variant_by_key(reply, "LastReloadUSec");
+        if (v)
+                printf("Last reload took: %s\n", FORMAT_TIMESPAN(sd_json_variant_unsigned(v), USEC_PER_MSEC));
+
+        v = sd_json_variant_by_key(reply, "MaxReloadUSec");
+        if (v)
+                printf("Slowest reload took: %s\n", FORMAT_TIMESPAN(sd_json_variant_unsigned(v), USEC_PER_MSEC));
+
+        return 0;
+}
@@ -11,6 +11,7 @@
 #include "networkctl-list.h"
 #include "networkctl-lldp.h"
 #include "networkctl-misc.h"
+#include "networkctl-statistics.h"
 #include "networkctl-status-link.h"
 #include "networkctl-util.h"
 #include "parse-argument.h"
@@ -62,6 +63,7 @@ static int help(void) {
                "  unmask FILES...        Unmask network configuration files\n"
                "  persistent-storage BOOL\n"
                "                         Notify systemd-networkd if persistent storage is ready\n"
+               "  stats                  Show internal statistics of systemd-networkd\n"
                "\nOptions:\n"
                "  -h --help              Show this help\n"
                "     --version           Show package version\n"
@@ -235,6 +237,7 @@ static int networkctl_main(int argc, char *argv[]) {
                 { "mask",               2,        VERB_ANY, 0,                             verb_mask               },
                 { "unmask",             2,        VERB_ANY, 0,                             verb_unmask             },
                 { "persistent-storage", 2,        2,        0,                             verb_persistent_storage },
+                { "stats",              1,        1,        0,                             verb_statistics         },
                 {}
         };
 
@@ -1671,6 +1671,12 @@ static int dhcp4_configure(Link *link) {
                         return log_link_debug_errno(link, r, "DHCPv4 CLIENT: Failed to set max attempts: %m");
         }
 
+        if (link->network->dhcp_randomized_delay_usec > 0) {
+                r = sd_dhcp_client_set_randomized_delay(link->dhcp_client, link->network->dhcp_randomized_delay_usec);
+                if (r < 0)
+                        return log_link_debug_errno(link, r, "DHCPv4 CLIENT: Failed to set randomized delay: %m");
+        }
+
         if (link->network->dhcp_ip_service_type >= 0) {
                 r = sd_dhcp_client_set_service_type(link->dhcp_client, link->network->dhcp_ip_service_type);
                 if (r < 0)
@@ -1575,6 +1575,14 @@ int manager_build_json(Manager *manager, sd_json_variant **ret) {
         if (r < 0)
                 return r;
 
+        if (!set_isempty(manager->ignore_foreign_route_protocols)) {
+                r = sd_json_variant_merge_objectbo(
+                                &v,
+                                SD_JSON_BUILD_PAIR_UNSIGNED("IgnoredForeignRoutes", manager->n_ignored_foreign_routes));
+                if (r < 0)
+                        return r;
+        }
+
         *ret = TAKE_PTR(v);
         return 0;
 }
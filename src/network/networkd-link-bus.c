@@ -15,6 +15,7 @@
 #include "networkd-link-bus.h"
 #include "networkd-link.h"
 #include "networkd-manager.h"
+#include "networkd-speed-meter.h"
 #include "networkd-state-file.h"
 #include "parse-util.h"
 #include "resolve-util.h"
@@ -38,33 +39,14 @@ static int property_get_bit_rates(
                 sd_bus_error *error) {
 
         Link *link = ASSERT_PTR(userdata);
-        Manager *manager;
-        double interval_sec;
         uint64_t tx, rx;
 
         assert(bus);
         assert(reply);
 
-        manager = link->manager;
-
-        if (!manager->use_speed_meter ||
-            manager->speed_meter_usec_old == 0 ||
-            !link->stats_updated)
+        if (link_get_bit_rates(link, &tx, &rx) < 0)
                 return sd_bus_message_append(reply, "(tt)", UINT64_MAX, UINT64_MAX);
 
-        assert(manager->speed_meter_usec_new > manager->speed_meter_usec_old);
-        interval_sec = (manager->speed_meter_usec_new - manager->speed_meter_usec_old) / USEC_PER_SEC;
-
-        if (link->stats_new.tx_bytes > link->stats_old.tx_bytes)
-                tx = (uint64_t) ((link->stats_new.tx_bytes - link->stats_old.tx_bytes) / interval_sec);
-        else
-                tx = (uint64_t) ((UINT64_MAX - (link->stats_old.tx_bytes - link->stats_new.tx_bytes)) / interval_sec);
-
-        if (link->stats_new.rx_bytes > link->stats_old.rx_bytes)
-                rx = (uint64_t) ((link->stats_new.rx_bytes - link->stats_old.rx_bytes) / interval_sec);
-        else
-                rx = (uint64_t) ((UINT64_MAX - (link->stats_old.rx_bytes - link->stats_new.rx_bytes)) / interval_sec);
-
         return sd_bus_message_append(reply, "(tt)", tx, rx);
 }
 
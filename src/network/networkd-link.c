@@ -1572,6 +1572,31 @@ failed:
         return r;
 }
 
+int link_reload(Link *link, sd_bus_message *message, unsigned *counter) {
+        Network *network;
+        int r;
+
+        assert(link);
+        assert(link->manager);
+
+        /* Called after .netdev and .network files are reloaded. network_reload() keeps the existing Network
+         * objects of unchanged files, hence for most interfaces the matching .network file is the same as
+         * before, and link_reconfigure_impl() would do nothing. Let's not even refresh the interface
+         * information for them, that would only cost a netlink roundtrip per interface. Interfaces in the
+         * failed state are reconfigured unconditionally, as before. */
+        if (IN_SET(link->state, LINK_STATE_CONFIGURING, LINK_STATE_CONFIGURED, LINK_STATE_UNMANAGED)) {
+                r = link_get_network(link, &network);
+                if (r == -ENOENT && !link->network)
+                        return 0;
+                if (r >= 0 && network == link->network) {
+                        log_link_debug(link, "Matching .network file is unchanged, not reconfiguring.");
+                        return 0;
+                }
+        }
+
+        return link_reconfigure_full(link, /* flags = */ 0, message, counter);
+}
+
 static int link_initialized_and_synced(Link *link) {
         int r;
 
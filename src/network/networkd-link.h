@@ -270,6 +270,7 @@ int link_reconfigure_full(Link *link, LinkReconfigurationFlag flags, sd_bus_mess
 static inline int link_reconfigure(Link *link, LinkReconfigurationFlag flags) {
         return link_reconfigure_full(link, flags, NULL, NULL);
 }
+int link_reload(Link *link, sd_bus_message *message, unsigned *counter);
 
 int link_check_initialized(Link *link);
 
@@ -8,9 +8,15 @@
 #include "fd-util.h"
 #include "json-util.h"
 #include "lldp-rx-internal.h"
+#include "metrics.h"
 #include "networkd-dhcp-server.h"
 #include "networkd-manager-varlink.h"
+#include "networkd-queue.h"
+#include "networkd-route.h"
+#include "networkd-speed-meter.h"
 #include "stat-util.h"
+#include "string-table.h"
+#include "varlink-io.systemd.Metrics.h"
 #include "varlink-io.systemd.Network.h"
 #include "varlink-io.systemd.service.h"
 #include "varlink-util.h"
@@ -254,6 +260,406 @@ static int vl_method_set_persistent_storage(sd_varlink *vlink, sd_json_variant *
         return sd_varlink_reply(vlink, NULL);
 }
 
+static int link_append_online_state(Link *link, sd_json_variant **array) {
+        _cleanup_free_ char *required_operstate = NULL;
+        const char *required_family = NULL;
+
+        assert(link);
+        assert(array);
+
+        /* Carries the same information as the ONLINE related fields of the link state file, so that
+         * clients like systemd-networkd-wait-online can follow them without rereading the files. */
+
+        if (link->network) {
+                LinkOperationalStateRange st;
+
+                link_required_operstate_for_online(link, &st);
+
+                if (asprintf(&required_operstate, "%s:%s",
+                             link_operstate_to_string(st.min), link_operstate_to_string(st.max)) < 0)
+                        return -ENOMEM;
+
+                required_family = link_required_address_family_to_string(link_required_family_for_online(link));
+        }
+
+        return sd_json_variant_append_arraybo(
+                        array,
+                        SD_JSON_BUILD_PAIR_INTEGER("InterfaceIndex", link->ifindex),
+                        SD_JSON_BUILD_PAIR_STRING("SetupState", link_state_to_string(link->state)),
+                        SD_JSON_BUILD_PAIR_STRING("OperationalState", link_operstate_to_string(link->operstate)),
+                        SD_JSON_BUILD_PAIR_STRING("IPv4AddressState", link_address_state_to_string(link->ipv4_address_state)),
+                        SD_JSON_BUILD_PAIR_STRING("IPv6AddressState", link_address_state_to_string(link->ipv6_address_state)),
+                        SD_JSON_BUILD_PAIR_CONDITION(!!link->network, "RequiredForOnline",
+                                                     SD_JSON_BUILD_BOOLEAN(link->network && link->network->required_for_online)),
+                        JSON_BUILD_PAIR_STRING_NON_EMPTY("RequiredOperationalStateForOnline", required_operstate),
+                        JSON_BUILD_PAIR_STRING_NON_EMPTY("RequiredFamilyForOnline", required_family));
+}
+
+static int vl_method_subscribe_link_states(sd_varlink *vlink, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *array = NULL;
+        Manager *manager = ASSERT_PTR(userdata);
+        Link *link;
+        int r;
+
+        assert(vlink);
+
+        /* if the client didn't set the more flag, it is using us incorrectly */
+        if (!FLAGS_SET(flags, SD_VARLINK_METHOD_MORE))
+                return sd_varlink_error(vlink, SD_VARLINK_ERROR_EXPECTED_MORE, NULL);
+
+        r = sd_varlink_dispatch(vlink, parameters, /* dispatch_table = */ NULL, /* userdata = */ NULL);
+        if (r != 0)
+                return r;
+
+        HASHMAP_FOREACH(link, manager->links_by_index) {
+                if (link->state == LINK_STATE_LINGER)
+                        continue;
+
+                r = link_append_online_state(link, &array);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_varlink_notifybo(
+                        vlink,
+                        SD_JSON_BUILD_PAIR_CONDITION(sd_json_variant_is_blank_array(array), "Links", SD_JSON_BUILD_EMPTY_ARRAY),
+                        SD_JSON_BUILD_PAIR_CONDITION(!sd_json_variant_is_blank_array(array), "Links", SD_JSON_BUILD_VARIANT(array)));
+        if (r < 0)
+                return r;
+
+        r = set_ensure_put(&manager->varlink_link_state_subscriptions, NULL, vlink);
+        if (r < 0)
+                return r;
+        sd_varlink_ref(vlink);
+
+        log_debug("%u clients now subscribed to link state changes",
+                  set_size(manager->varlink_link_state_subscriptions));
+        return 1;
+}
+
+static int link_append_statistics(Link *link, sd_json_variant **array) {
+        uint64_t tx, rx;
+        bool has_rates;
+
+        assert(link);
+        assert(array);
+
+        has_rates = link_get_bit_rates(link, &tx, &rx) >= 0;
+
+        return sd_json_variant_append_arraybo(
+                        array,
+                        SD_JSON_BUILD_PAIR_INTEGER("InterfaceIndex", link->ifindex),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("RxBytes", link->stats_new.rx_bytes),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("TxBytes", link->stats_new.tx_bytes),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("RxPackets", link->stats_new.rx_packets),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("TxPackets", link->stats_new.tx_packets),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("RxErrors", link->stats_new.rx_errors),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("TxErrors", link->stats_new.tx_errors),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("RxDropped", link->stats_new.rx_dropped),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("TxDropped", link->stats_new.tx_dropped),
+                        SD_JSON_BUILD_PAIR_CONDITION(has_rates, "RxBitRate", SD_JSON_BUILD_UNSIGNED(rx)),
+                        SD_JSON_BUILD_PAIR_CONDITION(has_rates, "TxBitRate", SD_JSON_BUILD_UNSIGNED(tx)));
+}
+
+static int vl_method_get_link_statistics(sd_varlink *vlink, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *array = NULL;
+        Manager *manager = ASSERT_PTR(userdata);
+        Link *link;
+        int r;
+
+        assert(vlink);
+
+        r = sd_varlink_dispatch(vlink, parameters, /* dispatch_table = */ NULL, /* userdata = */ NULL);
+        if (r != 0)
+                return r;
+
+        /* The counters are only collected by the speed meter, we do not query the kernel here. */
+        if (!manager->use_speed_meter)
+                return sd_varlink_error(vlink, "io.systemd.Network.SpeedMeterDisabled", NULL);
+
+        HASHMAP_FOREACH(link, manager->links_by_index) {
+                if (!link->stats_updated)
+                        continue;
+
+                r = link_append_statistics(link, &array);
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_varlink_replybo(
+                        vlink,
+                        SD_JSON_BUILD_PAIR_CONDITION(manager->speed_meter_usec_new > 0, "Timestamp",
+                                                     SD_JSON_BUILD_UNSIGNED(manager->speed_meter_usec_new)),
+                        SD_JSON_BUILD_PAIR_CONDITION(sd_json_variant_is_blank_array(array), "Links", SD_JSON_BUILD_EMPTY_ARRAY),
+                        SD_JSON_BUILD_PAIR_CONDITION(!sd_json_variant_is_blank_array(array), "Links", SD_JSON_BUILD_VARIANT(array)));
+}
+
+static const char* const rtnl_message_type_table[RTM_MAX + 1] = {
+        [RTM_NEWLINK]      = "RTM_NEWLINK",
+        [RTM_DELLINK]      = "RTM_DELLINK",
+        [RTM_GETLINK]      = "RTM_GETLINK",
+        [RTM_SETLINK]      = "RTM_SETLINK",
+        [RTM_NEWADDR]      = "RTM_NEWADDR",
+        [RTM_DELADDR]      = "RTM_DELADDR",
+        [RTM_NEWROUTE]     = "RTM_NEWROUTE",
+        [RTM_DELROUTE]     = "RTM_DELROUTE",
+        [RTM_NEWNEIGH]     = "RTM_NEWNEIGH",
+        [RTM_DELNEIGH]     = "RTM_DELNEIGH",
+        [RTM_NEWRULE]      = "RTM_NEWRULE",
+        [RTM_DELRULE]      = "RTM_DELRULE",
+        [RTM_NEWQDISC]     = "RTM_NEWQDISC",
+        [RTM_DELQDISC]     = "RTM_DELQDISC",
+        [RTM_NEWTCLASS]    = "RTM_NEWTCLASS",
+        [RTM_DELTCLASS]    = "RTM_DELTCLASS",
+        [RTM_NEWADDRLABEL] = "RTM_NEWADDRLABEL",
+        [RTM_NEWMDB]       = "RTM_NEWMDB",
+        [RTM_NEWNEXTHOP]   = "RTM_NEWNEXTHOP",
+        [RTM_DELNEXTHOP]   = "RTM_DELNEXTHOP",
+        [RTM_NEWLINKPROP]  = "RTM_NEWLINKPROP",
+        [RTM_DELLINKPROP]  = "RTM_DELLINKPROP",
+};
+
+DEFINE_PRIVATE_STRING_TABLE_LOOKUP_TO_STRING(rtnl_message_type, uint16_t);
+
+static int vl_method_get_daemon_statistics(sd_varlink *vlink, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *links = NULL, *requests = NULL, *histogram = NULL, *messages = NULL;
+        _cleanup_hashmap_free_ Hashmap *n_routes = NULL, *n_requests = NULL;
+        Manager *manager = ASSERT_PTR(userdata);
+        ManagerStatistics *stats = &manager->stats;
+        Request *req;
+        Route *route;
+        Link *link;
+        int r;
+
+        assert(vlink);
+
+        r = sd_varlink_dispatch(vlink, parameters, /* dispatch_table = */ NULL, /* userdata = */ NULL);
+        if (r != 0)
+                return r;
+
+        /* Routes and requests are owned by the manager, hence count them per link in one pass each,
+         * rather than walking them once for every link. */
+        SET_FOREACH(route, manager->routes) {
+                if (route->nexthop.ifindex <= 0)
+                        continue;
+
+                r = hashmap_ensure_replace(&n_routes, NULL, INT_TO_PTR(route->nexthop.ifindex),
+                                           UINT_TO_PTR(PTR_TO_UINT(hashmap_get(n_routes, INT_TO_PTR(route->nexthop.ifindex))) + 1));
+                if (r < 0)
+                        return r;
+        }
+
+        ORDERED_SET_FOREACH(req, manager->request_queue) {
+                if (!req->link)
+                        continue;
+
+                r = hashmap_ensure_replace(&n_requests, NULL, INT_TO_PTR(req->link->ifindex),
+                                           UINT_TO_PTR(PTR_TO_UINT(hashmap_get(n_requests, INT_TO_PTR(req->link->ifindex))) + 1));
+                if (r < 0)
+                        return r;
+        }
+
+        HASHMAP_FOREACH(link, manager->links_by_index) {
+                r = sd_json_variant_append_arraybo(
+                                &links,
+                                SD_JSON_BUILD_PAIR_INTEGER("InterfaceIndex", link->ifindex),
+                                SD_JSON_BUILD_PAIR_STRING("InterfaceName", link->ifname),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Addresses", set_size(link->addresses)),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Neighbors", set_size(link->neighbors)),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Routes", PTR_TO_UINT(hashmap_get(n_routes, INT_TO_PTR(link->ifindex)))),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Requests", PTR_TO_UINT(hashmap_get(n_requests, INT_TO_PTR(link->ifindex)))));
+                if (r < 0)
+                        return r;
+        }
+
+        for (RequestType t = 0; t < _REQUEST_TYPE_MAX; t++) {
+                if (stats->requests_queued[t] == 0)
+                        continue;
+
+                r = sd_json_variant_append_arraybo(
+                                &requests,
+                                SD_JSON_BUILD_PAIR_STRING("Type", request_type_to_string(t)),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Queued", stats->requests_queued[t]),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Processed", stats->requests_processed[t]));
+                if (r < 0)
+                        return r;
+        }
+
+        FOREACH_ELEMENT(n, stats->request_wait_histogram.buckets) {
+                r = sd_json_variant_append_arrayb(&histogram, SD_JSON_BUILD_UNSIGNED(*n));
+                if (r < 0)
+                        return r;
+        }
+
+        for (uint16_t t = 0; t <= RTM_MAX; t++) {
+                if (stats->rtnl_received[t] == 0 && stats->rtnl_sent[t] == 0)
+                        continue;
+
+                r = sd_json_variant_append_arraybo(
+                                &messages,
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Type", t),
+                                JSON_BUILD_PAIR_STRING_NON_EMPTY("Name", rtnl_message_type_to_string(t)),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Received", stats->rtnl_received[t]),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("Sent", stats->rtnl_sent[t]));
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_varlink_replybo(
+                        vlink,
+                        SD_JSON_BUILD_PAIR_CONDITION(sd_json_variant_is_blank_array(links), "Links", SD_JSON_BUILD_EMPTY_ARRAY),
+                        SD_JSON_BUILD_PAIR_CONDITION(!sd_json_variant_is_blank_array(links), "Links", SD_JSON_BUILD_VARIANT(links)),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("PendingRequests", ordered_set_size(manager->request_queue)),
+                        SD_JSON_BUILD_PAIR_CONDITION(sd_json_variant_is_blank_array(requests), "Requests", SD_JSON_BUILD_EMPTY_ARRAY),
+                        SD_JSON_BUILD_PAIR_CONDITION(!sd_json_variant_is_blank_array(requests), "Requests", SD_JSON_BUILD_VARIANT(requests)),
+                        SD_JSON_BUILD_PAIR_VARIANT("RequestWaitHistogram", histogram),
+                        SD_JSON_BUILD_PAIR_CONDITION(sd_json_variant_is_blank_array(messages), "NetlinkMessages", SD_JSON_BUILD_EMPTY_ARRAY),
+                        SD_JSON_BUILD_PAIR_CONDITION(!sd_json_variant_is_blank_array(messages), "NetlinkMessages", SD_JSON_BUILD_VARIANT(messages)),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("Reloads", stats->n_reloads),
+                        SD_JSON_BUILD_PAIR_CONDITION(stats->n_reloads > 0, "LastReloadUSec", SD_JSON_BUILD_UNSIGNED(stats->last_reload_usec)),
+                        SD_JSON_BUILD_PAIR_CONDITION(stats->n_reloads > 0, "MaxReloadUSec", SD_JSON_BUILD_UNSIGNED(stats->max_reload_usec)));
+}
+
+static int metric_links(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, hashmap_size(manager->links_by_index));
+}
+
+static int metric_pending_requests(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, ordered_set_size(manager->request_queue));
+}
+
+static int metric_requests_queued(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+        int r;
+
+        for (RequestType t = 0; t < _REQUEST_TYPE_MAX; t++) {
+                if (manager->stats.requests_queued[t] == 0)
+                        continue;
+
+                r = metric_append_value(array, f, "type", request_type_to_string(t), manager->stats.requests_queued[t]);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int metric_requests_processed(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+        int r;
+
+        for (RequestType t = 0; t < _REQUEST_TYPE_MAX; t++) {
+                if (manager->stats.requests_queued[t] == 0)
+                        continue;
+
+                r = metric_append_value(array, f, "type", request_type_to_string(t), manager->stats.requests_processed[t]);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int metric_request_wait(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+
+        return metric_append_histogram(array, f, NULL, NULL, &manager->stats.request_wait_histogram);
+}
+
+static int metric_netlink_messages(const MetricFamily *f, const uint64_t counters[static RTM_MAX + 1], sd_json_variant **array) {
+        int r;
+
+        for (uint16_t t = 0; t <= RTM_MAX; t++) {
+                const char *name;
+
+                if (counters[t] == 0)
+                        continue;
+
+                name = rtnl_message_type_to_string(t);
+                if (!name)
+                        continue;
+
+                r = metric_append_value(array, f, "type", name, counters[t]);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int metric_netlink_messages_received(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+
+        return metric_netlink_messages(f, manager->stats.rtnl_received, array);
+}
+
+static int metric_netlink_messages_sent(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+
+        return metric_netlink_messages(f, manager->stats.rtnl_sent, array);
+}
+
+static int metric_reloads(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, manager->stats.n_reloads);
+}
+
+static const MetricFamily manager_metric_families[] = {
+        { "io.systemd.Network.Links",                        "Network interfaces known",                               METRIC_GAUGE,     metric_links                     },
+        { "io.systemd.Network.PendingRequests",              "Requests currently queued",                              METRIC_GAUGE,     metric_pending_requests          },
+        { "io.systemd.Network.RequestsQueuedTotal",          "Requests queued, by request type",                       METRIC_COUNTER,   metric_requests_queued           },
+        { "io.systemd.Network.RequestsProcessedTotal",       "Requests processed, by request type",                    METRIC_COUNTER,   metric_requests_processed        },
+        { "io.systemd.Network.RequestWaitMSec",              "Time requests waited in the queue, in ms",               METRIC_HISTOGRAM, metric_request_wait              },
+        { "io.systemd.Network.NetlinkMessagesReceivedTotal", "rtnetlink notifications received, by message type",      METRIC_COUNTER,   metric_netlink_messages_received },
+        { "io.systemd.Network.NetlinkMessagesSentTotal",     "rtnetlink messages sent, by message type",               METRIC_COUNTER,   metric_netlink_messages_sent     },
+        { "io.systemd.Network.ReloadsTotal",                 "Reloads of the configuration",                           METRIC_COUNTER,   metric_reloads                   },
+        {}
+};
+
+static int vl_method_list_metrics(sd_varlink *vlink, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_list(vlink, parameters, manager_metric_families, userdata);
+}
+
+static int vl_method_describe_metrics(sd_varlink *vlink, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_describe(vlink, parameters, manager_metric_families);
+}
+
+int manager_varlink_notify_link_state(Manager *m, Link *link) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *array = NULL;
+        int r;
+
+        assert(m);
+        assert(link);
+
+        /* Only the link that changed is sent, hence subscribers do work proportional to the number of
+         * changes rather than to the number of links. */
+
+        if (set_isempty(m->varlink_link_state_subscriptions) || link->state == LINK_STATE_LINGER)
+                return 0;
+
+        r = link_append_online_state(link, &array);
+        if (r < 0)
+                return r;
+
+        return varlink_many_notifybo(
+                        m->varlink_link_state_subscriptions,
+                        SD_JSON_BUILD_PAIR_VARIANT("Links", array));
+}
+
+static void vl_on_disconnect(sd_varlink_server *s, sd_varlink *vlink, void *userdata) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        assert(s);
+        assert(vlink);
+
+        sd_varlink_unref(set_remove(m->varlink_link_state_subscriptions, vlink));
+}
+
 int manager_connect_varlink(Manager *m) {
         _cleanup_(sd_varlink_server_unrefp) sd_varlink_server *s = NULL;
         int r;
@@ -276,6 +682,7 @@ int manager_connect_varlink(Manager *m) {
         r = sd_varlink_server_add_interface_many(
                         s,
                         &vl_interface_io_systemd_Network,
+                        &vl_interface_io_systemd_Metrics,
                         &vl_interface_io_systemd_service);
         if (r < 0)
                 return log_error_errno(r, "Failed to add Network interface to varlink server: %m");
@@ -286,12 +693,21 @@ int manager_connect_varlink(Manager *m) {
                         "io.systemd.Network.GetNamespaceId",       vl_method_get_namespace_id,
                         "io.systemd.Network.GetLLDPNeighbors",     vl_method_get_lldp_neighbors,
                         "io.systemd.Network.SetPersistentStorage", vl_method_set_persistent_storage,
+                        "io.systemd.Network.SubscribeLinkStates",  vl_method_subscribe_link_states,
+                        "io.systemd.Network.GetLinkStatistics",    vl_method_get_link_statistics,
+                        "io.systemd.Network.GetDaemonStatistics",  vl_method_get_daemon_statistics,
+                        "io.systemd.Metrics.List",                 vl_method_list_metrics,
+                        "io.systemd.Metrics.Describe",             vl_method_describe_metrics,
                         "io.systemd.service.Ping",                 varlink_method_ping,
                         "io.systemd.service.SetLogLevel",          varlink_method_set_log_level,
                         "io.systemd.service.GetEnvironment",       varlink_method_get_environment);
         if (r < 0)
                 return log_error_errno(r, "Failed to register varlink methods: %m");
 
+        r = sd_varlink_server_bind_disconnect(s, vl_on_disconnect);
+        if (r < 0)
+                return log_error_errno(r, "Failed to register varlink disconnect handler: %m");
+
         r = sd_varlink_server_listen_address(s, "/run/systemd/netif/io.systemd.Network", 0666);
         if (r < 0)
                 return log_error_errno(r, "Failed to bind to varlink socket: %m");
@@ -308,5 +724,6 @@ void manager_varlink_done(Manager *m) {
         assert(m);
 
         m->varlink_server = sd_varlink_server_unref(m->varlink_server);
+        m->varlink_link_state_subscriptions = set_free(m->varlink_link_state_subscriptions);
         (void) unlink("/run/systemd/netif/io.systemd.Network");
 }
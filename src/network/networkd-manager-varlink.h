@@ -5,3 +5,5 @@
 
 int manager_connect_varlink(Manager *m);
 void manager_varlink_done(Manager *m);
+
+int manager_varlink_notify_link_state(Manager *m, Link *link);
@@ -325,6 +325,73 @@ static int manager_setup_rtnl_filter(Manager *manager) {
         return sd_netlink_attach_filter(manager->rtnl, ELEMENTSOF(filter), filter);
 }
 
+static const uint16_t rtnl_message_types[] = {
+        RTM_NEWLINK,
+        RTM_DELLINK,
+        RTM_NEWQDISC,
+        RTM_DELQDISC,
+        RTM_NEWTCLASS,
+        RTM_DELTCLASS,
+        RTM_NEWADDR,
+        RTM_DELADDR,
+        RTM_NEWNEIGH,
+        RTM_DELNEIGH,
+        RTM_NEWROUTE,
+        RTM_DELROUTE,
+        RTM_NEWRULE,
+        RTM_DELRULE,
+        RTM_NEWNEXTHOP,
+        RTM_DELNEXTHOP,
+};
+
+static int manager_rtnl_process_message(sd_netlink *rtnl, sd_netlink_message *message, Manager *m) {
+        uint16_t type;
+        int r;
+
+        assert(rtnl);
+        assert(message);
+        assert(m);
+
+        r = sd_netlink_message_get_type(message, &type);
+        if (r < 0) {
+                log_warning_errno(r, "rtnl: could not get message type, ignoring: %m");
+                return 0;
+        }
+
+        /* Count notifications per type, so that it can be seen what keeps us busy. */
+        if (type < ELEMENTSOF(m->stats.rtnl_received))
+                m->stats.rtnl_received[type]++;
+
+        switch (type) {
+        case RTM_NEWLINK:
+        case RTM_DELLINK:
+                return manager_rtnl_process_link(rtnl, message, m);
+        case RTM_NEWQDISC:
+        case RTM_DELQDISC:
+                return manager_rtnl_process_qdisc(rtnl, message, m);
+        case RTM_NEWTCLASS:
+        case RTM_DELTCLASS:
+                return manager_rtnl_process_tclass(rtnl, message, m);
+        case RTM_NEWADDR:
+        case RTM_DELADDR:
+                return manager_rtnl_process_address(rtnl, message, m);
+        case RTM_NEWNEIGH:
+        case RTM_DELNEIGH:
+                return manager_rtnl_process_neighbor(rtnl, message, m);
+        case RTM_NEWROUTE:
+        case RTM_DELROUTE:
+                return manager_rtnl_process_route(rtnl, message, m);
+        case RTM_NEWRULE:
+        case RTM_DELRULE:
+                return manager_rtnl_process_rule(rtnl, message, m);
+        case RTM_NEWNEXTHOP:
+        case RTM_DELNEXTHOP:
+                return manager_rtnl_process_nexthop(rtnl, message, m);
+        default:
+                assert_not_reached();
+        }
+}
+
 static int manager_connect_rtnl(Manager *m, int fd) {
         _unused_ _cleanup_close_ int fd_close = fd;
         int r;
@@ -354,69 +421,11 @@ static int manager_connect_rtnl(Manager *m, int fd) {
         if (r < 0)
                 return r;
 
-        r = netlink_add_match(m->rtnl, NULL, RTM_NEWLINK, &manager_rtnl_process_link, NULL, m, "network-rtnl_process_link");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_DELLINK, &manager_rtnl_process_link, NULL, m, "network-rtnl_process_link");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_NEWQDISC, &manager_rtnl_process_qdisc, NULL, m, "network-rtnl_process_qdisc");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_DELQDISC, &manager_rtnl_process_qdisc, NULL, m, "network-rtnl_process_qdisc");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_NEWTCLASS, &manager_rtnl_process_tclass, NULL, m, "network-rtnl_process_tclass");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_DELTCLASS, &manager_rtnl_process_tclass, NULL, m, "network-rtnl_process_tclass");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_NEWADDR, &manager_rtnl_process_address, NULL, m, "network-rtnl_process_address");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_DELADDR, &manager_rtnl_process_address, NULL, m, "network-rtnl_process_address");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_NEWNEIGH, &manager_rtnl_process_neighbor, NULL, m, "network-rtnl_process_neighbor");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_DELNEIGH, &manager_rtnl_process_neighbor, NULL, m, "network-rtnl_process_neighbor");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_NEWROUTE, &manager_rtnl_process_route, NULL, m, "network-rtnl_process_route");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_DELROUTE, &manager_rtnl_process_route, NULL, m, "network-rtnl_process_route");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_NEWRULE, &manager_rtnl_process_rule, NULL, m, "network-rtnl_process_rule");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_DELRULE, &manager_rtnl_process_rule, NULL, m, "network-rtnl_process_rule");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_NEWNEXTHOP, &manager_rtnl_process_nexthop, NULL, m, "network-rtnl_process_nexthop");
-        if (r < 0)
-                return r;
-
-        r = netlink_add_match(m->rtnl, NULL, RTM_DELNEXTHOP, &manager_rtnl_process_nexthop, NULL, m, "network-rtnl_process_nexthop");
-        if (r < 0)
-                return r;
+        FOREACH_ELEMENT(type, rtnl_message_types) {
+                r = netlink_add_match(m->rtnl, NULL, *type, &manager_rtnl_process_message, NULL, m, "network-rtnl_process_message");
+                if (r < 0)
+                        return r;
+        }
 
         return manager_setup_rtnl_filter(m);
 }
@@ -696,6 +705,7 @@ Manager* manager_free(Manager *m) {
         ordered_set_free(m->address_pools);
 
         hashmap_free(m->route_table_names_by_number);
+        set_free(m->ignore_foreign_route_protocols);
         hashmap_free(m->route_table_numbers_by_name);
 
         set_free(m->rules);
@@ -1203,11 +1213,14 @@ int manager_set_timezone(Manager *m, const char *tz) {
 }
 
 int manager_reload(Manager *m, sd_bus_message *message) {
+        usec_t start, duration;
         Link *link;
         int r;
 
         assert(m);
 
+        start = now(CLOCK_MONOTONIC);
+
         log_debug("Reloading...");
         (void) notify_reloading();
 
@@ -1224,10 +1237,16 @@ int manager_reload(Manager *m, sd_bus_message *message) {
         }
 
         HASHMAP_FOREACH(link, m->links_by_index)
-                (void) link_reconfigure_full(link, /* flags = */ 0, message,
-                                             /* counter = */ message ? &m->reloading : NULL);
+                (void) link_reload(link, message, /* counter = */ message ? &m->reloading : NULL);
+
+        /* This only covers reading the configuration and queueing the reconfiguration, the requests
+         * themselves are accounted in the request queue statistics. */
+        duration = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+        m->stats.n_reloads++;
+        m->stats.last_reload_usec = duration;
+        m->stats.max_reload_usec = MAX(m->stats.max_reload_usec, duration);
 
-        log_debug("Reloaded.");
+        log_debug("Reloaded in %s.", FORMAT_TIMESPAN(duration, USEC_PER_MSEC));
         r = 0;
 finish:
         (void) sd_notify(/* unset= */ false, NOTIFY_READY);
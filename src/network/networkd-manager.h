@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 #pragma once
 
+#include <linux/rtnetlink.h>
+
 #include "sd-bus.h"
 #include "sd-device.h"
 #include "sd-event.h"
@@ -12,13 +14,26 @@
 #include "dhcp-duid-internal.h"
 #include "firewall-util.h"
 #include "hashmap.h"
+#include "metrics.h"
 #include "networkd-link.h"
 #include "networkd-network.h"
+#include "networkd-queue.h"
 #include "networkd-sysctl.h"
 #include "ordered-set.h"
 #include "set.h"
 #include "time-util.h"
 
+typedef struct ManagerStatistics {
+        uint64_t rtnl_received[RTM_MAX + 1];
+        uint64_t rtnl_sent[RTM_MAX + 1];
+        uint64_t requests_queued[_REQUEST_TYPE_MAX];
+        uint64_t requests_processed[_REQUEST_TYPE_MAX];
+        MetricHistogram request_wait_histogram; /* how long requests waited in the queue, in ms */
+        uint64_t n_reloads;
+        usec_t last_reload_usec;
+        usec_t max_reload_usec;
+} ManagerStatistics;
+
 typedef enum ManagerState {
         MANAGER_RUNNING,
         MANAGER_TERMINATING,
@@ -36,6 +51,7 @@ struct Manager {
         sd_resolve *resolve;
         sd_bus *bus;
         sd_varlink_server *varlink_server;
+        Set *varlink_link_state_subscriptions;
         sd_device_monitor *device_monitor;
         Hashmap *polkit_registry;
         int ethtool_fd;
@@ -53,6 +69,10 @@ struct Manager {
         bool manage_foreign_nexthops;
         bool dhcp_server_persist_leases;
 
+        /* Routes with these protocols are not tracked at all, only counted */
+        Set *ignore_foreign_route_protocols;
+        uint64_t n_ignored_foreign_routes;
+
         Set *dirty_links;
         Set *new_wlan_ifindices;
 
@@ -123,6 +143,7 @@ struct Manager {
         bool request_queued;
         OrderedSet *request_queue;
         OrderedSet *remove_request_queue;
+        ManagerStatistics stats;
 
         Hashmap *tuntap_fds_by_name;
 
@@ -171,3 +192,12 @@ static inline Hashmap** manager_get_sysctl_shadow(Manager *manager) {
 }
 
 DEFINE_TRIVIAL_CLEANUP_FUNC(Manager*, manager_free);
+
+static inline void manager_account_rtnl_sent(Manager *m, sd_netlink_message *message) {
+        uint16_t type;
+
+        assert(m);
+
+        if (sd_netlink_message_get_type(message, &type) >= 0 && type < ELEMENTSOF(m->stats.rtnl_sent))
+                m->stats.rtnl_sent[type]++;
+}
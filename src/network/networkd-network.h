@@ -134,6 +134,7 @@ struct Network {
         char *dhcp_hostname;
         char *dhcp_label;
         uint64_t dhcp_max_attempts;
+        usec_t dhcp_randomized_delay_usec;
         uint32_t dhcp_route_metric;
         bool dhcp_route_metric_set;
         uint32_t dhcp_route_table;
@@ -183,6 +183,9 @@ static int request_new(
         if (req->counter)
                 (*req->counter)++;
 
+        (void) sd_event_now(manager->event, CLOCK_MONOTONIC, &req->queued_usec);
+        manager->stats.requests_queued[type]++;
+
         /* If this is called in the ORDERED_SET_FOREACH() loop of manager_process_requests(), we need to
          * exit from the loop, due to the limitation of the iteration on OrderedSet. */
         manager->request_queued = true;
@@ -268,6 +271,22 @@ int link_requeue_request(Link *link, Request *req, void *userdata, Request **ret
                         ret);
 }
 
+static void request_account_processed(Request *req) {
+        ManagerStatistics *stats;
+        usec_t n;
+
+        assert(req);
+        assert(req->manager);
+
+        stats = &req->manager->stats;
+        stats->requests_processed[req->type]++;
+
+        if (sd_event_now(req->manager->event, CLOCK_MONOTONIC, &n) < 0)
+                return;
+
+        metric_histogram_observe(&stats->request_wait_histogram, usec_sub_unsigned(n, req->queued_usec) / USEC_PER_MSEC);
+}
+
 int manager_process_requests(Manager *manager) {
         Request *req;
         int r;
@@ -280,6 +299,9 @@ int manager_process_requests(Manager *manager) {
 
         manager->request_queued = false;
 
+        /* Send the netlink messages of the requests processed below in batches, rather than one by one */
+        netlink_cork(manager->rtnl);
+
         ORDERED_SET_FOREACH(req, manager->request_queue) {
                 if (req->waiting_reply)
                         continue; /* Already processed, and waiting for netlink reply. */
@@ -307,6 +329,8 @@ int manager_process_requests(Manager *manager) {
                                 break;
                         }
                 }
+                if (r > 0)
+                        request_account_processed(req);
                 if (r > 0 && !req->waiting_reply)
                         /* If the request sends netlink message, e.g. for Address or so, the Request object is
                          * referenced by the netlink slot, and will be detached later by its destroy callback.
@@ -317,6 +341,10 @@ int manager_process_requests(Manager *manager) {
                         break; /* New request is queued. Exit from the loop. */
         }
 
+        r = netlink_uncork(manager->rtnl);
+        if (r < 0)
+                log_warning_errno(r, "Failed to send queued netlink messages, ignoring: %m");
+
         return 0;
 }
 
@@ -349,6 +377,9 @@ int request_call_netlink_async(sd_netlink *nl, sd_netlink_message *m, Request *r
         if (r < 0)
                 return r;
 
+        if (nl == req->manager->rtnl)
+                manager_account_rtnl_sent(req->manager, m);
+
         request_ref(req);
         req->waiting_reply = true;
         return 0;
@@ -495,6 +526,9 @@ int manager_process_remove_requests(Manager *manager) {
                                 link_enter_failed(link);
 
                 } else {
+                        if (req->netlink == manager->rtnl)
+                                manager_account_rtnl_sent(manager, req->message);
+
                         /* On success, netlink needs to be unref()ed. Otherwise, the netlink and remove
                          * request may not freed on shutting down. */
                         req->netlink = sd_netlink_unref(req->netlink);
@@ -82,6 +82,9 @@ struct Request {
         request_netlink_handler_t netlink_handler;
 
         bool waiting_reply;
+
+        /* When the request was queued, CLOCK_MONOTONIC. */
+        usec_t queued_usec;
 };
 
 Request *request_ref(Request *req);
@@ -604,3 +604,63 @@ int config_parse_route_table_names(
                 TAKE_PTR(name);
         }
 }
+
+int config_parse_ignore_foreign_route_protocols(
+                const char *unit,
+                const char *filename,
+                unsigned line,
+                const char *section,
+                unsigned section_line,
+                const char *lvalue,
+                int ltype,
+                const char *rvalue,
+                void *data,
+                void *userdata) {
+
+        Set **protocols = ASSERT_PTR(data);
+        int r;
+
+        assert(filename);
+        assert(lvalue);
+        assert(rvalue);
+
+        if (isempty(rvalue)) {
+                *protocols = set_free(*protocols);
+                return 0;
+        }
+
+        for (const char *p = rvalue;;) {
+                _cleanup_free_ char *word = NULL;
+                int protocol;
+
+                r = extract_first_word(&p, &word, NULL, 0);
+                if (r == -ENOMEM)
+                        return log_oom();
+                if (r < 0) {
+                        log_syntax(unit, LOG_WARNING, filename, line, r,
+                                   "Invalid %s=, ignoring assignment: %s", lvalue, rvalue);
+                        return 0;
+                }
+                if (r == 0)
+                        return 0;
+
+                protocol = route_protocol_full_from_string(word);
+                if (protocol < 0) {
+                        log_syntax(unit, LOG_WARNING, filename, line, protocol,
+                                   "Failed to parse route protocol \"%s\", ignoring: %m", word);
+                        continue;
+                }
+
+                /* Refuse protocols of routes that we configure ourselves, otherwise we would not notice
+                 * them being configured. */
+                if (IN_SET(protocol, RTPROT_UNSPEC, RTPROT_KERNEL, RTPROT_BOOT, RTPROT_STATIC, RTPROT_RA, RTPROT_DHCP)) {
+                        log_syntax(unit, LOG_WARNING, filename, line, 0,
+                                   "Route protocol \"%s\" is used by systemd-networkd itself, ignoring.", word);
+                        continue;
+                }
+
+                r = set_ensure_put(protocols, NULL, INT_TO_PTR(protocol));
+                if (r < 0)
+                        return log_oom();
+        }
+}
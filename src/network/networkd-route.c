@@ -1220,6 +1220,22 @@ int manager_rtnl_process_route(sd_netlink *rtnl, sd_netlink_message *message, Ma
                 return 0;
         }
 
+        if (!set_isempty(m->ignore_foreign_route_protocols)) {
+                uint8_t protocol;
+
+                /* Do not parse and remember routes whose protocol we were told to ignore, e.g. full BGP
+                 * tables installed by a routing daemon. Only keep track of how many of them exist. Replacing
+                 * a route or appending a nexthop to it does not change the number. */
+                r = sd_rtnl_message_route_get_protocol(message, &protocol);
+                if (r >= 0 && set_contains(m->ignore_foreign_route_protocols, INT_TO_PTR(protocol))) {
+                        if (type == RTM_DELROUTE)
+                                m->n_ignored_foreign_routes = LESS_BY(m->n_ignored_foreign_routes, 1u);
+                        else if (!(netlink_message_get_flags(message) & (NLM_F_REPLACE | NLM_F_APPEND)))
+                                m->n_ignored_foreign_routes++;
+                        return 0;
+                }
+        }
+
         r = route_new(&tmp);
         if (r < 0)
                 return log_oom();
@@ -1951,6 +1967,12 @@ int route_section_verify(Route *route) {
         if (r < 0)
                 return r;
 
+        if (route->network &&
+            set_contains(route->network->manager->ignore_foreign_route_protocols, INT_TO_PTR(route->protocol)))
+                return log_section_warning_errno(route->section, SYNTHETIC_ERRNO(EINVAL),
+                                                 "Protocol=%u is listed in IgnoreForeignRouteProtocols= of networkd.conf, ignoring [Route] section.",
+                                                 route->protocol);
+
         /* table */
         if (!route->table_set && route->network && route->network->vrf) {
                 route->table = VRF(route->network->vrf)->table;
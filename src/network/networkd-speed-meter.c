@@ -19,10 +19,10 @@ static int process_message(Manager *manager, sd_netlink_message *message) {
         if (r < 0)
                 return r;
 
-        if (type != RTM_NEWLINK)
+        if (type != RTM_NEWSTATS)
                 return 0;
 
-        r = sd_rtnl_message_link_get_ifindex(message, &ifindex);
+        r = sd_rtnl_message_stats_get_ifindex(message, &ifindex);
         if (r < 0)
                 return r;
 
@@ -32,7 +32,7 @@ static int process_message(Manager *manager, sd_netlink_message *message) {
 
         link->stats_old = link->stats_new;
 
-        r = sd_netlink_message_read(message, IFLA_STATS64, sizeof link->stats_new, &link->stats_new);
+        r = sd_netlink_message_read(message, IFLA_STATS_LINK_64, sizeof link->stats_new, &link->stats_new);
         if (r < 0)
                 return r;
 
@@ -64,9 +64,10 @@ static int speed_meter_handler(sd_event_source *s, uint64_t usec, void *userdata
         HASHMAP_FOREACH(link, manager->links_by_index)
                 link->stats_updated = false;
 
-        r = sd_rtnl_message_new_link(manager->rtnl, &req, RTM_GETLINK, 0);
+        /* Only request the 64-bit counters, rather than full link messages with all their attributes. */
+        r = sd_rtnl_message_new_stats(manager->rtnl, &req, RTM_GETSTATS, 0, IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64));
         if (r < 0) {
-                log_warning_errno(r, "Failed to allocate RTM_GETLINK netlink message, ignoring: %m");
+                log_warning_errno(r, "Failed to allocate RTM_GETSTATS netlink message, ignoring: %m");
                 return 0;
         }
 
@@ -78,7 +79,7 @@ static int speed_meter_handler(sd_event_source *s, uint64_t usec, void *userdata
 
         r = sd_netlink_call(manager->rtnl, req, 0, &reply);
         if (r < 0) {
-                log_warning_errno(r, "Failed to call RTM_GETLINK, ignoring: %m");
+                log_warning_errno(r, "Failed to call RTM_GETSTATS, ignoring: %m");
                 return 0;
         }
 
@@ -88,6 +89,37 @@ static int speed_meter_handler(sd_event_source *s, uint64_t usec, void *userdata
         return 0;
 }
 
+int link_get_bit_rates(Link *link, uint64_t *ret_tx, uint64_t *ret_rx) {
+        Manager *manager;
+        double interval_sec;
+
+        assert(link);
+        assert(ret_tx);
+        assert(ret_rx);
+
+        manager = ASSERT_PTR(link->manager);
+
+        if (!manager->use_speed_meter ||
+            manager->speed_meter_usec_old == 0 ||
+            !link->stats_updated)
+                return -ENODATA;
+
+        assert(manager->speed_meter_usec_new > manager->speed_meter_usec_old);
+        interval_sec = (manager->speed_meter_usec_new - manager->speed_meter_usec_old) / USEC_PER_SEC;
+
+        if (link->stats_new.tx_bytes > link->stats_old.tx_bytes)
+                *ret_tx = (uint64_t) ((link->stats_new.tx_bytes - link->stats_old.tx_bytes) / interval_sec);
+        else
+                *ret_tx = (uint64_t) ((UINT64_MAX - (link->stats_old.tx_bytes - link->stats_new.tx_bytes)) / interval_sec);
+
+        if (link->stats_new.rx_bytes > link->stats_old.rx_bytes)
+                *ret_rx = (uint64_t) ((link->stats_new.rx_bytes - link->stats_old.rx_bytes) / interval_sec);
+        else
+                *ret_rx = (uint64_t) ((UINT64_MAX - (link->stats_old.rx_bytes - link->stats_new.rx_bytes)) / interval_sec);
+
+        return 0;
+}
+
 int manager_start_speed_meter(Manager *manager) {
         _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL;
         int r;
@@ -1,12 +1,16 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 #pragma once
 
+#include <inttypes.h>
+
 /* Default interval is 10sec. The speed meter periodically make networkd
  * to be woke up. So, too small interval value is not desired.
  * We set the minimum value 100msec = 0.1sec. */
 #define SPEED_METER_DEFAULT_TIME_INTERVAL (10 * USEC_PER_SEC)
 #define SPEED_METER_MINIMUM_TIME_INTERVAL (100 * USEC_PER_MSEC)
 
+typedef struct Link Link;
 typedef struct Manager Manager;
 
+int link_get_bit_rates(Link *link, uint64_t *ret_tx, uint64_t *ret_rx);
 int manager_start_speed_meter(Manager *m);
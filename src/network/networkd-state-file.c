@@ -10,10 +10,12 @@
 #include "fd-util.h"
 #include "fileio.h"
 #include "fs-util.h"
+#include "memstream-util.h"
 #include "network-internal.h"
 #include "networkd-dhcp-common.h"
 #include "networkd-link.h"
 #include "networkd-manager-bus.h"
+#include "networkd-manager-varlink.h"
 #include "networkd-manager.h"
 #include "networkd-network.h"
 #include "networkd-ntp.h"
@@ -324,6 +326,44 @@ static int link_put_domains(Link *link, bool is_route, OrderedSet **s) {
         return 0;
 }
 
+static int write_state_file(const char *path, const char *buf, size_t size) {
+        _cleanup_(unlink_and_freep) char *temp_path = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        _cleanup_free_ char *old = NULL;
+        size_t old_size;
+        int r;
+
+        assert(path);
+        assert(buf || size == 0);
+
+        /* Even when the contents do not change, creating and then removing or renaming the temporary
+         * file generates inotify events, which wake up all sd_network_monitor consumers. Hence, compare
+         * with what is on disk first, and do not touch the directory when nothing changed. Returns 1 if
+         * the file was written, 0 if it was already up-to-date. */
+
+        if (read_full_file(path, &old, &old_size) >= 0 &&
+            memcmp_nn(old, old_size, buf, size) == 0)
+                return 0;
+
+        r = fopen_temporary(path, &f, &temp_path);
+        if (r < 0)
+                return r;
+
+        (void) fchmod(fileno(f), 0644);
+
+        fwrite(buf, 1, size, f);
+
+        r = fflush_and_check(f);
+        if (r < 0)
+                return r;
+
+        if (rename(temp_path, path) < 0)
+                return -errno;
+
+        temp_path = mfree(temp_path);
+        return 1;
+}
+
 int manager_save(Manager *m) {
         _cleanup_ordered_set_free_ OrderedSet *dns = NULL, *ntp = NULL, *sip = NULL, *search_domains = NULL, *route_domains = NULL;
         const char *operstate_str, *carrier_state_str, *address_state_str, *ipv4_address_state_str, *ipv6_address_state_str, *online_state_str;
@@ -395,14 +435,14 @@ int manager_save(Manager *m) {
         ipv4_address_state_str = ASSERT_PTR(link_address_state_to_string(ipv4_address_state));
         ipv6_address_state_str = ASSERT_PTR(link_address_state_to_string(ipv6_address_state));
 
-        _cleanup_(unlink_and_freep) char *temp_path = NULL;
-        _cleanup_fclose_ FILE *f = NULL;
-
-        r = fopen_temporary(m->state_file, &f, &temp_path);
-        if (r < 0)
-                return r;
+        _cleanup_(memstream_done) MemStream ms = {};
+        _cleanup_free_ char *buf = NULL;
+        size_t size;
+        FILE *f;
 
-        (void) fchmod(fileno(f), 0644);
+        f = memstream_init(&ms);
+        if (!f)
+                return -ENOMEM;
 
         fprintf(f,
                 "# This is private data. Do not parse.\n"
@@ -423,16 +463,14 @@ int manager_save(Manager *m) {
         ordered_set_print(f, "DOMAINS=", search_domains);
         ordered_set_print(f, "ROUTE_DOMAINS=", route_domains);
 
-        r = fflush_and_check(f);
+        r = memstream_finalize(&ms, &buf, &size);
         if (r < 0)
                 return r;
 
-        r = conservative_rename(temp_path, m->state_file);
+        r = write_state_file(m->state_file, buf, size);
         if (r < 0)
                 return r;
 
-        temp_path = mfree(temp_path);
-
         _cleanup_strv_free_ char **p = NULL;
 
         if (m->operational_state != operstate) {
@@ -701,8 +739,10 @@ static int serialize_config_files(FILE *f, const char *prefix, const char *main_
 
 static int link_save(Link *link) {
         const char *admin_state, *oper_state, *carrier_state, *address_state, *ipv4_address_state, *ipv6_address_state;
-        _cleanup_(unlink_and_freep) char *temp_path = NULL;
-        _cleanup_fclose_ FILE *f = NULL;
+        _cleanup_(memstream_done) MemStream ms = {};
+        _cleanup_free_ char *buf = NULL;
+        size_t size;
+        FILE *f;
         int r;
 
         assert(link);
@@ -721,11 +761,9 @@ static int link_save(Link *link) {
         ipv4_address_state = ASSERT_PTR(link_address_state_to_string(link->ipv4_address_state));
         ipv6_address_state = ASSERT_PTR(link_address_state_to_string(link->ipv6_address_state));
 
-        r = fopen_temporary(link->state_file, &f, &temp_path);
-        if (r < 0)
-                return r;
-
-        (void) fchmod(fileno(f), 0644);
+        f = memstream_init(&ms);
+        if (!f)
+                return -ENOMEM;
 
         fprintf(f,
                 "# This is private data. Do not parse.\n"
@@ -933,17 +971,11 @@ static int link_save(Link *link) {
         if (r < 0)
                 return r;
 
-        r = fflush_and_check(f);
-        if (r < 0)
-                return r;
-
-        r = conservative_rename(temp_path, link->state_file);
+        r = memstream_finalize(&ms, &buf, &size);
         if (r < 0)
                 return r;
 
-        temp_path = mfree(temp_path);
-
-        return 0;
+        return write_state_file(link->state_file, buf, size);
 }
 
 void link_dirty(Link *link) {
@@ -990,6 +1022,11 @@ int link_save_and_clean_full(Link *link, bool also_save_manager) {
         r = link_save(link);
         if (r < 0)
                 return r;
+        if (r > 0) {
+                r = manager_varlink_notify_link_state(link->manager, link);
+                if (r < 0)
+                        log_link_debug_errno(link, r, "Failed to notify varlink subscribers about link state, ignoring: %m");
+        }
 
         link_clean(link);
         return k;
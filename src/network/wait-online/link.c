@@ -252,3 +252,62 @@ int link_update_monitor(Link *l) {
 
         return ret;
 }
+
+int link_update_varlink(Link *l, const LinkOnlineStateInfo *info) {
+        LinkOperationalState operational_state;
+        LinkAddressState s;
+        int r, ret = 0;
+
+        assert(l);
+        assert(info);
+
+        /* Same as link_update_monitor(), but takes the data from a varlink notification rather than from
+         * the state file. Missing Required* fields have the same meaning as missing keys in the file. */
+
+        l->required_for_online = info->required_for_online != 0;
+
+        if (isempty(info->required_operstate))
+                l->required_operstate = LINK_OPERSTATE_RANGE_DEFAULT;
+        else {
+                r = parse_operational_state_range(info->required_operstate, &l->required_operstate);
+                if (r < 0)
+                        ret = log_link_debug_errno(l, SYNTHETIC_ERRNO(EINVAL),
+                                                   "Failed to parse required operational state, ignoring: %m");
+        }
+
+        operational_state = link_operstate_from_string(info->operational_state);
+        if (operational_state < 0)
+                ret = log_link_debug_errno(l, operational_state, "Failed to parse operational state, ignoring: %m");
+        else
+                l->operational_state = operational_state;
+
+        if (isempty(info->required_family))
+                l->required_family = ADDRESS_FAMILY_NO;
+        else {
+                AddressFamily f;
+
+                f = link_required_address_family_from_string(info->required_family);
+                if (f < 0)
+                        ret = log_link_debug_errno(l, f, "Failed to parse required address family, ignoring: %m");
+                else
+                        l->required_family = f;
+        }
+
+        s = link_address_state_from_string(info->ipv4_address_state);
+        if (s < 0)
+                ret = log_link_debug_errno(l, s, "Failed to parse IPv4 address state, ignoring: %m");
+        else
+                l->ipv4_address_state = s;
+
+        s = link_address_state_from_string(info->ipv6_address_state);
+        if (s < 0)
+                ret = log_link_debug_errno(l, s, "Failed to parse IPv6 address state, ignoring: %m");
+        else
+                l->ipv6_address_state = s;
+
+        r = free_and_strdup(&l->state, info->setup_state);
+        if (r < 0)
+                return r;
+
+        return ret;
+}
@@ -28,9 +28,22 @@ struct Link {
         DNSConfiguration *dns_configuration;
 };
 
+/* The state of a link as sent by systemd-networkd's io.systemd.Network.SubscribeLinkStates() */
+typedef struct LinkOnlineStateInfo {
+        int ifindex;
+        const char *setup_state;
+        const char *operational_state;
+        const char *ipv4_address_state;
+        const char *ipv6_address_state;
+        int required_for_online;
+        const char *required_operstate;
+        const char *required_family;
+} LinkOnlineStateInfo;
+
 int link_new(Manager *m, Link **ret, int ifindex, const char *ifname);
 Link *link_free(Link *l);
 int link_update_rtnl(Link *l, sd_netlink_message *m);
 int link_update_monitor(Link *l);
+int link_update_varlink(Link *l, const LinkOnlineStateInfo *info);
 
 DEFINE_TRIVIAL_CLEANUP_FUNC(Link*, link_free);
@@ -362,12 +362,11 @@ static int manager_rtnl_listen(Manager *m) {
         return r;
 }
 
-static int on_network_event(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
-        Manager *m = ASSERT_PTR(userdata);
+static void manager_update_all_links(Manager *m) {
         Link *l;
         int r;
 
-        sd_network_monitor_flush(m->network_monitor);
+        assert(m);
 
         HASHMAP_FOREACH(l, m->links_by_index) {
                 r = link_update_monitor(l);
@@ -375,6 +374,16 @@ static int on_network_event(sd_event_source *s, int fd, uint32_t revents, void *
                         log_link_full_errno(l, IN_SET(r, -ENODATA, -ENOENT) ? LOG_DEBUG : LOG_WARNING, r,
                                             "Failed to update link state, ignoring: %m");
         }
+}
+
+static int on_network_event(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        /* The inotify events do not tell which link changed, hence all links need to be reread. */
+
+        sd_network_monitor_flush(m->network_monitor);
+
+        manager_update_all_links(m);
 
         if (manager_configured(m))
                 sd_event_exit(m->event, 0);
@@ -407,6 +416,130 @@ static int manager_network_monitor_listen(Manager *m) {
         return 0;
 }
 
+static int manager_fallback_to_network_monitor(Manager *m) {
+        int r;
+
+        assert(m);
+
+        if (m->network_monitor)
+                return 0;
+
+        r = manager_network_monitor_listen(m);
+        if (r < 0)
+                return r;
+
+        /* We may have missed changes while switching, hence reread everything once. */
+        manager_update_all_links(m);
+        return 0;
+}
+
+static int on_link_states_event(
+                sd_varlink *link,
+                sd_json_variant *parameters,
+                const char *error_id,
+                sd_varlink_reply_flags_t flags,
+                void *userdata) {
+
+        static const sd_json_dispatch_field dispatch_table[] = {
+                { "InterfaceIndex",                    _SD_JSON_VARIANT_TYPE_INVALID, json_dispatch_ifindex,         offsetof(LinkOnlineStateInfo, ifindex),            SD_JSON_MANDATORY|SD_JSON_RELAX },
+                { "SetupState",                        SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(LinkOnlineStateInfo, setup_state),        SD_JSON_MANDATORY               },
+                { "OperationalState",                  SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(LinkOnlineStateInfo, operational_state),  SD_JSON_MANDATORY               },
+                { "IPv4AddressState",                  SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(LinkOnlineStateInfo, ipv4_address_state), SD_JSON_MANDATORY               },
+                { "IPv6AddressState",                  SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(LinkOnlineStateInfo, ipv6_address_state), SD_JSON_MANDATORY               },
+                { "RequiredForOnline",                 SD_JSON_VARIANT_BOOLEAN,       sd_json_dispatch_tristate,     offsetof(LinkOnlineStateInfo, required_for_online), 0                              },
+                { "RequiredOperationalStateForOnline", SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(LinkOnlineStateInfo, required_operstate), 0                               },
+                { "RequiredFamilyForOnline",           SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(LinkOnlineStateInfo, required_family),    0                               },
+                {}
+        };
+
+        Manager *m = ASSERT_PTR(userdata);
+        sd_json_variant *links, *v;
+        int r;
+
+        assert(link);
+
+        if (error_id) {
+                /* E.g. an older networkd which does not implement the method, or networkd went away. */
+                log_debug("Link state subscription failed, falling back to monitoring state files: %s", error_id);
+
+                r = manager_fallback_to_network_monitor(m);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to start network monitor: %m");
+
+                if (manager_configured(m))
+                        sd_event_exit(m->event, 0);
+
+                return 0;
+        }
+
+        links = sd_json_variant_by_key(parameters, "Links");
+        if (!sd_json_variant_is_array(links)) {
+                log_warning("Link state JSON data does not have Links key, ignoring.");
+                return 0;
+        }
+
+        /* Only the links mentioned in the notification changed, all others are left untouched. */
+        JSON_VARIANT_ARRAY_FOREACH(v, links) {
+                LinkOnlineStateInfo info = {
+                        .required_for_online = -1,
+                };
+                Link *l;
+
+                r = sd_json_dispatch(v, dispatch_table, SD_JSON_ALLOW_EXTENSIONS, &info);
+                if (r < 0) {
+                        log_warning_errno(r, "Failed to parse link state JSON, ignoring: %m");
+                        continue;
+                }
+
+                /* Links not known yet are read from their state file when rtnl reports them. */
+                l = hashmap_get(m->links_by_index, INT_TO_PTR(info.ifindex));
+                if (!l)
+                        continue;
+
+                r = link_update_varlink(l, &info);
+                if (r < 0)
+                        log_link_warning_errno(l, r, "Failed to update link state, ignoring: %m");
+        }
+
+        if (manager_configured(m))
+                sd_event_exit(m->event, 0);
+
+        return 0;
+}
+
+static int manager_link_states_listen(Manager *m) {
+        _cleanup_(sd_varlink_unrefp) sd_varlink *vl = NULL;
+        int r;
+
+        assert(m);
+        assert(m->event);
+
+        r = sd_varlink_connect_address(&vl, "/run/systemd/netif/io.systemd.Network");
+        if (r < 0)
+                return log_debug_errno(r, "Failed to connect to io.systemd.Network: %m");
+
+        r = sd_varlink_set_relative_timeout(vl, USEC_INFINITY);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to set varlink timeout: %m");
+
+        r = sd_varlink_attach_event(vl, m->event, SD_EVENT_PRIORITY_NORMAL);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to attach varlink connection to event loop: %m");
+
+        (void) sd_varlink_set_userdata(vl, m);
+
+        r = sd_varlink_bind_reply(vl, on_link_states_event);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to bind varlink reply callback: %m");
+
+        r = sd_varlink_observe(vl, "io.systemd.Network.SubscribeLinkStates", /* parameters= */ NULL);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to issue SubscribeLinkStates: %m");
+
+        m->network_varlink_client = TAKE_PTR(vl);
+        return 0;
+}
+
 static int on_dns_configuration_event(
                 sd_varlink *link,
                 sd_json_variant *parameters,
@@ -551,9 +684,13 @@ int manager_new(Manager **ret,
 
         sd_event_set_watchdog(m->event, true);
 
-        r = manager_network_monitor_listen(m);
-        if (r < 0)
-                return r;
+        /* Subscribe before enumerating links, so that no change is missed in between. */
+        r = manager_link_states_listen(m);
+        if (r < 0) {
+                r = manager_network_monitor_listen(m);
+                if (r < 0)
+                        return r;
+        }
 
         r = manager_rtnl_listen(m);
         if (r < 0)
@@ -577,6 +714,7 @@ Manager* manager_free(Manager *m) {
 
         sd_event_source_unref(m->network_monitor_event_source);
         sd_network_monitor_unref(m->network_monitor);
+        sd_varlink_unref(m->network_varlink_client);
         sd_event_source_unref(m->rtnl_event_source);
         sd_netlink_unref(m->rtnl);
         sd_event_unref(m->event);
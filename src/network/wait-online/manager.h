@@ -30,6 +30,9 @@ struct Manager {
         sd_netlink *rtnl;
         sd_event_source *rtnl_event_source;
 
+        /* Link state changes are received from systemd-networkd via varlink. Only when that is not
+         * available, the state files are monitored and reread. */
+        sd_varlink *network_varlink_client;
         sd_network_monitor *network_monitor;
         sd_event_source *network_monitor_event_source;
 
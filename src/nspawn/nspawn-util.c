@@ -7,6 +7,7 @@
 #include "parse-util.h"
 #include "path-util.h"
 #include "string-util.h"
+#include "time-util.h"
 
 int systemd_installation_has_version(const char *root, const char *minimal_version) {
         bool found = false;
@@ -77,3 +78,16 @@ int systemd_installation_has_version(const char *root, const char *minimal_versi
 
         return !found ? -ENOENT : false;
 }
+
+void log_startup_phase(const char *phase, usec_t *ts) {
+        usec_t n;
+
+        assert(phase);
+        assert(ts);
+
+        /* Logs how long the specified phase of the container setup took, and starts the next one */
+
+        n = now(CLOCK_MONOTONIC);
+        log_debug("Startup phase '%s' took %s.", phase, FORMAT_TIMESPAN(usec_sub_unsigned(n, *ts), 1));
+        *ts = n;
+}
@@ -1,4 +1,8 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 #pragma once
 
+#include "time-util.h"
+
 int systemd_installation_has_version(const char *root, const char *minimal_version);
+
+void log_startup_phase(const char *phase, usec_t *ts);
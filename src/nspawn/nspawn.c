@@ -3360,6 +3360,8 @@ static int inner_child(
         assert(barrier);
         assert(fd_inner_socket >= 0);
 
+        usec_t start = now(CLOCK_MONOTONIC), ts = start;
+
         log_debug("Inner child is initializing.");
 
         if (arg_userns_mode != USER_NAMESPACE_NO) {
@@ -3383,6 +3385,8 @@ static int inner_child(
                         return r;
         }
 
+        log_startup_phase("inner child user namespace", &ts);
+
         r = mount_all(/* dest= */ NULL,
                       arg_mount_settings | MOUNT_IN_USERNS,
                       arg_uid_shift,
@@ -3390,6 +3394,8 @@ static int inner_child(
         if (r < 0)
                 return r;
 
+        log_startup_phase("inner child API file systems", &ts);
+
         if (!arg_network_namespace_path && arg_private_network) {
                 _cleanup_close_ int netns_fd = -EBADF;
 
@@ -3416,10 +3422,14 @@ static int inner_child(
         }
 
         /* Wait until we are cgroup-ified, so that we can mount the right cgroup path writable */
+        log_startup_phase("inner child network and sysfs", &ts);
+
         if (!barrier_place_and_sync(barrier)) /* #4 */
                 return log_error_errno(SYNTHETIC_ERRNO(ESRCH),
                                        "Parent died too early");
 
+        log_startup_phase("inner child waiting for parent", &ts);
+
         if (arg_use_cgns) {
                 r = unshare(CLONE_NEWCGROUP);
                 if (r < 0)
@@ -3456,6 +3466,8 @@ static int inner_child(
         if (r < 0)
                 return r;
 
+        log_startup_phase("inner child cgroups and custom mounts", &ts);
+
         if (setsid() < 0)
                 return log_error_errno(errno, "setsid() failed: %m");
 
@@ -3630,6 +3642,9 @@ static int inner_child(
         if (!env_use)
                 return log_oom();
 
+        log_startup_phase("inner child credentials and environment", &ts);
+        log_debug("Inner child initialized in %s.", FORMAT_TIMESPAN(usec_sub_unsigned(ts, start), 1));
+
         /* Let the parent know that we are ready and wait until the parent is ready with the setup, too... */
         if (!barrier_place_and_sync(barrier)) /* #5 */
                 return log_error_errno(SYNTHETIC_ERRNO(ESRCH), "Parent died too early");
@@ -3921,6 +3936,8 @@ static int outer_child(
         assert(fd_outer_socket >= 0);
         assert(fd_inner_socket >= 0);
 
+        usec_t start = now(CLOCK_MONOTONIC), ts = start;
+
         log_debug("Outer child is initializing.");
 
         r = load_os_release_pairs_with_prefix("/", "container_host_", &os_release_pairs);
@@ -4053,6 +4070,8 @@ static int outer_child(
         if (r < 0)
                 return r;
 
+        log_startup_phase("root directory", &ts);
+
         r = setup_volatile_mode(
                         directory,
                         arg_volatile_mode,
@@ -4061,6 +4080,8 @@ static int outer_child(
         if (r < 0)
                 return r;
 
+        log_startup_phase("volatile mode", &ts);
+
         r = bind_user_prepare(
                         directory,
                         arg_bind_user,
@@ -4103,6 +4124,8 @@ static int outer_child(
         if (r < 0)
                 return r;
 
+        log_startup_phase("custom root mounts", &ts);
+
         if (!IN_SET(arg_userns_mode, USER_NAMESPACE_NO, USER_NAMESPACE_MANAGED) &&
             IN_SET(arg_userns_ownership, USER_NAMESPACE_OWNERSHIP_MAP, USER_NAMESPACE_OWNERSHIP_FOREIGN, USER_NAMESPACE_OWNERSHIP_AUTO) &&
             chown_uid != 0) {
@@ -4218,6 +4241,8 @@ static int outer_child(
                                                "Short write while sending cgroup mode.");
         }
 
+        log_startup_phase("ID mapping and image mounts", &ts);
+
         r = recursive_chown(directory, chown_uid, chown_range);
         if (r < 0)
                 return r;
@@ -4233,6 +4258,8 @@ static int outer_child(
                         return log_error_errno(r, "Failed to make tree read-only: %m");
         }
 
+        log_startup_phase("base file system", &ts);
+
         r = mount_all(directory,
                       arg_mount_settings,
                       chown_uid,
@@ -4240,6 +4267,8 @@ static int outer_child(
         if (r < 0)
                 return r;
 
+        log_startup_phase("API file systems", &ts);
+
         r = copy_devnodes(directory);
         if (r < 0)
                 return r;
@@ -4261,6 +4290,8 @@ static int outer_child(
         if (r < 0)
                 return r;
 
+        log_startup_phase("device nodes", &ts);
+
         r = mount_tunnel_dig(directory);
         if (r < 0)
                 return r;
@@ -4288,6 +4319,8 @@ static int outer_child(
         if (r < 0)
                 return r;
 
+        log_startup_phase("credentials, users and custom mounts", &ts);
+
         r = setup_timezone(directory);
         if (r < 0)
                 return r;
@@ -4375,6 +4408,9 @@ static int outer_child(
         if (notify_fd < 0)
                 return notify_fd;
 
+        log_startup_phase("host configuration, cgroups and root switch", &ts);
+        log_debug("Outer child initialized in %s.", FORMAT_TIMESPAN(usec_sub_unsigned(ts, start), 1));
+
         pid = raw_clone(SIGCHLD|CLONE_NEWNS|
                         arg_clone_ns_flags |
                         (IN_SET(arg_userns_mode, USER_NAMESPACE_FIXED, USER_NAMESPACE_PICK) ? CLONE_NEWUSER : 0) |
@@ -5213,6 +5249,8 @@ static int run_container(
                                                "Path %s doesn't refer to a network namespace, refusing.", arg_network_namespace_path);
         }
 
+        usec_t start = now(CLOCK_MONOTONIC);
+
         if (arg_userns_mode != USER_NAMESPACE_MANAGED) {
                 assert(userns_fd < 0);
                 /* If we have no user namespace then we'll clone and create a new mount namespace right-away. */
@@ -5592,6 +5630,8 @@ static int run_container(
         if (!barrier_place(&barrier)) /* #5.2 */
                 return log_error_errno(SYNTHETIC_ERRNO(ESRCH), "Child died too early.");
 
+        log_debug("Container set up in %s.", FORMAT_TIMESPAN(usec_sub_unsigned(now(CLOCK_MONOTONIC), start), 1));
+
         /* At this point we have made use of the UID we picked, and thus nss-systemd/systemd-machined.service
          * will make them appear in getpwuid(), thus we can release the /etc/passwd lock. */
         etc_passwd_lock = safe_close(etc_passwd_lock);
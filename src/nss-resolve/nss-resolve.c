@@ -17,13 +17,31 @@
 #include "json-util.h"
 #include "macro.h"
 #include "nss-util.h"
+#include "process-util.h"
 #include "resolved-def.h"
 #include "signal-util.h"
+#include "stat-util.h"
 #include "string-util.h"
 #include "strv.h"
+#include "time-util.h"
+
+/* How long to keep an unused connection to resolved around for reuse by later lookups */
+#define RESOLVED_LINK_IDLE_USEC (5U*USEC_PER_SEC)
 
 static sd_json_dispatch_flags_t json_dispatch_flags = SD_JSON_ALLOW_EXTENSIONS;
 
+/* Processes doing lots of lookups in a row would otherwise pay for a connect() and the peer's accept() for
+ * each of them, hence we keep one idle connection around. Threads doing lookups concurrently take the
+ * connection out of the cache while using it, and simply connect on their own if it is already taken. */
+static struct {
+        sd_varlink *link;
+        pid_t pid;
+        usec_t timestamp;
+        struct stat st;
+} cached_link = {};
+static pthread_mutex_t cached_link_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool cached_link_disabled = false;
+
 static void setup_logging(void) {
         log_parse_environment_variables();
 
@@ -82,6 +100,141 @@ static int connect_to_resolved(sd_varlink **ret) {
         return 0;
 }
 
+static void cached_link_atfork_prepare(void) {
+        assert_se(pthread_mutex_lock(&cached_link_mutex) == 0);
+}
+
+static void cached_link_atfork_release(void) {
+        /* Called in both parent and child. The child won't use the cached connection anyway, see
+         * acquire_link(), but needs the lock to get rid of it. */
+        assert_se(pthread_mutex_unlock(&cached_link_mutex) == 0);
+}
+
+static void cached_link_atfork_install(void) {
+        /* Take the lock around fork(), so that a child forked while another thread holds it doesn't
+         * deadlock. If this can't be arranged for, never cache connections. */
+        cached_link_disabled = pthread_atfork(cached_link_atfork_prepare,
+                                              cached_link_atfork_release,
+                                              cached_link_atfork_release) != 0;
+}
+
+static bool cached_link_lock(void) {
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+        assert_se(pthread_once(&once, cached_link_atfork_install) == 0);
+        if (cached_link_disabled)
+                return false;
+
+        assert_se(pthread_mutex_lock(&cached_link_mutex) == 0);
+        return true;
+}
+
+static void cached_link_unlock(void) {
+        assert_se(pthread_mutex_unlock(&cached_link_mutex) == 0);
+}
+
+static bool cached_link_fd_valid(void) {
+        struct stat st;
+
+        /* The process might have closed all its fds behind our back (as daemons do after fork()), and the fd
+         * number might have been reused for something else since */
+        if (fstat(sd_varlink_get_fd(cached_link.link), &st) < 0)
+                return false;
+
+        return stat_inode_same(&st, &cached_link.st);
+}
+
+static int acquire_link(sd_varlink **ret, bool *ret_reused) {
+        _cleanup_(sd_varlink_unrefp) sd_varlink *stale = NULL;
+        sd_varlink *link = NULL;
+
+        assert(ret);
+        assert(ret_reused);
+
+        if (cached_link_lock()) {
+                if (cached_link.link) {
+                        if (!cached_link_fd_valid())
+                                /* The fd is not ours anymore, hence we must not close it. Leak the rest. */
+                                cached_link.link = NULL;
+                        else if (cached_link.pid == getpid_cached() &&
+                                 usec_add(cached_link.timestamp, RESOLVED_LINK_IDLE_USEC) > now(CLOCK_MONOTONIC))
+                                link = TAKE_PTR(cached_link.link);
+                        else
+                                /* Never use a connection inherited from our parent process, and don't use one
+                                 * that has been idle for long, the server might have closed it already. */
+                                stale = TAKE_PTR(cached_link.link);
+                }
+
+                cached_link_unlock();
+        }
+
+        if (link) {
+                *ret = link;
+                *ret_reused = true;
+                return 0;
+        }
+
+        *ret_reused = false;
+        return connect_to_resolved(ret);
+}
+
+static void release_linkp(sd_varlink **link) {
+        assert(link);
+
+        if (!*link)
+                return;
+
+        /* Only connections that are idle again, i.e. were used for a complete method call, are cached */
+        if (sd_varlink_is_idle(*link) > 0) {
+                struct stat st;
+
+                if (cached_link_lock()) {
+                        if (!cached_link.link && fstat(sd_varlink_get_fd(*link), &st) >= 0) {
+                                cached_link.link = TAKE_PTR(*link);
+                                cached_link.pid = getpid_cached();
+                                cached_link.timestamp = now(CLOCK_MONOTONIC);
+                                cached_link.st = st;
+                        }
+
+                        cached_link_unlock();
+                }
+        }
+
+        *link = sd_varlink_unref(*link);
+}
+
+static int resolved_call(
+                sd_varlink **link,
+                const char *method,
+                sd_json_variant *parameters,
+                sd_json_variant **ret_parameters,
+                const char **ret_error_id) {
+
+        bool reused;
+        int r;
+
+        assert(link);
+        assert(!*link);
+
+        r = acquire_link(link, &reused);
+        if (r < 0)
+                return r;
+
+        r = sd_varlink_call(*link, method, parameters, ret_parameters, ret_error_id);
+        if (r >= 0 || !reused)
+                return r;
+
+        /* The cached connection might have been closed by resolved in the meantime, for example because it
+         * was restarted. Try once more on a fresh connection. */
+        *link = sd_varlink_unref(*link);
+
+        r = connect_to_resolved(link);
+        if (r < 0)
+                return r;
+
+        return sd_varlink_call(*link, method, parameters, ret_parameters, ret_error_id);
+}
+
 static uint32_t ifindex_to_scopeid(int family, const void *a, int ifindex) {
         struct in6_addr in6;
 
@@ -216,7 +369,7 @@ enum nss_status _nss_resolve_gethostbyname4_r(
                 int *errnop, int *h_errnop,
                 int32_t *ttlp) {
 
-        _cleanup_(sd_varlink_unrefp) sd_varlink *link = NULL;
+        _cleanup_(release_linkp) sd_varlink *link = NULL;
         _cleanup_(sd_json_variant_unrefp) sd_json_variant *cparams = NULL;
         _cleanup_(resolve_hostname_reply_destroy) ResolveHostnameReply p = {};
         sd_json_variant *rparams, *entry;
@@ -231,10 +384,6 @@ enum nss_status _nss_resolve_gethostbyname4_r(
         assert(errnop);
         assert(h_errnop);
 
-        r = connect_to_resolved(&link);
-        if (r < 0)
-                goto fail;
-
         r = sd_json_buildo(
                         &cparams,
                         SD_JSON_BUILD_PAIR("name", SD_JSON_BUILD_STRING(name)),
@@ -248,7 +397,7 @@ enum nss_status _nss_resolve_gethostbyname4_r(
          * configuration can distinguish such executed but negative replies from complete failure to
          * talk to resolved). */
         const char *error_id;
-        r = sd_varlink_call(link, "io.systemd.Resolve.ResolveHostname", cparams, &rparams, &error_id);
+        r = resolved_call(&link, "io.systemd.Resolve.ResolveHostname", cparams, &rparams, &error_id);
         if (r < 0)
                 goto fail;
         if (!isempty(error_id)) {
@@ -376,7 +525,7 @@ enum nss_status _nss_resolve_gethostbyname3_r(
                 int32_t *ttlp,
                 char **canonp) {
 
-        _cleanup_(sd_varlink_unrefp) sd_varlink *link = NULL;
+        _cleanup_(release_linkp) sd_varlink *link = NULL;
         _cleanup_(sd_json_variant_unrefp) sd_json_variant *cparams = NULL;
         _cleanup_(resolve_hostname_reply_destroy) ResolveHostnameReply p = {};
         sd_json_variant *rparams, *entry;
@@ -399,10 +548,6 @@ enum nss_status _nss_resolve_gethostbyname3_r(
                 goto fail;
         }
 
-        r = connect_to_resolved(&link);
-        if (r < 0)
-                goto fail;
-
         r = sd_json_buildo(
                         &cparams,
                         SD_JSON_BUILD_PAIR("name", SD_JSON_BUILD_STRING(name)),
@@ -412,7 +557,7 @@ enum nss_status _nss_resolve_gethostbyname3_r(
                 goto fail;
 
         const char *error_id;
-        r = sd_varlink_call(link, "io.systemd.Resolve.ResolveHostname", cparams, &rparams, &error_id);
+        r = resolved_call(&link, "io.systemd.Resolve.ResolveHostname", cparams, &rparams, &error_id);
         if (r < 0)
                 goto fail;
         if (!isempty(error_id)) {
@@ -592,7 +737,7 @@ enum nss_status _nss_resolve_gethostbyaddr2_r(
                 int *errnop, int *h_errnop,
                 int32_t *ttlp) {
 
-        _cleanup_(sd_varlink_unrefp) sd_varlink *link = NULL;
+        _cleanup_(release_linkp) sd_varlink *link = NULL;
         _cleanup_(sd_json_variant_unrefp) sd_json_variant *cparams = NULL;
         _cleanup_(resolve_address_reply_destroy) ResolveAddressReply p = {};
         sd_json_variant *rparams, *entry;
@@ -619,10 +764,6 @@ enum nss_status _nss_resolve_gethostbyaddr2_r(
                 goto fail;
         }
 
-        r = connect_to_resolved(&link);
-        if (r < 0)
-                goto fail;
-
         r = sd_json_buildo(
                         &cparams,
                         SD_JSON_BUILD_PAIR("address", SD_JSON_BUILD_BYTE_ARRAY(addr, len)),
@@ -632,7 +773,7 @@ enum nss_status _nss_resolve_gethostbyaddr2_r(
                 goto fail;
 
         const char* error_id;
-        r = sd_varlink_call(link, "io.systemd.Resolve.ResolveAddress", cparams, &rparams, &error_id);
+        r = resolved_call(&link, "io.systemd.Resolve.ResolveAddress", cparams, &rparams, &error_id);
         if (r < 0)
                 goto fail;
         if (!isempty(error_id)) {
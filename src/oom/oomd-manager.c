@@ -1,5 +1,9 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
 #include "sd-daemon.h"
 #include "sd-json.h"
 
@@ -14,11 +18,13 @@
 #include "json-util.h"
 #include "memory-util.h"
 #include "memstream-util.h"
+#include "metrics.h"
 #include "oomd-conf.h"
 #include "oomd-manager-bus.h"
 #include "oomd-manager.h"
 #include "path-util.h"
 #include "percent-util.h"
+#include "varlink-io.systemd.Metrics.h"
 #include "varlink-io.systemd.oom.h"
 #include "varlink-io.systemd.service.h"
 #include "varlink-util.h"
@@ -37,6 +43,182 @@ static void managed_oom_message_destroy(ManagedOOMMessage *message) {
         free(message->property);
 }
 
+typedef struct OomdPressureTrigger {
+        Manager *manager;
+        char *path;
+        loadavg_t limit;
+        sd_event_source *event_source;
+        bool fired;
+        bool broken;
+} OomdPressureTrigger;
+
+static OomdPressureTrigger* oomd_pressure_trigger_free(OomdPressureTrigger *t) {
+        if (!t)
+                return NULL;
+
+        sd_event_source_disable_unref(t->event_source);
+        free(t->path);
+        return mfree(t);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(OomdPressureTrigger*, oomd_pressure_trigger_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(
+                oomd_pressure_trigger_hash_ops,
+                char,
+                path_hash_func,
+                path_compare,
+                OomdPressureTrigger,
+                oomd_pressure_trigger_free);
+
+static bool mem_pressure_approaching_limit(const OomdCGroupContext *ctx) {
+        assert(ctx);
+
+        return ctx->mem_pressure_limit_hit_start > 0 ||
+                ctx->memory_pressure.avg10 > ctx->mem_pressure_limit / 2;
+}
+
+static int manager_wake_mem_pressure_monitor(Manager *m) {
+        int r;
+
+        assert(m);
+
+        if (!m->mem_pressure_idle)
+                return 0;
+
+        /* Leave idle mode right away, instead of waiting for the next safety net poll */
+        m->mem_pressure_idle = false;
+        r = sd_event_source_set_time_relative(m->mem_pressure_context_event_source, 0);
+        if (r < 0)
+                return log_error_errno(r, "Failed to set relative time for timer: %m");
+
+        return 0;
+}
+
+static int on_mem_pressure_trigger(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        OomdPressureTrigger *t = ASSERT_PTR(userdata);
+
+        if (FLAGS_SET(revents, EPOLLERR) || FLAGS_SET(revents, EPOLLHUP)) {
+                /* The cgroup is most likely gone. Disable the trigger, it is dropped (or recreated, if the
+                 * cgroup is still monitored) on the next update. */
+                log_debug("Memory pressure trigger for %s failed, disabling.", t->path);
+                t->broken = true;
+                (void) sd_event_source_set_enabled(s, SD_EVENT_OFF);
+        } else
+                log_debug("Memory pressure of %s is approaching its limit.", t->path);
+
+        t->fired = true;
+
+        return manager_wake_mem_pressure_monitor(t->manager);
+}
+
+static int oomd_pressure_trigger_new(Manager *m, const OomdCGroupContext *ctx, OomdPressureTrigger **ret) {
+        _cleanup_(oomd_pressure_trigger_freep) OomdPressureTrigger *t = NULL;
+        _cleanup_free_ char *p = NULL, *buf = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        usec_t threshold;
+        ssize_t n;
+        int r;
+
+        assert(m);
+        assert(ctx);
+        assert(ret);
+
+        r = cg_get_path(SYSTEMD_CGROUP_CONTROLLER, ctx->path, "memory.pressure", &p);
+        if (r < 0)
+                return r;
+
+        fd = open(p, O_RDWR|O_NONBLOCK|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0)
+                return -errno;
+
+        /* The limit is a percentage in fixed point. Trigger at half of it, since we want to start polling
+         * before the limit is reached, and the kernel refuses a stall time of zero. */
+        threshold = MAX(MEM_PRESSURE_TRIGGER_WINDOW_USEC * ctx->mem_pressure_limit / (LOADAVG_FIXED_POINT_1_0 * 100 * 2),
+                        USEC_PER_MSEC);
+        threshold = MIN(threshold, MEM_PRESSURE_TRIGGER_WINDOW_USEC);
+
+        /* Same PSI type that is compared with the limit, see oomd_cgroup_context_acquire() */
+        if (asprintf(&buf, "full " USEC_FMT " " USEC_FMT, threshold, (usec_t) MEM_PRESSURE_TRIGGER_WINDOW_USEC) < 0)
+                return -ENOMEM;
+
+        n = write(fd, buf, strlen(buf));
+        if (n < 0)
+                return -errno;
+        if ((size_t) n != strlen(buf))
+                return -EIO;
+
+        t = new(OomdPressureTrigger, 1);
+        if (!t)
+                return -ENOMEM;
+
+        *t = (OomdPressureTrigger) {
+                .manager = m,
+                .limit = ctx->mem_pressure_limit,
+        };
+
+        t->path = strdup(ctx->path);
+        if (!t->path)
+                return -ENOMEM;
+
+        r = sd_event_add_io(m->event, &t->event_source, fd, EPOLLPRI, on_mem_pressure_trigger, t);
+        if (r < 0)
+                return r;
+
+        r = sd_event_source_set_io_fd_own(t->event_source, true);
+        if (r < 0)
+                return r;
+        TAKE_FD(fd);
+
+        (void) sd_event_source_set_description(t->event_source, "oomd-memory-pressure-trigger");
+
+        *ret = TAKE_PTR(t);
+        return 0;
+}
+
+/* Make sure there is a PSI trigger for every cgroup monitored for memory pressure. Returns true if all of
+ * them are covered, i.e. if it is safe to stop polling them every interval. */
+static int manager_update_mem_pressure_triggers(Manager *m) {
+        OomdPressureTrigger *t;
+        OomdCGroupContext *ctx;
+        bool complete = true;
+        int r;
+
+        assert(m);
+
+        /* Drop triggers of cgroups that are not monitored anymore, whose limit changed, or which failed */
+        HASHMAP_FOREACH(t, m->mem_pressure_triggers) {
+                ctx = hashmap_get(m->monitored_mem_pressure_cgroup_contexts, t->path);
+                if (!ctx || ctx->mem_pressure_limit != t->limit || t->broken)
+                        oomd_pressure_trigger_free(hashmap_remove(m->mem_pressure_triggers, t->path));
+        }
+
+        HASHMAP_FOREACH(ctx, m->monitored_mem_pressure_cgroup_contexts) {
+                _cleanup_(oomd_pressure_trigger_freep) OomdPressureTrigger *n = NULL;
+
+                if (hashmap_contains(m->mem_pressure_triggers, ctx->path))
+                        continue;
+
+                r = oomd_pressure_trigger_new(m, ctx, &n);
+                if (r == -ENOMEM)
+                        return r;
+                if (r == -ENOENT) /* The cgroup is gone, nothing to watch and nothing to poll either. */
+                        continue;
+                if (r < 0) {
+                        log_debug_errno(r, "Failed to set up memory pressure trigger for %s, polling it instead: %m", ctx->path);
+                        complete = false;
+                        continue;
+                }
+
+                r = hashmap_ensure_put(&m->mem_pressure_triggers, &oomd_pressure_trigger_hash_ops, n->path, n);
+                if (r < 0)
+                        return r;
+                TAKE_PTR(n);
+        }
+
+        return complete;
+}
+
 static JSON_DISPATCH_ENUM_DEFINE(dispatch_managed_oom_mode, ManagedOOMMode, managed_oom_mode_from_string);
 
 static int process_managed_oom_message(Manager *m, uid_t uid, sd_json_variant *parameters) {
@@ -118,7 +300,7 @@ static int process_managed_oom_message(Manager *m, uid_t uid, sd_json_variant *p
                 else
                         duration = m->default_mem_pressure_duration_usec;
 
-                r = oomd_insert_cgroup_context(NULL, monitor_hm, message.path);
+                r = oomd_insert_cgroup_context_full(&m->cgroup_files, NULL, monitor_hm, message.path);
                 if (r == -ENOMEM)
                         return r;
                 if (r < 0 && r != -EEXIST)
@@ -133,6 +315,11 @@ static int process_managed_oom_message(Manager *m, uid_t uid, sd_json_variant *p
                 }
         }
 
+        /* Pick up new or changed memory pressure monitored cgroups right away */
+        r = manager_wake_mem_pressure_monitor(m);
+        if (r < 0)
+                return r;
+
         /* Toggle wake-ups for "ManagedOOMSwap" if entries are present. */
         r = sd_event_source_set_enabled(m->swap_context_event_source,
                                         hashmap_isempty(m->monitored_swap_cgroup_contexts) ? SD_EVENT_OFF : SD_EVENT_ON);
@@ -196,7 +383,7 @@ finish:
  * populating the hashmap.
  *
  * 'new_h' is of the form { key: cgroup paths -> value: OomdCGroupContext } */
-static int recursively_get_cgroup_context(Hashmap *new_h, const char *path) {
+static int recursively_get_cgroup_context(Hashmap **files_cache, Hashmap *new_h, const char *path) {
         _cleanup_free_ char *subpath = NULL;
         _cleanup_closedir_ DIR *d = NULL;
         int r;
@@ -212,7 +399,7 @@ static int recursively_get_cgroup_context(Hashmap *new_h, const char *path) {
         if (r < 0)
                 return r;
         else if (r == 0) { /* No subgroups? We're a leaf node */
-                r = oomd_insert_cgroup_context(NULL, new_h, path);
+                r = oomd_insert_cgroup_context_full(files_cache, NULL, new_h, path);
                 if (r == -ENOMEM)
                         return r;
                 if (r < 0)
@@ -230,6 +417,14 @@ static int recursively_get_cgroup_context(Hashmap *new_h, const char *path) {
 
                 subpath = mfree(subpath);
 
+                /* Killing cannot free anything in subtrees without any processes, hence skip them right
+                 * away rather than reading the attributes of every cgroup in them. */
+                r = cg_is_empty_recursive(SYSTEMD_CGROUP_CONTROLLER, cg_path);
+                if (r == -ENOMEM)
+                        return r;
+                if (r > 0)
+                        continue;
+
                 r = cg_get_attribute_as_bool("memory", cg_path, "memory.oom.group", &oom_group);
                 /* The cgroup might be gone. Skip it as a candidate since we can't get information on it. */
                 if (r == -ENOMEM)
@@ -240,9 +435,9 @@ static int recursively_get_cgroup_context(Hashmap *new_h, const char *path) {
                 }
 
                 if (oom_group)
-                        r = oomd_insert_cgroup_context(NULL, new_h, cg_path);
+                        r = oomd_insert_cgroup_context_full(files_cache, NULL, new_h, cg_path);
                 else
-                        r = recursively_get_cgroup_context(new_h, cg_path);
+                        r = recursively_get_cgroup_context(files_cache, new_h, cg_path);
                 if (r == -ENOMEM)
                         return r;
                 if (r < 0)
@@ -252,7 +447,10 @@ static int recursively_get_cgroup_context(Hashmap *new_h, const char *path) {
         return 0;
 }
 
-static int update_monitored_cgroup_contexts(Hashmap **monitored_cgroups) {
+/* Re-read the contexts in 'monitored_cgroups'. Unless 'full' is set, only those cgroups are re-read whose
+ * pressure is approaching their limit, whose PSI trigger in 'triggers' fired, or which have no trigger at
+ * all. The contexts of all other cgroups are kept as they are. */
+static int update_monitored_cgroup_contexts(Hashmap **files_cache, Hashmap **monitored_cgroups, Hashmap *triggers, bool full) {
         _cleanup_hashmap_free_ Hashmap *new_base = NULL;
         OomdCGroupContext *ctx;
         int r;
@@ -264,8 +462,25 @@ static int update_monitored_cgroup_contexts(Hashmap **monitored_cgroups) {
                 return -ENOMEM;
 
         HASHMAP_FOREACH(ctx, *monitored_cgroups) {
+                OomdPressureTrigger *t;
+
+                t = hashmap_get(triggers, ctx->path);
+                if (t) {
+                        if (!full && !t->fired && !t->broken && !mem_pressure_approaching_limit(ctx)) {
+                                /* Nothing happened here, move the context over as is */
+                                r = hashmap_put(new_base, ctx->path, ctx);
+                                if (r < 0)
+                                        return r;
+
+                                assert_se(hashmap_remove(*monitored_cgroups, ctx->path) == ctx);
+                                continue;
+                        }
+
+                        t->fired = false;
+                }
+
                 /* Skip most errors since the cgroup we're trying to update might not exist anymore. */
-                r = oomd_insert_cgroup_context(*monitored_cgroups, new_base, ctx->path);
+                r = oomd_insert_cgroup_context_full(files_cache, *monitored_cgroups, new_base, ctx->path);
                 if (r == -ENOMEM)
                         return r;
                 if (r < 0 && !IN_SET(r, -EEXIST, -ENOENT))
@@ -278,7 +493,7 @@ static int update_monitored_cgroup_contexts(Hashmap **monitored_cgroups) {
         return 0;
 }
 
-static int get_monitored_cgroup_contexts_candidates(Hashmap *monitored_cgroups, Hashmap **ret_candidates) {
+static int get_monitored_cgroup_contexts_candidates(Hashmap **files_cache, Hashmap *monitored_cgroups, Hashmap **ret_candidates) {
         _cleanup_hashmap_free_ Hashmap *candidates = NULL;
         OomdCGroupContext *ctx;
         int r;
@@ -291,7 +506,7 @@ static int get_monitored_cgroup_contexts_candidates(Hashmap *monitored_cgroups,
                 return -ENOMEM;
 
         HASHMAP_FOREACH(ctx, monitored_cgroups) {
-                r = recursively_get_cgroup_context(candidates, ctx->path);
+                r = recursively_get_cgroup_context(files_cache, candidates, ctx->path);
                 if (r == -ENOMEM)
                         return r;
                 if (r < 0)
@@ -303,7 +518,7 @@ static int get_monitored_cgroup_contexts_candidates(Hashmap *monitored_cgroups,
         return 0;
 }
 
-static int update_monitored_cgroup_contexts_candidates(Hashmap *monitored_cgroups, Hashmap **candidates) {
+static int update_monitored_cgroup_contexts_candidates(Hashmap **files_cache, Hashmap *monitored_cgroups, Hashmap **candidates) {
         _cleanup_hashmap_free_ Hashmap *new_candidates = NULL;
         int r;
 
@@ -311,7 +526,7 @@ static int update_monitored_cgroup_contexts_candidates(Hashmap *monitored_cgroup
         assert(candidates);
         assert(*candidates);
 
-        r = get_monitored_cgroup_contexts_candidates(monitored_cgroups, &new_candidates);
+        r = get_monitored_cgroup_contexts_candidates(files_cache, monitored_cgroups, &new_candidates);
         if (r < 0)
                 return log_debug_errno(r, "Failed to get candidate contexts: %m");
 
@@ -323,6 +538,22 @@ static int update_monitored_cgroup_contexts_candidates(Hashmap *monitored_cgroup
         return 0;
 }
 
+/* Close the attribute files of cgroups that are in none of our hashmaps anymore */
+static void manager_prune_cgroup_files(Manager *m) {
+        OomdCGroupFiles *files;
+
+        assert(m);
+
+        HASHMAP_FOREACH(files, m->cgroup_files) {
+                if (hashmap_contains(m->monitored_mem_pressure_cgroup_contexts, files->path) ||
+                    hashmap_contains(m->monitored_mem_pressure_cgroup_contexts_candidates, files->path) ||
+                    hashmap_contains(m->monitored_swap_cgroup_contexts, files->path))
+                        continue;
+
+                oomd_cgroup_files_free(hashmap_remove(m->cgroup_files, files->path));
+        }
+}
+
 static int acquire_managed_oom_connect(Manager *m) {
         _cleanup_(sd_varlink_close_unrefp) sd_varlink *link = NULL;
         int r;
@@ -397,7 +628,7 @@ static int monitor_swap_contexts_handler(sd_event_source *s, uint64_t usec, void
                           m->system_context.swap_used, m->system_context.swap_total,
                           PERMYRIAD_AS_PERCENT_FORMAT_VAL(m->swap_used_limit_permyriad));
 
-                r = get_monitored_cgroup_contexts_candidates(m->monitored_swap_cgroup_contexts, &candidates);
+                r = get_monitored_cgroup_contexts_candidates(&m->cgroup_files, m->monitored_swap_cgroup_contexts, &candidates);
                 if (r == -ENOMEM)
                         return log_oom();
                 if (r < 0)
@@ -411,6 +642,8 @@ static int monitor_swap_contexts_handler(sd_event_source *s, uint64_t usec, void
                         log_notice_errno(r, "Failed to kill any cgroups based on swap: %m");
                 else {
                         if (selected && r > 0) {
+                                m->n_killed_memory_used++;
+
                                 log_notice("Killed %s due to memory used (%"PRIu64") / total (%"PRIu64") and "
                                            "swap used (%"PRIu64") / total (%"PRIu64") being more than "
                                            PERMYRIAD_AS_PERCENT_FORMAT_STR,
@@ -435,6 +668,25 @@ static int monitor_swap_contexts_handler(sd_event_source *s, uint64_t usec, void
         return 0;
 }
 
+static int manager_set_mem_pressure_idle(Manager *m, bool idle) {
+        int r;
+
+        assert(m);
+
+        if (idle != m->mem_pressure_idle)
+                log_debug("%s polling of memory pressure monitored cgroups.", idle ? "Suspending" : "Resuming");
+
+        m->mem_pressure_idle = idle;
+        if (!idle)
+                return 0;
+
+        r = sd_event_source_set_time_relative(m->mem_pressure_context_event_source, MEM_PRESSURE_IDLE_INTERVAL_USEC);
+        if (r < 0)
+                return log_error_errno(r, "Failed to set relative time for timer: %m");
+
+        return 0;
+}
+
 static void clear_candidate_hashmapp(Manager **m) {
         if (*m)
                 hashmap_clear((*m)->monitored_mem_pressure_cgroup_contexts_candidates);
@@ -445,8 +697,9 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
          * update the candidate data (in which case clear_candidates will be NULL). */
         _unused_ _cleanup_(clear_candidate_hashmapp) Manager *clear_candidates = userdata;
         _cleanup_set_free_ Set *targets = NULL;
-        bool in_post_action_delay = false;
+        bool in_post_action_delay = false, triggers_complete, full, idle;
         Manager *m = ASSERT_PTR(userdata);
+        OomdCGroupContext *ctx;
         usec_t usec_now;
         int r;
 
@@ -468,12 +721,30 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
                         return log_error_errno(r, "Failed to acquire varlink connection: %m");
         }
 
-        /* Return early if nothing is requesting memory pressure monitoring */
-        if (hashmap_isempty(m->monitored_mem_pressure_cgroup_contexts))
-                return 0;
+        manager_prune_cgroup_files(m);
+
+        /* Return early if nothing is requesting memory pressure monitoring. We are woken up again once
+         * something is. */
+        if (hashmap_isempty(m->monitored_mem_pressure_cgroup_contexts)) {
+                m->mem_pressure_triggers = hashmap_free(m->mem_pressure_triggers);
+                return manager_set_mem_pressure_idle(m, true);
+        }
+
+        r = manager_update_mem_pressure_triggers(m);
+        if (r == -ENOMEM)
+                return log_oom();
+        if (r < 0)
+                log_debug_errno(r, "Failed to update memory pressure triggers, ignoring: %m");
+        triggers_complete = r > 0;
+
+        /* Cgroups whose triggers did not fire are only re-read every idle interval, to make up for anything
+         * the triggers might have missed. */
+        full = usec_now >= usec_add(m->mem_pressure_last_full_update, MEM_PRESSURE_IDLE_INTERVAL_USEC);
+        if (full)
+                m->mem_pressure_last_full_update = usec_now;
 
         /* Update the cgroups used for detection/action */
-        r = update_monitored_cgroup_contexts(&m->monitored_mem_pressure_cgroup_contexts);
+        r = update_monitored_cgroup_contexts(&m->cgroup_files, &m->monitored_mem_pressure_cgroup_contexts, m->mem_pressure_triggers, full);
         if (r == -ENOMEM)
                 return log_oom();
         if (r < 0)
@@ -488,6 +759,19 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
                         m->mem_pressure_post_action_delay_start = 0;
         }
 
+        /* Keep polling every interval as long as any cgroup is getting close to its limit, otherwise wait
+         * for the triggers. */
+        idle = triggers_complete && !in_post_action_delay;
+        HASHMAP_FOREACH(ctx, m->monitored_mem_pressure_cgroup_contexts)
+                if (mem_pressure_approaching_limit(ctx)) {
+                        idle = false;
+                        break;
+                }
+
+        r = manager_set_mem_pressure_idle(m, idle);
+        if (r < 0)
+                return r;
+
         r = oomd_pressure_above(m->monitored_mem_pressure_cgroup_contexts, &targets);
         if (r == -ENOMEM)
                 return log_oom();
@@ -513,6 +797,7 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
                                   FORMAT_TIMESPAN(t->mem_pressure_duration_usec, USEC_PER_SEC));
 
                         r = update_monitored_cgroup_contexts_candidates(
+                                        &m->cgroup_files,
                                         m->monitored_mem_pressure_cgroup_contexts, &m->monitored_mem_pressure_cgroup_contexts_candidates);
                         if (r == -ENOMEM)
                                 return log_oom();
@@ -537,6 +822,8 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
                                  * pressure is still high. */
                                 m->mem_pressure_post_action_delay_start = usec_now;
                                 if (selected && r > 0) {
+                                        m->n_killed_memory_pressure++;
+
                                         log_notice("Killed %s due to memory pressure for %s being %lu.%02lu%% > %lu.%02lu%%"
                                                    " for > %s with reclaim activity",
                                                    selected, t->path,
@@ -568,6 +855,7 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
                                 continue;
 
                         r = update_monitored_cgroup_contexts_candidates(
+                                        &m->cgroup_files,
                                         m->monitored_mem_pressure_cgroup_contexts, &m->monitored_mem_pressure_cgroup_contexts_candidates);
                         if (r == -ENOMEM)
                                 return log_oom();
@@ -640,6 +928,7 @@ Manager* manager_free(Manager *m) {
         sd_varlink_close_unref(m->varlink_client);
         sd_event_source_unref(m->swap_context_event_source);
         sd_event_source_unref(m->mem_pressure_context_event_source);
+        hashmap_free(m->mem_pressure_triggers);
         sd_event_unref(m->event);
 
         hashmap_free(m->polkit_registry);
@@ -648,6 +937,7 @@ Manager* manager_free(Manager *m) {
         hashmap_free(m->monitored_swap_cgroup_contexts);
         hashmap_free(m->monitored_mem_pressure_cgroup_contexts);
         hashmap_free(m->monitored_mem_pressure_cgroup_contexts_candidates);
+        hashmap_free(m->cgroup_files);
 
         return mfree(m);
 }
@@ -736,6 +1026,57 @@ static int manager_connect_bus(Manager *m) {
         return 0;
 }
 
+static int metric_kills(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+        int r;
+
+        /* Same reasons as reported by the Killed D-Bus signal */
+        r = metric_append_value(array, f, "reason", "memory-used", m->n_killed_memory_used);
+        if (r < 0)
+                return r;
+
+        return metric_append_value(array, f, "reason", "memory-pressure", m->n_killed_memory_pressure);
+}
+
+static int metric_monitored_cgroups(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+        int r;
+
+        r = metric_append_value(array, f, "type", "swap", hashmap_size(m->monitored_swap_cgroup_contexts));
+        if (r < 0)
+                return r;
+
+        return metric_append_value(array, f, "type", "memory-pressure", hashmap_size(m->monitored_mem_pressure_cgroup_contexts));
+}
+
+static int metric_memory_used(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->system_context.mem_used);
+}
+
+static int metric_swap_used(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->system_context.swap_used);
+}
+
+static const MetricFamily manager_metric_families[] = {
+        { "io.systemd.oom.KillsTotal",       "Cgroups killed, or that would have been in dry-run mode, by reason", METRIC_COUNTER, metric_kills             },
+        { "io.systemd.oom.MonitoredCGroups", "Cgroups monitored, by type of limit",                                METRIC_GAUGE,   metric_monitored_cgroups },
+        { "io.systemd.oom.MemoryUsedBytes",  "Memory used by the system, as of the last check",                    METRIC_GAUGE,   metric_memory_used       },
+        { "io.systemd.oom.SwapUsedBytes",    "Swap used by the system, as of the last check",                      METRIC_GAUGE,   metric_swap_used         },
+        {}
+};
+
+static int vl_method_list_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_list(link, parameters, manager_metric_families, userdata);
+}
+
+static int vl_method_describe_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_describe(link, parameters, manager_metric_families);
+}
+
 static int manager_varlink_init(Manager *m, int fd) {
         _cleanup_(sd_varlink_server_unrefp) sd_varlink_server *s = NULL;
         int r;
@@ -750,6 +1091,7 @@ static int manager_varlink_init(Manager *m, int fd) {
         r = sd_varlink_server_add_interface_many(
                         s,
                         &vl_interface_io_systemd_oom,
+                        &vl_interface_io_systemd_Metrics,
                         &vl_interface_io_systemd_service);
         if (r < 0)
                 return log_error_errno(r, "Failed to add Varlink interfaces to varlink server: %m");
@@ -757,6 +1099,8 @@ static int manager_varlink_init(Manager *m, int fd) {
         r = sd_varlink_server_bind_method_many(
                         s,
                         "io.systemd.oom.ReportManagedOOMCGroups", process_managed_oom_request,
+                        "io.systemd.Metrics.List",                vl_method_list_metrics,
+                        "io.systemd.Metrics.Describe",            vl_method_describe_metrics,
                         "io.systemd.service.Ping",                varlink_method_ping,
                         "io.systemd.service.SetLogLevel",         varlink_method_set_log_level,
                         "io.systemd.service.GetEnvironment",      varlink_method_get_environment);
@@ -12,6 +12,12 @@
 #define SWAP_INTERVAL_USEC 150000 /* 0.15 seconds */
 /* Pressure counters are lagging (~2 seconds) compared to swap so polling too frequently just wastes CPU */
 #define MEM_PRESSURE_INTERVAL_USEC (1 * USEC_PER_SEC)
+/* While no monitored cgroup comes close to its memory pressure limit we rely on PSI triggers to wake us up, and
+ * only poll all monitored cgroups at this rate as a safety net. */
+#define MEM_PRESSURE_IDLE_INTERVAL_USEC (30 * USEC_PER_SEC)
+/* Window of the PSI triggers. The kernel requires multiples of 2s for unprivileged triggers. The triggers fire
+ * once pressure reaches half of the configured limit, so that we start polling before the limit is hit. */
+#define MEM_PRESSURE_TRIGGER_WINDOW_USEC (2 * USEC_PER_SEC)
 
 /* Take action if 10s of memory pressure > 60 for more than 30s. We use the "full" value from PSI so this is the
  * percentage of time all tasks were delayed (i.e. unproductive).
@@ -46,10 +52,25 @@ struct Manager {
         Hashmap *monitored_mem_pressure_cgroup_contexts;
         Hashmap *monitored_mem_pressure_cgroup_contexts_candidates;
 
+        /* k: cgroup paths -> v: OomdCGroupFiles
+         * Open attribute files of the cgroups in the hashmaps above, reused across intervals. */
+        Hashmap *cgroup_files;
+
         OomdSystemContext system_context;
 
+        /* k: cgroup paths -> v: OomdPressureTrigger
+         * PSI triggers on the memory.pressure files of the cgroups monitored for memory pressure. */
+        Hashmap *mem_pressure_triggers;
+        /* Whether we are currently relying on the triggers rather than polling every interval */
+        bool mem_pressure_idle;
+        usec_t mem_pressure_last_full_update;
+
         usec_t mem_pressure_post_action_delay_start;
 
+        /* How many cgroups were killed (or would have been, in dry-run mode), by reason */
+        uint64_t n_killed_memory_used;
+        uint64_t n_killed_memory_pressure;
+
         sd_event_source *swap_context_event_source;
         sd_event_source *mem_pressure_context_event_source;
 
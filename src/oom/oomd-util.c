@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <fcntl.h>
 #include <sys/xattr.h>
 #include <unistd.h>
 
@@ -401,9 +402,152 @@ int oomd_kill_by_swap_usage(Hashmap *h, uint64_t threshold_usage, bool dry_run,
         return ret;
 }
 
-int oomd_cgroup_context_acquire(const char *path, OomdCGroupContext **ret) {
+static const char* const oomd_cgroup_file_table[_OOMD_CGROUP_FILE_MAX] = {
+        [OOMD_CGROUP_FILE_MEMORY_PRESSURE]     = "memory.pressure",
+        [OOMD_CGROUP_FILE_MEMORY_CURRENT]      = "memory.current",
+        [OOMD_CGROUP_FILE_MEMORY_MIN]          = "memory.min",
+        [OOMD_CGROUP_FILE_MEMORY_LOW]          = "memory.low",
+        [OOMD_CGROUP_FILE_MEMORY_SWAP_CURRENT] = "memory.swap.current",
+        [OOMD_CGROUP_FILE_MEMORY_STAT]         = "memory.stat",
+};
+
+OomdCGroupFiles *oomd_cgroup_files_free(OomdCGroupFiles *files) {
+        if (!files)
+                return NULL;
+
+        close_many(files->fds, _OOMD_CGROUP_FILE_MAX);
+        free(files->path);
+        return mfree(files);
+}
+
+DEFINE_HASH_OPS_WITH_VALUE_DESTRUCTOR(
+                oomd_cgroup_files_hash_ops,
+                char,
+                path_hash_func,
+                path_compare,
+                OomdCGroupFiles,
+                oomd_cgroup_files_free);
+
+static int oomd_cgroup_files_get(Hashmap **cache, const char *path, OomdCGroupFiles **ret) {
+        _cleanup_(oomd_cgroup_files_freep) OomdCGroupFiles *files = NULL;
+        OomdCGroupFiles *existing;
+        int r;
+
+        assert(cache);
+        assert(path);
+        assert(ret);
+
+        existing = hashmap_get(*cache, path);
+        if (existing) {
+                *ret = existing;
+                return 0;
+        }
+
+        files = new(OomdCGroupFiles, 1);
+        if (!files)
+                return -ENOMEM;
+
+        files->path = strdup(path);
+        if (!files->path)
+                return -ENOMEM;
+
+        FOREACH_ELEMENT(fd, files->fds)
+                *fd = -EBADF;
+
+        r = hashmap_ensure_put(cache, &oomd_cgroup_files_hash_ops, files->path, files);
+        if (r < 0)
+                return r;
+
+        *ret = TAKE_PTR(files);
+        return 0;
+}
+
+static int oomd_cgroup_read_file(OomdCGroupFiles *files, const char *path, OomdCGroupFile file, char **ret) {
+        _cleanup_free_ char *p = NULL;
+        int r;
+
+        assert(path);
+        assert(file >= 0 && file < _OOMD_CGROUP_FILE_MAX);
+        assert(ret);
+
+        r = cg_get_path(SYSTEMD_CGROUP_CONTROLLER, path, oomd_cgroup_file_table[file], &p);
+        if (r < 0)
+                return r;
+
+        if (!files)
+                return read_full_virtual_file(p, ret, NULL);
+
+        for (bool retry = true;; retry = false) {
+                if (files->fds[file] < 0) {
+                        files->fds[file] = open(p, O_RDONLY|O_CLOEXEC|O_NOCTTY);
+                        if (files->fds[file] < 0)
+                                return -errno;
+                }
+
+                r = pread_virtual_file(files->fds[file], ret, NULL);
+                if (r >= 0 || r == -ENOMEM)
+                        return r;
+
+                /* The cgroup might have been removed (and maybe created again) since we opened the file,
+                 * in which case reading through the old fd fails. Try once more with a fresh fd. */
+                files->fds[file] = safe_close(files->fds[file]);
+                if (!retry)
+                        return r;
+        }
+}
+
+static int oomd_cgroup_read_file_as_uint64(OomdCGroupFiles *files, const char *path, OomdCGroupFile file, uint64_t *ret) {
+        _cleanup_free_ char *value = NULL;
+        int r;
+
+        assert(ret);
+
+        /* Same semantics as cg_get_attribute_as_uint64() */
+
+        r = oomd_cgroup_read_file(files, path, file, &value);
+        if (r == -ENOENT)
+                return -ENODATA;
+        if (r < 0)
+                return r;
+
+        delete_trailing_chars(value, NEWLINE);
+
+        if (streq(value, "max")) {
+                *ret = CGROUP_LIMIT_MAX;
+                return 0;
+        }
+
+        return safe_atou64(value, ret);
+}
+
+static int oomd_cgroup_read_pgscan(OomdCGroupFiles *files, const char *path, uint64_t *ret) {
+        _cleanup_free_ char *contents = NULL;
+        int r;
+
+        assert(ret);
+
+        r = oomd_cgroup_read_file(files, path, OOMD_CGROUP_FILE_MEMORY_STAT, &contents);
+        if (r < 0)
+                return r;
+
+        for (const char *p = contents; *p; p += strspn(p, NEWLINE)) {
+                size_t l = strcspn(p, NEWLINE);
+                const char *w;
+
+                w = first_word(p, "pgscan");
+                if (w)
+                        return safe_atou64(strndupa_safe(w, l - (w - p)), ret);
+
+                p += l;
+        }
+
+        return -ENXIO;
+}
+
+int oomd_cgroup_context_acquire_full(Hashmap **files_cache, const char *path, OomdCGroupContext **ret) {
         _cleanup_(oomd_cgroup_context_freep) OomdCGroupContext *ctx = NULL;
-        _cleanup_free_ char *p = NULL, *val = NULL;
+        _cleanup_free_ char *val = NULL;
+        OomdCGroupFiles *files = NULL;
         bool is_root;
         int r;
 
@@ -417,32 +561,38 @@ int oomd_cgroup_context_acquire(const char *path, OomdCGroupContext **ret) {
         is_root = empty_or_root(path);
         ctx->preference = MANAGED_OOM_PREFERENCE_NONE;
 
-        r = cg_get_path(SYSTEMD_CGROUP_CONTROLLER, path, "memory.pressure", &p);
+        if (files_cache) {
+                r = oomd_cgroup_files_get(files_cache, empty_to_root(path), &files);
+                if (r < 0)
+                        return r;
+        }
+
+        r = oomd_cgroup_read_file(files, path, OOMD_CGROUP_FILE_MEMORY_PRESSURE, &val);
         if (r < 0)
-                return log_debug_errno(r, "Error getting cgroup memory pressure path from %s: %m", path);
+                return log_debug_errno(r, "Error reading memory.pressure from %s: %m", path);
 
-        r = read_resource_pressure(p, PRESSURE_TYPE_FULL, &ctx->memory_pressure);
+        r = parse_resource_pressure(val, PRESSURE_TYPE_FULL, &ctx->memory_pressure);
         if (r < 0)
-                return log_debug_errno(r, "Error parsing memory pressure from %s: %m", p);
+                return log_debug_errno(r, "Error parsing memory pressure from %s: %m", path);
 
         if (is_root) {
                 r = procfs_memory_get_used(&ctx->current_memory_usage);
                 if (r < 0)
                         return log_debug_errno(r, "Error getting memory used from procfs: %m");
         } else {
-                r = cg_get_attribute_as_uint64(SYSTEMD_CGROUP_CONTROLLER, path, "memory.current", &ctx->current_memory_usage);
+                r = oomd_cgroup_read_file_as_uint64(files, path, OOMD_CGROUP_FILE_MEMORY_CURRENT, &ctx->current_memory_usage);
                 if (r < 0)
                         return log_debug_errno(r, "Error getting memory.current from %s: %m", path);
 
-                r = cg_get_attribute_as_uint64(SYSTEMD_CGROUP_CONTROLLER, path, "memory.min", &ctx->memory_min);
+                r = oomd_cgroup_read_file_as_uint64(files, path, OOMD_CGROUP_FILE_MEMORY_MIN, &ctx->memory_min);
                 if (r < 0)
                         return log_debug_errno(r, "Error getting memory.min from %s: %m", path);
 
-                r = cg_get_attribute_as_uint64(SYSTEMD_CGROUP_CONTROLLER, path, "memory.low", &ctx->memory_low);
+                r = oomd_cgroup_read_file_as_uint64(files, path, OOMD_CGROUP_FILE_MEMORY_LOW, &ctx->memory_low);
                 if (r < 0)
                         return log_debug_errno(r, "Error getting memory.low from %s: %m", path);
 
-                r = cg_get_attribute_as_uint64(SYSTEMD_CGROUP_CONTROLLER, path, "memory.swap.current", &ctx->swap_usage);
+                r = oomd_cgroup_read_file_as_uint64(files, path, OOMD_CGROUP_FILE_MEMORY_SWAP_CURRENT, &ctx->swap_usage);
                 if (r == -ENODATA)
                         /* The kernel can be compiled without support for memory.swap.* files,
                          * or it can be disabled with boot param 'swapaccount=0' */
@@ -450,13 +600,9 @@ int oomd_cgroup_context_acquire(const char *path, OomdCGroupContext **ret) {
                 else if (r < 0)
                         return log_debug_errno(r, "Error getting memory.swap.current from %s: %m", path);
 
-                r = cg_get_keyed_attribute(SYSTEMD_CGROUP_CONTROLLER, path, "memory.stat", STRV_MAKE("pgscan"), &val);
+                r = oomd_cgroup_read_pgscan(files, path, &ctx->pgscan);
                 if (r < 0)
                         return log_debug_errno(r, "Error getting pgscan from memory.stat under %s: %m", path);
-
-                r = safe_atou64(val, &ctx->pgscan);
-                if (r < 0)
-                        return log_debug_errno(r, "Error converting pgscan value to uint64_t: %m");
         }
 
         r = strdup_to(&ctx->path, empty_to_root(path));
@@ -543,7 +689,7 @@ int oomd_system_context_acquire(const char *proc_meminfo_path, OomdSystemContext
         return 0;
 }
 
-int oomd_insert_cgroup_context(Hashmap *old_h, Hashmap *new_h, const char *path) {
+int oomd_insert_cgroup_context_full(Hashmap **files_cache, Hashmap *old_h, Hashmap *new_h, const char *path) {
         _cleanup_(oomd_cgroup_context_freep) OomdCGroupContext *curr_ctx = NULL;
         OomdCGroupContext *old_ctx;
         int r;
@@ -553,7 +699,7 @@ int oomd_insert_cgroup_context(Hashmap *old_h, Hashmap *new_h, const char *path)
 
         path = empty_to_root(path);
 
-        r = oomd_cgroup_context_acquire(path, &curr_ctx);
+        r = oomd_cgroup_context_acquire_full(files_cache, path, &curr_ctx);
         if (r < 0)
                 return log_debug_errno(r, "Failed to get OomdCGroupContext for %s: %m", path);
 
@@ -13,6 +13,7 @@
 extern const struct hash_ops oomd_cgroup_ctx_hash_ops;
 
 typedef struct OomdCGroupContext OomdCGroupContext;
+typedef struct OomdCGroupFiles OomdCGroupFiles;
 typedef struct OomdSystemContext OomdSystemContext;
 
 typedef int (oomd_compare_t)(OomdCGroupContext * const *, OomdCGroupContext * const *);
@@ -40,6 +41,25 @@ struct OomdCGroupContext {
         usec_t mem_pressure_duration_usec;
 };
 
+typedef enum OomdCGroupFile {
+        OOMD_CGROUP_FILE_MEMORY_PRESSURE,
+        OOMD_CGROUP_FILE_MEMORY_CURRENT,
+        OOMD_CGROUP_FILE_MEMORY_MIN,
+        OOMD_CGROUP_FILE_MEMORY_LOW,
+        OOMD_CGROUP_FILE_MEMORY_SWAP_CURRENT,
+        OOMD_CGROUP_FILE_MEMORY_STAT,
+        _OOMD_CGROUP_FILE_MAX,
+        _OOMD_CGROUP_FILE_INVALID = -EINVAL,
+} OomdCGroupFile;
+
+/* The attribute files of a cgroup read when acquiring its OomdCGroupContext. They are opened on first use
+ * and then kept open, so that later reads are a single pread() each rather than a path lookup, open and
+ * close. */
+struct OomdCGroupFiles {
+        char *path;
+        int fds[_OOMD_CGROUP_FILE_MAX];
+};
+
 struct OomdSystemContext {
         uint64_t mem_total;
         uint64_t mem_used;
@@ -50,6 +70,12 @@ struct OomdSystemContext {
 OomdCGroupContext *oomd_cgroup_context_free(OomdCGroupContext *ctx);
 DEFINE_TRIVIAL_CLEANUP_FUNC(OomdCGroupContext*, oomd_cgroup_context_free);
 
+/* k: cgroup paths -> v: OomdCGroupFiles */
+extern const struct hash_ops oomd_cgroup_files_hash_ops;
+
+OomdCGroupFiles *oomd_cgroup_files_free(OomdCGroupFiles *files);
+DEFINE_TRIVIAL_CLEANUP_FUNC(OomdCGroupFiles*, oomd_cgroup_files_free);
+
 /* All hashmaps used with these functions are expected to be of the form
  * key: cgroup paths -> value: OomdCGroupContext. */
 
@@ -130,14 +156,22 @@ int oomd_cgroup_kill(const char *path, bool recurse, bool dry_run);
 int oomd_kill_by_pgscan_rate(Hashmap *h, const char *prefix, bool dry_run, char **ret_selected);
 int oomd_kill_by_swap_usage(Hashmap *h, uint64_t threshold_usage, bool dry_run, char **ret_selected);
 
-int oomd_cgroup_context_acquire(const char *path, OomdCGroupContext **ret);
+/* If `files_cache` is not NULL, the attribute files of the cgroup are kept open in it (see OomdCGroupFiles)
+ * and reused by later calls. */
+int oomd_cgroup_context_acquire_full(Hashmap **files_cache, const char *path, OomdCGroupContext **ret);
+static inline int oomd_cgroup_context_acquire(const char *path, OomdCGroupContext **ret) {
+        return oomd_cgroup_context_acquire_full(NULL, path, ret);
+}
 int oomd_system_context_acquire(const char *proc_swaps_path, OomdSystemContext *ret);
 
 /* Get the OomdCGroupContext of `path` and insert it into `new_h`. The key for the inserted context will be `path`.
  *
  * `old_h` is used to get data used to calculate prior interval information. `old_h` can be NULL in which case there
  * was no prior data to reference. */
-int oomd_insert_cgroup_context(Hashmap *old_h, Hashmap *new_h, const char *path);
+int oomd_insert_cgroup_context_full(Hashmap **files_cache, Hashmap *old_h, Hashmap *new_h, const char *path);
+static inline int oomd_insert_cgroup_context(Hashmap *old_h, Hashmap *new_h, const char *path) {
+        return oomd_insert_cgroup_context_full(NULL, old_h, new_h, path);
+}
 
 /* Update each OomdCGroupContext in `curr_h` with prior interval information from `old_h`. */
 void oomd_update_cgroup_contexts_between_hashmaps(Hashmap *old_h, Hashmap *curr_h);
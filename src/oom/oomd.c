@@ -17,6 +17,7 @@
 #include "parse-util.h"
 #include "pretty-print.h"
 #include "psi-util.h"
+#include "rlimit-util.h"
 #include "signal-util.h"
 
 static bool arg_dry_run = false;
@@ -145,6 +146,9 @@ static int run(int argc, char *argv[]) {
         if (!FLAGS_SET(mask, CGROUP_MASK_MEMORY))
                 return log_error_errno(SYNTHETIC_ERRNO(EOPNOTSUPP), "Requires the cgroup memory controller.");
 
+        /* We keep the attribute files of all monitored cgroups and kill candidates open */
+        (void) rlimit_nofile_bump(HIGH_RLIMIT_NOFILE);
+
         r = manager_new(&m);
         if (r < 0)
                 return log_error_errno(r, "Failed to create manager: %m");
@@ -91,10 +91,11 @@ static void test_oomd_cgroup_kill(void) {
 }
 
 static void test_oomd_cgroup_context_acquire_and_insert(void) {
-        _cleanup_hashmap_free_ Hashmap *h1 = NULL, *h2 = NULL;
+        _cleanup_hashmap_free_ Hashmap *h1 = NULL, *h2 = NULL, *files_cache = NULL;
         _cleanup_(oomd_cgroup_context_freep) OomdCGroupContext *ctx = NULL;
         _cleanup_free_ char *cgroup = NULL;
         OomdCGroupContext *c1, *c2;
+        OomdCGroupFiles *files;
         CGroupMask mask;
 
         if (geteuid() != 0)
@@ -126,6 +127,22 @@ static void test_oomd_cgroup_context_acquire_and_insert(void) {
         assert_se(oomd_cgroup_context_acquire("", &ctx) == 0);
         assert_se(streq(ctx->path, "/"));
         assert_se(ctx->current_memory_usage > 0);
+        ctx = oomd_cgroup_context_free(ctx);
+
+        /* The second acquisition rereads the files opened by the first one */
+        for (int i = 0; i < 2; i++) {
+                assert_se(oomd_cgroup_context_acquire_full(&files_cache, cgroup, &ctx) == 0);
+                assert_se(streq(ctx->path, cgroup));
+                assert_se(ctx->current_memory_usage > 0);
+                assert_se(ctx->memory_min == 0);
+                assert_se(ctx->memory_low == 0);
+                assert_se(ctx->pgscan == 0);
+                ctx = oomd_cgroup_context_free(ctx);
+        }
+        assert_se(hashmap_size(files_cache) == 1);
+        assert_se(files = hashmap_get(files_cache, cgroup));
+        assert_se(files->fds[OOMD_CGROUP_FILE_MEMORY_PRESSURE] >= 0);
+        assert_se(files->fds[OOMD_CGROUP_FILE_MEMORY_STAT] >= 0);
 
         /* Test hashmap inserts */
         assert_se(h1 = hashmap_new(&oomd_cgroup_ctx_hash_ops));
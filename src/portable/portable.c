@@ -349,128 +349,156 @@ static int extract_now(
         return 0;
 }
 
-static int portable_extract_by_path(
+typedef struct ExtractJob {
+        Image *image;
+        bool is_extension;
+
+        LoopDevice *loop_device;
+        DissectedImage *dissected_image;
+        char *tmpdir;
+        int fd;         /* Our end of the socket the child sends the metadata through */
+        pid_t pid;
+
+        PortableMetadata *os_release;
+        Hashmap *unit_files;
+} ExtractJob;
+
+static void extract_job_array_free(ExtractJob *jobs, size_t n_jobs) {
+        FOREACH_ARRAY(j, jobs, n_jobs) {
+                sigkill_waitp(&j->pid);
+                safe_close(j->fd);
+                rmdir_and_free(j->tmpdir);
+                dissected_image_unref(j->dissected_image);
+                loop_device_unref(j->loop_device);
+                portable_metadata_unref(j->os_release);
+                hashmap_free(j->unit_files);
+        }
+
+        free(jobs);
+}
+
+static int extract_job_start(
                 RuntimeScope scope,
-                const char *path,
-                bool path_is_extension,
+                ExtractJob *j,
                 bool relax_extension_release_check,
                 char **matches,
                 const ImagePolicy *image_policy,
-                PortableMetadata **ret_os_release,
-                Hashmap **ret_unit_files,
                 sd_bus_error *error) {
 
-        _cleanup_hashmap_free_ Hashmap *unit_files = NULL;
-        _cleanup_(portable_metadata_unrefp) PortableMetadata* os_release = NULL;
-        _cleanup_(loop_device_unrefp) LoopDevice *d = NULL;
         int r;
 
-        assert(path);
+        assert(j);
+        assert(j->image);
+
+        /* Sets up the image, and forks off a child that mounts it and sends us the metadata. This only
+         * starts the extraction, the results are collected by extract_job_finish(). */
 
         r = loop_device_make_by_path(
-                        path,
+                        j->image->path,
                         O_RDONLY,
                         /* sector_size= */ UINT32_MAX,
                         LO_FLAGS_PARTSCAN,
                         LOCK_SH,
-                        &d);
+                        &j->loop_device);
         if (r == -EISDIR) {
                 _cleanup_free_ char *image_name = NULL;
 
                 /* We can't turn this into a loop-back block device, and this returns EISDIR? Then this is a directory
                  * tree and not a raw device. It's easy then. */
 
-                r = path_extract_filename(path, &image_name);
+                r = path_extract_filename(j->image->path, &image_name);
                 if (r < 0)
-                        return log_error_errno(r, "Failed to extract image name from path '%s': %m", path);
+                        return log_error_errno(r, "Failed to extract image name from path '%s': %m", j->image->path);
 
-                r = extract_now(scope, path, matches, image_name, path_is_extension, /* relax_extension_release_check= */ false, -1, &os_release, &unit_files);
-                if (r < 0)
-                        return r;
+                return extract_now(scope, j->image->path, matches, image_name, j->is_extension, /* relax_extension_release_check= */ false, -1, &j->os_release, &j->unit_files);
 
         } else if (r < 0)
-                return log_debug_errno(r, "Failed to set up loopback device for %s: %m", path);
-        else {
-                _cleanup_(dissected_image_unrefp) DissectedImage *m = NULL;
-                _cleanup_(rmdir_and_freep) char *tmpdir = NULL;
-                _cleanup_close_pair_ int seq[2] = EBADF_PAIR;
-                _cleanup_(sigkill_waitp) pid_t child = 0;
-                DissectImageFlags flags =
-                        DISSECT_IMAGE_READ_ONLY |
-                        DISSECT_IMAGE_GENERIC_ROOT |
-                        DISSECT_IMAGE_REQUIRE_ROOT |
-                        DISSECT_IMAGE_DISCARD_ON_LOOP |
-                        DISSECT_IMAGE_RELAX_VAR_CHECK |
-                        DISSECT_IMAGE_USR_NO_ROOT |
-                        DISSECT_IMAGE_ADD_PARTITION_DEVICES |
-                        DISSECT_IMAGE_PIN_PARTITION_DEVICES |
-                        DISSECT_IMAGE_ALLOW_USERSPACE_VERITY;
-
-                if (path_is_extension)
-                        flags |= DISSECT_IMAGE_VALIDATE_OS_EXT | (relax_extension_release_check ? DISSECT_IMAGE_RELAX_EXTENSION_CHECK : 0);
-                else
-                        flags |= DISSECT_IMAGE_VALIDATE_OS;
+                return log_debug_errno(r, "Failed to set up loopback device for %s: %m", j->image->path);
+
+        _cleanup_close_pair_ int seq[2] = EBADF_PAIR;
+        DissectImageFlags flags =
+                DISSECT_IMAGE_READ_ONLY |
+                DISSECT_IMAGE_GENERIC_ROOT |
+                DISSECT_IMAGE_REQUIRE_ROOT |
+                DISSECT_IMAGE_DISCARD_ON_LOOP |
+                DISSECT_IMAGE_RELAX_VAR_CHECK |
+                DISSECT_IMAGE_USR_NO_ROOT |
+                DISSECT_IMAGE_ADD_PARTITION_DEVICES |
+                DISSECT_IMAGE_PIN_PARTITION_DEVICES |
+                DISSECT_IMAGE_ALLOW_USERSPACE_VERITY;
+
+        if (j->is_extension)
+                flags |= DISSECT_IMAGE_VALIDATE_OS_EXT | (relax_extension_release_check ? DISSECT_IMAGE_RELAX_EXTENSION_CHECK : 0);
+        else
+                flags |= DISSECT_IMAGE_VALIDATE_OS;
 
-                /* We now have a loopback block device, let's fork off a child in its own mount namespace, mount it
-                 * there, and extract the metadata we need. The metadata is sent from the child back to us. */
+        /* We now have a loopback block device, let's fork off a child in its own mount namespace, mount it
+         * there, and extract the metadata we need. The metadata is sent from the child back to us. */
 
-                BLOCK_SIGNALS(SIGCHLD);
+        r = mkdtemp_malloc("/tmp/inspect-XXXXXX", &j->tmpdir);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to create temporary directory: %m");
 
-                r = mkdtemp_malloc("/tmp/inspect-XXXXXX", &tmpdir);
-                if (r < 0)
-                        return log_debug_errno(r, "Failed to create temporary directory: %m");
-
-                r = dissect_loop_device(
-                                d,
-                                /* verity= */ NULL,
-                                /* mount_options= */ NULL,
-                                image_policy,
-                                flags,
-                                &m);
-                if (r == -ENOPKG)
-                        sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Couldn't identify a suitable partition table or file system in '%s'.", path);
-                else if (r == -EADDRNOTAVAIL)
-                        sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "No root partition for specified root hash found in '%s'.", path);
-                else if (r == -ENOTUNIQ)
-                        sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Multiple suitable root partitions found in image '%s'.", path);
-                else if (r == -ENXIO)
-                        sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "No suitable root partition found in image '%s'.", path);
-                else if (r == -EPROTONOSUPPORT)
-                        sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Device '%s' is loopback block device with partition scanning turned off, please turn it on.", path);
-                if (r < 0)
-                        return r;
+        r = dissect_loop_device(
+                        j->loop_device,
+                        /* verity= */ NULL,
+                        /* mount_options= */ NULL,
+                        image_policy,
+                        flags,
+                        &j->dissected_image);
+        if (r == -ENOPKG)
+                sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Couldn't identify a suitable partition table or file system in '%s'.", j->image->path);
+        else if (r == -EADDRNOTAVAIL)
+                sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "No root partition for specified root hash found in '%s'.", j->image->path);
+        else if (r == -ENOTUNIQ)
+                sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Multiple suitable root partitions found in image '%s'.", j->image->path);
+        else if (r == -ENXIO)
+                sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "No suitable root partition found in image '%s'.", j->image->path);
+        else if (r == -EPROTONOSUPPORT)
+                sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Device '%s' is loopback block device with partition scanning turned off, please turn it on.", j->image->path);
+        if (r < 0)
+                return r;
 
-                if (socketpair(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC, 0, seq) < 0)
-                        return log_debug_errno(errno, "Failed to allocated SOCK_SEQPACKET socket: %m");
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC, 0, seq) < 0)
+                return log_debug_errno(errno, "Failed to allocated SOCK_SEQPACKET socket: %m");
 
-                r = safe_fork("(sd-dissect)", FORK_RESET_SIGNALS|FORK_DEATHSIG_SIGTERM|FORK_NEW_MOUNTNS|FORK_MOUNTNS_SLAVE|FORK_LOG, &child);
-                if (r < 0)
-                        return r;
-                if (r == 0) {
-                        seq[0] = safe_close(seq[0]);
-
-                        r = dissected_image_mount(
-                                        m,
-                                        tmpdir,
-                                        /* uid_shift= */ UID_INVALID,
-                                        /* uid_range= */ UID_INVALID,
-                                        /* userns_fd= */ -EBADF,
-                                        flags);
-                        if (r < 0) {
-                                log_debug_errno(r, "Failed to mount dissected image: %m");
-                                goto child_finish;
-                        }
+        r = safe_fork("(sd-dissect)", FORK_RESET_SIGNALS|FORK_DEATHSIG_SIGTERM|FORK_NEW_MOUNTNS|FORK_MOUNTNS_SLAVE|FORK_LOG, &j->pid);
+        if (r < 0)
+                return r;
+        if (r == 0) {
+                seq[0] = safe_close(seq[0]);
+
+                r = dissected_image_mount(
+                                j->dissected_image,
+                                j->tmpdir,
+                                /* uid_shift= */ UID_INVALID,
+                                /* uid_range= */ UID_INVALID,
+                                /* userns_fd= */ -EBADF,
+                                flags);
+                if (r < 0) {
+                        log_debug_errno(r, "Failed to mount dissected image: %m");
+                        goto child_finish;
+                }
 
-                        r = extract_now(scope, tmpdir, matches, m->image_name, path_is_extension, relax_extension_release_check, seq[1], NULL, NULL);
+                r = extract_now(scope, j->tmpdir, matches, j->dissected_image->image_name, j->is_extension, relax_extension_release_check, seq[1], NULL, NULL);
 
-                child_finish:
-                        _exit(r < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
-                }
+        child_finish:
+                _exit(r < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+        }
+
+        j->fd = TAKE_FD(seq[0]);
+        return 0;
+}
+
+static int extract_job_finish(ExtractJob *j, sd_bus_error *error) {
+        int r;
 
-                seq[1] = safe_close(seq[1]);
+        assert(j);
+        assert(j->image);
 
-                unit_files = hashmap_new(&portable_metadata_hash_ops);
-                if (!unit_files)
+        if (j->pid > 0) {
+                j->unit_files = hashmap_new(&portable_metadata_hash_ops);
+                if (!j->unit_files)
                         return -ENOMEM;
 
                 for (;;) {
@@ -483,7 +511,7 @@ static int portable_extract_by_path(
                         char iov_buffer[PATH_MAX + NAME_MAX + 2];
                         struct iovec iov = IOVEC_MAKE(iov_buffer, sizeof(iov_buffer));
 
-                        ssize_t n = receive_one_fd_iov(seq[0], &iov, 1, 0, &fd);
+                        ssize_t n = receive_one_fd_iov(j->fd, &iov, 1, 0, &fd);
                         if (n == -EIO)
                                 break;
                         if (n < 0)
@@ -505,7 +533,7 @@ static int portable_extract_by_path(
                         assert(selinux_label);
                         selinux_label++;
 
-                        add = portable_metadata_new(iov_buffer, path, selinux_label, fd);
+                        add = portable_metadata_new(iov_buffer, j->image->path, selinux_label, fd);
                         if (!add)
                                 return -ENOMEM;
                         fd = -EBADF;
@@ -515,7 +543,7 @@ static int portable_extract_by_path(
                          * here. */
 
                         if (PORTABLE_METADATA_IS_UNIT(add)) {
-                                r = hashmap_put(unit_files, add->name, add);
+                                r = hashmap_put(j->unit_files, add->name, add);
                                 if (r < 0)
                                         return log_debug_errno(r, "Failed to add item to unit file list: %m");
 
@@ -523,30 +551,24 @@ static int portable_extract_by_path(
 
                         } else if (PORTABLE_METADATA_IS_OS_RELEASE(add) || PORTABLE_METADATA_IS_EXTENSION_RELEASE(add)) {
 
-                                assert(!os_release);
-                                os_release = TAKE_PTR(add);
+                                assert(!j->os_release);
+                                j->os_release = TAKE_PTR(add);
                         } else
                                 assert_not_reached();
                 }
 
-                r = wait_for_terminate_and_check("(sd-dissect)", child, 0);
+                r = wait_for_terminate_and_check("(sd-dissect)", j->pid, 0);
                 if (r < 0)
                         return r;
-                child = 0;
+                j->pid = 0;
         }
 
-        if (!os_release)
+        if (!j->os_release)
                 return sd_bus_error_setf(error,
                                          SD_BUS_ERROR_INVALID_ARGS,
                                          "Image '%s' lacks %s data, refusing.",
-                                         path,
-                                         path_is_extension ? "extension-release" : "os-release");
-
-        if (ret_unit_files)
-                *ret_unit_files = TAKE_PTR(unit_files);
-
-        if (ret_os_release)
-                *ret_os_release = TAKE_PTR(os_release);
+                                         j->image->path,
+                                         j->is_extension ? "extension-release" : "os-release");
 
         return 0;
 }
@@ -574,11 +596,15 @@ static int extract_image_and_extensions(
         _cleanup_hashmap_free_ Hashmap *unit_files = NULL;
         _cleanup_strv_free_ char **valid_prefixes = NULL;
         _cleanup_(image_unrefp) Image *image = NULL;
+        ExtractJob *jobs = NULL;
+        size_t n_jobs = 0;
         Image *ext;
         int r;
 
         assert(name_or_path);
 
+        CLEANUP_ARRAY(jobs, n_jobs, extract_job_array_free);
+
         /* If we get a path, then check if it can be resolved with vpick. We need this as we might just
          * get a simple image name, which would make vpick error out. */
         if (path_is_absolute(name_or_path)) {
@@ -648,18 +674,40 @@ static int extract_image_and_extensions(
                 }
         }
 
-        r = portable_extract_by_path(
-                        scope,
-                        image->path,
-                        /* path_is_extension= */ false,
-                        /* relax_extension_release_check= */ false,
-                        matches,
-                        image_policy,
-                        &os_release,
-                        &unit_files,
-                        error);
-        if (r < 0)
-                return r;
+        jobs = new(ExtractJob, 1 + ordered_hashmap_size(extension_images));
+        if (!jobs)
+                return -ENOMEM;
+
+        jobs[n_jobs++] = (ExtractJob) {
+                .image = image,
+                .fd = -EBADF,
+        };
+
+        ORDERED_HASHMAP_FOREACH(ext, extension_images)
+                jobs[n_jobs++] = (ExtractJob) {
+                        .image = ext,
+                        .is_extension = true,
+                        .fd = -EBADF,
+                };
+
+        /* Mounting the images and extracting the metadata from them happens in forked off children. Start
+         * all of them first, so that they run in parallel, and only then collect the results in order. */
+        BLOCK_SIGNALS(SIGCHLD);
+
+        FOREACH_ARRAY(j, jobs, n_jobs) {
+                r = extract_job_start(scope, j, j->is_extension && relax_extension_release_check, matches, image_policy, error);
+                if (r < 0)
+                        return r;
+        }
+
+        FOREACH_ARRAY(j, jobs, n_jobs) {
+                r = extract_job_finish(j, error);
+                if (r < 0)
+                        return r;
+        }
+
+        os_release = TAKE_PTR(jobs[0].os_release);
+        unit_files = TAKE_PTR(jobs[0].unit_files);
 
         /* If we are layering extension images on top of a runtime image, check that the os-release and
          * extension-release metadata match, otherwise reject it immediately as invalid, or it will fail when
@@ -685,26 +733,18 @@ static int extract_image_and_extensions(
                 }
         }
 
-        ORDERED_HASHMAP_FOREACH(ext, extension_images) {
+        FOREACH_ARRAY(j, jobs, n_jobs) {
                 _cleanup_(portable_metadata_unrefp) PortableMetadata *extension_release_meta = NULL;
-                _cleanup_hashmap_free_ Hashmap *extra_unit_files = NULL;
                 _cleanup_strv_free_ char **extension_release = NULL;
                 const char *e;
 
-                r = portable_extract_by_path(
-                                scope,
-                                ext->path,
-                                /* path_is_extension= */ true,
-                                relax_extension_release_check,
-                                matches,
-                                image_policy,
-                                &extension_release_meta,
-                                &extra_unit_files,
-                                error);
-                if (r < 0)
-                        return r;
+                if (!j->is_extension)
+                        continue;
+
+                ext = j->image;
+                extension_release_meta = TAKE_PTR(j->os_release);
 
-                r = hashmap_move(unit_files, extra_unit_files);
+                r = hashmap_move(unit_files, j->unit_files);
                 if (r < 0)
                         return r;
 
@@ -180,6 +180,7 @@ static char *arg_make_ddi = NULL;
 static char *arg_generate_fstab = NULL;
 static char *arg_generate_crypttab = NULL;
 static Set *arg_verity_settings = NULL;
+static unsigned arg_jobs = 1;
 
 STATIC_DESTRUCTOR_REGISTER(arg_node, freep);
 STATIC_DESTRUCTOR_REGISTER(arg_root, freep);
@@ -5170,7 +5171,182 @@ static int progress_bytes(uint64_t n_bytes, void *userdata) {
         return 0;
 }
 
+static bool partition_may_run_in_worker(const Partition *p) {
+        assert(p);
+
+        /* Worker processes operate on their own copy of the partition objects, hence anything they
+         * learn about a partition is lost when they exit. Encryption and Verity record such state (the
+         * volume key, the root hash, …), so handle those partitions in the main process. */
+        return p->encrypt == ENCRYPT_OFF && p->verity == VERITY_OFF;
+}
+
+static int context_run_partition_jobs(
+                Context *context,
+                Partition **jobs,
+                size_t n_jobs,
+                int (*job)(Context *context, Partition *p)) {
+
+        _cleanup_free_ pid_t *pids = NULL;
+        size_t n_pids = 0, n_workers;
+        int r, ret = 0;
+
+        assert(context);
+        assert(jobs || n_jobs == 0);
+        assert(job);
+
+        /* Runs the specified job for each of the specified partitions, spread over up to arg_jobs worker
+         * processes. Partitions are independent of each other at this point, each one is written to its
+         * own range of the image. */
+
+        n_workers = MIN(n_jobs, (size_t) arg_jobs);
+        if (n_workers <= 1) {
+                FOREACH_ARRAY(p, jobs, n_jobs) {
+                        r = job(context, *p);
+                        if (r < 0)
+                                return r;
+                }
+
+                return 0;
+        }
+
+        pids = new(pid_t, n_workers);
+        if (!pids)
+                return log_oom();
+
+        for (size_t w = 0; w < n_workers; w++) {
+                pid_t pid;
+                int k = 0;
+
+                r = safe_fork("(sd-repart)", FORK_RESET_SIGNALS|FORK_DEATHSIG_SIGTERM|FORK_LOG, &pid);
+                if (r > 0) {
+                        pids[n_pids++] = pid;
+                        continue;
+                }
+                if (r == 0) {
+                        int whole_fd, fd;
+
+                        /* The image is written to with lseek() + write(), hence give each worker its own
+                         * file offset by replacing the fd with a fresh open file description. */
+                        assert_se((whole_fd = fdisk_get_devfd(context->fdisk_context)) >= 0);
+
+                        fd = fd_reopen(whole_fd, O_RDWR|O_CLOEXEC|O_NOCTTY);
+                        if (fd < 0) {
+                                log_error_errno(fd, "Failed to reopen %s: %m", context->node);
+                                _exit(EXIT_FAILURE);
+                        }
+
+                        if (dup3(fd, whole_fd, O_CLOEXEC) < 0) {
+                                log_error_errno(errno, "Failed to replace file descriptor of %s: %m", context->node);
+                                _exit(EXIT_FAILURE);
+                        }
+
+                        safe_close(fd);
+                }
+
+                /* In the child, or forking failed, in which case we do this worker's share ourselves. */
+                for (size_t j = w; j < n_jobs; j += n_workers) {
+                        k = job(context, jobs[j]);
+                        if (k < 0)
+                                break;
+                }
+
+                if (r == 0)
+                        _exit(k < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+
+                RET_GATHER(ret, k);
+        }
+
+        FOREACH_ARRAY(pid, pids, n_pids) {
+                r = wait_for_terminate_and_check("(sd-repart)", *pid, WAIT_LOG);
+                if (r < 0)
+                        RET_GATHER(ret, r);
+                else if (r != EXIT_SUCCESS)
+                        RET_GATHER(ret, -EPROTO);
+        }
+
+        return ret;
+}
+
+static int partition_copy_blocks(Context *context, Partition *p) {
+        _cleanup_(partition_target_freep) PartitionTarget *t = NULL;
+        int r;
+
+        assert(context);
+        assert(p);
+        assert(p->copy_blocks_fd >= 0);
+        assert(p->new_size != UINT64_MAX);
+        assert(p->copy_blocks_size != UINT64_MAX);
+        assert(p->new_size >= p->copy_blocks_size + (p->encrypt != ENCRYPT_OFF ? LUKS2_METADATA_KEEP_FREE : 0));
+
+        usec_t start_timestamp = now(CLOCK_MONOTONIC);
+
+        r = partition_target_prepare(context, p, p->new_size,
+                                     /*need_path=*/ p->encrypt != ENCRYPT_OFF || p->siblings[VERITY_HASH],
+                                     &t);
+        if (r < 0)
+                return r;
+
+        if (p->encrypt != ENCRYPT_OFF && t->loop) {
+                r = partition_encrypt(context, p, t, /* offline = */ false);
+                if (r < 0)
+                        return r;
+        }
+
+        if (p->copy_blocks_offset == UINT64_MAX)
+                log_info("Copying in '%s' (%s) on block level into future partition %" PRIu64 ".",
+                         p->copy_blocks_path, FORMAT_BYTES(p->copy_blocks_size), p->partno);
+        else {
+                log_info("Copying in '%s' @ %" PRIu64 " (%s) on block level into future partition %" PRIu64 ".",
+                         p->copy_blocks_path, p->copy_blocks_offset, FORMAT_BYTES(p->copy_blocks_size), p->partno);
+
+                if (lseek(p->copy_blocks_fd, p->copy_blocks_offset, SEEK_SET) < 0)
+                        return log_error_errno(errno, "Failed to seek to copy blocks offset in %s: %m", p->copy_blocks_path);
+        }
+
+        r = copy_bytes_full(p->copy_blocks_fd, partition_target_fd(t), p->copy_blocks_size, COPY_REFLINK, /* ret_remains= */ NULL, /* ret_remains_size= */ NULL, arg_jobs > 1 ? NULL : progress_bytes, p);
+        clear_progress_bar(/* prefix= */ NULL);
+        if (r < 0)
+                return log_error_errno(r, "Failed to copy in data from '%s': %m", p->copy_blocks_path);
+
+        log_info("Copying in of '%s' on block level completed.", p->copy_blocks_path);
+
+        if (p->encrypt != ENCRYPT_OFF && !t->loop) {
+                r = partition_encrypt(context, p, t, /* offline = */ true);
+                if (r < 0)
+                        return r;
+        }
+
+        r = partition_target_sync(context, p, t);
+        if (r < 0)
+                return r;
+
+        usec_t time_spent = usec_sub_unsigned(now(CLOCK_MONOTONIC), start_timestamp);
+        if (time_spent > 250 * USEC_PER_MSEC) /* Show throughput, but not if we spent too little time on it, since it's just noise then */
+                log_info("Block level copying and synchronization of partition %" PRIu64 " complete in %s (%s/s).",
+                         p->partno, FORMAT_TIMESPAN(time_spent, 0), FORMAT_BYTES((uint64_t) ((double) p->copy_blocks_size / time_spent * USEC_PER_SEC)));
+        else
+                log_info("Block level copying and synchronization of partition %" PRIu64 " complete in %s.",
+                         p->partno, FORMAT_TIMESPAN(time_spent, 0));
+
+        if (p->siblings[VERITY_HASH] && !partition_type_defer(&p->siblings[VERITY_HASH]->type)) {
+                r = partition_format_verity_hash(context, p->siblings[VERITY_HASH],
+                                                 /* node = */ NULL, partition_target_path(t));
+                if (r < 0)
+                        return r;
+        }
+
+        if (p->siblings[VERITY_SIG] && !partition_type_defer(&p->siblings[VERITY_SIG]->type)) {
+                r = partition_format_verity_sig(context, p->siblings[VERITY_SIG]);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
 static int context_copy_blocks(Context *context) {
+        _cleanup_free_ Partition **jobs = NULL;
+        size_t n_jobs = 0;
         int r;
 
         assert(context);
@@ -5178,8 +5354,6 @@ static int context_copy_blocks(Context *context) {
         /* Copy in file systems on the block level */
 
         LIST_FOREACH(partitions, p, context->partitions) {
-                _cleanup_(partition_target_freep) PartitionTarget *t = NULL;
-
                 if (p->dropped)
                         continue;
 
@@ -5198,78 +5372,25 @@ static int context_copy_blocks(Context *context) {
 
                 assert(p->new_size != UINT64_MAX);
 
-                size_t extra = p->encrypt != ENCRYPT_OFF ? LUKS2_METADATA_KEEP_FREE : 0;
-
+                /* Settle on the size here rather than in partition_copy_blocks(), which might run in a
+                 * worker process. */
                 if (p->copy_blocks_size == UINT64_MAX)
-                        p->copy_blocks_size = LESS_BY(p->new_size, extra);
+                        p->copy_blocks_size = LESS_BY(p->new_size, p->encrypt != ENCRYPT_OFF ? LUKS2_METADATA_KEEP_FREE : 0);
 
-                assert(p->new_size >= p->copy_blocks_size + extra);
-
-                usec_t start_timestamp = now(CLOCK_MONOTONIC);
-
-                r = partition_target_prepare(context, p, p->new_size,
-                                             /*need_path=*/ p->encrypt != ENCRYPT_OFF || p->siblings[VERITY_HASH],
-                                             &t);
-                if (r < 0)
-                        return r;
-
-                if (p->encrypt != ENCRYPT_OFF && t->loop) {
-                        r = partition_encrypt(context, p, t, /* offline = */ false);
-                        if (r < 0)
-                                return r;
-                }
-
-                if (p->copy_blocks_offset == UINT64_MAX)
-                        log_info("Copying in '%s' (%s) on block level into future partition %" PRIu64 ".",
-                                 p->copy_blocks_path, FORMAT_BYTES(p->copy_blocks_size), p->partno);
-                else {
-                        log_info("Copying in '%s' @ %" PRIu64 " (%s) on block level into future partition %" PRIu64 ".",
-                                 p->copy_blocks_path, p->copy_blocks_offset, FORMAT_BYTES(p->copy_blocks_size), p->partno);
-
-                        if (lseek(p->copy_blocks_fd, p->copy_blocks_offset, SEEK_SET) < 0)
-                                return log_error_errno(errno, "Failed to seek to copy blocks offset in %s: %m", p->copy_blocks_path);
-                }
-
-                r = copy_bytes_full(p->copy_blocks_fd, partition_target_fd(t), p->copy_blocks_size, COPY_REFLINK, /* ret_remains= */ NULL, /* ret_remains_size= */ NULL, progress_bytes, p);
-                clear_progress_bar(/* prefix= */ NULL);
-                if (r < 0)
-                        return log_error_errno(r, "Failed to copy in data from '%s': %m", p->copy_blocks_path);
-
-                log_info("Copying in of '%s' on block level completed.", p->copy_blocks_path);
+                if (arg_jobs > 1 && partition_may_run_in_worker(p)) {
+                        if (!GREEDY_REALLOC(jobs, n_jobs + 1))
+                                return log_oom();
 
-                if (p->encrypt != ENCRYPT_OFF && !t->loop) {
-                        r = partition_encrypt(context, p, t, /* offline = */ true);
-                        if (r < 0)
-                                return r;
+                        jobs[n_jobs++] = p;
+                        continue;
                 }
 
-                r = partition_target_sync(context, p, t);
+                r = partition_copy_blocks(context, p);
                 if (r < 0)
                         return r;
-
-                usec_t time_spent = usec_sub_unsigned(now(CLOCK_MONOTONIC), start_timestamp);
-                if (time_spent > 250 * USEC_PER_MSEC) /* Show throughput, but not if we spent too little time on it, since it's just noise then */
-                        log_info("Block level copying and synchronization of partition %" PRIu64 " complete in %s (%s/s).",
-                                 p->partno, FORMAT_TIMESPAN(time_spent, 0), FORMAT_BYTES((uint64_t) ((double) p->copy_blocks_size / time_spent * USEC_PER_SEC)));
-                else
-                        log_info("Block level copying and synchronization of partition %" PRIu64 " complete in %s.",
-                                 p->partno, FORMAT_TIMESPAN(time_spent, 0));
-
-                if (p->siblings[VERITY_HASH] && !partition_type_defer(&p->siblings[VERITY_HASH]->type)) {
-                        r = partition_format_verity_hash(context, p->siblings[VERITY_HASH],
-                                                         /* node = */ NULL, partition_target_path(t));
-                        if (r < 0)
-                                return r;
-                }
-
-                if (p->siblings[VERITY_SIG] && !partition_type_defer(&p->siblings[VERITY_SIG]->type)) {
-                        r = partition_format_verity_sig(context, p->siblings[VERITY_SIG]);
-                        if (r < 0)
-                                return r;
-                }
         }
 
-        return 0;
+        return context_run_partition_jobs(context, jobs, n_jobs, partition_copy_blocks);
 }
 
 static int add_exclude_path(const char *path, Hashmap **denylist, DenyType type) {
@@ -6021,145 +6142,167 @@ static int finalize_extra_mkfs_options(const Partition *p, const char *root, cha
         return 0;
 }
 
-static int context_mkfs(Context *context) {
+static int partition_mkfs(Context *context, Partition *p) {
+        _cleanup_(rm_rf_physical_and_freep) char *root = NULL;
+        _cleanup_(partition_target_freep) PartitionTarget *t = NULL;
+        _cleanup_strv_free_ char **extra_mkfs_options = NULL;
         int r;
 
         assert(context);
+        assert(p);
+        assert(p->format);
+        assert(p->offset != UINT64_MAX);
+        assert(p->new_size != UINT64_MAX);
+        assert(p->new_size >= (p->encrypt != ENCRYPT_OFF ? LUKS2_METADATA_KEEP_FREE : 0));
+
+        /* If we're doing encryption, keep free space at the end which is required
+         * for cryptsetup's offline encryption. */
+        r = partition_target_prepare(context, p,
+                                     p->new_size - (p->encrypt != ENCRYPT_OFF ? LUKS2_METADATA_KEEP_FREE : 0),
+                                     /*need_path=*/ true,
+                                     &t);
+        if (r < 0)
+                return r;
 
-        /* Make a file system */
+        if (p->encrypt != ENCRYPT_OFF && t->loop) {
+                r = partition_target_grow(t, p->new_size);
+                if (r < 0)
+                        return r;
 
-        LIST_FOREACH(partitions, p, context->partitions) {
-                _cleanup_(rm_rf_physical_and_freep) char *root = NULL;
-                _cleanup_(partition_target_freep) PartitionTarget *t = NULL;
-                _cleanup_strv_free_ char **extra_mkfs_options = NULL;
+                r = partition_encrypt(context, p, t, /* offline = */ false);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to encrypt device: %m");
+        }
 
-                if (p->dropped)
-                        continue;
+        log_info("Formatting future partition %" PRIu64 ".", p->partno);
 
-                if (PARTITION_EXISTS(p)) /* Never format existing partitions */
-                        continue;
+        /* If we're not writing to a loop device or if we're populating a read-only filesystem, we
+         * have to populate using the filesystem's mkfs's --root (or equivalent) option. To do that,
+         * we need to set up the final directory tree beforehand. */
 
-                if (!p->format)
-                        continue;
+        if (partition_needs_populate(p) && (!t->loop || fstype_is_ro(p->format))) {
+                if (!mkfs_supports_root_option(p->format))
+                        return log_error_errno(SYNTHETIC_ERRNO(ENODEV),
+                                                "Loop device access is required to populate %s filesystems.",
+                                                p->format);
 
-                if (partition_type_defer(&p->type))
-                        continue;
+                r = partition_populate_directory(context, p, &root);
+                if (r < 0)
+                        return r;
+        }
 
-                /* For offline signing case */
-                if (!set_isempty(arg_verity_settings) && IN_SET(p->type.designator, PARTITION_ROOT_VERITY_SIG, PARTITION_USR_VERITY_SIG))
-                        return partition_format_verity_sig(context, p);
+        r = finalize_extra_mkfs_options(p, root, &extra_mkfs_options);
+        if (r < 0)
+                return r;
 
-                /* Minimized partitions will use the copy blocks logic so skip those here. */
-                if (p->copy_blocks_fd >= 0)
-                        continue;
+        r = make_filesystem(partition_target_path(t), p->format, strempty(p->new_label), root,
+                            p->fs_uuid, arg_discard,
+                            /* quiet = */ streq(p->format, "erofs") && !DEBUG_LOGGING,
+                            context->fs_sector_size, p->compression, p->compression_level,
+                            extra_mkfs_options);
+        if (r < 0)
+                return r;
 
-                assert(p->offset != UINT64_MAX);
-                assert(p->new_size != UINT64_MAX);
-                assert(p->new_size >= (p->encrypt != ENCRYPT_OFF ? LUKS2_METADATA_KEEP_FREE : 0));
+        /* The mkfs binary we invoked might have removed our temporary file when we're not operating
+         * on a loop device, so open the file again to make sure our file descriptor points to actual
+         * new file. */
 
-                /* If we're doing encryption, keep free space at the end which is required
-                 * for cryptsetup's offline encryption. */
-                r = partition_target_prepare(context, p,
-                                             p->new_size - (p->encrypt != ENCRYPT_OFF ? LUKS2_METADATA_KEEP_FREE : 0),
-                                             /*need_path=*/ true,
-                                             &t);
-                if (r < 0)
-                        return r;
+        if (t->fd >= 0 && t->path && !t->loop) {
+                safe_close(t->fd);
+                t->fd = open(t->path, O_RDWR|O_CLOEXEC);
+                if (t->fd < 0)
+                        return log_error_errno(errno, "Failed to reopen temporary file: %m");
+        }
 
-                if (p->encrypt != ENCRYPT_OFF && t->loop) {
-                        r = partition_target_grow(t, p->new_size);
-                        if (r < 0)
-                                return r;
+        log_info("Successfully formatted future partition %" PRIu64 ".", p->partno);
 
-                        r = partition_encrypt(context, p, t, /* offline = */ false);
-                        if (r < 0)
-                                return log_error_errno(r, "Failed to encrypt device: %m");
-                }
+        /* If we're writing to a loop device, we can now mount the empty filesystem and populate it. */
+        if (partition_needs_populate(p) && !root) {
+                assert(t->loop);
 
-                log_info("Formatting future partition %" PRIu64 ".", p->partno);
+                r = partition_populate_filesystem(context, p, partition_target_path(t));
+                if (r < 0)
+                        return r;
+        }
 
-                /* If we're not writing to a loop device or if we're populating a read-only filesystem, we
-                 * have to populate using the filesystem's mkfs's --root (or equivalent) option. To do that,
-                 * we need to set up the final directory tree beforehand. */
+        if (p->encrypt != ENCRYPT_OFF && !t->loop) {
+                r = partition_target_grow(t, p->new_size);
+                if (r < 0)
+                        return r;
 
-                if (partition_needs_populate(p) && (!t->loop || fstype_is_ro(p->format))) {
-                        if (!mkfs_supports_root_option(p->format))
-                                return log_error_errno(SYNTHETIC_ERRNO(ENODEV),
-                                                        "Loop device access is required to populate %s filesystems.",
-                                                        p->format);
+                r = partition_encrypt(context, p, t, /* offline = */ true);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to encrypt device: %m");
+        }
 
-                        r = partition_populate_directory(context, p, &root);
-                        if (r < 0)
-                                return r;
-                }
+        /* Note that we always sync explicitly here, since mkfs.fat doesn't do that on its own, and
+         * if we don't sync before detaching a block device the in-flight sectors possibly won't hit
+         * the disk. */
 
-                r = finalize_extra_mkfs_options(p, root, &extra_mkfs_options);
+        r = partition_target_sync(context, p, t);
+        if (r < 0)
+                return r;
+
+        if (p->siblings[VERITY_HASH] && !partition_type_defer(&p->siblings[VERITY_HASH]->type)) {
+                r = partition_format_verity_hash(context, p->siblings[VERITY_HASH],
+                                                 /* node = */ NULL, partition_target_path(t));
                 if (r < 0)
                         return r;
+        }
 
-                r = make_filesystem(partition_target_path(t), p->format, strempty(p->new_label), root,
-                                    p->fs_uuid, arg_discard,
-                                    /* quiet = */ streq(p->format, "erofs") && !DEBUG_LOGGING,
-                                    context->fs_sector_size, p->compression, p->compression_level,
-                                    extra_mkfs_options);
+        if (p->siblings[VERITY_SIG] && !partition_type_defer(&p->siblings[VERITY_SIG]->type)) {
+                r = partition_format_verity_sig(context, p->siblings[VERITY_SIG]);
                 if (r < 0)
                         return r;
+        }
 
-                /* The mkfs binary we invoked might have removed our temporary file when we're not operating
-                 * on a loop device, so open the file again to make sure our file descriptor points to actual
-                 * new file. */
+        return 0;
+}
 
-                if (t->fd >= 0 && t->path && !t->loop) {
-                        safe_close(t->fd);
-                        t->fd = open(t->path, O_RDWR|O_CLOEXEC);
-                        if (t->fd < 0)
-                                return log_error_errno(errno, "Failed to reopen temporary file: %m");
-                }
+static int context_mkfs(Context *context) {
+        _cleanup_free_ Partition **jobs = NULL;
+        size_t n_jobs = 0;
+        int r;
 
-                log_info("Successfully formatted future partition %" PRIu64 ".", p->partno);
+        assert(context);
 
-                /* If we're writing to a loop device, we can now mount the empty filesystem and populate it. */
-                if (partition_needs_populate(p) && !root) {
-                        assert(t->loop);
+        /* Make a file system */
 
-                        r = partition_populate_filesystem(context, p, partition_target_path(t));
-                        if (r < 0)
-                                return r;
-                }
+        LIST_FOREACH(partitions, p, context->partitions) {
+                if (p->dropped)
+                        continue;
 
-                if (p->encrypt != ENCRYPT_OFF && !t->loop) {
-                        r = partition_target_grow(t, p->new_size);
-                        if (r < 0)
-                                return r;
+                if (PARTITION_EXISTS(p)) /* Never format existing partitions */
+                        continue;
 
-                        r = partition_encrypt(context, p, t, /* offline = */ true);
-                        if (r < 0)
-                                return log_error_errno(r, "Failed to encrypt device: %m");
-                }
+                if (!p->format)
+                        continue;
 
-                /* Note that we always sync explicitly here, since mkfs.fat doesn't do that on its own, and
-                 * if we don't sync before detaching a block device the in-flight sectors possibly won't hit
-                 * the disk. */
+                if (partition_type_defer(&p->type))
+                        continue;
 
-                r = partition_target_sync(context, p, t);
-                if (r < 0)
-                        return r;
+                /* For offline signing case */
+                if (!set_isempty(arg_verity_settings) && IN_SET(p->type.designator, PARTITION_ROOT_VERITY_SIG, PARTITION_USR_VERITY_SIG))
+                        return partition_format_verity_sig(context, p);
 
-                if (p->siblings[VERITY_HASH] && !partition_type_defer(&p->siblings[VERITY_HASH]->type)) {
-                        r = partition_format_verity_hash(context, p->siblings[VERITY_HASH],
-                                                         /* node = */ NULL, partition_target_path(t));
-                        if (r < 0)
-                                return r;
-                }
+                /* Minimized partitions will use the copy blocks logic so skip those here. */
+                if (p->copy_blocks_fd >= 0)
+                        continue;
 
-                if (p->siblings[VERITY_SIG] && !partition_type_defer(&p->siblings[VERITY_SIG]->type)) {
-                        r = partition_format_verity_sig(context, p->siblings[VERITY_SIG]);
-                        if (r < 0)
-                                return r;
+                if (arg_jobs > 1 && partition_may_run_in_worker(p)) {
+                        if (!GREEDY_REALLOC(jobs, n_jobs + 1))
+                                return log_oom();
+
+                        jobs[n_jobs++] = p;
+                        continue;
                 }
+
+                r = partition_mkfs(context, p);
+                if (r < 0)
+                        return r;
         }
 
-        return 0;
+        return context_run_partition_jobs(context, jobs, n_jobs, partition_mkfs);
 }
 
 static int partition_acquire_uuid(Context *context, Partition *p, sd_id128_t *ret) {
@@ -7960,6 +8103,7 @@ static int help(void) {
                "     --size=BYTES         Grow loopback file to specified size\n"
                "     --seed=UUID          128-bit seed UUID to derive all UUIDs from\n"
                "     --split=BOOL         Whether to generate split artifacts\n"
+               "     --jobs=N             Format and populate up to N partitions in parallel\n"
                "\n%3$sOutput:%4$s\n"
                "     --pretty=BOOL        Whether to show pretty summary before doing changes\n"
                "     --json=pretty|short|off\n"
@@ -8074,6 +8218,7 @@ static int parse_argv(int argc, char *argv[], X509 **ret_certificate, EVP_PKEY *
                 ARG_TPM2_PUBLIC_KEY_PCRS,
                 ARG_TPM2_PCRLOCK,
                 ARG_SPLIT,
+                ARG_JOBS,
                 ARG_INCLUDE_PARTITIONS,
                 ARG_EXCLUDE_PARTITIONS,
                 ARG_DEFER_PARTITIONS,
@@ -8120,6 +8265,7 @@ static int parse_argv(int argc, char *argv[], X509 **ret_certificate, EVP_PKEY *
                 { "tpm2-public-key-pcrs", required_argument, NULL, ARG_TPM2_PUBLIC_KEY_PCRS },
                 { "tpm2-pcrlock",         required_argument, NULL, ARG_TPM2_PCRLOCK         },
                 { "split",                required_argument, NULL, ARG_SPLIT                },
+                { "jobs",                 required_argument, NULL, ARG_JOBS                 },
                 { "include-partitions",   required_argument, NULL, ARG_INCLUDE_PARTITIONS   },
                 { "exclude-partitions",   required_argument, NULL, ARG_EXCLUDE_PARTITIONS   },
                 { "defer-partitions",     required_argument, NULL, ARG_DEFER_PARTITIONS     },
@@ -8405,6 +8551,14 @@ static int parse_argv(int argc, char *argv[], X509 **ret_certificate, EVP_PKEY *
                         arg_split = r;
                         break;
 
+                case ARG_JOBS:
+                        r = safe_atou(optarg, &arg_jobs);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse --jobs= argument: %s", optarg);
+                        if (arg_jobs == 0)
+                                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "The argument to --jobs= must be positive.");
+                        break;
+
                 case ARG_INCLUDE_PARTITIONS:
                         if (arg_filter_partitions_type == FILTER_PARTITIONS_EXCLUDE)
                                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
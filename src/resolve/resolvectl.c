@@ -1132,6 +1132,65 @@ static int verb_tlsa(int argc, char **argv, void *userdata) {
         return ret;
 }
 
+static int table_add_latency(Table *table, const char *title, sd_json_variant *histogram) {
+        uint64_t n[DNS_LATENCY_BUCKETS] = {}, total = 0;
+        _cleanup_free_ char *s = NULL;
+        int r;
+
+        assert(table);
+        assert(title);
+
+        /* Summarizes a latency histogram as reported by DumpStatistics as a few percentiles */
+
+        if (!histogram)
+                return 0;
+        if (!sd_json_variant_is_array(histogram))
+                return log_error_errno(SYNTHETIC_ERRNO(EBADMSG), "Latency histogram is not an array.");
+
+        for (size_t i = 0; i < MIN(sd_json_variant_elements(histogram), (size_t) DNS_LATENCY_BUCKETS); i++) {
+                sd_json_variant *e = sd_json_variant_by_index(histogram, i);
+
+                if (!sd_json_variant_is_unsigned(e))
+                        return log_error_errno(SYNTHETIC_ERRNO(EBADMSG), "Latency histogram entry is not an unsigned integer.");
+
+                n[i] = sd_json_variant_unsigned(e);
+                total += n[i];
+        }
+
+        if (total == 0)
+                return 0;
+
+        if (asprintf(&s, "%" PRIu64 " replies", total) < 0)
+                return log_oom();
+
+        FOREACH_ELEMENT(q, ((const unsigned[]) { 50, 90, 99 })) {
+                uint64_t sum = 0;
+                unsigned b;
+
+                for (b = 0; b < DNS_LATENCY_BUCKETS - 1; b++) {
+                        sum += n[b];
+                        if (sum * 100 >= total * *q)
+                                break;
+                }
+
+                if (b < DNS_LATENCY_BUCKETS - 1)
+                        r = strextendf(&s, ", %u%% < %s", *q, FORMAT_TIMESPAN(dns_latency_bucket_max(b), USEC_PER_MSEC));
+                else
+                        r = strextendf(&s, ", %u%% >= %s", *q, FORMAT_TIMESPAN(dns_latency_bucket_max(b - 1), USEC_PER_MSEC));
+                if (r < 0)
+                        return log_oom();
+        }
+
+        r = table_add_many(table,
+                           TABLE_FIELD, title,
+                           TABLE_STRING, s,
+                           TABLE_SET_ALIGN_PERCENT, 100);
+        if (r < 0)
+                return table_log_add_error(r);
+
+        return 0;
+}
+
 static int show_statistics(int argc, char **argv, void *userdata) {
         _cleanup_(table_unrefp) Table *table = NULL;
         sd_json_variant *reply = NULL;
@@ -1159,12 +1218,14 @@ static int show_statistics(int argc, char **argv, void *userdata) {
                 sd_json_variant *transactions;
                 sd_json_variant *cache;
                 sd_json_variant *dnssec;
-        } statistics;
+                sd_json_variant *latency;
+        } statistics = {};
 
         static const sd_json_dispatch_field statistics_dispatch_table[] = {
                 { "transactions", SD_JSON_VARIANT_OBJECT, sd_json_dispatch_variant_noref, offsetof(struct statistics, transactions), SD_JSON_MANDATORY },
                 { "cache",        SD_JSON_VARIANT_OBJECT, sd_json_dispatch_variant_noref, offsetof(struct statistics, cache),        SD_JSON_MANDATORY },
                 { "dnssec",       SD_JSON_VARIANT_OBJECT, sd_json_dispatch_variant_noref, offsetof(struct statistics, dnssec),       SD_JSON_MANDATORY },
+                { "latency",      SD_JSON_VARIANT_OBJECT, sd_json_dispatch_variant_noref, offsetof(struct statistics, latency),      0                 },
                 {},
         };
 
@@ -1173,6 +1234,7 @@ static int show_statistics(int argc, char **argv, void *userdata) {
                 return r;
 
         struct transactions {
+                uint64_t n_stub_queries_total;
                 uint64_t n_current_transactions;
                 uint64_t n_transactions_total;
                 uint64_t n_timeouts_total;
@@ -1188,6 +1250,7 @@ static int show_statistics(int argc, char **argv, void *userdata) {
                 { "totalTimeoutsServedStale",        _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct transactions, n_timeouts_served_stale_total),          SD_JSON_MANDATORY },
                 { "totalFailedResponses",            _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct transactions, n_failure_responses_total),              SD_JSON_MANDATORY },
                 { "totalFailedResponsesServedStale", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct transactions, n_failure_responses_served_stale_total), SD_JSON_MANDATORY },
+                { "totalStubQueries",                _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct transactions, n_stub_queries_total),                   0                 },
                 {},
         };
 
@@ -1199,12 +1262,18 @@ static int show_statistics(int argc, char **argv, void *userdata) {
                 uint64_t cache_size;
                 uint64_t n_cache_hit;
                 uint64_t n_cache_miss;
-        } cache;
+                uint64_t n_cache_prefetch;
+                uint64_t cache_bytes;
+                uint64_t n_cache_rejected;
+        } cache = {};
 
         static const sd_json_dispatch_field cache_dispatch_table[] = {
-                { "size",   _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct cache, cache_size),   SD_JSON_MANDATORY },
-                { "hits",   _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct cache, n_cache_hit),  SD_JSON_MANDATORY },
-                { "misses", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct cache, n_cache_miss), SD_JSON_MANDATORY },
+                { "size",       _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct cache, cache_size),       SD_JSON_MANDATORY },
+                { "hits",       _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct cache, n_cache_hit),      SD_JSON_MANDATORY },
+                { "misses",     _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct cache, n_cache_miss),     SD_JSON_MANDATORY },
+                { "prefetches", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct cache, n_cache_prefetch), 0                 },
+                { "bytes",      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct cache, cache_bytes),      0                 },
+                { "rejected",   _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct cache, n_cache_rejected), 0                 },
                 {},
         };
 
@@ -1217,13 +1286,15 @@ static int show_statistics(int argc, char **argv, void *userdata) {
                 uint64_t n_dnssec_insecure;
                 uint64_t n_dnssec_bogus;
                 uint64_t n_dnssec_indeterminate;
-        } dnsssec;
+                uint64_t n_dnssec_verifications_cached;
+        } dnsssec = {};
 
         static const sd_json_dispatch_field dnssec_dispatch_table[] = {
-                { "secure",        _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct dnsssec, n_dnssec_secure),        SD_JSON_MANDATORY },
-                { "insecure",      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct dnsssec, n_dnssec_insecure),      SD_JSON_MANDATORY },
-                { "bogus",         _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct dnsssec, n_dnssec_bogus),         SD_JSON_MANDATORY },
-                { "indeterminate", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct dnsssec, n_dnssec_indeterminate), SD_JSON_MANDATORY },
+                { "secure",              _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct dnsssec, n_dnssec_secure),               SD_JSON_MANDATORY },
+                { "insecure",            _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct dnsssec, n_dnssec_insecure),             SD_JSON_MANDATORY },
+                { "bogus",               _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct dnsssec, n_dnssec_bogus),                SD_JSON_MANDATORY },
+                { "indeterminate",       _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct dnsssec, n_dnssec_indeterminate),        SD_JSON_MANDATORY },
+                { "verificationsCached", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64, offsetof(struct dnsssec, n_dnssec_verifications_cached), 0                 },
                 {},
         };
 
@@ -1246,6 +1317,8 @@ static int show_statistics(int argc, char **argv, void *userdata) {
                            TABLE_SET_ALIGN_PERCENT, 100,
                            TABLE_FIELD, "Total Transactions",
                            TABLE_UINT64, transactions.n_transactions_total,
+                           TABLE_FIELD, "Total Stub Queries",
+                           TABLE_UINT64, transactions.n_stub_queries_total,
                            TABLE_EMPTY, TABLE_EMPTY,
                            TABLE_STRING, "Cache",
                            TABLE_SET_COLOR, ansi_highlight(),
@@ -1254,10 +1327,16 @@ static int show_statistics(int argc, char **argv, void *userdata) {
                            TABLE_FIELD, "Current Cache Size",
                            TABLE_SET_ALIGN_PERCENT, 100,
                            TABLE_UINT64, cache.cache_size,
+                           TABLE_FIELD, "Current Cache Memory",
+                           TABLE_SIZE, cache.cache_bytes,
                            TABLE_FIELD, "Cache Hits",
                            TABLE_UINT64, cache.n_cache_hit,
                            TABLE_FIELD, "Cache Misses",
                            TABLE_UINT64, cache.n_cache_miss,
+                           TABLE_FIELD, "Cache Prefetches",
+                           TABLE_UINT64, cache.n_cache_prefetch,
+                           TABLE_FIELD, "Cache Entries Refused",
+                           TABLE_UINT64, cache.n_cache_rejected,
                            TABLE_EMPTY, TABLE_EMPTY,
                            TABLE_STRING, "Failure Transactions",
                            TABLE_SET_COLOR, ansi_highlight(),
@@ -1285,11 +1364,41 @@ static int show_statistics(int argc, char **argv, void *userdata) {
                            TABLE_FIELD, "Bogus",
                            TABLE_UINT64, dnsssec.n_dnssec_bogus,
                            TABLE_FIELD, "Indeterminate",
-                           TABLE_UINT64, dnsssec.n_dnssec_indeterminate
+                           TABLE_UINT64, dnsssec.n_dnssec_indeterminate,
+                           TABLE_FIELD, "Cached Verifications",
+                           TABLE_UINT64, dnsssec.n_dnssec_verifications_cached
                           );
         if (r < 0)
                 return table_log_add_error(r);
 
+        if (statistics.latency) {
+                static const struct {
+                        const char *field;
+                        const char *title;
+                } protocols[] = {
+                        { "udp",   "UDP"          },
+                        { "tcp",   "TCP"          },
+                        { "tls",   "DNS-over-TLS" },
+                        { "llmnr", "LLMNR"        },
+                        { "mdns",  "MulticastDNS" },
+                };
+
+                r = table_add_many(table,
+                                   TABLE_EMPTY, TABLE_EMPTY,
+                                   TABLE_STRING, "Reply Latency",
+                                   TABLE_SET_COLOR, ansi_highlight(),
+                                   TABLE_SET_ALIGN_PERCENT, 0,
+                                   TABLE_EMPTY);
+                if (r < 0)
+                        return table_log_add_error(r);
+
+                FOREACH_ELEMENT(p, protocols) {
+                        r = table_add_latency(table, p->title, sd_json_variant_by_key(statistics.latency, p->field));
+                        if (r < 0)
+                                return r;
+                }
+        }
+
         r = table_print(table, NULL);
         if (r < 0)
                 return table_log_print_error(r);
@@ -3216,8 +3325,10 @@ static int dump_server_state(sd_json_variant *server) {
                 bool packet_rrsig_missing;
                 bool packet_invalid;
                 bool packet_do_off;
+                uint64_t rtt_usec;
         } server_state = {
                 .ifindex = -1,
+                .rtt_usec = UINT64_MAX,
         };
 
         int r;
@@ -3239,6 +3350,7 @@ static int dump_server_state(sd_json_variant *server) {
                 { "PacketRRSIGMissing",     SD_JSON_VARIANT_BOOLEAN,       sd_json_dispatch_stdbool,       offsetof(struct server_state, packet_rrsig_missing),      SD_JSON_MANDATORY },
                 { "PacketInvalid",          SD_JSON_VARIANT_BOOLEAN,       sd_json_dispatch_stdbool,       offsetof(struct server_state, packet_invalid),            SD_JSON_MANDATORY },
                 { "PacketDoOff",            SD_JSON_VARIANT_BOOLEAN,       sd_json_dispatch_stdbool,       offsetof(struct server_state, packet_do_off),             SD_JSON_MANDATORY },
+                { "RoundTripTimeUSec",      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,        offsetof(struct server_state, rtt_usec),                  0                 },
                 {},
         };
 
@@ -3319,9 +3431,19 @@ static int dump_server_state(sd_json_variant *server) {
                            TABLE_STRING, yes_no(server_state.packet_invalid),
                            TABLE_FIELD, "Server dropped DO flag",
                            TABLE_STRING, yes_no(server_state.packet_do_off),
-                           TABLE_SET_ALIGN_PERCENT, 0,
-                           TABLE_EMPTY, TABLE_EMPTY);
+                           TABLE_SET_ALIGN_PERCENT, 0);
+        if (r < 0)
+                return table_log_add_error(r);
+
+        if (server_state.rtt_usec != UINT64_MAX) {
+                r = table_add_many(table,
+                                   TABLE_FIELD, "Round-trip time",
+                                   TABLE_TIMESPAN_MSEC, server_state.rtt_usec);
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
 
+        r = table_add_many(table, TABLE_EMPTY, TABLE_EMPTY);
         if (r < 0)
                 return table_log_add_error(r);
 
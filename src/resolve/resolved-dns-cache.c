@@ -6,15 +6,31 @@
 #include "alloc-util.h"
 #include "dns-domain.h"
 #include "format-ifname.h"
+#include "iovec-util.h"
+#include "json-util.h"
 #include "resolved-dns-answer.h"
 #include "resolved-dns-cache.h"
 #include "resolved-dns-packet.h"
+#include "random-util.h"
+#include "set.h"
+#include "siphash24.h"
 #include "string-util.h"
 
 /* Never cache more than 4K entries. RFC 1536, Section 5 suggests to
  * leave DNS caches unbounded, but that's crazy. */
 #define CACHE_MAX 4096
 
+/* Number of slots of the admission filter. Once the cache is full, a key is only admitted if it was looked up
+ * at least CACHE_ADMISSION_LOOKUPS times while its slot wasn't reused in between, i.e. only keys that are
+ * looked up repeatedly may evict other entries. */
+#define CACHE_ADMISSION_FILTER_SIZE 1024U
+#define CACHE_ADMISSION_LOOKUPS 2U
+
+struct DnsCacheAdmissionSlot {
+        uint64_t hash;
+        unsigned n_lookups;
+};
+
 /* We never keep any item longer than 2h in our cache unless StaleRetentionSec is greater than zero. */
 #define CACHE_TTL_MAX_USEC (2 * USEC_PER_HOUR)
 
@@ -27,6 +43,11 @@
 
 #define CACHEABLE_QUERY_FLAGS (SD_RESOLVED_AUTHENTICATED|SD_RESOLVED_CONFIDENTIAL)
 
+/* With CachePrefetch=yes, positive entries that were looked up at least this many times are refreshed in the
+ * background when they are looked up again during the last tenth of their TTL. */
+#define CACHE_PREFETCH_HITS_MIN 2U
+#define CACHE_PREFETCH_DIVISOR 10U
+
 typedef enum DnsCacheItemType DnsCacheItemType;
 typedef struct DnsCacheItem DnsCacheItem;
 
@@ -47,6 +68,9 @@ struct DnsCacheItem {
 
         usec_t until;            /* If StaleRetentionSec is greater than zero, until is set to a duration of StaleRetentionSec from the time of TTL expiry. If StaleRetentionSec is zero, both until and until_valid will be set to ttl. */
         usec_t until_valid;      /* The key is for storing the time when the TTL set to expire. */
+        usec_t until_prefetch;   /* Hits after this time will refresh the entry if CachePrefetch= is enabled. */
+        unsigned n_hits;         /* How often this entry was used to answer a lookup */
+        size_t size;             /* Approximate memory used by this entry, as accounted in DnsCache.n_bytes */
         uint64_t query_flags;    /* SD_RESOLVED_AUTHENTICATED and/or SD_RESOLVED_CONFIDENTIAL */
         DnssecResult dnssec_result;
 
@@ -117,6 +141,9 @@ static void dns_cache_item_unlink_and_free(DnsCache *c, DnsCacheItem *i) {
 
         prioq_remove(c->by_expiry, i, &i->prioq_idx);
 
+        assert(c->n_bytes >= i->size);
+        c->n_bytes -= i->size;
+
         dns_cache_item_free(i);
 }
 
@@ -150,6 +177,10 @@ static bool dns_cache_remove_by_key(DnsCache *c, DnsResourceKey *key) {
 
         LIST_FOREACH(by_key, i, first) {
                 prioq_remove(c->by_expiry, i, &i->prioq_idx);
+
+                assert(c->n_bytes >= i->size);
+                c->n_bytes -= i->size;
+
                 dns_cache_item_free(i);
         }
 
@@ -166,21 +197,161 @@ void dns_cache_flush(DnsCache *c) {
 
         assert(hashmap_isempty(c->by_key));
         assert(prioq_isempty(c->by_expiry));
+        assert(c->n_bytes == 0);
 
         c->by_key = hashmap_free(c->by_key);
         c->by_expiry = prioq_free(c->by_expiry);
+        c->admission_filter = mfree(c->admission_filter);
+}
+
+static size_t dns_cache_item_size(const DnsCacheItem *i) {
+        size_t n;
+
+        assert(i);
+
+        /* We only approximate here: the item itself, its key name and the wire format of its RR. The full
+         * packet is shared between all items created from the same answer, hence split its size among
+         * them. */
+
+        n = sizeof(DnsCacheItem) + strlen(dns_resource_key_name(i->key)) + 1;
+
+        if (i->rr)
+                n += sizeof(DnsResourceRecord) + i->rr->wire_format_size;
+
+        if (i->full_packet)
+                n += DIV_ROUND_UP(i->full_packet->size, MAX(dns_answer_size(i->answer), (size_t) 1U));
+
+        return n;
+}
+
+static size_t dns_cache_answer_size(DnsAnswer *answer, DnsPacket *full_packet) {
+        DnsResourceRecord *rr;
+        size_t n = 0;
+
+        /* Estimates what dns_cache_item_size() will return for the items created from the answer, in total */
+
+        DNS_ANSWER_FOREACH(rr, answer)
+                n += sizeof(DnsCacheItem) + sizeof(DnsResourceRecord) +
+                        strlen(dns_resource_key_name(rr->key)) + 1 + rr->wire_format_size;
+
+        if (full_packet)
+                n += full_packet->size;
+
+        return n;
+}
+
+static bool dns_cache_full(DnsCache *c, unsigned add, size_t add_bytes) {
+        assert(c);
+
+        /* If add_bytes is zero only the number of entries is checked: the caller made room for the memory
+         * of the whole answer already, and we shouldn't evict its other RRs due to rounding differences. */
+
+        if (prioq_size(c->by_expiry) + add >= CACHE_MAX)
+                return true;
+
+        return add_bytes > 0 && c->max_bytes > 0 && c->n_bytes + add_bytes > c->max_bytes;
+}
+
+static DnsCacheAdmissionSlot* dns_cache_admission_slot(DnsCache *c, DnsResourceKey *key, uint64_t *ret_hash) {
+        struct siphash state;
+        uint64_t h;
+
+        assert(c);
+        assert(key);
+        assert(ret_hash);
+
+        if (!c->admission_filter)
+                return NULL;
+
+        siphash24_init(&state, c->admission_hash_key);
+        dns_resource_key_hash_ops.hash(key, &state);
+        h = siphash24_finalize(&state);
+
+        *ret_hash = h;
+        return c->admission_filter + h % CACHE_ADMISSION_FILTER_SIZE;
+}
+
+static void dns_cache_admission_note_lookup(DnsCache *c, DnsResourceKey *key) {
+        DnsCacheAdmissionSlot *slot;
+        uint64_t h;
+
+        assert(c);
+        assert(key);
+
+        /* Counts a lookup that could not be answered from the cache. The filter only exists once an entry
+         * was refused, until then everything is admitted anyway. */
+
+        slot = dns_cache_admission_slot(c, key, &h);
+        if (!slot)
+                return;
+
+        if (slot->hash == h)
+                slot->n_lookups = MIN(slot->n_lookups + 1, CACHE_ADMISSION_LOOKUPS);
+        else
+                *slot = (DnsCacheAdmissionSlot) {
+                        .hash = h,
+                        .n_lookups = 1,
+                };
+}
+
+static bool dns_cache_admit(
+                DnsCache *c,
+                DnsProtocol protocol,
+                DnsResourceKey *key,
+                bool update,
+                unsigned add,
+                size_t add_bytes) {
+
+        DnsCacheAdmissionSlot *slot;
+        uint64_t h;
+
+        assert(c);
+
+        /* Decides whether a new entry may evict others. As long as there's space in the cache everything is
+         * admitted, and so are updates of entries we already have. Otherwise a key is only admitted once it
+         * was looked up repeatedly, so that one-off lookups cannot push out the entries that are actually
+         * used. This only applies to unicast DNS: on LLMNR and mDNS responses are not the result of
+         * arbitrary lookups by (possibly) remote clients, and mDNS announcements come without key. */
+
+        if (protocol != DNS_PROTOCOL_DNS || !key || update || prioq_isempty(c->by_expiry))
+                return true;
+
+        if (!dns_cache_full(c, add, add_bytes))
+                return true;
+
+        if (!c->admission_filter) {
+                c->admission_filter = new0(DnsCacheAdmissionSlot, CACHE_ADMISSION_FILTER_SIZE);
+                if (!c->admission_filter)
+                        return true;
+
+                random_bytes(c->admission_hash_key, sizeof(c->admission_hash_key));
+        }
+
+        slot = ASSERT_PTR(dns_cache_admission_slot(c, key, &h));
+        if (slot->hash == h)
+                return slot->n_lookups >= CACHE_ADMISSION_LOOKUPS;
+
+        /* The filter didn't exist yet, or the slot was reused since, hence the lookup that led to this
+         * response wasn't recorded. Do that now. */
+        *slot = (DnsCacheAdmissionSlot) {
+                .hash = h,
+                .n_lookups = 1,
+        };
+
+        return false;
 }
 
-static void dns_cache_make_space(DnsCache *c, unsigned add) {
+static void dns_cache_make_space(DnsCache *c, unsigned add, size_t add_bytes) {
         assert(c);
 
         if (add <= 0)
                 return;
 
-        /* Makes space for n new entries. Note that we actually allow
-         * the cache to grow beyond CACHE_MAX, but only when we shall
-         * add more RRs to the cache than CACHE_MAX at once. In that
-         * case the cache will be emptied completely otherwise. */
+        /* Makes space for n new entries and the specified number of
+         * bytes. Note that we actually allow the cache to grow beyond
+         * CACHE_MAX (or the byte limit), but only when we shall add
+         * more RRs to the cache than that at once. In that case the
+         * cache will be emptied completely otherwise. */
 
         for (;;) {
                 _cleanup_(dns_resource_key_unrefp) DnsResourceKey *key = NULL;
@@ -189,7 +360,7 @@ static void dns_cache_make_space(DnsCache *c, unsigned add) {
                 if (prioq_isempty(c->by_expiry))
                         break;
 
-                if (prioq_size(c->by_expiry) + add < CACHE_MAX)
+                if (!dns_cache_full(c, add, add_bytes))
                         break;
 
                 i = prioq_peek(c->by_expiry);
@@ -317,6 +488,9 @@ static int dns_cache_link_item(DnsCache *c, DnsCacheItem *i) {
                 }
         }
 
+        i->size = dns_cache_item_size(i);
+        c->n_bytes += i->size;
+
         return 0;
 }
 
@@ -377,6 +551,10 @@ static usec_t calculate_until(
         return stale_retention_usec > 0 ? usec_add(until_valid, stale_retention_usec) : until_valid;
 }
 
+static usec_t calculate_until_prefetch(usec_t until_valid, usec_t timestamp) {
+        return until_valid - LESS_BY(until_valid, timestamp) / CACHE_PREFETCH_DIVISOR;
+}
+
 static void dns_cache_item_update_positive(
                 DnsCache *c,
                 DnsCacheItem *i,
@@ -416,6 +594,8 @@ static void dns_cache_item_update_positive(
 
         i->until_valid = calculate_until_valid(rr, min_ttl, UINT32_MAX, timestamp, false);
         i->until = calculate_until(i->until_valid, stale_retention_usec);
+        i->until_prefetch = calculate_until_prefetch(i->until_valid, timestamp);
+        i->n_hits = 0;
         i->query_flags = query_flags & CACHEABLE_QUERY_FLAGS;
         i->shared_owner = shared_owner;
         i->dnssec_result = dnssec_result;
@@ -425,6 +605,11 @@ static void dns_cache_item_update_positive(
         i->owner_family = owner_family;
         i->owner_address = *owner_address;
 
+        assert(c->n_bytes >= i->size);
+        c->n_bytes -= i->size;
+        i->size = dns_cache_item_size(i);
+        c->n_bytes += i->size;
+
         prioq_reshuffle(c->by_expiry, i, &i->prioq_idx);
 }
 
@@ -502,7 +687,7 @@ static int dns_cache_put_positive(
         if (r < 0)
                 return r;
 
-        dns_cache_make_space(c, 1);
+        dns_cache_make_space(c, 1, 0);
 
         _cleanup_(dns_cache_item_freep) DnsCacheItem *i = new(DnsCacheItem, 1);
         if (!i)
@@ -521,6 +706,7 @@ static int dns_cache_put_positive(
                 .full_packet = dns_packet_ref(full_packet),
                 .until = calculate_until(until_valid, stale_retention_usec),
                 .until_valid = until_valid,
+                .until_prefetch = calculate_until_prefetch(until_valid, timestamp),
                 .query_flags = query_flags & CACHEABLE_QUERY_FLAGS,
                 .shared_owner = shared_owner,
                 .dnssec_result = dnssec_result,
@@ -611,7 +797,7 @@ static int dns_cache_put_negative(
         if (r < 0)
                 return r;
 
-        dns_cache_make_space(c, 1);
+        dns_cache_make_space(c, 1, 0);
 
         i = new(DnsCacheItem, 1);
         if (!i)
@@ -740,14 +926,35 @@ int dns_cache_put(
         DnsAnswerItem *item;
         DnsAnswerFlags flags;
         unsigned cache_keys;
+        size_t cache_bytes;
         usec_t timestamp;
+        bool update;
         int r;
 
         assert(c);
         assert(owner_address);
 
+        update = key && hashmap_contains(c->by_key, key);
+
+        /* Whatever we decide below, the previous entries are outdated now */
         dns_cache_remove_previous(c, key, answer);
 
+        cache_keys = dns_answer_size(answer);
+        if (key)
+                cache_keys++;
+
+        cache_bytes = dns_cache_answer_size(answer, full_packet);
+
+        /* If the cache is full, only let keys evict others that are looked up repeatedly */
+        if (!dns_cache_admit(c, protocol, key, update, cache_keys, cache_bytes)) {
+                char key_str[DNS_RESOURCE_KEY_STRING_MAX];
+
+                c->n_rejected++;
+                log_debug("Cache is full, not caching entry for %s that was not looked up repeatedly.",
+                          dns_resource_key_to_string(key, key_str, sizeof key_str));
+                return 0;
+        }
+
         /* We only care for positive replies and NXDOMAINs, on all other replies we will simply flush the respective
          * entries, and that's it. (Well, with one further exception: since some DNS zones (akamai!) return SERVFAIL
          * consistently for some lookups, and forwarders tend to propagate that we'll cache that too, but only for a
@@ -774,12 +981,8 @@ int dns_cache_put(
                 weird_rcode = true;
         }
 
-        cache_keys = dns_answer_size(answer);
-        if (key)
-                cache_keys++;
-
         /* Make some space for our new entries */
-        dns_cache_make_space(c, cache_keys);
+        dns_cache_make_space(c, cache_keys, cache_bytes);
 
         timestamp = now(CLOCK_BOOTTIME);
 
@@ -1089,6 +1292,8 @@ int dns_cache_lookup(
                         goto miss;
                 }
 
+                j->n_hits++;
+
                 if (j->type == DNS_CACHE_NXDOMAIN)
                         nxdomain = true;
                 else if (j->type == DNS_CACHE_RCODE)
@@ -1279,6 +1484,7 @@ miss:
                 *ret_dnssec_result = _DNSSEC_RESULT_INVALID;
 
         c->n_miss++;
+        dns_cache_admission_note_lookup(c, key);
         return 0;
 }
 
@@ -1474,19 +1680,22 @@ int dns_cache_dump_to_json(DnsCache *cache, sd_json_variant **ret) {
                                         &d,
                                         SD_JSON_BUILD_PAIR_VARIANT("key", k),
                                         SD_JSON_BUILD_PAIR_VARIANT("rrs", l),
-                                        SD_JSON_BUILD_PAIR_UNSIGNED("until", i->until));
+                                        SD_JSON_BUILD_PAIR_UNSIGNED("until", i->until),
+                                        SD_JSON_BUILD_PAIR_UNSIGNED("hits", i->n_hits));
                 } else if (i->type == DNS_CACHE_NODATA) {
                         r = sd_json_buildo(
                                         &d,
                                         SD_JSON_BUILD_PAIR_VARIANT("key", k),
                                         SD_JSON_BUILD_PAIR_EMPTY_ARRAY("rrs"),
-                                        SD_JSON_BUILD_PAIR_UNSIGNED("until", i->until));
+                                        SD_JSON_BUILD_PAIR_UNSIGNED("until", i->until),
+                                        SD_JSON_BUILD_PAIR_UNSIGNED("hits", i->n_hits));
                 } else
                         r = sd_json_buildo(
                                         &d,
                                         SD_JSON_BUILD_PAIR_VARIANT("key", k),
                                         SD_JSON_BUILD_PAIR_STRING("type", dns_cache_item_type_to_string(i)),
-                                        SD_JSON_BUILD_PAIR_UNSIGNED("until", i->until));
+                                        SD_JSON_BUILD_PAIR_UNSIGNED("until", i->until),
+                                        SD_JSON_BUILD_PAIR_UNSIGNED("hits", i->n_hits));
                 if (r < 0)
                         return r;
 
@@ -1502,6 +1711,282 @@ int dns_cache_dump_to_json(DnsCache *cache, sd_json_variant **ret) {
         return 0;
 }
 
+int dns_cache_serialize(DnsCache *cache, sd_json_variant **ret) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *c = NULL;
+        _cleanup_set_free_ Set *seen = NULL;
+        DnsCacheItem *i;
+        int r;
+
+        assert(cache);
+        assert(ret);
+
+        /* Serializes the full answers of the positive primary entries, so that they can be restored by the
+         * next instance via dns_cache_deserialize(). Side-effect entries and negative entries are not worth
+         * the trouble, they are cheap to reacquire. The expiry is an absolute CLOCK_BOOTTIME timestamp,
+         * hence the result is only meaningful within the same boot. */
+
+        HASHMAP_FOREACH(i, cache->by_key) {
+                _cleanup_(sd_json_variant_unrefp) sd_json_variant *k = NULL, *l = NULL;
+                usec_t until_valid = USEC_INFINITY;
+                DnsAnswerItem *item;
+
+                if (i->type != DNS_CACHE_POSITIVE || !DNS_CACHE_ITEM_IS_PRIMARY(i))
+                        continue;
+
+                /* All items of a primary entry share the same answer, write it out only once */
+                r = set_ensure_put(&seen, NULL, i->answer);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        continue;
+
+                LIST_FOREACH(by_key, j, i)
+                        until_valid = MIN(until_valid, j->until_valid);
+
+                DNS_ANSWER_FOREACH_ITEM(item, i->answer) {
+                        if (!FLAGS_SET(item->flags, DNS_ANSWER_CACHEABLE))
+                                continue;
+
+                        r = dns_resource_record_to_wire_format(item->rr, /* canonical= */ false);
+                        if (r < 0)
+                                return r;
+
+                        r = sd_json_variant_append_arraybo(
+                                        &l,
+                                        SD_JSON_BUILD_PAIR_BASE64("raw", item->rr->wire_format, item->rr->wire_format_size),
+                                        SD_JSON_BUILD_PAIR_INTEGER("ifindex", item->ifindex),
+                                        SD_JSON_BUILD_PAIR_BOOLEAN("authenticated", FLAGS_SET(item->flags, DNS_ANSWER_AUTHENTICATED)),
+                                        SD_JSON_BUILD_PAIR_BOOLEAN("sharedOwner", FLAGS_SET(item->flags, DNS_ANSWER_SHARED_OWNER)));
+                        if (r < 0)
+                                return r;
+                }
+
+                if (!l)
+                        continue;
+
+                r = dns_resource_key_to_json(i->key, &k);
+                if (r < 0)
+                        return r;
+
+                r = sd_json_variant_append_arraybo(
+                                &c,
+                                SD_JSON_BUILD_PAIR_VARIANT("key", k),
+                                SD_JSON_BUILD_PAIR_VARIANT("rrs", l),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("untilValid", until_valid),
+                                SD_JSON_BUILD_PAIR_BOOLEAN("authenticated", FLAGS_SET(i->query_flags, SD_RESOLVED_AUTHENTICATED)),
+                                SD_JSON_BUILD_PAIR_BOOLEAN("confidential", FLAGS_SET(i->query_flags, SD_RESOLVED_CONFIDENTIAL)),
+                                SD_JSON_BUILD_PAIR_CONDITION(i->dnssec_result >= 0, "dnssecResult", SD_JSON_BUILD_STRING(dnssec_result_to_string(i->dnssec_result))),
+                                SD_JSON_BUILD_PAIR_INTEGER("ownerFamily", i->owner_family),
+                                JSON_BUILD_PAIR_IN_ADDR("ownerAddress", &i->owner_address, i->owner_family));
+                if (r < 0)
+                        return r;
+        }
+
+        if (!c)
+                return sd_json_variant_new_array(ret, NULL, 0);
+
+        *ret = TAKE_PTR(c);
+        return 0;
+}
+
+typedef struct SerializedRR {
+        struct iovec raw;
+        int ifindex;
+        bool authenticated;
+        bool shared_owner;
+} SerializedRR;
+
+typedef struct SerializedEntry {
+        sd_json_variant *key;
+        sd_json_variant *rrs;
+        uint64_t until_valid;
+        bool authenticated;
+        bool confidential;
+        const char *dnssec_result;
+        int owner_family;
+        struct iovec owner_address;
+} SerializedEntry;
+
+static void serialized_rr_done(SerializedRR *p) {
+        assert(p);
+
+        iovec_done(&p->raw);
+}
+
+static void serialized_entry_done(SerializedEntry *p) {
+        assert(p);
+
+        iovec_done(&p->owner_address);
+}
+
+static int dns_cache_deserialize_one(
+                DnsCache *cache,
+                DnsCacheMode cache_mode,
+                sd_json_variant *v,
+                int owner_family,
+                const union in_addr_union *owner_address,
+                usec_t stale_retention_usec,
+                usec_t ts) {
+
+        static const sd_json_dispatch_field entry_dispatch_table[] = {
+                { "key",           SD_JSON_VARIANT_OBJECT,   sd_json_dispatch_variant_noref, offsetof(SerializedEntry, key),           SD_JSON_MANDATORY },
+                { "rrs",           SD_JSON_VARIANT_ARRAY,    sd_json_dispatch_variant_noref, offsetof(SerializedEntry, rrs),           SD_JSON_MANDATORY },
+                { "untilValid",    _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,   offsetof(SerializedEntry, until_valid),   SD_JSON_MANDATORY },
+                { "authenticated", SD_JSON_VARIANT_BOOLEAN,  sd_json_dispatch_stdbool,       offsetof(SerializedEntry, authenticated), 0                 },
+                { "confidential",  SD_JSON_VARIANT_BOOLEAN,  sd_json_dispatch_stdbool,       offsetof(SerializedEntry, confidential),  0                 },
+                { "dnssecResult",  SD_JSON_VARIANT_STRING,   sd_json_dispatch_const_string,  offsetof(SerializedEntry, dnssec_result), 0                 },
+                { "ownerFamily",   _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_int,      offsetof(SerializedEntry, owner_family),  SD_JSON_MANDATORY },
+                { "ownerAddress",  SD_JSON_VARIANT_ARRAY,    json_dispatch_byte_array_iovec, offsetof(SerializedEntry, owner_address), 0                 },
+                {}
+        };
+
+        static const sd_json_dispatch_field rr_dispatch_table[] = {
+                { "raw",           SD_JSON_VARIANT_STRING,   json_dispatch_unbase64_iovec,   offsetof(SerializedRR, raw),           SD_JSON_MANDATORY },
+                { "ifindex",       _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_int,      offsetof(SerializedRR, ifindex),       0                 },
+                { "authenticated", SD_JSON_VARIANT_BOOLEAN,  sd_json_dispatch_stdbool,       offsetof(SerializedRR, authenticated), 0                 },
+                { "sharedOwner",   SD_JSON_VARIANT_BOOLEAN,  sd_json_dispatch_stdbool,       offsetof(SerializedRR, shared_owner),  0                 },
+                {}
+        };
+
+        _cleanup_(dns_resource_key_unrefp) DnsResourceKey *key = NULL;
+        _cleanup_(dns_answer_unrefp) DnsAnswer *answer = NULL;
+        _cleanup_(serialized_entry_done) SerializedEntry p = {};
+        DnssecResult dnssec_result = _DNSSEC_RESULT_INVALID;
+        sd_json_variant *e;
+        uint32_t ttl;
+        int r;
+
+        r = sd_json_dispatch(v, entry_dispatch_table, SD_JSON_ALLOW_EXTENSIONS, &p);
+        if (r < 0)
+                return r;
+
+        /* Only restore what we learnt from the server we'd ask now, anything else would be flushed anyway
+         * once we switch servers. */
+        if (p.owner_family != owner_family ||
+            memcmp_nn(p.owner_address.iov_base, p.owner_address.iov_len,
+                      owner_address->bytes, FAMILY_ADDRESS_SIZE_SAFE(owner_family)) != 0)
+                return 0;
+
+        /* Don't bother with entries that are about to expire */
+        if (p.until_valid <= usec_add(ts, USEC_PER_SEC))
+                return 0;
+
+        ttl = (uint32_t) MIN((p.until_valid - ts) / USEC_PER_SEC, (uint64_t) UINT32_MAX);
+
+        if (p.dnssec_result) {
+                dnssec_result = dnssec_result_from_string(p.dnssec_result);
+                if (dnssec_result < 0)
+                        return dnssec_result;
+        }
+
+        r = dns_resource_key_from_json(p.key, &key);
+        if (r < 0)
+                return r;
+
+        answer = dns_answer_new(sd_json_variant_elements(p.rrs));
+        if (!answer)
+                return -ENOMEM;
+
+        JSON_VARIANT_ARRAY_FOREACH(e, p.rrs) {
+                _cleanup_(dns_resource_record_unrefp) DnsResourceRecord *rr = NULL;
+                _cleanup_(serialized_rr_done) SerializedRR q = {};
+
+                r = sd_json_dispatch(e, rr_dispatch_table, SD_JSON_ALLOW_EXTENSIONS, &q);
+                if (r < 0)
+                        return r;
+
+                r = dns_resource_record_new_from_raw(&rr, q.raw.iov_base, q.raw.iov_len);
+                if (r < 0)
+                        return r;
+
+                rr->ttl = ttl;
+
+                r = dns_answer_add(
+                                answer,
+                                rr,
+                                q.ifindex,
+                                DNS_ANSWER_CACHEABLE |
+                                (q.authenticated ? DNS_ANSWER_AUTHENTICATED : 0) |
+                                (q.shared_owner ? DNS_ANSWER_SHARED_OWNER : 0),
+                                /* rrsig= */ NULL);
+                if (r < 0)
+                        return r;
+        }
+
+        r = dns_cache_put(
+                        cache,
+                        cache_mode,
+                        DNS_PROTOCOL_DNS,
+                        key,
+                        DNS_RCODE_SUCCESS,
+                        answer,
+                        /* full_packet= */ NULL,
+                        (p.authenticated ? SD_RESOLVED_AUTHENTICATED : 0) |
+                        (p.confidential ? SD_RESOLVED_CONFIDENTIAL : 0),
+                        dnssec_result,
+                        UINT32_MAX,
+                        owner_family,
+                        owner_address,
+                        stale_retention_usec);
+        if (r < 0)
+                return r;
+
+        return 1;
+}
+
+int dns_cache_deserialize(
+                DnsCache *cache,
+                DnsCacheMode cache_mode,
+                sd_json_variant *v,
+                int owner_family,
+                const union in_addr_union *owner_address,
+                usec_t stale_retention_usec) {
+
+        sd_json_variant *e;
+        unsigned n = 0;
+        usec_t ts;
+        int r;
+
+        assert(cache);
+        assert(owner_address);
+
+        /* Restores entries written by dns_cache_serialize(), and returns how many were restored. Broken
+         * entries are skipped, this is just an optimization after all. */
+
+        if (!sd_json_variant_is_array(v))
+                return -EINVAL;
+
+        ts = now(CLOCK_BOOTTIME);
+
+        JSON_VARIANT_ARRAY_FOREACH(e, v) {
+                r = dns_cache_deserialize_one(cache, cache_mode, e, owner_family, owner_address, stale_retention_usec, ts);
+                if (r < 0) {
+                        log_debug_errno(r, "Failed to restore serialized cache entry, ignoring: %m");
+                        continue;
+                }
+
+                n += r;
+        }
+
+        return (int) MIN(n, (unsigned) INT_MAX);
+}
+
+bool dns_cache_prefetch_needed(DnsCache *c, DnsResourceKey *key, usec_t ts) {
+        DnsCacheItem *i;
+
+        assert(c);
+        assert(key);
+
+        /* Returns true if the positive cache entry for this key is used frequently and about to expire, so
+         * that it should be refreshed before it does. */
+
+        i = dns_cache_get_by_key_follow_cname_dname_nsec(c, key);
+        if (!i || i->type != DNS_CACHE_POSITIVE)
+                return false;
+
+        return i->n_hits >= CACHE_PREFETCH_HITS_MIN && i->until_prefetch <= ts && ts < i->until_valid;
+}
+
 bool dns_cache_is_empty(DnsCache *cache) {
         if (!cache)
                 return true;
@@ -1515,3 +2000,10 @@ unsigned dns_cache_size(DnsCache *cache) {
 
         return hashmap_size(cache->by_key);
 }
+
+uint64_t dns_cache_bytes(DnsCache *cache) {
+        if (!cache)
+                return 0;
+
+        return cache->n_bytes;
+}
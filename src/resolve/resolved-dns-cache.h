@@ -8,11 +8,26 @@
 #include "resolved-dns-dnssec.h"
 #include "time-util.h"
 
+/* Upper limit for the memory used by the cache of a single scope, by default */
+#define DNS_CACHE_MEMORY_MAX_DEFAULT (4U * 1024U * 1024U)
+
+typedef struct DnsCacheAdmissionSlot DnsCacheAdmissionSlot;
+
 typedef struct DnsCache {
         Hashmap *by_key;
         Prioq *by_expiry;
         unsigned n_hit;
         unsigned n_miss;
+        unsigned n_prefetch;
+        unsigned n_rejected;
+
+        /* Approximate number of bytes used by the cached items, and the limit for that (0 if unlimited) */
+        uint64_t n_bytes;
+        uint64_t max_bytes;
+
+        /* Hashes of keys recently looked up but not found, and how often, see dns_cache_admit() */
+        DnsCacheAdmissionSlot *admission_filter;
+        uint8_t admission_hash_key[HASH_KEY_SIZE];
 } DnsCache;
 
 #include "resolved-dns-answer.h"
@@ -53,9 +68,21 @@ int dns_cache_check_conflicts(DnsCache *cache, DnsResourceRecord *rr, int owner_
 void dns_cache_dump(DnsCache *cache, FILE *f);
 int dns_cache_dump_to_json(DnsCache *cache, sd_json_variant **ret);
 
+int dns_cache_serialize(DnsCache *cache, sd_json_variant **ret);
+int dns_cache_deserialize(
+                DnsCache *cache,
+                DnsCacheMode cache_mode,
+                sd_json_variant *v,
+                int owner_family,
+                const union in_addr_union *owner_address,
+                usec_t stale_retention_usec);
+
+bool dns_cache_prefetch_needed(DnsCache *c, DnsResourceKey *key, usec_t ts);
+
 bool dns_cache_is_empty(DnsCache *cache);
 
 unsigned dns_cache_size(DnsCache *cache);
+uint64_t dns_cache_bytes(DnsCache *cache);
 
 int dns_cache_export_shared_to_packet(DnsCache *cache, DnsPacket *p, usec_t ts, unsigned max_rr);
 
@@ -11,6 +11,7 @@
 #include "openssl-util.h"
 #include "resolved-dns-dnssec.h"
 #include "resolved-dns-packet.h"
+#include "sha256.h"
 #include "sort-util.h"
 #include "string-table.h"
 
@@ -31,6 +32,36 @@ REENABLE_WARNING;
  * RFC9276 § 3.2 says that we should reduce the acceptable iteration count */
 #define NSEC3_ITERATIONS_MAX 100
 
+/* Never remember more than 4K signature verification results */
+#define VERIFY_CACHE_MAX 4096U
+
+typedef struct DnssecVerifyCacheEntry {
+        uint8_t digest[SHA256_DIGEST_SIZE]; /* Covers the signed data, the signature and the DNSKEY */
+        usec_t until;                       /* The signature can't be valid anymore after this (CLOCK_REALTIME) */
+        bool valid;
+} DnssecVerifyCacheEntry;
+
+static void verify_cache_entry_hash_func(const DnssecVerifyCacheEntry *e, struct siphash *state) {
+        siphash24_compress_typesafe(e->digest, state);
+}
+
+static int verify_cache_entry_compare_func(const DnssecVerifyCacheEntry *a, const DnssecVerifyCacheEntry *b) {
+        return memcmp(a->digest, b->digest, sizeof(a->digest));
+}
+
+DEFINE_PRIVATE_HASH_OPS_WITH_KEY_DESTRUCTOR(
+                verify_cache_entry_hash_ops,
+                DnssecVerifyCacheEntry,
+                verify_cache_entry_hash_func,
+                verify_cache_entry_compare_func,
+                free);
+
+void dnssec_verify_cache_flush(DnssecVerifyCache *c) {
+        assert(c);
+
+        c->by_digest = hashmap_free(c->by_digest);
+}
+
 /*
  * The DNSSEC Chain of trust:
  *
@@ -972,12 +1003,111 @@ static int dnssec_rrset_verify_sig(
         }
 }
 
-int dnssec_verify_rrset(
+static void dnssec_verify_cache_digest(
+                DnsResourceRecord *rrsig,
+                DnsResourceRecord *dnskey,
+                const char *sig_data,
+                size_t sig_size,
+                uint8_t ret[static SHA256_DIGEST_SIZE]) {
+
+        struct sha256_ctx ctx;
+
+        assert(rrsig);
+        assert(dnskey);
+        assert(sig_data);
+
+        /* The signed data already covers the RRSIG RDATA (minus the signature itself) and the RRset in
+         * canonical form, hence together with the signature and the key this identifies the verification
+         * fully. */
+
+        sha256_init_ctx(&ctx);
+        sha256_process_bytes_and_size(sig_data, sig_size, &ctx);
+        sha256_process_bytes_and_size(rrsig->rrsig.signature, rrsig->rrsig.signature_size, &ctx);
+        sha256_process_bytes(&dnskey->dnskey.flags, sizeof(dnskey->dnskey.flags), &ctx);
+        sha256_process_bytes(&dnskey->dnskey.protocol, sizeof(dnskey->dnskey.protocol), &ctx);
+        sha256_process_bytes(&dnskey->dnskey.algorithm, sizeof(dnskey->dnskey.algorithm), &ctx);
+        sha256_process_bytes_and_size(dnskey->dnskey.key, dnskey->dnskey.key_size, &ctx);
+        sha256_finish_ctx(&ctx, ret);
+}
+
+static void dnssec_verify_cache_vacuum(DnssecVerifyCache *c, usec_t realtime) {
+        DnssecVerifyCacheEntry *e;
+
+        assert(c);
+
+        if (hashmap_size(c->by_digest) < VERIFY_CACHE_MAX)
+                return;
+
+        /* Drop the results for signatures that expired first, and if that doesn't help just start over */
+        HASHMAP_FOREACH(e, c->by_digest)
+                if (e->until < realtime)
+                        free(hashmap_remove(c->by_digest, e));
+
+        if (hashmap_size(c->by_digest) >= VERIFY_CACHE_MAX)
+                dnssec_verify_cache_flush(c);
+}
+
+static int dnssec_rrset_verify_sig_cached(
+                DnssecVerifyCache *cache,
+                DnsResourceRecord *rrsig,
+                DnsResourceRecord *dnskey,
+                const char *sig_data,
+                size_t sig_size,
+                usec_t realtime) {
+
+        _cleanup_free_ DnssecVerifyCacheEntry *e = NULL;
+        DnssecVerifyCacheEntry lookup = {}, *found;
+        int r;
+
+        assert(rrsig);
+        assert(dnskey);
+
+        /* Like dnssec_rrset_verify_sig(), but first checks whether we already verified the very same
+         * signature over the very same data with the very same key before. Popular zones' DNSKEY and DS
+         * RRsets are otherwise verified again by every transaction that needs them. */
+
+        if (!cache)
+                return dnssec_rrset_verify_sig(rrsig, dnskey, sig_data, sig_size);
+
+        dnssec_verify_cache_digest(rrsig, dnskey, sig_data, sig_size, lookup.digest);
+
+        found = hashmap_get(cache->by_digest, &lookup);
+        if (found) {
+                cache->n_hit++;
+                return found->valid;
+        }
+
+        r = dnssec_rrset_verify_sig(rrsig, dnskey, sig_data, sig_size);
+        if (r < 0)
+                return r;
+
+        /* Remembering the result is merely an optimization, hence ignore failures from here on */
+
+        if (realtime == USEC_INFINITY)
+                realtime = now(CLOCK_REALTIME);
+
+        dnssec_verify_cache_vacuum(cache, realtime);
+
+        e = newdup(DnssecVerifyCacheEntry, &lookup, 1);
+        if (!e)
+                return r;
+
+        e->until = usec_add(rrsig->rrsig.expiration * USEC_PER_SEC, SKEW_MAX);
+        e->valid = r > 0;
+
+        if (hashmap_ensure_put(&cache->by_digest, &verify_cache_entry_hash_ops, e, e) > 0)
+                TAKE_PTR(e);
+
+        return r;
+}
+
+static int dnssec_verify_rrset_full(
                 DnsAnswer *a,
                 const DnsResourceKey *key,
                 DnsResourceRecord *rrsig,
                 DnsResourceRecord *dnskey,
                 usec_t realtime,
+                DnssecVerifyCache *cache,
                 DnssecResult *result) {
 
         DnsResourceRecord **list, *rr;
@@ -1093,7 +1223,7 @@ int dnssec_verify_rrset(
         if (r < 0)
                 return r;
 
-        r = dnssec_rrset_verify_sig(rrsig, dnskey, sig_data, sig_size);
+        r = dnssec_rrset_verify_sig_cached(cache, rrsig, dnskey, sig_data, sig_size, realtime);
         if (r == -EOPNOTSUPP) {
                 *result = DNSSEC_UNSUPPORTED_ALGORITHM;
                 return 0;
@@ -1115,6 +1245,17 @@ int dnssec_verify_rrset(
         return 0;
 }
 
+int dnssec_verify_rrset(
+                DnsAnswer *a,
+                const DnsResourceKey *key,
+                DnsResourceRecord *rrsig,
+                DnsResourceRecord *dnskey,
+                usec_t realtime,
+                DnssecResult *result) {
+
+        return dnssec_verify_rrset_full(a, key, rrsig, dnskey, realtime, /* cache= */ NULL, result);
+}
+
 int dnssec_rrsig_match_dnskey(DnsResourceRecord *rrsig, DnsResourceRecord *dnskey, bool revoked_ok) {
 
         assert(rrsig);
@@ -1166,6 +1307,7 @@ int dnssec_verify_rrset_search(
                 const DnsResourceKey *key,
                 DnsAnswer *validated_dnskeys,
                 usec_t realtime,
+                DnssecVerifyCache *cache,
                 DnssecResult *result,
                 DnsResourceRecord **ret_rrsig) {
 
@@ -1177,7 +1319,8 @@ int dnssec_verify_rrset_search(
         assert(key);
         assert(result);
 
-        /* Verifies all RRs from "a" that match the key "key" against DNSKEYs in "validated_dnskeys" */
+        /* Verifies all RRs from "a" that match the key "key" against DNSKEYs in "validated_dnskeys". If
+         * "cache" is specified, previous verification results are reused and new ones stored there. */
 
         if (dns_answer_isempty(a))
                 return -ENODATA;
@@ -1229,7 +1372,7 @@ int dnssec_verify_rrset_search(
                          * the RRSet against the RRSIG and DNSKEY
                          * combination. */
 
-                        r = dnssec_verify_rrset(a, key, rrsig, dnskey, realtime, &one_result);
+                        r = dnssec_verify_rrset_full(a, key, rrsig, dnskey, realtime, cache, &one_result);
                         if (r < 0)
                                 return r;
 
@@ -2529,6 +2672,7 @@ int dnssec_verify_rrset_search(
                 const DnsResourceKey *key,
                 DnsAnswer *validated_dnskeys,
                 usec_t realtime,
+                DnssecVerifyCache *cache,
                 DnssecResult *result,
                 DnsResourceRecord **ret_rrsig) {
 
@@ -5,6 +5,7 @@ typedef enum DnssecResult DnssecResult;
 typedef enum DnssecVerdict DnssecVerdict;
 
 #include "dns-domain.h"
+#include "hashmap.h"
 #include "resolved-dns-answer.h"
 #include "resolved-dns-rr.h"
 
@@ -53,11 +54,19 @@ enum DnssecVerdict {
 /* The total number of signature validations we will tolerate for a single transaction */
 #define DNSSEC_VALIDATION_MAX 64
 
+/* Results of previous signature verifications, shared by all transactions */
+typedef struct DnssecVerifyCache {
+        Hashmap *by_digest;
+        uint64_t n_hit;
+} DnssecVerifyCache;
+
+void dnssec_verify_cache_flush(DnssecVerifyCache *c);
+
 int dnssec_rrsig_match_dnskey(DnsResourceRecord *rrsig, DnsResourceRecord *dnskey, bool revoked_ok);
 int dnssec_key_match_rrsig(const DnsResourceKey *key, DnsResourceRecord *rrsig);
 
 int dnssec_verify_rrset(DnsAnswer *answer, const DnsResourceKey *key, DnsResourceRecord *rrsig, DnsResourceRecord *dnskey, usec_t realtime, DnssecResult *result);
-int dnssec_verify_rrset_search(DnsAnswer *answer, const DnsResourceKey *key, DnsAnswer *validated_dnskeys, usec_t realtime, DnssecResult *result, DnsResourceRecord **rrsig);
+int dnssec_verify_rrset_search(DnsAnswer *answer, const DnsResourceKey *key, DnsAnswer *validated_dnskeys, usec_t realtime, DnssecVerifyCache *cache, DnssecResult *result, DnsResourceRecord **rrsig);
 
 int dnssec_verify_dnskey_by_ds(DnsResourceRecord *dnskey, DnsResourceRecord *ds, bool mask_revoke);
 int dnssec_verify_dnskey_by_ds_search(DnsResourceRecord *dnskey, DnsAnswer *validated_ds);
@@ -216,6 +216,7 @@ static void dns_packet_free(DnsPacket *p) {
         dns_question_unref(p->question);
         dns_answer_unref(p->answer);
         dns_resource_record_unref(p->opt);
+        dns_resource_key_unref(p->last_key);
 
         while ((s = hashmap_steal_first_key(p->names)))
                 free(s);
@@ -1713,13 +1714,31 @@ int dns_packet_read_key(
 
         _cleanup_(rewind_dns_packet) DnsPacketRewinder rewinder = REWINDER_INIT(p);
         _cleanup_free_ char *name = NULL;
-        bool cache_flush_or_qu = false;
+        bool cache_flush_or_qu = false, pointer = false, reused = false;
+        size_t name_offset = p->rindex;
         uint16_t class, type;
         int r;
 
-        r = dns_packet_read_name(p, &name, true, NULL);
-        if (r < 0)
-                return r;
+        /* If the name is just a compression pointer, determine where it points to */
+        if (p->reuse_keys && !p->refuse_compression && p->rindex + 2 <= p->size) {
+                const uint8_t *d = DNS_PACKET_DATA(p) + p->rindex;
+
+                if (FLAGS_SET(d[0], 0xc0)) {
+                        name_offset = (size_t) (d[0] & ~0xc0) << 8 | (size_t) d[1];
+                        pointer = true;
+                }
+        }
+
+        if (ret && pointer && p->last_key && name_offset == p->last_key_name_offset) {
+                /* Same name as the previous key, which was successfully read from there already, hence
+                 * only skip over the pointer. */
+                p->rindex += 2;
+                reused = true;
+        } else {
+                r = dns_packet_read_name(p, &name, true, NULL);
+                if (r < 0)
+                        return r;
+        }
 
         r = dns_packet_read_uint16(p, &type, NULL);
         if (r < 0)
@@ -1741,11 +1760,28 @@ int dns_packet_read_key(
         if (ret) {
                 DnsResourceKey *key;
 
-                key = dns_resource_key_new_consume(class, type, name);
-                if (!key)
-                        return -ENOMEM;
+                if (reused && p->last_key->class == class && p->last_key->type == type)
+                        key = dns_resource_key_ref(p->last_key);
+                else {
+                        if (reused) {
+                                name = strdup(dns_resource_key_name(p->last_key));
+                                if (!name)
+                                        return -ENOMEM;
+                        }
+
+                        key = dns_resource_key_new_consume(class, type, name);
+                        if (!key)
+                                return -ENOMEM;
+
+                        TAKE_PTR(name);
+                }
+
+                if (p->reuse_keys && key != p->last_key) {
+                        dns_resource_key_unref(p->last_key);
+                        p->last_key = dns_resource_key_ref(key);
+                        p->last_key_name_offset = name_offset;
+                }
 
-                TAKE_PTR(name);
                 *ret = key;
         }
 
@@ -2587,12 +2623,9 @@ static int dns_packet_extract_answer(DnsPacket *p, DnsAnswer **ret_answer) {
         return 0;
 }
 
-int dns_packet_extract(DnsPacket *p) {
+static int dns_packet_extract_sections(DnsPacket *p) {
         assert(p);
 
-        if (p->extracted)
-                return 0;
-
         _cleanup_(dns_question_unrefp) DnsQuestion *question = NULL;
         _cleanup_(dns_answer_unrefp) DnsAnswer *answer = NULL;
         _unused_ _cleanup_(rewind_dns_packet) DnsPacketRewinder rewinder = REWINDER_INIT(p);
@@ -2622,6 +2655,27 @@ int dns_packet_extract(DnsPacket *p) {
         return 0;
 }
 
+int dns_packet_extract(DnsPacket *p) {
+        int r;
+
+        assert(p);
+
+        if (p->extracted)
+                return 0;
+
+        /* Typically all RRs of an RRset, and often the question too, refer to the same owner name via
+         * compression pointers. Let them share a single key object while extracting, instead of
+         * allocating a new key and name for each of them. */
+        p->reuse_keys = true;
+
+        r = dns_packet_extract_sections(p);
+
+        p->reuse_keys = false;
+        p->last_key = dns_resource_key_unref(p->last_key);
+
+        return r;
+}
+
 int dns_packet_is_reply_for(DnsPacket *p, const DnsResourceKey *key) {
         int r;
 
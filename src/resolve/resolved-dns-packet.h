@@ -71,6 +71,11 @@ struct DnsPacket {
         DnsAnswer *answer;
         DnsResourceRecord *opt;
 
+        /* While extracting: the key read last, and where its name starts in the packet, so that following
+         * RRs whose owner name is a compression pointer to the same name can share the key object */
+        DnsResourceKey *last_key;
+        size_t last_key_name_offset;
+
         /* For support of truncated packets */
         DnsPacket *more;
 
@@ -86,6 +91,7 @@ struct DnsPacket {
         bool extracted;
         bool refuse_compression;
         bool canonical_form;
+        bool reuse_keys;
 
         /* Note: fields should be ordered to minimize alignment gaps. Use pahole! */
 };
@@ -25,6 +25,21 @@
 /* The number of times we will attempt a certain feature set before degrading */
 #define DNS_SERVER_FEATURE_RETRY_ATTEMPTS 3
 
+/* The round-trip time estimate is smoothed like TCP's SRTT, i.e. each new sample accounts for 1/8 */
+#define DNS_SERVER_RTT_SMOOTHING_SHIFT 3
+
+/* Lost packets double the round-trip time estimate, up to this */
+#define DNS_SERVER_RTT_MAX_USEC (5 * USEC_PER_SEC)
+
+/* With PreferFastestDNSServer=yes, servers are compared only after this many replies */
+#define DNS_SERVER_RTT_SAMPLES_MIN 4U
+
+/* Only switch to a server that is at least twice and this much faster than the current one */
+#define DNS_SERVER_RTT_SWITCH_MIN_USEC (10 * USEC_PER_MSEC)
+
+/* When the current server is slower than this, also try servers we know nothing about yet */
+#define DNS_SERVER_RTT_SLOW_USEC (100 * USEC_PER_MSEC)
+
 int dns_server_new(
                 Manager *m,
                 DnsServer **ret,
@@ -262,7 +277,115 @@ static void dns_server_reset_counters(DnsServer *s) {
          * incomplete. */
 }
 
-void dns_server_packet_received(DnsServer *s, int protocol, DnsServerFeatureLevel level, size_t fragsize) {
+static bool dns_server_rtt_known(DnsServer *s) {
+        assert(s);
+
+        return s->n_rtt_samples >= DNS_SERVER_RTT_SAMPLES_MIN;
+}
+
+static DnsServer* dns_server_first_sibling(DnsServer *s) {
+        assert(s);
+
+        switch (s->type) {
+
+        case DNS_SERVER_SYSTEM:
+                return s->manager->dns_servers;
+
+        case DNS_SERVER_FALLBACK:
+                return s->manager->fallback_dns_servers;
+
+        case DNS_SERVER_LINK:
+                return s->link ? s->link->dns_servers : NULL;
+
+        default:
+                assert_not_reached();
+        }
+}
+
+static DnsServer* dns_server_find_faster(DnsServer *s) {
+        DnsServer *best = NULL, *unknown = NULL;
+
+        assert(s);
+
+        if (!s->linked || !dns_server_rtt_known(s))
+                return NULL;
+
+        LIST_FOREACH(servers, i, dns_server_first_sibling(s)) {
+                if (i == s || manager_server_is_stub(s->manager, i))
+                        continue;
+
+                if (!dns_server_rtt_known(i)) {
+                        if (!unknown)
+                                unknown = i;
+                        continue;
+                }
+
+                if (!best || i->rtt_usec < best->rtt_usec)
+                        best = i;
+        }
+
+        if (best &&
+            best->rtt_usec * 2 <= s->rtt_usec &&
+            usec_sub_unsigned(s->rtt_usec, best->rtt_usec) >= DNS_SERVER_RTT_SWITCH_MIN_USEC)
+                return best;
+
+        /* If we are slow and there are servers we haven't talked to enough yet, give them a chance, so that
+         * we learn how fast they are. */
+        if (unknown && s->rtt_usec >= DNS_SERVER_RTT_SLOW_USEC)
+                return unknown;
+
+        return NULL;
+}
+
+static void dns_server_maybe_switch_to_faster(DnsServer *s) {
+        DnsServer *faster;
+
+        assert(s);
+        assert(s->manager);
+
+        if (!s->manager->prefer_fastest_dns_server)
+                return;
+
+        if (s->type == DNS_SERVER_LINK ? !s->link || s->link->current_dns_server != s : s->manager->current_dns_server != s)
+                return;
+
+        faster = dns_server_find_faster(s);
+        if (!faster)
+                return;
+
+        log_debug("DNS server %s has a round-trip time of %s, trying %s instead.",
+                  strna(dns_server_string_full(s)),
+                  FORMAT_TIMESPAN(s->rtt_usec, USEC_PER_MSEC),
+                  strna(dns_server_string_full(faster)));
+
+        if (s->type == DNS_SERVER_LINK)
+                link_set_dns_server(s->link, faster);
+        else
+                manager_set_dns_server(s->manager, faster);
+}
+
+static void dns_server_update_rtt(DnsServer *s, usec_t rtt) {
+        assert(s);
+
+        if (rtt == USEC_INFINITY)
+                return;
+
+        if (s->n_rtt_samples == 0)
+                s->rtt_usec = rtt;
+        else
+                s->rtt_usec = s->rtt_usec - (s->rtt_usec >> DNS_SERVER_RTT_SMOOTHING_SHIFT) + (rtt >> DNS_SERVER_RTT_SMOOTHING_SHIFT);
+
+        if (s->n_rtt_samples < UINT_MAX)
+                s->n_rtt_samples++;
+
+        unsigned *n = &s->n_latency[dns_latency_bucket(rtt)];
+        if (*n < UINT_MAX)
+                (*n)++;
+
+        dns_server_maybe_switch_to_faster(s);
+}
+
+void dns_server_packet_received(DnsServer *s, int protocol, DnsServerFeatureLevel level, size_t fragsize, usec_t rtt) {
         assert(s);
 
         if (protocol == IPPROTO_UDP) {
@@ -295,12 +418,18 @@ void dns_server_packet_received(DnsServer *s, int protocol, DnsServerFeatureLeve
          * can always announce support for packets with at least this size. */
         if (protocol == IPPROTO_UDP && s->received_udp_fragment_max < fragsize)
                 s->received_udp_fragment_max = fragsize;
+
+        dns_server_update_rtt(s, rtt);
 }
 
 void dns_server_packet_lost(DnsServer *s, int protocol, DnsServerFeatureLevel level) {
         assert(s);
         assert(s->manager);
 
+        /* A server that doesn't reply is as bad as a slow one, make sure we don't prefer it */
+        if (s->n_rtt_samples > 0)
+                s->rtt_usec = s->rtt_usec >= DNS_SERVER_RTT_MAX_USEC / 2 ? DNS_SERVER_RTT_MAX_USEC : s->rtt_usec * 2;
+
         if (s->possible_feature_level != level)
                 return;
 
@@ -1113,10 +1242,16 @@ static const char* const dns_server_feature_level_table[_DNS_SERVER_FEATURE_LEVE
 DEFINE_STRING_TABLE_LOOKUP(dns_server_feature_level, DnsServerFeatureLevel);
 
 int dns_server_dump_state_to_json(DnsServer *server, sd_json_variant **ret) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *latency = NULL;
+        int r;
 
         assert(server);
         assert(ret);
 
+        r = dns_latency_histogram_build_json(server->n_latency, &latency);
+        if (r < 0)
+                return r;
+
         return sd_json_buildo(
                         ret,
                         SD_JSON_BUILD_PAIR_STRING("Server", strna(dns_server_string_full(server))),
@@ -1134,7 +1269,9 @@ int dns_server_dump_state_to_json(DnsServer *server, sd_json_variant **ret) {
                         SD_JSON_BUILD_PAIR_BOOLEAN("PacketBadOpt", server->packet_bad_opt),
                         SD_JSON_BUILD_PAIR_BOOLEAN("PacketRRSIGMissing", server->packet_rrsig_missing),
                         SD_JSON_BUILD_PAIR_BOOLEAN("PacketInvalid", server->packet_invalid),
-                        SD_JSON_BUILD_PAIR_BOOLEAN("PacketDoOff", server->packet_do_off));
+                        SD_JSON_BUILD_PAIR_BOOLEAN("PacketDoOff", server->packet_do_off),
+                        SD_JSON_BUILD_PAIR_CONDITION(server->n_rtt_samples > 0, "RoundTripTimeUSec", SD_JSON_BUILD_UNSIGNED(server->rtt_usec)),
+                        SD_JSON_BUILD_PAIR_VARIANT("LatencyHistogram", latency));
 }
 
 int dns_server_is_accessible(DnsServer *s) {
@@ -267,6 +267,16 @@ static ssize_t dns_stream_read(DnsStream *s, void *buf, size_t count) {
         return ss;
 }
 
+static usec_t dns_stream_established_timeout(DnsStream *s) {
+        assert(s);
+
+        /* An idle encrypted lookup stream may stay open for longer, as long as no transaction waits for it */
+        if (s->type == DNS_STREAM_LOOKUP && s->encrypted && !s->transactions && !s->write_packet)
+                return DNS_STREAM_ENCRYPTED_IDLE_TIMEOUT_USEC;
+
+        return DNS_STREAM_ESTABLISHED_TIMEOUT_USEC;
+}
+
 static int on_stream_timeout(sd_event_source *es, usec_t usec, void *userdata) {
         DnsStream *s = ASSERT_PTR(userdata);
 
@@ -462,7 +472,7 @@ static int on_stream_io(sd_event_source *es, int fd, uint32_t revents, void *use
 
         /* If we did something, let's restart the timeout event source */
         if (progressed && s->timeout_event_source) {
-                r = sd_event_source_set_time_relative(s->timeout_event_source, DNS_STREAM_ESTABLISHED_TIMEOUT_USEC);
+                r = sd_event_source_set_time_relative(s->timeout_event_source, dns_stream_established_timeout(s));
                 if (r < 0)
                         log_warning_errno(r, "Couldn't restart TCP connection timeout, ignoring: %m");
         }
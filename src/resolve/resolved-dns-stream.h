@@ -27,6 +27,10 @@ typedef struct DnsStubListenerExtra DnsStubListenerExtra;
 /* Once connections are established apply this timeout once nothing happens anymore */
 #define DNS_STREAM_ESTABLISHED_TIMEOUT_USEC (10 * USEC_PER_SEC)
 
+/* Encrypted lookup streams are expensive to set up, hence keep them around for longer while idle, so that
+ * the next lookup can reuse the session instead of doing a new TCP and TLS handshake */
+#define DNS_STREAM_ENCRYPTED_IDLE_TIMEOUT_USEC (30 * USEC_PER_SEC)
+
 typedef enum DnsStreamType {
         DNS_STREAM_LOOKUP,        /* Outgoing connection to a classic DNS server */
         DNS_STREAM_LLMNR_SEND,    /* Outgoing LLMNR TCP lookup */
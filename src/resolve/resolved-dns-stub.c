@@ -21,6 +21,10 @@
 /* On the extra stubs, use a more conservative choice */
 #define ADVERTISE_EXTRA_DATAGRAM_SIZE_MAX DNS_PACKET_UNICAST_SIZE_LARGE_MAX
 
+/* How many UDP queries to read from a stub socket per wakeup at most, so that a busy socket does not starve the
+ * other event sources */
+#define STUB_UDP_BATCH_MAX 32U
+
 static int manager_dns_stub_fd_extra(Manager *m, DnsStubListenerExtra *l, int type);
 static int manager_dns_stub_fd(Manager *m, int family, const union in_addr_union *listen_address, int type);
 
@@ -920,6 +924,8 @@ static void dns_stub_process_query(Manager *m, DnsStubListenerExtra *l, DnsStrea
                 return;
         }
 
+        m->n_stub_queries_total++;
+
         queries_by_packet = l ? &l->queries_by_packet : &m->stub_queries_by_packet;
         existing = hashmap_get(*queries_by_packet, p);
         if (existing && dns_packet_equal(existing->request_packet, p)) {
@@ -1038,19 +1044,27 @@ static void dns_stub_process_query(Manager *m, DnsStubListenerExtra *l, DnsStrea
 }
 
 static int on_dns_stub_packet_internal(sd_event_source *s, int fd, uint32_t revents, Manager *m, DnsStubListenerExtra *l) {
-        _cleanup_(dns_packet_unrefp) DnsPacket *p = NULL;
         int r;
 
-        r = manager_recv(m, fd, DNS_PROTOCOL_DNS, &p);
-        if (r <= 0)
-                return r;
+        /* Under load many queries are queued on the socket at once, hence keep reading until it is drained
+         * (or the batch is full) instead of going back to the event loop after each one. */
 
-        if (dns_packet_validate_query(p) > 0) {
-                log_debug("Got DNS stub UDP query packet for id %u", DNS_PACKET_ID(p));
+        for (unsigned i = 0; i < STUB_UDP_BATCH_MAX; i++) {
+                _cleanup_(dns_packet_unrefp) DnsPacket *p = NULL;
 
-                dns_stub_process_query(m, l, NULL, p);
-        } else
-                log_debug("Invalid DNS stub UDP packet, ignoring.");
+                r = manager_recv(m, fd, DNS_PROTOCOL_DNS, &p);
+                if (r == 0 || ERRNO_IS_NEG_TRANSIENT(r))
+                        return 0;
+                if (r < 0)
+                        return i > 0 ? 0 : r;
+
+                if (dns_packet_validate_query(p) > 0) {
+                        log_debug("Got DNS stub UDP query packet for id %u", DNS_PACKET_ID(p));
+
+                        dns_stub_process_query(m, l, NULL, p);
+                } else
+                        log_debug("Invalid DNS stub UDP packet, ignoring.");
+        }
 
         return 0;
 }
@@ -1231,6 +1231,14 @@ void dns_transaction_process_reply(DnsTransaction *t, DnsPacket *p, bool encrypt
                 return;
         }
 
+        manager_record_latency(
+                        t->scope->manager,
+                        t->scope->protocol == DNS_PROTOCOL_LLMNR ? DNS_LATENCY_LLMNR :
+                        t->scope->protocol == DNS_PROTOCOL_MDNS ? DNS_LATENCY_MDNS :
+                        encrypted ? DNS_LATENCY_TLS :
+                        p->ipproto == IPPROTO_TCP ? DNS_LATENCY_TCP : DNS_LATENCY_UDP,
+                        usec_sub_unsigned(p->timestamp, t->start_usec));
+
         switch (t->scope->protocol) {
 
         case DNS_PROTOCOL_DNS: {
@@ -1380,7 +1388,8 @@ void dns_transaction_process_reply(DnsTransaction *t, DnsPacket *p, bool encrypt
                 /* Report that we successfully received a packet. We keep track of the largest packet
                  * size/fragment size we got. Which is useful for announcing the EDNS(0) packet size we can
                  * receive to our server. */
-                dns_server_packet_received(t->server, p->ipproto, t->current_feature_level, dns_packet_size_unfragmented(p));
+                dns_server_packet_received(t->server, p->ipproto, t->current_feature_level, dns_packet_size_unfragmented(p),
+                                           usec_sub_unsigned(p->timestamp, t->start_usec));
         }
 
         /* See if we know things we didn't know before that indicate we better restart the lookup immediately. */
@@ -1674,6 +1683,61 @@ static void dns_transaction_randomize_answer(DnsTransaction *t) {
         dns_answer_randomize(t->answer);
 }
 
+static void dns_transaction_prefetch(DnsTransaction *t, usec_t ts) {
+        _cleanup_(dns_transaction_gcp) DnsTransaction *p = NULL;
+        char key_str[DNS_RESOURCE_KEY_STRING_MAX];
+        DnsResourceKey *key;
+        uint64_t query_flags;
+        int r;
+
+        assert(t);
+
+        /* Called when the transaction was answered from the cache. If the cache entry is popular and about
+         * to expire, start a detached transaction that refreshes it from the network, so that the following
+         * lookups do not have to wait for the upstream server once it expired. */
+
+        if (!t->scope->manager->cache_prefetch)
+                return;
+
+        if (t->scope->protocol != DNS_PROTOCOL_DNS || t->bypass)
+                return;
+
+        key = dns_transaction_key(t);
+        if (!dns_cache_prefetch_needed(&t->scope->cache, key, ts))
+                return;
+
+        query_flags = t->query_flags | SD_RESOLVED_NO_CACHE;
+
+        /* Already being refreshed? */
+        if (dns_scope_find_transaction(t->scope, key, query_flags))
+                return;
+
+        r = dns_transaction_new(&p, t->scope, key, NULL, query_flags);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to create transaction to refresh cache entry for %s, ignoring: %m",
+                                dns_resource_key_to_string(key, key_str, sizeof key_str));
+                return;
+        }
+
+        /* Nobody is waiting for this transaction, keep it around until the answer arrived and was cached. */
+        p->wait_for_answer = true;
+
+        log_debug("Refreshing cache entry for %s ahead of expiry in transaction %" PRIu16 ".",
+                  dns_resource_key_to_string(key, key_str, sizeof key_str), p->id);
+
+        t->scope->cache.n_prefetch++;
+
+        r = dns_transaction_go(p);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to start transaction to refresh cache entry for %s, ignoring: %m",
+                                dns_resource_key_to_string(key, key_str, sizeof key_str));
+                return;
+        }
+
+        /* The transaction is either pending now, or has already finished and was freed. */
+        TAKE_PTR(p);
+}
+
 static int dns_transaction_prepare(DnsTransaction *t, usec_t ts) {
         int r;
 
@@ -1783,6 +1847,10 @@ static int dns_transaction_prepare(DnsTransaction *t, usec_t ts) {
                  * a change of server this might flush the cache. */
                 (void) dns_scope_get_dns_server(t->scope);
 
+                /* If we have a cache left over from the previous instance, this is a good time to restore
+                 * it, now that we know the server. */
+                manager_restore_cache(t->scope->manager, t->scope);
+
                 /* Let's then prune all outdated entries */
                 dns_cache_prune(&t->scope->cache);
 
@@ -1828,6 +1896,9 @@ static int dns_transaction_prepare(DnsTransaction *t, usec_t ts) {
                                                 dns_resource_key_to_string(dns_transaction_key(t), key_str, sizeof key_str));
                                 }
 
+                                if (FLAGS_SET(query_flags, SD_RESOLVED_NO_STALE))
+                                        dns_transaction_prefetch(t, ts);
+
                                 t->answer_source = DNS_TRANSACTION_CACHE;
                                 if (t->answer_rcode == DNS_RCODE_SUCCESS)
                                         dns_transaction_complete(t, DNS_TRANSACTION_SUCCESS);
@@ -3302,6 +3373,7 @@ static int dnssec_validate_records(
                                 rr->key,
                                 t->validated_keys,
                                 USEC_INFINITY,
+                                &t->scope->manager->dnssec_verify_cache,
                                 &result,
                                 &rrsig);
                 if (r < 0)
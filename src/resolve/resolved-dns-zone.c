@@ -45,6 +45,8 @@ static void dns_zone_item_remove_and_free(DnsZone *z, DnsZoneItem *i) {
         if (!i)
                 return;
 
+        hashmap_remove_value(z->by_rr, i->rr, i);
+
         first = hashmap_get(z->by_key, i->rr->key);
         LIST_REMOVE(by_key, first, i);
         if (first)
@@ -72,20 +74,18 @@ void dns_zone_flush(DnsZone *z) {
 
         assert(hashmap_isempty(z->by_key));
         assert(hashmap_isempty(z->by_name));
+        assert(hashmap_isempty(z->by_rr));
 
         z->by_key = hashmap_free(z->by_key);
         z->by_name = hashmap_free(z->by_name);
+        z->by_rr = hashmap_free(z->by_rr);
 }
 
 DnsZoneItem* dns_zone_get(DnsZone *z, DnsResourceRecord *rr) {
         assert(z);
         assert(rr);
 
-        LIST_FOREACH(by_key, i, (DnsZoneItem*) hashmap_get(z->by_key, rr->key))
-                if (dns_resource_record_equal(i->rr, rr) > 0)
-                        return i;
-
-        return NULL;
+        return hashmap_get(z->by_rr, rr);
 }
 
 void dns_zone_remove_rr(DnsZone *z, DnsResourceRecord *rr) {
@@ -130,6 +130,10 @@ static int dns_zone_init(DnsZone *z) {
         if (r < 0)
                 return r;
 
+        r = hashmap_ensure_allocated(&z->by_rr, &dns_resource_record_hash_ops);
+        if (r < 0)
+                return r;
+
         return 0;
 }
 
@@ -137,6 +141,10 @@ static int dns_zone_link_item(DnsZone *z, DnsZoneItem *i) {
         DnsZoneItem *first;
         int r;
 
+        r = hashmap_put(z->by_rr, i->rr, i);
+        if (r < 0)
+                return r;
+
         first = hashmap_get(z->by_key, i->rr->key);
         if (first) {
                 LIST_PREPEND(by_key, first, i);
@@ -6,6 +6,8 @@
 typedef struct DnsZone {
         Hashmap *by_key;
         Hashmap *by_name;
+        Hashmap *by_rr;   /* DnsResourceRecord → DnsZoneItem, so that dns_zone_get() is not linear in the
+                           * number of items with the same key, e.g. many PTR records for a DNS-SD service */
 } DnsZone;
 
 typedef struct DnsZoneItem DnsZoneItem;
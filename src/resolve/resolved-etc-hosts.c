@@ -41,7 +41,7 @@ static EtcHostsItemByName *etc_hosts_item_by_name_free(EtcHostsItemByName *item)
                 return NULL;
 
         free(item->name);
-        set_free(item->addresses);
+        free(item->addresses);
         return mfree(item);
 }
 
@@ -55,6 +55,21 @@ DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(
         EtcHostsItemByName,
         etc_hosts_item_by_name_free);
 
+static int etc_hosts_item_by_name_add_address(EtcHostsItemByName *item, const struct in_addr_data *address) {
+        assert(item);
+        assert(address);
+
+        FOREACH_ARRAY(a, item->addresses, item->n_addresses)
+                if (in_addr_data_compare_func(a, address) == 0)
+                        return 0;
+
+        if (!GREEDY_REALLOC(item->addresses, item->n_addresses + 1))
+                return -ENOMEM;
+
+        item->addresses[item->n_addresses++] = *address;
+        return 1;
+}
+
 void etc_hosts_clear(EtcHosts *hosts) {
         assert(hosts);
 
@@ -177,17 +192,9 @@ static int parse_line(EtcHosts *hosts, unsigned nr, const char *line) {
                         bn = TAKE_PTR(new_item);
                 }
 
-                if (!set_contains(bn->addresses, &address)) {
-                        _cleanup_free_ struct in_addr_data *address_copy = NULL;
-
-                        address_copy = newdup(struct in_addr_data, &address, 1);
-                        if (!address_copy)
-                                return log_oom();
-
-                        r = set_ensure_consume(&bn->addresses, &in_addr_data_hash_ops_free, TAKE_PTR(address_copy));
-                        if (r < 0)
-                                return log_oom();
-                }
+                r = etc_hosts_item_by_name_add_address(bn, &address);
+                if (r < 0)
+                        return log_oom();
 
                 r = set_ensure_put(&item->names, &dns_name_hash_ops_free, name);
                 if (r < 0)
@@ -260,7 +267,6 @@ static void strip_localhost(EtcHosts *hosts) {
                 all_local_address = true;
                 SET_FOREACH(name, item->names) {
                         EtcHostsItemByName *n;
-                        struct in_addr_data *a;
 
                         n = hashmap_get(hosts->by_name, name);
                         if (!n) /* No reverse entry? Then almost certainly the entry already got deleted from
@@ -268,7 +274,7 @@ static void strip_localhost(EtcHosts *hosts) {
                                 break;
 
                         /* Now check if the addresses of this item are all localhost addresses */
-                        SET_FOREACH(a, n->addresses)
+                        FOREACH_ARRAY(a, n->addresses, n->n_addresses)
                                 if (!in_addr_is_localhost(a->family, &a->address)) {
                                         all_local_address = false;
                                         break;
@@ -492,7 +498,6 @@ static int etc_hosts_lookup_by_name(
                 DnsAnswer **answer) {
 
         bool question_for_a = false, question_for_aaaa = false;
-        const struct in_addr_data *a;
         EtcHostsItemByName *item;
         DnsResourceKey *t;
         int r;
@@ -503,15 +508,13 @@ static int etc_hosts_lookup_by_name(
         assert(answer);
 
         item = hashmap_get(hosts->by_name, name);
-        if (item) {
-                r = dns_answer_reserve(answer, set_size(item->addresses));
-                if (r < 0)
-                        return r;
-        } else {
-                /* Check if name was listed with no address. If yes, continue to return an answer. */
-                if (!set_contains(hosts->no_address, name))
-                        return 0;
-        }
+        if (!item)
+                /* Check if name was listed with no address. If yes, return an empty answer. */
+                return set_contains(hosts->no_address, name);
+
+        r = dns_answer_reserve(answer, item->n_addresses);
+        if (r < 0)
+                return r;
 
         /* Determine whether we are looking for A and/or AAAA RRs */
         DNS_QUESTION_FOREACH(t, q) {
@@ -535,7 +538,7 @@ static int etc_hosts_lookup_by_name(
                         break; /* We are looking for both, no need to continue loop */
         }
 
-        SET_FOREACH(a, item ? item->addresses : NULL) {
+        FOREACH_ARRAY(a, item->addresses, item->n_addresses) {
                 EtcHostsItemByAddress *item_by_addr;
                 const char *canonical_name;
 
@@ -13,7 +13,11 @@ typedef struct EtcHostsItemByAddress {
 
 typedef struct EtcHostsItemByName {
         char *name;
-        Set *addresses;
+
+        /* Most names have only one or two addresses, hence keep them in an array in the order they appear in
+         * the file, rather than allocating a Set for each name */
+        struct in_addr_data *addresses;
+        size_t n_addresses;
 } EtcHostsItemByName;
 
 int etc_hosts_parse(EtcHosts *hosts, FILE *f);
@@ -630,6 +630,10 @@ static void manager_set_defaults(Manager *m) {
         m->read_etc_hosts = true;
         m->resolve_unicast_single_label = false;
         m->cache_from_localhost = false;
+        m->cache_prefetch = false;
+        m->cache_persist = false;
+        m->cache_memory_max = DNS_CACHE_MEMORY_MAX_DEFAULT;
+        m->prefer_fastest_dns_server = false;
         m->stale_retention_usec = 0;
         m->refuse_record_types = set_free(m->refuse_record_types);
 }
@@ -676,6 +680,9 @@ static int manager_dispatch_reload_signal(sd_event_source *s, const struct signa
         if (r < 0)
                 log_warning_errno(r, "Failed to update network information: %m");
 
+        LIST_FOREACH(scopes, s, m->dns_scopes)
+                s->cache.max_bytes = m->cache_memory_max;
+
         /* We have new configuration, which means potentially new servers, so close all connections and drop
          * all caches, so that we can start fresh. */
         (void) dns_stream_disconnect_all(m);
@@ -858,6 +865,8 @@ Manager *manager_free(Manager *m) {
         sd_event_source_unref(m->clock_change_event_source);
 
         sd_json_variant_unref(m->dns_configuration_json);
+        sd_json_variant_unref(m->serialized_cache);
+        dnssec_verify_cache_flush(&m->dnssec_verify_cache);
 
         manager_llmnr_stop(m);
         manager_mdns_stop(m);
@@ -1759,9 +1768,128 @@ void manager_flush_caches(Manager *m, int log_level) {
         LIST_FOREACH(scopes, scope, m->dns_scopes)
                 dns_cache_flush(&scope->cache);
 
+        dnssec_verify_cache_flush(&m->dnssec_verify_cache);
+
         log_full(log_level, "Flushed all caches.");
 }
 
+#define SERIALIZED_CACHE_PATH "/run/systemd/resolve/cache.json"
+
+int manager_serialize_cache(Manager *m) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        _cleanup_free_ char *text = NULL;
+        int r;
+
+        assert(m);
+
+        /* Writes out the unicast DNS caches on shutdown, so that the next instance (e.g. after a restart or
+         * an upgrade) doesn't have to start from a cold cache. The runtime directory is preserved across
+         * restarts, and the entries carry CLOCK_BOOTTIME timestamps, hence this doesn't survive reboots. */
+
+        if (!m->cache_persist || m->enable_cache == DNS_CACHE_MODE_NO)
+                return 0;
+
+        LIST_FOREACH(scopes, s, m->dns_scopes) {
+                _cleanup_(sd_json_variant_unrefp) sd_json_variant *c = NULL;
+                char ifindex_str[DECIMAL_STR_MAX(int)];
+
+                if (s->protocol != DNS_PROTOCOL_DNS)
+                        continue;
+
+                r = dns_cache_serialize(&s->cache, &c);
+                if (r < 0)
+                        return log_warning_errno(r, "Failed to serialize DNS cache, ignoring: %m");
+
+                if (sd_json_variant_elements(c) == 0)
+                        continue;
+
+                xsprintf(ifindex_str, "%i", dns_scope_ifindex(s));
+
+                r = sd_json_variant_set_field(&v, ifindex_str, c);
+                if (r < 0)
+                        return log_warning_errno(r, "Failed to serialize DNS cache, ignoring: %m");
+        }
+
+        if (!v)
+                return 0;
+
+        r = sd_json_variant_format(v, /* flags= */ 0, &text);
+        if (r < 0)
+                return log_warning_errno(r, "Failed to format serialized DNS cache, ignoring: %m");
+
+        r = write_string_file(SERIALIZED_CACHE_PATH, text,
+                              WRITE_STRING_FILE_CREATE|WRITE_STRING_FILE_ATOMIC|WRITE_STRING_FILE_MODE_0600);
+        if (r < 0)
+                return log_warning_errno(r, "Failed to write %s, ignoring: %m", SERIALIZED_CACHE_PATH);
+
+        log_debug("Serialized DNS cache to %s.", SERIALIZED_CACHE_PATH);
+        return 1;
+}
+
+int manager_deserialize_cache(Manager *m) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r;
+
+        assert(m);
+
+        /* Picks up the cache written by the previous instance. The file is removed right away, so that
+         * stale data is never loaded twice. The entries are only restored into the scopes once these have
+         * picked their server, see manager_restore_cache(). */
+
+        r = sd_json_parse_file(/* f= */ NULL, SERIALIZED_CACHE_PATH, /* flags= */ 0, &v, /* reterr_line= */ NULL, /* reterr_column= */ NULL);
+        if (r == -ENOENT)
+                return 0;
+        if (unlink(SERIALIZED_CACHE_PATH) < 0 && errno != ENOENT)
+                log_debug_errno(errno, "Failed to remove %s, ignoring: %m", SERIALIZED_CACHE_PATH);
+        if (r < 0)
+                return log_warning_errno(r, "Failed to parse %s, ignoring: %m", SERIALIZED_CACHE_PATH);
+
+        if (!m->cache_persist || m->enable_cache == DNS_CACHE_MODE_NO)
+                return 0;
+
+        if (!sd_json_variant_is_object(v))
+                return log_warning_errno(SYNTHETIC_ERRNO(EINVAL), "Serialized DNS cache is not a JSON object, ignoring.");
+
+        sd_json_variant_unref(m->serialized_cache);
+        m->serialized_cache = TAKE_PTR(v);
+        return 1;
+}
+
+void manager_restore_cache(Manager *m, DnsScope *s) {
+        char ifindex_str[DECIMAL_STR_MAX(int)];
+        sd_json_variant *c;
+        DnsServer *server;
+        int r;
+
+        assert(m);
+        assert(s);
+
+        if (!m->serialized_cache || s->protocol != DNS_PROTOCOL_DNS)
+                return;
+
+        xsprintf(ifindex_str, "%i", dns_scope_ifindex(s));
+
+        c = sd_json_variant_by_key(m->serialized_cache, ifindex_str);
+        if (!c)
+                return;
+
+        /* Switching servers flushes the cache, hence only restore once the scope settled on one, and only
+         * the entries that came from that very server. */
+        server = dns_scope_get_dns_server(s);
+        if (!server)
+                return;
+
+        r = dns_cache_deserialize(&s->cache, m->enable_cache, c, server->family, &server->address, m->stale_retention_usec);
+        if (r < 0)
+                log_debug_errno(r, "Failed to restore serialized DNS cache for interface %s, ignoring: %m", ifindex_str);
+        else
+                log_debug("Restored %i serialized DNS cache entries for interface %s.", r, ifindex_str);
+
+        r = sd_json_variant_filter(&m->serialized_cache, STRV_MAKE(ifindex_str));
+        if (r < 0 || sd_json_variant_elements(m->serialized_cache) == 0)
+                m->serialized_cache = sd_json_variant_unref(m->serialized_cache);
+}
+
 void manager_reset_server_features(Manager *m) {
         Link *l;
 
@@ -1937,16 +2065,89 @@ int socket_disable_pmtud(int fd, int af) {
         }
 }
 
+static const char* const dns_latency_protocol_table[_DNS_LATENCY_PROTOCOL_MAX] = {
+        [DNS_LATENCY_UDP]   = "udp",
+        [DNS_LATENCY_TCP]   = "tcp",
+        [DNS_LATENCY_TLS]   = "tls",
+        [DNS_LATENCY_LLMNR] = "llmnr",
+        [DNS_LATENCY_MDNS]  = "mdns",
+};
+
+DEFINE_STRING_TABLE_LOOKUP_TO_STRING(dns_latency_protocol, DnsLatencyProtocol);
+
+void manager_record_latency(Manager *m, DnsLatencyProtocol protocol, usec_t latency) {
+        unsigned *n;
+
+        assert(m);
+        assert(protocol >= 0 && protocol < _DNS_LATENCY_PROTOCOL_MAX);
+
+        if (latency == USEC_INFINITY)
+                return;
+
+        n = &m->n_latency[protocol][dns_latency_bucket(latency)];
+        if (*n < UINT_MAX)
+                (*n)++;
+}
+
+int dns_latency_histogram_build_json(const unsigned histogram[static DNS_LATENCY_BUCKETS], sd_json_variant **ret) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r;
+
+        assert(histogram);
+        assert(ret);
+
+        for (unsigned i = 0; i < DNS_LATENCY_BUCKETS; i++) {
+                r = sd_json_variant_append_arrayb(&v, SD_JSON_BUILD_UNSIGNED(histogram[i]));
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = TAKE_PTR(v);
+        return 0;
+}
+
+static int latency_build_json(Manager *m, sd_json_variant **ret) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r;
+
+        assert(m);
+        assert(ret);
+
+        for (DnsLatencyProtocol p = 0; p < _DNS_LATENCY_PROTOCOL_MAX; p++) {
+                _cleanup_(sd_json_variant_unrefp) sd_json_variant *a = NULL;
+
+                r = dns_latency_histogram_build_json(m->n_latency[p], &a);
+                if (r < 0)
+                        return r;
+
+                r = sd_json_variant_set_field(&v, dns_latency_protocol_to_string(p), a);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = TAKE_PTR(v);
+        return 0;
+}
+
 int dns_manager_dump_statistics_json(Manager *m, sd_json_variant **ret) {
-        uint64_t size = 0, hit = 0, miss = 0;
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *latency = NULL;
+        uint64_t size = 0, bytes = 0, hit = 0, miss = 0, prefetch = 0, rejected = 0;
+        int r;
 
         assert(m);
         assert(ret);
 
+        r = latency_build_json(m, &latency);
+        if (r < 0)
+                return r;
+
         LIST_FOREACH(scopes, s, m->dns_scopes) {
                 size += dns_cache_size(&s->cache);
+                bytes += dns_cache_bytes(&s->cache);
                 hit += s->cache.n_hit;
                 miss += s->cache.n_miss;
+                prefetch += s->cache.n_prefetch;
+                rejected += s->cache.n_rejected;
         }
 
         return sd_json_buildo(ret,
@@ -1956,34 +2157,54 @@ int dns_manager_dump_statistics_json(Manager *m, sd_json_variant **ret) {
                                                                  SD_JSON_BUILD_PAIR_UNSIGNED("totalTimeouts", m->n_timeouts_total),
                                                                  SD_JSON_BUILD_PAIR_UNSIGNED("totalTimeoutsServedStale", m->n_timeouts_served_stale_total),
                                                                  SD_JSON_BUILD_PAIR_UNSIGNED("totalFailedResponses", m->n_failure_responses_total),
-                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("totalFailedResponsesServedStale", m->n_failure_responses_served_stale_total)
+                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("totalFailedResponsesServedStale", m->n_failure_responses_served_stale_total),
+                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("totalStubQueries", m->n_stub_queries_total)
                                                  )),
+                              SD_JSON_BUILD_PAIR_VARIANT("latency", latency),
                               SD_JSON_BUILD_PAIR("cache", SD_JSON_BUILD_OBJECT(
                                                                  SD_JSON_BUILD_PAIR_UNSIGNED("size", size),
                                                                  SD_JSON_BUILD_PAIR_UNSIGNED("hits", hit),
-                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("misses", miss)
+                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("misses", miss),
+                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("prefetches", prefetch),
+                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("bytes", bytes),
+                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("rejected", rejected)
                                                  )),
                               SD_JSON_BUILD_PAIR("dnssec", SD_JSON_BUILD_OBJECT(
                                                                  SD_JSON_BUILD_PAIR_UNSIGNED("secure", m->n_dnssec_verdict[DNSSEC_SECURE]),
                                                                  SD_JSON_BUILD_PAIR_UNSIGNED("insecure", m->n_dnssec_verdict[DNSSEC_INSECURE]),
                                                                  SD_JSON_BUILD_PAIR_UNSIGNED("bogus", m->n_dnssec_verdict[DNSSEC_BOGUS]),
-                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("indeterminate", m->n_dnssec_verdict[DNSSEC_INDETERMINATE])
+                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("indeterminate", m->n_dnssec_verdict[DNSSEC_INDETERMINATE]),
+                                                                 SD_JSON_BUILD_PAIR_UNSIGNED("verificationsCached", m->dnssec_verify_cache.n_hit)
                                                  )));
 }
 
+static void dns_server_reset_latency_all(DnsServer *first) {
+        LIST_FOREACH(servers, s, first)
+                zero(s->n_latency);
+}
+
 void dns_manager_reset_statistics(Manager *m) {
+        Link *l;
 
         assert(m);
 
+        dns_server_reset_latency_all(m->dns_servers);
+        dns_server_reset_latency_all(m->fallback_dns_servers);
+        HASHMAP_FOREACH(l, m->links)
+                dns_server_reset_latency_all(l->dns_servers);
+
         LIST_FOREACH(scopes, s, m->dns_scopes)
-                s->cache.n_hit = s->cache.n_miss = 0;
+                s->cache.n_hit = s->cache.n_miss = s->cache.n_prefetch = s->cache.n_rejected = 0;
 
         m->n_transactions_total = 0;
         m->n_timeouts_total = 0;
         m->n_timeouts_served_stale_total = 0;
         m->n_failure_responses_total = 0;
         m->n_failure_responses_served_stale_total = 0;
+        m->n_stub_queries_total = 0;
+        zero(m->n_latency);
         zero(m->n_dnssec_verdict);
+        m->dnssec_verify_cache.n_hit = 0;
 }
 
 static int dns_configuration_json_append(
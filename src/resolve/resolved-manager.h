@@ -27,6 +27,16 @@ typedef struct Manager Manager;
 #define MANAGER_SEARCH_DOMAINS_MAX 256
 #define MANAGER_DNS_SERVERS_MAX 256
 
+typedef enum DnsLatencyProtocol {
+        DNS_LATENCY_UDP,
+        DNS_LATENCY_TCP,
+        DNS_LATENCY_TLS,
+        DNS_LATENCY_LLMNR,
+        DNS_LATENCY_MDNS,
+        _DNS_LATENCY_PROTOCOL_MAX,
+        _DNS_LATENCY_PROTOCOL_INVALID = -EINVAL,
+} DnsLatencyProtocol;
+
 typedef struct EtcHosts {
         Hashmap *by_address;
         Hashmap *by_name;
@@ -42,6 +52,10 @@ struct Manager {
         DnsOverTlsMode dns_over_tls_mode;
         DnsCacheMode enable_cache;
         bool cache_from_localhost;
+        bool cache_prefetch;
+        bool cache_persist;
+        uint64_t cache_memory_max;
+        bool prefer_fastest_dns_server;
         DnsStubListenerMode dns_stub_listener_mode;
         usec_t stale_retention_usec;
 
@@ -129,7 +143,11 @@ struct Manager {
         unsigned n_failure_responses_total;
         unsigned n_failure_responses_served_stale_total;
 
+        unsigned n_stub_queries_total;
+        unsigned n_latency[_DNS_LATENCY_PROTOCOL_MAX][DNS_LATENCY_BUCKETS];
+
         unsigned n_dnssec_verdict[_DNSSEC_VERDICT_MAX];
+        DnssecVerifyCache dnssec_verify_cache;
 
         /* Data from /etc/hosts */
         EtcHosts etc_hosts;
@@ -160,6 +178,9 @@ struct Manager {
 
         sd_json_variant *dns_configuration_json;
 
+        /* Cache entries of the previous instance not restored yet, keyed by the scope's ifindex */
+        sd_json_variant *serialized_cache;
+
         sd_netlink_slot *netlink_new_route_slot;
         sd_netlink_slot *netlink_del_route_slot;
 
@@ -221,6 +242,9 @@ void manager_dnssec_verdict(Manager *m, DnssecVerdict verdict, const DnsResource
 bool manager_routable(Manager *m);
 
 void manager_flush_caches(Manager *m, int log_level);
+int manager_serialize_cache(Manager *m);
+int manager_deserialize_cache(Manager *m);
+void manager_restore_cache(Manager *m, DnsScope *s);
 void manager_reset_server_features(Manager *m);
 
 void manager_cleanup_saved_user(Manager *m);
@@ -231,6 +255,9 @@ bool manager_server_is_stub(Manager *m, DnsServer *s);
 
 int socket_disable_pmtud(int fd, int af);
 
+void manager_record_latency(Manager *m, DnsLatencyProtocol protocol, usec_t latency);
+int dns_latency_histogram_build_json(const unsigned histogram[static DNS_LATENCY_BUCKETS], sd_json_variant **ret);
+
 int dns_manager_dump_statistics_json(Manager *m, sd_json_variant **ret);
 
 void dns_manager_reset_statistics(Manager *m);
@@ -238,5 +265,7 @@ void dns_manager_reset_statistics(Manager *m);
 int manager_dump_dns_configuration_json(Manager *m, sd_json_variant **ret);
 int manager_send_dns_configuration_changed(Manager *m, Link *l, bool reset);
 
+const char* dns_latency_protocol_to_string(DnsLatencyProtocol p) _const_;
+
 int manager_start_dns_configuration_monitor(Manager *m);
 void manager_stop_dns_configuration_monitor(Manager *m);
@@ -4,9 +4,11 @@
 #include "glyph-util.h"
 #include "in-addr-util.h"
 #include "json-util.h"
+#include "metrics.h"
 #include "resolved-dns-synthesize.h"
 #include "resolved-varlink.h"
 #include "socket-netlink.h"
+#include "varlink-io.systemd.Metrics.h"
 #include "varlink-io.systemd.Resolve.h"
 #include "varlink-io.systemd.Resolve.Monitor.h"
 #include "varlink-io.systemd.service.h"
@@ -1423,6 +1425,134 @@ static int varlink_monitor_server_init(Manager *m) {
         return 0;
 }
 
+static int metric_transactions(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, hashmap_size(m->dns_transactions));
+}
+
+static int metric_transactions_total(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->n_transactions_total);
+}
+
+static int metric_timeouts_total(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->n_timeouts_total);
+}
+
+static int metric_failed_responses_total(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->n_failure_responses_total);
+}
+
+static int metric_stub_queries_total(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, m->n_stub_queries_total);
+}
+
+static int metric_cache_hits(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+        uint64_t n = 0;
+
+        LIST_FOREACH(scopes, s, m->dns_scopes)
+                n += s->cache.n_hit;
+
+        return metric_append_value(array, f, NULL, NULL, n);
+}
+
+static int metric_cache_misses(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+        uint64_t n = 0;
+
+        LIST_FOREACH(scopes, s, m->dns_scopes)
+                n += s->cache.n_miss;
+
+        return metric_append_value(array, f, NULL, NULL, n);
+}
+
+static int metric_cache_size(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+        uint64_t n = 0;
+
+        LIST_FOREACH(scopes, s, m->dns_scopes)
+                n += dns_cache_size(&s->cache);
+
+        return metric_append_value(array, f, NULL, NULL, n);
+}
+
+static int metric_cache_bytes(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+        uint64_t n = 0;
+
+        LIST_FOREACH(scopes, s, m->dns_scopes)
+                n += dns_cache_bytes(&s->cache);
+
+        return metric_append_value(array, f, NULL, NULL, n);
+}
+
+static int metric_dnssec_verdicts(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+        int r;
+
+        for (DnssecVerdict v = 0; v < _DNSSEC_VERDICT_MAX; v++) {
+                r = metric_append_value(array, f, "verdict", dnssec_verdict_to_string(v), m->n_dnssec_verdict[v]);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int metric_latency(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *m = ASSERT_PTR(userdata);
+        int r;
+
+        for (DnsLatencyProtocol p = 0; p < _DNS_LATENCY_PROTOCOL_MAX; p++) {
+                uint64_t buckets[DNS_LATENCY_BUCKETS];
+
+                for (unsigned i = 0; i < DNS_LATENCY_BUCKETS; i++)
+                        buckets[i] = m->n_latency[p][i];
+
+                r = metric_append_buckets(array, f, "protocol", dns_latency_protocol_to_string(p),
+                                          buckets, ELEMENTSOF(buckets), /* sum= */ UINT64_MAX);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static const MetricFamily manager_metric_families[] = {
+        { "io.systemd.Resolve.Transactions",         "DNS transactions currently ongoing",                   METRIC_GAUGE,     metric_transactions           },
+        { "io.systemd.Resolve.TransactionsTotal",    "DNS transactions started",                             METRIC_COUNTER,   metric_transactions_total     },
+        { "io.systemd.Resolve.TimeoutsTotal",        "DNS transactions that timed out",                      METRIC_COUNTER,   metric_timeouts_total         },
+        { "io.systemd.Resolve.FailedResponsesTotal", "DNS transactions that failed with an error response",  METRIC_COUNTER,   metric_failed_responses_total },
+        { "io.systemd.Resolve.StubQueriesTotal",     "Queries received by the stub resolver",                METRIC_COUNTER,   metric_stub_queries_total     },
+        { "io.systemd.Resolve.CacheHitsTotal",       "Cache hits",                                           METRIC_COUNTER,   metric_cache_hits             },
+        { "io.systemd.Resolve.CacheMissesTotal",     "Cache misses",                                         METRIC_COUNTER,   metric_cache_misses           },
+        { "io.systemd.Resolve.CacheEntries",         "Resource records in the cache",                        METRIC_GAUGE,     metric_cache_size             },
+        { "io.systemd.Resolve.CacheBytes",           "Memory used by the cache, in bytes",                   METRIC_GAUGE,     metric_cache_bytes            },
+        { "io.systemd.Resolve.DNSSECVerdictsTotal",  "DNSSEC validation results, by verdict",                METRIC_COUNTER,   metric_dnssec_verdicts        },
+        { "io.systemd.Resolve.LatencyMSec",          "Round trip times of packets, in ms, by protocol",      METRIC_HISTOGRAM, metric_latency                },
+        {}
+};
+
+static int vl_method_list_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        Manager *m = ASSERT_PTR(sd_varlink_server_get_userdata(sd_varlink_get_server(link)));
+
+        /* The counters are reset by ResetStatistics(), hence may decrease */
+        return metrics_method_list(link, parameters, manager_metric_families, m);
+}
+
+static int vl_method_describe_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_describe(link, parameters, manager_metric_families);
+}
+
 static int varlink_main_server_init(Manager *m) {
         _cleanup_(sd_varlink_server_unrefp) sd_varlink_server *s = NULL;
         int r;
@@ -1439,6 +1569,7 @@ static int varlink_main_server_init(Manager *m) {
         r = sd_varlink_server_add_interface_many(
                         s,
                         &vl_interface_io_systemd_Resolve,
+                        &vl_interface_io_systemd_Metrics,
                         &vl_interface_io_systemd_service);
         if (r < 0)
                 return log_error_errno(r, "Failed to add Resolve interface to varlink server: %m");
@@ -1449,6 +1580,8 @@ static int varlink_main_server_init(Manager *m) {
                         "io.systemd.Resolve.ResolveAddress",  vl_method_resolve_address,
                         "io.systemd.Resolve.ResolveService",  vl_method_resolve_service,
                         "io.systemd.Resolve.ResolveRecord",   vl_method_resolve_record,
+                        "io.systemd.Metrics.List",            vl_method_list_metrics,
+                        "io.systemd.Metrics.Describe",        vl_method_describe_metrics,
                         "io.systemd.service.Ping",            varlink_method_ping,
                         "io.systemd.service.SetLogLevel",     varlink_method_set_log_level,
                         "io.systemd.service.GetEnvironment",  varlink_method_get_environment);
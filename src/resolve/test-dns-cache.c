@@ -271,6 +271,60 @@ TEST(dns_a_success_mdns_same_key_different_payloads) {
         ASSERT_EQ(dns_cache_size(&cache), 1u);
 }
 
+TEST(dns_a_success_memory_max_admission) {
+        _cleanup_(dns_cache_unrefp) DnsCache cache = new_cache();
+        _cleanup_(put_args_unrefp) PutArgs args1 = mk_put_args(), args2 = mk_put_args();
+
+        /* Any second entry exceeds the limit */
+        cache.max_bytes = 1;
+
+        args1.key = dns_resource_key_new(DNS_CLASS_IN, DNS_TYPE_A, "a.example.com");
+        ASSERT_NOT_NULL(args1.key);
+        answer_add_a(&args1, args1.key, 0xc0a8017f, 3600, DNS_ANSWER_CACHEABLE);
+
+        args2.key = dns_resource_key_new(DNS_CLASS_IN, DNS_TYPE_A, "b.example.com");
+        ASSERT_NOT_NULL(args2.key);
+        answer_add_a(&args2, args2.key, 0xc0a8017e, 3600, DNS_ANSWER_CACHEABLE);
+
+        /* The first entry is always admitted */
+        ASSERT_OK(cache_put(&cache, &args1));
+        ASSERT_EQ(dns_cache_size(&cache), 1u);
+        ASSERT_GT(dns_cache_bytes(&cache), 0u);
+
+        /* A key seen for the first time does not evict it… */
+        ASSERT_OK(cache_put(&cache, &args2));
+        ASSERT_EQ(dns_cache_size(&cache), 1u);
+        ASSERT_EQ(cache.n_rejected, 1u);
+
+        /* …but updating the existing entry is fine… */
+        ASSERT_OK(cache_put(&cache, &args1));
+        ASSERT_EQ(dns_cache_size(&cache), 1u);
+        ASSERT_EQ(cache.n_rejected, 1u);
+
+        /* …responses alone don't count, only lookups do… */
+        ASSERT_OK(cache_put(&cache, &args2));
+        ASSERT_EQ(dns_cache_size(&cache), 1u);
+        ASSERT_EQ(cache.n_rejected, 2u);
+
+        /* …so a key looked up again is admitted, and takes the place of the old entry */
+        ASSERT_FALSE(dns_cache_lookup(&cache, args2.key, 0, NULL, NULL, NULL, NULL, NULL));
+        ASSERT_OK(cache_put(&cache, &args2));
+        ASSERT_EQ(dns_cache_size(&cache), 1u);
+        ASSERT_EQ(cache.n_rejected, 2u);
+        ASSERT_OK_POSITIVE(dns_cache_lookup(&cache, args2.key, 0, NULL, NULL, NULL, NULL, NULL));
+        ASSERT_FALSE(dns_cache_lookup(&cache, args1.key, 0, NULL, NULL, NULL, NULL, NULL));
+
+        /* Responses outside of unicast DNS are always admitted */
+        args1.protocol = DNS_PROTOCOL_LLMNR;
+        ASSERT_OK(cache_put(&cache, &args1));
+        ASSERT_EQ(dns_cache_size(&cache), 1u);
+        ASSERT_EQ(cache.n_rejected, 2u);
+        ASSERT_OK_POSITIVE(dns_cache_lookup(&cache, args1.key, 0, NULL, NULL, NULL, NULL, NULL));
+
+        dns_cache_flush(&cache);
+        ASSERT_EQ(dns_cache_bytes(&cache), 0u);
+}
+
 TEST(dns_a_success_escaped_key_returns_error) {
         _cleanup_(dns_cache_unrefp) DnsCache cache = new_cache();
         _cleanup_(put_args_unrefp) PutArgs put_args = mk_put_args();
@@ -608,6 +662,75 @@ TEST(dns_cache_lookup_clamp_ttl) {
         ASSERT_TRUE(dns_answer_contains(ret_answer, rr));
 }
 
+TEST(dns_cache_prefetch_needed) {
+        _cleanup_(dns_cache_unrefp) DnsCache cache = new_cache();
+        _cleanup_(put_args_unrefp) PutArgs put_args = mk_put_args();
+        _cleanup_(dns_resource_key_unrefp) DnsResourceKey *key = NULL;
+        usec_t ts;
+
+        put_args.key = dns_resource_key_new(DNS_CLASS_IN, DNS_TYPE_A, "www.example.com");
+        ASSERT_NOT_NULL(put_args.key);
+        put_args.rcode = DNS_RCODE_SUCCESS;
+        answer_add_a(&put_args, put_args.key, 0xc0a8017f, 3600, DNS_ANSWER_CACHEABLE);
+        ts = now(CLOCK_BOOTTIME);
+        cache_put(&cache, &put_args);
+
+        key = dns_resource_key_new(DNS_CLASS_IN, DNS_TYPE_A, "www.example.com");
+        ASSERT_NOT_NULL(key);
+
+        /* Not looked up often enough yet */
+        ASSERT_OK_POSITIVE(dns_cache_lookup(&cache, key, 0, NULL, NULL, NULL, NULL, NULL));
+        ASSERT_FALSE(dns_cache_prefetch_needed(&cache, key, ts + 3500 * USEC_PER_SEC));
+
+        /* Popular now, but only refreshed during the last tenth of the TTL, and not after it expired */
+        ASSERT_OK_POSITIVE(dns_cache_lookup(&cache, key, 0, NULL, NULL, NULL, NULL, NULL));
+        ASSERT_FALSE(dns_cache_prefetch_needed(&cache, key, ts + 3000 * USEC_PER_SEC));
+        ASSERT_TRUE(dns_cache_prefetch_needed(&cache, key, ts + 3500 * USEC_PER_SEC));
+        ASSERT_FALSE(dns_cache_prefetch_needed(&cache, key, ts + 3700 * USEC_PER_SEC));
+}
+
+TEST(dns_cache_serialize) {
+        _cleanup_(dns_cache_unrefp) DnsCache cache = new_cache(), restored = new_cache();
+        _cleanup_(put_args_unrefp) PutArgs put_args = mk_put_args();
+        _cleanup_(dns_answer_unrefp) DnsAnswer *ret_answer = NULL;
+        _cleanup_(dns_resource_key_unrefp) DnsResourceKey *key = NULL;
+        _cleanup_(dns_resource_record_unrefp) DnsResourceRecord *rr = NULL;
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        union in_addr_union other = { .in.s_addr = htobe32(0x05060708) };
+        uint64_t ret_query_flags;
+        DnssecResult ret_dnssec_result;
+        int ret_rcode;
+
+        put_args.key = dns_resource_key_new(DNS_CLASS_IN, DNS_TYPE_A, "www.example.com");
+        ASSERT_NOT_NULL(put_args.key);
+        put_args.query_flags = SD_RESOLVED_CONFIDENTIAL;
+        answer_add_a(&put_args, put_args.key, 0xc0a8017f, 3600, DNS_ANSWER_CACHEABLE);
+        ASSERT_OK(cache_put(&cache, &put_args));
+
+        ASSERT_OK(dns_cache_serialize(&cache, &v));
+        ASSERT_EQ(sd_json_variant_elements(v), 1u);
+
+        /* Entries from other servers are not restored */
+        ASSERT_OK_ZERO(dns_cache_deserialize(&restored, DNS_CACHE_MODE_YES, v, AF_INET, &other, 0));
+        ASSERT_TRUE(dns_cache_is_empty(&restored));
+
+        ASSERT_OK_EQ(dns_cache_deserialize(&restored, DNS_CACHE_MODE_YES, v, put_args.owner_family, &put_args.owner_address, 0), 1);
+        ASSERT_EQ(dns_cache_size(&restored), 1u);
+
+        key = dns_resource_key_new(DNS_CLASS_IN, DNS_TYPE_A, "www.example.com");
+        ASSERT_NOT_NULL(key);
+        ASSERT_OK_POSITIVE(dns_cache_lookup(&restored, key, 0, &ret_rcode, &ret_answer, NULL, &ret_query_flags, &ret_dnssec_result));
+        ASSERT_EQ(ret_rcode, DNS_RCODE_SUCCESS);
+        ASSERT_EQ(ret_query_flags, SD_RESOLVED_CONFIDENTIAL);
+        ASSERT_EQ(ret_dnssec_result, DNSSEC_UNSIGNED);
+
+        rr = dns_resource_record_new_full(DNS_CLASS_IN, DNS_TYPE_A, "www.example.com");
+        ASSERT_NOT_NULL(rr);
+        rr->a.in_addr.s_addr = htobe32(0xc0a8017f);
+        ASSERT_TRUE(dns_answer_contains(ret_answer, rr));
+        ASSERT_LE(dns_answer_min_ttl(ret_answer), 3600u);
+}
+
 TEST(dns_cache_lookup_returns_most_recent_response) {
         _cleanup_(dns_cache_unrefp) DnsCache cache = new_cache();
         _cleanup_(put_args_unrefp) PutArgs args1 = mk_put_args(), args2 = mk_put_args();
@@ -1677,6 +1677,68 @@ TEST(packet_reply_a_multi) {
         dns_resource_record_unref(rr);
 }
 
+TEST(packet_reply_shared_keys) {
+        _cleanup_(dns_packet_unrefp) DnsPacket *packet = NULL;
+        DnsResourceKey *question_key;
+        DnsResourceRecord *rr;
+        unsigned n_shared = 0;
+
+        ASSERT_OK(dns_packet_new(&packet, DNS_PROTOCOL_DNS, 0, DNS_PACKET_SIZE_MAX));
+        ASSERT_NOT_NULL(packet);
+        dns_packet_truncate(packet, 0);
+
+        const uint8_t data[] = {
+                        0x00, 0x42,     BIT_QR | BIT_AA, DNS_RCODE_SUCCESS,
+                        0x00, 0x01,     0x00, 0x03,     0x00, 0x00,     0x00, 0x00,
+
+        /* name */      0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e',
+                        0x03, 'c', 'o', 'm',
+                        0x00,
+        /* A */         0x00, 0x01,
+        /* IN */        0x00, 0x01,
+
+        /* name */      0xc0, 0x0c,
+        /* A */         0x00, 0x01,
+        /* IN */        0x00, 0x01,
+        /* ttl */       0x00, 0x00, 0x0e, 0x10,
+        /* rdata */     0x00, 0x04,
+        /* ip */        0xc0, 0xa8, 0x01, 0x7f,
+
+        /* name */      0xc0, 0x0c,
+        /* A */         0x00, 0x01,
+        /* IN */        0x00, 0x01,
+        /* ttl */       0x00, 0x00, 0x0e, 0x10,
+        /* rdata */     0x00, 0x04,
+        /* ip */        0xa9, 0xfe, 0x01, 0x00,
+
+        /* name */      0xc0, 0x0c,
+        /* TXT */       0x00, 0x10,
+        /* IN */        0x00, 0x01,
+        /* ttl */       0x00, 0x00, 0x0e, 0x10,
+        /* rdata */     0x00, 0x04,
+        /* text */      0x03, 'f', 'o', 'o'
+        };
+
+        ASSERT_OK(dns_packet_append_blob(packet, data, sizeof(data), NULL));
+
+        ASSERT_OK(dns_packet_extract(packet));
+        ASSERT_EQ(dns_question_size(packet->question), 1u);
+        ASSERT_EQ(dns_answer_size(packet->answer), 3u);
+        ASSERT_NULL(packet->last_key);
+
+        /* The A RRs share the key object of the question, the TXT RR needs its own, with the same name */
+        ASSERT_NOT_NULL(question_key = dns_question_first_key(packet->question));
+        DNS_ANSWER_FOREACH(rr, packet->answer) {
+                ASSERT_STREQ(dns_resource_key_name(rr->key), "example.com");
+
+                if (rr->key == question_key)
+                        n_shared++;
+                else
+                        ASSERT_EQ(rr->key->type, DNS_TYPE_TXT);
+        }
+        ASSERT_EQ(n_shared, 2u);
+}
+
 TEST(packet_reply_a_bad_rdata_size) {
         _cleanup_(dns_packet_unrefp) DnsPacket *packet = NULL;
 
@@ -167,6 +167,51 @@ TEST(dns_zone_remove_rr_different_payload) {
         ASSERT_NOT_NULL(dns_zone_get(zone, rr_in));
 }
 
+TEST(dns_zone_get_many_same_key) {
+        Manager manager = {};
+        _cleanup_(dns_scope_freep) DnsScope *scope = NULL;
+        DnsZone *zone = NULL;
+
+        ASSERT_OK(dns_scope_new(&manager, &scope, NULL, DNS_PROTOCOL_DNS, AF_INET));
+        ASSERT_NOT_NULL(scope);
+        zone = &scope->zone;
+
+        /* Lots of PTR records for the same service type, only differing in payload */
+        for (unsigned i = 0; i < 1000; i++) {
+                _cleanup_(dns_resource_record_unrefp) DnsResourceRecord *rr = NULL;
+
+                ASSERT_NOT_NULL(rr = dns_resource_record_new_full(DNS_CLASS_IN, DNS_TYPE_PTR, "_http._tcp.local"));
+                ASSERT_OK(asprintf(&rr->ptr.name, "service%u._http._tcp.local", i));
+
+                ASSERT_OK(dns_zone_put(zone, scope, rr, 0));
+                /* Adding the same record again is a NOP */
+                ASSERT_OK(dns_zone_put(zone, scope, rr, 0));
+        }
+
+        for (unsigned i = 0; i < 1000; i += 2) {
+                _cleanup_(dns_resource_record_unrefp) DnsResourceRecord *rr = NULL;
+
+                ASSERT_NOT_NULL(rr = dns_resource_record_new_full(DNS_CLASS_IN, DNS_TYPE_PTR, "_HTTP._tcp.local"));
+                ASSERT_OK(asprintf(&rr->ptr.name, "service%u._http._tcp.local", i));
+
+                ASSERT_NOT_NULL(dns_zone_get(zone, rr));
+                dns_zone_remove_rr(zone, rr);
+                ASSERT_NULL(dns_zone_get(zone, rr));
+        }
+
+        for (unsigned i = 0; i < 1000; i++) {
+                _cleanup_(dns_resource_record_unrefp) DnsResourceRecord *rr = NULL;
+
+                ASSERT_NOT_NULL(rr = dns_resource_record_new_full(DNS_CLASS_IN, DNS_TYPE_PTR, "_http._tcp.local"));
+                ASSERT_OK(asprintf(&rr->ptr.name, "service%u._http._tcp.local", i));
+
+                ASSERT_EQ(!!dns_zone_get(zone, rr), i % 2 == 1);
+        }
+
+        ASSERT_EQ(hashmap_size(zone->by_rr), 500U);
+        ASSERT_EQ(hashmap_size(zone->by_key), 1U);
+}
+
 /* ================================================================
  * dns_zone_remove_rrs_by_key()
  * ================================================================ */
@@ -478,7 +478,8 @@ TEST(dnssec_verify_rrset) {
         };
 
         _cleanup_(dns_resource_record_unrefp) DnsResourceRecord *a = NULL, *rrsig = NULL, *dnskey = NULL;
-        _cleanup_(dns_answer_unrefp) DnsAnswer *answer = NULL;
+        _cleanup_(dns_answer_unrefp) DnsAnswer *answer = NULL, *keys = NULL;
+        _cleanup_(dnssec_verify_cache_flush) DnssecVerifyCache cache = {};
         DnssecResult result;
 
         a = dns_resource_record_new_full(DNS_CLASS_IN, DNS_TYPE_A, "nAsA.gov");
@@ -529,6 +530,17 @@ TEST(dnssec_verify_rrset) {
         /* Validate the RR as it if was 2015-12-2 today */
         assert_se(dnssec_verify_rrset(answer, a->key, rrsig, dnskey, 1449092754*USEC_PER_SEC, &result) >= 0);
         assert_se(result == DNSSEC_VALIDATED);
+
+        /* Now search for the signature, the second time the result of the first verification is reused */
+        ASSERT_OK(dns_answer_add(answer, rrsig, 0, 0, NULL));
+        ASSERT_NOT_NULL(keys = dns_answer_new(1));
+        ASSERT_OK(dns_answer_add(keys, dnskey, 0, DNS_ANSWER_AUTHENTICATED, NULL));
+
+        for (unsigned i = 0; i < 2; i++) {
+                ASSERT_OK_POSITIVE(dnssec_verify_rrset_search(answer, a->key, keys, 1449092754*USEC_PER_SEC, &cache, &result, NULL));
+                ASSERT_EQ(result, DNSSEC_VALIDATED);
+                ASSERT_EQ(cache.n_hit, (uint64_t) i);
+        }
 }
 
 TEST(dnssec_verify_rrset2) {
@@ -33,11 +33,19 @@ TEST(parse_etc_hosts_system) {
 #define in_addr_6(...)                                           \
         (&(struct in_addr_data) { .family = AF_INET6, .address.in6 = { .s6_addr = __VA_ARGS__ } })
 
-#define has_4(_set, _address_str)                                       \
-        set_contains(_set, in_addr_4(_address_str))
+static bool has_address(const EtcHostsItemByName *bn, const struct in_addr_data *address) {
+        FOREACH_ARRAY(a, bn->addresses, bn->n_addresses)
+                if (in_addr_data_compare_func(a, address) == 0)
+                        return true;
 
-#define has_6(_set, ...)                                           \
-        set_contains(_set, in_addr_6(__VA_ARGS__))
+        return false;
+}
+
+#define has_4(_bn, _address_str)                                       \
+        has_address(_bn, in_addr_4(_address_str))
+
+#define has_6(_bn, ...)                                           \
+        has_address(_bn, in_addr_6(__VA_ARGS__))
 
 TEST(parse_etc_hosts) {
         _cleanup_(unlink_tempfilep) char
@@ -76,29 +84,31 @@ TEST(parse_etc_hosts) {
 
         EtcHostsItemByName *bn;
         assert_se(bn = hashmap_get(hosts.by_name, "some.where"));
-        assert_se(set_size(bn->addresses) == 3);
-        assert_se(has_4(bn->addresses, "1.2.3.4"));
-        assert_se(has_4(bn->addresses, "1.2.3.5"));
-        assert_se(has_6(bn->addresses, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5}));
+        assert_se(bn->n_addresses == 3);
+        /* Addresses are kept in the order of the file */
+        assert_se(in_addr_data_compare_func(&bn->addresses[0], in_addr_4("1.2.3.4")) == 0);
+        assert_se(has_4(bn, "1.2.3.4"));
+        assert_se(has_4(bn, "1.2.3.5"));
+        assert_se(has_6(bn, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5}));
 
         assert_se(bn = hashmap_get(hosts.by_name, "dash"));
-        assert_se(set_size(bn->addresses) == 1);
-        assert_se(has_4(bn->addresses, "1.2.3.6"));
+        assert_se(bn->n_addresses == 1);
+        assert_se(has_4(bn, "1.2.3.6"));
 
         assert_se(bn = hashmap_get(hosts.by_name, "dash-dash.where-dash"));
-        assert_se(set_size(bn->addresses) == 1);
-        assert_se(has_4(bn->addresses, "1.2.3.6"));
+        assert_se(bn->n_addresses == 1);
+        assert_se(has_4(bn, "1.2.3.6"));
 
         /* See https://tools.ietf.org/html/rfc1035#section-2.3.1 */
         FOREACH_STRING(s, "bad-dash-", "-bad-dash", "-bad-dash.bad-")
                 assert_se(!hashmap_get(hosts.by_name, s));
 
         assert_se(bn = hashmap_get(hosts.by_name, "before.comment"));
-        assert_se(set_size(bn->addresses) == 4);
-        assert_se(has_4(bn->addresses, "1.2.3.9"));
-        assert_se(has_4(bn->addresses, "1.2.3.10"));
-        assert_se(has_4(bn->addresses, "1.2.3.11"));
-        assert_se(has_4(bn->addresses, "1.2.3.12"));
+        assert_se(bn->n_addresses == 4);
+        assert_se(has_4(bn, "1.2.3.9"));
+        assert_se(has_4(bn, "1.2.3.10"));
+        assert_se(has_4(bn, "1.2.3.11"));
+        assert_se(has_4(bn, "1.2.3.12"));
 
         assert_se(!hashmap_get(hosts.by_name, "within.comment"));
         assert_se(!hashmap_get(hosts.by_name, "within.comment2"));
@@ -113,8 +123,8 @@ TEST(parse_etc_hosts) {
         assert_se(!set_contains(hosts.no_address, "multi.colon"));
 
         assert_se(bn = hashmap_get(hosts.by_name, "some.other"));
-        assert_se(set_size(bn->addresses) == 1);
-        assert_se(has_6(bn->addresses, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5}));
+        assert_se(bn->n_addresses == 1);
+        assert_se(has_6(bn, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5}));
 
         EtcHostsItemByAddress *ba;
         assert_se(ba = hashmap_get(hosts.by_address, in_addr_4("1.2.3.6")));
@@ -141,6 +141,33 @@ bool bitmap_isclear(const Bitmap *b) {
         return true;
 }
 
+unsigned bitmap_find_unset(const Bitmap *b, unsigned n) {
+        unsigned offset;
+        uint64_t bits;
+
+        /* Returns the smallest number equal to or larger than n which is not set. */
+
+        if (!b)
+                return n;
+
+        offset = BITMAP_NUM_TO_OFFSET(n);
+        if (offset >= b->n_bitmaps)
+                return n;
+
+        /* Consider the bits below n as set */
+        bits = b->bitmaps[offset] | ((UINT64_C(1) << BITMAP_NUM_TO_REM(n)) - 1);
+
+        for (;;) {
+                if (bits != UINT64_MAX)
+                        return BITMAP_OFFSET_TO_NUM(offset, __builtin_ctzll(~bits));
+
+                if (++offset >= b->n_bitmaps)
+                        return BITMAP_OFFSET_TO_NUM(offset, 0);
+
+                bits = b->bitmaps[offset];
+        }
+}
+
 void bitmap_clear(Bitmap *b) {
         if (!b)
                 return;
@@ -20,6 +20,7 @@ int bitmap_set(Bitmap *b, unsigned n);
 void bitmap_unset(Bitmap *b, unsigned n);
 bool bitmap_isset(const Bitmap *b, unsigned n);
 bool bitmap_isclear(const Bitmap *b);
+unsigned bitmap_find_unset(const Bitmap *b, unsigned n);
 void bitmap_clear(Bitmap *b);
 
 bool bitmap_iterate(const Bitmap *b, Iterator *i, unsigned *n);
@@ -938,7 +938,7 @@ static int trim_cmdline(char **cmdline) {
  * the ones we do care about and we are willing to load into memory have this size limit.) */
 #define PE_SECTION_SIZE_MAX (4U*1024U*1024U)
 
-static int pe_find_uki_sections(
+int pe_find_uki_sections(
                 int fd,
                 const char *path,
                 unsigned profile,
@@ -374,6 +374,39 @@ int bpf_program_get_id_by_fd(int prog_fd, uint32_t *ret_id) {
         return 0;
 };
 
+int bpf_program_get_tag_by_fd(int prog_fd, uint32_t *ret_id, uint32_t *ret_type, uint8_t ret_tag[static BPF_TAG_SIZE]) {
+        struct bpf_prog_info info = {};
+        int r;
+
+        assert(ret_tag);
+
+        r = bpf_program_get_info_by_fd(prog_fd, &info, sizeof(info));
+        if (r < 0)
+                return r;
+
+        if (ret_id)
+                *ret_id = info.id;
+        if (ret_type)
+                *ret_type = info.type;
+        memcpy(ret_tag, info.tag, BPF_TAG_SIZE);
+
+        return 0;
+}
+
+int bpf_program_get_fd_by_id(uint32_t prog_id) {
+        union bpf_attr attr;
+        int fd;
+
+        zero(attr);
+        attr.prog_id = prog_id;
+
+        fd = bpf(BPF_PROG_GET_FD_BY_ID, &attr, sizeof(attr));
+        if (fd < 0)
+                return -errno;
+
+        return fd;
+}
+
 int bpf_program_serialize_attachment(
                 FILE *f,
                 FDSet *fds,
@@ -1395,13 +1395,34 @@ typedef struct SpecNextResult {
         int return_value;
 } SpecNextResult;
 
+static bool calendar_spec_timezone_is_local(const CalendarSpec *spec) {
+        _cleanup_free_ char *zone = NULL;
+
+        assert(spec);
+
+        /* Checks whether the timezone of the spec is the one we are running in anyway, in which case there's
+         * no need to switch to it. If $TZ is set we don't bother figuring out what it refers to. */
+
+        if (getenv("TZ"))
+                return false;
+
+        if (get_timezone(&zone) < 0)
+                return false;
+
+        return streq(zone, spec->timezone);
+}
+
 int calendar_spec_next_usec(const CalendarSpec *spec, usec_t usec, usec_t *ret_next) {
         SpecNextResult *shared, tmp;
         int r;
 
         assert(spec);
 
-        if (isempty(spec->timezone))
+        /* Calculating the elapse in a different timezone requires forking off a child, as the timezone is
+         * process global state. Avoid that when the specified timezone is the local one, which is a fairly
+         * common case, and matters when a large number of timers is recalculated at once, e.g. on clock
+         * changes. */
+        if (isempty(spec->timezone) || calendar_spec_timezone_is_local(spec))
                 return calendar_spec_next_usec_impl(spec, usec, ret_next);
 
         shared = mmap(NULL, sizeof *shared, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
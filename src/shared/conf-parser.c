@@ -279,6 +279,40 @@ static int parse_line(
                                userdata);
 }
 
+/* Split off the next line from the buffer in place. This follows the same rules for line endings as
+ * read_line(), i.e. any combination of \n, \r and \0 in which each appears at most once, and nothing is
+ * appended after \0. */
+static int config_next_line(char **p, const char *end, char **ret) {
+        char *s, *e;
+        unsigned seen = 0;
+
+        assert(p);
+        assert(ret);
+
+        s = *p;
+        if (!s || s >= end)
+                return 0;
+
+        /* The buffer is NUL terminated, hence this also stops at embedded NUL bytes and at the end */
+        e = s + strcspn(s, NEWLINE);
+        if ((size_t) (e - s) >= LONG_LINE_MAX)
+                return -ENOBUFS;
+
+        while (e < end) {
+                unsigned m = *e == '\n' ? 1U : *e == '\r' ? 2U : *e == '\0' ? 4U : 0U;
+
+                if (m == 0 || FLAGS_SET(seen, 4U) || (seen & m) != 0)
+                        break;
+
+                seen |= m;
+                *(e++) = '\0';
+        }
+
+        *p = e;
+        *ret = s;
+        return 1;
+}
+
 /* Go through the file and parse each line */
 int config_parse(
                 const char *unit,
@@ -291,11 +325,13 @@ int config_parse(
                 void *userdata,
                 struct stat *ret_stat) {
 
-        _cleanup_free_ char *section = NULL, *continuation = NULL;
+        _cleanup_free_ char *section = NULL, *continuation = NULL, *contents = NULL;
         _cleanup_fclose_ FILE *ours = NULL;
         unsigned line = 0, section_line = 0;
         bool section_ignored = false, bom_seen = false;
+        char *next, *end;
         struct stat st;
+        size_t size;
         int r, fd;
 
         assert(filename);
@@ -332,12 +368,24 @@ int config_parse(
         } else
                 st = (struct stat) {};
 
+        /* Configuration files are small, hence read them in one go and split the lines in place, instead of
+         * allocating a new buffer for each line. */
+        r = read_full_stream(f, &contents, &size);
+        if (r < 0) {
+                if (FLAGS_SET(flags, CONFIG_PARSE_WARN))
+                        log_error_errno(r, "%s: Error while reading configuration file: %m", filename);
+
+                return r;
+        }
+
+        next = contents;
+        end = contents + size;
+
         for (;;) {
-                _cleanup_free_ char *buf = NULL;
                 bool escaped = false;
-                char *l, *p, *e;
+                char *buf, *l, *p, *e;
 
-                r = read_line(f, LONG_LINE_MAX, &buf);
+                r = config_next_line(&next, end, &buf);
                 if (r == 0)
                         break;
                 if (r == -ENOBUFS) {
@@ -346,12 +394,7 @@ int config_parse(
 
                         return r;
                 }
-                if (r < 0) {
-                        if (FLAGS_SET(flags, CONFIG_PARSE_WARN))
-                                log_error_errno(r, "%s:%u: Error while reading configuration file: %m", filename, line);
-
-                        return r;
-                }
+                assert(r > 0);
 
                 line++;
 
@@ -3,6 +3,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <linux/btrfs.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,14 +18,17 @@
 #include "btrfs-util.h"
 #include "chattr-util.h"
 #include "copy.h"
+#include "cpu-set-util.h"
 #include "dirent-util.h"
 #include "fd-util.h"
 #include "fileio.h"
 #include "fs-util.h"
 #include "io-util.h"
+#include "list.h"
 #include "macro.h"
 #include "missing_fs.h"
 #include "missing_syscall.h"
+#include "missing_threads.h"
 #include "mkdir-label.h"
 #include "mountpoint-util.h"
 #include "nulstr-util.h"
@@ -99,6 +104,9 @@ static int fd_is_nonblock_pipe(int fd) {
         return FLAGS_SET(flags, O_NONBLOCK) ? FD_IS_NONBLOCKING_PIPE : FD_IS_BLOCKING_PIPE;
 }
 
+/* Set on the worker threads of a tree copy, which must not log, see copy_worker_thread(). */
+static thread_local bool copy_worker = false;
+
 static int look_for_signals(CopyFlags copy_flags) {
         int r;
 
@@ -109,9 +117,13 @@ static int look_for_signals(CopyFlags copy_flags) {
                                copy_flags & COPY_SIGTERM ? SIGTERM : 0);
         if (r < 0)
                 return r;
-        if (r != 0)
+        if (r != 0) {
+                if (copy_worker)
+                        return -EINTR; /* Logged by copy_tree_context_wait() */
+
                 return log_debug_errno(SYNTHETIC_ERRNO(EINTR),
                                        "Got %s, cancelling copy operation.", signal_to_string(r));
+        }
 
         return 0;
 }
@@ -796,6 +808,397 @@ static int prepare_nocow(int fdf, const char *from, int fdt, unsigned *chattr_ma
         return 0;
 }
 
+/* When copying a directory tree the contents of regular files are copied by up to this many worker threads,
+ * while the calling thread keeps walking the tree. Everything that depends on the order in which we visit
+ * inodes (hardlink detection, labelling, the progress callbacks, denylist handling) stays on the calling
+ * thread, the workers only ever see an already created target file. */
+#define COPY_WORKERS_MAX 8U
+
+/* Maximum number of files waiting for a worker. Each of them pins three file descriptors. */
+#define COPY_QUEUE_MAX 32U
+
+/* Maximum number of source file systems we remember reflinking doesn't work for */
+#define REFLINK_UNSUPPORTED_MAX 8U
+
+typedef struct CopyJob CopyJob;
+
+struct CopyJob {
+        int fdf;
+        int fdt;
+        int dt;
+        char *to;
+        struct stat st;
+        uid_t override_uid;
+        gid_t override_gid;
+        CopyFlags copy_flags;
+
+        LIST_FIELDS(CopyJob, queue);
+};
+
+typedef struct CopyTreeContext {
+        pthread_mutex_t mutex;
+        pthread_cond_t job_cond;    /* Signalled when a job is queued, or when the workers shall exit */
+        pthread_cond_t space_cond;  /* Signalled when a worker took a job off the queue */
+
+        LIST_HEAD(CopyJob, queue);
+        size_t n_queued;
+
+        pthread_t workers[COPY_WORKERS_MAX];
+        size_t n_workers;
+        size_t n_workers_max;
+
+        bool shutdown;
+        bool cancelled;
+        int error;
+        char *error_path;           /* The file the first error happened on, logged by copy_tree_context_wait() */
+
+        dev_t reflink_unsupported[REFLINK_UNSUPPORTED_MAX];
+        size_t n_reflink_unsupported;
+} CopyTreeContext;
+
+#define COPY_TREE_CONTEXT_NULL                                  \
+        {                                                       \
+                .mutex = PTHREAD_MUTEX_INITIALIZER,             \
+                .job_cond = PTHREAD_COND_INITIALIZER,           \
+                .space_cond = PTHREAD_COND_INITIALIZER,         \
+        }
+
+static CopyJob* copy_job_free(CopyJob *j) {
+        if (!j)
+                return NULL;
+
+        safe_close(j->fdf);
+        safe_close(j->fdt);
+        safe_close(j->dt);
+        free(j->to);
+        return mfree(j);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(CopyJob*, copy_job_free);
+
+static void copy_tree_context_setup(CopyTreeContext *c, CopyFlags copy_flags, copy_progress_bytes_t progress_bytes) {
+        int n;
+
+        assert(c);
+
+        /* The byte progress callback is invoked from whichever thread copies the data, and callers don't
+         * expect that, hence copy sequentially if one is set. */
+        if (progress_bytes)
+                return;
+
+        /* Copying is mostly waiting for I/O, hence keep at least two requests in flight even on a single
+         * CPU. */
+        n = cpus_in_affinity_mask();
+        c->n_workers_max = CLAMP(n > 0 ? (size_t) n : 1U, 2U, COPY_WORKERS_MAX);
+}
+
+static bool copy_tree_context_may_reflink(CopyTreeContext *c, dev_t devnum) {
+        bool b = true;
+
+        if (!c)
+                return true;
+
+        assert_se(pthread_mutex_lock(&c->mutex) == 0);
+        FOREACH_ARRAY(d, c->reflink_unsupported, c->n_reflink_unsupported)
+                if (*d == devnum) {
+                        b = false;
+                        break;
+                }
+        assert_se(pthread_mutex_unlock(&c->mutex) == 0);
+
+        return b;
+}
+
+static void copy_tree_context_reflink_unsupported(CopyTreeContext *c, dev_t devnum) {
+        if (!c)
+                return;
+
+        assert_se(pthread_mutex_lock(&c->mutex) == 0);
+        if (c->n_reflink_unsupported < REFLINK_UNSUPPORTED_MAX)
+                c->reflink_unsupported[c->n_reflink_unsupported++] = devnum;
+        assert_se(pthread_mutex_unlock(&c->mutex) == 0);
+}
+
+static int fd_copy_regular_contents(
+                CopyTreeContext *c,
+                int fdf,
+                int fdt_owned,
+                const struct stat *st,
+                int dt,
+                const char *to,
+                uid_t override_uid,
+                gid_t override_gid,
+                CopyFlags copy_flags,
+                copy_progress_bytes_t progress,
+                void *userdata) {
+
+        _cleanup_close_ int fdt = fdt_owned;
+        bool reflinked = false;
+        int r, q;
+
+        assert(fdf >= 0);
+        assert(fdt >= 0);
+        assert(st);
+        assert(to);
+
+        /* Copies the contents and metadata of a regular file into a freshly created target file, whose fd
+         * we take possession of. This might run on a worker thread. */
+
+        r = prepare_nocow(fdf, /*from=*/ NULL, fdt, /*chattr_mask=*/ NULL, /*chattr_flags=*/ NULL);
+        if (r < 0)
+                return r;
+
+        if (FLAGS_SET(copy_flags, COPY_REFLINK)) {
+                /* Try to reflink the whole file right away, but only once per source file system if that's
+                 * not supported, so that we don't issue a futile ioctl for each file of a large tree. Either
+                 * way there's no point in copy_bytes_full() trying again. */
+                if (copy_tree_context_may_reflink(c, st->st_dev)) {
+                        r = reflink(fdf, fdt);
+                        if (r >= 0)
+                                reflinked = true;
+                        else if (ERRNO_IS_NEG_NOT_SUPPORTED(r) || r == -EXDEV)
+                                copy_tree_context_reflink_unsupported(c, st->st_dev);
+                }
+
+                copy_flags &= ~COPY_REFLINK;
+        }
+
+        if (!reflinked) {
+                r = copy_bytes_full(fdf, fdt, UINT64_MAX, copy_flags, NULL, NULL, progress, userdata);
+                if (r < 0)
+                        goto fail;
+        }
+
+        if (fchown(fdt,
+                   uid_is_valid(override_uid) ? override_uid : st->st_uid,
+                   gid_is_valid(override_gid) ? override_gid : st->st_gid) < 0)
+                r = -errno;
+
+        if (fchmod(fdt, st->st_mode & 07777) < 0)
+                r = -errno;
+
+        (void) futimens(fdt, (struct timespec[]) { st->st_atim, st->st_mtim });
+        (void) copy_xattr(fdf, NULL, fdt, NULL, copy_flags);
+
+        if (FLAGS_SET(copy_flags, COPY_VERIFY_LINKED)) {
+                r = fd_verify_linked(fdf);
+                if (r < 0)
+                        return r;
+        }
+
+        if (copy_flags & COPY_FSYNC) {
+                if (fsync(fdt) < 0) {
+                        r = -errno;
+                        goto fail;
+                }
+        }
+
+        q = close_nointr(TAKE_FD(fdt)); /* even if this fails, the fd is now invalidated */
+        if (q < 0) {
+                r = q;
+                goto fail;
+        }
+
+        return r;
+
+fail:
+        (void) unlinkat(dt, to, 0);
+        return r;
+}
+
+static void* copy_worker_thread(void *p) {
+        CopyTreeContext *c = ASSERT_PTR(p);
+
+        /* The workers never log: the log target is not ours to reconfigure or write to from other threads
+         * behind the caller's back. Errors are collected in the context instead, and logged by the calling
+         * thread. */
+        copy_worker = true;
+
+        (void) pthread_setname_np(pthread_self(), "copy-worker");
+
+        assert_se(pthread_mutex_lock(&c->mutex) == 0);
+
+        for (;;) {
+                _cleanup_(copy_job_freep) CopyJob *j = NULL;
+                int r;
+
+                while (!c->queue && !c->shutdown)
+                        assert_se(pthread_cond_wait(&c->job_cond, &c->mutex) == 0);
+
+                /* When asked to shut down we still finish what's queued, unless the copy was cancelled */
+                j = LIST_POP(queue, c->queue);
+                if (!j)
+                        break;
+
+                c->n_queued--;
+                assert_se(pthread_cond_signal(&c->space_cond) == 0);
+
+                if (c->cancelled)
+                        continue;
+
+                assert_se(pthread_mutex_unlock(&c->mutex) == 0);
+
+                r = fd_copy_regular_contents(c, j->fdf, TAKE_FD(j->fdt), &j->st, j->dt, j->to,
+                                             j->override_uid, j->override_gid, j->copy_flags,
+                                             /* progress= */ NULL, /* userdata= */ NULL);
+
+                assert_se(pthread_mutex_lock(&c->mutex) == 0);
+
+                if (r < 0 && c->error >= 0) {
+                        c->error = r;
+                        c->error_path = TAKE_PTR(j->to);
+                }
+                if (r == -EINTR)
+                        c->cancelled = true;
+        }
+
+        assert_se(pthread_mutex_unlock(&c->mutex) == 0);
+        return NULL;
+}
+
+static int copy_tree_context_spawn_worker_unlocked(CopyTreeContext *c) {
+        sigset_t ss, saved_ss;
+        int r, k;
+
+        assert(c);
+        assert(c->n_workers < c->n_workers_max);
+
+        /* Block all signals in the workers, so that they are delivered to the calling thread, which might
+         * want to handle them. If COPY_SIGINT/COPY_SIGTERM is set the workers dequeue them explicitly. */
+        assert_se(sigfillset(&ss) >= 0);
+
+        r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+        if (r > 0)
+                return -r;
+
+        r = pthread_create(c->workers + c->n_workers, NULL, copy_worker_thread, c);
+
+        k = pthread_sigmask(SIG_SETMASK, &saved_ss, NULL);
+        if (r > 0)
+                return -r;
+
+        c->n_workers++;
+
+        if (k > 0)
+                return -k;
+
+        return 0;
+}
+
+static int copy_tree_context_queue(
+                CopyTreeContext *c,
+                int *fdf,
+                int *fdt,
+                const struct stat *st,
+                int dt,
+                const char *to,
+                uid_t override_uid,
+                gid_t override_gid,
+                CopyFlags copy_flags) {
+
+        _cleanup_(copy_job_freep) CopyJob *j = NULL;
+        int r;
+
+        assert(fdf);
+        assert(fdt);
+        assert(st);
+        assert(to);
+
+        /* Hands the copy of the file contents off to a worker thread. Returns > 0 if that worked and we
+         * took possession of the fds, 0 if the caller shall copy the file itself, and -EINTR if the
+         * operation was cancelled by a worker. */
+
+        if (!c || c->n_workers_max == 0)
+                return 0;
+
+        j = new(CopyJob, 1);
+        if (!j)
+                return 0;
+
+        *j = (CopyJob) {
+                .fdf = -EBADF,
+                .fdt = -EBADF,
+                .dt = fcntl(dt, F_DUPFD_CLOEXEC, 3), /* So that we can remove the file again on failure */
+                .to = strdup(to),
+                .st = *st,
+                .override_uid = override_uid,
+                .override_gid = override_gid,
+                .copy_flags = copy_flags,
+        };
+        if (j->dt < 0 || !j->to)
+                return 0;
+
+        assert_se(pthread_mutex_lock(&c->mutex) == 0);
+
+        if (c->n_workers < c->n_workers_max) {
+                r = copy_tree_context_spawn_worker_unlocked(c);
+                if (r < 0) {
+                        log_debug_errno(r, "Failed to start copy worker thread, continuing with %zu: %m", c->n_workers);
+                        c->n_workers_max = c->n_workers;
+                }
+        }
+
+        while (c->n_workers > 0 && c->n_queued >= COPY_QUEUE_MAX && !c->cancelled)
+                assert_se(pthread_cond_wait(&c->space_cond, &c->mutex) == 0);
+
+        if (c->cancelled)
+                r = -EINTR;
+        else if (c->n_workers == 0)
+                r = 0;
+        else {
+                j->fdf = TAKE_FD(*fdf);
+                j->fdt = TAKE_FD(*fdt);
+                LIST_APPEND(queue, c->queue, TAKE_PTR(j));
+                c->n_queued++;
+                assert_se(pthread_cond_signal(&c->job_cond) == 0);
+                r = 1;
+        }
+
+        assert_se(pthread_mutex_unlock(&c->mutex) == 0);
+        return r;
+}
+
+static int copy_tree_context_wait(CopyTreeContext *c) {
+        assert(c);
+
+        /* Waits until all queued files are copied and the workers exited, and returns the first error any of
+         * them encountered. */
+
+        assert_se(pthread_mutex_lock(&c->mutex) == 0);
+        c->shutdown = true;
+        assert_se(pthread_cond_broadcast(&c->job_cond) == 0);
+        assert_se(pthread_mutex_unlock(&c->mutex) == 0);
+
+        FOREACH_ARRAY(t, c->workers, c->n_workers)
+                assert_se(pthread_join(*t, NULL) == 0);
+        c->n_workers = c->n_workers_max = 0;
+
+        assert(!c->queue);
+
+        /* Only log once, we might be called again from copy_tree_context_done() */
+        if (c->error_path) {
+                if (c->error == -EINTR)
+                        log_debug_errno(c->error, "Got signal while copying '%s', cancelling copy operation.", c->error_path);
+                else
+                        log_debug_errno(c->error, "Failed to copy '%s': %m", c->error_path);
+
+                c->error_path = mfree(c->error_path);
+        }
+
+        return c->error;
+}
+
+static void copy_tree_context_done(CopyTreeContext *c) {
+        assert(c);
+
+        /* Drop whatever is still queued, we only get here without waiting first if the copy failed. */
+        assert_se(pthread_mutex_lock(&c->mutex) == 0);
+        c->cancelled = true;
+        assert_se(pthread_mutex_unlock(&c->mutex) == 0);
+
+        (void) copy_tree_context_wait(c);
+}
+
 static int fd_copy_tree_generic(
                 int df,
                 const char *from,
@@ -810,6 +1213,7 @@ static int fd_copy_tree_generic(
                 Hashmap *denylist,
                 Set *subvolumes,
                 HardlinkContext *hardlink_context,
+                CopyTreeContext *tree_context,
                 const char *display_path,
                 copy_progress_path_t progress_path,
                 copy_progress_bytes_t progress_bytes,
@@ -825,11 +1229,12 @@ static int fd_copy_regular(
                 gid_t override_gid,
                 CopyFlags copy_flags,
                 HardlinkContext *hardlink_context,
+                CopyTreeContext *tree_context,
                 copy_progress_bytes_t progress,
                 void *userdata) {
 
         _cleanup_close_ int fdf = -EBADF, fdt = -EBADF;
-        int r, q;
+        int r;
 
         assert(st);
         assert(to);
@@ -855,50 +1260,21 @@ static int fd_copy_regular(
         if (fdt < 0)
                 return -errno;
 
-        r = prepare_nocow(fdf, /*from=*/ NULL, fdt, /*chattr_mask=*/ NULL, /*chattr_flags=*/ NULL);
-        if (r < 0)
+        r = copy_tree_context_queue(tree_context, &fdf, &fdt, st, dt, to, override_uid, override_gid, copy_flags);
+        if (r < 0) {
+                (void) unlinkat(dt, to, 0);
                 return r;
-
-        r = copy_bytes_full(fdf, fdt, UINT64_MAX, copy_flags, NULL, NULL, progress, userdata);
-        if (r < 0)
-                goto fail;
-
-        if (fchown(fdt,
-                   uid_is_valid(override_uid) ? override_uid : st->st_uid,
-                   gid_is_valid(override_gid) ? override_gid : st->st_gid) < 0)
-                r = -errno;
-
-        if (fchmod(fdt, st->st_mode & 07777) < 0)
-                r = -errno;
-
-        (void) futimens(fdt, (struct timespec[]) { st->st_atim, st->st_mtim });
-        (void) copy_xattr(fdf, NULL, fdt, NULL, copy_flags);
-
-        if (FLAGS_SET(copy_flags, COPY_VERIFY_LINKED)) {
-                r = fd_verify_linked(fdf);
-                if (r < 0)
-                        return r;
-        }
-
-        if (copy_flags & COPY_FSYNC) {
-                if (fsync(fdt) < 0) {
-                        r = -errno;
-                        goto fail;
-                }
-        }
-
-        q = close_nointr(TAKE_FD(fdt)); /* even if this fails, the fd is now invalidated */
-        if (q < 0) {
-                r = q;
-                goto fail;
         }
+        if (r == 0)
+                r = fd_copy_regular_contents(tree_context, fdf, TAKE_FD(fdt), st, dt, to, override_uid,
+                                             override_gid, copy_flags, progress, userdata);
+        if (r < 0)
+                return r;
 
+        /* The target inode exists at this point even if a worker is still filling it, hence further links
+         * to it may be created right away. */
         (void) memorize_hardlink(hardlink_context, st, dt, to);
-        return r;
-
-fail:
-        (void) unlinkat(dt, to, 0);
-        return r;
+        return 0;
 }
 
 static int fd_copy_fifo(
@@ -1021,6 +1397,7 @@ static int fd_copy_directory(
                 Hashmap *denylist,
                 Set *subvolumes,
                 HardlinkContext *hardlink_context,
+                CopyTreeContext *tree_context,
                 const char *display_path,
                 copy_progress_path_t progress_path,
                 copy_progress_bytes_t progress_bytes,
@@ -1157,8 +1534,8 @@ static int fd_copy_directory(
 
                 q = fd_copy_tree_generic(dirfd(d), de->d_name, &buf, fdt, de->d_name, original_device,
                                          depth_left-1, override_uid, override_gid, copy_flags & ~COPY_LOCK_BSD,
-                                         denylist, subvolumes, hardlink_context, child_display_path, progress_path,
-                                         progress_bytes, userdata);
+                                         denylist, subvolumes, hardlink_context, tree_context, child_display_path,
+                                         progress_path, progress_bytes, userdata);
 
                 if (q == -EINTR) /* Propagate SIGINT/SIGTERM up instantly */
                         return q;
@@ -1210,13 +1587,14 @@ static int fd_copy_leaf(
                 gid_t override_gid,
                 CopyFlags copy_flags,
                 HardlinkContext *hardlink_context,
+                CopyTreeContext *tree_context,
                 const char *display_path,
                 copy_progress_bytes_t progress_bytes,
                 void *userdata) {
         int r;
 
         if (S_ISREG(st->st_mode))
-                r = fd_copy_regular(df, from, st, dt, to, override_uid, override_gid, copy_flags, hardlink_context, progress_bytes, userdata);
+                r = fd_copy_regular(df, from, st, dt, to, override_uid, override_gid, copy_flags, hardlink_context, tree_context, progress_bytes, userdata);
         else if (S_ISLNK(st->st_mode))
                 r = fd_copy_symlink(df, from, st, dt, to, override_uid, override_gid, copy_flags);
         else if (S_ISFIFO(st->st_mode))
@@ -1243,6 +1621,7 @@ static int fd_copy_tree_generic(
                 Hashmap *denylist,
                 Set *subvolumes,
                 HardlinkContext *hardlink_context,
+                CopyTreeContext *tree_context,
                 const char *display_path,
                 copy_progress_path_t progress_path,
                 copy_progress_bytes_t progress_bytes,
@@ -1255,7 +1634,7 @@ static int fd_copy_tree_generic(
         if (S_ISDIR(st->st_mode))
                 return fd_copy_directory(df, from, st, dt, to, original_device, depth_left-1, override_uid,
                                          override_gid, copy_flags, denylist, subvolumes, hardlink_context,
-                                         display_path, progress_path, progress_bytes, userdata);
+                                         tree_context, display_path, progress_path, progress_bytes, userdata);
 
         DenyType t = PTR_TO_INT(hashmap_get(denylist, st));
         if (t == DENY_INODE) {
@@ -1264,14 +1643,14 @@ static int fd_copy_tree_generic(
         } else if (t == DENY_CONTENTS)
                 log_debug("%s is configured to have its contents excluded, but is not a directory", from ?: "file to copy");
 
-        r = fd_copy_leaf(df, from, st, dt, to, override_uid, override_gid, copy_flags, hardlink_context, display_path, progress_bytes, userdata);
+        r = fd_copy_leaf(df, from, st, dt, to, override_uid, override_gid, copy_flags, hardlink_context, tree_context, display_path, progress_bytes, userdata);
         /* We just tried to copy a leaf node of the tree. If it failed because the node already exists *and* the COPY_REPLACE flag has been provided, we should unlink the node and re-copy. */
         if (r == -EEXIST && (copy_flags & COPY_REPLACE)) {
                 /* This codepath is us trying to address an error to copy, if the unlink fails, lets just return the original error. */
                 if (unlinkat(dt, to, 0) < 0)
                         return r;
 
-                r = fd_copy_leaf(df, from, st, dt, to, override_uid, override_gid, copy_flags, hardlink_context, display_path, progress_bytes, userdata);
+                r = fd_copy_leaf(df, from, st, dt, to, override_uid, override_gid, copy_flags, hardlink_context, tree_context, display_path, progress_bytes, userdata);
         }
 
         return r;
@@ -1291,6 +1670,7 @@ int copy_tree_at_full(
                 copy_progress_bytes_t progress_bytes,
                 void *userdata) {
 
+        _cleanup_(copy_tree_context_done) CopyTreeContext tree_context = COPY_TREE_CONTEXT_NULL;
         struct stat st;
         int r;
 
@@ -1300,9 +1680,17 @@ int copy_tree_at_full(
         if (fstatat(fdf, strempty(from), &st, AT_SYMLINK_NOFOLLOW | (isempty(from) ? AT_EMPTY_PATH : 0)) < 0)
                 return -errno;
 
+        if (S_ISDIR(st.st_mode))
+                copy_tree_context_setup(&tree_context, copy_flags, progress_bytes);
+
         r = fd_copy_tree_generic(fdf, from, &st, fdt, to, st.st_dev, COPY_DEPTH_MAX, override_uid,
-                                 override_gid, copy_flags, denylist, subvolumes, NULL, NULL, progress_path,
-                                 progress_bytes, userdata);
+                                 override_gid, copy_flags, denylist, subvolumes, NULL, &tree_context, NULL,
+                                 progress_path, progress_bytes, userdata);
+        if (r == -EINTR)
+                return r;
+
+        /* Everything must have hit the disk before we sync below */
+        RET_GATHER(r, copy_tree_context_wait(&tree_context));
         if (r < 0)
                 return r;
 
@@ -1347,6 +1735,7 @@ int copy_directory_at_full(
                 copy_progress_bytes_t progress_bytes,
                 void *userdata) {
 
+        _cleanup_(copy_tree_context_done) CopyTreeContext tree_context = COPY_TREE_CONTEXT_NULL;
         _cleanup_close_ int fdt = -EBADF;
         struct stat st;
         int r;
@@ -1362,6 +1751,8 @@ int copy_directory_at_full(
         if (r < 0)
                 return r;
 
+        copy_tree_context_setup(&tree_context, copy_flags, progress_bytes);
+
         r = fd_copy_directory(
                         dir_fdf, from,
                         &st,
@@ -1370,16 +1761,22 @@ int copy_directory_at_full(
                         COPY_DEPTH_MAX,
                         UID_INVALID, GID_INVALID,
                         copy_flags,
-                        NULL, NULL, NULL, NULL,
+                        NULL, NULL, NULL,
+                        &tree_context,
+                        NULL,
                         progress_path,
                         progress_bytes,
                         userdata);
-        if (r < 0)
+        if (r == -EINTR)
                 return r;
 
-        if (FLAGS_SET(copy_flags, COPY_LOCK_BSD))
+        if (FLAGS_SET(copy_flags, COPY_LOCK_BSD) && r >= 0)
                 fdt = r;
 
+        RET_GATHER(r, copy_tree_context_wait(&tree_context));
+        if (r < 0)
+                return r;
+
         r = sync_dir_by_flags(dir_fdt, to, copy_flags);
         if (r < 0)
                 return r;
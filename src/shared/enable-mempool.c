@@ -1,19 +1,23 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <pthread.h>
 #include <stdbool.h>
 
 #include "env-util.h"
+#include "macro.h"
 #include "mempool.h"
-#include "process-util.h"
 
-bool mempool_enabled(void) {
-        static int cache = -1;
+static bool enabled = false;
+
+static void mempool_enabled_init(void) {
+        enabled = getenv_bool("SYSTEMD_MEMPOOL") != 0;
+}
 
-        if (!is_main_thread())
-                return false;
+bool mempool_enabled(void) {
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
 
-        if (cache < 0)
-                cache = getenv_bool("SYSTEMD_MEMPOOL") != 0;
+        /* The pools keep per-thread caches and may be used from any thread. */
 
-        return cache;
+        assert_se(pthread_once(&once, mempool_enabled_init) == 0);
+        return enabled;
 }
@@ -3,6 +3,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <sys/prctl.h>
+#include <sys/wait.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -15,11 +16,13 @@
 #include "errno-util.h"
 #include "escape.h"
 #include "exec-util.h"
+#include "extract-word.h"
 #include "fd-util.h"
 #include "fileio.h"
 #include "hashmap.h"
 #include "macro.h"
 #include "missing_syscall.h"
+#include "parse-util.h"
 #include "path-util.h"
 #include "process-util.h"
 #include "serialize.h"
@@ -88,6 +91,53 @@ static int do_spawn(
         return 1;
 }
 
+typedef struct ExecChild {
+        usec_t start;
+        char path[];
+} ExecChild;
+
+static void exec_child_record_timing(const char *path, usec_t start, int timing_fd) {
+        usec_t d;
+
+        assert(path);
+
+        d = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+
+        log_debug("%s finished after %s.", path, FORMAT_TIMESPAN(d, USEC_PER_MSEC));
+
+        if (timing_fd >= 0 && dprintf(timing_fd, USEC_FMT " %s\n", d, path) < 0)
+                log_debug_errno(errno, "Failed to record execution time of %s, ignoring: %m", path);
+}
+
+static int wait_for_any_child(Hashmap *pids, int timing_fd, ExecDirFlags flags) {
+        _cleanup_free_ ExecChild *c = NULL;
+        siginfo_t si = {};
+        int r;
+
+        assert(!hashmap_isempty(pids));
+
+        /* Find out which child finished first, but leave reaping it to wait_for_terminate_and_check() */
+        if (waitid(P_ALL, 0, &si, WEXITED|WNOWAIT) < 0)
+                return log_error_errno(errno, "Failed to wait for child processes: %m");
+
+        c = hashmap_remove(pids, PID_TO_PTR(si.si_pid));
+        if (!c) {
+                /* Not one of ours, just reap it */
+                (void) wait_for_terminate(si.si_pid, NULL);
+                return 0;
+        }
+
+        exec_child_record_timing(c->path, c->start, timing_fd);
+
+        r = wait_for_terminate_and_check(c->path, si.si_pid, WAIT_LOG);
+        if (r < 0)
+                return r;
+        if (!FLAGS_SET(flags, EXEC_DIR_IGNORE_ERRORS) && r > 0)
+                return r;
+
+        return 0;
+}
+
 static int do_execute(
                 char * const *paths,
                 const char *root,
@@ -97,7 +147,9 @@ static int do_execute(
                 int output_fd,
                 char *argv[],
                 char *envp[],
-                ExecDirFlags flags) {
+                ExecDirFlags flags,
+                unsigned max_parallel,
+                int timing_fd) {
 
         _cleanup_hashmap_free_ Hashmap *pids = NULL;
         bool parallel_execution;
@@ -107,7 +159,9 @@ static int do_execute(
          * to set a time limit.
          *
          * We attempt to perform parallel execution if configured by the user, however if `callbacks` is nonnull,
-         * execution must be serial.
+         * execution must be serial. If max_parallel is non-zero, at most that many processes are run at the
+         * same time. If timing_fd is valid, a line with the execution time (in µs) and path is written to it
+         * for each executed binary.
          */
 
         assert(!strv_isempty(paths));
@@ -127,6 +181,7 @@ static int do_execute(
         STRV_FOREACH(path, paths) {
                 _cleanup_free_ char *t = NULL;
                 _cleanup_close_ int fd = -EBADF;
+                usec_t start;
                 pid_t pid;
 
                 t = path_join(root, *path);
@@ -165,21 +220,43 @@ static int do_execute(
                                             "permission bits. Proceeding anyway.", t);
                 }
 
+                if (parallel_execution && max_parallel > 0)
+                        while (hashmap_size(pids) >= max_parallel) {
+                                r = wait_for_any_child(pids, timing_fd, flags);
+                                if (r != 0)
+                                        return r;
+                        }
+
+                start = now(CLOCK_MONOTONIC);
+
                 r = do_spawn(t, argv, fd, FLAGS_SET(flags, EXEC_DIR_SET_SYSTEMD_EXEC_PID), &pid);
                 if (r <= 0)
                         continue;
 
                 if (parallel_execution) {
-                        r = hashmap_ensure_put(&pids, &trivial_hash_ops_value_free, PID_TO_PTR(pid), t);
+                        _cleanup_free_ ExecChild *c = NULL;
+                        size_t l = strlen(t);
+
+                        c = malloc(offsetof(ExecChild, path) + l + 1);
+                        if (!c)
+                                return log_oom();
+
+                        c->start = start;
+                        memcpy(c->path, t, l + 1);
+
+                        r = hashmap_ensure_put(&pids, &trivial_hash_ops_value_free, PID_TO_PTR(pid), c);
                         if (r < 0)
                                 return log_oom();
-                        t = NULL;
+                        TAKE_PTR(c);
                 } else {
                         bool skip_remaining = false;
 
                         r = wait_for_terminate_and_check(t, pid, WAIT_LOG_ABNORMAL);
                         if (r < 0)
                                 return r;
+
+                        exec_child_record_timing(t, start, timing_fd);
+
                         if (r > 0) {
                                 if (FLAGS_SET(flags, EXEC_DIR_SKIP_REMAINING) && r == EXIT_SKIP_REMAINING) {
                                         log_info("%s succeeded with exit status %i, not executing remaining executables.", *path, r);
@@ -213,26 +290,17 @@ static int do_execute(
                         return log_error_errno(r, "Callback two failed: %m");
         }
 
+        /* Reap in order of completion, so that the recorded execution times are accurate */
         while (!hashmap_isempty(pids)) {
-                _cleanup_free_ char *t = NULL;
-                pid_t pid;
-                void *p;
-
-                t = ASSERT_PTR(hashmap_steal_first_key_and_value(pids, &p));
-                pid = PTR_TO_PID(p);
-                assert(pid > 0);
-
-                r = wait_for_terminate_and_check(t, pid, WAIT_LOG);
-                if (r < 0)
-                        return r;
-                if (!FLAGS_SET(flags, EXEC_DIR_IGNORE_ERRORS) && r > 0)
+                r = wait_for_any_child(pids, timing_fd, flags);
+                if (r != 0)
                         return r;
         }
 
         return 0;
 }
 
-int execute_strv(
+int execute_strv_full(
                 const char *name,
                 char * const *paths,
                 const char *root,
@@ -241,7 +309,9 @@ int execute_strv(
                 void * const callback_args[_STDOUT_CONSUME_MAX],
                 char *argv[],
                 char *envp[],
-                ExecDirFlags flags) {
+                ExecDirFlags flags,
+                unsigned max_parallel,
+                int timing_fd) {
 
         _cleanup_close_ int fd = -EBADF;
         pid_t executor_pid;
@@ -272,7 +342,7 @@ int execute_strv(
         if (r < 0)
                 return r;
         if (r == 0) {
-                r = do_execute(paths, root, timeout, callbacks, callback_args, fd, argv, envp, flags);
+                r = do_execute(paths, root, timeout, callbacks, callback_args, fd, argv, envp, flags, max_parallel, timing_fd);
                 _exit(r < 0 ? EXIT_FAILURE : r);
         }
 
@@ -296,14 +366,16 @@ int execute_strv(
         return 0;
 }
 
-int execute_directories(
+int execute_directories_full(
                 const char * const *directories,
                 usec_t timeout,
                 gather_stdout_callback_t const callbacks[_STDOUT_CONSUME_MAX],
                 void * const callback_args[_STDOUT_CONSUME_MAX],
                 char *argv[],
                 char *envp[],
-                ExecDirFlags flags) {
+                ExecDirFlags flags,
+                unsigned max_parallel,
+                int timing_fd) {
 
         _cleanup_strv_free_ char **paths = NULL;
         _cleanup_free_ char *name = NULL;
@@ -326,7 +398,70 @@ int execute_directories(
                         return log_error_errno(r, "Failed to extract file name from '%s': %m", directories[0]);
         }
 
-        return execute_strv(name, paths, /* root = */ NULL, timeout, callbacks, callback_args, argv, envp, flags);
+        return execute_strv_full(name, paths, /* root = */ NULL, timeout, callbacks, callback_args, argv, envp, flags, max_parallel, timing_fd);
+}
+
+void exec_timing_free_many(ExecTiming *t, size_t n) {
+        FOREACH_ARRAY(i, t, n)
+                free(i->path);
+
+        free(t);
+}
+
+int exec_timing_read(int fd, ExecTiming **ret, size_t *ret_n) {
+        _cleanup_fclose_ FILE *f = NULL;
+        ExecTiming *t = NULL;
+        size_t n = 0;
+        int r;
+
+        CLEANUP_ARRAY(t, n, exec_timing_free_many);
+
+        /* Reads back the execution times written by execute_strv_full() to timing_fd. The fd is always
+         * consumed, even on error. */
+
+        assert(fd >= 0);
+        assert(ret);
+        assert(ret_n);
+
+        f = take_fdopen(&fd, "r");
+        if (!f) {
+                safe_close(fd);
+                return -errno;
+        }
+
+        for (;;) {
+                _cleanup_free_ char *line = NULL, *word = NULL;
+                const char *p;
+                usec_t u;
+
+                r = read_line(f, LONG_LINE_MAX, &line);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        break;
+
+                p = line;
+                r = extract_first_word(&p, &word, " ", 0);
+                if (r < 0)
+                        return r;
+                if (r == 0 || isempty(p) || safe_atou64(word, &u) < 0) {
+                        log_debug("Failed to parse execution time line '%s', ignoring.", line);
+                        continue;
+                }
+
+                if (!GREEDY_REALLOC(t, n + 1))
+                        return -ENOMEM;
+
+                t[n].path = strdup(p);
+                if (!t[n].path)
+                        return -ENOMEM;
+
+                t[n++].duration = u;
+        }
+
+        *ret = TAKE_PTR(t);
+        *ret_n = TAKE_GENERIC(n, size_t, 0);
+        return 0;
 }
 
 static int gather_environment_generate(int fd, void *arg) {
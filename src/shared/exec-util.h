@@ -22,7 +22,7 @@ typedef enum ExecDirFlags {
         EXEC_DIR_WARN_WORLD_WRITABLE  = 1 << 4, /* Warn if world writable files are found */
 } ExecDirFlags;
 
-int execute_strv(
+int execute_strv_full(
                 const char *name,
                 char * const *paths,
                 const char *root,
@@ -31,16 +31,50 @@ int execute_strv(
                 void * const callback_args[_STDOUT_CONSUME_MAX],
                 char *argv[],
                 char *envp[],
-                ExecDirFlags flags);
+                ExecDirFlags flags,
+                unsigned max_parallel,
+                int timing_fd);
+static inline int execute_strv(
+                const char *name,
+                char * const *paths,
+                const char *root,
+                usec_t timeout,
+                gather_stdout_callback_t const callbacks[_STDOUT_CONSUME_MAX],
+                void * const callback_args[_STDOUT_CONSUME_MAX],
+                char *argv[],
+                char *envp[],
+                ExecDirFlags flags) {
+        return execute_strv_full(name, paths, root, timeout, callbacks, callback_args, argv, envp, flags, 0, -EBADF);
+}
 
-int execute_directories(
+int execute_directories_full(
                 const char * const *directories,
                 usec_t timeout,
                 gather_stdout_callback_t const callbacks[_STDOUT_CONSUME_MAX],
                 void * const callback_args[_STDOUT_CONSUME_MAX],
                 char *argv[],
                 char *envp[],
-                ExecDirFlags flags);
+                ExecDirFlags flags,
+                unsigned max_parallel,
+                int timing_fd);
+static inline int execute_directories(
+                const char * const *directories,
+                usec_t timeout,
+                gather_stdout_callback_t const callbacks[_STDOUT_CONSUME_MAX],
+                void * const callback_args[_STDOUT_CONSUME_MAX],
+                char *argv[],
+                char *envp[],
+                ExecDirFlags flags) {
+        return execute_directories_full(directories, timeout, callbacks, callback_args, argv, envp, flags, 0, -EBADF);
+}
+
+typedef struct ExecTiming {
+        char *path;
+        usec_t duration;
+} ExecTiming;
+
+void exec_timing_free_many(ExecTiming *t, size_t n);
+int exec_timing_read(int fd, ExecTiming **ret, size_t *ret_n);
 
 extern const gather_stdout_callback_t gather_environment[_STDOUT_CONSUME_MAX];
 
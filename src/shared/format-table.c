@@ -25,6 +25,7 @@
 #include "path-util.h"
 #include "pretty-print.h"
 #include "process-util.h"
+#include "set.h"
 #include "signal-util.h"
 #include "sort-util.h"
 #include "stat-util.h"
@@ -37,6 +38,12 @@
 
 #define DEFAULT_WEIGHT 100
 
+/* Short strings are interned, so that cells with the same text share one data object even if they are not in
+ * adjacent rows (think "active", "loaded", …). The pool is bounded, so that tables with mostly unique strings
+ * don't end up with a useless second copy of everything. */
+#define INTERN_STRING_MAX 64U
+#define INTERN_ENTRIES_MAX 256U
+
 /*
    A few notes on implementation details:
 
@@ -159,6 +166,15 @@ struct Table {
         size_t n_json_fields;
 
         bool *reverse_map;
+
+        Set *interned;          /* Pool of shared data objects for short strings */
+
+        FILE *stream;           /* If set, rows are written out while they are added */
+        size_t stream_rows;     /* The number of rows to collect before column widths are fixed */
+        size_t *stream_width;   /* The fixed column widths, once rows have been written out */
+        size_t n_stream_width;
+        size_t stream_next_row; /* The first row in data[] that has not been written out yet */
+        size_t n_dropped_rows;  /* The number of rows written out and released from data[] */
 };
 
 Table *table_new_raw(size_t n_columns) {
@@ -276,6 +292,9 @@ Table *table_unref(Table *t) {
 
         free(t->json_fields);
 
+        set_free(t->interned);
+        free(t->stream_width);
+
         return mfree(t);
 }
 
@@ -455,6 +474,126 @@ static TableData *table_data_new(
         return TAKE_PTR(d);
 }
 
+static bool table_data_type_internable(TableDataType type) {
+        return IN_SET(type, TABLE_STRING, TABLE_PATH, TABLE_PATH_BASENAME, TABLE_FIELD, TABLE_HEADER);
+}
+
+static void table_data_intern_hash_func(const TableData *d, struct siphash *state) {
+        assert(d);
+
+        siphash24_compress_typesafe(d->type, state);
+        siphash24_compress_typesafe(d->minimum_width, state);
+        siphash24_compress_typesafe(d->maximum_width, state);
+        siphash24_compress_typesafe(d->weight, state);
+        siphash24_compress_typesafe(d->align_percent, state);
+        siphash24_compress_typesafe(d->ellipsize_percent, state);
+        siphash24_compress_string(d->string, state);
+}
+
+static int table_data_intern_compare_func(const TableData *x, const TableData *y) {
+        int r;
+
+        assert(x);
+        assert(y);
+
+        r = CMP(x->type, y->type);
+        if (r != 0)
+                return r;
+
+        r = CMP(x->minimum_width, y->minimum_width);
+        if (r != 0)
+                return r;
+
+        r = CMP(x->maximum_width, y->maximum_width);
+        if (r != 0)
+                return r;
+
+        r = CMP(x->weight, y->weight);
+        if (r != 0)
+                return r;
+
+        r = CMP(x->align_percent, y->align_percent);
+        if (r != 0)
+                return r;
+
+        r = CMP(x->ellipsize_percent, y->ellipsize_percent);
+        if (r != 0)
+                return r;
+
+        return strcmp(x->string, y->string);
+}
+
+DEFINE_PRIVATE_HASH_OPS_WITH_KEY_DESTRUCTOR(
+                table_data_intern_hash_ops,
+                TableData,
+                table_data_intern_hash_func,
+                table_data_intern_compare_func,
+                table_data_unref);
+
+static int table_data_acquire(
+                Table *t,
+                TableDataType type,
+                const void *data,
+                size_t minimum_width,
+                size_t maximum_width,
+                unsigned weight,
+                unsigned align_percent,
+                unsigned ellipsize_percent,
+                bool uppercase,
+                TableData **ret) {
+
+        _cleanup_(table_data_unrefp) TableData *d = NULL;
+        bool intern;
+        int r;
+
+        assert(t);
+        assert(ret);
+
+        /* Returns a reference to a data object with the specified data and formatting, either a shared one
+         * from the intern pool, or a newly allocated one. Objects in the pool never carry colors or URLs:
+         * the pool holds a reference of its own, hence table_dedup_cell() will always make a copy before
+         * the formatting of a cell is changed. */
+
+        intern = table_data_type_internable(type) && strlen(data) <= INTERN_STRING_MAX;
+        if (intern) {
+                size_t l = strlen(data);
+                TableData *key, *found;
+
+                key = alloca0(offsetof(TableData, data) + l + 1);
+                key->type = type;
+                key->minimum_width = minimum_width;
+                key->maximum_width = maximum_width;
+                key->weight = weight;
+                key->align_percent = align_percent;
+                key->ellipsize_percent = ellipsize_percent;
+                memcpy(key->string, data, l);
+
+                found = set_get(t->interned, key);
+                if (found) {
+                        assert(found->uppercase == uppercase);
+                        *ret = table_data_ref(found);
+                        return 0;
+                }
+        }
+
+        d = table_data_new(type, data, minimum_width, maximum_width, weight, align_percent, ellipsize_percent, uppercase);
+        if (!d)
+                return -ENOMEM;
+
+        if (intern && set_size(t->interned) < INTERN_ENTRIES_MAX) {
+                r = set_ensure_put(&t->interned, &table_data_intern_hash_ops, d);
+                if (r < 0)
+                        return r;
+
+                table_data_ref(d);
+        }
+
+        *ret = TAKE_PTR(d);
+        return 0;
+}
+
+static int table_stream_flush(Table *t, bool final);
+
 int table_add_cell_full(
                 Table *t,
                 TableCell **ret_cell,
@@ -469,6 +608,7 @@ int table_add_cell_full(
         _cleanup_(table_data_unrefp) TableData *d = NULL;
         bool uppercase;
         TableData *p;
+        int r;
 
         assert(t);
         assert(type >= 0);
@@ -478,6 +618,13 @@ int table_add_cell_full(
         if (!data)
                 type = TABLE_EMPTY;
 
+        /* When streaming, write out the rows completed so far before starting a new one. */
+        if (t->stream && t->n_cells > 0 && t->n_cells % t->n_columns == 0) {
+                r = table_stream_flush(t, /* final= */ false);
+                if (r < 0)
+                        return r;
+        }
+
         /* Determine the cell adjacent to the current one, but one row up */
         if (t->n_cells >= t->n_columns)
                 assert_se(p = t->data[t->n_cells - t->n_columns]);
@@ -508,9 +655,9 @@ int table_add_cell_full(
         if (p && table_data_matches(p, type, data, minimum_width, maximum_width, weight, align_percent, ellipsize_percent, uppercase))
                 d = table_data_ref(p);
         else {
-                d = table_data_new(type, data, minimum_width, maximum_width, weight, align_percent, ellipsize_percent, uppercase);
-                if (!d)
-                        return -ENOMEM;
+                r = table_data_acquire(t, type, data, minimum_width, maximum_width, weight, align_percent, ellipsize_percent, uppercase, &d);
+                if (r < 0)
+                        return r;
         }
 
         if (!GREEDY_REALLOC(t->data, MAX(t->n_cells + 1, t->n_columns)))
@@ -2244,44 +2391,20 @@ static const char* table_data_rgap_underline(const TableData *d) {
         return NULL;
 }
 
-int table_print(Table *t, FILE *f) {
-        size_t n_rows, *minimum_width, *maximum_width, display_columns, *requested_width,
+static int table_compute_widths(Table *t, size_t display_columns, size_t *ret_width) {
+        size_t n_rows, *minimum_width, *maximum_width, *requested_width,
                 table_minimum_width, table_maximum_width, table_requested_width, table_effective_width,
                 *width = NULL;
-        _cleanup_free_ size_t *sorted = NULL;
         uint64_t *column_weight, weight_sum;
         int r;
 
         assert(t);
+        assert(display_columns > 0);
+        assert(ret_width);
 
-        if (!f)
-                f = stdout;
-
-        /* Ensure we have no incomplete rows */
-        assert(t->n_cells % t->n_columns == 0);
+        /* Determines the widths of the displayed columns, from the data of all rows we currently have */
 
         n_rows = t->n_cells / t->n_columns;
-        assert(n_rows > 0); /* at least the header row must be complete */
-
-        if (t->sort_map) {
-                /* If sorting is requested, let's calculate an index table we use to lookup the actual index to display with. */
-
-                sorted = new(size_t, n_rows);
-                if (!sorted)
-                        return -ENOMEM;
-
-                for (size_t i = 0; i < n_rows; i++)
-                        sorted[i] = i * t->n_columns;
-
-                typesafe_qsort_r(sorted, n_rows, table_data_compare, t);
-        }
-
-        if (t->display_map)
-                display_columns = t->n_display_map;
-        else
-                display_columns = t->n_columns;
-
-        assert(display_columns > 0);
 
         minimum_width = newa(size_t, display_columns);
         maximum_width = newa(size_t, display_columns);
@@ -2397,8 +2520,7 @@ int table_print(Table *t, FILE *f) {
                 if (table_effective_width < table_minimum_width)
                         table_effective_width = table_minimum_width;
 
-                if (!width)
-                        width = newa(size_t, display_columns);
+                width = ret_width;
 
                 if (table_effective_width >= table_requested_width) {
                         size_t extra;
@@ -2502,147 +2624,308 @@ int table_print(Table *t, FILE *f) {
                 }
         }
 
-        /* Second pass: show output */
-        for (size_t i = t->header ? 0 : 1; i < n_rows; i++) {
-                size_t n_subline = 0;
-                bool more_sublines;
-                TableData **row;
+        return 0;
+}
 
-                if (sorted)
-                        row = t->data + sorted[i];
-                else
-                        row = t->data + i * t->n_columns;
+static bool table_data_is_numeric(const TableData *d) {
+        assert(d);
 
-                do {
-                        const char *gap_color = NULL, *gap_underline = NULL;
-                        more_sublines = false;
+        return IN_SET(d->type,
+                      TABLE_SIZE, TABLE_BPS,
+                      TABLE_INT, TABLE_INT8, TABLE_INT16, TABLE_INT32, TABLE_INT64,
+                      TABLE_UINT, TABLE_UINT8, TABLE_UINT16, TABLE_UINT32, TABLE_UINT32_HEX, TABLE_UINT64, TABLE_UINT64_HEX,
+                      TABLE_PERCENT, TABLE_IFINDEX, TABLE_UID, TABLE_GID, TABLE_PID);
+}
 
-                        for (size_t j = 0; j < display_columns; j++) {
-                                _cleanup_free_ char *buffer = NULL, *extracted = NULL;
-                                bool lines_truncated = false;
-                                const char *field, *color = NULL, *underline = NULL;
-                                TableData *d;
-                                size_t l;
+static int table_print_row(Table *t, FILE *f, TableData **row, const size_t *width, size_t display_columns) {
+        size_t n_subline = 0;
+        bool more_sublines;
+        int r;
 
-                                assert_se(d = row[t->display_map ? t->display_map[j] : j]);
+        assert(t);
+        assert(f);
+        assert(row);
+        assert(width);
 
-                                field = table_data_format(t, d, false, width[j], NULL);
-                                if (!field)
+        do {
+                const char *gap_color = NULL, *gap_underline = NULL;
+                more_sublines = false;
+
+                for (size_t j = 0; j < display_columns; j++) {
+                        _cleanup_free_ char *buffer = NULL, *extracted = NULL;
+                        bool lines_truncated = false;
+                        const char *field, *color = NULL, *underline = NULL;
+                        TableData *d;
+                        size_t l;
+
+                        assert_se(d = row[t->display_map ? t->display_map[j] : j]);
+
+                        field = table_data_format(t, d, false, width[j], NULL);
+                        if (!field)
+                                return -ENOMEM;
+
+                        r = string_extract_line(field, n_subline, &extracted);
+                        if (r < 0)
+                                return r;
+                        if (r > 0) {
+                                /* There are more lines to come */
+                                if ((t->cell_height_max == SIZE_MAX || n_subline + 1 < t->cell_height_max))
+                                        more_sublines = true; /* There are more lines to come */
+                                else
+                                        lines_truncated = true;
+                        }
+                        if (extracted)
+                                field = extracted;
+
+                        /* When streaming, the column widths were fixed before this row was seen. A truncated
+                         * number is misleading though, hence let it overflow the column instead. */
+                        l = utf8_console_width(field);
+                        if (l > width[j] && !(t->stream_width && table_data_is_numeric(d))) {
+                                /* Field is wider than allocated space. Let's ellipsize */
+
+                                buffer = ellipsize(field, width[j], /* ellipsize at the end if we truncated coming lines, otherwise honour configuration */
+                                                   lines_truncated ? 100 : d->ellipsize_percent);
+                                if (!buffer)
                                         return -ENOMEM;
 
-                                r = string_extract_line(field, n_subline, &extracted);
-                                if (r < 0)
-                                        return r;
-                                if (r > 0) {
-                                        /* There are more lines to come */
-                                        if ((t->cell_height_max == SIZE_MAX || n_subline + 1 < t->cell_height_max))
-                                                more_sublines = true; /* There are more lines to come */
-                                        else
-                                                lines_truncated = true;
-                                }
-                                if (extracted)
-                                        field = extracted;
+                                field = buffer;
+                        } else {
+                                if (lines_truncated) {
+                                        _cleanup_free_ char *padded = NULL;
+
+                                        /* We truncated more lines of this cell, let's add an
+                                         * ellipsis. We first append it, but that might make our
+                                         * string grow above what we have space for, hence ellipsize
+                                         * right after. This will truncate the ellipsis and add a new
+                                         * one. */
 
-                                l = utf8_console_width(field);
-                                if (l > width[j]) {
-                                        /* Field is wider than allocated space. Let's ellipsize */
+                                        padded = strjoin(field, special_glyph(SPECIAL_GLYPH_ELLIPSIS));
+                                        if (!padded)
+                                                return -ENOMEM;
 
-                                        buffer = ellipsize(field, width[j], /* ellipsize at the end if we truncated coming lines, otherwise honour configuration */
-                                                           lines_truncated ? 100 : d->ellipsize_percent);
+                                        buffer = ellipsize(padded, width[j], 100);
                                         if (!buffer)
                                                 return -ENOMEM;
 
                                         field = buffer;
-                                } else {
-                                        if (lines_truncated) {
-                                                _cleanup_free_ char *padded = NULL;
-
-                                                /* We truncated more lines of this cell, let's add an
-                                                 * ellipsis. We first append it, but that might make our
-                                                 * string grow above what we have space for, hence ellipsize
-                                                 * right after. This will truncate the ellipsis and add a new
-                                                 * one. */
-
-                                                padded = strjoin(field, special_glyph(SPECIAL_GLYPH_ELLIPSIS));
-                                                if (!padded)
-                                                        return -ENOMEM;
-
-                                                buffer = ellipsize(padded, width[j], 100);
-                                                if (!buffer)
-                                                        return -ENOMEM;
-
-                                                field = buffer;
-                                                l = utf8_console_width(field);
-                                        }
-
-                                        if (l < width[j]) {
-                                                _cleanup_free_ char *aligned = NULL;
-                                                /* Field is shorter than allocated space. Let's align with spaces */
-
-                                                aligned = align_string_mem(field, d->url, width[j], d->align_percent);
-                                                if (!aligned)
-                                                        return -ENOMEM;
-
-                                                /* Drop trailing white spaces of last column when no cosmetics is set. */
-                                                if (j == display_columns - 1 &&
-                                                    (!colors_enabled() || !table_data_color(d)) &&
-                                                    (!underline_enabled() || !table_data_underline(d)) &&
-                                                    (!urlify_enabled() || !d->url))
-                                                        delete_trailing_chars(aligned, NULL);
-
-                                                free_and_replace(buffer, aligned);
-                                                field = buffer;
-                                        }
+                                        l = utf8_console_width(field);
                                 }
 
-                                if (l >= width[j] && d->url) {
-                                        _cleanup_free_ char *clickable = NULL;
+                                if (l < width[j]) {
+                                        _cleanup_free_ char *aligned = NULL;
+                                        /* Field is shorter than allocated space. Let's align with spaces */
 
-                                        r = terminal_urlify(d->url, field, &clickable);
-                                        if (r < 0)
-                                                return r;
+                                        aligned = align_string_mem(field, d->url, width[j], d->align_percent);
+                                        if (!aligned)
+                                                return -ENOMEM;
 
-                                        free_and_replace(buffer, clickable);
+                                        /* Drop trailing white spaces of last column when no cosmetics is set. */
+                                        if (j == display_columns - 1 &&
+                                            (!colors_enabled() || !table_data_color(d)) &&
+                                            (!underline_enabled() || !table_data_underline(d)) &&
+                                            (!urlify_enabled() || !d->url))
+                                                delete_trailing_chars(aligned, NULL);
+
+                                        free_and_replace(buffer, aligned);
                                         field = buffer;
                                 }
+                        }
 
-                                if (colors_enabled() && gap_color)
-                                        fputs(gap_color, f);
-                                if (underline_enabled() && gap_underline)
-                                        fputs(gap_underline, f);
+                        if (l >= width[j] && d->url) {
+                                _cleanup_free_ char *clickable = NULL;
 
-                                if (j > 0)
-                                        fputc(' ', f); /* column separator left of cell */
+                                r = terminal_urlify(d->url, field, &clickable);
+                                if (r < 0)
+                                        return r;
 
-                                /* Undo gap color/underline */
-                                if ((colors_enabled() && gap_color) ||
-                                    (underline_enabled() && gap_underline))
-                                        fputs(ANSI_NORMAL, f);
+                                free_and_replace(buffer, clickable);
+                                field = buffer;
+                        }
 
-                                if (colors_enabled()) {
-                                        color = table_data_color(d);
-                                        if (color)
-                                                fputs(color, f);
-                                }
+                        if (colors_enabled() && gap_color)
+                                fputs(gap_color, f);
+                        if (underline_enabled() && gap_underline)
+                                fputs(gap_underline, f);
 
-                                if (underline_enabled()) {
-                                        underline = table_data_underline(d);
-                                        if (underline)
-                                                fputs(underline, f);
-                                }
+                        if (j > 0)
+                                fputc(' ', f); /* column separator left of cell */
 
-                                fputs(field, f);
+                        /* Undo gap color/underline */
+                        if ((colors_enabled() && gap_color) ||
+                            (underline_enabled() && gap_underline))
+                                fputs(ANSI_NORMAL, f);
 
-                                if (color || underline)
-                                        fputs(ANSI_NORMAL, f);
+                        if (colors_enabled()) {
+                                color = table_data_color(d);
+                                if (color)
+                                        fputs(color, f);
+                        }
 
-                                gap_color = d->rgap_color;
-                                gap_underline = table_data_rgap_underline(d);
+                        if (underline_enabled()) {
+                                underline = table_data_underline(d);
+                                if (underline)
+                                        fputs(underline, f);
                         }
 
-                        fputc('\n', f);
-                        n_subline++;
-                } while (more_sublines);
+                        fputs(field, f);
+
+                        if (color || underline)
+                                fputs(ANSI_NORMAL, f);
+
+                        gap_color = d->rgap_color;
+                        gap_underline = table_data_rgap_underline(d);
+                }
+
+                fputc('\n', f);
+                n_subline++;
+        } while (more_sublines);
+
+        return 0;
+}
+
+static int table_stream_flush(Table *t, bool final) {
+        size_t n_rows, display_columns;
+        int r;
+
+        assert(t);
+        assert(t->stream);
+        assert(t->n_cells % t->n_columns == 0);
+
+        /* Rows can only be written out if they come in the order they are added */
+        if (t->sort_map)
+                return 0;
+
+        n_rows = t->n_cells / t->n_columns;
+
+        if (t->display_map)
+                display_columns = t->n_display_map;
+        else
+                display_columns = t->n_columns;
+
+        assert(display_columns > 0);
+
+        if (!t->stream_width) {
+                _cleanup_free_ size_t *width = NULL;
+
+                /* Collect the requested number of rows (plus the header row) first, and fix the column widths
+                 * based on them. Cells added later which do not fit are ellipsized, except for numbers. */
+                if (!final && n_rows <= t->stream_rows)
+                        return 0;
+
+                width = new(size_t, display_columns);
+                if (!width)
+                        return -ENOMEM;
+
+                r = table_compute_widths(t, display_columns, width);
+                if (r < 0)
+                        return r;
+
+                t->stream_width = TAKE_PTR(width);
+                t->n_stream_width = display_columns;
+                t->stream_next_row = t->header ? 0 : 1;
+        }
+
+        /* The set of columns to show can't be changed anymore once we started writing */
+        assert(t->n_stream_width == display_columns);
+
+        for (; t->stream_next_row < n_rows; t->stream_next_row++) {
+                r = table_print_row(t, t->stream, t->data + t->stream_next_row * t->n_columns, t->stream_width, display_columns);
+                if (r < 0)
+                        return r;
+        }
+
+        /* Release everything written out, except for the header row and the last row, as new cells inherit
+         * their formatting from the row above. */
+        if (n_rows > 2) {
+                for (size_t i = t->n_columns; i < (n_rows - 1) * t->n_columns; i++)
+                        table_data_unref(t->data[i]);
+
+                memmove(t->data + t->n_columns,
+                        t->data + (n_rows - 1) * t->n_columns,
+                        t->n_columns * sizeof(TableData*));
+
+                t->n_cells = 2 * t->n_columns;
+                t->n_dropped_rows += n_rows - 2;
+                t->stream_next_row = 2;
+        }
+
+        return 0;
+}
+
+int table_set_stream(Table *t, FILE *f, size_t n_rows) {
+        assert(t);
+
+        /* Enables streaming mode: once n_rows rows have been added, column widths are fixed and from then on
+         * rows are written to f as soon as they are complete, and released. table_print() will write out the
+         * remaining rows to f, too. Only cells of the row currently being added may be modified in this
+         * mode, and this is ignored if the table is sorted. */
+
+        if (t->stream_width)
+                return -EBUSY;
+
+        t->stream = f;
+        t->stream_rows = MAX(n_rows, 1U);
+        return 0;
+}
+
+int table_print(Table *t, FILE *f) {
+        size_t n_rows, display_columns, *width;
+        _cleanup_free_ size_t *sorted = NULL;
+        int r;
+
+        assert(t);
+
+        if (!f)
+                f = stdout;
+
+        /* Ensure we have no incomplete rows */
+        assert(t->n_cells % t->n_columns == 0);
+
+        n_rows = t->n_cells / t->n_columns;
+        assert(n_rows > 0); /* at least the header row must be complete */
+
+        if (t->stream && !t->sort_map) {
+                /* In streaming mode, write out what's left, to where the rest went */
+                r = table_stream_flush(t, /* final= */ true);
+                if (r < 0)
+                        return r;
+
+                return fflush_and_check(t->stream);
+        }
+
+        if (t->sort_map) {
+                /* If sorting is requested, let's calculate an index table we use to lookup the actual index to display with. */
+
+                sorted = new(size_t, n_rows);
+                if (!sorted)
+                        return -ENOMEM;
+
+                for (size_t i = 0; i < n_rows; i++)
+                        sorted[i] = i * t->n_columns;
+
+                typesafe_qsort_r(sorted, n_rows, table_data_compare, t);
+        }
+
+        if (t->display_map)
+                display_columns = t->n_display_map;
+        else
+                display_columns = t->n_columns;
+
+        assert(display_columns > 0);
+
+        width = newa(size_t, display_columns);
+
+        r = table_compute_widths(t, display_columns, width);
+        if (r < 0)
+                return r;
+
+        /* Second pass: show output */
+        for (size_t i = t->header ? 0 : 1; i < n_rows; i++) {
+                r = table_print_row(t, f,
+                                    t->data + (sorted ? sorted[i] : i * t->n_columns),
+                                    width, display_columns);
+                if (r < 0)
+                        return r;
         }
 
         return fflush_and_check(f);
@@ -2672,7 +2955,7 @@ size_t table_get_rows(Table *t) {
                 return 0;
 
         assert(t->n_columns > 0);
-        return t->n_cells / t->n_columns;
+        return t->n_cells / t->n_columns + t->n_dropped_rows;
 }
 
 size_t table_get_columns(Table *t) {
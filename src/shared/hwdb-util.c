@@ -20,6 +20,7 @@
 #include "strbuf.h"
 #include "string-util.h"
 #include "strv.h"
+#include "time-util.h"
 #include "tmpfile-util.h"
 
 static const char* const conf_file_dirs[] = {
@@ -570,7 +571,66 @@ static int import_file(struct trie *trie, const char *filename, uint16_t file_pr
         return r;
 }
 
-int hwdb_update(const char *root, const char *hwdb_bin_dir, bool strict, bool compat) {
+static int hwdb_bin_is_up_to_date(const char *root, const char *hwdb_bin, char * const *files, bool compat) {
+        const char sig[] = HWDB_SIG;
+        struct trie_header_f h;
+        _cleanup_close_ int fd = -EBADF;
+        struct stat st;
+        usec_t t;
+        ssize_t n;
+
+        assert(hwdb_bin);
+
+        /* Checks whether the compiled database was generated by this version of the tool, in the requested
+         * format, and after the last modification of any of the source files. Adding, removing or renaming
+         * source files updates the modification time of the containing directory, hence check these too. */
+
+        fd = open(hwdb_bin, O_RDONLY|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0)
+                return errno == ENOENT ? false : -errno;
+
+        if (fstat(fd, &st) < 0)
+                return -errno;
+        t = timespec_load(&st.st_mtim);
+
+        n = pread(fd, &h, sizeof(h), 0);
+        if (n < 0)
+                return -errno;
+        if ((size_t) n != sizeof(h) ||
+            memcmp(h.signature, sig, sizeof(h.signature)) != 0 ||
+            le64toh(h.tool_version) != PROJECT_VERSION ||
+            le64toh(h.value_entry_size) != (compat ? sizeof(struct trie_value_entry_f) : sizeof(struct trie_value_entry2_f)))
+                return false;
+
+        STRV_FOREACH(d, conf_file_dirs) {
+                _cleanup_free_ char *p = NULL;
+
+                p = path_join(root, *d);
+                if (!p)
+                        return -ENOMEM;
+
+                if (stat(p, &st) < 0) {
+                        if (errno == ENOENT)
+                                continue;
+                        return -errno;
+                }
+
+                if (timespec_load(&st.st_mtim) >= t)
+                        return false;
+        }
+
+        STRV_FOREACH(f, files) {
+                if (stat(*f, &st) < 0)
+                        return -errno;
+
+                if (timespec_load(&st.st_mtim) >= t)
+                        return false;
+        }
+
+        return true;
+}
+
+int hwdb_update(const char *root, const char *hwdb_bin_dir, bool strict, bool compat, bool incremental) {
         _cleanup_free_ char *hwdb_bin = NULL;
         _cleanup_(trie_freep) struct trie *trie = NULL;
         _cleanup_strv_free_ char **files = NULL;
@@ -580,7 +640,10 @@ int hwdb_update(const char *root, const char *hwdb_bin_dir, bool strict, bool co
         /* The argument 'compat' controls the format version of database. If false, then hwdb.bin will be
          * created with additional information such that priority, line number, and filename of database
          * source. If true, then hwdb.bin will be created without the information. systemd-hwdb command
-         * should set the argument false, and 'udevadm hwdb' command should set it true. */
+         * should set the argument false, and 'udevadm hwdb' command should set it true.
+         *
+         * If 'incremental' is true, the database is only regenerated if any of the source files changed
+         * since it was generated the last time. */
 
         hwdb_bin = path_join(root, hwdb_bin_dir ?: "/etc/udev", "hwdb.bin");
         if (!hwdb_bin)
@@ -618,6 +681,16 @@ int hwdb_update(const char *root, const char *hwdb_bin_dir, bool strict, bool co
                 return 0;
         }
 
+        if (incremental) {
+                err = hwdb_bin_is_up_to_date(root, hwdb_bin, files, compat);
+                if (err < 0)
+                        log_debug_errno(err, "Failed to check whether %s is up to date, regenerating: %m", hwdb_bin);
+                else if (err > 0) {
+                        log_info("Compiled hwdb database %s is up to date, skipping.", hwdb_bin);
+                        return 0;
+                }
+        }
+
         STRV_FOREACH(f, files) {
                 log_debug("Reading file \"%s\"", *f);
                 err = import_file(trie, *f, file_priority++, compat);
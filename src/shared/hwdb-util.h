@@ -6,6 +6,6 @@
 #include "sd-hwdb.h"
 
 bool hwdb_should_reload(sd_hwdb *hwdb);
-int hwdb_update(const char *root, const char *hwdb_bin_dir, bool strict, bool compat);
+int hwdb_update(const char *root, const char *hwdb_bin_dir, bool strict, bool compat, bool incremental);
 int hwdb_query(const char *modalias, const char *root);
 int hwdb_bypass(void);
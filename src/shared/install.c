@@ -658,6 +658,7 @@ static int remove_marked_symlinks_fd(
                 const char *config_path,
                 const LookupPaths *lp,
                 bool dry_run,
+                Hashmap **resolved,
                 bool *restart,
                 InstallChange **changes,
                 size_t *n_changes) {
@@ -670,6 +671,7 @@ static int remove_marked_symlinks_fd(
         assert(path);
         assert(config_path);
         assert(lp);
+        assert(resolved);
         assert(restart);
 
         d = fdopendir(fd);
@@ -701,6 +703,7 @@ static int remove_marked_symlinks_fd(
                                                                   TAKE_FD(nfd), p,
                                                                   config_path, lp,
                                                                   dry_run,
+                                                                  resolved,
                                                                   restart,
                                                                   changes, n_changes));
 
@@ -733,15 +736,34 @@ static int remove_marked_symlinks_fd(
                         }
 
                         if (!found) {
-                                _cleanup_free_ char *dest = NULL, *dest_name = NULL;
+                                _cleanup_free_ char *dest_name = NULL;
+                                const char *dest;
+
+                                /* We might have to go through the tree multiple times, see below, but the
+                                 * symlinks we keep stay the same, hence resolve each of them only once. */
+                                dest = hashmap_get(*resolved, p);
+                                if (!dest) {
+                                        _cleanup_free_ char *k = NULL, *v = NULL;
+
+                                        r = chase(p, lp->root_dir, CHASE_NONEXISTENT, &v, NULL);
+                                        if (r == -ENOENT)
+                                                continue;
+                                        if (r < 0) {
+                                                log_debug_errno(r, "Failed to resolve symlink \"%s\": %m", p);
+                                                RET_GATHER(ret, install_changes_add(changes, n_changes, r, p, NULL));
+                                                continue;
+                                        }
+
+                                        k = strdup(p);
+                                        if (!k)
+                                                return -ENOMEM;
 
-                                r = chase(p, lp->root_dir, CHASE_NONEXISTENT, &dest, NULL);
-                                if (r == -ENOENT)
-                                        continue;
-                                if (r < 0) {
-                                        log_debug_errno(r, "Failed to resolve symlink \"%s\": %m", p);
-                                        RET_GATHER(ret, install_changes_add(changes, n_changes, r, p, NULL));
-                                        continue;
+                                        r = hashmap_ensure_put(resolved, &path_hash_ops_free_free, k, v);
+                                        if (r < 0)
+                                                return r;
+
+                                        TAKE_PTR(k);
+                                        dest = TAKE_PTR(v);
                                 }
 
                                 r = path_extract_filename(dest, &dest_name);
@@ -790,6 +812,7 @@ static int remove_marked_symlinks(
                 InstallChange **changes,
                 size_t *n_changes) {
 
+        _cleanup_hashmap_free_ Hashmap *resolved = NULL;
         _cleanup_close_ int fd = -EBADF;
         bool restart;
         int r = 0;
@@ -817,6 +840,7 @@ static int remove_marked_symlinks(
                                                         cfd, config_path,
                                                         config_path, lp,
                                                         dry_run,
+                                                        &resolved,
                                                         &restart,
                                                         changes, n_changes));
         } while (restart);
@@ -3671,6 +3695,7 @@ int unit_file_preset_all(
         _cleanup_(install_context_done) InstallContext plus = {}, minus = {};
         _cleanup_(lookup_paths_done) LookupPaths lp = {};
         _cleanup_(unit_file_presets_done) UnitFilePresets presets = {};
+        _cleanup_set_free_ Set *seen = NULL;
         const char *config_path = NULL;
         int r;
 
@@ -3710,6 +3735,14 @@ int unit_file_preset_all(
                         if (!IN_SET(de->d_type, DT_LNK, DT_REG))
                                 continue;
 
+                        /* Units are looked up by name across all search paths anyway, hence if the same
+                         * name shows up in multiple of them, there's no need to look at it again. */
+                        k = set_put_strdup_full(&seen, &string_hash_ops_free, de->d_name);
+                        if (k < 0)
+                                return k;
+                        if (k == 0)
+                                continue;
+
                         k = preset_prepare_one(scope, &plus, &minus, &lp, de->d_name, &presets, changes, n_changes);
                         if (k < 0 &&
                             !IN_SET(k, -EEXIST,
@@ -9,7 +9,10 @@
 #include "fd-util.h"
 #include "format-util.h"
 #include "journal-authenticate.h"
+#include "journal-boot-index.h"
 #include "journal-file-util.h"
+#include "journal-index.h"
+#include "journal-unique-index.h"
 #include "path-util.h"
 #include "random-util.h"
 #include "set.h"
@@ -182,10 +185,27 @@ static void journal_file_set_offline_internal(JournalFile *f) {
                         if (f->archive) {
                                 (void) journal_file_end_punch_hole(f);
                                 (void) journal_file_punch_holes(f);
+
+                                if (journal_index_enabled()) {
+                                        (void) journal_index_write(f);
+                                        (void) journal_unique_index_write(f);
+                                }
+
+                                (void) journal_boot_index_update(f);
                         }
 
                         (void) fsync(f->fd);
 
+                        if (__atomic_load_n(&f->offline_sync_only, __ATOMIC_SEQ_CST)) {
+                                /* We were only asked to sync, see journal_file_sync_async() */
+                                OfflineState tmp_state = OFFLINE_SYNCING;
+                                if (!__atomic_compare_exchange_n(&f->offline_state, &tmp_state, OFFLINE_DONE,
+                                                                 false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+                                        continue;
+
+                                return;
+                        }
+
                         {
                                 OfflineState tmp_state = OFFLINE_SYNCING;
                                 if (!__atomic_compare_exchange_n(&f->offline_state, &tmp_state, OFFLINE_OFFLINING,
@@ -255,6 +275,35 @@ static void * journal_file_set_offline_thread(void *arg) {
         return NULL;
 }
 
+static int journal_file_start_offline_thread(JournalFile *f) {
+        sigset_t ss, saved_ss;
+        int r, k;
+
+        assert(f);
+        assert(f->offline_state == OFFLINE_SYNCING);
+
+        assert_se(sigfillset(&ss) >= 0);
+        /* Don't block SIGBUS since the offlining thread accesses a memory mapped file.
+         * Asynchronous SIGBUS signals can safely be handled by either thread. */
+        assert_se(sigdelset(&ss, SIGBUS) >= 0);
+
+        r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+        if (r > 0)
+                return -r;
+
+        r = pthread_create(&f->offline_thread, NULL, journal_file_set_offline_thread, f);
+
+        k = pthread_sigmask(SIG_SETMASK, &saved_ss, NULL);
+        if (r > 0) {
+                f->offline_state = OFFLINE_JOINED;
+                return -r;
+        }
+        if (k > 0)
+                return -k;
+
+        return 0;
+}
+
 /* Trigger a restart if the offline thread is mid-flight in a restartable state. */
 static bool journal_file_set_offline_try_restart(JournalFile *f) {
         for (;;) {
@@ -318,6 +367,9 @@ int journal_file_set_offline(JournalFile *f, bool wait) {
 
         target_state = f->archive ? STATE_ARCHIVED : STATE_OFFLINE;
 
+        /* If a sync started by journal_file_sync_async() is in flight, make it go all the way. */
+        __atomic_store_n(&f->offline_sync_only, false, __ATOMIC_SEQ_CST);
+
         /* An offlining journal is implicitly online and may modify f->header->state,
          * we must also join any potentially lingering offline thread when already in
          * the desired offline state.
@@ -339,38 +391,60 @@ int journal_file_set_offline(JournalFile *f, bool wait) {
         /* Initiate a new offline. */
         f->offline_state = OFFLINE_SYNCING;
 
-        if (wait) {
-                /* Without using a thread if waiting. */
-                journal_file_set_offline_internal(f);
+        if (!wait)
+                return journal_file_start_offline_thread(f);
 
-                assert(f->offline_state == OFFLINE_DONE);
-                f->offline_state = OFFLINE_JOINED;
+        /* Without using a thread if waiting. */
+        journal_file_set_offline_internal(f);
 
-        } else {
-                sigset_t ss, saved_ss;
-                int k;
+        assert(f->offline_state == OFFLINE_DONE);
+        f->offline_state = OFFLINE_JOINED;
 
-                assert_se(sigfillset(&ss) >= 0);
-                /* Don't block SIGBUS since the offlining thread accesses a memory mapped file.
-                 * Asynchronous SIGBUS signals can safely be handled by either thread. */
-                assert_se(sigdelset(&ss, SIGBUS) >= 0);
+        return 0;
+}
 
-                r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
-                if (r > 0)
-                        return -r;
+/* Syncs a journal to disk in a separate thread, like journal_file_set_offline() with wait set to false,
+ * but leaves it online. Offlining a journal means that the next write has to bring it online again,
+ * which involves another fsync() in the caller's context, hence this is preferable for journals that
+ * are being written to actively. */
+int journal_file_sync_async(JournalFile *f) {
+        int r;
 
-                r = pthread_create(&f->offline_thread, NULL, journal_file_set_offline_thread, f);
+        assert(f);
 
-                k = pthread_sigmask(SIG_SETMASK, &saved_ss, NULL);
-                if (r > 0) {
-                        f->offline_state = OFFLINE_JOINED;
-                        return -r;
-                }
-                if (k > 0)
-                        return -k;
+        if (!journal_file_writable(f))
+                return -EPERM;
+
+        if (f->fd < 0 || !f->header)
+                return -EINVAL;
+
+        if (f->archive)
+                return journal_file_set_offline(f, /* wait= */ false);
+
+        if (journal_file_is_offlining(f)) {
+                /* An offline puts everything on disk anyway, and nothing was written since it was started,
+                 * as that would have cancelled it. */
+                if (!__atomic_load_n(&f->offline_sync_only, __ATOMIC_SEQ_CST))
+                        return 0;
+
+                /* A sync is in flight, make it go again, to cover whatever was written since it started. */
+                if (journal_file_set_offline_try_restart(f))
+                        return 0;
         }
 
-        return 0;
+        /* Join a lingering done thread */
+        r = journal_file_set_offline_thread_join(f);
+        if (r < 0)
+                return r;
+
+        /* Nothing written since the journal was last offlined? */
+        if (f->header->state != STATE_ONLINE)
+                return 0;
+
+        __atomic_store_n(&f->offline_sync_only, true, __ATOMIC_SEQ_CST);
+        f->offline_state = OFFLINE_SYNCING;
+
+        return journal_file_start_offline_thread(f);
 }
 
 bool journal_file_is_offlining(JournalFile *f) {
@@ -4,6 +4,7 @@
 #include "journal-file.h"
 
 int journal_file_set_offline(JournalFile *f, bool wait);
+int journal_file_sync_async(JournalFile *f);
 bool journal_file_is_offlining(JournalFile *f);
 void journal_file_write_final_tag(JournalFile *f);
 JournalFile* journal_file_offline_close(JournalFile *f);
@@ -27,6 +27,7 @@
 #include "log.h"
 #include "logs-show.h"
 #include "macro.h"
+#include "missing_threads.h"
 #include "output-mode.h"
 #include "parse-util.h"
 #include "pretty-print.h"
@@ -37,6 +38,7 @@
 #include "strv.h"
 #include "terminal-util.h"
 #include "time-util.h"
+#include "unaligned.h"
 #include "user-util.h"
 #include "utf8.h"
 #include "web-util.h"
@@ -361,6 +363,57 @@ finish:
         return written_chars;
 }
 
+typedef struct TimestampPrefixCache {
+        usec_t sec;
+        bool utc;
+        bool iso;
+        long gmtoff;
+        size_t len;
+        char buf[CONST_MAX(FORMAT_TIMESTAMP_MAX, 64U)];
+
+        /* The time zone the prefix was formatted in, as callers may switch it via $TZ and tzset() */
+        bool tz_set;
+        char tz[64];
+        const char *tzname[2];
+        long timezone;
+        int daylight;
+} TimestampPrefixCache;
+
+static thread_local TimestampPrefixCache timestamp_prefix_cache = {
+        .sec = USEC_INFINITY,
+};
+
+static bool timestamp_prefix_cache_tz_matches(const TimestampPrefixCache *c) {
+        const char *tz;
+
+        assert(c);
+
+        tz = getenv("TZ");
+        if (!!tz != c->tz_set || (tz && !streq(tz, c->tz)))
+                return false;
+
+        return c->tzname[0] == tzname[0] && c->tzname[1] == tzname[1] &&
+                c->timezone == timezone && c->daylight == daylight;
+}
+
+static bool timestamp_prefix_cache_tz_save(TimestampPrefixCache *c) {
+        const char *tz;
+
+        assert(c);
+
+        tz = getenv("TZ");
+        if (tz && strlen(tz) >= sizeof(c->tz))
+                return false; /* Don't bother with unusually long time zone specifications */
+
+        c->tz_set = !!tz;
+        strcpy(c->tz, strempty(tz));
+        c->tzname[0] = tzname[0];
+        c->tzname[1] = tzname[1];
+        c->timezone = timezone;
+        c->daylight = daylight;
+        return true;
+}
+
 static int output_timestamp_realtime(
                 FILE *f,
                 sd_journal *j,
@@ -394,19 +447,45 @@ static int output_timestamp_realtime(
         case OUTPUT_SHORT_PRECISE:
         case OUTPUT_SHORT_ISO:
         case OUTPUT_SHORT_ISO_PRECISE: {
-                struct tm tm;
+                TimestampPrefixCache *c = &timestamp_prefix_cache;
+                bool utc = FLAGS_SET(flags, OUTPUT_UTC), iso = IN_SET(mode, OUTPUT_SHORT_ISO, OUTPUT_SHORT_ISO_PRECISE);
                 size_t tail = 0;
+                long gmtoff = 0;
+
+                /* Converting to calendar time is expensive, and consecutive entries are usually logged within
+                 * the same second. Hence, remember the formatted seconds of the previous entry. */
+                if (c->sec == usec / USEC_PER_SEC && c->utc == utc && c->iso == iso &&
+                    timestamp_prefix_cache_tz_matches(c)) {
+                        memcpy(buf, c->buf, c->len + 1);
+                        tail = c->len;
+                        gmtoff = c->gmtoff;
+                } else {
+                        struct tm tm;
 
-                r = localtime_or_gmtime_usec(usec, flags & OUTPUT_UTC, &tm);
-                if (r < 0)
-                        log_debug_errno(r, "Failed to convert timestamp to calendar time, generating fallback timestamp: %m");
-                else {
-                        tail = strftime(
-                                        buf, sizeof(buf),
-                                        IN_SET(mode, OUTPUT_SHORT_ISO, OUTPUT_SHORT_ISO_PRECISE) ? "%Y-%m-%dT%H:%M:%S" : "%b %d %H:%M:%S",
-                                        &tm);
-                        if (tail <= 0)
-                                log_debug("Failed to format calendar time, generating fallback timestamp.");
+                        r = localtime_or_gmtime_usec(usec, utc, &tm);
+                        if (r < 0)
+                                log_debug_errno(r, "Failed to convert timestamp to calendar time, generating fallback timestamp: %m");
+                        else {
+                                tail = strftime(buf, sizeof(buf), iso ? "%Y-%m-%dT%H:%M:%S" : "%b %d %H:%M:%S", &tm);
+                                if (tail <= 0)
+                                        log_debug("Failed to format calendar time, generating fallback timestamp.");
+                        }
+
+                        if (tail > 0) {
+                                gmtoff = tm.tm_gmtoff;
+
+                                *c = (TimestampPrefixCache) {
+                                        .sec = usec / USEC_PER_SEC,
+                                        .utc = utc,
+                                        .iso = iso,
+                                        .gmtoff = gmtoff,
+                                        .len = tail,
+                                };
+                                memcpy(c->buf, buf, tail + 1);
+
+                                if (!timestamp_prefix_cache_tz_save(c))
+                                        c->sec = USEC_INFINITY;
+                        }
                 }
 
                 if (tail <= 0) {
@@ -434,9 +513,9 @@ static int output_timestamp_realtime(
                         assert(tail <= sizeof(buf));
                 }
 
-                if (IN_SET(mode, OUTPUT_SHORT_ISO, OUTPUT_SHORT_ISO_PRECISE)) {
-                        int h = tm.tm_gmtoff / 60 / 60,
-                                m = abs((int) ((tm.tm_gmtoff / 60) % 60));
+                if (iso) {
+                        int h = gmtoff / 60 / 60,
+                                m = abs((int) ((gmtoff / 60) % 60));
 
                         assert_se(snprintf_ok(buf + tail, sizeof(buf) - tail, "%+03d:%02d", h, m));
                 }
@@ -570,6 +649,14 @@ static int output_short(
                 PARSE_FIELD_VEC_ENTRY("_SOURCE_REALTIME_TIMESTAMP=",  &realtime,          NULL                  ),
                 PARSE_FIELD_VEC_ENTRY("_SOURCE_MONOTONIC_TIMESTAMP=", &monotonic,         NULL                  ),
         };
+        /* The same fields as above, so that the library can skip over all others without decompressing
+         * them */
+        static const char *const data_filter[] = {
+                "_PID", "_COMM", "MESSAGE", "PRIORITY", "_TRANSPORT", "_HOSTNAME", "SYSLOG_PID",
+                "SYSLOG_IDENTIFIER", "CONFIG_FILE", "_SYSTEMD_UNIT", "_SYSTEMD_USER_UNIT", "DOCUMENTATION",
+                "_SOURCE_REALTIME_TIMESTAMP", "_SOURCE_MONOTONIC_TIMESTAMP",
+                NULL
+        };
         size_t highlight_shifted[] = {highlight ? highlight[0] : 0, highlight ? highlight[1] : 0};
 
         assert(f);
@@ -582,6 +669,10 @@ static int output_short(
          * misleading line without any indication of truncation.
          */
         (void) sd_journal_set_data_threshold(j, flags & (OUTPUT_SHOW_ALL|OUTPUT_FULL_WIDTH) ? 0 : PRINT_CHAR_THRESHOLD + 1);
+        assert_cc(ELEMENTSOF(data_filter) == ELEMENTSOF(fields) + 1);
+        r = sd_journal_set_data_filter(j, (char**) data_filter);
+        if (r < 0)
+                return log_error_errno(r, "Failed to set journal data filter: %m");
 
         JOURNAL_FOREACH_DATA_RETVAL(j, data, length, r) {
                 r = parse_fieldv(data, length, fields, ELEMENTSOF(fields));
@@ -1008,6 +1099,374 @@ static int output_export(
         return 0;
 }
 
+/* A batch is written out once it reaches either limit */
+#define COLUMNAR_BATCH_ENTRIES_MAX 1024U
+#define COLUMNAR_BATCH_SIZE_MAX (4U*1024U*1024U)
+
+typedef struct ColumnarColumn ColumnarColumn;
+
+struct ColumnarColumn {
+        char *name;
+
+        /* One per entry of the batch, UINT64_MAX if the entry doesn't carry the field */
+        uint64_t *lengths;
+        size_t n_lengths;
+
+        uint8_t *values;
+        size_t values_size;
+
+        /* Another column of the same name, for fields that appear more than once in an entry */
+        ColumnarColumn *next;
+};
+
+struct JournalColumnarWriter {
+        FILE *f;
+        const Set *output_fields;
+
+        ColumnarColumn **columns;
+        size_t n_columns;
+        Hashmap *columns_by_name; /* first column of each name */
+
+        size_t n_entries;
+        size_t size;
+};
+
+static ColumnarColumn* columnar_column_free(ColumnarColumn *c) {
+        if (!c)
+                return NULL;
+
+        free(c->name);
+        free(c->lengths);
+        free(c->values);
+        return mfree(c);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(ColumnarColumn*, columnar_column_free);
+
+static void journal_columnar_writer_reset(JournalColumnarWriter *w) {
+        assert(w);
+
+        hashmap_clear(w->columns_by_name);
+
+        FOREACH_ARRAY(c, w->columns, w->n_columns)
+                columnar_column_free(*c);
+        w->columns = mfree(w->columns);
+        w->n_columns = 0;
+
+        w->n_entries = 0;
+        w->size = 0;
+}
+
+JournalColumnarWriter* journal_columnar_writer_free(JournalColumnarWriter *w) {
+        if (!w)
+                return NULL;
+
+        journal_columnar_writer_reset(w);
+        hashmap_free(w->columns_by_name);
+
+        return mfree(w);
+}
+
+int journal_columnar_writer_new(FILE *f, const Set *output_fields, JournalColumnarWriter **ret) {
+        JournalColumnarWriter *w;
+
+        assert(f);
+        assert(ret);
+
+        w = new(JournalColumnarWriter, 1);
+        if (!w)
+                return -ENOMEM;
+
+        *w = (JournalColumnarWriter) {
+                .f = f,
+                .output_fields = output_fields,
+        };
+
+        *ret = w;
+        return 0;
+}
+
+static int columnar_add_field(
+                JournalColumnarWriter *w,
+                const char *name,
+                size_t name_len,
+                const void *value,
+                size_t value_len) {
+
+        ColumnarColumn *c, *first, *last = NULL;
+        const char *n;
+        int r;
+
+        assert(w);
+        assert(name);
+        assert(value || value_len == 0);
+
+        n = strndupa_safe(name, name_len);
+
+        /* Find the first column of this name that has no value for the current entry yet */
+        first = hashmap_get(w->columns_by_name, n);
+        for (c = first; c; c = c->next) {
+                if (c->n_lengths <= w->n_entries)
+                        break;
+
+                last = c;
+        }
+
+        if (!c) {
+                _cleanup_(columnar_column_freep) ColumnarColumn *nc = NULL;
+
+                nc = new0(ColumnarColumn, 1);
+                if (!nc)
+                        return -ENOMEM;
+
+                nc->name = strdup(n);
+                if (!nc->name)
+                        return -ENOMEM;
+
+                if (!GREEDY_REALLOC(w->columns, w->n_columns + 1))
+                        return -ENOMEM;
+
+                if (last)
+                        last->next = nc;
+                else {
+                        r = hashmap_ensure_put(&w->columns_by_name, &string_hash_ops, nc->name, nc);
+                        if (r < 0)
+                                return r;
+                }
+
+                c = w->columns[w->n_columns++] = TAKE_PTR(nc);
+                w->size += sizeof(le32_t) + name_len;
+        }
+
+        if (!GREEDY_REALLOC(c->lengths, w->n_entries + 1))
+                return -ENOMEM;
+
+        if (value_len > 0) {
+                if (!GREEDY_REALLOC(c->values, c->values_size + value_len))
+                        return -ENOMEM;
+
+                memcpy(c->values + c->values_size, value, value_len);
+                c->values_size += value_len;
+        }
+
+        /* Mark the entries before this one that didn't carry the field */
+        while (c->n_lengths < w->n_entries)
+                c->lengths[c->n_lengths++] = UINT64_MAX;
+        c->lengths[c->n_lengths++] = value_len;
+
+        w->size += value_len;
+        return 0;
+}
+
+static int columnar_add_string(JournalColumnarWriter *w, const char *name, const char *value) {
+        assert(name);
+        assert(value);
+
+        return columnar_add_field(w, name, strlen(name), value, strlen(value));
+}
+
+static int columnar_add_unsigned(JournalColumnarWriter *w, const char *name, uint64_t value) {
+        char buf[DECIMAL_STR_MAX(uint64_t)];
+
+        xsprintf(buf, "%" PRIu64, value);
+        return columnar_add_string(w, name, buf);
+}
+
+static int columnar_add_data(JournalColumnarWriter *w, const void *data, size_t length) {
+        const char *eq;
+        size_t fieldlen;
+
+        eq = memchr(data, '=', length);
+        if (!eq)
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Invalid field.");
+
+        fieldlen = eq - (const char*) data;
+        if (!journal_field_valid(data, fieldlen, true))
+                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Invalid field.");
+
+        return columnar_add_field(w, data, fieldlen, eq + 1, length - fieldlen - 1);
+}
+
+int journal_columnar_writer_add(JournalColumnarWriter *w, sd_journal *j) {
+        sd_id128_t journal_boot_id, seqnum_id;
+        _cleanup_free_ char *cursor = NULL;
+        usec_t monotonic, realtime;
+        const void *data;
+        uint64_t seqnum;
+        size_t length;
+        int r;
+
+        assert(w);
+        assert(j);
+
+        (void) sd_journal_set_data_threshold(j, 0);
+
+        r = sd_journal_get_cursor(j, &cursor);
+        if (r < 0)
+                return log_error_errno(r, "Failed to get cursor: %m");
+
+        r = sd_journal_get_realtime_usec(j, &realtime);
+        if (r < 0)
+                return log_error_errno(r, "Failed to get realtime timestamp: %m");
+
+        r = sd_journal_get_monotonic_usec(j, &monotonic, &journal_boot_id);
+        if (r < 0)
+                return log_error_errno(r, "Failed to get monotonic timestamp: %m");
+
+        r = sd_journal_get_seqnum(j, &seqnum, &seqnum_id);
+        if (r < 0)
+                return log_error_errno(r, "Failed to get seqnum: %m");
+
+        /* The same metadata the export format carries, as fields of their own */
+        r = columnar_add_string(w, "__CURSOR", cursor);
+        if (r >= 0)
+                r = columnar_add_unsigned(w, "__REALTIME_TIMESTAMP", realtime);
+        if (r >= 0)
+                r = columnar_add_unsigned(w, "__MONOTONIC_TIMESTAMP", monotonic);
+        if (r >= 0)
+                r = columnar_add_unsigned(w, "__SEQNUM", seqnum);
+        if (r >= 0)
+                r = columnar_add_string(w, "__SEQNUM_ID", SD_ID128_TO_STRING(seqnum_id));
+        if (r >= 0)
+                r = columnar_add_string(w, "_BOOT_ID", SD_ID128_TO_STRING(journal_boot_id));
+        if (r < 0)
+                return log_oom();
+
+        if (!set_isempty(w->output_fields)) {
+                const char *field;
+
+                /* Only look up the requested fields, so that we never decompress any other data objects */
+                SET_FOREACH(field, w->output_fields) {
+                        if (streq(field, "_BOOT_ID"))
+                                continue;
+
+                        r = sd_journal_get_data(j, field, &data, &length);
+                        if (r == -ENOENT)
+                                continue;
+                        if (IN_SET(r, -EADDRNOTAVAIL, -EBADMSG)) {
+                                log_debug_errno(r, "Skipping rest of message we can't read: %m");
+                                break;
+                        }
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to get data: %m");
+
+                        r = columnar_add_data(w, data, length);
+                        if (r == -ENOMEM)
+                                return log_oom();
+                        if (r < 0)
+                                return r;
+                }
+        } else {
+                JOURNAL_FOREACH_DATA_RETVAL(j, data, length, r) {
+                        /* We already added the boot id from the entry header, hence let's suppress it here */
+                        if (memory_startswith(data, length, "_BOOT_ID="))
+                                continue;
+
+                        r = columnar_add_data(w, data, length);
+                        if (r == -ENOMEM)
+                                return log_oom();
+                        if (r < 0)
+                                return r;
+                }
+                if (IN_SET(r, -EADDRNOTAVAIL, -EBADMSG))
+                        log_debug_errno(r, "Skipping rest of message we can't read: %m");
+                else if (r < 0)
+                        return r;
+        }
+
+        w->n_entries++;
+
+        if (w->n_entries >= COLUMNAR_BATCH_ENTRIES_MAX || w->size >= COLUMNAR_BATCH_SIZE_MAX)
+                return journal_columnar_writer_flush(w);
+
+        return 0;
+}
+
+int journal_columnar_writer_flush(JournalColumnarWriter *w) {
+        _cleanup_free_ uint8_t *buf = NULL;
+        size_t size;
+        uint8_t *p;
+
+        assert(w);
+
+        if (w->n_entries == 0)
+                return 0;
+
+        /* A batch consists of its size, the number of entries and columns, followed by the columns. Each
+         * column consists of the field name, the lengths of its values in all entries, and the values
+         * themselves. See docs/JOURNAL_EXPORT_FORMATS.md for details. */
+
+        size = sizeof(le64_t) + 2 * sizeof(le32_t);
+        FOREACH_ARRAY(i, w->columns, w->n_columns)
+                size += sizeof(le32_t) + strlen((*i)->name) + w->n_entries * sizeof(le64_t) + (*i)->values_size;
+
+        buf = malloc(size);
+        if (!buf)
+                return log_oom();
+
+        p = buf;
+        unaligned_write_le64(p, size - sizeof(le64_t));
+        p += sizeof(le64_t);
+        unaligned_write_le32(p, w->n_entries);
+        p += sizeof(le32_t);
+        unaligned_write_le32(p, w->n_columns);
+        p += sizeof(le32_t);
+
+        FOREACH_ARRAY(i, w->columns, w->n_columns) {
+                ColumnarColumn *c = *i;
+                size_t l = strlen(c->name);
+
+                unaligned_write_le32(p, l);
+                p += sizeof(le32_t);
+                p = mempcpy(p, c->name, l);
+
+                for (size_t k = 0; k < w->n_entries; k++) {
+                        unaligned_write_le64(p, k < c->n_lengths ? c->lengths[k] : UINT64_MAX);
+                        p += sizeof(le64_t);
+                }
+
+                p = mempcpy_safe(p, c->values, c->values_size);
+        }
+
+        assert(p == buf + size);
+
+        journal_columnar_writer_reset(w);
+
+        /* Write the whole batch with a single call, large writes bypass the stdio buffer */
+        if (fwrite(buf, 1, size, w->f) != size)
+                return log_error_errno(errno_or_else(EIO), "Failed to write batch: %m");
+
+        return 0;
+}
+
+static int output_export_columnar(
+                FILE *f,
+                sd_journal *j,
+                OutputMode mode,
+                unsigned n_columns,
+                OutputFlags flags,
+                const Set *output_fields,
+                const size_t highlight[2],
+                dual_timestamp *previous_display_ts, /* unused */
+                sd_id128_t *previous_boot_id) {      /* unused */
+
+        _cleanup_(journal_columnar_writer_freep) JournalColumnarWriter *w = NULL;
+        int r;
+
+        /* When called for individual entries each entry makes a batch of its own. Callers that show many
+         * entries should use JournalColumnarWriter directly. */
+
+        r = journal_columnar_writer_new(f, output_fields, &w);
+        if (r < 0)
+                return log_oom();
+
+        r = journal_columnar_writer_add(w, j);
+        if (r < 0)
+                return r;
+
+        return journal_columnar_writer_flush(w);
+}
+
 void json_escape(
                 FILE *f,
                 const char* p,
@@ -1423,6 +1882,7 @@ static output_func_t output_funcs[_OUTPUT_MODE_MAX] = {
         [OUTPUT_SHORT_FULL]        = output_short,
         [OUTPUT_VERBOSE]           = output_verbose,
         [OUTPUT_EXPORT]            = output_export,
+        [OUTPUT_EXPORT_COLUMNAR]   = output_export_columnar,
         [OUTPUT_JSON]              = output_json,
         [OUTPUT_JSON_PRETTY]       = output_json,
         [OUTPUT_JSON_SSE]          = output_json,
@@ -1453,6 +1913,14 @@ int show_journal_entry(
         if (n_columns <= 0)
                 n_columns = columns();
 
+        /* output_short() only looks at a few fields and installs a filter for them, everybody else wants
+         * to see all fields */
+        if (output_funcs[mode] != output_short) {
+                r = sd_journal_set_data_filter(j, NULL);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to reset journal data filter: %m");
+        }
+
         r = output_funcs[mode](
                         f,
                         j,
@@ -2115,6 +2583,40 @@ static int discover_next_id(
         }
 }
 
+static int find_boot_by_summary(sd_journal *j, sd_id128_t previous_id, int offset, sd_id128_t *ret) {
+        _cleanup_free_ JournalBoot *boots = NULL;
+        size_t n_boots;
+        int64_t i;
+        int r;
+
+        assert(j);
+        assert(ret);
+
+        r = journal_enumerate_boots(j, &boots, &n_boots);
+        if (r < 0)
+                return r;
+
+        if (sd_id128_is_null(previous_id))
+                /* Offset 0 is the last boot, 1 the first one, and negative offsets count back from the last. */
+                i = offset <= 0 ? (int64_t) n_boots - 1 + offset : offset - 1;
+        else {
+                i = -1; /* Not found, unless we find it below */
+                for (size_t k = 0; k < n_boots; k++)
+                        if (sd_id128_equal(boots[k].boot_id, previous_id)) {
+                                i = (int64_t) k + offset;
+                                break;
+                        }
+        }
+
+        if (i < 0 || i >= (int64_t) n_boots) {
+                *ret = SD_ID128_NULL;
+                return false;
+        }
+
+        *ret = boots[i].boot_id;
+        return true;
+}
+
 int journal_find_log_id(
                 sd_journal *j,
                 LogIdType type,
@@ -2133,6 +2635,18 @@ int journal_find_log_id(
         assert(type == LOG_BOOT_ID || (!sd_id128_is_null(previous_id) && offset == 0) || unit);
         assert(ret);
 
+        if (type == LOG_BOOT_ID) {
+                /* Try to determine the boot from the boot ranges recorded in the journal files (and the
+                 * boot index) first, which is much cheaper than walking the journal boot by boot. */
+                sd_journal_flush_matches(j);
+
+                r = find_boot_by_summary(j, previous_id, offset, ret);
+                if (r >= 0 || r == -ENOMEM)
+                        return r;
+
+                log_debug_errno(r, "Failed to look up boot from journal file summaries, walking the journal instead: %m");
+        }
+
         /* Adjust for the asymmetry that offset 0 is the last (and current) boot or invocation, while 1 is
          * considered the (chronological) first boot or invocation in the journal. */
         advance_older = offset <= 0;
@@ -2224,6 +2738,38 @@ int journal_get_log_ids(
 
         sd_journal_flush_matches(j);
 
+        if (type == LOG_BOOT_ID) {
+                _cleanup_free_ JournalBoot *boots = NULL;
+                size_t n_boots;
+
+                /* See journal_find_log_id() */
+                r = journal_enumerate_boots(j, &boots, &n_boots);
+                if (r == -ENOMEM)
+                        return r;
+                if (r >= 0) {
+                        n_ids = MIN(n_boots, max_ids);
+                        if (n_ids > 0) {
+                                ids = new(LogId, n_ids);
+                                if (!ids)
+                                        return -ENOMEM;
+                        }
+
+                        for (size_t i = 0; i < n_ids; i++) {
+                                const JournalBoot *b = advance_older ? boots + n_boots - i - 1 : boots + i;
+
+                                ids[i] = (LogId) {
+                                        .id = b->boot_id,
+                                        .first_usec = b->first_realtime,
+                                        .last_usec = b->last_realtime,
+                                };
+                        }
+
+                        goto finish;
+                }
+
+                log_debug_errno(r, "Failed to enumerate boots from journal file summaries, walking the journal instead: %m");
+        }
+
         if (advance_older)
                 r = sd_journal_seek_tail(j); /* seek to newest */
         else
@@ -41,6 +41,16 @@ int show_journal_entry(
                 bool *ellipsized,
                 dual_timestamp *previous_display_ts,
                 sd_id128_t *previous_boot_id);
+/* Collects entries in batches for OUTPUT_EXPORT_COLUMNAR, which are written out in one go once full */
+typedef struct JournalColumnarWriter JournalColumnarWriter;
+
+int journal_columnar_writer_new(FILE *f, const Set *output_fields, JournalColumnarWriter **ret);
+JournalColumnarWriter* journal_columnar_writer_free(JournalColumnarWriter *w);
+DEFINE_TRIVIAL_CLEANUP_FUNC(JournalColumnarWriter*, journal_columnar_writer_free);
+
+int journal_columnar_writer_add(JournalColumnarWriter *w, sd_journal *j);
+int journal_columnar_writer_flush(JournalColumnarWriter *w);
+
 int show_journal(
                 FILE *f,
                 sd_journal *j,
@@ -394,6 +394,103 @@ static int loop_configure(
         return 0;
 }
 
+static bool loop_info_matches(const struct loop_info64 *info, const struct stat *st, const struct loop_config *c) {
+        assert(info);
+        assert(st);
+        assert(c);
+
+        /* LO_FLAGS_DIRECT_IO is deliberately not compared, it only changes how the backing file is accessed,
+         * not what the device shows. */
+        return info->lo_device == (uint64_t) st->st_dev &&
+                info->lo_inode == (uint64_t) st->st_ino &&
+                info->lo_offset == c->info.lo_offset &&
+                info->lo_sizelimit == c->info.lo_sizelimit &&
+                (info->lo_flags & (LO_FLAGS_READ_ONLY|LO_FLAGS_AUTOCLEAR|LO_FLAGS_PARTSCAN)) ==
+                (c->info.lo_flags & (LO_FLAGS_READ_ONLY|LO_FLAGS_AUTOCLEAR|LO_FLAGS_PARTSCAN));
+}
+
+static int loop_device_find_shared(
+                const struct stat *st,
+                const struct loop_config *c,
+                int lock_op,
+                LoopDevice **ret) {
+
+        _cleanup_(sd_device_enumerator_unrefp) sd_device_enumerator *e = NULL;
+        int r;
+
+        assert(st);
+        assert(c);
+        assert(FLAGS_SET(c->info.lo_flags, LO_FLAGS_READ_ONLY|LO_FLAGS_AUTOCLEAR));
+        assert(ret);
+
+        /* Looks for an already attached, fully initialized, read-only loopback device that covers exactly
+         * the same range of the same inode with the same sector size. If many short-lived users attach the
+         * same image at the same time, this saves them from allocating, configuring and probing a new device
+         * each, and from waiting for udev to process it. Since the device is autoclear, it goes away once the
+         * last user closes it. */
+
+        r = sd_device_enumerator_new(&e);
+        if (r < 0)
+                return r;
+
+        r = sd_device_enumerator_add_match_subsystem(e, "block", /* match = */ true);
+        if (r < 0)
+                return r;
+
+        r = sd_device_enumerator_add_match_sysname(e, "loop*");
+        if (r < 0)
+                return r;
+
+        /* Only bound whole devices have this attribute, partitions do not */
+        r = sd_device_enumerator_add_match_sysattr(e, "loop/backing_file", /* value = */ NULL, /* match = */ true);
+        if (r < 0)
+                return r;
+
+        FOREACH_DEVICE(e, dev) {
+                _cleanup_(loop_device_unrefp) LoopDevice *d = NULL;
+                struct loop_info64 info;
+                uint32_t ssz;
+
+                /* Open the device first and only then check what is attached to it: as long as we hold it
+                 * open, autoclear cannot detach it under our feet anymore. Never block on the lock, if
+                 * somebody holds it exclusively the device is not for sharing anyway. */
+                r = loop_device_open(dev, O_RDONLY, lock_op | LOCK_NB, &d);
+                if (r < 0) {
+                        log_device_debug_errno(dev, r, "Failed to open loopback device for sharing, skipping: %m");
+                        continue;
+                }
+
+                if (ioctl(d->fd, LOOP_GET_STATUS64, &info) < 0)
+                        continue;
+
+#if HAVE_VALGRIND_MEMCHECK_H
+                VALGRIND_MAKE_MEM_DEFINED(&info, sizeof(info));
+#endif
+
+                if (!loop_info_matches(&info, st, c))
+                        continue;
+
+                if (blockdev_get_sector_size(d->fd, &ssz) < 0 || ssz != c->block_size)
+                        continue;
+
+                log_device_debug(dev, "Sharing already attached loopback device %s.", d->node);
+                *ret = TAKE_PTR(d);
+                return 1;
+        }
+
+        return 0;
+}
+
+static bool loop_share_enabled(void) {
+        int r;
+
+        r = getenv_bool("SYSTEMD_LOOP_SHARE");
+        if (r < 0 && r != -ENXIO)
+                log_debug_errno(r, "Failed to parse $SYSTEMD_LOOP_SHARE, ignoring: %m");
+
+        return r > 0; /* Off by default */
+}
+
 static int loop_device_make_internal(
                 const char *path,
                 int fd,
@@ -522,6 +619,25 @@ static int loop_device_make_internal(
                 },
         };
 
+        /* Read-only devices may be shared with other users of the same image, if so requested. Take the
+         * control device lock before looking, so that concurrent users of the same image serialize on it,
+         * and all but the first one find the device the first one attached. */
+        if (FLAGS_SET(config.info.lo_flags, LO_FLAGS_READ_ONLY) &&
+            (lock_op & ~LOCK_NB) != LOCK_EX &&
+            loop_share_enabled()) {
+
+                if (flock(control, LOCK_EX) < 0)
+                        return -errno;
+
+                r = loop_device_find_shared(&st, &config, lock_op, &d);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to look for shareable loopback device, allocating a new one: %m");
+                else if (r > 0) {
+                        *ret = TAKE_PTR(d);
+                        return 0;
+                }
+        }
+
         /* Loop around LOOP_CTL_GET_FREE, since at the moment we attempt to open the returned device it might
          * be gone already, taken by somebody else racing against us. */
         for (unsigned n_attempts = 0;;) {
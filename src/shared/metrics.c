@@ -0,0 +1,176 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "json-util.h"
+#include "log.h"
+#include "logarithm.h"
+#include "metrics.h"
+#include "string-table.h"
+
+static const char* const metric_type_table[_METRIC_TYPE_MAX] = {
+        [METRIC_COUNTER]   = "counter",
+        [METRIC_GAUGE]     = "gauge",
+        [METRIC_HISTOGRAM] = "histogram",
+};
+
+DEFINE_STRING_TABLE_LOOKUP_TO_STRING(metric_type, MetricType);
+
+unsigned metric_histogram_bucket(uint64_t v) {
+        if (v == 0)
+                return 0;
+
+        return MIN((unsigned) log2u64(v) + 1, METRIC_HISTOGRAM_BUCKETS - 1);
+}
+
+void metric_histogram_observe(MetricHistogram *h, uint64_t v) {
+        assert(h);
+
+        metric_counter_inc(h->buckets + metric_histogram_bucket(v));
+        metric_counter_add(&h->sum, v);
+}
+
+int metric_append_value(
+                sd_json_variant **array,
+                const MetricFamily *f,
+                const char *field,
+                const char *field_value,
+                uint64_t value) {
+
+        assert(array);
+        assert(f);
+        assert(IN_SET(f->type, METRIC_COUNTER, METRIC_GAUGE));
+        assert(!field == !field_value);
+
+        return sd_json_variant_append_arraybo(
+                        array,
+                        SD_JSON_BUILD_PAIR_STRING("name", f->name),
+                        SD_JSON_BUILD_PAIR_STRING("type", metric_type_to_string(f->type)),
+                        SD_JSON_BUILD_PAIR_CONDITION(!!field, "fields", SD_JSON_BUILD_OBJECT(SD_JSON_BUILD_PAIR_STRING(field, field_value))),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("value", value));
+}
+
+int metric_append_buckets(
+                sd_json_variant **array,
+                const MetricFamily *f,
+                const char *field,
+                const char *field_value,
+                const uint64_t *buckets,
+                size_t n_buckets,
+                uint64_t sum) {
+
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *b = NULL;
+        int r;
+
+        assert(array);
+        assert(f);
+        assert(f->type == METRIC_HISTOGRAM);
+        assert(!field == !field_value);
+        assert(buckets);
+        assert(n_buckets > 0);
+
+        /* Pass sum as UINT64_MAX if the histogram does not track it */
+
+        FOREACH_ARRAY(i, buckets, n_buckets) {
+                r = sd_json_variant_append_arrayb(&b, SD_JSON_BUILD_UNSIGNED(*i));
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_json_variant_append_arraybo(
+                        array,
+                        SD_JSON_BUILD_PAIR_STRING("name", f->name),
+                        SD_JSON_BUILD_PAIR_STRING("type", metric_type_to_string(f->type)),
+                        SD_JSON_BUILD_PAIR_CONDITION(!!field, "fields", SD_JSON_BUILD_OBJECT(SD_JSON_BUILD_PAIR_STRING(field, field_value))),
+                        SD_JSON_BUILD_PAIR_VARIANT("buckets", b),
+                        SD_JSON_BUILD_PAIR_CONDITION(sum != UINT64_MAX, "sum", SD_JSON_BUILD_UNSIGNED(sum)));
+}
+
+int metric_append_histogram(
+                sd_json_variant **array,
+                const MetricFamily *f,
+                const char *field,
+                const char *field_value,
+                const MetricHistogram *h) {
+
+        uint64_t buckets[METRIC_HISTOGRAM_BUCKETS];
+
+        assert(h);
+
+        /* Take a copy first, so that concurrent updates don't make the JSON output inconsistent midway */
+        for (size_t i = 0; i < ELEMENTSOF(buckets); i++)
+                buckets[i] = metric_read(h->buckets + i);
+
+        return metric_append_buckets(array, f, field, field_value, buckets, ELEMENTSOF(buckets), metric_read(&h->sum));
+}
+
+int metrics_build_json(const MetricFamily families[], void *userdata, sd_json_variant **ret) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *array = NULL;
+        int r;
+
+        assert(families);
+        assert(ret);
+
+        for (const MetricFamily *f = families; f->name; f++) {
+                assert(f->generate);
+
+                r = f->generate(f, userdata, &array);
+                if (r < 0)
+                        return log_debug_errno(r, "Failed to generate metric %s: %m", f->name);
+        }
+
+        if (!array) {
+                r = sd_json_variant_new_array(&array, NULL, 0);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = TAKE_PTR(array);
+        return 0;
+}
+
+int metrics_method_list(sd_varlink *link, sd_json_variant *parameters, const MetricFamily families[], void *userdata) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r;
+
+        assert(link);
+        assert(families);
+
+        r = sd_varlink_dispatch(link, parameters, /* dispatch_table= */ NULL, /* userdata= */ NULL);
+        if (r != 0)
+                return r;
+
+        r = metrics_build_json(families, userdata, &v);
+        if (r < 0)
+                return r;
+
+        return sd_varlink_replybo(link, SD_JSON_BUILD_PAIR_VARIANT("metrics", v));
+}
+
+int metrics_method_describe(sd_varlink *link, sd_json_variant *parameters, const MetricFamily families[]) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r;
+
+        assert(link);
+        assert(families);
+
+        r = sd_varlink_dispatch(link, parameters, /* dispatch_table= */ NULL, /* userdata= */ NULL);
+        if (r != 0)
+                return r;
+
+        for (const MetricFamily *f = families; f->name; f++) {
+                r = sd_json_variant_append_arraybo(
+                                &v,
+                                SD_JSON_BUILD_PAIR_STRING("name", f->name),
+                                SD_JSON_BUILD_PAIR_STRING("type", metric_type_to_string(f->type)),
+                                SD_JSON_BUILD_PAIR_STRING("description", f->description));
+                if (r < 0)
+                        return r;
+        }
+
+        if (!v) {
+                r = sd_json_variant_new_array(&v, NULL, 0);
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_varlink_replybo(link, SD_JSON_BUILD_PAIR_VARIANT("families", v));
+}
@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "sd-json.h"
+#include "sd-varlink.h"
+
+#include "macro.h"
+
+/* Helpers for exposing performance metrics of a service via the io.systemd.Metrics Varlink interface.
+ *
+ * Each service declares a table of metric families, terminated by an empty entry. For every family a
+ * callback reads the current value(s) from wherever the service keeps them anyway, hence collecting metrics
+ * costs nothing until somebody asks for them. Counters, gauges and histograms that are new may be kept as
+ * plain uint64_t and MetricHistogram objects, which are updated with relaxed atomic operations, so that
+ * they may be bumped from worker threads too, without any locking. */
+
+typedef enum MetricType {
+        METRIC_COUNTER,
+        METRIC_GAUGE,
+        METRIC_HISTOGRAM,
+        _METRIC_TYPE_MAX,
+        _METRIC_TYPE_INVALID = -EINVAL,
+} MetricType;
+
+const char* metric_type_to_string(MetricType t) _const_;
+
+/* Bucket 0 counts values of zero, bucket i counts values in the range [2^(i-1), 2^i), the last bucket
+ * everything beyond. This is the same bucketing as used by the DNS latency histograms of resolved. */
+#define METRIC_HISTOGRAM_BUCKETS 16U
+
+typedef struct MetricHistogram {
+        uint64_t buckets[METRIC_HISTOGRAM_BUCKETS];
+        uint64_t sum;
+} MetricHistogram;
+
+unsigned metric_histogram_bucket(uint64_t v) _const_;
+void metric_histogram_observe(MetricHistogram *h, uint64_t v);
+
+static inline void metric_counter_add(uint64_t *c, uint64_t n) {
+        (void) __atomic_add_fetch(c, n, __ATOMIC_RELAXED);
+}
+
+static inline void metric_counter_inc(uint64_t *c) {
+        metric_counter_add(c, 1);
+}
+
+static inline void metric_gauge_set(uint64_t *g, uint64_t v) {
+        __atomic_store_n(g, v, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t metric_read(const uint64_t *v) {
+        return __atomic_load_n(v, __ATOMIC_RELAXED);
+}
+
+typedef struct MetricFamily MetricFamily;
+
+/* Appends the current value(s) of the family to the specified JSON array, via the metric_append_*()
+ * calls below */
+typedef int (*metric_generate_t)(const MetricFamily *f, void *userdata, sd_json_variant **array);
+
+struct MetricFamily {
+        const char *name;
+        const char *description;
+        MetricType type;
+        metric_generate_t generate;
+};
+
+int metric_append_value(
+                sd_json_variant **array,
+                const MetricFamily *f,
+                const char *field,
+                const char *field_value,
+                uint64_t value);
+int metric_append_buckets(
+                sd_json_variant **array,
+                const MetricFamily *f,
+                const char *field,
+                const char *field_value,
+                const uint64_t *buckets,
+                size_t n_buckets,
+                uint64_t sum);
+int metric_append_histogram(
+                sd_json_variant **array,
+                const MetricFamily *f,
+                const char *field,
+                const char *field_value,
+                const MetricHistogram *h);
+
+int metrics_build_json(const MetricFamily families[], void *userdata, sd_json_variant **ret);
+
+/* Implementations of io.systemd.Metrics.List() and .Describe(), to be called from a service specific
+ * method handler that passes its table of metric families */
+int metrics_method_list(sd_varlink *link, sd_json_variant *parameters, const MetricFamily families[], void *userdata);
+int metrics_method_describe(sd_varlink *link, sd_json_variant *parameters, const MetricFamily families[]);
@@ -1382,7 +1382,9 @@ int make_userns(uid_t uid_shift,
         uid_t source_base = 0;
 
         /* Allocates a userns file descriptor with the mapping we need. For this we'll fork off a child
-         * process whose only purpose is to give us a new user namespace. It's killed when we got it. */
+         * process whose only purpose is to give us a new user namespace. It's killed when we got it. The
+         * same mapping is typically needed multiple times while setting up a container (for the image
+         * itself and each bind mount), hence reuse earlier ones. */
 
         if (!userns_shift_range_valid(uid_shift, uid_range))
                 return log_debug_errno(SYNTHETIC_ERRNO(EINVAL), "Invalid UID range for user namespace.");
@@ -1446,7 +1448,7 @@ int make_userns(uid_t uid_shift,
         }
 
         /* We always assign the same UID and GID ranges */
-        userns_fd = userns_acquire(line, line);
+        userns_fd = userns_acquire_cached(line, line);
         if (userns_fd < 0)
                 return log_debug_errno(userns_fd, "Failed to acquire new userns: %m");
 
@@ -47,6 +47,19 @@ bool net_match_is_empty(const NetMatch *match) {
                 set_isempty(match->bssid);
 }
 
+static bool net_condition_pattern_matches(const char *pattern, const char *string) {
+        assert(pattern);
+        assert(string);
+
+        /* Most patterns are literal MAC addresses, driver names or paths. fnmatch() is comparatively slow,
+         * and this is evaluated for each .link/.network file and each device, hence avoid it if there's
+         * nothing to expand. Note that fnmatch() also treats backslashes specially. */
+        if (!strpbrk(pattern, "*?[\\"))
+                return streq(pattern, string);
+
+        return fnmatch(pattern, string, 0) == 0;
+}
+
 static bool net_condition_test_strv(char * const *patterns, const char *string) {
         bool match = false, has_positive_rule = false;
 
@@ -63,7 +76,7 @@ static bool net_condition_test_strv(char * const *patterns, const char *string)
                 if (!invert)
                         has_positive_rule = true;
 
-                if (string && fnmatch(q, string, 0) == 0) {
+                if (string && net_condition_pattern_matches(q, string)) {
                         if (invert)
                                 return false;
                         else
@@ -131,16 +144,10 @@ int net_match_config(
                 const char *ssid,
                 const struct ether_addr *bssid) {
 
-        _cleanup_free_ char *iftype_str = NULL;
-        const char *path = NULL;
-
         assert(match);
 
-        if (net_get_type_string(device, iftype, &iftype_str) == -ENOMEM)
-                return -ENOMEM;
-
-        if (device)
-                (void) sd_device_get_property_value(device, "ID_PATH", &path);
+        /* This is called for each device and each config file in order, until one matches. Hence check the
+         * cheap conditions first, and only look up what is needed for the others if they are used. */
 
         if (match->hw_addr && (!hw_addr || !set_contains(match->hw_addr, hw_addr)))
                 return false;
@@ -150,14 +157,28 @@ int net_match_config(
              !set_contains(match->permanent_hw_addr, permanent_hw_addr)))
                 return false;
 
-        if (!net_condition_test_strv(match->path, path))
-                return false;
-
         if (!net_condition_test_strv(match->driver, driver))
                 return false;
 
-        if (!net_condition_test_strv(match->iftype, iftype_str))
-                return false;
+        if (!strv_isempty(match->path)) {
+                const char *path = NULL;
+
+                if (device)
+                        (void) sd_device_get_property_value(device, "ID_PATH", &path);
+
+                if (!net_condition_test_strv(match->path, path))
+                        return false;
+        }
+
+        if (!strv_isempty(match->iftype)) {
+                _cleanup_free_ char *iftype_str = NULL;
+
+                if (net_get_type_string(device, iftype, &iftype_str) == -ENOMEM)
+                        return -ENOMEM;
+
+                if (!net_condition_test_strv(match->iftype, iftype_str))
+                        return false;
+        }
 
         if (!net_condition_test_strv(match->kind, kind))
                 return false;
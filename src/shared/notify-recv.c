@@ -1,44 +1,36 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include "async.h"
+#include "alloc-util.h"
+#include "errno-util.h"
 #include "fd-util.h"
+#include "iovec-util.h"
 #include "notify-recv.h"
 #include "socket-util.h"
 #include "strv.h"
 #include "user-util.h"
 
-int notify_recv_with_fds(
-                int fd,
+#define NOTIFY_CONTROL_SIZE                             \
+        (CMSG_SPACE(sizeof(struct ucred)) +             \
+         CMSG_SPACE(sizeof(int)) + /* SCM_PIDFD */      \
+         CMSG_SPACE(sizeof(int) * NOTIFY_FD_MAX))
+
+static int notify_process(
+                struct msghdr *msghdr,
+                ssize_t n,
                 char **ret_text,
                 struct ucred *ret_ucred,
                 PidRef *ret_pidref,
                 FDSet **ret_fds) {
 
-        char buf[NOTIFY_BUFFER_MAX];
-        struct iovec iovec = {
-                .iov_base = buf,
-                .iov_len = sizeof(buf),
-        };
-        CMSG_BUFFER_TYPE(CMSG_SPACE(sizeof(struct ucred)) +
-                         CMSG_SPACE(sizeof(int)) + /* SCM_PIDFD */
-                         CMSG_SPACE(sizeof(int) * NOTIFY_FD_MAX)) control;
-        struct msghdr msghdr = {
-                .msg_iov = &iovec,
-                .msg_iovlen = 1,
-                .msg_control = &control,
-                .msg_controllen = sizeof(control),
-        };
-        ssize_t n;
         int r;
 
-        assert(fd >= 0);
+        assert(msghdr);
+        assert(msghdr->msg_iovlen == 1);
 
-        /* Receives a $NOTIFY_SOCKET message (aka sd_notify()). Does various validations.
-         *
-         * Returns -EAGAIN on recoverable errors (e.g. in case an invalid message is received, following
-         * the logic that an invalid message shall be ignored, and treated like no message at all). */
+        /* Validates a received $NOTIFY_SOCKET message, and extracts the payload and ancillary data. 'n' is
+         * the return value of recvmsg_safe(), i.e. the payload size or a negative errno. */
 
-        n = recvmsg_safe(fd, &msghdr, MSG_DONTWAIT|MSG_CMSG_CLOEXEC);
         if (ERRNO_IS_NEG_TRANSIENT(n))
                 return -EAGAIN;
         if (n == -ECHRNG) {
@@ -53,13 +45,14 @@ int notify_recv_with_fds(
         if (n < 0)
                 return log_error_errno(n, "Failed to receive notification message: %m");
 
+        const char *buf = msghdr->msg_iov[0].iov_base;
         const struct ucred *ucred = NULL;
         _cleanup_close_ int pidfd = -EBADF;
         int *fd_array = NULL;
         size_t n_fds = 0;
 
         struct cmsghdr *cmsg;
-        CMSG_FOREACH(cmsg, &msghdr) {
+        CMSG_FOREACH(cmsg, msghdr) {
                 if (cmsg->cmsg_level != SOL_SOCKET)
                         continue;
 
@@ -143,6 +136,42 @@ int notify_recv_with_fds(
         return 0;
 }
 
+int notify_recv_with_fds(
+                int fd,
+                char **ret_text,
+                struct ucred *ret_ucred,
+                PidRef *ret_pidref,
+                FDSet **ret_fds) {
+
+        char buf[NOTIFY_BUFFER_MAX];
+        struct iovec iovec = {
+                .iov_base = buf,
+                .iov_len = sizeof(buf),
+        };
+        CMSG_BUFFER_TYPE(NOTIFY_CONTROL_SIZE) control;
+        struct msghdr msghdr = {
+                .msg_iov = &iovec,
+                .msg_iovlen = 1,
+                .msg_control = &control,
+                .msg_controllen = sizeof(control),
+        };
+
+        assert(fd >= 0);
+
+        /* Receives a $NOTIFY_SOCKET message (aka sd_notify()). Does various validations.
+         *
+         * Returns -EAGAIN on recoverable errors (e.g. in case an invalid message is received, following
+         * the logic that an invalid message shall be ignored, and treated like no message at all). */
+
+        return notify_process(
+                        &msghdr,
+                        recvmsg_safe(fd, &msghdr, MSG_DONTWAIT|MSG_CMSG_CLOEXEC),
+                        ret_text,
+                        ret_ucred,
+                        ret_pidref,
+                        ret_fds);
+}
+
 int notify_recv_with_fds_strv(
                 int fd,
                 char ***ret_list,
@@ -184,3 +213,143 @@ int notify_recv_with_fds_strv(
 
         return 0;
 }
+
+void notify_message_done(NotifyMessage *m) {
+        assert(m);
+
+        m->tags = strv_free(m->tags);
+        pidref_done(&m->pidref);
+        m->fds = fdset_free_async(m->fds);
+}
+
+typedef struct NotifySlot {
+        char buf[NOTIFY_BUFFER_MAX];
+        CMSG_BUFFER_TYPE(NOTIFY_CONTROL_SIZE) control;
+} NotifySlot;
+
+struct NotifyRecvBuffer {
+        size_t n_slots;
+        struct mmsghdr *msgs;
+        struct iovec *iovecs;
+        NotifySlot *slots;
+};
+
+NotifyRecvBuffer* notify_recv_buffer_free(NotifyRecvBuffer *b) {
+        if (!b)
+                return NULL;
+
+        free(b->msgs);
+        free(b->iovecs);
+        free(b->slots);
+        return mfree(b);
+}
+
+static int notify_recv_buffer_acquire(NotifyRecvBuffer **buffer, size_t n_slots) {
+        _cleanup_(notify_recv_buffer_freep) NotifyRecvBuffer *b = NULL;
+
+        assert(buffer);
+        assert(n_slots > 0);
+
+        if (*buffer && (*buffer)->n_slots >= n_slots)
+                return 0;
+
+        b = new(NotifyRecvBuffer, 1);
+        if (!b)
+                return -ENOMEM;
+
+        *b = (NotifyRecvBuffer) {
+                .n_slots = n_slots,
+                .msgs = new(struct mmsghdr, n_slots),
+                .iovecs = new(struct iovec, n_slots),
+                .slots = new(NotifySlot, n_slots),
+        };
+        if (!b->msgs || !b->iovecs || !b->slots)
+                return -ENOMEM;
+
+        notify_recv_buffer_free(*buffer);
+        *buffer = TAKE_PTR(b);
+        return 0;
+}
+
+int notify_recv_many_with_fds_strv(int fd, NotifyRecvBuffer **buffer, NotifyMessage *messages, size_t n_messages) {
+        struct mmsghdr *msgs;
+        size_t n_valid = 0;
+        int n, r;
+
+        assert(fd >= 0);
+        assert(buffer);
+        assert(messages);
+        assert(n_messages > 0);
+        assert(n_messages <= INT_MAX);
+
+        /* Like notify_recv_with_fds_strv(), but receives up to the specified number of queued messages with
+         * a single recvmmsg() call, so that a busy notification socket doesn't cost a wakeup and a syscall
+         * per message. Invalid messages are skipped. Returns the number of messages stored in the array,
+         * which need to be released with notify_message_done() afterwards, and -EAGAIN if there was nothing
+         * to receive. The receive buffer is allocated on first use, and should be kept by the caller and
+         * passed in again on the next call, so that it is reused. */
+
+        r = notify_recv_buffer_acquire(buffer, n_messages);
+        if (r < 0)
+                return log_oom_warning();
+
+        msgs = (*buffer)->msgs;
+        for (size_t i = 0; i < n_messages; i++) {
+                NotifySlot *slot = (*buffer)->slots + i;
+
+                (*buffer)->iovecs[i] = IOVEC_MAKE(slot->buf, sizeof(slot->buf));
+
+                /* The msghdr fields are updated by the kernel on each call, hence reinitialize them */
+                msgs[i] = (struct mmsghdr) {
+                        .msg_hdr = {
+                                .msg_iov = (*buffer)->iovecs + i,
+                                .msg_iovlen = 1,
+                                .msg_control = &slot->control,
+                                .msg_controllen = sizeof(slot->control),
+                        },
+                };
+        }
+
+        n = recvmmsg(fd, msgs, n_messages, MSG_DONTWAIT|MSG_CMSG_CLOEXEC, /* timeout= */ NULL);
+        if (n < 0) {
+                if (ERRNO_IS_TRANSIENT(errno))
+                        return -EAGAIN;
+
+                return log_error_errno(errno, "Failed to receive notification messages: %m");
+        }
+        if (n == 0)
+                return -EAGAIN;
+
+        for (int i = 0; i < n; i++) {
+                struct msghdr *mh = &msgs[i].msg_hdr;
+                _cleanup_free_ char *text = NULL;
+                NotifyMessage *m = messages + n_valid;
+                ssize_t k = msgs[i].msg_len;
+
+                /* Same as recvmsg_safe() */
+                if (FLAGS_SET(mh->msg_flags, MSG_CTRUNC) || FLAGS_SET(mh->msg_flags, MSG_TRUNC)) {
+                        cmsg_close_all(mh);
+                        k = FLAGS_SET(mh->msg_flags, MSG_CTRUNC) ? -ECHRNG : -EXFULL;
+                }
+
+                *m = (NotifyMessage) {
+                        .ucred = UCRED_INVALID,
+                        .pidref = PIDREF_NULL,
+                };
+
+                r = notify_process(mh, k, &text, &m->ucred, &m->pidref, &m->fds);
+                if (r < 0)
+                        continue;
+
+                m->tags = strv_split_newlines(text);
+                if (!m->tags) {
+                        log_oom_warning();
+                        notify_message_done(m);
+                        continue;
+                }
+
+                n_valid++;
+        }
+
+        return (int) n_valid;
+}
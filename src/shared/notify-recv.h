@@ -27,3 +27,19 @@ int notify_recv_with_fds_strv(
 static inline int notify_recv_strv(int fd, char ***ret_list, struct ucred *ret_ucred, PidRef *ret_pidref) {
         return notify_recv_with_fds_strv(fd, ret_list, ret_ucred, ret_pidref, NULL);
 }
+
+typedef struct NotifyMessage {
+        char **tags;
+        struct ucred ucred;
+        PidRef pidref;
+        FDSet *fds;
+} NotifyMessage;
+
+void notify_message_done(NotifyMessage *m);
+
+typedef struct NotifyRecvBuffer NotifyRecvBuffer;
+
+NotifyRecvBuffer* notify_recv_buffer_free(NotifyRecvBuffer *b);
+DEFINE_TRIVIAL_CLEANUP_FUNC(NotifyRecvBuffer*, notify_recv_buffer_free);
+
+int notify_recv_many_with_fds_strv(int fd, NotifyRecvBuffer **buffer, NotifyMessage *messages, size_t n_messages);
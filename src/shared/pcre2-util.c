@@ -2,6 +2,7 @@
 
 #include "dlfcn-util.h"
 #include "log.h"
+#include "missing_threads.h"
 #include "pcre2-util.h"
 
 #if HAVE_PCRE2
@@ -14,6 +15,12 @@ DLSYM_PROTOTYPE(pcre2_compile) = NULL;
 DLSYM_PROTOTYPE(pcre2_get_error_message) = NULL;
 DLSYM_PROTOTYPE(pcre2_match) = NULL;
 DLSYM_PROTOTYPE(pcre2_get_ovector_pointer) = NULL;
+DLSYM_PROTOTYPE(pcre2_jit_compile) = NULL;
+
+/* A single ovector pair is all we ever look at, hence a match data block of that size can be shared by all
+ * patterns. Keep one around per thread, so that matching a pattern against many messages in a row (as
+ * journalctl --grep does) doesn't have to allocate and free one for every message. */
+static thread_local pcre2_match_data *cached_match_data = NULL;
 
 DEFINE_HASH_OPS_WITH_KEY_DESTRUCTOR(
         pcre2_code_hash_ops_free,
@@ -48,7 +55,8 @@ int dlopen_pcre2(void) {
                         DLSYM_ARG(pcre2_compile),
                         DLSYM_ARG(pcre2_get_error_message),
                         DLSYM_ARG(pcre2_match),
-                        DLSYM_ARG(pcre2_get_ovector_pointer));
+                        DLSYM_ARG(pcre2_get_ovector_pointer),
+                        DLSYM_ARG(pcre2_jit_compile));
 #else
         return log_error_errno(SYNTHETIC_ERRNO(EOPNOTSUPP), "PCRE2 support is not compiled in.");
 #endif
@@ -104,6 +112,14 @@ int pattern_compile_and_log(const char *pattern, PatternCompileCase case_, pcre2
                                        r < 0 ? "unknown error" : (char *)buf);
         }
 
+        /* Translate the pattern into native code, which speeds up matching considerably. This is merely
+         * an optimization: PCRE2 might be built without JIT support, or we might not be allowed to map
+         * executable memory (e.g. with MemoryDenyWriteExecute=yes), in which case pcre2_match() simply
+         * falls back to the interpreter. */
+        r = sym_pcre2_jit_compile(p, PCRE2_JIT_COMPLETE);
+        if (r < 0)
+                log_debug("Failed to JIT compile pattern \"%s\", using interpreter: %i", pattern, r);
+
         if (ret)
                 *ret = TAKE_PTR(p);
 
@@ -115,7 +131,6 @@ int pattern_compile_and_log(const char *pattern, PatternCompileCase case_, pcre2
 
 int pattern_matches_and_log(pcre2_code *compiled_pattern, const char *message, size_t size, size_t *ret_ovec) {
 #if HAVE_PCRE2
-        _cleanup_(sym_pcre2_match_data_freep) pcre2_match_data *md = NULL;
         int r;
 
         assert(compiled_pattern);
@@ -124,16 +139,18 @@ int pattern_matches_and_log(pcre2_code *compiled_pattern, const char *message, s
          * dlopens pcre2 so we can assert on it being available here. */
         assert(pcre2_dl);
 
-        md = sym_pcre2_match_data_create(1, NULL);
-        if (!md)
-                return log_oom();
+        if (!cached_match_data) {
+                cached_match_data = sym_pcre2_match_data_create(1, NULL);
+                if (!cached_match_data)
+                        return log_oom();
+        }
 
         r = sym_pcre2_match(compiled_pattern,
                             (const unsigned char *)message,
                             size,
                             0,      /* start at offset 0 in the subject */
                             0,      /* default options */
-                            md,
+                            cached_match_data,
                             NULL);
         if (r == PCRE2_ERROR_NOMATCH)
                 return false;
@@ -146,8 +163,8 @@ int pattern_matches_and_log(pcre2_code *compiled_pattern, const char *message, s
         }
 
         if (ret_ovec) {
-                ret_ovec[0] = sym_pcre2_get_ovector_pointer(md)[0];
-                ret_ovec[1] = sym_pcre2_get_ovector_pointer(md)[1];
+                ret_ovec[0] = sym_pcre2_get_ovector_pointer(cached_match_data)[0];
+                ret_ovec[1] = sym_pcre2_get_ovector_pointer(cached_match_data)[1];
         }
 
         return true;
@@ -163,6 +180,10 @@ void *pattern_free(pcre2_code *p) {
 
         assert(pcre2_dl);
         sym_pcre2_code_free(p);
+
+        /* The match data is not tied to any specific pattern, but let's not keep it around longer than
+         * necessary. The next match will allocate a new one if needed. */
+        sym_pcre2_match_data_freep(&cached_match_data);
         return NULL;
 #else
         assert(p == NULL);
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include "conf-parser.h"
+#include "logarithm.h"
 #include "resolve-util.h"
 #include "string-table.h"
 
@@ -50,3 +51,21 @@ static const char* const dns_cache_mode_table[_DNS_CACHE_MODE_MAX] = {
         [DNS_CACHE_MODE_NO_NEGATIVE] = "no-negative",
 };
 DEFINE_STRING_TABLE_LOOKUP_WITH_BOOLEAN(dns_cache_mode, DnsCacheMode, DNS_CACHE_MODE_YES);
+
+unsigned dns_latency_bucket(usec_t latency) {
+        uint64_t msec = latency / USEC_PER_MSEC;
+
+        if (msec == 0)
+                return 0;
+
+        return MIN((unsigned) log2u64(msec) + 1, DNS_LATENCY_BUCKETS - 1);
+}
+
+usec_t dns_latency_bucket_max(unsigned bucket) {
+        /* Returns the (exclusive) upper bound of the specified bucket */
+
+        if (bucket >= DNS_LATENCY_BUCKETS - 1)
+                return USEC_INFINITY;
+
+        return (UINT64_C(1) << bucket) * USEC_PER_MSEC;
+}
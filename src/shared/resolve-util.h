@@ -4,6 +4,7 @@
 #include "conf-parser.h"
 #include "in-addr-util.h"
 #include "macro.h"
+#include "time-util.h"
 
 /* 127.0.0.53 in native endian (The IP address we listen on with the full DNS stub, i.e. that does LLMNR/mDNS, and stuff) */
 #define INADDR_DNS_STUB ((in_addr_t) 0x7f000035U)
@@ -89,6 +90,13 @@ bool dns_server_address_valid(int family, const union in_addr_union *sa);
 const char* dns_cache_mode_to_string(DnsCacheMode p) _const_;
 DnsCacheMode dns_cache_mode_from_string(const char *s) _pure_;
 
+/* Latency histograms use log2-scale buckets: the first one counts replies that took less than 1ms, bucket n
+ * those that took between 2^(n-1)ms and 2^n ms, and the last one everything slower. */
+#define DNS_LATENCY_BUCKETS 16U
+
+unsigned dns_latency_bucket(usec_t latency) _const_;
+usec_t dns_latency_bucket_max(unsigned bucket) _const_;
+
 /* A resolv.conf file containing the DNS server and domain data we learnt from uplink, i.e. the full uplink data */
 #define PRIVATE_UPLINK_RESOLV_CONF "/run/systemd/resolve/resolv.conf"
 
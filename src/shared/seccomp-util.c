@@ -2,6 +2,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/filter.h>
 #include <linux/seccomp.h>
 #include <stddef.h>
 #include <sys/mman.h>
@@ -17,15 +18,24 @@
 #include "alloc-util.h"
 #include "env-util.h"
 #include "errno-list.h"
+#include "fd-util.h"
+#include "fileio.h"
+#include "fs-util.h"
+#include "hexdecoct.h"
+#include "iovec-util.h"
 #include "macro.h"
+#include "mkdir.h"
 #include "namespace-util.h"
 #include "nsflags.h"
 #include "nulstr-util.h"
 #include "process-util.h"
 #include "seccomp-util.h"
 #include "set.h"
+#include "sha256.h"
+#include "sort-util.h"
 #include "string-util.h"
 #include "strv.h"
+#include "tmpfile-util.h"
 
 /* This array will be modified at runtime as seccomp_restrict_archs is called. */
 uint32_t seccomp_local_archs[] = {
@@ -1170,84 +1180,292 @@ int seccomp_load_syscall_filter_set(uint32_t default_action, const SyscallFilter
         return 0;
 }
 
-int seccomp_load_syscall_filter_set_raw(uint32_t default_action, Hashmap* filter, uint32_t action, bool log_missing) {
-        uint32_t arch, default_action_override;
+static int seccomp_build_syscall_filter_set_raw(
+                uint32_t arch,
+                uint32_t default_action,
+                Hashmap* filter,
+                uint32_t action,
+                bool log_missing,
+                scmp_filter_ctx *ret) {
+
+        _cleanup_(seccomp_releasep) scmp_filter_ctx seccomp = NULL;
+        uint32_t default_action_override;
+        void *syscall_id, *val;
         int r;
 
-        /* Similar to seccomp_load_syscall_filter_set(), but takes a raw Hashmap* of syscalls, instead
-         * of a SyscallFilterSet* table. */
+        assert(ret);
 
-        if (hashmap_isempty(filter) && default_action == SCMP_ACT_ALLOW)
-                return 0;
+        log_trace("Operating on architecture: %s", seccomp_arch_to_string(arch));
 
         default_action_override = override_default_action(default_action);
 
-        SECCOMP_FOREACH_LOCAL_ARCH(arch) {
-                _cleanup_(seccomp_releasep) scmp_filter_ctx seccomp = NULL;
-                void *syscall_id, *val;
-
-                log_trace("Operating on architecture: %s", seccomp_arch_to_string(arch));
-
-                r = seccomp_init_for_arch(&seccomp, arch, default_action_override);
-                if (r < 0)
-                        return r;
+        r = seccomp_init_for_arch(&seccomp, arch, default_action_override);
+        if (r < 0)
+                return r;
 
-                HASHMAP_FOREACH_KEY(val, syscall_id, filter) {
-                        uint32_t a = action;
-                        int id = PTR_TO_INT(syscall_id) - 1;
-                        int error = PTR_TO_INT(val);
+        HASHMAP_FOREACH_KEY(val, syscall_id, filter) {
+                uint32_t a = action;
+                int id = PTR_TO_INT(syscall_id) - 1;
+                int error = PTR_TO_INT(val);
 
-                        if (error == SECCOMP_ERROR_NUMBER_KILL)
-                                a = scmp_act_kill_process();
+                if (error == SECCOMP_ERROR_NUMBER_KILL)
+                        a = scmp_act_kill_process();
 #ifdef SCMP_ACT_LOG
-                        else if (action == SCMP_ACT_LOG)
-                                a = SCMP_ACT_LOG;
+                else if (action == SCMP_ACT_LOG)
+                        a = SCMP_ACT_LOG;
 #endif
-                        else if (error >= 0)
-                                a = SCMP_ACT_ERRNO(error);
+                else if (error >= 0)
+                        a = SCMP_ACT_ERRNO(error);
 
-                        r = seccomp_rule_add_exact(seccomp, a, id, 0);
-                        if (r < 0) {
-                                /* If the system call is not known on this architecture, then that's
-                                 * fine, let's ignore it */
-                                _cleanup_free_ char *n = NULL;
-                                bool ignore;
-
-                                n = seccomp_syscall_resolve_num_arch(SCMP_ARCH_NATIVE, id);
-                                ignore = r == -EDOM;
-                                if (!ignore || log_missing)
-                                        log_debug_errno(r, "Failed to add rule for system call %s() / %d%s: %m",
-                                                        strna(n), id, ignore ? ", ignoring" : "");
-                                if (!ignore)
-                                        return r;
-                        }
+                r = seccomp_rule_add_exact(seccomp, a, id, 0);
+                if (r < 0) {
+                        /* If the system call is not known on this architecture, then that's
+                         * fine, let's ignore it */
+                        _cleanup_free_ char *n = NULL;
+                        bool ignore;
+
+                        n = seccomp_syscall_resolve_num_arch(SCMP_ARCH_NATIVE, id);
+                        ignore = r == -EDOM;
+                        if (!ignore || log_missing)
+                                log_debug_errno(r, "Failed to add rule for system call %s() / %d%s: %m",
+                                                strna(n), id, ignore ? ", ignoring" : "");
+                        if (!ignore)
+                                return r;
                 }
+        }
 
-                if (default_action != default_action_override)
-                        NULSTR_FOREACH(name, syscall_filter_sets[SYSCALL_FILTER_SET_KNOWN].value) {
-                                int id;
+        if (default_action != default_action_override)
+                NULSTR_FOREACH(name, syscall_filter_sets[SYSCALL_FILTER_SET_KNOWN].value) {
+                        int id;
 
-                                id = seccomp_syscall_resolve_name(name);
-                                if (id < 0)
-                                        continue;
+                        id = seccomp_syscall_resolve_name(name);
+                        if (id < 0)
+                                continue;
 
-                                /* Ignore the syscall if it was already handled above */
-                                if (hashmap_contains(filter, INT_TO_PTR(id + 1)))
-                                        continue;
+                        /* Ignore the syscall if it was already handled above */
+                        if (hashmap_contains(filter, INT_TO_PTR(id + 1)))
+                                continue;
 
-                                r = seccomp_rule_add_exact(seccomp, default_action, id, 0);
-                                if (r < 0 && r != -EDOM)  /* EDOM means that the syscall is not available for arch */
-                                        return log_debug_errno(r, "Failed to add rule for system call %s() / %d: %m",
-                                                               name, id);
-                        }
+                        r = seccomp_rule_add_exact(seccomp, default_action, id, 0);
+                        if (r < 0 && r != -EDOM)  /* EDOM means that the syscall is not available for arch */
+                                return log_debug_errno(r, "Failed to add rule for system call %s() / %d: %m",
+                                                       name, id);
+                }
 
 #if (SCMP_VER_MAJOR == 2 && SCMP_VER_MINOR >= 5) || SCMP_VER_MAJOR > 2
-                /* We have a large filter here, so let's turn on the binary tree mode if possible. */
-                r = seccomp_attr_set(seccomp, SCMP_FLTATR_CTL_OPTIMIZE, 2);
-                if (r < 0)
-                        log_warning_errno(r, "Failed to set SCMP_FLTATR_CTL_OPTIMIZE, ignoring: %m");
+        /* We have a large filter here, so let's turn on the binary tree mode if possible. */
+        r = seccomp_attr_set(seccomp, SCMP_FLTATR_CTL_OPTIMIZE, 2);
+        if (r < 0)
+                log_warning_errno(r, "Failed to set SCMP_FLTATR_CTL_OPTIMIZE, ignoring: %m");
 #endif
 
+        *ret = TAKE_PTR(seccomp);
+        return 0;
+}
+
+typedef struct SyscallFilterEntry {
+        int id;
+        int error;
+} SyscallFilterEntry;
+
+static int syscall_filter_entry_compare(const SyscallFilterEntry *a, const SyscallFilterEntry *b) {
+        return CMP(a->id, b->id);
+}
+
+static int seccomp_syscall_filter_cache_path(
+                const char *cache_dir,
+                uint32_t arch,
+                uint32_t default_action,
+                Hashmap* filter,
+                uint32_t action,
+                char **ret) {
+
+        _cleanup_free_ SyscallFilterEntry *entries = NULL;
+        _cleanup_free_ char *hex = NULL;
+        const struct scmp_version *v;
+        uint8_t h[SHA256_DIGEST_SIZE];
+        struct sha256_ctx ctx;
+        void *syscall_id, *val;
+        size_t n = 0;
+        char *p;
+
+        assert(cache_dir);
+        assert(ret);
+
+        /* Derives the name of the cache file for a filter from everything that goes into it: the
+         * parameters, the system call list of the libseccomp version we use, and our own idea which system
+         * calls are known. */
+
+        entries = new(SyscallFilterEntry, hashmap_size(filter));
+        if (!entries)
+                return -ENOMEM;
+
+        HASHMAP_FOREACH_KEY(val, syscall_id, filter)
+                entries[n++] = (SyscallFilterEntry) {
+                        .id = PTR_TO_INT(syscall_id) - 1,
+                        .error = PTR_TO_INT(val),
+                };
+
+        typesafe_qsort(entries, n, syscall_filter_entry_compare);
+
+        v = seccomp_version();
+        if (!v)
+                return -EOPNOTSUPP;
+
+        sha256_init_ctx(&ctx);
+        sha256_process_bytes(v, sizeof(*v), &ctx);
+        sha256_process_bytes(&arch, sizeof(arch), &ctx);
+        sha256_process_bytes(&default_action, sizeof(default_action), &ctx);
+        sha256_process_bytes(&action, sizeof(action), &ctx);
+        sha256_process_bytes_and_size(entries, n * sizeof(SyscallFilterEntry), &ctx);
+        NULSTR_FOREACH(name, syscall_filter_sets[SYSCALL_FILTER_SET_KNOWN].value)
+                sha256_process_bytes(name, strlen(name) + 1, &ctx);
+        sha256_finish_ctx(&ctx, h);
+
+        hex = hexmem(h, sizeof(h));
+        if (!hex)
+                return -ENOMEM;
+
+        p = strjoin(cache_dir, "/", hex, ".bpf");
+        if (!p)
+                return -ENOMEM;
+
+        *ret = p;
+        return 0;
+}
+
+static int seccomp_syscall_filter_read_cached(const char *path, struct iovec *ret) {
+        _cleanup_free_ char *data = NULL;
+        size_t size;
+        int r;
+
+        assert(path);
+        assert(ret);
+
+        r = read_full_file_full(
+                        AT_FDCWD,
+                        path,
+                        /* offset= */ UINT64_MAX,
+                        BPF_MAXINSNS * sizeof(struct sock_filter),
+                        READ_FULL_FILE_FAIL_WHEN_LARGER,
+                        /* bind_name= */ NULL,
+                        &data,
+                        &size);
+        if (r < 0)
+                return r;
+        if (size == 0 || size % sizeof(struct sock_filter) != 0)
+                return -EBADMSG;
+
+        *ret = IOVEC_MAKE(TAKE_PTR(data), size);
+        return 0;
+}
+
+static int seccomp_syscall_filter_store_cached(const char *path, scmp_filter_ctx seccomp) {
+        _cleanup_(unlink_and_freep) char *t = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        int r;
+
+        assert(path);
+        assert(seccomp);
+
+        fd = open_tmpfile_linkable(path, O_WRONLY|O_CLOEXEC, &t);
+        if (fd < 0)
+                return fd;
+
+        r = seccomp_export_bpf(seccomp, fd);
+        if (r < 0)
+                return r;
+
+        if (fchmod(fd, 0644) < 0)
+                return -errno;
+
+        r = link_tmpfile(fd, t, path, LINK_TMPFILE_REPLACE);
+        if (r < 0)
+                return r;
+
+        t = mfree(t);
+        return 0;
+}
+
+static int seccomp_program_load(const SeccompProgram *program) {
+        assert(program);
+        assert(iovec_is_set(&program->bpf));
+
+        /* This is what seccomp_load() does too, given that we turned off the NNP fiddling */
+        struct sock_fprog prog = {
+                .len = program->bpf.iov_len / sizeof(struct sock_filter),
+                .filter = program->bpf.iov_base,
+        };
+
+        if (prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog, 0, 0) < 0)
+                return -errno;
+
+        return 0;
+}
+
+void seccomp_program_set_done(SeccompProgramSet *s) {
+        assert(s);
+
+        FOREACH_ARRAY(i, s->programs, s->n_programs)
+                iovec_done(&i->bpf);
+
+        s->programs = mfree(s->programs);
+        s->n_programs = 0;
+}
+
+static const SeccompProgram* seccomp_program_set_find(const SeccompProgramSet *s, uint32_t arch) {
+        if (!s)
+                return NULL;
+
+        FOREACH_ARRAY(i, s->programs, s->n_programs)
+                if (i->arch == arch)
+                        return i;
+
+        return NULL;
+}
+
+int seccomp_load_syscall_filter_set_raw_full(
+                uint32_t default_action,
+                Hashmap* filter,
+                uint32_t action,
+                bool log_missing,
+                const SeccompProgramSet *prepared) {
+
+        uint32_t arch;
+        int r;
+
+        /* Similar to seccomp_load_syscall_filter_set(), but takes a raw Hashmap* of syscalls, instead
+         * of a SyscallFilterSet* table. If filters have been compiled already with
+         * seccomp_prepare_syscall_filter_set_raw() for the same parameters, they are installed from memory,
+         * and only the architectures missing there are compiled here. */
+
+        if (hashmap_isempty(filter) && default_action == SCMP_ACT_ALLOW)
+                return 0;
+
+        /* libseccomp passes the logging flag to the kernel only when loading the filter itself */
+        if (getenv_bool("SYSTEMD_LOG_SECCOMP") > 0)
+                prepared = NULL;
+
+        SECCOMP_FOREACH_LOCAL_ARCH(arch) {
+                _cleanup_(seccomp_releasep) scmp_filter_ctx seccomp = NULL;
+                const SeccompProgram *program;
+
+                program = seccomp_program_set_find(prepared, arch);
+                if (program) {
+                        r = seccomp_program_load(program);
+                        if (r >= 0)
+                                continue;
+                        if (ERRNO_IS_NEG_SECCOMP_FATAL(r))
+                                return r;
+
+                        log_debug_errno(r, "Failed to install precompiled system call filter for architecture %s, compiling it again: %m",
+                                        seccomp_arch_to_string(arch));
+                }
+
+                r = seccomp_build_syscall_filter_set_raw(arch, default_action, filter, action, log_missing, &seccomp);
+                if (r < 0)
+                        return r;
+
                 r = seccomp_load(seccomp);
                 if (ERRNO_IS_NEG_SECCOMP_FATAL(r))
                         return r;
@@ -1259,6 +1477,78 @@ int seccomp_load_syscall_filter_set_raw(uint32_t default_action, Hashmap* filter
         return 0;
 }
 
+int seccomp_prepare_syscall_filter_set_raw(
+                uint32_t default_action,
+                Hashmap* filter,
+                uint32_t action,
+                const char *cache_dir,
+                SeccompProgramSet *ret) {
+
+        _cleanup_(seccomp_program_set_done) SeccompProgramSet s = {};
+        uint32_t arch;
+        int r;
+
+        assert(cache_dir);
+        assert(ret);
+
+        /* Compiles the filters seccomp_load_syscall_filter_set_raw_full() would install for all local
+         * architectures, and places them in the cache directory, unless they are already there. The
+         * compiled programs are then read into memory, so that they can be installed later on without
+         * accessing the cache directory again, i.e. after the root directory was switched or privileges
+         * were dropped. */
+
+        *ret = (SeccompProgramSet) {};
+
+        if (hashmap_isempty(filter) && default_action == SCMP_ACT_ALLOW)
+                return 0;
+
+        if (getenv_bool("SYSTEMD_LOG_SECCOMP") > 0)
+                return 0;
+
+        r = mkdir_p(cache_dir, 0755);
+        if (r < 0)
+                return r;
+
+        SECCOMP_FOREACH_LOCAL_ARCH(arch) {
+                _cleanup_(seccomp_releasep) scmp_filter_ctx seccomp = NULL;
+                _cleanup_(iovec_done) struct iovec bpf = {};
+                _cleanup_free_ char *path = NULL;
+
+                r = seccomp_syscall_filter_cache_path(cache_dir, arch, default_action, filter, action, &path);
+                if (r < 0)
+                        return r;
+
+                r = seccomp_syscall_filter_read_cached(path, &bpf);
+                if (r < 0) {
+                        if (r != -ENOENT)
+                                log_debug_errno(r, "Failed to read cached system call filter %s, compiling it again: %m", path);
+
+                        r = seccomp_build_syscall_filter_set_raw(arch, default_action, filter, action, /* log_missing= */ false, &seccomp);
+                        if (r < 0)
+                                return r;
+
+                        r = seccomp_syscall_filter_store_cached(path, seccomp);
+                        if (r < 0)
+                                return r;
+
+                        r = seccomp_syscall_filter_read_cached(path, &bpf);
+                        if (r < 0)
+                                return r;
+                }
+
+                if (!GREEDY_REALLOC(s.programs, s.n_programs + 1))
+                        return -ENOMEM;
+
+                s.programs[s.n_programs++] = (SeccompProgram) {
+                        .arch = arch,
+                        .bpf = TAKE_STRUCT(bpf),
+                };
+        }
+
+        *ret = TAKE_STRUCT(s);
+        return 0;
+}
+
 int seccomp_parse_syscall_filter(
                 const char *name,
                 int errno_num,
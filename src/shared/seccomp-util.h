@@ -6,6 +6,7 @@
 #endif
 #include <stdbool.h>
 #include <stdint.h>
+#include <sys/uio.h>
 
 #include "errno-list.h"
 #include "errno-util.h"
@@ -82,7 +83,24 @@ int seccomp_add_syscall_filter_item(
                 char ***added);
 
 int seccomp_load_syscall_filter_set(uint32_t default_action, const SyscallFilterSet *set, uint32_t action, bool log_missing);
-int seccomp_load_syscall_filter_set_raw(uint32_t default_action, Hashmap* set, uint32_t action, bool log_missing);
+/* A compiled BPF program for one architecture, as generated by libseccomp */
+typedef struct SeccompProgram {
+        uint32_t arch;
+        struct iovec bpf;
+} SeccompProgram;
+
+typedef struct SeccompProgramSet {
+        SeccompProgram *programs;
+        size_t n_programs;
+} SeccompProgramSet;
+
+void seccomp_program_set_done(SeccompProgramSet *s);
+
+int seccomp_load_syscall_filter_set_raw_full(uint32_t default_action, Hashmap* set, uint32_t action, bool log_missing, const SeccompProgramSet *prepared);
+static inline int seccomp_load_syscall_filter_set_raw(uint32_t default_action, Hashmap* set, uint32_t action, bool log_missing) {
+        return seccomp_load_syscall_filter_set_raw_full(default_action, set, action, log_missing, /* prepared= */ NULL);
+}
+int seccomp_prepare_syscall_filter_set_raw(uint32_t default_action, Hashmap* set, uint32_t action, const char *cache_dir, SeccompProgramSet *ret);
 
 typedef enum SeccompParseFlags {
         SECCOMP_PARSE_INVERT     = 1 << 0,
@@ -324,12 +324,15 @@ int serialize_image_policy(FILE *f, const char *key, const ImagePolicy *p) {
 
 int deserialize_read_line(FILE *f, char **ret) {
         _cleanup_free_ char *line = NULL;
+        char *p;
         int r;
 
         assert(f);
         assert(ret);
 
-        r = read_stripped_line(f, LONG_LINE_MAX, &line);
+        /* Serialization never comes from a TTY, hence tell read_line_full() so, which otherwise checks that
+         * for every single line. With hundreds of thousands of lines on reexecution this adds up. */
+        r = read_line_full(f, LONG_LINE_MAX, READ_LINE_NOT_A_TTY, &line);
         if (r < 0)
                 return log_error_errno(r, "Failed to read serialization line: %m");
         if (r == 0) { /* eof */
@@ -337,11 +340,16 @@ int deserialize_read_line(FILE *f, char **ret) {
                 return 0;
         }
 
-        if (isempty(line)) { /* End marker */
+        /* Strip in place, rather than duplicating the line */
+        p = strstrip(line);
+        if (isempty(p)) { /* End marker */
                 *ret = NULL;
                 return 0;
         }
 
+        if (p != line)
+                memmove(line, p, strlen(p) + 1);
+
         *ret = TAKE_PTR(line);
         return 1;
 }
@@ -573,6 +581,7 @@ int open_serialization_fd(const char *ident) {
 int open_serialization_file(const char *ident, FILE **ret) {
         _cleanup_fclose_ FILE *f = NULL;
         _cleanup_close_ int fd;
+        int r;
 
         assert(ret);
 
@@ -580,9 +589,11 @@ int open_serialization_file(const char *ident, FILE **ret) {
         if (fd < 0)
                 return fd;
 
-        f = take_fdopen(&fd, "w+");
-        if (!f)
-                return -errno;
+        /* Serialization files are only ever accessed by a single thread, hence turn off stdio's locking,
+         * which otherwise is taken for every single item written and character read */
+        r = take_fdopen_unlocked(&fd, "w+", &f);
+        if (r < 0)
+                return r;
 
         *ret = TAKE_PTR(f);
         return 0;
@@ -2741,6 +2741,10 @@ int tpm2_pcr_read_missing_values(Tpm2Context *c, Tpm2PCRValue *pcr_values, size_
                 }
         }
 
+        /* Collect all missing values first, and read them in one go: the TPM returns up to 8 values per
+         * PCR_Read command (across all banks), and each command is a round trip that is quite slow on some
+         * (firmware) TPMs. */
+        TPML_PCR_SELECTION selection = {};
         FOREACH_ARRAY(v, pcr_values, n_pcr_values) {
                 if (v->hash == 0)
                         v->hash = pcr_bank;
@@ -2748,27 +2752,30 @@ int tpm2_pcr_read_missing_values(Tpm2Context *c, Tpm2PCRValue *pcr_values, size_
                 if (v->value.size > 0)
                         continue;
 
-                TPML_PCR_SELECTION selection;
-                r = tpm2_tpml_pcr_selection_from_pcr_values(v, 1, &selection, NULL, NULL);
-                if (r < 0)
-                        return r;
+                tpm2_tpml_pcr_selection_add_mask(&selection, v->hash, INDEX_TO_MASK(uint32_t, v->index));
+        }
 
-                _cleanup_free_ Tpm2PCRValue *read_values = NULL;
-                size_t n_read_values;
-                r = tpm2_pcr_read(c, &selection, &read_values, &n_read_values);
-                if (r < 0)
-                        return r;
+        if (tpm2_tpml_pcr_selection_is_empty(&selection))
+                return 0;
 
-                if (n_read_values == 0)
+        _cleanup_free_ Tpm2PCRValue *read_values = NULL;
+        size_t n_read_values;
+        r = tpm2_pcr_read(c, &selection, &read_values, &n_read_values);
+        if (r < 0)
+                return r;
+
+        /* tpm2_pcr_read() returns the values sorted, hence we can bisect */
+        FOREACH_ARRAY(v, pcr_values, n_pcr_values) {
+                if (v->value.size > 0)
+                        continue;
+
+                const Tpm2PCRValue *found = typesafe_bsearch(v, read_values, n_read_values, cmp_pcr_values);
+                if (!found)
                         return log_debug_errno(SYNTHETIC_ERRNO(ENOTRECOVERABLE),
                                                "Could not read PCR hash 0x%" PRIu16 " index %u",
                                                v->hash, v->index);
 
-                assert(n_read_values == 1);
-                assert(read_values[0].hash == v->hash);
-                assert(read_values[0].index == v->index);
-
-                v->value = read_values[0].value;
+                v->value = found->value;
         }
 
         return 0;
@@ -5738,37 +5745,45 @@ int tpm2_unseal(Tpm2Context *c,
                         return log_debug_errno(r, "Could not get key fingerprint: %m");
         }
 
+        /* Unmarshalling and importing the sealed objects does not depend on the PCR state, hence do it once
+         * here, rather than again for each retry below. Importing involves an asymmetric decryption on the
+         * TPM, which is one of the slowest operations on some (firmware) TPMs. Note that we don't keep the
+         * objects loaded across retries though, as TPMs typically only have very few transient object
+         * slots, and building the policy might need one too. */
+        assert(n_blobs <= 2);
+        TPM2B_PUBLIC publics[2];
+        TPM2B_PRIVATE privates[2];
+        for (size_t shard = 0; shard < n_blobs; shard++) {
+                TPM2B_ENCRYPTED_SECRET seed = {};
+                r = tpm2_unmarshal_blob(blobs[shard].iov_base, blobs[shard].iov_len, publics + shard, privates + shard, &seed);
+                if (r < 0)
+                        return log_debug_errno(r, "Could not extract parts from blob: %m");
+
+                if (seed.size > 0) {
+                        /* This is a calculated (or duplicated) sealed object, and must be imported. */
+                        _cleanup_free_ TPM2B_PRIVATE *imported_private = NULL;
+                        r = tpm2_import(c,
+                                        primary_handle,
+                                        /* session= */ NULL,
+                                        publics + shard,
+                                        privates + shard,
+                                        &seed,
+                                        /* encryption_key= */ NULL,
+                                        /* symmetric= */ NULL,
+                                        &imported_private);
+                        if (r < 0)
+                                return r;
+
+                        privates[shard] = *imported_private;
+                }
+        }
+
         _cleanup_(iovec_done_erase) struct iovec secret = {};
         for (unsigned i = RETRY_UNSEAL_MAX;; i--) {
                 bool retry = false;
                 iovec_done_erase(&secret); /* clear data from previous unseal attempt */
 
                 for (size_t shard = 0; shard < n_blobs; shard++) {
-                        TPM2B_PUBLIC public;
-                        TPM2B_PRIVATE private;
-                        TPM2B_ENCRYPTED_SECRET seed = {};
-                        r = tpm2_unmarshal_blob(blobs[shard].iov_base, blobs[shard].iov_len, &public, &private, &seed);
-                        if (r < 0)
-                                return log_debug_errno(r, "Could not extract parts from blob: %m");
-
-                        if (seed.size > 0) {
-                                /* This is a calculated (or duplicated) sealed object, and must be imported. */
-                                _cleanup_free_ TPM2B_PRIVATE *imported_private = NULL;
-                                r = tpm2_import(c,
-                                                primary_handle,
-                                                /* session= */ NULL,
-                                                &public,
-                                                &private,
-                                                &seed,
-                                                /* encryption_key= */ NULL,
-                                                /* symmetric= */ NULL,
-                                                &imported_private);
-                                if (r < 0)
-                                        return r;
-
-                                private = *imported_private;
-                        }
-
                         log_debug("Loading HMAC key into TPM for shard %zu.", shard);
 
                         /* Nothing sensitive on the bus, no need for encryption. Even if an attacker gives
@@ -5776,7 +5791,7 @@ int tpm2_unseal(Tpm2Context *c,
                          * tpmKey is verified. In the non-srk model, with pin, the bindKey provides
                          * protections. */
                         _cleanup_(tpm2_handle_freep) Tpm2Handle *hmac_key = NULL;
-                        r = tpm2_load(c, primary_handle, NULL, &public, &private, &hmac_key);
+                        r = tpm2_load(c, primary_handle, NULL, publics + shard, privates + shard, &hmac_key);
                         if (r < 0)
                                 return r;
 
@@ -7,6 +7,30 @@ static SD_VARLINK_DEFINE_METHOD(Rotate);
 static SD_VARLINK_DEFINE_METHOD(FlushToVar);
 static SD_VARLINK_DEFINE_METHOD(RelinquishVar);
 
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                RateLimitGroup,
+                SD_VARLINK_FIELD_COMMENT("The unit the messages originated from"),
+                SD_VARLINK_DEFINE_FIELD(Unit, SD_VARLINK_STRING, 0),
+                SD_VARLINK_FIELD_COMMENT("Number of messages from the unit that were suppressed by the rate limit"),
+                SD_VARLINK_DEFINE_FIELD(Suppressed, SD_VARLINK_INT, 0));
+
+static SD_VARLINK_DEFINE_METHOD(
+                GetStatistics,
+                SD_VARLINK_FIELD_COMMENT("Number of payloads found in the cache of recently written data objects, summed over all open journal files"),
+                SD_VARLINK_DEFINE_OUTPUT(DataCacheHits, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("Number of payloads not found in the cache of recently written data objects, summed over all open journal files"),
+                SD_VARLINK_DEFINE_OUTPUT(DataCacheMisses, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("Number of log messages whose sender was found in the client metadata cache"),
+                SD_VARLINK_DEFINE_OUTPUT(ContextCacheHits, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("Number of log messages whose sender was not found in the client metadata cache"),
+                SD_VARLINK_DEFINE_OUTPUT(ContextCacheMisses, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("Number of client metadata refreshes that could reuse the recently read unit metadata of the same cgroup"),
+                SD_VARLINK_DEFINE_OUTPUT(CgroupCacheHits, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("Number of client metadata refreshes that had to read the unit metadata of the cgroup"),
+                SD_VARLINK_DEFINE_OUTPUT(CgroupCacheMisses, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("Units currently tracked by the rate limit that had messages suppressed, most recently logging first"),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(RateLimitSuppressed, RateLimitGroup, SD_VARLINK_ARRAY));
+
 static SD_VARLINK_DEFINE_ERROR(NotSupportedByNamespaces);
 
 SD_VARLINK_DEFINE_INTERFACE(
@@ -16,4 +40,6 @@ SD_VARLINK_DEFINE_INTERFACE(
                 &vl_method_Rotate,
                 &vl_method_FlushToVar,
                 &vl_method_RelinquishVar,
+                &vl_method_GetStatistics,
+                &vl_type_RateLimitGroup,
                 &vl_error_NotSupportedByNamespaces);
@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "varlink-idl-common.h"
+#include "varlink-io.systemd.Manager.h"
+
+static SD_VARLINK_DEFINE_METHOD_FULL(
+                ListUnits,
+                SD_VARLINK_SUPPORTS_MORE,
+                SD_VARLINK_FIELD_COMMENT("If specified, only units in one of these load, active or sub states are returned"),
+                SD_VARLINK_DEFINE_INPUT(states, SD_VARLINK_STRING, SD_VARLINK_ARRAY|SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("If specified, only units whose names match one of these glob patterns are returned"),
+                SD_VARLINK_DEFINE_INPUT(patterns, SD_VARLINK_STRING, SD_VARLINK_ARRAY|SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("If specified, only the listed output fields are returned for each unit, in addition to 'id'. If not specified all fields are returned."),
+                SD_VARLINK_DEFINE_INPUT(properties, SD_VARLINK_STRING, SD_VARLINK_ARRAY|SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The primary name of the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(id, SD_VARLINK_STRING, 0),
+                SD_VARLINK_FIELD_COMMENT("The human readable description of the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(description, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The load state of the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(loadState, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The active state of the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(activeState, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The freezer state of the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(freezerState, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The unit type specific sub state of the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(subState, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The unit this unit follows in state, if any"),
+                SD_VARLINK_DEFINE_OUTPUT(following, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The numeric ID of the job queued for the unit, if any"),
+                SD_VARLINK_DEFINE_OUTPUT(jobId, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The type of the job queued for the unit, if any"),
+                SD_VARLINK_DEFINE_OUTPUT(jobType, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The 128bit ID of the current invocation of the unit, formatted in hexadecimal"),
+                SD_VARLINK_DEFINE_OUTPUT(invocationId, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("Timestamp when the unit last entered the active state"),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(activeEnterTimestamp, Timestamp, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("Timestamp when the unit last left the active state"),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(activeExitTimestamp, Timestamp, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("Timestamp of the last state change of the unit"),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(stateChangeTimestamp, Timestamp, SD_VARLINK_NULLABLE));
+
+static SD_VARLINK_DEFINE_METHOD_FULL(
+                ListUnitAccounting,
+                SD_VARLINK_SUPPORTS_MORE,
+                SD_VARLINK_FIELD_COMMENT("If specified, only units whose names match one of these glob patterns are returned"),
+                SD_VARLINK_DEFINE_INPUT(patterns, SD_VARLINK_STRING, SD_VARLINK_ARRAY|SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The primary name of the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(id, SD_VARLINK_STRING, 0),
+                SD_VARLINK_FIELD_COMMENT("The current memory usage of the unit's cgroup in bytes"),
+                SD_VARLINK_DEFINE_OUTPUT(memoryCurrent, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The peak memory usage of the unit's cgroup in bytes"),
+                SD_VARLINK_DEFINE_OUTPUT(memoryPeak, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The current swap usage of the unit's cgroup in bytes"),
+                SD_VARLINK_DEFINE_OUTPUT(memorySwapCurrent, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The peak swap usage of the unit's cgroup in bytes"),
+                SD_VARLINK_DEFINE_OUTPUT(memorySwapPeak, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The current zswap usage of the unit's cgroup in bytes"),
+                SD_VARLINK_DEFINE_OUTPUT(memoryZSwapCurrent, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The current number of tasks in the unit's cgroup"),
+                SD_VARLINK_DEFINE_OUTPUT(tasksCurrent, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The CPU time consumed by the unit in nanoseconds"),
+                SD_VARLINK_DEFINE_OUTPUT(cpuUsageNSec, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The number of bytes read by the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(ioReadBytes, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The number of bytes written by the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(ioWriteBytes, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The number of read operations issued by the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(ioReadOperations, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The number of write operations issued by the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(ioWriteOperations, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The number of IP bytes received by the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(ipIngressBytes, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The number of IP packets received by the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(ipIngressPackets, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The number of IP bytes sent by the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(ipEgressBytes, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The number of IP packets sent by the unit"),
+                SD_VARLINK_DEFINE_OUTPUT(ipEgressPackets, SD_VARLINK_INT, SD_VARLINK_NULLABLE));
+
+static SD_VARLINK_DEFINE_ERROR(NoSuchUnit);
+
+SD_VARLINK_DEFINE_INTERFACE(
+                io_systemd_Manager,
+                "io.systemd.Manager",
+                SD_VARLINK_INTERFACE_COMMENT("The service manager's unit enumeration interface."),
+                SD_VARLINK_SYMBOL_COMMENT("List loaded units matching the specified filters, with a selectable set of fields each"),
+                &vl_method_ListUnits,
+                SD_VARLINK_SYMBOL_COMMENT("Return the resource accounting counters of all loaded units with a cgroup, matching the specified filters"),
+                &vl_method_ListUnitAccounting,
+                &vl_type_Timestamp,
+                SD_VARLINK_SYMBOL_COMMENT("No unit matched the specified filters"),
+                &vl_error_NoSuchUnit);
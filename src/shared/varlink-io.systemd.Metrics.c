@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "varlink-io.systemd.Metrics.h"
+
+static SD_VARLINK_DEFINE_ENUM_TYPE(
+                MetricType,
+                SD_VARLINK_FIELD_COMMENT("A value that only ever increases, until the service is restarted"),
+                SD_VARLINK_DEFINE_ENUM_VALUE(counter),
+                SD_VARLINK_FIELD_COMMENT("A current value, that may increase and decrease"),
+                SD_VARLINK_DEFINE_ENUM_VALUE(gauge),
+                SD_VARLINK_FIELD_COMMENT("A distribution of observed values over power-of-two buckets"),
+                SD_VARLINK_DEFINE_ENUM_VALUE(histogram));
+
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                Metric,
+                SD_VARLINK_FIELD_COMMENT("The name of the metric family, prefixed with the name of the service's main interface"),
+                SD_VARLINK_DEFINE_FIELD(name, SD_VARLINK_STRING, 0),
+                SD_VARLINK_FIELD_COMMENT("The type of the metric family"),
+                SD_VARLINK_DEFINE_FIELD_BY_TYPE(type, MetricType, 0),
+                SD_VARLINK_FIELD_COMMENT("Distinguishes the values of a family that are reported more than once, e.g. per protocol"),
+                SD_VARLINK_DEFINE_FIELD(fields, SD_VARLINK_STRING, SD_VARLINK_MAP|SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The value of a counter or gauge"),
+                SD_VARLINK_DEFINE_FIELD(value, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The bucket counts of a histogram. The first bucket counts values of zero, bucket i values in the range [2^(i-1), 2^i), the last bucket everything beyond."),
+                SD_VARLINK_DEFINE_FIELD(buckets, SD_VARLINK_INT, SD_VARLINK_ARRAY|SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("The sum of all values observed by a histogram, if known"),
+                SD_VARLINK_DEFINE_FIELD(sum, SD_VARLINK_INT, SD_VARLINK_NULLABLE));
+
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                MetricFamily,
+                SD_VARLINK_FIELD_COMMENT("The name of the metric family"),
+                SD_VARLINK_DEFINE_FIELD(name, SD_VARLINK_STRING, 0),
+                SD_VARLINK_FIELD_COMMENT("The type of the metric family"),
+                SD_VARLINK_DEFINE_FIELD_BY_TYPE(type, MetricType, 0),
+                SD_VARLINK_FIELD_COMMENT("A human readable description of the metric family, including its unit"),
+                SD_VARLINK_DEFINE_FIELD(description, SD_VARLINK_STRING, 0));
+
+static SD_VARLINK_DEFINE_METHOD(
+                List,
+                SD_VARLINK_FIELD_COMMENT("The current values of all metrics of the service"),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(metrics, Metric, SD_VARLINK_ARRAY));
+
+static SD_VARLINK_DEFINE_METHOD(
+                Describe,
+                SD_VARLINK_FIELD_COMMENT("All metric families the service reports"),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(families, MetricFamily, SD_VARLINK_ARRAY));
+
+SD_VARLINK_DEFINE_INTERFACE(
+                io_systemd_Metrics,
+                "io.systemd.Metrics",
+                SD_VARLINK_INTERFACE_COMMENT("A common interface to collect performance metrics of systemd services."),
+                SD_VARLINK_SYMBOL_COMMENT("The type of a metric family"),
+                &vl_type_MetricType,
+                SD_VARLINK_SYMBOL_COMMENT("A single value of a metric family"),
+                &vl_type_Metric,
+                SD_VARLINK_SYMBOL_COMMENT("The description of a metric family"),
+                &vl_type_MetricFamily,
+                SD_VARLINK_SYMBOL_COMMENT("Returns the current values of all metrics in a single reply. This is cheap, the values are read from counters the service maintains anyway."),
+                &vl_method_List,
+                SD_VARLINK_SYMBOL_COMMENT("Describes the metric families returned by List()"),
+                &vl_method_Describe);
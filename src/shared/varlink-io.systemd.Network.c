@@ -44,7 +44,77 @@ static SD_VARLINK_DEFINE_METHOD(
                 SetPersistentStorage,
                 SD_VARLINK_DEFINE_INPUT(Ready, SD_VARLINK_BOOL, 0));
 
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                LinkOnlineState,
+                SD_VARLINK_DEFINE_FIELD(InterfaceIndex, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(SetupState, SD_VARLINK_STRING, 0),
+                SD_VARLINK_DEFINE_FIELD(OperationalState, SD_VARLINK_STRING, 0),
+                SD_VARLINK_DEFINE_FIELD(IPv4AddressState, SD_VARLINK_STRING, 0),
+                SD_VARLINK_DEFINE_FIELD(IPv6AddressState, SD_VARLINK_STRING, 0),
+                SD_VARLINK_DEFINE_FIELD(RequiredForOnline, SD_VARLINK_BOOL, SD_VARLINK_NULLABLE),
+                SD_VARLINK_DEFINE_FIELD(RequiredOperationalStateForOnline, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_DEFINE_FIELD(RequiredFamilyForOnline, SD_VARLINK_STRING, SD_VARLINK_NULLABLE));
+
+static SD_VARLINK_DEFINE_METHOD_FULL(
+                SubscribeLinkStates,
+                SD_VARLINK_REQUIRES_MORE,
+                /* The first reply carries all links, subsequent replies only the links that changed */
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(Links, LinkOnlineState, SD_VARLINK_ARRAY));
+
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                LinkStatistics,
+                SD_VARLINK_DEFINE_FIELD(InterfaceIndex, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(RxBytes, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(TxBytes, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(RxPackets, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(TxPackets, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(RxErrors, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(TxErrors, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(RxDropped, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(TxDropped, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(RxBitRate, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_DEFINE_FIELD(TxBitRate, SD_VARLINK_INT, SD_VARLINK_NULLABLE));
+
+static SD_VARLINK_DEFINE_METHOD(
+                GetLinkStatistics,
+                SD_VARLINK_DEFINE_OUTPUT(Timestamp, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(Links, LinkStatistics, SD_VARLINK_ARRAY));
+
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                LinkObjectCounts,
+                SD_VARLINK_DEFINE_FIELD(InterfaceIndex, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(InterfaceName, SD_VARLINK_STRING, 0),
+                SD_VARLINK_DEFINE_FIELD(Addresses, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(Neighbors, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(Routes, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(Requests, SD_VARLINK_INT, 0));
+
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                RequestTypeStatistics,
+                SD_VARLINK_DEFINE_FIELD(Type, SD_VARLINK_STRING, 0),
+                SD_VARLINK_DEFINE_FIELD(Queued, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(Processed, SD_VARLINK_INT, 0));
+
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                NetlinkMessageStatistics,
+                SD_VARLINK_DEFINE_FIELD(Type, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(Name, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
+                SD_VARLINK_DEFINE_FIELD(Received, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(Sent, SD_VARLINK_INT, 0));
+
+static SD_VARLINK_DEFINE_METHOD(
+                GetDaemonStatistics,
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(Links, LinkObjectCounts, SD_VARLINK_ARRAY),
+                SD_VARLINK_DEFINE_OUTPUT(PendingRequests, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(Requests, RequestTypeStatistics, SD_VARLINK_ARRAY),
+                SD_VARLINK_DEFINE_OUTPUT(RequestWaitHistogram, SD_VARLINK_INT, SD_VARLINK_ARRAY),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(NetlinkMessages, NetlinkMessageStatistics, SD_VARLINK_ARRAY),
+                SD_VARLINK_DEFINE_OUTPUT(Reloads, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_OUTPUT(LastReloadUSec, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_DEFINE_OUTPUT(MaxReloadUSec, SD_VARLINK_INT, SD_VARLINK_NULLABLE));
+
 static SD_VARLINK_DEFINE_ERROR(StorageReadOnly);
+static SD_VARLINK_DEFINE_ERROR(SpeedMeterDisabled);
 
 SD_VARLINK_DEFINE_INTERFACE(
                 io_systemd_Network,
@@ -53,6 +123,15 @@ SD_VARLINK_DEFINE_INTERFACE(
                 &vl_method_GetNamespaceId,
                 &vl_method_GetLLDPNeighbors,
                 &vl_method_SetPersistentStorage,
+                &vl_method_SubscribeLinkStates,
+                &vl_method_GetLinkStatistics,
+                &vl_method_GetDaemonStatistics,
                 &vl_type_LLDPNeighbor,
                 &vl_type_LLDPNeighborsByInterface,
-                &vl_error_StorageReadOnly);
+                &vl_type_LinkOnlineState,
+                &vl_type_LinkStatistics,
+                &vl_type_LinkObjectCounts,
+                &vl_type_RequestTypeStatistics,
+                &vl_type_NetlinkMessageStatistics,
+                &vl_error_StorageReadOnly,
+                &vl_error_SpeedMeterDisabled);
@@ -40,7 +40,8 @@ static SD_VARLINK_DEFINE_STRUCT_TYPE(
                 SD_VARLINK_DEFINE_FIELD_BY_TYPE(key, ResourceKey, 0),
                 SD_VARLINK_DEFINE_FIELD_BY_TYPE(rrs, ResourceRecordArray, SD_VARLINK_NULLABLE|SD_VARLINK_ARRAY),
                 SD_VARLINK_DEFINE_FIELD(type, SD_VARLINK_STRING, SD_VARLINK_NULLABLE),
-                SD_VARLINK_DEFINE_FIELD(until, SD_VARLINK_INT, 0));
+                SD_VARLINK_DEFINE_FIELD(until, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(hits, SD_VARLINK_INT, SD_VARLINK_NULLABLE));
 
 static SD_VARLINK_DEFINE_STRUCT_TYPE(
                 ScopeCache,
@@ -72,7 +73,9 @@ static SD_VARLINK_DEFINE_STRUCT_TYPE(
                 SD_VARLINK_DEFINE_FIELD(PacketBadOpt, SD_VARLINK_BOOL, 0),
                 SD_VARLINK_DEFINE_FIELD(PacketRRSIGMissing, SD_VARLINK_BOOL, 0),
                 SD_VARLINK_DEFINE_FIELD(PacketInvalid, SD_VARLINK_BOOL, 0),
-                SD_VARLINK_DEFINE_FIELD(PacketDoOff, SD_VARLINK_BOOL, 0));
+                SD_VARLINK_DEFINE_FIELD(PacketDoOff, SD_VARLINK_BOOL, 0),
+                SD_VARLINK_DEFINE_FIELD(RoundTripTimeUSec, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_DEFINE_FIELD(LatencyHistogram, SD_VARLINK_INT, SD_VARLINK_ARRAY|SD_VARLINK_NULLABLE));
 
 static SD_VARLINK_DEFINE_METHOD(
                 DumpServerState,
@@ -86,27 +89,42 @@ static SD_VARLINK_DEFINE_STRUCT_TYPE(
                 SD_VARLINK_DEFINE_FIELD(totalTimeouts, SD_VARLINK_INT, 0),
                 SD_VARLINK_DEFINE_FIELD(totalTimeoutsServedStale, SD_VARLINK_INT, 0),
                 SD_VARLINK_DEFINE_FIELD(totalFailedResponses, SD_VARLINK_INT, 0),
-                SD_VARLINK_DEFINE_FIELD(totalFailedResponsesServedStale, SD_VARLINK_INT, 0));
+                SD_VARLINK_DEFINE_FIELD(totalFailedResponsesServedStale, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(totalStubQueries, SD_VARLINK_INT, SD_VARLINK_NULLABLE));
+
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                LatencyStatistics,
+                SD_VARLINK_DEFINE_FIELD(udp, SD_VARLINK_INT, SD_VARLINK_ARRAY),
+                SD_VARLINK_DEFINE_FIELD(tcp, SD_VARLINK_INT, SD_VARLINK_ARRAY),
+                SD_VARLINK_DEFINE_FIELD(tls, SD_VARLINK_INT, SD_VARLINK_ARRAY),
+                SD_VARLINK_DEFINE_FIELD(llmnr, SD_VARLINK_INT, SD_VARLINK_ARRAY),
+                SD_VARLINK_DEFINE_FIELD(mdns, SD_VARLINK_INT, SD_VARLINK_ARRAY));
 
 static SD_VARLINK_DEFINE_STRUCT_TYPE(
                 CacheStatistics,
                 SD_VARLINK_DEFINE_FIELD(size, SD_VARLINK_INT, 0),
                 SD_VARLINK_DEFINE_FIELD(hits, SD_VARLINK_INT, 0),
-                SD_VARLINK_DEFINE_FIELD(misses, SD_VARLINK_INT, 0));
+                SD_VARLINK_DEFINE_FIELD(misses, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(prefetches, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_DEFINE_FIELD(bytes, SD_VARLINK_INT, SD_VARLINK_NULLABLE),
+                SD_VARLINK_DEFINE_FIELD(rejected, SD_VARLINK_INT, SD_VARLINK_NULLABLE));
 
 static SD_VARLINK_DEFINE_STRUCT_TYPE(
                 DnssecStatistics,
                 SD_VARLINK_DEFINE_FIELD(secure, SD_VARLINK_INT, 0),
                 SD_VARLINK_DEFINE_FIELD(insecure, SD_VARLINK_INT, 0),
                 SD_VARLINK_DEFINE_FIELD(bogus, SD_VARLINK_INT, 0),
-                SD_VARLINK_DEFINE_FIELD(indeterminate, SD_VARLINK_INT, 0));
+                SD_VARLINK_DEFINE_FIELD(indeterminate, SD_VARLINK_INT, 0),
+                SD_VARLINK_DEFINE_FIELD(verificationsCached, SD_VARLINK_INT, SD_VARLINK_NULLABLE));
 
 static SD_VARLINK_DEFINE_METHOD(
                 DumpStatistics,
                 VARLINK_DEFINE_POLKIT_INPUT,
                 SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(transactions, TransactionStatistics, 0),
                 SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(cache, CacheStatistics, 0),
-                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(dnssec, DnssecStatistics, 0));
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(dnssec, DnssecStatistics, 0),
+                SD_VARLINK_FIELD_COMMENT("Number of replies per protocol by latency, in log2-scale buckets: less than 1ms, less than 2ms, less than 4ms and so on, the last one counting everything slower."),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(latency, LatencyStatistics, SD_VARLINK_NULLABLE));
 
 static SD_VARLINK_DEFINE_METHOD(
                 ResetStatistics,
@@ -175,6 +193,7 @@ SD_VARLINK_DEFINE_INTERFACE(
                 &vl_type_TransactionStatistics,
                 &vl_type_CacheStatistics,
                 &vl_type_DnssecStatistics,
+                &vl_type_LatencyStatistics,
                 &vl_type_ServerState,
                 SD_VARLINK_SYMBOL_COMMENT("Encapsulates a DNS server address specification."),
                 &vl_type_DNSServer,
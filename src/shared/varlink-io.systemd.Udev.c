@@ -21,8 +21,50 @@ static SD_VARLINK_DEFINE_METHOD(StartExecQueue);
 
 static SD_VARLINK_DEFINE_METHOD(StopExecQueue);
 
+static SD_VARLINK_DEFINE_METHOD(
+                SetProfile,
+                SD_VARLINK_FIELD_COMMENT("Enable/disable. Enabling again after disabling starts over with zero counters."),
+                SD_VARLINK_DEFINE_INPUT(enable, SD_VARLINK_BOOL, 0));
+
+static SD_VARLINK_DEFINE_STRUCT_TYPE(
+                RuleProfile,
+                SD_VARLINK_FIELD_COMMENT("The rules file the line is in."),
+                SD_VARLINK_DEFINE_FIELD(file, SD_VARLINK_STRING, 0),
+                SD_VARLINK_FIELD_COMMENT("The line number within the file."),
+                SD_VARLINK_DEFINE_FIELD(line, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("The total time in microseconds spent on checking the conditions of the line and applying its assignments."),
+                SD_VARLINK_DEFINE_FIELD(usec, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("The number of events the line was checked for."),
+                SD_VARLINK_DEFINE_FIELD(evaluated, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("The number of events all conditions of the line matched for."),
+                SD_VARLINK_DEFINE_FIELD(matched, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("The part of the total time in microseconds spent on running PROGRAM= and IMPORT{program}= commands."),
+                SD_VARLINK_DEFINE_FIELD(spawnUSec, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("The number of PROGRAM= and IMPORT{program}= commands run."),
+                SD_VARLINK_DEFINE_FIELD(spawned, SD_VARLINK_INT, 0));
+
+static SD_VARLINK_DEFINE_METHOD(
+                GetProfile,
+                SD_VARLINK_FIELD_COMMENT("Whether profiling is enabled."),
+                SD_VARLINK_DEFINE_OUTPUT(enabled, SD_VARLINK_BOOL, 0),
+                SD_VARLINK_FIELD_COMMENT("The rule lines checked at least once since profiling was enabled or the rules were reloaded, most expensive first."),
+                SD_VARLINK_DEFINE_OUTPUT_BY_TYPE(rules, RuleProfile, SD_VARLINK_ARRAY|SD_VARLINK_NULLABLE));
+
 static SD_VARLINK_DEFINE_METHOD(Exit);
 
+static SD_VARLINK_DEFINE_METHOD(
+                GetQueueStatistics,
+                SD_VARLINK_FIELD_COMMENT("The number of events waiting in the queue."),
+                SD_VARLINK_DEFINE_OUTPUT(queued, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("The number of events currently being processed by a worker."),
+                SD_VARLINK_DEFINE_OUTPUT(running, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("The number of events passed to a worker since systemd-udevd was started."),
+                SD_VARLINK_DEFINE_OUTPUT(started, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("The total time in microseconds those events waited in the queue."),
+                SD_VARLINK_DEFINE_OUTPUT(waitUSecTotal, SD_VARLINK_INT, 0),
+                SD_VARLINK_FIELD_COMMENT("The longest time in microseconds one of those events waited in the queue."),
+                SD_VARLINK_DEFINE_OUTPUT(waitUSecMax, SD_VARLINK_INT, 0));
+
 SD_VARLINK_DEFINE_INTERFACE(
                 io_systemd_Udev,
                 "io.systemd.Udev",
@@ -37,5 +79,12 @@ SD_VARLINK_DEFINE_INTERFACE(
                 &vl_method_StartExecQueue,
                 SD_VARLINK_SYMBOL_COMMENT("Stops processing of queued events."),
                 &vl_method_StopExecQueue,
+                SD_VARLINK_SYMBOL_COMMENT("Returns statistics about the event queue."),
+                &vl_method_GetQueueStatistics,
+                SD_VARLINK_SYMBOL_COMMENT("Enable/disable collecting the time spent on each udev rule line, summed over all workers."),
+                &vl_method_SetProfile,
+                SD_VARLINK_SYMBOL_COMMENT("Returns the counters collected for each udev rule line."),
+                &vl_method_GetProfile,
+                &vl_type_RuleProfile,
                 SD_VARLINK_SYMBOL_COMMENT("Terminates systemd-udevd. This exists for backward compatibility. Please consider to use 'systemctl stop systemd-udevd.service'."),
                 &vl_method_Exit);
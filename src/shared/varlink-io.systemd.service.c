@@ -21,6 +21,13 @@ static SD_VARLINK_DEFINE_METHOD(
                 SD_VARLINK_FIELD_COMMENT("Returns the current environment block, i.e. the contents of environ[]."),
                 SD_VARLINK_DEFINE_OUTPUT(environment, SD_VARLINK_STRING, SD_VARLINK_NULLABLE|SD_VARLINK_ARRAY));
 
+static SD_VARLINK_DEFINE_METHOD(
+                GetEventLoopStatistics,
+                SD_VARLINK_FIELD_COMMENT("If true, enables collection of per event source dispatch statistics, if false disables it again and resets the counters."),
+                SD_VARLINK_DEFINE_INPUT(enable, SD_VARLINK_BOOL, SD_VARLINK_NULLABLE),
+                SD_VARLINK_FIELD_COMMENT("Dispatch counts, callback run times and queueing delays of the event loop, as returned by sd_event_get_statistics()."),
+                SD_VARLINK_DEFINE_OUTPUT(statistics, SD_VARLINK_OBJECT, SD_VARLINK_NULLABLE));
+
 static SD_VARLINK_DEFINE_ERROR(
                 InconsistentEnvironment);
 
@@ -36,6 +43,8 @@ SD_VARLINK_DEFINE_INTERFACE(
                 &vl_method_SetLogLevel,
                 SD_VARLINK_SYMBOL_COMMENT("Get current environment block."),
                 &vl_method_GetEnvironment,
+                SD_VARLINK_SYMBOL_COMMENT("Get event loop statistics, optionally enabling or disabling their collection first."),
+                &vl_method_GetEventLoopStatistics,
                 SD_VARLINK_SYMBOL_COMMENT("Returned if the environment block is currently not in a valid state."),
                 &vl_error_InconsistentEnvironment);
 
@@ -129,3 +138,49 @@ int varlink_method_get_environment(sd_varlink *link, sd_json_variant *parameters
 invalid:
         return sd_varlink_error(link, "io.systemd.service.InconsistentEnvironment", parameters);
 }
+
+int varlink_method_get_event_loop_statistics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        static const sd_json_dispatch_field dispatch_table[] = {
+                { "enable", SD_JSON_VARIANT_BOOLEAN, sd_json_dispatch_tristate, 0, 0 },
+                {}
+        };
+
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        int r, enable = -1;
+        sd_event *e;
+        uid_t uid;
+
+        assert(link);
+        assert(parameters);
+
+        r = sd_varlink_dispatch(link, parameters, dispatch_table, &enable);
+        if (r != 0)
+                return r;
+
+        r = sd_varlink_get_peer_uid(link, &uid);
+        if (r < 0)
+                return r;
+
+        /* Event source descriptions might reveal what the service is busy with, hence restrict this like
+         * the environment block above */
+        if (uid != 0 && uid != getuid())
+                return sd_varlink_error(link, SD_VARLINK_ERROR_PERMISSION_DENIED, parameters);
+
+        log_debug("Received io.systemd.service.GetEventLoopStatistics()");
+
+        e = sd_varlink_get_event(link);
+        if (!e)
+                return sd_varlink_reply(link, NULL);
+
+        if (enable >= 0) {
+                r = sd_event_set_statistics(e, enable);
+                if (r < 0)
+                        return r;
+        }
+
+        r = sd_event_get_statistics(e, &v);
+        if (r < 0)
+                return r;
+
+        return sd_varlink_replybo(link, SD_JSON_BUILD_PAIR_VARIANT("statistics", v));
+}
@@ -4,8 +4,11 @@
 #include <fcntl.h>
 #include <getopt.h>
 #include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/eventfd.h>
 #include <sys/un.h>
 #include <unistd.h>
 
@@ -17,9 +20,13 @@
 #include "build.h"
 #include "daemon-util.h"
 #include "errno-util.h"
+#include "event-uring.h"
 #include "fd-util.h"
+#include "format-util.h"
+#include "list.h"
 #include "log.h"
 #include "main-func.h"
+#include "parse-argument.h"
 #include "parse-util.h"
 #include "path-util.h"
 #include "pretty-print.h"
@@ -29,21 +36,167 @@
 #include "string-util.h"
 
 #define BUFFER_SIZE (256 * 1024)
+#define STATUS_INTERVAL_USEC (5 * USEC_PER_SEC)
 
 static unsigned arg_connections_max = 256;
 static const char *arg_remote_host = NULL;
 static usec_t arg_exit_idle_time = USEC_INFINITY;
+static unsigned arg_workers = 1;
+static bool arg_io_uring = false;
 
-typedef struct Context {
+/* Shared by all worker threads, hence only accessed atomically */
+static unsigned n_connections = 0;
+static uint64_t total_server_to_client_bytes = 0, total_client_to_server_bytes = 0;
+
+typedef struct Context Context;
+typedef struct LogMessage LogMessage;
+
+/* A message logged by a worker thread, to be logged by the main thread */
+struct LogMessage {
+        int level;
+        int error;
+        char *text;
+
+        LIST_FIELDS(LogMessage, messages);
+};
+
+struct Context {
         sd_event *event;
         sd_resolve *resolve;
         sd_event_source *idle_time;
+        sd_event_source *status_time;
 
         Set *listen;
         Set *connections;
-} Context;
 
-typedef struct Connection {
+        bool io_uring;
+
+        /* In the main thread's context: an eventfd poked by the workers when they might have gone idle. In
+         * a worker's context: an eventfd signalled by the main thread when the worker shall exit. */
+        int notify_fd;
+        sd_event_source *notify_event_source;
+
+        Context *main; /* NULL for the main thread's context */
+        Context *workers;
+        size_t n_workers;
+        pthread_t thread;
+        bool thread_started;
+
+        /* Only in the main thread's context: messages queued by the workers, see context_log_queue() */
+        pthread_mutex_t log_mutex;
+        LIST_HEAD(LogMessage, log_messages);
+};
+
+/* Workers don't log themselves, but queue their messages for the main thread. */
+#define context_log_full_errno(context, level, error, ...)                                              \
+        ({                                                                                              \
+                Context *_context = (context);                                                          \
+                _context->main ?                                                                        \
+                        context_log_queue(_context->main, (level), (error), __VA_ARGS__) :              \
+                        log_full_errno_zerook((level), (error), __VA_ARGS__);                           \
+        })
+
+#define context_log_debug(context, ...)          context_log_full_errno(context, LOG_DEBUG, 0, __VA_ARGS__)
+#define context_log_notice(context, ...)         context_log_full_errno(context, LOG_NOTICE, 0, __VA_ARGS__)
+#define context_log_warning(context, ...)        context_log_full_errno(context, LOG_WARNING, 0, __VA_ARGS__)
+#define context_log_error(context, ...)          context_log_full_errno(context, LOG_ERR, 0, __VA_ARGS__)
+#define context_log_warning_errno(context, ...)  context_log_full_errno(context, LOG_WARNING, __VA_ARGS__)
+#define context_log_error_errno(context, ...)    context_log_full_errno(context, LOG_ERR, __VA_ARGS__)
+#define context_log_oom(context)                 context_log_error_errno(context, ENOMEM, "Out of memory.")
+
+static LogMessage* log_message_free(LogMessage *m) {
+        if (!m)
+                return NULL;
+
+        free(m->text);
+        return mfree(m);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(LogMessage*, log_message_free);
+
+_printf_(4, 5)
+static int context_log_queue(Context *main, int level, int error, const char *format, ...) {
+        _cleanup_(log_message_freep) LogMessage *m = NULL;
+        va_list ap;
+        int r;
+
+        assert(main);
+        assert(!main->main);
+        assert(format);
+
+        /* Formats the message right away, as the arguments might not live long enough, and wakes up the main
+         * thread to log it. Returns the error just like log_full_errno() does. */
+
+        error = ERRNO_VALUE(error);
+
+        if (log_get_max_level() < LOG_PRI(level))
+                goto finish;
+
+        m = new(LogMessage, 1);
+        if (!m)
+                goto finish;
+
+        *m = (LogMessage) {
+                .level = level,
+                .error = error,
+        };
+
+        errno = error; /* for %m */
+        va_start(ap, format);
+        r = vasprintf(&m->text, format, ap);
+        va_end(ap);
+        if (r < 0) {
+                m->text = NULL;
+                goto finish;
+        }
+
+        assert_se(pthread_mutex_lock(&main->log_mutex) == 0);
+        LIST_APPEND(messages, main->log_messages, TAKE_PTR(m));
+        assert_se(pthread_mutex_unlock(&main->log_mutex) == 0);
+
+        (void) eventfd_write(main->notify_fd, 1);
+
+finish:
+        return error > 0 ? -error : -ESTRPIPE;
+}
+
+static void context_log_flush(Context *context) {
+        LIST_HEAD(LogMessage, messages);
+
+        assert(context);
+        assert(!context->main);
+
+        assert_se(pthread_mutex_lock(&context->log_mutex) == 0);
+        messages = TAKE_PTR(context->log_messages);
+        assert_se(pthread_mutex_unlock(&context->log_mutex) == 0);
+
+        LIST_FOREACH(messages, m, messages) {
+                log_full_errno_zerook(m->level, m->error, "%s", m->text);
+                log_message_free(m);
+        }
+}
+
+typedef struct Connection Connection;
+
+typedef enum ShovelState {
+        SHOVEL_POLL_FROM,
+        SHOVEL_SPLICE_FROM,
+        SHOVEL_POLL_TO,
+        SHOVEL_SPLICE_TO,
+} ShovelState;
+
+/* One direction of a connection, when driven by io_uring operations rather than by fd readiness */
+typedef struct Shovel {
+        Connection *connection;
+        int from, to;
+        int *buffer;
+        size_t *full, *sz;
+        uint64_t *bytes, *total;
+        ShovelState state;
+        sd_event_source *event_source;
+} Shovel;
+
+struct Connection {
         Context *context;
 
         int server_fd, client_fd;
@@ -53,10 +206,13 @@ typedef struct Connection {
         size_t server_to_client_buffer_full, client_to_server_buffer_full;
         size_t server_to_client_buffer_size, client_to_server_buffer_size;
 
+        uint64_t server_to_client_bytes, client_to_server_bytes;
+
         sd_event_source *server_event_source, *client_event_source;
+        Shovel server_to_client_shovel, client_to_server_shovel;
 
         sd_resolve_query *resolve_query;
-} Connection;
+};
 
 static void connection_free(Connection *c) {
         assert(c);
@@ -64,8 +220,12 @@ static void connection_free(Connection *c) {
         if (c->context)
                 set_remove(c->context->connections, c);
 
+        assert_se(__atomic_fetch_sub(&n_connections, 1, __ATOMIC_SEQ_CST) > 0);
+
         sd_event_source_unref(c->server_event_source);
         sd_event_source_unref(c->client_event_source);
+        sd_event_source_unref(c->server_to_client_shovel.event_source);
+        sd_event_source_unref(c->client_to_server_shovel.event_source);
 
         safe_close(c->server_fd);
         safe_close(c->client_fd);
@@ -82,8 +242,9 @@ static int idle_time_cb(sd_event_source *s, uint64_t usec, void *userdata) {
         Context *c = userdata;
         int r;
 
-        if (!set_isempty(c->connections)) {
-                log_warning("Idle timer fired even though there are connections, ignoring");
+        /* Workers don't disable the timer when they accept a connection, so this might happen */
+        if (__atomic_load_n(&n_connections, __ATOMIC_SEQ_CST) > 0) {
+                log_debug("Idle timer fired even though there are connections, ignoring");
                 return 0;
         }
 
@@ -95,42 +256,97 @@ static int idle_time_cb(sd_event_source *s, uint64_t usec, void *userdata) {
         return 0;
 }
 
-static int connection_release(Connection *c) {
-        Context *context = ASSERT_PTR(ASSERT_PTR(c)->context);
+static int context_maybe_idle(Context *context) {
         int r;
 
-        connection_free(c);
+        assert(context);
 
-        if (arg_exit_idle_time < USEC_INFINITY && set_isempty(context->connections)) {
-                if (context->idle_time) {
-                        r = sd_event_source_set_time_relative(context->idle_time, arg_exit_idle_time);
-                        if (r < 0)
-                                return log_error_errno(r, "Error while setting idle time: %m");
+        if (arg_exit_idle_time == USEC_INFINITY)
+                return 0;
 
-                        r = sd_event_source_set_enabled(context->idle_time, SD_EVENT_ONESHOT);
-                        if (r < 0)
-                                return log_error_errno(r, "Error while enabling idle time: %m");
-                } else {
-                        r = sd_event_add_time_relative(
-                                        context->event, &context->idle_time, CLOCK_MONOTONIC,
-                                        arg_exit_idle_time, 0, idle_time_cb, context);
-                        if (r < 0)
-                                return log_error_errno(r, "Failed to create idle timer: %m");
-                }
+        /* Only the main thread may exit, hence let it know that we might all be idle now */
+        if (context->main) {
+                if (eventfd_write(context->main->notify_fd, 1) < 0)
+                        return context_log_error_errno(context, errno, "Failed to wake up main thread: %m");
+
+                return 0;
+        }
+
+        if (__atomic_load_n(&n_connections, __ATOMIC_SEQ_CST) > 0)
+                return 0;
+
+        if (context->idle_time) {
+                r = sd_event_source_set_time_relative(context->idle_time, arg_exit_idle_time);
+                if (r < 0)
+                        return context_log_error_errno(context, r, "Error while setting idle time: %m");
+
+                r = sd_event_source_set_enabled(context->idle_time, SD_EVENT_ONESHOT);
+                if (r < 0)
+                        return context_log_error_errno(context, r, "Error while enabling idle time: %m");
+        } else {
+                r = sd_event_add_time_relative(
+                                context->event, &context->idle_time, CLOCK_MONOTONIC,
+                                arg_exit_idle_time, 0, idle_time_cb, context);
+                if (r < 0)
+                        return context_log_error_errno(context, r, "Failed to create idle timer: %m");
         }
 
         return 0;
 }
 
+static int connection_release(Connection *c) {
+        Context *context = ASSERT_PTR(ASSERT_PTR(c)->context);
+
+        context_log_debug(context, "Connection closed, forwarded %s to and %s from remote host.",
+                          FORMAT_BYTES(c->server_to_client_bytes),
+                          FORMAT_BYTES(c->client_to_server_bytes));
+
+        connection_free(c);
+
+        if (__atomic_load_n(&n_connections, __ATOMIC_SEQ_CST) > 0)
+                return 0;
+
+        return context_maybe_idle(context);
+}
+
 static void context_clear(Context *context) {
         assert(context);
 
+        /* Stop the workers first, they might still poke us */
+        FOREACH_ARRAY(w, context->workers, context->n_workers) {
+                if (w->thread_started) {
+                        if (eventfd_write(w->notify_fd, 1) < 0)
+                                log_warning_errno(errno, "Failed to ask worker thread to exit, ignoring: %m");
+                        else
+                                (void) pthread_join(w->thread, NULL);
+                }
+
+                context_clear(w);
+        }
+        context->workers = mfree(context->workers);
+
+        /* Whatever the workers logged before they exited */
+        if (!context->main)
+                context_log_flush(context);
+
         set_free_with_destructor(context->listen, sd_event_source_unref);
         set_free_with_destructor(context->connections, connection_free);
 
+        sd_event_source_unref(context->notify_event_source);
+        safe_close(context->notify_fd);
+
         sd_event_unref(context->event);
         sd_resolve_unref(context->resolve);
         sd_event_source_unref(context->idle_time);
+        sd_event_source_unref(context->status_time);
+}
+
+static void shovel_account(uint64_t *bytes, uint64_t *total, size_t n) {
+        assert(bytes);
+        assert(total);
+
+        *bytes += n;
+        __atomic_fetch_add(total, n, __ATOMIC_RELAXED);
 }
 
 static int connection_create_pipes(Connection *c, int buffer[static 2], size_t *sz) {
@@ -145,13 +361,13 @@ static int connection_create_pipes(Connection *c, int buffer[static 2], size_t *
 
         r = pipe2(buffer, O_CLOEXEC|O_NONBLOCK);
         if (r < 0)
-                return log_error_errno(errno, "Failed to allocate pipe buffer: %m");
+                return context_log_error_errno(c->context, errno, "Failed to allocate pipe buffer: %m");
 
         (void) fcntl(buffer[0], F_SETPIPE_SZ, BUFFER_SIZE);
 
         r = fcntl(buffer[0], F_GETPIPE_SZ);
         if (r < 0)
-                return log_error_errno(errno, "Failed to get pipe buffer size: %m");
+                return context_log_error_errno(c->context, errno, "Failed to get pipe buffer size: %m");
 
         assert(r > 0);
         *sz = r;
@@ -163,6 +379,7 @@ static int connection_shovel(
                 Connection *c,
                 int *from, int buffer[2], int *to,
                 size_t *full, size_t *sz,
+                uint64_t *bytes, uint64_t *total,
                 sd_event_source **from_source, sd_event_source **to_source) {
 
         bool shoveled;
@@ -175,6 +392,8 @@ static int connection_shovel(
         assert(to);
         assert(full);
         assert(sz);
+        assert(bytes);
+        assert(total);
         assert(from_source);
         assert(to_source);
 
@@ -192,19 +411,20 @@ static int connection_shovel(
                                 *from_source = sd_event_source_unref(*from_source);
                                 *from = safe_close(*from);
                         } else if (!ERRNO_IS_TRANSIENT(errno))
-                                return log_error_errno(errno, "Failed to splice: %m");
+                                return context_log_error_errno(c->context, errno, "Failed to splice: %m");
                 }
 
                 if (*full > 0 && *to >= 0) {
                         z = splice(buffer[0], NULL, *to, NULL, *full, SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
                         if (z > 0) {
                                 *full -= z;
+                                shovel_account(bytes, total, z);
                                 shoveled = true;
                         } else if (z == 0 || ERRNO_IS_DISCONNECT(errno)) {
                                 *to_source = sd_event_source_unref(*to_source);
                                 *to = safe_close(*to);
                         } else if (!ERRNO_IS_TRANSIENT(errno))
-                                return log_error_errno(errno, "Failed to splice: %m");
+                                return context_log_error_errno(c->context, errno, "Failed to splice: %m");
                 }
         } while (shoveled);
 
@@ -223,6 +443,7 @@ static int traffic_cb(sd_event_source *s, int fd, uint32_t revents, void *userda
         r = connection_shovel(c,
                               &c->server_fd, c->server_to_client_buffer, &c->client_fd,
                               &c->server_to_client_buffer_full, &c->server_to_client_buffer_size,
+                              &c->server_to_client_bytes, &total_server_to_client_bytes,
                               &c->server_event_source, &c->client_event_source);
         if (r < 0)
                 goto quit;
@@ -230,6 +451,7 @@ static int traffic_cb(sd_event_source *s, int fd, uint32_t revents, void *userda
         r = connection_shovel(c,
                               &c->client_fd, c->client_to_server_buffer, &c->server_fd,
                               &c->client_to_server_buffer_full, &c->client_to_server_buffer_size,
+                              &c->client_to_server_bytes, &total_client_to_server_bytes,
                               &c->client_event_source, &c->server_event_source);
         if (r < 0)
                 goto quit;
@@ -281,7 +503,7 @@ static int connection_enable_event_sources(Connection *c) {
                 r = 0;
 
         if (r < 0)
-                return log_error_errno(r, "Failed to set up server event source: %m");
+                return context_log_error_errno(c->context, r, "Failed to set up server event source: %m");
 
         if (c->client_event_source)
                 r = sd_event_source_set_io_events(c->client_event_source, b);
@@ -291,9 +513,206 @@ static int connection_enable_event_sources(Connection *c) {
                 r = 0;
 
         if (r < 0)
-                return log_error_errno(r, "Failed to set up client event source: %m");
+                return context_log_error_errno(c->context, r, "Failed to set up client event source: %m");
+
+        return 0;
+}
+
+#if ENABLE_URING
+static uint32_t poll32_events(uint32_t events) {
+        /* The kernel swaps the 16-bit halves of poll32_events on big-endian machines */
+#if __BYTE_ORDER == __BIG_ENDIAN
+        return events << 16 | events >> 16;
+#else
+        return events;
+#endif
+}
+
+static void shovel_make_sqe(const Shovel *s, struct io_uring_sqe *ret) {
+        assert(s);
+        assert(ret);
+
+        /* Splice operations are always executed by io_uring's kernel worker threads. To not tie one of
+         * them up for each idle connection, wait for readiness with a cheap poll operation first, and
+         * only then splice without blocking. */
+
+        switch (s->state) {
+
+        case SHOVEL_POLL_FROM:
+        case SHOVEL_POLL_TO:
+                *ret = (struct io_uring_sqe) {
+                        .opcode = IORING_OP_POLL_ADD,
+                        .fd = s->state == SHOVEL_POLL_FROM ? s->from : s->to,
+                        .poll32_events = poll32_events(s->state == SHOVEL_POLL_FROM ? POLLIN : POLLOUT),
+                };
+                break;
+
+        case SHOVEL_SPLICE_FROM:
+                *ret = (struct io_uring_sqe) {
+                        .opcode = IORING_OP_SPLICE,
+                        .fd = s->buffer[1],
+                        .off = UINT64_MAX,
+                        .splice_fd_in = s->from,
+                        .splice_off_in = UINT64_MAX,
+                        .len = *s->sz - *s->full,
+                        .splice_flags = SPLICE_F_MOVE|SPLICE_F_NONBLOCK,
+                };
+                break;
+
+        case SHOVEL_SPLICE_TO:
+                *ret = (struct io_uring_sqe) {
+                        .opcode = IORING_OP_SPLICE,
+                        .fd = s->to,
+                        .off = UINT64_MAX,
+                        .splice_fd_in = s->buffer[0],
+                        .splice_off_in = UINT64_MAX,
+                        .len = *s->full,
+                        .splice_flags = SPLICE_F_MOVE|SPLICE_F_NONBLOCK,
+                };
+                break;
+
+        default:
+                assert_not_reached();
+        }
+}
+
+static int shovel_io_uring_cb(sd_event_source *s, const struct io_uring_cqe *cqe, void *userdata);
+
+static int shovel_submit(Shovel *s) {
+        struct io_uring_sqe sqe;
+        int r;
+
+        assert(s);
+
+        shovel_make_sqe(s, &sqe);
+
+        if (!s->event_source)
+                return sd_event_add_io_uring(s->connection->context->event, &s->event_source, &sqe, shovel_io_uring_cb, s);
+
+        r = sd_event_source_set_io_uring_sqe(s->event_source, &sqe);
+        if (r < 0)
+                return context_log_error_errno(s->connection->context, r, "Failed to update io_uring operation: %m");
+
+        r = sd_event_source_set_enabled(s->event_source, SD_EVENT_ONESHOT);
+        if (r < 0)
+                return context_log_error_errno(s->connection->context, r, "Failed to resubmit io_uring operation: %m");
+
+        return 0;
+}
+
+static int shovel_process(Shovel *s, int res) {
+        assert(s);
+
+        /* Returns > 0 if there's more to do, 0 if this direction is finished, and < 0 on error. */
+
+        switch (s->state) {
+
+        case SHOVEL_POLL_FROM:
+        case SHOVEL_POLL_TO:
+                if (res < 0)
+                        return context_log_error_errno(s->connection->context, res, "Failed to wait for socket: %m");
+
+                s->state = s->state == SHOVEL_POLL_FROM ? SHOVEL_SPLICE_FROM : SHOVEL_SPLICE_TO;
+                return 1;
+
+        case SHOVEL_SPLICE_FROM:
+                if (res > 0) {
+                        *s->full += res;
+                        s->state = SHOVEL_SPLICE_TO; /* The other side is most likely writable, try right away */
+                } else if (res == 0 || ERRNO_IS_NEG_DISCONNECT(res))
+                        return 0;
+                else if (ERRNO_IS_NEG_TRANSIENT(res))
+                        s->state = SHOVEL_POLL_FROM;
+                else
+                        return context_log_error_errno(s->connection->context, res, "Failed to splice: %m");
+
+                return 1;
+
+        case SHOVEL_SPLICE_TO:
+                if (res > 0) {
+                        assert((size_t) res <= *s->full);
+                        *s->full -= res;
+                        shovel_account(s->bytes, s->total, res);
+                        s->state = *s->full > 0 ? SHOVEL_POLL_TO : SHOVEL_POLL_FROM;
+                } else if (res == 0 || ERRNO_IS_NEG_DISCONNECT(res))
+                        return 0;
+                else if (ERRNO_IS_NEG_TRANSIENT(res))
+                        s->state = SHOVEL_POLL_TO;
+                else
+                        return context_log_error_errno(s->connection->context, res, "Failed to splice: %m");
+
+                return 1;
+
+        default:
+                assert_not_reached();
+        }
+}
+
+static int shovel_io_uring_cb(sd_event_source *s, const struct io_uring_cqe *cqe, void *userdata) {
+        Shovel *sh = ASSERT_PTR(userdata);
+        int r;
+
+        assert(s);
+        assert(cqe);
+
+        /* Unlike in the epoll logic the fds are not closed on EOF, as the other direction might still
+         * have an operation in flight on them. Instead, the connection is done once either direction
+         * is, which matches what the epoll logic does too. */
+
+        r = shovel_process(sh, cqe->res);
+        if (r <= 0)
+                goto quit;
+
+        r = shovel_submit(sh);
+        if (r < 0)
+                goto quit;
 
         return 0;
+
+quit:
+        connection_release(sh->connection);
+        return 0; /* ignore errors, continue serving */
+}
+#endif
+
+static int connection_start_io_uring(Connection *c) {
+#if ENABLE_URING
+        int r;
+
+        assert(c);
+
+        c->server_to_client_shovel = (Shovel) {
+                .connection = c,
+                .from = c->server_fd,
+                .to = c->client_fd,
+                .buffer = c->server_to_client_buffer,
+                .full = &c->server_to_client_buffer_full,
+                .sz = &c->server_to_client_buffer_size,
+                .bytes = &c->server_to_client_bytes,
+                .total = &total_server_to_client_bytes,
+                .state = SHOVEL_POLL_FROM,
+        };
+
+        c->client_to_server_shovel = (Shovel) {
+                .connection = c,
+                .from = c->client_fd,
+                .to = c->server_fd,
+                .buffer = c->client_to_server_buffer,
+                .full = &c->client_to_server_buffer_full,
+                .sz = &c->client_to_server_buffer_size,
+                .bytes = &c->client_to_server_bytes,
+                .total = &total_client_to_server_bytes,
+                .state = SHOVEL_POLL_FROM,
+        };
+
+        r = shovel_submit(&c->server_to_client_shovel);
+        if (r < 0)
+                return r;
+
+        return shovel_submit(&c->client_to_server_shovel);
+#else
+        return -EOPNOTSUPP;
+#endif
 }
 
 static int connection_complete(Connection *c) {
@@ -309,6 +728,17 @@ static int connection_complete(Connection *c) {
         if (r < 0)
                 goto fail;
 
+        if (c->context->io_uring) {
+                r = connection_start_io_uring(c);
+                if (r >= 0)
+                        return 0;
+                if (r != -EOPNOTSUPP)
+                        goto fail;
+
+                context_log_notice(c->context, "io_uring is not available, falling back to epoll.");
+                c->context->io_uring = false;
+        }
+
         r = connection_enable_event_sources(c);
         if (r < 0)
                 goto fail;
@@ -331,12 +761,12 @@ static int connect_cb(sd_event_source *s, int fd, uint32_t revents, void *userda
         solen = sizeof(error);
         r = getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &solen);
         if (r < 0) {
-                log_error_errno(errno, "Failed to issue SO_ERROR: %m");
+                context_log_error_errno(c->context, errno, "Failed to issue SO_ERROR: %m");
                 goto fail;
         }
 
         if (error != 0) {
-                log_error_errno(error, "Failed to connect to remote host: %m");
+                context_log_error_errno(c->context, error, "Failed to connect to remote host: %m");
                 goto fail;
         }
 
@@ -358,7 +788,7 @@ static int connection_start(Connection *c, struct sockaddr *sa, socklen_t salen)
 
         c->client_fd = socket(sa->sa_family, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0);
         if (c->client_fd < 0) {
-                log_error_errno(errno, "Failed to get remote socket: %m");
+                context_log_error_errno(c->context, errno, "Failed to get remote socket: %m");
                 goto fail;
         }
 
@@ -367,17 +797,17 @@ static int connection_start(Connection *c, struct sockaddr *sa, socklen_t salen)
                 if (errno == EINPROGRESS) {
                         r = sd_event_add_io(c->context->event, &c->client_event_source, c->client_fd, EPOLLOUT, connect_cb, c);
                         if (r < 0) {
-                                log_error_errno(r, "Failed to add connection socket: %m");
+                                context_log_error_errno(c->context, r, "Failed to add connection socket: %m");
                                 goto fail;
                         }
 
                         r = sd_event_source_set_enabled(c->client_event_source, SD_EVENT_ONESHOT);
                         if (r < 0) {
-                                log_error_errno(r, "Failed to enable oneshot event source: %m");
+                                context_log_error_errno(c->context, r, "Failed to enable oneshot event source: %m");
                                 goto fail;
                         }
                 } else {
-                        log_error_errno(errno, "Failed to connect to remote host: %m");
+                        context_log_error_errno(c->context, errno, "Failed to connect to remote host: %m");
                         goto fail;
                 }
         } else {
@@ -398,7 +828,7 @@ static int resolve_handler(sd_resolve_query *q, int ret, const struct addrinfo *
         assert(c);
 
         if (ret != 0) {
-                log_error("Failed to resolve host: %s", gai_strerror(ret));
+                context_log_error(c->context, "Failed to resolve host: %s", gai_strerror(ret));
                 goto fail;
         }
 
@@ -427,7 +857,7 @@ static int resolve_remote(Connection *c) {
 
                 r = sockaddr_un_set_path(&sa.un, arg_remote_host);
                 if (r < 0) {
-                        log_error_errno(r, "Specified address doesn't fit in an AF_UNIX address, refusing: %m");
+                        context_log_error_errno(c->context, r, "Specified address doesn't fit in an AF_UNIX address, refusing: %m");
                         goto fail;
                 }
                 sa_len = r;
@@ -445,10 +875,10 @@ static int resolve_remote(Connection *c) {
                 service = "80";
         }
 
-        log_debug("Looking up address info for %s:%s", node, service);
+        context_log_debug(c->context, "Looking up address info for %s:%s", node, service);
         r = resolve_getaddrinfo(c->context->resolve, &c->resolve_query, node, service, &hints, resolve_handler, NULL, c);
         if (r < 0) {
-                log_error_errno(r, "Failed to resolve remote host: %m");
+                context_log_error_errno(c->context, r, "Failed to resolve remote host: %m");
                 goto fail;
         }
 
@@ -466,19 +896,22 @@ static int add_connection_socket(Context *context, int fd) {
         assert(context);
         assert(fd >= 0);
 
-        if (set_size(context->connections) > arg_connections_max) {
-                log_warning("Hit connection limit, refusing connection.");
+        /* The limit applies to all workers together, hence reserve a slot first */
+        if (__atomic_add_fetch(&n_connections, 1, __ATOMIC_SEQ_CST) > arg_connections_max) {
+                assert_se(__atomic_fetch_sub(&n_connections, 1, __ATOMIC_SEQ_CST) > 0);
+                context_log_warning(context, "Hit connection limit, refusing connection.");
                 safe_close(fd);
                 return 0;
         }
 
         r = sd_event_source_set_enabled(context->idle_time, SD_EVENT_OFF);
         if (r < 0)
-                log_warning_errno(r, "Unable to disable idle timer, continuing: %m");
+                context_log_warning_errno(context, r, "Unable to disable idle timer, continuing: %m");
 
         c = new(Connection, 1);
         if (!c) {
-                log_oom();
+                assert_se(__atomic_fetch_sub(&n_connections, 1, __ATOMIC_SEQ_CST) > 0);
+                context_log_oom(context);
                 return 0;
         }
 
@@ -493,7 +926,8 @@ static int add_connection_socket(Context *context, int fd) {
         r = set_ensure_put(&context->connections, NULL, c);
         if (r < 0) {
                 free(c);
-                log_oom();
+                assert_se(__atomic_fetch_sub(&n_connections, 1, __ATOMIC_SEQ_CST) > 0);
+                context_log_oom(context);
                 return 0;
         }
 
@@ -512,21 +946,21 @@ static int accept_cb(sd_event_source *s, int fd, uint32_t revents, void *userdat
         nfd = accept4(fd, NULL, NULL, SOCK_NONBLOCK|SOCK_CLOEXEC);
         if (nfd < 0) {
                 if (!ERRNO_IS_ACCEPT_AGAIN(errno))
-                        log_warning_errno(errno, "Failed to accept() socket: %m");
+                        context_log_warning_errno(context, errno, "Failed to accept() socket: %m");
         } else {
                 (void) getpeername_pretty(nfd, true, &peer);
-                log_debug("New connection from %s", strna(peer));
+                context_log_debug(context, "New connection from %s", strna(peer));
 
                 r = add_connection_socket(context, nfd);
                 if (r < 0) {
-                        log_warning_errno(r, "Failed to accept connection, ignoring: %m");
+                        context_log_warning_errno(context, r, "Failed to accept connection, ignoring: %m");
                         safe_close(nfd);
                 }
         }
 
         r = sd_event_source_set_enabled(s, SD_EVENT_ONESHOT);
         if (r < 0)
-                return log_error_errno(r, "Error while re-enabling listener with ONESHOT: %m");
+                return context_log_error_errno(context, r, "Error while re-enabling listener with ONESHOT: %m");
 
         return 1;
 }
@@ -572,6 +1006,166 @@ static int add_listen_socket(Context *context, int fd) {
         return 0;
 }
 
+static int notify_cb(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        Context *context = ASSERT_PTR(userdata);
+        eventfd_t v;
+
+        assert(s);
+        assert(fd >= 0);
+
+        if (context->main) /* Workers are only notified when they shall exit */
+                return sd_event_exit(context->event, 0);
+
+        if (eventfd_read(fd, &v) < 0 && !ERRNO_IS_TRANSIENT(errno))
+                return log_error_errno(errno, "Failed to read eventfd: %m");
+
+        context_log_flush(context);
+
+        (void) context_maybe_idle(context);
+        return 0;
+}
+
+static int status_time_cb(sd_event_source *s, uint64_t usec, void *userdata) {
+        int r;
+
+        assert(s);
+
+        (void) sd_notifyf(/* unset_environment= */ false,
+                          "STATUS=%u connections, forwarded %s to and %s from remote host.",
+                          __atomic_load_n(&n_connections, __ATOMIC_SEQ_CST),
+                          FORMAT_BYTES(__atomic_load_n(&total_server_to_client_bytes, __ATOMIC_RELAXED)),
+                          FORMAT_BYTES(__atomic_load_n(&total_client_to_server_bytes, __ATOMIC_RELAXED)));
+
+        r = sd_event_source_set_time_relative(s, STATUS_INTERVAL_USEC);
+        if (r < 0)
+                return log_error_errno(r, "Failed to reset status timer: %m");
+
+        return sd_event_source_set_enabled(s, SD_EVENT_ONESHOT);
+}
+
+static int context_init(Context *context, Context *main, int n_fds) {
+        int r;
+
+        assert(context);
+
+        *context = (Context) {
+                .notify_fd = -EBADF,
+                .main = main,
+                .io_uring = arg_io_uring,
+                .log_mutex = PTHREAD_MUTEX_INITIALIZER,
+        };
+
+        if (main) {
+                r = sd_event_new(&context->event);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to allocate event loop: %m");
+
+                r = sd_resolve_new(&context->resolve);
+        } else {
+                r = sd_event_default(&context->event);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to allocate event loop: %m");
+
+                r = sd_resolve_default(&context->resolve);
+        }
+        if (r < 0)
+                return log_error_errno(r, "Failed to allocate resolver: %m");
+
+        r = sd_resolve_attach_event(context->resolve, context->event, 0);
+        if (r < 0)
+                return log_error_errno(r, "Failed to attach resolver: %m");
+
+        if (arg_workers > 1) {
+                context->notify_fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+                if (context->notify_fd < 0)
+                        return log_error_errno(errno, "Failed to allocate eventfd: %m");
+
+                r = sd_event_add_io(context->event, &context->notify_event_source, context->notify_fd, EPOLLIN, notify_cb, context);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to add eventfd event source: %m");
+        }
+
+        if (!main) {
+                sd_event_set_watchdog(context->event, true);
+
+                r = sd_event_add_time_relative(
+                                context->event, &context->status_time, CLOCK_MONOTONIC,
+                                STATUS_INTERVAL_USEC, 0, status_time_cb, context);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to create status timer: %m");
+
+                r = sd_event_source_set_enabled(context->status_time, SD_EVENT_ONESHOT);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to enable status timer: %m");
+        }
+
+        /* All loops watch all listening sockets, whichever wakes up first gets to accept() the
+         * connection, and then serves it until it is closed. */
+        for (int fd = SD_LISTEN_FDS_START; fd < SD_LISTEN_FDS_START + n_fds; fd++) {
+                r = add_listen_socket(context, fd);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static void* worker_thread(void *p) {
+        Context *context = ASSERT_PTR(p);
+        int r;
+
+        (void) pthread_setname_np(pthread_self(), "proxy-worker");
+
+        r = sd_event_loop(context->event);
+        if (r < 0)
+                context_log_error_errno(context, r, "Failed to run worker event loop: %m");
+
+        return NULL;
+}
+
+static int context_start_workers(Context *context, int n_fds) {
+        sigset_t ss, saved_ss;
+        int r;
+
+        assert(context);
+        assert(!context->main);
+
+        if (arg_workers <= 1)
+                return 0;
+
+        context->workers = new0(Context, arg_workers - 1);
+        if (!context->workers)
+                return log_oom();
+
+        for (unsigned i = 0; i < arg_workers - 1; i++) {
+                r = context_init(context->workers + i, context, n_fds);
+                context->n_workers++;
+                if (r < 0)
+                        return r;
+        }
+
+        /* Block all signals in the workers, so that they are delivered to the main thread */
+        assert_se(sigfillset(&ss) >= 0);
+
+        r = pthread_sigmask(SIG_BLOCK, &ss, &saved_ss);
+        if (r > 0)
+                return log_error_errno(r, "Failed to block signals: %m");
+
+        FOREACH_ARRAY(w, context->workers, context->n_workers) {
+                r = pthread_create(&w->thread, NULL, worker_thread, w);
+                if (r > 0) {
+                        log_error_errno(r, "Failed to start worker thread: %m");
+                        break;
+                }
+
+                w->thread_started = true;
+        }
+
+        assert_se(pthread_sigmask(SIG_SETMASK, &saved_ss, NULL) == 0);
+
+        return r > 0 ? -r : 0;
+}
+
 static int help(void) {
         _cleanup_free_ char *link = NULL;
         _cleanup_free_ char *time_link = NULL;
@@ -590,6 +1184,8 @@ static int help(void) {
                "  -c --connections-max=  Set the maximum number of connections to be accepted\n"
                "     --exit-idle-time=   Exit when without a connection for this duration. See\n"
                "                         the %3$s for time span format\n"
+               "     --workers=N         Serve connections in N threads\n"
+               "     --io-uring=BOOL     Forward data with io_uring operations\n"
                "  -h --help              Show this help\n"
                "     --version           Show package version\n"
                "\nSee the %2$s for details.\n",
@@ -605,12 +1201,16 @@ static int parse_argv(int argc, char *argv[]) {
         enum {
                 ARG_VERSION = 0x100,
                 ARG_EXIT_IDLE,
-                ARG_IGNORE_ENV
+                ARG_IGNORE_ENV,
+                ARG_WORKERS,
+                ARG_IO_URING,
         };
 
         static const struct option options[] = {
                 { "connections-max", required_argument, NULL, 'c'           },
                 { "exit-idle-time",  required_argument, NULL, ARG_EXIT_IDLE },
+                { "workers",         required_argument, NULL, ARG_WORKERS   },
+                { "io-uring",        required_argument, NULL, ARG_IO_URING  },
                 { "help",            no_argument,       NULL, 'h'           },
                 { "version",         no_argument,       NULL, ARG_VERSION   },
                 {}
@@ -650,6 +1250,20 @@ static int parse_argv(int argc, char *argv[]) {
                                 return log_error_errno(r, "Failed to parse --exit-idle-time= argument: %s", optarg);
                         break;
 
+                case ARG_WORKERS:
+                        r = safe_atou(optarg, &arg_workers);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse --workers= argument: %s", optarg);
+                        if (arg_workers < 1)
+                                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Number of workers must be at least 1.");
+                        break;
+
+                case ARG_IO_URING:
+                        r = parse_boolean_argument("--io-uring=", optarg, &arg_io_uring);
+                        if (r < 0)
+                                return r;
+                        break;
+
                 case '?':
                         return -EINVAL;
 
@@ -670,9 +1284,11 @@ static int parse_argv(int argc, char *argv[]) {
 }
 
 static int run(int argc, char *argv[]) {
-        _cleanup_(context_clear) Context context = {};
+        _cleanup_(context_clear) Context context = {
+                .notify_fd = -EBADF,
+        };
         _unused_ _cleanup_(notify_on_cleanup) const char *notify_stop = NULL;
-        int r, n, fd;
+        int r, n;
 
         log_setup();
 
@@ -680,20 +1296,6 @@ static int run(int argc, char *argv[]) {
         if (r <= 0)
                 return r;
 
-        r = sd_event_default(&context.event);
-        if (r < 0)
-                return log_error_errno(r, "Failed to allocate event loop: %m");
-
-        r = sd_resolve_default(&context.resolve);
-        if (r < 0)
-                return log_error_errno(r, "Failed to allocate resolver: %m");
-
-        r = sd_resolve_attach_event(context.resolve, context.event, 0);
-        if (r < 0)
-                return log_error_errno(r, "Failed to attach resolver: %m");
-
-        sd_event_set_watchdog(context.event, true);
-
         r = sd_listen_fds(1);
         if (r < 0)
                 return log_error_errno(r, "Failed to receive sockets from parent.");
@@ -702,11 +1304,13 @@ static int run(int argc, char *argv[]) {
 
         n = r;
 
-        for (fd = SD_LISTEN_FDS_START; fd < SD_LISTEN_FDS_START + n; fd++) {
-                r = add_listen_socket(&context, fd);
-                if (r < 0)
-                        return r;
-        }
+        r = context_init(&context, /* main= */ NULL, n);
+        if (r < 0)
+                return r;
+
+        r = context_start_workers(&context, n);
+        if (r < 0)
+                return r;
 
         notify_stop = notify_start(NOTIFY_READY, NOTIFY_STOPPING);
         r = sd_event_loop(context.event);
@@ -28,6 +28,7 @@
 #include "fd-util.h"
 #include "fileio.h"
 #include "format-table.h"
+#include "hexdecoct.h"
 #include "fs-util.h"
 #include "hashmap.h"
 #include "initrd-util.h"
@@ -46,6 +47,7 @@
 #include "process-util.h"
 #include "rm-rf.h"
 #include "selinux-util.h"
+#include "sha256.h"
 #include "sort-util.h"
 #include "string-table.h"
 #include "string-util.h"
@@ -1460,9 +1462,34 @@ static int write_work_dir_file(ImageClass image_class, const char *meta_path, co
         return 0;
 }
 
+static int write_fingerprint_file(ImageClass image_class, const char *meta_path, const char *fingerprint, const char *hierarchy) {
+        _cleanup_free_ char *f = NULL, *hierarchy_path = NULL;
+        int r;
+
+        assert(meta_path);
+        assert(fingerprint);
+
+        /* Remember what this merge was set up from, so that a later refresh can tell whether there's
+         * anything to do. */
+        f = path_join(meta_path, image_class_info[image_class].dot_directory_name, "fingerprint");
+        if (!f)
+                return log_oom();
+
+        hierarchy_path = path_join(hierarchy, image_class_info[image_class].dot_directory_name, "fingerprint");
+        if (!hierarchy_path)
+                return log_oom();
+
+        r = write_string_file_full(AT_FDCWD, f, fingerprint, WRITE_STRING_FILE_CREATE|WRITE_STRING_FILE_LABEL, /* ts= */ NULL, hierarchy_path);
+        if (r < 0)
+                return log_error_errno(r, "Failed to write '%s': %m", f);
+
+        return 0;
+}
+
 static int store_info_in_meta(
                 ImageClass image_class,
                 char **extensions,
+                const char *fingerprint,
                 const char *meta_path,
                 const char *overlay_path,
                 const char *work_dir,
@@ -1471,6 +1498,7 @@ static int store_info_in_meta(
         int r;
 
         assert(extensions);
+        assert(fingerprint);
         assert(meta_path);
         assert(overlay_path);
         /* work_dir may be NULL */
@@ -1503,6 +1531,10 @@ static int store_info_in_meta(
         if (r < 0)
                 return r;
 
+        r = write_fingerprint_file(image_class, meta_path, fingerprint, hierarchy);
+        if (r < 0)
+                return r;
+
         /* Make sure the top-level dir has an mtime marking the point we established the merge */
         if (utimensat(AT_FDCWD, meta_path, NULL, AT_SYMLINK_NOFOLLOW) < 0)
                 return log_error_errno(r, "Failed fix mtime of '%s': %m", meta_path);
@@ -1549,6 +1581,7 @@ static int merge_hierarchy(
                 int noexec,
                 char **extensions,
                 char **paths,
+                const char *fingerprint,
                 const char *meta_path,
                 const char *overlay_path,
                 const char *workspace_path) {
@@ -1594,7 +1627,7 @@ static int merge_hierarchy(
         if (r < 0)
                 return r;
 
-        r = store_info_in_meta(image_class, extensions, meta_path, overlay_path, op->work_dir, op->hierarchy);
+        r = store_info_in_meta(image_class, extensions, fingerprint, meta_path, overlay_path, op->work_dir, op->hierarchy);
         if (r < 0)
                 return r;
 
@@ -1636,21 +1669,254 @@ static const ImagePolicy *pick_image_policy(const Image *img) {
         return image_class_info[img->class].default_image_policy;
 }
 
+/* Exit codes of the image mount workers, besides EXIT_SUCCESS and EXIT_FAILURE */
+#define MOUNT_WORKER_IGNORED 123
+#define MOUNT_WORKER_NEED_PASSPHRASE 124
+
+/* How many images to dissect and mount in parallel */
+#define MOUNT_WORKERS_MAX 16U
+
+typedef struct MountJob {
+        Image *image;
+        char *path;
+        pid_t pid;
+        int result; /* > 0 if mounted, 0 if to be ignored, -ENOKEY if a passphrase is needed, < 0 on error */
+} MountJob;
+
+static void mount_job_array_free(MountJob *jobs, size_t n_jobs) {
+        FOREACH_ARRAY(j, jobs, n_jobs)
+                free(j->path);
+
+        free(jobs);
+}
+
+static int mount_image(ImageClass image_class, Image *img, const char *p, bool force, bool interactive) {
+        int r;
+
+        assert(img);
+        assert(p);
+
+        /* Returns > 0 if the image was mounted, 0 if it shall be ignored, and -ENOKEY if it needs a
+         * passphrase but we may not ask for one. */
+
+        switch (img->type) {
+        case IMAGE_DIRECTORY:
+        case IMAGE_SUBVOLUME:
+
+                if (!force) {
+                        r = extension_has_forbidden_content(p);
+                        if (r < 0)
+                                return r;
+                        if (r > 0)
+                                return 0;
+                }
+
+                r = mount_nofollow_verbose(LOG_ERR, img->path, p, NULL, MS_BIND, NULL);
+                if (r < 0)
+                        return r;
+
+                /* Make this a read-only bind mount */
+                r = bind_remount_recursive(p, MS_RDONLY, MS_RDONLY, NULL);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to make bind mount '%s' read-only: %m", p);
+
+                return 1;
+
+        case IMAGE_RAW:
+        case IMAGE_BLOCK: {
+                _cleanup_(dissected_image_unrefp) DissectedImage *m = NULL;
+                _cleanup_(loop_device_unrefp) LoopDevice *d = NULL;
+                _cleanup_(verity_settings_done) VeritySettings verity_settings = VERITY_SETTINGS_DEFAULT;
+                DissectImageFlags flags =
+                        DISSECT_IMAGE_READ_ONLY |
+                        DISSECT_IMAGE_GENERIC_ROOT |
+                        DISSECT_IMAGE_REQUIRE_ROOT |
+                        DISSECT_IMAGE_MOUNT_ROOT_ONLY |
+                        DISSECT_IMAGE_USR_NO_ROOT |
+                        DISSECT_IMAGE_ADD_PARTITION_DEVICES |
+                        DISSECT_IMAGE_PIN_PARTITION_DEVICES |
+                        DISSECT_IMAGE_ALLOW_USERSPACE_VERITY;
+
+                r = verity_settings_load(&verity_settings, img->path, NULL, NULL);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to read verity artifacts for %s: %m", img->path);
+
+                if (verity_settings.data_path)
+                        flags |= DISSECT_IMAGE_NO_PARTITION_TABLE;
+
+                if (!force)
+                        flags |= DISSECT_IMAGE_VALIDATE_OS_EXT;
+
+                r = loop_device_make_by_path(
+                                img->path,
+                                O_RDONLY,
+                                /* sector_size= */ UINT32_MAX,
+                                FLAGS_SET(flags, DISSECT_IMAGE_NO_PARTITION_TABLE) ? 0 : LO_FLAGS_PARTSCAN,
+                                LOCK_SH,
+                                &d);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to set up loopback device for %s: %m", img->path);
+
+                r = dissect_loop_device_and_warn(
+                                d,
+                                &verity_settings,
+                                /* mount_options= */ NULL,
+                                pick_image_policy(img),
+                                flags,
+                                &m);
+                if (r < 0)
+                        return r;
+
+                r = dissected_image_load_verity_sig_partition(
+                                m,
+                                d->fd,
+                                &verity_settings);
+                if (r < 0)
+                        return r;
+
+                if (interactive)
+                        r = dissected_image_decrypt_interactively(
+                                        m, NULL,
+                                        &verity_settings,
+                                        flags);
+                else {
+                        r = dissected_image_decrypt(m, /* passphrase= */ NULL, &verity_settings, flags);
+                        if (r < 0 && r != -ENOKEY)
+                                log_error_errno(r, "Failed to decrypt image: %m");
+                }
+                if (r < 0)
+                        return r;
+
+                r = dissected_image_mount_and_warn(
+                                m,
+                                p,
+                                /* uid_shift= */ UID_INVALID,
+                                /* uid_range= */ UID_INVALID,
+                                /* userns_fd= */ -EBADF,
+                                flags);
+                if (r < 0 && r != -ENOMEDIUM)
+                        return r;
+                if (r == -ENOMEDIUM && !force)
+                        return 0;
+
+                r = dissected_image_relinquish(m);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to relinquish DM and loopback block devices: %m");
+
+                return 1;
+        }
+
+        default:
+                assert_not_reached();
+        }
+}
+
+static int mount_job_start(ImageClass image_class, MountJob *j, bool force) {
+        int r;
+
+        assert(j);
+
+        /* The worker shares our mount namespace, hence whatever it mounts stays around after it exits,
+         * and so do the relinquished loopback and DM devices backing it. */
+
+        r = safe_fork("(sd-dissect)", FORK_DEATHSIG_SIGTERM|FORK_LOG, &j->pid);
+        if (r < 0)
+                return r;
+        if (r == 0) {
+                r = mount_image(image_class, j->image, j->path, force, /* interactive= */ false);
+                _exit(r > 0 ? EXIT_SUCCESS :
+                      r == 0 ? MOUNT_WORKER_IGNORED :
+                      r == -ENOKEY ? MOUNT_WORKER_NEED_PASSPHRASE : EXIT_FAILURE);
+        }
+
+        return 0;
+}
+
+static int mount_job_wait(MountJob *j) {
+        int r;
+
+        assert(j);
+        assert(j->pid > 0);
+
+        r = wait_for_terminate_and_check("(sd-dissect)", TAKE_PID(j->pid), WAIT_LOG_ABNORMAL);
+        if (r < 0)
+                return r;
+
+        switch (r) {
+        case EXIT_SUCCESS:
+                j->result = 1;
+                break;
+        case MOUNT_WORKER_IGNORED:
+                j->result = 0;
+                break;
+        case MOUNT_WORKER_NEED_PASSPHRASE:
+                j->result = -ENOKEY;
+                break;
+        default: /* The worker logged about this already */
+                return -EPROTO;
+        }
+
+        return 0;
+}
+
+static int mount_images_in_workers(ImageClass image_class, MountJob *jobs, size_t n_jobs, bool force) {
+        _cleanup_free_ MountJob **queue = NULL;
+        size_t n_queue = 0;
+        int r, ret = 0;
+
+        assert(jobs || n_jobs == 0);
+
+        /* Setting up loopback and DM devices and waiting for their partitions to show up is what takes the
+         * most time when merging, but is entirely independent for each image. Hence do this in parallel
+         * for all disk images, and leave directories and anything that requires asking for a passphrase to
+         * the caller. */
+
+        queue = new(MountJob*, n_jobs);
+        if (!queue)
+                return log_oom();
+
+        FOREACH_ARRAY(j, jobs, n_jobs)
+                if (IN_SET(j->image->type, IMAGE_RAW, IMAGE_BLOCK))
+                        queue[n_queue++] = j;
+
+        for (size_t started = 0, finished = 0; finished < n_queue;) {
+                if (started < n_queue && started - finished < MOUNT_WORKERS_MAX) {
+                        r = mount_job_start(image_class, queue[started], force);
+                        if (r < 0) {
+                                /* Don't start any more workers, but wait for those already running */
+                                RET_GATHER(ret, r);
+                                n_queue = started;
+                        } else
+                                started++;
+
+                        continue;
+                }
+
+                RET_GATHER(ret, mount_job_wait(queue[finished++]));
+        }
+
+        return ret;
+}
+
 static int merge_subprocess(
                 ImageClass image_class,
                 char **hierarchies,
                 bool force,
                 int noexec,
                 Hashmap *images,
+                const char *fingerprint,
                 const char *workspace) {
 
         _cleanup_free_ char *host_os_release_id = NULL, *host_os_release_version_id = NULL, *host_os_release_api_level = NULL, *buf = NULL, *filename = NULL;
         _cleanup_strv_free_ char **extensions = NULL, **extensions_v = NULL, **paths = NULL;
-        size_t n_extensions = 0;
+        MountJob *jobs = NULL;
+        size_t n_extensions = 0, n_jobs = 0;
         unsigned n_ignored = 0;
         Image *img;
         int r;
 
+        CLEANUP_ARRAY(jobs, n_jobs, mount_job_array_free);
+
         assert(path_startswith(workspace, "/run/"));
 
         /* Mark the whole of /run as MS_SLAVE, so that we can mount stuff below it that doesn't show up on
@@ -1686,6 +1952,10 @@ static int merge_subprocess(
                                        empty_to_root(arg_root));
 
         /* Let's now mount all images */
+        jobs = new0(MountJob, hashmap_size(images));
+        if (!jobs)
+                return log_oom();
+
         HASHMAP_FOREACH(img, images) {
                 _cleanup_free_ char *p = NULL;
 
@@ -1697,111 +1967,28 @@ static int merge_subprocess(
                 if (r < 0)
                         return log_error_errno(r, "Failed to create %s: %m", p);
 
-                switch (img->type) {
-                case IMAGE_DIRECTORY:
-                case IMAGE_SUBVOLUME:
-
-                        if (!force) {
-                                r = extension_has_forbidden_content(p);
-                                if (r < 0)
-                                        return r;
-                                if (r > 0) {
-                                        n_ignored++;
-                                        continue;
-                                }
-                        }
-
-                        r = mount_nofollow_verbose(LOG_ERR, img->path, p, NULL, MS_BIND, NULL);
-                        if (r < 0)
-                                return r;
-
-                        /* Make this a read-only bind mount */
-                        r = bind_remount_recursive(p, MS_RDONLY, MS_RDONLY, NULL);
-                        if (r < 0)
-                                return log_error_errno(r, "Failed to make bind mount '%s' read-only: %m", p);
-
-                        break;
-
-                case IMAGE_RAW:
-                case IMAGE_BLOCK: {
-                        _cleanup_(dissected_image_unrefp) DissectedImage *m = NULL;
-                        _cleanup_(loop_device_unrefp) LoopDevice *d = NULL;
-                        _cleanup_(verity_settings_done) VeritySettings verity_settings = VERITY_SETTINGS_DEFAULT;
-                        DissectImageFlags flags =
-                                DISSECT_IMAGE_READ_ONLY |
-                                DISSECT_IMAGE_GENERIC_ROOT |
-                                DISSECT_IMAGE_REQUIRE_ROOT |
-                                DISSECT_IMAGE_MOUNT_ROOT_ONLY |
-                                DISSECT_IMAGE_USR_NO_ROOT |
-                                DISSECT_IMAGE_ADD_PARTITION_DEVICES |
-                                DISSECT_IMAGE_PIN_PARTITION_DEVICES |
-                                DISSECT_IMAGE_ALLOW_USERSPACE_VERITY;
-
-                        r = verity_settings_load(&verity_settings, img->path, NULL, NULL);
-                        if (r < 0)
-                                return log_error_errno(r, "Failed to read verity artifacts for %s: %m", img->path);
-
-                        if (verity_settings.data_path)
-                                flags |= DISSECT_IMAGE_NO_PARTITION_TABLE;
-
-                        if (!force)
-                                flags |= DISSECT_IMAGE_VALIDATE_OS_EXT;
-
-                        r = loop_device_make_by_path(
-                                        img->path,
-                                        O_RDONLY,
-                                        /* sector_size= */ UINT32_MAX,
-                                        FLAGS_SET(flags, DISSECT_IMAGE_NO_PARTITION_TABLE) ? 0 : LO_FLAGS_PARTSCAN,
-                                        LOCK_SH,
-                                        &d);
-                        if (r < 0)
-                                return log_error_errno(r, "Failed to set up loopback device for %s: %m", img->path);
-
-                        r = dissect_loop_device_and_warn(
-                                        d,
-                                        &verity_settings,
-                                        /* mount_options= */ NULL,
-                                        pick_image_policy(img),
-                                        flags,
-                                        &m);
-                        if (r < 0)
-                                return r;
-
-                        r = dissected_image_load_verity_sig_partition(
-                                        m,
-                                        d->fd,
-                                        &verity_settings);
-                        if (r < 0)
-                                return r;
+                jobs[n_jobs++] = (MountJob) {
+                        .image = img,
+                        .path = TAKE_PTR(p),
+                };
+        }
 
-                        r = dissected_image_decrypt_interactively(
-                                        m, NULL,
-                                        &verity_settings,
-                                        flags);
-                        if (r < 0)
-                                return r;
+        r = mount_images_in_workers(image_class, jobs, n_jobs, force);
+        if (r < 0)
+                return r;
 
-                        r = dissected_image_mount_and_warn(
-                                        m,
-                                        p,
-                                        /* uid_shift= */ UID_INVALID,
-                                        /* uid_range= */ UID_INVALID,
-                                        /* userns_fd= */ -EBADF,
-                                        flags);
-                        if (r < 0 && r != -ENOMEDIUM)
-                                return r;
-                        if (r == -ENOMEDIUM && !force) {
-                                n_ignored++;
-                                continue;
-                        }
+        FOREACH_ARRAY(j, jobs, n_jobs) {
+                img = j->image;
 
-                        r = dissected_image_relinquish(m);
-                        if (r < 0)
-                                return log_error_errno(r, "Failed to relinquish DM and loopback block devices: %m");
-                        break;
+                /* Directories are cheap to set up, and asking for passphrases is better done one by one */
+                if (IN_SET(img->type, IMAGE_DIRECTORY, IMAGE_SUBVOLUME) || j->result == -ENOKEY) {
+                        j->result = mount_image(image_class, img, j->path, force, /* interactive= */ true);
+                        if (j->result < 0)
+                                return j->result;
                 }
-                default:
-                        assert_not_reached();
+                if (j->result == 0) {
+                        n_ignored++;
+                        continue;
                 }
 
                 if (force)
@@ -1932,6 +2119,7 @@ static int merge_subprocess(
                                 noexec,
                                 extensions,
                                 paths,
+                                fingerprint,
                                 meta_path,
                                 overlay_path,
                                 merge_hierarchy_workspace);
@@ -1979,22 +2167,164 @@ static int merge_subprocess(
         return 1;
 }
 
+static int images_fingerprint(
+                Hashmap *images,
+                char **hierarchies,
+                bool force,
+                int noexec,
+                char **ret) {
+
+        _cleanup_strv_free_ char **l = NULL, **os_release = NULL;
+        _cleanup_free_ char *joined = NULL, *policy = NULL, *buf = NULL;
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        Image *img;
+        int r;
+
+        assert(ret);
+
+        /* Generates a hash over everything that goes into a merge: the identity of all images that are
+         * installed, the host's os-release data they are matched against, and the settings they are merged
+         * with. If this is unchanged on refresh, the current merge can be kept as is. This does not cover
+         * the contents of directory images nor of the mutable directories, see refresh_may_skip() for
+         * that. */
+
+        HASHMAP_FOREACH(img, images) {
+                struct stat st;
+
+                if (stat(img->path, &st) < 0)
+                        return log_error_errno(errno, "Failed to stat '%s': %m", img->path);
+
+                r = strv_extendf(&l, "%s:%s:" DEVNUM_FORMAT_STR ":%" PRIu64 ":" NSEC_FMT ":%" PRIu64,
+                                 img->name, img->path,
+                                 DEVNUM_FORMAT_VAL(st.st_dev), (uint64_t) st.st_ino,
+                                 timespec_load_nsec(&st.st_mtim), (uint64_t) st.st_size);
+                if (r < 0)
+                        return log_oom();
+        }
+
+        strv_sort(l);
+
+        r = load_os_release_pairs(arg_root, &os_release);
+        if (r < 0)
+                return log_error_errno(r, "Failed to acquire 'os-release' data of OS tree '%s': %m", empty_to_root(arg_root));
+
+        STRV_FOREACH_PAIR(k, v, os_release) {
+                r = strv_extendf(&l, "os-release:%s=%s", *k, *v);
+                if (r < 0)
+                        return log_oom();
+        }
+
+        if (arg_image_policy) {
+                r = image_policy_to_string(arg_image_policy, /* simplify= */ true, &policy);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to format image policy: %m");
+        }
+
+        joined = strv_join(hierarchies, ":");
+        if (!joined)
+                return log_oom();
+
+        r = strv_extendf(&l, "hierarchies=%s force=%s noexec=%i mutable=%i policy=%s",
+                         joined, yes_no(force), noexec, arg_mutable, strempty(policy));
+        if (r < 0)
+                return log_oom();
+
+        buf = strv_join(l, "\n");
+        if (!buf)
+                return log_oom();
+
+        char *h = hexmem(sha256_direct(buf, strlen(buf), digest), sizeof(digest));
+        if (!h)
+                return log_oom();
+
+        *ret = h;
+        return 0;
+}
+
+static bool refresh_may_skip(Hashmap *images) {
+        Image *img;
+
+        /* Directory images are bind mounted, and any file below them might have changed since the merge
+         * without the directory's own inode or mtime changing. Similar, in mutable mode the upper and
+         * import directories are set up from whatever is found in /var/lib/extensions.mutable/ at merge
+         * time, and in ephemeral modes the point of a refresh might very well be to start afresh. Hence
+         * we can only safely skip the refresh if only disk images are merged read-only. */
+
+        if (arg_mutable != MUTABLE_NO)
+                return false;
+
+        HASHMAP_FOREACH(img, images)
+                if (IN_SET(img->type, IMAGE_DIRECTORY, IMAGE_SUBVOLUME))
+                        return false;
+
+        return true;
+}
+
+static int merged_fingerprint_matches(ImageClass image_class, char **hierarchies, const char *fingerprint) {
+        bool found = false;
+        int r;
+
+        assert(fingerprint);
+
+        /* Checks whether all currently merged hierarchies were set up from exactly the images and settings
+         * the specified fingerprint was generated from. Hierarchies which are not merged had no content in
+         * any of the extensions then, and hence still don't now. */
+
+        STRV_FOREACH(p, hierarchies) {
+                _cleanup_free_ char *resolved = NULL, *f = NULL, *buf = NULL;
+
+                r = chase(*p, arg_root, CHASE_PREFIX_ROOT, &resolved, NULL);
+                if (r == -ENOENT)
+                        continue;
+                if (r < 0)
+                        return log_error_errno(r, "Failed to resolve path to hierarchy '%s%s': %m", strempty(arg_root), *p);
+
+                r = is_our_mount_point(image_class, resolved);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        continue;
+
+                f = path_join(resolved, image_class_info[image_class].dot_directory_name, "fingerprint");
+                if (!f)
+                        return log_oom();
+
+                r = read_one_line_file(f, &buf);
+                if (r == -ENOENT)
+                        return false;
+                if (r < 0)
+                        return log_error_errno(r, "Failed to read '%s': %m", f);
+
+                if (!streq(buf, fingerprint))
+                        return false;
+
+                found = true;
+        }
+
+        return found;
+}
+
 static int merge(ImageClass image_class,
                  char **hierarchies,
                  bool force,
                  bool no_reload,
                  int noexec,
                  Hashmap *images) {
+        _cleanup_free_ char *fingerprint = NULL;
         pid_t pid;
         int r;
 
+        r = images_fingerprint(images, hierarchies, force, noexec, &fingerprint);
+        if (r < 0)
+                return r;
+
         r = safe_fork("(sd-merge)", FORK_DEATHSIG_SIGTERM|FORK_LOG|FORK_NEW_MOUNTNS, &pid);
         if (r < 0)
                 return log_error_errno(r, "Failed to fork off child: %m");
         if (r == 0) {
                 /* Child with its own mount namespace */
 
-                r = merge_subprocess(image_class, hierarchies, force, noexec, images, "/run/systemd/sysext");
+                r = merge_subprocess(image_class, hierarchies, force, noexec, images, fingerprint, "/run/systemd/sysext");
                 if (r < 0)
                         _exit(EXIT_FAILURE);
 
@@ -2200,6 +2530,24 @@ static int refresh(
         if (r < 0)
                 return r;
 
+        if (!hashmap_isempty(images) && refresh_may_skip(images)) {
+                _cleanup_free_ char *fingerprint = NULL;
+
+                /* If the same images are merged with the same settings already, there's no point in
+                 * tearing everything down and building it up again. */
+                r = images_fingerprint(images, hierarchies, force, noexec, &fingerprint);
+                if (r < 0)
+                        return r;
+
+                r = merged_fingerprint_matches(image_class, hierarchies, fingerprint);
+                if (r < 0)
+                        return r;
+                if (r > 0) {
+                        log_info("Installed extensions are unchanged, not refreshing.");
+                        return 0;
+                }
+        }
+
         /* Returns > 0 if it did something, i.e. a new overlayfs is mounted now. When it does so it
          * implicitly unmounts any overlayfs placed there before. Returns == 0 if it did nothing, i.e. no
          * extension images found. In this case the old overlayfs remains in place if there was one. */
@@ -8,7 +8,7 @@
 
 int daemon_reload(enum action action, bool graceful) {
         _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
-        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL, *reply = NULL;
         const char *method;
         sd_bus *bus;
         int r;
@@ -22,7 +22,7 @@ int daemon_reload(enum action action, bool graceful) {
         switch (action) {
 
         case ACTION_RELOAD:
-                method = "Reload";
+                method = arg_incremental ? "ReloadChangedUnits" : "Reload";
                 break;
 
         case ACTION_REEXEC:
@@ -38,7 +38,23 @@ int daemon_reload(enum action action, bool graceful) {
                 return bus_log_create_error(r);
 
         /* Reloading the daemon may take long, hence set a longer timeout here */
-        r = sd_bus_call(bus, m, DAEMON_RELOAD_TIMEOUT_SEC, &error, NULL);
+        r = sd_bus_call(bus, m, DAEMON_RELOAD_TIMEOUT_SEC, &error, &reply);
+
+        /* Older managers don't know the incremental variant, do a full reload then */
+        if (r < 0 && streq(method, "ReloadChangedUnits") &&
+            sd_bus_error_has_name(&error, SD_BUS_ERROR_UNKNOWN_METHOD)) {
+                log_debug("Manager does not support incremental reloading, doing a full reload.");
+
+                sd_bus_error_free(&error);
+                m = sd_bus_message_unref(m);
+
+                method = "Reload";
+                r = bus_message_new_method_call(bus, &m, bus_systemd_mgr, method);
+                if (r < 0)
+                        return bus_log_create_error(r);
+
+                r = sd_bus_call(bus, m, DAEMON_RELOAD_TIMEOUT_SEC, &error, NULL);
+        }
 
         /* On reexecution, we expect a disconnect, not a reply */
         if (IN_SET(r, -ETIMEDOUT, -ECONNRESET) && action == ACTION_REEXEC)
@@ -54,6 +70,17 @@ int daemon_reload(enum action action, bool graceful) {
                                        method, bus_error_message(&error, r));
         }
 
+        if (streq(method, "ReloadChangedUnits")) {
+                int full;
+
+                r = sd_bus_message_read(reply, "b", &full);
+                if (r < 0)
+                        return bus_log_parse_error(r);
+
+                if (full)
+                        log_debug("Changed units could not be reloaded incrementally, a full reload was done.");
+        }
+
         return 1;
 }
 
@@ -83,6 +83,7 @@ bool arg_no_wtmp = false;
 bool arg_no_sync = false;
 bool arg_no_wall = false;
 bool arg_no_reload = false;
+bool arg_incremental = false;
 BusPrintPropertyFlags arg_print_flags = 0;
 bool arg_show_types = false;
 int arg_check_inhibitors = -1;
@@ -310,6 +311,7 @@ static int systemctl_help(void) {
                "     --no-wall           Don't send wall message before halt/power-off/reboot\n"
                "     --message=MESSAGE   Specify human readable reason for system shutdown\n"
                "     --no-reload         Don't reload daemon after en-/dis-abling unit files\n"
+               "     --incremental       For daemon-reload, only reload changed unit files\n"
                "     --legend=BOOL       Enable/disable the legend (column headers and hints)\n"
                "     --no-pager          Do not pipe output into a pager\n"
                "     --no-ask-password   Do not ask for system passwords\n"
@@ -449,6 +451,7 @@ static int systemctl_parse_argv(int argc, char *argv[]) {
                 ARG_IMAGE,
                 ARG_IMAGE_POLICY,
                 ARG_NO_RELOAD,
+                ARG_INCREMENTAL,
                 ARG_KILL_WHOM,
                 ARG_KILL_VALUE,
                 ARG_NO_ASK_PASSWORD,
@@ -514,6 +517,7 @@ static int systemctl_parse_argv(int argc, char *argv[]) {
                 { "image-policy",        required_argument, NULL, ARG_IMAGE_POLICY        },
                 { "force",               no_argument,       NULL, 'f'                     },
                 { "no-reload",           no_argument,       NULL, ARG_NO_RELOAD           },
+                { "incremental",         no_argument,       NULL, ARG_INCREMENTAL         },
                 { "kill-whom",           required_argument, NULL, ARG_KILL_WHOM           },
                 { "kill-value",          required_argument, NULL, ARG_KILL_VALUE          },
                 { "signal",              required_argument, NULL, 's'                     },
@@ -776,6 +780,10 @@ static int systemctl_parse_argv(int argc, char *argv[]) {
                         arg_no_reload = true;
                         break;
 
+                case ARG_INCREMENTAL:
+                        arg_incremental = true;
+                        break;
+
                 case ARG_KILL_WHOM:
                         arg_kill_whom = optarg;
                         break;
@@ -63,6 +63,7 @@ extern bool arg_no_wtmp;
 extern bool arg_no_sync;
 extern bool arg_no_wall;
 extern bool arg_no_reload;
+extern bool arg_incremental;
 extern BusPrintPropertyFlags arg_print_flags;
 extern bool arg_show_types;
 extern int arg_check_inhibitors;
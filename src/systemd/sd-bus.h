@@ -224,6 +224,7 @@ sd_event* sd_bus_get_event(sd_bus *bus);
 
 int sd_bus_get_n_queued_read(sd_bus *bus, uint64_t *ret);
 int sd_bus_get_n_queued_write(sd_bus *bus, uint64_t *ret);
+int sd_bus_get_n_written(sd_bus *bus, uint64_t *ret_messages, uint64_t *ret_writes);
 
 int sd_bus_set_method_call_timeout(sd_bus *bus, uint64_t usec);
 int sd_bus_get_method_call_timeout(sd_bus *bus, uint64_t *ret);
@@ -117,6 +117,9 @@ int sd_dhcp_client_set_mtu(
 int sd_dhcp_client_set_max_attempts(
                 sd_dhcp_client *client,
                 uint64_t attempt);
+int sd_dhcp_client_set_randomized_delay(
+                sd_dhcp_client *client,
+                uint64_t usec);
 int sd_dhcp_client_set_client_port(
                 sd_dhcp_client *client,
                 uint16_t port);
@@ -27,6 +27,7 @@
 #include <time.h>
 
 #include "_sd-common.h"
+#include "sd-json.h"
 
 /*
   Why is this better than pure epoll?
@@ -45,6 +46,9 @@ _SD_BEGIN_DECLARATIONS;
 typedef struct sd_event sd_event;
 typedef struct sd_event_source sd_event_source;
 
+struct io_uring_sqe;
+struct io_uring_cqe;
+
 enum {
         SD_EVENT_OFF = 0,
         SD_EVENT_ON = 1,
@@ -80,6 +84,9 @@ typedef int (*sd_event_child_handler_t)(sd_event_source *s, const siginfo_t *si,
 typedef void* sd_event_child_handler_t;
 #endif
 typedef int (*sd_event_inotify_handler_t)(sd_event_source *s, const struct inotify_event *event, void *userdata);
+typedef int (*sd_event_io_uring_handler_t)(sd_event_source *s, const struct io_uring_cqe *cqe, void *userdata);
+typedef int (*sd_event_work_func_t)(void *userdata);
+typedef int (*sd_event_work_handler_t)(sd_event_source *s, int result, void *userdata);
 typedef _sd_destroy_t sd_event_destroy_t;
 
 int sd_event_default(sd_event **e);
@@ -100,6 +107,8 @@ int sd_event_add_defer(sd_event *e, sd_event_source **s, sd_event_handler_t call
 int sd_event_add_post(sd_event *e, sd_event_source **s, sd_event_handler_t callback, void *userdata);
 int sd_event_add_exit(sd_event *e, sd_event_source **s, sd_event_handler_t callback, void *userdata);
 int sd_event_add_memory_pressure(sd_event *e, sd_event_source **s, sd_event_handler_t callback, void *userdata);
+int sd_event_add_io_uring(sd_event *e, sd_event_source **s, const struct io_uring_sqe *sqe, sd_event_io_uring_handler_t callback, void *userdata);
+int sd_event_add_work(sd_event *e, sd_event_source **s, sd_event_work_func_t work, sd_event_work_handler_t callback, void *userdata);
 
 int sd_event_prepare(sd_event *e);
 int sd_event_wait(sd_event *e, uint64_t usec);
@@ -118,6 +127,8 @@ int sd_event_set_watchdog(sd_event *e, int b);
 int sd_event_get_watchdog(sd_event *e);
 int sd_event_get_iteration(sd_event *e, uint64_t *ret);
 int sd_event_set_signal_exit(sd_event *e, int b);
+int sd_event_set_statistics(sd_event *e, int b);
+int sd_event_get_statistics(sd_event *e, sd_json_variant **ret);
 
 sd_event_source* sd_event_source_ref(sd_event_source *s);
 sd_event_source* sd_event_source_unref(sd_event_source *s);
@@ -164,6 +175,7 @@ int sd_event_source_get_inotify_mask(sd_event_source *s, uint32_t *ret);
 int sd_event_source_get_inotify_path(sd_event_source *s, const char **ret);
 int sd_event_source_set_memory_pressure_type(sd_event_source *e, const char *ty);
 int sd_event_source_set_memory_pressure_period(sd_event_source *s, uint64_t threshold_usec, uint64_t window_usec);
+int sd_event_source_set_io_uring_sqe(sd_event_source *s, const struct io_uring_sqe *sqe);
 int sd_event_source_set_destroy_callback(sd_event_source *s, sd_event_destroy_t callback);
 int sd_event_source_get_destroy_callback(sd_event_source *s, sd_event_destroy_t *ret);
 int sd_event_source_get_floating(sd_event_source *s);
@@ -152,6 +152,7 @@ __extension__ typedef enum _SD_ENUM_TYPE_S64(sd_json_format_flags_t) {
 } sd_json_format_flags_t;
 
 int sd_json_variant_format(sd_json_variant *v, sd_json_format_flags_t flags, char **ret);
+int sd_json_variant_format_append(sd_json_variant *v, sd_json_format_flags_t flags, char **buffer, size_t *size);
 int sd_json_variant_dump(sd_json_variant *v, sd_json_format_flags_t flags, FILE *f, const char *prefix);
 
 int sd_json_variant_filter(sd_json_variant **v, char **to_remove);
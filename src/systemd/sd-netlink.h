@@ -228,6 +228,11 @@ int sd_rtnl_message_new_mdb(sd_netlink *rtnl, sd_netlink_message **ret, uint16_t
 
 int sd_rtnl_message_new_nsid(sd_netlink *rtnl, sd_netlink_message **ret, uint16_t nlmsg_type);
 
+int sd_rtnl_message_new_stats(sd_netlink *rtnl, sd_netlink_message **ret, uint16_t nlmsg_type, int ifindex,
+                              uint32_t filter_mask);
+/* struct if_stats_msg */
+int sd_rtnl_message_stats_get_ifindex(sd_netlink_message *m, int *ret); /* ifindex */
+
 /* genl */
 int sd_genl_socket_open(sd_netlink **ret);
 int sd_genl_message_new(sd_netlink *genl, const char *family_name, uint8_t cmd, sd_netlink_message **ret);
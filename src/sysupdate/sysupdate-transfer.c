@@ -498,6 +498,7 @@ int transfer_read_definition(Transfer *t, const char *path, const char **dirs, H
                 { "Transfer",    "MinVersion",              config_parse_min_version,          0, &t->min_version             },
                 { "Transfer",    "ProtectVersion",          config_parse_protect_version,      0, &t->protected_versions      },
                 { "Transfer",    "Verify",                  config_parse_bool,                 0, &t->verify                  },
+                { "Transfer",    "Delta",                   config_parse_bool,                 0, &t->delta                   },
                 { "Transfer",    "ChangeLog",               config_parse_url_specifiers,       0, &t->changelog               },
                 { "Transfer",    "AppStream",               config_parse_url_specifiers,       0, &t->appstream               },
                 { "Transfer",    "Features",                config_parse_strv,                 0, &t->features                },
@@ -1124,8 +1125,44 @@ static int run_callout(
         return sd_event_loop(event);
 }
 
+static int transfer_delta_args(Transfer *t, char ***ret) {
+        _cleanup_strv_free_ char **l = NULL;
+        Instance *seed;
+        int r;
+
+        assert(t);
+        assert(ret);
+
+        /* Seed chunked downloads with the newest installed version, which is the one most likely to share
+         * data with the new one. */
+
+        if (!t->delta || t->target.n_instances == 0) {
+                *ret = NULL;
+                return 0;
+        }
+
+        seed = t->target.instances[0];
+
+        if (t->target.type == RESOURCE_PARTITION) {
+                r = strv_extendf(&l, "--delta-seed=%s", t->target.path);
+                if (r < 0)
+                        return log_oom();
+
+                r = strv_extendf(&l, "--delta-seed-offset=%" PRIu64, seed->partition_info.start);
+        } else
+                r = strv_extendf(&l, "--delta-seed=%s", seed->path);
+        if (r < 0)
+                return log_oom();
+
+        log_debug("Using '%s' as seed for delta download.", seed->path);
+
+        *ret = TAKE_PTR(l);
+        return 1;
+}
+
 int transfer_acquire_instance(Transfer *t, Instance *i, TransferProgress cb, void *userdata) {
         _cleanup_free_ char *formatted_pattern = NULL, *digest = NULL;
+        _cleanup_strv_free_ char **cmdline = NULL, **delta = NULL;
         char offset[DECIMAL_STR_MAX(uint64_t)+1], max_size[DECIMAL_STR_MAX(uint64_t)+1];
         const char *where = NULL;
         InstanceMetadata f;
@@ -1301,34 +1338,48 @@ int transfer_acquire_instance(Transfer *t, Instance *i, TransferProgress cb, voi
 
                         /* url file → regular file */
 
-                        r = run_callout("(sd-pull-raw)",
-                                       STRV_MAKE(
-                                               SYSTEMD_PULL_PATH,
-                                               "raw",
-                                               "--direct",          /* just download the specified URL, don't download anything else */
-                                               "--verify", digest,  /* validate by explicit SHA256 sum */
-                                               arg_sync ? "--sync=yes" : "--sync=no",
-                                               i->path,
-                                               t->temporary_path),
-                                        t, i, cb, userdata);
+                        r = transfer_delta_args(t, &delta);
+                        if (r < 0)
+                                return r;
+
+                        cmdline = strv_new(SYSTEMD_PULL_PATH,
+                                           "raw",
+                                           "--direct",          /* just download the specified URL, don't download anything else */
+                                           "--verify", digest,  /* validate by explicit SHA256 sum */
+                                           arg_sync ? "--sync=yes" : "--sync=no");
+                        if (!cmdline)
+                                return log_oom();
+
+                        if (strv_extend_strv(&cmdline, delta, /* filter_duplicates= */ false) < 0 ||
+                            strv_extend_many(&cmdline, i->path, t->temporary_path) < 0)
+                                return log_oom();
+
+                        r = run_callout("(sd-pull-raw)", cmdline, t, i, cb, userdata);
                         break;
 
                 case RESOURCE_PARTITION:
 
                         /* url file → partition */
 
-                        r = run_callout("(sd-pull-raw)",
-                                        STRV_MAKE(
-                                               SYSTEMD_PULL_PATH,
-                                               "raw",
-                                               "--direct",              /* just download the specified URL, don't download anything else */
-                                               "--verify", digest,      /* validate by explicit SHA256 sum */
-                                               "--offset", offset,
-                                               "--size-max", max_size,
-                                               arg_sync ? "--sync=yes" : "--sync=no",
-                                               i->path,
-                                               t->target.path),
-                                        t, i, cb, userdata);
+                        r = transfer_delta_args(t, &delta);
+                        if (r < 0)
+                                return r;
+
+                        cmdline = strv_new(SYSTEMD_PULL_PATH,
+                                           "raw",
+                                           "--direct",              /* just download the specified URL, don't download anything else */
+                                           "--verify", digest,      /* validate by explicit SHA256 sum */
+                                           "--offset", offset,
+                                           "--size-max", max_size,
+                                           arg_sync ? "--sync=yes" : "--sync=no");
+                        if (!cmdline)
+                                return log_oom();
+
+                        if (strv_extend_strv(&cmdline, delta, /* filter_duplicates= */ false) < 0 ||
+                            strv_extend_many(&cmdline, i->path, t->target.path) < 0)
+                                return log_oom();
+
+                        r = run_callout("(sd-pull-raw)", cmdline, t, i, cb, userdata);
                         break;
 
                 default:
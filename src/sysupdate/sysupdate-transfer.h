@@ -21,6 +21,7 @@ struct Transfer {
         char **protected_versions;
         char *current_symlink;
         bool verify;
+        bool delta;
 
         char **features;
         char **requisite_features;
@@ -112,5 +112,18 @@ int main(int argc, const char *argv[]) {
         ASSERT_EQ(bitmap_set(b2, 0), 0);
         assert_se(bitmap_equal(b, b2));
 
+        bitmap_clear(b);
+        ASSERT_EQ(bitmap_find_unset(NULL, 5), 5u);
+        ASSERT_EQ(bitmap_find_unset(b, 5), 5u);
+        for (unsigned i = 0; i < 130; i++)
+                ASSERT_EQ(bitmap_set(b, i), 0);
+        bitmap_unset(b, 70);
+        ASSERT_EQ(bitmap_find_unset(b, 0), 70u);
+        ASSERT_EQ(bitmap_find_unset(b, 70), 70u);
+        ASSERT_EQ(bitmap_find_unset(b, 71), 130u);
+        ASSERT_EQ(bitmap_find_unset(b, 200), 200u);
+        ASSERT_EQ(bitmap_set(b, 70), 0);
+        ASSERT_EQ(bitmap_find_unset(b, 3), 130u);
+
         return 0;
 }
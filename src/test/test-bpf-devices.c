@@ -11,6 +11,7 @@
 #include "errno-list.h"
 #include "fd-util.h"
 #include "fs-util.h"
+#include "hashmap.h"
 #include "path-util.h"
 #include "tests.h"
 
@@ -27,7 +28,7 @@ static void test_policy_closed(const char *cgroup_path, BPFProgram **installed_p
         r = bpf_devices_allow_list_static(prog, cgroup_path);
         ASSERT_OK(r);
 
-        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_CLOSED, true, cgroup_path, installed_prog);
+        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_CLOSED, true, cgroup_path, /* cache= */ NULL, installed_prog);
         ASSERT_OK(r);
 
         FOREACH_STRING(s, "/dev/null",
@@ -70,7 +71,7 @@ static void test_policy_strict(const char *cgroup_path, BPFProgram **installed_p
         r = bpf_devices_allow_list_device(prog, cgroup_path, "/dev/zero", CGROUP_DEVICE_WRITE);
         ASSERT_OK(r);
 
-        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_STRICT, true, cgroup_path, installed_prog);
+        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_STRICT, true, cgroup_path, /* cache= */ NULL, installed_prog);
         ASSERT_OK(r);
 
         {
@@ -141,7 +142,7 @@ static void test_policy_allow_list_major(const char *pattern, const char *cgroup
         r = bpf_devices_allow_list_major(prog, cgroup_path, pattern, 'c', CGROUP_DEVICE_READ|CGROUP_DEVICE_WRITE);
         ASSERT_OK(r);
 
-        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_STRICT, true, cgroup_path, installed_prog);
+        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_STRICT, true, cgroup_path, /* cache= */ NULL, installed_prog);
         ASSERT_OK(r);
 
         /* /dev/null, /dev/full have major==1, /dev/tty has major==5 */
@@ -200,7 +201,7 @@ static void test_policy_allow_list_major_star(char type, const char *cgroup_path
         r = bpf_devices_allow_list_major(prog, cgroup_path, "*", type, CGROUP_DEVICE_READ|CGROUP_DEVICE_WRITE);
         ASSERT_OK(r);
 
-        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_STRICT, true, cgroup_path, installed_prog);
+        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_STRICT, true, cgroup_path, /* cache= */ NULL, installed_prog);
         ASSERT_OK(r);
 
         {
@@ -233,7 +234,7 @@ static void test_policy_empty(bool add_mismatched, const char *cgroup_path, BPFP
                 assert_se(r < 0);
         }
 
-        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_STRICT, false, cgroup_path, installed_prog);
+        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_STRICT, false, cgroup_path, /* cache= */ NULL, installed_prog);
         ASSERT_OK(r);
 
         {
@@ -248,6 +249,51 @@ static void test_policy_empty(bool add_mismatched, const char *cgroup_path, BPFP
         assert_se(wrong == 0);
 }
 
+static void test_policy_shared(const char *cgroup_path) {
+        _cleanup_(bpf_program_freep) BPFProgram *prog = NULL, *installed = NULL, *child_installed = NULL;
+        _cleanup_hashmap_free_ Hashmap *cache = NULL;
+        _cleanup_free_ char *child = NULL;
+        uint32_t id, child_id;
+        BPFProgram *p;
+        int r;
+
+        log_info("/* %s */", __func__);
+
+        ASSERT_NOT_NULL(child = path_join(cgroup_path, "shared"));
+        ASSERT_OK(cg_create(SYSTEMD_CGROUP_CONTROLLER, child));
+
+        ASSERT_OK(bpf_devices_cgroup_init(&prog, CGROUP_DEVICE_POLICY_CLOSED, true));
+        ASSERT_OK(bpf_devices_allow_list_static(prog, cgroup_path));
+        ASSERT_OK(bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_CLOSED, true, cgroup_path, &cache, &installed));
+        ASSERT_NOT_NULL(installed);
+        ASSERT_OK(bpf_program_get_id_by_fd(installed->kernel_fd, &id));
+
+        /* Applying the same policy again keeps the installed program in place */
+        p = installed;
+        ASSERT_OK(bpf_devices_cgroup_init(&prog, CGROUP_DEVICE_POLICY_CLOSED, true));
+        ASSERT_OK(bpf_devices_allow_list_static(prog, cgroup_path));
+        ASSERT_OK(bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_CLOSED, true, cgroup_path, &cache, &installed));
+        ASSERT_TRUE(installed == p);
+        ASSERT_NULL(prog);
+
+        /* Applying the same policy to another cgroup reuses the loaded program */
+        ASSERT_OK(bpf_devices_cgroup_init(&prog, CGROUP_DEVICE_POLICY_CLOSED, true));
+        ASSERT_OK(bpf_devices_allow_list_static(prog, child));
+        r = bpf_devices_apply_policy(&prog, CGROUP_DEVICE_POLICY_CLOSED, true, child, &cache, &child_installed);
+        if (r < 0 && ERRNO_IS_PRIVILEGE(r)) {
+                log_tests_skipped_errno(r, "Cannot attach BPF program to child cgroup");
+                goto finish;
+        }
+        ASSERT_OK(r);
+        ASSERT_NOT_NULL(child_installed);
+        ASSERT_OK(bpf_program_get_id_by_fd(child_installed->kernel_fd, &child_id));
+        ASSERT_EQ(child_id, id);
+
+finish:
+        child_installed = bpf_program_free(child_installed);
+        (void) cg_trim(SYSTEMD_CGROUP_CONTROLLER, child, /* delete_root= */ true);
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_free_ char *cgroup = NULL, *parent = NULL;
         _cleanup_(rmdir_and_freep) char *controller_path = NULL;
@@ -296,6 +342,8 @@ int main(int argc, char *argv[]) {
         test_policy_empty(false, cgroup, &prog);
         test_policy_empty(true, cgroup, &prog);
 
+        test_policy_shared(cgroup);
+
         ASSERT_OK(path_extract_directory(cgroup, &parent));
 
         ASSERT_OK(cg_mask_supported(&supported));
@@ -269,6 +269,78 @@ static void test_lz4_decompress_partial(void) {
 }
 #endif
 
+#if HAVE_ZSTD
+static int compress_stream_zstd_threaded(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_uncompressed_size) {
+        return compress_stream_zstd_full(fdf, fdt, max_bytes, /* n_threads= */ 2, ret_uncompressed_size);
+}
+
+static void test_zstd_dictionary(void) {
+        _cleanup_(compress_dictionary_freep) CompressDictionary *d = NULL;
+        _cleanup_free_ size_t *sizes = NULL;
+        _cleanup_free_ char *samples = NULL;
+        _cleanup_free_ void *dict = NULL, *decompressed = NULL;
+        const char *msg = "MESSAGE=Started session 4711 of user alice.";
+        size_t n = 0, dict_size, csize, dsize, plain_csize;
+        char buf[512], buf2[512];
+        int r;
+
+        log_debug("/* %s */", __func__);
+
+        /* Lots of similar, but not identical, short log messages */
+        for (unsigned i = 0; i < 2000; i++) {
+                char line[LINE_MAX];
+                int k;
+
+                k = snprintf(line, sizeof(line), "MESSAGE=Started session %u of user %s.", i,
+                             (const char*[]) { "root", "alice", "bob", "carol" }[i % 4]);
+                assert_se(k > 0);
+
+                assert_se(GREEDY_REALLOC(samples, n + k));
+                assert_se(GREEDY_REALLOC(sizes, i + 1));
+                memcpy(samples + n, line, k);
+                n += k;
+                sizes[i] = k;
+        }
+
+        r = compress_dictionary_train_zstd(samples, sizes, 2000, 4096, &dict, &dict_size);
+        if (r == -EOPNOTSUPP)
+                return (void) log_tests_skipped_errno(r, "zstd dictionary training");
+        ASSERT_OK(r);
+        assert_se(dict_size > 0 && dict_size <= 4096);
+
+        ASSERT_OK(compress_dictionary_new_zstd(dict, dict_size, /* level = */ -1, &d));
+
+        ASSERT_OK(compress_blob_zstd_dictionary(d, msg, strlen(msg), buf, sizeof(buf), &csize));
+        log_info("Compressed %zu → %zu with dictionary", strlen(msg), csize);
+
+        /* The whole point of the dictionary: beat compressing the message on its own */
+        r = compress_blob_zstd(msg, strlen(msg), buf2, sizeof(buf2), &plain_csize, /* level = */ -1);
+        if (r >= 0)
+                assert_se(csize < plain_csize);
+        else
+                ASSERT_ERROR(r, ENOBUFS);
+
+        ASSERT_OK(decompress_blob_zstd_dictionary(d, buf, csize, &decompressed, &dsize, 0));
+        assert_se(memcmp_nn(decompressed, dsize, msg, strlen(msg)) == 0);
+
+        /* Repeat, to make sure the reused contexts are reset properly */
+        decompressed = mfree(decompressed);
+        ASSERT_OK(decompress_blob_zstd_dictionary(d, buf, csize, &decompressed, &dsize, 0));
+        assert_se(memcmp_nn(decompressed, dsize, msg, strlen(msg)) == 0);
+
+        ASSERT_OK_POSITIVE(decompress_startswith_zstd_dictionary(d, buf, csize, &decompressed,
+                                                                 "MESSAGE", STRLEN("MESSAGE"), '='));
+        ASSERT_OK_ZERO(decompress_startswith_zstd_dictionary(d, buf, csize, &decompressed,
+                                                             "MESSAGE", STRLEN("MESSAGE"), 'x'));
+
+        /* Data compressed with the dictionary can't be decompressed without it */
+        decompressed = mfree(decompressed);
+        assert_se(decompress_blob_zstd(buf, csize, &decompressed, &dsize, 0) < 0);
+
+        assert_se(decompress_blob_zstd_dictionary(d, "garbage", 7, &decompressed, &dsize, 0) < 0);
+}
+#endif
+
 int main(int argc, char *argv[]) {
 #if HAVE_COMPRESSION
         _unused_ const char text[] =
@@ -363,8 +435,12 @@ int main(int argc, char *argv[]) {
 
         test_compress_stream("ZSTD", "zstdcat",
                              compress_stream_zstd, decompress_stream_zstd, srcfile);
+        test_compress_stream("ZSTD", "zstdcat",
+                             compress_stream_zstd_threaded, decompress_stream_zstd, srcfile);
 
         test_decompress_startswith_short("ZSTD", compress_blob_zstd, decompress_startswith_zstd);
+
+        test_zstd_dictionary();
 #else
         log_info("/* ZSTD test skipped */");
 #endif
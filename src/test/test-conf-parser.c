@@ -322,6 +322,11 @@ static const char* const config_file[] = {
         "setting1=3\n"
         "[X-Section]\n"
         "setting1=3\n",
+
+        "[Section]\r\n"
+        "setting1=1\\\r\n"   /* DOS line endings, with continuation */
+        "2\\\r"              /* old MacOS line endings */
+        "3\n\r",
 };
 
 static void test_config_parse_one(unsigned i, const char *s) {
@@ -396,6 +401,11 @@ static void test_config_parse_one(unsigned i, const char *s) {
                 assert_se(r == 1);
                 ASSERT_STREQ(setting1, "2");
                 break;
+
+        case 18:
+                assert_se(r == 1);
+                ASSERT_STREQ(setting1, "1 2 3");
+                break;
         }
 }
 
@@ -18,6 +18,7 @@
 #include "path-util.h"
 #include "random-util.h"
 #include "rm-rf.h"
+#include "stat-util.h"
 #include "string-util.h"
 #include "strv.h"
 #include "tests.h"
@@ -253,6 +254,72 @@ TEST(copy_tree) {
         (void) rm_rf(original_dir, REMOVE_ROOT|REMOVE_PHYSICAL);
 }
 
+TEST(copy_tree_many_files) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_close_ int tfd = -EBADF;
+
+        /* Enough files of various sizes for the worker threads to actually race each other */
+
+        ASSERT_OK(tfd = mkdtemp_open(NULL, O_PATH, &t));
+        ASSERT_OK_ERRNO(mkdirat(tfd, "src", 0755));
+        for (unsigned i = 0; i < 8; i++) {
+                _cleanup_free_ char *dir = NULL;
+
+                ASSERT_OK(asprintf(&dir, "src/dir%u", i));
+                ASSERT_OK_ERRNO(mkdirat(tfd, dir, 0755));
+        }
+
+        for (unsigned i = 0; i < 400; i++) {
+                _cleanup_free_ char *fn = NULL, *buf = NULL;
+                _cleanup_close_ int fd = -EBADF;
+                size_t sz = (i * 7919) % (256 * 1024);
+
+                ASSERT_OK(asprintf(&fn, "src/dir%u/file%u", i % 8, i));
+
+                ASSERT_NOT_NULL(buf = malloc(sz));
+                random_bytes(buf, sz);
+
+                ASSERT_OK_ERRNO(fd = openat(tfd, fn, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0600 | (i % 2 == 0 ? 0044 : 0)));
+                ASSERT_OK(loop_write(fd, buf, sz));
+
+                if (i % 10 == 0) {
+                        _cleanup_free_ char *ln = NULL;
+
+                        ASSERT_OK(asprintf(&ln, "src/link%u", i));
+                        ASSERT_OK_ERRNO(linkat(tfd, fn, tfd, ln, 0));
+                }
+        }
+
+        ASSERT_OK(copy_tree_at(tfd, "src", tfd, "dst", UID_INVALID, GID_INVALID, COPY_REFLINK|COPY_HARDLINKS, NULL, NULL));
+
+        for (unsigned i = 0; i < 400; i++) {
+                _cleanup_free_ char *fn = NULL, *a = NULL, *b = NULL, *src = NULL, *dst = NULL;
+                size_t asz, bsz;
+                struct stat sta, stb;
+
+                ASSERT_OK(asprintf(&fn, "dir%u/file%u", i % 8, i));
+                ASSERT_NOT_NULL(src = path_join(t, "src", fn));
+                ASSERT_NOT_NULL(dst = path_join(t, "dst", fn));
+
+                ASSERT_OK(read_full_file(src, &a, &asz));
+                ASSERT_OK(read_full_file(dst, &b, &bsz));
+                ASSERT_EQ(memcmp_nn(a, asz, b, bsz), 0);
+
+                ASSERT_OK_ERRNO(stat(src, &sta));
+                ASSERT_OK_ERRNO(stat(dst, &stb));
+                ASSERT_EQ(sta.st_mode, stb.st_mode);
+
+                if (i % 10 == 0) {
+                        _cleanup_free_ char *ln = NULL;
+                        struct stat stl;
+
+                        ASSERT_OK(asprintf(&ln, "dst/link%u", i));
+                        ASSERT_OK_ERRNO(fstatat(tfd, ln, &stl, AT_SYMLINK_NOFOLLOW));
+                        ASSERT_TRUE(stat_inode_same(&stb, &stl));
+                }
+        }
+}
+
 TEST(copy_tree_at_symlink) {
         _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
         _cleanup_close_ int tfd = -EBADF, fd = -EBADF;
@@ -17,6 +17,7 @@
 #include "macro.h"
 #include "path-util.h"
 #include "rm-rf.h"
+#include "serialize.h"
 #include "string-util.h"
 #include "strv.h"
 #include "tests.h"
@@ -410,6 +411,53 @@ TEST(error_catching) {
         assert_se(r == 42);
 }
 
+TEST(parallelism_and_timing) {
+        _cleanup_(rm_rf_physical_and_freep) char *tmpdir = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        ExecTiming *t = NULL;
+        size_t n = 0;
+
+        CLEANUP_ARRAY(t, n, exec_timing_free_many);
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/test-exec-util.XXXXXXX", &tmpdir));
+
+        const char *dirs[] = { tmpdir, NULL };
+
+        /* Each script fails if it runs concurrently with any of the others */
+        FOREACH_STRING(s, "10-a", "20-b", "30-c", "40-d") {
+                _cleanup_free_ char *p = NULL;
+
+                ASSERT_NOT_NULL(p = path_join(tmpdir, s));
+                ASSERT_OK(write_string_file(p,
+                                            "#!/bin/sh\nmkdir \"$(dirname $0)/lock\" || exit 1\nsleep 0.1\nrmdir \"$(dirname $0)/lock\"\n",
+                                            WRITE_STRING_FILE_CREATE));
+                ASSERT_OK_ERRNO(chmod(p, 0755));
+
+                if (access(p, X_OK) < 0 && ERRNO_IS_PRIVILEGE(errno))
+                        return (void) log_tests_skipped("cannot execute scripts");
+        }
+
+        ASSERT_OK(fd = open_serialization_fd("timings"));
+
+        ASSERT_OK_ZERO(execute_directories_full(
+                                       dirs, DEFAULT_TIMEOUT_USEC,
+                                       /* callbacks = */ NULL, /* callback_args = */ NULL,
+                                       /* argv = */ NULL, /* envp = */ NULL,
+                                       EXEC_DIR_PARALLEL,
+                                       /* max_parallel = */ 1,
+                                       fd));
+
+        ASSERT_OK(finish_serialization_fd(fd));
+        ASSERT_OK(exec_timing_read(TAKE_FD(fd), &t, &n));
+        ASSERT_EQ(n, 4U);
+
+        FOREACH_ARRAY(i, t, n) {
+                log_debug("%s: %s", i->path, FORMAT_TIMESPAN(i->duration, USEC_PER_MSEC));
+                ASSERT_TRUE(path_startswith(i->path, tmpdir));
+                ASSERT_GE(i->duration, 100 * USEC_PER_MSEC);
+        }
+}
+
 TEST(exec_command_flags_from_strv) {
         ExecCommandFlags flags = 0;
         char **valid_strv = STRV_MAKE("no-env-expand", "no-setuid", "ignore-failure");
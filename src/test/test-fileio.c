@@ -13,6 +13,7 @@
 #include "fd-util.h"
 #include "fileio.h"
 #include "fs-util.h"
+#include "io-util.h"
 #include "iovec-util.h"
 #include "memfd-util.h"
 #include "parse-util.h"
@@ -1084,6 +1085,47 @@ TEST(read_virtual_file) {
         test_read_virtual_file_one(SIZE_MAX);
 }
 
+TEST(pread_virtual_file) {
+        _cleanup_free_ char *buf = NULL, *big = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        size_t size;
+
+        fd = RET_NERRNO(open("/proc/self/stat", O_RDONLY|O_CLOEXEC));
+        if (fd < 0)
+                return (void) log_tests_skipped_errno(fd, "Failed to open /proc/self/stat");
+
+        /* The same fd can be read over and over again */
+        for (unsigned i = 0; i < 3; i++) {
+                pid_t pid;
+
+                buf = mfree(buf);
+                ASSERT_OK(pread_virtual_file(fd, &buf, &size));
+                ASSERT_GT(size, 0U);
+                ASSERT_EQ(strlen(buf), size);
+                buf[strcspn(buf, WHITESPACE)] = 0;
+                ASSERT_OK(parse_pid(buf, &pid));
+                ASSERT_EQ(pid, getpid_cached());
+        }
+
+        /* Contents larger than the initial buffer */
+        fd = safe_close(fd);
+        fd = memfd_new("pread_virtual_file");
+        if (fd < 0) {
+                assert_se(ERRNO_IS_NOT_SUPPORTED(fd));
+                return;
+        }
+
+        ASSERT_NOT_NULL(big = malloc(3 * page_size() + 1));
+        memset(big, 'x', 3 * page_size());
+        big[3 * page_size()] = 0;
+        ASSERT_OK(loop_write(fd, big, 3 * page_size()));
+
+        buf = mfree(buf);
+        ASSERT_OK(pread_virtual_file(fd, &buf, &size));
+        ASSERT_EQ(size, 3 * page_size());
+        ASSERT_STREQ(buf, big);
+}
+
 TEST(fdopen_independent) {
 #define TEST_TEXT "this is some random test text we are going to write to a memfd"
         _cleanup_close_ int fd = -EBADF;
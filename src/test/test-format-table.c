@@ -5,6 +5,7 @@
 #include "alloc-util.h"
 #include "format-table.h"
 #include "json-util.h"
+#include "memstream-util.h"
 #include "string-util.h"
 #include "strv.h"
 #include "terminal-util.h"
@@ -836,6 +837,71 @@ TEST(table_bps) {
                      "2500000000         2.3G           2.5Gbps\n");
 }
 
+TEST(stream) {
+        _cleanup_(table_unrefp) Table *t = NULL;
+        _cleanup_(memstream_done) MemStream m = {};
+        _cleanup_free_ char *buf = NULL;
+        FILE *f;
+
+        ASSERT_NOT_NULL(t = table_new("unit", "state", "n"));
+        table_set_width(t, 0);
+        ASSERT_NOT_NULL(f = memstream_init(&m));
+        ASSERT_OK(table_set_stream(t, f, 2));
+
+        ASSERT_OK(table_add_many(t, TABLE_STRING, "a.service", TABLE_STRING, "active", TABLE_UINT, 1U));
+        ASSERT_OK(table_add_many(t, TABLE_STRING, "bb.service", TABLE_STRING, "inactive", TABLE_UINT, 22U));
+
+        /* Nothing written before the widths are fixed */
+        ASSERT_OK_ERRNO(fflush(f));
+        ASSERT_EQ(m.sz, 0U);
+
+        /* This fixes the widths and writes out the first rows, hence the wider string is ellipsized, while the
+         * number overflows its column */
+        ASSERT_OK(table_add_many(t, TABLE_STRING, "verylongname.service", TABLE_STRING, "active", TABLE_UINT, 333U));
+        ASSERT_OK_ERRNO(fflush(f));
+        ASSERT_GT(m.sz, 0U);
+
+        ASSERT_OK(table_add_many(t, TABLE_STRING, "c.service", TABLE_STRING, "failed", TABLE_UINT, 4U));
+        ASSERT_OK(table_add_many(t, TABLE_STRING, "d.service", TABLE_STRING, "active", TABLE_UINT, 5U));
+        ASSERT_EQ(table_get_rows(t), 6U);
+
+        ASSERT_OK(table_print(t, NULL));
+        ASSERT_OK(memstream_finalize(&m, &buf, NULL));
+
+        printf("%s", buf);
+        ASSERT_STREQ(buf,
+                     "UNIT       STATE    N\n"
+                     "a.service  active   1\n"
+                     "bb.service inactive 22\n"
+                     "verylongn… active   333\n"
+                     "c.service  failed   4\n"
+                     "d.service  active   5\n");
+}
+
+TEST(intern) {
+        _cleanup_(table_unrefp) Table *t = NULL;
+        _cleanup_free_ char *formatted = NULL;
+        TableCell *cell;
+
+        ASSERT_NOT_NULL(t = table_new("x", "y"));
+        table_set_width(t, 0);
+
+        /* Strings in non-adjacent rows share their data, hence changing one cell must not affect the others */
+        ASSERT_OK(table_add_many(t, TABLE_STRING, "loaded", TABLE_STRING, "active"));
+        ASSERT_OK(table_add_many(t, TABLE_STRING, "masked", TABLE_STRING, "inactive"));
+        ASSERT_OK(table_add_cell(t, NULL, TABLE_STRING, "loaded"));
+        ASSERT_OK(table_add_cell(t, &cell, TABLE_STRING, "active"));
+        ASSERT_OK(table_set_uppercase(t, cell, true));
+
+        ASSERT_OK(table_format(t, &formatted));
+        printf("%s", formatted);
+        ASSERT_STREQ(formatted,
+                     "X      Y\n"
+                     "loaded active\n"
+                     "masked inactive\n"
+                     "loaded ACTIVE\n");
+}
+
 static int intro(void) {
         ASSERT_OK(setenv("SYSTEMD_COLORS", "0", 1));
         ASSERT_OK(setenv("COLUMNS", "40", 1));
@@ -2,6 +2,7 @@
 
 #include "tests.h"
 #include "hash-funcs.h"
+#include "hashmap.h"
 #include "set.h"
 
 TEST(path_hash_set) {
@@ -74,4 +75,34 @@ TEST(path_hash_set) {
         assert_se(!set_contains(set, "/////../bar/./"));
 }
 
+TEST(trusted_hash_ops) {
+        _cleanup_hashmap_free_ Hashmap *h = NULL;
+        _cleanup_set_free_ Set *s = NULL;
+        uint64_t keys[1024];
+
+        /* Pointers to our own objects are aligned, make sure those do not all end up in a few buckets */
+        for (unsigned i = 0; i < ELEMENTSOF(keys); i++)
+                ASSERT_OK_POSITIVE(set_ensure_put(&s, &trusted_trivial_hash_ops, UINT_TO_PTR((i + 1) * 64)));
+        ASSERT_EQ(set_size(s), ELEMENTSOF(keys));
+
+        for (unsigned i = 0; i < ELEMENTSOF(keys); i++)
+                ASSERT_TRUE(set_contains(s, UINT_TO_PTR((i + 1) * 64)));
+        ASSERT_FALSE(set_contains(s, UINT_TO_PTR(32)));
+        ASSERT_FALSE(set_contains(s, UINT_TO_PTR(ELEMENTSOF(keys) * 64 + 64)));
+
+        for (unsigned i = 0; i < ELEMENTSOF(keys); i++) {
+                keys[i] = (uint64_t) i << 32;
+                ASSERT_OK_POSITIVE(hashmap_ensure_put(&h, &trusted_uint64_hash_ops, &keys[i], UINT_TO_PTR(i + 1)));
+        }
+
+        for (unsigned i = 0; i < ELEMENTSOF(keys); i++) {
+                uint64_t k = (uint64_t) i << 32;
+
+                ASSERT_EQ(PTR_TO_UINT(hashmap_get(h, &k)), i + 1);
+        }
+
+        /* The mixer is a bijection, different inputs must never produce the same output */
+        ASSERT_NE(trusted_hash_mix64(0), trusted_hash_mix64(1));
+}
+
 DEFINE_TEST_MAIN(LOG_INFO);
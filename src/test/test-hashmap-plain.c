@@ -718,6 +718,96 @@ TEST(hashmap_many) {
         }
 }
 
+static void log_benchmark(const char *title, const char *op, unsigned n, usec_t ts) {
+        usec_t n_usec = now(CLOCK_MONOTONIC) - ts;
+
+        log_info("%s: %-7s %8u entries in %-10s (%.1f ns/op)",
+                 title, op, n, FORMAT_TIMESPAN(n_usec, 1), (double) n_usec * NSEC_PER_USEC / MAX(n, 1U));
+}
+
+TEST(hashmap_benchmark) {
+        bool slow = slow_tests_enabled();
+        unsigned sizes[] = { 16, 256, 4096, slow ? 1U << 16 : 0, slow ? 1U << 20 : 0 };
+        const struct {
+                const char *title;
+                const struct hash_ops *ops;
+                bool strings;
+        } tests[] = {
+                { "trivial_hashmap_ops",      NULL,                      false },
+                { "trusted_trivial_hash_ops", &trusted_trivial_hash_ops, false },
+                { "string_hash_ops",          &string_hash_ops,          true  },
+        };
+
+        /* Not a test as such, but numbers to compare when touching the hashmap implementation. Lookups are
+         * done both for present and absent keys, as the latter need to probe until the chain ends. */
+
+        log_info("/* %s (%s) */", __func__, slow ? "slow" : "fast");
+
+        FOREACH_ELEMENT(test, tests)
+                FOREACH_ELEMENT(size, sizes) {
+                        _cleanup_strv_free_ char **keys = NULL;
+                        _cleanup_(hashmap_freep) Hashmap *h = NULL;
+                        unsigned n = *size, c = 0;
+                        usec_t ts;
+                        void *v;
+
+                        if (n == 0)
+                                continue;
+
+                        /* Keys for the odd numbers are inserted, the even ones are used for misses. */
+                        if (test->strings) {
+                                ASSERT_NOT_NULL(keys = new0(char*, 2 * n + 1));
+                                for (unsigned i = 0; i < 2 * n; i++)
+                                        ASSERT_OK(asprintf(&keys[i], "unit-%u.service", i));
+                        }
+
+#define KEY(i) (test->strings ? (const void*) keys[i] : UINT_TO_PTR((i) + 1))
+
+                        ASSERT_NOT_NULL(h = hashmap_new(test->ops));
+
+                        ts = now(CLOCK_MONOTONIC);
+                        for (unsigned i = 1; i < 2 * n; i += 2)
+                                ASSERT_OK_POSITIVE(hashmap_put(h, KEY(i), UINT_TO_PTR(i)));
+                        log_benchmark(test->title, "insert", n, ts);
+
+                        ts = now(CLOCK_MONOTONIC);
+                        for (unsigned i = 1; i < 2 * n; i += 2)
+                                ASSERT_EQ(PTR_TO_UINT(hashmap_get(h, KEY(i))), i);
+                        log_benchmark(test->title, "hit", n, ts);
+
+                        ts = now(CLOCK_MONOTONIC);
+                        for (unsigned i = 0; i < 2 * n; i += 2)
+                                ASSERT_NULL(hashmap_get(h, KEY(i)));
+                        log_benchmark(test->title, "miss", n, ts);
+
+                        ts = now(CLOCK_MONOTONIC);
+                        HASHMAP_FOREACH(v, h)
+                                c++;
+                        log_benchmark(test->title, "iterate", n, ts);
+                        ASSERT_EQ(c, n);
+
+                        /* Remove all but every eighth entry, the table does not shrink and becomes sparse. */
+                        ts = now(CLOCK_MONOTONIC);
+                        for (unsigned i = 1; i < 2 * n; i += 2)
+                                if (i % 16 != 1)
+                                        ASSERT_EQ(PTR_TO_UINT(hashmap_remove(h, KEY(i))), i);
+                        log_benchmark(test->title, "remove", n - DIV_ROUND_UP(n, 8), ts);
+
+                        c = 0;
+                        ts = now(CLOCK_MONOTONIC);
+                        HASHMAP_FOREACH(v, h)
+                                c++;
+                        log_benchmark(test->title, "sparse", c, ts);
+                        ASSERT_EQ(c, DIV_ROUND_UP(n, 8));
+
+                        for (unsigned i = 1; i < 2 * n; i += 16)
+                                ASSERT_EQ(PTR_TO_UINT(hashmap_remove(h, KEY(i))), i);
+                        ASSERT_TRUE(hashmap_isempty(h));
+
+#undef KEY
+                }
+}
+
 extern unsigned custom_counter;
 extern const struct hash_ops boring_hash_ops, custom_hash_ops;
 
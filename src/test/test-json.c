@@ -17,6 +17,7 @@
 #include "string-util.h"
 #include "strv.h"
 #include "tests.h"
+#include "time-util.h"
 #include "tmpfile-util.h"
 
 static void test_tokenizer_one(const char *data, ...) {
@@ -1042,6 +1043,44 @@ TEST(json_dispatch_double) {
         assert_se(data.x7 < 0);
 }
 
+TEST(json_dispatch_order) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *j = NULL;
+        struct data {
+                unsigned a, b, c;
+                sd_json_variant *rest;
+        } data = {};
+
+        /* Fields listed out of order with respect to the table */
+        ASSERT_OK(sd_json_buildo(&j,
+                                 SD_JSON_BUILD_PAIR_UNSIGNED("c", 3),
+                                 SD_JSON_BUILD_PAIR_UNSIGNED("b", 2),
+                                 SD_JSON_BUILD_PAIR_UNSIGNED("a", 1)));
+
+        const sd_json_dispatch_field table[] = {
+                { "a",                      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint, offsetof(struct data, a),    0 },
+                { "b",                      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint, offsetof(struct data, b),    0 },
+                { (const char*) POINTER_MAX, _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_variant, offsetof(struct data, rest), 0 },
+                { "c",                      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint, offsetof(struct data, c),    0 },
+                {},
+        };
+
+        ASSERT_OK(sd_json_dispatch(j, table, /* flags= */ 0, &data));
+
+        /* "c" comes after the catch-all entry, hence is never dispatched to its own entry */
+        ASSERT_EQ(data.a, 1U);
+        ASSERT_EQ(data.b, 2U);
+        ASSERT_EQ(data.c, 0U);
+        ASSERT_EQ(sd_json_variant_unsigned(data.rest), 3U);
+
+        sd_json_variant_unref(data.rest);
+        data = (struct data) {};
+
+        /* Duplicate fields are still refused if they are found by continuing the search */
+        j = sd_json_variant_unref(j);
+        ASSERT_OK(sd_json_parse("{\"b\":1,\"a\":2,\"b\":3}", 0, &j, NULL, NULL));
+        ASSERT_ERROR(sd_json_dispatch(j, table, /* flags= */ 0, &data), ENOTUNIQ);
+}
+
 TEST(json_sensitive) {
         _cleanup_(sd_json_variant_unrefp) sd_json_variant *a = NULL, *b = NULL, *v = NULL;
         _cleanup_free_ char *s = NULL;
@@ -1265,6 +1304,93 @@ TEST(parse_continue) {
         assert_se(sd_json_parse_with_source_continue(&p, "piff", /* flags= */ 0, &x, &line, &column) == -EINVAL);
 }
 
+TEST(parse_flat) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL, *s = NULL, *a = NULL;
+        _cleanup_free_ char *t = NULL;
+        const char *text =
+                "{\"userName\":\"averylongusername\",\"realName\":\"A Very Long Real Name\","
+                "\"memberOf\":[\"wheel\",\"systemd-journal\",\"a-rather-long-group\"],"
+                "\"password\":\"thisisasecretpassword\"}";
+        usec_t start;
+
+        /* Long strings of parsed arrays and objects are stored in the allocation of the array/object
+         * itself. Make sure references to them keep the whole thing alive, and that arrays/objects
+         * modified later on don't get confused by that. */
+
+        ASSERT_OK(sd_json_parse(text, /* flags= */ 0, &v, NULL, NULL));
+
+        ASSERT_NOT_NULL(s = sd_json_variant_ref(sd_json_variant_by_key(v, "realName")));
+        ASSERT_NOT_NULL(a = sd_json_variant_ref(sd_json_variant_by_key(v, "memberOf")));
+        sd_json_variant_sensitive(sd_json_variant_by_key(v, "password"));
+
+        ASSERT_OK(sd_json_variant_format(v, /* flags= */ 0, &t));
+        ASSERT_STREQ(t, "{\"userName\":\"averylongusername\",\"realName\":\"A Very Long Real Name\","
+                     "\"memberOf\":[\"wheel\",\"systemd-journal\",\"a-rather-long-group\"],"
+                     "\"password\":\"<sensitive data>\"}");
+        t = mfree(t);
+
+        v = sd_json_variant_unref(v);
+        ASSERT_STREQ(sd_json_variant_string(s), "A Very Long Real Name");
+
+        ASSERT_OK(sd_json_variant_append_arrayb(&a, SD_JSON_BUILD_STRING("yet-another-long-group")));
+        ASSERT_OK(sd_json_variant_append_arrayb(&a, SD_JSON_BUILD_STRING("and-one-more-long-group")));
+        ASSERT_OK(sd_json_variant_format(a, /* flags= */ 0, &t));
+        ASSERT_STREQ(t, "[\"wheel\",\"systemd-journal\",\"a-rather-long-group\",\"yet-another-long-group\",\"and-one-more-long-group\"]");
+        t = mfree(t);
+        a = sd_json_variant_unref(a);
+
+        /* A parsed array we hold the only reference to must not be extended in place */
+        ASSERT_OK(sd_json_parse("[\"a-rather-long-group\"]", /* flags= */ 0, &a, NULL, NULL));
+        ASSERT_OK(sd_json_variant_append_arrayb(&a, SD_JSON_BUILD_STRING("yet-another-long-group")));
+        ASSERT_OK(sd_json_variant_format(a, /* flags= */ 0, &t));
+        ASSERT_STREQ(t, "[\"a-rather-long-group\",\"yet-another-long-group\"]");
+
+        /* And a quick benchmark of the parse + free cycle */
+        start = now(CLOCK_MONOTONIC);
+        for (unsigned i = 0; i < 100000; i++) {
+                ASSERT_OK(sd_json_parse(text, /* flags= */ 0, &v, NULL, NULL));
+                v = sd_json_variant_unref(v);
+        }
+        log_info("Parsing and freeing the document 100000 times took %s.",
+                 FORMAT_TIMESPAN(usec_sub_unsigned(now(CLOCK_MONOTONIC), start), USEC_PER_MSEC));
+}
+
+TEST(format_append) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL, *w = NULL;
+        _cleanup_free_ char *buf = NULL, *t = NULL;
+        size_t size = 0;
+
+        ASSERT_OK(sd_json_build(&v, SD_JSON_BUILD_OBJECT(
+                                                SD_JSON_BUILD_PAIR_STRING("foo", "bar"),
+                                                SD_JSON_BUILD_PAIR_UNSIGNED("quux", 4711))));
+        ASSERT_OK(sd_json_build(&w, SD_JSON_BUILD_ARRAY(SD_JSON_BUILD_STRING("waldo"), SD_JSON_BUILD_NULL)));
+
+        ASSERT_OK(sd_json_variant_format_append(v, /* flags= */ 0, &buf, &size));
+        ASSERT_OK(sd_json_variant_format(v, /* flags= */ 0, &t));
+        ASSERT_STREQ(buf, t);
+        ASSERT_EQ(size, strlen(t));
+
+        ASSERT_OK(sd_json_variant_format_append(w, SD_JSON_FORMAT_NEWLINE, &buf, &size));
+        ASSERT_STREQ(buf, "{\"foo\":\"bar\",\"quux\":4711}[\"waldo\",null]\n");
+        ASSERT_EQ(size, strlen(buf));
+
+        ASSERT_ERROR(sd_json_variant_format_append(v, SD_JSON_FORMAT_OFF, &buf, &size), ENOEXEC);
+        ASSERT_EQ(size, strlen(buf));
+
+        /* Large documents need to grow the buffer multiple times, also in sensitive mode */
+        for (unsigned i = 0; i < 1000; i++)
+                ASSERT_OK(sd_json_variant_append_arrayb(&w, SD_JSON_BUILD_STRING("a-long-string-to-fill-up-the-buffer")));
+        sd_json_variant_sensitive(w);
+
+        buf = mfree(buf);
+        t = mfree(t);
+        size = 0;
+        ASSERT_OK(sd_json_variant_format_append(w, /* flags= */ 0, &buf, &size));
+        ASSERT_OK(sd_json_variant_format(w, /* flags= */ 0, &t));
+        ASSERT_STREQ(buf, t);
+        ASSERT_EQ(size, strlen(t));
+}
+
 TEST(pidref) {
         _cleanup_(pidref_done) PidRef myself = PIDREF_NULL, pid1 = PIDREF_NULL;
 
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "fileio.h"
+#include "fs-util.h"
+#include "manager.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "tests.h"
+#include "tmpfile-util.h"
+#include "unit.h"
+
+TEST(reload_changed) {
+        _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL, *unit_dir = NULL;
+        _cleanup_(manager_freep) Manager *m = NULL;
+        _cleanup_free_ char *a_path = NULL, *b_path = NULL;
+        Unit *a, *b;
+        int r;
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/test-manager-reload-changed-XXXXXX", &unit_dir));
+        ASSERT_NOT_NULL(a_path = path_join(unit_dir, "a.service"));
+        ASSERT_NOT_NULL(b_path = path_join(unit_dir, "b.target"));
+
+        ASSERT_OK(write_string_file(a_path,
+                                    "[Unit]\n"
+                                    "Description=first\n"
+                                    "[Service]\n"
+                                    "ExecStart=/bin/true\n",
+                                    WRITE_STRING_FILE_CREATE));
+        ASSERT_OK(write_string_file(b_path,
+                                    "[Unit]\n"
+                                    "Wants=a.service\n",
+                                    WRITE_STRING_FILE_CREATE));
+
+        ASSERT_OK(setenv_unit_path(unit_dir));
+        ASSERT_NOT_NULL(runtime_dir = setup_fake_runtime_dir());
+
+        r = manager_new(RUNTIME_SCOPE_USER, MANAGER_TEST_RUN_MINIMAL, &m);
+        if (manager_errno_skip_test(r))
+                return (void) log_tests_skipped_errno(r, "manager_new");
+        ASSERT_OK(r);
+        ASSERT_OK(manager_startup(m, NULL, NULL, NULL));
+
+        ASSERT_OK(manager_load_unit(m, "b.target", NULL, NULL, &b));
+        ASSERT_NOT_NULL(a = manager_get_unit(m, "a.service"));
+        ASSERT_EQ(a->load_state, UNIT_LOADED);
+        ASSERT_STREQ(a->description, "first");
+
+        /* Nothing changed yet */
+        ASSERT_OK_ZERO(manager_reload_changed(m));
+        ASSERT_TRUE(manager_get_unit(m, "a.service") == a);
+
+        ASSERT_OK(write_string_file(a_path,
+                                    "[Unit]\n"
+                                    "Description=second\n"
+                                    "[Service]\n"
+                                    "ExecStart=/bin/true\n",
+                                    WRITE_STRING_FILE_TRUNCATE));
+        ASSERT_OK(touch_file(a_path, /* parents = */ false, now(CLOCK_REALTIME) + USEC_PER_SEC,
+                             UID_INVALID, GID_INVALID, MODE_INVALID));
+
+        ASSERT_OK_EQ(manager_reload_changed(m), 1);
+
+        ASSERT_NOT_NULL(a = manager_get_unit(m, "a.service"));
+        ASSERT_EQ(a->load_state, UNIT_LOADED);
+        ASSERT_STREQ(a->description, "second");
+
+        /* The dependency b.target has on the replaced unit must have been restored */
+        ASSERT_TRUE(manager_get_unit(m, "b.target") == b);
+        ASSERT_TRUE(hashmap_contains(unit_get_dependencies(b, UNIT_WANTS), a));
+        ASSERT_TRUE(hashmap_contains(unit_get_dependencies(a, UNIT_WANTED_BY), b));
+
+        ASSERT_OK_ZERO(manager_reload_changed(m));
+
+        /* Changes to the unit file state always require a full reload */
+        m->unit_file_state_outdated = true;
+        ASSERT_ERROR(manager_reload_changed(m), EBUSY);
+}
+
+DEFINE_TEST_MAIN(LOG_DEBUG);
@@ -1,6 +1,9 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <pthread.h>
+
 #include "mempool.h"
+#include "process-util.h"
 #include "random-util.h"
 #include "tests.h"
 
@@ -89,4 +92,110 @@ TEST(mempool_trim) {
         assert_se(!test_mempool.freelist);
 }
 
+#define N_THREADS 4U
+#define N_TILES 2000U
+#define TILE_CHURN 100U
+
+struct thread_args {
+        struct element **mine;
+        struct element **theirs;
+};
+
+static void* thread_main(void *p) {
+        struct thread_args *args = ASSERT_PTR(p);
+
+        /* Allocate tiles and tag them, so that thread_free() can check it got the tiles of this thread */
+
+        for (unsigned i = 0; i < N_TILES; i++) {
+                ASSERT_NOT_NULL(args->mine[i] = mempool_alloc_tile(&test_mempool));
+                args->mine[i]->value = PTR_TO_UINT64(args->mine) + i;
+        }
+
+        return NULL;
+}
+
+static void* thread_free(void *p) {
+        struct thread_args *args = ASSERT_PTR(p);
+
+        /* Free the tiles another, already exited, thread allocated */
+
+        for (unsigned i = 0; i < N_TILES; i++) {
+                ASSERT_EQ(args->theirs[i]->value, PTR_TO_UINT64(args->theirs) + i);
+                args->theirs[i] = mempool_free_tile(&test_mempool, args->theirs[i]);
+        }
+
+        return NULL;
+}
+
+TEST(mempool_threads) {
+        static struct element *tiles[N_THREADS][N_TILES];
+        struct thread_args args[N_THREADS];
+        pthread_t t[N_THREADS];
+
+        for (unsigned i = 0; i < N_THREADS; i++)
+                args[i] = (struct thread_args) {
+                        .mine = tiles[i],
+                        .theirs = tiles[(i + 1) % N_THREADS],
+                };
+
+        for (unsigned i = 0; i < N_THREADS; i++)
+                ASSERT_OK_ZERO(-pthread_create(t + i, NULL, thread_main, args + i));
+        for (unsigned i = 0; i < N_THREADS; i++)
+                ASSERT_OK_ZERO(-pthread_join(t[i], NULL));
+
+        for (unsigned i = 0; i < N_THREADS; i++)
+                ASSERT_OK_ZERO(-pthread_create(t + i, NULL, thread_free, args + i));
+        for (unsigned i = 0; i < N_THREADS; i++)
+                ASSERT_OK_ZERO(-pthread_join(t[i], NULL));
+
+        /* The exited threads handed their cached tiles back, hence everything can be released. */
+        mempool_trim(&test_mempool);
+
+        ASSERT_NULL(test_mempool.first_pool);
+        ASSERT_NULL(test_mempool.freelist);
+}
+
+static void* thread_churn(void *p) {
+        bool *stop = ASSERT_PTR(p);
+
+        /* Keep taking and releasing the pool lock, by allocating more than the thread's cache holds */
+
+        while (!__atomic_load_n(stop, __ATOMIC_ACQUIRE)) {
+                struct element *e[TILE_CHURN];
+
+                FOREACH_ELEMENT(i, e)
+                        ASSERT_NOT_NULL(*i = mempool_alloc_tile(&test_mempool));
+                FOREACH_ELEMENT(i, e)
+                        mempool_free_tile(&test_mempool, *i);
+                mempool_trim(&test_mempool);
+        }
+
+        return NULL;
+}
+
+TEST(mempool_fork) {
+        bool stop = false;
+        pthread_t t;
+        int r;
+
+        /* Forking while another thread holds the pool lock must not leave the lock held in the child */
+
+        ASSERT_OK_ZERO(-pthread_create(&t, NULL, thread_churn, &stop));
+
+        for (unsigned i = 0; i < 100; i++) {
+                ASSERT_OK(r = safe_fork("(mempool-fork)", FORK_WAIT|FORK_LOG, NULL));
+                if (r == 0) {
+                        struct element *e;
+
+                        e = mempool_alloc_tile(&test_mempool);
+                        mempool_free_tile(&test_mempool, e);
+                        mempool_trim(&test_mempool);
+                        _exit(e ? EXIT_SUCCESS : EXIT_FAILURE);
+                }
+        }
+
+        __atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+        ASSERT_OK_ZERO(-pthread_join(t, NULL));
+}
+
 DEFINE_TEST_MAIN(LOG_DEBUG);
@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "sd-json.h"
+
+#include "json-util.h"
+#include "metrics.h"
+#include "tests.h"
+#include "varlink-idl-util.h"
+#include "varlink-io.systemd.Metrics.h"
+
+typedef struct Context {
+        uint64_t n_requests;
+        uint64_t n_pending;
+        MetricHistogram latency;
+} Context;
+
+static int metric_requests(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Context *c = ASSERT_PTR(userdata);
+        int r;
+
+        r = metric_append_value(array, f, "protocol", "udp", metric_read(&c->n_requests));
+        if (r < 0)
+                return r;
+
+        return metric_append_value(array, f, "protocol", "tcp", 0);
+}
+
+static int metric_pending(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Context *c = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, metric_read(&c->n_pending));
+}
+
+static int metric_latency(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Context *c = ASSERT_PTR(userdata);
+
+        return metric_append_histogram(array, f, NULL, NULL, &c->latency);
+}
+
+static const MetricFamily families[] = {
+        { "io.systemd.Test.Requests",       "Requests received",          METRIC_COUNTER,   metric_requests },
+        { "io.systemd.Test.Pending",        "Requests currently pending", METRIC_GAUGE,     metric_pending  },
+        { "io.systemd.Test.LatencyUSec",    "Request latency in µs",      METRIC_HISTOGRAM, metric_latency  },
+        {}
+};
+
+TEST(metric_histogram_bucket) {
+        ASSERT_EQ(metric_histogram_bucket(0), 0U);
+        ASSERT_EQ(metric_histogram_bucket(1), 1U);
+        ASSERT_EQ(metric_histogram_bucket(2), 2U);
+        ASSERT_EQ(metric_histogram_bucket(3), 2U);
+        ASSERT_EQ(metric_histogram_bucket(4), 3U);
+        ASSERT_EQ(metric_histogram_bucket((UINT64_C(1) << 14) - 1), 14U);
+        ASSERT_EQ(metric_histogram_bucket(UINT64_C(1) << 14), 15U);
+        ASSERT_EQ(metric_histogram_bucket(UINT64_MAX), METRIC_HISTOGRAM_BUCKETS - 1);
+}
+
+TEST(metrics_build_json) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL, *reply = NULL;
+        const sd_varlink_symbol *symbol;
+        Context c = {};
+        sd_json_variant *i;
+        size_t n = 0;
+
+        metric_counter_add(&c.n_requests, 41);
+        metric_counter_inc(&c.n_requests);
+        metric_gauge_set(&c.n_pending, 7);
+        metric_histogram_observe(&c.latency, 0);
+        metric_histogram_observe(&c.latency, 5);
+        metric_histogram_observe(&c.latency, 6);
+
+        ASSERT_OK(metrics_build_json(families, &c, &v));
+        sd_json_variant_dump(v, SD_JSON_FORMAT_PRETTY_AUTO|SD_JSON_FORMAT_COLOR_AUTO, stdout, NULL);
+
+        ASSERT_EQ(sd_json_variant_elements(v), 4U);
+
+        JSON_VARIANT_ARRAY_FOREACH(i, v) {
+                const char *name = sd_json_variant_string(sd_json_variant_by_key(i, "name"));
+
+                if (streq(name, "io.systemd.Test.Requests")) {
+                        ASSERT_STREQ(sd_json_variant_string(sd_json_variant_by_key(i, "type")), "counter");
+                        if (streq(sd_json_variant_string(sd_json_variant_by_key(sd_json_variant_by_key(i, "fields"), "protocol")), "udp"))
+                                ASSERT_EQ(sd_json_variant_unsigned(sd_json_variant_by_key(i, "value")), 42U);
+                        else
+                                ASSERT_EQ(sd_json_variant_unsigned(sd_json_variant_by_key(i, "value")), 0U);
+                } else if (streq(name, "io.systemd.Test.Pending")) {
+                        ASSERT_STREQ(sd_json_variant_string(sd_json_variant_by_key(i, "type")), "gauge");
+                        ASSERT_NULL(sd_json_variant_by_key(i, "fields"));
+                        ASSERT_EQ(sd_json_variant_unsigned(sd_json_variant_by_key(i, "value")), 7U);
+                } else {
+                        sd_json_variant *b;
+
+                        ASSERT_STREQ(name, "io.systemd.Test.LatencyUSec");
+                        ASSERT_STREQ(sd_json_variant_string(sd_json_variant_by_key(i, "type")), "histogram");
+                        ASSERT_EQ(sd_json_variant_unsigned(sd_json_variant_by_key(i, "sum")), 11U);
+                        ASSERT_NOT_NULL(b = sd_json_variant_by_key(i, "buckets"));
+                        ASSERT_EQ(sd_json_variant_elements(b), METRIC_HISTOGRAM_BUCKETS);
+                        ASSERT_EQ(sd_json_variant_unsigned(sd_json_variant_by_index(b, 0)), 1U);
+                        ASSERT_EQ(sd_json_variant_unsigned(sd_json_variant_by_index(b, 3)), 2U);
+                }
+
+                n++;
+        }
+        ASSERT_EQ(n, 4U);
+
+        /* The reply must match what the interface promises */
+        ASSERT_OK(sd_json_buildo(&reply, SD_JSON_BUILD_PAIR_VARIANT("metrics", v)));
+        ASSERT_NOT_NULL(symbol = varlink_idl_find_symbol(&vl_interface_io_systemd_Metrics, SD_VARLINK_METHOD, "List"));
+        ASSERT_OK(varlink_idl_validate_method_reply(symbol, reply, /* flags= */ 0, /* reterr_bad_field= */ NULL));
+}
+
+TEST(metrics_build_json_empty) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        static const MetricFamily none[] = { {} };
+
+        ASSERT_OK(metrics_build_json(none, NULL, &v));
+        ASSERT_TRUE(sd_json_variant_is_array(v));
+        ASSERT_EQ(sd_json_variant_elements(v), 0U);
+}
+
+DEFINE_TEST_MAIN(LOG_DEBUG);
@@ -11,6 +11,7 @@
 #include "namespace.h"
 #include "pidref.h"
 #include "process-util.h"
+#include "stat-util.h"
 #include "string-util.h"
 #include "tests.h"
 #include "uid-range.h"
@@ -279,6 +280,42 @@ TEST(userns_get_base_uid) {
         ASSERT_ERROR(userns_get_base_uid(fd, &base_uid, &base_gid), ENOMSG);
 }
 
+TEST(userns_acquire_cached) {
+        _cleanup_close_ int a = -EBADF, b = -EBADF, c = -EBADF;
+
+        a = userns_acquire_cached("0 1 1", "0 2 1");
+        if (ERRNO_IS_NEG_NOT_SUPPORTED(a))
+                return (void) log_tests_skipped("userns is not supported");
+        if (ERRNO_IS_NEG_PRIVILEGE(a))
+                return (void) log_tests_skipped("lacking userns privileges");
+        ASSERT_OK(a);
+
+        /* Same mapping → same namespace, but a separate fd */
+        b = userns_acquire_cached("0 1 1", "0 2 1");
+        ASSERT_OK(b);
+        ASSERT_NE(a, b);
+        ASSERT_OK_POSITIVE(fd_inode_same(a, b));
+
+        /* Different mapping → different namespace */
+        c = userns_acquire_cached("0 1 1", "0 3 1");
+        ASSERT_OK(c);
+        ASSERT_OK_ZERO(fd_inode_same(a, c));
+
+        uid_t base_uid, base_gid;
+        ASSERT_OK(userns_get_base_uid(c, &base_uid, &base_gid));
+        ASSERT_EQ(base_uid, 1U);
+        ASSERT_EQ(base_gid, 3U);
+
+        /* Once flushed, a new one is acquired */
+        userns_cache_flush();
+        b = safe_close(b);
+        b = userns_acquire_cached("0 1 1", "0 2 1");
+        ASSERT_OK(b);
+        ASSERT_OK_ZERO(fd_inode_same(a, b));
+
+        userns_cache_flush();
+}
+
 TEST(process_is_owned_by_uid) {
         int r;
 
@@ -75,4 +75,23 @@ TEST(read_mem_pressure) {
         assert_se(rp.total == 58464525);
 }
 
+TEST(parse_resource_pressure) {
+        ResourcePressure rp;
+
+        ASSERT_ERROR(parse_resource_pressure("", PRESSURE_TYPE_SOME, &rp), ENODATA);
+        ASSERT_ERROR(parse_resource_pressure("herpdederp\n", PRESSURE_TYPE_SOME, &rp), ENODATA);
+
+        /* Fields must not be picked up from the following line */
+        ASSERT_FAIL(parse_resource_pressure("some avg10=0.22 avg60=0.17\n"
+                                            "full avg10=0.23 avg60=0.16 avg300=1.08 total=58464525\n", PRESSURE_TYPE_SOME, &rp));
+
+        ASSERT_OK(parse_resource_pressure("some avg10=0.22 avg60=0.17 avg300=1.11 total=58761459\n"
+                                          "full avg10=0.23 avg60=0.16 avg300=1.08 total=58464525\n", PRESSURE_TYPE_FULL, &rp));
+        ASSERT_EQ(LOADAVG_INT_SIDE(rp.avg10), 0UL);
+        ASSERT_EQ(LOADAVG_DECIMAL_SIDE(rp.avg10), 23UL);
+        ASSERT_EQ(LOADAVG_INT_SIDE(rp.avg300), 1UL);
+        ASSERT_EQ(LOADAVG_DECIMAL_SIDE(rp.avg300), 8UL);
+        ASSERT_EQ(rp.total, 58464525U);
+}
+
 DEFINE_TEST_MAIN(LOG_DEBUG);
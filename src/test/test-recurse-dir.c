@@ -3,11 +3,15 @@
 #include <ftw.h>
 
 #include "fd-util.h"
+#include "fs-util.h"
 #include "log.h"
 #include "missing_magic.h"
 #include "recurse-dir.h"
+#include "rm-rf.h"
+#include "stdio-util.h"
 #include "strv.h"
 #include "tests.h"
+#include "tmpfile-util.h"
 
 static char **list_nftw = NULL;
 
@@ -117,6 +121,83 @@ static int recurse_dir_callback(
         return RECURSE_DIR_CONTINUE;
 }
 
+static int count_callback(
+                RecurseDirEvent event,
+                const char *path,
+                int dir_fd,
+                int inode_fd,
+                const struct dirent *de,
+                const struct statx *sx,
+                void *userdata) {
+
+        unsigned *n = ASSERT_PTR(userdata);
+
+        if (event == RECURSE_DIR_ENTRY)
+                (*n)++;
+
+        return RECURSE_DIR_CONTINUE;
+}
+
+static unsigned n_nftw = 0;
+
+static int nftw_count_cb(
+                const char *fpath,
+                const struct stat *sb,
+                int typeflag,
+                struct FTW *ftwbuf) {
+
+        if (typeflag == FTW_F)
+                n_nftw++;
+
+        return FTW_CONTINUE;
+}
+
+static void benchmark_synthetic_tree(void) {
+        _cleanup_(rm_rf_physical_and_freep) char *t = NULL;
+        _cleanup_close_ int fd = -EBADF;
+        bool slow = slow_tests_enabled();
+        unsigned n_dirs = slow ? 100 : 10, n_files = slow ? 10000 : 1000, n;
+        usec_t ts;
+
+        /* A flat-ish tree with many small directories, like /var/tmp or a journal directory */
+
+        ASSERT_OK(fd = mkdtemp_open(NULL, O_DIRECTORY|O_CLOEXEC, &t));
+
+        for (unsigned i = 0; i < n_dirs; i++) {
+                _cleanup_close_ int dfd = -EBADF;
+                char d[DECIMAL_STR_MAX(unsigned)];
+
+                xsprintf(d, "%u", i);
+                ASSERT_OK(dfd = open_mkdir_at(fd, d, O_CLOEXEC, 0755));
+
+                for (unsigned j = 0; j < n_files / n_dirs; j++) {
+                        char f[STRLEN("file") + DECIMAL_STR_MAX(unsigned)];
+                        _cleanup_close_ int ffd = -EBADF;
+
+                        xsprintf(f, "file%u", j);
+                        ASSERT_OK_ERRNO(ffd = openat(dfd, f, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0644));
+                }
+        }
+
+        n = 0;
+        ts = now(CLOCK_MONOTONIC);
+        ASSERT_OK(recurse_dir_at(fd, NULL, 0, UINT_MAX, RECURSE_DIR_ENSURE_TYPE, count_callback, &n));
+        log_info("recurse_dir() without statx: %u files in %s", n, FORMAT_TIMESPAN(now(CLOCK_MONOTONIC) - ts, 1));
+        ASSERT_EQ(n, n_files / n_dirs * n_dirs);
+
+        n = 0;
+        ts = now(CLOCK_MONOTONIC);
+        ASSERT_OK(recurse_dir_at(fd, NULL, STATX_TYPE|STATX_MODE|STATX_SIZE|STATX_MTIME, UINT_MAX, 0, count_callback, &n));
+        log_info("recurse_dir() with statx:    %u files in %s", n, FORMAT_TIMESPAN(now(CLOCK_MONOTONIC) - ts, 1));
+        ASSERT_EQ(n, n_files / n_dirs * n_dirs);
+
+        n_nftw = 0;
+        ts = now(CLOCK_MONOTONIC);
+        ASSERT_OK_ERRNO(nftw(t, nftw_count_cb, 64, FTW_PHYS));
+        log_info("nftw():                      %u files in %s", n_nftw, FORMAT_TIMESPAN(now(CLOCK_MONOTONIC) - ts, 1));
+        ASSERT_EQ(n_nftw, n_files / n_dirs * n_dirs);
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_strv_free_ char **list_recurse_dir = NULL;
         const char *p;
@@ -126,6 +207,9 @@ int main(int argc, char *argv[]) {
         log_show_color(true);
         test_setup_logging(LOG_INFO);
 
+        if (argc <= 1)
+                benchmark_synthetic_tree();
+
         if (argc > 1)
                 p = argv[1];
         else
@@ -54,6 +54,31 @@ TEST(basic_enumerate) {
         assert_se(len1 == len2);
 }
 
+TEST(repeated_lookup) {
+        _cleanup_(sd_hwdb_unrefp) sd_hwdb *hwdb = NULL;
+        const char *key, *value;
+        size_t n1 = 0, n2 = 0;
+
+        ASSERT_OK(sd_hwdb_new(&hwdb));
+
+        /* Looking up the same modalias again reuses the previous result, make sure that neither
+         * the enumeration nor lookups of other modaliases in between are affected by that. */
+        SD_HWDB_FOREACH_PROPERTY(hwdb, DELL_MODALIAS, key, value)
+                n1++;
+
+        ASSERT_ERROR(sd_hwdb_get(hwdb, "no-such-modalias-should-exist", "KEYBOARD_KEY_00", &value), ENOENT);
+
+        SD_HWDB_FOREACH_PROPERTY(hwdb, DELL_MODALIAS, key, value) {
+                const char *v;
+
+                ASSERT_OK(sd_hwdb_get(hwdb, DELL_MODALIAS, key, &v));
+                ASSERT_STREQ(v, value);
+                n2++;
+        }
+
+        ASSERT_EQ(n1, n2);
+}
+
 TEST(sd_hwdb_new_from_path) {
         _cleanup_(sd_hwdb_unrefp) sd_hwdb *hwdb = NULL;
         int r;
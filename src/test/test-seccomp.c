@@ -30,6 +30,7 @@
 #include "rm-rf.h"
 #include "seccomp-util.h"
 #include "set.h"
+#include "stat-util.h"
 #include "string-util.h"
 #include "tests.h"
 #include "tmpfile-util.h"
@@ -879,6 +880,65 @@ TEST(load_syscall_filter_set_raw) {
         assert_se(wait_for_terminate_and_check("syscallrawseccomp", pid, WAIT_LOG) == EXIT_SUCCESS);
 }
 
+TEST(load_syscall_filter_set_raw_cached) {
+        pid_t pid;
+
+        if (!is_seccomp_available()) {
+                log_notice("Seccomp not available, skipping %s", __func__);
+                return;
+        }
+        if (!have_seccomp_privs()) {
+                log_notice("Not privileged, skipping %s", __func__);
+                return;
+        }
+
+        pid = fork();
+        assert_se(pid >= 0);
+
+        if (pid == 0) {
+                _cleanup_(rm_rf_physical_and_freep) char *cache_dir = NULL;
+                _cleanup_hashmap_free_ Hashmap *s = NULL;
+                _cleanup_(seccomp_program_set_done) SeccompProgramSet programs = {};
+
+                assert_se(mkdtemp_malloc("/tmp/seccomp-cache-XXXXXX", &cache_dir) >= 0);
+
+                assert_se(s = hashmap_new(NULL));
+#if defined __NR_access && __NR_access >= 0
+                assert_se(hashmap_put(s, UINT32_TO_PTR(__NR_access + 1), INT_TO_PTR(-1)) >= 0);
+#endif
+#if defined __NR_faccessat && __NR_faccessat >= 0
+                assert_se(hashmap_put(s, UINT32_TO_PTR(__NR_faccessat + 1), INT_TO_PTR(-1)) >= 0);
+#endif
+#if defined __NR_faccessat2 && __NR_faccessat2 >= 0
+                assert_se(hashmap_put(s, UINT32_TO_PTR(__NR_faccessat2 + 1), INT_TO_PTR(-1)) >= 0);
+#endif
+                assert_se(!hashmap_isempty(s));
+
+                /* First compile the filter into the cache, then take it from there, and install it from
+                 * memory after the cache is gone */
+                ASSERT_OK(seccomp_prepare_syscall_filter_set_raw(SCMP_ACT_ALLOW, s, SCMP_ACT_ERRNO(EUCLEAN), cache_dir, &programs));
+                ASSERT_GT(programs.n_programs, 0u);
+                seccomp_program_set_done(&programs);
+                ASSERT_OK_ZERO(dir_is_empty(cache_dir, /* ignore_hidden_or_backup= */ false));
+
+                ASSERT_OK(seccomp_prepare_syscall_filter_set_raw(SCMP_ACT_ALLOW, s, SCMP_ACT_ERRNO(EUCLEAN), cache_dir, &programs));
+                ASSERT_GT(programs.n_programs, 0u);
+                ASSERT_OK(rm_rf(cache_dir, REMOVE_ROOT|REMOVE_PHYSICAL));
+
+                assert_se(access("/", F_OK) >= 0);
+                ASSERT_OK(seccomp_load_syscall_filter_set_raw_full(SCMP_ACT_ALLOW, s, SCMP_ACT_ERRNO(EUCLEAN), true, &programs));
+
+                assert_se(access("/", F_OK) < 0);
+                assert_se(errno == EUCLEAN);
+
+                assert_se(poll(NULL, 0, 0) == 0);
+
+                _exit(EXIT_SUCCESS);
+        }
+
+        assert_se(wait_for_terminate_and_check("syscallrawcachedseccomp", pid, WAIT_LOG) == EXIT_SUCCESS);
+}
+
 TEST(native_syscalls_filtered) {
         pid_t pid;
 
@@ -255,6 +255,28 @@ TEST(serialize_string_set) {
         assert_se(STR_IN_SET(q, "abc def", "ghi jkl"));
 }
 
+TEST(deserialize_read_line) {
+        _cleanup_fclose_ FILE *f = NULL;
+        _cleanup_free_ char *line1 = NULL, *line2 = NULL, *line3 = NULL;
+
+        ASSERT_OK(open_serialization_file("test-serialize", &f));
+
+        ASSERT_OK_EQ(serialize_item(f, "a", "bbb"), 1);
+        fputs("   c=ddd  \n", f);
+        fputs("\n", f);
+        ASSERT_OK_EQ(serialize_item(f, "e", "fff"), 1);
+        ASSERT_OK(finish_serialization_file(f));
+
+        ASSERT_OK_EQ(deserialize_read_line(f, &line1), 1);
+        ASSERT_STREQ(line1, "a=bbb");
+        ASSERT_OK_EQ(deserialize_read_line(f, &line2), 1);
+        ASSERT_STREQ(line2, "c=ddd");
+
+        /* The empty line is the end marker */
+        ASSERT_OK_EQ(deserialize_read_line(f, &line3), 0);
+        ASSERT_NULL(line3);
+}
+
 static int intro(void) {
         memset(long_string, 'x', sizeof(long_string)-1);
         char_array_0(long_string);
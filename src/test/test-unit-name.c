@@ -89,10 +89,15 @@ TEST(unit_name_is_valid) {
 }
 
 static void test_unit_name_replace_instance_one(const char *pattern, const char *repl, const char *expected, int ret) {
-        _cleanup_free_ char *t = NULL;
+        _cleanup_free_ char *t = NULL, *u = NULL, *suffixed = NULL;
         assert_se(unit_name_replace_instance(pattern, repl, &t) == ret);
         puts(strna(t));
         ASSERT_STREQ(t, expected);
+
+        /* The same with an instance that isn't NUL-terminated */
+        ASSERT_NOT_NULL(suffixed = strjoin(repl, "-trailing"));
+        assert_se(unit_name_replace_instance_n(pattern, suffixed, strlen(repl), false, &u) == ret);
+        ASSERT_STREQ(u, expected);
 }
 
 TEST(unit_name_replace_instance) {
@@ -104,6 +109,8 @@ TEST(unit_name_replace_instance) {
         test_unit_name_replace_instance_one(".service", "waldo", NULL, -EINVAL);
         test_unit_name_replace_instance_one("foo@", "waldo", NULL, -EINVAL);
         test_unit_name_replace_instance_one("@bar", "waldo", NULL, -EINVAL);
+        test_unit_name_replace_instance_one("foo@.service", "", NULL, -EINVAL);
+        test_unit_name_replace_instance_one("foo@.service", "wal/do", NULL, -EINVAL);
 }
 
 static void test_unit_name_from_path_one(const char *path, const char *suffix, const char *expected, int ret) {
@@ -628,6 +635,29 @@ TEST(unit_name_to_instance) {
         assert_se(!instance);
 }
 
+TEST(unit_name_to_instance_view) {
+        const char *instance;
+        size_t n;
+
+        ASSERT_EQ(unit_name_to_instance_view("foo@bar.service", &instance, &n), UNIT_NAME_INSTANCE);
+        ASSERT_EQ(n, 3U);
+        ASSERT_TRUE(strneq(instance, "bar", n));
+
+        ASSERT_EQ(unit_name_to_instance_view("foo@.service", &instance, &n), UNIT_NAME_TEMPLATE);
+        ASSERT_EQ(n, 0U);
+        ASSERT_NOT_NULL(instance);
+
+        ASSERT_EQ(unit_name_to_instance_view("foo@a@b.c.service", &instance, &n), UNIT_NAME_INSTANCE);
+        ASSERT_TRUE(strneq(instance, "a@b.c", n));
+        ASSERT_EQ(n, 5U);
+
+        ASSERT_EQ(unit_name_to_instance_view("foo.service", &instance, &n), UNIT_NAME_PLAIN);
+        ASSERT_NULL(instance);
+        ASSERT_EQ(n, 0U);
+
+        ASSERT_LT(unit_name_to_instance_view("foo@", &instance, &n), 0);
+}
+
 TEST(unit_name_escape) {
         _cleanup_free_ char *r = NULL;
 
@@ -674,8 +704,17 @@ TEST(unit_name_path_unescape) {
 static void test_unit_name_to_prefix_one(const char *input, int ret, const char *output) {
         _cleanup_free_ char *k = NULL;
 
+        const char *p;
+        size_t n;
+
         assert_se(unit_name_to_prefix(input, &k) == ret);
         ASSERT_STREQ(k, output);
+
+        assert_se(unit_name_to_prefix_view(input, &p, &n) == ret);
+        if (ret >= 0) {
+                ASSERT_TRUE(p == input);
+                ASSERT_EQ(n, strlen(output));
+        }
 }
 
 TEST(unit_name_to_prefix) {
@@ -31,6 +31,25 @@ TEST(utf8_n_is_valid) {
         assert_se( utf8_is_valid_n("<ZZ>", 3));
         assert_se( utf8_is_valid_n("<ZZ>", 4));
         assert_se(!utf8_is_valid_n("<ZZ>", 5));
+
+        /* Exercise the word-wise ASCII fast path, with the interesting bits at various offsets */
+        for (size_t i = 0; i < 24; i++) {
+                char buf[32];
+
+                memset(buf, 'a', sizeof(buf));
+                assert_se(utf8_is_valid_n(buf, sizeof(buf)));
+
+                buf[i] = 0;
+                assert_se(!utf8_is_valid_n(buf, sizeof(buf)));
+                assert_se(utf8_is_valid_n(buf, i));
+
+                memcpy(buf + i, "\342\204\242", 3);
+                assert_se(utf8_is_valid_n(buf, sizeof(buf)));
+                assert_se(!utf8_is_valid_n(buf, i + 2));
+
+                buf[i] = '\341';
+                assert_se(!utf8_is_valid_n(buf, sizeof(buf)));
+        }
 }
 
 TEST(utf8_is_valid) {
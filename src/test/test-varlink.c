@@ -457,4 +457,50 @@ TEST(invalid_parameter) {
         assert_se(sd_event_loop(e) >= 0);
 }
 
+#define N_PIPELINED 100
+
+static int reply_pipelined(sd_varlink *link, sd_json_variant *parameters, const char *error_id, sd_varlink_reply_flags_t flags, void *userdata) {
+        unsigned *n = ASSERT_PTR(userdata);
+
+        /* Replies must arrive in the order the calls were made */
+        ASSERT_NULL(error_id);
+        ASSERT_EQ(sd_json_variant_integer(sd_json_variant_by_key(parameters, "sum")), (int64_t) *n + 1);
+
+        if (++(*n) == N_PIPELINED)
+                ASSERT_OK(sd_event_exit(sd_varlink_get_event(link), EXIT_SUCCESS));
+
+        return 0;
+}
+
+TEST(pipelining) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        _cleanup_(sd_varlink_server_unrefp) sd_varlink_server *s = NULL;
+        _cleanup_(sd_varlink_unrefp) sd_varlink *c = NULL;
+        int connfd[2];
+        unsigned n = 0;
+
+        ASSERT_OK(sd_event_new(&e));
+
+        ASSERT_OK(sd_varlink_server_new(&s, 0));
+        ASSERT_OK(sd_varlink_server_attach_event(s, e, 0));
+        ASSERT_OK(sd_varlink_server_bind_method(s, "io.test.DoSomething", method_something));
+
+        ASSERT_OK_ERRNO(socketpair(AF_UNIX, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0, connfd));
+        ASSERT_OK(sd_varlink_server_add_connection(s, connfd[0], /* ret= */ NULL));
+
+        ASSERT_OK(sd_varlink_connect_fd(&c, connfd[1]));
+        ASSERT_OK(sd_varlink_attach_event(c, e, 0));
+        ASSERT_OK(sd_varlink_bind_reply(c, reply_pipelined));
+        sd_varlink_set_userdata(c, &n);
+
+        /* Enqueue a burst of calls on the same connection before any of them is answered */
+        for (unsigned i = 0; i < N_PIPELINED; i++)
+                ASSERT_OK(sd_varlink_invokebo(c, "io.test.DoSomething",
+                                              SD_JSON_BUILD_PAIR_INTEGER("a", i),
+                                              SD_JSON_BUILD_PAIR_INTEGER("b", 1)));
+
+        ASSERT_OK(sd_event_loop(e));
+        ASSERT_EQ(n, (unsigned) N_PIPELINED);
+}
+
 DEFINE_TEST_MAIN(LOG_DEBUG);
@@ -56,6 +56,7 @@
 #include "path-lookup.h"
 #include "path-util.h"
 #include "pretty-print.h"
+#include "process-util.h"
 #include "rlimit-util.h"
 #include "rm-rf.h"
 #include "selinux-util.h"
@@ -215,6 +216,7 @@ static char *arg_root = NULL;
 static char *arg_image = NULL;
 static char *arg_replace = NULL;
 static ImagePolicy *arg_image_policy = NULL;
+static unsigned arg_jobs = 1;
 
 #define MAX_DEPTH 256
 
@@ -447,13 +449,80 @@ static bool supports_ignore_if_target_missing(ItemType t) {
         return t == CREATE_SYMLINK;
 }
 
-static struct Item* find_glob(OrderedHashmap *h, const char *match) {
+typedef struct DirCleanup {
+        Item **globs;           /* Only the globs that may match anything below the directory cleaned up */
+        size_t n_globs;
+
+        uint64_t n_examined;
+        uint64_t n_removed;
+} DirCleanup;
+
+static void dir_cleanup_done(DirCleanup *dc) {
+        assert(dc);
+
+        dc->globs = mfree(dc->globs);
+        dc->n_globs = 0;
+}
+
+static bool glob_may_match_below(const char *pattern, const char *path) {
+        size_t n, m;
+
+        assert(pattern);
+        assert(path);
+
+        /* Returns false if the literal part of the pattern before the first wildcard already rules out that
+         * it matches anything below the specified directory. Escaped characters are not literal, hence stop
+         * at backslashes too. */
+
+        n = strcspn(pattern, GLOB_CHARS "\\");
+        m = strlen(path);
+        while (m > 0 && path[m-1] == '/')
+                m--;
+
+        if (strncmp(pattern, path, MIN(n, m)) != 0)
+                return false;
+
+        return n <= m || pattern[m] == '/';
+}
+
+static int dir_cleanup_init(Context *c, const char *path, DirCleanup *ret) {
+        _cleanup_free_ Item **globs = NULL;
+        size_t n_globs = 0;
         ItemArray *j;
 
-        ORDERED_HASHMAP_FOREACH(j, h)
-                FOREACH_ARRAY(item, j->items, j->n_items)
-                        if (fnmatch(item->path, match, FNM_PATHNAME|FNM_PERIOD) == 0)
-                                return item;
+        assert(c);
+        assert(path);
+        assert(ret);
+
+        /* Every entry we look at is checked against the globs, so drop all globs upfront that cannot match
+         * anything below the directory. On a big tree the per-entry fnmatch() calls otherwise dominate. */
+
+        ORDERED_HASHMAP_FOREACH(j, c->globs)
+                FOREACH_ARRAY(item, j->items, j->n_items) {
+                        if (!glob_may_match_below(item->path, path))
+                                continue;
+
+                        if (!GREEDY_REALLOC(globs, n_globs + 1))
+                                return -ENOMEM;
+
+                        globs[n_globs++] = item;
+                }
+
+        *ret = (DirCleanup) {
+                .globs = TAKE_PTR(globs),
+                .n_globs = n_globs,
+        };
+        return 0;
+}
+
+static Item* dir_cleanup_find_glob(const DirCleanup *dc, const char *match) {
+        assert(dc);
+        assert(match);
+
+        FOREACH_ARRAY(item, dc->globs, dc->n_globs)
+                if (fnmatch((*item)->path, match, FNM_PATHNAME|FNM_PERIOD) == 0)
+                        return *item;
+
         return NULL;
 }
 
@@ -669,6 +738,7 @@ static bool needs_cleanup(
 static int dir_cleanup(
                 Context *c,
                 Item *i,
+                DirCleanup *dc,
                 const char *p,
                 DIR *d,
                 nsec_t self_atime_nsec,
@@ -687,6 +757,7 @@ static int dir_cleanup(
 
         assert(c);
         assert(i);
+        assert(dc);
         assert(d);
 
         FOREACH_DIRENT_ALL(de, d, break) {
@@ -696,6 +767,8 @@ static int dir_cleanup(
                 if (dot_or_dot_dot(de->d_name))
                         continue;
 
+                dc->n_examined++;
+
                 /* If statx() is supported, use it. It's preferable over fstatat() since it tells us
                  * explicitly where we are looking at a mount point, for free as side information. Determining
                  * the same information without statx() is hard, see the complexity of path_is_mount_point(),
@@ -771,7 +844,7 @@ static int dir_cleanup(
                         continue;
                 }
 
-                if (find_glob(c->globs, sub_path)) {
+                if (dir_cleanup_find_glob(dc, sub_path)) {
                         log_debug("Ignoring \"%s\": a separate glob exists.", sub_path);
                         continue;
                 }
@@ -805,7 +878,7 @@ static int dir_cleanup(
                                         continue;
                                 }
 
-                                q = dir_cleanup(c, i,
+                                q = dir_cleanup(c, i, dc,
                                                 sub_path, sub_dir,
                                                 atime_nsec, mtime_nsec, cutoff_nsec,
                                                 rootdev_major, rootdev_minor,
@@ -834,9 +907,9 @@ static int dir_cleanup(
                                 continue;
 
                         log_action("Would remove", "Removing", "%s directory \"%s\"", sub_path);
-                        if (!arg_dry_run &&
-                            unlinkat(dirfd(d), de->d_name, AT_REMOVEDIR) < 0 &&
-                            !IN_SET(errno, ENOENT, ENOTEMPTY))
+                        if (arg_dry_run || unlinkat(dirfd(d), de->d_name, AT_REMOVEDIR) >= 0)
+                                dc->n_removed++;
+                        else if (!IN_SET(errno, ENOENT, ENOTEMPTY))
                                 r = log_warning_errno(errno, "Failed to remove directory \"%s\", ignoring: %m", sub_path);
 
                 } else {
@@ -895,9 +968,9 @@ static int dir_cleanup(
                         }
 
                         log_action("Would remove", "Removing", "%s \"%s\"", sub_path);
-                        if (!arg_dry_run &&
-                            unlinkat(dirfd(d), de->d_name, 0) < 0 &&
-                            errno != ENOENT)
+                        if (arg_dry_run || unlinkat(dirfd(d), de->d_name, 0) >= 0)
+                                dc->n_removed++;
+                        else if (errno != ENOENT)
                                 r = log_warning_errno(errno, "Failed to remove \"%s\", ignoring: %m", sub_path);
 
                         deleted = true;
@@ -2772,7 +2845,8 @@ static int mkdir_parents_rm_if_wrong_type(mode_t child_mode, const char *path) {
                         if (!arg_dry_run) {
                                 WITH_UMASK(0000)
                                         r = mkdirat_label(parent_fd, t, 0755);
-                                if (r < 0) {
+                                /* Another worker might have created it in the meantime */
+                                if (r < 0 && r != -EEXIST) {
                                         _cleanup_free_ char *parent_name = NULL;
 
                                         (void) fd_get_path(parent_fd, &parent_name);
@@ -2993,6 +3067,7 @@ static int remove_recursive(
                 const char *instance,
                 bool remove_instance) {
 
+        _cleanup_(dir_cleanup_done) DirCleanup dc = {};
         _cleanup_closedir_ DIR *d = NULL;
         STRUCT_STATX_DEFINE(sx);
         bool mountpoint;
@@ -3012,7 +3087,11 @@ static int remove_recursive(
                 return 0;
         }
 
-        r = dir_cleanup(c, i, instance, d,
+        r = dir_cleanup_init(c, instance, &dc);
+        if (r < 0)
+                return log_oom();
+
+        r = dir_cleanup(c, i, &dc, instance, d,
                         /* self_atime_nsec= */ NSEC_INFINITY,
                         /* self_mtime_nsec= */ NSEC_INFINITY,
                         /* cutoff_nsec= */ NSEC_INFINITY,
@@ -3143,9 +3222,11 @@ static int clean_item_instance(
 
         usec_t cutoff = n - i->age;
 
+        _cleanup_(dir_cleanup_done) DirCleanup dc = {};
         _cleanup_closedir_ DIR *d = NULL;
         STRUCT_STATX_DEFINE(sx);
         bool mountpoint;
+        usec_t start;
         int r;
 
         r = opendir_and_stat(instance, &d, &sx, &mountpoint);
@@ -3170,14 +3251,29 @@ static int clean_item_instance(
                           ab_f, ab_d);
         }
 
-        return dir_cleanup(c, i, instance, d,
-                           statx_timestamp_load_nsec(&sx.stx_atime),
-                           statx_timestamp_load_nsec(&sx.stx_mtime),
-                           cutoff * NSEC_PER_USEC,
-                           sx.stx_dev_major, sx.stx_dev_minor,
-                           mountpoint,
-                           MAX_DEPTH, i->keep_first_level,
-                           i->age_by_file, i->age_by_dir);
+        r = dir_cleanup_init(c, instance, &dc);
+        if (r < 0)
+                return log_oom();
+
+        start = now(CLOCK_MONOTONIC);
+
+        r = dir_cleanup(c, i, &dc, instance, d,
+                        statx_timestamp_load_nsec(&sx.stx_atime),
+                        statx_timestamp_load_nsec(&sx.stx_mtime),
+                        cutoff * NSEC_PER_USEC,
+                        sx.stx_dev_major, sx.stx_dev_minor,
+                        mountpoint,
+                        MAX_DEPTH, i->keep_first_level,
+                        i->age_by_file, i->age_by_dir);
+
+        log_debug("Cleaned up \"%s\": examined %" PRIu64 " entries, %s %" PRIu64 ", took %s.",
+                  instance,
+                  dc.n_examined,
+                  arg_dry_run ? "would remove" : "removed",
+                  dc.n_removed,
+                  FORMAT_TIMESPAN(usec_sub_unsigned(now(CLOCK_MONOTONIC), start), USEC_PER_MSEC));
+
+        return r;
 }
 
 static int clean_item(Context *c, Item *i) {
@@ -4182,6 +4278,7 @@ static int help(void) {
                "     --image-policy=POLICY  Specify disk image dissection policy\n"
                "     --replace=PATH         Treat arguments as replacement for PATH\n"
                "     --dry-run              Just print what would be done\n"
+               "     --jobs=N               Process independent items in N worker processes\n"
                "     --no-pager             Do not pipe output into a pager\n"
                "\nSee the %5$s for details.\n",
                program_invocation_short_name,
@@ -4212,6 +4309,7 @@ static int parse_argv(int argc, char *argv[]) {
                 ARG_IMAGE_POLICY,
                 ARG_REPLACE,
                 ARG_DRY_RUN,
+                ARG_JOBS,
                 ARG_NO_PAGER,
         };
 
@@ -4234,6 +4332,7 @@ static int parse_argv(int argc, char *argv[]) {
                 { "image-policy",   required_argument,   NULL, ARG_IMAGE_POLICY   },
                 { "replace",        required_argument,   NULL, ARG_REPLACE        },
                 { "dry-run",        no_argument,         NULL, ARG_DRY_RUN        },
+                { "jobs",           required_argument,   NULL, ARG_JOBS           },
                 { "no-pager",       no_argument,         NULL, ARG_NO_PAGER       },
                 {}
         };
@@ -4345,6 +4444,14 @@ static int parse_argv(int argc, char *argv[]) {
                         arg_dry_run = true;
                         break;
 
+                case ARG_JOBS:
+                        r = safe_atou(optarg, &arg_jobs);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse --jobs= argument: %s", optarg);
+                        if (arg_jobs == 0)
+                                return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "The argument to --jobs= must be positive.");
+                        break;
+
                 case ARG_NO_PAGER:
                         arg_pager_flags |= PAGER_DISABLE;
                         break;
@@ -4546,6 +4653,371 @@ static int link_parent(Context *c, ItemArray *a) {
         return 0;
 }
 
+typedef struct ItemSchedule {
+        ItemArray **arrays;     /* All item arrays, the non-globbing ones first, each in configuration order */
+        size_t n_arrays;
+        unsigned *worker;       /* Index of the worker each item array is assigned to */
+        unsigned n_workers;
+} ItemSchedule;
+
+static void item_schedule_done(ItemSchedule *s) {
+        assert(s);
+
+        s->arrays = mfree(s->arrays);
+        s->worker = mfree(s->worker);
+        s->n_arrays = 0;
+        s->n_workers = 0;
+}
+
+static size_t item_group_find(size_t *groups, size_t i) {
+        while (groups[i] != i) {
+                groups[i] = groups[groups[i]];
+                i = groups[i];
+        }
+
+        return i;
+}
+
+static void item_group_join(size_t *groups, size_t a, size_t b) {
+        a = item_group_find(groups, a);
+        b = item_group_find(groups, b);
+
+        /* Always keep the earlier item array as representative, so that groups are ordered like the
+         * configuration. */
+        if (a < b)
+                groups[b] = a;
+        else if (b < a)
+                groups[a] = b;
+}
+
+static int item_schedule_key(const char *path, char **ret) {
+        _cleanup_free_ char *k = NULL;
+        int r;
+
+        assert(path);
+        assert(ret);
+
+        if (string_is_glob(path)) {
+                r = glob_non_glob_prefix(path, &k);
+                if (r == -ENOENT)
+                        k = strdup("/");
+                else if (r < 0)
+                        return r;
+        } else
+                k = strdup(path);
+        if (!k)
+                return -ENOMEM;
+
+        path_simplify(k);
+
+        /* PATH_FOREACH_PREFIX() returns the root directory as empty string, hence use the same here */
+        if (empty_or_root(k))
+                k[0] = 0;
+
+        *ret = TAKE_PTR(k);
+        return 0;
+}
+
+static int item_target_key(const Item *i, char **ret) {
+        _cleanup_free_ char *d = NULL;
+        int r;
+
+        assert(i);
+        assert(ret);
+
+        /* Symlinks and copies make the item depend on a second path. Returns it, so that items below that
+         * path can be kept in the same worker. */
+
+        if (!IN_SET(i->type, CREATE_SYMLINK, COPY_FILES) || isempty(i->argument)) {
+                *ret = NULL;
+                return 0;
+        }
+
+        if (path_is_absolute(i->argument))
+                return item_schedule_key(i->argument, ret);
+
+        r = path_extract_directory(i->path, &d);
+        if (r < 0)
+                return r;
+
+        for (const char *p = i->argument;;) {
+                _cleanup_free_ char *e = NULL;
+                const char *q;
+
+                r = path_find_first_component(&p, /* accept_dot_dot= */ true, &q);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        break;
+
+                if (r == 2 && startswith(q, "..")) {
+                        _cleanup_free_ char *up = NULL;
+
+                        r = path_extract_directory(d, &up);
+                        if (r == -EADDRNOTAVAIL) /* Already at the root */
+                                continue;
+                        if (r < 0)
+                                return r;
+
+                        free_and_replace(d, up);
+                        continue;
+                }
+
+                e = strndup(q, r);
+                if (!e)
+                        return -ENOMEM;
+
+                if (!path_extend(&d, e))
+                        return -ENOMEM;
+        }
+
+        return item_schedule_key(d, ret);
+}
+
+static unsigned item_array_weight(const ItemArray *a) {
+        unsigned w = 0;
+
+        assert(a);
+
+        /* A rough estimate of the work an item array causes: items that descend into directory trees are
+         * what makes a run slow, everything else is a handful of syscalls. */
+        FOREACH_ARRAY(i, a->items, a->n_items)
+                w += i->age_set || IN_SET(i->type,
+                                          TRUNCATE_DIRECTORY,
+                                          COPY_FILES,
+                                          EMPTY_DIRECTORY,
+                                          RECURSIVE_SET_XATTR,
+                                          RECURSIVE_SET_ACL,
+                                          RECURSIVE_SET_ATTRIBUTE,
+                                          RECURSIVE_REMOVE_PATH,
+                                          RECURSIVE_RELABEL_PATH) ? 64 : 1;
+
+        return w;
+}
+
+static int group_weight_compare(const size_t *a, const size_t *b, unsigned *weight) {
+        return CMP(weight[*b], weight[*a]) ?: CMP(*a, *b);
+}
+
+static int item_schedule_build(Context *c, unsigned n_jobs, ItemSchedule *ret) {
+        _cleanup_(item_schedule_done) ItemSchedule s = {};
+        _cleanup_hashmap_free_ Hashmap *by_key = NULL;
+        _cleanup_free_ unsigned *weight = NULL, *load = NULL, *group_worker = NULL;
+        _cleanup_free_ size_t *groups = NULL, *order = NULL;
+        _cleanup_strv_free_ char **keys = NULL;
+        size_t n_groups = 0;
+        ItemArray *a;
+        int r;
+
+        assert(c);
+        assert(n_jobs > 1);
+        assert(ret);
+
+        /* Splits the item arrays into groups that may be processed independently of each other, and
+         * distributes the groups over at most n_jobs workers. Two item arrays end up in the same group if
+         * the path of one (or the non-globbing prefix of it) is below the path of the other, or below the
+         * target of a symlink or copy item of the other. This covers the parent/child links too, so that
+         * within each worker items are processed in exactly the same order as without workers. */
+
+        s.n_arrays = ordered_hashmap_size(c->items) + ordered_hashmap_size(c->globs);
+        s.arrays = new(ItemArray*, s.n_arrays);
+        keys = new0(char*, s.n_arrays + 1);
+        groups = new(size_t, s.n_arrays);
+        if (!s.arrays || !keys || !groups)
+                return -ENOMEM;
+
+        size_t n = 0;
+        ORDERED_HASHMAP_FOREACH(a, c->items)
+                s.arrays[n++] = a;
+        ORDERED_HASHMAP_FOREACH(a, c->globs)
+                s.arrays[n++] = a;
+        assert(n == s.n_arrays);
+
+        for (size_t j = 0; j < s.n_arrays; j++) {
+                groups[j] = j;
+
+                if (s.arrays[j]->n_items <= 0)
+                        continue;
+
+                r = item_schedule_key(s.arrays[j]->items[0].path, keys + j);
+                if (r < 0)
+                        return r;
+
+                void *found = hashmap_get(by_key, keys[j]);
+                if (found) {
+                        item_group_join(groups, j, PTR_TO_SIZE(found) - 1);
+                        continue;
+                }
+
+                r = hashmap_ensure_put(&by_key, &string_hash_ops, keys[j], SIZE_TO_PTR(j + 1));
+                if (r < 0)
+                        return r;
+        }
+
+        for (size_t j = 0; j < s.n_arrays; j++) {
+                if (!keys[j])
+                        continue;
+
+                /* Joining with the closest ancestor is enough, that one is joined with its own ancestor. */
+                char *prefix = newa(char, strlen(keys[j]) + 1);
+                PATH_FOREACH_PREFIX(prefix, keys[j]) {
+                        void *found = hashmap_get(by_key, prefix);
+                        if (found) {
+                                item_group_join(groups, j, PTR_TO_SIZE(found) - 1);
+                                break;
+                        }
+                }
+
+                FOREACH_ARRAY(i, s.arrays[j]->items, s.arrays[j]->n_items) {
+                        _cleanup_free_ char *target = NULL;
+
+                        r = item_target_key(i, &target);
+                        if (r < 0)
+                                return r;
+                        if (!target)
+                                continue;
+
+                        prefix = newa(char, strlen(target) + 1);
+                        PATH_FOREACH_PREFIX_MORE(prefix, target) {
+                                void *found = hashmap_get(by_key, prefix);
+                                if (found) {
+                                        item_group_join(groups, j, PTR_TO_SIZE(found) - 1);
+                                        break;
+                                }
+                        }
+
+                        for (size_t k = 0; k < s.n_arrays; k++)
+                                if (keys[k] && (isempty(target) || path_startswith(keys[k], target)))
+                                        item_group_join(groups, j, k);
+                }
+        }
+
+        /* Collect the group representatives, they are the earliest member of each group */
+        order = new(size_t, s.n_arrays);
+        if (!order)
+                return -ENOMEM;
+
+        for (size_t j = 0; j < s.n_arrays; j++)
+                if (item_group_find(groups, j) == j)
+                        order[n_groups++] = j;
+
+        s.n_workers = MIN(n_jobs, n_groups);
+        if (s.n_workers <= 1) {
+                /* Everything depends on everything else, no point in forking off workers */
+                *ret = (ItemSchedule) {};
+                return 0;
+        }
+
+        /* Give each group to the least loaded worker, heaviest groups first */
+        weight = new0(unsigned, s.n_arrays);
+        load = new0(unsigned, s.n_workers);
+        group_worker = new(unsigned, s.n_arrays);
+        s.worker = new(unsigned, s.n_arrays);
+        if (!weight || !load || !group_worker || !s.worker)
+                return -ENOMEM;
+
+        for (size_t j = 0; j < s.n_arrays; j++)
+                weight[item_group_find(groups, j)] += item_array_weight(s.arrays[j]);
+
+        typesafe_qsort_r(order, n_groups, group_weight_compare, weight);
+
+        FOREACH_ARRAY(g, order, n_groups) {
+                unsigned w = 0;
+
+                for (unsigned k = 1; k < s.n_workers; k++)
+                        if (load[k] < load[w])
+                                w = k;
+
+                group_worker[*g] = w;
+                load[w] += weight[*g];
+        }
+
+        for (size_t j = 0; j < s.n_arrays; j++)
+                s.worker[j] = group_worker[item_group_find(groups, j)];
+
+        log_debug("Processing %zu item arrays in %zu independent groups with %u workers.",
+                  s.n_arrays, n_groups, s.n_workers);
+
+        *ret = TAKE_STRUCT(s);
+        return 0;
+}
+
+static int process_item_arrays_parallel(Context *c, const ItemSchedule *s, OperationMask operation) {
+        _cleanup_close_pair_ int errno_pipe[2] = EBADF_PAIR;
+        _cleanup_free_ pid_t *pids = NULL;
+        size_t n_pids = 0, n_failed = 0, n_reported = 0;
+        int r, ret = 0;
+
+        assert(c);
+        assert(s);
+        assert(s->n_workers > 1);
+
+        /* The cache is used by all workers, so fill it once before forking */
+        if (FLAGS_SET(operation, OPERATION_CLEAN))
+                (void) load_unix_sockets(c);
+
+        pids = new(pid_t, s->n_workers);
+        if (!pids)
+                return log_oom();
+
+        /* The workers pass their error up through this, so that we can still tell resource errors apart
+         * from others. Each error is written in one go, hence they don't interleave. */
+        if (pipe2(errno_pipe, O_CLOEXEC) < 0)
+                return log_error_errno(errno, "Failed to create pipe: %m");
+
+        for (unsigned w = 0; w < s->n_workers; w++) {
+                pid_t pid;
+                int k = 0;
+
+                r = safe_fork("(sd-tmpfiles)", FORK_RESET_SIGNALS|FORK_DEATHSIG_SIGTERM|FORK_LOG, &pid);
+                if (r > 0) {
+                        pids[n_pids++] = pid;
+                        continue;
+                }
+
+                /* In the child, or forking failed, in which case we do this worker's share ourselves. */
+                for (size_t j = 0; j < s->n_arrays; j++)
+                        if (s->worker[j] == w)
+                                RET_GATHER(k, process_item_array(c, s->arrays[j], operation));
+
+                if (r == 0)
+                        report_errno_and_exit(errno_pipe[1], k);
+
+                RET_GATHER(ret, k);
+        }
+
+        errno_pipe[1] = safe_close(errno_pipe[1]);
+
+        FOREACH_ARRAY(pid, pids, n_pids) {
+                r = wait_for_terminate_and_check("(sd-tmpfiles)", *pid, WAIT_LOG_ABNORMAL);
+                if (r < 0)
+                        RET_GATHER(ret, r);
+                else if (r != EXIT_SUCCESS)
+                        n_failed++;
+        }
+
+        /* All workers exited, hence this won't block, and returns 0 once everything reported was read. */
+        for (size_t i = 0; i < n_pids; i++) {
+                r = read_errno(errno_pipe[0]);
+                if (r == 0)
+                        break;
+
+                RET_GATHER(ret, r);
+                n_reported++;
+        }
+
+        /* Be safe if a worker failed without being able to tell us why */
+        if (n_reported < n_failed)
+                RET_GATHER(ret, -EPROTO);
+
+        /* The workers operated on their own copies of the items, hence update ours. */
+        for (size_t j = 0; j < s->n_arrays; j++)
+                FOREACH_ARRAY(i, s->arrays[j]->items, s->arrays[j]->n_items)
+                        i->done |= operation;
+
+        return ret;
+}
+
 DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(item_array_hash_ops, char, string_hash_func, string_compare_func,
                                               ItemArray, item_array_free);
 
@@ -4556,6 +5028,7 @@ static int run(int argc, char *argv[]) {
 #endif
         _cleanup_strv_free_ char **config_dirs = NULL;
         _cleanup_(context_done) Context c = {};
+        _cleanup_(item_schedule_done) ItemSchedule schedule = {};
         bool invalid_config = false;
         ItemArray *a;
         enum {
@@ -4689,6 +5162,12 @@ static int run(int argc, char *argv[]) {
                         return r;
         }
 
+        if (arg_jobs > 1) {
+                r = item_schedule_build(&c, arg_jobs, &schedule);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to split items into independent groups: %m");
+        }
+
         /* If multiple operations are requested, let's first run the remove/clean operations, and only then
          * the create operations. i.e. that we first clean out the platform we then build on. */
         for (phase = 0; phase < _PHASE_MAX; phase++) {
@@ -4706,6 +5185,11 @@ static int run(int argc, char *argv[]) {
                 if (op == 0) /* Nothing requested in this phase */
                         continue;
 
+                if (schedule.n_workers > 1) {
+                        RET_GATHER(r, process_item_arrays_parallel(&c, &schedule, op));
+                        continue;
+                }
+
                 /* The non-globbing ones usually create things, hence we apply them first */
                 ORDERED_HASHMAP_FOREACH(a, c.items)
                         RET_GATHER(r, process_item_array(&c, a, op));
@@ -1,7 +1,11 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include "fileio.h"
+#include "path-util.h"
+#include "rm-rf.h"
 #include "string-util.h"
 #include "tests.h"
+#include "tmpfile-util.h"
 #include "udev-rules.h"
 
 static void test_udev_rule_parse_value_one(const char *in, const char *expected_value, bool expected_case_insensitive, int expected_retval) {
@@ -92,4 +96,46 @@ TEST(udev_rule_parse_value) {
         test_udev_rule_parse_value_one("a\"\"", NULL, /* case_insensitive = */ false, -EINVAL);
 }
 
+TEST(udev_rules_load_reuse) {
+        _cleanup_(rm_rf_physical_and_freep) char *tmpdir = NULL;
+        _cleanup_(udev_rules_freep) UdevRules *a = NULL, *b = NULL, *c = NULL;
+        _cleanup_free_ char *unchanged = NULL, *changed = NULL, *owner = NULL;
+        UdevRuleFile *f;
+
+        ASSERT_OK(mkdtemp_malloc("/tmp/test-udev-rules-XXXXXX", &tmpdir));
+
+        ASSERT_NOT_NULL(unchanged = path_join(tmpdir, "10-unchanged.rules"));
+        ASSERT_NOT_NULL(changed = path_join(tmpdir, "20-changed.rules"));
+        ASSERT_NOT_NULL(owner = path_join(tmpdir, "30-owner.rules"));
+
+        ASSERT_OK(write_string_file(unchanged, "SUBSYSTEM==\"foo\", TAG+=\"unchanged\"", WRITE_STRING_FILE_CREATE));
+        ASSERT_OK(write_string_file(changed, "SUBSYSTEM==\"foo\", TAG+=\"old\"", WRITE_STRING_FILE_CREATE));
+        ASSERT_OK(write_string_file(owner, "SUBSYSTEM==\"foo\", OWNER=\"root\"", WRITE_STRING_FILE_CREATE));
+
+        ASSERT_OK(udev_rules_load(&a, RESOLVE_NAME_EARLY, STRV_MAKE(tmpdir)));
+        ASSERT_NOT_NULL(f = udev_rules_get_file(a, unchanged));
+        ASSERT_NOT_NULL(udev_rules_get_file(a, changed));
+        ASSERT_NOT_NULL(udev_rules_get_file(a, owner));
+
+        /* Replace the file, so that it gets a new inode. */
+        ASSERT_OK(write_string_file(changed, "SUBSYSTEM==\"foo\", TAG+=\"new\"", WRITE_STRING_FILE_CREATE|WRITE_STRING_FILE_ATOMIC));
+
+        ASSERT_OK(udev_rules_load_full(&b, RESOLVE_NAME_EARLY, STRV_MAKE(tmpdir), a));
+
+        /* The unchanged file is moved over from the previous rules, ... */
+        ASSERT_TRUE(udev_rules_get_file(b, unchanged) == f);
+        ASSERT_NULL(udev_rules_get_file(a, unchanged));
+
+        /* ... while the changed file and the one that resolved a user name are parsed again. */
+        ASSERT_NOT_NULL(udev_rules_get_file(b, changed));
+        ASSERT_NOT_NULL(udev_rules_get_file(a, changed));
+        ASSERT_NOT_NULL(udev_rules_get_file(b, owner));
+        ASSERT_NOT_NULL(udev_rules_get_file(a, owner));
+
+        /* Nothing is reused when the name resolution timing changed. */
+        ASSERT_OK(udev_rules_load_full(&c, RESOLVE_NAME_LATE, STRV_MAKE(tmpdir), b));
+        ASSERT_NOT_NULL(udev_rules_get_file(c, unchanged));
+        ASSERT_TRUE(udev_rules_get_file(b, unchanged) == f);
+}
+
 DEFINE_TEST_MAIN(LOG_DEBUG);
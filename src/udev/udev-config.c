@@ -29,12 +29,13 @@ static void manager_parse_udev_config(UdevConfig *config) {
         assert(config);
 
         const ConfigTableItem config_table[] = {
-                { NULL, "udev_log",       config_parse_log_level,           0, &config->log_level           },
-                { NULL, "children_max",   config_parse_unsigned,            0, &config->children_max        },
-                { NULL, "exec_delay",     config_parse_sec,                 0, &config->exec_delay_usec     },
-                { NULL, "event_timeout",  config_parse_sec,                 0, &config->timeout_usec        },
-                { NULL, "resolve_names",  config_parse_resolve_name_timing, 0, &config->resolve_name_timing },
-                { NULL, "timeout_signal", config_parse_signal,              0, &config->timeout_signal      },
+                { NULL, "udev_log",            config_parse_log_level,           0, &config->log_level                },
+                { NULL, "children_max",        config_parse_unsigned,            0, &config->children_max             },
+                { NULL, "exec_delay",          config_parse_sec,                 0, &config->exec_delay_usec          },
+                { NULL, "event_timeout",       config_parse_sec,                 0, &config->timeout_usec             },
+                { NULL, "worker_idle_timeout", config_parse_sec,                 0, &config->worker_idle_timeout_usec },
+                { NULL, "resolve_names",       config_parse_resolve_name_timing, 0, &config->resolve_name_timing      },
+                { NULL, "timeout_signal",      config_parse_signal,              0, &config->timeout_signal           },
                 {}
         };
 
@@ -292,6 +293,7 @@ static void manager_merge_config(Manager *manager) {
         MERGE_NON_NEGATIVE(resolve_name_timing, RESOLVE_NAME_EARLY);
         MERGE_NON_ZERO(exec_delay_usec, 0);
         MERGE_NON_ZERO(timeout_usec, DEFAULT_WORKER_TIMEOUT_USEC);
+        MERGE_NON_ZERO(worker_idle_timeout_usec, DEFAULT_WORKER_IDLE_TIMEOUT_USEC);
         MERGE_NON_ZERO(timeout_signal, SIGKILL);
         MERGE_BOOL(blockdev_read_only);
 }
@@ -16,6 +16,7 @@ typedef struct UdevConfig {
         unsigned children_max;
         usec_t exec_delay_usec;
         usec_t timeout_usec;
+        usec_t worker_idle_timeout_usec;
         int timeout_signal;
         bool blockdev_read_only;
         bool trace;
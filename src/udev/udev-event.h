@@ -41,6 +41,8 @@ typedef struct UdevEvent {
         usec_t birth_usec;
         unsigned builtin_run;
         unsigned builtin_ret;
+        unsigned n_rule_lines_evaluated;
+        unsigned n_rule_tokens_evaluated;
         UdevRuleEscapeType esc:8;
         bool inotify_watch;
         bool inotify_watch_final;
@@ -56,6 +56,7 @@ typedef struct Event {
         sd_device_action_t action;
         uint64_t seqnum;
         uint64_t blocker_seqnum;
+        usec_t queued_usec;
         const char *id;
         const char *devpath;
         const char *devpath_old;
@@ -89,12 +90,133 @@ typedef struct Worker {
         Event *event;
 } Worker;
 
+DEFINE_PRIVATE_HASH_OPS_FULL(event_index_hash_ops, char, string_hash_func, string_compare_func, free, Set, set_free);
+
+static int event_index_add_one(Hashmap **index, const char *key, Event *event) {
+        _cleanup_set_free_ Set *s = NULL;
+        _cleanup_free_ char *k = NULL;
+        Set *existing;
+        int r;
+
+        assert(index);
+        assert(key);
+        assert(event);
+
+        existing = hashmap_get(*index, key);
+        if (existing)
+                return set_put(existing, event);
+
+        k = strdup(key);
+        if (!k)
+                return -ENOMEM;
+
+        r = set_ensure_put(&s, NULL, event);
+        if (r < 0)
+                return r;
+
+        r = hashmap_ensure_put(index, &event_index_hash_ops, k, s);
+        if (r < 0)
+                return r;
+
+        TAKE_PTR(k);
+        TAKE_PTR(s);
+        return 1;
+}
+
+static void event_index_remove_one(Hashmap *index, const char *key, Event *event) {
+        _cleanup_free_ char *k = NULL;
+        Set *s;
+
+        assert(key);
+        assert(event);
+
+        s = hashmap_get(index, key);
+        if (!s)
+                return;
+
+        set_remove(s, event);
+        if (!set_isempty(s))
+                return;
+
+        assert_se(hashmap_remove2(index, key, (void**) &k) == s);
+        set_free(s);
+}
+
+static int event_index_update_devpath(Event *event, const char *devpath, bool add) {
+        Manager *manager = ASSERT_PTR(ASSERT_PTR(event)->manager);
+        char *p;
+        int r;
+
+        if (!devpath)
+                return 0;
+
+        if (add) {
+                r = event_index_add_one(&manager->events_by_devpath, devpath, event);
+                if (r < 0)
+                        return r;
+        } else
+                event_index_remove_one(manager->events_by_devpath, devpath, event);
+
+        p = strdupa_safe(devpath);
+        for (;;) {
+                char *e;
+
+                e = strrchr(p, '/');
+                if (!e || e == p)
+                        return 0;
+                *e = '\0';
+
+                if (add) {
+                        r = event_index_add_one(&manager->events_by_devpath_parent, p, event);
+                        if (r < 0)
+                                return r;
+                } else
+                        event_index_remove_one(manager->events_by_devpath_parent, p, event);
+        }
+}
+
+static void event_index_remove(Event *event) {
+        Manager *manager = ASSERT_PTR(ASSERT_PTR(event)->manager);
+
+        if (event->id)
+                event_index_remove_one(manager->events_by_id, event->id, event);
+        if (event->devnode)
+                event_index_remove_one(manager->events_by_devnode, event->devnode, event);
+
+        (void) event_index_update_devpath(event, event->devpath, /* add = */ false);
+        (void) event_index_update_devpath(event, event->devpath_old, /* add = */ false);
+}
+
+static int event_index_add(Event *event) {
+        Manager *manager = ASSERT_PTR(ASSERT_PTR(event)->manager);
+        int r;
+
+        if (event->id) {
+                r = event_index_add_one(&manager->events_by_id, event->id, event);
+                if (r < 0)
+                        return r;
+        }
+
+        if (event->devnode) {
+                r = event_index_add_one(&manager->events_by_devnode, event->devnode, event);
+                if (r < 0)
+                        return r;
+        }
+
+        r = event_index_update_devpath(event, event->devpath, /* add = */ true);
+        if (r < 0)
+                return r;
+
+        return event_index_update_devpath(event, event->devpath_old, /* add = */ true);
+}
+
 static Event *event_free(Event *event) {
         if (!event)
                 return NULL;
 
         assert(event->manager);
 
+        event_index_remove(event);
         LIST_REMOVE(event, event->manager->events, event);
         sd_device_unref(event->dev);
 
@@ -145,6 +267,11 @@ Manager* manager_free(Manager *manager) {
         hashmap_free(manager->workers);
         event_queue_cleanup(manager, EVENT_UNDEF);
 
+        hashmap_free(manager->events_by_id);
+        hashmap_free(manager->events_by_devnode);
+        hashmap_free(manager->events_by_devpath);
+        hashmap_free(manager->events_by_devpath_parent);
+
         safe_close(manager->inotify_fd);
         safe_close(manager->worker_notify_fd);
 
@@ -278,22 +405,58 @@ void manager_reload(Manager *manager, bool force) {
 
         flags |= manager_reload_config(manager);
 
+        /* If the idle timeout of workers was changed to infinity, idle workers must not be killed by a timer
+         * that was armed with the previous value. */
+        if (manager->config.worker_idle_timeout_usec == USEC_INFINITY)
+                (void) event_source_disable(manager->kill_workers_event);
+
         if (FLAGS_SET(flags, UDEV_RELOAD_KILL_WORKERS))
                 manager_kill_workers(manager, false);
 
         udev_builtin_reload(flags);
 
         if (FLAGS_SET(flags, UDEV_RELOAD_RULES)) {
-                r = udev_rules_load(&rules, manager->config.resolve_name_timing, /* extra = */ NULL);
+                /* Files that did not change are moved over from the currently loaded rules. */
+                r = udev_rules_load_full(&rules, manager->config.resolve_name_timing, /* extra = */ NULL, manager->rules);
                 if (r < 0)
                         log_warning_errno(r, "Failed to read udev rules, using the previously loaded rules, ignoring: %m");
                 else
                         udev_rules_free_and_replace(manager->rules, rules);
+
+                /* Line numbers may have changed, hence start over with fresh counters. */
+                if (manager->profile) {
+                        r = udev_rules_set_profile(manager->rules, true);
+                        if (r < 0) {
+                                log_warning_errno(r, "Failed to allocate rule profiling counters, disabling profiling: %m");
+                                manager->profile = false;
+                        }
+                }
         }
 
         notify_ready(manager);
 }
 
+int manager_set_profile(Manager *manager, bool enable) {
+        int r;
+
+        assert(manager);
+
+        if (manager->profile == enable)
+                return 0;
+
+        if (manager->rules) {
+                r = udev_rules_set_profile(manager->rules, enable);
+                if (r < 0)
+                        return log_warning_errno(r, "Failed to allocate rule profiling counters: %m");
+        }
+
+        manager->profile = enable;
+
+        /* Only workers forked from now on share the counters with us, hence replace the idle ones. */
+        manager_kill_workers(manager, /* force = */ false);
+        return 0;
+}
+
 static int on_kill_workers_event(sd_event_source *s, uint64_t usec, void *userdata) {
         Manager *manager = ASSERT_PTR(userdata);
 
@@ -368,6 +531,12 @@ static void worker_attach_event(Worker *worker, Event *event) {
         event->state = EVENT_RUNNING;
         event->worker = worker;
 
+        usec_t wait_usec = usec_sub_unsigned(now(CLOCK_MONOTONIC), event->queued_usec);
+        manager->n_events_started++;
+        manager->event_wait_usec_total = usec_add(manager->event_wait_usec_total, wait_usec);
+        manager->event_wait_usec_max = MAX(manager->event_wait_usec_max, wait_usec);
+        metric_histogram_observe(&manager->event_wait_histogram, wait_usec / USEC_PER_MSEC);
+
         (void) sd_event_add_time_relative(e, &event->timeout_warning_event, CLOCK_MONOTONIC,
                                           udev_warn_timeout(manager->config.timeout_usec), USEC_PER_SEC,
                                           on_event_timeout_warning, event);
@@ -481,6 +650,23 @@ static int event_run(Event *event) {
         return 1; /* event is now processing. */
 }
 
+void manager_get_queue_statistics(Manager *manager, unsigned *ret_queued, unsigned *ret_running) {
+        unsigned queued = 0, running = 0;
+
+        assert(manager);
+        assert(ret_queued);
+        assert(ret_running);
+
+        LIST_FOREACH(event, event, manager->events)
+                if (event->state == EVENT_QUEUED)
+                        queued++;
+                else if (event->state == EVENT_RUNNING)
+                        running++;
+
+        *ret_queued = queued;
+        *ret_running = running;
+}
+
 bool devpath_conflict(const char *a, const char *b) {
         /* This returns true when two paths are equivalent, or one is a child of another. */
 
@@ -494,20 +680,86 @@ bool devpath_conflict(const char *a, const char *b) {
         return *a == '/' || *b == '/' || *a == *b;
 }
 
+static bool event_blocks(Event *blocker, Event *event) {
+        assert(blocker);
+        assert(event);
+
+        /* Returns true if 'blocker' is an earlier event for an identical, parent, or child device */
+
+        if (blocker->seqnum >= event->seqnum)
+                return false;
+
+        return streq_ptr(blocker->id, event->id) ||
+                devpath_conflict(event->devpath, blocker->devpath) ||
+                devpath_conflict(event->devpath, blocker->devpath_old) ||
+                devpath_conflict(event->devpath_old, blocker->devpath) ||
+                (event->devnode && streq_ptr(event->devnode, blocker->devnode));
+}
+
+static Event* event_find_blocker_in(Hashmap *index, const char *key, Event *event) {
+        Event *e;
+
+        assert(event);
+
+        if (!key)
+                return NULL;
+
+        SET_FOREACH(e, hashmap_get(index, key))
+                if (event_blocks(e, event))
+                        return e;
+
+        return NULL;
+}
+
+static Event* event_find_blocker_by_devpath(Event *event, const char *devpath) {
+        Manager *manager = ASSERT_PTR(ASSERT_PTR(event)->manager);
+        Event *e;
+        char *p;
+
+        if (!devpath)
+                return NULL;
+
+        /* identical or child device */
+        e = event_find_blocker_in(manager->events_by_devpath, devpath, event);
+        if (e)
+                return e;
+
+        e = event_find_blocker_in(manager->events_by_devpath_parent, devpath, event);
+        if (e)
+                return e;
+
+        /* parent device */
+        p = strdupa_safe(devpath);
+
+        for (;;) {
+                char *s;
+
+                s = strrchr(p, '/');
+                if (!s || s == p)
+                        return NULL;
+                *s = '\0';
+
+                e = event_find_blocker_in(manager->events_by_devpath, p, event);
+                if (e)
+                        return e;
+        }
+}
+
 static int event_is_blocked(Event *event) {
-        Event *loop_event = NULL;
+        Manager *manager;
+        Event *blocker;
         int r;
 
         /* lookup event for identical, parent, child device */
 
         assert(event);
-        assert(event->manager);
+        manager = ASSERT_PTR(event->manager);
         assert(event->blocker_seqnum <= event->seqnum);
 
         if (event->retry_again_next_usec > 0) {
                 usec_t now_usec;
 
-                r = sd_event_now(event->manager->event, CLOCK_BOOTTIME, &now_usec);
+                r = sd_event_now(manager->event, CLOCK_BOOTTIME, &now_usec);
                 if (r < 0)
                         return r;
 
@@ -519,60 +771,27 @@ static int event_is_blocked(Event *event) {
                 /* we have checked previously and no blocker found */
                 return false;
 
-        LIST_FOREACH(event, e, event->manager->events) {
-                loop_event = e;
-
-                /* we already found a later event, earlier cannot block us, no need to check again */
-                if (loop_event->seqnum < event->blocker_seqnum)
-                        continue;
-
-                /* event we checked earlier still exists, no need to check again */
-                if (loop_event->seqnum == event->blocker_seqnum)
-                        return true;
-
-                /* found ourself, no later event can block us */
-                if (loop_event->seqnum >= event->seqnum)
-                        goto no_blocker;
-
-                /* found event we have not checked */
-                break;
-        }
-
-        assert(loop_event);
-        assert(loop_event->seqnum > event->blocker_seqnum &&
-               loop_event->seqnum < event->seqnum);
-
-        /* check if queue contains events we depend on */
-        LIST_FOREACH(event, e, loop_event) {
-                loop_event = e;
-
-                /* found ourself, no later event can block us */
-                if (loop_event->seqnum >= event->seqnum)
-                        goto no_blocker;
-
-                if (streq_ptr(loop_event->id, event->id))
-                        break;
-
-                if (devpath_conflict(event->devpath, loop_event->devpath) ||
-                    devpath_conflict(event->devpath, loop_event->devpath_old) ||
-                    devpath_conflict(event->devpath_old, loop_event->devpath))
-                        break;
-
-                if (event->devnode && streq_ptr(event->devnode, loop_event->devnode))
-                        break;
+        /* Instead of comparing with every earlier event in the queue, only look at the events indexed under
+         * our device ID, device node, devpaths and their parents. */
+        blocker = event_find_blocker_in(manager->events_by_id, event->id, event);
+        if (!blocker)
+                blocker = event_find_blocker_in(manager->events_by_devnode, event->devnode, event);
+        if (!blocker)
+                blocker = event_find_blocker_by_devpath(event, event->devpath);
+        if (!blocker)
+                blocker = event_find_blocker_by_devpath(event, event->devpath_old);
+        if (!blocker) {
+                /* No later event can block us */
+                event->blocker_seqnum = event->seqnum;
+                return false;
         }
 
-        assert(loop_event);
-
-        log_device_debug(event->dev, "SEQNUM=%" PRIu64 " blocked by SEQNUM=%" PRIu64,
-                         event->seqnum, loop_event->seqnum);
+        if (blocker->seqnum != event->blocker_seqnum)
+                log_device_debug(event->dev, "SEQNUM=%" PRIu64 " blocked by SEQNUM=%" PRIu64,
+                                 event->seqnum, blocker->seqnum);
 
-        event->blocker_seqnum = loop_event->seqnum;
+        event->blocker_seqnum = blocker->seqnum;
         return true;
-
-no_blocker:
-        event->blocker_seqnum = event->seqnum;
-        return false;
 }
 
 static int event_queue_start(Manager *manager) {
@@ -746,6 +965,7 @@ static int event_queue_insert(Manager *manager, sd_device *dev) {
                 .devpath_old = devpath_old,
                 .devnode = devnode,
                 .state = EVENT_QUEUED,
+                .queued_usec = now(CLOCK_MONOTONIC),
         };
 
         if (!manager->events) {
@@ -756,6 +976,12 @@ static int event_queue_insert(Manager *manager, sd_device *dev) {
 
         LIST_APPEND(event, manager->events, event);
 
+        r = event_index_add(event);
+        if (r < 0) {
+                event_free(event);
+                return r;
+        }
+
         log_device_uevent(dev, "Device is queued");
 
         return 0;
@@ -1033,11 +1259,13 @@ static int on_post(sd_event_source *s, void *userdata) {
                 log_debug("No events are queued, removing /run/udev/queue.");
 
         if (!hashmap_isempty(manager->workers)) {
-                /* There are idle workers */
-                (void) event_reset_time_relative(manager->event, &manager->kill_workers_event,
-                                                 CLOCK_MONOTONIC, 3 * USEC_PER_SEC, USEC_PER_SEC,
-                                                 on_kill_workers_event, manager,
-                                                 0, "kill-workers-event", false);
+                /* There are idle workers. Keep them around for a while, as forking new ones for the next
+                 * batch of events is not free. */
+                if (manager->config.worker_idle_timeout_usec != USEC_INFINITY)
+                        (void) event_reset_time_relative(manager->event, &manager->kill_workers_event,
+                                                         CLOCK_MONOTONIC, manager->config.worker_idle_timeout_usec, USEC_PER_SEC,
+                                                         on_kill_workers_event, manager,
+                                                         0, "kill-workers-event", false);
                 return 1;
         }
 
@@ -9,6 +9,7 @@
 
 #include "hashmap.h"
 #include "macro.h"
+#include "metrics.h"
 #include "time-util.h"
 #include "udev-config.h"
 #include "udev-ctrl.h"
@@ -24,6 +25,19 @@ typedef struct Manager {
         LIST_HEAD(Event, events);
         char *cgroup;
 
+        /* All queued and running events, indexed by device ID, device node, devpath and DEVPATH_OLD=,
+         * and by every parent directory of the latter two. Used to find events blocking another one. */
+        Hashmap *events_by_id;
+        Hashmap *events_by_devnode;
+        Hashmap *events_by_devpath;
+        Hashmap *events_by_devpath_parent;
+
+        /* Statistics about the time events spent in the queue before being passed to a worker */
+        uint64_t n_events_started;
+        usec_t event_wait_usec_total;
+        usec_t event_wait_usec_max;
+        MetricHistogram event_wait_histogram; /* in ms */
+
         UdevRules *rules;
         Hashmap *properties;
 
@@ -47,6 +61,7 @@ typedef struct Manager {
         UdevConfig config;
 
         bool stop_exec_queue;
+        bool profile; /* collect per rule line counters, see udev_rules_set_profile() */
         bool exit;
 } Manager;
 
@@ -62,5 +77,7 @@ void manager_exit(Manager *manager);
 void notify_ready(Manager *manager);
 
 void manager_kill_workers(Manager *manager, bool force);
+int manager_set_profile(Manager *manager, bool enable);
 
 bool devpath_conflict(const char *a, const char *b);
+void manager_get_queue_statistics(Manager *manager, unsigned *ret_queued, unsigned *ret_running);
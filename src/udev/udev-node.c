@@ -99,6 +99,15 @@ static int stack_directory_read_one(int dirfd, const char *id, char **devnode, i
 
                 *colon = '\0';
 
+                r = safe_atoi(buf, &tmp_prio);
+                if (r < 0)
+                        return r;
+
+                /* Compare the priority first, so that when scanning a large stack directory only the entries
+                 * that would actually win need to be checked below, instead of all of them. */
+                if (devnode && *devnode && tmp_prio <= *priority)
+                        return 0; /* Unchanged */
+
                 /* Of course, this check is racy, but it is not necessary to be perfect. Even if the device
                  * node will be removed after this check, we will receive 'remove' uevent, and the invalid
                  * symlink will be removed during processing the event. The check is just for shortening the
@@ -106,16 +115,9 @@ static int stack_directory_read_one(int dirfd, const char *id, char **devnode, i
                 if (access(colon + 1, F_OK) < 0)
                         return -ENODEV;
 
-                r = safe_atoi(buf, &tmp_prio);
-                if (r < 0)
-                        return r;
-
                 if (!devnode)
                         goto finalize;
 
-                if (*devnode && tmp_prio <= *priority)
-                        return 0; /* Unchanged */
-
                 r = free_and_strdup(devnode, colon + 1);
                 if (r < 0)
                         return r;
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
 #include <ctype.h>
+#include <sys/mman.h>
 
 #include "alloc-util.h"
 #include "architecture.h"
@@ -25,6 +26,7 @@
 #include "parse-util.h"
 #include "path-util.h"
 #include "proc-cmdline.h"
+#include "sort-util.h"
 #include "socket-util.h"
 #include "stat-util.h"
 #include "string-table.h"
@@ -186,6 +188,8 @@ struct UdevRuleLine {
         const char *goto_label;
         UdevRuleLine *goto_line;
 
+        unsigned index; /* position in the whole rule set, assigned by udev_rules_build_index() */
+
         UdevRuleFile *rule_file;
         LIST_HEAD(UdevRuleToken, tokens);
         LIST_FIELDS(UdevRuleLine, rule_lines);
@@ -194,18 +198,54 @@ struct UdevRuleLine {
 struct UdevRuleFile {
         char *filename;
         unsigned issues; /* used by "udevadm verify" */
+        bool resolved_names; /* user or group names were resolved while parsing, see rule_resolve_user() */
 
         UdevRules *rules;
         LIST_HEAD(UdevRuleLine, rule_lines);
         LIST_FIELDS(UdevRuleFile, rule_files);
 };
 
+typedef enum UdevRuleIndexKey {
+        INDEX_KEY_SUBSYSTEM,
+        INDEX_KEY_ACTION,
+        INDEX_KEY_KERNEL,
+        _INDEX_KEY_MAX,
+        _INDEX_KEY_INVALID = -EINVAL,
+} UdevRuleIndexKey;
+
+/* Counters of a single rule line, collected when profiling is enabled with udev_rules_set_profile(). They
+ * live in memory shared with the worker processes, which update them atomically, so that the manager sees
+ * the sum over all workers. */
+typedef struct UdevRuleProfile {
+        uint64_t usec;         /* time spent checking the conditions and applying the assignments */
+        uint64_t n_evaluated;
+        uint64_t n_matched;
+        uint64_t spawn_usec;   /* time spent in PROGRAM= and IMPORT{program}=, included in 'usec' */
+        uint64_t n_spawned;
+} UdevRuleProfile;
+
+typedef struct UdevRuleLineArray {
+        UdevRuleLine **lines;
+        size_t n_lines;
+} UdevRuleLineArray;
+
 struct UdevRules {
         ResolveNameTiming resolve_name_timing;
         Hashmap *known_users;
         Hashmap *known_groups;
         Hashmap *stats_by_path;
         LIST_HEAD(UdevRuleFile, rule_files);
+
+        /* Lines which can only match when SUBSYSTEM, ACTION or KERNEL equal one of a set of literal values
+         * are indexed by those values, all other lines are collected in 'unindexed'. Each array is in rule
+         * order, so that walking them merged is equivalent to walking all lines. */
+        bool indexed;
+        UdevRuleLineArray unindexed;
+        Hashmap *index[_INDEX_KEY_MAX]; /* value → UdevRuleLineArray */
+
+        /* Indexed by UdevRuleLine.index, shared with the workers forked after it was allocated */
+        UdevRuleProfile *profile;
+        size_t profile_size;
 };
 
 #define LINE_GET_RULES(line)                                            \
@@ -215,6 +255,21 @@ static bool token_is_for_parents(UdevRuleToken *token) {
         return token->type >= TK_M_PARENTS_KERNEL && token->type <= TK_M_PARENTS_TAG;
 }
 
+static UdevRuleProfile* rule_line_get_profile(UdevRuleLine *line) {
+        UdevRules *rules = LINE_GET_RULES(line);
+
+        if (!rules->profile)
+                return NULL;
+
+        assert(line->index < rules->profile_size / sizeof(UdevRuleProfile));
+        return rules->profile + line->index;
+}
+
+static void profile_add(uint64_t *counter, uint64_t n) {
+        /* Multiple workers may process events concurrently */
+        (void) __atomic_add_fetch(counter, n, __ATOMIC_RELAXED);
+}
+
 /*** Logging helpers ***/
 
 #define _log_udev_rule_file_full(device, device_u, file, file_u, line_nr, level, level_u, error, fmt, ...) \
@@ -410,6 +465,34 @@ static bool token_is_for_parents(UdevRuleToken *token) {
 
 /*** Other functions ***/
 
+static UdevRuleLineArray* udev_rule_line_array_free(UdevRuleLineArray *a) {
+        if (!a)
+                return NULL;
+
+        free(a->lines);
+        return mfree(a);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(UdevRuleLineArray*, udev_rule_line_array_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(
+                udev_rule_line_array_hash_ops,
+                char, string_hash_func, string_compare_func,
+                UdevRuleLineArray, udev_rule_line_array_free);
+
+static void udev_rules_drop_index(UdevRules *rules) {
+        if (!rules)
+                return;
+
+        rules->unindexed.lines = mfree(rules->unindexed.lines);
+        rules->unindexed.n_lines = 0;
+
+        FOREACH_ELEMENT(h, rules->index)
+                *h = hashmap_free(*h);
+
+        rules->indexed = false;
+}
+
 static UdevRuleToken* udev_rule_token_free(UdevRuleToken *token) {
         if (!token)
                 return NULL;
@@ -435,8 +518,10 @@ static UdevRuleLine* udev_rule_line_free(UdevRuleLine *rule_line) {
 
         udev_rule_line_clear_tokens(rule_line);
 
-        if (rule_line->rule_file)
+        if (rule_line->rule_file) {
+                udev_rules_drop_index(rule_line->rule_file->rules);
                 LIST_REMOVE(rule_lines, rule_line->rule_file->rule_lines, rule_line);
+        }
 
         free(rule_line->line);
         free(rule_line->line_for_logging);
@@ -452,8 +537,10 @@ static UdevRuleFile* udev_rule_file_free(UdevRuleFile *rule_file) {
         LIST_FOREACH(rule_lines, i, rule_file->rule_lines)
                 udev_rule_line_free(i);
 
-        if (rule_file->rules)
+        if (rule_file->rules) {
+                udev_rules_drop_index(rule_file->rules);
                 LIST_REMOVE(rule_files, rule_file->rules->rule_files, rule_file);
+        }
 
         free(rule_file->filename);
         return mfree(rule_file);
@@ -468,6 +555,8 @@ UdevRules* udev_rules_free(UdevRules *rules) {
         LIST_FOREACH(rule_files, i, rules->rule_files)
                 udev_rule_file_free(i);
 
+        udev_rules_drop_index(rules);
+        (void) udev_rules_set_profile(rules, false);
         hashmap_free(rules->known_users);
         hashmap_free(rules->known_groups);
         hashmap_free(rules->stats_by_path);
@@ -484,6 +573,9 @@ static int rule_resolve_user(UdevRuleLine *rule_line, const char *name, uid_t *r
         assert(name);
         assert(ret);
 
+        /* The result depends on the user database, hence the file cannot be reused on reload. */
+        rule_line->rule_file->resolved_names = true;
+
         val = hashmap_get(*known_users, name);
         if (val) {
                 *ret = PTR_TO_UID(val);
@@ -528,6 +620,9 @@ static int rule_resolve_group(UdevRuleLine *rule_line, const char *name, gid_t *
         assert(name);
         assert(ret);
 
+        /* The result depends on the user database, hence the file cannot be reused on reload. */
+        rule_line->rule_file->resolved_names = true;
+
         val = hashmap_get(*known_groups, name);
         if (val) {
                 *ret = PTR_TO_GID(val);
@@ -1694,6 +1789,7 @@ int udev_rules_parse_file(UdevRules *rules, const char *filename, bool extra_che
                 .rules = rules,
         };
 
+        udev_rules_drop_index(rules);
         LIST_APPEND(rule_files, rules->rule_files, rule_file);
 
         _cleanup_free_ char *continuation = NULL;
@@ -1781,6 +1877,122 @@ unsigned udev_rule_file_get_issues(UdevRuleFile *rule_file) {
         return rule_file->issues;
 }
 
+UdevRuleFile* udev_rules_get_file(UdevRules *rules, const char *filename) {
+        assert(rules);
+        assert(filename);
+
+        LIST_FOREACH(rule_files, file, rules->rule_files)
+                if (streq(file->filename, filename))
+                        return file;
+
+        return NULL;
+}
+
+static UdevRuleToken* rule_line_find_index_token(UdevRuleLine *line, UdevRuleIndexKey *ret_key) {
+        static const UdevRuleTokenType index_token_type[_INDEX_KEY_MAX] = {
+                [INDEX_KEY_SUBSYSTEM] = TK_M_SUBSYSTEM,
+                [INDEX_KEY_ACTION]    = TK_M_ACTION,
+                [INDEX_KEY_KERNEL]    = TK_M_KERNEL,
+        };
+
+        assert(line);
+        assert(ret_key);
+
+        /* These match tokens sort before all tokens with side effects (e.g. PROGRAM= or IMPORT=), hence
+         * skipping a line that fails one of them is indistinguishable from evaluating it. */
+        for (UdevRuleIndexKey k = 0; k < _INDEX_KEY_MAX; k++)
+                LIST_FOREACH(tokens, token, line->tokens)
+                        if (token->type == index_token_type[k] &&
+                            token->op == OP_MATCH &&
+                            token->match_type == MATCH_TYPE_PLAIN) {
+                                *ret_key = k;
+                                return token;
+                        }
+
+        *ret_key = _INDEX_KEY_INVALID;
+        return NULL;
+}
+
+static int udev_rule_line_array_append(UdevRuleLineArray *a, UdevRuleLine *line) {
+        assert(a);
+        assert(line);
+
+        /* The same value may be listed more than once, e.g. SUBSYSTEM=="block|block" */
+        if (a->n_lines > 0 && a->lines[a->n_lines - 1] == line)
+                return 0;
+
+        if (!GREEDY_REALLOC(a->lines, a->n_lines + 1))
+                return -ENOMEM;
+
+        a->lines[a->n_lines++] = line;
+        return 0;
+}
+
+static int udev_rules_index_line(UdevRules *rules, UdevRuleLine *line) {
+        UdevRuleIndexKey key;
+        UdevRuleToken *token;
+        int r;
+
+        assert(rules);
+        assert(line);
+
+        token = rule_line_find_index_token(line, &key);
+        if (!token)
+                return udev_rule_line_array_append(&rules->unindexed, line);
+
+        NULSTR_FOREACH(v, token->value) {
+                UdevRuleLineArray *a;
+
+                a = hashmap_get(rules->index[key], v);
+                if (!a) {
+                        _cleanup_(udev_rule_line_array_freep) UdevRuleLineArray *new_a = NULL;
+
+                        new_a = new0(UdevRuleLineArray, 1);
+                        if (!new_a)
+                                return -ENOMEM;
+
+                        r = hashmap_ensure_put(&rules->index[key], &udev_rule_line_array_hash_ops, v, new_a);
+                        if (r < 0)
+                                return r;
+
+                        a = TAKE_PTR(new_a);
+                }
+
+                r = udev_rule_line_array_append(a, line);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static int udev_rules_build_index(UdevRules *rules) {
+        unsigned n = 0;
+        int r;
+
+        assert(rules);
+
+        if (rules->indexed)
+                return 0;
+
+        LIST_FOREACH(rule_files, file, rules->rule_files)
+                LIST_FOREACH(rule_lines, line, file->rule_lines) {
+                        line->index = n++;
+
+                        r = udev_rules_index_line(rules, line);
+                        if (r < 0) {
+                                udev_rules_drop_index(rules);
+                                return r;
+                        }
+                }
+
+        rules->indexed = true;
+
+        log_debug("Indexed %u udev rule lines, %zu of them without literal SUBSYSTEM, ACTION or KERNEL match.",
+                  n, rules->unindexed.n_lines);
+        return 0;
+}
+
 UdevRules* udev_rules_new(ResolveNameTiming resolve_name_timing) {
         assert(resolve_name_timing >= 0 && resolve_name_timing < _RESOLVE_NAME_TIMING_MAX);
 
@@ -1795,7 +2007,55 @@ UdevRules* udev_rules_new(ResolveNameTiming resolve_name_timing) {
         return rules;
 }
 
-int udev_rules_load(UdevRules **ret_rules, ResolveNameTiming resolve_name_timing, char * const *extra) {
+static int udev_rules_take_file(UdevRules *rules, UdevRules *previous, const char *filename) {
+        struct stat st, *previous_st;
+        UdevRuleFile *file;
+        int r;
+
+        assert(rules);
+        assert(filename);
+
+        /* Moves the already parsed file over from the previously loaded rules, if it did not change since
+         * then. Returns 1 if the file was taken, 0 if it needs to be parsed again. */
+
+        if (!previous || previous->resolve_name_timing != rules->resolve_name_timing)
+                return 0;
+
+        previous_st = hashmap_get(previous->stats_by_path, filename);
+        if (!previous_st)
+                return 0;
+
+        file = udev_rules_get_file(previous, filename);
+        if (!file || file->resolved_names)
+                return 0;
+
+        if (stat(filename, &st) < 0)
+                return 0; /* Let udev_rules_parse_file() handle and log this */
+
+        if (!stat_inode_unmodified(&st, previous_st))
+                return 0;
+
+        r = hashmap_put_stats_by_path(&rules->stats_by_path, filename, &st);
+        if (r < 0)
+                return r;
+
+        udev_rules_drop_index(previous);
+        LIST_REMOVE(rule_files, previous->rule_files, file);
+
+        udev_rules_drop_index(rules);
+        file->rules = rules;
+        LIST_APPEND(rule_files, rules->rule_files, file);
+
+        log_debug("Reusing unchanged rules file: %s", filename);
+        return 1;
+}
+
+int udev_rules_load_full(
+                UdevRules **ret_rules,
+                ResolveNameTiming resolve_name_timing,
+                char * const *extra,
+                UdevRules *previous) {
+
         _cleanup_(udev_rules_freep) UdevRules *rules = NULL;
         _cleanup_strv_free_ char **files = NULL, **directories = NULL;
         int r;
@@ -1819,11 +2079,22 @@ int udev_rules_load(UdevRules **ret_rules, ResolveNameTiming resolve_name_timing
                 return log_debug_errno(r, "Failed to enumerate rules files: %m");
 
         STRV_FOREACH(f, files) {
+                r = udev_rules_take_file(rules, previous, *f);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to reuse previously loaded rules file %s, parsing it again: %m", *f);
+                if (r > 0)
+                        continue;
+
                 r = udev_rules_parse_file(rules, *f, /* extra_checks = */ false, NULL);
                 if (r < 0)
                         log_debug_errno(r, "Failed to read rules file %s, ignoring: %m", *f);
         }
 
+        /* Build the index now, so that workers forked off later inherit it instead of each building it again. */
+        r = udev_rules_build_index(rules);
+        if (r < 0)
+                log_debug_errno(r, "Failed to build index of udev rules, ignoring: %m");
+
         *ret_rules = TAKE_PTR(rules);
         return 0;
 }
@@ -2176,6 +2447,34 @@ static void udev_replace_chars_and_log(UdevEvent *event, UdevRuleToken *token, c
                                 count, what, buf);
 }
 
+static int udev_rule_spawn(
+                UdevRuleToken *token,
+                UdevEvent *event,
+                const char *cmd,
+                char *result,
+                size_t result_size,
+                bool *ret_truncated) {
+
+        UdevRuleProfile *profile;
+        usec_t begin_usec = 0;
+        int r;
+
+        assert(token);
+
+        profile = rule_line_get_profile(token->rule_line);
+        if (profile)
+                begin_usec = now(CLOCK_MONOTONIC);
+
+        r = udev_event_spawn(event, /* accept_failure = */ true, cmd, result, result_size, ret_truncated);
+
+        if (profile) {
+                profile_add(&profile->spawn_usec, usec_sub_unsigned(now(CLOCK_MONOTONIC), begin_usec));
+                profile_add(&profile->n_spawned, 1);
+        }
+
+        return r;
+}
+
 static int udev_rule_apply_token_to_event(
                 UdevRuleToken *token,
                 sd_device *dev,
@@ -2192,6 +2491,8 @@ static int udev_rule_apply_token_to_event(
          * 1 on the current token matches the event, and
          * negative errno on some critical errors. */
 
+        event->n_rule_tokens_evaluated++;
+
         switch (token->type) {
         case TK_M_ACTION: {
                 sd_device_action_t a;
@@ -2352,7 +2653,7 @@ static int udev_rule_apply_token_to_event(
 
                 log_event_debug(event, token, "Running command \"%s\"", buf);
 
-                r = udev_event_spawn(event, /* accept_failure = */ true, buf, result, sizeof(result), NULL);
+                r = udev_rule_spawn(token, event, buf, result, sizeof(result), NULL);
                 if (r != 0) {
                         if (r < 0)
                                 log_event_warning_errno(event, token, r, "Failed to execute \"%s\": %m", buf);
@@ -2425,7 +2726,7 @@ static int udev_rule_apply_token_to_event(
 
                 log_event_debug(event, token, "Importing properties from results of \"%s\"", buf);
 
-                r = udev_event_spawn(event, /* accept_failure = */ true, buf, result, sizeof result, &truncated);
+                r = udev_rule_spawn(token, event, buf, result, sizeof result, &truncated);
                 if (r != 0) {
                         if (r < 0)
                                 log_event_warning_errno(event, token, r, "Failed to execute \"%s\", ignoring: %m", buf);
@@ -3163,14 +3464,46 @@ static int udev_rule_apply_parent_token_to_event(UdevRuleToken *head_token, Udev
         }
 }
 
+static int udev_rule_apply_tokens_to_event(UdevRuleLine *line, UdevEvent *event) {
+        bool parents_done = false;
+        int r;
+
+        assert(line);
+        assert(event);
+
+        /* Returns positive if all conditions of the line matched, and hence all its assignments were
+         * applied, zero if a condition did not match. */
+
+        LIST_FOREACH(tokens, token, line->tokens) {
+                if (token_is_for_parents(token)) {
+                        if (parents_done)
+                                continue;
+
+                        r = udev_rule_apply_parent_token_to_event(token, event);
+                        if (r <= 0)
+                                return r;
+
+                        parents_done = true;
+                        continue;
+                }
+
+                r = udev_rule_apply_token_to_event(token, event->dev, event);
+                if (r <= 0)
+                        return r;
+        }
+
+        return 1;
+}
+
 static int udev_rule_apply_line_to_event(
                 UdevRuleLine *line,
                 UdevEvent *event,
                 UdevRuleLine **next_line) {
 
         UdevRuleLineType mask = LINE_HAS_GOTO | LINE_UPDATE_SOMETHING;
-        bool parents_done = false;
         sd_device_action_t action;
+        UdevRuleProfile *profile;
+        usec_t begin_usec = 0;
         int r;
 
         assert(line);
@@ -3192,28 +3525,27 @@ static int udev_rule_apply_line_to_event(
         if ((line->type & mask) == 0)
                 return 0;
 
+        event->n_rule_lines_evaluated++;
         event->esc = ESCAPE_UNSET;
 
         DEVICE_TRACE_POINT(rules_apply_line, event->dev, line->rule_file->filename, line->line_number);
 
-        LIST_FOREACH(tokens, token, line->tokens) {
-                if (token_is_for_parents(token)) {
-                        if (parents_done)
-                                continue;
-
-                        r = udev_rule_apply_parent_token_to_event(token, event);
-                        if (r <= 0)
-                                return r;
+        profile = rule_line_get_profile(line);
+        if (profile)
+                begin_usec = now(CLOCK_MONOTONIC);
 
-                        parents_done = true;
-                        continue;
-                }
+        r = udev_rule_apply_tokens_to_event(line, event);
 
-                r = udev_rule_apply_token_to_event(token, event->dev, event);
-                if (r <= 0)
-                        return r;
+        if (profile) {
+                profile_add(&profile->usec, usec_sub_unsigned(now(CLOCK_MONOTONIC), begin_usec));
+                profile_add(&profile->n_evaluated, 1);
+                if (r > 0)
+                        profile_add(&profile->n_matched, 1);
         }
 
+        if (r <= 0)
+                return r;
+
         if (line->goto_line) {
                 log_event_line(event, line, "GOTO=%s", strna(line->goto_label));
                 *next_line = line->goto_line; /* update next_line only when the line has GOTO token. */
@@ -3222,12 +3554,74 @@ static int udev_rule_apply_line_to_event(
         return 0;
 }
 
+static int udev_rules_apply_to_event_indexed(UdevRules *rules, UdevEvent *event) {
+        UdevRuleLineArray *candidates[1 + _INDEX_KEY_MAX];
+        size_t pos[1 + _INDEX_KEY_MAX] = {}, n = 0;
+        const char *values[_INDEX_KEY_MAX] = {};
+        sd_device_action_t action;
+        int r;
+
+        assert(rules);
+        assert(rules->indexed);
+        assert(event);
+
+        /* Like the unindexed path, treat a device without action (e.g. with 'udevadm test' on a device
+         * read from sysfs) as one that matches no ACTION== line. */
+        if (sd_device_get_action(event->dev, &action) < 0)
+                action = _SD_DEVICE_ACTION_INVALID;
+
+        values[INDEX_KEY_ACTION] = device_action_to_string(action);
+        (void) sd_device_get_subsystem(event->dev, &values[INDEX_KEY_SUBSYSTEM]);
+        (void) sd_device_get_sysname(event->dev, &values[INDEX_KEY_KERNEL]);
+
+        candidates[n++] = &rules->unindexed;
+        for (UdevRuleIndexKey k = 0; k < _INDEX_KEY_MAX; k++) {
+                UdevRuleLineArray *a;
+
+                a = values[k] ? hashmap_get(rules->index[k], values[k]) : NULL;
+                if (a)
+                        candidates[n++] = a;
+        }
+
+        /* Walk the candidate arrays merged by rule order, lines in no candidate array cannot match */
+        for (;;) {
+                UdevRuleLine *line = NULL, *next_line = NULL;
+                size_t c = 0;
+
+                for (size_t i = 0; i < n; i++)
+                        if (pos[i] < candidates[i]->n_lines &&
+                            (!line || candidates[i]->lines[pos[i]]->index < line->index)) {
+                                line = candidates[i]->lines[pos[i]];
+                                c = i;
+                        }
+                if (!line)
+                        return 0;
+
+                pos[c]++;
+
+                r = udev_rule_apply_line_to_event(line, event, &next_line);
+                if (r < 0)
+                        return r;
+
+                /* GOTO always jumps forward within the same file, skip everything up to the label */
+                if (next_line)
+                        for (size_t i = 0; i < n; i++)
+                                while (pos[i] < candidates[i]->n_lines &&
+                                       candidates[i]->lines[pos[i]]->index < next_line->index)
+                                        pos[i]++;
+        }
+}
+
 int udev_rules_apply_to_event(UdevRules *rules, UdevEvent *event) {
         int r;
 
         assert(rules);
         assert(event);
 
+        /* When tracing, evaluate every line, so that the log explains why each line did not match. */
+        if (!event->trace && udev_rules_build_index(rules) >= 0)
+                return udev_rules_apply_to_event_indexed(rules, event);
+
         LIST_FOREACH(rule_files, file, rules->rule_files)
                 LIST_FOREACH_WITH_NEXT(rule_lines, line, next_line, file->rule_lines) {
                         r = udev_rule_apply_line_to_event(line, event, &next_line);
@@ -3285,6 +3679,107 @@ int udev_rules_apply_static_dev_perms(UdevRules *rules) {
         return 0;
 }
 
+int udev_rules_set_profile(UdevRules *rules, bool enable) {
+        unsigned n = 0;
+        size_t size;
+        void *p;
+
+        assert(rules);
+
+        /* Allocates the profiling counters in anonymous shared memory, so that worker processes forked
+         * afterwards update the very same counters. Disabling drops them, enabling again starts from
+         * zero. */
+
+        if (!enable) {
+                if (rules->profile)
+                        assert_se(munmap(rules->profile, rules->profile_size) >= 0);
+
+                rules->profile = NULL;
+                rules->profile_size = 0;
+                return 0;
+        }
+
+        if (rules->profile)
+                return 0;
+
+        /* Same numbering as udev_rules_build_index(), but also covers lines if indexing failed. */
+        LIST_FOREACH(rule_files, file, rules->rule_files)
+                LIST_FOREACH(rule_lines, line, file->rule_lines)
+                        line->index = n++;
+
+        size = PAGE_ALIGN(MAX(n, 1U) * sizeof(UdevRuleProfile));
+        p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+                return -errno;
+
+        rules->profile = p;
+        rules->profile_size = size;
+        return 0;
+}
+
+static int rule_line_compare_profile(UdevRuleLine * const *a, UdevRuleLine * const *b, UdevRules *rules) {
+        const UdevRuleProfile *x = rules->profile + (*a)->index, *y = rules->profile + (*b)->index;
+
+        /* Most expensive first */
+        return CMP(y->usec, x->usec) ?: CMP((*a)->index, (*b)->index);
+}
+
+int udev_rules_get_profile(UdevRules *rules, sd_json_variant **ret) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        _cleanup_free_ UdevRuleLine **lines = NULL;
+        size_t n = 0;
+        int r;
+
+        assert(rules);
+        assert(ret);
+
+        /* Returns the counters of all lines that were evaluated at least once as JSON array, sorted by the
+         * time spent on them, or NULL if profiling is not enabled. */
+
+        if (!rules->profile) {
+                *ret = NULL;
+                return 0;
+        }
+
+        LIST_FOREACH(rule_files, file, rules->rule_files)
+                LIST_FOREACH(rule_lines, line, file->rule_lines) {
+                        if (__atomic_load_n(&rules->profile[line->index].n_evaluated, __ATOMIC_RELAXED) == 0)
+                                continue;
+
+                        if (!GREEDY_REALLOC(lines, n + 1))
+                                return -ENOMEM;
+
+                        lines[n++] = line;
+                }
+
+        typesafe_qsort_r(lines, n, rule_line_compare_profile, rules);
+
+        FOREACH_ARRAY(i, lines, n) {
+                const UdevRuleProfile *p = rules->profile + (*i)->index;
+
+                r = sd_json_variant_append_arraybo(
+                                &v,
+                                SD_JSON_BUILD_PAIR_STRING("file", (*i)->rule_file->filename),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("line", (*i)->line_number),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("usec", p->usec),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("evaluated", p->n_evaluated),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("matched", p->n_matched),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("spawnUSec", p->spawn_usec),
+                                SD_JSON_BUILD_PAIR_UNSIGNED("spawned", p->n_spawned));
+                if (r < 0)
+                        return r;
+        }
+
+        if (!v) {
+                r = sd_json_variant_new_array(&v, NULL, 0);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = TAKE_PTR(v);
+        return 1;
+}
+
 static const char* const resolve_name_timing_table[_RESOLVE_NAME_TIMING_MAX] = {
         [RESOLVE_NAME_NEVER] = "never",
         [RESOLVE_NAME_LATE]  = "late",
@@ -1,9 +1,12 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include "json-util.h"
+#include "metrics.h"
 #include "strv.h"
 #include "udev-manager.h"
+#include "udev-rules.h"
 #include "udev-varlink.h"
+#include "varlink-io.systemd.Metrics.h"
 #include "varlink-io.systemd.Udev.h"
 #include "varlink-io.systemd.service.h"
 #include "varlink-util.h"
@@ -123,6 +126,125 @@ static int vl_method_start_stop_exec_queue(sd_varlink *link, sd_json_variant *pa
         return sd_varlink_reply(link, NULL);
 }
 
+static int vl_method_get_queue_statistics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        Manager *manager = ASSERT_PTR(userdata);
+        unsigned queued, running;
+        int r;
+
+        assert(link);
+
+        r = sd_varlink_dispatch(link, parameters, /* dispatch_table = */ NULL, /* userdata = */ NULL);
+        if (r != 0)
+                return r;
+
+        log_debug("Received io.systemd.Udev.GetQueueStatistics()");
+        manager_get_queue_statistics(manager, &queued, &running);
+
+        return sd_varlink_replybo(
+                        link,
+                        SD_JSON_BUILD_PAIR_UNSIGNED("queued", queued),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("running", running),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("started", manager->n_events_started),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("waitUSecTotal", manager->event_wait_usec_total),
+                        SD_JSON_BUILD_PAIR_UNSIGNED("waitUSecMax", manager->event_wait_usec_max));
+}
+
+static int metric_events(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+        unsigned queued, running;
+        int r;
+
+        manager_get_queue_statistics(manager, &queued, &running);
+
+        r = metric_append_value(array, f, "state", "queued", queued);
+        if (r < 0)
+                return r;
+
+        return metric_append_value(array, f, "state", "running", running);
+}
+
+static int metric_events_started(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, manager->n_events_started);
+}
+
+static int metric_event_wait(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+
+        return metric_append_histogram(array, f, NULL, NULL, &manager->event_wait_histogram);
+}
+
+static int metric_workers(const MetricFamily *f, void *userdata, sd_json_variant **array) {
+        Manager *manager = ASSERT_PTR(userdata);
+
+        return metric_append_value(array, f, NULL, NULL, hashmap_size(manager->workers));
+}
+
+static const MetricFamily manager_metric_families[] = {
+        { "io.systemd.Udev.Events",             "Events in the queue, by state",                             METRIC_GAUGE,     metric_events         },
+        { "io.systemd.Udev.EventsStartedTotal", "Events passed to a worker",                                 METRIC_COUNTER,   metric_events_started },
+        { "io.systemd.Udev.EventWaitMSec",      "Time events were queued before passed to a worker, in ms",  METRIC_HISTOGRAM, metric_event_wait     },
+        { "io.systemd.Udev.Workers",            "Worker processes, idle or busy",                            METRIC_GAUGE,     metric_workers        },
+        {}
+};
+
+static int vl_method_list_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_list(link, parameters, manager_metric_families, userdata);
+}
+
+static int vl_method_describe_metrics(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        return metrics_method_describe(link, parameters, manager_metric_families);
+}
+
+static int vl_method_set_profile(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        bool enable;
+        int r;
+
+        static const sd_json_dispatch_field dispatch_table[] = {
+                { "enable", SD_JSON_VARIANT_BOOLEAN, sd_json_dispatch_stdbool, 0, SD_JSON_MANDATORY },
+                {}
+        };
+
+        assert(link);
+
+        r = sd_varlink_dispatch(link, parameters, dispatch_table, &enable);
+        if (r != 0)
+                return r;
+
+        log_debug("Received io.systemd.Udev.SetProfile(%s)", yes_no(enable));
+        r = manager_set_profile(userdata, enable);
+        if (r < 0)
+                return r;
+
+        return sd_varlink_reply(link, NULL);
+}
+
+static int vl_method_get_profile(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
+        _cleanup_(sd_json_variant_unrefp) sd_json_variant *v = NULL;
+        Manager *manager = ASSERT_PTR(userdata);
+        int r;
+
+        assert(link);
+
+        r = sd_varlink_dispatch(link, parameters, /* dispatch_table = */ NULL, /* userdata = */ NULL);
+        if (r != 0)
+                return r;
+
+        log_debug("Received io.systemd.Udev.GetProfile()");
+
+        if (manager->profile && manager->rules) {
+                r = udev_rules_get_profile(manager->rules, &v);
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_varlink_replybo(
+                        link,
+                        SD_JSON_BUILD_PAIR_BOOLEAN("enabled", manager->profile),
+                        JSON_BUILD_PAIR_VARIANT_NON_NULL("rules", v));
+}
+
 static int vl_method_exit(sd_varlink *link, sd_json_variant *parameters, sd_varlink_method_flags_t flags, void *userdata) {
         int r;
 
@@ -170,6 +292,7 @@ int manager_start_varlink_server(Manager *manager) {
         r = sd_varlink_server_add_interface_many(
                         v,
                         &vl_interface_io_systemd_service,
+                        &vl_interface_io_systemd_Metrics,
                         &vl_interface_io_systemd_Udev);
         if (r < 0)
                 return log_error_errno(r, "Failed to add Varlink interface: %m");
@@ -185,7 +308,12 @@ int manager_start_varlink_server(Manager *manager) {
                         "io.systemd.Udev.SetEnvironment",    vl_method_set_environment,
                         "io.systemd.Udev.StartExecQueue",    vl_method_start_stop_exec_queue,
                         "io.systemd.Udev.StopExecQueue",     vl_method_start_stop_exec_queue,
-                        "io.systemd.Udev.Exit",              vl_method_exit);
+                        "io.systemd.Udev.GetQueueStatistics", vl_method_get_queue_statistics,
+                        "io.systemd.Udev.SetProfile",        vl_method_set_profile,
+                        "io.systemd.Udev.GetProfile",        vl_method_get_profile,
+                        "io.systemd.Udev.Exit",              vl_method_exit,
+                        "io.systemd.Metrics.List",           vl_method_list_metrics,
+                        "io.systemd.Metrics.Describe",       vl_method_describe_metrics);
         if (r < 0)
                 return log_error_errno(r, "Failed to bind Varlink methods: %m");
 
@@ -14,6 +14,7 @@
 
 #define DEFAULT_WORKER_TIMEOUT_USEC (3 * USEC_PER_MINUTE)
 #define MIN_WORKER_TIMEOUT_USEC     (1 * USEC_PER_MSEC)
+#define DEFAULT_WORKER_IDLE_TIMEOUT_USEC (3 * USEC_PER_SEC)
 
 typedef struct UdevRules UdevRules;
 
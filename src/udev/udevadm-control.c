@@ -10,6 +10,8 @@
 
 #include "creds-util.h"
 #include "errno-util.h"
+#include "format-table.h"
+#include "json-util.h"
 #include "parse-argument.h"
 #include "parse-util.h"
 #include "process-util.h"
@@ -32,6 +34,8 @@ static int arg_max_children = -1;
 static int arg_log_level = -1;
 static int arg_start_exec_queue = -1;
 static int arg_trace = -1;
+static int arg_profile = -1;
+static bool arg_show_profile = false;
 static bool arg_load_credentials = false;
 
 STATIC_DESTRUCTOR_REGISTER(arg_env, strv_freep);
@@ -45,7 +49,9 @@ static bool arg_has_control_commands(void) {
                 !strv_isempty(arg_env) ||
                 arg_max_children >= 0 ||
                 arg_ping ||
-                arg_trace >= 0;
+                arg_trace >= 0 ||
+                arg_profile >= 0 ||
+                arg_show_profile;
 }
 
 static int help(void) {
@@ -62,6 +68,8 @@ static int help(void) {
                "  -m --children-max=N      Maximum number of children\n"
                "     --ping                Wait for udev to respond to a ping message\n"
                "     --trace=BOOL          Enable/disable trace logging\n"
+               "     --profile=BOOL        Enable/disable collecting the time spent on each rule\n"
+               "     --show-profile        Show the rules the most time was spent on\n"
                "  -t --timeout=SECONDS     Maximum time to block for a reply\n"
                "     --load-credentials    Load udev rules from credentials\n",
                program_invocation_short_name);
@@ -73,6 +81,8 @@ static int parse_argv(int argc, char *argv[]) {
         enum {
                 ARG_PING = 0x100,
                 ARG_TRACE,
+                ARG_PROFILE,
+                ARG_SHOW_PROFILE,
                 ARG_LOAD_CREDENTIALS,
         };
 
@@ -89,6 +99,8 @@ static int parse_argv(int argc, char *argv[]) {
                 { "children-max",     required_argument, NULL, 'm'                  },
                 { "ping",             no_argument,       NULL, ARG_PING             },
                 { "trace",            required_argument, NULL, ARG_TRACE            },
+                { "profile",          required_argument, NULL, ARG_PROFILE          },
+                { "show-profile",     no_argument,       NULL, ARG_SHOW_PROFILE     },
                 { "timeout",          required_argument, NULL, 't'                  },
                 { "load-credentials", no_argument,       NULL, ARG_LOAD_CREDENTIALS },
                 { "version",          no_argument,       NULL, 'V'                  },
@@ -157,6 +169,18 @@ static int parse_argv(int argc, char *argv[]) {
                         arg_trace = r;
                         break;
 
+                case ARG_PROFILE:
+                        r = parse_boolean_argument("--profile=", optarg, NULL);
+                        if (r < 0)
+                                return r;
+
+                        arg_profile = r;
+                        break;
+
+                case ARG_SHOW_PROFILE:
+                        arg_show_profile = true;
+                        break;
+
                 case 't':
                         r = parse_sec(optarg, &arg_timeout);
                         if (r < 0)
@@ -248,6 +272,9 @@ static int send_control_commands_via_ctrl(void) {
                         return log_error_errno(r, "Failed to send a ping message: %m");
         }
 
+        if (arg_profile >= 0 || arg_show_profile)
+                log_warning("Rule profiling is not supported by the legacy control socket, ignoring.");
+
         r = udev_ctrl_wait(uctrl, arg_timeout);
         if (r < 0)
                 return log_error_errno(r, "Failed to wait for daemon to reply: %m");
@@ -255,6 +282,82 @@ static int send_control_commands_via_ctrl(void) {
         return 0;
 }
 
+typedef struct RuleProfile {
+        const char *file;
+        unsigned line;
+        uint64_t usec;
+        uint64_t evaluated;
+        uint64_t matched;
+        uint64_t spawn_usec;
+        uint64_t spawned;
+} RuleProfile;
+
+static int show_profile(sd_varlink *link) {
+        static const sd_json_dispatch_field dispatch_table[] = {
+                { "file",      SD_JSON_VARIANT_STRING,        sd_json_dispatch_const_string, offsetof(RuleProfile, file),       SD_JSON_MANDATORY },
+                { "line",      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint,         offsetof(RuleProfile, line),       SD_JSON_MANDATORY },
+                { "usec",      _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(RuleProfile, usec),       SD_JSON_MANDATORY },
+                { "evaluated", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(RuleProfile, evaluated),  SD_JSON_MANDATORY },
+                { "matched",   _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(RuleProfile, matched),    SD_JSON_MANDATORY },
+                { "spawnUSec", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(RuleProfile, spawn_usec), SD_JSON_MANDATORY },
+                { "spawned",   _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint64,       offsetof(RuleProfile, spawned),    SD_JSON_MANDATORY },
+                {}
+        };
+
+        _cleanup_(table_unrefp) Table *table = NULL;
+        sd_json_variant *reply = NULL, *rules, *e;
+        int r;
+
+        assert(link);
+
+        r = varlink_call_and_log(link, "io.systemd.Udev.GetProfile", /* parameters = */ NULL, &reply);
+        if (r < 0)
+                return r;
+
+        rules = sd_json_variant_by_key(reply, "rules");
+        if (!rules)
+                return log_error_errno(SYNTHETIC_ERRNO(ENODATA),
+                                       "Rule profiling is not enabled, use --profile=yes to enable it.");
+        if (!sd_json_variant_is_array(rules))
+                return log_error_errno(SYNTHETIC_ERRNO(EBADMSG), "Received invalid rule profile.");
+
+        table = table_new("rule", "time", "evaluated", "matched", "spawned", "spawn time");
+        if (!table)
+                return log_oom();
+
+        /* Sorted by udevd already, most expensive first */
+        for (size_t i = 1; i < 6; i++)
+                (void) table_set_align_percent(table, table_get_cell(table, 0, i), 100);
+
+        JSON_VARIANT_ARRAY_FOREACH(e, rules) {
+                _cleanup_free_ char *rule = NULL;
+                RuleProfile p = {};
+
+                r = sd_json_dispatch(e, dispatch_table, SD_JSON_ALLOW_EXTENSIONS, &p);
+                if (r < 0)
+                        return log_error_errno(r, "Received invalid rule profile: %m");
+
+                if (asprintf(&rule, "%s:%u", p.file, p.line) < 0)
+                        return log_oom();
+
+                r = table_add_many(table,
+                                   TABLE_STRING, rule,
+                                   TABLE_TIMESPAN_MSEC, p.usec,
+                                   TABLE_UINT64, p.evaluated,
+                                   TABLE_UINT64, p.matched,
+                                   TABLE_UINT64, p.spawned,
+                                   TABLE_TIMESPAN_MSEC, p.spawn_usec);
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
+
+        r = table_print(table, NULL);
+        if (r < 0)
+                return table_log_print_error(r);
+
+        return 0;
+}
+
 static int send_control_commands(void) {
         _cleanup_(sd_varlink_flush_close_unrefp) sd_varlink *link = NULL;
         int r;
@@ -317,6 +420,19 @@ static int send_control_commands(void) {
                         return r;
         }
 
+        if (arg_profile >= 0) {
+                r = varlink_callbo_and_log(link, "io.systemd.Udev.SetProfile", /* reply = */ NULL,
+                                           SD_JSON_BUILD_PAIR_BOOLEAN("enable", arg_profile));
+                if (r < 0)
+                        return r;
+        }
+
+        if (arg_show_profile) {
+                r = show_profile(link);
+                if (r < 0)
+                        return r;
+        }
+
         return 0;
 }
 
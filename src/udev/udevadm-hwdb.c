@@ -90,7 +90,7 @@ int hwdb_main(int argc, char *argv[], void *userdata) {
         log_notice("udevadm hwdb is deprecated. Use systemd-hwdb instead.");
 
         if (arg_update && !hwdb_bypass()) {
-                r = hwdb_update(arg_root, arg_hwdb_bin_dir, arg_strict, true);
+                r = hwdb_update(arg_root, arg_hwdb_bin_dir, arg_strict, /* compat = */ true, /* incremental = */ false);
                 if (r < 0)
                         return r;
         }
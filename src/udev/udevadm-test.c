@@ -176,8 +176,13 @@ int test_main(int argc, char *argv[], void *userdata) {
 
         maybe_insert_empty_line();
         log_info("Processing udev rules%s...", arg_verbose ? "" : " (verbose logs can be shown by -v/--verbose)");
+        usec_t ts = now(CLOCK_MONOTONIC);
         udev_event_execute_rules(event, rules);
         log_info("Processing udev rules done.");
+        log_info("Evaluated %u rule tokens in %u lines in %s%s.",
+                 event->n_rule_tokens_evaluated, event->n_rule_lines_evaluated,
+                 FORMAT_TIMESPAN(usec_sub_unsigned(now(CLOCK_MONOTONIC), ts), USEC_PER_MSEC),
+                 arg_verbose ? " (without using the rules index, as verbose logging is enabled)" : "");
 
         maybe_insert_empty_line();
         r = dump_event(event, arg_json_format_flags, NULL);
@@ -11,6 +11,8 @@
 #include "device-util.h"
 #include "fd-util.h"
 #include "fileio.h"
+#include "format-table.h"
+#include "hashmap.h"
 #include "id128-util.h"
 #include "parse-util.h"
 #include "path-util.h"
@@ -19,6 +21,7 @@
 #include "static-destruct.h"
 #include "string-util.h"
 #include "strv.h"
+#include "udev-varlink.h"
 #include "udevadm.h"
 #include "udevadm-util.h"
 #include "virt.h"
@@ -28,16 +31,200 @@ static bool arg_dry_run = false;
 static bool arg_quiet = false;
 static bool arg_uuid = false;
 static bool arg_settle = false;
+static bool arg_report = false;
+static unsigned arg_queue_limit = 0;
+
+/* How long to wait before asking udevd again whether its queue has drained below the limit */
+#define QUEUE_POLL_USEC (10 * USEC_PER_MSEC)
+
+typedef struct TriggerStats {
+        unsigned n_triggered;
+        unsigned n_settled;
+        usec_t settled_usec;
+} TriggerStats;
+
+typedef struct TriggerContext {
+        Set *settle_ids;
+        Hashmap *stats;         /* subsystem → TriggerStats, only with --report */
+        usec_t start_usec;
+
+        /* Pacing, only with --queue-limit= */
+        sd_varlink *link;
+        unsigned budget;        /* number of events we may still write without asking udevd again */
+        usec_t timeout_usec;    /* how long to wait for udevd to make progress, from --wait-daemon= */
+} TriggerContext;
+
+static void trigger_context_done(TriggerContext *c) {
+        assert(c);
+
+        c->settle_ids = set_free(c->settle_ids);
+        c->stats = hashmap_free(c->stats);
+        c->link = sd_varlink_flush_close_unref(c->link);
+}
+
+static int trigger_stats_update(TriggerContext *c, sd_device *d, bool settled) {
+        const char *subsystem = NULL;
+        TriggerStats *s;
+        int r;
+
+        assert(c);
+        assert(d);
+
+        if (!c->stats)
+                return 0;
+
+        (void) sd_device_get_subsystem(d, &subsystem);
+        subsystem = subsystem ?: "-";
+
+        s = hashmap_get(c->stats, subsystem);
+        if (!s) {
+                _cleanup_free_ TriggerStats *n = new0(TriggerStats, 1);
+                if (!n)
+                        return -ENOMEM;
+
+                _cleanup_free_ char *k = strdup(subsystem);
+                if (!k)
+                        return -ENOMEM;
+
+                r = hashmap_put(c->stats, k, n);
+                if (r < 0)
+                        return r;
+
+                TAKE_PTR(k);
+                s = TAKE_PTR(n);
+        }
+
+        if (settled) {
+                s->n_settled++;
+                s->settled_usec = now(CLOCK_MONOTONIC);
+        } else
+                s->n_triggered++;
+
+        return 0;
+}
+
+static int trigger_stats_print(TriggerContext *c) {
+        _cleanup_(table_unrefp) Table *table = NULL;
+        const char *subsystem;
+        TriggerStats *s;
+        int r;
+
+        assert(c);
+
+        table = table_new("subsystem", "triggered", "settled", "time");
+        if (!table)
+                return log_oom();
+
+        (void) table_set_sort(table, (size_t) 0);
+        (void) table_set_align_percent(table, table_get_cell(table, 0, 1), 100);
+        (void) table_set_align_percent(table, table_get_cell(table, 0, 2), 100);
+        (void) table_set_align_percent(table, table_get_cell(table, 0, 3), 100);
+
+        HASHMAP_FOREACH_KEY(s, subsystem, c->stats) {
+                r = table_add_many(table,
+                                   TABLE_STRING, subsystem,
+                                   TABLE_UINT, s->n_triggered,
+                                   TABLE_UINT, s->n_settled);
+                if (r < 0)
+                        return table_log_add_error(r);
+
+                /* Time until the last event of the subsystem was processed by udevd */
+                if (s->n_settled > 0)
+                        r = table_add_cell(table, NULL, TABLE_TIMESPAN_MSEC, &(usec_t) { usec_sub_unsigned(s->settled_usec, c->start_usec) });
+                else
+                        r = table_add_cell(table, NULL, TABLE_EMPTY, NULL);
+                if (r < 0)
+                        return table_log_add_error(r);
+        }
+
+        r = table_print(table, NULL);
+        if (r < 0)
+                return table_log_print_error(r);
+
+        return 0;
+}
+
+static int queue_get_queued(sd_varlink *link, unsigned *ret) {
+        static const sd_json_dispatch_field dispatch_table[] = {
+                { "queued", _SD_JSON_VARIANT_TYPE_INVALID, sd_json_dispatch_uint, 0, SD_JSON_MANDATORY },
+                {}
+        };
+
+        sd_json_variant *reply = NULL;
+        const char *error_id = NULL;
+        int r;
+
+        assert(link);
+        assert(ret);
+
+        r = sd_varlink_call(link, "io.systemd.Udev.GetQueueStatistics", /* parameters = */ NULL, &reply, &error_id);
+        if (r < 0)
+                return r;
+        if (error_id)
+                return sd_varlink_error_to_errno(error_id, reply);
+
+        return sd_json_dispatch(reply, dispatch_table, SD_JSON_ALLOW_EXTENSIONS, ret);
+}
+
+static int trigger_pace(TriggerContext *c) {
+        int r;
+
+        assert(c);
+
+        /* Keeps the number of events queued in udevd below --queue-limit=. Instead of asking udevd before
+         * every single write, we remember how much room was left in the queue the last time we asked, and
+         * only ask again once we used that up. */
+
+        if (!c->link)
+                return 0;
+
+        if (c->budget > 0) {
+                c->budget--;
+                return 0;
+        }
+
+        usec_t deadline = USEC_INFINITY;
+        unsigned last = UINT_MAX;
+
+        for (;;) {
+                unsigned queued;
+
+                r = queue_get_queued(c->link, &queued);
+                if (r < 0) {
+                        log_warning_errno(r, "Failed to query udev event queue, disabling pacing: %m");
+                        c->link = sd_varlink_flush_close_unref(c->link);
+                        return 0;
+                }
+
+                if (queued < arg_queue_limit) {
+                        c->budget = arg_queue_limit - queued - 1;
+                        return 0;
+                }
+
+                /* Only give up if udevd does not process any events for the whole timeout. */
+                if (queued < last) {
+                        deadline = usec_add(now(CLOCK_MONOTONIC), c->timeout_usec);
+                        last = queued;
+                } else if (now(CLOCK_MONOTONIC) >= deadline)
+                        return log_error_errno(SYNTHETIC_ERRNO(ETIMEDOUT),
+                                               "Timed out waiting for the udev event queue to drain below %u events (%u queued).",
+                                               arg_queue_limit, queued);
+
+                log_debug("udev event queue has %u events queued, waiting.", queued);
+                (void) usleep_safe(QUEUE_POLL_USEC);
+        }
+}
 
 static int exec_list(
                 sd_device_enumerator *e,
                 sd_device_action_t action,
-                Set *settle_ids) {
+                TriggerContext *c) {
 
         const char *action_str = device_action_to_string(action);
         int r, ret = 0;
 
         assert(e);
+        assert(c);
 
         sd_device *d;
         FOREACH_DEVICE_AND_SUBSYSTEM(e, d) {
@@ -55,6 +242,10 @@ static int exec_list(
                 if (arg_dry_run)
                         continue;
 
+                r = trigger_pace(c);
+                if (r < 0)
+                        return r;
+
                 sd_id128_t id;
                 r = sd_device_trigger_with_uuid(d, action, &id);
                 if (r < 0) {
@@ -103,22 +294,26 @@ static int exec_list(
                 if (arg_uuid)
                         printf(SD_ID128_UUID_FORMAT_STR "\n", SD_ID128_FORMAT_VAL(id));
 
-                if (settle_ids) {
+                if (c->settle_ids) {
                         sd_id128_t *dup = newdup(sd_id128_t, &id, 1);
                         if (!dup)
                                 return log_oom();
 
-                        r = set_consume(settle_ids, dup);
+                        r = set_consume(c->settle_ids, dup);
                         if (r < 0)
                                 return log_oom();
                 }
+
+                r = trigger_stats_update(c, d, /* settled = */ false);
+                if (r < 0)
+                        return log_oom();
         }
 
         return ret;
 }
 
 static int device_monitor_handler(sd_device_monitor *m, sd_device *dev, void *userdata) {
-        Set *settle_ids = ASSERT_PTR(userdata);
+        TriggerContext *c = ASSERT_PTR(userdata);
         int r;
 
         assert(dev);
@@ -130,7 +325,7 @@ static int device_monitor_handler(sd_device_monitor *m, sd_device *dev, void *us
                 return 0;
         }
 
-        _cleanup_free_ sd_id128_t *saved = set_remove(settle_ids, &id);
+        _cleanup_free_ sd_id128_t *saved = set_remove(c->settle_ids, &id);
         if (!saved) {
                 log_device_debug(dev, "Got uevent with unexpected UUID, ignoring.");
                 return 0;
@@ -149,7 +344,11 @@ static int device_monitor_handler(sd_device_monitor *m, sd_device *dev, void *us
         if (arg_uuid)
                 printf("settle " SD_ID128_UUID_FORMAT_STR "\n", SD_ID128_FORMAT_VAL(id));
 
-        if (set_isempty(settle_ids))
+        r = trigger_stats_update(c, dev, /* settled = */ true);
+        if (r < 0)
+                return log_oom();
+
+        if (set_isempty(c->settle_ids))
                 return sd_event_exit(sd_device_monitor_get_event(m), 0);
 
         return 0;
@@ -204,7 +403,9 @@ static int help(void) {
                "                                    before triggering uevents\n"
                "     --uuid                         Print synthetic uevent UUID\n"
                "     --prioritized-subsystem=SUBSYSTEM[,SUBSYSTEM…]\n"
-               "                                    Trigger devices from a matching subsystem first\n",
+               "                                    Trigger devices from a matching subsystem first\n"
+               "     --queue-limit=EVENTS           Keep at most EVENTS events queued in udevd\n"
+               "     --report                       Show a per-subsystem summary when finished\n",
                program_invocation_short_name);
 
         return 0;
@@ -219,6 +420,8 @@ int trigger_main(int argc, char *argv[], void *userdata) {
                 ARG_INITIALIZED_MATCH,
                 ARG_INITIALIZED_NOMATCH,
                 ARG_INCLUDE_PARENTS,
+                ARG_QUEUE_LIMIT,
+                ARG_REPORT,
         };
 
         static const struct option options[] = {
@@ -245,6 +448,8 @@ int trigger_main(int argc, char *argv[], void *userdata) {
                 { "help",                  no_argument,       NULL, 'h'                       },
                 { "uuid",                  no_argument,       NULL, ARG_UUID                  },
                 { "prioritized-subsystem", required_argument, NULL, ARG_PRIORITIZED_SUBSYSTEM },
+                { "queue-limit",           required_argument, NULL, ARG_QUEUE_LIMIT           },
+                { "report",                no_argument,       NULL, ARG_REPORT                },
                 {}
         };
         enum {
@@ -256,7 +461,7 @@ int trigger_main(int argc, char *argv[], void *userdata) {
         _cleanup_(sd_device_enumerator_unrefp) sd_device_enumerator *e = NULL;
         _cleanup_(sd_device_monitor_unrefp) sd_device_monitor *m = NULL;
         _cleanup_(sd_event_unrefp) sd_event *event = NULL;
-        _cleanup_set_free_ Set *settle_ids = NULL;
+        _cleanup_(trigger_context_done) TriggerContext context = {};
         usec_t ping_timeout_usec = 5 * USEC_PER_SEC;
         bool ping = false;
         int c, r;
@@ -414,6 +619,14 @@ int trigger_main(int argc, char *argv[], void *userdata) {
                         if (r < 0)
                                 return log_error_errno(r, "Failed to set initialized filter: %m");
                         break;
+                case ARG_QUEUE_LIMIT:
+                        r = safe_atou(optarg, &arg_queue_limit);
+                        if (r < 0)
+                                return log_error_errno(r, "Failed to parse queue limit '%s': %m", optarg);
+                        break;
+                case ARG_REPORT:
+                        arg_report = true;
+                        break;
                 case 'V':
                         return print_version();
                 case 'h':
@@ -457,11 +670,11 @@ int trigger_main(int argc, char *argv[], void *userdata) {
                 if (r < 0)
                         return log_error_errno(r, "Failed to attach event to device monitor: %m");
 
-                settle_ids = set_new(&id128_hash_ops_free);
-                if (!settle_ids)
+                context.settle_ids = set_new(&id128_hash_ops_free);
+                if (!context.settle_ids)
                         return log_oom();
 
-                r = sd_device_monitor_start(m, device_monitor_handler, settle_ids);
+                r = sd_device_monitor_start(m, device_monitor_handler, &context);
                 if (r < 0)
                         return log_error_errno(r, "Failed to start device monitor: %m");
         }
@@ -486,16 +699,34 @@ int trigger_main(int argc, char *argv[], void *userdata) {
                 assert_not_reached();
         }
 
-        r = exec_list(e, action, settle_ids);
+        if (arg_queue_limit > 0 && !arg_dry_run) {
+                r = udev_varlink_connect(&context.link, ping_timeout_usec);
+                if (r < 0)
+                        log_warning_errno(r, "Failed to connect to udev via varlink, not pacing uevents: %m");
+
+                context.timeout_usec = ping_timeout_usec;
+        }
+
+        if (arg_report) {
+                context.stats = hashmap_new(&string_hash_ops_free_free);
+                if (!context.stats)
+                        return log_oom();
+        }
+
+        context.start_usec = now(CLOCK_MONOTONIC);
+
+        r = exec_list(e, action, &context);
         if (r < 0)
                 return r;
 
-        if (set_isempty(settle_ids))
-                return 0;
+        if (!set_isempty(context.settle_ids)) {
+                r = sd_event_loop(event);
+                if (r < 0)
+                        return log_error_errno(r, "Event loop failed: %m");
+        }
 
-        r = sd_event_loop(event);
-        if (r < 0)
-                return log_error_errno(r, "Event loop failed: %m");
+        if (arg_report)
+                return trigger_stats_print(&context);
 
         return 0;
 }
@@ -6,13 +6,16 @@
 #include "sd-daemon.h"
 #include "sd-varlink.h"
 
+#include "alloc-util.h"
 #include "env-util.h"
 #include "fd-util.h"
 #include "group-record.h"
+#include "hashmap.h"
 #include "io-util.h"
 #include "json-util.h"
 #include "main-func.h"
 #include "process-util.h"
+#include "string-util.h"
 #include "strv.h"
 #include "time-util.h"
 #include "user-record.h"
@@ -27,6 +30,9 @@
 #define PRESSURE_SLEEP_TIME_USEC (50 * USEC_PER_MSEC)
 #define CONNECTION_IDLE_USEC (15 * USEC_PER_SEC)
 #define LISTEN_IDLE_USEC (90 * USEC_PER_SEC)
+#define CACHE_POSITIVE_USEC (30 * USEC_PER_SEC)
+#define CACHE_NEGATIVE_USEC (5 * USEC_PER_SEC)
+#define CACHE_ENTRIES_MAX 1024U
 
 typedef struct LookupParameters {
         const char *name;
@@ -44,6 +50,107 @@ static void lookup_parameters_done(LookupParameters *p) {
         userdb_match_done(&p->match);
 }
 
+/* Clients typically look up the same few users and groups over and over again (think 'ls -l' in a large
+ * directory), and each lookup means asking every backend service. Hence remember the results of simple
+ * lookups by UID/GID or name for a short while, including the fact that there is no such record. The cache
+ * is private to this worker, and goes away with it. */
+typedef struct CacheEntry {
+        char *key;
+        UserRecord *user;     /* NULL for negative entries and group entries */
+        GroupRecord *group;   /* NULL for negative entries and user entries */
+        usec_t until;
+} CacheEntry;
+
+static CacheEntry* cache_entry_free(CacheEntry *e) {
+        if (!e)
+                return NULL;
+
+        user_record_unref(e->user);
+        group_record_unref(e->group);
+        free(e->key);
+        return mfree(e);
+}
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(cache_entry_hash_ops, char, string_hash_func, string_compare_func,
+                                              CacheEntry, cache_entry_free);
+
+static Hashmap *user_cache = NULL, *group_cache = NULL;
+
+static int cache_key(const char *name, uid_t id, char **ret) {
+        assert(ret);
+
+        if (uid_is_valid(id))
+                return asprintf(ret, "id:" UID_FMT, id) < 0 ? -ENOMEM : 0;
+
+        assert(name);
+
+        char *k = strjoin("name:", name);
+        if (!k)
+                return -ENOMEM;
+
+        *ret = k;
+        return 0;
+}
+
+static CacheEntry* cache_get(Hashmap *cache, const char *key) {
+        CacheEntry *e;
+
+        assert(key);
+
+        e = hashmap_get(cache, key);
+        if (!e)
+                return NULL;
+
+        if (now(CLOCK_MONOTONIC) >= e->until) {
+                cache_entry_free(hashmap_remove(cache, key));
+                return NULL;
+        }
+
+        return e;
+}
+
+static void cache_put(Hashmap **cache, char *key, UserRecord *user, GroupRecord *group) {
+        _cleanup_free_ char *k = key;
+        CacheEntry *e;
+        int r;
+
+        assert(cache);
+        assert(key);
+
+        /* Takes possession of 'key'. Failing to cache something is not an error, hence this doesn't return
+         * one. */
+
+        if (hashmap_size(*cache) >= CACHE_ENTRIES_MAX)
+                *cache = hashmap_free(*cache);
+
+        e = new(CacheEntry, 1);
+        if (!e)
+                return (void) log_oom_debug();
+
+        *e = (CacheEntry) {
+                .key = TAKE_PTR(k),
+                .user = user_record_ref(user),
+                .group = group_record_ref(group),
+                .until = usec_add(now(CLOCK_MONOTONIC), user || group ? CACHE_POSITIVE_USEC : CACHE_NEGATIVE_USEC),
+        };
+
+        cache_entry_free(hashmap_remove(*cache, e->key));
+
+        r = hashmap_ensure_put(cache, &cache_entry_hash_ops, e->key, e);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to add lookup result to cache, ignoring: %m");
+                cache_entry_free(e);
+        }
+}
+
+static bool lookup_cacheable(const LookupParameters *p, UserDBFlags userdb_flags) {
+        assert(p);
+
+        /* Only cache plain lookups of a single record through the multiplexer, everything else is rare
+         * enough to not bother. */
+        return userdb_flags == USERDB_AVOID_MULTIPLEXER && !userdb_match_is_set(&p->match);
+}
+
 static int add_nss_service(sd_json_variant **v) {
         _cleanup_(sd_json_variant_unrefp) sd_json_variant *status = NULL, *z = NULL;
         sd_id128_t mid;
@@ -171,11 +278,31 @@ static int vl_method_get_user_record(sd_varlink *link, sd_json_variant *paramete
                      * we are done'; == 0 means 'not processed, caller should process now' */
                 return r;
 
-        if (uid_is_valid(p.uid))
-                r = userdb_by_uid(p.uid, &p.match, userdb_flags, &hr);
-        else if (p.name)
-                r = userdb_by_name(p.name, &p.match, userdb_flags, &hr);
-        else {
+        if (uid_is_valid(p.uid) || p.name) {
+                _cleanup_free_ char *key = NULL;
+                CacheEntry *e = NULL;
+
+                if (lookup_cacheable(&p, userdb_flags)) {
+                        r = cache_key(p.name, p.uid, &key);
+                        if (r < 0)
+                                return r;
+
+                        e = cache_get(user_cache, key);
+                }
+
+                if (e) {
+                        hr = user_record_ref(e->user);
+                        r = hr ? 0 : -ESRCH;
+                } else {
+                        if (uid_is_valid(p.uid))
+                                r = userdb_by_uid(p.uid, &p.match, userdb_flags, &hr);
+                        else
+                                r = userdb_by_name(p.name, &p.match, userdb_flags, &hr);
+
+                        if (key && (r >= 0 || r == -ESRCH))
+                                cache_put(&user_cache, TAKE_PTR(key), hr, /* group= */ NULL);
+                }
+        } else {
                 _cleanup_(userdb_iterator_freep) UserDBIterator *iterator = NULL;
                 _cleanup_(sd_json_variant_unrefp) sd_json_variant *last = NULL;
 
@@ -314,11 +441,31 @@ static int vl_method_get_group_record(sd_varlink *link, sd_json_variant *paramet
         if (r != 0)
                 return r;
 
-        if (gid_is_valid(p.gid))
-                r = groupdb_by_gid(p.gid, &p.match, userdb_flags, &g);
-        else if (p.name)
-                r = groupdb_by_name(p.name, &p.match, userdb_flags, &g);
-        else {
+        if (gid_is_valid(p.gid) || p.name) {
+                _cleanup_free_ char *key = NULL;
+                CacheEntry *e = NULL;
+
+                if (lookup_cacheable(&p, userdb_flags)) {
+                        r = cache_key(p.name, (uid_t) p.gid, &key);
+                        if (r < 0)
+                                return r;
+
+                        e = cache_get(group_cache, key);
+                }
+
+                if (e) {
+                        g = group_record_ref(e->group);
+                        r = g ? 0 : -ESRCH;
+                } else {
+                        if (gid_is_valid(p.gid))
+                                r = groupdb_by_gid(p.gid, &p.match, userdb_flags, &g);
+                        else
+                                r = groupdb_by_name(p.name, &p.match, userdb_flags, &g);
+
+                        if (key && (r >= 0 || r == -ESRCH))
+                                cache_put(&group_cache, TAKE_PTR(key), /* user= */ NULL, g);
+                }
+        } else {
                 _cleanup_(userdb_iterator_freep) UserDBIterator *iterator = NULL;
                 _cleanup_(sd_json_variant_unrefp) sd_json_variant *last = NULL;
 
@@ -608,6 +755,9 @@ static int run(int argc, char *argv[]) {
                 last_busy_usec = USEC_INFINITY;
         }
 
+        user_cache = hashmap_free(user_cache);
+        group_cache = hashmap_free(group_cache);
+
         return 0;
 }
 
@@ -244,6 +244,11 @@ udevadm trigger --initialized-nomatch
 udevadm trigger -w
 udevadm trigger --uuid /sys/class/net/$netdev
 udevadm settle -t 300
+udevadm trigger --queue-limit 16
+udevadm trigger -s net --queue-limit 1 --settle --report
+udevadm trigger --report
+(! udevadm trigger --queue-limit hello)
+udevadm settle -t 300
 udevadm trigger --wait-daemon
 udevadm settle -t 300
 udevadm trigger --wait-daemon=5
@@ -0,0 +1,50 @@
+#!/bin/bash
+# SPDX-License-Identifier: LGPL-2.1-or-later
+#
+# Test for processing independent lines in multiple workers (--jobs=)
+set -eux
+set -o pipefail
+
+rm -rf /tmp/jobs
+mkdir /tmp/jobs
+
+(! systemd-tmpfiles --jobs=0 --create /dev/null)
+(! systemd-tmpfiles --jobs=foo --create /dev/null)
+
+# Independent trees, dependent lines within each of them, a symlink tying two trees together, and a glob
+# covering one of them.
+systemd-tmpfiles --jobs=4 --create - <<EOF
+d /tmp/jobs/a 0755 - - -
+d /tmp/jobs/a/1 0700 - - -
+f /tmp/jobs/a/1/file 0600 - - - a
+d /tmp/jobs/b 0755 - - -
+f /tmp/jobs/b/file 0644 - - - b
+L /tmp/jobs/c - - - - b
+f /tmp/jobs/c/file2 0644 - - - c
+d /tmp/jobs/d 0755 - - -
+d /tmp/jobs/d/x 0755 - - -
+d /tmp/jobs/d/y 0755 - - -
+z /tmp/jobs/d/* 0711 - - -
+EOF
+
+test "$(stat -c %a /tmp/jobs/a/1)" = 700
+test "$(cat /tmp/jobs/a/1/file)" = a
+test "$(readlink /tmp/jobs/c)" = b
+test "$(cat /tmp/jobs/b/file)" = b
+test "$(cat /tmp/jobs/b/file2)" = c
+test "$(stat -c %a /tmp/jobs/d/x)" = 711
+test "$(stat -c %a /tmp/jobs/d/y)" = 711
+
+# Children are still removed before their parents
+systemd-tmpfiles --jobs=4 --remove - <<EOF
+R /tmp/jobs/a
+R /tmp/jobs/d
+r /tmp/jobs/b/file
+EOF
+
+test ! -e /tmp/jobs/a
+test ! -e /tmp/jobs/d
+test ! -e /tmp/jobs/b/file
+test -e /tmp/jobs/b/file2
+
+rm -rf /tmp/jobs
@@ -1618,6 +1618,68 @@ EOF
     assert_in "${image}2 : start=      206848, size=      100312, type=${esp_guid}" "$output"
 }
 
+testcase_jobs() {
+    local defs imgs loop
+
+    if systemd-detect-virt --quiet --container; then
+        echo "Skipping --jobs= test in container."
+        return
+    fi
+
+    defs="$(mktemp --directory "/tmp/test-repart.defs.XXXXXXXXXX")"
+    imgs="$(mktemp --directory "/var/tmp/test-repart.imgs.XXXXXXXXXX")"
+    # shellcheck disable=SC2064
+    trap "rm -rf '$defs' '$imgs'" RETURN
+    chmod 0755 "$defs"
+
+    echo "foo" >"$defs/foo"
+    dd if=/dev/urandom of="$imgs/blocks" bs=1M count=4
+
+    tee "$defs/root.conf" <<EOF
+[Partition]
+Type=root
+Format=ext4
+CopyFiles=/foo:/foo
+MakeDirectories=/dir
+EOF
+
+    tee "$defs/usr.conf" <<EOF
+[Partition]
+Type=usr
+Format=ext4
+CopyFiles=/foo:/bar
+EOF
+
+    tee "$defs/home.conf" <<EOF
+[Partition]
+Type=linux-generic
+CopyBlocks=$imgs/blocks
+EOF
+
+    (! systemd-repart --jobs=0 --definitions="$defs" --empty=create --size=1G "$imgs/zzz")
+
+    systemd-repart --offline="$OFFLINE" \
+                   --definitions="$defs" \
+                   --copy-source="$defs" \
+                   --seed="$seed" \
+                   --empty=create \
+                   --size=1G \
+                   --dry-run=no \
+                   --jobs=3 \
+                   "$imgs/zzz"
+
+    systemd-dissect "$imgs/zzz" -M "$imgs/mnt"
+    assert_eq "$(cat "$imgs/mnt/foo")" "foo"
+    assert_eq "$(cat "$imgs/mnt/usr/bar")" "foo"
+    test -d "$imgs/mnt/dir"
+    systemd-dissect -U "$imgs/mnt"
+
+    loop="$(losetup -P --show --find "$imgs/zzz")"
+    udevadm wait --timeout=60 --settle "${loop}p1"
+    cmp --bytes=$((4*1024*1024)) "${loop}p1" "$imgs/blocks"
+    losetup -d "$loop"
+}
+
 OFFLINE="yes"
 run_testcases
 
@@ -17,6 +17,9 @@ export SYSTEMD_LOG_LEVEL=debug
 systemd-analyze || :
 systemd-analyze time || :
 systemd-analyze critical-chain || :
+systemd-analyze simulate || :
+systemd-analyze simulate systemd-journald.service=0 || :
+(! systemd-analyze simulate foo)
 # blame
 systemd-analyze blame
 systemd-run --wait --user --pipe -M testuser@.host systemd-analyze blame